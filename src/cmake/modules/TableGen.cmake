@@ -36,6 +36,12 @@ function(tablegen project ofn)
     ${LLVM_TARGET_DEFINITIONS_ABSOLUTE}
     COMMENT "Building ${ofn}..."
     )
+  tablegen_update(${ofn})
+endfunction()
+
+# Copies the tablegen output in ${ofn}.tmp to ${ofn} and adds ${ofn} to
+# TABLEGEN_OUTPUT in the scope of the function it is called from.
+macro(tablegen_update ofn)
   add_custom_command(OUTPUT ${CMAKE_CURRENT_BINARY_DIR}/${ofn}
     # Only update the real output file if there are any differences.
     # This prevents recompilation of all the files depending on it if there
@@ -51,9 +57,67 @@ function(tablegen project ofn)
   set_property(DIRECTORY APPEND
     PROPERTY ADDITIONAL_MAKE_CLEAN_FILES ${ofn}.tmp ${ofn})
 
-  set(TABLEGEN_OUTPUT ${TABLEGEN_OUTPUT} ${CMAKE_CURRENT_BINARY_DIR}/${ofn} PARENT_SCOPE)
+  set(TABLEGEN_OUTPUT ${TABLEGEN_OUTPUT} ${CMAKE_CURRENT_BINARY_DIR}/${ofn})
+  set(TABLEGEN_OUTPUT ${TABLEGEN_OUTPUT} PARENT_SCOPE)
   set_source_files_properties(${CMAKE_CURRENT_BINARY_DIR}/${ofn} PROPERTIES
     GENERATED 1)
+endmacro()
+
+# Like tablegen(), for several outputs of LLVM_TARGET_DEFINITIONS, each given
+# as the output file followed by the action option that selects its backend.
+# Where tblgen can fork and is built here, it parses the .td files once and
+# runs the backends in parallel; elsewhere each output is a tablegen() of its
+# own.
+function(tablegen_batch project)
+  set(outputs ${ARGN})
+  if(NOT UNIX OR NOT TARGET ${${project}_TABLEGEN_EXE})
+    while(outputs)
+      list(GET outputs 0 ofn)
+      list(GET outputs 1 action)
+      list(REMOVE_AT outputs 0 1)
+      tablegen(${project} ${ofn} ${action})
+    endwhile()
+    set(TABLEGEN_OUTPUT ${TABLEGEN_OUTPUT} PARENT_SCOPE)
+    return()
+  endif()
+
+  file(GLOB local_tds "*.td")
+  file(GLOB_RECURSE global_tds "${LLVM_MAIN_INCLUDE_DIR}/llvm/*.td")
+
+  if (IS_ABSOLUTE ${LLVM_TARGET_DEFINITIONS})
+    set(LLVM_TARGET_DEFINITIONS_ABSOLUTE ${LLVM_TARGET_DEFINITIONS})
+  else()
+    set(LLVM_TARGET_DEFINITIONS_ABSOLUTE
+      ${CMAKE_CURRENT_SOURCE_DIR}/${LLVM_TARGET_DEFINITIONS})
+  endif()
+
+  set(ofns)
+  set(tmps)
+  set(emits)
+  while(outputs)
+    list(GET outputs 0 ofn)
+    list(GET outputs 1 action)
+    list(REMOVE_AT outputs 0 1)
+    string(REGEX REPLACE "^-+" "" action ${action})
+    list(APPEND ofns ${ofn})
+    list(APPEND tmps ${CMAKE_CURRENT_BINARY_DIR}/${ofn}.tmp)
+    list(APPEND emits -emit=${action}:${CMAKE_CURRENT_BINARY_DIR}/${ofn}.tmp)
+  endwhile()
+
+  string(REPLACE ";" ", " ofns_comment "${ofns}")
+  add_custom_command(OUTPUT ${tmps}
+    # Generate tablegen output in temporary files.
+    COMMAND ${${project}_TABLEGEN_EXE} ${emits} -I ${CMAKE_CURRENT_SOURCE_DIR}
+    -I ${LLVM_MAIN_SRC_DIR}/lib/Target -I ${LLVM_MAIN_INCLUDE_DIR}
+    ${LLVM_TARGET_DEFINITIONS_ABSOLUTE}
+    DEPENDS ${${project}_TABLEGEN_EXE} ${local_tds} ${global_tds}
+    ${LLVM_TARGET_DEFINITIONS_ABSOLUTE}
+    COMMENT "Building ${ofns_comment}..."
+    )
+
+  foreach(ofn ${ofns})
+    tablegen_update(${ofn})
+  endforeach()
 endfunction()
 
 # Creates a target for publicly exporting tablegen dependencies.
@@ -40,7 +40,7 @@ typedef bool lto_bool_t;
  * @{
  */
 
-#define LTO_API_VERSION 15
+#define LTO_API_VERSION 17
 #define LTO_APPLE_INTERNAL 1
 
 /**
@@ -537,6 +537,90 @@ lto_codegen_optimize(lto_code_gen_t cg);
 extern const void*
 lto_codegen_compile_optimized(lto_code_gen_t cg, size_t* length);
 
+/**
+ * Sets the number of native object files that lto_codegen_compile_to_files()
+ * and lto_codegen_compile_optimized_to_files() split the merged module into.
+ * Code for each of them is generated on its own thread. The default is 1.
+ *
+ * \since LTO_API_VERSION=16
+ */
+extern void
+lto_codegen_set_parallelism(lto_code_gen_t cg, unsigned int parallelism);
+
+/**
+ * Generates code for all added modules into as many native object files as
+ * the parallelism set with lto_codegen_set_parallelism(), in parallel. This
+ * calls lto_codegen_optimize then lto_codegen_compile_optimized_to_files.
+ *
+ * The names of the files are written to names and their number to count. The
+ * names array is owned by the lto_code_gen_t and remains valid until the next
+ * compilation or lto_codegen_dispose(). As with
+ * lto_codegen_compile_to_file(), it is up to the linker to remove the files.
+ * Returns true on error.
+ *
+ * \since LTO_API_VERSION=16
+ */
+extern lto_bool_t
+lto_codegen_compile_to_files(lto_code_gen_t cg, const char ***names,
+                             unsigned int *count);
+
+/**
+ * Generates code for the optimized merged module into as many native object
+ * files as the parallelism set with lto_codegen_set_parallelism(), in parallel.
+ * It will not run any IR optimizations on the merged module. See
+ * lto_codegen_compile_to_files() for the ownership of names. Returns true on
+ * error.
+ *
+ * \since LTO_API_VERSION=16
+ */
+extern lto_bool_t
+lto_codegen_compile_optimized_to_files(lto_code_gen_t cg, const char ***names,
+                                       unsigned int *count);
+
+/**
+ * Sets the directory where the native object files generated by
+ * lto_codegen_compile(), lto_codegen_compile_to_file() and
+ * lto_codegen_compile_to_files() are cached. The objects are keyed by a hash
+ * of the merged module, of the preserved symbols, and of the target and
+ * options they are generated for: when a link produces the same key as a
+ * previous one, the cached objects are used instead of optimizing and
+ * generating code again. There is no cache by default.
+ *
+ * \since LTO_API_VERSION=17
+ */
+extern void
+lto_codegen_set_cache_dir(lto_code_gen_t cg, const char *cache_dir);
+
+/**
+ * Sets the minimum interval, in seconds, between two prunings of the cache,
+ * which happen after adding to it. A negative value disables pruning, and 0
+ * prunes after every addition. The default is 1200 seconds.
+ *
+ * \since LTO_API_VERSION=17
+ */
+extern void
+lto_codegen_set_cache_pruning_interval(lto_code_gen_t cg, int interval);
+
+/**
+ * Sets the time, in seconds, after which an unused cache entry is pruned. 0
+ * disables the expiration. The default is one week.
+ *
+ * \since LTO_API_VERSION=17
+ */
+extern void
+lto_codegen_set_cache_entry_expiration(lto_code_gen_t cg,
+                                       unsigned int expiration);
+
+/**
+ * Sets the maximum size of the cache, in bytes. Pruning removes the least
+ * recently used entries until the cache fits. 0, the default, disables the
+ * limit.
+ *
+ * \since LTO_API_VERSION=17
+ */
+extern void
+lto_codegen_set_max_cache_size(lto_code_gen_t cg, unsigned long long size);
+
 /**
  * Hide the names of all non-exported symbols from bitcode.
  *
@@ -75,20 +75,24 @@ const unsigned int integerPartWidth =
 class APInt {
   unsigned BitWidth; ///< The number of bits in this APInt.
 
-  /// This union is used to store the integer value. When the
-  /// integer bit-width <= 64, it uses VAL, otherwise it uses pVal.
-  union {
-    uint64_t VAL;   ///< Used to store the <= 64 bits integer value.
-    uint64_t *pVal; ///< Used to store the >64 bits integer value.
-  };
-
   /// This enum is used to hold the constants we needed for APInt.
   enum {
     /// Bits in a word
     APINT_BITS_PER_WORD =
         static_cast<unsigned int>(sizeof(uint64_t)) * CHAR_BIT,
     /// Byte size of a word
-    APINT_WORD_SIZE = static_cast<unsigned int>(sizeof(uint64_t))
+    APINT_WORD_SIZE = static_cast<unsigned int>(sizeof(uint64_t)),
+    /// Words stored in the object itself rather than allocated
+    APINT_INLINE_WORDS = 2
+  };
+
+  /// This union is used to store the integer value. When the
+  /// integer bit-width <= 64, it uses VAL, when it is <= 128 it uses InlineVal,
+  /// otherwise it uses pVal.
+  union {
+    uint64_t VAL;   ///< Used to store the <= 64 bits integer value.
+    uint64_t InlineVal[APINT_INLINE_WORDS]; ///< Used to store <= 128 bits.
+    uint64_t *pVal; ///< Used to store the >128 bits integer value.
   };
 
   friend struct DenseMapAPIntKeyInfo;
@@ -99,6 +103,23 @@ class APInt {
   /// temporaries. It is unsafe for general use so it is not public.
   APInt(uint64_t *val, unsigned bits) : BitWidth(bits), pVal(val) {}
 
+  /// \brief Get the words of a multi-word value.
+  ///
+  /// They are in InlineVal if they fit there, and allocated in pVal otherwise.
+  uint64_t *getWords() { return needsCleanup() ? pVal : InlineVal; }
+  const uint64_t *getWords() const {
+    return needsCleanup() ? pVal : InlineVal;
+  }
+
+  /// \brief Make room for the words of a multi-word value.
+  ///
+  /// \returns the words, which are not cleared.
+  uint64_t *allocateWords() {
+    if (needsCleanup())
+      pVal = new uint64_t[getNumWords()];
+    return getWords();
+  }
+
   /// \brief Determine if this APInt just has one word to store value.
   ///
   /// \returns true if the number of bits <= 64, false otherwise.
@@ -149,14 +170,14 @@ class APInt {
     if (isSingleWord())
       VAL &= mask;
     else
-      pVal[getNumWords() - 1] &= mask;
+      getWords()[getNumWords() - 1] &= mask;
     return *this;
   }
 
   /// \brief Get the word corresponding to a bit position
   /// \returns the corresponding word for the specified bit position.
   uint64_t getWord(unsigned bitPosition) const {
-    return isSingleWord() ? VAL : pVal[whichWord(bitPosition)];
+    return isSingleWord() ? VAL : getWords()[whichWord(bitPosition)];
   }
 
   /// \brief Convert a char array into an APInt
@@ -183,12 +204,14 @@ class APInt {
                      unsigned rhsWords, APInt *Quotient, APInt *Remainder);
 
   /// out-of-line slow case for inline constructor
+  LLVM_ATTRIBUTE_NOINLINE
   void initSlowCase(unsigned numBits, uint64_t val, bool isSigned);
 
   /// shared code between two array constructors
   void initFromArray(ArrayRef<uint64_t> array);
 
   /// out-of-line slow case for inline copy constructor
+  LLVM_ATTRIBUTE_NOINLINE
   void initSlowCase(const APInt &that);
 
   /// out-of-line slow case for shl
@@ -286,7 +309,11 @@ public:
   }
 
   /// \brief Move Constructor.
-  APInt(APInt &&that) : BitWidth(that.BitWidth), VAL(that.VAL) {
+  APInt(APInt &&that) : BitWidth(that.BitWidth) {
+    if (isSingleWord())
+      VAL = that.VAL;
+    else
+      memcpy(InlineVal, that.InlineVal, sizeof(InlineVal));
     that.BitWidth = 0;
   }
 
@@ -303,7 +330,9 @@ public:
   explicit APInt() : BitWidth(1) {}
 
   /// \brief Returns whether this instance allocated memory.
-  bool needsCleanup() const { return !isSingleWord(); }
+  bool needsCleanup() const {
+    return BitWidth > APINT_INLINE_WORDS * APINT_BITS_PER_WORD;
+  }
 
   /// Used to insert APInt objects, or objects that contain APInt objects, into
   ///  FoldingSets.
@@ -569,7 +598,7 @@ public:
   const uint64_t *getRawData() const {
     if (isSingleWord())
       return &VAL;
-    return &pVal[0];
+    return getWords();
   }
 
   /// @}
@@ -632,7 +661,7 @@ public:
       return !VAL;
 
     for (unsigned i = 0; i != getNumWords(); ++i)
-      if (pVal[i])
+      if (getWords()[i])
         return false;
     return true;
   }
@@ -657,18 +686,17 @@ public:
 
   /// @brief Move assignment operator.
   APInt &operator=(APInt &&that) {
-    if (!isSingleWord()) {
-      // The MSVC STL shipped in 2013 requires that self move assignment be a
-      // no-op.  Otherwise algorithms like stable_sort will produce answers
-      // where half of the output is left in a moved-from state.
-      if (this == &that)
-        return *this;
+    // The MSVC STL shipped in 2013 requires that self move assignment be a
+    // no-op.  Otherwise algorithms like stable_sort will produce answers
+    // where half of the output is left in a moved-from state.
+    if (this == &that)
+      return *this;
+    if (needsCleanup())
       delete[] pVal;
-    }
 
-    // Use memcpy so that type based alias analysis sees both VAL and pVal
-    // as modified.
-    memcpy(&VAL, &that.VAL, sizeof(uint64_t));
+    // Use memcpy so that type based alias analysis sees VAL, InlineVal and
+    // pVal as modified.
+    memcpy(InlineVal, that.InlineVal, sizeof(InlineVal));
 
     // If 'this == &that', avoid zeroing our own bitwidth by storing to 'that'
     // first.
@@ -714,7 +742,7 @@ public:
       VAL |= RHS;
       clearUnusedBits();
     } else {
-      pVal[0] |= RHS;
+      getWords()[0] |= RHS;
     }
     return *this;
   }
@@ -957,7 +985,7 @@ public:
   bool operator[](unsigned bitPosition) const {
     assert(bitPosition < getBitWidth() && "Bit position out of bounds!");
     return (maskBit(bitPosition) &
-            (isSingleWord() ? VAL : pVal[whichWord(bitPosition)])) !=
+            (isSingleWord() ? VAL : getWords()[whichWord(bitPosition)])) !=
            0;
   }
 
@@ -1212,7 +1240,7 @@ public:
     else {
       // Set all the bits in all the words.
       for (unsigned i = 0; i < getNumWords(); ++i)
-        pVal[i] = UINT64_MAX;
+        getWords()[i] = UINT64_MAX;
     }
     // Clear the unused ones
     clearUnusedBits();
@@ -1228,7 +1256,7 @@ public:
     if (isSingleWord())
       VAL = 0;
     else
-      memset(pVal, 0, getNumWords() * APINT_WORD_SIZE);
+      memset(getWords(), 0, getNumWords() * APINT_WORD_SIZE);
   }
 
   /// \brief Set a given bit to 0.
@@ -1242,7 +1270,7 @@ public:
       VAL ^= UINT64_MAX;
     else {
       for (unsigned i = 0; i < getNumWords(); ++i)
-        pVal[i] ^= UINT64_MAX;
+        getWords()[i] ^= UINT64_MAX;
     }
     clearUnusedBits();
   }
@@ -1316,7 +1344,7 @@ public:
     if (isSingleWord())
       return VAL;
     assert(getActiveBits() <= 64 && "Too many bits for uint64_t");
-    return pVal[0];
+    return getWords()[0];
   }
 
   /// \brief Get sign extended value
@@ -1329,7 +1357,7 @@ public:
       return int64_t(VAL << (APINT_BITS_PER_WORD - BitWidth)) >>
              (APINT_BITS_PER_WORD - BitWidth);
     assert(getMinSignedBits() <= 64 && "Too many bits for int64_t");
-    return int64_t(pVal[0]);
+    return int64_t(getWords()[0]);
   }
 
   /// \brief Get bits required for string value.
@@ -1457,7 +1485,7 @@ public:
       uint64_t I;
       double D;
     } T;
-    T.I = (isSingleWord() ? VAL : pVal[0]);
+    T.I = (isSingleWord() ? VAL : getWords()[0]);
     return T.D;
   }
 
@@ -1471,7 +1499,7 @@ public:
       unsigned I;
       float F;
     } T;
-    T.I = unsigned((isSingleWord() ? VAL : pVal[0]));
+    T.I = unsigned((isSingleWord() ? VAL : getWords()[0]));
     return T.F;
   }
 
@@ -37,6 +37,11 @@ namespace llvm {
 /// should satisfy.
 class DAGDeltaAlgorithm {
   virtual void anchor();
+
+  /// The number of tests to execute concurrently, 0 for one per hardware
+  /// thread.
+  unsigned NumThreads;
+
 public:
   typedef unsigned change_ty;
   typedef std::pair<change_ty, change_ty> edge_ty;
@@ -46,8 +51,16 @@ public:
   typedef std::vector<changeset_ty> changesetlist_ty;
 
 public:
+  /// Create an instance that executes up to \p NumThreads tests
+  /// concurrently, 0 for as many as there are hardware threads. Unless
+  /// \p NumThreads is 1, ExecuteOneTest() must be safe to call from several
+  /// threads at once. \see DeltaAlgorithm
+  explicit DAGDeltaAlgorithm(unsigned NumThreads = 1)
+      : NumThreads(NumThreads) {}
   virtual ~DAGDeltaAlgorithm() {}
 
+  unsigned getNumThreads() const { return NumThreads; }
+
   /// Run - Minimize the DAG formed by the \p Changes vertices and the
   /// \p Dependencies edges by executing \see ExecuteOneTest() on subsets of
   /// changes and returning the smallest set which still satisfies the test
@@ -9,11 +9,14 @@
 #ifndef LLVM_ADT_DELTAALGORITHM_H
 #define LLVM_ADT_DELTAALGORITHM_H
 
+#include <map>
 #include <set>
 #include <vector>
 
 namespace llvm {
 
+class ThreadPool;
+
 /// DeltaAlgorithm - Implements the delta debugging algorithm (A. Zeller '99)
 /// for minimizing arbitrary sets using a predicate function.
 ///
@@ -33,6 +36,11 @@ namespace llvm {
 /// requirements, and the algorithm will generally produce reasonable
 /// results. However, it may run substantially more tests than with a good
 /// predicate.
+///
+/// The algorithm can execute several tests concurrently, in which case the
+/// predicate must be safe to call from several threads at once. The tests are
+/// tried in the same order, and the result is the same, as when they run one
+/// after the other; some tests are run whose results end up unused.
 class DeltaAlgorithm {
 public:
   typedef unsigned change_ty;
@@ -41,9 +49,18 @@ public:
   typedef std::vector<changeset_ty> changesetlist_ty;
 
 private:
-  /// Cache of failed test results. Successful test results are never cached
-  /// since we always reduce following a success.
-  std::set<changeset_ty> FailedTestsCache;
+  /// The number of tests to execute concurrently, 0 for one per hardware
+  /// thread.
+  unsigned NumThreads;
+
+  /// The threads executing the tests while Run() runs, or null if the tests
+  /// are executed one after the other.
+  ThreadPool *Pool;
+
+  /// Cache of test results, keyed by the change set tested. Successful tests
+  /// are cached as well, since tests whose result ended up unused may be
+  /// tried again later.
+  std::map<changeset_ty, bool> TestResultsCache;
 
   /// GetTestResult - Get the test result for the \p Changes from the
   /// cache, executing the test if necessary.
@@ -52,6 +69,10 @@ private:
   /// \return - The test result.
   bool GetTestResult(const changeset_ty &Changes);
 
+  /// GetTestResults - Get the test results for each change set of \p Sets
+  /// from the cache, executing the missing tests concurrently.
+  std::vector<bool> GetTestResults(const changesetlist_ty &Sets);
+
   /// Split - Partition a set of changes \p S into one or two subsets.
   void Split(const changeset_ty &S, changesetlist_ty &Res);
 
@@ -78,6 +99,10 @@ protected:
   virtual bool ExecuteOneTest(const changeset_ty &S) = 0;
 
 public:
+  /// Create an instance that executes up to \p NumThreads tests
+  /// concurrently, 0 for as many as there are hardware threads.
+  explicit DeltaAlgorithm(unsigned NumThreads = 1)
+      : NumThreads(NumThreads), Pool(nullptr) {}
   virtual ~DeltaAlgorithm();
 
   /// Run - Minimize the set \p Changes by executing \see ExecuteOneTest() on
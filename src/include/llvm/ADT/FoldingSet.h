@@ -596,6 +596,228 @@ public:
   bool empty() const { return Set.empty(); }
 };
 
+//===----------------------------------------------------------------------===//
+/// HashedFoldingSetBucket - A bucket of a HashedFoldingSet.  It holds a node
+/// and the hash of the node.  The node is null if the bucket is empty and
+/// getTombstone() if the node in it was removed.
+struct HashedFoldingSetBucket {
+  unsigned Hash;
+  FoldingSetNode *Node;
+
+  static FoldingSetNode *getTombstone() {
+    return reinterpret_cast<FoldingSetNode *>(-1);
+  }
+  bool hasNode() const { return Node && Node != getTombstone(); }
+};
+
+//===----------------------------------------------------------------------===//
+/// HashedFoldingSetImpl - Implements the functionality of HashedFoldingSet.
+/// Unlike FoldingSetImpl, this is an open addressing hash table whose buckets
+/// store the hash of their node next to it.  A lookup only profiles the nodes
+/// whose hash matches the hash of the ID, and growing the table never
+/// profiles a node.  The next pointer of the nodes is not used.
+///
+class HashedFoldingSetImpl {
+protected:
+  typedef FoldingSetNode Node;
+  typedef HashedFoldingSetBucket Bucket;
+
+  /// Buckets - Array of buckets.
+  ///
+  Bucket *Buckets;
+
+  /// NumBuckets - Length of the Buckets array.  Always a power of 2.
+  ///
+  unsigned NumBuckets;
+
+  /// NumNodes - Number of nodes in the folding set.
+  ///
+  unsigned NumNodes;
+
+  /// NumTombstones - Number of buckets whose node was removed.
+  ///
+  unsigned NumTombstones;
+
+public:
+  explicit HashedFoldingSetImpl(unsigned Log2InitSize = 6);
+  virtual ~HashedFoldingSetImpl();
+
+  /// clear - Remove all nodes from the folding set.
+  void clear();
+
+  /// RemoveNode - Remove a node from the folding set, returning true if one
+  /// was removed or false if the node was not in the folding set.
+  bool RemoveNode(Node *N);
+
+  /// GetOrInsertNode - If there is an existing simple Node exactly
+  /// equal to the specified node, return it.  Otherwise, insert 'N' and return
+  /// it instead.
+  Node *GetOrInsertNode(Node *N);
+
+  /// FindNodeOrInsertPos - Look up the node specified by ID.  If it exists,
+  /// return it.  If not, return the insertion token that will make insertion
+  /// faster.
+  Node *FindNodeOrInsertPos(const FoldingSetNodeID &ID, void *&InsertPos);
+
+  /// InsertNode - Insert the specified node into the folding set, knowing that
+  /// it is not already in the folding set.  InsertPos must be obtained from
+  /// FindNodeOrInsertPos.
+  void InsertNode(Node *N, void *InsertPos);
+
+  /// InsertNode - Insert the specified node into the folding set, knowing that
+  /// it is not already in the folding set.
+  void InsertNode(Node *N) {
+    Node *Inserted = GetOrInsertNode(N);
+    (void)Inserted;
+    assert(Inserted == N && "Node already inserted!");
+  }
+
+  /// size - Returns the number of nodes in the folding set.
+  unsigned size() const { return NumNodes; }
+
+  /// empty - Returns true if there are no nodes in the folding set.
+  bool empty() const { return NumNodes == 0; }
+
+private:
+  /// GrowHashTable - Rehash everything into NewNumBuckets buckets, dropping
+  /// the tombstones.
+  ///
+  void GrowHashTable(unsigned NewNumBuckets);
+
+protected:
+  /// GetNodeProfile - Instantiations of the HashedFoldingSet template
+  /// implement this function to gather data bits for the given node.
+  virtual void GetNodeProfile(Node *N, FoldingSetNodeID &ID) const = 0;
+  /// NodeEquals - Instantiations of the HashedFoldingSet template implement
+  /// this function to compare the given node with the given ID.
+  virtual bool NodeEquals(Node *N, const FoldingSetNodeID &ID, unsigned IDHash,
+                          FoldingSetNodeID &TempID) const = 0;
+  /// ComputeNodeHash - Instantiations of the HashedFoldingSet template
+  /// implement this function to compute a hash value for the given node.
+  virtual unsigned ComputeNodeHash(Node *N, FoldingSetNodeID &TempID) const = 0;
+};
+
+template<class T> class HashedFoldingSetIterator;
+
+//===----------------------------------------------------------------------===//
+/// HashedFoldingSet - A replacement for FoldingSet for sets that are looked
+/// up much more often than they are iterated over or removed from, such as
+/// the type uniquing tables of a compiler.  It has the same interface as
+/// FoldingSet, except for the bucket iterators, and does not use the next
+/// pointer of the nodes.  T must be a subclass of FoldingSetNode and
+/// implement a Profile function.
+///
+template<class T> class HashedFoldingSet : public HashedFoldingSetImpl {
+private:
+  void GetNodeProfile(Node *N, FoldingSetNodeID &ID) const override {
+    T *TN = static_cast<T *>(N);
+    FoldingSetTrait<T>::Profile(*TN, ID);
+  }
+  bool NodeEquals(Node *N, const FoldingSetNodeID &ID, unsigned IDHash,
+                  FoldingSetNodeID &TempID) const override {
+    T *TN = static_cast<T *>(N);
+    return FoldingSetTrait<T>::Equals(*TN, ID, IDHash, TempID);
+  }
+  unsigned ComputeNodeHash(Node *N, FoldingSetNodeID &TempID) const override {
+    T *TN = static_cast<T *>(N);
+    return FoldingSetTrait<T>::ComputeHash(*TN, TempID);
+  }
+
+public:
+  explicit HashedFoldingSet(unsigned Log2InitSize = 6)
+  : HashedFoldingSetImpl(Log2InitSize)
+  {}
+
+  typedef HashedFoldingSetIterator<T> iterator;
+  iterator begin() { return iterator(Buckets, Buckets+NumBuckets); }
+  iterator end() { return iterator(Buckets+NumBuckets, Buckets+NumBuckets); }
+
+  typedef HashedFoldingSetIterator<const T> const_iterator;
+  const_iterator begin() const {
+    return const_iterator(Buckets, Buckets+NumBuckets);
+  }
+  const_iterator end() const {
+    return const_iterator(Buckets+NumBuckets, Buckets+NumBuckets);
+  }
+
+  /// GetOrInsertNode - If there is an existing simple Node exactly
+  /// equal to the specified node, return it.  Otherwise, insert 'N' and
+  /// return it instead.
+  T *GetOrInsertNode(Node *N) {
+    return static_cast<T *>(HashedFoldingSetImpl::GetOrInsertNode(N));
+  }
+
+  /// FindNodeOrInsertPos - Look up the node specified by ID.  If it exists,
+  /// return it.  If not, return the insertion token that will make insertion
+  /// faster.
+  T *FindNodeOrInsertPos(const FoldingSetNodeID &ID, void *&InsertPos) {
+    return static_cast<T *>(
+        HashedFoldingSetImpl::FindNodeOrInsertPos(ID, InsertPos));
+  }
+};
+
+//===----------------------------------------------------------------------===//
+/// HashedContextualFoldingSet - The HashedFoldingSet counterpart of
+/// ContextualFoldingSet.
+///
+/// T must be a subclass of FoldingSetNode and implement a Profile
+/// function with signature
+///   void Profile(llvm::FoldingSetNodeID &, Ctx);
+template <class T, class Ctx>
+class HashedContextualFoldingSet : public HashedFoldingSetImpl {
+private:
+  Ctx Context;
+
+  void GetNodeProfile(Node *N, FoldingSetNodeID &ID) const override {
+    T *TN = static_cast<T *>(N);
+    ContextualFoldingSetTrait<T, Ctx>::Profile(*TN, ID, Context);
+  }
+  bool NodeEquals(Node *N, const FoldingSetNodeID &ID, unsigned IDHash,
+                  FoldingSetNodeID &TempID) const override {
+    T *TN = static_cast<T *>(N);
+    return ContextualFoldingSetTrait<T, Ctx>::Equals(*TN, ID, IDHash, TempID,
+                                                     Context);
+  }
+  unsigned ComputeNodeHash(Node *N, FoldingSetNodeID &TempID) const override {
+    T *TN = static_cast<T *>(N);
+    return ContextualFoldingSetTrait<T, Ctx>::ComputeHash(*TN, TempID, Context);
+  }
+
+public:
+  explicit HashedContextualFoldingSet(Ctx Context, unsigned Log2InitSize = 6)
+  : HashedFoldingSetImpl(Log2InitSize), Context(Context)
+  {}
+
+  Ctx getContext() const { return Context; }
+
+  typedef HashedFoldingSetIterator<T> iterator;
+  iterator begin() { return iterator(Buckets, Buckets+NumBuckets); }
+  iterator end() { return iterator(Buckets+NumBuckets, Buckets+NumBuckets); }
+
+  typedef HashedFoldingSetIterator<const T> const_iterator;
+  const_iterator begin() const {
+    return const_iterator(Buckets, Buckets+NumBuckets);
+  }
+  const_iterator end() const {
+    return const_iterator(Buckets+NumBuckets, Buckets+NumBuckets);
+  }
+
+  /// GetOrInsertNode - If there is an existing simple Node exactly
+  /// equal to the specified node, return it.  Otherwise, insert 'N'
+  /// and return it instead.
+  T *GetOrInsertNode(Node *N) {
+    return static_cast<T *>(HashedFoldingSetImpl::GetOrInsertNode(N));
+  }
+
+  /// FindNodeOrInsertPos - Look up the node specified by ID.  If it
+  /// exists, return it.  If not, return the insertion token that will
+  /// make insertion faster.
+  T *FindNodeOrInsertPos(const FoldingSetNodeID &ID, void *&InsertPos) {
+    return static_cast<T *>(
+        HashedFoldingSetImpl::FindNodeOrInsertPos(ID, InsertPos));
+  }
+};
+
 //===----------------------------------------------------------------------===//
 /// FoldingSetIteratorImpl - This is the common iterator support shared by all
 /// folding sets, which knows how to walk the folding set hash table.
@@ -688,6 +910,45 @@ public:
   }
 };
 
+//===----------------------------------------------------------------------===//
+/// HashedFoldingSetIterator - Walks the nodes of a HashedFoldingSet, in no
+/// particular order.
+template<class T>
+class HashedFoldingSetIterator {
+  const HashedFoldingSetBucket *Ptr, *End;
+
+  void skipEmptyBuckets() {
+    while (Ptr != End && !Ptr->hasNode())
+      ++Ptr;
+  }
+
+public:
+  HashedFoldingSetIterator(const HashedFoldingSetBucket *Ptr,
+                           const HashedFoldingSetBucket *End)
+    : Ptr(Ptr), End(End) {
+    skipEmptyBuckets();
+  }
+
+  T &operator*() const { return *static_cast<T*>(Ptr->Node); }
+  T *operator->() const { return static_cast<T*>(Ptr->Node); }
+
+  bool operator==(const HashedFoldingSetIterator &RHS) const {
+    return Ptr == RHS.Ptr;
+  }
+  bool operator!=(const HashedFoldingSetIterator &RHS) const {
+    return Ptr != RHS.Ptr;
+  }
+
+  inline HashedFoldingSetIterator &operator++() { // Preincrement
+    ++Ptr;
+    skipEmptyBuckets();
+    return *this;
+  }
+  HashedFoldingSetIterator operator++(int) {      // Postincrement
+    HashedFoldingSetIterator tmp = *this; ++*this; return tmp;
+  }
+};
+
 //===----------------------------------------------------------------------===//
 /// FoldingSetNodeWrapper - This template class is used to "wrap" arbitrary
 /// types in an enclosing object so that they can be inserted into FoldingSets.
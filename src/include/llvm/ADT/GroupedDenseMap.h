@@ -0,0 +1,728 @@
+//===- llvm/ADT/GroupedDenseMap.h - Group probed hash table -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the GroupedDenseMap class, a hash table with the interface
+// of DenseMap that keeps the state of its buckets in a separate array of
+// control bytes.
+//
+// Each control byte says whether its bucket is empty, erased, or full, and for
+// a full bucket holds 7 bits of the hash of its key.  A lookup probes the
+// buckets by groups of 16 of them (8 without SSE2), matching the control bytes
+// of a whole group against the hash bits of the key in a few instructions, and
+// only compares the keys of the buckets that match.  So a probe reads one or
+// two cache lines of control bytes instead of a bucket per step, and a miss
+// rarely touches a bucket at all.
+//
+// Unlike DenseMap, the map never compares keys against the empty and
+// tombstone keys of KeyInfoT, which only needs getHashValue and isEqual: any
+// key may be inserted.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_GROUPEDDENSEMAP_H
+#define LLVM_ADT_GROUPEDDENSEMAP_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/SwapByteOrder.h"
+#include "llvm/Support/type_traits.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace llvm {
+
+namespace detail {
+
+/// The control byte of an empty bucket.  Lookups stop at groups holding one.
+static const int8_t GroupCtrlEmpty = -128;
+/// The control byte of a bucket whose entry was erased.
+static const int8_t GroupCtrlErased = -2;
+// The control byte of a full bucket is the 7 bits of the hash of its key,
+// so it is nonnegative.
+
+/// The buckets of a group matching some condition, as a mask with one set bit
+/// at each bucket: at bit Index << Shift for the bucket at Index.
+template <typename MaskT, unsigned Shift> class GroupMatch {
+  MaskT Bits;
+
+public:
+  explicit GroupMatch(MaskT Bits) : Bits(Bits) {}
+
+  explicit operator bool() const { return Bits != 0; }
+
+  /// The index of the first matching bucket.
+  unsigned first() const {
+    return countTrailingZeros(Bits, ZB_Undefined) >> Shift;
+  }
+
+  /// Drops the first matching bucket.
+  void next() { Bits &= Bits - 1; }
+};
+
+#if defined(__SSE2__)
+
+/// The control bytes of 16 buckets, matched with SSE2 compares.
+class GroupCtrl {
+  __m128i Ctrl;
+
+public:
+  enum { Width = 16 };
+  typedef GroupMatch<unsigned, 0> MatchT;
+
+  explicit GroupCtrl(const int8_t *Pos)
+      : Ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(Pos))) {}
+
+  MatchT match(int8_t HashBits) const {
+    return MatchT(static_cast<unsigned>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(HashBits), Ctrl))));
+  }
+
+  MatchT matchEmpty() const {
+    __m128i Empty = _mm_set1_epi8(GroupCtrlEmpty);
+    return MatchT(
+        static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(Empty, Ctrl))));
+  }
+
+  MatchT matchEmptyOrErased() const {
+    // Both have the sign bit set, and full buckets don't.
+    return MatchT(static_cast<unsigned>(_mm_movemask_epi8(Ctrl)));
+  }
+};
+
+#else
+
+/// The control bytes of 8 buckets, matched with arithmetic on a 64-bit word.
+class GroupCtrl {
+  uint64_t Ctrl;
+
+  static const uint64_t LowBits = 0x0101010101010101ULL;
+  static const uint64_t HighBits = 0x8080808080808080ULL;
+
+public:
+  enum { Width = 8 };
+  typedef GroupMatch<uint64_t, 3> MatchT;
+
+  explicit GroupCtrl(const int8_t *Pos) {
+    memcpy(&Ctrl, Pos, sizeof(Ctrl));
+    // Keep the control byte of the first bucket in the low bits.
+    if (sys::IsBigEndianHost)
+      Ctrl = sys::getSwappedBytes(Ctrl);
+  }
+
+  MatchT match(int8_t HashBits) const {
+    // The bytes equal to HashBits become zero, and the subtraction then sets
+    // their high bits.  It can also set the high bit of a byte above one that
+    // matched, which only costs a comparison of the keys.
+    uint64_t X = Ctrl ^ (LowBits * static_cast<uint8_t>(HashBits));
+    return MatchT((X - LowBits) & ~X & HighBits);
+  }
+
+  MatchT matchEmpty() const {
+    // Only the empty bytes have their high bit set and their bit 1 clear.
+    return MatchT(Ctrl & (~Ctrl << 6) & HighBits);
+  }
+
+  MatchT matchEmptyOrErased() const {
+    return MatchT(Ctrl & HighBits);
+  }
+};
+
+#endif
+
+} // end namespace detail
+
+template <typename KeyT, typename ValueT, typename KeyInfoT, typename Bucket,
+          bool IsConst = false>
+class GroupedDenseMapIterator;
+
+template <typename KeyT, typename ValueT,
+          typename KeyInfoT = DenseMapInfo<KeyT>,
+          typename BucketT = detail::DenseMapPair<KeyT, ValueT>>
+class GroupedDenseMap {
+  typedef detail::GroupCtrl GroupCtrl;
+
+  enum { GroupWidth = GroupCtrl::Width };
+
+  // The buckets, followed by their control bytes in the same allocation.
+  BucketT *Buckets;
+  unsigned NumEntries;
+  unsigned NumErased;
+  unsigned NumBuckets;
+
+public:
+  typedef unsigned size_type;
+  typedef KeyT key_type;
+  typedef ValueT mapped_type;
+  typedef BucketT value_type;
+
+  typedef GroupedDenseMapIterator<KeyT, ValueT, KeyInfoT, BucketT> iterator;
+  typedef GroupedDenseMapIterator<KeyT, ValueT, KeyInfoT, BucketT, true>
+      const_iterator;
+
+  explicit GroupedDenseMap(unsigned NumInitBuckets = 0) {
+    init(NumInitBuckets);
+  }
+
+  GroupedDenseMap(const GroupedDenseMap &other) {
+    init(0);
+    copyFrom(other);
+  }
+
+  GroupedDenseMap(GroupedDenseMap &&other) {
+    init(0);
+    swap(other);
+  }
+
+  template<typename InputIt>
+  GroupedDenseMap(const InputIt &I, const InputIt &E) {
+    init(std::distance(I, E));
+    insert(I, E);
+  }
+
+  ~GroupedDenseMap() {
+    destroyAll();
+    operator delete(Buckets);
+  }
+
+  GroupedDenseMap& operator=(const GroupedDenseMap& other) {
+    if (&other != this)
+      copyFrom(other);
+    return *this;
+  }
+
+  GroupedDenseMap& operator=(GroupedDenseMap &&other) {
+    destroyAll();
+    operator delete(Buckets);
+    init(0);
+    swap(other);
+    return *this;
+  }
+
+  void swap(GroupedDenseMap& RHS) {
+    std::swap(Buckets, RHS.Buckets);
+    std::swap(NumEntries, RHS.NumEntries);
+    std::swap(NumErased, RHS.NumErased);
+    std::swap(NumBuckets, RHS.NumBuckets);
+  }
+
+  inline iterator begin() {
+    // When the map is empty, avoid the overhead of skipping empty buckets.
+    return empty() ? end() : iterator(Buckets, getBucketsEnd(), getCtrl());
+  }
+  inline iterator end() {
+    return iterator(getBucketsEnd(), getBucketsEnd(), nullptr, true);
+  }
+  inline const_iterator begin() const {
+    return empty() ? end()
+                   : const_iterator(Buckets, getBucketsEnd(), getCtrl());
+  }
+  inline const_iterator end() const {
+    return const_iterator(getBucketsEnd(), getBucketsEnd(), nullptr, true);
+  }
+
+  bool LLVM_ATTRIBUTE_UNUSED_RESULT empty() const {
+    return NumEntries == 0;
+  }
+  unsigned size() const { return NumEntries; }
+
+  /// Grow the map so that it has at least Size buckets. Does not shrink
+  void resize(size_type Size) {
+    if (Size > NumBuckets)
+      grow(Size);
+  }
+
+  void clear() {
+    if (NumEntries == 0 && NumErased == 0) return;
+
+    // If the capacity of the array is huge, and the # elements used is small,
+    // shrink the array.
+    if (NumEntries * 4 < NumBuckets && NumBuckets > 64) {
+      shrink_and_clear();
+      return;
+    }
+
+    destroyAll();
+    memset(getCtrl(), detail::GroupCtrlEmpty, NumBuckets);
+    NumEntries = 0;
+    NumErased = 0;
+  }
+
+  /// Return 1 if the specified key is in the map, 0 otherwise.
+  size_type count(const KeyT &Val) const {
+    return lookupBucket(Val) ? 1 : 0;
+  }
+
+  iterator find(const KeyT &Val) {
+    return find_as(Val);
+  }
+  const_iterator find(const KeyT &Val) const {
+    return find_as(Val);
+  }
+
+  /// Alternate version of find() which allows a different, and possibly
+  /// less expensive, key type.
+  /// The KeyInfoT is responsible for supplying methods
+  /// getHashValue(LookupKeyT) and isEqual(LookupKeyT, KeyT) for each key
+  /// type used.
+  template<class LookupKeyT>
+  iterator find_as(const LookupKeyT &Val) {
+    if (BucketT *TheBucket = lookupBucket(Val))
+      return makeIterator(TheBucket);
+    return end();
+  }
+  template<class LookupKeyT>
+  const_iterator find_as(const LookupKeyT &Val) const {
+    if (const BucketT *TheBucket = lookupBucket(Val))
+      return makeIterator(TheBucket);
+    return end();
+  }
+
+  /// lookup - Return the entry for the specified key, or a default
+  /// constructed value if no such entry exists.
+  ValueT lookup(const KeyT &Val) const {
+    if (const BucketT *TheBucket = lookupBucket(Val))
+      return TheBucket->getSecond();
+    return ValueT();
+  }
+
+  // Inserts key,value pair into the map if the key isn't already in the map.
+  // If the key is already in the map, it returns false and doesn't update the
+  // value.
+  std::pair<iterator, bool> insert(const std::pair<KeyT, ValueT> &KV) {
+    unsigned Hash = KeyInfoT::getHashValue(KV.first);
+    if (BucketT *TheBucket = lookupBucket(KV.first, Hash))
+      return std::make_pair(makeIterator(TheBucket),
+                            false); // Already in map.
+
+    // Otherwise, insert the new element.
+    BucketT *TheBucket = insertIntoBucket(Hash);
+    ::new (&TheBucket->getFirst()) KeyT(KV.first);
+    ::new (&TheBucket->getSecond()) ValueT(KV.second);
+    return std::make_pair(makeIterator(TheBucket), true);
+  }
+
+  // Inserts key,value pair into the map if the key isn't already in the map.
+  // If the key is already in the map, it returns false and doesn't update the
+  // value.
+  std::pair<iterator, bool> insert(std::pair<KeyT, ValueT> &&KV) {
+    unsigned Hash = KeyInfoT::getHashValue(KV.first);
+    if (BucketT *TheBucket = lookupBucket(KV.first, Hash))
+      return std::make_pair(makeIterator(TheBucket),
+                            false); // Already in map.
+
+    // Otherwise, insert the new element.
+    BucketT *TheBucket = insertIntoBucket(Hash);
+    ::new (&TheBucket->getFirst()) KeyT(std::move(KV.first));
+    ::new (&TheBucket->getSecond()) ValueT(std::move(KV.second));
+    return std::make_pair(makeIterator(TheBucket), true);
+  }
+
+  /// insert - Range insertion of pairs.
+  template<typename InputIt>
+  void insert(InputIt I, InputIt E) {
+    for (; I != E; ++I)
+      insert(*I);
+  }
+
+  bool erase(const KeyT &Val) {
+    BucketT *TheBucket = lookupBucket(Val);
+    if (!TheBucket)
+      return false; // not in map.
+
+    eraseBucket(TheBucket);
+    return true;
+  }
+  void erase(iterator I) {
+    eraseBucket(&*I);
+  }
+
+  value_type& FindAndConstruct(const KeyT &Key) {
+    unsigned Hash = KeyInfoT::getHashValue(Key);
+    if (BucketT *TheBucket = lookupBucket(Key, Hash))
+      return *TheBucket;
+
+    BucketT *TheBucket = insertIntoBucket(Hash);
+    ::new (&TheBucket->getFirst()) KeyT(Key);
+    ::new (&TheBucket->getSecond()) ValueT();
+    return *TheBucket;
+  }
+
+  ValueT &operator[](const KeyT &Key) {
+    return FindAndConstruct(Key).second;
+  }
+
+  value_type& FindAndConstruct(KeyT &&Key) {
+    unsigned Hash = KeyInfoT::getHashValue(Key);
+    if (BucketT *TheBucket = lookupBucket(Key, Hash))
+      return *TheBucket;
+
+    BucketT *TheBucket = insertIntoBucket(Hash);
+    ::new (&TheBucket->getFirst()) KeyT(std::move(Key));
+    ::new (&TheBucket->getSecond()) ValueT();
+    return *TheBucket;
+  }
+
+  ValueT &operator[](KeyT &&Key) {
+    return FindAndConstruct(std::move(Key)).second;
+  }
+
+  /// isPointerIntoBucketsArray - Return true if the specified pointer points
+  /// somewhere into the map's array of buckets (i.e. either to a key or
+  /// value in the map).
+  bool isPointerIntoBucketsArray(const void *Ptr) const {
+    return Ptr >= Buckets && Ptr < getBucketsEnd();
+  }
+
+  /// getPointerIntoBucketsArray() - Return an opaque pointer into the buckets
+  /// array.  In conjunction with the previous method, this can be used to
+  /// determine whether an insertion caused the map to reallocate.
+  const void *getPointerIntoBucketsArray() const { return Buckets; }
+
+  void grow(unsigned AtLeast) {
+    unsigned OldNumBuckets = NumBuckets;
+    BucketT *OldBuckets = Buckets;
+
+    allocateBuckets(std::max<unsigned>(
+        64, static_cast<unsigned>(NextPowerOf2(AtLeast - 1))));
+    assert(Buckets);
+    initEmpty();
+    if (!OldBuckets)
+      return;
+
+    moveFromOldBuckets(OldBuckets, OldNumBuckets);
+
+    // Free the old table.
+    operator delete(OldBuckets);
+  }
+
+  void shrink_and_clear() {
+    unsigned OldNumEntries = NumEntries;
+    destroyAll();
+
+    // Reduce the number of buckets.
+    unsigned NewNumBuckets = 0;
+    if (OldNumEntries)
+      NewNumBuckets = std::max(64, 1 << (Log2_32_Ceil(OldNumEntries) + 1));
+    if (NewNumBuckets == NumBuckets) {
+      initEmpty();
+      return;
+    }
+
+    operator delete(Buckets);
+    init(NewNumBuckets);
+  }
+
+  /// Return the approximate size (in bytes) of the actual map.
+  /// This is just the raw memory used by the map, control bytes included.
+  /// If entries are pointers to objects, the size of the referenced objects
+  /// are not included.
+  size_t getMemorySize() const {
+    return NumBuckets * (sizeof(BucketT) + 1);
+  }
+
+private:
+  BucketT *getBucketsEnd() const {
+    return Buckets + NumBuckets;
+  }
+
+  int8_t *getCtrl() const {
+    return reinterpret_cast<int8_t *>(getBucketsEnd());
+  }
+
+  iterator makeIterator(BucketT *TheBucket) {
+    return iterator(TheBucket, getBucketsEnd(),
+                    getCtrl() + (TheBucket - Buckets), true);
+  }
+  const_iterator makeIterator(const BucketT *TheBucket) const {
+    return const_iterator(TheBucket, getBucketsEnd(),
+                          getCtrl() + (TheBucket - Buckets), true);
+  }
+
+  /// The 7 bits of the hash that go in the control byte of a bucket, and the
+  /// group where probing starts, from the bits of a product of the hash:
+  /// many DenseMapInfo hashes only vary in some of their bits.
+  static uint64_t mixHash(unsigned Hash) {
+    return static_cast<uint64_t>(Hash) * 0x9E3779B97F4A7C15ULL;
+  }
+  static int8_t getHashBits(uint64_t Mixed) {
+    return static_cast<int8_t>(Mixed >> 57);
+  }
+  unsigned getFirstGroup(uint64_t Mixed) const {
+    return static_cast<unsigned>(Mixed >> 32) & (NumBuckets / GroupWidth - 1);
+  }
+
+  void init(unsigned InitBuckets) {
+    if (InitBuckets == 0) {
+      Buckets = nullptr;
+      NumBuckets = 0;
+      NumEntries = 0;
+      NumErased = 0;
+      return;
+    }
+    allocateBuckets(std::max<unsigned>(
+        GroupWidth, static_cast<unsigned>(NextPowerOf2(InitBuckets - 1))));
+    initEmpty();
+  }
+
+  void initEmpty() {
+    NumEntries = 0;
+    NumErased = 0;
+    memset(getCtrl(), detail::GroupCtrlEmpty, NumBuckets);
+  }
+
+  void allocateBuckets(unsigned Num) {
+    NumBuckets = Num;
+    Buckets = static_cast<BucketT *>(
+        operator new(NumBuckets * (sizeof(BucketT) + 1)));
+  }
+
+  void destroyAll() {
+    if (NumEntries == 0) // Nothing to do.
+      return;
+
+    const int8_t *Ctrl = getCtrl();
+    for (unsigned I = 0; I != NumBuckets; ++I) {
+      if (Ctrl[I] >= 0) {
+        Buckets[I].getSecond().~ValueT();
+        Buckets[I].getFirst().~KeyT();
+      }
+    }
+  }
+
+  void copyFrom(const GroupedDenseMap &other) {
+    destroyAll();
+    operator delete(Buckets);
+    if (other.NumBuckets == 0) {
+      init(0);
+      return;
+    }
+
+    allocateBuckets(other.NumBuckets);
+    NumEntries = other.NumEntries;
+    NumErased = other.NumErased;
+    memcpy(getCtrl(), other.getCtrl(), NumBuckets);
+    if (isPodLike<KeyT>::value && isPodLike<ValueT>::value) {
+      memcpy(Buckets, other.Buckets, NumBuckets * sizeof(BucketT));
+      return;
+    }
+    const int8_t *Ctrl = getCtrl();
+    for (unsigned I = 0; I != NumBuckets; ++I) {
+      if (Ctrl[I] >= 0) {
+        ::new (&Buckets[I].getFirst()) KeyT(other.Buckets[I].getFirst());
+        ::new (&Buckets[I].getSecond()) ValueT(other.Buckets[I].getSecond());
+      }
+    }
+  }
+
+  void moveFromOldBuckets(BucketT *OldBuckets, unsigned OldNumBuckets) {
+    const int8_t *OldCtrl =
+        reinterpret_cast<int8_t *>(OldBuckets + OldNumBuckets);
+    for (unsigned I = 0; I != OldNumBuckets; ++I) {
+      if (OldCtrl[I] < 0)
+        continue;
+      // The keys are all different, so don't look them up.
+      BucketT *B = OldBuckets + I;
+      uint64_t Mixed = mixHash(KeyInfoT::getHashValue(B->getFirst()));
+      BucketT *DestBucket = Buckets + findFreeBucket(Mixed);
+      getCtrl()[DestBucket - Buckets] = getHashBits(Mixed);
+      ::new (&DestBucket->getFirst()) KeyT(std::move(B->getFirst()));
+      ::new (&DestBucket->getSecond()) ValueT(std::move(B->getSecond()));
+      ++NumEntries;
+
+      // Free the old entry.
+      B->getSecond().~ValueT();
+      B->getFirst().~KeyT();
+    }
+
+#ifndef NDEBUG
+    memset((void*)OldBuckets, 0x5a, sizeof(BucketT) * OldNumBuckets);
+#endif
+  }
+
+  /// Return the bucket holding Val, or null if the map doesn't hold it.
+  template <typename LookupKeyT>
+  BucketT *lookupBucket(const LookupKeyT &Val) const {
+    return lookupBucket(Val, KeyInfoT::getHashValue(Val));
+  }
+
+  template <typename LookupKeyT>
+  BucketT *lookupBucket(const LookupKeyT &Val, unsigned Hash) const {
+    if (NumBuckets == 0)
+      return nullptr;
+
+    uint64_t Mixed = mixHash(Hash);
+    int8_t HashBits = getHashBits(Mixed);
+    const int8_t *Ctrl = getCtrl();
+    unsigned GroupMask = NumBuckets / GroupWidth - 1;
+    unsigned Group = getFirstGroup(Mixed);
+    unsigned ProbeAmt = 1;
+    while (1) {
+      GroupCtrl G(Ctrl + Group * GroupWidth);
+      for (GroupCtrl::MatchT M = G.match(HashBits); M; M.next()) {
+        BucketT *ThisBucket = Buckets + Group * GroupWidth + M.first();
+        if (KeyInfoT::isEqual(Val, ThisBucket->getFirst()))
+          return ThisBucket;
+      }
+
+      // An insertion would have stopped at the empty bucket, so the key can't
+      // be further.
+      if (G.matchEmpty())
+        return nullptr;
+
+      // Otherwise, continue quadratic probing over the groups, which visits
+      // all of them.
+      Group = (Group + ProbeAmt++) & GroupMask;
+    }
+  }
+
+  /// Return the index of the first empty or erased bucket in the probe
+  /// sequence for the hash.
+  unsigned findFreeBucket(uint64_t Mixed) const {
+    const int8_t *Ctrl = getCtrl();
+    unsigned GroupMask = NumBuckets / GroupWidth - 1;
+    unsigned Group = getFirstGroup(Mixed);
+    unsigned ProbeAmt = 1;
+    while (1) {
+      GroupCtrl::MatchT M = GroupCtrl(Ctrl + Group * GroupWidth)
+                                .matchEmptyOrErased();
+      if (M)
+        return Group * GroupWidth + M.first();
+      Group = (Group + ProbeAmt++) & GroupMask;
+    }
+  }
+
+  /// Claim a bucket for a new entry with the hash, growing the table first if
+  /// needed, and return it for the caller to construct the entry in.
+  BucketT *insertIntoBucket(unsigned Hash) {
+    // If the load of the hash table is more than 3/4, grow the table, and if
+    // erased buckets make more than 7/8 of the buckets used, rehash them away.
+    // Lookups stop at the first group with an empty bucket, so the table must
+    // keep enough of them for lookups to stay short and to terminate.
+    unsigned NewNumEntries = NumEntries + 1;
+    if (NumBuckets == 0 || NewNumEntries * 4 >= NumBuckets * 3)
+      grow(NumBuckets * 2);
+    else if ((NewNumEntries + NumErased) * 8 > NumBuckets * 7)
+      grow(NumBuckets);
+
+    uint64_t Mixed = mixHash(Hash);
+    unsigned Index = findFreeBucket(Mixed);
+    int8_t *Ctrl = getCtrl();
+    if (Ctrl[Index] == detail::GroupCtrlErased)
+      --NumErased;
+    Ctrl[Index] = getHashBits(Mixed);
+    ++NumEntries;
+    return Buckets + Index;
+  }
+
+  void eraseBucket(BucketT *TheBucket) {
+    TheBucket->getSecond().~ValueT();
+    TheBucket->getFirst().~KeyT();
+    --NumEntries;
+
+    // If the group of the bucket has an empty bucket, no lookup ever probed
+    // past it, and the bucket can become empty too.  Otherwise some lookups
+    // must keep probing past it.
+    unsigned Index = TheBucket - Buckets;
+    int8_t *Ctrl = getCtrl();
+    if (GroupCtrl(Ctrl + Index / GroupWidth * GroupWidth).matchEmpty()) {
+      Ctrl[Index] = detail::GroupCtrlEmpty;
+    } else {
+      Ctrl[Index] = detail::GroupCtrlErased;
+      ++NumErased;
+    }
+  }
+};
+
+template <typename KeyT, typename ValueT, typename KeyInfoT, typename Bucket,
+          bool IsConst>
+class GroupedDenseMapIterator {
+  typedef GroupedDenseMapIterator<KeyT, ValueT, KeyInfoT, Bucket, true>
+      ConstIterator;
+  friend class GroupedDenseMapIterator<KeyT, ValueT, KeyInfoT, Bucket, true>;
+
+public:
+  typedef ptrdiff_t difference_type;
+  typedef typename std::conditional<IsConst, const Bucket, Bucket>::type
+  value_type;
+  typedef value_type *pointer;
+  typedef value_type &reference;
+  typedef std::forward_iterator_tag iterator_category;
+private:
+  pointer Ptr, End;
+  // The control byte of the bucket at Ptr.
+  const int8_t *Ctrl;
+public:
+  GroupedDenseMapIterator() : Ptr(nullptr), End(nullptr), Ctrl(nullptr) {}
+
+  GroupedDenseMapIterator(pointer Pos, pointer E, const int8_t *PosCtrl,
+                          bool NoAdvance = false)
+    : Ptr(Pos), End(E), Ctrl(PosCtrl) {
+    if (!NoAdvance) AdvancePastEmptyBuckets();
+  }
+
+  // If IsConst is true this is a converting constructor from iterator to
+  // const_iterator and the default copy constructor is used.
+  // Otherwise this is a copy constructor for iterator.
+  GroupedDenseMapIterator(
+      const GroupedDenseMapIterator<KeyT, ValueT, KeyInfoT, Bucket, false> &I)
+      : Ptr(I.Ptr), End(I.End), Ctrl(I.Ctrl) {}
+
+  reference operator*() const {
+    return *Ptr;
+  }
+  pointer operator->() const {
+    return Ptr;
+  }
+
+  bool operator==(const ConstIterator &RHS) const {
+    return Ptr == RHS.operator->();
+  }
+  bool operator!=(const ConstIterator &RHS) const {
+    return Ptr != RHS.operator->();
+  }
+
+  inline GroupedDenseMapIterator& operator++() {  // Preincrement
+    ++Ptr;
+    ++Ctrl;
+    AdvancePastEmptyBuckets();
+    return *this;
+  }
+  GroupedDenseMapIterator operator++(int) {  // Postincrement
+    GroupedDenseMapIterator tmp = *this; ++*this; return tmp;
+  }
+
+private:
+  void AdvancePastEmptyBuckets() {
+    while (Ptr != End && *Ctrl < 0) {
+      ++Ptr;
+      ++Ctrl;
+    }
+  }
+};
+
+template<typename KeyT, typename ValueT, typename KeyInfoT>
+static inline size_t
+capacity_in_bytes(const GroupedDenseMap<KeyT, ValueT, KeyInfoT> &X) {
+  return X.getMemorySize();
+}
+
+} // end namespace llvm
+
+#endif
@@ -10,7 +10,7 @@
 // This file defines the 'Statistic' class, which is designed to be an easy way
 // to expose various metrics from passes.  These statistics are printed at the
 // end of a run (from llvm_shutdown), when the -stats command line option is
-// passed on the command line.
+// passed on the command line, as JSON if -stats-json is passed too.
 //
 // This is useful for reporting information like the number of instructions
 // simplified, optimized or removed by various transformations, like this:
@@ -26,85 +26,98 @@
 #ifndef LLVM_ADT_STATISTIC_H
 #define LLVM_ADT_STATISTIC_H
 
-#include "llvm/Support/Atomic.h"
-#include "llvm/Support/Valgrind.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Compiler.h"
+#include <atomic>
+
+// Statistics are collected in builds with assertions, or when LLVM is
+// configured with LLVM_FORCE_ENABLE_STATS.  The latter is decided here rather
+// than in CMake so that every file sees the same answer as NDEBUG.
+#if !defined(LLVM_ENABLE_STATS) && (!defined(NDEBUG) || LLVM_FORCE_ENABLE_STATS)
+#define LLVM_ENABLE_STATS 1
+#endif
 
 namespace llvm {
 class raw_ostream;
 
 class Statistic {
 public:
+  const char *DebugType;
   const char *Name;
   const char *Desc;
-  volatile llvm::sys::cas_flag Value;
-  bool Initialized;
+  std::atomic<unsigned> Value;
+  std::atomic<bool> Initialized;
 
-  llvm::sys::cas_flag getValue() const { return Value; }
+  unsigned getValue() const { return Value.load(std::memory_order_relaxed); }
+  const char *getDebugType() const { return DebugType; }
   const char *getName() const { return Name; }
   const char *getDesc() const { return Desc; }
 
   /// construct - This should only be called for non-global statistics.
-  void construct(const char *name, const char *desc) {
-    Name = name; Desc = desc;
+  void construct(const char *debugtype, const char *name, const char *desc) {
+    DebugType = debugtype; Name = name; Desc = desc;
     Value = 0; Initialized = false;
   }
 
   // Allow use of this class as the value itself.
-  operator unsigned() const { return Value; }
+  operator unsigned() const { return getValue(); }
 
-#if !defined(NDEBUG) || defined(LLVM_ENABLE_STATS)
-   const Statistic &operator=(unsigned Val) {
-    Value = Val;
+#if defined(LLVM_ENABLE_STATS)
+  // The counters are only ever read once the work is done, so bumping them
+  // needs atomicity but no ordering; relaxed operations keep a statistic in a
+  // hot loop as cheap as a plain increment on most targets.
+  const Statistic &operator=(unsigned Val) {
+    Value.store(Val, std::memory_order_relaxed);
     return init();
   }
 
   const Statistic &operator++() {
-    // FIXME: This function and all those that follow carefully use an
-    // atomic operation to update the value safely in the presence of
-    // concurrent accesses, but not to read the return value, so the
-    // return value is not thread safe.
-    sys::AtomicIncrement(&Value);
+    Value.fetch_add(1, std::memory_order_relaxed);
     return init();
   }
 
   unsigned operator++(int) {
     init();
-    unsigned OldValue = Value;
-    sys::AtomicIncrement(&Value);
-    return OldValue;
+    return Value.fetch_add(1, std::memory_order_relaxed);
   }
 
   const Statistic &operator--() {
-    sys::AtomicDecrement(&Value);
+    Value.fetch_sub(1, std::memory_order_relaxed);
     return init();
   }
 
   unsigned operator--(int) {
     init();
-    unsigned OldValue = Value;
-    sys::AtomicDecrement(&Value);
-    return OldValue;
+    return Value.fetch_sub(1, std::memory_order_relaxed);
   }
 
-  const Statistic &operator+=(const unsigned &V) {
-    if (!V) return *this;
-    sys::AtomicAdd(&Value, V);
+  const Statistic &operator+=(unsigned V) {
+    if (V == 0)
+      return *this;
+    Value.fetch_add(V, std::memory_order_relaxed);
     return init();
   }
 
-  const Statistic &operator-=(const unsigned &V) {
-    if (!V) return *this;
-    sys::AtomicAdd(&Value, -V);
+  const Statistic &operator-=(unsigned V) {
+    if (V == 0)
+      return *this;
+    Value.fetch_sub(V, std::memory_order_relaxed);
     return init();
   }
 
-  const Statistic &operator*=(const unsigned &V) {
-    sys::AtomicMul(&Value, V);
+  const Statistic &operator*=(unsigned V) {
+    unsigned Old = Value.load(std::memory_order_relaxed);
+    while (!Value.compare_exchange_weak(Old, Old * V,
+                                        std::memory_order_relaxed))
+      ;
     return init();
   }
 
-  const Statistic &operator/=(const unsigned &V) {
-    sys::AtomicDiv(&Value, V);
+  const Statistic &operator/=(unsigned V) {
+    unsigned Old = Value.load(std::memory_order_relaxed);
+    while (!Value.compare_exchange_weak(Old, Old / V,
+                                        std::memory_order_relaxed))
+      ;
     return init();
   }
 
@@ -146,14 +159,14 @@ public:
     return *this;
   }
 
-#endif  // !defined(NDEBUG) || defined(LLVM_ENABLE_STATS)
+#endif  // defined(LLVM_ENABLE_STATS)
 
 protected:
   Statistic &init() {
-    bool tmp = Initialized;
-    sys::MemoryFence();
-    if (!tmp) RegisterStatistic();
-    TsanHappensAfter(this);
+    // Registration is idempotent and takes a lock, so a stale read here only
+    // costs a trip through RegisterStatistic.
+    if (LLVM_UNLIKELY(!Initialized.load(std::memory_order_relaxed)))
+      RegisterStatistic();
     return *this;
   }
   void RegisterStatistic();
@@ -161,21 +174,32 @@ protected:
 
 // STATISTIC - A macro to make definition of statistics really simple.  This
 // automatically passes the DEBUG_TYPE of the file into the statistic.
-#define STATISTIC(VARNAME, DESC) \
-  static llvm::Statistic VARNAME = { DEBUG_TYPE, DESC, 0, 0 }
+#define STATISTIC(VARNAME, DESC)                                               \
+  static llvm::Statistic VARNAME = {DEBUG_TYPE, #VARNAME, DESC, {0}, {false}}
 
-/// \brief Enable the collection and printing of statistics.
-void EnableStatistics();
+/// \brief Enable the collection and printing of statistics.  If PrintOnExit is
+/// false, the statistics are collected but only printed when asked for, e.g.
+/// by PrintStatisticsJSON.
+void EnableStatistics(bool PrintOnExit = true);
 
 /// \brief Check if statistics are enabled.
 bool AreStatisticsEnabled();
 
-/// \brief Print statistics to the file returned by CreateInfoOutputFile().
+/// \brief Print statistics to the file returned by CreateInfoOutputFile(),
+/// unless they were only enabled with EnableStatistics(false).
 void PrintStatistics();
 
 /// \brief Print statistics to the given output stream.
 void PrintStatistics(raw_ostream &OS);
 
+/// \brief Print statistics in JSON format, as one object mapping
+/// "<debug type>.<name>" to each statistic's value.
+void PrintStatisticsJSON(raw_ostream &OS);
+
+/// \brief Zero the statistics collected so far, so that a process running
+/// several jobs can report each separately.
+void ResetStatistics();
+
 } // End llvm namespace
 
 #endif
@@ -560,6 +560,34 @@ public:
     copyValue(Old, New);
     deleteValue(Old);
   }
+
+  //===--------------------------------------------------------------------===//
+  /// Methods that clients may call around a batch of queries that they make
+  /// without changing the program in between, such as when building alias
+  /// sets.  Alias analyses may then keep what they learn about a pointer from
+  /// one query to the next instead of recomputing it.  Batches nest, and
+  /// deleteValue still has to be called for any value deleted in a batch.
+  ///
+
+  /// beginBatchQueries - Start a batch of queries.
+  virtual void beginBatchQueries();
+
+  /// endBatchQueries - End the batch of queries started by the matching call
+  /// to beginBatchQueries.
+  virtual void endBatchQueries();
+
+  /// BatchQueryScope - Makes the queries made during its lifetime a batch.
+  class BatchQueryScope {
+    AliasAnalysis &AA;
+    BatchQueryScope(const BatchQueryScope &) = delete;
+    void operator=(const BatchQueryScope &) = delete;
+
+  public:
+    explicit BatchQueryScope(AliasAnalysis &AA) : AA(AA) {
+      AA.beginBatchQueries();
+    }
+    ~BatchQueryScope() { AA.endBatchQueries(); }
+  };
 };
 
 // Specialize DenseMapInfo for Location.
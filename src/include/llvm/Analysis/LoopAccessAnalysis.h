@@ -16,6 +16,7 @@
 #define LLVM_ANALYSIS_LOOPACCESSANALYSIS_H
 
 #include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/Analysis/AliasAnalysis.h"
@@ -503,6 +504,138 @@ const SCEV *replaceSymbolicStrideSCEV(ScalarEvolution *SE,
                                       const ValueToValueMap &PtrToStride,
                                       Value *Ptr, Value *OrigPtr = nullptr);
 
+/// \brief Check the stride of the pointer and ensure that it does not wrap in
+/// the address space.  Returns the stride in units of the pointee type, or zero
+/// if the access through \p Ptr does not have a constant stride.
+int isStridedPtr(ScalarEvolution *SE, Value *Ptr, const Loop *Lp,
+                 const ValueToValueMap &StridesMap);
+
+/// \brief A group of loads or stores with the same constant stride whose
+/// addresses are at constant distances from one another, e.g. the accesses to
+/// A[2*i] and A[2*i+1].
+///
+/// The stride is the interleave factor of the group and each member has an
+/// index within [0, Factor).  A load group may have gaps, i.e. indices without
+/// a member, a store group may not.  The group is vectorized as one wide memory
+/// operation at its insert position plus shuffles.
+class InterleaveGroup {
+public:
+  InterleaveGroup(Instruction *Instr, int Stride, unsigned Align)
+      : Align(Align), SmallestKey(0), LargestKey(0), InsertPos(Instr) {
+    assert(Align && "The alignment should be non-zero");
+
+    Factor = std::abs(Stride);
+    assert(Factor > 1 && "Invalid interleave factor");
+
+    Reverse = Stride < 0;
+    Members[0] = Instr;
+  }
+
+  bool isReverse() const { return Reverse; }
+  unsigned getFactor() const { return Factor; }
+  unsigned getAlignment() const { return Align; }
+  unsigned getNumMembers() const { return Members.size(); }
+
+  /// \brief Try to insert \p Instr at \p Index relative to the smallest index
+  /// of the group.  Returns false if the index is taken or would make the group
+  /// span more than Factor elements.
+  bool insertMember(Instruction *Instr, int Index, unsigned NewAlign);
+
+  /// \brief Get the member with index \p Index, or null if there is a gap.
+  Instruction *getMember(unsigned Index) const {
+    auto I = Members.find(SmallestKey + Index);
+    return I == Members.end() ? nullptr : I->second;
+  }
+
+  /// \brief Get the index of the member \p Instr.
+  unsigned getIndex(Instruction *Instr) const {
+    for (auto I : Members)
+      if (I.second == Instr)
+        return I.first - SmallestKey;
+
+    llvm_unreachable("InterleaveGroup contains no such member");
+  }
+
+  /// \brief The instruction at which the whole group is emitted: the first
+  /// load of a load group or the last store of a store group.
+  Instruction *getInsertPos() const { return InsertPos; }
+  void setInsertPos(Instruction *Inst) { InsertPos = Inst; }
+
+private:
+  unsigned Factor;
+  bool Reverse;
+  unsigned Align;
+  DenseMap<int, Instruction *> Members;
+  int SmallestKey;
+  int LargestKey;
+  Instruction *InsertPos;
+};
+
+/// \brief Drive the analysis of interleaved memory accesses in a loop.
+///
+/// Only loops without predicated blocks are analyzed, and a group is only
+/// kept if emitting all of its members at the insert position cannot reorder
+/// them with any other memory access that may conflict.
+class InterleavedAccessInfo {
+public:
+  InterleavedAccessInfo(ScalarEvolution *SE, Loop *L, DominatorTree *DT)
+      : SE(SE), TheLoop(L), DT(DT) {}
+
+  ~InterleavedAccessInfo();
+
+  /// \brief Analyze the interleaved accesses and collect them in interleave
+  /// groups.  Substitute symbolic strides using \p Strides.
+  void analyzeInterleaving(const ValueToValueMap &Strides);
+
+  /// \brief Check if \p Instr belongs to any interleave group.
+  bool isInterleaved(Instruction *Instr) const {
+    return InterleaveGroupMap.count(Instr);
+  }
+
+  /// \brief Get the interleave group that \p Instr belongs to, or null.
+  InterleaveGroup *getInterleaveGroup(Instruction *Instr) const {
+    return InterleaveGroupMap.lookup(Instr);
+  }
+
+  /// \brief The largest interleave factor that is analyzed.
+  static const unsigned MaxInterleaveGroupFactor = 4;
+
+private:
+  struct StrideDescriptor {
+    StrideDescriptor() : Stride(0), Scev(nullptr), Size(0), Align(0) {}
+    StrideDescriptor(int Stride, const SCEV *Scev, unsigned Size,
+                     unsigned Align)
+        : Stride(Stride), Scev(Scev), Size(Size), Align(Align) {}
+
+    int Stride;
+    const SCEV *Scev;
+    unsigned Size;
+    unsigned Align;
+  };
+
+  /// \brief Collect the accesses with a constant stride, in program order.
+  void collectConstStridedAccesses(
+      MapVector<Instruction *, StrideDescriptor> &StrideAccesses,
+      const ValueToValueMap &Strides);
+
+  InterleaveGroup *createInterleaveGroup(Instruction *Instr, int Stride,
+                                         unsigned Align);
+
+  /// \brief Check that the members of \p Group can be emitted together and
+  /// move its insert position to where they are emitted.
+  bool legalizeGroup(InterleaveGroup *Group);
+
+  /// \brief Remove \p Group and let its members be vectorized on their own.
+  void releaseGroup(InterleaveGroup *Group);
+
+  ScalarEvolution *SE;
+  Loop *TheLoop;
+  DominatorTree *DT;
+
+  /// \brief Maps each member to its group.
+  DenseMap<Instruction *, InterleaveGroup *> InterleaveGroupMap;
+};
+
 /// \brief This analysis provides dependence information for the memory accesses
 /// of a loop.
 ///
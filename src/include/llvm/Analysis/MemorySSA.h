@@ -0,0 +1,431 @@
+//===- llvm/Analysis/MemorySSA.h - Memory SSA form --------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief This file defines Memory SSA, a def-use form of the memory accesses
+/// of a function.
+///
+/// Every instruction that may write memory gets a MemoryDef, which produces a
+/// new version of all of memory, and every other instruction that may read
+/// memory gets a MemoryUse.  Blocks where different versions meet get a
+/// MemoryPhi, and the version of memory on entry to the function is the
+/// live-on-entry MemoryDef.  Each MemoryUse and MemoryDef refers to the
+/// version it follows, its defining access, so that walking up the defining
+/// accesses visits every earlier write that may reach the instruction, like
+/// MemoryDependenceAnalysis does by scanning the instructions backwards.
+///
+/// The versions are not disambiguated when they are built.  A MemorySSAWalker
+/// skips the defining accesses that do not alias the location of a query, and
+/// caches the answers, so that repeated queries do not walk the function
+/// again.  The form can be updated as its users change the IR, instead of
+/// being recomputed.
+///
+/// For example:
+/// \code
+///   define void @f(i32* %a, i32* noalias %b) {
+///   ; 1 = MemoryDef(liveOnEntry)
+///     store i32 0, i32* %a
+///   ; 2 = MemoryDef(1)
+///     store i32 1, i32* %b
+///   ; MemoryUse(2)
+///     %x = load i32, i32* %a
+///     ret void
+///   }
+/// \endcode
+/// The load is a MemoryUse of the version produced by the store to %b, but
+/// the walker finds that its clobber is the store to %a.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_MEMORYSSA_H
+#define LLVM_ANALYSIS_MEMORYSSA_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/iterator_range.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Pass.h"
+#include <list>
+#include <memory>
+
+namespace llvm {
+
+class BasicBlock;
+class DominatorTree;
+class Function;
+class Instruction;
+class MemorySSA;
+class MemorySSAWalker;
+class raw_ostream;
+
+/// \brief The base of the accesses of Memory SSA.
+///
+/// MemoryAccesses are not Values: they refer to each other through their
+/// defining accesses and incoming values, and keep the list of the accesses
+/// that refer to them.
+class MemoryAccess {
+public:
+  enum AccessKind { UseKind, DefKind, PhiKind };
+
+  virtual ~MemoryAccess();
+
+  AccessKind getKind() const { return Kind; }
+  BasicBlock *getBlock() const { return Block; }
+
+  /// \brief The accesses that refer to this one, once per reference.
+  typedef SmallVectorImpl<MemoryAccess *>::const_iterator user_iterator;
+  iterator_range<user_iterator> users() const {
+    return make_range(Users.begin(), Users.end());
+  }
+  bool hasUsers() const { return !Users.empty(); }
+
+  /// \brief Make the users of this access refer to \p New instead.
+  void replaceAllUsesWith(MemoryAccess *New);
+
+  virtual void print(raw_ostream &OS) const = 0;
+  /// \brief Print how this access is referred to by others.
+  virtual void printID(raw_ostream &OS) const = 0;
+  void dump() const;
+
+protected:
+  friend class MemorySSA;
+  friend class MemoryUseOrDef;
+  friend class MemoryPhi;
+
+  MemoryAccess(AccessKind Kind, BasicBlock *BB) : Kind(Kind), Block(BB) {}
+
+  void addUser(MemoryAccess *User) { Users.push_back(User); }
+  void removeUser(MemoryAccess *User);
+
+private:
+  MemoryAccess(const MemoryAccess &) = delete;
+  void operator=(const MemoryAccess &) = delete;
+
+  AccessKind Kind;
+  BasicBlock *Block;
+  SmallVector<MemoryAccess *, 4> Users;
+};
+
+inline raw_ostream &operator<<(raw_ostream &OS, const MemoryAccess &MA) {
+  MA.print(OS);
+  return OS;
+}
+
+/// \brief The access of an instruction, which follows the memory version
+/// produced by its defining access.
+class MemoryUseOrDef : public MemoryAccess {
+public:
+  Instruction *getMemoryInst() const { return MemoryInst; }
+  MemoryAccess *getDefiningAccess() const { return DefiningAccess; }
+
+  /// \brief Make \p DMA the defining access, as when a MemoryDef has been
+  /// added in front of this access.  The walker's cached clobbers for this
+  /// access must be invalidated by the caller.
+  void setDefiningAccess(MemoryAccess *DMA);
+
+  static bool classof(const MemoryAccess *MA) {
+    return MA->getKind() != PhiKind;
+  }
+
+protected:
+  friend class MemoryAccess;
+  friend class MemorySSA;
+
+  MemoryUseOrDef(AccessKind Kind, Instruction *MI, BasicBlock *BB)
+      : MemoryAccess(Kind, BB), MemoryInst(MI), DefiningAccess(nullptr) {}
+  ~MemoryUseOrDef() override;
+
+private:
+  Instruction *MemoryInst;
+  MemoryAccess *DefiningAccess;
+};
+
+/// \brief The access of an instruction that may read memory but does not
+/// write it.
+class MemoryUse final : public MemoryUseOrDef {
+public:
+  static bool classof(const MemoryAccess *MA) {
+    return MA->getKind() == UseKind;
+  }
+
+  void print(raw_ostream &OS) const override;
+  void printID(raw_ostream &OS) const override;
+
+protected:
+  friend class MemorySSA;
+
+  MemoryUse(Instruction *MI, BasicBlock *BB)
+      : MemoryUseOrDef(UseKind, MI, BB) {}
+};
+
+/// \brief The access of an instruction that may write memory, which produces
+/// a new version of memory.
+///
+/// The live-on-entry definition is a MemoryDef without an instruction.
+class MemoryDef final : public MemoryUseOrDef {
+public:
+  static bool classof(const MemoryAccess *MA) {
+    return MA->getKind() == DefKind;
+  }
+
+  unsigned getID() const { return ID; }
+
+  void print(raw_ostream &OS) const override;
+  void printID(raw_ostream &OS) const override;
+
+protected:
+  friend class MemorySSA;
+
+  MemoryDef(Instruction *MI, BasicBlock *BB, unsigned ID)
+      : MemoryUseOrDef(DefKind, MI, BB), ID(ID) {}
+
+private:
+  unsigned ID;
+};
+
+/// \brief The version of memory at the start of a block whose predecessors
+/// may end with different versions.
+///
+/// Like a PHINode, a MemoryPhi has one incoming value per predecessor edge.
+class MemoryPhi final : public MemoryAccess {
+public:
+  static bool classof(const MemoryAccess *MA) {
+    return MA->getKind() == PhiKind;
+  }
+
+  unsigned getID() const { return ID; }
+
+  unsigned getNumIncomingValues() const { return Operands.size(); }
+  MemoryAccess *getIncomingValue(unsigned I) const {
+    return Operands[I].second;
+  }
+  BasicBlock *getIncomingBlock(unsigned I) const { return Operands[I].first; }
+
+  /// \brief Return the incoming value of the first edge from \p BB, or null.
+  MemoryAccess *getIncomingValueForBlock(const BasicBlock *BB) const;
+
+  void addIncoming(MemoryAccess *MA, BasicBlock *BB);
+  void setIncomingValue(unsigned I, MemoryAccess *MA);
+
+  void print(raw_ostream &OS) const override;
+  void printID(raw_ostream &OS) const override;
+
+protected:
+  friend class MemorySSA;
+
+  MemoryPhi(BasicBlock *BB, unsigned ID) : MemoryAccess(PhiKind, BB), ID(ID) {}
+  ~MemoryPhi() override;
+
+private:
+  unsigned ID;
+  SmallVector<std::pair<BasicBlock *, MemoryAccess *>, 4> Operands;
+};
+
+/// \brief The Memory SSA form of a function.
+class MemorySSA {
+public:
+  /// \brief The accesses of a block in program order, its MemoryPhi first.
+  typedef std::list<MemoryAccess *> AccessListType;
+
+  MemorySSA(Function &F, AliasAnalysis *AA, DominatorTree *DT);
+  ~MemorySSA();
+
+  Function &getFunction() const { return F; }
+  AliasAnalysis *getAliasAnalysis() const { return AA; }
+
+  /// \brief Return the walker used to find the clobbers of accesses.
+  MemorySSAWalker *getWalker();
+
+  /// \brief Return the MemoryUse or MemoryDef of \p I, or null if it does not
+  /// access memory.
+  MemoryUseOrDef *getMemoryAccess(const Instruction *I) const;
+
+  /// \brief Return the MemoryPhi of \p BB, or null if it has none.
+  MemoryPhi *getMemoryAccess(const BasicBlock *BB) const;
+
+  /// \brief Return the accesses of \p BB, or null if it has none.
+  const AccessListType *getBlockAccesses(const BasicBlock *BB) const {
+    auto It = PerBlockAccesses.find(BB);
+    return It == PerBlockAccesses.end() ? nullptr : It->second.get();
+  }
+
+  MemoryDef *getLiveOnEntryDef() const { return LiveOnEntryDef.get(); }
+  bool isLiveOnEntryDef(const MemoryAccess *MA) const {
+    return MA == LiveOnEntryDef.get();
+  }
+
+  /// \brief Whether \p A comes before \p B in their block, or is \p B.
+  bool locallyDominates(const MemoryAccess *A, const MemoryAccess *B) const;
+
+  /// \brief Whether the version of memory \p A refers to is available at
+  /// \p B.
+  bool dominates(const MemoryAccess *A, const MemoryAccess *B) const;
+
+  /// \name Updates
+  /// Passes that change the IR keep the form up to date with these.  They
+  /// are responsible for the defining accesses of the accesses after a new
+  /// MemoryDef, which are left alone.
+  /// @{
+
+  enum InsertionPlace { Beginning, End };
+
+  /// \brief Add the access of \p I, which must access memory, to the
+  /// beginning or the end of \p BB, with \p Definition as its defining
+  /// access.
+  MemoryUseOrDef *createMemoryAccessInBB(Instruction *I,
+                                         MemoryAccess *Definition,
+                                         BasicBlock *BB, InsertionPlace Point);
+
+  /// \brief Add the access of \p I, which must access memory, right before
+  /// \p InsertPt, with \p Definition as its defining access.
+  MemoryUseOrDef *createMemoryAccessBefore(Instruction *I,
+                                           MemoryAccess *Definition,
+                                           MemoryUseOrDef *InsertPt);
+
+  /// \brief Add the access of \p I, which must access memory, right after
+  /// \p InsertPt, with \p Definition as its defining access.
+  MemoryUseOrDef *createMemoryAccessAfter(Instruction *I,
+                                          MemoryAccess *Definition,
+                                          MemoryAccess *InsertPt);
+
+  /// \brief Remove \p MA, whose instruction is about to be erased.
+  ///
+  /// The users of a MemoryUse or MemoryDef are given its defining access.  A
+  /// MemoryPhi that is still used must have a single incoming value besides
+  /// itself, which replaces it.
+  void removeMemoryAccess(MemoryAccess *MA);
+
+  /// @}
+
+  /// \brief Check the invariants of the form, asserting if one is broken.
+  void verifyMemorySSA() const;
+
+  void print(raw_ostream &OS) const;
+  void dump() const;
+
+private:
+  MemorySSA(const MemorySSA &) = delete;
+  void operator=(const MemorySSA &) = delete;
+
+  void buildMemorySSA();
+  void placePHINodes(const SmallPtrSetImpl<BasicBlock *> &DefiningBlocks);
+  MemoryAccess *renameBlock(BasicBlock *BB, MemoryAccess *IncomingVal);
+  MemoryUseOrDef *createNewAccess(Instruction *I, BasicBlock *BB);
+  AccessListType &getOrCreateAccessList(const BasicBlock *BB);
+  AccessListType::iterator findInBlock(const MemoryAccess *MA);
+  MemoryUseOrDef *insertAccess(MemoryUseOrDef *NewAccess,
+                               MemoryAccess *Definition, BasicBlock *BB,
+                               AccessListType::iterator InsertPt);
+
+  Function &F;
+  AliasAnalysis *AA;
+  DominatorTree *DT;
+  unsigned NextID;
+  std::unique_ptr<MemoryDef> LiveOnEntryDef;
+  DenseMap<const BasicBlock *, std::unique_ptr<AccessListType>>
+      PerBlockAccesses;
+  // The MemoryUseOrDef of each instruction and the MemoryPhi of each block.
+  DenseMap<const Value *, MemoryAccess *> ValueToMemoryAccess;
+  std::unique_ptr<MemorySSAWalker> Walker;
+};
+
+/// \brief Finds the accesses that actually clobber the memory read or
+/// written by other accesses.
+class MemorySSAWalker {
+public:
+  explicit MemorySSAWalker(MemorySSA *MSSA) : MSSA(MSSA) {}
+  virtual ~MemorySSAWalker();
+
+  /// \brief Return the nearest access before \p I that may write the memory
+  /// \p I accesses.
+  ///
+  /// This is a MemoryDef that may clobber it, or the live-on-entry
+  /// definition, or a MemoryPhi where the paths to different clobbers meet.
+  /// The result always dominates \p I.
+  virtual MemoryAccess *getClobberingMemoryAccess(const Instruction *I) = 0;
+
+  /// \brief Return the nearest access from \p StartingAccess up, inclusive,
+  /// that may write \p Loc.
+  ///
+  /// This is how clients ask about a location derived from an instruction,
+  /// such as a pointer translated through a PHI node.
+  virtual MemoryAccess *
+  getClobberingMemoryAccess(MemoryAccess *StartingAccess,
+                            const AliasAnalysis::Location &Loc) = 0;
+
+  /// \brief Forget what is known about \p MA, which is being changed or
+  /// removed.
+  virtual void invalidateInfo(MemoryAccess *MA) {}
+
+protected:
+  MemorySSA *MSSA;
+};
+
+/// \brief A walker that answers with the defining access, for clients that
+/// disambiguate themselves.
+class DoNothingMemorySSAWalker final : public MemorySSAWalker {
+public:
+  explicit DoNothingMemorySSAWalker(MemorySSA *MSSA) : MemorySSAWalker(MSSA) {}
+
+  MemoryAccess *getClobberingMemoryAccess(const Instruction *I) override;
+  MemoryAccess *
+  getClobberingMemoryAccess(MemoryAccess *StartingAccess,
+                            const AliasAnalysis::Location &Loc) override;
+};
+
+/// \brief The default walker, which asks alias analysis about each defining
+/// access up to a limit and caches its answers until the form changes.
+class CachingMemorySSAWalker final : public MemorySSAWalker {
+public:
+  CachingMemorySSAWalker(MemorySSA *MSSA, AliasAnalysis *AA);
+  ~CachingMemorySSAWalker() override;
+
+  MemoryAccess *getClobberingMemoryAccess(const Instruction *I) override;
+  MemoryAccess *
+  getClobberingMemoryAccess(MemoryAccess *StartingAccess,
+                            const AliasAnalysis::Location &Loc) override;
+  void invalidateInfo(MemoryAccess *MA) override;
+
+private:
+  struct WalkState;
+
+  MemoryAccess *walk(MemoryAccess *MA, WalkState &State);
+  MemoryAccess *walkPhi(MemoryPhi *Phi, WalkState &State);
+
+  AliasAnalysis *AA;
+  DenseMap<const MemoryAccess *, MemoryAccess *> CachedAccessClobbers;
+  DenseMap<std::pair<const MemoryAccess *, AliasAnalysis::Location>,
+           MemoryAccess *> CachedLocationClobbers;
+};
+
+/// \brief The legacy pass that builds the Memory SSA form of a function, and
+/// prints it with -analyze.
+class MemorySSAWrapperPass : public FunctionPass {
+public:
+  static char ID;
+
+  MemorySSAWrapperPass();
+
+  MemorySSA &getMSSA() { return *MSSA; }
+  const MemorySSA &getMSSA() const { return *MSSA; }
+
+  bool runOnFunction(Function &F) override;
+  void releaseMemory() override;
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+  void verifyAnalysis() const override;
+  void print(raw_ostream &OS, const Module *M = nullptr) const override;
+
+private:
+  std::unique_ptr<MemorySSA> MSSA;
+};
+
+} // End llvm namespace
+
+#endif
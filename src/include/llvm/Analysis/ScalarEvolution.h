@@ -939,6 +939,21 @@ namespace llvm {
                             bool IsSigned, bool NoWrap);
 
   private:
+    /// getOrCreateAddExpr - Return the add expression of the simplified and
+    /// sorted operands \p Ops, creating it if it does not exist yet.
+    const SCEV *getOrCreateAddExpr(SmallVectorImpl<const SCEV *> &Ops,
+                                   SCEV::NoWrapFlags Flags);
+
+    /// getOrCreateMulExpr - Return the mul expression of the simplified and
+    /// sorted operands \p Ops, creating it if it does not exist yet.
+    const SCEV *getOrCreateMulExpr(SmallVectorImpl<const SCEV *> &Ops,
+                                   SCEV::NoWrapFlags Flags);
+
+    /// ArithDepth - The number of add and mul expressions being simplified
+    /// while building the current one.  Past -scalar-evolution-max-arith-depth
+    /// expressions are created without being simplified.
+    unsigned ArithDepth;
+
     FoldingSet<SCEV> UniqueSCEVs;
     BumpPtrAllocator SCEVAllocator;
 
@@ -44,6 +44,12 @@ public:
 private:
   std::unique_ptr<MemoryObject> BitcodeBytes;
 
+  /// The bytes of the stream when they are all in memory, i.e. when it isn't
+  /// streamed. Cursors load whole words from there instead of going through
+  /// BitcodeBytes.
+  const unsigned char *BufferStart = nullptr;
+  size_t BufferSize = 0;
+
   std::vector<BlockInfo> BlockInfoRecords;
 
   /// This is set to true if we don't care about the block/record name
@@ -70,6 +76,8 @@ public:
 
   BitstreamReader &operator=(BitstreamReader &&Other) {
     BitcodeBytes = std::move(Other.BitcodeBytes);
+    BufferStart = Other.BufferStart;
+    BufferSize = Other.BufferSize;
     // Explicitly swap block info, so that nothing gets destroyed twice.
     std::swap(BlockInfoRecords, Other.BlockInfoRecords);
     IgnoreBlockInfoNames = Other.IgnoreBlockInfoNames;
@@ -79,10 +87,17 @@ public:
   void init(const unsigned char *Start, const unsigned char *End) {
     assert(((End-Start) & 3) == 0 &&"Bitcode stream not a multiple of 4 bytes");
     BitcodeBytes.reset(getNonStreamedMemoryObject(Start, End));
+    BufferStart = Start;
+    BufferSize = End - Start;
   }
 
   MemoryObject &getBitcodeBytes() { return *BitcodeBytes; }
 
+  /// Return the start of the bytes of the stream if they are contiguous in
+  /// memory, or null if the stream is streamed.
+  const unsigned char *getBufferStart() const { return BufferStart; }
+  size_t getBufferSize() const { return BufferSize; }
+
   /// This is called by clients that want block/record name information.
   void CollectBlockInfoNames() { IgnoreBlockInfoNames = false; }
   bool isIgnoringBlockInfoNames() { return IgnoreBlockInfoNames; }
@@ -318,6 +333,16 @@ public:
     if (Size != 0 && NextChar >= Size)
       report_fatal_error("Unexpected end of file");
 
+    // Load the next word directly when the bytes are in memory.
+    if (NextChar + sizeof(word_t) <= BitStream->getBufferSize()) {
+      CurWord =
+          support::endian::read<word_t, support::little, support::unaligned>(
+              BitStream->getBufferStart() + NextChar);
+      NextChar += sizeof(word_t);
+      BitsInCurWord = sizeof(word_t) * 8;
+      return;
+    }
+
     // Read the next word from the stream.
     uint8_t Array[sizeof(word_t)] = {0};
 
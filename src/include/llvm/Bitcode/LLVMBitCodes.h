@@ -42,7 +42,11 @@ namespace bitc {
 
     TYPE_BLOCK_ID_NEW,
 
-    USELIST_BLOCK_ID
+    USELIST_BLOCK_ID,
+
+    FUNCTION_SUMMARY_BLOCK_ID,
+
+    SYMTAB_BLOCK_ID
   };
 
 
@@ -73,6 +77,17 @@ namespace bitc {
 
     MODULE_CODE_GCNAME      = 11,  // GCNAME: [strchr x N]
     MODULE_CODE_COMDAT      = 12,  // COMDAT: [selection_kind, name]
+
+    // FUNCTION_INDEX: [blob: offset x N, end offset]. The 64-bit offsets, in
+    // bits from the start of the blob, of where the N function blocks of the
+    // module resume after their ID, and of their end.
+    MODULE_CODE_FUNCTION_INDEX = 13,
+
+    // STRTAB: [strchr x N] or [blob], a part of the string table of the
+    // module, which holds the metadata strings and then the names of the
+    // values. Each record appends to the table, and other records refer to
+    // its strings by offset and size.
+    MODULE_CODE_STRTAB      = 14,
   };
 
   /// PARAMATTR blocks have code for defining a parameter attribute set.
@@ -132,7 +147,9 @@ namespace bitc {
   // The value symbol table only has one code (VST_ENTRY_CODE).
   enum ValueSymtabCodes {
     VST_CODE_ENTRY   = 1,  // VST_ENTRY: [valid, namechar x N]
-    VST_CODE_BBENTRY = 2   // VST_BBENTRY: [bbid, namechar x N]
+    VST_CODE_BBENTRY = 2,  // VST_BBENTRY: [bbid, namechar x N]
+    VST_CODE_STRTAB_ENTRY   = 3,  // [valid, strtab offset, strtab size]
+    VST_CODE_STRTAB_BBENTRY = 4   // [bbid, strtab offset, strtab size]
   };
 
   enum MetadataCodes {
@@ -168,6 +185,7 @@ namespace bitc {
     METADATA_OBJC_PROPERTY = 30,  // [distinct, name, file, line, ...]
     METADATA_IMPORTED_ENTITY=31,  // [distinct, tag, scope, entity, line, name]
     METADATA_MODULE=32,           // [distinct, scope, name, ...]
+    METADATA_STRINGS       = 33,  // [n x size], from the start of the STRTAB
   };
 
   // The constants block (CONSTANTS_BLOCK_ID) describes emission for each
@@ -355,6 +373,34 @@ namespace bitc {
     USELIST_CODE_BB      = 2  // BB: [index..., bb-id]
   };
 
+  /// FUNCTION_SUMMARY blocks describe the function definitions of one or more
+  /// modules. Names and modules are referred to by their position in the
+  /// block; a summary block without MODULE records describes the enclosing
+  /// module.
+  enum FunctionSummaryCodes {
+    FS_CODE_MODULE   = 1, // MODULE:   [strchr x N]
+    FS_CODE_NAME     = 2, // NAME:     [strchr x N]
+    FS_CODE_FUNCTION = 3  // FUNCTION: [module, name, linkage, instcount,
+                          //            referstolocal, callee name...]
+  };
+
+  /// SYMTAB blocks list the symbols of the enclosing module, so that archivers
+  /// and linkers can read them without parsing the module. The symbols are in
+  /// the order IRObjectFile enumerates them: functions, global variables, then
+  /// aliases.
+  enum SymtabCodes {
+    SYMTAB_CODE_SYMBOL = 1 // SYMBOL: [flags, namechar x N]
+  };
+
+  /// The flags of a SYMTAB_CODE_SYMBOL record.
+  enum SymtabFlags {
+    SYMTAB_UNDEFINED       = 1 << 0,
+    SYMTAB_GLOBAL          = 1 << 1,
+    SYMTAB_WEAK            = 1 << 2,
+    SYMTAB_COMMON          = 1 << 3,
+    SYMTAB_FORMAT_SPECIFIC = 1 << 4
+  };
+
   enum AttributeKindCodes {
     // = 0 is unused
     ATTR_KIND_ALIGNMENT = 1,
@@ -19,10 +19,12 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace llvm {
   class BitstreamWriter;
   class DataStreamer;
+  class FunctionInfoIndex;
   class LLVMContext;
   class Module;
   class ModulePass;
@@ -56,6 +58,32 @@ namespace llvm {
   parseBitcodeFile(MemoryBufferRef Buffer, LLVMContext &Context,
                    DiagnosticHandlerFunction DiagnosticHandler = nullptr);
 
+  /// Check whether the specified bitcode buffer contains function summaries,
+  /// either next to a module or as a combined index.
+  bool hasFunctionSummary(MemoryBufferRef Buffer,
+                          DiagnosticHandlerFunction DiagnosticHandler = nullptr);
+
+  /// Read the function summaries of the specified bitcode buffer, without
+  /// parsing the module. The summaries written next to a module are indexed
+  /// as a single module named after the buffer identifier.
+  ErrorOr<std::unique_ptr<FunctionInfoIndex>>
+  getFunctionInfoIndex(MemoryBufferRef Buffer,
+                       DiagnosticHandlerFunction DiagnosticHandler = nullptr);
+
+  /// A symbol of the table written next to a module: its mangled name, and a
+  /// combination of bitc::SymtabFlags.
+  struct BitcodeSymbol {
+    std::string Name;
+    unsigned Flags;
+  };
+
+  /// Read the symbol table written next to the module of the specified
+  /// bitcode buffer, without parsing the module. Modules with module-level
+  /// inline asm have no table, since listing their symbols needs a target.
+  ErrorOr<std::vector<BitcodeSymbol>>
+  getBitcodeSymbolTable(MemoryBufferRef Buffer,
+                        DiagnosticHandlerFunction DiagnosticHandler = nullptr);
+
   /// \brief Write the specified module to the specified raw output stream.
   ///
   /// For streams where it matters, the given stream should be in "binary"
@@ -64,8 +92,20 @@ namespace llvm {
   /// If \c ShouldPreserveUseListOrder, encode the use-list order for each \a
   /// Value in \c M.  These will be reconstructed exactly when \a M is
   /// deserialized.
+  ///
+  /// If \c EmitFunctionSummary, also emit a summary of each function
+  /// definition of \c M, which can be read back with \a getFunctionInfoIndex.
+  ///
+  /// The symbols of \c M are also emitted, to be read back with
+  /// \a getBitcodeSymbolTable.
   void WriteBitcodeToFile(const Module *M, raw_ostream &Out,
-                          bool ShouldPreserveUseListOrder = false);
+                          bool ShouldPreserveUseListOrder = false,
+                          bool EmitFunctionSummary = false);
+
+  /// \brief Write the combined function summary index \p Index, which refers
+  /// to its modules by path, as a bitcode file without a module.
+  void WriteFunctionSummaryToFile(const FunctionInfoIndex &Index,
+                                  raw_ostream &Out);
 
   /// isBitcodeWrapper - Return true if the given bytes are the magic bytes
   /// for an LLVM IR bitcode wrapper.
@@ -150,7 +190,12 @@ namespace llvm {
   }
 
   const std::error_category &BitcodeErrorCategory();
-  enum class BitcodeError { InvalidBitcodeSignature, CorruptedBitcode };
+  enum class BitcodeError {
+    InvalidBitcodeSignature,
+    CorruptedBitcode,
+    NoFunctionSummary,
+    NoSymbolTable
+  };
   inline std::error_code make_error_code(BitcodeError E) {
     return std::error_code(static_cast<int>(E), BitcodeErrorCategory());
   }
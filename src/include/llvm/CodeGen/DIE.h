@@ -15,6 +15,7 @@
 #define LLVM_LIB_CODEGEN_ASMPRINTER_DIE_H
 
 #include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/ilist_node.h"
 #include "llvm/ADT/ilist.h"
@@ -96,8 +97,12 @@ private:
   ///
   SmallVector<DIEAbbrevData, NumInlineAttributes> Data;
 
+  /// DataHash - Hash of the attributes in Data, updated as they are added so
+  /// that uniquing an abbreviation does not need to walk them again.
+  unsigned DataHash;
+
 public:
-  DIEAbbrev(dwarf::Tag T, bool C) : Tag(T), Children(C), Data() {}
+  DIEAbbrev(dwarf::Tag T, bool C) : Tag(T), Children(C), Data(), DataHash(0) {}
 
   // Accessors.
   dwarf::Tag getTag() const { return Tag; }
@@ -111,8 +116,19 @@ public:
   /// abbreviation.
   void AddAttribute(dwarf::Attribute Attribute, dwarf::Form Form) {
     Data.push_back(DIEAbbrevData(Attribute, Form));
+    DataHash = hash_combine(DataHash, unsigned(Attribute), unsigned(Form));
+  }
+
+  /// getHash - Return a hash of the tag, children flag and attributes of the
+  /// abbreviation.  Equal abbreviations have equal hashes.
+  unsigned getHash() const {
+    return hash_combine(unsigned(Tag), Children, DataHash);
   }
 
+  /// isEqual - Return true if this abbreviation describes the same
+  /// organization as \p Other.
+  bool isEqual(const DIEAbbrev &Other) const;
+
   /// Profile - Used to gather unique data for the abbreviation folding set.
   ///
   void Profile(FoldingSetNodeID &ID) const;
@@ -0,0 +1,67 @@
+//===-- llvm/CodeGen/GlobalISel/CallLowering.h - Call lowering --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file describes how to lower LLVM calls, returns and formal arguments
+/// to machine code for the global instruction selector.
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_GLOBALISEL_CALLLOWERING_H
+#define LLVM_CODEGEN_GLOBALISEL_CALLLOWERING_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/IR/Function.h"
+
+namespace llvm {
+
+class MachineIRBuilder;
+class TargetLowering;
+class Value;
+
+/// \brief Target hooks that lower the ABI boundaries of a function: the
+/// incoming formal arguments and the returned value. Targets implement the
+/// parts that they support; the defaults report failure.
+class CallLowering {
+  const TargetLowering *TLI;
+
+protected:
+  /// \brief Getter for the target lowering of the subclass.
+  template <class XXXTargetLowering>
+  const XXXTargetLowering *getTLI() const {
+    return static_cast<const XXXTargetLowering *>(TLI);
+  }
+
+public:
+  CallLowering(const TargetLowering *TLI) : TLI(TLI) {}
+  virtual ~CallLowering() {}
+
+  /// \brief Lower the return of \p Val, which is held in the generic virtual
+  /// register \p VReg, with \p MIRBuilder. \p Val and \p VReg are null for a
+  /// function that returns void.
+  ///
+  /// \return true if the return was lowered, false otherwise.
+  virtual bool lowerReturn(MachineIRBuilder &MIRBuilder, const Value *Val,
+                           unsigned VReg) const {
+    return false;
+  }
+
+  /// \brief Lower the incoming \p Args of the current function into the
+  /// generic virtual registers \p VRegs, with one register per argument.
+  ///
+  /// \return true if the arguments were lowered, false otherwise.
+  virtual bool
+  lowerFormalArguments(MachineIRBuilder &MIRBuilder,
+                       const Function::ArgumentListType &Args,
+                       ArrayRef<unsigned> VRegs) const {
+    return false;
+  }
+};
+
+} // End namespace llvm.
+
+#endif
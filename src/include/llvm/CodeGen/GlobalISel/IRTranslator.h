@@ -0,0 +1,72 @@
+//===-- llvm/CodeGen/GlobalISel/IRTranslator.h - IRTranslator ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file declares the IRTranslator pass, the first step of the global
+/// instruction selector. It translates a whole LLVM IR function into generic
+/// MachineInstrs on generic virtual registers, in one walk over the function
+/// and without building a SelectionDAG for each basic block. The ABI
+/// boundaries are lowered by the target's CallLowering.
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_GLOBALISEL_IRTRANSLATOR_H
+#define LLVM_CODEGEN_GLOBALISEL_IRTRANSLATOR_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/CodeGen/GlobalISel/MachineIRBuilder.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+
+namespace llvm {
+
+class BasicBlock;
+class CallLowering;
+class Instruction;
+class MachineBasicBlock;
+class MachineRegisterInfo;
+class Value;
+
+/// \brief Translate LLVM IR into generic MachineInstrs.
+class IRTranslator : public MachineFunctionPass {
+public:
+  static char ID;
+
+private:
+  /// The call lowering of the current function's subtarget.
+  const CallLowering *CLI;
+  /// The generic virtual register of each value that is not a constant.
+  DenseMap<const Value *, unsigned> ValToVReg;
+  /// The machine basic block of each IR basic block.
+  DenseMap<const BasicBlock *, MachineBasicBlock *> BBToMBB;
+  /// The helper that inserts the translated instructions.
+  MachineIRBuilder MIRBuilder;
+  MachineRegisterInfo *MRI;
+
+  /// \brief Return the generic virtual register holding \p V. Constants are
+  /// materialized at the current insertion point on each use.
+  unsigned getOrCreateVReg(const Value &V);
+
+  /// \brief Return the machine basic block of \p BB, and create it if needed.
+  MachineBasicBlock &getOrCreateBB(const BasicBlock &BB);
+
+  /// \brief Translate \p Inst, and return false if it is not supported.
+  bool translate(const Instruction &Inst);
+  bool translateBinaryOp(unsigned Opcode, const Instruction &Inst);
+  bool translateReturn(const Instruction &Inst);
+  bool translateBr(const Instruction &Inst);
+
+public:
+  IRTranslator();
+
+  const char *getPassName() const override { return "IRTranslator"; }
+
+  bool runOnMachineFunction(MachineFunction &MF) override;
+};
+
+} // End namespace llvm.
+
+#endif
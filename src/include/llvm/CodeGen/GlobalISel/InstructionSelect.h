@@ -0,0 +1,36 @@
+//===-- llvm/CodeGen/GlobalISel/InstructionSelect.h - Select ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file declares the InstructionSelect pass, the last step of the global
+/// instruction selector. It selects each generic MachineInstr of the function
+/// with the target's InstructionSelector.
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_GLOBALISEL_INSTRUCTIONSELECT_H
+#define LLVM_CODEGEN_GLOBALISEL_INSTRUCTIONSELECT_H
+
+#include "llvm/CodeGen/MachineFunctionPass.h"
+
+namespace llvm {
+
+/// \brief Select target instructions for the generic MachineInstrs.
+class InstructionSelect : public MachineFunctionPass {
+public:
+  static char ID;
+
+  InstructionSelect();
+
+  const char *getPassName() const override { return "InstructionSelect"; }
+
+  bool runOnMachineFunction(MachineFunction &MF) override;
+};
+
+} // End namespace llvm.
+
+#endif
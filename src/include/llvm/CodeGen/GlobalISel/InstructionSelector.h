@@ -0,0 +1,37 @@
+//===-- llvm/CodeGen/GlobalISel/InstructionSelector.h -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file declares the target hook that the InstructionSelect pass uses
+/// to turn generic MachineInstrs into target instructions.
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_GLOBALISEL_INSTRUCTIONSELECTOR_H
+#define LLVM_CODEGEN_GLOBALISEL_INSTRUCTIONSELECTOR_H
+
+namespace llvm {
+
+class MachineInstr;
+
+/// \brief Target hook that selects generic MachineInstrs.
+class InstructionSelector {
+public:
+  virtual ~InstructionSelector() {}
+
+  /// \brief Select the generic instruction \p I, whose register operands are
+  /// already in register banks, into one or more target instructions. The
+  /// selection may mutate \p I in place, or replace it; the selected
+  /// instructions must take the place of \p I in its basic block.
+  ///
+  /// \return true if \p I was selected, false otherwise.
+  virtual bool select(MachineInstr &I) const = 0;
+};
+
+} // End namespace llvm.
+
+#endif
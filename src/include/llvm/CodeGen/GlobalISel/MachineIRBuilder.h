@@ -0,0 +1,88 @@
+//===-- llvm/CodeGen/GlobalISel/MachineIRBuilder.h - MIBuilder --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file declares the MachineIRBuilder class, a helper that inserts
+/// MachineInstrs at a given point of a MachineFunction. It is used by the
+/// global instruction selector, which creates generic MachineInstrs directly
+/// from LLVM IR.
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_GLOBALISEL_MACHINEIRBUILDER_H
+#define LLVM_CODEGEN_GLOBALISEL_MACHINEIRBUILDER_H
+
+#include "llvm/CodeGen/MachineBasicBlock.h"
+#include "llvm/IR/DebugLoc.h"
+
+namespace llvm {
+
+class MachineFunction;
+class MachineInstr;
+class TargetInstrInfo;
+
+/// \brief Helper class to build MachineInstrs. It keeps the position where
+/// the next instruction is inserted, and the debug location it is given.
+class MachineIRBuilder {
+  /// The MachineFunction the instructions are built in.
+  MachineFunction *MF;
+  /// The instruction information of the current function's subtarget.
+  const TargetInstrInfo *TII;
+  /// The block that the instructions are inserted into.
+  MachineBasicBlock *MBB;
+  /// The instructions are inserted before this point of MBB.
+  MachineBasicBlock::iterator II;
+  /// The debug location of the instructions that are built.
+  DebugLoc DL;
+
+public:
+  MachineIRBuilder() : MF(nullptr), TII(nullptr), MBB(nullptr) {}
+
+  /// \brief Set the function to build instructions in. This resets the
+  /// insertion point.
+  void setMF(MachineFunction &MF);
+
+  MachineFunction &getMF() {
+    assert(MF && "MachineFunction is not set");
+    return *MF;
+  }
+
+  MachineBasicBlock &getMBB() {
+    assert(MBB && "MachineBasicBlock is not set");
+    return *MBB;
+  }
+
+  /// \brief Insert the next instructions at the beginning of \p BB if
+  /// \p Beginning is true, or at its end otherwise.
+  void setMBB(MachineBasicBlock &BB, bool Beginning = false);
+
+  /// \brief Insert the next instructions before \p MI if \p Before is true,
+  /// or after it otherwise.
+  void setInstr(MachineInstr &MI, bool Before = true);
+
+  void setDebugLoc(DebugLoc DL) { this->DL = DL; }
+
+  /// \brief Build and insert an instruction with \p Opcode and no operands.
+  MachineInstr *buildInstr(unsigned Opcode);
+
+  /// \brief Build and insert `Res = Opcode Op0`.
+  MachineInstr *buildInstr(unsigned Opcode, unsigned Res, unsigned Op0);
+
+  /// \brief Build and insert `Res = Opcode Op0, Op1`.
+  MachineInstr *buildInstr(unsigned Opcode, unsigned Res, unsigned Op0,
+                           unsigned Op1);
+
+  /// \brief Build and insert `Opcode BB`.
+  MachineInstr *buildInstr(unsigned Opcode, MachineBasicBlock &BB);
+
+  /// \brief Build and insert `Res = G_CONSTANT Val`.
+  MachineInstr *buildConstant(unsigned Res, int64_t Val);
+};
+
+} // End namespace llvm.
+
+#endif
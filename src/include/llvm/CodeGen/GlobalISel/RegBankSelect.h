@@ -0,0 +1,37 @@
+//===-- llvm/CodeGen/GlobalISel/RegBankSelect.h - Reg Bank Sel --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file declares the RegBankSelect pass of the global instruction
+/// selector. It assigns each generic virtual register to the register bank
+/// that the target's RegisterBankInfo picks, by giving the register the
+/// register class of that bank. The instructions themselves are unchanged.
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_GLOBALISEL_REGBANKSELECT_H
+#define LLVM_CODEGEN_GLOBALISEL_REGBANKSELECT_H
+
+#include "llvm/CodeGen/MachineFunctionPass.h"
+
+namespace llvm {
+
+/// \brief Assign the generic virtual registers to register banks.
+class RegBankSelect : public MachineFunctionPass {
+public:
+  static char ID;
+
+  RegBankSelect();
+
+  const char *getPassName() const override { return "RegBankSelect"; }
+
+  bool runOnMachineFunction(MachineFunction &MF) override;
+};
+
+} // End namespace llvm.
+
+#endif
@@ -0,0 +1,40 @@
+//===-- llvm/CodeGen/GlobalISel/RegisterBankInfo.h --------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file declares the target hook that the RegBankSelect pass uses to
+/// place generic virtual registers into register banks.
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_GLOBALISEL_REGISTERBANKINFO_H
+#define LLVM_CODEGEN_GLOBALISEL_REGISTERBANKINFO_H
+
+namespace llvm {
+
+class MachineRegisterInfo;
+class TargetRegisterClass;
+
+/// \brief Target information about register banks. A register bank is a set
+/// of registers that generic instructions on the same kind of data can use,
+/// such as the general purpose or the floating point registers. A bank is
+/// represented by its largest allocatable register class for each size.
+class RegisterBankInfo {
+public:
+  virtual ~RegisterBankInfo() {}
+
+  /// \brief Return the register class of the bank that the generic virtual
+  /// register \p VReg, of \p Size bits, should live in, given its definition
+  /// and uses in \p MRI. Return null if no bank can hold it.
+  virtual const TargetRegisterClass *
+  getRegBankClass(unsigned VReg, unsigned Size,
+                  const MachineRegisterInfo &MRI) const = 0;
+};
+
+} // End namespace llvm.
+
+#endif
@@ -416,6 +416,9 @@ extern cl::opt<bool> UseSegmentSetForPhysRegs;
     /// Compute RegMaskSlots and RegMaskBits.
     void computeRegMasks();
 
+    /// Add the memory used by the live intervals to the statistics.
+    void countMemoryUsage();
+
     /// Walk the values in @p LI and check for dead values:
     /// - Dead PHIDef values are marked as unused.
     /// - Dead operands are marked as such.
@@ -30,13 +30,6 @@ template <unsigned Element> class SparseBitVector;
 typedef SparseBitVector<128> LiveVirtRegBitSet;
 #endif
 
-/// Compare a live virtual register segment to a LiveIntervalUnion segment.
-inline bool
-overlap(const LiveInterval::Segment &VRSeg,
-        const IntervalMap<SlotIndex, LiveInterval*>::const_iterator &LUSeg) {
-  return VRSeg.start < LUSeg.stop() && LUSeg.start() < VRSeg.end;
-}
-
 /// Union of live intervals that are strong candidates for coalescing into a
 /// single register (either physical or virtual depending on the context).  We
 /// expect the constituent live intervals to be disjoint, although we may
@@ -45,7 +38,11 @@ class LiveIntervalUnion {
   // A set of live virtual register segments that supports fast insertion,
   // intersection, and removal.
   // Mapping SlotIndex intervals to virtual register numbers.
-  typedef IntervalMap<SlotIndex, LiveInterval*> LiveSegments;
+  //
+  // There is one union per register unit and most of them only ever hold a
+  // handful of segments, so the root node embedded in each union is kept
+  // small. Busy units spill into the shared allocator like before.
+  typedef IntervalMap<SlotIndex, LiveInterval*, 4> LiveSegments;
 
 public:
   // SegmentIter can advance to the next segment ordered by starting position
@@ -206,6 +203,13 @@ public:
   };
 };
 
+/// Compare a live virtual register segment to a LiveIntervalUnion segment.
+inline bool
+overlap(const LiveInterval::Segment &VRSeg,
+        const LiveIntervalUnion::Map::const_iterator &LUSeg) {
+  return VRSeg.start < LUSeg.stop() && LUSeg.start() < VRSeg.end;
+}
+
 } // end namespace llvm
 
 #endif // !defined(LLVM_CODEGEN_LIVEINTERVALUNION_H)
@@ -15,6 +15,7 @@
 #define LLVM_CODEGEN_MACHINEREGISTERINFO_H
 
 #include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/IndexedMap.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/CodeGen/MachineFunction.h"
@@ -62,6 +63,11 @@ private:
   IndexedMap<std::pair<const TargetRegisterClass*, MachineOperand*>,
              VirtReg2IndexFunctor> VRegInfo;
 
+  /// VRegToSize - The size in bits of each generic virtual register. Generic
+  /// virtual registers are created by the global instruction selector and have
+  /// no register class until register bank selection assigns one.
+  DenseMap<unsigned, unsigned> VRegToSize;
+
   /// RegAllocHints - This vector records register allocation hints for virtual
   /// registers. For each virtual register, it keeps a register and hint type
   /// pair making up the allocation hint. Hint type is target specific except
@@ -600,6 +606,16 @@ public:
   ///
   unsigned createVirtualRegister(const TargetRegisterClass *RegClass);
 
+  /// createGenericVirtualRegister - Create and return a new generic virtual
+  /// register of \p Size bits, which has no register class.
+  ///
+  unsigned createGenericVirtualRegister(unsigned Size);
+
+  /// getSize - Return the size in bits of the generic virtual register \p
+  /// VReg, or 0 if \p VReg was not created as a generic virtual register.
+  ///
+  unsigned getSize(unsigned VReg) const { return VRegToSize.lookup(VReg); }
+
   /// getNumVirtRegs - Return the number of virtual registers created.
   ///
   unsigned getNumVirtRegs() const { return VRegInfo.size(); }
@@ -0,0 +1,54 @@
+//===-- llvm/CodeGen/ParallelCG.h - Parallel code generation ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This header declares a function for splitting a module and generating code
+// for the partitions in parallel.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_PARALLELCG_H
+#define LLVM_CODEGEN_PARALLELCG_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include <functional>
+#include <string>
+
+namespace llvm {
+
+class LLVMContext;
+class Module;
+class raw_ostream;
+
+/// Generates code for the partition \p MPart into \p OS. On failure, it
+/// returns false and sets \p ErrMsg.
+typedef std::function<bool(Module &MPart, raw_ostream &OS,
+                           std::string &ErrMsg)> PartitionCodeGenFn;
+
+/// Split \p M into one partition for each stream of \p OSs with SplitModule,
+/// and call \p CodeGen for every partition and its stream, each on a thread
+/// of its own.
+///
+/// An LLVMContext, and the machine code state of the code generator, can only
+/// be used from one thread. So every partition is serialized to bitcode here,
+/// and parsed back by its thread into an LLVMContext of its own, which is
+/// first passed to \p SetupContext if it is set. \p CodeGen must create its
+/// own TargetMachine. Since the partitions are made in a fixed order and each
+/// one goes to its own stream, the output does not depend on the scheduling
+/// of the threads.
+///
+/// \returns true on success. Otherwise, sets \p ErrMsg to the first error in
+/// partition order.
+bool splitCodeGen(Module &M, ArrayRef<raw_ostream *> OSs,
+                  const PartitionCodeGenFn &CodeGen, std::string &ErrMsg,
+                  const std::function<void(LLVMContext &)> &SetupContext =
+                      std::function<void(LLVMContext &)>());
+
+} // End llvm namespace
+
+#endif
@@ -204,6 +204,25 @@ public:
     return true;
   }
 
+  /// addIRTranslator - This method should install the IR translator pass of
+  /// the global instruction selector, which converts from LLVM code to generic
+  /// machine instructions. Returns true if the target does not support it.
+  virtual bool addIRTranslator() {
+    return true;
+  }
+
+  /// addRegBankSelect - This method should install the pass that assigns the
+  /// generic virtual registers to register banks.
+  virtual bool addRegBankSelect() {
+    return true;
+  }
+
+  /// addGlobalInstructionSelect - This method should install the pass that
+  /// selects target instructions for the generic machine instructions.
+  virtual bool addGlobalInstructionSelect() {
+    return true;
+  }
+
   /// Add the complete, standard set of LLVM CodeGen passes.
   /// Fully developed targets will not generally override this.
   virtual void addMachinePasses();
@@ -36,6 +36,7 @@ namespace llvm {
   class GCFunctionInfo;
   class ScheduleDAGSDNodes;
   class LoadInst;
+  class raw_ostream;
 
 /// SelectionDAGISel - This is the common base class used for SelectionDAG-based
 /// pattern-matching instruction selectors.
@@ -66,6 +67,8 @@ public:
 
   bool runOnMachineFunction(MachineFunction &MF) override;
 
+  bool doFinalization(Module &M) override;
+
   virtual void EmitFunctionEntryCode() {}
 
   /// PreprocessISelDAG - This hook allows targets to hack on the graph before
@@ -119,8 +122,10 @@ public:
     OPC_CheckPredicate,
     OPC_CheckOpcode,
     OPC_SwitchOpcode,
+    OPC_SwitchOpcodeTable,
     OPC_CheckType,
     OPC_SwitchType,
+    OPC_SwitchTypeTable,
     OPC_CheckChild0Type, OPC_CheckChild1Type, OPC_CheckChild2Type,
     OPC_CheckChild3Type, OPC_CheckChild4Type, OPC_CheckChild5Type,
     OPC_CheckChild6Type, OPC_CheckChild7Type,
@@ -291,6 +296,25 @@ private:
   /// state machines that start with a OPC_SwitchOpcode node.
   std::vector<unsigned> OpcodeOffset;
 
+  /// SwitchTables - For each OPC_SwitchOpcodeTable and OPC_SwitchTypeTable
+  /// node, the index of the case of each opcode or type, or zero.  Filled in
+  /// the first time the node is reached.
+  std::vector<std::vector<unsigned> > SwitchTables;
+
+  /// FastISelOpcodeCounts - For each IR opcode, the number of instructions
+  /// that fast isel selected, the number that it missed, and the number of
+  /// instructions that were left to SelectionDAG because of those misses.
+  struct FastISelOpcodeCounts {
+    unsigned Selected = 0;
+    unsigned Missed = 0;
+    unsigned FellBack = 0;
+  };
+  std::vector<FastISelOpcodeCounts> FastISelCounts;
+
+  void countFastISelSelected(const Instruction *I);
+  void countFastISelMiss(const Instruction *I, unsigned NumFellBack);
+  void printFastISelFallbacks(raw_ostream &OS) const;
+
   void UpdateChainsAndGlue(SDNode *NodeToMatch, SDValue InputChain,
                            const SmallVectorImpl<SDNode*> &ChainNodesMatched,
                            SDValue InputGlue, const SmallVectorImpl<SDNode*> &F,
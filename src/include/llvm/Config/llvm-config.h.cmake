@@ -35,6 +35,9 @@
 /* Installation directory for config files */
 #cmakedefine LLVM_ETCDIR "${LLVM_ETCDIR}"
 
+/* Define to 1 to collect statistics in builds without assertions */
+#cmakedefine01 LLVM_FORCE_ENABLE_STATS
+
 /* Has gcc/MSVC atomic intrinsics */
 #cmakedefine01 LLVM_HAS_ATOMICS
 
@@ -123,6 +123,19 @@ class DWARFUnit {
   // The compile unit debug information entry items.
   std::vector<DWARFDebugInfoEntryMinimal> DieArray;
 
+  // An address range of a subprogram DIE, indexed by its position in DieArray.
+  struct SubprogramRange {
+    uint64_t LowPC;
+    uint64_t HighPC;
+    // The largest HighPC of this range and of the ones sorted before it.
+    uint64_t MaxHighPC;
+    uint32_t DieIdx;
+  };
+  // The address ranges of the subprogram DIEs sorted by LowPC, built on the
+  // first call to getSubprogramForAddress and cleared with the DIEs.
+  std::vector<SubprogramRange> SubprogramRanges;
+  bool HasSubprogramRanges;
+
   class DWOHolder {
     object::OwningBinary<object::ObjectFile> DWOFile;
     std::unique_ptr<DWARFContext> DWOContext;
@@ -200,6 +213,10 @@ public:
     return DieArray.empty() ? nullptr : &DieArray[0];
   }
 
+  /// clearDIEs - Clear parsed DIEs to keep memory usage low. Pointers to the
+  /// cleared DIEs are invalidated.
+  void clearDIEs(bool KeepCUDie);
+
   const char *getCompilationDir();
   uint64_t getDWOId();
 
@@ -267,13 +284,16 @@ private:
   /// of DIE entries and now we need to go back through all of them and set the
   /// parent, sibling and child pointers for quick DIE navigation.
   void setDIERelations();
-  /// clearDIEs - Clear parsed DIEs to keep memory usage low.
-  void clearDIEs(bool KeepCUDie);
 
   /// parseDWO - Parses .dwo file for current compile unit. Returns true if
   /// it was actually constructed.
   bool parseDWO();
 
+  /// buildSubprogramRanges - Index the address ranges of the subprogram DIEs
+  /// so that looking up the subprogram for an address does not need to walk
+  /// all the DIEs.
+  void buildSubprogramRanges();
+
   /// getSubprogramForAddress - Returns subprogram DIE with address range
   /// encompassing the provided address. The pointer is alive as long as parsed
   /// compile unit DIEs are not cleared.
@@ -408,6 +408,13 @@ public:
     llvm_unreachable("No support for ProcessAllSections option");
   }
 
+  /// setCompileThreads (MCJIT Only): Let finalizeObject generate code for up
+  /// to NumThreads modules at the same time.  Only modules in different
+  /// LLVMContexts are compiled concurrently; symbol resolution and the loading
+  /// of the objects remain serial.  Engines that can't compile modules
+  /// concurrently ignore this.
+  virtual void setCompileThreads(unsigned NumThreads) {}
+
   /// Return the target machine (if available).
   virtual TargetMachine *getTargetMachine() { return nullptr; }
 
@@ -0,0 +1,63 @@
+//===-- FileObjectCache.h - Object cache kept in a directory ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares an ObjectCache that stores the objects compiled for
+// modules in a directory, so that they can be reused by later processes.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_EXECUTIONENGINE_FILEOBJECTCACHE_H
+#define LLVM_EXECUTIONENGINE_FILEOBJECTCACHE_H
+
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include <string>
+
+namespace llvm {
+
+class TargetMachine;
+
+/// An ObjectCache keeping each object in a file of a cache directory, named
+/// after an MD5 hash of the IR of the module and of a key describing the
+/// target it is compiled for. A module that changes in any way, or that is
+/// compiled for another target, gets a file of its own, so the cache never
+/// returns a stale object. It can be given to MCJIT with setObjectCache, or
+/// to an Orc IRCompileLayer with setObjectCache.
+///
+/// Objects are written to a temporary file that is then renamed, so that
+/// processes sharing the directory never read a partial object. Failing to
+/// read or write the cache isn't an error: the module is just compiled.
+class FileObjectCache : public ObjectCache {
+  void anchor() override;
+
+public:
+  /// Creates a cache keeping its objects in CacheDir, which is created when
+  /// the first object is stored. TargetKey must describe everything besides
+  /// the IR that affects the generated code; getTargetKey provides one.
+  FileObjectCache(std::string CacheDir, std::string TargetKey);
+
+  /// Returns a key made of the triple, CPU, features, relocation model, code
+  /// model and optimization level of TM. Clients setting TargetOptions that
+  /// affect the generated code should append them to it.
+  static std::string getTargetKey(const TargetMachine &TM);
+
+  void notifyObjectCompiled(const Module *M, MemoryBufferRef Obj) override;
+
+  std::unique_ptr<MemoryBuffer> getObject(const Module *M) override;
+
+  /// Returns the path of the file caching the object for M.
+  std::string getObjectPath(const Module &M) const;
+
+private:
+  std::string CacheDir;
+  std::string TargetKey;
+};
+
+} // End llvm namespace
+
+#endif
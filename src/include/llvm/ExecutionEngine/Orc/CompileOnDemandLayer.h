@@ -18,7 +18,9 @@
 #include "IndirectionUtils.h"
 #include "LookasideRTDyldMM.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/ThreadPool.h"
 #include <list>
+#include <mutex>
 
 namespace llvm {
 
@@ -32,6 +34,13 @@ namespace llvm {
 /// It is expected that this layer will frequently be used on top of a
 /// LazyEmittingLayer. The combination of the two ensures that each function is
 /// compiled only when it is first called.
+///
+///   The layer may be used from several threads: its operations, including the
+/// compilations triggered by first calls, are serialized by a lock, and the
+/// stubs are updated atomically so that other threads keep executing compiled
+/// code meanwhile. If the layer is given speculation threads, resolving a
+/// function also queues the functions it calls for compilation on these
+/// threads, so that they are likely ready by the time they are called.
 template <typename BaseLayerT> class CompileOnDemandLayer {
 public:
   /// @brief Lookup helper that provides compatibility with the classic
@@ -105,6 +114,55 @@ private:
   typedef typename BaseLayerT::ModuleSetHandleT BaseLayerModuleSetHandleT;
   typedef std::vector<BaseLayerModuleSetHandleT> BaseLayerModuleSetHandleListT;
 
+  // Resolves the functions of one logical module under the layer's lock,
+  // remembering their addresses, and queues the call graph neighbors of each
+  // function resolved on demand for speculative compilation.
+  class ConcurrentCallbackHandler : public JITResolveCallbackHandler {
+  public:
+    ConcurrentCallbackHandler(
+        CompileOnDemandLayer &Parent,
+        std::unique_ptr<JITResolveCallbackHandler> Resolver,
+        std::vector<std::vector<unsigned>> Callees)
+        : Parent(Parent), Resolver(std::move(Resolver)),
+          Callees(std::move(Callees)),
+          Addrs(this->Resolver->getNumFuncs(), 0),
+          Queued(this->Resolver->getNumFuncs(), false) {
+      for (StubIndex I = 0, E = this->Resolver->getNumFuncs(); I != E; ++I)
+        addFuncName(this->Resolver->getFuncName(I));
+    }
+
+    uint64_t resolve(StubIndex StubIdx) override {
+      return resolveImpl(StubIdx, true);
+    }
+
+  private:
+    uint64_t resolveImpl(StubIndex StubIdx, bool Speculate) {
+      std::lock_guard<std::recursive_mutex> Lock(Parent.LayerMutex);
+      // Another thread may have loaded the stub's address before it was
+      // updated, in which case the function is already compiled.
+      uint64_t &Addr = Addrs[StubIdx];
+      if (!Addr)
+        Addr = Resolver->resolve(StubIdx);
+
+      // Only the neighbors of functions that were actually called are
+      // speculated on, so that speculation doesn't compile the whole module.
+      if (Speculate && Parent.SpeculationPool)
+        for (unsigned Callee : Callees[StubIdx])
+          if (!Addrs[Callee] && !Queued[Callee]) {
+            Queued[Callee] = true;
+            Parent.SpeculationPool->async(
+                [this, Callee] { resolveImpl(Callee, false); });
+          }
+      return Addr;
+    }
+
+    CompileOnDemandLayer &Parent;
+    std::unique_ptr<JITResolveCallbackHandler> Resolver;
+    std::vector<std::vector<unsigned>> Callees;
+    std::vector<uint64_t> Addrs;
+    std::vector<bool> Queued;
+  };
+
   struct ModuleSetInfo {
     // Symbol lookup - just one for the whole module set.
     std::shared_ptr<CODScopedLookup> Lookup;
@@ -145,16 +203,22 @@ public:
   typedef std::function<void(Module&, JITResolveCallbackHandler&)>
     InsertCallbackAsmFtor;
 
-  /// @brief Construct a compile-on-demand layer instance.
+  /// @brief Construct a compile-on-demand layer instance, speculatively
+  ///        compiling on SpeculationThreads background threads if non-zero.
   CompileOnDemandLayer(BaseLayerT &BaseLayer,
-                       InsertCallbackAsmFtor InsertCallbackAsm)
-    : BaseLayer(BaseLayer), InsertCallbackAsm(InsertCallbackAsm) {}
+                       InsertCallbackAsmFtor InsertCallbackAsm,
+                       unsigned SpeculationThreads = 0)
+    : BaseLayer(BaseLayer), InsertCallbackAsm(InsertCallbackAsm) {
+    if (SpeculationThreads)
+      SpeculationPool = llvm::make_unique<ThreadPool>(SpeculationThreads);
+  }
 
   /// @brief Add a module to the compile-on-demand layer.
   template <typename ModuleSetT>
   ModuleSetHandleT addModuleSet(ModuleSetT Ms,
                                 std::unique_ptr<RTDyldMemoryManager> MM) {
 
+    std::lock_guard<std::recursive_mutex> Lock(LayerMutex);
     const char *JITAddrSuffix = "$orc_addr";
     const char *JITImplSuffix = "$orc_impl";
 
@@ -173,13 +237,20 @@ public:
       MSI.LMHandles.push_back(LMH);
 
       // Create a persistent mangler for this module.
-      MSI.PersistentManglers.emplace_back(*M->getDataLayout());
+      MSI.PersistentManglers.emplace_back(M->getDataLayout());
 
       // Make all calls to functions defined in this module indirect.
       JITIndirections Indirections =
           makeCallsDoubleIndirect(*M, [](const Function &) { return true; },
                                   JITImplSuffix, JITAddrSuffix);
 
+      // Record the calls between the indirected functions for speculation.
+      std::vector<std::vector<unsigned>> Callees;
+      if (SpeculationPool)
+        Callees = getIndirectedCallees(*M, Indirections);
+      else
+        Callees.resize(Indirections.IndirectedNames.size());
+
       // Then carve up the module into a bunch of single-function modules.
       std::vector<std::unique_ptr<Module>> ExplodedModules =
           explode(*M, Indirections);
@@ -187,9 +258,13 @@ public:
       // Add a resolve-callback handler for this module to look up symbol
       // addresses when requested via a callback.
       MSI.JITResolveCallbackHandlers.push_back(
-          createCallbackHandlerFromJITIndirections(
-              Indirections, MSI.PersistentManglers.back(),
-              [=](StringRef S) { return DylibLookup->lookup(LMH, S); }));
+          llvm::make_unique<ConcurrentCallbackHandler>(
+              *this, createCallbackHandlerFromJITIndirections(
+                         Indirections, MSI.PersistentManglers.back(),
+                         [=](StringRef S) {
+                           return DylibLookup->lookup(LMH, S);
+                         }),
+              std::move(Callees)));
 
       // Insert callback asm code into the first module.
       InsertCallbackAsm(*ExplodedModules[0],
@@ -233,6 +308,10 @@ public:
   ///   This will remove all modules in the layers below that were derived from
   /// the module represented by H.
   void removeModuleSet(ModuleSetHandleT H) {
+    // Pending speculations may refer to this module set.
+    if (SpeculationPool)
+      SpeculationPool->wait();
+    std::lock_guard<std::recursive_mutex> Lock(LayerMutex);
     H->releaseResources(BaseLayer);
     ModuleSetInfos.erase(H);
   }
@@ -240,6 +319,7 @@ public:
   /// @brief Get the address of a symbol provided by this layer, or some layer
   ///        below this one.
   uint64_t getSymbolAddress(const std::string &Name, bool ExportedSymbolsOnly) {
+    std::lock_guard<std::recursive_mutex> Lock(LayerMutex);
     return BaseLayer.getSymbolAddress(Name, ExportedSymbolsOnly);
   }
 
@@ -247,7 +327,9 @@ public:
   ///        below this one.
   uint64_t lookupSymbolAddressIn(ModuleSetHandleT H, const std::string &Name,
                                  bool ExportedSymbolsOnly) {
-    BaseLayerModuleSetHandleListT &BaseLayerHandles = H->second;
+    std::lock_guard<std::recursive_mutex> Lock(LayerMutex);
+    BaseLayerModuleSetHandleListT &BaseLayerHandles =
+        H->BaseLayerModuleSetHandles;
     for (auto &BH : BaseLayerHandles) {
       if (uint64_t Addr =
             BaseLayer.lookupSymbolAddressIn(BH, Name, ExportedSymbolsOnly))
@@ -260,6 +342,10 @@ private:
   BaseLayerT &BaseLayer;
   InsertCallbackAsmFtor InsertCallbackAsm;
   ModuleSetInfoListT ModuleSetInfos;
+  std::recursive_mutex LayerMutex;
+  // Declared last so that it is destroyed, finishing the pending speculations,
+  // before the state they use.
+  std::unique_ptr<ThreadPool> SpeculationPool;
 };
 }
 
@@ -16,6 +16,7 @@
 
 #include "llvm/IR/Mangler.h"
 #include "llvm/IR/Module.h"
+#include <atomic>
 #include <sstream>
 
 namespace llvm {
@@ -195,6 +196,28 @@ JITIndirections makeCallsDoubleIndirect(
     const std::function<bool(const Function &)> &ShouldIndirect,
     const char *JITImplSuffix, const char *JITAddrSuffix);
 
+/// @brief Count the calls to each function indirected by a double
+///        indirection.
+///
+/// @return The names of the counters, in the order of Indirs.IndirectedNames.
+///
+///   For each function 'F' in Indirs, add to the module a zero-initialized,
+/// hidden i64 global variable named after 'F' and JITCountSuffix, and make the
+/// redirecting body of 'F' atomically increment it. Since every call to 'F'
+/// goes through its redirecting body, a JIT can read the counters to find the
+/// functions that are called the most.
+std::vector<std::string> insertCallCounters(Module &M,
+                                            const JITIndirections &Indirs,
+                                            const char *JITCountSuffix);
+
+/// @brief For each function indirected by Indirs, in order, get the indices of
+///        the indirected functions that its implementation calls directly.
+///
+///   A JIT can use these call graph neighbors to compile the functions likely
+/// to be called next ahead of time.
+std::vector<std::vector<unsigned>>
+getIndirectedCallees(const Module &M, const JITIndirections &Indirs);
+
 /// @brief Given a set of indirections and a symbol lookup functor, create a
 ///        JITResolveCallbackHandler instance that will resolve the
 ///        implementations for the indirected symbols on demand.
@@ -214,7 +237,11 @@ createCallbackHandlerFromJITIndirections(const JITIndirections &Indirs,
           [=](const std::string &S, uint64_t Addr) {
             void *ImplPtr = reinterpret_cast<void *>(
                 Lookup(NM.getMangledName(GetAddrName(S))));
-            memcpy(ImplPtr, &Addr, sizeof(uint64_t));
+            // Other threads may be calling through the stub: store the new
+            // address in a single write so that they see either the old or
+            // the new one.
+            reinterpret_cast<std::atomic<uint64_t> *>(ImplPtr)->store(
+                Addr, std::memory_order_release);
           });
 
   for (const auto &FuncName : Indirs.IndirectedNames)
@@ -0,0 +1,354 @@
+//===- TieredCompileLayer.h - Recompile hot functions optimized -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// JIT layer compiling each function quickly first, then recompiling the
+// functions that are called often with an optimizing compiler.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_EXECUTIONENGINE_ORC_TIEREDCOMPILELAYER_H
+#define LLVM_EXECUTIONENGINE_ORC_TIEREDCOMPILELAYER_H
+
+#include "IndirectionUtils.h"
+#include "LookasideRTDyldMM.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+
+namespace llvm {
+
+/// @brief Tiered compilation layer.
+///
+///   Modules added to this layer have their calls indirected and counted, and
+/// are broken up into single-function modules. Each of these is compiled at
+/// once with the fast compiler, typically a SimpleCompiler for a TargetMachine
+/// at CodeGenOpt::None, which selects instructions with FastISel. The
+/// resulting objects are added to the layer below, which must implement the
+/// object layer concept.
+///
+///   The functions called at least HotCallCount times are then recompiled in
+/// the background with the optimizing compiler, and their indirection is
+/// updated atomically to the optimized code: threads calling them meanwhile
+/// keep running the fast code until their next call. The fast code is kept
+/// until the module set is removed, since it may still be running.
+///
+///   The layer may be used from several threads. Its operations and the
+/// compilations are serialized by a lock, so the LLVMContext of the added
+/// modules must not be used elsewhere while the layer may recompile them.
+template <typename BaseLayerT> class TieredCompileLayer {
+public:
+  typedef std::function<object::OwningBinary<object::ObjectFile>(Module &)>
+      CompileFtor;
+
+private:
+  typedef typename BaseLayerT::ObjSetHandleT BaseLayerObjSetHandleT;
+
+  // A function whose implementation can be recompiled.
+  struct TieredFunction {
+    // The single-function module defining the implementation, kept to be
+    // recompiled. Reset once it is.
+    std::unique_ptr<Module> M;
+    std::string ImplName;
+    std::atomic<uint64_t> *ImplAddr;
+    std::atomic<uint64_t> *Counter;
+    bool Queued;
+
+    TieredFunction(std::unique_ptr<Module> M, std::string ImplName)
+        : M(std::move(M)), ImplName(std::move(ImplName)), ImplAddr(nullptr),
+          Counter(nullptr), Queued(false) {}
+  };
+
+  // The objects and functions derived from one of the added modules. Symbols
+  // are looked up in the fast objects of the same module first.
+  struct LogicalModule {
+    PersistentMangler Mangler;
+    std::vector<BaseLayerObjSetHandleT> Handles;
+    std::vector<BaseLayerObjSetHandleT> OptimizedHandles;
+    std::vector<TieredFunction> Functions;
+
+    LogicalModule(DataLayout DL) : Mangler(std::move(DL)) {}
+  };
+
+  struct ModuleSetInfo {
+    std::list<LogicalModule> LogicalModules;
+
+    void releaseResources(BaseLayerT &BaseLayer) {
+      for (auto &LM : LogicalModules) {
+        for (auto H : LM.OptimizedHandles)
+          BaseLayer.removeObjectSet(H);
+        for (auto H : LM.Handles)
+          BaseLayer.removeObjectSet(H);
+      }
+    }
+  };
+
+  typedef std::list<ModuleSetInfo> ModuleSetInfoListT;
+
+public:
+  /// @brief Handle to a set of loaded modules.
+  typedef typename ModuleSetInfoListT::iterator ModuleSetHandleT;
+
+  /// @brief Construct a tiered compilation layer over the given BaseLayer,
+  ///        which must implement the ObjectLayer concept.
+  ///
+  ///   Functions called HotCallCount times are recompiled with Optimize on
+  /// OptimizeThreads background threads. If ScanInterval is non-zero, a
+  /// background thread looks for hot functions that often; otherwise the
+  /// client must call recompileHotFunctions itself.
+  TieredCompileLayer(
+      BaseLayerT &BaseLayer, CompileFtor Compile, CompileFtor Optimize,
+      uint64_t HotCallCount = 1000,
+      std::chrono::milliseconds ScanInterval = std::chrono::milliseconds(10),
+      unsigned OptimizeThreads = 1)
+      : BaseLayer(BaseLayer), Compile(std::move(Compile)),
+        Optimize(std::move(Optimize)), HotCallCount(HotCallCount),
+        Stopping(false), OptimizePool(OptimizeThreads) {
+    if (ScanInterval.count())
+      Scanner = std::thread([this, ScanInterval] { scan(ScanInterval); });
+  }
+
+  ~TieredCompileLayer() {
+    if (Scanner.joinable()) {
+      {
+        std::lock_guard<std::mutex> Lock(ScannerMutex);
+        Stopping = true;
+      }
+      ScannerCond.notify_all();
+      Scanner.join();
+    }
+    OptimizePool.wait();
+  }
+
+  /// @brief Compile each module in the given module set with the fast
+  ///        compiler, and add the resulting objects to the base layer.
+  ///
+  /// @return A handle for the added modules.
+  template <typename ModuleSetT>
+  ModuleSetHandleT addModuleSet(ModuleSetT Ms,
+                                std::unique_ptr<RTDyldMemoryManager> MM) {
+    std::lock_guard<std::recursive_mutex> Lock(LayerMutex);
+    const char *JITAddrSuffix = "$orc_addr";
+    const char *JITImplSuffix = "$orc_impl";
+    const char *JITCountSuffix = "$orc_count";
+
+    ModuleSetHandleT H =
+        ModuleSetInfos.insert(ModuleSetInfos.end(), ModuleSetInfo());
+
+    for (auto &M : Ms) {
+      H->LogicalModules.emplace_back(M->getDataLayout());
+      LogicalModule &LM = H->LogicalModules.back();
+
+      // Make all calls to functions defined in this module go through a
+      // redirection counting them, then carve the module up into a module
+      // holding everything but the implementations, followed by one module
+      // for each implementation.
+      JITIndirections Indirections =
+          makeCallsDoubleIndirect(*M, [](const Function &) { return true; },
+                                  JITImplSuffix, JITAddrSuffix);
+      std::vector<std::string> CounterNames =
+          insertCallCounters(*M, Indirections, JITCountSuffix);
+      std::vector<std::unique_ptr<Module>> ExplodedModules =
+          explode(*M, Indirections);
+
+      // The implementation modules are compiled from a copy: code generation
+      // alters the IR, and the originals will be compiled again if hot.
+      for (unsigned I = 0, E = ExplodedModules.size(); I != E; ++I) {
+        Module *ToCompile = ExplodedModules[I].get();
+        std::unique_ptr<Module> Copy;
+        if (I != 0) {
+          Copy.reset(CloneModule(ToCompile));
+          ToCompile = Copy.get();
+        }
+        if (!addCompiledModule(LM, *ToCompile, Compile, LM.Handles))
+          report_fatal_error("Tiered compile layer failed to compile " +
+                             ToCompile->getModuleIdentifier());
+      }
+
+      StringMap<unsigned> IndirectionIdx;
+      for (unsigned I = 0, E = Indirections.IndirectedNames.size(); I != E;
+           ++I)
+        IndirectionIdx[Indirections.GetImplName(
+            Indirections.IndirectedNames[I])] = I;
+
+      for (unsigned I = 1, E = ExplodedModules.size(); I != E; ++I) {
+        std::string ImplName;
+        for (const auto &F : *ExplodedModules[I])
+          if (!F.isDeclaration())
+            ImplName = F.getName();
+        auto Idx = IndirectionIdx.find(ImplName);
+        if (Idx == IndirectionIdx.end())
+          continue;
+
+        const std::string &FuncName = Indirections.IndirectedNames[Idx->second];
+        LM.Functions.emplace_back(std::move(ExplodedModules[I]), ImplName);
+        TieredFunction &F = LM.Functions.back();
+        F.ImplAddr = reinterpret_cast<std::atomic<uint64_t> *>(
+            lookupInLogicalModule(LM, LM.Mangler.getMangledName(
+                                          Indirections.GetAddrName(FuncName))));
+        F.Counter = reinterpret_cast<std::atomic<uint64_t> *>(
+            lookupInLogicalModule(
+                LM, LM.Mangler.getMangledName(CounterNames[Idx->second])));
+        assert(F.ImplAddr && F.Counter && "Can't find indirection globals.");
+        F.ImplAddr->store(
+            lookupInLogicalModule(LM, LM.Mangler.getMangledName(ImplName)),
+            std::memory_order_release);
+      }
+    }
+
+    return H;
+  }
+
+  /// @brief Remove the module set represented by the given handle.
+  ///
+  ///   This will remove all objects, fast and optimized, that were compiled
+  /// from the module set represented by H.
+  void removeModuleSet(ModuleSetHandleT H) {
+    // Keep the functions of H from being queued for recompilation, then let
+    // the pending recompilations, which may refer to H, finish.
+    {
+      std::lock_guard<std::recursive_mutex> Lock(LayerMutex);
+      for (auto &LM : H->LogicalModules)
+        for (auto &F : LM.Functions)
+          F.Queued = true;
+    }
+    OptimizePool.wait();
+    std::lock_guard<std::recursive_mutex> Lock(LayerMutex);
+    H->releaseResources(BaseLayer);
+    ModuleSetInfos.erase(H);
+  }
+
+  /// @brief Queue the functions called at least HotCallCount times, and not
+  ///        yet recompiled, for recompilation with the optimizing compiler.
+  ///
+  /// @return The number of functions queued.
+  unsigned recompileHotFunctions() {
+    std::lock_guard<std::recursive_mutex> Lock(LayerMutex);
+    unsigned NumQueued = 0;
+    for (auto &MSI : ModuleSetInfos)
+      for (auto &LM : MSI.LogicalModules)
+        for (auto &F : LM.Functions) {
+          if (F.Queued ||
+              F.Counter->load(std::memory_order_relaxed) < HotCallCount)
+            continue;
+          F.Queued = true;
+          ++NumQueued;
+          LogicalModule *LMPtr = &LM;
+          TieredFunction *FPtr = &F;
+          OptimizePool.async([this, LMPtr, FPtr] { recompile(*LMPtr, *FPtr); });
+        }
+    return NumQueued;
+  }
+
+  /// @brief Get the address of a symbol provided by this layer, or some layer
+  ///        below this one.
+  uint64_t getSymbolAddress(const std::string &Name, bool ExportedSymbolsOnly) {
+    std::lock_guard<std::recursive_mutex> Lock(LayerMutex);
+    return BaseLayer.getSymbolAddress(Name, ExportedSymbolsOnly);
+  }
+
+  /// @brief Get the address of the given symbol in the context of the set of
+  ///        modules represented by the handle H.
+  uint64_t lookupSymbolAddressIn(ModuleSetHandleT H, const std::string &Name,
+                                 bool ExportedSymbolsOnly) {
+    std::lock_guard<std::recursive_mutex> Lock(LayerMutex);
+    for (auto &LM : H->LogicalModules)
+      for (auto BH : LM.Handles)
+        if (uint64_t Addr =
+                BaseLayer.lookupSymbolAddressIn(BH, Name, ExportedSymbolsOnly))
+          return Addr;
+    return 0;
+  }
+
+private:
+  // Compile M with C and add the object to the base layer, recording its
+  // handle in Handles. Returns false if M couldn't be compiled.
+  bool addCompiledModule(LogicalModule &LM, Module &M, CompileFtor &C,
+                         std::vector<BaseLayerObjSetHandleT> &Handles) {
+    std::unique_ptr<object::ObjectFile> Object;
+    std::unique_ptr<MemoryBuffer> Buffer;
+    std::tie(Object, Buffer) = C(M).takeBinary();
+    if (!Object)
+      return false;
+
+    std::vector<std::unique_ptr<object::ObjectFile>> Objects;
+    Objects.push_back(std::move(Object));
+    std::vector<std::unique_ptr<MemoryBuffer>> Buffers;
+    Buffers.push_back(std::move(Buffer));
+
+    LogicalModule *LMPtr = &LM;
+    BaseLayerObjSetHandleT H = BaseLayer.addObjectSet(
+        Objects, createLookasideRTDyldMM<SectionMemoryManager>(
+                     [=](const std::string &Name) {
+                       if (uint64_t Addr = lookupInLogicalModule(*LMPtr, Name))
+                         return Addr;
+                       return getSymbolAddress(Name, true);
+                     },
+                     [=](const std::string &Name) {
+                       return lookupInLogicalModule(*LMPtr, Name);
+                     }));
+    BaseLayer.takeOwnershipOfBuffers(H, std::move(Buffers));
+    Handles.push_back(H);
+    return true;
+  }
+
+  uint64_t lookupInLogicalModule(LogicalModule &LM, const std::string &Name) {
+    for (auto H : LM.Handles)
+      if (uint64_t Addr = BaseLayer.lookupSymbolAddressIn(H, Name, false))
+        return Addr;
+    return 0;
+  }
+
+  // Compile the implementation of F with the optimizing compiler, and point
+  // its indirection to the result. On failure, F keeps its fast code.
+  void recompile(LogicalModule &LM, TieredFunction &F) {
+    std::lock_guard<std::recursive_mutex> Lock(LayerMutex);
+    if (!addCompiledModule(LM, *F.M, Optimize, LM.OptimizedHandles))
+      return;
+    F.M.reset();
+    if (uint64_t Addr = BaseLayer.lookupSymbolAddressIn(
+            LM.OptimizedHandles.back(), LM.Mangler.getMangledName(F.ImplName),
+            false))
+      F.ImplAddr->store(Addr, std::memory_order_release);
+  }
+
+  void scan(std::chrono::milliseconds ScanInterval) {
+    std::unique_lock<std::mutex> Lock(ScannerMutex);
+    while (!ScannerCond.wait_for(Lock, ScanInterval,
+                                 [this] { return Stopping; })) {
+      Lock.unlock();
+      recompileHotFunctions();
+      Lock.lock();
+    }
+  }
+
+  BaseLayerT &BaseLayer;
+  CompileFtor Compile;
+  CompileFtor Optimize;
+  uint64_t HotCallCount;
+  ModuleSetInfoListT ModuleSetInfos;
+  std::recursive_mutex LayerMutex;
+
+  std::mutex ScannerMutex;
+  std::condition_variable ScannerCond;
+  bool Stopping;
+  std::thread Scanner;
+  ThreadPool OptimizePool;
+};
+}
+
+#endif // LLVM_EXECUTIONENGINE_ORC_TIEREDCOMPILELAYER_H
@@ -34,12 +34,19 @@ namespace llvm {
 /// in the JITed object.  Permissions can be applied either by calling
 /// MCJIT::finalizeObject or by calling SectionMemoryManager::finalizeMemory
 /// directly.  Clients of MCJIT should call MCJIT::finalizeObject.
+///
+/// Sections are packed into slabs of at least SlabSize bytes, so that objects
+/// with many small sections need few mappings, and finalizeMemory changes the
+/// protection of the pages holding the new sections with as few calls as
+/// possible.  The pages of a slab that no section uses yet remain available
+/// to the sections allocated after finalizeMemory.
 class SectionMemoryManager : public RTDyldMemoryManager {
   SectionMemoryManager(const SectionMemoryManager&) LLVM_DELETED_FUNCTION;
   void operator=(const SectionMemoryManager&) LLVM_DELETED_FUNCTION;
 
 public:
-  SectionMemoryManager() { }
+  explicit SectionMemoryManager(uintptr_t SlabSize = 64 * 1024)
+      : SlabSize(SlabSize) {}
   virtual ~SectionMemoryManager();
 
   /// \brief Allocates a memory block of (at least) the given size suitable for
@@ -86,6 +93,8 @@ private:
   struct MemoryGroup {
       SmallVector<sys::MemoryBlock, 16> AllocatedMem;
       SmallVector<sys::MemoryBlock, 16> FreeMem;
+      // The sections allocated since the last finalizeMemory.
+      SmallVector<sys::MemoryBlock, 16> PendingMem;
       sys::MemoryBlock Near;
   };
 
@@ -95,6 +104,7 @@ private:
   std::error_code applyMemoryGroupPermissions(MemoryGroup &MemGroup,
                                               unsigned Permissions);
 
+  uintptr_t SlabSize;
   MemoryGroup CodeMem;
   MemoryGroup RWDataMem;
   MemoryGroup RODataMem;
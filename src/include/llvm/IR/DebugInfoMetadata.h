@@ -904,6 +904,20 @@ public:
 
   TempDICompositeType clone() const { return cloneImpl(); }
 
+  /// \brief Get a type, uniquing definitions by their identifier.
+  ///
+  /// If the context \a LLVMContext::isODRUniquingDebugTypes(), returns the
+  /// first definition seen with this \c Identifier, even if its other operands
+  /// differ.  Otherwise, and for forward declarations, this is \a get() or \a
+  /// getDistinct().
+  static DICompositeType *
+  getODRType(LLVMContext &Context, bool IsDistinct, unsigned Tag,
+             MDString *Name, Metadata *File, unsigned Line, Metadata *Scope,
+             Metadata *BaseType, uint64_t SizeInBits, uint64_t AlignInBits,
+             uint64_t OffsetInBits, unsigned Flags, Metadata *Elements,
+             unsigned RuntimeLang, Metadata *VTableHolder,
+             Metadata *TemplateParams, MDString *Identifier);
+
   static bool classof(const Metadata *MD) {
     return MD->getMetadataID() == DICompositeTypeKind;
   }
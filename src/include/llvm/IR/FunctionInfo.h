@@ -0,0 +1,107 @@
+//===-- llvm/IR/FunctionInfo.h - Function summary index ---------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines FunctionSummary, a compact description of a function
+// definition, and FunctionInfoIndex, an index of the function summaries of one
+// or more modules. The summaries are written to bitcode next to the module,
+// and allow making cross-module decisions, such as which functions to import
+// into a module for inlining, without loading the modules themselves.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_FUNCTIONINFO_H
+#define LLVM_IR_FUNCTIONINFO_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/GlobalValue.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+
+class Function;
+class Module;
+
+/// \brief Summary of a function definition.
+struct FunctionSummary {
+  /// The linkage of the function.
+  GlobalValue::LinkageTypes Linkage = GlobalValue::ExternalLinkage;
+
+  /// The number of instructions in the function, ignoring debug intrinsics.
+  unsigned InstCount = 0;
+
+  /// Whether the function refers to a global value with local linkage. Such
+  /// a function can't be imported into another module as is.
+  bool RefersToLocal = false;
+
+  /// The names of the functions called directly by this function.
+  std::vector<std::string> Callees;
+
+  /// \brief Compute the summary of the function definition \p F.
+  static FunctionSummary compute(const Function &F);
+
+  /// \brief Whether a copy of the function could be used by another module in
+  /// place of a call to this definition.
+  bool isImportable() const;
+};
+
+/// \brief An index of function summaries, keyed by function name.
+///
+/// For each function name, the index lists every module defining a function
+/// with that name. Modules are referred to by their position in the list of
+/// module paths.
+class FunctionInfoIndex {
+public:
+  typedef std::pair<unsigned, FunctionSummary> ModuleSummaryTy;
+  typedef StringMap<std::vector<ModuleSummaryTy>> FunctionMapTy;
+
+private:
+  std::vector<std::string> ModulePaths;
+  FunctionMapTy Functions;
+
+public:
+  /// \brief Add a module without summaries and return its ID.
+  unsigned addModule(StringRef Path);
+
+  /// \brief Add the summaries of the function definitions of \p M, as module
+  /// \p Path, and return its ID.
+  unsigned addModule(const Module &M, StringRef Path);
+
+  /// \brief Record that module \p ModuleID defines a function \p Name.
+  void addFunction(StringRef Name, unsigned ModuleID, FunctionSummary Summary);
+
+  /// \brief Add the modules and summaries of \p Other to this index.
+  void mergeFrom(const FunctionInfoIndex &Other);
+
+  ArrayRef<std::string> getModulePaths() const { return ModulePaths; }
+  StringRef getModulePath(unsigned ModuleID) const {
+    return ModulePaths[ModuleID];
+  }
+
+  /// \brief Return the ID of the module at \p Path, or -1 if there is none.
+  int findModule(StringRef Path) const;
+
+  /// \brief Return the definitions of the function \p Name.
+  ArrayRef<ModuleSummaryTy> lookup(StringRef Name) const {
+    auto I = Functions.find(Name);
+    if (I == Functions.end())
+      return None;
+    return I->getValue();
+  }
+
+  FunctionMapTy::const_iterator begin() const { return Functions.begin(); }
+  FunctionMapTy::const_iterator end() const { return Functions.end(); }
+};
+
+} // End llvm namespace
+
+#endif
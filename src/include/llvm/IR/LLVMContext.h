@@ -69,6 +69,16 @@ public:
   /// custom metadata IDs registered in this LLVMContext.
   void getMDKindNames(SmallVectorImpl<StringRef> &Result) const;
 
+  /// \brief Whether there is a string map for uniquing debug info types with
+  /// identifiers across the context.
+  ///
+  /// When enabled, the bitcode reader replaces a composite type definition by
+  /// the first one read with the same identifier, assuming the one definition
+  /// rule.  This saves memory when many modules describe the same types.
+  bool isODRUniquingDebugTypes() const;
+  void enableDebugTypeODRUniquing();
+  void disableDebugTypeODRUniquing();
+
 
   typedef void (*InlineAsmDiagHandlerTy)(const SMDiagnostic&, void *Context,
                                          unsigned LocCookie);
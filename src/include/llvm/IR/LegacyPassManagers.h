@@ -19,6 +19,7 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/Timer.h"
 #include <map>
 #include <vector>
 
@@ -92,6 +93,8 @@
 #include "llvm/Support/PrettyStackTrace.h"
 
 namespace llvm {
+  class BasicBlock;
+  class Function;
   class Module;
   class Pass;
   class StringRef;
@@ -474,6 +477,37 @@ public:
 
 Timer *getPassTimer(Pass *);
 
+/// PassExecutionTimer - Times one run of a pass for -time-passes, and records
+/// it in the time trace if one is being recorded.  For -time-passes-json, it
+/// also measures how the run changed the peak memory use of the process and
+/// the number of instructions in the IR it ran on, which must outlive it.
+class PassExecutionTimer {
+  TimeRegion Region;
+  Pass *P;
+  const Module *M = nullptr;
+  SmallVector<const Function *, 1> Functions;
+  const BasicBlock *BB = nullptr;
+  bool Traced;
+  bool CollectUsage;
+  int64_t StartInstructions;
+  size_t StartPeakMemory;
+  TimeRecord StartTime;
+
+  PassExecutionTimer(const PassExecutionTimer &) = delete;
+  void operator=(const PassExecutionTimer &) = delete;
+
+  void start();
+  uint64_t countInstructions() const;
+
+public:
+  PassExecutionTimer(Pass *P, const Module &M);
+  PassExecutionTimer(Pass *P, const Function &F);
+  PassExecutionTimer(Pass *P, const BasicBlock &BB);
+  /// Time a run of \p P on \p Functions, such as the functions of an SCC.
+  PassExecutionTimer(Pass *P, ArrayRef<const Function *> Functions);
+  ~PassExecutionTimer();
+};
+
 }
 
 #endif
@@ -34,34 +34,45 @@ struct OperandTraits;
 
 class User : public Value {
   User(const User &) LLVM_DELETED_FUNCTION;
-  void *operator new(size_t) LLVM_DELETED_FUNCTION;
   template <unsigned>
   friend struct HungoffOperandTraits;
   virtual void anchor();
 protected:
-  /// \brief This is a pointer to the array of Uses for this User.
+  /// \brief Allocate a User whose operands will be hung off.
   ///
-  /// For nodes of fixed arity (e.g. a binary operator) this array will live
-  /// prefixed to some derived class instance.  For nodes of resizable variable
-  /// arity (e.g. PHINodes, SwitchInst etc.), this memory will be dynamically
-  /// allocated and should be destroyed by the classes' virtual dtor.
-  Use *OperandList;
+  /// A single Use* is allocated before the User, and points to the operands
+  /// once setHungOffOperands is called.  Resizable variable arity nodes (e.g.
+  /// PHINodes, SwitchInst etc.) use this and must destroy their Use array in
+  /// their virtual dtor.
+  void *operator new(size_t s);
 
+  /// \brief Allocate a User followed by its operands.
+  ///
+  /// The array of Us Uses is prefixed to the User, fixed arity nodes (e.g. a
+  /// binary operator) find their operands through this.
   void *operator new(size_t s, unsigned Us);
-  User(Type *ty, unsigned vty, Use *OpList, unsigned NumOps)
-      : Value(ty, vty), OperandList(OpList) {
+
+  // The operands are found from the layout chosen by operator new, so the
+  // OpList argument is unused.
+  User(Type *ty, unsigned vty, Use *, unsigned NumOps) : Value(ty, vty) {
     NumOperands = NumOps;
   }
   Use *allocHungoffUses(unsigned) const;
+  /// \brief Make Ops the operands of this User, which must have been
+  /// allocated by the hung-off operator new.
+  void setHungOffOperands(Use *Ops) {
+    HasHungOffUses = true;
+    *(reinterpret_cast<Use **>(this) - 1) = Ops;
+  }
   void dropHungoffUses() {
-    Use::zap(OperandList, OperandList + NumOperands, true);
-    OperandList = nullptr;
-    // Reset NumOperands so User::operator delete() does the right thing.
+    Use::zap(getOperandList(), getOperandList() + NumOperands, true);
+    setHungOffOperands(nullptr);
+    // Reset NumOperands so ~User() has nothing left to zap.
     NumOperands = 0;
   }
 public:
   ~User() {
-    Use::zap(OperandList, OperandList + NumOperands);
+    Use::zap(getOperandList(), getOperandList() + NumOperands);
   }
   /// \brief Free memory allocated for User and Use objects.
   void operator delete(void *Usr);
@@ -86,24 +97,35 @@ protected:
     return OpFrom<Idx>(this);
   }
 public:
+  /// \brief Return the array of Uses for this User.
+  ///
+  /// It is either hung off, or lives immediately before the User.
+  const Use *getOperandList() const {
+    return HasHungOffUses ? *(reinterpret_cast<Use *const *>(this) - 1)
+                          : reinterpret_cast<const Use *>(this) - NumOperands;
+  }
+  Use *getOperandList() {
+    return const_cast<Use *>(static_cast<const User *>(this)->getOperandList());
+  }
+
   Value *getOperand(unsigned i) const {
     assert(i < NumOperands && "getOperand() out of range!");
-    return OperandList[i];
+    return getOperandList()[i];
   }
   void setOperand(unsigned i, Value *Val) {
     assert(i < NumOperands && "setOperand() out of range!");
     assert((!isa<Constant>((const Value*)this) ||
             isa<GlobalValue>((const Value*)this)) &&
            "Cannot mutate a constant with setOperand!");
-    OperandList[i] = Val;
+    getOperandList()[i] = Val;
   }
   const Use &getOperandUse(unsigned i) const {
     assert(i < NumOperands && "getOperandUse() out of range!");
-    return OperandList[i];
+    return getOperandList()[i];
   }
   Use &getOperandUse(unsigned i) {
     assert(i < NumOperands && "getOperandUse() out of range!");
-    return OperandList[i];
+    return getOperandList()[i];
   }
 
   unsigned getNumOperands() const { return NumOperands; }
@@ -116,10 +138,14 @@ public:
   typedef iterator_range<op_iterator> op_range;
   typedef iterator_range<const_op_iterator> const_op_range;
 
-  inline op_iterator       op_begin()       { return OperandList; }
-  inline const_op_iterator op_begin() const { return OperandList; }
-  inline op_iterator       op_end()         { return OperandList+NumOperands; }
-  inline const_op_iterator op_end()   const { return OperandList+NumOperands; }
+  inline op_iterator       op_begin()       { return getOperandList(); }
+  inline const_op_iterator op_begin() const { return getOperandList(); }
+  inline op_iterator       op_end()         {
+    return getOperandList() + NumOperands;
+  }
+  inline const_op_iterator op_end()   const {
+    return getOperandList() + NumOperands;
+  }
   inline op_range operands() {
     return op_range(op_begin(), op_end());
   }
@@ -102,7 +102,14 @@ protected:
   /// This is stored here to save space in User on 64-bit hosts.  Since most
   /// instances of Value have operands, 32-bit hosts aren't significantly
   /// affected.
-  unsigned NumOperands;
+  unsigned NumOperands : 31;
+
+  /// \brief Whether the operands of this User are hung off.
+  ///
+  /// Hung-off operands live in a separate, resizable allocation, pointed to
+  /// by the word preceding the User.  Other Users find their operands
+  /// immediately before themselves, so neither needs an operand pointer.
+  unsigned HasHungOffUses : 1;
 
 private:
   template <typename UseT> // UseT == 'Use' or 'const Use'
@@ -46,7 +46,12 @@ bool verifyFunction(const Function &F, raw_ostream *OS = nullptr);
 /// If there are no errors, the function returns false. If an error is found,
 /// a message describing the error is written to OS (if non-null) and true is
 /// returned.
-bool verifyModule(const Module &M, raw_ostream *OS = nullptr);
+///
+/// When \p NumThreads is more than 1, the function bodies are verified on
+/// that many threads, while the module-level checks run once on the calling
+/// thread.  Nothing else may modify the context meanwhile.
+bool verifyModule(const Module &M, raw_ostream *OS = nullptr,
+                  unsigned NumThreads = 1);
 
 /// \brief Create a verifier pass.
 ///
@@ -20,6 +20,7 @@
 
 namespace llvm {
 
+class MemoryBuffer;
 class Module;
 class SMDiagnostic;
 class LLVMContext;
@@ -32,6 +33,13 @@ std::unique_ptr<Module> getLazyIRFileModule(StringRef Filename,
                                             SMDiagnostic &Err,
                                             LLVMContext &Context);
 
+/// If the given MemoryBuffer holds a bitcode image, return a Module for it
+/// which does lazy deserialization of function bodies. Otherwise, attempt to
+/// parse it as LLVM Assembly and return a fully populated Module.
+std::unique_ptr<Module> getLazyIRModule(std::unique_ptr<MemoryBuffer> Buffer,
+                                        SMDiagnostic &Err,
+                                        LLVMContext &Context);
+
 /// If the given MemoryBuffer holds a bitcode image, return a Module
 /// for it.  Otherwise, attempt to parse it as LLVM Assembly and return
 /// a Module for it.
@@ -40,8 +40,11 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Linker/Linker.h"
+#include "llvm/Support/CodeGen.h"
 #include "llvm/Target/TargetOptions.h"
 #include "llvm/Transforms/Utils/Obfuscation.h"
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -49,8 +52,10 @@ namespace llvm {
   class LLVMContext;
   class DiagnosticInfo;
   class GlobalValue;
+  struct LTOModule;
   class Mangler;
   class MemoryBuffer;
+  class Target;
   class TargetLibraryInfo;
   class TargetMachine;
   class raw_ostream;
@@ -78,11 +83,53 @@ struct LTOCodeGenerator {
   void setCpu(const char *mCpu) { MCpu = mCpu; }
   void setAttr(const char *mAttr) { MAttr = mAttr; }
 
+  // Set the number of object files that the optimized merged module is split
+  // into by compile_to_files() and compileOptimizedToFiles(). Each of them is
+  // generated on its own thread.
+  void setParallelism(unsigned Value) { Parallelism = Value ? Value : 1; }
+
+  // With parallelism, only run the interprocedural part of the optimization
+  // pipeline in optimize(), and leave the passes that optimize each function
+  // on its own to the threads that generate code for the partitions. The
+  // interprocedural alias analysis these passes use only sees one partition.
+  void setShouldOptimizePartitions(bool Value) {
+    ShouldOptimizePartitions = Value;
+  }
+
   void setShouldInternalize(bool Value) { ShouldInternalize = Value; }
+
+  // Defer linking the modules passed to addModule() until the symbols to
+  // preserve are known, then only link the definitions they reach. The other
+  // function bodies are never materialized, which saves the most with modules
+  // created lazily (see LTOModule::createFromFile). The modules must stay
+  // alive until the code generator is done with them.
+  void setShouldLinkLazily(bool Value) { ShouldLinkLazily = Value; }
   void setShouldEmbedUselists(bool Value) { ShouldEmbedUselists = Value; }
 
   void addMustPreserveSymbol(const char *sym) { MustPreserveSymbols[sym] = 1; }
 
+  // Cache the native object files in the directory Path. compile(),
+  // compile_to_file() and compile_to_files() key the objects by a hash of the
+  // merged module, the symbols to preserve, the target and the options, and
+  // skip optimization and code generation when the key is already cached.
+  void setCacheDir(const char *Path) { CacheDir = Path; }
+
+  // Prune the cache at most every Interval seconds, when adding to it. A
+  // negative value disables pruning. The default is 20 minutes.
+  void setCachePruningInterval(int Interval) {
+    CachePruningInterval = Interval;
+  }
+
+  // Prune the entries of the cache unused for Seconds. 0 disables the
+  // expiration. The default is a week.
+  void setCacheEntryExpiration(unsigned Seconds) {
+    CacheEntryExpiration = Seconds;
+  }
+
+  // Prune the least recently used entries of the cache until it takes at most
+  // Bytes. 0, the default, disables the limit.
+  void setMaxCacheSize(uint64_t Bytes) { MaxCacheSize = Bytes; }
+
   // To pass options to the driver and optimization passes. These options are
   // not necessarily for debugging purpose (The function name is misleading).
   // This function should be called before LTOCodeGenerator::compilexxx(),
@@ -112,6 +159,21 @@ struct LTOCodeGenerator {
                        bool disableVectorization,
                        std::string &errMsg);
 
+  // As with compile_to_file(), but the merged module is split into as many
+  // object files as the parallelism level, which are generated in parallel.
+  // The paths to the object files are returned via argument "names", and
+  // remain valid until the next compilation. Return true on success.
+  //
+  // The objects together define the same symbols as the single object that
+  // compile_to_file() would produce, plus hidden symbols for the definitions
+  // that had local linkage.
+  bool compile_to_files(ArrayRef<const char *> &names,
+                        bool disableOpt,
+                        bool disableInline,
+                        bool disableGVNLoadPRE,
+                        bool disableVectorization,
+                        std::string &errMsg);
+
   // As with compile_to_file(), this function compiles the merged module into
   // single object file. Instead of returning the object-file-path to the caller
   // (linker), it brings the object to a buffer, and return the buffer to the
@@ -136,6 +198,17 @@ struct LTOCodeGenerator {
   // if the compilation was not successful.
   const void *compileOptimized(size_t *length, std::string &errMsg);
 
+  // Compiles the merged optimized module into as many object files as the
+  // parallelism level; see compile_to_files(). Return true on success.
+  bool compileOptimizedToFiles(ArrayRef<const char *> &names,
+                               std::string &errMsg);
+
+  // Compiles the merged optimized module into one object file per stream in
+  // Out, in parallel. When there's more than one stream, the merged module is
+  // split and its definitions with local linkage are externalized. Return true
+  // on success.
+  bool compileOptimized(ArrayRef<raw_ostream *> Out, std::string &errMsg);
+
   // reset the codegen context
   void resetContext();
 
@@ -152,16 +225,29 @@ struct LTOCodeGenerator {
 private:
   void initializeLTOPasses();
 
-  bool compileOptimized(raw_ostream &out, std::string &errMsg);
   bool compileOptimizedToFile(const char **name, std::string &errMsg);
+  const void *readNativeObjectFile(size_t *length, std::string &errMsg);
+
+  bool computeCacheKey(unsigned Count, bool disableOpt, bool disableInline,
+                       bool disableGVNLoadPRE, bool disableVectorization,
+                       std::string &Key, std::string &errMsg);
+  std::string getCacheEntryPath(StringRef Key, unsigned Index);
+  bool getCachedObjects(StringRef Key, unsigned Count,
+                        ArrayRef<const char *> &names);
+  void addCachedObjects(StringRef Key, ArrayRef<const char *> names);
+  std::unique_ptr<TargetMachine> createTargetMachine();
   void applyScopeRestrictions();
+  // Run the function passes optimize() deferred, if any, on the merged module.
+  void runPendingFunctionPasses();
   void applyRestriction(GlobalValue &GV, ArrayRef<StringRef> Libcalls,
                         std::vector<const char *> &MustPreserveList,
                         SmallPtrSetImpl<GlobalValue *> &AsmUsed,
                         Mangler &Mangler);
   bool determineTarget(std::string &errMsg);
+  bool linkLazyModules(std::string &errMsg);
 
   static void DiagnosticHandler(const DiagnosticInfo &DI, void *Context);
+  static void ThreadDiagnosticHandler(const DiagnosticInfo &DI, void *Context);
 
   void DiagnosticHandler2(const DiagnosticInfo &DI);
 
@@ -172,6 +258,10 @@ private:
   LLVMContext *Context;
   Linker IRLinker;
   TargetMachine *TargetMach = nullptr;
+  const Target *MArch = nullptr;
+  std::string TripleStr;
+  std::string FeatureStr;
+  Reloc::Model RelocModel = Reloc::Default;
   bool EmitDwarfDebugInfo = false;
   bool ScopeRestrictionsDone = false;
   lto_codegen_model CodeModel = LTO_CODEGEN_PIC_MODEL_DEFAULT;
@@ -182,12 +272,29 @@ private:
   std::string MCpu;
   std::string MAttr;
   std::string NativeObjectPath;
+  std::vector<std::string> NativeObjectPaths;
+  std::vector<const char *> NativeObjectNames;
+  unsigned Parallelism = 1;
   TargetOptions Options;
   lto_diagnostic_handler_t DiagHandler = nullptr;
   void *DiagContext = nullptr;
+  // Serializes the diagnostics reported by the code generation threads.
+  std::mutex DiagnosticLock;
   LTOModule *OwnedModule = nullptr;
   bool ShouldInternalize = true;
   bool ShouldEmbedUselists = false;
+  bool ShouldLinkLazily = false;
+  bool ShouldOptimizePartitions = false;
+  // The function passes optimize() left to compileOptimized(), and the options
+  // they were requested with.
+  bool FunctionPassesPending = false;
+  bool PendingDisableGVNLoadPRE = false;
+  bool PendingDisableVectorization = false;
+  std::vector<LTOModule *> LazyModules;
+  std::string CacheDir;
+  int CachePruningInterval = 1200;
+  unsigned CacheEntryExpiration = 7 * 24 * 3600;
+  uint64_t MaxCacheSize = 0;
 
   // For symbol hiding/obfuscation
   obfuscate::IncrementObfuscator IncrObfuscate = {true};
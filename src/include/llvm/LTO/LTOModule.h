@@ -87,8 +87,12 @@ public:
   /// InitializeAllTargetMCs();
   /// InitializeAllAsmPrinters();
   /// InitializeAllAsmParsers();
+  ///
+  /// If \p ShouldBeLazy, function bodies are only parsed when they are
+  /// materialized, such as when a lazily linking LTOCodeGenerator links them.
   static LTOModule *createFromFile(const char *path, TargetOptions options,
-                                   std::string &errMsg);
+                                   std::string &errMsg,
+                                   bool ShouldBeLazy = false);
   static LTOModule *createFromOpenFile(int fd, const char *path, size_t size,
                                        TargetOptions options,
                                        std::string &errMsg);
@@ -216,7 +220,8 @@ private:
 
   /// Create an LTOModule (private version).
   static LTOModule *makeLTOModule(MemoryBufferRef Buffer, TargetOptions options,
-                                  std::string &errMsg, LLVMContext *Context);
+                                  std::string &errMsg, LLVMContext *Context,
+                                  bool ShouldBeLazy = false);
 };
 }
 #endif
@@ -0,0 +1,96 @@
+//===-ThinLTOCodeGenerator.h - LLVM Link Time Optimizer -------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the ThinLTOCodeGenerator class, a driver for "thin" link
+// time optimization.
+//
+//   Instead of linking all the bitcode modules into a single module, thin LTO
+// combines the function summaries of the modules (see FunctionInfoIndex) into
+// a global index. Each module is then optimized and compiled on its own, by a
+// backend that only imports from the other modules the functions the index
+// selects for it. The backends are independent from each other: they run in
+// parallel here, or can be distributed over several machines by writing the
+// combined index to disk and running each backend separately.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LTO_THINLTOCODEGENERATOR_H
+#define LLVM_LTO_THINLTOCODEGENERATOR_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/FunctionInfo.h"
+#include "llvm/Support/CodeGen.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Target/TargetOptions.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+/// \brief Driver for the thin LTO of a set of bitcode modules.
+class ThinLTOCodeGenerator {
+public:
+  /// Add the module \p Identifier, whose bitcode is \p Data. The data must
+  /// stay valid for the lifetime of the code generator.
+  void addModule(StringRef Identifier, StringRef Data);
+
+  /// Use the combined index \p Index instead of computing one from the added
+  /// modules. Modules of the index that were not added are loaded from their
+  /// path when functions are imported from them.
+  void setCombinedIndex(std::unique_ptr<FunctionInfoIndex> Index) {
+    CombinedIndex = std::move(Index);
+  }
+
+  void setCpu(std::string Cpu) { MCpu = std::move(Cpu); }
+  void setAttr(std::string Attr) { MAttr = std::move(Attr); }
+  void setTargetOptions(TargetOptions Options) { this->Options = Options; }
+  void setCodePICModel(Reloc::Model Model) { RelocModel = Model; }
+
+  /// Set the number of backends to run at the same time.
+  void setParallelism(unsigned N) { Parallelism = N; }
+
+  /// Only import functions of at most \p Limit instructions.
+  void setImportInstrLimit(unsigned Limit) { ImportInstrLimit = Limit; }
+
+  /// \brief Compute the combined index of the added modules, from the function
+  /// summaries in their bitcode. Modules without summaries are loaded to
+  /// compute them. Returns null on error, setting \p ErrMsg.
+  std::unique_ptr<FunctionInfoIndex> linkCombinedIndex(std::string &ErrMsg);
+
+  /// \brief Import, optimize and generate code for each added module, in
+  /// parallel. Returns false on error, setting \p ErrMsg.
+  bool run(std::string &ErrMsg);
+
+  /// The object files produced by \a run, in the order the modules were
+  /// added.
+  ArrayRef<std::unique_ptr<MemoryBuffer>> getProducedBinaries() const {
+    return ProducedBinaries;
+  }
+
+private:
+  /// Run the backend of the added module \p ModuleIndex.
+  bool runBackend(unsigned ModuleIndex, std::string &ErrMsg);
+
+  std::vector<MemoryBufferRef> Modules;
+  std::unique_ptr<FunctionInfoIndex> CombinedIndex;
+  std::vector<std::unique_ptr<MemoryBuffer>> ProducedBinaries;
+
+  std::string MCpu;
+  std::string MAttr;
+  TargetOptions Options;
+  Reloc::Model RelocModel = Reloc::Default;
+  unsigned Parallelism = 1;
+  unsigned ImportInstrLimit = 100;
+};
+
+} // End llvm namespace
+
+#endif
@@ -14,8 +14,10 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/IR/DiagnosticInfo.h"
+#include <functional>
 
 namespace llvm {
+class GlobalValue;
 class Module;
 class StructType;
 class Type;
@@ -70,8 +72,16 @@ public:
   /// \brief Link \p Src into the composite. The source is destroyed.
   /// Passing OverrideSymbols as true will have symbols from Src
   /// shadow those in the Dest.
+  ///
+  /// If \p IsNeeded is set, the definitions of \p Src it rejects are only
+  /// linked if something linked into the composite refers to them, like
+  /// those with local or linkonce linkage. The bodies of \p Src that are not
+  /// linked are never materialized.
+  ///
   /// Returns true on error.
-  bool linkInModule(Module *Src, bool OverrideSymbols = false);
+  bool linkInModule(Module *Src, bool OverrideSymbols = false,
+                    std::function<bool(const GlobalValue &)> IsNeeded =
+                        nullptr);
 
   /// \brief Set the composite to the passed-in module.
   void setModule(Module *Dst);
@@ -52,7 +52,7 @@ class MCFragment : public ilist_node<MCFragment> {
   void operator=(const MCFragment&) LLVM_DELETED_FUNCTION;
 
 public:
-  enum FragmentType {
+  enum FragmentType : uint8_t {
     FT_Align,
     FT_Data,
     FT_CompactEncodedInst,
@@ -65,8 +65,6 @@ public:
   };
 
 private:
-  FragmentType Kind;
-
   /// Parent - The data for the section this fragment is in.
   MCSectionData *Parent;
 
@@ -88,6 +86,10 @@ private:
 
   /// @}
 
+  // Kind is kept last so that the small fields of the derived fragments can
+  // go into the tail padding.
+  FragmentType Kind;
+
 protected:
   MCFragment(FragmentType _Kind, MCSectionData *_Parent = nullptr);
 
@@ -934,6 +936,11 @@ private:
   MCLOHContainer LOHContainer;
 
   VersionMinInfoType VersionMinInfo;
+
+  /// The fragments of each section, indexed by section ordinal and in layout
+  /// order, that may still change size during relaxation. Each layout
+  /// iteration only revisits these instead of every fragment.
+  std::vector<std::vector<MCFragment *> > RelaxCandidates;
 private:
   /// Evaluate a fixup to a relocatable expression and the value which should be
   /// placed into the fixup.
@@ -969,6 +976,9 @@ private:
   /// if any offsets were adjusted.
   bool layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD);
 
+  /// \brief Collect the fragments of every section that may need relaxation.
+  void collectRelaxCandidates();
+
   bool relaxInstruction(MCAsmLayout &Layout, MCRelaxableFragment &IF);
 
   bool relaxLEB(MCAsmLayout &Layout, MCLEBFragment &IF);
@@ -21,6 +21,7 @@
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include <vector>
 
 namespace llvm {
 namespace object {
@@ -202,15 +203,33 @@ public:
   // check if a symbol is in the archive
   child_iterator findSym(StringRef name) const;
 
+  /// \brief Returns the number of regular members, i.e. the members visited by
+  /// child_begin().
+  unsigned getNumChildren() const;
+  /// \brief Returns the regular member at position \p Index, without walking
+  /// the headers of the members before it.
+  child_iterator getChild(unsigned Index) const;
+
   bool hasSymbolTable() const;
   child_iterator getSymbolTableChild() const { return SymbolTable; }
 
 private:
+  void buildMemberIndex() const;
+  void buildSymbolIndex() const;
+
   child_iterator SymbolTable;
   child_iterator StringTable;
   child_iterator FirstRegular;
   unsigned Format : 2;
   unsigned IsThin : 1;
+
+  /// The start of each regular member, built on first use.
+  mutable std::vector<const char *> MemberIndex;
+  mutable bool HasMemberIndex = false;
+  /// The symbol names sorted by name, with the start of the member each one
+  /// is defined in, built by the first call to findSym.
+  mutable std::vector<std::pair<StringRef, const char *>> SymbolIndex;
+  mutable bool HasSymbolIndex = false;
 };
 
 }
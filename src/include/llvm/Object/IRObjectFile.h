@@ -27,10 +27,15 @@ class ObjectFile;
 class IRObjectFile : public SymbolicFile {
   std::unique_ptr<Module> M;
   std::unique_ptr<Mangler> Mang;
+  /// The symbols defined by module-level inline asm, or all the symbols when
+  /// they were read from the symbol table of the bitcode.
   std::vector<std::pair<std::string, uint32_t>> AsmSymbols;
 
 public:
   IRObjectFile(MemoryBufferRef Object, std::unique_ptr<Module> M);
+  /// List \p Symbols, with their names and SymbolRef flags, without a module.
+  IRObjectFile(MemoryBufferRef Object,
+               std::vector<std::pair<std::string, uint32_t>> Symbols);
   ~IRObjectFile();
   void moveSymbolNext(DataRefImpl &Symb) const override;
   std::error_code printSymbolName(raw_ostream &OS,
@@ -43,6 +48,11 @@ public:
   basic_symbol_iterator symbol_begin_impl() const override;
   basic_symbol_iterator symbol_end_impl() const override;
 
+  /// Whether the symbols come from a module, rather than from the symbol
+  /// table of the bitcode. getModule and takeModule need one, and getSymbolGV
+  /// returns null without one.
+  bool hasModule() const { return M != nullptr; }
+
   const Module &getModule() const {
     return const_cast<IRObjectFile*>(this)->getModule();
   }
@@ -67,6 +77,13 @@ public:
 
   static ErrorOr<std::unique_ptr<IRObjectFile>> create(MemoryBufferRef Object,
                                                        LLVMContext &Context);
+
+  /// \brief List the symbols of the bitcode in \p Object from its symbol
+  /// table, without parsing the module. Fails with BitcodeError::NoSymbolTable
+  /// when the bitcode has none, for instance because it was written by an
+  /// older producer or has module-level inline asm.
+  static ErrorOr<std::unique_ptr<IRObjectFile>>
+  createFromSymbolTable(MemoryBufferRef Object);
 };
 }
 }
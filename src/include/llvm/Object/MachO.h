@@ -18,6 +18,7 @@
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Triple.h"
+#include "llvm/ADT/iterator_range.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/MachO.h"
 
@@ -332,6 +333,20 @@ public:
   LoadCommandInfo getFirstLoadCommandInfo() const;
   LoadCommandInfo getNextLoadCommandInfo(const LoadCommandInfo &L) const;
 
+  /// \brief The load commands, as read once by the constructor.
+  typedef SmallVector<LoadCommandInfo, 4> LoadCommandList;
+  typedef LoadCommandList::const_iterator load_command_iterator;
+  load_command_iterator begin_load_commands() const {
+    return LoadCommands.begin();
+  }
+  load_command_iterator end_load_commands() const {
+    return LoadCommands.end();
+  }
+  iterator_range<load_command_iterator> load_commands() const {
+    return iterator_range<load_command_iterator>(begin_load_commands(),
+                                                 end_load_commands());
+  }
+
   // MachO specific structures.
   MachO::section getSection(DataRefImpl DRI) const;
   MachO::section_64 getSection64(DataRefImpl DRI) const;
@@ -429,6 +444,9 @@ public:
   }
 
 private:
+  const std::vector<uint64_t> &getSectionSymbolAddresses(uint8_t Sect) const;
+
+  LoadCommandList LoadCommands;
   typedef SmallVector<const char*, 1> SectionList;
   SectionList Sections;
   typedef SmallVector<const char*, 1> LibraryList;
@@ -441,6 +459,11 @@ private:
   const char *LinkOptHintsLoadCmd;
   const char *DyldInfoLoadCmd;
   const char *UuidLoadCmd;
+  /// The sorted addresses of the symbols defined in each section, indexed by
+  /// section number, built on the first getSymbolSize. These make computing
+  /// a symbol's size a binary search rather than a walk of all symbols.
+  mutable std::vector<std::vector<uint64_t>> SectionSymbolAddresses;
+  mutable bool HasSectionSymbolAddresses;
   bool HasPageZeroSegment;
 };
 
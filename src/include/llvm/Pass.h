@@ -369,6 +369,11 @@ protected:
 /// @brief This is the storage for the -time-passes option.
 extern bool TimePassesIsEnabled;
 
+/// If -time-passes-json is given, append the pass timings recorded since the
+/// last call to the file it names, and start recording afresh.  This also
+/// happens on llvm_shutdown().
+void writePassTimingsJSON();
+
 } // End llvm namespace
 
 // Include support files that contain important APIs commonly used by Passes,
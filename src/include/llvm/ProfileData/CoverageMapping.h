@@ -25,6 +25,7 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/raw_ostream.h"
+#include <functional>
 #include <system_error>
 
 namespace llvm {
@@ -423,9 +424,13 @@ public:
        IndexedInstrProfReader &ProfileReader);
 
   /// \brief Load the coverage mapping from the given files.
+  ///
+  /// When \p IsFileWanted is set, only the functions that refer to a source
+  /// file it accepts are decoded and loaded.
   static ErrorOr<std::unique_ptr<CoverageMapping>>
   load(StringRef ObjectFilename, StringRef ProfileFilename,
-       StringRef Arch = StringRef());
+       StringRef Arch = StringRef(),
+       std::function<bool(StringRef Filename)> IsFileWanted = nullptr);
 
   /// \brief The number of functions that couldn't have their profiles mapped.
   ///
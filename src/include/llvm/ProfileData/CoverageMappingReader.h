@@ -16,6 +16,8 @@
 #define LLVM_PROFILEDATA_COVERAGEMAPPINGREADER_H
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Object/ObjectFile.h"
@@ -129,7 +131,12 @@ public:
 
   std::error_code read();
 
+  /// \brief Only read the filenames of the function, without decoding its
+  /// expressions and mapping regions.
+  std::error_code readFilenames();
+
 private:
+  std::error_code readFileIDMapping(uint64_t &NumFileIDs);
   std::error_code decodeCounter(unsigned Value, Counter &C);
   std::error_code readCounter(Counter &C);
   std::error_code
@@ -164,17 +171,37 @@ private:
   std::vector<StringRef> FunctionsFilenames;
   std::vector<CounterExpression> Expressions;
   std::vector<CounterMappingRegion> MappingRegions;
+  /// \brief The records that refer to each source file, in record order.
+  /// Built on demand by buildFileIndex().
+  StringMap<std::vector<unsigned>> FileIndex;
+  bool HasFileIndex;
+  /// \brief When restricted to some files, the records to read, in order.
+  std::vector<unsigned> SelectedRecords;
+  bool IsRestricted;
 
   BinaryCoverageReader(const BinaryCoverageReader &) = delete;
   BinaryCoverageReader &operator=(const BinaryCoverageReader &) = delete;
 
-  BinaryCoverageReader() : CurrentRecord(0) {}
+  BinaryCoverageReader()
+      : CurrentRecord(0), HasFileIndex(false), IsRestricted(false) {}
+
+  std::error_code buildFileIndex();
 
 public:
   static ErrorOr<std::unique_ptr<BinaryCoverageReader>>
   create(std::unique_ptr<MemoryBuffer> &ObjectBuffer,
          StringRef Arch);
 
+  /// \brief Return the source files referred to by the coverage mapping,
+  /// sorted. Only the filenames of the records are decoded to compute this.
+  ErrorOr<std::vector<StringRef>> getSourceFiles();
+
+  /// \brief Only read the records of the functions that refer to a source
+  /// file for which \p IsFileWanted returns true, and restart reading from
+  /// the first such record. The other records are never decoded.
+  std::error_code
+  restrictToFiles(function_ref<bool(StringRef Filename)> IsFileWanted);
+
   std::error_code readNextRecord(CoverageMappingRecord &Record) override;
 };
 
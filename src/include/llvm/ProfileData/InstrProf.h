@@ -16,7 +16,12 @@
 #ifndef LLVM_PROFILEDATA_INSTRPROF_H_
 #define LLVM_PROFILEDATA_INSTRPROF_H_
 
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/MD5.h"
 #include <system_error>
+#include <vector>
 
 namespace llvm {
 const std::error_category &instrprof_category();
@@ -34,13 +39,54 @@ enum class instrprof_error {
     unknown_function,
     hash_mismatch,
     count_mismatch,
-    counter_overflow
+    counter_overflow,
+    value_site_count_mismatch
 };
 
 inline std::error_code make_error_code(instrprof_error E) {
   return std::error_code(static_cast<int>(E), instrprof_category());
 }
 
+/// The kinds of values recorded by the value profiling sites. This matches
+/// the value kind operand of the llvm.instrprof.value.profile intrinsic.
+enum InstrProfValueKind : uint32_t {
+  IPVK_IndirectCallTarget = 0,
+
+  IPVK_Last = IPVK_IndirectCallTarget
+};
+
+/// A value seen at a value profiling site, and the number of times it was
+/// seen there. The targets of indirect calls are identified by the hash of
+/// the profile name of the callee, see getInstrProfNameHash().
+struct InstrProfValueData {
+  uint64_t Value;
+  uint64_t Count;
+};
+
+/// All the values seen at one value profiling site.
+typedef std::vector<InstrProfValueData> InstrProfValueSiteRecord;
+
+/// Return the hash that identifies the function with the profile name
+/// \p Name in the value profile data: the least significant 8 bytes of the
+/// MD5 of the name, which is also the key hash of the indexed format.
+inline uint64_t getInstrProfNameHash(StringRef Name) {
+  MD5 Hash;
+  Hash.update(Name);
+  MD5::MD5Result Result;
+  Hash.final(Result);
+  // Our MD5 implementation returns the result in little endian, so we may
+  // need to swap bytes.
+  using namespace support;
+  return endian::read<uint64_t, little, unaligned>(Result);
+}
+
+/// Add the values of \p Src to those of the same sites in \p Dst. If the
+/// values are only known for one of them, that one is used; otherwise the
+/// number of sites must match.
+std::error_code
+mergeInstrProfValueSites(std::vector<InstrProfValueSiteRecord> &Dst,
+                         const std::vector<InstrProfValueSiteRecord> &Src);
+
 } // end namespace llvm
 
 namespace std {
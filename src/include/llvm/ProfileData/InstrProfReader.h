@@ -16,6 +16,7 @@
 #define LLVM_PROFILEDATA_INSTRPROFREADER_H
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ProfileData/InstrProf.h"
 #include "llvm/Support/EndianStream.h"
@@ -24,6 +25,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/OnDiskHashTable.h"
 #include <iterator>
+#include <memory>
 
 namespace llvm {
 
@@ -37,6 +39,9 @@ struct InstrProfRecord {
   StringRef Name;
   uint64_t Hash;
   ArrayRef<uint64_t> Counts;
+  /// The targets seen at each indirect call site of the function, in the
+  /// order of the sites. Empty if the profile has no value data.
+  std::vector<InstrProfValueSiteRecord> IndirectCallSites;
 };
 
 /// A file format agnostic iterator over profiling data.
@@ -150,6 +155,9 @@ private:
     const uint64_t FuncHash;
     const IntPtrT NamePtr;
     const IntPtrT CounterPtr;
+    const IntPtrT FunctionPointer;
+    const IntPtrT Values;
+    const uint64_t NumValueSites;
   };
   struct RawHeader {
     const uint64_t Magic;
@@ -159,6 +167,7 @@ private:
     const uint64_t NamesSize;
     const uint64_t CountersDelta;
     const uint64_t NamesDelta;
+    const uint64_t ValueDataSize;
   };
 
   bool ShouldSwapBytes;
@@ -168,7 +177,13 @@ private:
   const ProfileData *DataEnd;
   const uint64_t *CountersStart;
   const char *NamesStart;
+  /// The value data of the next record that has value profiling sites.
+  const uint64_t *ValueDataCur;
+  const uint64_t *ValueDataEnd;
   const char *ProfileEnd;
+  /// The name hashes of the functions of the current profile, by address, to
+  /// identify the targets of the indirect calls.
+  DenseMap<uint64_t, uint64_t> FunctionNameHashes;
 
   RawInstrProfReader(const RawInstrProfReader &) LLVM_DELETED_FUNCTION;
   RawInstrProfReader &operator=(const RawInstrProfReader &)
@@ -184,6 +199,9 @@ public:
 private:
   std::error_code readNextHeader(const char *CurrentPos);
   std::error_code readHeader(const RawHeader &Header);
+  /// Read the value data of \p NumValueSites sites into \p Record.
+  std::error_code readValueData(uint64_t NumValueSites,
+                                InstrProfRecord &Record);
   template <class IntT>
   IntT swap(IntT Int) const {
     return ShouldSwapBytes ? sys::getSwappedBytes(Int) : Int;
@@ -208,16 +226,33 @@ enum class HashT : uint32_t;
 /// Trait for lookups into the on-disk hash table for the binary instrprof
 /// format.
 class InstrProfLookupTrait {
-  std::vector<uint64_t> DataBuffer;
   IndexedInstrProf::HashT HashType;
 public:
   InstrProfLookupTrait(IndexedInstrProf::HashT HashType) : HashType(HashType) {}
 
+  /// The data of a function. It points straight into the profile: the words
+  /// are only decoded when they are accessed, so that a lookup only pays for
+  /// the counters it actually returns.
   struct data_type {
-    data_type(StringRef Name, ArrayRef<uint64_t> Data)
-        : Name(Name), Data(Data) {}
+    data_type(StringRef Name, StringRef Data) : Name(Name), Data(Data) {}
     StringRef Name;
-    ArrayRef<uint64_t> Data;
+    /// The little endian 64-bit words of the function's records.
+    StringRef Data;
+
+    /// Return the number of words.
+    size_t size() const { return Data.size() / sizeof(uint64_t); }
+    /// Return the word at index \p I.
+    uint64_t operator[](size_t I) const {
+      using namespace support;
+      return endian::read<uint64_t, little, unaligned>(Data.data() +
+                                                       I * sizeof(uint64_t));
+    }
+    /// Replace the contents of \p Words with the \p N words from index \p I.
+    void decode(size_t I, size_t N, std::vector<uint64_t> &Words) const {
+      Words.resize(N);
+      for (size_t J = 0; J < N; ++J)
+        Words[J] = (*this)[I + J];
+    }
   };
   typedef StringRef internal_key_type;
   typedef StringRef external_key_type;
@@ -242,19 +277,13 @@ public:
   }
 
   data_type ReadData(StringRef K, const unsigned char *D, offset_type N) {
-    DataBuffer.clear();
     if (N % sizeof(uint64_t))
       // The data is corrupt, don't try to read it.
-      return data_type("", DataBuffer);
+      return data_type("", StringRef());
 
-    using namespace support;
     // We just treat the data as opaque here. It's simpler to handle in
     // IndexedInstrProfReader.
-    unsigned NumEntries = N / sizeof(uint64_t);
-    DataBuffer.reserve(NumEntries);
-    for (unsigned I = 0; I < NumEntries; ++I)
-      DataBuffer.push_back(endian::readNext<uint64_t, little, unaligned>(D));
-    return data_type(K, DataBuffer);
+    return data_type(K, StringRef((const char *)D, N));
   }
 };
 typedef OnDiskIterableChainedHashTable<InstrProfLookupTrait>
@@ -263,8 +292,9 @@ typedef OnDiskIterableChainedHashTable<InstrProfLookupTrait>
 /// Reader for the indexed binary instrprof format.
 class IndexedInstrProfReader : public InstrProfReader {
 private:
-  /// The profile data file contents.
-  std::unique_ptr<MemoryBuffer> DataBuffer;
+  /// The profile data file contents, possibly shared with other readers of
+  /// the same file.
+  std::shared_ptr<MemoryBuffer> DataBuffer;
   /// The index into the profile data.
   std::unique_ptr<InstrProfReaderIndex> Index;
   /// Iterator over the profile data.
@@ -275,12 +305,14 @@ private:
   uint64_t FormatVersion;
   /// The maximal execution count among all functions.
   uint64_t MaxFunctionCount;
+  /// The counts of the last record returned by readNextRecord().
+  std::vector<uint64_t> RecordCounts;
 
   IndexedInstrProfReader(const IndexedInstrProfReader &) LLVM_DELETED_FUNCTION;
   IndexedInstrProfReader &operator=(const IndexedInstrProfReader &)
     LLVM_DELETED_FUNCTION;
 public:
-  IndexedInstrProfReader(std::unique_ptr<MemoryBuffer> DataBuffer)
+  IndexedInstrProfReader(std::shared_ptr<MemoryBuffer> DataBuffer)
       : DataBuffer(std::move(DataBuffer)), Index(nullptr), CurrentOffset(0) {}
 
   /// Return true if the given buffer is in an indexed instrprof format.
@@ -291,18 +323,26 @@ public:
   /// Read a single record.
   std::error_code readNextRecord(InstrProfRecord &Record) override;
 
-  /// Fill Counts with the profile data for the given function name.
-  std::error_code getFunctionCounts(StringRef FuncName, uint64_t FuncHash,
-                                    std::vector<uint64_t> &Counts);
+  /// Fill Counts with the profile data for the given function name. If
+  /// \p IndirectCallSites is not null, it is filled with the targets seen at
+  /// each indirect call site of the function.
+  std::error_code getFunctionCounts(
+      StringRef FuncName, uint64_t FuncHash, std::vector<uint64_t> &Counts,
+      std::vector<InstrProfValueSiteRecord> *IndirectCallSites = nullptr);
   /// Return the maximum of all known function counts.
   uint64_t getMaximumFunctionCount() { return MaxFunctionCount; }
 
-  /// Factory method to create an indexed reader.
+  /// Factory method to create an indexed reader. The file is mapped in
+  /// memory, and the mapping is shared by all the readers of the same file in
+  /// the process.
   static ErrorOr<std::unique_ptr<IndexedInstrProfReader>>
   create(std::string Path);
 
   static ErrorOr<std::unique_ptr<IndexedInstrProfReader>>
   create(std::unique_ptr<MemoryBuffer> Buffer);
+
+  static ErrorOr<std::unique_ptr<IndexedInstrProfReader>>
+  create(std::shared_ptr<MemoryBuffer> Buffer);
 };
 
 } // end namespace llvm
@@ -17,11 +17,15 @@
 
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ProfileData/InstrProf.h"
 #include "llvm/Support/DataTypes.h"
+#include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
+#include <functional>
+#include <string>
 #include <vector>
 
 namespace llvm {
@@ -29,26 +33,74 @@ namespace llvm {
 /// Writer for instrumentation based profile data.
 class InstrProfWriter {
 public:
-  typedef SmallDenseMap<uint64_t, std::vector<uint64_t>, 1> CounterData;
+  /// The counts of one function hash, and the targets seen at each of its
+  /// indirect call sites.
+  struct ProfileRecord {
+    std::vector<uint64_t> Counts;
+    std::vector<InstrProfValueSiteRecord> IndirectCallSites;
+  };
+  typedef SmallDenseMap<uint64_t, ProfileRecord, 1> CounterData;
+  typedef std::function<void(StringRef, std::error_code)> WarningHandlerTy;
 private:
   StringMap<CounterData> FunctionData;
   uint64_t MaxFunctionCount;
+  /// Approximate budget for FunctionData, in bytes. Zero means unlimited.
+  size_t MemoryLimit;
+  /// Approximate size of FunctionData, in bytes.
+  size_t MemoryUsed;
+  /// Temporary files holding the sorted runs spilled so far, oldest first.
+  std::vector<std::string> SpilledRuns;
+  /// The first error encountered while spilling, reported by write().
+  std::error_code SpillError;
+  /// Reports the conflicts found while merging the spilled runs.
+  WarningHandlerTy SpillWarningHandler;
+
+  InstrProfWriter(const InstrProfWriter &) = delete;
+  void operator=(const InstrProfWriter &) = delete;
 public:
-  InstrProfWriter() : MaxFunctionCount(0) {}
+  InstrProfWriter() : MaxFunctionCount(0), MemoryLimit(0), MemoryUsed(0) {}
+  ~InstrProfWriter();
+
+  /// Bound the memory used to accumulate function counts to approximately
+  /// \p Bytes, zero meaning no limit. Past that, the counts are sorted and
+  /// spilled to a temporary file, and the spilled runs are merged back by
+  /// write() in bounded memory. Mismatches between counts that ended up in
+  /// different runs are then only detected when writing, and are reported
+  /// through \p Warn instead of by addFunctionCounts().
+  void setMemoryLimit(size_t Bytes, WarningHandlerTy Warn);
 
   /// Add function counts for the given function. If there are already counts
   /// for this function and the hash and number of counts match, each counter is
-  /// summed.
-  std::error_code addFunctionCounts(StringRef FunctionName,
-                                    uint64_t FunctionHash,
-                                    ArrayRef<uint64_t> Counters);
+  /// summed. The counts of the targets seen at each indirect call site are
+  /// summed too.
+  std::error_code addFunctionCounts(
+      StringRef FunctionName, uint64_t FunctionHash,
+      ArrayRef<uint64_t> Counters,
+      const std::vector<InstrProfValueSiteRecord> &IndirectCallSites = {});
+  /// Merge all the function counts of \p IPW into this writer, as if each of
+  /// them had been added with addFunctionCounts(). \p IPW is left empty.
+  /// \p Warn is called for each function whose counts couldn't be merged.
+  void mergeRecordsFromWriter(
+      InstrProfWriter &&IPW,
+      function_ref<void(StringRef, std::error_code)> Warn);
   /// Write the profile to \c OS
-  void write(raw_fd_ostream &OS);
-  /// Write the profile, returning the raw data. For testing.
+  std::error_code write(raw_fd_ostream &OS);
+  /// Write the profile, returning the raw data, or null if the spilled runs
+  /// couldn't be read back. For testing.
   std::unique_ptr<MemoryBuffer> writeBuffer();
 
 private:
-  std::pair<uint64_t, uint64_t> writeImpl(raw_ostream &OS);
+  ErrorOr<std::pair<uint64_t, uint64_t>> writeImpl(raw_ostream &OS);
+  /// Write the in memory counts to a new sorted run and release them.
+  std::error_code spill();
+  /// Merge the spilled runs into a single run, without duplicate functions,
+  /// and recompute MaxFunctionCount.
+  std::error_code mergeSpilledRuns(uint64_t &NumFunctions);
+  /// Emit the hash table from the single run left by mergeSpilledRuns(),
+  /// returning its offset like OnDiskChainedHashTableGenerator::Emit().
+  ErrorOr<uint64_t> emitMergedRun(raw_ostream &OS, uint64_t NumFunctions);
+  /// Remove the temporary files of the spilled runs.
+  void removeSpilledRuns();
 };
 
 } // end namespace llvm
@@ -15,6 +15,7 @@
 #define LLVM_PROFILEDATA_SAMPLEPROF_H_
 
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/Debug.h"
@@ -57,7 +58,18 @@ static inline uint64_t SPMagic() {
          uint64_t('2') << (64 - 56) | uint64_t(0xff);
 }
 
-static inline uint64_t SPVersion() { return 100; }
+/// \brief Magic number of the compact binary format, which indexes the
+/// profile of every function so that it can be read on demand.
+static inline uint64_t SPCompactMagic() {
+  return uint64_t('S') << (64 - 8) | uint64_t('P') << (64 - 16) |
+         uint64_t('R') << (64 - 24) | uint64_t('O') << (64 - 32) |
+         uint64_t('F') << (64 - 40) | uint64_t('I') << (64 - 48) |
+         uint64_t('D') << (64 - 56) | uint64_t(0xff);
+}
+
+/// \brief Version of the binary formats. Version 101 added the profiles of
+/// inlined call sites; the binary reader still accepts version 100.
+static inline uint64_t SPVersion() { return 101; }
 
 /// \brief Represents the relative location of an instruction.
 ///
@@ -74,6 +86,17 @@ struct LineLocation {
   unsigned Discriminator;
 };
 
+/// \brief Represents the relative location of a call site.
+///
+/// Besides the location of the call, this holds the name of the function
+/// that the call site invoked, so that the profiles of different functions
+/// inlined at the same location are kept apart.
+struct CallsiteLocation : public LineLocation {
+  CallsiteLocation(int L, unsigned D, StringRef N)
+      : LineLocation(L, D), CalleeName(N) {}
+  StringRef CalleeName;
+};
+
 } // End namespace sampleprof
 
 template <> struct DenseMapInfo<sampleprof::LineLocation> {
@@ -98,6 +121,29 @@ template <> struct DenseMapInfo<sampleprof::LineLocation> {
   }
 };
 
+template <> struct DenseMapInfo<sampleprof::CallsiteLocation> {
+  typedef DenseMapInfo<int> OffsetInfo;
+  typedef DenseMapInfo<unsigned> DiscriminatorInfo;
+  static inline sampleprof::CallsiteLocation getEmptyKey() {
+    return sampleprof::CallsiteLocation(OffsetInfo::getEmptyKey(),
+                                        DiscriminatorInfo::getEmptyKey(), "");
+  }
+  static inline sampleprof::CallsiteLocation getTombstoneKey() {
+    return sampleprof::CallsiteLocation(OffsetInfo::getTombstoneKey(),
+                                        DiscriminatorInfo::getTombstoneKey(),
+                                        "");
+  }
+  static inline unsigned getHashValue(sampleprof::CallsiteLocation Val) {
+    return hash_combine(Val.LineOffset, Val.Discriminator, Val.CalleeName);
+  }
+  static inline bool isEqual(sampleprof::CallsiteLocation LHS,
+                             sampleprof::CallsiteLocation RHS) {
+    return LHS.LineOffset == RHS.LineOffset &&
+           LHS.Discriminator == RHS.Discriminator &&
+           LHS.CalleeName.equals(RHS.CalleeName);
+  }
+};
+
 namespace sampleprof {
 
 /// \brief Representation of a single sample record.
@@ -158,16 +204,20 @@ private:
 };
 
 typedef DenseMap<LineLocation, SampleRecord> BodySampleMap;
+class FunctionSamples;
+typedef DenseMap<CallsiteLocation, FunctionSamples> CallsiteSampleMap;
 
 /// \brief Representation of the samples collected for a function.
 ///
 /// This data structure contains all the collected samples for the body
 /// of a function. Each sample corresponds to a LineLocation instance
-/// within the body of the function.
+/// within the body of the function. The samples of the functions that were
+/// inlined into the profiled binary are kept apart, as the samples of the
+/// call site that they were inlined at.
 class FunctionSamples {
 public:
   FunctionSamples() : TotalSamples(0), TotalHeadSamples(0) {}
-  void print(raw_ostream &OS = dbgs());
+  void print(raw_ostream &OS = dbgs(), unsigned Indent = 0) const;
   void addTotalSamples(unsigned Num) { TotalSamples += Num; }
   void addHeadSamples(unsigned Num) { TotalHeadSamples += Num; }
   void addBodySamples(int LineOffset, unsigned Discriminator, unsigned Num) {
@@ -199,7 +249,27 @@ public:
     return sampleRecordAt(LineLocation(LineOffset, Discriminator)).getSamples();
   }
 
-  bool empty() const { return BodySamples.empty(); }
+  /// \brief Return the number of samples collected at the given location,
+  /// without creating a record for it.
+  unsigned findSamplesAt(int LineOffset, unsigned Discriminator) const {
+    auto I = BodySamples.find(LineLocation(LineOffset, Discriminator));
+    return I == BodySamples.end() ? 0 : I->second.getSamples();
+  }
+
+  /// \brief Return the samples of the function inlined at call site \p Loc.
+  FunctionSamples &functionSamplesAt(const CallsiteLocation &Loc) {
+    return CallsiteSamples[Loc];
+  }
+
+  /// \brief Return the samples of the function inlined at call site \p Loc,
+  /// or null if nothing was inlined there.
+  const FunctionSamples *
+  findFunctionSamplesAt(const CallsiteLocation &Loc) const {
+    auto I = CallsiteSamples.find(Loc);
+    return I == CallsiteSamples.end() ? nullptr : &I->second;
+  }
+
+  bool empty() const { return BodySamples.empty() && CallsiteSamples.empty(); }
 
   /// \brief Return the total number of samples collected inside the function.
   unsigned getTotalSamples() const { return TotalSamples; }
@@ -211,6 +281,11 @@ public:
   /// \brief Return all the samples collected in the body of the function.
   const BodySampleMap &getBodySamples() const { return BodySamples; }
 
+  /// \brief Return the samples of all the functions inlined into this one.
+  const CallsiteSampleMap &getCallsiteSamples() const {
+    return CallsiteSamples;
+  }
+
   /// \brief Merge the samples in \p Other into this one.
   void merge(const FunctionSamples &Other) {
     addTotalSamples(Other.getTotalSamples());
@@ -220,6 +295,8 @@ public:
       const SampleRecord &Rec = I.second;
       sampleRecordAt(Loc).merge(Rec);
     }
+    for (const auto &I : Other.getCallsiteSamples())
+      functionSamplesAt(I.first).merge(I.second);
   }
 
 private:
@@ -238,6 +315,12 @@ private:
   /// collected at the corresponding line offset. All line locations
   /// are an offset from the start of the function.
   BodySampleMap BodySamples;
+
+  /// \brief Map call sites to the samples of the functions inlined there.
+  ///
+  /// The samples of an inlined function are relative to the start of that
+  /// function, and are not included in BodySamples.
+  CallsiteSampleMap CallsiteSamples;
 };
 
 } // End namespace sampleprof
@@ -55,9 +55,14 @@ namespace sampleprof {
 ///      protection against source code shuffling, line numbers should
 ///      be relative to the start of the function.
 ///
-/// The reader supports two file formats: text and binary. The text format
-/// is useful for debugging and testing, while the binary format is more
-/// compact. They can both be used interchangeably.
+///   3. The samples of the functions that were inlined into F in the
+///      profiled binary, for each of the call sites they were inlined at.
+///
+/// The reader supports three file formats: text, binary and compact binary.
+/// The text format is useful for debugging and testing, while the binary
+/// formats are more compact. The compact binary format also indexes the
+/// functions, so that only the profiles of the functions that are compiled
+/// are read. They can all be used interchangeably.
 class SampleProfileReader {
 public:
   SampleProfileReader(std::unique_ptr<MemoryBuffer> B, LLVMContext &C)
@@ -71,6 +76,11 @@ public:
   /// \brief Read sample profiles from the associated file.
   virtual std::error_code read() = 0;
 
+  /// \brief Prepare to read the profile of each function on demand, when
+  /// getSamplesFor is first called for it. Formats without an index read all
+  /// the profiles here.
+  virtual std::error_code readOnDemand() { return read(); }
+
   /// \brief Print the profile for \p FName on stream \p OS.
   void dumpFunctionProfile(StringRef FName, raw_ostream &OS = dbgs());
 
@@ -79,7 +89,12 @@ public:
 
   /// \brief Return the samples collected for function \p F.
   FunctionSamples *getSamplesFor(const Function &F) {
-    return &Profiles[F.getName()];
+    return getSamplesFor(F.getName());
+  }
+
+  /// \brief Return the samples collected for the function named \p FName.
+  virtual FunctionSamples *getSamplesFor(StringRef FName) {
+    return &Profiles[FName];
   }
 
   /// \brief Return all the profiles.
@@ -125,7 +140,8 @@ public:
 class SampleProfileReaderBinary : public SampleProfileReader {
 public:
   SampleProfileReaderBinary(std::unique_ptr<MemoryBuffer> B, LLVMContext &C)
-      : SampleProfileReader(std::move(B), C), Data(nullptr), End(nullptr) {}
+      : SampleProfileReader(std::move(B), C), Data(nullptr), End(nullptr),
+        Version(0) {}
 
   /// \brief Read and validate the file header.
   std::error_code readHeader() override;
@@ -153,6 +169,16 @@ protected:
   /// \returns the read value.
   ErrorOr<StringRef> readString();
 
+  /// \brief Read the name of a called or inlined function from the profile.
+  virtual ErrorOr<StringRef> readName() { return readString(); }
+
+  /// \brief Read the samples of a function, and of the functions inlined
+  /// into it, into \p FProfile.
+  std::error_code readProfile(FunctionSamples &FProfile);
+
+  /// \brief Read and check the magic identifier and the version of the file.
+  std::error_code readMagicAndVersion(uint64_t Magic);
+
   /// \brief Return true if we've reached the end of file.
   bool at_eof() const { return Data >= End; }
 
@@ -161,6 +187,53 @@ protected:
 
   /// \brief Points to the end of the buffer.
   const uint8_t *End;
+
+  /// \brief Version of the file format.
+  uint64_t Version;
+};
+
+/// \brief Reader of the compact binary format.
+///
+/// The names of all the functions are stored once, in a name table, and the
+/// profile of every function starts at an offset recorded in a function
+/// index. readOnDemand only reads these tables, and the profile of a function
+/// is read on the first call to getSamplesFor for it.
+class SampleProfileReaderCompactBinary : public SampleProfileReaderBinary {
+public:
+  SampleProfileReaderCompactBinary(std::unique_ptr<MemoryBuffer> B,
+                                   LLVMContext &C)
+      : SampleProfileReaderBinary(std::move(B), C), Records(nullptr) {}
+
+  /// \brief Read and validate the file header, the name table and the
+  /// function index.
+  std::error_code readHeader() override;
+
+  /// \brief Read the profiles of all the functions.
+  std::error_code read() override;
+
+  /// \brief The tables are read with the header, so there is nothing to do.
+  std::error_code readOnDemand() override { return sampleprof_error::success; }
+
+  using SampleProfileReader::getSamplesFor;
+  FunctionSamples *getSamplesFor(StringRef FName) override;
+
+  /// \brief Return true if \p Buffer is in the format supported by this class.
+  static bool hasFormat(const MemoryBuffer &Buffer);
+
+protected:
+  ErrorOr<StringRef> readName() override;
+
+  /// \brief Read the profile of \p FName at \p Offset in the records.
+  std::error_code readFunction(StringRef FName, uint64_t Offset);
+
+  /// \brief The names of the functions, in the order of the name table.
+  std::vector<StringRef> NameTable;
+
+  /// \brief The offset of the profile of each function in the records.
+  StringMap<uint64_t> FuncOffsets;
+
+  /// \brief Points to the start of the records.
+  const uint8_t *Records;
 };
 
 } // End namespace sampleprof
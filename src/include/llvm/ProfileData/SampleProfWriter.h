@@ -25,7 +25,13 @@ namespace llvm {
 
 namespace sampleprof {
 
-enum SampleProfileFormat { SPF_None = 0, SPF_Text, SPF_Binary, SPF_GCC };
+enum SampleProfileFormat {
+  SPF_None = 0,
+  SPF_Text,
+  SPF_Binary,
+  SPF_Compact,
+  SPF_GCC
+};
 
 /// \brief Sample-based profile writer. Base class.
 class SampleProfileWriter {
@@ -40,6 +46,13 @@ public:
   /// \returns true if the file was updated successfully. False, otherwise.
   virtual bool write(StringRef FName, const FunctionSamples &S) = 0;
 
+  /// \brief Complete the file after the profiles of all the functions were
+  /// written. This is called by the writers of whole modules and profile
+  /// maps, and must be called by users of the per-function writers.
+  ///
+  /// \returns true if the file was updated successfully. False, otherwise.
+  virtual bool finalize() { return true; }
+
   /// \brief Write sample profiles in \p S for function \p F.
   bool write(const Function &F, const FunctionSamples &S) {
     return write(F.getName(), S);
@@ -54,7 +67,7 @@ public:
       if (!write(Name, P[Name]))
         return false;
     }
-    return true;
+    return finalize();
   }
 
   /// \brief Write all the sample profiles in the given map of samples.
@@ -67,7 +80,7 @@ public:
       if (!write(FName, Profile))
         return false;
     }
-    return true;
+    return finalize();
   }
 
   /// \brief Profile writer factory. Create a new writer based on the value of
@@ -90,6 +103,11 @@ public:
   bool write(const Module &M, StringMap<FunctionSamples> &P) {
     return SampleProfileWriter::write(M, P);
   }
+
+private:
+  /// \brief Write the body of \p S, with every line indented by \p Indent
+  /// spaces. The bodies of inlined call sites are indented one more space.
+  void writeBody(const FunctionSamples &S, unsigned Indent);
 };
 
 /// \brief Sample-based profile writer (binary format).
@@ -101,6 +119,55 @@ public:
   bool write(const Module &M, StringMap<FunctionSamples> &P) {
     return SampleProfileWriter::write(M, P);
   }
+
+protected:
+  /// \brief Write the file header with the given \p Magic number.
+  SampleProfileWriterBinary(StringRef F, std::error_code &EC, uint64_t Magic);
+
+  /// \brief Write the name of a called or inlined function to \p Out.
+  virtual void writeName(raw_ostream &Out, StringRef Name);
+
+  /// \brief Write the samples of \p S, and of the functions inlined into it,
+  /// to \p Out.
+  void writeBody(raw_ostream &Out, const FunctionSamples &S);
+};
+
+/// \brief Sample-based profile writer (compact binary format).
+///
+/// The profiles are buffered, and written by finalize together with the name
+/// table and the function index.
+class SampleProfileWriterCompactBinary : public SampleProfileWriterBinary {
+public:
+  SampleProfileWriterCompactBinary(StringRef F, std::error_code &EC)
+      : SampleProfileWriterBinary(F, EC, SPCompactMagic()), RecordsOS(Records) {
+  }
+
+  bool write(StringRef F, const FunctionSamples &S) override;
+  bool write(const Module &M, StringMap<FunctionSamples> &P) {
+    return SampleProfileWriter::write(M, P);
+  }
+  bool finalize() override;
+
+protected:
+  void writeName(raw_ostream &Out, StringRef Name) override;
+
+private:
+  /// \brief Return the index of \p Name in the name table, adding it to the
+  /// table if needed.
+  uint64_t getNameIndex(StringRef Name);
+
+  /// \brief The index of each name in the name table.
+  StringMap<uint64_t> NameIndices;
+
+  /// \brief The names in the order of the name table.
+  std::vector<StringRef> NameTable;
+
+  /// \brief The name index and the record offset of each function written.
+  std::vector<std::pair<uint64_t, uint64_t>> FuncIndex;
+
+  /// \brief The records of the functions written so far.
+  std::string Records;
+  raw_string_ostream RecordsOS;
 };
 
 } // End namespace sampleprof
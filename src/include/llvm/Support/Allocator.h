@@ -142,19 +142,20 @@ public:
                 "allocation.");
 
   BumpPtrAllocatorImpl()
-      : CurPtr(nullptr), End(nullptr), BytesAllocated(0), Allocator() {}
+      : CurPtr(nullptr), End(nullptr), BytesAllocated(0), SlabSizeShift(0),
+        UseHugePages(false), Allocator() {}
   template <typename T>
   BumpPtrAllocatorImpl(T &&Allocator)
-      : CurPtr(nullptr), End(nullptr), BytesAllocated(0),
-        Allocator(std::forward<T &&>(Allocator)) {}
+      : CurPtr(nullptr), End(nullptr), BytesAllocated(0), SlabSizeShift(0),
+        UseHugePages(false), Allocator(std::forward<T &&>(Allocator)) {}
 
   // Manually implement a move constructor as we must clear the old allocators
   // slabs as a matter of correctness.
   BumpPtrAllocatorImpl(BumpPtrAllocatorImpl &&Old)
       : CurPtr(Old.CurPtr), End(Old.End), Slabs(std::move(Old.Slabs)),
         CustomSizedSlabs(std::move(Old.CustomSizedSlabs)),
-        BytesAllocated(Old.BytesAllocated),
-        Allocator(std::move(Old.Allocator)) {
+        BytesAllocated(Old.BytesAllocated), SlabSizeShift(Old.SlabSizeShift),
+        UseHugePages(Old.UseHugePages), Allocator(std::move(Old.Allocator)) {
     Old.CurPtr = Old.End = nullptr;
     Old.BytesAllocated = 0;
     Old.Slabs.clear();
@@ -173,6 +174,8 @@ public:
     CurPtr = RHS.CurPtr;
     End = RHS.End;
     BytesAllocated = RHS.BytesAllocated;
+    SlabSizeShift = RHS.SlabSizeShift;
+    UseHugePages = RHS.UseHugePages;
     Slabs = std::move(RHS.Slabs);
     CustomSizedSlabs = std::move(RHS.CustomSizedSlabs);
     Allocator = std::move(RHS.Allocator);
@@ -193,7 +196,7 @@ public:
     // Reset the state.
     BytesAllocated = 0;
     CurPtr = (char *)Slabs.front();
-    End = CurPtr + SlabSize;
+    End = CurPtr + computeSlabSize(0);
 
     // Deallocate all but the first slab, and all custome sized slabs.
     DeallocateSlabs(std::next(Slabs.begin()), Slabs.end());
@@ -228,6 +231,8 @@ public:
     if (PaddedSize > SizeThreshold) {
       void *NewSlab = Allocator.Allocate(PaddedSize, 0);
       CustomSizedSlabs.push_back(std::make_pair(NewSlab, PaddedSize));
+      if (UseHugePages)
+        sys::Memory::adviseHugePages(NewSlab, PaddedSize);
 
       uintptr_t AlignedAddr = alignAddr(NewSlab, Alignment);
       assert(AlignedAddr + Size <= (uintptr_t)NewSlab + PaddedSize);
@@ -257,6 +262,34 @@ public:
 
   size_t GetNumSlabs() const { return Slabs.size() + CustomSizedSlabs.size(); }
 
+  /// \brief Allocate slabs of at least \p MinSize bytes from now on, rather
+  /// than starting from \c SlabSize bytes.
+  ///
+  /// Larger slabs mean fewer calls into the underlying allocator for clients
+  /// that allocate a lot, and are needed for the slabs to be backed by huge
+  /// pages.  The slabs allocated so far are kept as they are.
+  void setMinSlabSize(size_t MinSize) {
+    // The size of a slab is derived from its index, so the slabs allocated
+    // with the previous size are kept aside with an explicit size.
+    for (auto I = Slabs.begin(), E = Slabs.end(); I != E; ++I)
+      CustomSizedSlabs.push_back(std::make_pair(
+          *I, computeSlabSize(std::distance(Slabs.begin(), I))));
+    Slabs.clear();
+
+    SlabSizeShift = 0;
+    while ((SlabSize << SlabSizeShift) < MinSize)
+      ++SlabSizeShift;
+  }
+
+  /// \brief Ask the system to back the slabs allocated from now on with huge
+  /// pages, which reduces TLB misses for clients with large heaps.  Only the
+  /// huge pages that fit entirely in a slab can be used, so this is best
+  /// combined with setMinSlabSize().
+  void setUseHugePages(bool Use) { UseHugePages = Use; }
+
+  /// \brief The number of bytes requested from this allocator so far.
+  size_t getBytesAllocated() const { return BytesAllocated; }
+
   size_t getTotalMemory() const {
     size_t TotalMemory = 0;
     for (auto I = Slabs.begin(), E = Slabs.end(); I != E; ++I)
@@ -291,15 +324,22 @@ private:
   /// Used so that we can compute how much space was wasted.
   size_t BytesAllocated;
 
+  /// \brief The regular slabs are \c SlabSize times 2^SlabSizeShift bytes.
+  unsigned SlabSizeShift;
+
+  /// \brief Whether slabs should be backed by huge pages.
+  bool UseHugePages;
+
   /// \brief The allocator instance we use to get slabs of memory.
   AllocatorT Allocator;
 
-  static size_t computeSlabSize(unsigned SlabIdx) {
+  size_t computeSlabSize(unsigned SlabIdx) const {
     // Scale the actual allocated slab size based on the number of slabs
     // allocated. Every 128 slabs allocated, we double the allocated size to
     // reduce allocation frequency, but saturate at multiplying the slab size by
     // 2^30.
-    return SlabSize * ((size_t)1 << std::min<size_t>(30, SlabIdx / 128));
+    return (SlabSize << SlabSizeShift) *
+           ((size_t)1 << std::min<size_t>(30, SlabIdx / 128));
   }
 
   /// \brief Allocate a new slab and move the bump pointers over into the new
@@ -309,6 +349,8 @@ private:
 
     void *NewSlab = Allocator.Allocate(AllocatedSlabSize, 0);
     Slabs.push_back(NewSlab);
+    if (UseHugePages)
+      sys::Memory::adviseHugePages(NewSlab, AllocatedSlabSize);
     CurPtr = (char *)(NewSlab);
     End = ((char *)NewSlab) + AllocatedSlabSize;
   }
@@ -384,7 +426,7 @@ public:
 
     for (auto I = Allocator.Slabs.begin(), E = Allocator.Slabs.end(); I != E;
          ++I) {
-      size_t AllocatedSlabSize = BumpPtrAllocator::computeSlabSize(
+      size_t AllocatedSlabSize = Allocator.computeSlabSize(
           std::distance(Allocator.Slabs.begin(), I));
       char *Begin = (char*)alignAddr(*I, alignOf<T>());
       char *End = *I == Allocator.Slabs.back() ? Allocator.CurPtr
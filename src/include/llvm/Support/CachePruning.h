@@ -0,0 +1,76 @@
+//===- CachePruning.h - Helper to manage the pruning of a cache dir -*- C++ -*-//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements pruning of a directory intended for cache storage, using
+// various policies.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_CACHEPRUNING_H
+#define LLVM_SUPPORT_CACHEPRUNING_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DataTypes.h"
+#include <string>
+
+namespace llvm {
+
+/// \brief Handle pruning a directory provided by the user.
+///
+/// Every file of the directory is a cache entry, except the timestamp file
+/// recording when the directory was last pruned. Entries are considered used
+/// when they were last modified, so the owner of the cache should update the
+/// modification time of the entries it reuses.
+class CachePruning {
+public:
+  /// Prepare to prune \p Path.
+  CachePruning(StringRef Path) : Path(Path) {}
+
+  /// Define the pruning interval, in seconds. This is intended to be used to
+  /// avoid scanning the directory too often. It does not impact the decision
+  /// of which file to prune. A value of 0 forces the scan to occur, and a
+  /// negative value disables pruning.
+  CachePruning &setPruningInterval(int PruningInterval) {
+    Interval = PruningInterval;
+    return *this;
+  }
+
+  /// Define the expiration for a file, in seconds. When a file hasn't been
+  /// used for this long, it is pruned. A value of 0 disables the expiration.
+  CachePruning &setEntryExpiration(unsigned ExpireAfter) {
+    Expiration = ExpireAfter;
+    return *this;
+  }
+
+  /// Define the maximum size of the cache, in bytes. The least recently used
+  /// entries are pruned until the cache fits. A value of 0 disables the size
+  /// limit.
+  CachePruning &setMaxSize(uint64_t Bytes) {
+    MaxSize = Bytes;
+    return *this;
+  }
+
+  /// Peform pruning using the supplied options, returns true if pruning
+  /// occured, i.e. if the pruning interval had elapsed since the last time the
+  /// directory was pruned.
+  bool prune();
+
+  /// The name of the file recording when the directory was last pruned.
+  static StringRef getTimestampFileName() { return "llvm.prune.timestamp"; }
+
+private:
+  std::string Path;
+  int Interval = -1;
+  unsigned Expiration = 0;
+  uint64_t MaxSize = 0;
+};
+
+} // namespace llvm
+
+#endif
@@ -208,6 +208,7 @@ public:
   const char *ValueStr; // String describing what the value of this option is
   OptionCategory *Category; // The Category this option belongs to
   bool FullyInitialized;    // Has addArguemnt been called?
+  Option *NextRegistered;   // The next option the parser hasn't taken in.
 
   inline enum NumOccurrencesFlag getNumOccurrencesFlag() const {
     return (enum NumOccurrencesFlag)Occurrences;
@@ -248,12 +249,14 @@ protected:
       : NumOccurrences(0), Occurrences(OccurrencesFlag), Value(0),
         HiddenFlag(Hidden), Formatting(NormalFormatting), Misc(0), Position(0),
         AdditionalVals(0), ArgStr(""), HelpStr(""), ValueStr(""),
-        Category(&GeneralCategory), FullyInitialized(false) {}
+        Category(&GeneralCategory), FullyInitialized(false),
+        NextRegistered(nullptr) {}
 
   inline void setNumAdditionalVals(unsigned n) { AdditionalVals = n; }
 
 public:
-  // addArgument - Register this argument with the commandline system.
+  // addArgument - Register this argument with the commandline system.  The
+  // option is only queued: the parser takes it in when it is first used.
   //
   void addArgument();
 
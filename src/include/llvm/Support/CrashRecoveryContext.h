@@ -46,9 +46,10 @@ class CrashRecoveryContextCleanup;
 class CrashRecoveryContext {
   void *Impl;
   CrashRecoveryContextCleanup *head;
+  int RetCode;
 
 public:
-  CrashRecoveryContext() : Impl(nullptr), head(nullptr) {}
+  CrashRecoveryContext() : Impl(nullptr), head(nullptr), RetCode(0) {}
   ~CrashRecoveryContext();
 
   void registerCleanup(CrashRecoveryContextCleanup *cleanup);
@@ -87,6 +88,10 @@ public:
   ///
   /// See RunSafely() and llvm_execute_on_thread().
   ///
+  /// The threads are reused by later calls with the same stack size, except
+  /// for those whose callback crashed, so that running many callbacks in turn
+  /// doesn't create a thread for each.
+  ///
   /// On Darwin, if PRIO_DARWIN_BG is set on the calling thread, it will be
   /// propagated to the new thread as well.
   bool RunSafelyOnThread(function_ref<void()>, unsigned RequestedStackSize = 0);
@@ -99,6 +104,15 @@ public:
   /// return failure from RunSafely(). This function does not return.
   void HandleCrash();
 
+  /// \brief Leave the protected context as if the code running in it had
+  /// exited the process with \p Code, and return failure from RunSafely().
+  /// This function does not return.
+  void HandleExit(int Code);
+
+  /// \brief Return the code passed to HandleExit(), or 0 if RunSafely()
+  /// failed because of a crash.
+  int getRetCode() const { return RetCode; }
+
   /// \brief Return a string containing the backtrace where the crash was
   /// detected; or empty if the backtrace wasn't recovered.
   ///
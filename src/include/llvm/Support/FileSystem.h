@@ -636,6 +636,12 @@ public:
     priv ///< May modify via data, but changes are lost on destruction.
   };
 
+  enum advice {
+    sequential, ///< The map will be read front to back.
+    random,     ///< The map will be read in no particular order.
+    willneed    ///< The whole map will be read soon.
+  };
+
 private:
   /// Platform-specific mapping state.
   uint64_t Size;
@@ -659,6 +665,10 @@ public:
   /// behavior.
   const char *const_data() const;
 
+  /// Tell the system how the map will be read, so that it can read the file
+  /// ahead or not.  This is only a hint, which may be ignored.
+  void advise(advice Advice) const;
+
   /// \returns The minimum alignment offset must be.
   static int alignment();
 };
@@ -15,6 +15,7 @@
 #ifndef LLVM_SUPPORT_GCOV_H
 #define LLVM_SUPPORT_GCOV_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SmallVector.h"
@@ -31,6 +32,16 @@ class FileInfo;
 
 namespace GCOV {
 enum GCOVVersion { V402, V404 };
+
+/// The flags of an arc in a .gcno file.
+enum GCOVArcFlags {
+  /// The arc is on a spanning tree of the function's graph and has no count
+  /// in the .gcda file: its count follows from those of the other arcs.
+  ArcOnTree = 1,
+  /// The arc leads to the exit block from a block that leaves the function
+  /// other than by returning.
+  ArcFake = 2
+};
 } // end GCOV namespace
 
 /// GCOVOptions - A struct for passing gcov options between functions.
@@ -246,11 +257,16 @@ private:
 
 /// GCOVEdge - Collects edge information.
 struct GCOVEdge {
-  GCOVEdge(GCOVBlock &S, GCOVBlock &D) : Src(S), Dst(D), Count(0) {}
+  GCOVEdge(GCOVBlock &S, GCOVBlock &D, uint32_t Flags)
+      : Src(S), Dst(D), Count(0), Flags(Flags) {}
+
+  bool isOnTree() const { return Flags & GCOV::ArcOnTree; }
+  bool isFake() const { return Flags & GCOV::ArcFake; }
 
   GCOVBlock &Src;
   GCOVBlock &Dst;
   uint64_t Count;
+  uint32_t Flags;
 };
 
 /// GCOVFunction - Collects function information.
@@ -278,6 +294,8 @@ public:
   void collectLineCounts(FileInfo &FI);
 
 private:
+  bool solveTreeEdges();
+
   GCOVFile &Parent;
   uint32_t Ident;
   uint32_t Checksum;
@@ -311,6 +329,7 @@ public:
         DstEdges(), Lines() {}
   ~GCOVBlock();
   const GCOVFunction &getParent() const { return Parent; }
+  uint32_t getNumber() const { return Number; }
   void addLine(uint32_t N) { Lines.push_back(N); }
   uint32_t getLastLine() const { return Lines.back(); }
   void addCount(size_t DstEdgeNo, uint64_t N);
@@ -393,16 +412,21 @@ public:
   FileInfo(const GCOVOptions &Options)
       : Options(Options), LineInfo(), RunCount(0), ProgramCount(0) {}
 
-  void addBlockLine(StringRef Filename, uint32_t Line, const GCOVBlock *Block) {
-    if (Line > LineInfo[Filename].LastLine)
-      LineInfo[Filename].LastLine = Line;
-    LineInfo[Filename].Blocks[Line - 1].push_back(Block);
+  void addBlockLines(StringRef Filename, ArrayRef<uint32_t> Lines,
+                     const GCOVBlock *Block) {
+    LineData &Data = LineInfo[Filename];
+    for (uint32_t Line : Lines) {
+      if (Line > Data.LastLine)
+        Data.LastLine = Line;
+      Data.Blocks[Line - 1].push_back(Block);
+    }
   }
   void addFunctionLine(StringRef Filename, uint32_t Line,
                        const GCOVFunction *Function) {
-    if (Line > LineInfo[Filename].LastLine)
-      LineInfo[Filename].LastLine = Line;
-    LineInfo[Filename].Functions[Line - 1].push_back(Function);
+    LineData &Data = LineInfo[Filename];
+    if (Line > Data.LastLine)
+      Data.LastLine = Line;
+    Data.Functions[Line - 1].push_back(Function);
   }
   void setRunCount(uint32_t Runs) { RunCount = Runs; }
   void setProgramCount(uint32_t Programs) { ProgramCount = Programs; }
@@ -154,6 +154,11 @@ namespace sys {
     /// setRangeWritable - Mark the page containing a range of addresses
     /// as writable.
     static bool setRangeWritable(const void *Addr, size_t Size);
+
+    /// adviseHugePages - Ask the system to back the huge pages that lie
+    /// entirely within a range of addresses with actual huge pages.  Returns
+    /// false if the system does not support this.
+    static bool adviseHugePages(const void *Addr, size_t Size);
   };
 }
 }
@@ -68,6 +68,10 @@ public:
   /// means that the client knows that the file exists and that it has the
   /// specified size.
   ///
+  /// \param RequiresNullTerminator Set to false when the client doesn't need
+  /// the buffer to end with a null character, as for bitcode and object files.
+  /// The file can then be mapped whatever its size.
+  ///
   /// \param IsVolatileSize Set to true to indicate that the file size may be
   /// changing, e.g. when libclang tries to parse while the user is
   /// editing/updating the file.
@@ -124,7 +128,8 @@ public:
   /// Open the specified file as a MemoryBuffer, or open stdin if the Filename
   /// is "-".
   static ErrorOr<std::unique_ptr<MemoryBuffer>>
-  getFileOrSTDIN(const Twine &Filename, int64_t FileSize = -1);
+  getFileOrSTDIN(const Twine &Filename, int64_t FileSize = -1,
+                 bool RequiresNullTerminator = true);
 
   /// Map a subrange of the the specified file as a MemoryBuffer.
   static ErrorOr<std::unique_ptr<MemoryBuffer>>
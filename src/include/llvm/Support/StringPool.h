@@ -24,6 +24,11 @@
 // to another instance. So that interned strings can eventually be freed,
 // strings in the string pool are reference-counted (automatically).
 //
+// A pool may be used from several threads at the same time: it is split into
+// shards, each with a lock of its own, so that threads interning different
+// strings rarely wait for each other, and copying or destroying a
+// PooledStringPtr only takes a lock when it may release the string.
+//
 //===----------------------------------------------------------------------===//
 
 #ifndef LLVM_SUPPORT_STRINGPOOL_H
@@ -31,7 +36,9 @@
 
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/Compiler.h"
+#include <atomic>
 #include <cassert>
+#include <mutex>
 #include <new>
 
 namespace llvm {
@@ -42,21 +49,38 @@ namespace llvm {
   /// string. Strings are removed automatically as PooledStringPtrs are
   /// destroyed.
   class StringPool {
+    struct Shard;
+
     /// PooledString - This is the value of an entry in the pool's interning
     /// table.
     struct PooledString {
-      StringPool *Pool;  ///< So the string can remove itself.
-      unsigned Refcount; ///< Number of referencing PooledStringPtrs.
+      Shard *Owner;                     ///< So the string can remove itself.
+      std::atomic<unsigned> Refcount;   ///< Number of referencing
+                                        ///< PooledStringPtrs.
 
     public:
-      PooledString() : Pool(nullptr), Refcount(0) { }
+      PooledString() : Owner(nullptr), Refcount(0) { }
+      PooledString(PooledString &&Other)
+          : Owner(Other.Owner), Refcount(Other.Refcount.load()) { }
     };
 
     friend class PooledStringPtr;
 
     typedef StringMap<PooledString> table_t;
     typedef StringMapEntry<PooledString> entry_t;
-    table_t InternTable;
+
+    /// Shard - A part of the interning table. The reference count of a string
+    /// only reaches zero, and the string is only found or removed, with the
+    /// lock of its shard held.
+    struct Shard {
+      mutable std::mutex Lock;
+      table_t InternTable;
+    };
+
+    enum { NumShards = 16 };
+    Shard Shards[NumShards];
+
+    Shard &getShard(StringRef Str);
 
   public:
     StringPool();
@@ -69,7 +93,7 @@ namespace llvm {
 
     /// empty - Checks whether the pool is empty. Returns true if so.
     ///
-    inline bool empty() const { return InternTable.empty(); }
+    bool empty() const;
   };
 
   /// PooledStringPtr - A pointer to an interned string. Use operator bool to
@@ -84,6 +108,8 @@ namespace llvm {
   public:
     PooledStringPtr() : S(nullptr) {}
 
+    /// The lock of the shard of E must be held, or E must already be
+    /// referenced.
     explicit PooledStringPtr(entry_t *E) : S(E) {
       if (S) ++S->getValue().Refcount;
     }
@@ -104,8 +130,21 @@ namespace llvm {
     void clear() {
       if (!S)
         return;
-      if (--S->getValue().Refcount == 0) {
-        S->getValue().Pool->InternTable.remove(S);
+      // Drop a reference that isn't the last one without locking. The last one
+      // is dropped under the lock, so that the string can't be interned again
+      // while it is being removed.
+      std::atomic<unsigned> &Refcount = S->getValue().Refcount;
+      unsigned Count = Refcount.load();
+      while (Count > 1)
+        if (Refcount.compare_exchange_weak(Count, Count - 1)) {
+          S = nullptr;
+          return;
+        }
+
+      StringPool::Shard &Owner = *S->getValue().Owner;
+      std::lock_guard<std::mutex> Lock(Owner.Lock);
+      if (--Refcount == 0) {
+        Owner.InternTable.remove(S);
         S->Destroy();
       }
       S = nullptr;
@@ -0,0 +1,156 @@
+//===-- llvm/Support/ThreadPool.h - A ThreadPool implementation -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a crude C++11 based thread pool, and a TaskGroup helper
+// to wait on a subset of the tasks submitted to a pool.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_THREADPOOL_H
+#define LLVM_SUPPORT_THREADPOOL_H
+
+#include "llvm/Config/llvm-config.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+
+/// A ThreadPool for asynchronous parallel execution on a defined number of
+/// threads.
+///
+/// The pool keeps a vector of threads alive, waiting on a condition variable
+/// for some work to become available. Threads that block in wait() (or in
+/// TaskGroup::wait()) pick up queued work themselves instead of sleeping, so
+/// a task may wait on a TaskGroup of nested tasks without deadlocking.
+///
+/// When LLVM is built without thread support (LLVM_ENABLE_THREADS=0) no thread
+/// is ever created and every task runs synchronously inside async().
+class ThreadPool {
+public:
+  typedef std::function<void()> TaskTy;
+
+  /// Construct a pool of \p ThreadCount threads. A count of zero means one
+  /// thread per hardware thread, as reported by
+  /// std::thread::hardware_concurrency().
+  explicit ThreadPool(unsigned ThreadCount = 0);
+
+  /// Blocking destructor: the pool will wait for all the queued tasks to
+  /// complete before joining its threads.
+  ~ThreadPool();
+
+  /// Asynchronous submission of a task to the pool. The returned future can
+  /// be used to wait for the task to finish and retrieve its result.
+  template <typename Function>
+  auto async(Function &&F) -> std::future<decltype(F())> {
+    typedef decltype(F()) ResultTy;
+    auto Task = std::make_shared<std::packaged_task<ResultTy()>>(
+        std::forward<Function>(F));
+    std::future<ResultTy> Future = Task->get_future();
+    enqueue([Task]() { (*Task)(); });
+    return Future;
+  }
+
+  /// Asynchronous submission of \p F applied to \p ArgList. The arguments are
+  /// copied into the task, like std::bind does.
+  template <typename Function, typename... Args>
+  auto async(Function &&F, Args &&... ArgList)
+      -> std::future<decltype(F(ArgList...))> {
+    auto Task =
+        std::bind(std::forward<Function>(F), std::forward<Args>(ArgList)...);
+    return async(std::move(Task));
+  }
+
+  /// Blocking wait for all the tasks to complete and the queue to be empty.
+  /// The calling thread helps executing queued tasks while waiting. It is an
+  /// error to call this from one of the pool's tasks; use a TaskGroup instead.
+  void wait();
+
+  /// Return the number of worker threads owned by the pool. This is zero when
+  /// LLVM is built without thread support.
+  unsigned getThreadCount() const { return Threads.size(); }
+
+private:
+  friend class TaskGroup;
+
+  /// Queue \p Task for execution by a worker (or run it inline when threading
+  /// is disabled).
+  void enqueue(TaskTy Task);
+
+  /// Block the calling thread until \p IsDone returns true, running queued
+  /// tasks in the meantime. \p IsDone is evaluated with QueueLock held.
+  void waitUntil(const std::function<bool()> &IsDone);
+
+  /// Main loop of the worker threads.
+  void workerLoop();
+
+  /// The worker threads.
+  std::vector<std::thread> Threads;
+
+  /// Tasks waiting for a thread to pick them up.
+  std::deque<TaskTy> Tasks;
+
+  /// Protects Tasks, ActiveTasks and EnableFlag.
+  std::mutex QueueLock;
+
+  /// Signaled when a task is queued or when the pool shuts down.
+  std::condition_variable QueueCondition;
+
+  /// Signaled when a task is queued or completes, for waiting threads.
+  std::condition_variable CompletionCondition;
+
+  /// Number of tasks currently executing.
+  unsigned ActiveTasks;
+
+  /// Cleared by the destructor to request the workers to exit.
+  bool EnableFlag;
+};
+
+/// A TaskGroup tracks a set of tasks submitted to a ThreadPool and allows
+/// waiting for just those tasks, independently of whatever else is running on
+/// the pool. The destructor waits for the outstanding tasks.
+class TaskGroup {
+  TaskGroup(const TaskGroup &) = delete;
+  void operator=(const TaskGroup &) = delete;
+
+public:
+  explicit TaskGroup(ThreadPool &Pool) : Pool(Pool), Pending(0) {}
+  ~TaskGroup() { wait(); }
+
+  /// Submit \p F to the underlying pool as part of this group.
+  template <typename Function> void spawn(Function &&F) {
+    ++Pending;
+    std::function<void()> Task(std::forward<Function>(F));
+    Pool.enqueue([this, Task]() {
+      Task();
+      --Pending;
+    });
+  }
+
+  /// Blocking wait for all the tasks spawned in this group to complete. The
+  /// calling thread helps executing queued tasks while waiting.
+  void wait();
+
+  ThreadPool &getPool() { return Pool; }
+
+private:
+  ThreadPool &Pool;
+  std::atomic<unsigned> Pending;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_SUPPORT_THREADPOOL_H
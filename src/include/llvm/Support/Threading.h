@@ -34,6 +34,16 @@ namespace llvm {
   /// the thread stack.
   void llvm_execute_on_thread(void (*UserFn)(void*), void *UserData,
                               unsigned RequestedStackSize = 0);
+
+  /// llvm_execute_on_detached_thread - Start executing the given \p UserFn on
+  /// a separate thread, passing it the provided \p UserData, and return
+  /// without waiting for it to finish.
+  ///
+  /// \returns false if no thread could be started, in which case \p UserFn
+  /// has not been called. This is always the case if LLVM is built without
+  /// thread support.
+  bool llvm_execute_on_detached_thread(void (*UserFn)(void*), void *UserData,
+                                       unsigned RequestedStackSize = 0);
 }
 
 #endif
@@ -0,0 +1,101 @@
+//===- llvm/Support/TimeProfiler.h - Hierarchical time trace ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the TimeTraceScope class, which records how long a program
+/// spends in a scope, and the functions that write the recorded scopes as a
+/// Chrome trace (see chrome://tracing) or as folded stacks for flame graphs.
+///
+/// Scopes are cheap enough to leave in hot code: when no trace is recorded a
+/// scope only tests a global pointer, and when one is, it reads a nanosecond
+/// clock on entry and exit and appends to a buffer owned by its thread.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_TIMEPROFILER_H
+#define LLVM_SUPPORT_TIMEPROFILER_H
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+
+namespace llvm {
+
+class raw_ostream;
+class TimeTraceProfiler;
+
+/// \brief The time trace being recorded, if any.
+extern TimeTraceProfiler *TimeTraceProfilerInstance;
+
+/// \brief Start recording a time trace.  This and timeTraceProfilerCleanup
+/// must not be called while other threads may be recording scopes.
+///
+/// \param GranularityUS Scopes that take less than this many microseconds are
+/// left out of the Chrome trace, although they still count towards the totals
+/// and the folded stacks.
+/// \param ProcessName The name the Chrome trace shows for the process.
+void timeTraceProfilerInitialize(unsigned GranularityUS,
+                                 StringRef ProcessName);
+
+/// \brief Stop recording the time trace and discard it.
+void timeTraceProfilerCleanup();
+
+/// \brief Write the time trace recorded so far to \p OS as a Chrome trace.
+///
+/// Besides one event per recorded scope, with one row per thread, the trace
+/// has one event per scope name with the total time spent in scopes of that
+/// name.  Each thread keeps only its most recent scopes once it has recorded
+/// a few hundred thousand.
+void timeTraceProfilerWrite(raw_ostream &OS);
+
+/// \brief Write the time recorded so far to \p OS as folded stacks: one line
+/// per stack of nested scope names, joined with ';', followed by the
+/// microseconds spent in the innermost scope itself.  This is the format
+/// perf traces are collapsed into for flamegraph.pl and similar tools.
+void timeTraceProfilerWriteFolded(raw_ostream &OS);
+
+/// \brief Whether a time trace is being recorded.
+inline bool isTimeTraceProfilerEnabled() {
+  return TimeTraceProfilerInstance != nullptr;
+}
+
+void timeTraceProfilerBegin(StringRef Name, StringRef Detail);
+void timeTraceProfilerEnd();
+
+/// \brief Records the time spent between its construction and destruction
+/// into the time trace, if one is being recorded.
+///
+/// The detail of the scope, such as the name of the function being parsed, is
+/// only computed when a trace is recorded.
+class TimeTraceScope {
+  bool Active;
+
+  TimeTraceScope(const TimeTraceScope &) = delete;
+  void operator=(const TimeTraceScope &) = delete;
+
+public:
+  explicit TimeTraceScope(StringRef Name)
+      : Active(isTimeTraceProfilerEnabled()) {
+    if (Active)
+      timeTraceProfilerBegin(Name, StringRef());
+  }
+  TimeTraceScope(StringRef Name, function_ref<std::string()> Detail)
+      : Active(isTimeTraceProfilerEnabled()) {
+    if (Active)
+      timeTraceProfilerBegin(Name, Detail());
+  }
+  ~TimeTraceScope() {
+    if (Active)
+      timeTraceProfilerEnd();
+  }
+};
+
+} // end namespace llvm
+
+#endif
@@ -13,6 +13,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/DataTypes.h"
+#include "llvm/Support/TimeProfiler.h"
 #include <cassert>
 #include <string>
 #include <utility>
@@ -143,13 +144,18 @@ public:
 /// NamedRegionTimer - This class is basically a combination of TimeRegion and
 /// Timer.  It allows you to declare a new timer, AND specify the region to
 /// time, all in one statement.  All timers with the same name are merged.  This
-/// is primarily used for debugging and for hunting performance problems.
+/// is primarily used for debugging and for hunting performance problems.  The
+/// region is also recorded in the time trace, if one is being recorded, even
+/// when the timer is disabled.
 ///
 struct NamedRegionTimer : public TimeRegion {
   explicit NamedRegionTimer(StringRef Name,
                             bool Enabled = true);
   explicit NamedRegionTimer(StringRef Name, StringRef GroupName,
                             bool Enabled = true);
+
+private:
+  TimeTraceScope TraceScope;
 };
 
 
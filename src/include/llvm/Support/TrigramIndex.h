@@ -0,0 +1,62 @@
+//===-- TrigramIndex.h - a heuristic for SpecialCaseList --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//===----------------------------------------------------------------------===//
+//
+// TrigramIndex implements a heuristic for SpecialCaseList that allows to
+// filter out ~99% incoming queries when all regular expressions in the
+// SpecialCaseList are simple wildcards with '*' and '.'. If rules are more
+// complicated, the check is defeated and it will always pass the queries to a
+// full regex.
+//
+// The basic idea is that in order for a wildcard to match a query, the query
+// needs to have all trigrams which occur in the wildcard. We create a trigram
+// index (trigram -> list of rules with it) and then count trigrams in the
+// query for each rule. If the count for one rule reaches the expected value,
+// the query may match that rule and has to go through the full regex.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_TRIGRAMINDEX_H
+#define LLVM_SUPPORT_TRIGRAMINDEX_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+class TrigramIndex {
+public:
+  TrigramIndex() : Defeated(false) {}
+
+  /// Inserts a new regular expression, as SpecialCaseList writes it, to the
+  /// index.
+  void insert(StringRef Regex);
+
+  /// Returns true if the query can't match any of the regular expressions
+  /// inserted so far, false if it may match one of them.
+  bool isDefinitelyOut(StringRef Query) const;
+
+  /// Returned true, iff the heuristic is defeated and not useful.
+  /// In this case isDefinitelyOut always returns false.
+  bool isDefeated() const { return Defeated; }
+
+private:
+  /// If true, the rules are too complicated for the check to work, and full
+  /// regex matching is needed for every rule.
+  bool Defeated;
+  /// The number of distinct trigrams in each rule.
+  std::vector<unsigned> Counts;
+  /// The rules each trigram occurs in.
+  DenseMap<unsigned, SmallVector<unsigned, 4>> Index;
+};
+
+}  // namespace llvm
+
+#endif  // LLVM_SUPPORT_TRIGRAMINDEX_H
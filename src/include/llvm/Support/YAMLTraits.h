@@ -19,6 +19,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/Twine.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Regex.h"
 #include "llvm/Support/SourceMgr.h"
@@ -958,14 +959,15 @@ private:
     virtual void anchor();
 
   public:
-    MapHNode(Node *n) : HNode(n) { }
+    MapHNode(Node *n, BumpPtrAllocator &A) : HNode(n), Mapping(A) { }
 
     static inline bool classof(const HNode *n) {
       return MappingNode::classof(n->_node);
     }
     static inline bool classof(const MapHNode *) { return true; }
 
-    typedef llvm::StringMap<std::unique_ptr<HNode>> NameToNode;
+    // The nodes and the keys live in the allocators of the Input.
+    typedef llvm::StringMap<HNode *, BumpPtrAllocator &> NameToNode;
 
     bool isValidKey(StringRef key);
 
@@ -984,10 +986,10 @@ private:
     }
     static inline bool classof(const SequenceHNode *) { return true; }
 
-    std::vector<std::unique_ptr<HNode>> Entries;
+    std::vector<HNode *> Entries;
   };
 
-  std::unique_ptr<Input::HNode> createHNodes(Node *node);
+  Input::HNode *createHNodes(Node *node);
   void setError(HNode *hnode, const Twine &message);
   void setError(Node *node, const Twine &message);
 
@@ -1001,9 +1003,15 @@ public:
 private:
   llvm::SourceMgr                     SrcMgr; // must be before Strm
   std::unique_ptr<llvm::yaml::Stream> Strm;
-  std::unique_ptr<HNode>              TopNode;
+  HNode                              *TopNode;
   std::error_code                     EC;
   llvm::BumpPtrAllocator              StringAllocator;
+  // A document's nodes are allocated together, and freed together when the
+  // next document is read.
+  llvm::SpecificBumpPtrAllocator<EmptyHNode>    EmptyHNodeAllocator;
+  llvm::SpecificBumpPtrAllocator<ScalarHNode>   ScalarHNodeAllocator;
+  llvm::SpecificBumpPtrAllocator<MapHNode>      MapHNodeAllocator;
+  llvm::SpecificBumpPtrAllocator<SequenceHNode> SequenceHNodeAllocator;
   llvm::yaml::document_iterator       DocIterator;
   std::vector<bool>                   BitValuesUsed;
   HNode                              *CurrentNode;
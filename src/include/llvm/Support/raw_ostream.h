@@ -271,6 +271,16 @@ private:
   /// \invariant { Size > 0 }
   virtual void write_impl(const char *Ptr, size_t Size) = 0;
 
+  /// Write the \p Size1 bytes starting at \p Ptr1, which are the buffered
+  /// data, then the \p Size2 bytes starting at \p Ptr2.  This is how writes
+  /// at least as large as the buffer go out.  Streams that can gather writes
+  /// override this to write both at once; by default it calls write_impl once
+  /// for each.
+  ///
+  /// \invariant { Size1 > 0 && Size2 > 0 }
+  virtual void writev_impl(const char *Ptr1, size_t Size1, const char *Ptr2,
+                           size_t Size2);
+
   // An out of line virtual method to provide a home for the class vtable.
   virtual void handle();
 
@@ -332,6 +342,10 @@ class raw_fd_ostream : public raw_ostream {
   /// See raw_ostream::write_impl.
   void write_impl(const char *Ptr, size_t Size) override;
 
+  /// See raw_ostream::writev_impl.
+  void writev_impl(const char *Ptr1, size_t Size1, const char *Ptr2,
+                   size_t Size2) override;
+
   /// Return the current position within the stream, not counting the bytes
   /// currently in the buffer.
   uint64_t current_pos() const override { return pos; }
@@ -0,0 +1,39 @@
+//===- llvm/Support/xxhash.h - 64-bit xxHash --------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Declares xxHash64, an implementation of the 64-bit variant of Yann
+/// Collet's xxHash (https://github.com/Cyan4973/xxHash).
+///
+/// xxHash reads its input eight bytes at a time and hashes several gigabytes
+/// a second, many times faster than MD5.  Use it to fingerprint data that is
+/// only compared within one build, such as an in-memory buffer or a key used
+/// to spread values into buckets.  It is not a cryptographic hash: anything
+/// an adversary may try to collide with, or that a format requires to be MD5,
+/// such as DWARF type signatures, should keep using llvm::MD5.
+///
+/// The results are the same on every host and match the reference
+/// implementation, so they may be written to files.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_XXHASH_H
+#define LLVM_SUPPORT_XXHASH_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DataTypes.h"
+
+namespace llvm {
+
+/// \brief Returns the 64-bit xxHash of \p Data with the given seed.
+uint64_t xxHash64(StringRef Data, uint64_t Seed = 0);
+
+} // end namespace llvm
+
+#endif
@@ -122,7 +122,36 @@ enum {
   /// label. Created by the llvm.frameallocate intrinsic. It has two arguments:
   /// the symbol for the label and the frame index of the stack allocation.
   FRAME_ALLOC = 21,
+
+  /// Generic opcodes used by the global instruction selector before
+  /// instruction selection. Their register operands are generic virtual
+  /// registers, which have a size but no register class yet.
+  /// res = G_ADD op0, op1
+  G_ADD = 22,
+  PRE_ISEL_GENERIC_OPCODE_START = G_ADD,
+  /// res = G_SUB op0, op1
+  G_SUB = 23,
+  /// res = G_MUL op0, op1
+  G_MUL = 24,
+  /// res = G_AND op0, op1
+  G_AND = 25,
+  /// res = G_OR op0, op1
+  G_OR = 26,
+  /// res = G_XOR op0, op1
+  G_XOR = 27,
+  /// G_BR bb, unconditional branch to the basic block.
+  G_BR = 28,
+  /// res = G_CONSTANT imm
+  G_CONSTANT = 29,
+  PRE_ISEL_GENERIC_OPCODE_END = G_CONSTANT,
 };
+
+/// isPreISelGenericOpcode - Return true if \p Opcode is one of the generic
+/// opcodes that only exist before instruction selection.
+inline bool isPreISelGenericOpcode(unsigned Opcode) {
+  return Opcode >= PRE_ISEL_GENERIC_OPCODE_START &&
+         Opcode <= PRE_ISEL_GENERIC_OPCODE_END;
+}
 } // end namespace TargetOpcode
 } // end namespace llvm
 
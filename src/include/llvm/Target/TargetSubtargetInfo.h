@@ -20,9 +20,12 @@
 
 namespace llvm {
 
+class CallLowering;
 class DataLayout;
+class InstructionSelector;
 class MachineFunction;
 class MachineInstr;
+class RegisterBankInfo;
 class SDep;
 class SUnit;
 class TargetFrameLowering;
@@ -72,6 +75,16 @@ public:
     return nullptr;
   }
 
+  /// Hooks of the global instruction selector. A target that supports it
+  /// returns the lowering of its calling convention, the assignment of
+  /// generic virtual registers to register banks, and the selector of
+  /// generic instructions.
+  virtual const CallLowering *getCallLowering() const { return nullptr; }
+  virtual const RegisterBankInfo *getRegBankInfo() const { return nullptr; }
+  virtual const InstructionSelector *getInstructionSelector() const {
+    return nullptr;
+  }
+
   /// getRegisterInfo - If register information is available, return it.  If
   /// not, return null.  This is kept separate from RegInfo until RegInfo has
   /// details of graph coloring register allocation removed from it.
@@ -189,6 +189,24 @@ ModulePass *createMergeFunctionsPass();
 ///
 ModulePass *createPartialInliningPass();
 
+//===----------------------------------------------------------------------===//
+/// createHotColdSplittingPass - This pass outlines the cold regions of
+/// functions.
+///
+ModulePass *createHotColdSplittingPass();
+
+//===----------------------------------------------------------------------===//
+/// createFunctionOrderingPass - This pass orders the functions of a module by
+/// their profile, so that hot functions that call each other are close.
+///
+ModulePass *createFunctionOrderingPass();
+
+//===----------------------------------------------------------------------===//
+/// createWholeProgramDevirtPass - This pass devirtualizes virtual calls whose
+/// targets are known from the virtual tables of the whole program.
+///
+ModulePass *createWholeProgramDevirtPass();
+
 //===----------------------------------------------------------------------===//
 // createMetaRenamerPass - Rename everything with metasyntatic names.
 //
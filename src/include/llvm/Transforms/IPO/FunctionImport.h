@@ -0,0 +1,73 @@
+//===- llvm/Transforms/IPO/FunctionImport.h - Function import ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the interface to decide, from a function summary index,
+// which functions to import into a module, and to import them. Imported
+// functions become available_externally definitions, which can be inlined in
+// the destination module but are never emitted there.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_IPO_FUNCTIONIMPORT_H
+#define LLVM_TRANSFORMS_IPO_FUNCTIONIMPORT_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/Support/ErrorOr.h"
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+class FunctionInfoIndex;
+class Module;
+
+/// The names of the functions to import, keyed by the path of the module
+/// defining them.
+typedef std::map<std::string, std::vector<std::string>> ImportListTy;
+
+/// \brief Compute the functions to import into the module \p ModulePath of
+/// \p Index.
+///
+/// A function is imported when it is called, directly or through another
+/// imported function, by a function of the module, is not defined in the
+/// module, and has an importable definition of at most \p InstLimit
+/// instructions in another module.
+ImportListTy ComputeImportList(const FunctionInfoIndex &Index,
+                               StringRef ModulePath, unsigned InstLimit);
+
+/// \brief Imports functions from other modules into a module.
+class FunctionImporter {
+public:
+  /// Load the module at the given path, lazily, in the context of the
+  /// destination module. Errors are reported by the loader itself.
+  typedef std::function<ErrorOr<std::unique_ptr<Module>>(StringRef Path)>
+      ModuleLoaderTy;
+
+  FunctionImporter(ModuleLoaderTy ModuleLoader,
+                   DiagnosticHandlerFunction DiagnosticHandler = nullptr)
+      : ModuleLoader(std::move(ModuleLoader)),
+        DiagnosticHandler(std::move(DiagnosticHandler)) {}
+
+  /// \brief Import the functions of \p ImportList into \p M, as
+  /// available_externally definitions. Functions that \p M already defines
+  /// are not imported. Returns true on error.
+  bool importFunctions(Module &M, const ImportListTy &ImportList);
+
+private:
+  ModuleLoaderTy ModuleLoader;
+  DiagnosticHandlerFunction DiagnosticHandler;
+};
+
+} // End llvm namespace
+
+#endif
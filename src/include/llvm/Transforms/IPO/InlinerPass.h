@@ -17,14 +17,15 @@
 #ifndef LLVM_TRANSFORMS_IPO_INLINERPASS_H
 #define LLVM_TRANSFORMS_IPO_INLINERPASS_H
 
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Analysis/CallGraphSCCPass.h"
 
 namespace llvm {
   class CallSite;
   class DataLayout;
+  class Function;
   class InlineCost;
-  template<class PtrType, unsigned SmallSize>
-  class SmallPtrSet;
+  class Instruction;
 
 /// Inliner - This class contains all of the helper code which is used to
 /// perform the inlining operations that do not depend on the policy.
@@ -55,7 +56,8 @@ struct Inliner : public CallGraphSCCPass {
   /// Calculate the inline threshold for given Caller. This threshold is lower
   /// if the caller is marked with OptimizeForSize and -inline-threshold is not
   /// given on the comand line. It is higher if the callee is marked with the
-  /// inlinehint attribute.
+  /// inlinehint attribute, or if the profile says that the call site is hot,
+  /// and lower if the profile says that it is cold.
   ///
   unsigned getInlineThreshold(CallSite CS) const;
 
@@ -81,9 +83,18 @@ private:
   // InsertLifetime - Insert @llvm.lifetime intrinsics.
   bool InsertLifetime;
 
+  // HotCallSites, ColdCallSites - The call sites of the current SCC that the
+  // block frequencies of their profiled callers classify as hot or cold.
+  SmallPtrSet<const Instruction *, 16> HotCallSites;
+  SmallPtrSet<const Instruction *, 16> ColdCallSites;
+
   /// shouldInline - Return true if the inliner should attempt to
   /// inline at the given CallSite.
   bool shouldInline(CallSite CS);
+
+  /// collectCallSiteHotness - Classify the call sites of \p F as hot or cold
+  /// from its block frequencies if \p F carries profile data.
+  void collectCallSiteHotness(Function &F);
 };
 
 } // End llvm namespace
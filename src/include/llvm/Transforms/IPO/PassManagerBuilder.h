@@ -140,6 +140,8 @@ public:
 private:
   void addExtensionsToPM(ExtensionPointTy ETy, PassManagerBase &PM) const;
   void addInitialAliasAnalysisPasses(PassManagerBase &PM) const;
+  void addLTOIPOPasses(PassManagerBase &PM);
+  void addLTOFunctionPasses(PassManagerBase &PM);
   void addLTOOptimizationPasses(PassManagerBase &PM);
 
 public:
@@ -151,6 +153,15 @@ public:
   /// populateModulePassManager - This sets up the primary pass manager.
   void populateModulePassManager(PassManagerBase &MPM);
   void populateLTOPassManager(PassManagerBase &PM);
+
+  /// populateLTOIPOPassManager - This sets up the interprocedural part of the
+  /// LTO pipeline, which stops before the passes that optimize each function
+  /// on its own.  populateLTOFunctionPassManager sets up the rest, so that it
+  /// can run on each partition of the module separately (see SplitModule).
+  /// Together they skip the final GlobalDCE and MergeFunctions of the
+  /// populateLTOPassManager pipeline.
+  void populateLTOIPOPassManager(PassManagerBase &PM);
+  void populateLTOFunctionPassManager(PassManagerBase &PM);
 };
 
 /// Registers a function for adding a standard set of passes.  This should be
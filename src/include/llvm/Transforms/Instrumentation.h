@@ -80,6 +80,10 @@ struct InstrProfOptions {
 ModulePass *createInstrProfilingPass(
     const InstrProfOptions &Options = InstrProfOptions());
 
+/// Promote the hot targets of indirect calls to direct calls, using the value
+/// profile of the calls.
+ModulePass *createPGOIndirectCallPromotionPass();
+
 // Insert AddressSanitizer (address sanity checking) instrumentation
 FunctionPass *createAddressSanitizerFunctionPass();
 ModulePass *createAddressSanitizerModulePass();
@@ -0,0 +1,47 @@
+//===- SplitModule.h - Split a module into partitions -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the function llvm::SplitModule, which splits a module
+// into multiple linkable partitions. It can be used to implement parallel code
+// generation for link-time optimization.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_UTILS_SPLITMODULE_H
+#define LLVM_TRANSFORMS_UTILS_SPLITMODULE_H
+
+#include "llvm/ADT/STLExtras.h"
+#include <memory>
+
+namespace llvm {
+
+class Module;
+
+/// Split the given module \p M into \p N linkable partitions, calling
+/// \p ModuleCallback on each partition in order. The partitions are created in
+/// the context of \p M.
+///
+/// Each global definition of \p M ends up in exactly one partition, and every
+/// other partition refers to it through an external declaration. To make this
+/// possible, the symbols with local linkage are first given hidden visibility
+/// external linkage and a unique name, in place in \p M. Symbols whose name
+/// bypasses mangling (starting with '\1') are kept local instead, together
+/// with every global that refers to them. Members of a comdat, and aliases
+/// with their aliasee, are kept together.
+///
+/// Module inline asm and the global constructor and destructor lists go to the
+/// first partition; llvm.used and llvm.compiler.used are split so that each
+/// partition lists the symbols it defines.
+void SplitModule(Module &M, unsigned N,
+                 function_ref<void(std::unique_ptr<Module> MPart)>
+                     ModuleCallback);
+
+} // End llvm namespace
+
+#endif
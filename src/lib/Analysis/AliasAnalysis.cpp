@@ -82,6 +82,16 @@ void AliasAnalysis::addEscapingUse(Use &U) {
   AA->addEscapingUse(U);
 }
 
+void AliasAnalysis::beginBatchQueries() {
+  assert(AA && "AA didn't call InitializeAliasAnalysis in its run method!");
+  AA->beginBatchQueries();
+}
+
+void AliasAnalysis::endBatchQueries() {
+  assert(AA && "AA didn't call InitializeAliasAnalysis in its run method!");
+  AA->endBatchQueries();
+}
+
 
 AliasAnalysis::ModRefResult
 AliasAnalysis::getModRefInfo(ImmutableCallSite CS,
@@ -183,6 +183,9 @@ bool AAEval::runOnFunction(Function &F) {
     errs() << "Function: " << F.getName() << ": " << Pointers.size()
            << " pointers, " << CallSites.size() << " call sites\n";
 
+  // None of the queries below change the function.
+  AliasAnalysis::BatchQueryScope Batch(AA);
+
   // iterate over the worklist, and run the full (n^2)/2 disambiguations
   for (SetVector<Value *>::iterator I1 = Pointers.begin(), E = Pointers.end();
        I1 != E; ++I1) {
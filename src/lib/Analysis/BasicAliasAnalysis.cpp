@@ -14,6 +14,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Analysis/Passes.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Analysis/AliasAnalysis.h"
@@ -447,7 +448,7 @@ namespace {
   /// BasicAliasAnalysis - This is the primary alias analysis implementation.
   struct BasicAliasAnalysis : public ImmutablePass, public AliasAnalysis {
     static char ID; // Class identification, replacement for typeinfo
-    BasicAliasAnalysis() : ImmutablePass(ID) {
+    BasicAliasAnalysis() : ImmutablePass(ID), BatchDepth(0) {
       initializeBasicAliasAnalysisPass(*PassRegistry::getPassRegistry());
     }
 
@@ -471,9 +472,29 @@ namespace {
       // FIXME: This should really be shrink_to_inline_capacity_and_clear().
       AliasCache.shrink_and_clear();
       VisitedPhiBBs.clear();
+      if (!BatchDepth)
+        clearPointerCaches();
       return Alias;
     }
 
+    void deleteValue(Value *V) override {
+      // A cached decomposition may refer to V anywhere in its expression.
+      clearPointerCaches();
+      AliasAnalysis::deleteValue(V);
+    }
+
+    void beginBatchQueries() override {
+      ++BatchDepth;
+      AliasAnalysis::beginBatchQueries();
+    }
+
+    void endBatchQueries() override {
+      assert(BatchDepth && "ending a batch of queries that was not started");
+      if (!--BatchDepth)
+        clearPointerCaches();
+      AliasAnalysis::endBatchQueries();
+    }
+
     ModRefResult getModRefInfo(ImmutableCallSite CS,
                                const Location &Loc) override;
 
@@ -529,6 +550,41 @@ namespace {
     // Visited - Track instructions visited by pointsToConstantMemory.
     SmallPtrSet<const Value*, 16> Visited;
 
+    /// \brief A pointer decomposed by DecomposeGEPExpression.
+    struct DecomposedGEP {
+      const Value *Base;
+      int64_t Offset;
+      SmallVector<VariableGEPIndex, 4> VarIndices;
+      bool MaxLookupReached;
+    };
+
+    /// \brief The pointers decomposed, and the underlying objects found, in
+    /// the current query or batch of queries.  A single query often looks at
+    /// the same pointers several times through phis and selects, and the
+    /// queries of a batch mostly look at the same few pointers.
+    DenseMap<const Value *, DecomposedGEP> DecomposedGEPs;
+    DenseMap<const Value *, const Value *> UnderlyingObjects;
+
+    /// \brief The number of batches of queries that have been started and not
+    /// ended yet.
+    unsigned BatchDepth;
+
+    void clearPointerCaches() {
+      DecomposedGEPs.clear();
+      UnderlyingObjects.clear();
+    }
+
+    /// \brief DecomposeGEPExpression, going through the cache of decomposed
+    /// pointers.
+    const Value *decomposeGEP(const Value *V, int64_t &BaseOffs,
+                              SmallVectorImpl<VariableGEPIndex> &VarIndices,
+                              bool &MaxLookupReached, AssumptionCache *AC,
+                              DominatorTree *DT);
+
+    /// \brief GetUnderlyingObject, going through the cache of underlying
+    /// objects.
+    const Value *getUnderlyingObject(const Value *V);
+
     /// \brief Check whether two Values can be considered equivalent.
     ///
     /// In addition to pointer equivalence of \p V1 and \p V2 this checks
@@ -808,6 +864,33 @@ bool BasicAliasAnalysis::doInitialization(Module &M) {
   return true;
 }
 
+const Value *
+BasicAliasAnalysis::decomposeGEP(const Value *V, int64_t &BaseOffs,
+                                 SmallVectorImpl<VariableGEPIndex> &VarIndices,
+                                 bool &MaxLookupReached, AssumptionCache *AC,
+                                 DominatorTree *DT) {
+  assert(VarIndices.empty() && "decomposing into non-empty indices");
+  auto Cached = DecomposedGEPs.find(V);
+  if (Cached == DecomposedGEPs.end()) {
+    DecomposedGEP D;
+    D.Base = DecomposeGEPExpression(V, D.Offset, D.VarIndices,
+                                    D.MaxLookupReached, *DL, AC, DT);
+    Cached = DecomposedGEPs.insert(std::make_pair(V, std::move(D))).first;
+  }
+  const DecomposedGEP &D = Cached->second;
+  BaseOffs = D.Offset;
+  VarIndices.append(D.VarIndices.begin(), D.VarIndices.end());
+  MaxLookupReached = D.MaxLookupReached;
+  return D.Base;
+}
+
+const Value *BasicAliasAnalysis::getUnderlyingObject(const Value *V) {
+  const Value *&Object = UnderlyingObjects[V];
+  if (!Object)
+    Object = GetUnderlyingObject(V, *DL, MaxLookupSearchDepth);
+  return Object;
+}
+
 /// getModRefInfo - Check to see if the specified callsite can clobber the
 /// specified memory object.  Since we only look at local properties of this
 /// function, we really can't say much about this query.  We do, however, use
@@ -1034,11 +1117,11 @@ BasicAliasAnalysis::aliasGEP(const GEPOperator *GEP1, uint64_t V1Size,
         bool GEP2MaxLookupReached;
         SmallVector<VariableGEPIndex, 4> GEP2VariableIndices;
         const Value *GEP2BasePtr =
-            DecomposeGEPExpression(GEP2, GEP2BaseOffset, GEP2VariableIndices,
-                                   GEP2MaxLookupReached, *DL, AC2, DT);
+            decomposeGEP(GEP2, GEP2BaseOffset, GEP2VariableIndices,
+                         GEP2MaxLookupReached, AC2, DT);
         const Value *GEP1BasePtr =
-            DecomposeGEPExpression(GEP1, GEP1BaseOffset, GEP1VariableIndices,
-                                   GEP1MaxLookupReached, *DL, AC1, DT);
+            decomposeGEP(GEP1, GEP1BaseOffset, GEP1VariableIndices,
+                         GEP1MaxLookupReached, AC1, DT);
         // DecomposeGEPExpression and GetUnderlyingObject should return the
         // same result except when DecomposeGEPExpression has no DataLayout.
         if (GEP1BasePtr != UnderlyingV1 || GEP2BasePtr != UnderlyingV2) {
@@ -1066,15 +1149,15 @@ BasicAliasAnalysis::aliasGEP(const GEPOperator *GEP1, uint64_t V1Size,
     // exactly, see if the computed offset from the common pointer tells us
     // about the relation of the resulting pointer.
     const Value *GEP1BasePtr =
-        DecomposeGEPExpression(GEP1, GEP1BaseOffset, GEP1VariableIndices,
-                               GEP1MaxLookupReached, *DL, AC1, DT);
+        decomposeGEP(GEP1, GEP1BaseOffset, GEP1VariableIndices,
+                     GEP1MaxLookupReached, AC1, DT);
 
     int64_t GEP2BaseOffset;
     bool GEP2MaxLookupReached;
     SmallVector<VariableGEPIndex, 4> GEP2VariableIndices;
     const Value *GEP2BasePtr =
-        DecomposeGEPExpression(GEP2, GEP2BaseOffset, GEP2VariableIndices,
-                               GEP2MaxLookupReached, *DL, AC2, DT);
+        decomposeGEP(GEP2, GEP2BaseOffset, GEP2VariableIndices,
+                     GEP2MaxLookupReached, AC2, DT);
 
     // DecomposeGEPExpression and GetUnderlyingObject should return the
     // same result except when DecomposeGEPExpression has no DataLayout.
@@ -1123,8 +1206,8 @@ BasicAliasAnalysis::aliasGEP(const GEPOperator *GEP1, uint64_t V1Size,
       return R;
 
     const Value *GEP1BasePtr =
-        DecomposeGEPExpression(GEP1, GEP1BaseOffset, GEP1VariableIndices,
-                               GEP1MaxLookupReached, *DL, AC1, DT);
+        decomposeGEP(GEP1, GEP1BaseOffset, GEP1VariableIndices,
+                     GEP1MaxLookupReached, AC1, DT);
 
     // DecomposeGEPExpression and GetUnderlyingObject should return the
     // same result except when DecomposeGEPExpression has no DataLayout.
@@ -1402,8 +1485,8 @@ BasicAliasAnalysis::aliasCheck(const Value *V1, uint64_t V1Size,
     return NoAlias;  // Scalars cannot alias each other
 
   // Figure out what objects these things are pointing to if we can.
-  const Value *O1 = GetUnderlyingObject(V1, *DL, MaxLookupSearchDepth);
-  const Value *O2 = GetUnderlyingObject(V2, *DL, MaxLookupSearchDepth);
+  const Value *O1 = getUnderlyingObject(V1);
+  const Value *O2 = getUnderlyingObject(V2);
 
   // Null values in the default address space don't point to any object, so they
   // don't alias any other pointer.
@@ -122,7 +122,11 @@ bool CGPassManager::RunPassOnSCC(Pass *P, CallGraphSCC &CurSCC,
     }
 
     {
-      TimeRegion PassTimer(getPassTimer(CGSP));
+      SmallVector<const Function *, 4> Functions;
+      for (CallGraphNode *CGN : CurSCC)
+        if (const Function *F = CGN->getFunction())
+          Functions.push_back(F);
+      PassExecutionTimer PassTimer(CGSP, Functions);
       Changed = CGSP->runOnSCC(CurSCC);
     }
     
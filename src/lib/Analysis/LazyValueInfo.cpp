@@ -13,8 +13,11 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Analysis/LazyValueInfo.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AssumptionCache.h"
 #include "llvm/Analysis/ConstantFolding.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
@@ -28,6 +31,7 @@
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/PatternMatch.h"
 #include "llvm/IR/ValueHandle.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 #include <map>
@@ -37,6 +41,18 @@ using namespace PatternMatch;
 
 #define DEBUG_TYPE "lazy-value-info"
 
+STATISTIC(NumQueries, "Number of LVI queries");
+STATISTIC(NumSolverSteps, "Number of block values processed by the LVI solver");
+STATISTIC(NumBudgetExhausted,
+          "Number of LVI queries that exhausted the solver budget");
+STATISTIC(NumThreadEdgeCleared,
+          "Number of overdefined values dropped by edge threading");
+
+static cl::opt<unsigned>
+MaxSolverSteps("lvi-max-solver-steps", cl::Hidden, cl::init(500),
+               cl::desc("Maximum number of block values that the solver "
+                        "processes for a single query before giving up"));
+
 char LazyValueInfo::ID = 0;
 INITIALIZE_PASS_BEGIN(LazyValueInfo, "lazy-value-info",
                 "Lazy Value Information Analysis", false, true)
@@ -323,9 +339,10 @@ namespace {
     
     /// This tracks, on a per-block basis, the set of values that are
     /// over-defined at the end of that block.  This is required
-    /// for cache updating.
-    typedef std::pair<AssertingVH<BasicBlock>, Value*> OverDefinedPairTy;
-    DenseSet<OverDefinedPairTy> OverDefinedCache;
+    /// for cache updating, and keying it by block keeps the updates after
+    /// edge threading and block deletion local to the blocks involved.
+    typedef SmallPtrSet<Value *, 4> OverDefinedSetTy;
+    DenseMap<AssertingVH<BasicBlock>, OverDefinedSetTy> OverDefinedCache;
 
     /// Keep track of all blocks that we have ever seen, so we
     /// don't spend time removing unused blocks from our caches.
@@ -359,7 +376,7 @@ namespace {
       SeenBlocks.insert(BB);
       lookup(Val)[BB] = Result;
       if (Result.isOverdefined())
-        OverDefinedCache.insert(std::make_pair(BB, Val));
+        OverDefinedCache[BB].insert(Val);
     }
 
     LVILatticeVal getBlockValue(Value *Val, BasicBlock *BB);
@@ -425,15 +442,9 @@ namespace {
 } // end anonymous namespace
 
 void LVIValueHandle::deleted() {
-  typedef std::pair<AssertingVH<BasicBlock>, Value*> OverDefinedPairTy;
-  
-  SmallVector<OverDefinedPairTy, 4> ToErase;
-  for (const OverDefinedPairTy &P : Parent->OverDefinedCache)
-    if (P.second == getValPtr())
-      ToErase.push_back(P);
-  for (const OverDefinedPairTy &P : ToErase)
-    Parent->OverDefinedCache.erase(P);
-  
+  for (auto &I : Parent->OverDefinedCache)
+    I.second.erase(getValPtr());
+
   // This erasure deallocates *this, so it MUST happen after we're done
   // using any and all members of *this.
   Parent->ValueCache.erase(*this);
@@ -446,12 +457,7 @@ void LazyValueInfoCache::eraseBlock(BasicBlock *BB) {
     return;
   SeenBlocks.erase(I);
 
-  SmallVector<OverDefinedPairTy, 4> ToErase;
-  for (const OverDefinedPairTy& P : OverDefinedCache)
-    if (P.first == BB)
-      ToErase.push_back(P);
-  for (const OverDefinedPairTy &P : ToErase)
-    OverDefinedCache.erase(P);
+  OverDefinedCache.erase(BB);
 
   for (std::map<LVIValueHandle, ValueCacheEntryTy>::iterator
        I = ValueCache.begin(), E = ValueCache.end(); I != E; ++I)
@@ -459,7 +465,34 @@ void LazyValueInfoCache::eraseBlock(BasicBlock *BB) {
 }
 
 void LazyValueInfoCache::solve() {
+  // The overdefined results are only cached per block, so a query on a large
+  // function may rediscover the same overdefined values along every path.
+  // Keep a copy of the values that the client asked for, so that they can be
+  // given up on when the query runs out of budget.
+  std::stack<std::pair<BasicBlock*, Value*> > StartingStack(BlockValueStack);
+  unsigned Steps = 0;
   while (!BlockValueStack.empty()) {
+    ++NumSolverSteps;
+    if (++Steps > MaxSolverSteps) {
+      DEBUG(dbgs() << "LVI giving up on a query after " << MaxSolverSteps
+                   << " solver steps\n");
+      ++NumBudgetExhausted;
+      // Only the values of the original query get a result; the unfinished
+      // intermediate values are recomputed if they are ever asked for.
+      for (; !StartingStack.empty(); StartingStack.pop()) {
+        std::pair<BasicBlock*, Value*> &e = StartingStack.top();
+        if (hasBlockValue(e.second, e.first))
+          continue;
+        LVILatticeVal Result;
+        Result.markOverdefined();
+        insertResult(e.second, e.first, Result);
+      }
+      while (!BlockValueStack.empty())
+        BlockValueStack.pop();
+      BlockValueSet.clear();
+      return;
+    }
+
     std::pair<BasicBlock*, Value*> &e = BlockValueStack.top();
     assert(BlockValueSet.count(e) && "Stack value should be in BlockValueSet!");
 
@@ -999,6 +1032,7 @@ LVILatticeVal LazyValueInfoCache::getValueInBlock(Value *V, BasicBlock *BB,
         << BB->getName() << "'\n");
   
   assert(BlockValueStack.empty() && BlockValueSet.empty());
+  ++NumQueries;
   pushBlockValue(std::make_pair(BB, V));
 
   solve();
@@ -1026,6 +1060,7 @@ getValueOnEdge(Value *V, BasicBlock *FromBB, BasicBlock *ToBB,
   DEBUG(dbgs() << "LVI Getting edge value " << *V << " from '"
         << FromBB->getName() << "' to '" << ToBB->getName() << "'\n");
   
+  ++NumQueries;
   LVILatticeVal Result;
   if (!getEdgeValue(V, FromBB, ToBB, Result, CxtI)) {
     solve();
@@ -1053,11 +1088,13 @@ void LazyValueInfoCache::threadEdge(BasicBlock *PredBB, BasicBlock *OldSucc,
   std::vector<BasicBlock*> worklist;
   worklist.push_back(OldSucc);
   
-  DenseSet<Value*> ClearSet;
-  for (OverDefinedPairTy &P : OverDefinedCache)
-    if (P.first == OldSucc)
-      ClearSet.insert(P.second);
-  
+  // Values that are not overdefined in OldSucc keep their cached results,
+  // so the following queries of the threading client reuse them.
+  auto OSI = OverDefinedCache.find(OldSucc);
+  if (OSI == OverDefinedCache.end())
+    return;
+  SmallVector<Value *, 8> ClearSet(OSI->second.begin(), OSI->second.end());
+
   // Use a worklist to perform a depth-first search of OldSucc's successors.
   // NOTE: We do not need a visited list since any blocks we have already
   // visited will have had their overdefined markers cleared already, and we
@@ -1069,12 +1106,13 @@ void LazyValueInfoCache::threadEdge(BasicBlock *PredBB, BasicBlock *OldSucc,
     // Skip blocks only accessible through NewSucc.
     if (ToUpdate == NewSucc) continue;
     
+    auto OI = OverDefinedCache.find(ToUpdate);
+    if (OI == OverDefinedCache.end()) continue;
+
     bool changed = false;
     for (Value *V : ClearSet) {
       // If a value was marked overdefined in OldSucc, and is here too...
-      DenseSet<OverDefinedPairTy>::iterator OI =
-        OverDefinedCache.find(std::make_pair(ToUpdate, V));
-      if (OI == OverDefinedCache.end()) continue;
+      if (!OI->second.erase(V)) continue;
 
       // Remove it from the caches.
       ValueCacheEntryTy &Entry = ValueCache[LVIValueHandle(V, this)];
@@ -1082,7 +1120,7 @@ void LazyValueInfoCache::threadEdge(BasicBlock *PredBB, BasicBlock *OldSucc,
 
       assert(CI != Entry.end() && "Couldn't find entry to update?");
       Entry.erase(CI);
-      OverDefinedCache.erase(OI);
+      ++NumThreadEdgeCleared;
 
       // If we removed anything, then we potentially need to update 
       // blocks successors too.
@@ -245,7 +245,8 @@ bool LPPassManager::runOnFunction(Function &F) {
 
       {
         PassManagerPrettyStackEntry X(P, *CurrentLoop->getHeader());
-        TimeRegion PassTimer(getPassTimer(P));
+        PassExecutionTimer PassTimer(P,
+                                     *CurrentLoop->getHeader()->getParent());
 
         Changed |= P->runOnLoop(CurrentLoop, *this);
       }
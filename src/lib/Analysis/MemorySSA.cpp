@@ -0,0 +1,802 @@
+//===- MemorySSA.cpp - Memory SSA form ------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the MemorySSA class, its walkers and its pass.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/MemorySSA.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/IR/AssemblyAnnotationWriter.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <queue>
+using namespace llvm;
+
+#define DEBUG_TYPE "memoryssa"
+
+STATISTIC(NumClobberCacheLookups, "Number of Memory SSA clobber queries");
+STATISTIC(NumClobberCacheHits, "Number of Memory SSA clobber cache hits");
+
+// The number of defining accesses and phis a clobber query may look at
+// before it gives up and answers with the access it reached.
+static cl::opt<unsigned>
+MaxCheckLimit("memssa-check-limit", cl::init(100), cl::Hidden,
+              cl::desc("The maximum number of accesses a Memory SSA clobber "
+                       "query checks"));
+
+static cl::opt<bool>
+VerifyMemorySSA("verify-memoryssa", cl::init(false), cl::Hidden,
+                cl::desc("Verify Memory SSA after building it"));
+
+//===----------------------------------------------------------------------===//
+// MemoryAccess implementation
+//===----------------------------------------------------------------------===//
+
+MemoryAccess::~MemoryAccess() {}
+
+void MemoryAccess::removeUser(MemoryAccess *User) {
+  auto I = std::find(Users.begin(), Users.end(), User);
+  assert(I != Users.end() && "access is not a user");
+  Users.erase(I);
+}
+
+void MemoryAccess::replaceAllUsesWith(MemoryAccess *New) {
+  assert(New != this && "replacing an access with itself");
+  while (!Users.empty()) {
+    MemoryAccess *User = Users.back();
+    if (auto *MUD = dyn_cast<MemoryUseOrDef>(User)) {
+      MUD->setDefiningAccess(New);
+      continue;
+    }
+    auto *Phi = cast<MemoryPhi>(User);
+    for (unsigned I = 0, E = Phi->getNumIncomingValues(); I != E; ++I)
+      if (Phi->getIncomingValue(I) == this)
+        Phi->setIncomingValue(I, New);
+  }
+}
+
+void MemoryAccess::dump() const {
+  print(dbgs());
+  dbgs() << "\n";
+}
+
+MemoryUseOrDef::~MemoryUseOrDef() {}
+
+void MemoryUseOrDef::setDefiningAccess(MemoryAccess *DMA) {
+  if (DefiningAccess)
+    DefiningAccess->removeUser(this);
+  DefiningAccess = DMA;
+  if (DMA)
+    DMA->addUser(this);
+}
+
+void MemoryUse::print(raw_ostream &OS) const {
+  OS << "MemoryUse(";
+  getDefiningAccess()->printID(OS);
+  OS << ')';
+}
+
+void MemoryUse::printID(raw_ostream &OS) const {
+  llvm_unreachable("a MemoryUse defines no version of memory");
+}
+
+void MemoryDef::print(raw_ostream &OS) const {
+  if (!getMemoryInst()) {
+    OS << "liveOnEntry";
+    return;
+  }
+  OS << getID() << " = MemoryDef(";
+  getDefiningAccess()->printID(OS);
+  OS << ')';
+}
+
+void MemoryDef::printID(raw_ostream &OS) const {
+  if (getMemoryInst())
+    OS << getID();
+  else
+    OS << "liveOnEntry";
+}
+
+MemoryPhi::~MemoryPhi() {}
+
+MemoryAccess *MemoryPhi::getIncomingValueForBlock(const BasicBlock *BB) const {
+  for (const auto &Op : Operands)
+    if (Op.first == BB)
+      return Op.second;
+  return nullptr;
+}
+
+void MemoryPhi::addIncoming(MemoryAccess *MA, BasicBlock *BB) {
+  Operands.push_back(std::make_pair(BB, MA));
+  MA->addUser(this);
+}
+
+void MemoryPhi::setIncomingValue(unsigned I, MemoryAccess *MA) {
+  Operands[I].second->removeUser(this);
+  Operands[I].second = MA;
+  MA->addUser(this);
+}
+
+void MemoryPhi::print(raw_ostream &OS) const {
+  OS << getID() << " = MemoryPhi(";
+  for (unsigned I = 0, E = Operands.size(); I != E; ++I) {
+    if (I)
+      OS << ',';
+    OS << '{';
+    if (Operands[I].first->hasName())
+      OS << Operands[I].first->getName();
+    else
+      Operands[I].first->printAsOperand(OS, false);
+    OS << ',';
+    Operands[I].second->printID(OS);
+    OS << '}';
+  }
+  OS << ')';
+}
+
+void MemoryPhi::printID(raw_ostream &OS) const { OS << getID(); }
+
+//===----------------------------------------------------------------------===//
+// MemorySSA implementation
+//===----------------------------------------------------------------------===//
+
+MemorySSA::MemorySSA(Function &F, AliasAnalysis *AA, DominatorTree *DT)
+    : F(F), AA(AA), DT(DT), NextID(0) {
+  buildMemorySSA();
+}
+
+MemorySSA::~MemorySSA() {
+  // The accesses refer to each other, so none of them drop their references.
+  for (auto &BlockAccesses : PerBlockAccesses)
+    for (MemoryAccess *MA : *BlockAccesses.second)
+      delete MA;
+}
+
+MemorySSAWalker *MemorySSA::getWalker() {
+  if (!Walker)
+    Walker.reset(new CachingMemorySSAWalker(this, AA));
+  return Walker.get();
+}
+
+MemoryUseOrDef *MemorySSA::getMemoryAccess(const Instruction *I) const {
+  return cast_or_null<MemoryUseOrDef>(ValueToMemoryAccess.lookup(I));
+}
+
+MemoryPhi *MemorySSA::getMemoryAccess(const BasicBlock *BB) const {
+  return cast_or_null<MemoryPhi>(ValueToMemoryAccess.lookup(BB));
+}
+
+MemorySSA::AccessListType &
+MemorySSA::getOrCreateAccessList(const BasicBlock *BB) {
+  std::unique_ptr<AccessListType> &Accesses = PerBlockAccesses[BB];
+  if (!Accesses)
+    Accesses.reset(new AccessListType());
+  return *Accesses;
+}
+
+MemoryUseOrDef *MemorySSA::createNewAccess(Instruction *I, BasicBlock *BB) {
+  bool Def, Use;
+  if (ImmutableCallSite CS = ImmutableCallSite(I)) {
+    AliasAnalysis::ModRefBehavior MRB = AA->getModRefBehavior(CS);
+    if (MRB == AliasAnalysis::DoesNotAccessMemory)
+      return nullptr;
+    Def = !AliasAnalysis::onlyReadsMemory(MRB);
+    Use = !Def;
+  } else {
+    Def = I->mayWriteToMemory();
+    Use = !Def && I->mayReadFromMemory();
+  }
+  if (!Def && !Use)
+    return nullptr;
+
+  MemoryUseOrDef *MUD;
+  if (Def)
+    MUD = new MemoryDef(I, BB, NextID++);
+  else
+    MUD = new MemoryUse(I, BB);
+  ValueToMemoryAccess[I] = MUD;
+  return MUD;
+}
+
+void MemorySSA::buildMemorySSA() {
+  // The live-on-entry definition is in no block's access list.
+  LiveOnEntryDef.reset(new MemoryDef(nullptr, &F.getEntryBlock(), NextID++));
+
+  SmallPtrSet<BasicBlock *, 32> DefiningBlocks;
+  for (BasicBlock &BB : F) {
+    AccessListType *Accesses = nullptr;
+    bool Defines = false;
+    for (Instruction &I : BB) {
+      MemoryUseOrDef *MUD = createNewAccess(&I, &BB);
+      if (!MUD)
+        continue;
+      if (!Accesses)
+        Accesses = &getOrCreateAccessList(&BB);
+      Accesses->push_back(MUD);
+      Defines |= isa<MemoryDef>(MUD);
+    }
+    if (Defines)
+      DefiningBlocks.insert(&BB);
+  }
+
+  placePHINodes(DefiningBlocks);
+
+  // Give every access the version of memory it follows, walking the
+  // dominator tree and keeping the version each block ends with.
+  SmallPtrSet<BasicBlock *, 32> Visited;
+  struct RenameFrame {
+    DomTreeNode *Node;
+    DomTreeNode::iterator Child;
+    MemoryAccess *IncomingVal;
+  };
+  SmallVector<RenameFrame, 32> Worklist;
+  DomTreeNode *Root = DT->getRootNode();
+  Visited.insert(Root->getBlock());
+  Worklist.push_back(
+      {Root, Root->begin(), renameBlock(Root->getBlock(), LiveOnEntryDef.get())});
+  while (!Worklist.empty()) {
+    RenameFrame &Frame = Worklist.back();
+    if (Frame.Child == Frame.Node->end()) {
+      Worklist.pop_back();
+      continue;
+    }
+    DomTreeNode *Child = *Frame.Child++;
+    MemoryAccess *IncomingVal = renameBlock(Child->getBlock(), Frame.IncomingVal);
+    Visited.insert(Child->getBlock());
+    Worklist.push_back({Child, Child->begin(), IncomingVal});
+  }
+
+  // Unreachable code reads and writes the live-on-entry memory, so that the
+  // accesses and the incoming values of the phis are all set.
+  for (BasicBlock &BB : F) {
+    if (Visited.count(&BB))
+      continue;
+    if (const AccessListType *Accesses = getBlockAccesses(&BB))
+      for (MemoryAccess *MA : *Accesses)
+        cast<MemoryUseOrDef>(MA)->setDefiningAccess(LiveOnEntryDef.get());
+    for (BasicBlock *Succ : successors(&BB))
+      if (MemoryPhi *Phi = getMemoryAccess(Succ))
+        Phi->addIncoming(LiveOnEntryDef.get(), &BB);
+  }
+
+  if (VerifyMemorySSA)
+    verifyMemorySSA();
+}
+
+/// Put a MemoryPhi at the start of every block in the iterated dominance
+/// frontier of the blocks that write memory, as PromoteMemToReg does for the
+/// stores to an alloca.
+void MemorySSA::placePHINodes(
+    const SmallPtrSetImpl<BasicBlock *> &DefiningBlocks) {
+  DenseMap<DomTreeNode *, unsigned> DomLevels;
+  SmallVector<DomTreeNode *, 32> Worklist;
+  DomTreeNode *Root = DT->getRootNode();
+  DomLevels[Root] = 0;
+  Worklist.push_back(Root);
+  while (!Worklist.empty()) {
+    DomTreeNode *Node = Worklist.pop_back_val();
+    unsigned ChildLevel = DomLevels[Node] + 1;
+    for (DomTreeNode *Child : *Node) {
+      DomLevels[Child] = ChildLevel;
+      Worklist.push_back(Child);
+    }
+  }
+
+  // Use a priority queue keyed on dominator tree level so that inserted nodes
+  // are handled from the bottom of the dominator tree upwards.
+  typedef std::pair<DomTreeNode *, unsigned> DomTreeNodePair;
+  typedef std::priority_queue<DomTreeNodePair, SmallVector<DomTreeNodePair, 32>,
+                              less_second> IDFPriorityQueue;
+  IDFPriorityQueue PQ;
+  for (BasicBlock &BB : F)
+    if (DefiningBlocks.count(&BB))
+      if (DomTreeNode *Node = DT->getNode(&BB))
+        PQ.push(std::make_pair(Node, DomLevels[Node]));
+
+  SmallPtrSet<BasicBlock *, 32> PHIBlocks;
+  SmallPtrSet<DomTreeNode *, 32> Visited;
+  while (!PQ.empty()) {
+    DomTreeNodePair RootPair = PQ.top();
+    PQ.pop();
+    unsigned RootLevel = RootPair.second;
+
+    // Walk all dominator tree children of Root, inspecting their CFG edges
+    // with targets elsewhere on the dominator tree. Only targets whose level
+    // is at most Root's level are in the iterated dominance frontier.
+    Worklist.clear();
+    Worklist.push_back(RootPair.first);
+    while (!Worklist.empty()) {
+      DomTreeNode *Node = Worklist.pop_back_val();
+      for (BasicBlock *Succ : successors(Node->getBlock())) {
+        DomTreeNode *SuccNode = DT->getNode(Succ);
+        if (SuccNode->getIDom() == Node)
+          continue;
+        unsigned SuccLevel = DomLevels[SuccNode];
+        if (SuccLevel > RootLevel)
+          continue;
+        if (!Visited.insert(SuccNode).second)
+          continue;
+        PHIBlocks.insert(Succ);
+        if (!DefiningBlocks.count(Succ))
+          PQ.push(std::make_pair(SuccNode, SuccLevel));
+      }
+      for (DomTreeNode *Child : *Node)
+        if (!Visited.count(Child))
+          Worklist.push_back(Child);
+    }
+  }
+
+  // Number the phis in the order of their blocks.
+  for (BasicBlock &BB : F) {
+    if (!PHIBlocks.count(&BB))
+      continue;
+    MemoryPhi *Phi = new MemoryPhi(&BB, NextID++);
+    ValueToMemoryAccess[&BB] = Phi;
+    getOrCreateAccessList(&BB).push_front(Phi);
+  }
+}
+
+/// Set the defining accesses in \p BB, which starts with the version of
+/// memory \p IncomingVal, and the incoming values of the phis of its
+/// successors.  Return the version \p BB ends with.
+MemoryAccess *MemorySSA::renameBlock(BasicBlock *BB,
+                                     MemoryAccess *IncomingVal) {
+  if (const AccessListType *Accesses = getBlockAccesses(BB)) {
+    for (MemoryAccess *MA : *Accesses) {
+      if (auto *MUD = dyn_cast<MemoryUseOrDef>(MA)) {
+        MUD->setDefiningAccess(IncomingVal);
+        if (isa<MemoryDef>(MUD))
+          IncomingVal = MUD;
+      } else {
+        IncomingVal = MA;
+      }
+    }
+  }
+
+  for (BasicBlock *Succ : successors(BB))
+    if (MemoryPhi *Phi = getMemoryAccess(Succ))
+      Phi->addIncoming(IncomingVal, BB);
+  return IncomingVal;
+}
+
+MemorySSA::AccessListType::iterator
+MemorySSA::findInBlock(const MemoryAccess *MA) {
+  AccessListType &Accesses = *PerBlockAccesses.find(MA->getBlock())->second;
+  auto It = std::find(Accesses.begin(), Accesses.end(), MA);
+  assert(It != Accesses.end() && "access is not in its block");
+  return It;
+}
+
+MemoryUseOrDef *MemorySSA::insertAccess(MemoryUseOrDef *NewAccess,
+                                        MemoryAccess *Definition,
+                                        BasicBlock *BB,
+                                        AccessListType::iterator InsertPt) {
+  NewAccess->setDefiningAccess(Definition);
+  getOrCreateAccessList(BB).insert(InsertPt, NewAccess);
+  if (Walker)
+    Walker->invalidateInfo(NewAccess);
+  return NewAccess;
+}
+
+MemoryUseOrDef *MemorySSA::createMemoryAccessInBB(Instruction *I,
+                                                  MemoryAccess *Definition,
+                                                  BasicBlock *BB,
+                                                  InsertionPlace Point) {
+  MemoryUseOrDef *NewAccess = createNewAccess(I, BB);
+  assert(NewAccess && "the instruction does not access memory");
+  AccessListType &Accesses = getOrCreateAccessList(BB);
+  AccessListType::iterator InsertPt = Accesses.end();
+  if (Point == Beginning) {
+    InsertPt = Accesses.begin();
+    if (InsertPt != Accesses.end() && isa<MemoryPhi>(*InsertPt))
+      ++InsertPt;
+  }
+  return insertAccess(NewAccess, Definition, BB, InsertPt);
+}
+
+MemoryUseOrDef *MemorySSA::createMemoryAccessBefore(Instruction *I,
+                                                    MemoryAccess *Definition,
+                                                    MemoryUseOrDef *InsertPt) {
+  assert(I->getParent() == InsertPt->getBlock() &&
+         "the instruction is not in the block of the insertion point");
+  MemoryUseOrDef *NewAccess = createNewAccess(I, InsertPt->getBlock());
+  assert(NewAccess && "the instruction does not access memory");
+  return insertAccess(NewAccess, Definition, InsertPt->getBlock(),
+                      findInBlock(InsertPt));
+}
+
+MemoryUseOrDef *MemorySSA::createMemoryAccessAfter(Instruction *I,
+                                                   MemoryAccess *Definition,
+                                                   MemoryAccess *InsertPt) {
+  assert(I->getParent() == InsertPt->getBlock() &&
+         "the instruction is not in the block of the insertion point");
+  MemoryUseOrDef *NewAccess = createNewAccess(I, InsertPt->getBlock());
+  assert(NewAccess && "the instruction does not access memory");
+  return insertAccess(NewAccess, Definition, InsertPt->getBlock(),
+                      std::next(findInBlock(InsertPt)));
+}
+
+void MemorySSA::removeMemoryAccess(MemoryAccess *MA) {
+  assert(!isLiveOnEntryDef(MA) && "removing the live-on-entry definition");
+  if (Walker)
+    Walker->invalidateInfo(MA);
+
+  if (auto *MUD = dyn_cast<MemoryUseOrDef>(MA)) {
+    if (MUD->hasUsers())
+      MUD->replaceAllUsesWith(MUD->getDefiningAccess());
+    MUD->setDefiningAccess(nullptr);
+    ValueToMemoryAccess.erase(MUD->getMemoryInst());
+  } else {
+    auto *Phi = cast<MemoryPhi>(MA);
+    if (Phi->hasUsers()) {
+      MemoryAccess *Replacement = nullptr;
+      for (unsigned I = 0, E = Phi->getNumIncomingValues(); I != E; ++I) {
+        MemoryAccess *Incoming = Phi->getIncomingValue(I);
+        if (Incoming == Phi)
+          continue;
+        assert((!Replacement || Replacement == Incoming) &&
+               "removing a phi that merges different versions of memory");
+        Replacement = Incoming;
+      }
+      Phi->replaceAllUsesWith(Replacement);
+    }
+    for (auto &Op : Phi->Operands)
+      Op.second->removeUser(Phi);
+    Phi->Operands.clear();
+    ValueToMemoryAccess.erase(Phi->getBlock());
+  }
+
+  auto ListIt = PerBlockAccesses.find(MA->getBlock());
+  ListIt->second->erase(findInBlock(MA));
+  if (ListIt->second->empty())
+    PerBlockAccesses.erase(ListIt);
+  delete MA;
+}
+
+bool MemorySSA::locallyDominates(const MemoryAccess *A,
+                                 const MemoryAccess *B) const {
+  assert(A->getBlock() == B->getBlock() &&
+         "asking about the local dominance of accesses in different blocks");
+  if (A == B || isLiveOnEntryDef(A))
+    return true;
+  if (isLiveOnEntryDef(B))
+    return false;
+  for (const MemoryAccess *MA : *getBlockAccesses(A->getBlock())) {
+    if (MA == A)
+      return true;
+    if (MA == B)
+      return false;
+  }
+  llvm_unreachable("accesses are not in their block");
+}
+
+bool MemorySSA::dominates(const MemoryAccess *A, const MemoryAccess *B) const {
+  if (A == B || isLiveOnEntryDef(A))
+    return true;
+  if (isLiveOnEntryDef(B))
+    return false;
+  if (A->getBlock() != B->getBlock())
+    return DT->dominates(A->getBlock(), B->getBlock());
+  return locallyDominates(A, B);
+}
+
+void MemorySSA::verifyMemorySSA() const {
+  // Users of each access, to check against the lists the accesses keep.
+  DenseMap<const MemoryAccess *, SmallVector<const MemoryAccess *, 4>> Uses;
+
+  for (BasicBlock &BB : F) {
+    const AccessListType *Accesses = getBlockAccesses(&BB);
+    MemoryPhi *Phi = getMemoryAccess(&BB);
+    bool Reachable = DT->isReachableFromEntry(&BB);
+
+    // The block starts with its phi, then has the accesses of its
+    // instructions in program order.
+    auto MAI = Accesses ? Accesses->begin() : AccessListType::const_iterator();
+    if (Phi) {
+      assert(Accesses && *MAI == Phi && "phi is not first in its block");
+      ++MAI;
+      SmallVector<BasicBlock *, 8> Preds(pred_begin(&BB), pred_end(&BB));
+      SmallVector<BasicBlock *, 8> Incoming;
+      for (unsigned I = 0, E = Phi->getNumIncomingValues(); I != E; ++I) {
+        BasicBlock *Pred = Phi->getIncomingBlock(I);
+        MemoryAccess *Val = Phi->getIncomingValue(I);
+        Incoming.push_back(Pred);
+        Uses[Val].push_back(Phi);
+        assert((!DT->isReachableFromEntry(Pred) || isLiveOnEntryDef(Val) ||
+                DT->dominates(Val->getBlock(), Pred)) &&
+               "incoming value does not dominate its edge");
+      }
+      std::sort(Preds.begin(), Preds.end());
+      std::sort(Incoming.begin(), Incoming.end());
+      assert(Preds == Incoming && "phi does not match the predecessors");
+    }
+    for (Instruction &I : BB) {
+      MemoryUseOrDef *MUD = getMemoryAccess(&I);
+      if (!MUD)
+        continue;
+      assert(Accesses && MAI != Accesses->end() && *MAI == MUD &&
+             "accesses are not in program order");
+      assert(MUD->getBlock() == &BB && "access is not in its block");
+      ++MAI;
+      MemoryAccess *Def = MUD->getDefiningAccess();
+      assert(Def && "access has no defining access");
+      assert((!Reachable || dominates(Def, MUD)) &&
+             "defining access does not dominate its use");
+      Uses[Def].push_back(MUD);
+    }
+    assert((!Accesses || MAI == Accesses->end()) &&
+           "block has accesses of no instruction");
+    (void)MAI;
+    (void)Phi;
+    (void)Reachable;
+  }
+
+  auto CheckUsers = [&](const MemoryAccess *MA) {
+    SmallVector<const MemoryAccess *, 4> Expected = Uses.lookup(MA);
+    SmallVector<const MemoryAccess *, 4> Actual(MA->users().begin(),
+                                                MA->users().end());
+    std::sort(Expected.begin(), Expected.end());
+    std::sort(Actual.begin(), Actual.end());
+    assert(Expected == Actual && "users of an access are out of date");
+    (void)Expected;
+    (void)Actual;
+  };
+  CheckUsers(LiveOnEntryDef.get());
+  for (auto &BlockAccesses : PerBlockAccesses)
+    for (const MemoryAccess *MA : *BlockAccesses.second)
+      CheckUsers(MA);
+}
+
+namespace {
+/// Prints the accesses of Memory SSA as comments before their instructions.
+class MemorySSAAnnotatedWriter : public AssemblyAnnotationWriter {
+  const MemorySSA &MSSA;
+
+public:
+  explicit MemorySSAAnnotatedWriter(const MemorySSA &MSSA) : MSSA(MSSA) {}
+
+  void emitBasicBlockStartAnnot(const BasicBlock *BB,
+                                formatted_raw_ostream &OS) override {
+    if (MemoryPhi *Phi = MSSA.getMemoryAccess(BB))
+      OS << "; " << *Phi << '\n';
+  }
+
+  void emitInstructionAnnot(const Instruction *I,
+                            formatted_raw_ostream &OS) override {
+    if (MemoryUseOrDef *MUD = MSSA.getMemoryAccess(I))
+      OS << "; " << *MUD << '\n';
+  }
+};
+} // end anonymous namespace
+
+void MemorySSA::print(raw_ostream &OS) const {
+  MemorySSAAnnotatedWriter Writer(*this);
+  F.print(OS, &Writer);
+}
+
+void MemorySSA::dump() const { print(dbgs()); }
+
+//===----------------------------------------------------------------------===//
+// MemorySSAWalker implementations
+//===----------------------------------------------------------------------===//
+
+MemorySSAWalker::~MemorySSAWalker() {}
+
+MemoryAccess *
+DoNothingMemorySSAWalker::getClobberingMemoryAccess(const Instruction *I) {
+  MemoryUseOrDef *MUD = MSSA->getMemoryAccess(I);
+  return MUD ? MUD->getDefiningAccess() : nullptr;
+}
+
+MemoryAccess *DoNothingMemorySSAWalker::getClobberingMemoryAccess(
+    MemoryAccess *StartingAccess, const AliasAnalysis::Location &) {
+  if (auto *Use = dyn_cast<MemoryUse>(StartingAccess))
+    return Use->getDefiningAccess();
+  return StartingAccess;
+}
+
+/// The state of one clobber query.
+struct CachingMemorySSAWalker::WalkState {
+  AliasAnalysis::Location Loc;
+  unsigned Budget;
+  /// The answer for each phi of the walk, or null while its incoming values
+  /// are being walked.
+  DenseMap<const MemoryPhi *, MemoryAccess *> PhiClobbers;
+  /// The depth of each phi being walked, and the lowest one that the current
+  /// walk looped back to.  A phi whose answer assumed that a phi above it
+  /// adds no clobber is walked again when reached after that phi is done.
+  DenseMap<const MemoryPhi *, unsigned> PhiDepths;
+  unsigned LowestLoop;
+
+  WalkState(const AliasAnalysis::Location &Loc)
+      : Loc(Loc), Budget(MaxCheckLimit), LowestLoop(~0U) {}
+};
+
+CachingMemorySSAWalker::CachingMemorySSAWalker(MemorySSA *MSSA,
+                                               AliasAnalysis *AA)
+    : MemorySSAWalker(MSSA), AA(AA) {}
+
+CachingMemorySSAWalker::~CachingMemorySSAWalker() {}
+
+/// Walk up from \p MA, inclusive, to the nearest access that may write the
+/// location of the query.  Return null if the walk loops back to a phi being
+/// walked without finding one, so that the path adds nothing to that phi.
+MemoryAccess *CachingMemorySSAWalker::walk(MemoryAccess *MA,
+                                           WalkState &State) {
+  while (true) {
+    if (MSSA->isLiveOnEntryDef(MA))
+      return MA;
+    if (auto *Phi = dyn_cast<MemoryPhi>(MA))
+      return walkPhi(Phi, State);
+    auto *MUD = cast<MemoryUseOrDef>(MA);
+    if (isa<MemoryDef>(MUD)) {
+      // Out of budget, the access reached is a conservative answer.
+      if (State.Budget == 0)
+        return MUD;
+      --State.Budget;
+      if (AA->getModRefInfo(MUD->getMemoryInst(), State.Loc) &
+          AliasAnalysis::Mod)
+        return MUD;
+    }
+    MA = MUD->getDefiningAccess();
+  }
+}
+
+/// The clobber of a phi is the clobber all its incoming paths agree on, or
+/// the phi itself.
+MemoryAccess *CachingMemorySSAWalker::walkPhi(MemoryPhi *Phi,
+                                              WalkState &State) {
+  auto Known = State.PhiClobbers.find(Phi);
+  if (Known != State.PhiClobbers.end()) {
+    if (!Known->second)
+      State.LowestLoop = std::min(State.LowestLoop, State.PhiDepths[Phi]);
+    return Known->second;
+  }
+  if (State.Budget == 0)
+    return Phi;
+  --State.Budget;
+
+  unsigned Depth = State.PhiDepths.size();
+  State.PhiDepths[Phi] = Depth;
+  State.PhiClobbers[Phi] = nullptr;
+  unsigned OuterLowestLoop = State.LowestLoop;
+  State.LowestLoop = ~0U;
+
+  MemoryAccess *Result = nullptr;
+  for (unsigned I = 0, E = Phi->getNumIncomingValues(); I != E; ++I) {
+    MemoryAccess *Clobber = walk(Phi->getIncomingValue(I), State);
+    if (!Clobber)
+      continue;
+    if (!Result) {
+      Result = Clobber;
+    } else if (Result != Clobber) {
+      Result = Phi;
+      break;
+    }
+  }
+  State.PhiDepths.erase(Phi);
+  bool Tentative = State.LowestLoop < Depth;
+  // Without a clobber on any path, an answer that holds for the phis above
+  // stays null, so that it adds nothing to them either.
+  if (!Result && !Tentative)
+    Result = Phi;
+  if (Tentative) {
+    // The answer holds while the phis above are being walked only.
+    State.PhiClobbers.erase(Phi);
+    State.LowestLoop = std::min(State.LowestLoop, OuterLowestLoop);
+  } else {
+    State.PhiClobbers[Phi] = Result;
+    State.LowestLoop = OuterLowestLoop;
+  }
+  return Result;
+}
+
+MemoryAccess *
+CachingMemorySSAWalker::getClobberingMemoryAccess(const Instruction *I) {
+  MemoryUseOrDef *MUD = MSSA->getMemoryAccess(I);
+  if (!MUD)
+    return nullptr;
+
+  // Only simple loads and stores access a single known location.
+  AliasAnalysis::Location Loc;
+  if (auto *LI = dyn_cast<LoadInst>(I)) {
+    if (!LI->isUnordered())
+      return MUD->getDefiningAccess();
+    Loc = AA->getLocation(LI);
+  } else if (auto *SI = dyn_cast<StoreInst>(I)) {
+    if (!SI->isUnordered())
+      return MUD->getDefiningAccess();
+    Loc = AA->getLocation(SI);
+  } else {
+    return MUD->getDefiningAccess();
+  }
+
+  ++NumClobberCacheLookups;
+  auto Cached = CachedAccessClobbers.find(MUD);
+  if (Cached != CachedAccessClobbers.end()) {
+    ++NumClobberCacheHits;
+    return Cached->second;
+  }
+
+  WalkState State(Loc);
+  MemoryAccess *Result = walk(MUD->getDefiningAccess(), State);
+  assert(Result && "walk from an instruction did not find a clobber");
+  CachedAccessClobbers[MUD] = Result;
+  return Result;
+}
+
+MemoryAccess *CachingMemorySSAWalker::getClobberingMemoryAccess(
+    MemoryAccess *StartingAccess, const AliasAnalysis::Location &Loc) {
+  ++NumClobberCacheLookups;
+  auto Key = std::make_pair(const_cast<const MemoryAccess *>(StartingAccess),
+                            Loc);
+  auto Cached = CachedLocationClobbers.find(Key);
+  if (Cached != CachedLocationClobbers.end()) {
+    ++NumClobberCacheHits;
+    return Cached->second;
+  }
+
+  WalkState State(Loc);
+  MemoryAccess *Result = walk(StartingAccess, State);
+  assert(Result && "walk from an access did not find a clobber");
+  CachedLocationClobbers[Key] = Result;
+  return Result;
+}
+
+void CachingMemorySSAWalker::invalidateInfo(MemoryAccess *) {
+  // A change anywhere above a query may change its answer.
+  CachedAccessClobbers.clear();
+  CachedLocationClobbers.clear();
+}
+
+//===----------------------------------------------------------------------===//
+// MemorySSAWrapperPass implementation
+//===----------------------------------------------------------------------===//
+
+char MemorySSAWrapperPass::ID = 0;
+
+INITIALIZE_PASS_BEGIN(MemorySSAWrapperPass, "memoryssa", "Memory SSA", false,
+                      true)
+INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
+INITIALIZE_AG_DEPENDENCY(AliasAnalysis)
+INITIALIZE_PASS_END(MemorySSAWrapperPass, "memoryssa", "Memory SSA", false,
+                    true)
+
+MemorySSAWrapperPass::MemorySSAWrapperPass() : FunctionPass(ID) {
+  initializeMemorySSAWrapperPassPass(*PassRegistry::getPassRegistry());
+}
+
+void MemorySSAWrapperPass::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.setPreservesAll();
+  AU.addRequiredTransitive<DominatorTreeWrapperPass>();
+  AU.addRequiredTransitive<AliasAnalysis>();
+}
+
+bool MemorySSAWrapperPass::runOnFunction(Function &F) {
+  MSSA.reset(new MemorySSA(F, &getAnalysis<AliasAnalysis>(),
+                           &getAnalysis<DominatorTreeWrapperPass>().getDomTree()));
+  return false;
+}
+
+void MemorySSAWrapperPass::releaseMemory() { MSSA.reset(); }
+
+void MemorySSAWrapperPass::verifyAnalysis() const { MSSA->verifyMemorySSA(); }
+
+void MemorySSAWrapperPass::print(raw_ostream &OS, const Module *) const {
+  MSSA->print(OS);
+}
@@ -75,6 +75,8 @@ namespace {
     void deleteValue(Value *V) override {}
     void copyValue(Value *From, Value *To) override {}
     void addEscapingUse(Use &U) override {}
+    void beginBatchQueries() override {}
+    void endBatchQueries() override {}
 
     /// getAdjustedAnalysisPointer - This method is used when a pass implements
     /// an analysis interface through multiple inheritance.  If needed, it
@@ -94,7 +94,8 @@ bool RGPassManager::runOnFunction(Function &F) {
       {
         PassManagerPrettyStackEntry X(P, *CurrentRegion->getEntry());
 
-        TimeRegion PassTimer(getPassTimer(P));
+        PassExecutionTimer PassTimer(P,
+                                     *CurrentRegion->getEntry()->getParent());
         Changed |= P->runOnRegion(CurrentRegion, *this);
       }
 
@@ -87,6 +87,7 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/SaveAndRestore.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 using namespace llvm;
@@ -101,6 +102,11 @@ STATISTIC(NumTripCountsNotComputed,
           "Number of loops without predictable loop counts");
 STATISTIC(NumBruteForceTripCountsComputed,
           "Number of loops with trip counts computed by force");
+STATISTIC(NumSCEVsCreated, "Number of SCEV expressions created");
+STATISTIC(NumArithBudgetExceeded,
+          "Number of add and mul expressions left unsimplified for budget");
+STATISTIC(NumCompareBudgetExceeded,
+          "Number of expression comparisons cut short for budget");
 
 static cl::opt<unsigned>
 MaxBruteForceIterations("scalar-evolution-max-iterations", cl::ReallyHidden,
@@ -109,6 +115,24 @@ MaxBruteForceIterations("scalar-evolution-max-iterations", cl::ReallyHidden,
                                  "derived loop"),
                         cl::init(100));
 
+static cl::opt<unsigned>
+MaxArithDepth("scalar-evolution-max-arith-depth", cl::Hidden,
+              cl::desc("Maximum depth of nested add and mul expressions "
+                       "that SCEV simplifies"),
+              cl::init(32));
+
+static cl::opt<unsigned>
+MaxArithOps("scalar-evolution-max-arith-ops", cl::Hidden,
+            cl::desc("Maximum number of operands of an add or mul "
+                     "expression that SCEV simplifies"),
+            cl::init(256));
+
+static cl::opt<unsigned>
+MaxCompareDepth("scalar-evolution-max-compare-depth", cl::Hidden,
+                cl::desc("Maximum depth to which SCEV compares expressions "
+                         "when putting operands in canonical order"),
+                cl::init(32));
+
 // FIXME: Enable this with XDEBUG when the test suite is clean.
 static cl::opt<bool>
 VerifySCEV("verify-scev",
@@ -465,17 +489,25 @@ namespace {
 
     // Return true or false if LHS is less than, or at least RHS, respectively.
     bool operator()(const SCEV *LHS, const SCEV *RHS) const {
-      return compare(LHS, RHS) < 0;
+      return compare(LHS, RHS, 0) < 0;
     }
 
     // Return negative, zero, or positive, if LHS is less than, equal to, or
     // greater than RHS, respectively. A three-way result allows recursive
     // comparisons to be more efficient.
-    int compare(const SCEV *LHS, const SCEV *RHS) const {
+    int compare(const SCEV *LHS, const SCEV *RHS, unsigned Depth) const {
       // Fast-path: SCEVs are uniqued so we can do a quick equality check.
       if (LHS == RHS)
         return 0;
 
+      // Shared subexpressions make the comparison of deep expressions take
+      // exponential time.  Past the budget, they are only sorted by kind.
+      if (Depth > MaxCompareDepth) {
+        ++NumCompareBudgetExceeded;
+        return (int)LHS->getSCEVType() - (int)RHS->getSCEVType();
+      }
+      ++Depth;
+
       // Primarily, sort the SCEVs by their getSCEVType().
       unsigned LType = LHS->getSCEVType(), RType = RHS->getSCEVType();
       if (LType != RType)
@@ -570,7 +602,7 @@ namespace {
 
         // Lexicographically compare.
         for (unsigned i = 0; i != LNumOps; ++i) {
-          long X = compare(LA->getOperand(i), RA->getOperand(i));
+          long X = compare(LA->getOperand(i), RA->getOperand(i), Depth);
           if (X != 0)
             return X;
         }
@@ -593,7 +625,7 @@ namespace {
         for (unsigned i = 0; i != LNumOps; ++i) {
           if (i >= RNumOps)
             return 1;
-          long X = compare(LC->getOperand(i), RC->getOperand(i));
+          long X = compare(LC->getOperand(i), RC->getOperand(i), Depth);
           if (X != 0)
             return X;
         }
@@ -605,10 +637,10 @@ namespace {
         const SCEVUDivExpr *RC = cast<SCEVUDivExpr>(RHS);
 
         // Lexicographically compare udiv expressions.
-        long X = compare(LC->getLHS(), RC->getLHS());
+        long X = compare(LC->getLHS(), RC->getLHS(), Depth);
         if (X != 0)
           return X;
-        return compare(LC->getRHS(), RC->getRHS());
+        return compare(LC->getRHS(), RC->getRHS(), Depth);
       }
 
       case scTruncate:
@@ -618,7 +650,7 @@ namespace {
         const SCEVCastExpr *RC = cast<SCEVCastExpr>(RHS);
 
         // Compare cast expressions by operand.
-        return compare(LC->getOperand(), RC->getOperand());
+        return compare(LC->getOperand(), RC->getOperand(), Depth);
       }
 
       case scCouldNotCompute:
@@ -1821,6 +1853,9 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
   // Sort by complexity, this groups all similar expression types together.
   GroupByComplexity(Ops, LI);
 
+  // The expressions built while simplifying this one are one level deeper.
+  SaveAndRestore<unsigned> NestArithDepth(ArithDepth, ArithDepth + 1);
+
   // If there are any constants, fold them together.
   unsigned Idx = 0;
   if (const SCEVConstant *LHSC = dyn_cast<SCEVConstant>(Ops[0])) {
@@ -1844,6 +1879,13 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
     if (Ops.size() == 1) return Ops[0];
   }
 
+  // Deeply nested or very wide expressions take super-linear time to
+  // simplify, so past the budget they are only uniqued.
+  if (ArithDepth > MaxArithDepth || Ops.size() > MaxArithOps) {
+    ++NumArithBudgetExceeded;
+    return getOrCreateAddExpr(Ops, Flags);
+  }
+
   // Okay, check to see if the same value occurs in the operand list more than
   // once.  If so, merge them together into an multiply expression.  Since we
   // sorted the list, these values are required to be adjacent.
@@ -2141,6 +2183,12 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
 
   // Okay, it looks like we really DO need an add expr.  Check to see if we
   // already have one, otherwise create a new one.
+  return getOrCreateAddExpr(Ops, Flags);
+}
+
+const SCEV *
+ScalarEvolution::getOrCreateAddExpr(SmallVectorImpl<const SCEV *> &Ops,
+                                     SCEV::NoWrapFlags Flags) {
   FoldingSetNodeID ID;
   ID.AddInteger(scAddExpr);
   for (unsigned i = 0, e = Ops.size(); i != e; ++i)
@@ -2230,6 +2278,9 @@ const SCEV *ScalarEvolution::getMulExpr(SmallVectorImpl<const SCEV *> &Ops,
   // Sort by complexity, this groups all similar expression types together.
   GroupByComplexity(Ops, LI);
 
+  // The expressions built while simplifying this one are one level deeper.
+  SaveAndRestore<unsigned> NestArithDepth(ArithDepth, ArithDepth + 1);
+
   // If there are any constants, fold them together.
   unsigned Idx = 0;
   if (const SCEVConstant *LHSC = dyn_cast<SCEVConstant>(Ops[0])) {
@@ -2297,6 +2348,13 @@ const SCEV *ScalarEvolution::getMulExpr(SmallVectorImpl<const SCEV *> &Ops,
       return Ops[0];
   }
 
+  // Deeply nested or very wide expressions take super-linear time to
+  // simplify, so past the budget they are only uniqued.
+  if (ArithDepth > MaxArithDepth || Ops.size() > MaxArithOps) {
+    ++NumArithBudgetExceeded;
+    return getOrCreateMulExpr(Ops, Flags);
+  }
+
   // Skip over the add expression until we get to a multiply.
   while (Idx < Ops.size() && Ops[Idx]->getSCEVType() < scMulExpr)
     ++Idx;
@@ -2438,6 +2496,12 @@ const SCEV *ScalarEvolution::getMulExpr(SmallVectorImpl<const SCEV *> &Ops,
 
   // Okay, it looks like we really DO need an mul expr.  Check to see if we
   // already have one, otherwise create a new one.
+  return getOrCreateMulExpr(Ops, Flags);
+}
+
+const SCEV *
+ScalarEvolution::getOrCreateMulExpr(SmallVectorImpl<const SCEV *> &Ops,
+                                     SCEV::NoWrapFlags Flags) {
   FoldingSetNodeID ID;
   ID.AddInteger(scMulExpr);
   for (unsigned i = 0, e = Ops.size(); i != e; ++i)
@@ -7865,7 +7929,7 @@ ScalarEvolution::SCEVCallbackVH::SCEVCallbackVH(Value *V, ScalarEvolution *se)
 
 ScalarEvolution::ScalarEvolution()
   : FunctionPass(ID), ValuesAtScopes(64), LoopDispositions(64),
-    BlockDispositions(64), FirstUnknown(nullptr) {
+    BlockDispositions(64), ArithDepth(0), FirstUnknown(nullptr) {
   initializeScalarEvolutionPass(*PassRegistry::getPassRegistry());
 }
 
@@ -7879,6 +7943,13 @@ bool ScalarEvolution::runOnFunction(Function &F) {
 }
 
 void ScalarEvolution::releaseMemory() {
+  if (!UniqueSCEVs.empty()) {
+    NumSCEVsCreated += UniqueSCEVs.size();
+    DEBUG(dbgs() << "SCEV: " << UniqueSCEVs.size() << " expressions for "
+                 << ValueExprMap.size() << " values in " << F->getName()
+                 << ", " << SCEVAllocator.getTotalMemory() << " bytes\n");
+  }
+
   // Iterate through all the SCEVUnknown instances and call their
   // destructors, so that they release their references to their values.
   for (SCEVUnknown *U = FirstUnknown; U; U = U->Next)
@@ -19,6 +19,7 @@
 #include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/DiagnosticPrinter.h"
+#include "llvm/IR/FunctionInfo.h"
 #include "llvm/IR/GVMaterializer.h"
 #include "llvm/IR/InlineAsm.h"
 #include "llvm/IR/IntrinsicInst.h"
@@ -28,6 +29,7 @@
 #include "llvm/IR/Operator.h"
 #include "llvm/IR/ValueHandle.h"
 #include "llvm/Support/DataStream.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -188,6 +190,14 @@ class BitcodeReader : public GVMaterializer {
   /// stream.
   DenseMap<Function*, uint64_t> DeferredFunctionInfo;
 
+  /// The positions of the function blocks and of their end, read from the
+  /// MODULE_CODE_FUNCTION_INDEX record when the bitcode has one.
+  std::vector<uint64_t> FunctionIndex;
+
+  /// The strings of the module, from the MODULE_CODE_STRTAB records, which the
+  /// metadata strings and the symbol tables refer to.
+  std::string StringTable;
+
   /// When Metadata block is initially scanned when parsing the module, we may
   /// choose to defer parsing of the metadata. This vector contains info about
   /// which Metadata blocks are deferred.
@@ -476,6 +486,8 @@ void BitcodeReader::FreeState() {
   std::vector<BasicBlock*>().swap(FunctionBBs);
   std::vector<Function*>().swap(FunctionsWithBodies);
   DeferredFunctionInfo.clear();
+  std::vector<uint64_t>().swap(FunctionIndex);
+  std::string().swap(StringTable);
   DeferredMetadataInfo.clear();
   MDKindMap.clear();
 
@@ -500,6 +512,20 @@ static bool ConvertToString(ArrayRef<uint64_t> Record, unsigned Idx,
   return false;
 }
 
+/// Set \p Result to the string of \p StringTable whose offset and size are the
+/// operands \p Idx and \p Idx + 1 of \p Record, return true on failure.
+static bool ReadStringTableEntry(ArrayRef<uint64_t> Record, unsigned Idx,
+                                 StringRef StringTable, StringRef &Result) {
+  if (Idx + 2 > Record.size())
+    return true;
+
+  uint64_t Offset = Record[Idx], Size = Record[Idx + 1];
+  if (Offset > StringTable.size() || Size > StringTable.size() - Offset)
+    return true;
+  Result = StringTable.substr(Offset, Size);
+  return false;
+}
+
 static bool hasImplicitComdat(size_t Val) {
   switch (Val) {
   default:
@@ -1493,18 +1519,25 @@ std::error_code BitcodeReader::ParseValueSymbolTable() {
 
     // Read a record.
     Record.clear();
-    switch (Stream.readRecord(Entry.ID, Record)) {
+    unsigned Code = Stream.readRecord(Entry.ID, Record);
+    switch (Code) {
     default:  // Default behavior: unknown type.
       break;
-    case bitc::VST_CODE_ENTRY: {  // VST_ENTRY: [valueid, namechar x N]
-      if (ConvertToString(Record, 1, ValueName))
+    case bitc::VST_CODE_ENTRY:          // VST_ENTRY: [valueid, namechar x N]
+    case bitc::VST_CODE_STRTAB_ENTRY: { // [valueid, offset, size]
+      StringRef Name;
+      if (Code == bitc::VST_CODE_ENTRY) {
+        if (ConvertToString(Record, 1, ValueName))
+          return Error("Invalid record");
+        Name = ValueName;
+      } else if (ReadStringTableEntry(Record, 1, StringTable, Name))
         return Error("Invalid record");
       unsigned ValueID = Record[0];
       if (ValueID >= ValueList.size() || !ValueList[ValueID])
         return Error("Invalid record");
       Value *V = ValueList[ValueID];
 
-      V->setName(StringRef(ValueName.data(), ValueName.size()));
+      V->setName(Name);
       if (auto *GO = dyn_cast<GlobalObject>(V)) {
         if (GO->getComdat() == reinterpret_cast<Comdat *>(1)) {
           if (TT.isOSBinFormatMachO())
@@ -1516,14 +1549,20 @@ std::error_code BitcodeReader::ParseValueSymbolTable() {
       ValueName.clear();
       break;
     }
-    case bitc::VST_CODE_BBENTRY: {
-      if (ConvertToString(Record, 1, ValueName))
+    case bitc::VST_CODE_BBENTRY:          // VST_BBENTRY: [bbid, namechar x N]
+    case bitc::VST_CODE_STRTAB_BBENTRY: { // [bbid, offset, size]
+      StringRef Name;
+      if (Code == bitc::VST_CODE_BBENTRY) {
+        if (ConvertToString(Record, 1, ValueName))
+          return Error("Invalid record");
+        Name = ValueName;
+      } else if (ReadStringTableEntry(Record, 1, StringTable, Name))
         return Error("Invalid record");
       BasicBlock *BB = getBasicBlock(Record[0]);
       if (!BB)
         return Error("Invalid record");
 
-      BB->setName(StringRef(ValueName.data(), ValueName.size()));
+      BB->setName(Name);
       ValueName.clear();
       break;
     }
@@ -1783,14 +1822,13 @@ std::error_code BitcodeReader::ParseMetadata() {
         return Error("Invalid record");
 
       MDValueList.AssignValue(
-          GET_OR_DISTINCT(DICompositeType, Record[0],
-                          (Context, Record[1], getMDString(Record[2]),
-                           getMDOrNull(Record[3]), Record[4],
-                           getMDOrNull(Record[5]), getMDOrNull(Record[6]),
-                           Record[7], Record[8], Record[9], Record[10],
-                           getMDOrNull(Record[11]), Record[12],
-                           getMDOrNull(Record[13]), getMDOrNull(Record[14]),
-                           getMDString(Record[15]))),
+          DICompositeType::getODRType(
+              Context, Record[0], Record[1], getMDString(Record[2]),
+              getMDOrNull(Record[3]), Record[4], getMDOrNull(Record[5]),
+              getMDOrNull(Record[6]), Record[7], Record[8], Record[9],
+              Record[10], getMDOrNull(Record[11]), Record[12],
+              getMDOrNull(Record[13]), getMDOrNull(Record[14]),
+              getMDString(Record[15])),
           NextMDValueNo++);
       break;
     }
@@ -2006,6 +2044,21 @@ std::error_code BitcodeReader::ParseMetadata() {
       MDValueList.AssignValue(MD, NextMDValueNo++);
       break;
     }
+    case bitc::METADATA_STRINGS: { // [n x size]
+      // The strings are at the start of the string table.
+      std::string String;
+      uint64_t Offset = 0;
+      for (uint64_t Size : Record) {
+        if (Size > StringTable.size() - Offset)
+          return Error("Invalid record");
+        String.assign(StringTable, Offset, Size);
+        Offset += Size;
+        llvm::UpgradeMDStringConstant(String);
+        Metadata *MD = MDString::get(Context, String);
+        MDValueList.AssignValue(MD, NextMDValueNo++);
+      }
+      break;
+    }
     case bitc::METADATA_KIND: {
       if (Record.size() < 2)
         return Error("Invalid record");
@@ -2774,6 +2827,21 @@ std::error_code BitcodeReader::ParseModule(bool Resume,
           SeenFirstFunctionBody = true;
         }
 
+        // With an index of the function blocks, remember all of them at once
+        // and jump past them, rather than skipping them one by one. Only the
+        // blocks that are materialized are then ever read.
+        if (!LazyStreamer && !FunctionIndex.empty()) {
+          if (FunctionIndex.size() != FunctionsWithBodies.size() + 1)
+            return Error("Invalid function index");
+          for (unsigned I = 0, E = FunctionsWithBodies.size(); I != E; ++I)
+            DeferredFunctionInfo[FunctionsWithBodies[E - 1 - I]] =
+                FunctionIndex[I];
+          FunctionsWithBodies.clear();
+          Stream.JumpToBit(FunctionIndex.back());
+          FunctionIndex.clear();
+          break;
+        }
+
         if (std::error_code EC = RememberAndSkipFunctionBody())
           return EC;
         // For streaming bitcode, suspend parsing when we reach the function
@@ -2801,7 +2869,8 @@ std::error_code BitcodeReader::ParseModule(bool Resume,
 
 
     // Read a record.
-    switch (Stream.readRecord(Entry.ID, Record)) {
+    StringRef Blob;
+    switch (Stream.readRecord(Entry.ID, Record, &Blob)) {
     default: break;  // Default behavior, ignore unknown content.
     case bitc::MODULE_CODE_VERSION: {  // VERSION: [version#]
       if (Record.size() < 1)
@@ -2863,6 +2932,34 @@ std::error_code BitcodeReader::ParseModule(bool Resume,
       GCTable.push_back(S);
       break;
     }
+    case bitc::MODULE_CODE_STRTAB: { // STRTAB: [strchr x N] or [blob]
+      // Each record appends to the table.
+      if (Record.empty()) {
+        StringTable.append(Blob.begin(), Blob.end());
+        break;
+      }
+      StringTable.reserve(StringTable.size() + Record.size());
+      for (uint64_t C : Record)
+        StringTable.push_back(char(C));
+      break;
+    }
+    case bitc::MODULE_CODE_FUNCTION_INDEX: { // FUNCTION_INDEX: [blob]
+      if (Blob.size() % 8)
+        return Error("Invalid record");
+      // The blob is 32-bit aligned and its size is a multiple of 4, so the
+      // record ends with it.
+      uint64_t BlobBit = Stream.GetCurrentBitNo() - Blob.size() * 8;
+      FunctionIndex.clear();
+      for (const char *I = Blob.begin(), *E = Blob.end(); I != E; I += 8) {
+        uint64_t Bit =
+            BlobBit + support::endian::read<uint64_t, support::little,
+                                            support::unaligned>(I);
+        if (!Stream.canSkipToPos(Bit / 8))
+          return Error("Invalid function index");
+        FunctionIndex.push_back(Bit);
+      }
+      break;
+    }
     case bitc::MODULE_CODE_COMDAT: { // COMDAT: [selection_kind, name]
       if (Record.size() < 2)
         return Error("Invalid record");
@@ -4473,6 +4570,10 @@ class BitcodeErrorCategoryType : public std::error_category {
       return "Invalid bitcode signature";
     case BitcodeError::CorruptedBitcode:
       return "Corrupted bitcode";
+    case BitcodeError::NoFunctionSummary:
+      return "No function summary";
+    case BitcodeError::NoSymbolTable:
+      return "No symbol table";
     }
     llvm_unreachable("Unknown error type!");
   }
@@ -4579,3 +4680,243 @@ llvm::getBitcodeTargetTriple(MemoryBufferRef Buffer, LLVMContext &Context,
     return "";
   return Triple.get();
 }
+
+//===----------------------------------------------------------------------===//
+// Function summaries and symbol tables
+//===----------------------------------------------------------------------===//
+
+static std::error_code
+topLevelError(DiagnosticHandlerFunction DiagnosticHandler, BitcodeError E,
+              const Twine &Message) {
+  std::error_code EC = make_error_code(E);
+  if (DiagnosticHandler) {
+    BitcodeDiagnosticInfo DI(EC, DS_Error, Message);
+    DiagnosticHandler(DI);
+  }
+  return EC;
+}
+
+/// Advance \p Stream to the top-level block \p BlockID, skipping over the
+/// module and any other top-level block. Return false if there is no such
+/// block.
+static ErrorOr<bool>
+findTopLevelBlock(BitstreamCursor &Stream, unsigned BlockID,
+                  DiagnosticHandlerFunction DiagnosticHandler) {
+  // Sniff for the signature.
+  if (Stream.Read(8) != 'B' || Stream.Read(8) != 'C' ||
+      Stream.Read(4) != 0x0 || Stream.Read(4) != 0xC ||
+      Stream.Read(4) != 0xE || Stream.Read(4) != 0xD)
+    return topLevelError(DiagnosticHandler,
+                         BitcodeError::InvalidBitcodeSignature,
+                         "Invalid bitcode signature");
+
+  while (!Stream.AtEndOfStream()) {
+    BitstreamEntry Entry = Stream.advance();
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+    case BitstreamEntry::EndBlock:
+    case BitstreamEntry::Record:
+      return topLevelError(DiagnosticHandler, BitcodeError::CorruptedBitcode,
+                           "Malformed block");
+    case BitstreamEntry::SubBlock:
+      if (Entry.ID == BlockID)
+        return true;
+      if (Stream.SkipBlock())
+        return topLevelError(DiagnosticHandler, BitcodeError::CorruptedBitcode,
+                             "Malformed block");
+      break;
+    }
+  }
+  return false;
+}
+
+/// Parse the function summary block \p Stream is positioned at into \p Index.
+static std::error_code
+parseFunctionSummaryBlock(BitstreamCursor &Stream, StringRef Identifier,
+                          FunctionInfoIndex &Index,
+                          DiagnosticHandlerFunction DiagnosticHandler) {
+  auto malformed = [&]() {
+    return topLevelError(DiagnosticHandler, BitcodeError::CorruptedBitcode,
+                         "Invalid function summary record");
+  };
+  if (Stream.EnterSubBlock(bitc::FUNCTION_SUMMARY_BLOCK_ID))
+    return malformed();
+
+  std::vector<std::string> Names;
+  SmallVector<uint64_t, 64> Record;
+  while (1) {
+    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+    switch (Entry.Kind) {
+    case BitstreamEntry::SubBlock: // Handled for us already.
+    case BitstreamEntry::Error:
+      return malformed();
+    case BitstreamEntry::EndBlock:
+      return std::error_code();
+    case BitstreamEntry::Record:
+      // The interesting case.
+      break;
+    }
+
+    Record.clear();
+    switch (Stream.readRecord(Entry.ID, Record)) {
+    default: // Default behavior: ignore.
+      break;
+    case bitc::FS_CODE_MODULE: { // MODULE: [strchr x N]
+      std::string Path;
+      if (ConvertToString(Record, 0, Path))
+        return malformed();
+      Index.addModule(Path);
+      break;
+    }
+    case bitc::FS_CODE_NAME: { // NAME: [strchr x N]
+      std::string Name;
+      if (ConvertToString(Record, 0, Name))
+        return malformed();
+      Names.push_back(std::move(Name));
+      break;
+    }
+    case bitc::FS_CODE_FUNCTION: {
+      // FUNCTION: [module, name, linkage, instcount, referstolocal,
+      //            callee name...]
+      if (Record.size() < 5)
+        return malformed();
+      // The summaries written next to a module describe that module.
+      if (Index.getModulePaths().empty())
+        Index.addModule(Identifier);
+      if (Record[0] >= Index.getModulePaths().size() ||
+          Record[1] >= Names.size())
+        return malformed();
+
+      FunctionSummary Summary;
+      Summary.Linkage = getDecodedLinkage(Record[2]);
+      Summary.InstCount = Record[3];
+      Summary.RefersToLocal = Record[4];
+      for (unsigned I = 5, E = Record.size(); I != E; ++I) {
+        if (Record[I] >= Names.size())
+          return malformed();
+        Summary.Callees.push_back(Names[Record[I]]);
+      }
+      Index.addFunction(Names[Record[1]], Record[0], std::move(Summary));
+      break;
+    }
+    }
+  }
+}
+
+/// Run \p Fn on a cursor over the bitcode in \p Buffer, positioned at its
+/// top-level block \p BlockID if there is one.
+template <typename T>
+static ErrorOr<T>
+withTopLevelBlock(MemoryBufferRef Buffer, unsigned BlockID,
+                  DiagnosticHandlerFunction DiagnosticHandler,
+                  function_ref<ErrorOr<T>(BitstreamCursor &, bool)> Fn) {
+  const unsigned char *BufPtr = (const unsigned char *)Buffer.getBufferStart();
+  const unsigned char *BufEnd = BufPtr + Buffer.getBufferSize();
+  if (Buffer.getBufferSize() & 3)
+    return topLevelError(DiagnosticHandler,
+                         BitcodeError::InvalidBitcodeSignature,
+                         "Invalid bitcode signature");
+
+  // If we have a wrapper header, parse it and ignore the non-bc file contents.
+  if (isBitcodeWrapper(BufPtr, BufEnd))
+    if (SkipBitcodeWrapperHeader(BufPtr, BufEnd, true))
+      return topLevelError(DiagnosticHandler, BitcodeError::CorruptedBitcode,
+                           "Invalid bitcode wrapper header");
+
+  BitstreamReader StreamFile(BufPtr, BufEnd);
+  BitstreamCursor Stream(StreamFile);
+  ErrorOr<bool> Found = findTopLevelBlock(Stream, BlockID, DiagnosticHandler);
+  if (std::error_code EC = Found.getError())
+    return EC;
+  return Fn(Stream, *Found);
+}
+
+bool llvm::hasFunctionSummary(MemoryBufferRef Buffer,
+                              DiagnosticHandlerFunction DiagnosticHandler) {
+  ErrorOr<bool> Found = withTopLevelBlock<bool>(
+      Buffer, bitc::FUNCTION_SUMMARY_BLOCK_ID, DiagnosticHandler,
+      [](BitstreamCursor &, bool Found) -> ErrorOr<bool> { return Found; });
+  return Found && *Found;
+}
+
+ErrorOr<std::unique_ptr<FunctionInfoIndex>>
+llvm::getFunctionInfoIndex(MemoryBufferRef Buffer,
+                           DiagnosticHandlerFunction DiagnosticHandler) {
+  typedef std::unique_ptr<FunctionInfoIndex> IndexPtr;
+  return withTopLevelBlock<IndexPtr>(
+      Buffer, bitc::FUNCTION_SUMMARY_BLOCK_ID, DiagnosticHandler,
+      [&](BitstreamCursor &Stream, bool Found) -> ErrorOr<IndexPtr> {
+        if (!Found)
+          return topLevelError(DiagnosticHandler,
+                               BitcodeError::NoFunctionSummary,
+                               "No function summary");
+        auto Index = llvm::make_unique<FunctionInfoIndex>();
+        if (std::error_code EC = parseFunctionSummaryBlock(
+                Stream, Buffer.getBufferIdentifier(), *Index,
+                DiagnosticHandler))
+          return EC;
+        return std::move(Index);
+      });
+}
+
+/// Parse the symbol table block \p Stream is positioned at into \p Symbols.
+static std::error_code
+parseSymbolTableBlock(BitstreamCursor &Stream,
+                      std::vector<BitcodeSymbol> &Symbols,
+                      DiagnosticHandlerFunction DiagnosticHandler) {
+  auto malformed = [&]() {
+    return topLevelError(DiagnosticHandler, BitcodeError::CorruptedBitcode,
+                         "Invalid symbol table record");
+  };
+  if (Stream.EnterSubBlock(bitc::SYMTAB_BLOCK_ID))
+    return malformed();
+
+  SmallVector<uint64_t, 64> Record;
+  while (1) {
+    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+    switch (Entry.Kind) {
+    case BitstreamEntry::SubBlock: // Handled for us already.
+    case BitstreamEntry::Error:
+      return malformed();
+    case BitstreamEntry::EndBlock:
+      return std::error_code();
+    case BitstreamEntry::Record:
+      // The interesting case.
+      break;
+    }
+
+    Record.clear();
+    switch (Stream.readRecord(Entry.ID, Record)) {
+    default: // Default behavior: ignore.
+      break;
+    case bitc::SYMTAB_CODE_SYMBOL: { // SYMBOL: [flags, namechar x N]
+      if (Record.empty())
+        return malformed();
+      BitcodeSymbol Symbol;
+      Symbol.Flags = Record[0];
+      if (ConvertToString(Record, 1, Symbol.Name))
+        return malformed();
+      Symbols.push_back(std::move(Symbol));
+      break;
+    }
+    }
+  }
+}
+
+ErrorOr<std::vector<BitcodeSymbol>>
+llvm::getBitcodeSymbolTable(MemoryBufferRef Buffer,
+                            DiagnosticHandlerFunction DiagnosticHandler) {
+  typedef std::vector<BitcodeSymbol> SymbolsTy;
+  return withTopLevelBlock<SymbolsTy>(
+      Buffer, bitc::SYMTAB_BLOCK_ID, DiagnosticHandler,
+      [&](BitstreamCursor &Stream, bool Found) -> ErrorOr<SymbolsTy> {
+        if (!Found)
+          return topLevelError(DiagnosticHandler, BitcodeError::NoSymbolTable,
+                               "No symbol table");
+        SymbolsTy Symbols;
+        if (std::error_code EC =
+                parseSymbolTableBlock(Stream, Symbols, DiagnosticHandler))
+          return EC;
+        return std::move(Symbols);
+      });
+}
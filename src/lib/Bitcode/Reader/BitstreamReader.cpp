@@ -157,6 +157,7 @@ unsigned BitstreamCursor::readRecord(unsigned AbbrevID,
   if (AbbrevID == bitc::UNABBREV_RECORD) {
     unsigned Code = ReadVBR(6);
     unsigned NumElts = ReadVBR(6);
+    Vals.reserve(Vals.size() + NumElts);
     for (unsigned i = 0; i != NumElts; ++i)
       Vals.push_back(ReadVBR64(6));
     return Code;
@@ -198,9 +199,34 @@ unsigned BitstreamCursor::readRecord(unsigned AbbrevID,
       assert(i+2 == e && "array op not second to last?");
       const BitCodeAbbrevOp &EltEnc = Abbv->getOperandInfo(++i);
 
-      // Read all the elements.
-      for (; NumElts; --NumElts)
-        Vals.push_back(readAbbreviatedField(*this, EltEnc));
+      // Read all the elements, dispatching on their encoding once rather than
+      // for each element.
+      if (EltEnc.isLiteral()) {
+        // Fixed(0) and VBR(0) elements are read as a literal zero.
+        Vals.append(NumElts, EltEnc.getLiteralValue());
+        continue;
+      }
+      Vals.reserve(Vals.size() + NumElts);
+      switch (EltEnc.getEncoding()) {
+      default:
+        report_fatal_error("Array element type can't be an Array or a Blob");
+      case BitCodeAbbrevOp::Fixed: {
+        unsigned Width = (unsigned)EltEnc.getEncodingData();
+        for (; NumElts; --NumElts)
+          Vals.push_back(Read(Width));
+        break;
+      }
+      case BitCodeAbbrevOp::VBR: {
+        unsigned Width = (unsigned)EltEnc.getEncodingData();
+        for (; NumElts; --NumElts)
+          Vals.push_back(ReadVBR64(Width));
+        break;
+      }
+      case BitCodeAbbrevOp::Char6:
+        for (; NumElts; --NumElts)
+          Vals.push_back(BitCodeAbbrevOp::DecodeChar6(Read(6)));
+        break;
+      }
       continue;
     }
 
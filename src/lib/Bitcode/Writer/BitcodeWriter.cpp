@@ -13,14 +13,18 @@
 
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "ValueEnumerator.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Bitcode/BitstreamWriter.h"
 #include "llvm/Bitcode/LLVMBitCodes.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/FunctionInfo.h"
 #include "llvm/IR/InlineAsm.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/Mangler.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Operator.h"
 #include "llvm/IR/UseListOrder.h"
@@ -30,6 +34,7 @@
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <cctype>
 #include <map>
 using namespace llvm;
@@ -38,10 +43,8 @@ using namespace llvm;
 /// be kept in sync with the reader, but need to be consistent within this file.
 enum {
   // VALUE_SYMTAB_BLOCK abbrev id's.
-  VST_ENTRY_8_ABBREV = bitc::FIRST_APPLICATION_ABBREV,
-  VST_ENTRY_7_ABBREV,
-  VST_ENTRY_6_ABBREV,
-  VST_BBENTRY_6_ABBREV,
+  VST_STRTAB_ENTRY_ABBREV = bitc::FIRST_APPLICATION_ABBREV,
+  VST_STRTAB_BBENTRY_ABBREV,
 
   // CONSTANTS_BLOCK abbrev id's.
   CONSTANTS_SETTYPE_ABBREV = bitc::FIRST_APPLICATION_ABBREV,
@@ -140,6 +143,46 @@ static unsigned GetEncodedSynchScope(SynchronizationScope SynchScope) {
   llvm_unreachable("Invalid synch scope");
 }
 
+namespace {
+/// The string table of a module, where each string is stored once: the
+/// metadata strings, in the order of their IDs, then the names of the values.
+class ModuleStringTable {
+  std::string Data;
+  StringMap<uint64_t> Offsets;
+  /// The ends of the runs of strings that are all char6, or all not char6,
+  /// with whether they are char6.
+  std::vector<std::pair<uint64_t, bool>> Runs;
+
+public:
+  /// Add \p Str to the table, unless it is already there, and return its
+  /// offset.
+  uint64_t add(StringRef Str) {
+    auto Insertion = Offsets.insert(std::make_pair(Str, Data.size()));
+    if (!Insertion.second || Str.empty())
+      return Insertion.first->second;
+
+    Data.append(Str.begin(), Str.end());
+    bool IsChar6 =
+        std::all_of(Str.begin(), Str.end(), BitCodeAbbrevOp::isChar6);
+    if (!Runs.empty() && Runs.back().second == IsChar6)
+      Runs.back().first = Data.size();
+    else
+      Runs.push_back(std::make_pair(Data.size(), IsChar6));
+    return Insertion.first->second;
+  }
+
+  /// Return the offset of \p Str, which must have been added.
+  uint64_t getOffset(StringRef Str) const {
+    auto I = Offsets.find(Str);
+    assert(I != Offsets.end() && "String not in the string table");
+    return I->second;
+  }
+
+  StringRef str() const { return Data; }
+  ArrayRef<std::pair<uint64_t, bool>> getRuns() const { return Runs; }
+};
+} // end anonymous namespace
+
 static void WriteStringRecord(unsigned Code, StringRef Str,
                               unsigned AbbrevToUse, BitstreamWriter &Stream) {
   SmallVector<unsigned, 64> Vals;
@@ -480,8 +523,8 @@ static void WriteTypeTable(const ValueEnumerator &VE, BitstreamWriter &Stream) {
   Stream.ExitBlock();
 }
 
-static unsigned getEncodedLinkage(const GlobalValue &GV) {
-  switch (GV.getLinkage()) {
+static unsigned getEncodedLinkage(GlobalValue::LinkageTypes Linkage) {
+  switch (Linkage) {
   case GlobalValue::ExternalLinkage:
     return 0;
   case GlobalValue::WeakAnyLinkage:
@@ -508,6 +551,10 @@ static unsigned getEncodedLinkage(const GlobalValue &GV) {
   llvm_unreachable("Invalid linkage");
 }
 
+static unsigned getEncodedLinkage(const GlobalValue &GV) {
+  return getEncodedLinkage(GV.getLinkage());
+}
+
 static unsigned getEncodedVisibility(const GlobalValue &GV) {
   switch (GV.getVisibility()) {
   case GlobalValue::DefaultVisibility:   return 0;
@@ -1161,14 +1208,23 @@ static void WriteModuleMetadata(const Module *M,
 
   Stream.EnterSubblock(bitc::METADATA_BLOCK_ID, 3);
 
-  unsigned MDSAbbrev = 0;
-  if (VE.hasMDString()) {
-    // Abbrev for METADATA_STRING.
+  SmallVector<uint64_t, 64> Record;
+
+  // The strings are at the start of the string table, in the order of their
+  // IDs, so only their sizes are needed.
+  ArrayRef<const Metadata *> Strings = VE.getMDStrings();
+  if (!Strings.empty()) {
+    // Abbrev for METADATA_STRINGS.
     BitCodeAbbrev *Abbv = new BitCodeAbbrev();
-    Abbv->Add(BitCodeAbbrevOp(bitc::METADATA_STRING));
+    Abbv->Add(BitCodeAbbrevOp(bitc::METADATA_STRINGS));
     Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
-    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 8));
-    MDSAbbrev = Stream.EmitAbbrev(Abbv);
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
+    unsigned MDSAbbrev = Stream.EmitAbbrev(Abbv);
+
+    for (const Metadata *MD : Strings)
+      Record.push_back(cast<MDString>(MD)->getLength());
+    Stream.EmitRecord(bitc::METADATA_STRINGS, Record, MDSAbbrev);
+    Record.clear();
   }
 
   // Initialize MDNode abbreviations.
@@ -1216,8 +1272,7 @@ static void WriteModuleMetadata(const Module *M,
     NameAbbrev = Stream.EmitAbbrev(Abbv);
   }
 
-  SmallVector<uint64_t, 64> Record;
-  for (const Metadata *MD : MDs) {
+  for (const Metadata *MD : makeArrayRef(MDs).slice(Strings.size())) {
     if (const MDNode *N = dyn_cast<MDNode>(MD)) {
       assert(N->isResolved() && "Expected forward references to be resolved");
 
@@ -1231,17 +1286,7 @@ static void WriteModuleMetadata(const Module *M,
 #include "llvm/IR/Metadata.def"
       }
     }
-    if (const auto *MDC = dyn_cast<ConstantAsMetadata>(MD)) {
-      WriteValueAsMetadata(MDC, VE, Stream, Record);
-      continue;
-    }
-    const MDString *MDS = cast<MDString>(MD);
-    // Code: [strchar x N]
-    Record.append(MDS->bytes_begin(), MDS->bytes_end());
-
-    // Emit the finished record.
-    Stream.EmitRecord(bitc::METADATA_STRING, Record, MDSAbbrev);
-    Record.clear();
+    WriteValueAsMetadata(cast<ConstantAsMetadata>(MD), VE, Stream, Record);
   }
 
   // Write named metadata.
@@ -1997,53 +2042,25 @@ static void WriteInstruction(const Instruction &I, unsigned InstID,
 // Emit names for globals/functions etc.
 static void WriteValueSymbolTable(const ValueSymbolTable &VST,
                                   const ValueEnumerator &VE,
+                                  const ModuleStringTable &StrTab,
                                   BitstreamWriter &Stream) {
   if (VST.empty()) return;
   Stream.EnterSubblock(bitc::VALUE_SYMTAB_BLOCK_ID, 4);
 
-  // FIXME: Set up the abbrev, we know how many values there are!
-  // FIXME: We know if the type names can use 7-bit ascii.
-  SmallVector<unsigned, 64> NameVals;
-
-  for (ValueSymbolTable::const_iterator SI = VST.begin(), SE = VST.end();
-       SI != SE; ++SI) {
-
-    const ValueName &Name = *SI;
-
-    // Figure out the encoding to use for the name.
-    bool is7Bit = true;
-    bool isChar6 = true;
-    for (const char *C = Name.getKeyData(), *E = C+Name.getKeyLength();
-         C != E; ++C) {
-      if (isChar6)
-        isChar6 = BitCodeAbbrevOp::isChar6(*C);
-      if ((unsigned char)*C & 128) {
-        is7Bit = false;
-        break;  // don't bother scanning the rest.
-      }
+  SmallVector<uint64_t, 3> NameVals;
+  for (const ValueName &Name : VST) {
+    // VST_STRTAB_ENTRY:   [valueid, offset, size]
+    // VST_STRTAB_BBENTRY: [bbid, offset, size]
+    unsigned Code = bitc::VST_CODE_STRTAB_ENTRY;
+    unsigned AbbrevToUse = VST_STRTAB_ENTRY_ABBREV;
+    if (isa<BasicBlock>(Name.getValue())) {
+      Code = bitc::VST_CODE_STRTAB_BBENTRY;
+      AbbrevToUse = VST_STRTAB_BBENTRY_ABBREV;
     }
 
-    unsigned AbbrevToUse = VST_ENTRY_8_ABBREV;
-
-    // VST_ENTRY:   [valueid, namechar x N]
-    // VST_BBENTRY: [bbid, namechar x N]
-    unsigned Code;
-    if (isa<BasicBlock>(SI->getValue())) {
-      Code = bitc::VST_CODE_BBENTRY;
-      if (isChar6)
-        AbbrevToUse = VST_BBENTRY_6_ABBREV;
-    } else {
-      Code = bitc::VST_CODE_ENTRY;
-      if (isChar6)
-        AbbrevToUse = VST_ENTRY_6_ABBREV;
-      else if (is7Bit)
-        AbbrevToUse = VST_ENTRY_7_ABBREV;
-    }
-
-    NameVals.push_back(VE.getValueID(SI->getValue()));
-    for (const char *P = Name.getKeyData(),
-         *E = Name.getKeyData()+Name.getKeyLength(); P != E; ++P)
-      NameVals.push_back((unsigned char)*P);
+    NameVals.push_back(VE.getValueID(Name.getValue()));
+    NameVals.push_back(StrTab.getOffset(Name.getKey()));
+    NameVals.push_back(Name.getKeyLength());
 
     // Emit the finished record.
     Stream.EmitRecord(Code, NameVals, AbbrevToUse);
@@ -2090,6 +2107,7 @@ static void WriteUseListBlock(const Function *F, ValueEnumerator &VE,
 
 /// WriteFunction - Emit a function body to the module stream.
 static void WriteFunction(const Function &F, ValueEnumerator &VE,
+                          const ModuleStringTable &StrTab,
                           BitstreamWriter &Stream) {
   Stream.EnterSubblock(bitc::FUNCTION_BLOCK_ID, 4);
   VE.incorporateFunction(F);
@@ -2151,7 +2169,7 @@ static void WriteFunction(const Function &F, ValueEnumerator &VE,
     }
 
   // Emit names for all the instructions etc.
-  WriteValueSymbolTable(F.getValueSymbolTable(), VE, Stream);
+  WriteValueSymbolTable(F.getValueSymbolTable(), VE, StrTab, Stream);
 
   if (NeedsMetadataAttachment)
     WriteMetadataAttachment(F, VE, Stream);
@@ -2162,56 +2180,39 @@ static void WriteFunction(const Function &F, ValueEnumerator &VE,
 }
 
 // Emit blockinfo, which defines the standard abbreviations etc.
-static void WriteBlockInfo(const ValueEnumerator &VE, BitstreamWriter &Stream) {
+static void WriteBlockInfo(const ValueEnumerator &VE,
+                           const ModuleStringTable &StrTab,
+                           BitstreamWriter &Stream) {
   // We only want to emit block info records for blocks that have multiple
   // instances: CONSTANTS_BLOCK, FUNCTION_BLOCK and VALUE_SYMTAB_BLOCK.
   // Other blocks can define their abbrevs inline.
   Stream.EnterBlockInfoBlock(2);
 
-  { // 8-bit fixed-width VST_ENTRY/VST_BBENTRY strings.
-    BitCodeAbbrev *Abbv = new BitCodeAbbrev();
-    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 3));
-    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8));
-    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
-    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 8));
-    if (Stream.EmitBlockInfoAbbrev(bitc::VALUE_SYMTAB_BLOCK_ID,
-                                   Abbv) != VST_ENTRY_8_ABBREV)
-      llvm_unreachable("Unexpected abbrev ordering!");
-  }
+  // The offsets into the string table, for the VST_STRTAB_ENTRY and
+  // VST_STRTAB_BBENTRY abbrevs.
+  unsigned OffsetBits = std::max(1u, Log2_64_Ceil(StrTab.str().size() + 1));
 
-  { // 7-bit fixed width VST_ENTRY strings.
+  { // VST_STRTAB_ENTRY abbrev for VALUE_SYMTAB_BLOCK.
     BitCodeAbbrev *Abbv = new BitCodeAbbrev();
-    Abbv->Add(BitCodeAbbrevOp(bitc::VST_CODE_ENTRY));
+    Abbv->Add(BitCodeAbbrevOp(bitc::VST_CODE_STRTAB_ENTRY));
     Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8));
-    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
-    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 7));
-    if (Stream.EmitBlockInfoAbbrev(bitc::VALUE_SYMTAB_BLOCK_ID,
-                                   Abbv) != VST_ENTRY_7_ABBREV)
-      llvm_unreachable("Unexpected abbrev ordering!");
-  }
-  { // 6-bit char6 VST_ENTRY strings.
-    BitCodeAbbrev *Abbv = new BitCodeAbbrev();
-    Abbv->Add(BitCodeAbbrevOp(bitc::VST_CODE_ENTRY));
-    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8));
-    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
-    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Char6));
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, OffsetBits));
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
     if (Stream.EmitBlockInfoAbbrev(bitc::VALUE_SYMTAB_BLOCK_ID,
-                                   Abbv) != VST_ENTRY_6_ABBREV)
+                                   Abbv) != VST_STRTAB_ENTRY_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
   }
-  { // 6-bit char6 VST_BBENTRY strings.
+  { // VST_STRTAB_BBENTRY abbrev for VALUE_SYMTAB_BLOCK.
     BitCodeAbbrev *Abbv = new BitCodeAbbrev();
-    Abbv->Add(BitCodeAbbrevOp(bitc::VST_CODE_BBENTRY));
+    Abbv->Add(BitCodeAbbrevOp(bitc::VST_CODE_STRTAB_BBENTRY));
     Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8));
-    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
-    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Char6));
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, OffsetBits));
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
     if (Stream.EmitBlockInfoAbbrev(bitc::VALUE_SYMTAB_BLOCK_ID,
-                                   Abbv) != VST_BBENTRY_6_ABBREV)
+                                   Abbv) != VST_STRTAB_BBENTRY_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
   }
 
-
-
   { // SETTYPE abbrev for CONSTANTS_BLOCK.
     BitCodeAbbrev *Abbv = new BitCodeAbbrev();
     Abbv->Add(BitCodeAbbrevOp(bitc::CST_CODE_SETTYPE));
@@ -2322,10 +2323,94 @@ static void WriteBlockInfo(const ValueEnumerator &VE, BitstreamWriter &Stream) {
   Stream.ExitBlock();
 }
 
+/// Collect the strings of \p M in \p StrTab: the metadata strings, then the
+/// names in the symbol tables of the module and of its function bodies.
+static void BuildStringTable(const Module &M, const ValueEnumerator &VE,
+                             ModuleStringTable &StrTab) {
+  for (const Metadata *MD : VE.getMDStrings()) {
+    StringRef Str = cast<MDString>(MD)->getString();
+    uint64_t Offset = StrTab.add(Str);
+    assert(Offset + Str.size() == StrTab.str().size() &&
+           "Metadata strings must be contiguous");
+    (void)Offset;
+  }
+  for (const ValueName &Name : M.getValueSymbolTable())
+    StrTab.add(Name.getKey());
+  for (const Function &F : M)
+    for (const ValueName &Name : F.getValueSymbolTable())
+      StrTab.add(Name.getKey());
+}
+
+/// Emit the string table, as char6 arrays for the runs of strings that allow
+/// it, and as blobs otherwise.
+static void WriteStringTable(const ModuleStringTable &StrTab,
+                             BitstreamWriter &Stream) {
+  if (StrTab.str().empty())
+    return;
+
+  BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(bitc::MODULE_CODE_STRTAB));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Char6));
+  unsigned Char6Abbrev = Stream.EmitAbbrev(Abbv);
+
+  Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(bitc::MODULE_CODE_STRTAB));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
+  unsigned BlobAbbrev = Stream.EmitAbbrev(Abbv);
+
+  SmallVector<unsigned, 64> Vals;
+  uint64_t Start = 0;
+  for (const auto &Run : StrTab.getRuns()) {
+    StringRef Str = StrTab.str().slice(Start, Run.first);
+    if (Run.second) {
+      Vals.append(Str.begin(), Str.end());
+      Stream.EmitRecord(bitc::MODULE_CODE_STRTAB, Vals, Char6Abbrev);
+    } else {
+      Vals.push_back(bitc::MODULE_CODE_STRTAB);
+      Stream.EmitRecordWithBlob(BlobAbbrev, Vals, Str);
+    }
+    Vals.clear();
+    Start = Run.first;
+  }
+}
+
+/// The width of the abbreviation IDs of the module block.
+static const unsigned ModuleCodeWidth = 3;
+
+/// Emit the placeholder of the index of the \p NumBodies function blocks of
+/// the module, and return the position of its blob, in bytes.
+static uint64_t WriteFunctionIndexPlaceholder(unsigned NumBodies,
+                                              BitstreamWriter &Stream) {
+  BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(bitc::MODULE_CODE_FUNCTION_INDEX));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
+  unsigned AbbrevID = Stream.EmitAbbrev(Abbv);
+
+  // One 64-bit offset per function block, and one for their end.
+  SmallVector<unsigned, 1> Vals;
+  Vals.push_back(bitc::MODULE_CODE_FUNCTION_INDEX);
+  std::string Placeholder((NumBodies + 1) * 8, '\0');
+  Stream.EmitRecordWithBlob(AbbrevID, Vals, Placeholder);
+
+  // The blob is 32-bit aligned and its size is a multiple of 4, so it ends
+  // where the stream is now.
+  return Stream.GetCurrentBitNo() / 8 - Placeholder.size();
+}
+
+/// Backpatch the entry \p Index of the function index at \p IndexByte with
+/// the current position in the stream, plus \p Delta bits.
+static void BackpatchFunctionIndex(uint64_t IndexByte, unsigned Index,
+                                   unsigned Delta, BitstreamWriter &Stream) {
+  uint64_t Offset = Stream.GetCurrentBitNo() + Delta - IndexByte * 8;
+  Stream.BackpatchWord(IndexByte + Index * 8, uint32_t(Offset));
+  Stream.BackpatchWord(IndexByte + Index * 8 + 4, uint32_t(Offset >> 32));
+}
+
 /// WriteModule - Emit the specified module to the bitstream.
 static void WriteModule(const Module *M, BitstreamWriter &Stream,
                         bool ShouldPreserveUseListOrder) {
-  Stream.EnterSubblock(bitc::MODULE_BLOCK_ID, 3);
+  Stream.EnterSubblock(bitc::MODULE_BLOCK_ID, ModuleCodeWidth);
 
   SmallVector<unsigned, 1> Vals;
   unsigned CurVersion = 1;
@@ -2335,8 +2420,13 @@ static void WriteModule(const Module *M, BitstreamWriter &Stream,
   // Analyze the module, enumerating globals, functions, etc.
   ValueEnumerator VE(*M, ShouldPreserveUseListOrder);
 
+  // Collect the strings of the module, which the metadata and the symbol
+  // tables refer to.
+  ModuleStringTable StrTab;
+  BuildStringTable(*M, VE, StrTab);
+
   // Emit blockinfo, which defines the standard abbreviations etc.
-  WriteBlockInfo(VE, Stream);
+  WriteBlockInfo(VE, StrTab, Stream);
 
   // Emit information about attribute groups.
   WriteAttributeGroupTable(VE, Stream);
@@ -2356,6 +2446,9 @@ static void WriteModule(const Module *M, BitstreamWriter &Stream,
   // Emit constants.
   WriteModuleConstants(VE, Stream);
 
+  // Emit the strings of the module.
+  WriteStringTable(StrTab, Stream);
+
   // Emit metadata.
   WriteModuleMetadata(M, VE, Stream);
 
@@ -2363,16 +2456,35 @@ static void WriteModule(const Module *M, BitstreamWriter &Stream,
   WriteModuleMetadataStore(M, Stream);
 
   // Emit names for globals/functions etc.
-  WriteValueSymbolTable(M->getValueSymbolTable(), VE, Stream);
+  WriteValueSymbolTable(M->getValueSymbolTable(), VE, StrTab, Stream);
 
   // Emit module-level use-lists.
   if (VE.shouldPreserveUseListOrder())
     WriteUseListBlock(nullptr, VE, Stream);
 
-  // Emit function bodies.
+  // Emit function bodies, after an index of where their blocks are, so that
+  // the reader can defer them all without skipping them one by one. The
+  // function blocks are the last content of the module block.
+  unsigned NumBodies = 0;
+  for (const Function &F : *M)
+    if (!F.isDeclaration())
+      ++NumBodies;
+  uint64_t IndexByte = 0;
+  if (NumBodies)
+    IndexByte = WriteFunctionIndexPlaceholder(NumBodies, Stream);
+
+  // The reader resumes parsing a function block after its ID.
+  static_assert(bitc::FUNCTION_BLOCK_ID < (1 << (bitc::BlockIDWidth - 1)),
+                "The function block ID must fit one VBR chunk");
+  unsigned Index = 0;
   for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
-    if (!F->isDeclaration())
-      WriteFunction(*F, VE, Stream);
+    if (!F->isDeclaration()) {
+      BackpatchFunctionIndex(IndexByte, Index++,
+                             ModuleCodeWidth + bitc::BlockIDWidth, Stream);
+      WriteFunction(*F, VE, StrTab, Stream);
+    }
+  if (NumBodies)
+    BackpatchFunctionIndex(IndexByte, Index, 0, Stream);
 
   Stream.ExitBlock();
 }
@@ -2450,10 +2562,133 @@ static void EmitDarwinBCHeaderAndTrailer(SmallVectorImpl<char> &Buffer,
     Buffer.push_back(0);
 }
 
+/// Emit the function summary block for \p Index. The module paths are only
+/// emitted for a combined index; the summaries written next to a module
+/// describe that module.
+static void WriteFunctionSummary(const FunctionInfoIndex &Index,
+                                 bool EmitModulePaths,
+                                 BitstreamWriter &Stream) {
+  Stream.EnterSubblock(bitc::FUNCTION_SUMMARY_BLOCK_ID, 3);
+
+  if (EmitModulePaths)
+    for (const std::string &Path : Index.getModulePaths())
+      WriteStringRecord(bitc::FS_CODE_MODULE, Path, 0, Stream);
+
+  // Each name is emitted once, right before the first record using it.
+  StringMap<unsigned> NameIDs;
+  auto getNameID = [&](StringRef Name) {
+    auto Entry = NameIDs.insert(std::make_pair(Name, NameIDs.size()));
+    if (Entry.second)
+      WriteStringRecord(bitc::FS_CODE_NAME, Name, 0, Stream);
+    return Entry.first->second;
+  };
+
+  // Sort the functions by name to keep the output deterministic.
+  std::vector<StringRef> Names;
+  for (const auto &Entry : Index)
+    Names.push_back(Entry.getKey());
+  std::sort(Names.begin(), Names.end());
+
+  SmallVector<uint64_t, 64> Vals;
+  SmallVector<unsigned, 16> CalleeIDs;
+  for (StringRef Name : Names) {
+    unsigned NameID = getNameID(Name);
+    for (const auto &Definition : Index.lookup(Name)) {
+      const FunctionSummary &Summary = Definition.second;
+      for (const std::string &Callee : Summary.Callees)
+        CalleeIDs.push_back(getNameID(Callee));
+
+      // FUNCTION: [module, name, linkage, instcount, referstolocal,
+      //            callee name...]
+      Vals.push_back(Definition.first);
+      Vals.push_back(NameID);
+      Vals.push_back(getEncodedLinkage(Summary.Linkage));
+      Vals.push_back(Summary.InstCount);
+      Vals.push_back(Summary.RefersToLocal);
+      Vals.append(CalleeIDs.begin(), CalleeIDs.end());
+      Stream.EmitRecord(bitc::FS_CODE_FUNCTION, Vals);
+      Vals.clear();
+      CalleeIDs.clear();
+    }
+  }
+
+  Stream.ExitBlock();
+}
+
+/// Compute the bitc::SymtabFlags of \p GV, as IRObjectFile does.
+static unsigned getSymtabFlags(const GlobalValue &GV) {
+  unsigned Flags = 0;
+  if (GV.isDeclarationForLinker())
+    Flags |= bitc::SYMTAB_UNDEFINED;
+  if (GV.hasPrivateLinkage())
+    Flags |= bitc::SYMTAB_FORMAT_SPECIFIC;
+  if (!GV.hasLocalLinkage())
+    Flags |= bitc::SYMTAB_GLOBAL;
+  if (GV.hasCommonLinkage())
+    Flags |= bitc::SYMTAB_COMMON;
+  if (GV.hasLinkOnceLinkage() || GV.hasWeakLinkage())
+    Flags |= bitc::SYMTAB_WEAK;
+
+  if (GV.getName().startswith("llvm."))
+    Flags |= bitc::SYMTAB_FORMAT_SPECIFIC;
+  else if (auto *Var = dyn_cast<GlobalVariable>(&GV))
+    if (Var->getSection() == "llvm.metadata")
+      Flags |= bitc::SYMTAB_FORMAT_SPECIFIC;
+  return Flags;
+}
+
+/// Emit the symbol table of \p M, unless it has module-level inline asm: the
+/// symbols it defines can only be found by parsing it for the target.
+static void WriteSymbolTable(const Module *M, BitstreamWriter &Stream) {
+  if (!M->getModuleInlineAsm().empty())
+    return;
+
+  Stream.EnterSubblock(bitc::SYMTAB_BLOCK_ID, 3);
+
+  // SYMBOL: [flags, namechar x N]
+  BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(bitc::SYMTAB_CODE_SYMBOL));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 5));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 8));
+  unsigned SymbolAbbrev = Stream.EmitAbbrev(Abbv);
+
+  Mangler Mang(&M->getDataLayout());
+  SmallString<64> Name;
+  SmallVector<unsigned, 64> Vals;
+  auto emitSymbol = [&](const GlobalValue &GV) {
+    Mang.getNameWithPrefix(Name, &GV, /*CannotUsePrivateLabel=*/false);
+    Vals.push_back(getSymtabFlags(GV));
+    for (char C : Name)
+      Vals.push_back((unsigned char)C);
+    Stream.EmitRecord(bitc::SYMTAB_CODE_SYMBOL, Vals, SymbolAbbrev);
+    Vals.clear();
+    Name.clear();
+  };
+  for (const Function &F : *M)
+    emitSymbol(F);
+  for (const GlobalVariable &GV : M->globals())
+    emitSymbol(GV);
+  for (const GlobalAlias &GA : M->aliases())
+    emitSymbol(GA);
+
+  Stream.ExitBlock();
+}
+
+static void WriteBitcodeHeader(BitstreamWriter &Stream) {
+  Stream.Emit((unsigned)'B', 8);
+  Stream.Emit((unsigned)'C', 8);
+  Stream.Emit(0x0, 4);
+  Stream.Emit(0xC, 4);
+  Stream.Emit(0xE, 4);
+  Stream.Emit(0xD, 4);
+}
+
 /// WriteBitcodeToFile - Write the specified module to the specified output
 /// stream.
 void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out,
-                              bool ShouldPreserveUseListOrder) {
+                              bool ShouldPreserveUseListOrder,
+                              bool EmitFunctionSummary) {
   SmallVector<char, 0> Buffer;
   Buffer.reserve(256*1024);
 
@@ -2468,15 +2703,21 @@ void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out,
     BitstreamWriter Stream(Buffer);
 
     // Emit the file header.
-    Stream.Emit((unsigned)'B', 8);
-    Stream.Emit((unsigned)'C', 8);
-    Stream.Emit(0x0, 4);
-    Stream.Emit(0xC, 4);
-    Stream.Emit(0xE, 4);
-    Stream.Emit(0xD, 4);
+    WriteBitcodeHeader(Stream);
 
     // Emit the module.
     WriteModule(M, Stream, ShouldPreserveUseListOrder);
+
+    // Emit the function summaries after the module, where readers that don't
+    // care about them never look.
+    if (EmitFunctionSummary) {
+      FunctionInfoIndex Index;
+      Index.addModule(*M, M->getModuleIdentifier());
+      WriteFunctionSummary(Index, /*EmitModulePaths=*/false, Stream);
+    }
+
+    // Likewise for the symbol table.
+    WriteSymbolTable(M, Stream);
   }
 
   if (TT.isOSDarwin())
@@ -2485,3 +2726,14 @@ void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out,
   // Write the generated bitstream to "Out".
   Out.write((char*)&Buffer.front(), Buffer.size());
 }
+
+void llvm::WriteFunctionSummaryToFile(const FunctionInfoIndex &Index,
+                                      raw_ostream &Out) {
+  SmallVector<char, 0> Buffer;
+  {
+    BitstreamWriter Stream(Buffer);
+    WriteBitcodeHeader(Stream);
+    WriteFunctionSummary(Index, /*EmitModulePaths=*/true, Stream);
+  }
+  Out.write((char*)&Buffer.front(), Buffer.size());
+}
@@ -285,7 +285,7 @@ static bool isIntOrIntVectorValue(const std::pair<const Value*, unsigned> &V) {
 
 ValueEnumerator::ValueEnumerator(const Module &M,
                                  bool ShouldPreserveUseListOrder)
-    : HasMDString(false), HasDILocation(false), HasGenericDINode(false),
+    : NumMDStrings(0), HasDILocation(false), HasGenericDINode(false),
       ShouldPreserveUseListOrder(ShouldPreserveUseListOrder) {
   if (ShouldPreserveUseListOrder)
     UseListOrders = predictUseListOrder(M);
@@ -389,6 +389,8 @@ ValueEnumerator::ValueEnumerator(const Module &M,
 
   // Optimize constant ordering.
   OptimizeConstants(FirstConstant, Values.size());
+
+  OrganizeMetadata();
 }
 
 unsigned ValueEnumerator::getInstructionID(const Instruction *Inst) const {
@@ -464,6 +466,21 @@ void ValueEnumerator::print(raw_ostream &OS, const MetadataMapType &Map,
   }
 }
 
+/// OrganizeMetadata - Move the MDStrings before the other metadata, so that
+/// they can all be emitted at once.  Strings have no operands, so this doesn't
+/// introduce forward references.
+void ValueEnumerator::OrganizeMetadata() {
+  auto FirstNonString =
+      std::stable_partition(MDs.begin(), MDs.end(), [](const Metadata *MD) {
+        return isa<MDString>(MD);
+      });
+  NumMDStrings = FirstNonString - MDs.begin();
+
+  // Update the IDs.
+  for (unsigned I = 0, E = MDs.size(); I != E; ++I)
+    MDValueMap[MDs[I]] = I + 1;
+}
+
 /// OptimizeConstants - Reorder constant pool for denser encoding.
 void ValueEnumerator::OptimizeConstants(unsigned CstStart, unsigned CstEnd) {
   if (CstStart == CstEnd || CstStart+1 == CstEnd) return;
@@ -547,7 +564,6 @@ void ValueEnumerator::EnumerateMetadata(const Metadata *MD) {
   else if (auto *C = dyn_cast<ConstantAsMetadata>(MD))
     EnumerateValue(C->getValue());
 
-  HasMDString |= isa<MDString>(MD);
   HasDILocation |= isa<DILocation>(MD);
   HasGenericDINode |= isa<GenericDINode>(MD);
 
@@ -14,6 +14,7 @@
 #ifndef LLVM_LIB_BITCODE_WRITER_VALUEENUMERATOR_H
 #define LLVM_LIB_BITCODE_WRITER_VALUEENUMERATOR_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/UniqueVector.h"
@@ -64,7 +65,8 @@ private:
   SmallVector<const LocalAsMetadata *, 8> FunctionLocalMDs;
   typedef DenseMap<const Metadata *, unsigned> MetadataMapType;
   MetadataMapType MDValueMap;
-  bool HasMDString;
+  /// The number of MDStrings, which come first in MDs.
+  unsigned NumMDStrings;
   bool HasDILocation;
   bool HasGenericDINode;
   bool ShouldPreserveUseListOrder;
@@ -120,7 +122,6 @@ public:
     return MDValueMap.lookup(MD);
   }
 
-  bool hasMDString() const { return HasMDString; }
   bool hasDILocation() const { return HasDILocation; }
   bool hasGenericDINode() const { return HasGenericDINode; }
 
@@ -158,6 +159,10 @@ public:
 
   const ValueList &getValues() const { return Values; }
   const std::vector<const Metadata *> &getMDs() const { return MDs; }
+  /// The MDStrings of the module, in the order of their IDs.
+  ArrayRef<const Metadata *> getMDStrings() const {
+    return makeArrayRef(MDs).slice(0, NumMDStrings);
+  }
   const SmallVectorImpl<const LocalAsMetadata *> &getFunctionLocalMDs() const {
     return FunctionLocalMDs;
   }
@@ -188,6 +193,7 @@ public:
 
 private:
   void OptimizeConstants(unsigned CstStart, unsigned CstEnd);
+  void OrganizeMetadata();
 
   void EnumerateMDNodeOperands(const MDNode *N);
   void EnumerateMetadata(const Metadata *MD);
@@ -57,6 +57,18 @@ void DIEAbbrev::Profile(FoldingSetNodeID &ID) const {
     Data[i].Profile(ID);
 }
 
+bool DIEAbbrev::isEqual(const DIEAbbrev &Other) const {
+  if (Tag != Other.Tag || Children != Other.Children ||
+      DataHash != Other.DataHash || Data.size() != Other.Data.size())
+    return false;
+
+  for (unsigned i = 0, N = Data.size(); i < N; ++i)
+    if (Data[i].getAttribute() != Other.Data[i].getAttribute() ||
+        Data[i].getForm() != Other.Data[i].getForm())
+      return false;
+  return true;
+}
+
 /// Emit - Print the abbreviation using the specified asm printer.
 ///
 void DIEAbbrev::Emit(const AsmPrinter *AP) const {
@@ -22,6 +22,9 @@
 #include "llvm/MC/MCStreamer.h"
 #include "llvm/MC/MCSymbol.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/ThreadPool.h"
+#include <algorithm>
+#include <thread>
 
 using namespace llvm;
 
@@ -137,22 +140,49 @@ static bool compareOffsets(const DwarfAccelTable::HashDataContents *A,
   return A->DieOffset < B->DieOffset;
 }
 
+// Call Fn on consecutive chunks [Begin, End) of the indices [0, N). When there
+// are many indices the chunks are processed concurrently, so Fn must only
+// touch the elements of its own chunk.
+template <typename FuncT> static void forEachChunk(size_t N, FuncT Fn) {
+  // Below this many elements, starting the threads costs more than it saves.
+  const size_t ParallelThreshold = 1 << 14;
+  unsigned Threads = std::thread::hardware_concurrency();
+  if (N < ParallelThreshold || Threads <= 1) {
+    Fn(size_t(0), N);
+    return;
+  }
+
+  // Use a few chunks per thread to balance uneven chunks.
+  size_t NumChunks = std::min<size_t>(N / (ParallelThreshold / 4), Threads * 4);
+  size_t ChunkSize = (N + NumChunks - 1) / NumChunks;
+  ThreadPool Pool(Threads);
+  for (size_t Begin = 0; Begin < N; Begin += ChunkSize) {
+    size_t End = std::min(N, Begin + ChunkSize);
+    Pool.async([=] { Fn(Begin, End); });
+  }
+  Pool.wait();
+}
+
 void DwarfAccelTable::FinalizeTable(AsmPrinter *Asm, StringRef Prefix) {
   // Create the individual hash data outputs.
   Data.reserve(Entries.size());
   for (StringMap<DataArray>::iterator EI = Entries.begin(), EE = Entries.end();
-       EI != EE; ++EI) {
-
-    // Unique the entries.
-    auto *Comparator = UseDieOffsets ? compareOffsets : compareDIEs;
-    std::stable_sort(EI->second.Values.begin(), EI->second.Values.end(), Comparator);
-    EI->second.Values.erase(
-        std::unique(EI->second.Values.begin(), EI->second.Values.end()),
-        EI->second.Values.end());
-
-    HashData *Entry = new (Allocator) HashData(EI->getKey(), EI->second);
-    Data.push_back(Entry);
-  }
+       EI != EE; ++EI)
+    Data.push_back(new (Allocator) HashData(EI->getKey(), EI->second));
+
+  // Hash the names and unique their entries. Each name only touches its own
+  // entries, so large tables do this on worker threads.
+  auto *Comparator = UseDieOffsets ? compareOffsets : compareDIEs;
+  forEachChunk(Data.size(), [&](size_t Begin, size_t End) {
+    for (size_t i = Begin; i != End; ++i) {
+      HashData *Entry = Data[i];
+      Entry->HashValue = HashDJB(Entry->Str);
+
+      std::vector<HashDataContents *> &Values = Entry->Data.Values;
+      std::stable_sort(Values.begin(), Values.end(), Comparator);
+      Values.erase(std::unique(Values.begin(), Values.end()), Values.end());
+    }
+  });
 
   // Figure out how many buckets we need, then compute the bucket
   // contents and the final ordering. We'll emit the hashes and offsets
@@ -171,14 +201,17 @@ void DwarfAccelTable::FinalizeTable(AsmPrinter *Asm, StringRef Prefix) {
 
   // Sort the contents of the buckets by hash value so that hash
   // collisions end up together. Stable sort makes testing easier and
-  // doesn't cost much more.
-  for (size_t i = 0; i < Buckets.size(); ++i)
-    std::stable_sort(Buckets[i].begin(), Buckets[i].end(),
-                     [&] (HashData *LHS, HashData *RHS) {
-                       return LHS->HashValue == RHS->HashValue ?
-                         (UseStringOffsets ? LHS->Data.StrOffset < RHS->Data.StrOffset : 0)
-                         : LHS->HashValue < RHS->HashValue;
-                     });
+  // doesn't cost much more. The buckets are independent, so the output does
+  // not depend on whether they are sorted concurrently.
+  forEachChunk(Buckets.size(), [&](size_t Begin, size_t End) {
+    for (size_t i = Begin; i != End; ++i)
+      std::stable_sort(Buckets[i].begin(), Buckets[i].end(),
+                       [&](HashData *LHS, HashData *RHS) {
+        if (LHS->HashValue != RHS->HashValue)
+          return LHS->HashValue < RHS->HashValue;
+        return UseStringOffsets && LHS->Data.StrOffset < RHS->Data.StrOffset;
+      });
+  });
 }
 
 // Emits the header for the table via the AsmPrinter.
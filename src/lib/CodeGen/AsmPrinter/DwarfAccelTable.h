@@ -232,10 +232,10 @@ private:
     uint32_t HashValue;
     MCSymbol *Sym;
     DwarfAccelTable::DataArray &Data; // offsets
+    // The hash value is computed by FinalizeTable, which hashes the names of
+    // large tables concurrently.
     HashData(StringRef S, DwarfAccelTable::DataArray &Data)
-        : Str(S), Data(Data) {
-      HashValue = DwarfAccelTable::HashDJB(S);
-    }
+        : Str(S), HashValue(0), Sym(nullptr), Data(Data) {}
 #ifndef NDEBUG
     void print(raw_ostream &O, DwarfAccelTable& Table) {
       O << "Name: " << Str << "\n";
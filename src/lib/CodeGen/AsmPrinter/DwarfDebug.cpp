@@ -57,6 +57,8 @@ using namespace llvm;
 
 #define DEBUG_TYPE "dwarfdebug"
 
+STATISTIC(NumDIEKB, "Kilobytes allocated for DIEs and their values");
+
 static cl::opt<bool>
 DisableDebugInfoPrinting("disable-debug-info-print", cl::Hidden,
                          cl::desc("Disable debug info printing"));
@@ -688,6 +690,9 @@ void DwarfDebug::endModule() {
     emitDebugPubTypes(GenerateGnuPubSections);
   }
 
+  if (AreStatisticsEnabled())
+    NumDIEKB += (DIEValueAllocator.getTotalMemory() + 512) / 1024;
+
   // clean up.
   SPMap.clear();
   AbstractVariables.clear();
@@ -11,34 +11,54 @@
 #include "DwarfDebug.h"
 #include "DwarfUnit.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/MC/MCStreamer.h"
+#include "llvm/Support/Debug.h"
 #include "llvm/Support/LEB128.h"
 #include "llvm/Target/TargetLoweringObjectFile.h"
 
+#define DEBUG_TYPE "dwarfdebug"
+
+STATISTIC(NumDIEs, "Number of DIEs emitted");
+STATISTIC(NumDIEAttributes, "Number of DIE attributes emitted");
+STATISTIC(NumAbbrevs, "Number of unique DIE abbreviations");
+
 namespace llvm {
 DwarfFile::DwarfFile(AsmPrinter *AP, StringRef Pref, BumpPtrAllocator &DA)
     : Asm(AP), StrPool(DA, *Asm, Pref) {}
 
 DwarfFile::~DwarfFile() {}
 
+unsigned DwarfFile::AbbrevMapInfo::getHashValue(const DIEAbbrev *Abbrev) {
+  return Abbrev->getHash();
+}
+
+bool DwarfFile::AbbrevMapInfo::isEqual(const DIEAbbrev *LHS,
+                                       const DIEAbbrev *RHS) {
+  if (LHS == RHS)
+    return true;
+  if (LHS == getEmptyKey() || LHS == getTombstoneKey() ||
+      RHS == getEmptyKey() || RHS == getTombstoneKey())
+    return false;
+  return LHS->isEqual(*RHS);
+}
+
 // Define a unique number for the abbreviation.
 //
 void DwarfFile::assignAbbrevNumber(DIEAbbrev &Abbrev) {
-  // Check the set for priors.
-  DIEAbbrev *InSet = AbbreviationsSet.GetOrInsertNode(&Abbrev);
+  // Check the map for priors, assigning the vector position + 1 as the number
+  // of a newly added abbreviation.
+  auto Ins = AbbreviationsMap.insert(
+      std::make_pair(&Abbrev, unsigned(Abbreviations.size() + 1)));
 
-  // If it's newly added.
-  if (InSet == &Abbrev) {
-    // Add to abbreviation list.
+  // If it's newly added, add it to the abbreviation list.
+  if (Ins.second) {
     Abbreviations.push_back(&Abbrev);
-
-    // Assign the vector position + 1 as its number.
-    Abbrev.setNumber(Abbreviations.size());
-  } else {
-    // Assign existing abbreviation number.
-    Abbrev.setNumber(InSet->getNumber());
+    ++NumAbbrevs;
   }
+
+  Abbrev.setNumber(Ins.first->second);
 }
 
 void DwarfFile::addUnit(std::unique_ptr<DwarfUnit> U) {
@@ -75,8 +95,12 @@ void DwarfFile::computeSizeAndOffsets() {
 
     // EndOffset here is CU-relative, after laying out
     // all of the CU DIE.
+    unsigned NumUnitDIEs = NumDIEs;
     unsigned EndOffset = computeSizeAndOffset(TheU->getUnitDie(), Offset);
     SecOffset += EndOffset;
+    DEBUG(dbgs() << "Unit at offset " << TheU->getDebugInfoOffset() << ": "
+                 << (NumDIEs - NumUnitDIEs) << " DIEs, " << EndOffset
+                 << " bytes\n");
   }
 }
 // Compute the size and offset of a DIE. The offset is relative to start of the
@@ -96,6 +120,8 @@ unsigned DwarfFile::computeSizeAndOffset(DIE &Die, unsigned Offset) {
 
   const SmallVectorImpl<DIEValue *> &Values = Die.getValues();
   const SmallVectorImpl<DIEAbbrevData> &AbbrevData = Abbrev.getData();
+  ++NumDIEs;
+  NumDIEAttributes += Values.size();
 
   // Size the DIE attribute values.
   for (unsigned i = 0, N = Values.size(); i < N; ++i)
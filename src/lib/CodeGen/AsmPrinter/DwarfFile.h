@@ -13,7 +13,6 @@
 #include "AddressPool.h"
 #include "DwarfStringPool.h"
 #include "llvm/ADT/DenseMap.h"
-#include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/Allocator.h"
@@ -36,8 +35,21 @@ class DwarfFile {
   // Target of Dwarf emission, used for sizing of abbreviations.
   AsmPrinter *Asm;
 
-  // Used to uniquely define abbreviations.
-  FoldingSet<DIEAbbrev> AbbreviationsSet;
+  // Hashes abbreviations by their precomputed hash and compares them by
+  // content, so that uniquing one does not need to profile it.
+  struct AbbrevMapInfo {
+    static DIEAbbrev *getEmptyKey() {
+      return DenseMapInfo<DIEAbbrev *>::getEmptyKey();
+    }
+    static DIEAbbrev *getTombstoneKey() {
+      return DenseMapInfo<DIEAbbrev *>::getTombstoneKey();
+    }
+    static unsigned getHashValue(const DIEAbbrev *Abbrev);
+    static bool isEqual(const DIEAbbrev *LHS, const DIEAbbrev *RHS);
+  };
+
+  // Used to uniquely define abbreviations, mapping them to their number.
+  DenseMap<DIEAbbrev *, unsigned, AbbrevMapInfo> AbbreviationsMap;
 
   // A list of all the unique abbreviations in use.
   std::vector<DIEAbbrev *> Abbreviations;
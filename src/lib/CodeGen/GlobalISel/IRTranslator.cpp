@@ -0,0 +1,163 @@
+//===-- llvm/CodeGen/GlobalISel/IRTranslator.cpp - IRTranslator --*- C++ -*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file implements the IRTranslator class.
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/GlobalISel/IRTranslator.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/CodeGen/GlobalISel/CallLowering.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Target/TargetOpcodes.h"
+#include "llvm/Target/TargetSubtargetInfo.h"
+
+#define DEBUG_TYPE "irtranslator"
+
+using namespace llvm;
+
+char IRTranslator::ID = 0;
+INITIALIZE_PASS(IRTranslator, "irtranslator", "IRTranslator LLVM IR -> MI",
+                false, false)
+
+IRTranslator::IRTranslator() : MachineFunctionPass(ID), CLI(nullptr),
+                               MRI(nullptr) {
+  initializeIRTranslatorPass(*PassRegistry::getPassRegistry());
+}
+
+unsigned IRTranslator::getOrCreateVReg(const Value &V) {
+  const DataLayout &DL = MIRBuilder.getMF().getFunction()->getParent()
+                             ->getDataLayout();
+  unsigned Size = DL.getTypeSizeInBits(V.getType());
+  if (const ConstantInt *CI = dyn_cast<ConstantInt>(&V)) {
+    if (CI->getBitWidth() > 64)
+      return 0;
+    unsigned VReg = MRI->createGenericVirtualRegister(Size);
+    MIRBuilder.buildConstant(VReg, CI->getSExtValue());
+    return VReg;
+  }
+  if (isa<Constant>(V))
+    return 0;
+
+  unsigned &VReg = ValToVReg[&V];
+  if (!VReg)
+    VReg = MRI->createGenericVirtualRegister(Size);
+  return VReg;
+}
+
+MachineBasicBlock &IRTranslator::getOrCreateBB(const BasicBlock &BB) {
+  MachineBasicBlock *&MBB = BBToMBB[&BB];
+  if (!MBB) {
+    MachineFunction &MF = MIRBuilder.getMF();
+    MBB = MF.CreateMachineBasicBlock(&BB);
+    MF.push_back(MBB);
+  }
+  return *MBB;
+}
+
+bool IRTranslator::translateBinaryOp(unsigned Opcode,
+                                     const Instruction &Inst) {
+  if (!Inst.getType()->isIntegerTy())
+    return false;
+  unsigned Op0 = getOrCreateVReg(*Inst.getOperand(0));
+  unsigned Op1 = getOrCreateVReg(*Inst.getOperand(1));
+  if (!Op0 || !Op1)
+    return false;
+  MIRBuilder.buildInstr(Opcode, getOrCreateVReg(Inst), Op0, Op1);
+  return true;
+}
+
+bool IRTranslator::translateReturn(const Instruction &Inst) {
+  const Value *Ret = cast<ReturnInst>(Inst).getReturnValue();
+  unsigned VReg = 0;
+  if (Ret) {
+    VReg = getOrCreateVReg(*Ret);
+    if (!VReg)
+      return false;
+  }
+  return CLI->lowerReturn(MIRBuilder, Ret, VReg);
+}
+
+bool IRTranslator::translateBr(const Instruction &Inst) {
+  const BranchInst &BrInst = cast<BranchInst>(Inst);
+  // Conditional branches need generic comparisons, which are not supported
+  // yet.
+  if (!BrInst.isUnconditional())
+    return false;
+  MachineBasicBlock &Succ = getOrCreateBB(*BrInst.getSuccessor(0));
+  MIRBuilder.buildInstr(TargetOpcode::G_BR, Succ);
+  MIRBuilder.getMBB().addSuccessor(&Succ);
+  return true;
+}
+
+bool IRTranslator::translate(const Instruction &Inst) {
+  MIRBuilder.setDebugLoc(Inst.getDebugLoc());
+  switch (Inst.getOpcode()) {
+  // Arithmetic and logical operations.
+  case Instruction::Add:
+    return translateBinaryOp(TargetOpcode::G_ADD, Inst);
+  case Instruction::Sub:
+    return translateBinaryOp(TargetOpcode::G_SUB, Inst);
+  case Instruction::Mul:
+    return translateBinaryOp(TargetOpcode::G_MUL, Inst);
+  case Instruction::And:
+    return translateBinaryOp(TargetOpcode::G_AND, Inst);
+  case Instruction::Or:
+    return translateBinaryOp(TargetOpcode::G_OR, Inst);
+  case Instruction::Xor:
+    return translateBinaryOp(TargetOpcode::G_XOR, Inst);
+  // Terminators.
+  case Instruction::Br:
+    return translateBr(Inst);
+  case Instruction::Ret:
+    return translateReturn(Inst);
+  default:
+    return false;
+  }
+}
+
+bool IRTranslator::runOnMachineFunction(MachineFunction &MF) {
+  const Function &F = *MF.getFunction();
+  if (F.empty())
+    return false;
+  CLI = MF.getSubtarget().getCallLowering();
+  if (!CLI)
+    report_fatal_error("The target does not support the global instruction "
+                       "selector");
+  MRI = &MF.getRegInfo();
+  MIRBuilder.setMF(MF);
+
+  // Create the blocks up front so that they keep the order of the IR.
+  for (const BasicBlock &BB : F)
+    getOrCreateBB(BB);
+
+  MIRBuilder.setMBB(getOrCreateBB(F.getEntryBlock()));
+  SmallVector<unsigned, 8> VRegArgs;
+  for (const Argument &Arg : F.args())
+    VRegArgs.push_back(getOrCreateVReg(Arg));
+  if (!CLI->lowerFormalArguments(MIRBuilder, F.getArgumentList(), VRegArgs))
+    report_fatal_error("Unable to lower arguments of " + F.getName());
+
+  for (const BasicBlock &BB : F) {
+    MIRBuilder.setMBB(getOrCreateBB(BB));
+    for (const Instruction &Inst : BB)
+      if (!translate(Inst))
+        report_fatal_error(Twine("Unable to translate instruction '") +
+                           Inst.getOpcodeName() + "' in " + F.getName());
+  }
+
+  ValToVReg.clear();
+  BBToMBB.clear();
+  return true;
+}
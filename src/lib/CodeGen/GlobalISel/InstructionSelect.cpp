@@ -0,0 +1,59 @@
+//===-- llvm/CodeGen/GlobalISel/InstructionSelect.cpp - Select ---*- C++ -*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file implements the InstructionSelect class.
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/GlobalISel/InstructionSelect.h"
+#include "llvm/CodeGen/GlobalISel/InstructionSelector.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineInstr.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetOpcodes.h"
+#include "llvm/Target/TargetSubtargetInfo.h"
+
+#define DEBUG_TYPE "instruction-select"
+
+using namespace llvm;
+
+char InstructionSelect::ID = 0;
+INITIALIZE_PASS(InstructionSelect, "instruction-select",
+                "Select target instructions out of generic instructions",
+                false, false)
+
+InstructionSelect::InstructionSelect() : MachineFunctionPass(ID) {
+  initializeInstructionSelectPass(*PassRegistry::getPassRegistry());
+}
+
+bool InstructionSelect::runOnMachineFunction(MachineFunction &MF) {
+  const InstructionSelector *ISel = MF.getSubtarget().getInstructionSelector();
+  if (!ISel)
+    report_fatal_error("The target does not support the global instruction "
+                       "selector");
+
+  bool Changed = false;
+  for (MachineBasicBlock &MBB : MF) {
+    // The iterator is moved past the instruction before selecting it, as the
+    // selection may replace it with new instructions inserted before it.
+    for (MachineBasicBlock::iterator I = MBB.begin(), E = MBB.end(); I != E;) {
+      MachineInstr &MI = *I++;
+      if (!TargetOpcode::isPreISelGenericOpcode(MI.getOpcode()))
+        continue;
+      DEBUG(dbgs() << "Selecting: " << MI);
+      if (!ISel->select(MI))
+        report_fatal_error("Unable to select instruction in " +
+                           MF.getFunction()->getName());
+      Changed = true;
+    }
+  }
+  return Changed;
+}
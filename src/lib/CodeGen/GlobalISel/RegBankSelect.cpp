@@ -0,0 +1,58 @@
+//===-- llvm/CodeGen/GlobalISel/RegBankSelect.cpp - RegBankSelect --*- C++ -*-//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file implements the RegBankSelect class.
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/GlobalISel/RegBankSelect.h"
+#include "llvm/CodeGen/GlobalISel/RegisterBankInfo.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Target/TargetSubtargetInfo.h"
+
+#define DEBUG_TYPE "regbankselect"
+
+using namespace llvm;
+
+char RegBankSelect::ID = 0;
+INITIALIZE_PASS(RegBankSelect, "regbankselect",
+                "Assign register bank of generic virtual registers",
+                false, false)
+
+RegBankSelect::RegBankSelect() : MachineFunctionPass(ID) {
+  initializeRegBankSelectPass(*PassRegistry::getPassRegistry());
+}
+
+bool RegBankSelect::runOnMachineFunction(MachineFunction &MF) {
+  const RegisterBankInfo *RBI = MF.getSubtarget().getRegBankInfo();
+  if (!RBI)
+    report_fatal_error("The target does not support register bank selection");
+
+  MachineRegisterInfo &MRI = MF.getRegInfo();
+  bool Changed = false;
+  for (unsigned i = 0, e = MRI.getNumVirtRegs(); i != e; ++i) {
+    unsigned VReg = TargetRegisterInfo::index2VirtReg(i);
+    unsigned Size = MRI.getSize(VReg);
+    if (!Size || MRI.getRegClass(VReg))
+      continue;
+    // Registers that were created and then erased have nothing to assign.
+    if (MRI.reg_nodbg_empty(VReg))
+      continue;
+    const TargetRegisterClass *RC = RBI->getRegBankClass(VReg, Size, MRI);
+    if (!RC)
+      report_fatal_error("Unable to assign a register bank to a " +
+                         Twine(Size) + "-bit value in " +
+                         MF.getFunction()->getName());
+    MRI.setRegClass(VReg, RC);
+    Changed = true;
+  }
+  return Changed;
+}
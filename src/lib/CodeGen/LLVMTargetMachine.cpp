@@ -46,6 +46,10 @@ static cl::opt<cl::boolOrDefault>
 EnableFastISelOption("fast-isel", cl::Hidden,
   cl::desc("Enable the \"fast\" instruction selector"));
 
+static cl::opt<bool>
+EnableGlobalISel("global-isel", cl::Hidden, cl::init(false),
+  cl::desc("Enable the \"global\" instruction selector"));
+
 void LLVMTargetMachine::initAsmInfo() {
   MRI = TheTarget.createMCRegInfo(getTargetTriple());
   MII = TheTarget.createMCInstrInfo();
@@ -134,7 +138,13 @@ static MCContext *addPassesToGenerateCode(LLVMTargetMachine *TM,
     TM->setFastISel(true);
 
   // Ask the target for an isel.
-  if (PassConfig->addInstSelector())
+  if (EnableGlobalISel) {
+    // The global instruction selector translates whole functions into generic
+    // machine instructions, and selects them without a SelectionDAG.
+    if (PassConfig->addIRTranslator() || PassConfig->addRegBankSelect() ||
+        PassConfig->addGlobalInstructionSelect())
+      return nullptr;
+  } else if (PassConfig->addInstSelector())
     return nullptr;
 
   PassConfig->addMachinePasses();
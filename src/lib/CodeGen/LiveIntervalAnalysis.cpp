@@ -19,6 +19,7 @@
 #include "LiveRangeCalc.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/CodeGen/LiveVariables.h"
 #include "llvm/CodeGen/MachineBlockFrequencyInfo.h"
@@ -44,6 +45,10 @@ using namespace llvm;
 
 #define DEBUG_TYPE "regalloc"
 
+STATISTIC(NumIntervalKB,  "Kilobytes used by virtual register live intervals");
+STATISTIC(NumSubRangeKB,  "Kilobytes used by subregister live ranges");
+STATISTIC(NumValNoKB,     "Kilobytes used by live range value numbers");
+
 char LiveIntervals::ID = 0;
 char &llvm::LiveIntervalsID = LiveIntervals::ID;
 INITIALIZE_PASS_BEGIN(LiveIntervals, "liveintervals",
@@ -140,6 +145,7 @@ bool LiveIntervals::runOnMachineFunction(MachineFunction &fn) {
   computeVirtRegs();
   computeRegMasks();
   computeLiveInRegUnits();
+  countMemoryUsage();
 
   if (EnablePrecomputePhysRegs) {
     // For stress testing, precompute live ranges of all physical register
@@ -212,6 +218,31 @@ void LiveIntervals::computeVirtRegs() {
   }
 }
 
+/// Return the approximate number of bytes used by \p LR, counting the storage
+/// of its segments and value numbers whether it is inline or on the heap.
+static size_t getLiveRangeBytes(const LiveRange &LR) {
+  return sizeof(LR) - sizeof(LR.segments) - sizeof(LR.valnos) +
+         capacity_in_bytes(LR.segments) + capacity_in_bytes(LR.valnos);
+}
+
+void LiveIntervals::countMemoryUsage() {
+  if (!AreStatisticsEnabled())
+    return;
+  uint64_t IntervalBytes = 0, SubRangeBytes = 0;
+  for (unsigned i = 0, e = VirtRegIntervals.size(); i != e; ++i) {
+    const LiveInterval *LI =
+        VirtRegIntervals[TargetRegisterInfo::index2VirtReg(i)];
+    if (!LI)
+      continue;
+    IntervalBytes += getLiveRangeBytes(*LI) + sizeof(*LI) - sizeof(LiveRange);
+    for (const LiveInterval::SubRange &SR : LI->subranges())
+      SubRangeBytes += getLiveRangeBytes(SR) + sizeof(SR) - sizeof(LiveRange);
+  }
+  NumIntervalKB += (IntervalBytes + 512) / 1024;
+  NumSubRangeKB += (SubRangeBytes + 512) / 1024;
+  NumValNoKB += (VNInfoAllocator.getTotalMemory() + 512) / 1024;
+}
+
 void LiveIntervals::computeRegMasks() {
   RegMaskBlocks.resize(MF->getNumBlockIDs());
 
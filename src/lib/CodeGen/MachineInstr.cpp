@@ -1716,12 +1716,13 @@ void MachineInstr::print(raw_ostream &OS, ModuleSlotTracker &MST,
     }
   }
 
-  // Print the regclass of any virtual registers encountered.
+  // Print the regclass of any virtual registers encountered. Generic virtual
+  // registers, which have no regclass yet, are printed as '_'.
   if (MRI && !VirtRegs.empty()) {
     if (!HaveSemi) OS << ";"; HaveSemi = true;
     for (unsigned i = 0; i != VirtRegs.size(); ++i) {
       const TargetRegisterClass *RC = MRI->getRegClass(VirtRegs[i]);
-      OS << " " << TRI->getRegClassName(RC)
+      OS << " " << (RC ? TRI->getRegClassName(RC) : "_")
          << ':' << PrintReg(VirtRegs[i]);
       for (unsigned j = i+1; j != VirtRegs.size();) {
         if (MRI->getRegClass(VirtRegs[j]) != RC) {
@@ -27,6 +27,7 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/GraphWriter.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetInstrInfo.h"
 #include <queue>
@@ -473,7 +474,11 @@ void MachineSchedulerBase::scheduleRegions(ScheduleDAGInstrs &Scheduler) {
 
       // Schedule a region: possibly reorder instructions.
       // This invalidates 'RegionEnd' and 'I'.
-      Scheduler.schedule();
+      {
+        NamedRegionTimer T("Region Scheduling", "Instruction Scheduling",
+                           TimePassesIsEnabled);
+        Scheduler.schedule();
+      }
 
       // Close the current region.
       Scheduler.exitRegion();
@@ -907,6 +907,16 @@ MachineVerifier::visitMachineOperand(const MachineOperand *MO, unsigned MONum) {
       } else {
         // Virtual register.
         const TargetRegisterClass *RC = MRI->getRegClass(Reg);
+        if (!RC) {
+          // Generic virtual registers get a register class from register
+          // bank selection, and cannot be constrained before that.
+          if (!MRI->getSize(Reg))
+            report("Virtual register has no register class", MO, MONum);
+          else if (SubIdx)
+            report("Generic virtual register with a subregister index", MO,
+                   MONum);
+          return;
+        }
         if (SubIdx) {
           const TargetRegisterClass *SRC =
             TRI->getSubClassWithSubReg(RC, SubIdx);
@@ -0,0 +1,68 @@
+//===-- ParallelCG.cpp ----------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines functions that can be used for parallel code generation.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/ParallelCG.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include <vector>
+
+using namespace llvm;
+
+bool llvm::splitCodeGen(Module &M, ArrayRef<raw_ostream *> OSs,
+                        const PartitionCodeGenFn &CodeGen, std::string &ErrMsg,
+                        const std::function<void(LLVMContext &)> &SetupContext) {
+  if (OSs.size() == 1)
+    return CodeGen(M, *OSs[0], ErrMsg);
+
+  std::vector<SmallString<0>> Partitions;
+  SplitModule(M, OSs.size(), [&](std::unique_ptr<Module> MPart) {
+    Partitions.emplace_back();
+    raw_svector_ostream BCOS(Partitions.back());
+    WriteBitcodeToFile(MPart.get(), BCOS);
+  });
+
+  std::vector<std::string> Errors(OSs.size());
+  {
+    ThreadPool Pool(OSs.size());
+    for (unsigned I = 0, E = OSs.size(); I != E; ++I)
+      Pool.async([&, I] {
+        LLVMContext Ctx;
+        if (SetupContext)
+          SetupContext(Ctx);
+        MemoryBufferRef Buffer(StringRef(Partitions[I].data(),
+                                         Partitions[I].size()),
+                               M.getModuleIdentifier());
+        ErrorOr<Module *> MPartOrErr = parseBitcodeFile(Buffer, Ctx);
+        if (std::error_code EC = MPartOrErr.getError()) {
+          Errors[I] = EC.message();
+          return;
+        }
+        std::unique_ptr<Module> MPart(MPartOrErr.get());
+        if (!CodeGen(*MPart, *OSs[I], Errors[I]) && Errors[I].empty())
+          Errors[I] = "code generation failed";
+      });
+  }
+
+  for (const std::string &Error : Errors)
+    if (!Error.empty()) {
+      ErrMsg = Error;
+      return false;
+    }
+  return true;
+}
@@ -42,6 +42,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetSubtargetInfo.h"
@@ -54,6 +55,7 @@ using namespace llvm;
 STATISTIC(NumGlobalSplits, "Number of split global live ranges");
 STATISTIC(NumLocalSplits,  "Number of split local live ranges");
 STATISTIC(NumEvicted,      "Number of interferences evicted");
+STATISTIC(NumOverBudget,   "Number of functions exceeding the allocation budget");
 
 static cl::opt<SplitEditor::ComplementSpillMode>
 SplitSpillMode("split-spill-mode", cl::Hidden,
@@ -86,6 +88,30 @@ static cl::opt<bool> EnableLocalReassignment(
              "may be compile time intensive"),
     cl::init(false));
 
+static cl::opt<unsigned> EvictInterferenceCutoff(
+    "regalloc-eviction-max-interference-cutoff", cl::Hidden,
+    cl::desc("Number of interferences after which we declare an interference "
+             "unevictable and bail out"),
+    cl::init(10));
+
+static cl::opt<unsigned> GrowRegionComplexityBudget(
+    "grow-region-complexity-budget", cl::Hidden,
+    cl::desc("Maximum number of edge bundle blocks visited when growing a "
+             "single split region, 0 for no limit"),
+    cl::init(10000));
+
+static cl::opt<unsigned> AllocBudget(
+    "regalloc-greedy-budget", cl::Hidden,
+    cl::desc("Amount of work per function after which the greedy allocator "
+             "stops region splitting and non-urgent evictions, 0 for no limit"),
+    cl::init(20000000));
+
+static cl::opt<bool> PrintFunctionStats(
+    "regalloc-greedy-stats", cl::Hidden,
+    cl::desc("Print the evictions, splits, spills and time of each function "
+             "to the debug output"),
+    cl::init(false));
+
 // FIXME: Find a good default for this flag and remove the flag.
 static cl::opt<unsigned>
 CSRFirstTimeCost("regalloc-csr-first-time-cost",
@@ -126,6 +152,20 @@ class RAGreedy : public MachineFunctionPass,
   PQueue Queue;
   unsigned NextCascade;
 
+  /// Allocation work done in the current function. This counts the blocks
+  /// visited while growing split regions and the register units checked for
+  /// eviction, which dominate the allocation time of huge functions. Once it
+  /// exceeds AllocBudget, only the cheaper strategies are used.
+  uint64_t Work;
+
+  /// Per function counters reported by -regalloc-greedy-stats.
+  struct FunctionStats {
+    unsigned Evictions;
+    unsigned GlobalSplits;
+    unsigned LocalSplits;
+    unsigned Spills;
+  } Stats;
+
   // Live ranges pass through a number of stages as we try to allocate them.
   // Some of the stages may also create new live ranges:
   //
@@ -334,7 +374,9 @@ private:
   BlockFrequency calcSpillCost();
   bool addSplitConstraints(InterferenceCache::Cursor, BlockFrequency&);
   void addThroughConstraints(InterferenceCache::Cursor, ArrayRef<unsigned>);
-  void growRegion(GlobalSplitCandidate &Cand);
+  bool growRegion(GlobalSplitCandidate &Cand);
+  bool isOverBudget() const { return AllocBudget && Work > AllocBudget; }
+  void addWork(uint64_t Amount);
   BlockFrequency calcGlobalSplitCost(GlobalSplitCandidate&);
   bool calcCompactRegion(GlobalSplitCandidate&);
   void splitAroundRegion(LiveRangeEdit&, ArrayRef<unsigned>);
@@ -718,8 +760,10 @@ bool RAGreedy::canEvictInterference(LiveInterval &VirtReg, unsigned PhysReg,
   EvictionCost Cost;
   for (MCRegUnitIterator Units(PhysReg, TRI); Units.isValid(); ++Units) {
     LiveIntervalUnion::Query &Q = Matrix->query(VirtReg, *Units);
-    // If there is 10 or more interferences, chances are one is heavier.
-    if (Q.collectInterferingVRegs(10) >= 10)
+    // If there are too many interferences, chances are one is heavier.
+    unsigned NumIntf = Q.collectInterferingVRegs(EvictInterferenceCutoff);
+    addWork(NumIntf + 1);
+    if (NumIntf >= EvictInterferenceCutoff)
       return false;
 
     // Check if any interfering live range is heavier than MaxWeight.
@@ -811,6 +855,7 @@ void RAGreedy::evictInterference(LiveInterval &VirtReg, unsigned PhysReg,
            "Cannot decrease cascade number, illegal eviction");
     ExtraRegInfo[Intf->reg].Cascade = Cascade;
     ++NumEvicted;
+    ++Stats.Evictions;
     NewVRegs.push_back(Intf->reg);
   }
 }
@@ -825,6 +870,11 @@ unsigned RAGreedy::tryEvict(LiveInterval &VirtReg,
                             unsigned CostPerUseLimit) {
   NamedRegionTimer T("Evict", TimerGroupName, TimePassesIsEnabled);
 
+  // Once over budget, only unspillable ranges may evict. The others are split
+  // or spilled instead, which avoids long eviction cascades.
+  if (isOverBudget() && VirtReg.isSpillable())
+    return 0;
+
   // Keep track of the cheapest interference seen so far.
   EvictionCost BestCost;
   BestCost.setMax();
@@ -1000,14 +1050,16 @@ void RAGreedy::addThroughConstraints(InterferenceCache::Cursor Intf,
   SpillPlacer->addLinks(makeArrayRef(TBS, T));
 }
 
-void RAGreedy::growRegion(GlobalSplitCandidate &Cand) {
+/// growRegion - Grow the region where Cand's register should be live by
+/// adding the through blocks connected to positive bundles. Return false when
+/// this takes more than GrowRegionComplexityBudget steps, in which case Cand
+/// should be discarded.
+bool RAGreedy::growRegion(GlobalSplitCandidate &Cand) {
   // Keep track of through blocks that have not been added to SpillPlacer.
   BitVector Todo = SA->getThroughBlocks();
   SmallVectorImpl<unsigned> &ActiveBlocks = Cand.ActiveBlocks;
   unsigned AddedTo = 0;
-#ifndef NDEBUG
   unsigned Visited = 0;
-#endif
 
   for (;;) {
     ArrayRef<unsigned> NewBundles = SpillPlacer->getRecentPositive();
@@ -1016,6 +1068,12 @@ void RAGreedy::growRegion(GlobalSplitCandidate &Cand) {
       unsigned Bundle = NewBundles[i];
       // Look at all blocks connected to Bundle in the full graph.
       ArrayRef<unsigned> Blocks = Bundles->getBlocks(Bundle);
+      Visited += Blocks.size();
+      addWork(Blocks.size());
+      if (GrowRegionComplexityBudget && Visited > GrowRegionComplexityBudget) {
+        DEBUG(dbgs() << ", over budget after v=" << Visited);
+        return false;
+      }
       for (ArrayRef<unsigned>::iterator I = Blocks.begin(), E = Blocks.end();
            I != E; ++I) {
         unsigned Block = *I;
@@ -1024,9 +1082,6 @@ void RAGreedy::growRegion(GlobalSplitCandidate &Cand) {
         Todo.reset(Block);
         // This is a new through block. Add it to SpillPlacer later.
         ActiveBlocks.push_back(Block);
-#ifndef NDEBUG
-        ++Visited;
-#endif
       }
     }
     // Any new blocks to add?
@@ -1048,6 +1103,17 @@ void RAGreedy::growRegion(GlobalSplitCandidate &Cand) {
     SpillPlacer->iterate();
   }
   DEBUG(dbgs() << ", v=" << Visited);
+  return true;
+}
+
+void RAGreedy::addWork(uint64_t Amount) {
+  bool WasOverBudget = isOverBudget();
+  Work += Amount;
+  if (!WasOverBudget && isOverBudget()) {
+    ++NumOverBudget;
+    DEBUG(dbgs() << "\nAllocation budget exceeded in " << MF->getName()
+                 << ", falling back to block splitting and spilling\n");
+  }
 }
 
 /// calcCompactRegion - Compute the set of edge bundles that should be live
@@ -1078,10 +1144,10 @@ bool RAGreedy::calcCompactRegion(GlobalSplitCandidate &Cand) {
     return false;
   }
 
-  growRegion(Cand);
+  bool Grown = growRegion(Cand);
   SpillPlacer->finish();
 
-  if (!Cand.LiveBundles.any()) {
+  if (!Grown || !Cand.LiveBundles.any()) {
     DEBUG(dbgs() << ", none.\n");
     return false;
   }
@@ -1262,6 +1328,7 @@ void RAGreedy::splitAroundRegion(LiveRangeEdit &LREdit,
   }
 
   ++NumGlobalSplits;
+  ++Stats.GlobalSplits;
 
   SmallVector<unsigned, 8> IntvMap;
   SE->finish(&IntvMap);
@@ -1392,10 +1459,15 @@ unsigned RAGreedy::calculateRegionSplitCost(LiveInterval &VirtReg,
       });
       continue;
     }
-    growRegion(Cand);
+    bool Grown = growRegion(Cand);
 
     SpillPlacer->finish();
 
+    if (!Grown) {
+      DEBUG(dbgs() << ".\n");
+      continue;
+    }
+
     // No live bundles, defer to splitSingleBlocks().
     if (!Cand.LiveBundles.any()) {
       DEBUG(dbgs() << " no bundles.\n");
@@ -1896,6 +1968,7 @@ unsigned RAGreedy::tryLocalSplit(LiveInterval &VirtReg, AllocationOrder &Order,
     DEBUG(dbgs() << '\n');
   }
   ++NumLocalSplits;
+  ++Stats.LocalSplits;
 
   return 0;
 }
@@ -1941,7 +2014,9 @@ unsigned RAGreedy::trySplit(LiveInterval &VirtReg, AllocationOrder &Order,
   // First try to split around a region spanning multiple blocks. RS_Split2
   // ranges already made dubious progress with region splitting, so they go
   // straight to single block splitting.
-  if (getStage(VirtReg) < RS_Split2) {
+  // Region splitting is also skipped once the function is over budget, since
+  // its cost grows with the number of blocks times the number of candidates.
+  if (getStage(VirtReg) < RS_Split2 && !isOverBudget()) {
     unsigned PhysReg = tryRegionSplit(VirtReg, Order, NewVRegs);
     if (PhysReg || !NewVRegs.empty())
       return PhysReg;
@@ -2508,6 +2583,7 @@ unsigned RAGreedy::selectOrSplitImpl(LiveInterval &VirtReg,
   NamedRegionTimer T("Spiller", TimerGroupName, TimePassesIsEnabled);
   LiveRangeEdit LRE(&VirtReg, NewVRegs, *MF, *LIS, VRM, this);
   spiller().spill(LRE);
+  ++Stats.Spills;
   setStage(NewVRegs.begin(), NewVRegs.end(), RS_Done);
 
   if (VerifyEnabled)
@@ -2522,6 +2598,10 @@ bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
   DEBUG(dbgs() << "********** GREEDY REGISTER ALLOCATION **********\n"
                << "********** Function: " << mf.getName() << '\n');
 
+  TimeRecord StartTime;
+  if (PrintFunctionStats)
+    StartTime = TimeRecord::getCurrentTime(/*Start=*/true);
+
   MF = &mf;
   TRI = MF->getSubtarget().getRegisterInfo();
   TII = MF->getSubtarget().getInstrInfo();
@@ -2560,9 +2640,23 @@ bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
   IntfCache.init(MF, Matrix->getLiveUnions(), Indexes, LIS, TRI);
   GlobalCand.resize(32);  // This will grow as needed.
   SetOfBrokenHints.clear();
+  Work = 0;
+  Stats = FunctionStats();
 
   allocatePhysRegs();
   tryHintsRecoloring();
+
+  if (PrintFunctionStats) {
+    TimeRecord Elapsed = TimeRecord::getCurrentTime(/*Start=*/false);
+    Elapsed -= StartTime;
+    dbgs() << "Greedy allocation of " << mf.getName() << ": "
+           << Stats.Evictions << " evictions, " << Stats.GlobalSplits
+           << " global splits, " << Stats.LocalSplits << " local splits, "
+           << Stats.Spills << " spills, work " << Work
+           << (isOverBudget() ? " (over budget)" : "") << ", "
+           << format("%.4f", Elapsed.getWallTime()) << "s\n";
+  }
+
   releaseMemory();
   return true;
 }
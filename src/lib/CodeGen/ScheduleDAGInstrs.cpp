@@ -16,6 +16,7 @@
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallSet.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/ValueTracking.h"
 #include "llvm/CodeGen/LiveIntervalAnalysis.h"
@@ -32,6 +33,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetInstrInfo.h"
 #include "llvm/Target/TargetMachine.h"
@@ -43,6 +45,9 @@ using namespace llvm;
 
 #define DEBUG_TYPE "misched"
 
+STATISTIC(NumHugeRegionBarriers,
+          "Number of memory operations turned into barriers in huge regions");
+
 static cl::opt<bool> EnableAASchedMI("enable-aa-sched-mi", cl::Hidden,
     cl::ZeroOrMore, cl::init(false),
     cl::desc("Enable use of AA during MI DAG construction"));
@@ -50,6 +55,14 @@ static cl::opt<bool> EnableAASchedMI("enable-aa-sched-mi", cl::Hidden,
 static cl::opt<bool> UseTBAA("use-tbaa-in-sched-mi", cl::Hidden,
     cl::init(true), cl::desc("Enable use of TBAA during MI DAG construction"));
 
+// Every memory operation is checked against all the memory operations below it
+// that it may alias, so the DAG construction is quadratic in the number of
+// tracked memory operations.
+static cl::opt<unsigned> HugeRegion("dag-maps-huge-region", cl::Hidden,
+    cl::init(1000), cl::desc("The number of memory operations tracked while "
+    "building the scheduling DAG, after which the next one is made a barrier "
+    "and the tracked ones are dropped, 0 for no limit"));
+
 ScheduleDAGInstrs::ScheduleDAGInstrs(MachineFunction &mf,
                                      const MachineLoopInfo *mli,
                                      bool IsPostRAFlag, bool RemoveKillFlags,
@@ -759,6 +772,9 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
                                                        : ST.useAA();
   AliasAnalysis *AAForDep = UseAA ? AA : nullptr;
 
+  NamedRegionTimer T("DAG Construction", "Instruction Scheduling",
+                     TimePassesIsEnabled);
+
   MISUnitMap.clear();
   ScheduleDAG::clearDAG();
 
@@ -781,6 +797,9 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
   MapVector<ValueType, std::vector<SUnit *> > AliasMemDefs, NonAliasMemDefs;
   MapVector<ValueType, std::vector<SUnit *> > AliasMemUses, NonAliasMemUses;
   std::set<SUnit*> RejectMemNodes;
+  // The number of SUnits in the four maps above and in PendingLoads, and the
+  // part of them in the NonAlias maps.
+  unsigned NumMemNodes = 0, NumNonAliasMemNodes = 0;
 
   // Remove any stale debug info; sometimes BuildSchedGraph is called again
   // without emitting the info from the previous call.
@@ -872,7 +891,15 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
     // TODO: Use an AliasAnalysis and do real alias-analysis queries, and
     // produce more precise dependence information.
     unsigned TrueMemOrderLatency = MI->mayStore() ? 1 : 0;
-    if (isGlobalMemoryObject(AA, MI)) {
+    // In a huge region, bound the cost of the chain dependencies by making
+    // this memory operation a barrier. It then depends on all the tracked
+    // operations, which can all be forgotten. This only adds ordering.
+    bool IsHugeRegionBarrier = HugeRegion && NumMemNodes >= HugeRegion &&
+                               (MI->mayStore() ||
+                                (MI->mayLoad() && !MI->isInvariantLoad(AA)));
+    if (IsHugeRegionBarrier)
+      ++NumHugeRegionBarriers;
+    if (IsHugeRegionBarrier || isGlobalMemoryObject(AA, MI)) {
       // Be conservative with these and add dependencies on all memory
       // references, even those that are known to not alias.
       for (MapVector<ValueType, std::vector<SUnit *> >::iterator I =
@@ -900,6 +927,8 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
       RejectMemNodes.clear();
       NonAliasMemDefs.clear();
       NonAliasMemUses.clear();
+      NumMemNodes -= NumNonAliasMemNodes;
+      NumNonAliasMemNodes = 0;
 
       // fall-through
     new_alias_chain:
@@ -933,6 +962,7 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
       PendingLoads.clear();
       AliasMemDefs.clear();
       AliasMemUses.clear();
+      NumMemNodes = NumNonAliasMemNodes;
     } else if (MI->mayStore()) {
       // Add dependence on barrier chain, if needed.
       // There is no point to check aliasing on barrier event. Even if
@@ -970,20 +1000,22 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
                                I->second[i], RejectMemNodes, 0, true);
 
           // If we're not using AA, then we only need one store per object.
-          if (!AAForDep)
+          if (!AAForDep) {
+            NumMemNodes -= I->second.size();
+            if (!ThisMayAlias)
+              NumNonAliasMemNodes -= I->second.size();
             I->second.clear();
+          }
           I->second.push_back(SU);
         } else {
-          if (ThisMayAlias) {
-            if (!AAForDep)
-              AliasMemDefs[V].clear();
+          if (ThisMayAlias)
             AliasMemDefs[V].push_back(SU);
-          } else {
-            if (!AAForDep)
-              NonAliasMemDefs[V].clear();
+          else
             NonAliasMemDefs[V].push_back(SU);
-          }
         }
+        ++NumMemNodes;
+        if (!ThisMayAlias)
+          ++NumNonAliasMemNodes;
         // Handle the uses in MemUses, if there are any.
         MapVector<ValueType, std::vector<SUnit *> >::iterator J =
           ((ThisMayAlias) ? AliasMemUses.find(V) : NonAliasMemUses.find(V));
@@ -994,6 +1026,9 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
             addChainDependency(AAForDep, MFI, *TM.getDataLayout(), SU,
                                J->second[i], RejectMemNodes,
                                TrueMemOrderLatency, true);
+          NumMemNodes -= J->second.size();
+          if (!ThisMayAlias)
+            NumNonAliasMemNodes -= J->second.size();
           J->second.clear();
         }
       }
@@ -1029,6 +1064,7 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
                                  I->second[i], RejectMemNodes);
 
           PendingLoads.push_back(SU);
+          ++NumMemNodes;
           MayAlias = true;
         } else {
           MayAlias = false;
@@ -1055,6 +1091,9 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
             AliasMemUses[V].push_back(SU);
           else
             NonAliasMemUses[V].push_back(SU);
+          ++NumMemNodes;
+          if (!ThisMayAlias)
+            ++NumNonAliasMemNodes;
         }
         if (MayAlias)
           adjustChainDeps(AA, MFI, *TM.getDataLayout(), SU, &ExitSU,
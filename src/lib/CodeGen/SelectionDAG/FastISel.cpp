@@ -1083,7 +1083,21 @@ bool FastISel::selectIntrinsicCall(const IntrinsicInst *II) {
   case Intrinsic::lifetime_end:
   // The donothing intrinsic does, well, nothing.
   case Intrinsic::donothing:
+  // Neither assumptions nor annotations nor invariant regions generate code.
+  case Intrinsic::assume:
+  case Intrinsic::var_annotation:
+  case Intrinsic::invariant_end:
     return true;
+  case Intrinsic::invariant_start: {
+    // Discard the region information; the result is only used to end it.
+    if (II->use_empty())
+      return true;
+    unsigned ResultReg = getRegForValue(UndefValue::get(II->getType()));
+    if (!ResultReg)
+      return false;
+    updateValueMap(II, ResultReg);
+    return true;
+  }
   case Intrinsic::dbg_declare: {
     const DbgDeclareInst *DI = cast<DbgDeclareInst>(II);
     assert(DI->getVariable() && "Missing variable");
@@ -1204,6 +1218,9 @@ bool FastISel::selectIntrinsicCall(const IntrinsicInst *II) {
     updateValueMap(II, ResultReg);
     return true;
   }
+  // The annotations and expect forward their first operand.
+  case Intrinsic::annotation:
+  case Intrinsic::ptr_annotation:
   case Intrinsic::expect: {
     unsigned ResultReg = getRegForValue(II->getArgOperand(0));
     if (!ResultReg)
@@ -46,6 +46,7 @@
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetInstrInfo.h"
@@ -176,6 +177,10 @@ static cl::opt<bool>
 EnableFastISelAbortArgs("fast-isel-abort-args", cl::Hidden,
           cl::desc("Enable abort calls when \"fast\" instruction selection "
                    "fails to lower a formal argument"));
+static cl::opt<bool>
+ReportFastISelFallbacks("fast-isel-report-fallbacks", cl::Hidden,
+          cl::desc("Report how often the \"fast\" instruction selector falls "
+                   "back to SelectionDAG for each opcode"));
 
 static cl::opt<bool>
 UseMBPI("use-mbpi",
@@ -362,6 +367,13 @@ SelectionDAGISel::~SelectionDAGISel() {
   delete FuncInfo;
 }
 
+bool SelectionDAGISel::doFinalization(Module &M) {
+  if (ReportFastISelFallbacks && !FastISelCounts.empty())
+    printFastISelFallbacks(dbgs());
+  FastISelCounts.clear();
+  return MachineFunctionPass::doFinalization(M);
+}
+
 void SelectionDAGISel::getAnalysisUsage(AnalysisUsage &AU) const {
   AU.addRequired<AliasAnalysis>();
   AU.addPreserved<AliasAnalysis>();
@@ -1240,6 +1252,51 @@ static void mergeIncomingSwiftErrors(FunctionLoweringInfo *FuncInfo,
   }
 }
 
+void SelectionDAGISel::countFastISelSelected(const Instruction *I) {
+  if (!ReportFastISelFallbacks)
+    return;
+  if (FastISelCounts.size() <= I->getOpcode())
+    FastISelCounts.resize(I->getOpcode() + 1);
+  ++FastISelCounts[I->getOpcode()].Selected;
+}
+
+void SelectionDAGISel::countFastISelMiss(const Instruction *I,
+                                         unsigned NumFellBack) {
+  if (!ReportFastISelFallbacks)
+    return;
+  if (FastISelCounts.size() <= I->getOpcode())
+    FastISelCounts.resize(I->getOpcode() + 1);
+  ++FastISelCounts[I->getOpcode()].Missed;
+  FastISelCounts[I->getOpcode()].FellBack += NumFellBack;
+}
+
+/// printFastISelFallbacks - Print, for each opcode that fast isel has seen,
+/// the fraction of its instructions that fast isel missed, and the number of
+/// instructions that SelectionDAG had to select because of those misses.
+void SelectionDAGISel::printFastISelFallbacks(raw_ostream &OS) const {
+  OS << "===" << std::string(73, '-') << "===\n"
+     << "                       FastISel fallbacks by opcode\n"
+     << "===" << std::string(73, '-') << "===\n"
+     << "Opcode                 Selected     Missed   Miss %    Fell back\n";
+  unsigned TotalSelected = 0, TotalMissed = 0, TotalFellBack = 0;
+  for (unsigned Opc = 0, E = FastISelCounts.size(); Opc != E; ++Opc) {
+    const FastISelOpcodeCounts &C = FastISelCounts[Opc];
+    unsigned Seen = C.Selected + C.Missed;
+    if (!Seen)
+      continue;
+    OS << format("%-20s %10u %10u %7.2f%% %12u\n",
+                 Instruction::getOpcodeName(Opc), C.Selected, C.Missed,
+                 100.0 * C.Missed / Seen, C.FellBack);
+    TotalSelected += C.Selected;
+    TotalMissed += C.Missed;
+    TotalFellBack += C.FellBack;
+  }
+  unsigned TotalSeen = TotalSelected + TotalMissed;
+  OS << format("Total                %10u %10u %7.2f%% %12u\n", TotalSelected,
+               TotalMissed, TotalSeen ? 100.0 * TotalMissed / TotalSeen : 0.0,
+               TotalFellBack);
+}
+
 void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
   // Initialize the Fast-ISel state, if needed.
   FastISel *FastIS = nullptr;
@@ -1342,6 +1399,7 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
         if (FastIS->selectInstruction(Inst)) {
           --NumFastIselRemaining;
           ++NumFastIselSuccess;
+          countFastISelSelected(Inst);
           // If fast isel succeeded, skip over all the folded instructions, and
           // then see if there is a load right before the selected instructions.
           // Try to fold the load if so.
@@ -1358,6 +1416,7 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
             BI = std::next(BasicBlock::const_iterator(BeforeInst));
             --NumFastIselRemaining;
             ++NumFastIselSuccess;
+            countFastISelSelected(BeforeInst);
           }
           continue;
         }
@@ -1397,6 +1456,7 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
           // selection may have handled the call, input args, etc.
           unsigned RemainingNow = std::distance(Begin, BI);
           NumFastIselFailures += NumFastIselRemaining - RemainingNow;
+          countFastISelMiss(Inst, NumFastIselRemaining - RemainingNow);
           NumFastIselRemaining = RemainingNow;
           continue;
         }
@@ -1404,12 +1464,14 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
         if (isa<TerminatorInst>(Inst) && !isa<BranchInst>(Inst)) {
           // Don't abort, and use a different message for terminator misses.
           NumFastIselFailures += NumFastIselRemaining;
+          countFastISelMiss(Inst, NumFastIselRemaining);
           if (EnableFastISelVerbose || EnableFastISelAbort) {
             dbgs() << "FastISel missed terminator: ";
             Inst->dump();
           }
         } else {
           NumFastIselFailures += NumFastIselRemaining;
+          countFastISelMiss(Inst, NumFastIselRemaining);
           if (EnableFastISelVerbose || EnableFastISelAbort) {
             dbgs() << "FastISel miss: ";
             Inst->dump();
@@ -2110,6 +2172,29 @@ GetVBR(uint64_t Val, const unsigned char *MatcherTable, unsigned &Idx) {
   return Val;
 }
 
+/// BuildSwitchTable - Map each case value of the OPC_SwitchOpcode or
+/// OPC_SwitchType cases starting at Idx to the index of its code.  Opcodes take
+/// two bytes in the table, types one.
+static void BuildSwitchTable(const unsigned char *MatcherTable, unsigned Idx,
+                             bool IsOpcode, std::vector<unsigned> &Table) {
+  while (1) {
+    // Get the size of this case.
+    unsigned CaseSize = MatcherTable[Idx++];
+    if (CaseSize & 128)
+      CaseSize = GetVBR(CaseSize, MatcherTable, Idx);
+    if (CaseSize == 0) break;
+
+    // Get the opcode or type, add the index to the table.
+    unsigned Val = MatcherTable[Idx++];
+    if (IsOpcode)
+      Val |= (unsigned)MatcherTable[Idx++] << 8;
+    if (Val >= Table.size())
+      Table.resize(Val+1);
+    Table[Val] = Idx;
+    Idx += CaseSize;
+  }
+}
+
 
 /// UpdateChainsAndGlue - When a match is complete, this method updates uses of
 /// interior glue and chain results to use the new glue and chain results.
@@ -2773,22 +2858,7 @@ SelectCodeCommon(SDNode *NodeToMatch, const unsigned char *MatcherTable,
     // Otherwise, the table isn't computed, but the state machine does start
     // with an OPC_SwitchOpcode instruction.  Populate the table now, since this
     // is the first time we're selecting an instruction.
-    unsigned Idx = 1;
-    while (1) {
-      // Get the size of this case.
-      unsigned CaseSize = MatcherTable[Idx++];
-      if (CaseSize & 128)
-        CaseSize = GetVBR(CaseSize, MatcherTable, Idx);
-      if (CaseSize == 0) break;
-
-      // Get the opcode, add the index to the table.
-      uint16_t Opc = MatcherTable[Idx++];
-      Opc |= (unsigned short)MatcherTable[Idx++] << 8;
-      if (Opc >= OpcodeOffset.size())
-        OpcodeOffset.resize((Opc+1)*2);
-      OpcodeOffset[Opc] = Idx;
-      Idx += CaseSize;
-    }
+    BuildSwitchTable(MatcherTable, 1, true, OpcodeOffset);
 
     // Okay, do the lookup for the first opcode.
     if (N.getOpcode() < OpcodeOffset.size())
@@ -2986,6 +3056,35 @@ SelectCodeCommon(SDNode *NodeToMatch, const unsigned char *MatcherTable,
       continue;
     }
 
+    case OPC_SwitchOpcodeTable:
+    case OPC_SwitchTypeTable: {
+      unsigned SwitchStart = MatcherIndex-1; (void)SwitchStart;
+      unsigned TableNo = MatcherTable[MatcherIndex++];
+      if (TableNo & 128)
+        TableNo = GetVBR(TableNo, MatcherTable, MatcherIndex);
+
+      // The cases are only scanned the first time the switch is reached, later
+      // the current opcode or type indexes right into them.
+      bool IsOpcode = Opcode == OPC_SwitchOpcodeTable;
+      if (TableNo >= SwitchTables.size())
+        SwitchTables.resize(TableNo+1);
+      std::vector<unsigned> &Table = SwitchTables[TableNo];
+      if (Table.empty())
+        BuildSwitchTable(MatcherTable, MatcherIndex, IsOpcode, Table);
+
+      unsigned Val = IsOpcode ? N.getOpcode() : N.getSimpleValueType().SimpleTy;
+
+      // If no cases matched, bail out.
+      if (Val >= Table.size() || Table[Val] == 0) break;
+
+      // Otherwise, execute the case we found.
+      MatcherIndex = Table[Val];
+      DEBUG(dbgs() << (IsOpcode ? "  OpcodeSwitch" : "  TypeSwitch")
+                   << " from " << SwitchStart << " to " << MatcherIndex
+                   << "\n");
+      continue;
+    }
+
     case OPC_SwitchType: {
       MVT CurNodeVT = N.getSimpleValueType();
       unsigned SwitchStart = MatcherIndex-1; (void)SwitchStart;
@@ -24,6 +24,7 @@ INITIALIZE_PASS(SlotIndexes, "slotindexes",
 
 STATISTIC(NumLocalRenum,  "Number of local renumberings");
 STATISTIC(NumGlobalRenum, "Number of global renumberings");
+STATISTIC(NumIndexKB,     "Kilobytes used by slot index lists and maps");
 
 void SlotIndexes::getAnalysisUsage(AnalysisUsage &au) const {
   au.setPreservesAll();
@@ -104,6 +105,12 @@ bool SlotIndexes::runOnMachineFunction(MachineFunction &fn) {
 
   DEBUG(mf->print(dbgs(), this));
 
+  if (AreStatisticsEnabled()) {
+    size_t Bytes = ileAllocator.getTotalMemory() + mi2iMap.getMemorySize() +
+                   capacity_in_bytes(MBBRanges) + capacity_in_bytes(idx2MBBMap);
+    NumIndexKB += (Bytes + 512) / 1024;
+  }
+
   // And we're done!
   return false;
 }
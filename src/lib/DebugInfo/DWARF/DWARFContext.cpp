@@ -16,8 +16,10 @@
 #include "llvm/Support/Dwarf.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <thread>
 using namespace llvm;
 using namespace dwarf;
 using namespace object;
@@ -71,6 +73,43 @@ static void dumpAccelSection(raw_ostream &OS, StringRef Name,
   Accel.dump(OS);
 }
 
+// Dump the compile units in order. Once their line tables are parsed, dumping
+// a unit only extracts its own DIEs, so batches of units are dumped into
+// buffers concurrently and the buffers are then printed in order.
+static void dumpCompileUnits(raw_ostream &OS, DWARFContext &Ctx) {
+  unsigned Threads = std::thread::hardware_concurrency();
+  if (Threads <= 1 || Ctx.getNumCompileUnits() < 2) {
+    for (const auto &CU : Ctx.compile_units())
+      CU->dump(OS);
+    return;
+  }
+
+  for (const auto &CU : Ctx.compile_units())
+    Ctx.getLineTableForUnit(CU.get());
+
+  // Keep a few units in flight per thread, but not all of them, so that the
+  // buffered output of a large file stays small.
+  ThreadPool Pool(Threads);
+  std::vector<std::string> Buffers(Threads * 4);
+  auto Units = Ctx.compile_units();
+  for (auto I = Units.begin(), E = Units.end(); I != E;) {
+    size_t N = 0;
+    for (; I != E && N != Buffers.size(); ++I, ++N) {
+      DWARFCompileUnit *CU = I->get();
+      std::string *Buffer = &Buffers[N];
+      Pool.async([CU, Buffer] {
+        raw_string_ostream BufferOS(*Buffer);
+        CU->dump(BufferOS);
+      });
+    }
+    Pool.wait();
+    for (size_t J = 0; J != N; ++J) {
+      OS << Buffers[J];
+      Buffers[J].clear();
+    }
+  }
+}
+
 void DWARFContext::dump(raw_ostream &OS, DIDumpType DumpType) {
   if (DumpType == DIDT_All || DumpType == DIDT_Abbrev) {
     OS << ".debug_abbrev contents:\n";
@@ -85,8 +124,7 @@ void DWARFContext::dump(raw_ostream &OS, DIDumpType DumpType) {
 
   if (DumpType == DIDT_All || DumpType == DIDT_Info) {
     OS << "\n.debug_info contents:\n";
-    for (const auto &CU : compile_units())
-      CU->dump(OS);
+    dumpCompileUnits(OS, *this);
   }
 
   if ((DumpType == DIDT_All || DumpType == DIDT_InfoDwo) &&
@@ -596,6 +634,10 @@ DWARFContextInMemory::DWARFContextInMemory(const object::ObjectFile &Obj)
             .Case("debug_line.dwo", &LineDWOSection.Data)
             .Case("debug_str.dwo", &StringDWOSection)
             .Case("debug_str_offsets.dwo", &StringOffsetDWOSection)
+            // MachO spellings of the dwo sections that do not fit in the 16
+            // character section limit.
+            .Case("debug_abbrev.d", &AbbrevDWOSection)
+            .Case("debug_str_offs", &StringOffsetDWOSection)
             .Case("debug_addr", &AddrSection)
             .Case("apple_names", &AppleNamesSection.Data)
             .Case("apple_types", &AppleTypesSection.Data)
@@ -615,7 +657,8 @@ DWARFContextInMemory::DWARFContextInMemory(const object::ObjectFile &Obj)
       // Find debug_types data by section rather than name as there are
       // multiple, comdat grouped, debug_types sections.
       TypesSections[Section].Data = data;
-    } else if (name == "debug_types.dwo") {
+    } else if (name == "debug_types.dwo" || name == "debug_types.dw") {
+      // The MachO spelling is truncated to the 16 character section limit.
       TypesDWOSections[Section].Data = data;
     }
 
@@ -647,7 +690,8 @@ DWARFContextInMemory::DWARFContextInMemory(const object::ObjectFile &Obj)
       // multiple, comdat grouped, debug_types sections.
       if (RelSecName == "debug_types")
         Map = &TypesSections[*RelocatedSection].Relocs;
-      else if (RelSecName == "debug_types.dwo")
+      else if (RelSecName == "debug_types.dwo" ||
+               RelSecName == "debug_types.dw")
         Map = &TypesDWOSections[*RelocatedSection].Relocs;
       else
         continue;
@@ -12,6 +12,7 @@
 #include "llvm/DebugInfo/DWARF/DWARFFormValue.h"
 #include "llvm/Support/Dwarf.h"
 #include "llvm/Support/Path.h"
+#include <algorithm>
 #include <cstdio>
 
 using namespace llvm;
@@ -307,6 +308,10 @@ void DWARFUnit::clearDIEs(bool KeepCUDie) {
     if (KeepCUDie)
       DieArray.push_back(TmpArray.front());
   }
+
+  // The subprogram ranges refer to the DIEs.
+  std::vector<SubprogramRange>().swap(SubprogramRanges);
+  HasSubprogramRanges = false;
 }
 
 void DWARFUnit::collectAddressRanges(DWARFAddressRangesVector &CURanges) {
@@ -339,16 +344,51 @@ void DWARFUnit::collectAddressRanges(DWARFAddressRangesVector &CURanges) {
     clearDIEs(true);
 }
 
+void DWARFUnit::buildSubprogramRanges() {
+  HasSubprogramRanges = true;
+  for (uint32_t I = 0, E = DieArray.size(); I != E; ++I) {
+    const DWARFDebugInfoEntryMinimal &DIE = DieArray[I];
+    if (!DIE.isSubprogramDIE())
+      continue;
+    for (const auto &R : DIE.getAddressRanges(this))
+      if (R.first < R.second)
+        SubprogramRanges.push_back({R.first, R.second, 0, I});
+  }
+
+  std::sort(SubprogramRanges.begin(), SubprogramRanges.end(),
+            [](const SubprogramRange &LHS, const SubprogramRange &RHS) {
+    return LHS.LowPC < RHS.LowPC;
+  });
+  uint64_t MaxHighPC = 0;
+  for (SubprogramRange &R : SubprogramRanges) {
+    MaxHighPC = std::max(MaxHighPC, R.HighPC);
+    R.MaxHighPC = MaxHighPC;
+  }
+}
+
 const DWARFDebugInfoEntryMinimal *
 DWARFUnit::getSubprogramForAddress(uint64_t Address) {
   extractDIEsIfNeeded(false);
-  for (const DWARFDebugInfoEntryMinimal &DIE : DieArray) {
-    if (DIE.isSubprogramDIE() &&
-        DIE.addressRangeContainsAddress(this, Address)) {
-      return &DIE;
-    }
+  if (!HasSubprogramRanges)
+    buildSubprogramRanges();
+
+  // Walk back from the last range starting at or before Address, as long as
+  // an earlier range may still extend past it. If several subprograms contain
+  // the address, return the first one, as a walk of the DIEs would.
+  auto I = std::upper_bound(
+      SubprogramRanges.begin(), SubprogramRanges.end(), Address,
+      [](uint64_t Address, const SubprogramRange &R) {
+        return Address < R.LowPC;
+      });
+  uint32_t DieIdx = -1U;
+  while (I != SubprogramRanges.begin()) {
+    --I;
+    if (I->MaxHighPC <= Address)
+      break;
+    if (Address < I->HighPC)
+      DieIdx = std::min(DieIdx, I->DieIdx);
   }
-  return nullptr;
+  return DieIdx == -1U ? nullptr : &DieArray[DieIdx];
 }
 
 DWARFDebugInfoEntryInlinedChain
@@ -0,0 +1,111 @@
+//===-- FileObjectCache.cpp - Object cache kept in a directory ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the ObjectCache storing objects in a directory.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ExecutionEngine/FileObjectCache.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+
+using namespace llvm;
+
+namespace {
+// Feeds everything written to it to an MD5 hash, so that a module can be
+// hashed without holding its printed form in memory.
+class HashingOStream : public raw_ostream {
+  MD5 &Hash;
+  uint64_t Pos;
+
+  void write_impl(const char *Ptr, size_t Size) override {
+    Hash.update(ArrayRef<uint8_t>(reinterpret_cast<const uint8_t *>(Ptr),
+                                  Size));
+    Pos += Size;
+  }
+
+  uint64_t current_pos() const override { return Pos; }
+
+public:
+  explicit HashingOStream(MD5 &Hash) : Hash(Hash), Pos(0) {}
+  ~HashingOStream() override { flush(); }
+};
+}
+
+void FileObjectCache::anchor() {}
+
+FileObjectCache::FileObjectCache(std::string CacheDir, std::string TargetKey)
+    : CacheDir(std::move(CacheDir)), TargetKey(std::move(TargetKey)) {}
+
+std::string FileObjectCache::getTargetKey(const TargetMachine &TM) {
+  std::string Key;
+  raw_string_ostream OS(Key);
+  OS << TM.getTargetTriple() << '/' << TM.getTargetCPU() << '/'
+     << TM.getTargetFeatureString() << '/' << TM.getRelocationModel() << '/'
+     << TM.getCodeModel() << '/' << TM.getOptLevel();
+  return OS.str();
+}
+
+std::string FileObjectCache::getObjectPath(const Module &M) const {
+  MD5 Hash;
+  Hash.update(TargetKey);
+  // Separate the key from the IR, which could otherwise extend it.
+  Hash.update(StringRef("", 1));
+  {
+    HashingOStream OS(Hash);
+    M.print(OS, nullptr);
+  }
+  MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Name;
+  MD5::stringifyResult(Result, Name);
+
+  SmallString<128> Path(CacheDir);
+  sys::path::append(Path, Twine(Name) + ".o");
+  return Path.str();
+}
+
+void FileObjectCache::notifyObjectCompiled(const Module *M,
+                                           MemoryBufferRef Obj) {
+  if (sys::fs::create_directories(CacheDir))
+    return;
+  std::string Path = getObjectPath(*M);
+
+  // Write to a file of our own, then move it in place: concurrent readers see
+  // either no object or a complete one.
+  int FD;
+  SmallString<128> TempPath;
+  if (sys::fs::createUniqueFile(Path + ".tmp%%%%%%", FD, TempPath))
+    return;
+  {
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << Obj.getBuffer();
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      sys::fs::remove(TempPath.str());
+      return;
+    }
+  }
+  if (sys::fs::rename(TempPath.str(), Path))
+    sys::fs::remove(TempPath.str());
+}
+
+std::unique_ptr<MemoryBuffer> FileObjectCache::getObject(const Module *M) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
+      MemoryBuffer::getFile(getObjectPath(*M), -1, false);
+  if (!BufferOrErr)
+    return nullptr;
+  return std::move(*BufferOrErr);
+}
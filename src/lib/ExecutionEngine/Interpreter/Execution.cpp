@@ -39,7 +39,16 @@ static cl::opt<bool> PrintVolatile("interpreter-print-volatile", cl::Hidden,
 //===----------------------------------------------------------------------===//
 
 static void SetValue(Value *V, GenericValue Val, ExecutionContext &SF) {
-  SF.Values[V] = Val;
+  SF.getValue(V) = Val;
+}
+
+FunctionInfo::FunctionInfo(const Function &F) {
+  for (const Argument &A : F.args())
+    getSlot(&A);
+  for (const BasicBlock &BB : F)
+    for (const Instruction &I : BB)
+      if (!I.getType()->isVoidTy())
+        getSlot(&I);
 }
 
 //===----------------------------------------------------------------------===//
@@ -2061,7 +2070,7 @@ GenericValue Interpreter::getOperandValue(Value *V, ExecutionContext &SF) {
   } else if (GlobalValue *GV = dyn_cast<GlobalValue>(V)) {
     return PTOGV(getPointerToGlobal(GV));
   } else {
-    return SF.Values[V];
+    return SF.getValue(V);
   }
 }
 
@@ -2094,6 +2103,13 @@ void Interpreter::callFunction(Function *F,
   StackFrame.CurBB     = F->begin();
   StackFrame.CurInst   = StackFrame.CurBB->begin();
 
+  // Make room for all the values of the function at once.
+  std::unique_ptr<FunctionInfo> &Info = FunctionInfos[F];
+  if (!Info)
+    Info.reset(new FunctionInfo(*F));
+  StackFrame.Info = Info.get();
+  StackFrame.Values.resize(Info->getNumSlots());
+
   // Run through the function arguments and initialize their values...
   assert((ArgVals.size() == F->arg_size() ||
          (ArgVals.size() > F->arg_size() && F->getFunctionType()->isVarArg()))&&
@@ -2127,7 +2143,7 @@ DEBUG(
     if (!isa<CallInst>(I) && !isa<InvokeInst>(I) && 
         I.getType() != Type::VoidTy) {
       dbgs() << "  --> ";
-      const GenericValue &Val = SF.Values[&I];
+      const GenericValue &Val = SF.getValue(&I);
       switch (I.getType()->getTypeID()) {
       default: llvm_unreachable("Invalid GenericValue Type");
       case Type::VoidTyID:    dbgs() << "void"; break;
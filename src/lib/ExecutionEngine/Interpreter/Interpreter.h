@@ -14,6 +14,7 @@
 #ifndef LLVM_LIB_EXECUTIONENGINE_INTERPRETER_INTERPRETER_H
 #define LLVM_LIB_EXECUTIONENGINE_INTERPRETER_INTERPRETER_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/GenericValue.h"
 #include "llvm/IR/CallSite.h"
@@ -26,7 +27,6 @@
 namespace llvm {
 
 class IntrinsicLowering;
-struct FunctionInfo;
 template<typename T> class generic_gep_type_iterator;
 class ConstantExpr;
 typedef generic_gep_type_iterator<User::const_op_iterator> gep_type_iterator;
@@ -59,6 +59,26 @@ public:
 
 typedef std::vector<GenericValue> ValuePlaneTy;
 
+// FunctionInfo - The numbering of the arguments and instructions of a
+// function, made the first time it is called.  Stack frames keep the values
+// they compute in a vector indexed by this numbering, so that a call doesn't
+// allocate a map node per value.
+//
+class FunctionInfo {
+  DenseMap<const Value *, unsigned> Slots;
+
+public:
+  explicit FunctionInfo(const Function &F);
+
+  // getSlot - Return the slot of V, numbering V if it was created after the
+  // function was numbered, e.g. by the lowering of an intrinsic call.
+  unsigned getSlot(const Value *V) {
+    return Slots.insert(std::make_pair(V, Slots.size())).first->second;
+  }
+
+  unsigned getNumSlots() const { return Slots.size(); }
+};
+
 // ExecutionContext struct - This struct represents one stack frame currently
 // executing.
 //
@@ -68,15 +88,17 @@ struct ExecutionContext {
   BasicBlock::iterator  CurInst;    // The next instruction to execute
   CallSite             Caller;     // Holds the call that called subframes.
                                    // NULL if main func or debugger invoked fn
-  std::map<Value *, GenericValue> Values; // LLVM values used in this invocation
+  FunctionInfo         *Info;      // The numbering of the values of CurFunction
+  ValuePlaneTy         Values;     // LLVM values used in this invocation
   std::vector<GenericValue>  VarArgs; // Values passed through an ellipsis
   AllocaHolder Allocas;            // Track memory allocated by alloca
 
-  ExecutionContext() : CurFunction(nullptr), CurBB(nullptr), CurInst(nullptr) {}
+  ExecutionContext()
+      : CurFunction(nullptr), CurBB(nullptr), CurInst(nullptr), Info(nullptr) {}
 
   ExecutionContext(ExecutionContext &&O)
       : CurFunction(O.CurFunction), CurBB(O.CurBB), CurInst(O.CurInst),
-        Caller(O.Caller), Values(std::move(O.Values)),
+        Caller(O.Caller), Info(O.Info), Values(std::move(O.Values)),
         VarArgs(std::move(O.VarArgs)), Allocas(std::move(O.Allocas)) {}
 
   ExecutionContext &operator=(ExecutionContext &&O) {
@@ -84,11 +106,20 @@ struct ExecutionContext {
     CurBB = O.CurBB;
     CurInst = O.CurInst;
     Caller = O.Caller;
+    Info = O.Info;
     Values = std::move(O.Values);
     VarArgs = std::move(O.VarArgs);
     Allocas = std::move(O.Allocas);
     return *this;
   }
+
+  // getValue - Return the value computed for V in this invocation.
+  GenericValue &getValue(const Value *V) {
+    unsigned Slot = Info->getSlot(V);
+    if (Slot >= Values.size())
+      Values.resize(Info->getNumSlots());
+    return Values[Slot];
+  }
 };
 
 // Interpreter - This class represents the entirety of the interpreter.
@@ -106,6 +137,9 @@ class Interpreter : public ExecutionEngine, public InstVisitor<Interpreter> {
   // registered with the atexit() library function.
   std::vector<Function*> AtExitHandlers;
 
+  // FunctionInfos - The numbering of the values of each function called.
+  DenseMap<const Function *, std::unique_ptr<FunctionInfo>> FunctionInfos;
+
 public:
   explicit Interpreter(std::unique_ptr<Module> M);
   ~Interpreter();
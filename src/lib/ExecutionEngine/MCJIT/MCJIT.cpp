@@ -25,6 +25,8 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/MutexGuard.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
 
 using namespace llvm;
 
@@ -60,7 +62,8 @@ ExecutionEngine *MCJIT::createJIT(std::unique_ptr<Module> M,
 MCJIT::MCJIT(std::unique_ptr<Module> M, std::unique_ptr<TargetMachine> tm,
              std::unique_ptr<RTDyldMemoryManager> MM)
     : ExecutionEngine(std::move(M)), TM(std::move(tm)), Ctx(nullptr),
-      MemMgr(this, std::move(MM)), Dyld(&MemMgr), ObjCache(nullptr) {
+      MemMgr(this, std::move(MM)), Dyld(&MemMgr), ObjCache(nullptr),
+      CompileThreads(1) {
   // FIXME: We are managing our modules, so we do not want the base class
   // ExecutionEngine to manage them as well. To avoid double destruction
   // of the first (and only) module added in ExecutionEngine constructor
@@ -128,33 +131,41 @@ void MCJIT::setObjectCache(ObjectCache* NewCache) {
   ObjCache = NewCache;
 }
 
-std::unique_ptr<MemoryBuffer> MCJIT::emitObject(Module *M) {
-  MutexGuard locked(lock);
-
-  // This must be a module which has already been added but not loaded to this
-  // MCJIT instance, since these conditions are tested by our caller,
-  // generateCodeForModule.
-
+// Generate code for M with TM, which only this thread may be using.
+static std::unique_ptr<MemoryBuffer> compileModule(TargetMachine &TM,
+                                                   MCContext *&Ctx, Module &M,
+                                                   bool VerifyModules) {
   PassManager PM;
 
-  M->setDataLayout(*TM->getDataLayout());
-
   // The RuntimeDyld will take ownership of this shortly
   SmallVector<char, 4096> ObjBufferSV;
   raw_svector_ostream ObjStream(ObjBufferSV);
 
   // Turn the machine code intermediate representation into bytes in memory
   // that may be executed.
-  if (TM->addPassesToEmitMC(PM, Ctx, ObjStream, !getVerifyModules()))
+  if (TM.addPassesToEmitMC(PM, Ctx, ObjStream, !VerifyModules))
     report_fatal_error("Target does not support MC emission!");
 
   // Initialize passes.
-  PM.run(*M);
+  PM.run(M);
   // Flush the output buffer to get the generated code into memory
   ObjStream.flush();
 
-  std::unique_ptr<MemoryBuffer> CompiledObjBuffer(
-                                new ObjectMemoryBuffer(std::move(ObjBufferSV)));
+  return std::unique_ptr<MemoryBuffer>(
+      new ObjectMemoryBuffer(std::move(ObjBufferSV)));
+}
+
+std::unique_ptr<MemoryBuffer> MCJIT::emitObject(Module *M) {
+  MutexGuard locked(lock);
+
+  // This must be a module which has already been added but not loaded to this
+  // MCJIT instance, since these conditions are tested by our caller,
+  // generateCodeForModule.
+
+  M->setDataLayout(*TM->getDataLayout());
+
+  std::unique_ptr<MemoryBuffer> CompiledObjBuffer =
+      compileModule(*TM, Ctx, *M, getVerifyModules());
 
   // If we have an object cache, tell it about the new object.
   // Note that we're using the compiled image, not the loaded image (as below).
@@ -191,6 +202,75 @@ void MCJIT::generateCodeForModule(Module *M) {
     assert(ObjectToLoad && "Compilation did not produce an object.");
   }
 
+  loadObject(M, std::move(ObjectToLoad));
+}
+
+std::vector<std::unique_ptr<MemoryBuffer>>
+MCJIT::emitObjects(ArrayRef<Module *> Mods) {
+  MutexGuard locked(lock);
+
+  std::vector<std::unique_ptr<MemoryBuffer>> Objects(Mods.size());
+  if (ObjCache)
+    for (unsigned I = 0, E = Mods.size(); I != E; ++I)
+      Objects[I] = ObjCache->getObject(Mods[I]);
+
+  // Modules sharing an LLVMContext can't be compiled at the same time, so
+  // each group of modules of a context is compiled by a single task.
+  SmallVector<std::pair<LLVMContext *, SmallVector<unsigned, 4>>, 8> Groups;
+  DenseMap<LLVMContext *, unsigned> GroupForContext;
+  for (unsigned I = 0, E = Mods.size(); I != E; ++I) {
+    if (Objects[I])
+      continue;
+    Mods[I]->setDataLayout(*TM->getDataLayout());
+    LLVMContext *Context = &Mods[I]->getContext();
+    auto Inserted = GroupForContext.insert(
+        std::make_pair(Context, (unsigned)Groups.size()));
+    if (Inserted.second)
+      Groups.push_back(std::make_pair(Context, SmallVector<unsigned, 4>()));
+    Groups[Inserted.first->second].second.push_back(I);
+  }
+
+  // Passes cache state in the TargetMachine, so every task uses a copy of
+  // it. The first group uses TM itself, on this thread.
+  bool VerifyModules = getVerifyModules();
+  auto CompileGroup = [&](TargetMachine &GroupTM, MCContext *&GroupCtx,
+                          ArrayRef<unsigned> Group) {
+    for (unsigned I : Group)
+      Objects[I] = compileModule(GroupTM, GroupCtx, *Mods[I], VerifyModules);
+  };
+  if (Groups.size() > 1) {
+    // This thread compiles too, and picks up queued groups once done.
+    ThreadPool Pool(std::min<unsigned>(CompileThreads, Groups.size()) - 1);
+    for (unsigned G = 1, E = Groups.size(); G != E; ++G) {
+      ArrayRef<unsigned> Group = Groups[G].second;
+      Pool.async([&, Group] {
+        std::unique_ptr<TargetMachine> GroupTM(
+            TM->getTarget().createTargetMachine(
+                TM->getTargetTriple(), TM->getTargetCPU(),
+                TM->getTargetFeatureString(), TM->Options,
+                TM->getRelocationModel(), TM->getCodeModel(),
+                TM->getOptLevel()));
+        MCContext *GroupCtx = nullptr;
+        CompileGroup(*GroupTM, GroupCtx, Group);
+      });
+    }
+    CompileGroup(*TM, Ctx, Groups[0].second);
+    Pool.wait();
+  } else if (!Groups.empty()) {
+    CompileGroup(*TM, Ctx, Groups[0].second);
+  }
+
+  if (ObjCache)
+    for (const auto &Group : Groups)
+      for (unsigned I : Group.second)
+        ObjCache->notifyObjectCompiled(Mods[I],
+                                       Objects[I]->getMemBufferRef());
+  return Objects;
+}
+
+void MCJIT::loadObject(Module *M, std::unique_ptr<MemoryBuffer> ObjectToLoad) {
+  MutexGuard locked(lock);
+
   // Load the object into the dynamic linker.
   // MCJIT now owns the ObjectImage pointer (via its LoadedObjects list).
   ErrorOr<std::unique_ptr<object::ObjectFile>> LoadedObject =
@@ -234,8 +314,16 @@ void MCJIT::finalizeObject() {
   for (auto M : OwnedModules.added())
     ModsToAdd.push_back(M);
 
-  for (auto M : ModsToAdd)
-    generateCodeForModule(M);
+  // Generate the code for several modules at the same time if allowed, but
+  // load the objects one at a time, in order.
+  if (CompileThreads > 1 && ModsToAdd.size() > 1) {
+    std::vector<std::unique_ptr<MemoryBuffer>> Objects = emitObjects(ModsToAdd);
+    for (unsigned I = 0, E = ModsToAdd.size(); I != E; ++I)
+      loadObject(ModsToAdd[I], std::move(Objects[I]));
+  } else {
+    for (auto M : ModsToAdd)
+      generateCodeForModule(M);
+  }
 
   finalizeLoadedModules();
 }
@@ -229,6 +229,9 @@ class MCJIT : public ExecutionEngine {
   // perform lookup of pre-compiled code to avoid re-compilation.
   ObjectCache *ObjCache;
 
+  // The number of modules finalizeObject may compile at the same time.
+  unsigned CompileThreads;
+
   Function *FindFunctionNamedInModulePtrSet(const char *FnName,
                                             ModulePtrSet::iterator I,
                                             ModulePtrSet::iterator E);
@@ -260,6 +263,10 @@ public:
     Dyld.setProcessAllSections(ProcessAllSections);
   }
 
+  void setCompileThreads(unsigned NumThreads) override {
+    CompileThreads = NumThreads;
+  }
+
   void generateCodeForModule(Module *M) override;
 
   /// finalizeObject - ensure the module is fully processed and is usable.
@@ -344,6 +351,16 @@ protected:
   /// the future.
   std::unique_ptr<MemoryBuffer> emitObject(Module *M);
 
+  /// emitObjects -- Generate the objects for the modules Mods, compiling the
+  /// modules of different LLVMContexts concurrently, each with a TargetMachine
+  /// of its own.  The modules found in the object cache are not compiled.
+  std::vector<std::unique_ptr<MemoryBuffer>>
+  emitObjects(ArrayRef<Module *> Mods);
+
+  /// loadObject -- Load the object generated for module M into the dynamic
+  /// linker.
+  void loadObject(Module *M, std::unique_ptr<MemoryBuffer> ObjectToLoad);
+
   void NotifyObjectEmitted(const object::ObjectFile& Obj,
                            const RuntimeDyld::LoadedObjectInfo &L);
   void NotifyFreeingObject(const object::ObjectFile& Obj);
@@ -1,3 +1,4 @@
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/ExecutionEngine/Orc/IndirectionUtils.h"
 #include "llvm/ExecutionEngine/Orc/CloneSubModule.h"
@@ -90,6 +91,60 @@ JITIndirections makeCallsDoubleIndirect(
           -> std::string { return std::string(S) + JITAddrSuffix; });
 }
 
+std::vector<std::string> insertCallCounters(Module &M,
+                                            const JITIndirections &Indirs,
+                                            const char *JITCountSuffix) {
+  std::vector<std::string> CounterNames;
+  Type *Int64Ty = Type::getInt64Ty(M.getContext());
+
+  for (const auto &FuncName : Indirs.IndirectedNames) {
+    CounterNames.push_back(FuncName + JITCountSuffix);
+    Function *FRedirect = M.getFunction(FuncName);
+    assert(FRedirect && !FRedirect->isDeclaration() &&
+           "Call counters require double indirection");
+
+    GlobalVariable *Counter = new GlobalVariable(
+        M, Int64Ty, false, GlobalValue::ExternalLinkage,
+        ConstantInt::get(Int64Ty, 0), CounterNames.back(), nullptr,
+        GlobalValue::NotThreadLocal, 0, true);
+    Counter->setVisibility(GlobalValue::HiddenVisibility);
+
+    BasicBlock &EntryBlock = FRedirect->getEntryBlock();
+    IRBuilder<> Builder(&EntryBlock, EntryBlock.begin());
+    Builder.CreateAtomicRMW(AtomicRMWInst::Add, Counter,
+                            ConstantInt::get(Int64Ty, 1), Monotonic);
+  }
+
+  return CounterNames;
+}
+
+std::vector<std::vector<unsigned>>
+getIndirectedCallees(const Module &M, const JITIndirections &Indirs) {
+  StringMap<unsigned> IndirectedIdx;
+  for (unsigned I = 0, E = Indirs.IndirectedNames.size(); I != E; ++I)
+    IndirectedIdx[Indirs.IndirectedNames[I]] = I;
+
+  std::vector<std::vector<unsigned>> Callees(Indirs.IndirectedNames.size());
+  for (unsigned I = 0, E = Indirs.IndirectedNames.size(); I != E; ++I) {
+    const Function *Impl =
+        M.getFunction(Indirs.GetImplName(Indirs.IndirectedNames[I]));
+    if (!Impl)
+      continue;
+    std::set<unsigned> Seen;
+    for (const auto &BB : *Impl)
+      for (const auto &Inst : BB) {
+        ImmutableCallSite CS(&Inst);
+        if (!CS || !CS.getCalledFunction())
+          continue;
+        auto It = IndirectedIdx.find(CS.getCalledFunction()->getName());
+        if (It != IndirectedIdx.end() && It->second != I &&
+            Seen.insert(It->second).second)
+          Callees[I].push_back(It->second);
+      }
+  }
+  return Callees;
+}
+
 std::vector<std::unique_ptr<Module>>
 explode(const Module &OrigMod,
         const std::function<bool(const Function &)> &ShouldExtract) {
@@ -19,6 +19,7 @@
 #include "llvm/Object/ELFObjectFile.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MutexGuard.h"
+#include <algorithm>
 
 using namespace llvm;
 using namespace llvm::object;
@@ -82,9 +83,15 @@ void RuntimeDyldImpl::resolveRelocations() {
   // First, resolve relocations associated with external symbols.
   resolveExternalSymbols();
 
-  // Just iterate over the sections we have and resolve all the relocations
-  // in them. Gross overkill, but it gets the job done.
-  for (int i = 0, e = Sections.size(); i != e; ++i) {
+  // Then resolve the relocations against each section that still has some.
+  // Sections accumulate as objects are loaded, so visit only these rather than
+  // every section, in section order to keep the output deterministic.
+  SmallVector<unsigned, 16> SectionIDs;
+  for (const auto &Relocs : Relocations)
+    SectionIDs.push_back(Relocs.first);
+  std::sort(SectionIDs.begin(), SectionIDs.end());
+
+  for (unsigned i : SectionIDs) {
     // The Section here (Sections[i]) refers to the section in which the
     // symbol for the relocation is located.  The SectionID in the relocation
     // entry provides the section to which the relocation will be applied.
@@ -94,8 +101,8 @@ void RuntimeDyldImpl::resolveRelocations() {
     DEBUG(dumpSectionMemory(Sections[i], "before relocations"));
     resolveRelocationList(Relocations[i], Addr);
     DEBUG(dumpSectionMemory(Sections[i], "after relocations"));
-    Relocations.erase(i);
   }
+  Relocations.clear();
 }
 
 void RuntimeDyldImpl::mapSectionAddress(const void *LocalAddress,
@@ -15,6 +15,8 @@
 #include "llvm/Config/config.h"
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Process.h"
+#include <algorithm>
 
 namespace llvm {
 
@@ -58,21 +60,21 @@ uint8_t *SectionMemoryManager::allocateSection(MemoryGroup &MemGroup,
       // Store cutted free memory block.
       MemGroup.FreeMem[i] = sys::MemoryBlock((void*)(Addr + Size),
                                              EndOfBlock - Addr - Size);
+      MemGroup.PendingMem.push_back(sys::MemoryBlock((void*)Addr, Size));
       return (uint8_t*)Addr;
     }
   }
 
-  // No pre-allocated free block was large enough. Allocate a new memory region.
+  // No pre-allocated free block was large enough. Allocate a new memory region,
+  // of at least a slab so that the next sections can be packed into it.
   // Note that all sections get allocated as read-write.  The permissions will
   // be updated later based on memory group.
   //
-  // FIXME: It would be useful to define a default allocation size (or add
-  // it as a constructor parameter) to minimize the number of allocations.
-  //
   // FIXME: Initialize the Near member for each memory group to avoid
   // interleaving.
   std::error_code ec;
-  sys::MemoryBlock MB = sys::Memory::allocateMappedMemory(RequiredSize,
+  sys::MemoryBlock MB = sys::Memory::allocateMappedMemory(std::max(RequiredSize,
+                                                                   SlabSize),
                                                           &MemGroup.Near,
                                                           sys::Memory::MF_READ |
                                                             sys::Memory::MF_WRITE,
@@ -97,6 +99,7 @@ uint8_t *SectionMemoryManager::allocateSection(MemoryGroup &MemGroup,
   unsigned FreeSize = EndOfBlock-Addr-Size;
   if (FreeSize > 16)
     MemGroup.FreeMem.push_back(sys::MemoryBlock((void*)(Addr + Size), FreeSize));
+  MemGroup.PendingMem.push_back(sys::MemoryBlock((void*)Addr, Size));
 
   // Return aligned address
   return (uint8_t*)Addr;
@@ -107,9 +110,6 @@ bool SectionMemoryManager::finalizeMemory(std::string *ErrMsg)
   // FIXME: Should in-progress permissions be reverted if an error occurs?
   std::error_code ec;
 
-  // Don't allow free memory blocks to be used after setting protection flags.
-  CodeMem.FreeMem.clear();
-
   // Make code memory executable.
   ec = applyMemoryGroupPermissions(CodeMem,
                                    sys::Memory::MF_READ | sys::Memory::MF_EXEC);
@@ -120,9 +120,6 @@ bool SectionMemoryManager::finalizeMemory(std::string *ErrMsg)
     return true;
   }
 
-  // Don't allow free memory blocks to be used after setting protection flags.
-  RODataMem.FreeMem.clear();
-
   // Make read-only data memory read-only.
   ec = applyMemoryGroupPermissions(RODataMem,
                                    sys::Memory::MF_READ | sys::Memory::MF_EXEC);
@@ -134,6 +131,7 @@ bool SectionMemoryManager::finalizeMemory(std::string *ErrMsg)
   }
 
   // Read-write data memory already has the correct permissions
+  RWDataMem.PendingMem.clear();
 
   // Some platforms with separate data cache and instruction cache require
   // explicit cache flush, otherwise JIT code manipulations (like resolved
@@ -147,14 +145,44 @@ std::error_code
 SectionMemoryManager::applyMemoryGroupPermissions(MemoryGroup &MemGroup,
                                                   unsigned Permissions) {
 
-  for (int i = 0, e = MemGroup.AllocatedMem.size(); i != e; ++i) {
-    std::error_code ec;
-    ec =
-        sys::Memory::protectMappedMemory(MemGroup.AllocatedMem[i], Permissions);
+  // Only the pages holding the sections allocated since the last call need a
+  // new protection.  Sections share pages, and consecutive sections usually
+  // share a slab, so merge their pages into as few ranges as possible.
+  uintptr_t PageSize = sys::Process::getPageSize();
+  SmallVector<std::pair<uintptr_t, uintptr_t>, 16> Ranges;
+  for (const sys::MemoryBlock &MB : MemGroup.PendingMem) {
+    uintptr_t Start = (uintptr_t)MB.base() & ~(PageSize - 1);
+    uintptr_t End = RoundUpToAlignment((uintptr_t)MB.base() + MB.size(),
+                                       PageSize);
+    Ranges.push_back(std::make_pair(Start, End));
+  }
+  std::sort(Ranges.begin(), Ranges.end());
+
+  for (unsigned i = 0, e = Ranges.size(); i != e;) {
+    uintptr_t Start = Ranges[i].first;
+    uintptr_t End = Ranges[i].second;
+    // Every page of the merged range holds a section, so it is mapped.
+    for (++i; i != e && Ranges[i].first <= End; ++i)
+      End = std::max(End, Ranges[i].second);
+
+    std::error_code ec = sys::Memory::protectMappedMemory(
+        sys::MemoryBlock((void *)Start, End - Start), Permissions);
     if (ec) {
       return ec;
     }
   }
+  MemGroup.PendingMem.clear();
+
+  // The free memory sharing a page with a section can't be written anymore;
+  // keep only the pages past it.
+  SmallVector<sys::MemoryBlock, 16> FreeMem;
+  for (const sys::MemoryBlock &MB : MemGroup.FreeMem) {
+    uintptr_t Start = RoundUpToAlignment((uintptr_t)MB.base(), PageSize);
+    uintptr_t End = (uintptr_t)MB.base() + MB.size();
+    if (Start < End)
+      FreeMem.push_back(sys::MemoryBlock((void *)Start, End - Start));
+  }
+  MemGroup.FreeMem = std::move(FreeMem);
 
   return std::error_code();
 }
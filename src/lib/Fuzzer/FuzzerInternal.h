@@ -8,13 +8,17 @@
 //===----------------------------------------------------------------------===//
 // Define the main class fuzzer::Fuzzer and most functions.
 //===----------------------------------------------------------------------===//
+#include <atomic>
 #include <cassert>
 #include <climits>
 #include <chrono>
 #include <cstddef>
 #include <cstdlib>
+#include <memory>
 #include <string>
+#include <thread>
 #include <vector>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace fuzzer {
@@ -22,6 +26,7 @@ typedef std::vector<uint8_t> Unit;
 using namespace std::chrono;
 
 Unit ReadFile(const char *Path);
+Unit FileToVector(const std::string &Path);
 void ReadDirToVectorOfUnits(const char *Path, std::vector<Unit> *V);
 void WriteToFile(const Unit &U, const std::string &Path);
 void CopyFileToErr(const std::string &Path);
@@ -38,6 +43,70 @@ void PrintASCII(const Unit &U, const char *PrintAfter = "");
 std::string Hash(const Unit &U);
 void SetTimer(int Seconds);
 
+// The PCs covered by running one unit, as sorted offsets from TestOneInput.
+typedef std::vector<uintptr_t> CoverageSignature;
+// Coverage signatures keyed by the Hash() of their unit.
+typedef std::unordered_map<std::string, CoverageSignature> CoverageCache;
+
+// Returns a key identifying the running executable, or "" if it can't be
+// read: signatures are only valid for the binary that computed them.
+std::string ExecutableKey();
+// Reads the signatures saved at Path, returning false if there are none or
+// if they were computed by another executable than the one of Key.
+bool ReadCoverageCache(const std::string &Path, const std::string &Key,
+                       CoverageCache *Cache);
+void WriteCoverageCache(const std::string &Path, const std::string &Key,
+                        const CoverageCache &Cache);
+// Greedily picks the unit adding the most PCs to Covered, the smallest one
+// on ties, until no unit adds any. Returns the indices of the picked units.
+std::vector<size_t> SelectCoveringSubset(
+    const std::vector<CoverageSignature> &Sigs,
+    const std::vector<size_t> &Sizes, std::unordered_set<uintptr_t> *Covered);
+
+// A corpus that fuzzing threads read and extend without locks. Units are
+// never removed, and are published in the order of their slots, so every
+// unit below size() is complete.
+class SharedCorpus {
+ public:
+  static const size_t kMaxSize = 1 << 18;
+
+  SharedCorpus()
+      : Units(new std::atomic<const Unit *>[kMaxSize]), Reserved(0),
+        Published(0) {}
+  ~SharedCorpus() {
+    for (size_t I = 0, N = size(); I < N; I++)
+      delete Units[I].load(std::memory_order_relaxed);
+  }
+  SharedCorpus(const SharedCorpus &) = delete;
+  SharedCorpus &operator=(const SharedCorpus &) = delete;
+
+  size_t size() const { return Published.load(std::memory_order_acquire); }
+  const Unit &operator[](size_t Idx) const {
+    assert(Idx < size());
+    return *Units[Idx].load(std::memory_order_relaxed);
+  }
+  // Returns false, dropping U, if the corpus is full.
+  bool push_back(const Unit &U) {
+    size_t Idx = Reserved.fetch_add(1, std::memory_order_relaxed);
+    if (Idx >= kMaxSize)
+      return false;
+    Units[Idx].store(new Unit(U), std::memory_order_relaxed);
+    // Wait for the threads that reserved the slots before ours.
+    size_t Expected = Idx;
+    while (!Published.compare_exchange_weak(Expected, Idx + 1,
+                                            std::memory_order_release)) {
+      Expected = Idx;
+      std::this_thread::yield();
+    }
+    return true;
+  }
+
+ private:
+  std::unique_ptr<std::atomic<const Unit *>[]> Units;
+  std::atomic<size_t> Reserved;
+  std::atomic<size_t> Published;
+};
+
 class Fuzzer {
  public:
   struct FuzzingOptions {
@@ -47,9 +116,14 @@ class Fuzzer {
     int  MutateDepth = 5;
     bool ExitOnFirst = false;
     bool UseFullCoverageSet  = false;
+    bool UseCounters = false;
+    int NumThreads = 1;
     int PreferSmallDuringInitialShuffle = -1;
     size_t MaxNumberOfRuns = ULONG_MAX;
     std::string OutputCorpus;
+    // If not empty, the file caching the coverage signatures of the units,
+    // which makes the initial minimization only run the units it keeps.
+    std::string CoverageCachePath;
   };
   Fuzzer(FuzzingOptions Options) : Options(Options) {
     SetDeathCallback();
@@ -63,6 +137,10 @@ class Fuzzer {
   }
   // Save the current corpus to OutputCorpus.
   void SaveCorpus();
+  // Adds to the first of Corpora the units of the others that cover PCs it
+  // does not and returns their number. The new units are written to
+  // OutputCorpus.
+  size_t Merge(const std::vector<std::string> &Corpora);
 
   size_t secondsSinceProcessStartUp() {
     return duration_cast<seconds>(system_clock::now() - ProcessStartTime)
@@ -74,24 +152,33 @@ class Fuzzer {
   static void AlarmCallback();
 
  private:
+  size_t LoopInThread(size_t NumIterations);
   size_t MutateAndTestOne(Unit *U);
   size_t RunOne(const Unit &U);
   size_t RunOneMaximizeTotalCoverage(const Unit &U);
   size_t RunOneMaximizeFullCoverageSet(const Unit &U);
+  CoverageSignature RunOneForSignature(const Unit &U);
+  std::vector<CoverageSignature> ComputeSignatures(
+      const std::vector<Unit> &Units);
+  void MinimizeWithCoverageSignatures();
   void WriteToOutputCorpus(const Unit &U);
   static void WriteToCrash(const Unit &U, const char *Prefix);
 
   void SetDeathCallback();
   static void DeathCallback();
-  static Unit CurrentUnit;
+  static thread_local Unit CurrentUnit;
 
-  size_t TotalNumberOfRuns = 0;
+  std::atomic<size_t> TotalNumberOfRuns{0};
 
   std::vector<Unit> Corpus;
+  // The corpus while the fuzzing threads run: Loop() syncs it with Corpus.
+  SharedCorpus LoopCorpus;
   std::unordered_set<uintptr_t> FullCoverageSets;
+  // One byte per 8-bit counter: the bits of the run counts seen so far.
+  std::vector<uint8_t> CounterBitmap;
   FuzzingOptions Options;
   system_clock::time_point ProcessStartTime = system_clock::now();
-  static system_clock::time_point UnitStartTime;
+  static thread_local system_clock::time_point UnitStartTime;
 };
 
 };  // namespace fuzzer
@@ -20,8 +20,8 @@ extern "C" void TestOneInput(const uint8_t *Data, size_t Size);
 namespace fuzzer {
 
 // static
-Unit Fuzzer::CurrentUnit;
-system_clock::time_point Fuzzer::UnitStartTime;
+thread_local Unit Fuzzer::CurrentUnit;
+thread_local system_clock::time_point Fuzzer::UnitStartTime;
 
 void Fuzzer::SetDeathCallback() {
   __sanitizer_set_death_callback(DeathCallback);
@@ -48,6 +48,8 @@ void Fuzzer::AlarmCallback() {
 }
 
 void Fuzzer::ShuffleAndMinimize() {
+  if (!Options.CoverageCachePath.empty())
+    return MinimizeWithCoverageSignatures();
   bool PreferSmall =
       (Options.PreferSmallDuringInitialShuffle == 1 ||
        (Options.PreferSmallDuringInitialShuffle == -1 && rand() % 2));
@@ -116,17 +118,27 @@ size_t Fuzzer::RunOneMaximizeFullCoverageSet(const Unit &U) {
 }
 
 size_t Fuzzer::RunOneMaximizeTotalCoverage(const Unit &U) {
+  if (Options.UseCounters) {
+    // Modules may have been loaded since the last run.
+    CounterBitmap.resize(__sanitizer_get_number_of_counters());
+    __sanitizer_update_counter_bitset_and_clear_counters(0);
+  }
   size_t OldCoverage = __sanitizer_get_total_unique_coverage();
   TestOneInput(U.data(), U.size());
   size_t NewCoverage = __sanitizer_get_total_unique_coverage();
-  if (!(TotalNumberOfRuns & (TotalNumberOfRuns - 1)) && Options.Verbosity) {
+  size_t NumNewBits = 0;
+  if (Options.UseCounters)
+    NumNewBits = __sanitizer_update_counter_bitset_and_clear_counters(
+        CounterBitmap.data());
+  size_t Runs = TotalNumberOfRuns;
+  if (!(Runs & (Runs - 1)) && Options.Verbosity) {
     size_t Seconds = secondsSinceProcessStartUp();
     std::cerr
-        << "#" << TotalNumberOfRuns
+        << "#" << Runs
         << "\tcov: " << NewCoverage
-        << "\texec/s: " << (Seconds ? TotalNumberOfRuns / Seconds : 0) << "\n";
+        << "\texec/s: " << (Seconds ? Runs / Seconds : 0) << "\n";
   }
-  if (NewCoverage > OldCoverage)
+  if (NewCoverage > OldCoverage || NumNewBits)
     return NewCoverage;
   return 0;
 }
@@ -162,13 +174,13 @@ size_t Fuzzer::MutateAndTestOne(Unit *U) {
     Mutate(U, Options.MaxLen);
     size_t NewCoverage = RunOne(*U);
     if (NewCoverage) {
-      Corpus.push_back(*U);
+      LoopCorpus.push_back(*U);
       NewUnits++;
       if (Options.Verbosity) {
         std::cerr << "#" << TotalNumberOfRuns
                   << "\tNEW: " << NewCoverage
                   << " L: " << U->size()
-                  << " S: " << Corpus.size()
+                  << " S: " << LoopCorpus.size()
                   << " I: " << i
                   << "\t";
         if (U->size() < 30) {
@@ -186,20 +198,21 @@ size_t Fuzzer::MutateAndTestOne(Unit *U) {
   return NewUnits;
 }
 
-size_t Fuzzer::Loop(size_t NumIterations) {
+size_t Fuzzer::LoopInThread(size_t NumIterations) {
   size_t NewUnits = 0;
   for (size_t i = 1; i <= NumIterations; i++) {
-    for (size_t J1 = 0; J1 < Corpus.size(); J1++) {
+    for (size_t J1 = 0; J1 < LoopCorpus.size(); J1++) {
       if (TotalNumberOfRuns >= Options.MaxNumberOfRuns)
         return NewUnits;
       // First, simply mutate the unit w/o doing crosses.
-      CurrentUnit = Corpus[J1];
+      CurrentUnit = LoopCorpus[J1];
       NewUnits += MutateAndTestOne(&CurrentUnit);
-      // Now, cross with others.
+      // Now, cross with others, including those found by other threads.
       if (Options.DoCrossOver) {
-        for (size_t J2 = 0; J2 < Corpus.size(); J2++) {
+        for (size_t J2 = 0; J2 < LoopCorpus.size(); J2++) {
           CurrentUnit.clear();
-          CrossOver(Corpus[J1], Corpus[J2], &CurrentUnit, Options.MaxLen);
+          CrossOver(LoopCorpus[J1], LoopCorpus[J2], &CurrentUnit,
+                    Options.MaxLen);
           NewUnits += MutateAndTestOne(&CurrentUnit);
         }
       }
@@ -208,4 +221,30 @@ size_t Fuzzer::Loop(size_t NumIterations) {
   return NewUnits;
 }
 
+size_t Fuzzer::Loop(size_t NumIterations) {
+  for (size_t i = LoopCorpus.size(); i < Corpus.size(); i++)
+    LoopCorpus.push_back(Corpus[i]);
+
+  size_t NewUnits = 0;
+  if (Options.NumThreads <= 1) {
+    NewUnits = LoopInThread(NumIterations);
+  } else {
+    // The threads share the coverage of the process: an input is kept by
+    // the thread that sees the coverage grow while running it.
+    std::atomic<size_t> ThreadNewUnits(0);
+    std::vector<std::thread> Threads;
+    for (int i = 0; i < Options.NumThreads; i++)
+      Threads.emplace_back([&]() {
+        ThreadNewUnits += LoopInThread(NumIterations);
+      });
+    for (auto &T : Threads)
+      T.join();
+    NewUnits = ThreadNewUnits;
+  }
+
+  for (size_t i = Corpus.size(); i < LoopCorpus.size(); i++)
+    Corpus.push_back(LoopCorpus[i]);
+  return NewUnits;
+}
+
 }  // namespace fuzzer
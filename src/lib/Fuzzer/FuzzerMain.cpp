@@ -156,12 +156,27 @@ int main(int argc, char **argv) {
   Options.MutateDepth = Flags.mutate_depth;
   Options.ExitOnFirst = Flags.exit_on_first;
   Options.UseFullCoverageSet = Flags.use_full_coverage_set;
+  Options.UseCounters = Flags.use_counters;
+  Options.NumThreads = Flags.threads;
+  // Resetting the coverage between runs only works with a single thread.
+  if (Options.NumThreads > 1 &&
+      (Options.UseCounters || Options.UseFullCoverageSet)) {
+    std::cerr << "-threads is not compatible with -use_counters and "
+                 "-use_full_coverage_set, using one thread\n";
+    Options.NumThreads = 1;
+  }
   Options.PreferSmallDuringInitialShuffle =
       Flags.prefer_small_during_initial_shuffle;
   if (Flags.runs >= 0)
     Options.MaxNumberOfRuns = Flags.runs;
   if (!inputs.empty())
     Options.OutputCorpus = inputs[0];
+  if (Flags.coverage_cache && !inputs.empty()) {
+    std::string Dir = inputs[0];
+    while (Dir.size() > 1 && Dir.back() == '/')
+      Dir.pop_back();
+    Options.CoverageCachePath = Dir + ".coverage_cache";
+  }
   Fuzzer F(Options);
 
   unsigned seed = Flags.seed;
@@ -176,6 +191,15 @@ int main(int argc, char **argv) {
   if (Flags.timeout > 0)
     SetTimer(Flags.timeout);
 
+  if (Flags.merge) {
+    if (inputs.size() < 2) {
+      std::cerr << "-merge=1 requires at least two input directories\n";
+      return 1;
+    }
+    F.Merge(inputs);
+    return 0;
+  }
+
   for (auto &inp : inputs)
     F.ReadDir(inp);
 
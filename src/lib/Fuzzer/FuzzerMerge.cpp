@@ -0,0 +1,243 @@
+//===- FuzzerMerge.cpp - Corpus minimization with coverage signatures -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// Coverage signatures of units, their cache, and the corpus minimization and
+// merging based on them.
+//===----------------------------------------------------------------------===//
+
+#include "FuzzerInternal.h"
+#include <sanitizer/coverage_interface.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include <sstream>
+#include <unistd.h>
+
+// This function should be defined by the user.
+extern "C" void TestOneInput(const uint8_t *Data, size_t Size);
+
+namespace fuzzer {
+
+static const char kCacheHeader[] = "libFuzzer coverage cache v1";
+
+std::string ExecutableKey() {
+  Unit Exe = FileToVector("/proc/self/exe");
+  if (Exe.empty())
+    return "";
+  return Hash(Exe);
+}
+
+bool ReadCoverageCache(const std::string &Path, const std::string &Key,
+                       CoverageCache *Cache) {
+  std::ifstream IF(Path);
+  std::string Line;
+  if (Key.empty() || !std::getline(IF, Line) ||
+      Line != std::string(kCacheHeader) + " " + Key)
+    return false;
+  while (std::getline(IF, Line)) {
+    std::istringstream IS(Line);
+    std::string UnitHash;
+    if (!(IS >> UnitHash))
+      continue;
+    CoverageSignature &Sig = (*Cache)[UnitHash];
+    Sig.clear();
+    uintptr_t PC;
+    while (IS >> std::hex >> PC)
+      Sig.push_back(PC);
+  }
+  return true;
+}
+
+void WriteCoverageCache(const std::string &Path, const std::string &Key,
+                        const CoverageCache &Cache) {
+  if (Key.empty())
+    return;
+  // Write a file of our own, then move it in place: processes sharing the
+  // corpus read either the old cache or the new one.
+  std::string TempPath = Path + ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream OF(TempPath);
+    OF << kCacheHeader << " " << Key << "\n" << std::hex;
+    for (const auto &It : Cache) {
+      OF << It.first;
+      for (uintptr_t PC : It.second)
+        OF << " " << PC;
+      OF << "\n";
+    }
+    if (!OF.good()) {
+      OF.close();
+      std::remove(TempPath.c_str());
+      return;
+    }
+  }
+  if (std::rename(TempPath.c_str(), Path.c_str()))
+    std::remove(TempPath.c_str());
+}
+
+std::vector<size_t> SelectCoveringSubset(
+    const std::vector<CoverageSignature> &Sigs,
+    const std::vector<size_t> &Sizes, std::unordered_set<uintptr_t> *Covered) {
+  assert(Sigs.size() == Sizes.size());
+  auto Gain = [&](size_t Idx) {
+    size_t Res = 0;
+    for (uintptr_t PC : Sigs[Idx])
+      Res += !Covered->count(PC);
+    return Res;
+  };
+  struct Candidate {
+    size_t Gain, Size, Idx;
+  };
+  auto LowerPriority = [](const Candidate &A, const Candidate &B) {
+    if (A.Gain != B.Gain)
+      return A.Gain < B.Gain;
+    if (A.Size != B.Size)
+      return A.Size > B.Size;
+    return A.Idx > B.Idx;
+  };
+  std::priority_queue<Candidate, std::vector<Candidate>,
+                      decltype(LowerPriority)> Queue(LowerPriority);
+  for (size_t Idx = 0; Idx < Sigs.size(); Idx++)
+    if (size_t G = Gain(Idx))
+      Queue.push({G, Sizes[Idx], Idx});
+
+  // The gain of a unit only decreases as PCs get covered, so the gain in the
+  // queue is an upper bound: a unit whose gain is still up to date is the
+  // best one, and the others are only recomputed when they reach the top.
+  std::vector<size_t> Res;
+  while (!Queue.empty()) {
+    Candidate C = Queue.top();
+    Queue.pop();
+    size_t G = Gain(C.Idx);
+    if (!G)
+      continue;
+    if (G < C.Gain) {
+      C.Gain = G;
+      Queue.push(C);
+      continue;
+    }
+    Covered->insert(Sigs[C.Idx].begin(), Sigs[C.Idx].end());
+    Res.push_back(C.Idx);
+  }
+  return Res;
+}
+
+// Runs U alone, with the coverage reset, and returns the PCs it covers.
+CoverageSignature Fuzzer::RunOneForSignature(const Unit &U) {
+  UnitStartTime = system_clock::now();
+  TotalNumberOfRuns++;
+  __sanitizer_reset_coverage();
+  TestOneInput(U.data(), U.size());
+  uintptr_t *PCs;
+  uintptr_t NumPCs = __sanitizer_get_coverage_guards(&PCs);
+  uintptr_t Base = reinterpret_cast<uintptr_t>(&TestOneInput);
+  CoverageSignature Sig;
+  for (uintptr_t i = 0; i < NumPCs; i++)
+    if (PCs[i])
+      Sig.push_back(PCs[i] - Base);
+  std::sort(Sig.begin(), Sig.end());
+  Sig.erase(std::unique(Sig.begin(), Sig.end()), Sig.end());
+  return Sig;
+}
+
+std::vector<CoverageSignature> Fuzzer::ComputeSignatures(
+    const std::vector<Unit> &Units) {
+  CoverageCache Cache;
+  std::string Key;
+  if (!Options.CoverageCachePath.empty()) {
+    Key = ExecutableKey();
+    ReadCoverageCache(Options.CoverageCachePath, Key, &Cache);
+  }
+  // Only the signatures of the current units are saved back.
+  CoverageCache NewCache;
+  std::vector<CoverageSignature> Sigs;
+  size_t NumRun = 0;
+  for (const auto &U : Units) {
+    std::string UnitHash = Hash(U);
+    auto It = Cache.find(UnitHash);
+    if (It == Cache.end()) {
+      It = Cache.insert({UnitHash, RunOneForSignature(U)}).first;
+      NumRun++;
+    }
+    Sigs.push_back(It->second);
+    NewCache.insert(*It);
+  }
+  if (!Options.CoverageCachePath.empty() &&
+      (NumRun || NewCache.size() != Cache.size()))
+    WriteCoverageCache(Options.CoverageCachePath, Key, NewCache);
+  if (Options.Verbosity)
+    std::cerr << "Signatures: " << Units.size() << " units, "
+              << Units.size() - NumRun << " cached\n";
+  return Sigs;
+}
+
+void Fuzzer::MinimizeWithCoverageSignatures() {
+  for (auto &U : Corpus)
+    if (U.size() > static_cast<size_t>(Options.MaxLen))
+      U.resize(Options.MaxLen);
+  std::vector<CoverageSignature> Sigs = ComputeSignatures(Corpus);
+  std::vector<size_t> Sizes;
+  for (const auto &U : Corpus)
+    Sizes.push_back(U.size());
+  std::unordered_set<uintptr_t> Covered;
+  std::vector<size_t> Picked = SelectCoveringSubset(Sigs, Sizes, &Covered);
+
+  std::vector<Unit> NewCorpus;
+  for (size_t Idx : Picked)
+    NewCorpus.push_back(Corpus[Idx]);
+  if (NewCorpus.empty())
+    NewCorpus.push_back(Corpus[0]);
+  Corpus = NewCorpus;
+
+  // Run the units we keep again, so that the coverage state is theirs.
+  __sanitizer_reset_coverage();
+  size_t MaxCov = 0;
+  for (const auto &U : Corpus) {
+    CurrentUnit = U;
+    if (size_t NewCoverage = RunOne(CurrentUnit))
+      MaxCov = NewCoverage;
+  }
+  if (Options.Verbosity)
+    std::cerr << "Minimize done: " << Corpus.size() << " U: " << Covered.size()
+              << " IC: " << MaxCov << "\n";
+}
+
+size_t Fuzzer::Merge(const std::vector<std::string> &Corpora) {
+  assert(!Corpora.empty());
+  std::vector<Unit> Units;
+  ReadDirToVectorOfUnits(Corpora[0].c_str(), &Units);
+  size_t NumOldUnits = Units.size();
+  for (size_t i = 1; i < Corpora.size(); i++)
+    ReadDirToVectorOfUnits(Corpora[i].c_str(), &Units);
+  for (auto &U : Units)
+    if (U.size() > static_cast<size_t>(Options.MaxLen))
+      U.resize(Options.MaxLen);
+
+  std::vector<CoverageSignature> Sigs = ComputeSignatures(Units);
+  std::unordered_set<uintptr_t> Covered;
+  for (size_t i = 0; i < NumOldUnits; i++)
+    Covered.insert(Sigs[i].begin(), Sigs[i].end());
+  size_t OldCoverage = Covered.size();
+
+  std::vector<CoverageSignature> NewSigs(Sigs.begin() + NumOldUnits,
+                                         Sigs.end());
+  std::vector<size_t> Sizes;
+  for (size_t i = NumOldUnits; i < Units.size(); i++)
+    Sizes.push_back(Units[i].size());
+  std::vector<size_t> Picked = SelectCoveringSubset(NewSigs, Sizes, &Covered);
+  for (size_t Idx : Picked)
+    WriteToOutputCorpus(Units[NumOldUnits + Idx]);
+  if (Options.Verbosity)
+    std::cerr << "Merge: written " << Picked.size() << " out of "
+              << Units.size() - NumOldUnits << " units; coverage "
+              << OldCoverage << " => " << Covered.size() << "\n";
+  return Picked.size();
+}
+
+}  // namespace fuzzer
@@ -60,3 +60,50 @@ TEST(Fuzzer, CrossOver) {
     EXPECT_EQ(ExpectedUnitsWitThisLength, FoundUnits);
   }
 }
+
+TEST(Fuzzer, SharedCorpus) {
+  using namespace fuzzer;
+  SharedCorpus C;
+  EXPECT_EQ(C.size(), 0U);
+  EXPECT_TRUE(C.push_back({1, 2, 3, 4}));
+  EXPECT_EQ(C.size(), 1U);
+  EXPECT_EQ(C[0], Unit({1, 2, 3, 4}));
+
+  const size_t kThreads = 4, kUnitsPerThread = 1000;
+  std::vector<std::thread> Threads;
+  for (size_t T = 0; T < kThreads; T++)
+    Threads.emplace_back([&C, T]() {
+      for (size_t I = 0; I < kUnitsPerThread; I++) {
+        // Every published unit must be complete.
+        for (size_t J = 0, N = C.size(); J < N; J++)
+          EXPECT_FALSE(C[J].empty());
+        C.push_back({static_cast<uint8_t>(T), static_cast<uint8_t>(I >> 8),
+                     static_cast<uint8_t>(I)});
+      }
+    });
+  for (auto &T : Threads)
+    T.join();
+  EXPECT_EQ(C.size(), 1 + kThreads * kUnitsPerThread);
+  std::set<Unit> Units;
+  for (size_t I = 0; I < C.size(); I++)
+    Units.insert(C[I]);
+  EXPECT_EQ(Units.size(), C.size());
+}
+
+TEST(Fuzzer, SelectCoveringSubset) {
+  using namespace fuzzer;
+  std::vector<CoverageSignature> Sigs = {{1, 2}, {2, 3}, {1, 2, 3}, {4}, {}};
+  std::vector<size_t> Sizes = {1, 1, 5, 3, 0};
+  std::unordered_set<uintptr_t> Covered;
+  EXPECT_EQ(SelectCoveringSubset(Sigs, Sizes, &Covered),
+            std::vector<size_t>({2, 3}));
+  EXPECT_EQ(Covered.size(), 4U);
+
+  // Of the units adding as much, the smallest one is picked.
+  Sizes[2] = 1;
+  Sigs.push_back({1, 2, 3});
+  Sizes.push_back(0);
+  Covered = {4};
+  EXPECT_EQ(SelectCoveringSubset(Sigs, Sizes, &Covered),
+            std::vector<size_t>({5}));
+}
@@ -2374,9 +2374,9 @@ GetElementPtrConstantExpr(Constant *C, ArrayRef<Constant*> IdxList,
   : ConstantExpr(DestTy, Instruction::GetElementPtr,
                  OperandTraits<GetElementPtrConstantExpr>::op_end(this)
                  - (IdxList.size()+1), IdxList.size()+1) {
-  OperandList[0] = C;
+  getOperandList()[0] = C;
   for (unsigned i = 0, E = IdxList.size(); i != E; ++i)
-    OperandList[i+1] = IdxList[i];
+    getOperandList()[i+1] = IdxList[i];
 }
 
 //===----------------------------------------------------------------------===//
@@ -2833,7 +2833,7 @@ void ConstantArray::replaceUsesOfWithOnConstant(Value *From, Value *To,
 
   // Keep track of whether all the values in the array are "ToC".
   bool AllSame = true;
-  for (Use *O = OperandList, *E = OperandList+getNumOperands(); O != E; ++O) {
+  for (Use *O = op_begin(), *E = op_end(); O != E; ++O) {
     Constant *Val = cast<Constant>(O->get());
     if (Val == From) {
       Val = ToC;
@@ -2860,7 +2860,7 @@ void ConstantArray::replaceUsesOfWithOnConstant(Value *From, Value *To,
 
   // Update to the new value.
   if (Constant *C = getContext().pImpl->ArrayConstants.replaceOperandsInPlace(
-          Values, this, From, ToC, NumUpdated, U - OperandList))
+          Values, this, From, ToC, NumUpdated, U - op_begin()))
     replaceUsesOfWithOnConstantImpl(C);
 }
 
@@ -2869,7 +2869,7 @@ void ConstantStruct::replaceUsesOfWithOnConstant(Value *From, Value *To,
   assert(isa<Constant>(To) && "Cannot make Constant refer to non-constant!");
   Constant *ToC = cast<Constant>(To);
 
-  unsigned OperandToUpdate = U-OperandList;
+  unsigned OperandToUpdate = U - op_begin();
   assert(getOperand(OperandToUpdate) == From && "ReplaceAllUsesWith broken!");
 
   SmallVector<Constant*, 8> Values;
@@ -2881,20 +2881,20 @@ void ConstantStruct::replaceUsesOfWithOnConstant(Value *From, Value *To,
   bool isAllUndef = false;
   if (ToC->isNullValue()) {
     isAllZeros = true;
-    for (Use *O = OperandList, *E = OperandList+getNumOperands(); O != E; ++O) {
+    for (Use *O = op_begin(), *E = op_end(); O != E; ++O) {
       Constant *Val = cast<Constant>(O->get());
       Values.push_back(Val);
       if (isAllZeros) isAllZeros = Val->isNullValue();
     }
   } else if (isa<UndefValue>(ToC)) {
     isAllUndef = true;
-    for (Use *O = OperandList, *E = OperandList+getNumOperands(); O != E; ++O) {
+    for (Use *O = op_begin(), *E = op_end(); O != E; ++O) {
       Constant *Val = cast<Constant>(O->get());
       Values.push_back(Val);
       if (isAllUndef) isAllUndef = isa<UndefValue>(Val);
     }
   } else {
-    for (Use *O = OperandList, *E = OperandList + getNumOperands(); O != E; ++O)
+    for (Use *O = op_begin(), *E = op_end(); O != E; ++O)
       Values.push_back(cast<Constant>(O->get()));
   }
   Values[OperandToUpdate] = ToC;
@@ -2938,7 +2938,7 @@ void ConstantVector::replaceUsesOfWithOnConstant(Value *From, Value *To,
 
   // Update to the new value.
   if (Constant *C = getContext().pImpl->VectorConstants.replaceOperandsInPlace(
-          Values, this, From, ToC, NumUpdated, U - OperandList))
+          Values, this, From, ToC, NumUpdated, U - op_begin()))
     replaceUsesOfWithOnConstantImpl(C);
 }
 
@@ -2966,7 +2966,7 @@ void ConstantExpr::replaceUsesOfWithOnConstant(Value *From, Value *ToV,
 
   // Update to the new value.
   if (Constant *C = getContext().pImpl->ExprConstants.replaceOperandsInPlace(
-          NewOps, this, From, To, NumUpdated, U - OperandList))
+          NewOps, this, From, To, NumUpdated, U - op_begin()))
     replaceUsesOfWithOnConstantImpl(C);
 }
 
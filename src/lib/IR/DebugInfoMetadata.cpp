@@ -290,6 +290,29 @@ DICompositeType *DICompositeType::getImpl(
                        Ops);
 }
 
+DICompositeType *DICompositeType::getODRType(
+    LLVMContext &Context, bool IsDistinct, unsigned Tag, MDString *Name,
+    Metadata *File, unsigned Line, Metadata *Scope, Metadata *BaseType,
+    uint64_t SizeInBits, uint64_t AlignInBits, uint64_t OffsetInBits,
+    unsigned Flags, Metadata *Elements, unsigned RuntimeLang,
+    Metadata *VTableHolder, Metadata *TemplateParams, MDString *Identifier) {
+  auto *Map = Context.pImpl->DITypeMap.get();
+  bool IsODR = Map && Identifier && !(Flags & FlagFwdDecl);
+  if (IsODR)
+    if (DICompositeType *CT = Map->lookup(Identifier))
+      return CT;
+
+  auto *CT = getImpl(Context, Tag, Name, File, Line, Scope, BaseType,
+                     SizeInBits, AlignInBits, OffsetInBits, Flags, Elements,
+                     RuntimeLang, VTableHolder, TemplateParams, Identifier,
+                     IsDistinct ? Distinct : Uniqued);
+  // Unresolved uniqued nodes may still be merged into another one and
+  // deleted, so only remember the ones that are here to stay.
+  if (IsODR && CT->isResolved())
+    (*Map)[Identifier] = CT;
+  return CT;
+}
+
 DISubroutineType *DISubroutineType::getImpl(LLVMContext &Context,
                                             unsigned Flags, Metadata *TypeArray,
                                             StorageType Storage,
@@ -0,0 +1,116 @@
+//===-- FunctionInfo.cpp - Function summary index -------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the function summary index.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/FunctionInfo.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include <algorithm>
+
+using namespace llvm;
+
+/// Whether \p V refers to a global value with local linkage, looking through
+/// constant expressions.
+static bool refersToLocal(const Value *V,
+                          SmallPtrSetImpl<const Constant *> &Visited) {
+  if (const auto *GV = dyn_cast<GlobalValue>(V))
+    return GV->hasLocalLinkage();
+  const auto *C = dyn_cast<Constant>(V);
+  if (!C || !Visited.insert(C).second)
+    return false;
+  for (const Value *Op : C->operands())
+    if (refersToLocal(Op, Visited))
+      return true;
+  return false;
+}
+
+FunctionSummary FunctionSummary::compute(const Function &F) {
+  FunctionSummary Summary;
+  Summary.Linkage = F.getLinkage();
+
+  SmallPtrSet<const Constant *, 16> Visited;
+  SmallPtrSet<const Function *, 16> Callees;
+  for (const BasicBlock &BB : F)
+    for (const Instruction &I : BB) {
+      if (isa<DbgInfoIntrinsic>(I))
+        continue;
+      ++Summary.InstCount;
+
+      if (!Summary.RefersToLocal)
+        for (const Value *Op : I.operands())
+          if (refersToLocal(Op, Visited)) {
+            Summary.RefersToLocal = true;
+            break;
+          }
+
+      ImmutableCallSite CS(&I);
+      if (!CS)
+        continue;
+      const Function *Callee =
+          dyn_cast<Function>(CS.getCalledValue()->stripPointerCasts());
+      if (Callee && Callee->hasName() && !Callee->isIntrinsic() &&
+          Callees.insert(Callee).second)
+        Summary.Callees.push_back(Callee->getName());
+    }
+  // Keep the summary independent from the order of the instructions.
+  std::sort(Summary.Callees.begin(), Summary.Callees.end());
+  return Summary;
+}
+
+bool FunctionSummary::isImportable() const {
+  // The definition must be the one the linker keeps and be equivalent to any
+  // other definition with that name, so that a copy can be used instead.
+  return (Linkage == GlobalValue::ExternalLinkage ||
+          Linkage == GlobalValue::WeakODRLinkage) &&
+         !RefersToLocal;
+}
+
+unsigned FunctionInfoIndex::addModule(StringRef Path) {
+  ModulePaths.push_back(Path);
+  return ModulePaths.size() - 1;
+}
+
+unsigned FunctionInfoIndex::addModule(const Module &M, StringRef Path) {
+  unsigned ModuleID = addModule(Path);
+  for (const Function &F : M)
+    if (!F.isDeclaration() && F.hasName())
+      addFunction(F.getName(), ModuleID, FunctionSummary::compute(F));
+  return ModuleID;
+}
+
+void FunctionInfoIndex::addFunction(StringRef Name, unsigned ModuleID,
+                                    FunctionSummary Summary) {
+  assert(ModuleID < ModulePaths.size() && "Unknown module");
+  Functions[Name].emplace_back(ModuleID, std::move(Summary));
+}
+
+void FunctionInfoIndex::mergeFrom(const FunctionInfoIndex &Other) {
+  unsigned FirstID = ModulePaths.size();
+  ModulePaths.insert(ModulePaths.end(), Other.ModulePaths.begin(),
+                     Other.ModulePaths.end());
+  for (const auto &Entry : Other.Functions)
+    for (const ModuleSummaryTy &Definition : Entry.getValue())
+      Functions[Entry.getKey()].emplace_back(FirstID + Definition.first,
+                                             Definition.second);
+}
+
+int FunctionInfoIndex::findModule(StringRef Path) const {
+  auto I = std::find(ModulePaths.begin(), ModulePaths.end(), Path);
+  if (I == ModulePaths.end())
+    return -1;
+  return I - ModulePaths.begin();
+}
@@ -14,6 +14,7 @@
 
 #include "llvm/Support/GCOV.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
@@ -175,16 +176,21 @@ bool GCOVFunction::readGCNO(GCOVBuffer &Buff, GCOV::GCOVVersion Version) {
              << ").\n";
       return false;
     }
+    Edges.reserve(Edges.size() + EdgeCount);
     for (uint32_t i = 0, e = EdgeCount; i != e; ++i) {
-      uint32_t Dst;
-      if (!Buff.readInt(Dst))
+      uint32_t Dst, Flags;
+      if (!Buff.readInt(Dst) || !Buff.readInt(Flags))
         return false;
-      Edges.push_back(make_unique<GCOVEdge>(*Blocks[BlockNo], *Blocks[Dst]));
+      if (Dst >= BlockCount) {
+        errs() << "Unexpected block number: " << Dst << " (in " << Name
+               << ").\n";
+        return false;
+      }
+      Edges.push_back(
+          make_unique<GCOVEdge>(*Blocks[BlockNo], *Blocks[Dst], Flags));
       GCOVEdge *Edge = Edges.back().get();
       Blocks[BlockNo]->addDstEdge(Edge);
       Blocks[Dst]->addSrcEdge(Edge);
-      if (!Buff.readInt(Dummy))
-        return false; // Edge flag
     }
   }
 
@@ -298,30 +304,106 @@ bool GCOVFunction::readGCDA(GCOVBuffer &Buff, GCOV::GCOVVersion Version) {
     return false;
   Count /= 2;
 
-  // This for loop adds the counts for each block. A second nested loop is
-  // required to combine the edge counts that are contained in the GCDA file.
-  for (uint32_t BlockNo = 0; Count > 0; ++BlockNo) {
+  // The GCDA file has the counts of the edges off the spanning tree, block by
+  // block. Read those first and work out the others from them.
+  for (const auto &Block : Blocks) {
     // The last block is always reserved for exit block
-    if (BlockNo >= Blocks.size()) {
-      errs() << "Unexpected number of edges (in " << Name << ").\n";
-      return false;
-    }
-    if (BlockNo == Blocks.size() - 1)
+    if (Block == Blocks.back() && Block->getNumDstEdges())
       errs() << "(" << Name << ") has arcs from exit block.\n";
-    GCOVBlock &Block = *Blocks[BlockNo];
-    for (size_t EdgeNo = 0, End = Block.getNumDstEdges(); EdgeNo < End;
-         ++EdgeNo) {
+    for (GCOVEdge *Edge : Block->dsts()) {
+      if (Edge->isOnTree())
+        continue;
       if (Count == 0) {
         errs() << "Unexpected number of edges (in " << Name << ").\n";
         return false;
       }
-      uint64_t ArcCount;
-      if (!Buff.readInt64(ArcCount))
+      if (!Buff.readInt64(Edge->Count))
         return false;
-      Block.addCount(EdgeNo, ArcCount);
       --Count;
     }
-    Block.sortDstEdges();
+  }
+  if (Count != 0) {
+    errs() << "Unexpected number of edges (in " << Name << ").\n";
+    return false;
+  }
+  if (!solveTreeEdges())
+    return false;
+
+  for (const auto &Block : Blocks) {
+    for (size_t EdgeNo = 0, End = Block->getNumDstEdges(); EdgeNo < End;
+         ++EdgeNo)
+      Block->addCount(EdgeNo, (*(Block->dst_begin() + EdgeNo))->Count);
+    Block->sortDstEdges();
+  }
+  return true;
+}
+
+/// solveTreeEdges - Work out the counts of the edges on the spanning tree from
+/// those of the other edges. The count of every block but the entry and exit
+/// blocks is both the sum of the counts of the edges into it and the sum of
+/// those out of it, so an edge can be solved once it is the only unknown edge
+/// into or out of a block whose count is known from its other side. Return
+/// false if some edges can't be solved.
+bool GCOVFunction::solveTreeEdges() {
+  SmallVector<unsigned, 16> UnknownSrcs(Blocks.size()),
+      UnknownDsts(Blocks.size());
+  unsigned Unknown = 0;
+  for (const auto &Edge : Edges) {
+    if (!Edge->isOnTree())
+      continue;
+    ++UnknownDsts[Edge->Src.getNumber()];
+    ++UnknownSrcs[Edge->Dst.getNumber()];
+    ++Unknown;
+  }
+  if (!Unknown)
+    return true;
+
+  SmallVector<GCOVBlock *, 16> Worklist;
+  for (const auto &Block : Blocks)
+    Worklist.push_back(Block.get());
+  SmallPtrSet<GCOVEdge *, 16> Solved;
+  while (!Worklist.empty() && Unknown) {
+    GCOVBlock &Block = *Worklist.pop_back_val();
+    uint32_t N = Block.getNumber();
+    // Flow enters the function at the entry block and leaves it at the blocks
+    // without successors, so those don't balance.
+    if (N == 0 || !Block.getNumDstEdges())
+      continue;
+    bool SolveDst;
+    if (!UnknownSrcs[N] && UnknownDsts[N] == 1)
+      SolveDst = true;
+    else if (!UnknownDsts[N] && UnknownSrcs[N] == 1)
+      SolveDst = false;
+    else
+      continue;
+
+    GCOVEdge *Edge = nullptr;
+    for (GCOVEdge *E : SolveDst ? Block.dsts() : Block.srcs())
+      if (E->isOnTree() && !Solved.count(E))
+        Edge = E;
+    uint64_t SrcsCount = 0, DstsCount = 0;
+    for (const GCOVEdge *E : Block.srcs())
+      SrcsCount += E->Count;
+    for (const GCOVEdge *E : Block.dsts())
+      DstsCount += E->Count;
+    // The unknown edge counts as zero in its own sum. Flushing the counters
+    // while the function runs can leave them inconsistent; don't wrap.
+    uint64_t Total = SolveDst ? SrcsCount : DstsCount;
+    uint64_t Others = SolveDst ? DstsCount : SrcsCount;
+    Edge->Count = Total > Others ? Total - Others : 0;
+
+    Solved.insert(Edge);
+    --UnknownDsts[Edge->Src.getNumber()];
+    --UnknownSrcs[Edge->Dst.getNumber()];
+    --Unknown;
+    Worklist.push_back(&Edge->Src);
+    Worklist.push_back(&Edge->Dst);
+  }
+
+  if (Unknown) {
+    errs() << "Unable to work out the counts of " << Unknown
+           << " edges (in " << Name << ").\n";
+    return false;
   }
   return true;
 }
@@ -373,10 +455,12 @@ GCOVBlock::~GCOVBlock() {
 /// destination has no outgoing edges, also update that block's count too.
 void GCOVBlock::addCount(size_t DstEdgeNo, uint64_t N) {
   assert(DstEdgeNo < DstEdges.size()); // up to caller to ensure EdgeNo is valid
-  DstEdges[DstEdgeNo]->Count = N;
+  GCOVEdge *Edge = DstEdges[DstEdgeNo];
+  Edge->Count = N;
   Counter += N;
-  if (!DstEdges[DstEdgeNo]->Dst.getNumDstEdges())
-    DstEdges[DstEdgeNo]->Dst.Counter += N;
+  // The exit block counts the returns, so leave out fake edges to it.
+  if (!Edge->Dst.getNumDstEdges() && !Edge->isFake())
+    Edge->Dst.Counter += N;
 }
 
 /// sortDstEdges - Sort destination edges by block number, nop if already
@@ -391,8 +475,7 @@ void GCOVBlock::sortDstEdges() {
 /// collectLineCounts - Collect line counts. This must be used after
 /// reading .gcno and .gcda files.
 void GCOVBlock::collectLineCounts(FileInfo &FI) {
-  for (uint32_t N : Lines)
-    FI.addBlockLine(Parent.getFilename(), N, this);
+  FI.addBlockLines(Parent.getFilename(), Lines, this);
 }
 
 /// dump - Dump GCOVBlock content to dbgs() for debugging purposes.
@@ -85,9 +85,9 @@ const char *SelectInst::areInvalidOperands(Value *Op0, Value *Op1, Value *Op2) {
 //===----------------------------------------------------------------------===//
 
 PHINode::PHINode(const PHINode &PN)
-  : Instruction(PN.getType(), Instruction::PHI,
-                allocHungoffUses(PN.getNumOperands()), PN.getNumOperands()),
+  : Instruction(PN.getType(), Instruction::PHI, nullptr, PN.getNumOperands()),
     ReservedSpace(PN.getNumOperands()) {
+  setHungOffOperands(allocHungoffUses(ReservedSpace));
   std::copy(PN.op_begin(), PN.op_end(), op_begin());
   std::copy(PN.block_begin(), PN.block_end(), block_begin());
   SubclassOptionalData = PN.SubclassOptionalData;
@@ -148,7 +148,7 @@ void PHINode::growOperands() {
   BasicBlock **OldBlocks = block_begin();
 
   ReservedSpace = NumOps;
-  OperandList = allocHungoffUses(ReservedSpace);
+  setHungOffOperands(allocHungoffUses(ReservedSpace));
 
   std::copy(OldOps, OldOps + e, op_begin());
   std::copy(OldBlocks, OldBlocks + e, block_begin());
@@ -192,10 +192,12 @@ LandingPadInst::LandingPadInst(Type *RetTy, Value *PersonalityFn,
 }
 
 LandingPadInst::LandingPadInst(const LandingPadInst &LP)
-  : Instruction(LP.getType(), Instruction::LandingPad,
-                allocHungoffUses(LP.getNumOperands()), LP.getNumOperands()),
+  : Instruction(LP.getType(), Instruction::LandingPad, nullptr,
+                LP.getNumOperands()),
     ReservedSpace(LP.getNumOperands()) {
-  Use *OL = OperandList, *InOL = LP.OperandList;
+  setHungOffOperands(allocHungoffUses(ReservedSpace));
+  Use *OL = getOperandList();
+  const Use *InOL = LP.getOperandList();
   for (unsigned I = 0, E = ReservedSpace; I != E; ++I)
     OL[I] = InOL[I];
 
@@ -226,8 +228,8 @@ void LandingPadInst::init(Value *PersFn, unsigned NumReservedValues,
                           const Twine &NameStr) {
   ReservedSpace = NumReservedValues;
   NumOperands = 1;
-  OperandList = allocHungoffUses(ReservedSpace);
-  OperandList[0] = PersFn;
+  setHungOffOperands(allocHungoffUses(ReservedSpace));
+  getOperandList()[0] = PersFn;
   setName(NameStr);
   setCleanup(false);
 }
@@ -240,11 +242,11 @@ void LandingPadInst::growOperands(unsigned Size) {
   ReservedSpace = (e + Size / 2) * 2;
 
   Use *NewOps = allocHungoffUses(ReservedSpace);
-  Use *OldOps = OperandList;
+  Use *OldOps = getOperandList();
   for (unsigned i = 0; i != e; ++i)
       NewOps[i] = OldOps[i];
 
-  OperandList = NewOps;
+  setHungOffOperands(NewOps);
   Use::zap(OldOps, OldOps + e, true);
 }
 
@@ -253,7 +255,7 @@ void LandingPadInst::addClause(Constant *Val) {
   growOperands(1);
   assert(OpNo < ReservedSpace && "Growing didn't work!");
   ++NumOperands;
-  OperandList[OpNo] = Val;
+  getOperandList()[OpNo] = Val;
 }
 
 //===----------------------------------------------------------------------===//
@@ -1343,7 +1345,7 @@ FenceInst::FenceInst(LLVMContext &C, AtomicOrdering Ordering,
 void GetElementPtrInst::init(Value *Ptr, ArrayRef<Value *> IdxList,
                              const Twine &Name) {
   assert(NumOperands == 1 + IdxList.size() && "NumOperands not initialized?");
-  OperandList[0] = Ptr;
+  getOperandList()[0] = Ptr;
   std::copy(IdxList.begin(), IdxList.end(), op_begin() + 1);
   setName(Name);
 }
@@ -3406,10 +3408,10 @@ void SwitchInst::init(Value *Value, BasicBlock *Default, unsigned NumReserved) {
   assert(Value && Default && NumReserved);
   ReservedSpace = NumReserved;
   NumOperands = 2;
-  OperandList = allocHungoffUses(ReservedSpace);
+  setHungOffOperands(allocHungoffUses(ReservedSpace));
 
-  OperandList[0] = Value;
-  OperandList[1] = Default;
+  getOperandList()[0] = Value;
+  getOperandList()[1] = Default;
 }
 
 /// SwitchInst ctor - Create a new switch instruction, specifying a value to
@@ -3438,7 +3440,8 @@ SwitchInst::SwitchInst(const SwitchInst &SI)
   : TerminatorInst(SI.getType(), Instruction::Switch, nullptr, 0) {
   init(SI.getCondition(), SI.getDefaultDest(), SI.getNumOperands());
   NumOperands = SI.getNumOperands();
-  Use *OL = OperandList, *InOL = SI.OperandList;
+  Use *OL = getOperandList();
+  const Use *InOL = SI.getOperandList();
   for (unsigned i = 2, E = SI.getNumOperands(); i != E; i += 2) {
     OL[i] = InOL[i];
     OL[i+1] = InOL[i+1];
@@ -3474,7 +3477,7 @@ void SwitchInst::removeCase(CaseIt i) {
   assert(2 + idx*2 < getNumOperands() && "Case index out of range!!!");
 
   unsigned NumOps = getNumOperands();
-  Use *OL = OperandList;
+  Use *OL = getOperandList();
 
   // Overwrite this case with the end of the list.
   if (2 + (idx + 1) * 2 != NumOps) {
@@ -3497,11 +3500,11 @@ void SwitchInst::growOperands() {
 
   ReservedSpace = NumOps;
   Use *NewOps = allocHungoffUses(NumOps);
-  Use *OldOps = OperandList;
+  Use *OldOps = getOperandList();
   for (unsigned i = 0; i != e; ++i) {
       NewOps[i] = OldOps[i];
   }
-  OperandList = NewOps;
+  setHungOffOperands(NewOps);
   Use::zap(OldOps, OldOps + e, true);
 }
 
@@ -3525,9 +3528,9 @@ void IndirectBrInst::init(Value *Address, unsigned NumDests) {
          "Address of indirectbr must be a pointer");
   ReservedSpace = 1+NumDests;
   NumOperands = 1;
-  OperandList = allocHungoffUses(ReservedSpace);
+  setHungOffOperands(allocHungoffUses(ReservedSpace));
   
-  OperandList[0] = Address;
+  getOperandList()[0] = Address;
 }
 
 
@@ -3540,10 +3543,10 @@ void IndirectBrInst::growOperands() {
   
   ReservedSpace = NumOps;
   Use *NewOps = allocHungoffUses(NumOps);
-  Use *OldOps = OperandList;
+  Use *OldOps = getOperandList();
   for (unsigned i = 0; i != e; ++i)
     NewOps[i] = OldOps[i];
-  OperandList = NewOps;
+  setHungOffOperands(NewOps);
   Use::zap(OldOps, OldOps + e, true);
 }
 
@@ -3563,9 +3566,10 @@ IndirectBrInst::IndirectBrInst(Value *Address, unsigned NumCases,
 
 IndirectBrInst::IndirectBrInst(const IndirectBrInst &IBI)
   : TerminatorInst(Type::getVoidTy(IBI.getContext()), Instruction::IndirectBr,
-                   allocHungoffUses(IBI.getNumOperands()),
-                   IBI.getNumOperands()) {
-  Use *OL = OperandList, *InOL = IBI.OperandList;
+                   nullptr, IBI.getNumOperands()) {
+  setHungOffOperands(allocHungoffUses(IBI.getNumOperands()));
+  Use *OL = getOperandList();
+  const Use *InOL = IBI.getOperandList();
   for (unsigned i = 0, E = IBI.getNumOperands(); i != E; ++i)
     OL[i] = InOL[i];
   SubclassOptionalData = IBI.SubclassOptionalData;
@@ -3584,7 +3588,7 @@ void IndirectBrInst::addDestination(BasicBlock *DestBB) {
   // Initialize some new operands.
   assert(OpNo < ReservedSpace && "Growing didn't work!");
   NumOperands = OpNo+1;
-  OperandList[OpNo] = DestBB;
+  getOperandList()[OpNo] = DestBB;
 }
 
 /// removeDestination - This method removes the specified successor from the
@@ -3593,7 +3597,7 @@ void IndirectBrInst::removeDestination(unsigned idx) {
   assert(idx < getNumOperands()-1 && "Successor index out of range!");
   
   unsigned NumOps = getNumOperands();
-  Use *OL = OperandList;
+  Use *OL = getOperandList();
 
   // Replace this value with the last one.
   OL[idx+1] = OL[NumOps-1];
@@ -249,3 +249,14 @@ void LLVMContext::getMDKindNames(SmallVectorImpl<StringRef> &Names) const {
        E = pImpl->CustomMDKindNames.end(); I != E; ++I)
     Names[I->second] = I->first();
 }
+
+bool LLVMContext::isODRUniquingDebugTypes() const {
+  return !!pImpl->DITypeMap;
+}
+
+void LLVMContext::enableDebugTypeODRUniquing() {
+  if (!pImpl->DITypeMap)
+    pImpl->DITypeMap.reset(new DenseMap<const MDString *, DICompositeType *>);
+}
+
+void LLVMContext::disableDebugTypeODRUniquing() { pImpl->DITypeMap.reset(); }
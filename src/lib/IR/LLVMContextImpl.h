@@ -960,6 +960,10 @@ public:
   // on Context destruction.
   SmallPtrSet<MDNode *, 1> DistinctMDNodes;
 
+  /// \brief Composite types by identifier, when uniquing them by the one
+  /// definition rule.  Only allocated when enabled.
+  std::unique_ptr<DenseMap<const MDString *, DICompositeType *>> DITypeMap;
+
   DenseMap<Type*, ConstantAggregateZero*> CAZConstants;
 
   typedef ConstantUniqueMap<ConstantArray> ArrayConstantsTy;
@@ -21,8 +21,12 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/TimeValue.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
@@ -455,15 +459,28 @@ namespace {
 
 static ManagedStatic<sys::SmartMutex<true> > TimingInfoMutex;
 
+/// PassUsage - What the runs of a pass, on one function or on any unit of IR,
+/// added up to.  Only collected for -time-passes-json.
+struct PassUsage {
+  unsigned Runs = 0;
+  TimeRecord Time;
+  uint64_t PeakMemoryDelta = 0;
+  int64_t InstructionDelta = 0;
+};
+
 class TimingInfo {
   DenseMap<Pass*, Timer*> TimingData;
   TimerGroup TG;
+  // Keyed by pass name and function name, which is empty for the passes that
+  // are not reported per function.
+  std::map<std::pair<std::string, std::string>, PassUsage> UsageData;
 public:
   // Use 'create' member to get this.
   TimingInfo() : TG("... Pass execution timing report ...") {}
 
   // TimingDtor - Print out information about timing information
   ~TimingInfo() {
+    writeJSON();
     // Delete all of the timers, which accumulate their info into the
     // TimerGroup.
     for (DenseMap<Pass*, Timer*>::iterator I = TimingData.begin(),
@@ -488,12 +505,115 @@ public:
       T = new Timer(P->getPassName(), TG);
     return T;
   }
+
+  /// addUsage - Account one run of \p P on \p F, or on a module if \p F is
+  /// null.
+  void addUsage(Pass *P, const Function *F, const PassUsage &Run);
+
+  /// writeJSON - Write the usage collected so far for -time-passes-json and
+  /// clear it.
+  void writeJSON();
 };
 
 } // End of anon namespace
 
 static TimingInfo *TheTimeInfo;
 
+static cl::opt<std::string>
+TimePassesJSON("time-passes-json", cl::value_desc("filename"),
+               cl::desc("With -time-passes, also append the timings of each "
+                        "pass, and how much it changed the peak memory use "
+                        "and the instruction count, to <filename> as JSON"));
+
+static cl::opt<bool>
+TimePassesPerFunction("time-passes-per-function",
+                      cl::desc("Report the -time-passes-json timings of "
+                               "function and basic block passes per "
+                               "function"));
+
+static uint64_t countInstructions(const Function &F) {
+  uint64_t Count = 0;
+  for (const BasicBlock &BB : F)
+    Count += BB.size();
+  return Count;
+}
+
+PassExecutionTimer::PassExecutionTimer(Pass *P, const Module &M)
+    : Region(getPassTimer(P)), P(P), M(&M) {
+  start();
+}
+
+PassExecutionTimer::PassExecutionTimer(Pass *P, const Function &F)
+    : Region(getPassTimer(P)), P(P), Functions(1, &F) {
+  start();
+}
+
+PassExecutionTimer::PassExecutionTimer(Pass *P, const BasicBlock &BB)
+    : Region(getPassTimer(P)), P(P), BB(&BB) {
+  start();
+}
+
+PassExecutionTimer::PassExecutionTimer(Pass *P,
+                                       ArrayRef<const Function *> Functions)
+    : Region(getPassTimer(P)), P(P),
+      Functions(Functions.begin(), Functions.end()) {
+  start();
+}
+
+uint64_t PassExecutionTimer::countInstructions() const {
+  if (BB)
+    return BB->size();
+  uint64_t Count = 0;
+  if (M)
+    for (const Function &F : *M)
+      Count += ::countInstructions(F);
+  for (const Function *F : Functions)
+    Count += ::countInstructions(*F);
+  return Count;
+}
+
+void PassExecutionTimer::start() {
+  Traced = isTimeTraceProfilerEnabled() && !P->getAsPMDataManager();
+  if (Traced) {
+    std::string Detail;
+    if (M)
+      Detail = M->getModuleIdentifier();
+    else if (BB)
+      Detail = BB->getParent()->getName();
+    else if (!Functions.empty())
+      Detail = Functions[0]->getName();
+    timeTraceProfilerBegin(P->getPassName(), Detail);
+  }
+
+  CollectUsage =
+      TheTimeInfo && !TimePassesJSON.empty() && !P->getAsPMDataManager();
+  if (!CollectUsage)
+    return;
+  StartInstructions = countInstructions();
+  StartPeakMemory = sys::Process::GetPeakMemoryUsage();
+  StartTime = TimeRecord::getCurrentTime(true);
+}
+
+PassExecutionTimer::~PassExecutionTimer() {
+  if (Traced)
+    timeTraceProfilerEnd();
+  if (!CollectUsage)
+    return;
+  PassUsage Run;
+  Run.Time = TimeRecord::getCurrentTime(false);
+  Run.Time -= StartTime;
+  Run.PeakMemoryDelta = sys::Process::GetPeakMemoryUsage() - StartPeakMemory;
+  Run.InstructionDelta = int64_t(countInstructions()) - StartInstructions;
+  Run.Runs = 1;
+
+  const Function *F = nullptr;
+  if (BB)
+    F = BB->getParent();
+  else if (Functions.size() == 1)
+    F = Functions[0];
+  TheTimeInfo->addUsage(P, F, Run);
+}
+
 //===----------------------------------------------------------------------===//
 // PMTopLevelManager implementation
 
@@ -1312,7 +1432,7 @@ bool BBPassManager::runOnFunction(Function &F) {
       {
         // If the pass crashes, remember this.
         PassManagerPrettyStackEntry X(BP, *I);
-        TimeRegion PassTimer(getPassTimer(BP));
+        PassExecutionTimer PassTimer(BP, *I);
 
         LocalChanged |= BP->runOnBasicBlock(*I);
       }
@@ -1533,7 +1653,7 @@ bool FPPassManager::runOnFunction(Function &F) {
 
     {
       PassManagerPrettyStackEntry X(FP, F);
-      TimeRegion PassTimer(getPassTimer(FP));
+      PassExecutionTimer PassTimer(FP, F);
 
       LocalChanged |= FP->runOnFunction(F);
     }
@@ -1611,7 +1731,7 @@ MPPassManager::runOnModule(Module &M) {
 
     {
       PassManagerPrettyStackEntry X(MP, M);
-      TimeRegion PassTimer(getPassTimer(MP));
+      PassExecutionTimer PassTimer(MP, M);
 
       LocalChanged |= MP->runOnModule(M);
     }
@@ -1784,6 +1904,80 @@ Timer *llvm::getPassTimer(Pass *P) {
   return nullptr;
 }
 
+void TimingInfo::addUsage(Pass *P, const Function *F, const PassUsage &Run) {
+  std::string FunctionName;
+  if (F && TimePassesPerFunction)
+    FunctionName = F->getName();
+
+  sys::SmartScopedLock<true> Lock(*TimingInfoMutex);
+  PassUsage &Usage = UsageData[std::make_pair(P->getPassName(), FunctionName)];
+  Usage.Runs += Run.Runs;
+  Usage.Time += Run.Time;
+  Usage.PeakMemoryDelta += Run.PeakMemoryDelta;
+  Usage.InstructionDelta += Run.InstructionDelta;
+}
+
+static void writeJSONString(raw_ostream &OS, StringRef Str) {
+  OS << '"';
+  for (unsigned char C : Str) {
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << format("\\u%04x", C);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+void TimingInfo::writeJSON() {
+  sys::SmartScopedLock<true> Lock(*TimingInfoMutex);
+  if (TimePassesJSON.empty() || UsageData.empty())
+    return;
+
+  std::error_code EC;
+  raw_fd_ostream OS(TimePassesJSON, EC, sys::fs::F_Append | sys::fs::F_Text);
+  if (EC) {
+    errs() << "Error opening time-passes-json file '" << TimePassesJSON
+           << "': " << EC.message() << '\n';
+    return;
+  }
+
+  // The passes are listed from the slowest to the fastest.
+  typedef std::pair<const std::pair<std::string, std::string>, PassUsage> Entry;
+  std::vector<const Entry *> Entries;
+  for (const Entry &E : UsageData)
+    Entries.push_back(&E);
+  std::stable_sort(Entries.begin(), Entries.end(),
+                   [](const Entry *A, const Entry *B) {
+    return A->second.Time.getWallTime() > B->second.Time.getWallTime();
+  });
+
+  OS << "{\"passes\":[";
+  for (unsigned I = 0, E = Entries.size(); I != E; ++I) {
+    const PassUsage &Usage = Entries[I]->second;
+    OS << (I ? ",\n" : "\n") << "{\"name\":";
+    writeJSONString(OS, Entries[I]->first.first);
+    if (!Entries[I]->first.second.empty()) {
+      OS << ",\"function\":";
+      writeJSONString(OS, Entries[I]->first.second);
+    }
+    OS << ",\"runs\":" << Usage.Runs
+       << format(",\"wall\":%.6f,\"user\":%.6f,\"system\":%.6f",
+                 Usage.Time.getWallTime(), Usage.Time.getUserTime(),
+                 Usage.Time.getSystemTime())
+       << ",\"peak_memory_delta\":" << Usage.PeakMemoryDelta
+       << ",\"instruction_delta\":" << Usage.InstructionDelta << '}';
+  }
+  OS << "\n]}\n";
+  UsageData.clear();
+}
+
+void llvm::writePassTimingsJSON() {
+  if (TheTimeInfo)
+    TheTimeInfo->writeJSON();
+}
+
 //===----------------------------------------------------------------------===//
 // PMStack implementation
 //
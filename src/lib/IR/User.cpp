@@ -58,21 +58,33 @@ void *User::operator new(size_t s, unsigned Us) {
   Use *Start = static_cast<Use*>(Storage);
   Use *End = Start + Us;
   User *Obj = reinterpret_cast<User*>(End);
-  Obj->OperandList = Start;
   Obj->NumOperands = Us;
   Use::initTags(Start, End);
   return Obj;
 }
 
+void *User::operator new(size_t s) {
+  // Allocate space for a single Use*, which setHungOffOperands points to the
+  // hung-off operands.
+  void *Storage = ::operator new(s + sizeof(Use *));
+  Use **HungOffOperandList = static_cast<Use **>(Storage);
+  *HungOffOperandList = nullptr;
+  return HungOffOperandList + 1;
+}
+
 //===----------------------------------------------------------------------===//
 //                         User operator delete Implementation
 //===----------------------------------------------------------------------===//
 
 void User::operator delete(void *Usr) {
   User *Start = static_cast<User*>(Usr);
+  // If there were hung-off uses, they will have been freed already, so here
+  // we just free the User itself along with its Use*.
+  if (Start->HasHungOffUses) {
+    ::operator delete(static_cast<Use **>(Usr) - 1);
+    return;
+  }
   Use *Storage = static_cast<Use*>(Usr) - Start->NumOperands;
-  // If there were hung-off uses, they will have been freed already and
-  // NumOperands reset to 0, so here we just free the User itself.
   ::operator delete(Storage);
 }
 
@@ -73,12 +73,15 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstdarg>
 using namespace llvm;
 
-static cl::opt<bool> VerifyDebugInfo("verify-debug-info", cl::init(true));
+static cl::opt<bool>
+    VerifyDebugInfo("verify-debug-info", cl::init(true),
+                    cl::desc("Verify debug info metadata and intrinsics"));
 
 namespace {
 struct VerifierSupport {
@@ -267,11 +270,23 @@ public:
     visitModuleIdents(M);
 
     // Verify type referneces last.
-    verifyTypeRefs();
+    if (VerifyDebugInfo)
+      verifyTypeRefs();
 
     return !Broken;
   }
 
+  /// \brief Take over the metadata visited by \c Other while it verified
+  /// functions, as if they had been verified by this Verifier.
+  ///
+  /// This lets the module-level checks skip the nodes already checked and
+  /// report the type references they left unresolved.
+  void takeFunctionState(const Verifier &Other) {
+    MDNodes.insert(Other.MDNodes.begin(), Other.MDNodes.end());
+    UnresolvedTypeRefs.insert(Other.UnresolvedTypeRefs.begin(),
+                              Other.UnresolvedTypeRefs.end());
+  }
+
 private:
   // Verification methods...
   void visitGlobalValue(const GlobalValue &GV);
@@ -596,7 +611,7 @@ void Verifier::visitNamedMDNode(const NamedMDNode &NMD) {
   for (unsigned i = 0, e = NMD.getNumOperands(); i != e; ++i) {
     MDNode *MD = NMD.getOperand(i);
 
-    if (NMD.getName() == "llvm.dbg.cu") {
+    if (VerifyDebugInfo && NMD.getName() == "llvm.dbg.cu") {
       Assert(MD && isa<DICompileUnit>(MD), "invalid compile unit", &NMD, MD);
     }
 
@@ -613,6 +628,10 @@ void Verifier::visitMDNode(const MDNode &MD) {
   if (!MDNodes.insert(&MD).second)
     return;
 
+  // All the specialized nodes are debug info.
+  if (!VerifyDebugInfo && !isa<MDTuple>(MD))
+    return;
+
   switch (MD.getMetadataID()) {
   default:
     llvm_unreachable("Invalid MDNode subclass");
@@ -2916,14 +2935,34 @@ void Verifier::visitInstruction(Instruction &I) {
            &I);
   }
 
-  if (MDNode *N = I.getDebugLoc().getAsMDNode()) {
-    Assert(isa<DILocation>(N), "invalid !dbg metadata attachment", &I, N);
-    visitMDNode(*N);
-  }
+  if (MDNode *N = I.getDebugLoc().getAsMDNode())
+    if (VerifyDebugInfo) {
+      Assert(isa<DILocation>(N), "invalid !dbg metadata attachment", &I, N);
+      visitMDNode(*N);
+    }
 
   InstsInThisBlock.insert(&I);
 }
 
+/// \brief Whether \c Wide is an integer, or a vector of integers, twice as wide
+/// as \c Narrow.
+///
+/// This compares the types instead of building the expected one, so that
+/// verifying a function never creates types in the context.
+static bool isIntWidthScaled(Type *Narrow, Type *Wide) {
+  if (auto *NarrowVTy = dyn_cast<VectorType>(Narrow)) {
+    auto *WideVTy = dyn_cast<VectorType>(Wide);
+    if (!WideVTy || WideVTy->getNumElements() != NarrowVTy->getNumElements())
+      return false;
+    Narrow = NarrowVTy->getElementType();
+    Wide = WideVTy->getElementType();
+  }
+  auto *NarrowITy = dyn_cast<IntegerType>(Narrow);
+  auto *WideITy = dyn_cast<IntegerType>(Wide);
+  return NarrowITy && WideITy &&
+         WideITy->getBitWidth() == 2 * NarrowITy->getBitWidth();
+}
+
 /// VerifyIntrinsicType - Verify that the specified type (which comes from an
 /// intrinsic argument or return value) matches the type constraints specified
 /// by the .td file (e.g. an "any integer" argument really is an integer).
@@ -2990,42 +3029,26 @@ bool Verifier::VerifyIntrinsicType(Type *Ty,
     }
     llvm_unreachable("all argument kinds not covered");
 
-  case IITDescriptor::ExtendArgument: {
+  case IITDescriptor::ExtendArgument:
     // This may only be used when referring to a previous vector argument.
-    if (D.getArgumentNumber() >= ArgTys.size())
-      return true;
+    return D.getArgumentNumber() >= ArgTys.size() ||
+           !isIntWidthScaled(ArgTys[D.getArgumentNumber()], Ty);
 
-    Type *NewTy = ArgTys[D.getArgumentNumber()];
-    if (VectorType *VTy = dyn_cast<VectorType>(NewTy))
-      NewTy = VectorType::getExtendedElementVectorType(VTy);
-    else if (IntegerType *ITy = dyn_cast<IntegerType>(NewTy))
-      NewTy = IntegerType::get(ITy->getContext(), 2 * ITy->getBitWidth());
-    else
-      return true;
+  case IITDescriptor::TruncArgument:
+    // This may only be used when referring to a previous vector argument.
+    return D.getArgumentNumber() >= ArgTys.size() ||
+           !isIntWidthScaled(Ty, ArgTys[D.getArgumentNumber()]);
 
-    return Ty != NewTy;
-  }
-  case IITDescriptor::TruncArgument: {
+  case IITDescriptor::HalfVecArgument: {
     // This may only be used when referring to a previous vector argument.
     if (D.getArgumentNumber() >= ArgTys.size())
       return true;
-
-    Type *NewTy = ArgTys[D.getArgumentNumber()];
-    if (VectorType *VTy = dyn_cast<VectorType>(NewTy))
-      NewTy = VectorType::getTruncatedElementVectorType(VTy);
-    else if (IntegerType *ITy = dyn_cast<IntegerType>(NewTy))
-      NewTy = IntegerType::get(ITy->getContext(), ITy->getBitWidth() / 2);
-    else
-      return true;
-
-    return Ty != NewTy;
+    auto *ArgVTy = dyn_cast<VectorType>(ArgTys[D.getArgumentNumber()]);
+    auto *VTy = dyn_cast<VectorType>(Ty);
+    return !ArgVTy || !VTy ||
+           VTy->getElementType() != ArgVTy->getElementType() ||
+           2 * VTy->getNumElements() != ArgVTy->getNumElements();
   }
-  case IITDescriptor::HalfVecArgument:
-    // This may only be used when referring to a previous vector argument.
-    return D.getArgumentNumber() >= ArgTys.size() ||
-           !isa<VectorType>(ArgTys[D.getArgumentNumber()]) ||
-           VectorType::getHalfElementsVectorType(
-                         cast<VectorType>(ArgTys[D.getArgumentNumber()])) != Ty;
   case IITDescriptor::SameVecWidthArgument: {
     if (D.getArgumentNumber() >= ArgTys.size())
       return true;
@@ -3338,6 +3361,9 @@ static DISubprogram *getSubprogram(Metadata *LocalScope) {
 
 template <class DbgIntrinsicTy>
 void Verifier::visitDbgIntrinsic(StringRef Kind, DbgIntrinsicTy &DII) {
+  if (!VerifyDebugInfo)
+    return;
+
   auto *MD = cast<MetadataAsValue>(DII.getArgOperand(0))->getMetadata();
   Assert(isa<ValueAsMetadata>(MD) ||
              (isa<MDNode>(MD) && !cast<MDNode>(MD)->getNumOperands()),
@@ -3505,14 +3531,75 @@ bool llvm::verifyFunction(const Function &f, raw_ostream *OS) {
   return !V.verify(F);
 }
 
-bool llvm::verifyModule(const Module &M, raw_ostream *OS) {
+namespace {
+/// \brief The functions of a module verified by one task, along with the
+/// messages printed while doing it.
+struct FunctionRange {
+  std::string Messages;
+  raw_string_ostream OS;
+  Verifier V;
+  bool Broken;
+
+  FunctionRange() : OS(Messages), V(OS), Broken(false) {}
+};
+}
+
+/// \brief Verify the function bodies of \c M on \c NumThreads threads.
+///
+/// The functions are split into contiguous ranges, each verified with a
+/// Verifier of its own.  Their messages are then printed in module order and
+/// their state handed to \c ModuleV for the module-level checks.
+static bool verifyFunctionsInParallel(const Module &M, Verifier &ModuleV,
+                                      raw_ostream *OS, unsigned NumThreads) {
+  std::vector<const Function *> Functions;
+  for (const Function &F : M) {
+    // Fill the intrinsic ID cache of the context now; it would otherwise be
+    // written to by the tasks.
+    (void)F.getIntrinsicID();
+    if (!F.isDeclaration() && !F.isMaterializable())
+      Functions.push_back(&F);
+  }
+
+  // A few ranges per thread even out the differences in function size.
+  size_t NumRanges = std::min<size_t>(Functions.size(), 4 * NumThreads);
+  std::vector<std::unique_ptr<FunctionRange>> Ranges;
+  for (size_t R = 0; R != NumRanges; ++R)
+    Ranges.emplace_back(new FunctionRange());
+  {
+    ThreadPool Pool(NumThreads);
+    for (size_t R = 0; R != NumRanges; ++R)
+      Pool.async([&, R] {
+        FunctionRange &Range = *Ranges[R];
+        size_t Begin = Functions.size() * R / NumRanges;
+        size_t End = Functions.size() * (R + 1) / NumRanges;
+        for (size_t I = Begin; I != End; ++I)
+          Range.Broken |= !Range.V.verify(*Functions[I]);
+      });
+    Pool.wait();
+  }
+
+  bool Broken = false;
+  for (auto &Range : Ranges) {
+    if (OS)
+      *OS << Range->OS.str();
+    ModuleV.takeFunctionState(Range->V);
+    Broken |= Range->Broken;
+  }
+  return Broken;
+}
+
+bool llvm::verifyModule(const Module &M, raw_ostream *OS,
+                        unsigned NumThreads) {
   raw_null_ostream NullStr;
   Verifier V(OS ? *OS : NullStr);
 
   bool Broken = false;
-  for (Module::const_iterator I = M.begin(), E = M.end(); I != E; ++I)
-    if (!I->isDeclaration() && !I->isMaterializable())
-      Broken |= !V.verify(*I);
+  if (NumThreads > 1)
+    Broken = verifyFunctionsInParallel(M, V, OS, NumThreads);
+  else
+    for (Module::const_iterator I = M.begin(), E = M.end(); I != E; ++I)
+      if (!I->isDeclaration() && !I->isMaterializable())
+        Broken |= !V.verify(*I);
 
   // Note that this function's return value is inverted from what you would
   // expect of a function called "verify".
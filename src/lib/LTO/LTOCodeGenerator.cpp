@@ -18,6 +18,7 @@
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/CodeGen/RuntimeLibcalls.h"
 #include "llvm/Config/config.h"
 #include "llvm/IR/Constants.h"
@@ -36,11 +37,15 @@
 #include "llvm/MC/MCContext.h"
 #include "llvm/MC/SubtargetFeature.h"
 #include "llvm/PassManager.h"
+#include "llvm/Support/CachePruning.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FormattedStream.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
@@ -53,6 +58,7 @@
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/ObjCARC.h"
+#include <algorithm>
 #include <system_error>
 using namespace llvm;
 
@@ -73,12 +79,14 @@ const char* LTOCodeGenerator::getVersionString() {
 LTOCodeGenerator::LTOCodeGenerator()
     : Context(&getGlobalContext()),
       IRLinker(new Module("ld-temp.o", *Context)) {
+  Context->enableDebugTypeODRUniquing();
   initializeLTOPasses();
 }
 
 LTOCodeGenerator::LTOCodeGenerator(std::unique_ptr<LLVMContext> Context)
     : OwnedContext(std::move(Context)), Context(OwnedContext.get()),
       IRLinker(new Module("ld-temp.o", *OwnedContext)) {
+  Context->enableDebugTypeODRUniquing();
   initializeLTOPasses();
 }
 
@@ -98,6 +106,9 @@ LTOCodeGenerator::~LTOCodeGenerator() {
   delete TargetMach;
   TargetMach = nullptr;
 
+  // The linker may never call llvm_shutdown().
+  writePassTimingsJSON();
+
   for (std::vector<char *>::iterator I = CodegenOptions.begin(),
                                      E = CodegenOptions.end();
        I != E; ++I)
@@ -138,7 +149,12 @@ bool LTOCodeGenerator::addModule(LTOModule *mod) {
   assert(&mod->getModule().getContext() == Context &&
          "Expected module in same context");
 
-  bool ret = IRLinker.linkInModule(&mod->getModule());
+  // The module is linked once the symbols to preserve are known.
+  bool ret = false;
+  if (ShouldLinkLazily)
+    LazyModules.push_back(mod);
+  else
+    ret = IRLinker.linkInModule(&mod->getModule());
 
   const std::vector<const char*> &undefs = mod->getAsmUndefinedRefs();
   for (int i = 0, e = undefs.size(); i != e; ++i)
@@ -199,6 +215,7 @@ bool LTOCodeGenerator::writeMergedModules(const char *path,
 
   // mark which symbols can not be internalized
   applyScopeRestrictions();
+  runPendingFunctionPasses();
 
   // create output file
   std::error_code EC;
@@ -239,7 +256,8 @@ bool LTOCodeGenerator::compileOptimizedToFile(const char **name,
   // generate object file
   tool_output_file objFile(Filename.c_str(), FD);
 
-  bool genResult = compileOptimized(objFile.os(), errMsg);
+  raw_ostream *Out = &objFile.os();
+  bool genResult = compileOptimized(Out, errMsg);
   objFile.os().close();
   if (objFile.os().has_error()) {
     objFile.os().clear_error();
@@ -258,15 +276,74 @@ bool LTOCodeGenerator::compileOptimizedToFile(const char **name,
   return true;
 }
 
+bool LTOCodeGenerator::compileOptimizedToFiles(ArrayRef<const char *> &names,
+                                               std::string &errMsg) {
+  if (Parallelism == 1) {
+    const char *name;
+    if (!compileOptimizedToFile(&name, errMsg))
+      return false;
+    NativeObjectNames.assign(1, name);
+    names = NativeObjectNames;
+    return true;
+  }
+
+  // make unique temp .o files to put the generated object files
+  std::vector<std::unique_ptr<tool_output_file>> ObjFiles;
+  std::vector<raw_ostream *> Out;
+  std::vector<std::string> Filenames;
+  for (unsigned I = 0; I != Parallelism; ++I) {
+    SmallString<128> Filename;
+    int FD;
+    std::error_code EC =
+        sys::fs::createTemporaryFile("lto-llvm", "o", FD, Filename);
+    if (EC) {
+      errMsg = EC.message();
+      return false;
+    }
+    ObjFiles.push_back(make_unique<tool_output_file>(Filename.c_str(), FD));
+    Out.push_back(&ObjFiles.back()->os());
+    Filenames.push_back(Filename.str());
+  }
+
+  // generate the object files; the files that aren't kept are removed
+  bool genResult = compileOptimized(Out, errMsg);
+  for (unsigned I = 0; I != Parallelism; ++I) {
+    raw_fd_ostream &OS = ObjFiles[I]->os();
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      if (genResult)
+        errMsg = "could not write object file: " + Filenames[I];
+      genResult = false;
+    }
+  }
+  if (!genResult)
+    return false;
+
+  NativeObjectPaths = std::move(Filenames);
+  NativeObjectNames.clear();
+  for (unsigned I = 0; I != Parallelism; ++I) {
+    ObjFiles[I]->keep();
+    NativeObjectNames.push_back(NativeObjectPaths[I].c_str());
+  }
+  names = NativeObjectNames;
+  return true;
+}
+
 const void *LTOCodeGenerator::compileOptimized(size_t *length,
                                                std::string &errMsg) {
   const char *name;
   if (!compileOptimizedToFile(&name, errMsg))
     return nullptr;
+  return readNativeObjectFile(length, errMsg);
+}
 
+/// Bring the object file at NativeObjectPath to memory, and remove the file.
+const void *LTOCodeGenerator::readNativeObjectFile(size_t *length,
+                                                   std::string &errMsg) {
   // read .o file into memory buffer
   ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
-      MemoryBuffer::getFile(name, -1, false);
+      MemoryBuffer::getFile(NativeObjectPath, -1, false);
   if (std::error_code EC = BufferOrErr.getError()) {
     errMsg = EC.message();
     sys::fs::remove(NativeObjectPath);
@@ -284,6 +361,191 @@ const void *LTOCodeGenerator::compileOptimized(size_t *length,
   return NativeObjectFile->getBufferStart();
 }
 
+namespace {
+/// A stream that only hashes what is written to it.
+class MD5OStream : public raw_ostream {
+  MD5 &Hasher;
+  uint64_t Pos = 0;
+
+  void write_impl(const char *Ptr, size_t Size) override {
+    Hasher.update(ArrayRef<uint8_t>((const uint8_t *)Ptr, Size));
+    Pos += Size;
+  }
+  uint64_t current_pos() const override { return Pos; }
+
+public:
+  explicit MD5OStream(MD5 &Hasher) : Hasher(Hasher) {}
+  ~MD5OStream() override { flush(); }
+};
+}
+
+/// Print the target options that the generated code depends on.
+static void printTargetOptions(raw_ostream &OS, const TargetOptions &Options) {
+  OS << Options.NoFramePointerElim << Options.LessPreciseFPMADOption
+     << Options.UnsafeFPMath << Options.NoInfsFPMath << Options.NoNaNsFPMath
+     << Options.HonorSignDependentRoundingFPMathOption << Options.UseSoftFloat
+     << Options.NoZerosInBSS << Options.GuaranteedTailCallOpt
+     << Options.DisableTailCalls << Options.EnableFastISel
+     << Options.PositionIndependentExecutable << Options.UseInitArray
+     << Options.DisableIntegratedAS << Options.CompressDebugSections
+     << Options.FunctionSections << Options.DataSections
+     << Options.TrapUnreachable << ' ' << Options.StackAlignmentOverride << ' '
+     << unsigned(Options.FloatABIType) << ' '
+     << unsigned(Options.AllowFPOpFusion) << ' ' << unsigned(Options.JTType)
+     << ' ' << Options.FCFI << ' ' << unsigned(Options.ThreadModel) << ' '
+     << unsigned(Options.CFIType) << ' ' << Options.CFIEnforcing << ' '
+     << Options.TrapFuncName << '\0' << Options.CFIFuncName << '\0';
+
+  const MCTargetOptions &MCOptions = Options.MCOptions;
+  OS << MCOptions.SanitizeAddress << MCOptions.MCRelaxAll
+     << MCOptions.MCNoExecStack << MCOptions.MCFatalWarnings
+     << MCOptions.MCSaveTempLabels << MCOptions.MCUseDwarfDirectory
+     << MCOptions.ShowMCEncoding << MCOptions.ShowMCInst
+     << MCOptions.AsmVerbose << ' ' << MCOptions.DwarfVersion << '\0';
+}
+
+/// Print the keys of \p Set in a deterministic order.
+static void printSortedKeys(raw_ostream &OS, const StringMap<uint8_t> &Set) {
+  std::vector<StringRef> Keys;
+  for (const auto &Entry : Set)
+    Keys.push_back(Entry.getKey());
+  std::sort(Keys.begin(), Keys.end());
+  for (StringRef Key : Keys)
+    OS << Key << '\0';
+  OS << '\0';
+}
+
+/// Compute the key of the \p Count objects that optimizing and compiling the
+/// merged module would produce, or leave \p Key empty when there's no cache.
+bool LTOCodeGenerator::computeCacheKey(unsigned Count, bool disableOpt,
+                                       bool disableInline,
+                                       bool disableGVNLoadPRE,
+                                       bool disableVectorization,
+                                       std::string &Key, std::string &errMsg) {
+  Key.clear();
+  if (CacheDir.empty())
+    return true;
+  if (!determineTarget(errMsg))
+    return false;
+
+  // The module is hashed through its bitcode, so it must be complete.
+  Module *MergedModule = IRLinker.getModule();
+  if (std::error_code EC = MergedModule->materializeAll()) {
+    errMsg = EC.message();
+    return false;
+  }
+
+  MD5 Hasher;
+  {
+    // Strings are null terminated, so that two of them never hash the same
+    // as their concatenation.
+    std::string Config;
+    raw_string_ostream OS(Config);
+    OS << getVersionString() << '\0' << TripleStr << '\0' << MCpu << '\0'
+       << FeatureStr << '\0' << RelocModel << ' ' << CodeModel << ' '
+       << EmitDwarfDebugInfo << ShouldInternalize << disableOpt
+       << disableInline << disableGVNLoadPRE << disableVectorization << ' '
+       << Count << ' ' << (Count > 1 && ShouldOptimizePartitions) << '\0';
+    printTargetOptions(OS, Options);
+    for (const char *Option : CodegenOptions)
+      OS << Option << '\0';
+    OS << '\0';
+    printSortedKeys(OS, MustPreserveSymbols);
+    printSortedKeys(OS, AsmUndefinedRefs);
+    Hasher.update(OS.str());
+  }
+  {
+    MD5OStream OS(Hasher);
+    WriteBitcodeToFile(MergedModule, OS);
+  }
+
+  MD5::MD5Result Result;
+  Hasher.final(Result);
+  SmallString<32> Hash;
+  MD5::stringifyResult(Result, Hash);
+  Key = Hash.str();
+  return true;
+}
+
+std::string LTOCodeGenerator::getCacheEntryPath(StringRef Key,
+                                                unsigned Index) {
+  SmallString<128> EntryPath(CacheDir);
+  sys::path::append(EntryPath, "llvmcache-" + Key + "-" + Twine(Index) + ".o");
+  return EntryPath.str();
+}
+
+/// Copy the \p Count objects cached under \p Key to temporary files, whose
+/// paths are returned via \p names. Return false when they're not all cached.
+bool LTOCodeGenerator::getCachedObjects(StringRef Key, unsigned Count,
+                                        ArrayRef<const char *> &names) {
+  // The linker removes the files it's given, so give it copies.
+  std::vector<std::string> Filenames;
+  for (unsigned I = 0; I != Count; ++I) {
+    std::string EntryPath = getCacheEntryPath(Key, I);
+    SmallString<128> Filename;
+    std::error_code EC =
+        sys::fs::createTemporaryFile("lto-llvm", "o", Filename);
+    if (!EC) {
+      Filenames.push_back(Filename.str());
+      EC = sys::fs::copy_file(EntryPath, Twine(Filename));
+    }
+    if (EC) {
+      for (const std::string &Path : Filenames)
+        sys::fs::remove(Path);
+      return false;
+    }
+  }
+
+  // The entries are pruned by least recent use, which their modification
+  // time records.
+  for (unsigned I = 0; I != Count; ++I) {
+    int FD;
+    if (sys::fs::openFileForRead(getCacheEntryPath(Key, I), FD))
+      continue;
+    sys::fs::setLastModificationAndAccessTime(FD, sys::TimeValue::now());
+    sys::Process::SafelyCloseFileDescriptor(FD);
+  }
+
+  if (Count == 1) {
+    NativeObjectPath = Filenames[0];
+    NativeObjectNames.assign(1, NativeObjectPath.c_str());
+  } else {
+    NativeObjectPaths = std::move(Filenames);
+    NativeObjectNames.clear();
+    for (const std::string &Filename : NativeObjectPaths)
+      NativeObjectNames.push_back(Filename.c_str());
+  }
+  names = NativeObjectNames;
+  return true;
+}
+
+/// Add the objects \p names to the cache under \p Key, then prune it. Failing
+/// to update the cache isn't an error: the objects are generated again by the
+/// next link.
+void LTOCodeGenerator::addCachedObjects(StringRef Key,
+                                        ArrayRef<const char *> names) {
+  if (sys::fs::create_directories(CacheDir))
+    return;
+  for (unsigned I = 0, E = names.size(); I != E; ++I) {
+    // Write each entry to a temporary file of the cache first and rename it,
+    // so that concurrent links never see partial entries.
+    std::string EntryPath = getCacheEntryPath(Key, I);
+    SmallString<128> TempPath;
+    if (sys::fs::createUniqueFile(EntryPath + ".tmp-%%%%%%", TempPath))
+      return;
+    if (sys::fs::copy_file(names[I], Twine(TempPath)) ||
+        sys::fs::rename(Twine(TempPath), EntryPath)) {
+      sys::fs::remove(Twine(TempPath));
+      return;
+    }
+  }
+
+  CachePruning(CacheDir)
+      .setPruningInterval(CachePruningInterval)
+      .setEntryExpiration(CacheEntryExpiration)
+      .setMaxSize(MaxCacheSize)
+      .prune();
+}
 
 bool LTOCodeGenerator::compile_to_file(const char **name,
                                        bool disableOpt,
@@ -291,11 +553,49 @@ bool LTOCodeGenerator::compile_to_file(const char **name,
                                        bool disableGVNLoadPRE,
                                        bool disableVectorization,
                                        std::string &errMsg) {
+  std::string Key;
+  if (!computeCacheKey(1, disableOpt, disableInline, disableGVNLoadPRE,
+                       disableVectorization, Key, errMsg))
+    return false;
+  ArrayRef<const char *> names;
+  if (!Key.empty() && getCachedObjects(Key, 1, names)) {
+    *name = names[0];
+    return true;
+  }
+
+  if (!optimize(disableOpt, disableInline, disableGVNLoadPRE,
+                disableVectorization, errMsg))
+    return false;
+
+  if (!compileOptimizedToFile(name, errMsg))
+    return false;
+  if (!Key.empty())
+    addCachedObjects(Key, *name);
+  return true;
+}
+
+bool LTOCodeGenerator::compile_to_files(ArrayRef<const char *> &names,
+                                        bool disableOpt,
+                                        bool disableInline,
+                                        bool disableGVNLoadPRE,
+                                        bool disableVectorization,
+                                        std::string &errMsg) {
+  std::string Key;
+  if (!computeCacheKey(Parallelism, disableOpt, disableInline,
+                       disableGVNLoadPRE, disableVectorization, Key, errMsg))
+    return false;
+  if (!Key.empty() && getCachedObjects(Key, Parallelism, names))
+    return true;
+
   if (!optimize(disableOpt, disableInline, disableGVNLoadPRE,
                 disableVectorization, errMsg))
     return false;
 
-  return compileOptimizedToFile(name, errMsg);
+  if (!compileOptimizedToFiles(names, errMsg))
+    return false;
+  if (!Key.empty())
+    addCachedObjects(Key, names);
+  return true;
 }
 
 const void* LTOCodeGenerator::compile(size_t *length,
@@ -304,30 +604,33 @@ const void* LTOCodeGenerator::compile(size_t *length,
                                       bool disableGVNLoadPRE,
                                       bool disableVectorization,
                                       std::string &errMsg) {
-  if (!optimize(disableOpt, disableInline, disableGVNLoadPRE,
-                disableVectorization, errMsg))
+  const char *name;
+  if (!compile_to_file(&name, disableOpt, disableInline, disableGVNLoadPRE,
+                       disableVectorization, errMsg))
     return nullptr;
 
-  return compileOptimized(length, errMsg);
+  return readNativeObjectFile(length, errMsg);
 }
 
 bool LTOCodeGenerator::determineTarget(std::string &errMsg) {
   if (TargetMach)
-    return true;
+    return linkLazyModules(errMsg);
 
-  std::string TripleStr = IRLinker.getModule()->getTargetTriple();
+  TripleStr = IRLinker.getModule()->getTargetTriple();
+  if (TripleStr.empty() && !LazyModules.empty())
+    TripleStr = LazyModules.front()->getModule().getTargetTriple();
   if (TripleStr.empty())
     TripleStr = sys::getDefaultTargetTriple();
   llvm::Triple Triple(TripleStr);
 
   // create target machine from info for merged modules
-  const Target *march = TargetRegistry::lookupTarget(TripleStr, errMsg);
-  if (!march)
+  MArch = TargetRegistry::lookupTarget(TripleStr, errMsg);
+  if (!MArch)
     return false;
 
   // The relocation model is actually a static member of TargetMachine and
   // needs to be set before the TargetMachine is instantiated.
-  Reloc::Model RelocModel = Reloc::Default;
+  RelocModel = Reloc::Default;
   switch (CodeModel) {
   case LTO_CODEGEN_PIC_MODEL_STATIC:
     RelocModel = Reloc::Static;
@@ -347,7 +650,7 @@ bool LTOCodeGenerator::determineTarget(std::string &errMsg) {
   // the default set of features.
   SubtargetFeatures Features(MAttr);
   Features.getDefaultSubtargetFeatures(Triple);
-  std::string FeatureStr = Features.getString();
+  FeatureStr = Features.getString();
   // Set a default CPU for Darwin triples.
   if (MCpu.empty() && Triple.isOSDarwin()) {
     if (Triple.getArch() == llvm::Triple::x86_64)
@@ -358,10 +661,15 @@ bool LTOCodeGenerator::determineTarget(std::string &errMsg) {
       MCpu = "cyclone";
   }
 
-  TargetMach = march->createTargetMachine(TripleStr, MCpu, FeatureStr, Options,
-                                          RelocModel, CodeModel::Default,
-                                          CodeGenOpt::Aggressive);
-  return true;
+  TargetMach = createTargetMachine().release();
+  return linkLazyModules(errMsg);
+}
+
+std::unique_ptr<TargetMachine> LTOCodeGenerator::createTargetMachine() {
+  assert(MArch && "Target not determined");
+  return std::unique_ptr<TargetMachine>(MArch->createTargetMachine(
+      TripleStr, MCpu, FeatureStr, Options, RelocModel, CodeModel::Default,
+      CodeGenOpt::Aggressive));
 }
 
 void LTOCodeGenerator::
@@ -444,6 +752,157 @@ static void accumulateAndSortLibcalls(std::vector<StringRef> &Libcalls,
                  Libcalls.end());
 }
 
+/// Collect the global values that \p V refers to, looking through constants.
+static void findReferencedGlobals(Value *V,
+                                  SmallPtrSetImpl<GlobalValue *> &Globals,
+                                  SmallPtrSetImpl<Value *> &Visited) {
+  if (auto *GV = dyn_cast<GlobalValue>(V)) {
+    Globals.insert(GV);
+    return;
+  }
+  auto *C = dyn_cast<Constant>(V);
+  if (!C || !Visited.insert(C).second)
+    return;
+  for (Value *Op : C->operands())
+    findReferencedGlobals(Op, Globals, Visited);
+}
+
+bool LTOCodeGenerator::linkLazyModules(std::string &errMsg) {
+  if (LazyModules.empty())
+    return true;
+
+  // The definitions of the pending modules, by name, and the members of
+  // their comdats.
+  StringMap<std::vector<GlobalValue *>> Definitions;
+  DenseMap<const Comdat *, std::vector<GlobalValue *>> ComdatMembers;
+
+  Mangler Mangler(TargetMach->getDataLayout());
+  std::vector<StringRef> Libcalls;
+  TargetLibraryInfoImpl TLII(Triple(TargetMach->getTargetTriple()));
+  TargetLibraryInfo TLI(TLII);
+
+  // Start from the symbols that applyScopeRestrictions() keeps external, or
+  // from every symbol that must be kept when not internalizing.
+  std::vector<GlobalValue *> Worklist;
+  auto isRoot = [&](GlobalValue &GV) {
+    if (GV.hasAppendingLinkage())
+      return true;
+    if (!ShouldInternalize)
+      return !GV.isDiscardableIfUnused();
+    if (GV.hasPrivateLinkage())
+      return false;
+    SmallString<64> Buffer;
+    TargetMach->getNameWithPrefix(Buffer, &GV, Mangler);
+    return MustPreserveSymbols.count(Buffer) ||
+           AsmUndefinedRefs.count(Buffer) ||
+           (isa<Function>(GV) &&
+            std::binary_search(Libcalls.begin(), Libcalls.end(),
+                               GV.getName()));
+  };
+  auto addDefinition = [&](GlobalValue &GV) {
+    if (GV.isDeclaration())
+      return;
+    if (!GV.hasLocalLinkage())
+      Definitions[GV.getName()].push_back(&GV);
+    if (const Comdat *C = GV.getComdat())
+      ComdatMembers[C].push_back(&GV);
+    if (isRoot(GV))
+      Worklist.push_back(&GV);
+  };
+  for (LTOModule *Mod : LazyModules) {
+    Module &M = Mod->getModule();
+    if (std::error_code EC = M.materializeMetadata()) {
+      errMsg = EC.message();
+      return false;
+    }
+    accumulateAndSortLibcalls(Libcalls, TLI, M, *TargetMach);
+  }
+  for (LTOModule *Mod : LazyModules) {
+    Module &M = Mod->getModule();
+    for (Function &F : M)
+      addDefinition(F);
+    for (GlobalVariable &GV : M.globals())
+      addDefinition(GV);
+    for (GlobalAlias &GA : M.aliases())
+      addDefinition(GA);
+  }
+
+  // What the merged module already refers to is needed too.
+  auto addReference = [&](const GlobalValue &GV) {
+    if (GV.hasLocalLinkage())
+      return;
+    auto I = Definitions.find(GV.getName());
+    if (I != Definitions.end())
+      Worklist.insert(Worklist.end(), I->second.begin(), I->second.end());
+  };
+  Module *MergedModule = IRLinker.getModule();
+  for (const GlobalValue &GV : *MergedModule)
+    if (GV.isDeclaration())
+      addReference(GV);
+  for (const GlobalValue &GV : MergedModule->globals())
+    if (GV.isDeclaration())
+      addReference(GV);
+
+  // Materialize and scan the needed definitions, to find what they refer to
+  // in their module and, by name, in the other modules.
+  SmallPtrSet<const GlobalValue *, 64> Needed;
+  SmallPtrSet<GlobalValue *, 16> Referenced;
+  SmallPtrSet<Value *, 64> Visited;
+  while (!Worklist.empty()) {
+    GlobalValue *GV = Worklist.back();
+    Worklist.pop_back();
+    if (!Needed.insert(GV).second)
+      continue;
+
+    if (const Comdat *C = GV->getComdat()) {
+      const std::vector<GlobalValue *> &Members = ComdatMembers[C];
+      Worklist.insert(Worklist.end(), Members.begin(), Members.end());
+    }
+
+    Referenced.clear();
+    if (auto *F = dyn_cast<Function>(GV)) {
+      if (std::error_code EC = F->materialize()) {
+        errMsg = EC.message();
+        return false;
+      }
+      for (BasicBlock &BB : *F)
+        for (Instruction &I : BB)
+          for (Value *Op : I.operands())
+            findReferencedGlobals(Op, Referenced, Visited);
+      if (F->hasPrefixData())
+        findReferencedGlobals(F->getPrefixData(), Referenced, Visited);
+      if (F->hasPrologueData())
+        findReferencedGlobals(F->getPrologueData(), Referenced, Visited);
+    } else if (auto *Var = dyn_cast<GlobalVariable>(GV)) {
+      if (Var->hasInitializer())
+        findReferencedGlobals(Var->getInitializer(), Referenced, Visited);
+    } else {
+      findReferencedGlobals(cast<GlobalAlias>(GV)->getAliasee(), Referenced,
+                            Visited);
+    }
+
+    for (GlobalValue *Ref : Referenced) {
+      if (!Ref->isDeclaration())
+        Worklist.push_back(Ref);
+      addReference(*Ref);
+    }
+  }
+
+  // Link the needed definitions. The others are only linked if they turn out
+  // to be referenced after all, such as from metadata.
+  std::vector<LTOModule *> Modules;
+  std::swap(Modules, LazyModules);
+  for (LTOModule *Mod : Modules)
+    if (IRLinker.linkInModule(&Mod->getModule(), /*OverrideSymbols=*/false,
+                              [&](const GlobalValue &GV) {
+                                return Needed.count(&GV) != 0;
+                              })) {
+      errMsg = "failed to link " + Mod->getModule().getModuleIdentifier();
+      return false;
+    }
+  return true;
+}
+
 void LTOCodeGenerator::applyScopeRestrictions() {
   if (ScopeRestrictionsDone || !ShouldInternalize)
     return;
@@ -541,20 +1000,53 @@ bool LTOCodeGenerator::optimize(bool DisableOpt,
   PMB.VerifyInput = true;
   PMB.VerifyOutput = true;
 
-  PMB.populateLTOPassManager(passes);
+  // Leave the function passes to the code generation threads when they can
+  // run on the partitions.
+  bool DeferFunctionPasses =
+      ShouldOptimizePartitions && Parallelism > 1 && !DisableOpt;
+  if (DeferFunctionPasses)
+    PMB.populateLTOIPOPassManager(passes);
+  else
+    PMB.populateLTOPassManager(passes);
 
   // Run our queue of passes all at once now, efficiently.
   passes.run(*mergedModule);
 
+  FunctionPassesPending = DeferFunctionPasses;
+  PendingDisableGVNLoadPRE = DisableGVNLoadPRE;
+  PendingDisableVectorization = DisableVectorization;
   return true;
 }
 
-bool LTOCodeGenerator::compileOptimized(raw_ostream &out, std::string &errMsg) {
-  if (!this->determineTarget(errMsg))
-    return false;
+/// Run the function passes of the LTO pipeline on \p M, tuned for \p TM.
+static void optimizeFunctions(Module &M, TargetMachine &TM,
+                              bool DisableGVNLoadPRE,
+                              bool DisableVectorization) {
+  PassManager passes;
+  passes.add(createTargetTransformInfoWrapperPass(TM.getTargetIRAnalysis()));
 
-  Module *mergedModule = IRLinker.getModule();
+  PassManagerBuilder PMB;
+  PMB.DisableGVNLoadPRE = DisableGVNLoadPRE;
+  PMB.LoopVectorize = !DisableVectorization;
+  PMB.SLPVectorize = !DisableVectorization;
+  PMB.LibraryInfo = new TargetLibraryInfoImpl(Triple(TM.getTargetTriple()));
+  PMB.VerifyOutput = true;
+  PMB.populateLTOFunctionPassManager(passes);
+
+  passes.run(M);
+}
 
+void LTOCodeGenerator::runPendingFunctionPasses() {
+  if (!FunctionPassesPending)
+    return;
+  optimizeFunctions(*IRLinker.getModule(), *TargetMach,
+                    PendingDisableGVNLoadPRE, PendingDisableVectorization);
+  FunctionPassesPending = false;
+}
+
+/// Generate an object file for \p M with \p TM into \p out.
+static bool codegenModule(Module &M, TargetMachine &TM, raw_ostream &out,
+                          std::string &errMsg) {
   PassManager codeGenPasses;
 
   formatted_raw_ostream Out(out);
@@ -563,18 +1055,48 @@ bool LTOCodeGenerator::compileOptimized(raw_ostream &out, std::string &errMsg) {
   // the ObjCARCContractPass must be run, so do it unconditionally here.
   codeGenPasses.add(createObjCARCContractPass());
 
-  if (TargetMach->addPassesToEmitFile(codeGenPasses, Out,
-                                      TargetMachine::CGFT_ObjectFile)) {
+  if (TM.addPassesToEmitFile(codeGenPasses, Out,
+                             TargetMachine::CGFT_ObjectFile)) {
     errMsg = "target file type not supported";
     return false;
   }
 
   // Run the code generator, and write assembly file
-  codeGenPasses.run(*mergedModule);
+  codeGenPasses.run(M);
 
   return true;
 }
 
+bool LTOCodeGenerator::compileOptimized(ArrayRef<raw_ostream *> Out,
+                                        std::string &errMsg) {
+  if (!this->determineTarget(errMsg))
+    return false;
+
+  Module *mergedModule = IRLinker.getModule();
+
+  if (Out.size() == 1) {
+    runPendingFunctionPasses();
+    return codegenModule(*mergedModule, *TargetMach, *Out[0], errMsg);
+  }
+
+  bool OptimizeFunctions = FunctionPassesPending;
+  FunctionPassesPending = false;
+
+  auto CodeGen = [&](Module &MPart, raw_ostream &OS, std::string &Err) {
+    std::unique_ptr<TargetMachine> TM = createTargetMachine();
+    if (OptimizeFunctions)
+      optimizeFunctions(MPart, *TM, PendingDisableGVNLoadPRE,
+                        PendingDisableVectorization);
+    return codegenModule(MPart, *TM, OS, Err);
+  };
+  auto SetupContext = [&](LLVMContext &Ctx) {
+    if (DiagHandler)
+      Ctx.setDiagnosticHandler(ThreadDiagnosticHandler, this,
+                               /* RespectFilters */ true);
+  };
+  return splitCodeGen(*mergedModule, Out, CodeGen, errMsg, SetupContext);
+}
+
 void LTOCodeGenerator::resetContext() {
   assert(OwnedContext.get() != NULL && "Context must be owned by codegen");
 
@@ -726,6 +1248,13 @@ void LTOCodeGenerator::DiagnosticHandler(const DiagnosticInfo &DI,
   ((LTOCodeGenerator *)Context)->DiagnosticHandler2(DI);
 }
 
+void LTOCodeGenerator::ThreadDiagnosticHandler(const DiagnosticInfo &DI,
+                                               void *Context) {
+  auto *CodeGen = (LTOCodeGenerator *)Context;
+  std::lock_guard<std::mutex> Lock(CodeGen->DiagnosticLock);
+  CodeGen->DiagnosticHandler2(DI);
+}
+
 void LTOCodeGenerator::DiagnosticHandler2(const DiagnosticInfo &DI) {
   // Map the LLVM internal diagnostic severity to the LTO diagnostic severity.
   lto_codegen_diagnostic_severity_t Severity;
@@ -70,7 +70,8 @@ bool LTOModule::isBitcodeFile(const void *Mem, size_t Length) {
 
 bool LTOModule::isBitcodeFile(const char *Path) {
   ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
-      MemoryBuffer::getFile(Path);
+      MemoryBuffer::getFile(Path, /*FileSize=*/-1,
+                            /*RequiresNullTerminator=*/false);
   if (!BufferOrErr)
     return false;
 
@@ -91,16 +92,17 @@ bool LTOModule::isBitcodeForTarget(MemoryBuffer *Buffer,
 }
 
 LTOModule *LTOModule::createFromFile(const char *path, TargetOptions options,
-                                     std::string &errMsg) {
+                                     std::string &errMsg, bool ShouldBeLazy) {
   ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
-      MemoryBuffer::getFile(path);
+      MemoryBuffer::getFile(path, /*FileSize=*/-1,
+                            /*RequiresNullTerminator=*/false);
   if (std::error_code EC = BufferOrErr.getError()) {
     errMsg = EC.message();
     return nullptr;
   }
   std::unique_ptr<MemoryBuffer> Buffer = std::move(BufferOrErr.get());
   return makeLTOModule(Buffer->getMemBufferRef(), options, errMsg,
-                       &getGlobalContext());
+                       &getGlobalContext(), ShouldBeLazy);
 }
 
 LTOModule *LTOModule::createFromOpenFile(int fd, const char *path, size_t size,
@@ -147,9 +149,12 @@ LTOModule *LTOModule::createInContext(const void *mem, size_t length,
   return makeLTOModule(Buffer, options, errMsg, Context);
 }
 
+/// Parse the bitcode in \p Buffer. A module parsed lazily for its symbols only
+/// refers to \p Buffer, while one parsed lazily to be linked (\p IsForLinking)
+/// outlives it: it owns a copy of the bitcode and loads its metadata.
 static Module *parseBitcodeFileImpl(MemoryBufferRef Buffer,
                                     LLVMContext &Context, bool ShouldBeLazy,
-                                    std::string &ErrMsg) {
+                                    bool IsForLinking, std::string &ErrMsg) {
 
   // Find the buffer.
   ErrorOr<MemoryBufferRef> MBOrErr =
@@ -177,10 +182,12 @@ static Module *parseBitcodeFileImpl(MemoryBufferRef Buffer,
 
   // Parse lazily.
   std::unique_ptr<MemoryBuffer> LightweightBuf =
-      MemoryBuffer::getMemBuffer(*MBOrErr, false);
-  ErrorOr<Module *> M = getLazyBitcodeModule(std::move(LightweightBuf), Context,
-                                             DiagnosticHandler,
-                                             true/*ShouldLazyLoadMetadata*/);
+      IsForLinking ? MemoryBuffer::getMemBufferCopy(
+                         MBOrErr->getBuffer(), MBOrErr->getBufferIdentifier())
+                   : MemoryBuffer::getMemBuffer(*MBOrErr, false);
+  ErrorOr<Module *> M = getLazyBitcodeModule(
+      std::move(LightweightBuf), Context, DiagnosticHandler,
+      /*ShouldLazyLoadMetadata=*/!IsForLinking);
   if (!M)
     return nullptr;
   return *M;
@@ -188,7 +195,7 @@ static Module *parseBitcodeFileImpl(MemoryBufferRef Buffer,
 
 LTOModule *LTOModule::makeLTOModule(MemoryBufferRef Buffer,
                                     TargetOptions options, std::string &errMsg,
-                                    LLVMContext *Context) {
+                                    LLVMContext *Context, bool ShouldBeLazy) {
   std::unique_ptr<LLVMContext> OwnedContext;
   if (!Context) {
     OwnedContext = llvm::make_unique<LLVMContext>();
@@ -199,7 +206,8 @@ LTOModule *LTOModule::makeLTOModule(MemoryBufferRef Buffer,
   // extraction, not linking.  Be lazy in that case.
   std::unique_ptr<Module> M(parseBitcodeFileImpl(
       Buffer, *Context,
-      /* ShouldBeLazy */ static_cast<bool>(OwnedContext), errMsg));
+      /* ShouldBeLazy */ ShouldBeLazy || static_cast<bool>(OwnedContext),
+      /* IsForLinking */ !OwnedContext, errMsg));
   if (!M)
     return nullptr;
 
@@ -0,0 +1,194 @@
+//===-ThinLTOCodeGenerator.cpp - LLVM Link Time Optimizer -----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the thin LTO driver: the combined function summary
+// index, and the per-module backends importing from it.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/LTO/ThinLTOCodeGenerator.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/MC/SubtargetFeature.h"
+#include "llvm/PassManager.h"
+#include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/IPO/FunctionImport.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include "llvm/Transforms/ObjCARC.h"
+#include <system_error>
+using namespace llvm;
+
+void ThinLTOCodeGenerator::addModule(StringRef Identifier, StringRef Data) {
+  Modules.push_back(MemoryBufferRef(Data, Identifier));
+}
+
+std::unique_ptr<FunctionInfoIndex>
+ThinLTOCodeGenerator::linkCombinedIndex(std::string &ErrMsg) {
+  auto Index = llvm::make_unique<FunctionInfoIndex>();
+  for (MemoryBufferRef Buffer : Modules) {
+    ErrorOr<std::unique_ptr<FunctionInfoIndex>> ModuleIndex =
+        getFunctionInfoIndex(Buffer);
+    if (ModuleIndex) {
+      Index->mergeFrom(**ModuleIndex);
+      continue;
+    }
+    if (ModuleIndex.getError() != BitcodeError::NoFunctionSummary) {
+      ErrMsg = Buffer.getBufferIdentifier().str() + ": " +
+               ModuleIndex.getError().message();
+      return nullptr;
+    }
+
+    // The module was written without summaries: compute them.
+    LLVMContext Context;
+    ErrorOr<Module *> MOrErr = parseBitcodeFile(Buffer, Context);
+    if (std::error_code EC = MOrErr.getError()) {
+      ErrMsg = Buffer.getBufferIdentifier().str() + ": " + EC.message();
+      return nullptr;
+    }
+    std::unique_ptr<Module> M(MOrErr.get());
+    Index->addModule(*M, Buffer.getBufferIdentifier());
+  }
+  return Index;
+}
+
+/// Generate an object file for \p M with \p TM into \p Out.
+static bool codegenModule(Module &M, TargetMachine &TM, raw_ostream &Out,
+                          std::string &ErrMsg) {
+  PassManager CodeGenPasses;
+  formatted_raw_ostream FOut(Out);
+
+  // If the bitcode files contain ARC code and were compiled with optimization,
+  // the ObjCARCContractPass must be run, so do it unconditionally here.
+  CodeGenPasses.add(createObjCARCContractPass());
+
+  if (TM.addPassesToEmitFile(CodeGenPasses, FOut,
+                             TargetMachine::CGFT_ObjectFile)) {
+    ErrMsg = "target file type not supported";
+    return false;
+  }
+  CodeGenPasses.run(M);
+  return true;
+}
+
+bool ThinLTOCodeGenerator::runBackend(unsigned ModuleIndex,
+                                      std::string &ErrMsg) {
+  MemoryBufferRef Buffer = Modules[ModuleIndex];
+  StringRef Identifier = Buffer.getBufferIdentifier();
+
+  // Every backend has its own context, so that they can run concurrently.
+  LLVMContext Context;
+  ErrorOr<Module *> MOrErr = parseBitcodeFile(Buffer, Context);
+  if (std::error_code EC = MOrErr.getError()) {
+    ErrMsg = Identifier.str() + ": " + EC.message();
+    return false;
+  }
+  std::unique_ptr<Module> M(MOrErr.get());
+
+  // Import the functions the index selects for this module. The source
+  // modules are loaded lazily, so that only the imported bodies are parsed.
+  ImportListTy ImportList =
+      ComputeImportList(*CombinedIndex, Identifier, ImportInstrLimit);
+  FunctionImporter Importer(
+      [&](StringRef Path) -> ErrorOr<std::unique_ptr<Module>> {
+        std::unique_ptr<MemoryBuffer> SrcBuffer;
+        for (MemoryBufferRef Added : Modules)
+          if (Added.getBufferIdentifier() == Path)
+            SrcBuffer = MemoryBuffer::getMemBuffer(Added, false);
+        if (!SrcBuffer) {
+          ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
+              MemoryBuffer::getFile(Path);
+          if (std::error_code EC = BufferOrErr.getError()) {
+            ErrMsg = Path.str() + ": " + EC.message();
+            return EC;
+          }
+          SrcBuffer = std::move(*BufferOrErr);
+        }
+        ErrorOr<Module *> SrcOrErr =
+            getLazyBitcodeModule(std::move(SrcBuffer), Context);
+        if (std::error_code EC = SrcOrErr.getError()) {
+          ErrMsg = Path.str() + ": " + EC.message();
+          return EC;
+        }
+        return std::unique_ptr<Module>(SrcOrErr.get());
+      });
+  if (Importer.importFunctions(*M, ImportList)) {
+    if (ErrMsg.empty())
+      ErrMsg = Identifier.str() + ": failed to import functions";
+    return false;
+  }
+
+  std::string TripleStr = M->getTargetTriple();
+  if (TripleStr.empty())
+    TripleStr = sys::getDefaultTargetTriple();
+  Triple TheTriple(TripleStr);
+  const Target *TheTarget = TargetRegistry::lookupTarget(TripleStr, ErrMsg);
+  if (!TheTarget)
+    return false;
+  SubtargetFeatures Features(MAttr);
+  Features.getDefaultSubtargetFeatures(TheTriple);
+  std::unique_ptr<TargetMachine> TM(TheTarget->createTargetMachine(
+      TripleStr, MCpu, Features.getString(), Options, RelocModel,
+      CodeModel::Default, CodeGenOpt::Aggressive));
+  M->setDataLayout(*TM->getDataLayout());
+
+  // Optimize the module with what was imported, as the compiler would.
+  PassManager Passes;
+  Passes.add(createTargetTransformInfoWrapperPass(TM->getTargetIRAnalysis()));
+  PassManagerBuilder PMB;
+  PMB.OptLevel = 3;
+  PMB.Inliner = createFunctionInliningPass();
+  PMB.LibraryInfo = new TargetLibraryInfoImpl(TheTriple);
+  PMB.populateModulePassManager(Passes);
+  Passes.run(*M);
+
+  SmallString<0> Object;
+  {
+    raw_svector_ostream OS(Object);
+    if (!codegenModule(*M, *TM, OS, ErrMsg))
+      return false;
+  }
+  ProducedBinaries[ModuleIndex] =
+      MemoryBuffer::getMemBufferCopy(Object, Identifier);
+  return true;
+}
+
+bool ThinLTOCodeGenerator::run(std::string &ErrMsg) {
+  if (!CombinedIndex) {
+    CombinedIndex = linkCombinedIndex(ErrMsg);
+    if (!CombinedIndex)
+      return false;
+  }
+
+  ProducedBinaries.clear();
+  ProducedBinaries.resize(Modules.size());
+  std::vector<std::string> Errors(Modules.size());
+  {
+    ThreadPool Pool(Parallelism);
+    for (unsigned I = 0, E = Modules.size(); I != E; ++I)
+      Pool.async([this, I, &Errors] { runBackend(I, Errors[I]); });
+  }
+
+  for (const std::string &Error : Errors)
+    if (!Error.empty()) {
+      ErrMsg = Error;
+      return false;
+    }
+  return true;
+}
@@ -427,14 +427,18 @@ class ModuleLinker {
   /// For symbol clashes, prefer those from Src.
   bool OverrideFromSrc;
 
+  /// If set, the definitions of Src it rejects are linked lazily.
+  std::function<bool(const GlobalValue &)> IsNeeded;
+
 public:
   ModuleLinker(Module *dstM, Linker::IdentifiedStructTypeSet &Set, Module *srcM,
                DiagnosticHandlerFunction DiagnosticHandler,
-               bool OverrideFromSrc)
+               bool OverrideFromSrc,
+               std::function<bool(const GlobalValue &)> IsNeeded)
       : DstM(dstM), SrcM(srcM), TypeMap(Set),
         ValMaterializer(TypeMap, DstM, LazilyLinkGlobalValues),
-        DiagnosticHandler(DiagnosticHandler), OverrideFromSrc(OverrideFromSrc) {
-  }
+        DiagnosticHandler(DiagnosticHandler), OverrideFromSrc(OverrideFromSrc),
+        IsNeeded(std::move(IsNeeded)) {}
 
   bool run();
 
@@ -754,7 +758,12 @@ bool ModuleLinker::shouldLinkFromSource(bool &LinkFromSrc,
       return false;
     }
     // If the Dest is weak, use the source linkage.
-    LinkFromSrc = Dest.hasExternalWeakLinkage();
+    if (Dest.hasExternalWeakLinkage()) {
+      LinkFromSrc = true;
+      return false;
+    }
+    // Link an available_externally over a declaration.
+    LinkFromSrc = !Src.isDeclaration() && Dest.isDeclaration();
     return false;
   }
 
@@ -1084,7 +1093,8 @@ bool ModuleLinker::linkGlobalValueProto(GlobalValue *SGV) {
     // The ValueMaterializerTy will deal with creating it if it's used.
     if (!DGV && !OverrideFromSrc &&
         (SGV->hasLocalLinkage() || SGV->hasLinkOnceLinkage() ||
-         SGV->hasAvailableExternallyLinkage())) {
+         SGV->hasAvailableExternallyLinkage() ||
+         (IsNeeded && !SGV->hasAppendingLinkage() && !IsNeeded(*SGV)))) {
       DoNotLinkFromSource.insert(SGV);
       return false;
     }
@@ -1761,9 +1771,11 @@ void Linker::deleteModule() {
   Composite = nullptr;
 }
 
-bool Linker::linkInModule(Module *Src, bool OverrideSymbols) {
+bool Linker::linkInModule(Module *Src, bool OverrideSymbols,
+                          std::function<bool(const GlobalValue &)> IsNeeded) {
   ModuleLinker TheLinker(Composite, IdentifiedStructTypes, Src,
-                         DiagnosticHandler, OverrideSymbols);
+                         DiagnosticHandler, OverrideSymbols,
+                         std::move(IsNeeded));
   bool RetCode = TheLinker.run();
   Composite->dropTriviallyDeadConstantArrays();
   return RetCode;
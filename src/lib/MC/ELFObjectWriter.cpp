@@ -34,6 +34,9 @@
 #include "llvm/Support/ELF.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/ThreadPool.h"
+#include <algorithm>
+#include <thread>
 #include <vector>
 using namespace llvm;
 
@@ -1202,17 +1205,13 @@ prependCompressionHeader(uint64_t Size,
 }
 
 // Return a single fragment containing the compressed contents of the whole
-// section. Null if the section was not compressed for any reason.
+// section, given its uncompressed data. Null if the section was not compressed
+// for any reason. This only touches its arguments, so different sections can
+// be compressed concurrently.
 static std::unique_ptr<MCDataFragment>
-getCompressedFragment(MCAsmLayout &Layout,
-                      MCSectionData::FragmentListType &Fragments) {
+getCompressedFragment(const SmallVectorImpl<char> &UncompressedData) {
   std::unique_ptr<MCDataFragment> CompressedFragment(new MCDataFragment());
 
-  // Gather the uncompressed data from all the fragments, recording the
-  // alignment fragment, if seen, and any fixups.
-  SmallVector<char, 128> UncompressedData =
-      getUncompressedData(Layout, Fragments);
-
   SmallVectorImpl<char> &CompressedContents = CompressedFragment->getContents();
 
   zlib::Status Success = zlib::compress(
@@ -1243,13 +1242,12 @@ static void UpdateSymbols(const MCAsmLayout &Layout,
 static void CompressDebugSection(MCAssembler &Asm, MCAsmLayout &Layout,
                                  const DefiningSymbolMap &DefiningSymbols,
                                  const MCSectionELF &Section,
-                                 MCSectionData &SD) {
+                                 MCSectionData &SD,
+                                 std::unique_ptr<MCDataFragment>
+                                     CompressedFragment) {
   StringRef SectionName = Section.getSectionName();
   MCSectionData::FragmentListType &Fragments = SD.getFragmentList();
 
-  std::unique_ptr<MCDataFragment> CompressedFragment =
-      getCompressedFragment(Layout, Fragments);
-
   // Leave the section as-is if the fragments could not be compressed.
   if (!CompressedFragment)
     return;
@@ -1286,6 +1284,14 @@ void ELFObjectWriter::CompressDebugSections(MCAssembler &Asm,
     if (MCFragment *F = SD.getFragment())
       DefiningSymbols[F->getParent()].push_back(&SD);
 
+  // Gather the uncompressed data of the debug sections first.
+  struct PendingSection {
+    MCSectionData *SD;
+    SmallVector<char, 128> UncompressedData;
+    std::unique_ptr<MCDataFragment> CompressedFragment;
+  };
+  std::vector<PendingSection> Pending;
+  size_t TotalSize = 0;
   for (MCSectionData &SD : Asm) {
     const MCSectionELF &Section =
         static_cast<const MCSectionELF &>(SD.getSection());
@@ -1297,8 +1303,37 @@ void ELFObjectWriter::CompressDebugSections(MCAssembler &Asm,
     if (!SectionName.startswith(".debug_") || SectionName == ".debug_frame")
       continue;
 
-    CompressDebugSection(Asm, Layout, DefiningSymbols, Section, SD);
+    Pending.push_back(PendingSection());
+    Pending.back().SD = &SD;
+    Pending.back().UncompressedData =
+        getUncompressedData(Layout, SD.getFragmentList());
+    TotalSize += Pending.back().UncompressedData.size();
   }
+
+  // Compressing dominates the object emission of large modules with debug
+  // info. The sections are independent, so compress them on worker threads
+  // unless there is too little data to be worth starting them.
+  const size_t ParallelCompressionThreshold = 1 << 20;
+  unsigned Threads = std::min<size_t>(std::thread::hardware_concurrency(),
+                                      Pending.size());
+  if (Threads > 1 && TotalSize >= ParallelCompressionThreshold) {
+    ThreadPool Pool(Threads);
+    for (PendingSection &P : Pending)
+      Pool.async([&P] {
+        P.CompressedFragment = getCompressedFragment(P.UncompressedData);
+      });
+    Pool.wait();
+  } else {
+    for (PendingSection &P : Pending)
+      P.CompressedFragment = getCompressedFragment(P.UncompressedData);
+  }
+
+  // Then replace their fragments, which updates the layout and the symbols,
+  // in section order.
+  for (PendingSection &P : Pending)
+    CompressDebugSection(Asm, Layout, DefiningSymbols,
+                         static_cast<const MCSectionELF &>(P.SD->getSection()),
+                         *P.SD, std::move(P.CompressedFragment));
 }
 
 void ELFObjectWriter::WriteRelocations(MCAssembler &Asm, MCAsmLayout &Layout,
@@ -28,7 +28,9 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/LEB128.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <tuple>
 using namespace llvm;
 
@@ -278,7 +280,7 @@ MCFragment::~MCFragment() {
 }
 
 MCFragment::MCFragment(FragmentType _Kind, MCSectionData *_Parent)
-  : Kind(_Kind), Parent(_Parent), Atom(nullptr), Offset(~UINT64_C(0))
+  : Parent(_Parent), Atom(nullptr), Offset(~UINT64_C(0)), Kind(_Kind)
 {
   if (Parent)
     Parent->getFragmentList().push_back(this);
@@ -924,6 +926,7 @@ void MCAssembler::fixup(MCAsmLayout &Layout) {
 }
 
 void MCAssembler::Finish() {
+  TimeTraceScope TimeScope("MCAssemblerFinish");
   DEBUG_WITH_TYPE("mc-dump", {
       llvm::errs() << "assembler backend - pre-layout\n--\n";
       dump(); });
@@ -954,8 +957,13 @@ void MCAssembler::Finish() {
   }
 
   // Layout until everything fits.
-  while (layoutOnce(Layout))
-    continue;
+  {
+    TimeTraceScope TimeScope("MCLayout");
+    collectRelaxCandidates();
+    while (layoutOnce(Layout))
+      continue;
+    RelaxCandidates.clear();
+  }
 
   DEBUG_WITH_TYPE("mc-dump", {
       llvm::errs() << "assembler backend - post-relaxation\n--\n";
@@ -978,7 +986,10 @@ void MCAssembler::Finish() {
   fixup(Layout);
   
   // Write the object file.
-  getWriter().WriteObject(*this, Layout);
+  {
+    TimeTraceScope TimeScope("MCWriteObject");
+    getWriter().WriteObject(*this, Layout);
+  }
 
   stats::ObjectBytes += OS.tell() - StartOffset;
 }
@@ -1087,6 +1098,31 @@ bool MCAssembler::relaxDwarfCallFrameFragment(MCAsmLayout &Layout,
   return OldSize != Data.size();
 }
 
+/// Return true if \p F may change size during relaxation.
+static bool mayRelax(const MCAsmBackend &Backend, const MCFragment &F) {
+  switch (F.getKind()) {
+  default:
+    return false;
+  case MCFragment::FT_Relaxable:
+    return Backend.mayNeedRelaxation(
+        cast<MCRelaxableFragment>(F).getInst());
+  case MCFragment::FT_Dwarf:
+  case MCFragment::FT_DwarfFrame:
+  case MCFragment::FT_LEB:
+    return true;
+  }
+}
+
+void MCAssembler::collectRelaxCandidates() {
+  RelaxCandidates.assign(size(), std::vector<MCFragment *>());
+  for (iterator it = begin(), ie = end(); it != ie; ++it) {
+    std::vector<MCFragment *> &Candidates = RelaxCandidates[it->getOrdinal()];
+    for (MCSectionData::iterator I = it->begin(), IE = it->end(); I != IE; ++I)
+      if (mayRelax(getBackend(), *I))
+        Candidates.push_back(I);
+  }
+}
+
 bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD) {
   // Holds the first fragment which needed relaxing during this layout. It will
   // remain NULL if none were relaxed.
@@ -1094,8 +1130,12 @@ bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD) {
   // invalidated because their offset is going to change.
   MCFragment *FirstRelaxedFragment = nullptr;
 
-  // Attempt to relax all the fragments in the section.
-  for (MCSectionData::iterator I = SD.begin(), IE = SD.end(); I != IE; ++I) {
+  // Attempt to relax all the fragments in the section that may still change.
+  // The others keep their size whatever the layout, so there is no need to
+  // visit them again.
+  std::vector<MCFragment *> &Candidates = RelaxCandidates[SD.getOrdinal()];
+  bool HasFinalFragments = false;
+  for (MCFragment *I : Candidates) {
     // Check if this is a fragment that needs relaxation.
     bool RelaxedFrag = false;
     switch(I->getKind()) {
@@ -1121,7 +1161,16 @@ bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD) {
     }
     if (RelaxedFrag && !FirstRelaxedFragment)
       FirstRelaxedFragment = I;
+    // An instruction relaxed to its final form never changes again.
+    if (RelaxedFrag && !mayRelax(getBackend(), *I))
+      HasFinalFragments = true;
   }
+  if (HasFinalFragments)
+    Candidates.erase(std::remove_if(Candidates.begin(), Candidates.end(),
+                                    [this](const MCFragment *F) {
+                                      return !mayRelax(getBackend(), *F);
+                                    }),
+                     Candidates.end());
   if (FirstRelaxedFragment) {
     Layout.invalidateFragmentsFrom(FirstRelaxedFragment);
     return true;
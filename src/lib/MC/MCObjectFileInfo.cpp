@@ -271,6 +271,41 @@ void MCObjectFileInfo::InitMachOMCObjectFileInfo(Triple T) {
     Ctx->getMachOSection("__DWARF", "__debug_inlined",
                          MachO::S_ATTR_DEBUG,
                          SectionKind::getMetadata());
+
+  // Fission Sections, truncated to the 16 character section limit.
+  DwarfInfoDWOSection =
+    Ctx->getMachOSection("__DWARF", "__debug_info.dwo",
+                         MachO::S_ATTR_DEBUG,
+                         SectionKind::getMetadata());
+  DwarfTypesDWOSection =
+    Ctx->getMachOSection("__DWARF", "__debug_types.dw",
+                         MachO::S_ATTR_DEBUG,
+                         SectionKind::getMetadata());
+  DwarfAbbrevDWOSection =
+    Ctx->getMachOSection("__DWARF", "__debug_abbrev.d",
+                         MachO::S_ATTR_DEBUG,
+                         SectionKind::getMetadata());
+  DwarfStrDWOSection =
+    Ctx->getMachOSection("__DWARF", "__debug_str.dwo",
+                         MachO::S_ATTR_DEBUG,
+                         SectionKind::getMetadata());
+  DwarfLineDWOSection =
+    Ctx->getMachOSection("__DWARF", "__debug_line.dwo",
+                         MachO::S_ATTR_DEBUG,
+                         SectionKind::getMetadata());
+  DwarfLocDWOSection =
+    Ctx->getMachOSection("__DWARF", "__debug_loc.dwo",
+                         MachO::S_ATTR_DEBUG,
+                         SectionKind::getMetadata());
+  DwarfStrOffDWOSection =
+    Ctx->getMachOSection("__DWARF", "__debug_str_offs",
+                         MachO::S_ATTR_DEBUG,
+                         SectionKind::getMetadata());
+  DwarfAddrSection =
+    Ctx->getMachOSection("__DWARF", "__debug_addr",
+                         MachO::S_ATTR_DEBUG,
+                         SectionKind::getMetadata());
+
   StackMapSection =
     Ctx->getMachOSection("__LLVM_STACKMAPS", "__llvm_stackmaps", 0,
                          SectionKind::getMetadata());
@@ -17,6 +17,7 @@
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include <algorithm>
 
 using namespace llvm;
 using namespace object;
@@ -499,21 +500,55 @@ Archive::symbol_iterator Archive::symbol_end() const {
     Symbol(this, symbol_count, 0));
 }
 
-Archive::child_iterator Archive::findSym(StringRef name) const {
-  Archive::symbol_iterator bs = symbol_begin();
-  Archive::symbol_iterator es = symbol_end();
-
-  for (; bs != es; ++bs) {
-    StringRef SymName = bs->getName();
-    if (SymName == name) {
-      ErrorOr<Archive::child_iterator> ResultOrErr = bs->getMember();
-      // FIXME: Should we really eat the error?
-      if (ResultOrErr.getError())
-        return child_end();
-      return ResultOrErr.get();
-    }
+void Archive::buildSymbolIndex() const {
+  HasSymbolIndex = true;
+  for (symbol_iterator I = symbol_begin(), E = symbol_end(); I != E; ++I) {
+    ErrorOr<child_iterator> MemberOrErr = I->getMember();
+    // A symbol whose member can't be found is kept, so that looking it up
+    // still fails instead of finding a later definition.
+    const char *Loc = nullptr;
+    if (MemberOrErr)
+      Loc = Data.getBufferStart() + MemberOrErr.get()->getChildOffset();
+    SymbolIndex.push_back(std::make_pair(I->getName(), Loc));
   }
-  return child_end();
+  // The first definition of a name wins, as in the symbol table order.
+  std::stable_sort(SymbolIndex.begin(), SymbolIndex.end(),
+                   [](const std::pair<StringRef, const char *> &A,
+                      const std::pair<StringRef, const char *> &B) {
+                     return A.first < B.first;
+                   });
+}
+
+Archive::child_iterator Archive::findSym(StringRef name) const {
+  if (!HasSymbolIndex)
+    buildSymbolIndex();
+
+  auto I = std::lower_bound(SymbolIndex.begin(), SymbolIndex.end(), name,
+                            [](const std::pair<StringRef, const char *> &A,
+                               StringRef Name) { return A.first < Name; });
+  // FIXME: Should we really eat the error?
+  if (I == SymbolIndex.end() || I->first != name || !I->second)
+    return child_end();
+  return Child(this, I->second);
+}
+
+void Archive::buildMemberIndex() const {
+  HasMemberIndex = true;
+  for (child_iterator I = child_begin(), E = child_end(); I != E; ++I)
+    MemberIndex.push_back(Data.getBufferStart() + I->getChildOffset());
+}
+
+unsigned Archive::getNumChildren() const {
+  if (!HasMemberIndex)
+    buildMemberIndex();
+  return MemberIndex.size();
+}
+
+Archive::child_iterator Archive::getChild(unsigned Index) const {
+  if (!HasMemberIndex)
+    buildMemberIndex();
+  assert(Index < MemberIndex.size() && "Member index out of range");
+  return Child(this, MemberIndex[Index]);
 }
 
 bool Archive::hasSymbolTable() const {
@@ -13,6 +13,7 @@
 
 #include "llvm/Object/IRObjectFile.h"
 #include "RecordStreamer.h"
+#include "llvm/Bitcode/LLVMBitCodes.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/IR/GVMaterializer.h"
 #include "llvm/IR/LLVMContext.h"
@@ -111,6 +112,11 @@ IRObjectFile::IRObjectFile(MemoryBufferRef Object, std::unique_ptr<Module> Mod)
   }
 }
 
+IRObjectFile::IRObjectFile(
+    MemoryBufferRef Object,
+    std::vector<std::pair<std::string, uint32_t>> Symbols)
+    : SymbolicFile(Binary::ID_IR, Object), AsmSymbols(std::move(Symbols)) {}
+
 IRObjectFile::~IRObjectFile() {
  }
 
@@ -240,8 +246,12 @@ GlobalValue *IRObjectFile::getSymbolGV(DataRefImpl Symb) { return getGV(Symb); }
 std::unique_ptr<Module> IRObjectFile::takeModule() { return std::move(M); }
 
 basic_symbol_iterator IRObjectFile::symbol_begin_impl() const {
-  Module::const_iterator I = M->begin();
   DataRefImpl Ret;
+  if (!M) {
+    Ret.p = 3;
+    return basic_symbol_iterator(BasicSymbolRef(Ret, this));
+  }
+  Module::const_iterator I = M->begin();
   Ret.p = skipEmpty(I, *M);
   return basic_symbol_iterator(BasicSymbolRef(Ret, this));
 }
@@ -308,3 +318,38 @@ llvm::object::IRObjectFile::create(MemoryBufferRef Object,
   std::unique_ptr<Module> M(MOrErr.get());
   return llvm::make_unique<IRObjectFile>(Object, std::move(M));
 }
+
+/// Translate the bitc::SymtabFlags of a symbol table entry to SymbolRef flags.
+static uint32_t getSymtabSymbolFlags(unsigned SymtabFlags) {
+  uint32_t Res = BasicSymbolRef::SF_None;
+  if (SymtabFlags & bitc::SYMTAB_UNDEFINED)
+    Res |= BasicSymbolRef::SF_Undefined;
+  if (SymtabFlags & bitc::SYMTAB_GLOBAL)
+    Res |= BasicSymbolRef::SF_Global;
+  if (SymtabFlags & bitc::SYMTAB_WEAK)
+    Res |= BasicSymbolRef::SF_Weak;
+  if (SymtabFlags & bitc::SYMTAB_COMMON)
+    Res |= BasicSymbolRef::SF_Common;
+  if (SymtabFlags & bitc::SYMTAB_FORMAT_SPECIFIC)
+    Res |= BasicSymbolRef::SF_FormatSpecific;
+  return Res;
+}
+
+ErrorOr<std::unique_ptr<IRObjectFile>>
+llvm::object::IRObjectFile::createFromSymbolTable(MemoryBufferRef Object) {
+  ErrorOr<MemoryBufferRef> BCOrErr = findBitcodeInMemBuffer(Object);
+  if (!BCOrErr)
+    return BCOrErr.getError();
+
+  ErrorOr<std::vector<BitcodeSymbol>> SymbolsOrErr =
+      getBitcodeSymbolTable(BCOrErr.get());
+  if (std::error_code EC = SymbolsOrErr.getError())
+    return EC;
+
+  std::vector<std::pair<std::string, uint32_t>> Symbols;
+  Symbols.reserve(SymbolsOrErr->size());
+  for (BitcodeSymbol &Symbol : *SymbolsOrErr)
+    Symbols.push_back(std::make_pair(std::move(Symbol.Name),
+                                     getSymtabSymbolFlags(Symbol.Flags)));
+  return llvm::make_unique<IRObjectFile>(Object, std::move(Symbols));
+}
@@ -24,6 +24,7 @@
 #include "llvm/Support/MachO.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <cctype>
 #include <cstring>
 #include <limits>
@@ -250,7 +251,7 @@ MachOObjectFile::MachOObjectFile(MemoryBufferRef Object, bool IsLittleEndian,
       SymtabLoadCmd(nullptr), DysymtabLoadCmd(nullptr),
       DataInCodeLoadCmd(nullptr), LinkOptHintsLoadCmd(nullptr),
       DyldInfoLoadCmd(nullptr), UuidLoadCmd(nullptr),
-      HasPageZeroSegment(false) {
+      HasSectionSymbolAddresses(false), HasPageZeroSegment(false) {
   uint32_t LoadCommandCount = this->getHeader().ncmds;
   if (LoadCommandCount == 0)
     return;
@@ -259,7 +260,9 @@ MachOObjectFile::MachOObjectFile(MemoryBufferRef Object, bool IsLittleEndian,
     MachO::LC_SEGMENT_64 : MachO::LC_SEGMENT;
 
   MachOObjectFile::LoadCommandInfo Load = getFirstLoadCommandInfo();
+  LoadCommands.reserve(LoadCommandCount);
   for (unsigned I = 0; ; ++I) {
+    LoadCommands.push_back(Load);
     if (Load.C.cmd == MachO::LC_SYMTAB) {
       // Multiple symbol tables
       if (SymtabLoadCmd) {
@@ -413,6 +416,28 @@ std::error_code MachOObjectFile::getSymbolAlignment(DataRefImpl DRI,
   return object_error::success;
 }
 
+const std::vector<uint64_t> &
+MachOObjectFile::getSectionSymbolAddresses(uint8_t Sect) const {
+  if (!HasSectionSymbolAddresses) {
+    // Unfortunately symbols are unsorted so we need to touch all
+    // symbols from load command, but only once.
+    HasSectionSymbolAddresses = true;
+    SectionSymbolAddresses.resize(256);
+    for (const SymbolRef &Symbol : symbols()) {
+      DataRefImpl DRI = Symbol.getRawDataRefImpl();
+      MachO::nlist_base Entry = getSymbolTableEntryBase(this, DRI);
+      uint64_t Value;
+      getSymbolAddress(DRI, Value);
+      if (Value == UnknownAddressOrSize)
+        continue;
+      SectionSymbolAddresses[Entry.n_sect].push_back(Value);
+    }
+    for (std::vector<uint64_t> &Addresses : SectionSymbolAddresses)
+      std::sort(Addresses.begin(), Addresses.end());
+  }
+  return SectionSymbolAddresses[Sect];
+}
+
 std::error_code MachOObjectFile::getSymbolSize(DataRefImpl DRI,
                                                uint64_t &Result) const {
   uint64_t BeginOffset;
@@ -438,18 +463,12 @@ std::error_code MachOObjectFile::getSymbolSize(DataRefImpl DRI,
       Result = UnknownAddressOrSize;
     return object_error::success;
   }
-  // Unfortunately symbols are unsorted so we need to touch all
-  // symbols from load command
-  for (const SymbolRef &Symbol : symbols()) {
-    DataRefImpl DRI = Symbol.getRawDataRefImpl();
-    Entry = getSymbolTableEntryBase(this, DRI);
-    getSymbolAddress(DRI, Value);
-    if (Value == UnknownAddressOrSize)
-      continue;
-    if (Entry.n_sect == SectionIndex && Value > BeginOffset)
-      if (!EndOffset || Value < EndOffset)
-        EndOffset = Value;
-  }
+  // The symbol ends where the next symbol of its section begins.
+  const std::vector<uint64_t> &Addresses =
+      getSectionSymbolAddresses(SectionIndex);
+  auto Next = std::upper_bound(Addresses.begin(), Addresses.end(), BeginOffset);
+  if (Next != Addresses.end())
+    EndOffset = *Next;
   if (!EndOffset) {
     DataRefImpl Sec;
     Sec.d.a = SectionIndex-1;
@@ -89,7 +89,8 @@ ObjectFile::createObjectFile(MemoryBufferRef Object, sys::fs::file_magic Type) {
 ErrorOr<OwningBinary<ObjectFile>>
 ObjectFile::createObjectFile(StringRef ObjectPath) {
   ErrorOr<std::unique_ptr<MemoryBuffer>> FileOrErr =
-      MemoryBuffer::getFile(ObjectPath);
+      MemoryBuffer::getFile(ObjectPath, /*FileSize=*/-1,
+                            /*RequiresNullTerminator=*/false);
   if (std::error_code EC = FileOrErr.getError())
     return EC;
   std::unique_ptr<MemoryBuffer> Buffer = std::move(FileOrErr.get());
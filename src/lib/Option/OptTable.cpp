@@ -23,6 +23,7 @@ using namespace llvm::opt;
 namespace llvm {
 namespace opt {
 
+#ifndef NDEBUG
 // Ordering on Info. The ordering is *almost* case-insensitive lexicographic,
 // with an exceptions. '\0' comes at the end of the alphabet instead of the
 // beginning (thus options precede any other options which prefix them).
@@ -46,7 +47,6 @@ static int StrCmpOptionNameIgnoreCase(const char *A, const char *B) {
   return (a < b) ? -1 : 1;
 }
 
-#ifndef NDEBUG
 static int StrCmpOptionName(const char *A, const char *B) {
   if (int N = StrCmpOptionNameIgnoreCase(A, B))
     return N;
@@ -74,11 +74,6 @@ static inline bool operator<(const OptTable::Info &A, const OptTable::Info &B) {
   return B.Kind == Option::JoinedClass;
 }
 #endif
-
-// Support lower_bound between info and an option name.
-static inline bool operator<(const OptTable::Info &I, const char *Name) {
-  return StrCmpOptionNameIgnoreCase(I.Name, Name) < 0;
-}
 }
 }
 
@@ -152,6 +147,15 @@ OptTable::OptTable(const Info *_OptionInfos, unsigned _NumOptionInfos,
             == PrefixChars.end())
         PrefixChars.push_back(*C);
   }
+
+#ifndef NDEBUG
+  // Parsing strips all the prefix characters before looking the name up.
+  for (unsigned i = FirstSearchableIndex + 1, e = getNumOptions() + 1;
+                i != e; ++i)
+    assert(std::find(PrefixChars.begin(), PrefixChars.end(),
+                     getInfo(i).Name[0]) == PrefixChars.end() &&
+           "Option names cannot start with a prefix character!");
+#endif
 }
 
 OptTable::~OptTable() {
@@ -207,40 +211,57 @@ Arg *OptTable::ParseOneArg(const ArgList &Args, unsigned &Index,
   const Info *End = OptionInfos + getNumOptions();
   StringRef Name = StringRef(Str).ltrim(PrefixChars);
 
-  // Search for the first next option which could be a prefix.
-  Start = std::lower_bound(Start, End, Name.data());
-
   // Options are stored in sorted order, with '\0' at the end of the
-  // alphabet. Since the only options which can accept a string must
-  // prefix it, we iteratively search for the next option which could
-  // be a prefix.
-  //
-  // FIXME: This is searching much more than necessary, but I am
-  // blanking on the simplest way to make it fast. We can solve this
-  // problem when we move to TableGen.
-  for (; Start != End; ++Start) {
-    unsigned ArgSize = 0;
-    // Scan for first option which is a proper prefix.
-    for (; Start != End; ++Start)
-      if ((ArgSize = matchOption(Start, Str, IgnoreCase)))
-        break;
+  // alphabet. The only options which can accept a string must prefix it, and
+  // the options starting with the same N characters are contiguous and end
+  // with those named by exactly these N characters. Narrow that range one
+  // character of Name at a time, and remember the options named by each
+  // prefix of Name.
+  SmallVector<std::pair<const Info *, const Info *>, 8> Candidates;
+  for (size_t N = 0;; ++N) {
+    const Info *Named =
+        std::partition_point(Start, End, [N](const Info &I) {
+          return I.Name[N] != '\0';
+        });
+    if (Named != End)
+      Candidates.push_back(std::make_pair(Named, End));
+    if (N == Name.size())
+      break;
+
+    char C = tolower(Name[N]);
+    Start = std::partition_point(Start, Named, [N, C](const Info &I) {
+      return tolower(I.Name[N]) < C;
+    });
+    End = std::partition_point(Start, Named, [N, C](const Info &I) {
+      return tolower(I.Name[N]) == C;
+    });
     if (Start == End)
       break;
+  }
 
-    Option Opt(Start, this);
+  // Try the options which could be a prefix in order, longest name first.
+  for (unsigned i = Candidates.size(); i != 0; --i) {
+    for (const Info *I = Candidates[i - 1].first, *E = Candidates[i - 1].second;
+         I != E; ++I) {
+      unsigned ArgSize = matchOption(I, Str, IgnoreCase);
+      if (!ArgSize)
+        continue;
 
-    if (FlagsToInclude && !Opt.hasFlag(FlagsToInclude))
-      continue;
-    if (Opt.hasFlag(FlagsToExclude))
-      continue;
+      Option Opt(I, this);
 
-    // See if this option matches.
-    if (Arg *A = Opt.accept(Args, Index, ArgSize))
-      return A;
+      if (FlagsToInclude && !Opt.hasFlag(FlagsToInclude))
+        continue;
+      if (Opt.hasFlag(FlagsToExclude))
+        continue;
 
-    // Otherwise, see if this argument was missing values.
-    if (Prev != Index)
-      return nullptr;
+      // See if this option matches.
+      if (Arg *A = Opt.accept(Args, Index, ArgSize))
+        return A;
+
+      // Otherwise, see if this argument was missing values.
+      if (Prev != Index)
+        return nullptr;
+    }
   }
 
   // If we failed to find an option and this arg started with /, then it's
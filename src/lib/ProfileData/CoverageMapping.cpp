@@ -234,7 +234,8 @@ CoverageMapping::load(CoverageMappingReader &CoverageReader,
 
 ErrorOr<std::unique_ptr<CoverageMapping>>
 CoverageMapping::load(StringRef ObjectFilename, StringRef ProfileFilename,
-                      StringRef Arch) {
+                      StringRef Arch,
+                      std::function<bool(StringRef Filename)> IsFileWanted) {
   auto CounterMappingBuff = MemoryBuffer::getFileOrSTDIN(ObjectFilename);
   if (std::error_code EC = CounterMappingBuff.getError())
     return EC;
@@ -243,6 +244,9 @@ CoverageMapping::load(StringRef ObjectFilename, StringRef ProfileFilename,
   if (std::error_code EC = CoverageReaderOrErr.getError())
     return EC;
   auto CoverageReader = std::move(CoverageReaderOrErr.get());
+  if (IsFileWanted)
+    if (std::error_code EC = CoverageReader->restrictToFiles(IsFileWanted))
+      return EC;
   auto ProfileReaderOrErr = IndexedInstrProfReader::create(ProfileFilename);
   if (auto EC = ProfileReaderOrErr.getError())
     return EC;
@@ -220,14 +220,13 @@ std::error_code RawCoverageMappingReader::readMappingRegionsSubArray(
   return std::error_code();
 }
 
-std::error_code RawCoverageMappingReader::read() {
-
+std::error_code
+RawCoverageMappingReader::readFileIDMapping(uint64_t &NumFileIDs) {
   // Read the virtual file mapping.
   llvm::SmallVector<unsigned, 8> VirtualFileMapping;
-  uint64_t NumFileMappings;
-  if (auto Err = readSize(NumFileMappings))
+  if (auto Err = readSize(NumFileIDs))
     return Err;
-  for (size_t I = 0; I < NumFileMappings; ++I) {
+  for (size_t I = 0; I < NumFileIDs; ++I) {
     uint64_t FilenameIndex;
     if (auto Err = readIntMax(FilenameIndex, TranslationUnitFilenames.size()))
       return Err;
@@ -238,6 +237,18 @@ std::error_code RawCoverageMappingReader::read() {
   for (auto I : VirtualFileMapping) {
     Filenames.push_back(TranslationUnitFilenames[I]);
   }
+  return std::error_code();
+}
+
+std::error_code RawCoverageMappingReader::readFilenames() {
+  uint64_t NumFileIDs;
+  return readFileIDMapping(NumFileIDs);
+}
+
+std::error_code RawCoverageMappingReader::read() {
+  uint64_t NumFileIDs;
+  if (auto Err = readFileIDMapping(NumFileIDs))
+    return Err;
 
   // Read the expressions.
   uint64_t NumExpressions;
@@ -257,10 +268,10 @@ std::error_code RawCoverageMappingReader::read() {
   }
 
   // Read the mapping regions sub-arrays.
-  for (unsigned InferredFileID = 0, S = VirtualFileMapping.size();
-       InferredFileID < S; ++InferredFileID) {
+  for (unsigned InferredFileID = 0; InferredFileID < NumFileIDs;
+       ++InferredFileID) {
     if (auto Err = readMappingRegionsSubArray(MappingRegions, InferredFileID,
-                                              VirtualFileMapping.size()))
+                                              NumFileIDs))
       return Err;
   }
 
@@ -270,8 +281,8 @@ std::error_code RawCoverageMappingReader::read() {
   // Perform multiple passes to correctly propagate the counters through
   // all the nested expansion regions.
   SmallVector<CounterMappingRegion *, 8> FileIDExpansionRegionMapping;
-  FileIDExpansionRegionMapping.resize(VirtualFileMapping.size(), nullptr);
-  for (unsigned Pass = 1, S = VirtualFileMapping.size(); Pass < S; ++Pass) {
+  FileIDExpansionRegionMapping.resize(NumFileIDs, nullptr);
+  for (unsigned Pass = 1; Pass < NumFileIDs; ++Pass) {
     for (auto &R : MappingRegions) {
       if (R.Kind != CounterMappingRegion::ExpansionRegion)
         continue;
@@ -531,15 +542,71 @@ BinaryCoverageReader::create(std::unique_ptr<MemoryBuffer> &ObjectBuffer,
   return std::move(Reader);
 }
 
+std::error_code BinaryCoverageReader::buildFileIndex() {
+  if (HasFileIndex)
+    return std::error_code();
+
+  std::vector<StringRef> RecordFilenames;
+  for (unsigned I = 0, E = MappingRecords.size(); I < E; ++I) {
+    auto &R = MappingRecords[I];
+    RecordFilenames.clear();
+    std::vector<CounterExpression> UnusedExpressions;
+    std::vector<CounterMappingRegion> UnusedRegions;
+    RawCoverageMappingReader Reader(
+        R.CoverageMapping,
+        makeArrayRef(Filenames).slice(R.FilenamesBegin, R.FilenamesSize),
+        RecordFilenames, UnusedExpressions, UnusedRegions);
+    if (auto Err = Reader.readFilenames())
+      return Err;
+    // A function can refer to the same file through several file IDs.
+    std::sort(RecordFilenames.begin(), RecordFilenames.end());
+    auto Last = std::unique(RecordFilenames.begin(), RecordFilenames.end());
+    for (auto Filename = RecordFilenames.begin(); Filename != Last; ++Filename)
+      FileIndex[*Filename].push_back(I);
+  }
+  HasFileIndex = true;
+  return std::error_code();
+}
+
+ErrorOr<std::vector<StringRef>> BinaryCoverageReader::getSourceFiles() {
+  if (auto Err = buildFileIndex())
+    return Err;
+  std::vector<StringRef> SourceFiles;
+  for (const auto &Entry : FileIndex)
+    SourceFiles.push_back(Entry.getKey());
+  std::sort(SourceFiles.begin(), SourceFiles.end());
+  return SourceFiles;
+}
+
+std::error_code BinaryCoverageReader::restrictToFiles(
+    function_ref<bool(StringRef Filename)> IsFileWanted) {
+  if (auto Err = buildFileIndex())
+    return Err;
+  SelectedRecords.clear();
+  for (const auto &Entry : FileIndex)
+    if (IsFileWanted(Entry.getKey()))
+      SelectedRecords.insert(SelectedRecords.end(), Entry.getValue().begin(),
+                             Entry.getValue().end());
+  std::sort(SelectedRecords.begin(), SelectedRecords.end());
+  SelectedRecords.erase(
+      std::unique(SelectedRecords.begin(), SelectedRecords.end()),
+      SelectedRecords.end());
+  IsRestricted = true;
+  CurrentRecord = 0;
+  return std::error_code();
+}
+
 std::error_code
 BinaryCoverageReader::readNextRecord(CoverageMappingRecord &Record) {
-  if (CurrentRecord >= MappingRecords.size())
+  if (CurrentRecord >=
+      (IsRestricted ? SelectedRecords.size() : MappingRecords.size()))
     return coveragemap_error::eof;
 
   FunctionsFilenames.clear();
   Expressions.clear();
   MappingRegions.clear();
-  auto &R = MappingRecords[CurrentRecord];
+  auto &R = MappingRecords[IsRestricted ? SelectedRecords[CurrentRecord]
+                                        : CurrentRecord];
   RawCoverageMappingReader Reader(
       R.CoverageMapping,
       makeArrayRef(Filenames).slice(R.FilenamesBegin, R.FilenamesSize),
@@ -15,6 +15,7 @@
 #include "llvm/ProfileData/InstrProf.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ManagedStatic.h"
+#include <algorithm>
 
 using namespace llvm;
 
@@ -50,6 +51,8 @@ class InstrProfErrorCategoryType : public std::error_category {
       return "Function count mismatch";
     case instrprof_error::counter_overflow:
       return "Counter overflow";
+    case instrprof_error::value_site_count_mismatch:
+      return "Function value site count mismatch";
     }
     llvm_unreachable("A value of instrprof_error has no message.");
   }
@@ -61,3 +64,34 @@ static ManagedStatic<InstrProfErrorCategoryType> ErrorCategory;
 const std::error_category &llvm::instrprof_category() {
   return *ErrorCategory;
 }
+
+std::error_code llvm::mergeInstrProfValueSites(
+    std::vector<InstrProfValueSiteRecord> &Dst,
+    const std::vector<InstrProfValueSiteRecord> &Src) {
+  if (Src.empty())
+    return instrprof_error::success;
+  if (Dst.empty()) {
+    Dst = Src;
+    return instrprof_error::success;
+  }
+  if (Dst.size() != Src.size())
+    return instrprof_error::value_site_count_mismatch;
+
+  for (size_t I = 0, E = Src.size(); I < E; ++I) {
+    InstrProfValueSiteRecord &Site = Dst[I];
+    for (const InstrProfValueData &V : Src[I]) {
+      auto Found = std::find_if(Site.begin(), Site.end(),
+                                [&](const InstrProfValueData &D) {
+                                  return D.Value == V.Value;
+                                });
+      if (Found == Site.end()) {
+        Site.push_back(V);
+        continue;
+      }
+      if (Found->Count + V.Count < Found->Count)
+        return instrprof_error::counter_overflow;
+      Found->Count += V.Count;
+    }
+  }
+  return instrprof_error::success;
+}
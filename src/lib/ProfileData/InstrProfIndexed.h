@@ -14,9 +14,9 @@
 #ifndef LLVM_LIB_PROFILEDATA_INSTRPROFINDEXED_H
 #define LLVM_LIB_PROFILEDATA_INSTRPROFINDEXED_H
 
+#include "llvm/ProfileData/InstrProf.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/ErrorHandling.h"
-#include "llvm/Support/MD5.h"
 
 namespace llvm {
 
@@ -28,14 +28,7 @@ enum class HashT : uint32_t {
 };
 
 static inline uint64_t MD5Hash(StringRef Str) {
-  MD5 Hash;
-  Hash.update(Str);
-  llvm::MD5::MD5Result Result;
-  Hash.final(Result);
-  // Return the least significant 8 bytes. Our MD5 implementation returns the
-  // result in little endian, so we may need to swap bytes.
-  using namespace llvm::support;
-  return endian::read<uint64_t, little, unaligned>(Result);
+  return getInstrProfNameHash(Str);
 }
 
 static inline uint64_t ComputeHash(HashT Type, StringRef K) {
@@ -47,7 +40,8 @@ static inline uint64_t ComputeHash(HashT Type, StringRef K) {
 }
 
 const uint64_t Magic = 0x8169666f72706cff; // "\xfflprofi\x81"
-const uint64_t Version = 2;
+// Version 3 adds the value profile data after the counters of each record.
+const uint64_t Version = 3;
 const HashT HashType = HashT::MD5;
 }
 
@@ -14,8 +14,13 @@
 
 #include "llvm/ProfileData/InstrProfReader.h"
 #include "InstrProfIndexed.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ProfileData/InstrProf.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ManagedStatic.h"
+#include <algorithm>
 #include <cassert>
+#include <mutex>
 
 using namespace llvm;
 
@@ -65,18 +70,70 @@ InstrProfReader::create(std::unique_ptr<MemoryBuffer> Buffer) {
   return std::move(Result);
 }
 
+namespace {
+/// The indexed profiles mapped by this process. Readers of the same unchanged
+/// file share one mapping instead of each reading the file again. Entries
+/// don't keep the mappings alive: they go away with their last reader.
+struct IndexedProfileCache {
+  struct Entry {
+    std::weak_ptr<MemoryBuffer> Buffer;
+    sys::TimeValue LastModified;
+    uint64_t Size;
+  };
+  std::mutex Lock;
+  StringMap<Entry> Entries;
+};
+}
+
+static ManagedStatic<IndexedProfileCache> ProfileCache;
+
+static ErrorOr<std::shared_ptr<MemoryBuffer>>
+getSharedIndexedProfile(const std::string &Path) {
+  if (Path == "-")
+    return setupMemoryBuffer(Path);
+
+  sys::fs::file_status Status;
+  if (std::error_code EC = sys::fs::status(Path, Status))
+    return EC;
+
+  std::lock_guard<std::mutex> Guard(ProfileCache->Lock);
+  IndexedProfileCache::Entry &Cached = ProfileCache->Entries[Path];
+  if (Cached.LastModified == Status.getLastModificationTime() &&
+      Cached.Size == Status.getSize())
+    if (std::shared_ptr<MemoryBuffer> Buffer = Cached.Buffer.lock())
+      return Buffer;
+
+  // The reader doesn't need a null terminator, which lets MemoryBuffer map
+  // the file whatever its size. Mapped pages are shared with the other
+  // processes reading the same profile, like parallel compiles.
+  auto BufferOrErr = MemoryBuffer::getFile(Path, -1,
+                                           /*RequiresNullTerminator=*/false);
+  if (std::error_code EC = BufferOrErr.getError())
+    return EC;
+  std::shared_ptr<MemoryBuffer> Buffer = std::move(BufferOrErr.get());
+  Cached.Buffer = Buffer;
+  Cached.LastModified = Status.getLastModificationTime();
+  Cached.Size = Status.getSize();
+  return Buffer;
+}
+
 ErrorOr<std::unique_ptr<IndexedInstrProfReader>>
 IndexedInstrProfReader::create(std::string Path) {
   // Set up the buffer to read.
-  auto BufferOrError = setupMemoryBuffer(Path);
+  auto BufferOrError = getSharedIndexedProfile(Path);
   if (std::error_code EC = BufferOrError.getError())
     return EC;
   return IndexedInstrProfReader::create(std::move(BufferOrError.get()));
 }
 
-
 ErrorOr<std::unique_ptr<IndexedInstrProfReader>>
 IndexedInstrProfReader::create(std::unique_ptr<MemoryBuffer> Buffer) {
+  return IndexedInstrProfReader::create(
+      std::shared_ptr<MemoryBuffer>(std::move(Buffer)));
+}
+
+ErrorOr<std::unique_ptr<IndexedInstrProfReader>>
+IndexedInstrProfReader::create(std::shared_ptr<MemoryBuffer> Buffer) {
   // Sanity check the buffer.
   if (Buffer->getBufferSize() > std::numeric_limits<unsigned>::max())
     return instrprof_error::too_large;
@@ -137,6 +194,8 @@ std::error_code TextInstrProfReader::readNextRecord(InstrProfRecord &Record) {
   }
   // Give the record a reference to our internal counter storage.
   Record.Counts = Counts;
+  // The text format has no value data.
+  Record.IndirectCallSites.clear();
 
   return success();
 }
@@ -220,7 +279,8 @@ RawInstrProfReader<IntPtrT>::readNextHeader(const char *CurrentPos) {
 }
 
 static uint64_t getRawVersion() {
-  return 1;
+  // Version 2 adds the value profile data after the names.
+  return 2;
 }
 
 template <class IntPtrT>
@@ -234,22 +294,44 @@ RawInstrProfReader<IntPtrT>::readHeader(const RawHeader &Header) {
   auto DataSize = swap(Header.DataSize);
   auto CountersSize = swap(Header.CountersSize);
   auto NamesSize = swap(Header.NamesSize);
+  auto ValueDataSize = swap(Header.ValueDataSize);
 
+  // The runtime pads the names with one to eight zeros, so that the value
+  // data is aligned.
   ptrdiff_t DataOffset = sizeof(RawHeader);
   ptrdiff_t CountersOffset = DataOffset + sizeof(ProfileData) * DataSize;
   ptrdiff_t NamesOffset = CountersOffset + sizeof(uint64_t) * CountersSize;
-  size_t ProfileSize = NamesOffset + sizeof(char) * NamesSize;
+  ptrdiff_t ValueDataOffset = NamesOffset + sizeof(char) * NamesSize +
+                              sizeof(uint64_t) - NamesSize % sizeof(uint64_t);
+  size_t ProfileSize = ValueDataOffset + ValueDataSize;
 
   auto *Start = reinterpret_cast<const char *>(&Header);
-  if (Start + ProfileSize > DataBuffer->getBufferEnd())
+  if (ValueDataSize % sizeof(uint64_t) ||
+      Start + ProfileSize > DataBuffer->getBufferEnd())
     return error(instrprof_error::bad_header);
 
   Data = reinterpret_cast<const ProfileData *>(Start + DataOffset);
   DataEnd = Data + DataSize;
   CountersStart = reinterpret_cast<const uint64_t *>(Start + CountersOffset);
   NamesStart = Start + NamesOffset;
+  ValueDataCur = reinterpret_cast<const uint64_t *>(Start + ValueDataOffset);
+  ValueDataEnd = ValueDataCur + ValueDataSize / sizeof(uint64_t);
   ProfileEnd = Start + ProfileSize;
 
+  // The indirect call targets are recorded as addresses, which are only
+  // meaningful for the functions of this profile.
+  FunctionNameHashes.clear();
+  for (const ProfileData *I = Data; I != DataEnd; ++I) {
+    if (!I->FunctionPointer)
+      continue;
+    const char *Name = getName(I->NamePtr);
+    uint32_t NameSize = swap(I->NameSize);
+    if (Name < NamesStart || Name + NameSize > DataBuffer->getBufferEnd())
+      return error(instrprof_error::malformed);
+    FunctionNameHashes[swap(I->FunctionPointer)] =
+        getInstrProfNameHash(StringRef(Name, NameSize));
+  }
+
   return success();
 }
 
@@ -287,11 +369,49 @@ RawInstrProfReader<IntPtrT>::readNextRecord(InstrProfRecord &Record) {
   } else
     Record.Counts = RawCounts;
 
+  if (std::error_code EC = readValueData(swap(Data->NumValueSites), Record))
+    return EC;
+
   // Iterate.
   ++Data;
   return success();
 }
 
+template <class IntPtrT>
+std::error_code
+RawInstrProfReader<IntPtrT>::readValueData(uint64_t NumValueSites,
+                                           InstrProfRecord &Record) {
+  Record.IndirectCallSites.clear();
+  Record.IndirectCallSites.resize(NumValueSites);
+  for (InstrProfValueSiteRecord &Site : Record.IndirectCallSites) {
+    if (ValueDataCur == ValueDataEnd)
+      return error(instrprof_error::malformed);
+    uint64_t NumValues = swap(*ValueDataCur++);
+    if (uint64_t(ValueDataEnd - ValueDataCur) / 2 < NumValues)
+      return error(instrprof_error::malformed);
+    for (uint64_t I = 0; I < NumValues; ++I, ValueDataCur += 2) {
+      // Drop the targets outside of the profile, like functions without
+      // instrumentation.
+      auto Target = FunctionNameHashes.find(swap(ValueDataCur[0]));
+      if (Target == FunctionNameHashes.end())
+        continue;
+      InstrProfValueData Value = {Target->second, swap(ValueDataCur[1])};
+      // Racing updates in the runtime may list a target more than once.
+      auto Found = std::find_if(Site.begin(), Site.end(),
+                                [&](const InstrProfValueData &D) {
+                                  return D.Value == Value.Value;
+                                });
+      if (Found == Site.end())
+        Site.push_back(Value);
+      else if (Found->Count + Value.Count < Found->Count)
+        return error(instrprof_error::counter_overflow);
+      else
+        Found->Count += Value.Count;
+    }
+  }
+  return success();
+}
+
 namespace llvm {
 template class RawInstrProfReader<uint32_t>;
 template class RawInstrProfReader<uint64_t>;
@@ -349,28 +469,64 @@ std::error_code IndexedInstrProfReader::readHeader() {
   return success();
 }
 
+/// Decode the value data of the record that continues at word \p I of
+/// \p Data, and move \p I past it. Returns false if the data is malformed.
+static bool readValueSites(const InstrProfLookupTrait::data_type &Data,
+                           uint64_t &I,
+                           std::vector<InstrProfValueSiteRecord> *Sites) {
+  uint64_t E = Data.size();
+  if (I == E)
+    return false;
+  uint64_t NumSites = Data[I++];
+  if (Sites) {
+    Sites->clear();
+    Sites->resize(std::min(NumSites, E - I));
+  }
+  for (uint64_t S = 0; S < NumSites; ++S) {
+    if (I == E)
+      return false;
+    uint64_t NumValues = Data[I++];
+    if ((E - I) / 2 < NumValues)
+      return false;
+    if (Sites)
+      for (uint64_t V = 0; V < NumValues; ++V)
+        (*Sites)[S].push_back({Data[I + 2 * V], Data[I + 2 * V + 1]});
+    I += 2 * NumValues;
+  }
+  return true;
+}
+
 std::error_code IndexedInstrProfReader::getFunctionCounts(
-    StringRef FuncName, uint64_t FuncHash, std::vector<uint64_t> &Counts) {
+    StringRef FuncName, uint64_t FuncHash, std::vector<uint64_t> &Counts,
+    std::vector<InstrProfValueSiteRecord> *IndirectCallSites) {
   auto Iter = Index->find(FuncName);
   if (Iter == Index->end())
     return error(instrprof_error::unknown_function);
 
-  // Found it. Look for counters with the right hash.
-  ArrayRef<uint64_t> Data = (*Iter).Data;
-  uint64_t NumCounts;
-  for (uint64_t I = 0, E = Data.size(); I != E; I += NumCounts) {
+  // Found it. Look for counters with the right hash. Only those are decoded.
+  const InstrProfLookupTrait::data_type Data = *Iter;
+  for (uint64_t I = 0, E = Data.size(); I != E;) {
     // The function hash comes first.
     uint64_t FoundHash = Data[I++];
     // In v1, we have at least one count. Later, we have the number of counts.
     if (I == E)
       return error(instrprof_error::malformed);
-    NumCounts = FormatVersion == 1 ? E - I : Data[I++];
+    uint64_t NumCounts = FormatVersion == 1 ? E - I : Data[I++];
     // If we have more counts than data, this is bogus.
     if (I + NumCounts > E)
       return error(instrprof_error::malformed);
+    uint64_t CountsStart = I;
+    I += NumCounts;
+    // Since v3, the value data follows the counts.
+    bool Found = FoundHash == FuncHash;
+    if (IndirectCallSites && Found)
+      IndirectCallSites->clear();
+    if (FormatVersion >= 3 &&
+        !readValueSites(Data, I, Found ? IndirectCallSites : nullptr))
+      return error(instrprof_error::malformed);
     // Check for a match and fill the vector if there is one.
-    if (FoundHash == FuncHash) {
-      Counts = Data.slice(I, NumCounts);
+    if (Found) {
+      Data.decode(CountsStart, NumCounts, Counts);
       return success();
     }
   }
@@ -386,7 +542,7 @@ IndexedInstrProfReader::readNextRecord(InstrProfRecord &Record) {
   // Record the current function name.
   Record.Name = (*RecordIterator).Name;
 
-  ArrayRef<uint64_t> Data = (*RecordIterator).Data;
+  const InstrProfLookupTrait::data_type Data = *RecordIterator;
   // Valid data starts with a hash and either a count or the number of counts.
   if (CurrentOffset + 1 > Data.size())
     return error(instrprof_error::malformed);
@@ -399,10 +555,18 @@ IndexedInstrProfReader::readNextRecord(InstrProfRecord &Record) {
   if (CurrentOffset + NumCounts > Data.size())
     return error(instrprof_error::malformed);
   // And finally the counts themselves.
-  Record.Counts = Data.slice(CurrentOffset, NumCounts);
+  Data.decode(CurrentOffset, NumCounts, RecordCounts);
+  Record.Counts = RecordCounts;
 
   // If we've exhausted this function's data, increment the record.
   CurrentOffset += NumCounts;
+  Record.IndirectCallSites.clear();
+  if (FormatVersion >= 3) {
+    uint64_t Offset = CurrentOffset;
+    if (!readValueSites(Data, Offset, &Record.IndirectCallSites))
+      return error(instrprof_error::malformed);
+    CurrentOffset = Offset;
+  }
   if (CurrentOffset == Data.size()) {
     ++RecordIterator;
     CurrentOffset = 0;
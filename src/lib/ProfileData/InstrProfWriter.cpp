@@ -14,9 +14,13 @@
 
 #include "llvm/ProfileData/InstrProfWriter.h"
 #include "InstrProfIndexed.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/OnDiskHashTable.h"
+#include <algorithm>
+#include <queue>
 
 using namespace llvm;
 
@@ -46,12 +50,22 @@ public:
 
     offset_type M = 0;
     for (const auto &Counts : *V)
-      M += (2 + Counts.second.size()) * sizeof(uint64_t);
+      M += getRecordSize(Counts.second) * sizeof(uint64_t);
     LE.write<offset_type>(M);
 
     return std::make_pair(N, M);
   }
 
+  /// Return the number of words of the record \p R: the hash, the number of
+  /// counts, the counts, and the number of value sites followed by the number
+  /// of values and the values of each site.
+  static uint64_t getRecordSize(const InstrProfWriter::ProfileRecord &R) {
+    uint64_t Size = 3 + R.Counts.size();
+    for (const InstrProfValueSiteRecord &Site : R.IndirectCallSites)
+      Size += 1 + 2 * Site.size();
+    return Size;
+  }
+
   static void EmitKey(raw_ostream &Out, key_type_ref K, offset_type N){
     Out.write(K.data(), N);
   }
@@ -61,26 +75,168 @@ public:
     using namespace llvm::support;
     endian::Writer<little> LE(Out);
 
-    for (const auto &Counts : *V) {
-      LE.write<uint64_t>(Counts.first);
-      LE.write<uint64_t>(Counts.second.size());
-      for (uint64_t I : Counts.second)
+    // Emit the records sorted by hash, the iteration order of the map depends
+    // on the order they were added in.
+    SmallVector<const InstrProfWriter::CounterData::value_type *, 1> Records;
+    for (const auto &Counts : *V)
+      Records.push_back(&Counts);
+    std::sort(Records.begin(), Records.end(),
+              [](const InstrProfWriter::CounterData::value_type *LHS,
+                 const InstrProfWriter::CounterData::value_type *RHS) {
+                return LHS->first < RHS->first;
+              });
+
+    for (const auto *Counts : Records) {
+      LE.write<uint64_t>(Counts->first);
+      LE.write<uint64_t>(Counts->second.Counts.size());
+      for (uint64_t I : Counts->second.Counts)
         LE.write<uint64_t>(I);
+      LE.write<uint64_t>(Counts->second.IndirectCallSites.size());
+      for (const InstrProfValueSiteRecord &Site :
+           Counts->second.IndirectCallSites) {
+        // The hottest targets first, to make them cheap to find.
+        InstrProfValueSiteRecord Sorted(Site);
+        std::stable_sort(Sorted.begin(), Sorted.end(),
+                         [](const InstrProfValueData &LHS,
+                            const InstrProfValueData &RHS) {
+                           return LHS.Count > RHS.Count;
+                         });
+        LE.write<uint64_t>(Sorted.size());
+        for (const InstrProfValueData &V : Sorted) {
+          LE.write<uint64_t>(V.Value);
+          LE.write<uint64_t>(V.Count);
+        }
+      }
     }
   }
 };
+
+/// Write the hash table entry of \p Name, minus the key hash. This is also
+/// the format of the records of the spilled runs.
+static void emitRecord(raw_ostream &OS, StringRef Name,
+                       const InstrProfWriter::CounterData &Data) {
+  auto Len = InstrProfRecordTrait::EmitKeyDataLength(OS, Name, &Data);
+  InstrProfRecordTrait::EmitKey(OS, Name, Len.first);
+  InstrProfRecordTrait::EmitData(OS, Name, &Data, Len.second);
 }
 
-std::error_code
-InstrProfWriter::addFunctionCounts(StringRef FunctionName,
-                                   uint64_t FunctionHash,
-                                   ArrayRef<uint64_t> Counters) {
-  auto &CounterData = FunctionData[FunctionName];
+/// Sequential reader for the records of a spilled run, as written by
+/// emitRecord().
+class SpilledRunReader {
+  std::unique_ptr<MemoryBuffer> Buffer;
+  const unsigned char *Cur, *End;
+
+public:
+  /// The name, data and raw bytes of the current record.
+  StringRef Name, Data, Record;
+
+  explicit SpilledRunReader(std::unique_ptr<MemoryBuffer> RunBuffer)
+      : Buffer(std::move(RunBuffer)) {
+    Cur = reinterpret_cast<const unsigned char *>(Buffer->getBufferStart());
+    End = reinterpret_cast<const unsigned char *>(Buffer->getBufferEnd());
+  }
+
+  /// Move to the next record. Returns false at the end of the run.
+  bool next() {
+    using namespace llvm::support;
+    if (End - Cur < 2 * static_cast<ptrdiff_t>(sizeof(uint64_t)))
+      return false;
+    const unsigned char *Start = Cur;
+    uint64_t N = endian::readNext<uint64_t, little, unaligned>(Cur);
+    uint64_t M = endian::readNext<uint64_t, little, unaligned>(Cur);
+    if (uint64_t(End - Cur) < N + M) {
+      Cur = Start;
+      return false;
+    }
+    Name = StringRef(reinterpret_cast<const char *>(Cur), N);
+    Data = StringRef(reinterpret_cast<const char *>(Cur + N), M);
+    Cur += N + M;
+    Record = StringRef(reinterpret_cast<const char *>(Start), Cur - Start);
+    return true;
+  }
+
+  /// Whether next() stopped before the end of the buffer.
+  bool isTruncated() const { return Cur != End; }
+
+  /// Call \p Callback on the hash, counters and value sites of each record
+  /// in \p Data.
+  static void forEachCounts(
+      StringRef Data,
+      function_ref<void(uint64_t, ArrayRef<uint64_t>,
+                        const std::vector<InstrProfValueSiteRecord> &)>
+          Callback) {
+    using namespace llvm::support;
+    const unsigned char *Cur = Data.bytes_begin(), *End = Data.bytes_end();
+    auto WordsLeft = [&]() { return uint64_t(End - Cur) / sizeof(uint64_t); };
+    auto Read = [&]() {
+      return endian::readNext<uint64_t, little, unaligned>(Cur);
+    };
+    SmallVector<uint64_t, 8> Counts;
+    std::vector<InstrProfValueSiteRecord> Sites;
+    while (WordsLeft() >= 3) {
+      uint64_t Hash = Read();
+      uint64_t NumCounts = Read();
+      if (WordsLeft() <= NumCounts)
+        return;
+      Counts.clear();
+      for (uint64_t I = 0; I < NumCounts; ++I)
+        Counts.push_back(Read());
+      uint64_t NumSites = Read();
+      Sites.clear();
+      for (uint64_t S = 0; S < NumSites; ++S) {
+        if (!WordsLeft())
+          return;
+        uint64_t NumValues = Read();
+        if (WordsLeft() / 2 < NumValues)
+          return;
+        Sites.emplace_back();
+        for (uint64_t V = 0; V < NumValues; ++V) {
+          uint64_t Value = Read();
+          Sites.back().push_back({Value, Read()});
+        }
+      }
+      Callback(Hash, Counts, Sites);
+    }
+  }
+};
+}
 
-  auto Where = CounterData.find(FunctionHash);
-  if (Where == CounterData.end()) {
+/// Create a temporary file for a spilled run, and an output stream for it.
+static std::error_code
+createSpillFile(const char *Prefix, std::vector<std::string> &Paths,
+                std::unique_ptr<raw_fd_ostream> &OS) {
+  int FD;
+  SmallString<128> Path;
+  if (std::error_code EC =
+          sys::fs::createTemporaryFile(Prefix, "tmp", FD, Path))
+    return EC;
+  Paths.push_back(Path.str());
+  OS.reset(new raw_fd_ostream(FD, /*shouldClose=*/true));
+  return std::error_code();
+}
+
+/// Close \p OS, returning an error if anything failed to be written.
+static std::error_code closeSpillFile(raw_fd_ostream &OS) {
+  OS.close();
+  if (!OS.has_error())
+    return std::error_code();
+  OS.clear_error();
+  return std::make_error_code(std::errc::io_error);
+}
+
+/// Merge \p Counters and \p Sites into the record of \p Data for
+/// \p FunctionHash.
+static std::error_code
+addCounts(InstrProfWriter::CounterData &Data, uint64_t FunctionHash,
+          ArrayRef<uint64_t> Counters,
+          const std::vector<InstrProfValueSiteRecord> &Sites,
+          uint64_t &MaxFunctionCount) {
+  auto Where = Data.find(FunctionHash);
+  if (Where == Data.end()) {
     // We've never seen a function with this name and hash, add it.
-    CounterData[FunctionHash] = Counters;
+    InstrProfWriter::ProfileRecord &Record = Data[FunctionHash];
+    Record.Counts = Counters;
+    Record.IndirectCallSites = Sites;
     // We keep track of the max function count as we go for simplicity.
     if (Counters[0] > MaxFunctionCount)
       MaxFunctionCount = Counters[0];
@@ -88,7 +244,7 @@ InstrProfWriter::addFunctionCounts(StringRef FunctionName,
   }
 
   // We're updating a function we've seen before.
-  auto &FoundCounters = Where->second;
+  auto &FoundCounters = Where->second.Counts;
   // If the number of counters doesn't match we either have bad data or a hash
   // collision.
   if (FoundCounters.size() != Counters.size())
@@ -103,15 +259,316 @@ InstrProfWriter::addFunctionCounts(StringRef FunctionName,
   if (FoundCounters[0] > MaxFunctionCount)
     MaxFunctionCount = FoundCounters[0];
 
-  return instrprof_error::success;
+  return mergeInstrProfValueSites(Where->second.IndirectCallSites, Sites);
 }
 
-std::pair<uint64_t, uint64_t> InstrProfWriter::writeImpl(raw_ostream &OS) {
-  OnDiskChainedHashTableGenerator<InstrProfRecordTrait> Generator;
+InstrProfWriter::~InstrProfWriter() { removeSpilledRuns(); }
 
-  // Populate the hash table generator.
-  for (const auto &I : FunctionData)
-    Generator.insert(I.getKey(), &I.getValue());
+void InstrProfWriter::setMemoryLimit(size_t Bytes, WarningHandlerTy Warn) {
+  MemoryLimit = Bytes;
+  SpillWarningHandler = std::move(Warn);
+}
+
+std::error_code InstrProfWriter::addFunctionCounts(
+    StringRef FunctionName, uint64_t FunctionHash, ArrayRef<uint64_t> Counters,
+    const std::vector<InstrProfValueSiteRecord> &IndirectCallSites) {
+  size_t NumFunctions = FunctionData.size();
+  auto &CounterData = FunctionData[FunctionName];
+  if (FunctionData.size() != NumFunctions)
+    MemoryUsed += sizeof(StringMapEntry<InstrProfWriter::CounterData>) +
+                  FunctionName.size() + 1;
+
+  size_t NumRecords = CounterData.size();
+  std::error_code EC = addCounts(CounterData, FunctionHash, Counters,
+                                 IndirectCallSites, MaxFunctionCount);
+  if (CounterData.size() == NumRecords)
+    return EC;
+
+  MemoryUsed += sizeof(InstrProfWriter::CounterData::value_type) +
+                Counters.size() * sizeof(uint64_t);
+  for (const InstrProfValueSiteRecord &Site : IndirectCallSites)
+    MemoryUsed += sizeof(Site) + Site.size() * sizeof(InstrProfValueData);
+  if (MemoryLimit && MemoryUsed > MemoryLimit && !SpillError)
+    SpillError = spill();
+  return EC;
+}
+
+void InstrProfWriter::mergeRecordsFromWriter(
+    InstrProfWriter &&IPW,
+    function_ref<void(StringRef, std::error_code)> Warn) {
+  // The spilled runs hold the oldest counts, merge them first.
+  for (const auto &Path : IPW.SpilledRuns) {
+    auto BufferOrErr = MemoryBuffer::getFile(Path, -1, false);
+    if (std::error_code EC = BufferOrErr.getError()) {
+      if (!SpillError)
+        SpillError = EC;
+      continue;
+    }
+    SpilledRunReader Run(std::move(BufferOrErr.get()));
+    while (Run.next())
+      SpilledRunReader::forEachCounts(
+          Run.Data,
+          [&](uint64_t Hash, ArrayRef<uint64_t> Counts,
+              const std::vector<InstrProfValueSiteRecord> &Sites) {
+            if (std::error_code EC =
+                    addFunctionCounts(Run.Name, Hash, Counts, Sites))
+              Warn(Run.Name, EC);
+          });
+    if (Run.isTruncated() && !SpillError)
+      SpillError = instrprof_error::malformed;
+  }
+  IPW.removeSpilledRuns();
+  if (IPW.SpillError && !SpillError)
+    SpillError = IPW.SpillError;
+
+  for (const auto &I : IPW.FunctionData)
+    for (const auto &Counts : I.getValue())
+      if (std::error_code EC =
+              addFunctionCounts(I.getKey(), Counts.first, Counts.second.Counts,
+                                Counts.second.IndirectCallSites))
+        Warn(I.getKey(), EC);
+  IPW.FunctionData.clear();
+  IPW.MaxFunctionCount = 0;
+  IPW.MemoryUsed = 0;
+}
+
+/// Return the functions of \p Map sorted by name.
+static std::vector<const StringMapEntry<InstrProfWriter::CounterData> *>
+getSortedFunctions(const StringMap<InstrProfWriter::CounterData> &Map) {
+  std::vector<const StringMapEntry<InstrProfWriter::CounterData> *> Functions;
+  Functions.reserve(Map.size());
+  for (const auto &I : Map)
+    Functions.push_back(&I);
+  std::sort(Functions.begin(), Functions.end(),
+            [](const StringMapEntry<InstrProfWriter::CounterData> *LHS,
+               const StringMapEntry<InstrProfWriter::CounterData> *RHS) {
+              return LHS->getKey() < RHS->getKey();
+            });
+  return Functions;
+}
+
+std::error_code InstrProfWriter::spill() {
+  std::unique_ptr<raw_fd_ostream> OS;
+  if (std::error_code EC = createSpillFile("instrprof-run", SpilledRuns, OS))
+    return EC;
+  for (const auto *I : getSortedFunctions(FunctionData))
+    emitRecord(*OS, I->getKey(), I->getValue());
+  if (std::error_code EC = closeSpillFile(*OS))
+    return EC;
+
+  FunctionData.clear();
+  MemoryUsed = 0;
+  return std::error_code();
+}
+
+void InstrProfWriter::removeSpilledRuns() {
+  for (const auto &Path : SpilledRuns)
+    sys::fs::remove(Path);
+  SpilledRuns.clear();
+}
+
+std::error_code InstrProfWriter::mergeSpilledRuns(uint64_t &NumFunctions) {
+  std::vector<std::unique_ptr<SpilledRunReader>> Runs;
+  for (const auto &Path : SpilledRuns) {
+    auto BufferOrErr = MemoryBuffer::getFile(Path, -1, false);
+    if (std::error_code EC = BufferOrErr.getError())
+      return EC;
+    Runs.emplace_back(new SpilledRunReader(std::move(BufferOrErr.get())));
+  }
+
+  // Pop the runs by function name and, for a given name, from the oldest run
+  // to the newest, so that the counts are merged in the order they were
+  // added in.
+  auto Later = [&](unsigned LHS, unsigned RHS) {
+    int Cmp = Runs[LHS]->Name.compare(Runs[RHS]->Name);
+    return Cmp > 0 || (Cmp == 0 && LHS > RHS);
+  };
+  std::priority_queue<unsigned, std::vector<unsigned>, decltype(Later)> Heads(
+      Later);
+  for (unsigned I = 0, E = Runs.size(); I < E; ++I)
+    if (Runs[I]->next())
+      Heads.push(I);
+
+  std::vector<std::string> MergedPaths;
+  std::unique_ptr<raw_fd_ostream> OS;
+  if (std::error_code EC = createSpillFile("instrprof-merged", MergedPaths, OS))
+    return EC;
+
+  NumFunctions = 0;
+  MaxFunctionCount = 0;
+  CounterData Data;
+  while (!Heads.empty()) {
+    // The run buffers stay alive until we're done, so this is stable.
+    StringRef Name = Runs[Heads.top()]->Name;
+    Data.clear();
+    while (!Heads.empty() && Runs[Heads.top()]->Name == Name) {
+      unsigned I = Heads.top();
+      Heads.pop();
+      SpilledRunReader::forEachCounts(
+          Runs[I]->Data,
+          [&](uint64_t Hash, ArrayRef<uint64_t> Counts,
+              const std::vector<InstrProfValueSiteRecord> &Sites) {
+            std::error_code EC =
+                addCounts(Data, Hash, Counts, Sites, MaxFunctionCount);
+            if (EC && SpillWarningHandler)
+              SpillWarningHandler(Name, EC);
+          });
+      if (Runs[I]->next())
+        Heads.push(I);
+    }
+    emitRecord(*OS, Name, Data);
+    ++NumFunctions;
+  }
+
+  std::error_code EC = closeSpillFile(*OS);
+  for (const auto &Run : Runs)
+    if (!EC && Run->isTruncated())
+      EC = instrprof_error::malformed;
+  Runs.clear();
+  removeSpilledRuns();
+  SpilledRuns = std::move(MergedPaths);
+  return EC;
+}
+
+ErrorOr<uint64_t> InstrProfWriter::emitMergedRun(raw_ostream &OS,
+                                                 uint64_t NumFunctions) {
+  assert(SpilledRuns.size() == 1 && "Spilled runs weren't merged");
+  using namespace llvm::support;
+  endian::Writer<little> LE(OS);
+
+  // Use the same load factor as OnDiskChainedHashTableGenerator.
+  uint64_t NumBuckets = 64;
+  while (4 * NumFunctions >= 3 * NumBuckets)
+    NumBuckets *= 2;
+
+  auto MergedOrErr = MemoryBuffer::getFile(SpilledRuns[0], -1, false);
+  if (std::error_code EC = MergedOrErr.getError())
+    return EC;
+  std::unique_ptr<MemoryBuffer> Merged = std::move(MergedOrErr.get());
+
+  // Distribute the functions over partitions of contiguous buckets that each
+  // fit in the memory budget, so that the buckets can be built one partition
+  // at a time and emitted in order.
+  uint64_t NumPartitions = 1;
+  if (MemoryLimit)
+    NumPartitions = std::min(
+        NumBuckets, NextPowerOf2(Merged->getBufferSize() / MemoryLimit));
+  uint64_t BucketsPerPartition = NumBuckets / NumPartitions;
+
+  std::vector<std::string> PartitionPaths;
+  if (NumPartitions > 1) {
+    std::vector<std::unique_ptr<raw_fd_ostream>> Partitions(NumPartitions);
+    std::error_code EC;
+    for (auto &Partition : Partitions)
+      if (!EC)
+        EC = createSpillFile("instrprof-part", PartitionPaths, Partition);
+    SpilledRunReader Run(std::move(Merged));
+    while (!EC && Run.next()) {
+      uint64_t Hash = InstrProfRecordTrait::ComputeHash(Run.Name);
+      *Partitions[(Hash & (NumBuckets - 1)) / BucketsPerPartition]
+          << Run.Record;
+    }
+    for (auto &Partition : Partitions)
+      if (Partition) {
+        std::error_code CloseEC = closeSpillFile(*Partition);
+        if (!EC)
+          EC = CloseEC;
+      }
+    SpilledRuns.insert(SpilledRuns.end(), PartitionPaths.begin(),
+                       PartitionPaths.end());
+    if (EC)
+      return EC;
+  }
+
+  std::vector<std::string> OffsetsPaths;
+  std::unique_ptr<raw_fd_ostream> OffsetsOS;
+  if (std::error_code EC =
+          createSpillFile("instrprof-offsets", OffsetsPaths, OffsetsOS))
+    return EC;
+  SpilledRuns.push_back(OffsetsPaths[0]);
+  endian::Writer<little> OffsetsLE(*OffsetsOS);
+
+  struct Entry {
+    uint64_t Hash;
+    StringRef Record;
+  };
+  std::vector<Entry> Entries;
+  std::vector<uint64_t> Offsets(BucketsPerPartition);
+  for (uint64_t P = 0; P < NumPartitions; ++P) {
+    if (NumPartitions > 1) {
+      auto BufferOrErr = MemoryBuffer::getFile(PartitionPaths[P], -1, false);
+      if (std::error_code EC = BufferOrErr.getError())
+        return EC;
+      Merged = std::move(BufferOrErr.get());
+    }
+
+    // The records are sorted by name, keep them that way within the buckets.
+    Entries.clear();
+    SpilledRunReader Run(std::move(Merged));
+    while (Run.next())
+      Entries.push_back({InstrProfRecordTrait::ComputeHash(Run.Name),
+                         Run.Record});
+    if (Run.isTruncated())
+      return instrprof_error::malformed;
+    std::stable_sort(Entries.begin(), Entries.end(),
+                     [&](const Entry &LHS, const Entry &RHS) {
+                       return (LHS.Hash & (NumBuckets - 1)) <
+                              (RHS.Hash & (NumBuckets - 1));
+                     });
+
+    std::fill(Offsets.begin(), Offsets.end(), 0);
+    for (size_t I = 0, E = Entries.size(); I != E;) {
+      uint64_t Bucket = Entries[I].Hash & (NumBuckets - 1);
+      size_t End = I + 1;
+      while (End != E && (Entries[End].Hash & (NumBuckets - 1)) == Bucket)
+        ++End;
+      assert(End - I <= UINT16_MAX && "Too many functions in a bucket");
+
+      Offsets[Bucket - P * BucketsPerPartition] = OS.tell();
+      LE.write<uint16_t>(End - I);
+      for (; I != End; ++I) {
+        LE.write<uint64_t>(Entries[I].Hash);
+        OS << Entries[I].Record;
+      }
+    }
+    for (uint64_t Offset : Offsets)
+      OffsetsLE.write<uint64_t>(Offset);
+  }
+  if (std::error_code EC = closeSpillFile(*OffsetsOS))
+    return EC;
+
+  // Pad with zeros so that the table starts at an aligned address.
+  uint64_t TableOff = OS.tell();
+  uint64_t N = OffsetToAlignment(TableOff, alignOf<uint64_t>());
+  TableOff += N;
+  while (N--)
+    LE.write<uint8_t>(0);
+
+  LE.write<uint64_t>(NumBuckets);
+  LE.write<uint64_t>(NumFunctions);
+  auto OffsetsOrErr = MemoryBuffer::getFile(OffsetsPaths[0], -1, false);
+  if (std::error_code EC = OffsetsOrErr.getError())
+    return EC;
+  OS << OffsetsOrErr.get()->getBuffer();
+
+  return TableOff;
+}
+
+ErrorOr<std::pair<uint64_t, uint64_t>>
+InstrProfWriter::writeImpl(raw_ostream &OS) {
+  if (SpillError)
+    return SpillError;
+
+  // Once something was spilled, everything goes through the runs.
+  bool Streaming = !SpilledRuns.empty();
+  uint64_t NumFunctions = 0;
+  if (Streaming) {
+    if (!FunctionData.empty())
+      if (std::error_code EC = spill())
+        return EC;
+    if (std::error_code EC = mergeSpilledRuns(NumFunctions))
+      return EC;
+  }
 
   using namespace llvm::support;
   endian::Writer<little> LE(OS);
@@ -125,20 +582,39 @@ std::pair<uint64_t, uint64_t> InstrProfWriter::writeImpl(raw_ostream &OS) {
   // Save a space to write the hash table start location.
   uint64_t HashTableStartLoc = OS.tell();
   LE.write<uint64_t>(0);
+
+  if (Streaming) {
+    ErrorOr<uint64_t> HashTableStart = emitMergedRun(OS, NumFunctions);
+    if (std::error_code EC = HashTableStart.getError())
+      return EC;
+    return std::make_pair(HashTableStartLoc, HashTableStart.get());
+  }
+
+  OnDiskChainedHashTableGenerator<InstrProfRecordTrait> Generator;
+
+  // Populate the hash table generator. Do it in name order: the layout of the
+  // StringMap depends on the insertion order, and the output should only
+  // depend on the profile data, not on the order the inputs were merged in.
+  for (const auto *I : getSortedFunctions(FunctionData))
+    Generator.insert(I->getKey(), &I->getValue());
+
   // Write the hash table.
   uint64_t HashTableStart = Generator.Emit(OS);
 
   return std::make_pair(HashTableStartLoc, HashTableStart);
 }
 
-void InstrProfWriter::write(raw_fd_ostream &OS) {
+std::error_code InstrProfWriter::write(raw_fd_ostream &OS) {
   // Write the hash table.
   auto TableStart = writeImpl(OS);
+  if (std::error_code EC = TableStart.getError())
+    return EC;
 
   // Go back and fill in the hash table start.
   using namespace support;
-  OS.seek(TableStart.first);
-  endian::Writer<little>(OS).write<uint64_t>(TableStart.second);
+  OS.seek(TableStart->first);
+  endian::Writer<little>(OS).write<uint64_t>(TableStart->second);
+  return std::error_code();
 }
 
 std::unique_ptr<MemoryBuffer> InstrProfWriter::writeBuffer() {
@@ -146,12 +622,14 @@ std::unique_ptr<MemoryBuffer> InstrProfWriter::writeBuffer() {
   llvm::raw_string_ostream OS(Data);
   // Write the hash table.
   auto TableStart = writeImpl(OS);
+  if (TableStart.getError())
+    return nullptr;
   OS.flush();
 
   // Go back and fill in the hash table start.
   using namespace support;
-  uint64_t Bytes = endian::byte_swap<uint64_t, little>(TableStart.second);
-  Data.replace(TableStart.first, sizeof(uint64_t), (const char *)&Bytes,
+  uint64_t Bytes = endian::byte_swap<uint64_t, little>(TableStart->second);
+  Data.replace(TableStart->first, sizeof(uint64_t), (const char *)&Bytes,
                sizeof(uint64_t));
 
   // Return this in an aligned memory buffer.
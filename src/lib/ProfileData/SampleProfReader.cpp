@@ -8,10 +8,11 @@
 //===----------------------------------------------------------------------===//
 //
 // This file implements the class that reads LLVM sample profiles. It
-// supports two file formats: text and binary. The textual representation
-// is useful for debugging and testing purposes. The binary representation
-// is more compact, resulting in smaller file sizes. However, they can
-// both be used interchangeably.
+// supports three file formats: text, binary and compact binary. The textual
+// representation is useful for debugging and testing purposes. The binary
+// representations are more compact, resulting in smaller file sizes, and the
+// compact binary representation can read the profile of each function on
+// demand. However, they can all be used interchangeably.
 //
 // NOTE: If you are making changes to the file format, please remember
 //       to document them in the Clang documentation at
@@ -29,6 +30,9 @@
 //     offset2[.discriminator]: number_of_samples [fn3:num fn4:num ... ]
 //     ...
 //     offsetN[.discriminator]: number_of_samples [fn5:num fn6:num ... ]
+//     offsetA[.discriminator]: fnA:num_of_total_samples
+//      offsetA1[.discriminator]: number_of_samples [fn7:num fn8:num ... ]
+//      ...
 //
 // The file may contain blank lines between sections and within a
 // section. However, the spacing within a single line is fixed. Additional
@@ -92,6 +96,22 @@
 //    instruction that calls one of ``foo()``, ``bar()`` and ``baz()``,
 //    with ``baz()`` being the relatively more frequently called target.
 //
+// e. [OPTIONAL] Inlined call site. A line with a function name in place of
+//    the number of samples marks a call site at which the named function
+//    was inlined in the profiled binary, with the total number of samples
+//    of the inlined instance. The lines that follow it, indented by one
+//    more space, are the samples of the inlined instance, relative to the
+//    start of the inlined function. They may contain inlined call sites of
+//    their own. For example,
+//
+//      10: foo:30
+//       1: 20
+//       2: bar:10
+//        1: 10
+//
+//    The above means that ``foo()`` was inlined at relative line offset 10,
+//    and that ``bar()`` was inlined into it at offset 2 of ``foo()``.
+//
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ProfileData/SampleProfReader.h"
@@ -108,15 +128,16 @@ using namespace llvm;
 /// \brief Print the samples collected for a function on stream \p OS.
 ///
 /// \param OS Stream to emit the output to.
-void FunctionSamples::print(raw_ostream &OS) {
+/// \param Indent Number of tabs to indent the body of the function with.
+void FunctionSamples::print(raw_ostream &OS, unsigned Indent) const {
   OS << TotalSamples << ", " << TotalHeadSamples << ", " << BodySamples.size()
      << " sampled lines\n";
   for (const auto &SI : BodySamples) {
     LineLocation Loc = SI.first;
     const SampleRecord &Sample = SI.second;
-    OS << "\tline offset: " << Loc.LineOffset
-       << ", discriminator: " << Loc.Discriminator
-       << ", number of samples: " << Sample.getSamples();
+    OS.indent(Indent) << "\tline offset: " << Loc.LineOffset
+                      << ", discriminator: " << Loc.Discriminator
+                      << ", number of samples: " << Sample.getSamples();
     if (Sample.hasCalls()) {
       OS << ", calls:";
       for (const auto &I : Sample.getCallTargets())
@@ -124,7 +145,15 @@ void FunctionSamples::print(raw_ostream &OS) {
     }
     OS << "\n";
   }
-  OS << "\n";
+  for (const auto &CS : CallsiteSamples) {
+    CallsiteLocation Loc = CS.first;
+    OS.indent(Indent) << "\tline offset: " << Loc.LineOffset
+                      << ", discriminator: " << Loc.Discriminator
+                      << ", inlined callee: " << Loc.CalleeName << ": ";
+    CS.second.print(OS, Indent + 2);
+  }
+  if (!Indent)
+    OS << "\n";
 }
 
 /// \brief Dump the function profile for \p FName.
@@ -155,9 +184,10 @@ std::error_code SampleProfileReaderText::read() {
   // Read the profile of each function. Since each function may be
   // mentioned more than once, and we are collecting flat profiles,
   // accumulate samples as we parse them.
-  Regex HeadRE("^([^0-9].*):([0-9]+):([0-9]+)$");
+  Regex HeadRE("^([^0-9 ].*):([0-9]+):([0-9]+)$");
   Regex LineSampleRE("^([0-9]+)\\.?([0-9]+)?: ([0-9]+)(.*)$");
   Regex CallSampleRE(" +([^0-9 ][^ ]*):([0-9]+)");
+  Regex CallsiteRE("^([0-9]+)\\.?([0-9]+)?: ([^0-9 ][^ ]*):([0-9]+)$");
   while (!LineIt.is_at_eof()) {
     // Read the header of each function.
     //
@@ -189,9 +219,38 @@ std::error_code SampleProfileReaderText::read() {
     ++LineIt;
 
     // Now read the body. The body of the function ends when we reach
-    // EOF or when we see the start of the next function.
-    while (!LineIt.is_at_eof() && isdigit((*LineIt)[0])) {
-      if (!LineSampleRE.match(*LineIt, &Matches)) {
+    // EOF or when we see the start of the next function. The samples of
+    // inlined call sites are indented by one space for each level of
+    // inlining, and InlineStack holds the profile of each level.
+    SmallVector<FunctionSamples *, 4> InlineStack(1, &FProfile);
+    while (!LineIt.is_at_eof() &&
+           (isdigit((*LineIt)[0]) || (*LineIt)[0] == ' ')) {
+      StringRef Line = LineIt->ltrim(" ");
+      size_t Depth = LineIt->size() - Line.size();
+      if (Depth >= InlineStack.size()) {
+        reportParseError(LineIt.line_number(),
+                         "Unexpected indentation, found " + *LineIt);
+        return sampleprof_error::malformed;
+      }
+      InlineStack.resize(Depth + 1);
+      FunctionSamples &Samples = *InlineStack.back();
+
+      if (CallsiteRE.match(Line, &Matches)) {
+        assert(Matches.size() == 5);
+        unsigned LineOffset, NumSamples, Discriminator = 0;
+        Matches[1].getAsInteger(10, LineOffset);
+        if (Matches[2] != "")
+          Matches[2].getAsInteger(10, Discriminator);
+        Matches[4].getAsInteger(10, NumSamples);
+        FunctionSamples &CalleeSamples = Samples.functionSamplesAt(
+            CallsiteLocation(LineOffset, Discriminator, Matches[3]));
+        CalleeSamples.addTotalSamples(NumSamples);
+        InlineStack.push_back(&CalleeSamples);
+        ++LineIt;
+        continue;
+      }
+
+      if (!LineSampleRE.match(Line, &Matches)) {
         reportParseError(
             LineIt.line_number(),
             "Expected 'NUM[.NUM]: NUM[ mangled_name:NUM]*', found " + *LineIt);
@@ -217,12 +276,12 @@ std::error_code SampleProfileReaderText::read() {
         StringRef CalledFunction = CallSample[1];
         unsigned CalledFunctionSamples;
         CallSample[2].getAsInteger(10, CalledFunctionSamples);
-        FProfile.addCalledTargetSamples(LineOffset, Discriminator,
-                                        CalledFunction, CalledFunctionSamples);
+        Samples.addCalledTargetSamples(LineOffset, Discriminator,
+                                       CalledFunction, CalledFunctionSamples);
         CallsLine = CallSampleRE.sub("", CallsLine);
       }
 
-      FProfile.addBodySamples(LineOffset, Discriminator, NumSamples);
+      Samples.addBodySamples(LineOffset, Discriminator, NumSamples);
       ++LineIt;
     }
   }
@@ -264,88 +323,125 @@ ErrorOr<StringRef> SampleProfileReaderBinary::readString() {
   return Str;
 }
 
-std::error_code SampleProfileReaderBinary::read() {
-  while (!at_eof()) {
-    auto FName(readString());
-    if (std::error_code EC = FName.getError())
-      return EC;
+std::error_code
+SampleProfileReaderBinary::readProfile(FunctionSamples &FProfile) {
+  auto Val = readNumber<unsigned>();
+  if (std::error_code EC = Val.getError())
+    return EC;
+  FProfile.addTotalSamples(*Val);
 
-    Profiles[*FName] = FunctionSamples();
-    FunctionSamples &FProfile = Profiles[*FName];
+  Val = readNumber<unsigned>();
+  if (std::error_code EC = Val.getError())
+    return EC;
+  FProfile.addHeadSamples(*Val);
 
-    auto Val = readNumber<unsigned>();
-    if (std::error_code EC = Val.getError())
+  // Read the samples in the body.
+  auto NumRecords = readNumber<unsigned>();
+  if (std::error_code EC = NumRecords.getError())
+    return EC;
+  for (unsigned I = 0; I < *NumRecords; ++I) {
+    auto LineOffset = readNumber<uint64_t>();
+    if (std::error_code EC = LineOffset.getError())
       return EC;
-    FProfile.addTotalSamples(*Val);
 
-    Val = readNumber<unsigned>();
-    if (std::error_code EC = Val.getError())
+    auto Discriminator = readNumber<uint64_t>();
+    if (std::error_code EC = Discriminator.getError())
       return EC;
-    FProfile.addHeadSamples(*Val);
 
-    // Read the samples in the body.
-    auto NumRecords = readNumber<unsigned>();
-    if (std::error_code EC = NumRecords.getError())
+    auto NumSamples = readNumber<uint64_t>();
+    if (std::error_code EC = NumSamples.getError())
       return EC;
-    for (unsigned I = 0; I < *NumRecords; ++I) {
-      auto LineOffset = readNumber<uint64_t>();
-      if (std::error_code EC = LineOffset.getError())
-        return EC;
 
-      auto Discriminator = readNumber<uint64_t>();
-      if (std::error_code EC = Discriminator.getError())
-        return EC;
+    auto NumCalls = readNumber<unsigned>();
+    if (std::error_code EC = NumCalls.getError())
+      return EC;
 
-      auto NumSamples = readNumber<uint64_t>();
-      if (std::error_code EC = NumSamples.getError())
+    for (unsigned J = 0; J < *NumCalls; ++J) {
+      auto CalledFunction(readName());
+      if (std::error_code EC = CalledFunction.getError())
         return EC;
 
-      auto NumCalls = readNumber<unsigned>();
-      if (std::error_code EC = NumCalls.getError())
+      auto CalledFunctionSamples = readNumber<uint64_t>();
+      if (std::error_code EC = CalledFunctionSamples.getError())
         return EC;
 
-      for (unsigned J = 0; J < *NumCalls; ++J) {
-        auto CalledFunction(readString());
-        if (std::error_code EC = CalledFunction.getError())
-          return EC;
+      FProfile.addCalledTargetSamples(*LineOffset, *Discriminator,
+                                      *CalledFunction, *CalledFunctionSamples);
+    }
 
-        auto CalledFunctionSamples = readNumber<uint64_t>();
-        if (std::error_code EC = CalledFunctionSamples.getError())
-          return EC;
+    FProfile.addBodySamples(*LineOffset, *Discriminator, *NumSamples);
+  }
 
-        FProfile.addCalledTargetSamples(*LineOffset, *Discriminator,
-                                        *CalledFunction,
-                                        *CalledFunctionSamples);
-      }
+  // Version 100 has no inlined call sites.
+  if (Version < 101)
+    return sampleprof_error::success;
 
-      FProfile.addBodySamples(*LineOffset, *Discriminator, *NumSamples);
-    }
+  // Read the samples of the inlined call sites.
+  auto NumCallsites = readNumber<unsigned>();
+  if (std::error_code EC = NumCallsites.getError())
+    return EC;
+  for (unsigned I = 0; I < *NumCallsites; ++I) {
+    auto LineOffset = readNumber<uint64_t>();
+    if (std::error_code EC = LineOffset.getError())
+      return EC;
+
+    auto Discriminator = readNumber<uint64_t>();
+    if (std::error_code EC = Discriminator.getError())
+      return EC;
+
+    auto FName(readName());
+    if (std::error_code EC = FName.getError())
+      return EC;
+
+    FunctionSamples &CalleeProfile = FProfile.functionSamplesAt(
+        CallsiteLocation(*LineOffset, *Discriminator, *FName));
+    if (std::error_code EC = readProfile(CalleeProfile))
+      return EC;
   }
 
   return sampleprof_error::success;
 }
 
-std::error_code SampleProfileReaderBinary::readHeader() {
+std::error_code SampleProfileReaderBinary::read() {
+  while (!at_eof()) {
+    auto FName(readString());
+    if (std::error_code EC = FName.getError())
+      return EC;
+
+    Profiles[*FName] = FunctionSamples();
+    if (std::error_code EC = readProfile(Profiles[*FName]))
+      return EC;
+  }
+
+  return sampleprof_error::success;
+}
+
+std::error_code SampleProfileReaderBinary::readMagicAndVersion(uint64_t Magic) {
   Data = reinterpret_cast<const uint8_t *>(Buffer->getBufferStart());
   End = Data + Buffer->getBufferSize();
 
   // Read and check the magic identifier.
-  auto Magic = readNumber<uint64_t>();
-  if (std::error_code EC = Magic.getError())
+  auto FileMagic = readNumber<uint64_t>();
+  if (std::error_code EC = FileMagic.getError())
     return EC;
-  else if (*Magic != SPMagic())
+  else if (*FileMagic != Magic)
     return sampleprof_error::bad_magic;
 
   // Read the version number.
-  auto Version = readNumber<uint64_t>();
-  if (std::error_code EC = Version.getError())
+  auto FileVersion = readNumber<uint64_t>();
+  if (std::error_code EC = FileVersion.getError())
     return EC;
-  else if (*Version != SPVersion())
+  else if (*FileVersion < 100 || *FileVersion > SPVersion())
     return sampleprof_error::unsupported_version;
+  Version = *FileVersion;
 
   return sampleprof_error::success;
 }
 
+std::error_code SampleProfileReaderBinary::readHeader() {
+  return readMagicAndVersion(SPMagic());
+}
+
 bool SampleProfileReaderBinary::hasFormat(const MemoryBuffer &Buffer) {
   const uint8_t *Data =
       reinterpret_cast<const uint8_t *>(Buffer.getBufferStart());
@@ -353,6 +449,101 @@ bool SampleProfileReaderBinary::hasFormat(const MemoryBuffer &Buffer) {
   return Magic == SPMagic();
 }
 
+ErrorOr<StringRef> SampleProfileReaderCompactBinary::readName() {
+  auto Idx = readNumber<size_t>();
+  if (std::error_code EC = Idx.getError())
+    return EC;
+  if (*Idx >= NameTable.size()) {
+    reportParseError(0, "Name index out of range");
+    return sampleprof_error::malformed;
+  }
+  return NameTable[*Idx];
+}
+
+std::error_code SampleProfileReaderCompactBinary::readHeader() {
+  if (std::error_code EC = readMagicAndVersion(SPCompactMagic()))
+    return EC;
+
+  // Read the name table.
+  auto NumNames = readNumber<size_t>();
+  if (std::error_code EC = NumNames.getError())
+    return EC;
+  NameTable.reserve(*NumNames);
+  for (size_t I = 0; I < *NumNames; ++I) {
+    auto Name(readString());
+    if (std::error_code EC = Name.getError())
+      return EC;
+    NameTable.push_back(*Name);
+  }
+
+  // Read the function index. The offsets are relative to the start of the
+  // records, which follow the index.
+  auto NumFuncs = readNumber<size_t>();
+  if (std::error_code EC = NumFuncs.getError())
+    return EC;
+  std::vector<std::pair<StringRef, uint64_t>> Index;
+  Index.reserve(*NumFuncs);
+  for (size_t I = 0; I < *NumFuncs; ++I) {
+    auto FName(readName());
+    if (std::error_code EC = FName.getError())
+      return EC;
+
+    auto Offset = readNumber<uint64_t>();
+    if (std::error_code EC = Offset.getError())
+      return EC;
+    Index.push_back(std::make_pair(*FName, *Offset));
+  }
+
+  Records = Data;
+  for (const auto &I : Index) {
+    if (I.second >= uint64_t(End - Records)) {
+      reportParseError(0, "Function offset out of range");
+      return sampleprof_error::malformed;
+    }
+    FuncOffsets[I.first] = I.second;
+  }
+
+  return sampleprof_error::success;
+}
+
+std::error_code
+SampleProfileReaderCompactBinary::readFunction(StringRef FName,
+                                               uint64_t Offset) {
+  Data = Records + Offset;
+  Profiles[FName] = FunctionSamples();
+  return readProfile(Profiles[FName]);
+}
+
+std::error_code SampleProfileReaderCompactBinary::read() {
+  for (const auto &I : FuncOffsets)
+    if (std::error_code EC = readFunction(I.getKey(), I.getValue()))
+      return EC;
+  FuncOffsets.clear();
+
+  return sampleprof_error::success;
+}
+
+FunctionSamples *
+SampleProfileReaderCompactBinary::getSamplesFor(StringRef FName) {
+  auto I = FuncOffsets.find(FName);
+  if (I != FuncOffsets.end()) {
+    // Read the profile the first time it is asked for. A malformed profile
+    // is dropped, so that the function is compiled without one.
+    uint64_t Offset = I->getValue();
+    FuncOffsets.erase(I);
+    if (readFunction(FName, Offset))
+      Profiles[FName] = FunctionSamples();
+  }
+  return &Profiles[FName];
+}
+
+bool SampleProfileReaderCompactBinary::hasFormat(const MemoryBuffer &Buffer) {
+  const uint8_t *Data =
+      reinterpret_cast<const uint8_t *>(Buffer.getBufferStart());
+  uint64_t Magic = decodeULEB128(Data);
+  return Magic == SPCompactMagic();
+}
+
 /// \brief Prepare a memory buffer for the contents of \p Filename.
 ///
 /// \returns an error code indicating the status of the buffer.
@@ -387,7 +578,9 @@ SampleProfileReader::create(StringRef Filename, LLVMContext &C) {
 
   auto Buffer = std::move(BufferOrError.get());
   std::unique_ptr<SampleProfileReader> Reader;
-  if (SampleProfileReaderBinary::hasFormat(*Buffer))
+  if (SampleProfileReaderCompactBinary::hasFormat(*Buffer))
+    Reader.reset(new SampleProfileReaderCompactBinary(std::move(Buffer), C));
+  else if (SampleProfileReaderBinary::hasFormat(*Buffer))
     Reader.reset(new SampleProfileReaderBinary(std::move(Buffer), C));
   else
     Reader.reset(new SampleProfileReaderText(std::move(Buffer), C));
@@ -8,10 +8,10 @@
 //===----------------------------------------------------------------------===//
 //
 // This file implements the class that writes LLVM sample profiles. It
-// supports two file formats: text and binary. The textual representation
-// is useful for debugging and testing purposes. The binary representation
-// is more compact, resulting in smaller file sizes. However, they can
-// both be used interchangeably.
+// supports three file formats: text, binary and compact binary. The textual
+// representation is useful for debugging and testing purposes. The binary
+// representations are more compact, resulting in smaller file sizes. However,
+// they can all be used interchangeably.
 //
 // See lib/ProfileData/SampleProfReader.cpp for documentation on each of the
 // supported formats.
@@ -36,10 +36,17 @@ bool SampleProfileWriterText::write(StringRef FName, const FunctionSamples &S) {
 
   OS << FName << ":" << S.getTotalSamples() << ":" << S.getHeadSamples()
      << "\n";
+  writeBody(S, 0);
 
+  return true;
+}
+
+void SampleProfileWriterText::writeBody(const FunctionSamples &S,
+                                        unsigned Indent) {
   for (const auto &I : S.getBodySamples()) {
     LineLocation Loc = I.first;
     const SampleRecord &Sample = I.second;
+    OS.indent(Indent);
     if (Loc.Discriminator == 0)
       OS << Loc.LineOffset << ": ";
     else
@@ -52,20 +59,69 @@ bool SampleProfileWriterText::write(StringRef FName, const FunctionSamples &S) {
     OS << "\n";
   }
 
-  return true;
+  for (const auto &I : S.getCallsiteSamples()) {
+    CallsiteLocation Loc = I.first;
+    const FunctionSamples &CalleeSamples = I.second;
+    OS.indent(Indent);
+    if (Loc.Discriminator == 0)
+      OS << Loc.LineOffset << ": ";
+    else
+      OS << Loc.LineOffset << "." << Loc.Discriminator << ": ";
+    OS << Loc.CalleeName << ":" << CalleeSamples.getTotalSamples() << "\n";
+    writeBody(CalleeSamples, Indent + 1);
+  }
 }
 
 SampleProfileWriterBinary::SampleProfileWriterBinary(StringRef F,
                                                      std::error_code &EC)
+    : SampleProfileWriterBinary(F, EC, SPMagic()) {}
+
+SampleProfileWriterBinary::SampleProfileWriterBinary(StringRef F,
+                                                     std::error_code &EC,
+                                                     uint64_t Magic)
     : SampleProfileWriter(F, EC, sys::fs::F_None) {
   if (EC)
     return;
 
   // Write the file header.
-  encodeULEB128(SPMagic(), OS);
+  encodeULEB128(Magic, OS);
   encodeULEB128(SPVersion(), OS);
 }
 
+void SampleProfileWriterBinary::writeName(raw_ostream &Out, StringRef Name) {
+  Out << Name;
+  encodeULEB128(0, Out);
+}
+
+void SampleProfileWriterBinary::writeBody(raw_ostream &Out,
+                                          const FunctionSamples &S) {
+  encodeULEB128(S.getTotalSamples(), Out);
+  encodeULEB128(S.getHeadSamples(), Out);
+  encodeULEB128(S.getBodySamples().size(), Out);
+  for (const auto &I : S.getBodySamples()) {
+    LineLocation Loc = I.first;
+    const SampleRecord &Sample = I.second;
+    encodeULEB128(Loc.LineOffset, Out);
+    encodeULEB128(Loc.Discriminator, Out);
+    encodeULEB128(Sample.getSamples(), Out);
+    encodeULEB128(Sample.getCallTargets().size(), Out);
+    for (const auto &J : Sample.getCallTargets()) {
+      writeName(Out, J.first());
+      encodeULEB128(J.second, Out);
+    }
+  }
+
+  // Recursively write the samples of the inlined call sites.
+  encodeULEB128(S.getCallsiteSamples().size(), Out);
+  for (const auto &I : S.getCallsiteSamples()) {
+    CallsiteLocation Loc = I.first;
+    encodeULEB128(Loc.LineOffset, Out);
+    encodeULEB128(Loc.Discriminator, Out);
+    writeName(Out, Loc.CalleeName);
+    writeBody(Out, I.second);
+  }
+}
+
 /// \brief Write samples to a binary file.
 ///
 /// \returns true if the samples were written successfully, false otherwise.
@@ -76,28 +132,60 @@ bool SampleProfileWriterBinary::write(StringRef FName,
 
   OS << FName;
   encodeULEB128(0, OS);
-  encodeULEB128(S.getTotalSamples(), OS);
-  encodeULEB128(S.getHeadSamples(), OS);
-  encodeULEB128(S.getBodySamples().size(), OS);
-  for (const auto &I : S.getBodySamples()) {
-    LineLocation Loc = I.first;
-    const SampleRecord &Sample = I.second;
-    encodeULEB128(Loc.LineOffset, OS);
-    encodeULEB128(Loc.Discriminator, OS);
-    encodeULEB128(Sample.getSamples(), OS);
-    encodeULEB128(Sample.getCallTargets().size(), OS);
-    for (const auto &J : Sample.getCallTargets()) {
-      std::string Callee = J.first();
-      unsigned CalleeSamples = J.second;
-      OS << Callee;
-      encodeULEB128(0, OS);
-      encodeULEB128(CalleeSamples, OS);
-    }
-  }
+  writeBody(OS, S);
 
   return true;
 }
 
+uint64_t SampleProfileWriterCompactBinary::getNameIndex(StringRef Name) {
+  auto Inserted = NameIndices.insert(std::make_pair(Name, NameTable.size()));
+  if (Inserted.second)
+    NameTable.push_back(Inserted.first->getKey());
+  return Inserted.first->getValue();
+}
+
+void SampleProfileWriterCompactBinary::writeName(raw_ostream &Out,
+                                                 StringRef Name) {
+  encodeULEB128(getNameIndex(Name), Out);
+}
+
+/// \brief Buffer the samples of \p FName until the file is finalized.
+///
+/// \returns true if the samples were written successfully, false otherwise.
+bool SampleProfileWriterCompactBinary::write(StringRef FName,
+                                             const FunctionSamples &S) {
+  if (S.empty())
+    return true;
+
+  FuncIndex.push_back(std::make_pair(getNameIndex(FName), RecordsOS.tell()));
+  writeBody(RecordsOS, S);
+
+  return true;
+}
+
+/// \brief Write the name table, the function index and the records.
+///
+/// \returns true if the file was written successfully, false otherwise.
+bool SampleProfileWriterCompactBinary::finalize() {
+  encodeULEB128(NameTable.size(), OS);
+  for (StringRef Name : NameTable) {
+    OS << Name;
+    encodeULEB128(0, OS);
+  }
+
+  encodeULEB128(FuncIndex.size(), OS);
+  for (const auto &I : FuncIndex) {
+    encodeULEB128(I.first, OS);
+    encodeULEB128(I.second, OS);
+  }
+
+  OS << RecordsOS.str();
+  Records.clear();
+  FuncIndex.clear();
+
+  return !OS.has_error();
+}
+
 /// \brief Create a sample profile writer based on the specified format.
 ///
 /// \param Filename The file to create.
@@ -114,6 +202,8 @@ SampleProfileWriter::create(StringRef Filename, SampleProfileFormat Format) {
 
   if (Format == SPF_Binary)
     Writer.reset(new SampleProfileWriterBinary(Filename, EC));
+  else if (Format == SPF_Compact)
+    Writer.reset(new SampleProfileWriterCompactBinary(Filename, EC));
   else if (Format == SPF_Text)
     Writer.reset(new SampleProfileWriterText(Filename, EC));
   else
@@ -20,8 +20,10 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
+#include <cfloat>
 #include <cstring>
 #include <limits.h>
+#include <limits>
 
 using namespace llvm;
 
@@ -1668,10 +1670,157 @@ APFloat::addOrSubtract(const APFloat &rhs, roundingMode rounding_mode,
   return fs;
 }
 
+/* Whether the host's float and double are IEEE single and double, and
+   evaluating an operation on them rounds it once, to their own precision.
+   An x87, for one, rounds to its wider format first.  The host is assumed
+   to round to nearest, ties to even, as it does unless told otherwise.  */
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+static const bool hostMatchesIEEE = std::numeric_limits<float>::is_iec559 &&
+                                    std::numeric_limits<double>::is_iec559;
+#else
+static const bool hostMatchesIEEE = false;
+#endif
+
+namespace {
+  enum hostOperation { hostAdd, hostSubtract, hostMultiply, hostDivide };
+}
+
+/* The rounding error of s = a + b, exactly.  */
+template<typename T>
+static T
+sumError(T a, T b, T s)
+{
+  T bb = s - a;
+
+  return (a - (s - bb)) + (b - bb);
+}
+
+/* The rounding error of p = a * b, exactly, as long as none of the partial
+   products overflows or underflows.  */
+static double
+productError(double a, double b, double p)
+{
+  /* Split each factor in two halves of 26 bits, whose products are exact.  */
+  double c = 134217729.0 * a;  /* 2^27 + 1 */
+  double ah = c - (c - a), al = a - ah;
+  c = 134217729.0 * b;
+  double bh = c - (c - b), bl = b - bh;
+
+  return ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+}
+
+/* Compute an operation in the host's arithmetic, returning whether it was
+   inexact.  Both operands are zero or normal and their exponents are at
+   most 62 for single and 300 for double.  Then neither the result nor any
+   step of checking it can overflow, underflow or be a denormal.  */
+static bool
+computeOnHost(float a, float b, hostOperation op, float &r)
+{
+  double p;
+
+  switch (op) {
+  case hostAdd:
+    r = a + b;
+    return sumError(a, b, r) != 0;
+  case hostSubtract:
+    r = a - b;
+    return sumError(a, -b, r) != 0;
+  case hostMultiply:
+    /* The product of two singles is exact in double.  */
+    p = (double) a * b;
+    r = (float) p;
+    return r != p;
+  case hostDivide:
+    r = a / b;
+    return (double) r * b != a;
+  }
+  llvm_unreachable("Unknown host operation");
+}
+
+static bool
+computeOnHost(double a, double b, hostOperation op, double &r)
+{
+  double p;
+
+  switch (op) {
+  case hostAdd:
+    r = a + b;
+    return sumError(a, b, r) != 0;
+  case hostSubtract:
+    r = a - b;
+    return sumError(a, -b, r) != 0;
+  case hostMultiply:
+    r = a * b;
+    return productError(a, b, r) != 0;
+  case hostDivide:
+    /* Exact if and only if r * b is exactly a.  */
+    r = a / b;
+    p = r * b;
+    return p != a || productError(r, b, p) != 0;
+  }
+  llvm_unreachable("Unknown host operation");
+}
+
+static bool
+fitsOnHost(const APFloat &x, int maxExponent)
+{
+  if (x.isZero())
+    return true;
+  if (!x.isFiniteNonZero())
+    return false;
+
+  int exp = ilogb(x);
+
+  return exp <= maxExponent && exp >= -maxExponent;
+}
+
+/* Most constant folding is of IEEE single and double values of moderate
+   magnitude, rounding to nearest.  The host computes those faster than the
+   multi-precision code, with the same results.  Returns false, leaving lhs
+   alone, for the operations it can't do.  */
+static bool
+operateOnHost(APFloat &lhs, const APFloat &rhs,
+              APFloat::roundingMode rounding_mode, hostOperation op,
+              APFloat::opStatus &fs)
+{
+  if (!hostMatchesIEEE || rounding_mode != APFloat::rmNearestTiesToEven)
+    return false;
+  if (&lhs.getSemantics() != &rhs.getSemantics())
+    return false;
+  if (op == hostDivide && rhs.isZero())
+    return false;
+
+  bool inexact;
+  if (&lhs.getSemantics() == &APFloat::IEEEsingle) {
+    if (!fitsOnHost(lhs, 62) || !fitsOnHost(rhs, 62))
+      return false;
+    float r;
+    inexact = computeOnHost(lhs.convertToFloat(), rhs.convertToFloat(), op, r);
+    lhs = APFloat(r);
+  } else if (&lhs.getSemantics() == &APFloat::IEEEdouble) {
+    if (!fitsOnHost(lhs, 300) || !fitsOnHost(rhs, 300))
+      return false;
+    double r;
+    inexact =
+        computeOnHost(lhs.convertToDouble(), rhs.convertToDouble(), op, r);
+    lhs = APFloat(r);
+  } else {
+    return false;
+  }
+
+  fs = inexact ? APFloat::opInexact : APFloat::opOK;
+  return true;
+}
+
 /* Normalized addition.  */
 APFloat::opStatus
 APFloat::add(const APFloat &rhs, roundingMode rounding_mode)
 {
+  opStatus fs;
+
+  if (operateOnHost(*this, rhs, rounding_mode, hostAdd, fs))
+    return fs;
+
   return addOrSubtract(rhs, rounding_mode, false);
 }
 
@@ -1679,6 +1828,11 @@ APFloat::add(const APFloat &rhs, roundingMode rounding_mode)
 APFloat::opStatus
 APFloat::subtract(const APFloat &rhs, roundingMode rounding_mode)
 {
+  opStatus fs;
+
+  if (operateOnHost(*this, rhs, rounding_mode, hostSubtract, fs))
+    return fs;
+
   return addOrSubtract(rhs, rounding_mode, true);
 }
 
@@ -1688,6 +1842,9 @@ APFloat::multiply(const APFloat &rhs, roundingMode rounding_mode)
 {
   opStatus fs;
 
+  if (operateOnHost(*this, rhs, rounding_mode, hostMultiply, fs))
+    return fs;
+
   sign ^= rhs.sign;
   fs = multiplySpecials(rhs);
 
@@ -1707,6 +1864,9 @@ APFloat::divide(const APFloat &rhs, roundingMode rounding_mode)
 {
   opStatus fs;
 
+  if (operateOnHost(*this, rhs, rounding_mode, hostDivide, fs))
+    return fs;
+
   sign ^= rhs.sign;
   fs = divideSpecials(rhs);
 
@@ -0,0 +1,116 @@
+//===-CachePruning.cpp - LLVM Cache Directory Pruning ---------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the pruning of a directory based on least recently
+// used.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/CachePruning.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/TimeValue.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#define DEBUG_TYPE "cache-pruning"
+
+using namespace llvm;
+
+/// Write a new timestamp file with the given path. This is used for the
+/// pruning interval option.
+static void writeTimestampFile(StringRef TimestampFile) {
+  std::error_code EC;
+  raw_fd_ostream Out(TimestampFile.str(), EC, sys::fs::F_None);
+}
+
+bool CachePruning::prune() {
+  if (Path.empty() || Interval < 0)
+    return false;
+
+  if (!sys::fs::is_directory(Path))
+    return false;
+
+  SmallString<128> TimestampFile(Path);
+  sys::path::append(TimestampFile, getTimestampFileName());
+
+  sys::TimeValue CurrentTime = sys::TimeValue::now();
+  if (Interval) {
+    // Check whether the time stamp is older than our pruning interval.
+    // If not, do nothing.
+    sys::fs::file_status FileStatus;
+    if (!sys::fs::status(TimestampFile.str(), FileStatus)) {
+      sys::TimeValue TimeStampModTime = FileStatus.getLastModificationTime();
+      auto TimeInterval = CurrentTime.seconds() - TimeStampModTime.seconds();
+      if (TimeInterval < Interval) {
+        DEBUG(dbgs() << "Timestamp file too recent (" << TimeInterval
+                     << "s), skip pruning\n");
+        return false;
+      }
+    }
+  }
+  // Write a new timestamp file so that nobody else attempts to prune.
+  writeTimestampFile(TimestampFile);
+
+  bool ShouldComputeSize = MaxSize > 0;
+
+  // The entries that weren't expired, with their last use time and size.
+  typedef std::tuple<sys::TimeValue, uint64_t, std::string> EntryTy;
+  std::vector<EntryTy> Entries;
+  uint64_t TotalSize = 0;
+
+  std::error_code EC;
+  for (sys::fs::directory_iterator File(Path, EC), FileEnd;
+       File != FileEnd && !EC; File.increment(EC)) {
+    if (sys::path::filename(File->path()) == getTimestampFileName())
+      continue;
+
+    sys::fs::file_status FileStatus;
+    if (File->status(FileStatus) ||
+        FileStatus.type() != sys::fs::file_type::regular_file)
+      continue;
+
+    // If the file hasn't been used recently enough, delete it.
+    sys::TimeValue FileModTime = FileStatus.getLastModificationTime();
+    auto TimeDiff = CurrentTime.seconds() - FileModTime.seconds();
+    if (Expiration && TimeDiff > Expiration) {
+      DEBUG(dbgs() << "Remove " << File->path() << " (" << TimeDiff
+                   << "s old)\n");
+      sys::fs::remove(File->path());
+      continue;
+    }
+
+    if (ShouldComputeSize) {
+      TotalSize += FileStatus.getSize();
+      Entries.push_back(
+          std::make_tuple(FileModTime, FileStatus.getSize(), File->path()));
+    }
+  }
+
+  // Prune the least recently used entries until the cache fits.
+  if (ShouldComputeSize && TotalSize > MaxSize) {
+    std::sort(Entries.begin(), Entries.end(),
+              [](const EntryTy &LHS, const EntryTy &RHS) {
+                return std::get<0>(LHS) < std::get<0>(RHS);
+              });
+    for (auto &Entry : Entries) {
+      if (TotalSize <= MaxSize)
+        break;
+      DEBUG(dbgs() << "Remove " << std::get<2>(Entry) << " (cache size "
+                   << TotalSize << ")\n");
+      sys::fs::remove(std::get<2>(Entry));
+      TotalSize -= std::get<1>(Entry);
+    }
+  }
+  return true;
+}
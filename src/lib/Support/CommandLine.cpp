@@ -109,7 +109,9 @@ public:
 
   void addLiteralOption(Option &Opt, const char *Name) {
     if (!Opt.hasArgStr()) {
-      if (!OptionsMap.insert(std::make_pair(Name, &Opt)).second) {
+      auto Result = OptionsMap.insert(std::make_pair(Name, &Opt));
+      // Taking in a pending option already added the literals it had.
+      if (!Result.second && Result.first->second != &Opt) {
         errs() << ProgramName << ": CommandLine Error: Option '" << Name
                << "' registered more than once!\n";
         report_fatal_error("inconsistency in registered CommandLine options");
@@ -126,6 +128,13 @@ public:
                << "' registered more than once!\n";
         HadErrors = true;
       }
+    } else {
+      // The option is vectored by its values, which it took before the
+      // parser took it in.
+      SmallVector<const char *, 16> LiteralNames;
+      O->getExtraOptionNames(LiteralNames);
+      for (auto Name : LiteralNames)
+        addLiteralOption(*O, Name);
     }
 
     // Remember information about positional options.
@@ -190,31 +199,59 @@ public:
     OptionsMap.erase(StringRef(O->ArgStr));
   }
 
+  void addPendingOptions();
+
   void printOptionValues();
 };
 
 } // namespace
 
-static ManagedStatic<CommandLineParser> GlobalParser;
+// The options that were registered but that the parser hasn't taken in yet,
+// in the order of their registration.  Nearly all of the options register
+// from static constructors, which then only link them here: the parser, its
+// map and its allocations are only made when something first uses them.
+static Option *PendingOptions = nullptr;
+static Option **PendingOptionsTail = &PendingOptions;
+
+void CommandLineParser::addPendingOptions() {
+  while (Option *O = PendingOptions) {
+    PendingOptions = O->NextRegistered;
+    O->NextRegistered = nullptr;
+    addOption(O);
+  }
+  PendingOptionsTail = &PendingOptions;
+}
+
+static ManagedStatic<CommandLineParser> TheParser;
+
+static CommandLineParser *getGlobalParser() {
+  CommandLineParser *Parser = &*TheParser;
+  if (PendingOptions)
+    Parser->addPendingOptions();
+  return Parser;
+}
 
 void cl::AddLiteralOption(Option &O, const char *Name) {
-  GlobalParser->addLiteralOption(O, Name);
+  // A pending option adds the literals it has when the parser takes it in.
+  if (O.FullyInitialized)
+    getGlobalParser()->addLiteralOption(O, Name);
 }
 
 extrahelp::extrahelp(const char *Help) : morehelp(Help) {
-  GlobalParser->MoreHelp.push_back(Help);
+  TheParser->MoreHelp.push_back(Help);
 }
 
 void Option::addArgument() {
-  GlobalParser->addOption(this);
+  *PendingOptionsTail = this;
+  PendingOptionsTail = &NextRegistered;
   FullyInitialized = true;
 }
 
-void Option::removeArgument() { GlobalParser->removeOption(this); }
+void Option::removeArgument() { getGlobalParser()->removeOption(this); }
 
 void Option::setArgStr(const char *S) {
   if (FullyInitialized)
-    GlobalParser->updateArgStr(this, S);
+    getGlobalParser()->updateArgStr(this, S);
   ArgStr = S;
 }
 
@@ -828,7 +865,7 @@ void cl::ParseEnvironmentOptions(const char *progName, const char *envVar,
 
 void cl::ParseCommandLineOptions(int argc, const char *const *argv,
                                  const char *Overview) {
-  GlobalParser->ParseCommandLineOptions(argc, argv, Overview);
+  getGlobalParser()->ParseCommandLineOptions(argc, argv, Overview);
 }
 
 void CommandLineParser::ParseCommandLineOptions(int argc,
@@ -914,6 +951,10 @@ void CommandLineParser::ParseCommandLineOptions(int argc,
     StringRef Value;
     StringRef ArgName = "";
 
+    // The arguments after one that loaded a plugin can use its options.
+    if (PendingOptions)
+      addPendingOptions();
+
     // Check to see if this is a positional argument.  This argument is
     // considered to be positional if it doesn't start with '-', if it is "-"
     // itself, or if we have seen "--" already.
@@ -1130,7 +1171,7 @@ bool Option::error(const Twine &Message, StringRef ArgName) {
   if (ArgName.empty())
     errs() << HelpStr; // Be nice for positional arguments
   else
-    errs() << GlobalParser->ProgramName << ": for the -" << ArgName;
+    errs() << getGlobalParser()->ProgramName << ": for the -" << ArgName;
 
   errs() << " option: " << Message << "\n";
   return true;
@@ -1518,22 +1559,22 @@ public:
       return;
 
     StrOptionPairVector Opts;
-    sortOpts(GlobalParser->OptionsMap, Opts, ShowHidden);
+    sortOpts(getGlobalParser()->OptionsMap, Opts, ShowHidden);
 
-    if (GlobalParser->ProgramOverview)
-      outs() << "OVERVIEW: " << GlobalParser->ProgramOverview << "\n";
+    if (getGlobalParser()->ProgramOverview)
+      outs() << "OVERVIEW: " << getGlobalParser()->ProgramOverview << "\n";
 
-    outs() << "USAGE: " << GlobalParser->ProgramName << " [options]";
+    outs() << "USAGE: " << getGlobalParser()->ProgramName << " [options]";
 
-    for (auto Opt : GlobalParser->PositionalOpts) {
+    for (auto Opt : getGlobalParser()->PositionalOpts) {
       if (Opt->ArgStr[0])
         outs() << " --" << Opt->ArgStr;
       outs() << " " << Opt->HelpStr;
     }
 
     // Print the consume after option info if it exists...
-    if (GlobalParser->ConsumeAfterOpt)
-      outs() << " " << GlobalParser->ConsumeAfterOpt->HelpStr;
+    if (getGlobalParser()->ConsumeAfterOpt)
+      outs() << " " << getGlobalParser()->ConsumeAfterOpt->HelpStr;
 
     outs() << "\n\n";
 
@@ -1546,9 +1587,9 @@ public:
     printOptions(Opts, MaxArgLen);
 
     // Print any extra help the user has declared.
-    for (auto I : GlobalParser->MoreHelp)
+    for (auto I : getGlobalParser()->MoreHelp)
       outs() << I;
-    GlobalParser->MoreHelp.clear();
+    getGlobalParser()->MoreHelp.clear();
 
     // Halt the program since help information was printed
     exit(0);
@@ -1732,7 +1773,7 @@ void HelpPrinterWrapper::operator=(bool Value) {
 }
 
 // Print the value of each option.
-void cl::PrintOptionValues() { GlobalParser->printOptionValues(); }
+void cl::PrintOptionValues() { getGlobalParser()->printOptionValues(); }
 
 void CommandLineParser::printOptionValues() {
   if (!PrintOptions && !PrintAllOptions)
@@ -1854,11 +1895,11 @@ void cl::AddExtraVersionPrinter(void (*func)()) {
 }
 
 StringMap<Option *> &cl::getRegisteredOptions() {
-  return GlobalParser->OptionsMap;
+  return getGlobalParser()->OptionsMap;
 }
 
 void cl::HideUnrelatedOptions(cl::OptionCategory &Category) {
-  for (auto &I : GlobalParser->OptionsMap) {
+  for (auto &I : getGlobalParser()->OptionsMap) {
     if (I.second->Category != &Category &&
         I.second->Category != &GenericCategory)
       I.second->setHiddenFlag(cl::ReallyHidden);
@@ -1868,7 +1909,7 @@ void cl::HideUnrelatedOptions(cl::OptionCategory &Category) {
 void cl::HideUnrelatedOptions(ArrayRef<const cl::OptionCategory *> Categories) {
   auto CategoriesBegin = Categories.begin();
   auto CategoriesEnd = Categories.end();
-  for (auto &I : GlobalParser->OptionsMap) {
+  for (auto &I : getGlobalParser()->OptionsMap) {
     if (std::find(CategoriesBegin, CategoriesEnd, I.second->Category) ==
             CategoriesEnd &&
         I.second->Category != &GenericCategory)
@@ -14,8 +14,12 @@
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/ThreadLocal.h"
+#include "llvm/Support/Threading.h"
+#include <condition_variable>
 #include <cstdio>
+#include <mutex>
 #include <setjmp.h>
+#include <vector>
 using namespace llvm;
 
 namespace {
@@ -325,6 +329,11 @@ void CrashRecoveryContext::HandleCrash() {
   CRCI->HandleCrash();
 }
 
+void CrashRecoveryContext::HandleExit(int Code) {
+  RetCode = Code;
+  HandleCrash();
+}
+
 const std::string &CrashRecoveryContext::getBacktrace() const {
   CrashRecoveryContextImpl *CRC = (CrashRecoveryContextImpl *) Impl;
   assert(CRC && "Crash recovery context never initialized!");
@@ -333,9 +342,11 @@ const std::string &CrashRecoveryContext::getBacktrace() const {
 }
 
 // FIXME: Portability.
-static void setThreadBackgroundPriority() {
+static void setThreadBackgroundPriority(bool Background) {
 #ifdef __APPLE__
-  setpriority(PRIO_DARWIN_THREAD, 0, PRIO_DARWIN_BG);
+  setpriority(PRIO_DARWIN_THREAD, 0, Background ? PRIO_DARWIN_BG : 0);
+#else
+  (void)Background;
 #endif
 }
 
@@ -360,16 +371,132 @@ static void RunSafelyOnThread_Dispatch(void *UserData) {
   RunSafelyOnThreadInfo *Info =
     reinterpret_cast<RunSafelyOnThreadInfo*>(UserData);
 
-  if (Info->UseBackgroundPriority)
-    setThreadBackgroundPriority();
+  // The thread may have run a caller with another priority before.
+  if (Info->UseBackgroundPriority != hasThreadBackgroundPriority())
+    setThreadBackgroundPriority(Info->UseBackgroundPriority);
 
   Info->Result = Info->CRC->RunSafely(Info->Fn);
+  // The context belongs to the calling thread; don't leave this thread
+  // pointing at it once it is gone.
+  CurrentContext->erase();
 }
+
+#if LLVM_ENABLE_THREADS
+namespace {
+/// The threads RunSafelyOnThread runs its callbacks on. Creating a thread with
+/// a large stack for every call is slow enough to matter to clients such as
+/// libclang, which parse each translation unit on one, so the threads are kept
+/// around between calls instead, one per stack size and concurrent caller.
+///
+/// A thread whose callback crashed is not reused, since the callback may have
+/// left thread-local state behind when control jumped out of it.
+class SafetyThreadPool {
+  struct SafetyThread {
+    SafetyThread(SafetyThreadPool &Pool, unsigned StackSize)
+        : Pool(Pool), StackSize(StackSize), Job(nullptr) {}
+
+    SafetyThreadPool &Pool;
+    unsigned StackSize;
+    /// The callback to run, if any; reset once it has run.
+    RunSafelyOnThreadInfo *Job;
+    /// Signalled when the thread is given a callback or finishes one, and
+    /// when the pool shuts down.
+    std::condition_variable Changed;
+  };
+
+  std::mutex Lock;
+  /// Signalled when a thread exits.
+  std::condition_variable ThreadExited;
+  std::vector<SafetyThread *> IdleThreads;
+  unsigned NumThreads = 0;
+  bool ShuttingDown = false;
+
+  static void threadMain(void *Arg);
+
+public:
+  ~SafetyThreadPool();
+
+  /// Run \p Info on a thread with the given stack size and wait for it.
+  /// Return false if no thread could be started.
+  bool run(RunSafelyOnThreadInfo &Info, unsigned StackSize);
+};
+}
+
+SafetyThreadPool::~SafetyThreadPool() {
+  std::unique_lock<std::mutex> Guard(Lock);
+  ShuttingDown = true;
+  for (SafetyThread *Thread : IdleThreads)
+    Thread->Changed.notify_all();
+  ThreadExited.wait(Guard, [&] { return NumThreads == 0; });
+}
+
+bool SafetyThreadPool::run(RunSafelyOnThreadInfo &Info, unsigned StackSize) {
+  std::unique_lock<std::mutex> Guard(Lock);
+  SafetyThread *Thread = nullptr;
+  for (auto I = IdleThreads.rbegin(), E = IdleThreads.rend(); I != E; ++I) {
+    if ((*I)->StackSize == StackSize) {
+      Thread = *I;
+      IdleThreads.erase(std::next(I).base());
+      break;
+    }
+  }
+  if (!Thread) {
+    Thread = new SafetyThread(*this, StackSize);
+    if (!llvm_execute_on_detached_thread(threadMain, Thread, StackSize)) {
+      delete Thread;
+      return false;
+    }
+    ++NumThreads;
+  }
+
+  Thread->Job = &Info;
+  Thread->Changed.notify_all();
+  Thread->Changed.wait(Guard, [&] { return !Thread->Job; });
+  return true;
+}
+
+void SafetyThreadPool::threadMain(void *Arg) {
+  SafetyThread *Thread = static_cast<SafetyThread *>(Arg);
+  SafetyThreadPool &Pool = Thread->Pool;
+  std::unique_lock<std::mutex> Guard(Pool.Lock);
+  while (true) {
+    Thread->Changed.wait(Guard,
+                         [&] { return Thread->Job || Pool.ShuttingDown; });
+    RunSafelyOnThreadInfo *Job = Thread->Job;
+    if (!Job)
+      break;
+
+    Guard.unlock();
+    RunSafelyOnThread_Dispatch(Job);
+    bool Reuse = Job->Result;
+    Guard.lock();
+
+    // The caller may return, and free Job, as soon as this is reset.
+    Thread->Job = nullptr;
+    Thread->Changed.notify_all();
+    if (!Reuse || Pool.ShuttingDown)
+      break;
+    Pool.IdleThreads.push_back(Thread);
+  }
+
+  --Pool.NumThreads;
+  Pool.ThreadExited.notify_all();
+  Guard.unlock();
+  delete Thread;
+}
+
+static ManagedStatic<SafetyThreadPool> SafetyThreads;
+#endif
+
 bool CrashRecoveryContext::RunSafelyOnThread(function_ref<void()> Fn,
                                              unsigned RequestedStackSize) {
   bool UseBackgroundPriority = hasThreadBackgroundPriority();
   RunSafelyOnThreadInfo Info = { Fn, this, UseBackgroundPriority, false };
-  llvm_execute_on_thread(RunSafelyOnThread_Dispatch, &Info, RequestedStackSize);
+#if LLVM_ENABLE_THREADS
+  if (!SafetyThreads->run(Info, RequestedStackSize))
+#endif
+    llvm_execute_on_thread(RunSafelyOnThread_Dispatch, &Info,
+                           RequestedStackSize);
   if (CrashRecoveryContextImpl *CRC = (CrashRecoveryContextImpl *)Impl)
     CRC->setSwitchedThread();
   return Info.Result;
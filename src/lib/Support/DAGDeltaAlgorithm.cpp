@@ -40,6 +40,7 @@
 #include <cassert>
 #include <iterator>
 #include <map>
+#include <mutex>
 using namespace llvm;
 
 #define DEBUG_TYPE "dag-delta"
@@ -68,11 +69,13 @@ private:
 
   std::vector<change_ty> Roots;
 
-  /// Cache of failed test results. Successful test results are never cached
-  /// since we always reduce following a success. We maintain an independent
-  /// cache from that used by the individual delta passes because we may get
-  /// hits across multiple individual delta invocations.
-  mutable std::set<changeset_ty> FailedTestsCache;
+  /// Cache of test results, keyed by the change set tested. We maintain an
+  /// independent cache from that used by the individual delta passes because
+  /// we may get hits across multiple individual delta invocations.
+  std::map<changeset_ty, bool> TestResultsCache;
+
+  /// Protects TestResultsCache from the concurrent tests of the delta passes.
+  std::mutex TestResultsLock;
 
   // FIXME: Gross.
   std::map<change_ty, std::vector<change_ty> > Predecessors;
@@ -176,7 +179,8 @@ protected:
 public:
   DeltaActiveSetHelper(DAGDeltaAlgorithmImpl &_DDAI,
                        const changeset_ty &_Required)
-    : DDAI(_DDAI), Required(_Required) {}
+    : DeltaAlgorithm(_DDAI.DDA.getNumThreads()), DDAI(_DDAI),
+      Required(_Required) {}
 };
 
 }
@@ -293,16 +297,22 @@ bool DAGDeltaAlgorithmImpl::GetTestResult(const changeset_ty &Changes,
   changeset_ty Extended(Required);
   Extended.insert(Changes.begin(), Changes.end());
   for (changeset_ty::const_iterator it = Changes.begin(),
-         ie = Changes.end(); it != ie; ++it)
-    Extended.insert(pred_closure_begin(*it), pred_closure_end(*it));
+         ie = Changes.end(); it != ie; ++it) {
+    // Tests may run concurrently: only look the closure up.
+    const std::set<change_ty> &Preds = PredClosure.find(*it)->second;
+    Extended.insert(Preds.begin(), Preds.end());
+  }
 
-  if (FailedTestsCache.count(Extended))
-    return false;
+  {
+    std::lock_guard<std::mutex> Lock(TestResultsLock);
+    auto Cached = TestResultsCache.find(Extended);
+    if (Cached != TestResultsCache.end())
+      return Cached->second;
+  }
 
   bool Result = ExecuteOneTest(Extended);
-  if (!Result)
-    FailedTestsCache.insert(Extended);
-
+  std::lock_guard<std::mutex> Lock(TestResultsLock);
+  TestResultsCache.insert(std::make_pair(Extended, Result));
   return Result;
 }
 
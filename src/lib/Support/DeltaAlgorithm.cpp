@@ -7,7 +7,9 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ADT/DeltaAlgorithm.h"
+#include "llvm/Support/ThreadPool.h"
 #include <algorithm>
+#include <future>
 #include <iterator>
 using namespace llvm;
 
@@ -15,16 +17,41 @@ DeltaAlgorithm::~DeltaAlgorithm() {
 }
 
 bool DeltaAlgorithm::GetTestResult(const changeset_ty &Changes) {
-  if (FailedTestsCache.count(Changes))
-    return false;
+  auto Cached = TestResultsCache.find(Changes);
+  if (Cached != TestResultsCache.end())
+    return Cached->second;
 
   bool Result = ExecuteOneTest(Changes);
-  if (!Result)
-    FailedTestsCache.insert(Changes);
-
+  TestResultsCache.insert(std::make_pair(Changes, Result));
   return Result;
 }
 
+std::vector<bool>
+DeltaAlgorithm::GetTestResults(const changesetlist_ty &Sets) {
+  if (!Pool || Sets.size() == 1) {
+    std::vector<bool> Results;
+    for (const changeset_ty &S : Sets)
+      Results.push_back(GetTestResult(S));
+    return Results;
+  }
+
+  std::vector<std::future<bool>> Tests(Sets.size());
+  for (unsigned i = 0, e = Sets.size(); i != e; ++i) {
+    if (TestResultsCache.count(Sets[i]))
+      continue;
+    const changeset_ty *S = &Sets[i];
+    Tests[i] = Pool->async([this, S] { return ExecuteOneTest(*S); });
+  }
+
+  std::vector<bool> Results;
+  for (unsigned i = 0, e = Sets.size(); i != e; ++i) {
+    if (Tests[i].valid())
+      TestResultsCache.insert(std::make_pair(Sets[i], Tests[i].get()));
+    Results.push_back(TestResultsCache.find(Sets[i])->second);
+  }
+  return Results;
+}
+
 void DeltaAlgorithm::Split(const changeset_ty &S, changesetlist_ty &Res) {
   // FIXME: Allow clients to provide heuristics for improved splitting.
 
@@ -69,32 +96,51 @@ DeltaAlgorithm::Delta(const changeset_ty &Changes,
 bool DeltaAlgorithm::Search(const changeset_ty &Changes,
                             const changesetlist_ty &Sets,
                             changeset_ty &Res) {
-  // FIXME: Parallelize.
-  for (changesetlist_ty::const_iterator it = Sets.begin(),
-         ie = Sets.end(); it != ie; ++it) {
-    // If the test passes on this subset alone, recurse.
-    if (GetTestResult(*it)) {
-      changesetlist_ty Sets;
-      Split(*it, Sets);
-      Res = Delta(*it, Sets);
-      return true;
-    }
+  // The candidates are each subset alone and, if we have more than two sets,
+  // its complement, in this order. Test as many of them at once as there are
+  // threads, and go on with the first which passes.
+  const bool TryComplements = Sets.size() > 2;
+  const unsigned NumCandidates = Sets.size() * (TryComplements ? 2 : 1);
+  const unsigned Window = Pool ? std::max(1u, Pool->getThreadCount()) : 1;
+  for (unsigned Begin = 0; Begin < NumCandidates; Begin += Window) {
+    unsigned End = std::min(NumCandidates, Begin + Window);
+    changesetlist_ty Candidates;
+    for (unsigned i = Begin; i != End; ++i) {
+      const changeset_ty &S = Sets[TryComplements ? i / 2 : i];
+      if (!TryComplements || i % 2 == 0) {
+        Candidates.push_back(S);
+        continue;
+      }
 
-    // Otherwise, if we have more than two sets, see if test passes on the
-    // complement.
-    if (Sets.size() > 2) {
       // FIXME: This is really slow.
       changeset_ty Complement;
       std::set_difference(
-        Changes.begin(), Changes.end(), it->begin(), it->end(),
+        Changes.begin(), Changes.end(), S.begin(), S.end(),
         std::insert_iterator<changeset_ty>(Complement, Complement.begin()));
-      if (GetTestResult(Complement)) {
-        changesetlist_ty ComplementSets;
-        ComplementSets.insert(ComplementSets.end(), Sets.begin(), it);
-        ComplementSets.insert(ComplementSets.end(), it + 1, Sets.end());
-        Res = Delta(Complement, ComplementSets);
+      Candidates.push_back(Complement);
+    }
+
+    std::vector<bool> Results = GetTestResults(Candidates);
+    for (unsigned i = Begin; i != End; ++i) {
+      if (!Results[i - Begin])
+        continue;
+
+      const changeset_ty &Passing = Candidates[i - Begin];
+      if (!TryComplements || i % 2 == 0) {
+        // The test passes on this subset alone, recurse.
+        changesetlist_ty Sets;
+        Split(Passing, Sets);
+        Res = Delta(Passing, Sets);
         return true;
       }
+
+      // The test passes on the complement of this subset, recurse.
+      changesetlist_ty::const_iterator it = Sets.begin() + i / 2;
+      changesetlist_ty ComplementSets;
+      ComplementSets.insert(ComplementSets.end(), Sets.begin(), it);
+      ComplementSets.insert(ComplementSets.end(), it + 1, Sets.end());
+      Res = Delta(Passing, ComplementSets);
+      return true;
     }
   }
 
@@ -102,13 +148,21 @@ bool DeltaAlgorithm::Search(const changeset_ty &Changes,
 }
 
 DeltaAlgorithm::changeset_ty DeltaAlgorithm::Run(const changeset_ty &Changes) {
-  // Check empty set first to quickly find poor test functions.
-  if (GetTestResult(changeset_ty()))
-    return changeset_ty();
+  std::unique_ptr<ThreadPool> Threads;
+  if (NumThreads != 1) {
+    Threads.reset(new ThreadPool(NumThreads));
+    Pool = Threads.get();
+  }
 
-  // Otherwise run the real delta algorithm.
-  changesetlist_ty Sets;
-  Split(Changes, Sets);
+  changeset_ty Res;
+  // Check empty set first to quickly find poor test functions.
+  if (!GetTestResult(changeset_ty())) {
+    // Otherwise run the real delta algorithm.
+    changesetlist_ty Sets;
+    Split(Changes, Sets);
+    Res = Delta(Changes, Sets);
+  }
 
-  return Delta(Changes, Sets);
+  Pool = nullptr;
+  return Res;
 }
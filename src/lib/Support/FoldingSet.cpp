@@ -384,6 +384,157 @@ FoldingSetImpl::Node *FoldingSetImpl::GetOrInsertNode(FoldingSetImpl::Node *N) {
   return N;
 }
 
+//===----------------------------------------------------------------------===//
+// HashedFoldingSetImpl Implementation
+
+/// AllocateHashedBuckets - Allocate empty buckets.
+static HashedFoldingSetBucket *AllocateHashedBuckets(unsigned NumBuckets) {
+  return static_cast<HashedFoldingSetBucket *>(
+      calloc(NumBuckets, sizeof(HashedFoldingSetBucket)));
+}
+
+/// FindEmptyBucket - Return the first empty bucket or tombstone in the probe
+/// sequence of the specified hash.
+static HashedFoldingSetBucket *FindEmptyBucket(unsigned Hash,
+                                               HashedFoldingSetBucket *Buckets,
+                                               unsigned NumBuckets) {
+  // NumBuckets is always a power of 2.  Quadratic probing visits every bucket.
+  unsigned BucketNum = Hash & (NumBuckets-1);
+  for (unsigned ProbeAmt = 1; Buckets[BucketNum].hasNode(); ++ProbeAmt)
+    BucketNum = (BucketNum + ProbeAmt) & (NumBuckets-1);
+  return Buckets + BucketNum;
+}
+
+HashedFoldingSetImpl::HashedFoldingSetImpl(unsigned Log2InitSize) {
+  assert(1 < Log2InitSize && Log2InitSize < 32 &&
+         "Initial hash table size out of range");
+  NumBuckets = 1 << Log2InitSize;
+  Buckets = AllocateHashedBuckets(NumBuckets);
+  NumNodes = 0;
+  NumTombstones = 0;
+}
+HashedFoldingSetImpl::~HashedFoldingSetImpl() {
+  free(Buckets);
+}
+void HashedFoldingSetImpl::clear() {
+  memset(Buckets, 0, NumBuckets*sizeof(Bucket));
+  NumNodes = 0;
+  NumTombstones = 0;
+}
+
+/// GrowHashTable - Rehash everything into NewNumBuckets buckets, dropping the
+/// tombstones.  The buckets remember the hash of their node, so no node needs
+/// to be profiled.
+void HashedFoldingSetImpl::GrowHashTable(unsigned NewNumBuckets) {
+  Bucket *OldBuckets = Buckets;
+  unsigned OldNumBuckets = NumBuckets;
+  NumBuckets = NewNumBuckets;
+  Buckets = AllocateHashedBuckets(NumBuckets);
+  NumTombstones = 0;
+
+  for (unsigned i = 0; i != OldNumBuckets; ++i)
+    if (OldBuckets[i].hasNode())
+      *FindEmptyBucket(OldBuckets[i].Hash, Buckets, NumBuckets) = OldBuckets[i];
+
+  free(OldBuckets);
+}
+
+/// FindNodeOrInsertPos - Look up the node specified by ID.  If it exists,
+/// return it.  If not, return the insertion token that will make insertion
+/// faster.
+HashedFoldingSetImpl::Node *
+HashedFoldingSetImpl::FindNodeOrInsertPos(const FoldingSetNodeID &ID,
+                                          void *&InsertPos) {
+  unsigned IDHash = ID.ComputeHash();
+  unsigned BucketNum = IDHash & (NumBuckets-1);
+  Bucket *FirstTombstone = nullptr;
+
+  FoldingSetNodeID TempID;
+  for (unsigned ProbeAmt = 1; ; ++ProbeAmt) {
+    Bucket *B = Buckets + BucketNum;
+    if (!B->Node) {
+      // Didn't find the node, return null with the first free bucket as the
+      // InsertPos.
+      InsertPos = FirstTombstone ? FirstTombstone : B;
+      return nullptr;
+    }
+    if (B->Node == Bucket::getTombstone()) {
+      if (!FirstTombstone)
+        FirstTombstone = B;
+    } else if (B->Hash == IDHash) {
+      // Only profile the nodes whose hash matches.
+      if (NodeEquals(B->Node, ID, IDHash, TempID)) {
+        InsertPos = nullptr;
+        return B->Node;
+      }
+      TempID.clear();
+    }
+    BucketNum = (BucketNum + ProbeAmt) & (NumBuckets-1);
+  }
+}
+
+/// InsertNode - Insert the specified node into the folding set, knowing that it
+/// is not already in the map.  InsertPos must be obtained from
+/// FindNodeOrInsertPos.
+void HashedFoldingSetImpl::InsertNode(Node *N, void *InsertPos) {
+  /// The insert position is actually a bucket pointer.
+  Bucket *B = static_cast<Bucket *>(InsertPos);
+  assert(B && !B->hasNode() && "Insert position is not a free bucket!");
+
+  // IDs looked up since may have been given the same insert position, so the
+  // bucket cannot carry the hash of N until N is inserted.
+  FoldingSetNodeID TempID;
+  unsigned Hash = ComputeNodeHash(N, TempID);
+
+  // Keep at least a quarter of the buckets empty so that probe sequences stay
+  // short.  If tombstones fill them, rehash at the same size.
+  bool IsTombstone = B->Node == Bucket::getTombstone();
+  if ((NumNodes + NumTombstones + !IsTombstone) * 4 > NumBuckets * 3) {
+    GrowHashTable((NumNodes + 1) * 2 > NumBuckets ? NumBuckets * 2
+                                                  : NumBuckets);
+    B = FindEmptyBucket(Hash, Buckets, NumBuckets);
+    IsTombstone = false;
+  }
+
+  ++NumNodes;
+  if (IsTombstone)
+    --NumTombstones;
+  B->Hash = Hash;
+  B->Node = N;
+}
+
+/// RemoveNode - Remove a node from the folding set, returning true if one was
+/// removed or false if the node was not in the folding set.
+bool HashedFoldingSetImpl::RemoveNode(Node *N) {
+  FoldingSetNodeID TempID;
+  unsigned Hash = ComputeNodeHash(N, TempID);
+  unsigned BucketNum = Hash & (NumBuckets-1);
+  for (unsigned ProbeAmt = 1; Buckets[BucketNum].Node; ++ProbeAmt) {
+    Bucket &B = Buckets[BucketNum];
+    if (B.Node == N) {
+      B.Node = Bucket::getTombstone();
+      --NumNodes;
+      ++NumTombstones;
+      return true;
+    }
+    BucketNum = (BucketNum + ProbeAmt) & (NumBuckets-1);
+  }
+  return false;
+}
+
+/// GetOrInsertNode - If there is an existing simple Node exactly
+/// equal to the specified node, return it.  Otherwise, insert 'N' and it
+/// instead.
+HashedFoldingSetImpl::Node *HashedFoldingSetImpl::GetOrInsertNode(Node *N) {
+  FoldingSetNodeID ID;
+  GetNodeProfile(N, ID);
+  void *IP;
+  if (Node *E = FindNodeOrInsertPos(ID, IP))
+    return E;
+  InsertNode(N, IP);
+  return N;
+}
+
 //===----------------------------------------------------------------------===//
 // FoldingSetIteratorImpl Implementation
 
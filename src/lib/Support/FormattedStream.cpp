@@ -23,22 +23,28 @@ using namespace llvm;
 static void UpdatePosition(std::pair<unsigned, unsigned> &Position, const char *Ptr, size_t Size) {
   unsigned &Column = Position.first;
   unsigned &Line = Position.second;
+  const char *End = Ptr + Size;
 
-  // Keep track of the current column and line by scanning the string for
-  // special characters
-  for (const char *End = Ptr + Size; Ptr != End; ++Ptr) {
+  // The column only depends on the characters after the last line break, so
+  // find it first and only count the line breaks before it. Output is mostly
+  // short lines, which makes this much cheaper than looking at every
+  // character.
+  const char *LastBreak = End;
+  while (LastBreak != Ptr && LastBreak[-1] != '\n' && LastBreak[-1] != '\r')
+    --LastBreak;
+  if (LastBreak != Ptr) {
+    Line += std::count(Ptr, LastBreak, '\n');
+    Column = 0;
+    Ptr = LastBreak;
+  }
+
+  // Keep track of the current column by scanning the rest of the string for
+  // tabs.
+  for (; Ptr != End; ++Ptr) {
     ++Column;
-    switch (*Ptr) {
-    case '\n':
-      Line += 1;
-    case '\r':
-      Column = 0;
-      break;
-    case '\t':
-      // Assumes tab stop = 8 characters.
+    // Assumes tab stop = 8 characters.
+    if (*Ptr == '\t')
       Column += (8 - (Column & 0x7)) & 0x7;
-      break;
-    }
   }
 }
 
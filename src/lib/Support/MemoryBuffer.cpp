@@ -162,13 +162,14 @@ MemoryBuffer::getNewMemBuffer(size_t Size, StringRef BufferName) {
 }
 
 ErrorOr<std::unique_ptr<MemoryBuffer>>
-MemoryBuffer::getFileOrSTDIN(const Twine &Filename, int64_t FileSize) {
+MemoryBuffer::getFileOrSTDIN(const Twine &Filename, int64_t FileSize,
+                             bool RequiresNullTerminator) {
   SmallString<256> NameBuf;
   StringRef NameRef = Filename.toStringRef(NameBuf);
 
   if (NameRef == "-")
     return getSTDIN();
-  return getFile(Filename, FileSize);
+  return getFile(Filename, FileSize, RequiresNullTerminator);
 }
 
 ErrorOr<std::unique_ptr<MemoryBuffer>>
@@ -209,6 +210,11 @@ public:
     if (!EC) {
       const char *Start = getStart(Len, Offset);
       init(Start, Start + Len, RequiresNullTerminator);
+      // The buffers that need a null terminator are text that is lexed front
+      // to back straight away, so have the system read the file in ahead of
+      // the page faults.  Binary files are often only read in part.
+      if (RequiresNullTerminator)
+        MFR.advise(sys::fs::mapped_file_region::willneed);
     }
   }
 
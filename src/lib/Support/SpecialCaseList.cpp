@@ -21,28 +21,109 @@
 #include "llvm/ADT/StringSet.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Regex.h"
+#include "llvm/Support/TrigramIndex.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <iterator>
 #include <string>
 #include <system_error>
 #include <utility>
 
 namespace llvm {
 
+namespace {
+/// A set of strings which tells whether any of them is a prefix of a query in
+/// time linear in the length of the query, however many strings it holds.
+class GlobTrie {
+  typedef SmallVector<std::pair<char, unsigned>, 2> ChildList;
+  struct Node {
+    Node() : Terminal(false) {}
+    /// The children, sorted by the character that leads to each.
+    ChildList Children;
+    /// Whether one of the strings ends here.
+    bool Terminal;
+  };
+  /// The nodes, with the root first.
+  std::vector<Node> Nodes;
+
+  /// Returns the position of the first child for character C or above.
+  static size_t lowerBound(const ChildList &Children, char C) {
+    return std::lower_bound(Children.begin(), Children.end(), C,
+                            [](const std::pair<char, unsigned> &Child,
+                               char C) { return Child.first < C; }) -
+           Children.begin();
+  }
+
+  /// Returns the child of node N for character C, or 0 if it has none.
+  unsigned getChild(unsigned N, char C) const {
+    const ChildList &Children = Nodes[N].Children;
+    size_t I = lowerBound(Children, C);
+    return I != Children.size() && Children[I].first == C ? Children[I].second
+                                                          : 0;
+  }
+
+public:
+  GlobTrie() : Nodes(1) {}
+
+  template <typename IterTy> void insert(IterTy Begin, IterTy End) {
+    unsigned N = 0;
+    for (; Begin != End; ++Begin) {
+      char C = *Begin;
+      unsigned Child = getChild(N, C);
+      if (!Child) {
+        Child = Nodes.size();
+        Nodes.emplace_back();
+        ChildList &Children = Nodes[N].Children;
+        Children.insert(Children.begin() + lowerBound(Children, C),
+                        std::make_pair(C, Child));
+      }
+      N = Child;
+    }
+    Nodes[N].Terminal = true;
+  }
+
+  template <typename IterTy>
+  bool containsPrefixOf(IterTy Begin, IterTy End) const {
+    unsigned N = 0;
+    while (!Nodes[N].Terminal) {
+      if (Begin == End || !(N = getChild(N, *Begin)))
+        return false;
+      ++Begin;
+    }
+    return true;
+  }
+};
+}
+
 /// Represents a set of regular expressions.  Regular expressions which are
-/// "literal" (i.e. no regex metacharacters) are stored in Strings, while all
-/// others are represented as a single pipe-separated regex in RegEx.  The
-/// reason for doing so is efficiency; StringSet is much faster at matching
-/// literal strings than Regex.
+/// "literal" (i.e. no regex metacharacters) are stored in Strings, and globs
+/// which are a literal followed or preceded by a single '*' in Prefixes and
+/// Suffixes, the latter reversed.  All others are represented as a single
+/// pipe-separated regex in RegEx, which is only run on queries that Trigrams
+/// can't rule out.  The reason for doing so is efficiency; with large lists
+/// the regex is much slower than a lookup in any of the others.
 struct SpecialCaseList::Entry {
   Entry() {}
   Entry(Entry &&Other)
-      : Strings(std::move(Other.Strings)), RegEx(std::move(Other.RegEx)) {}
+      : Strings(std::move(Other.Strings)),
+        Prefixes(std::move(Other.Prefixes)),
+        Suffixes(std::move(Other.Suffixes)),
+        Trigrams(std::move(Other.Trigrams)), RegEx(std::move(Other.RegEx)) {}
 
   StringSet<> Strings;
+  GlobTrie Prefixes;
+  GlobTrie Suffixes;
+  TrigramIndex Trigrams;
   std::unique_ptr<Regex> RegEx;
 
   bool match(StringRef Query) const {
-    return Strings.count(Query) || (RegEx && RegEx->match(Query));
+    typedef std::reverse_iterator<StringRef::iterator> ReverseIt;
+    if (Strings.count(Query) ||
+        Prefixes.containsPrefixOf(Query.begin(), Query.end()) ||
+        Suffixes.containsPrefixOf(ReverseIt(Query.end()),
+                                  ReverseIt(Query.begin())))
+      return true;
+    return RegEx && !Trigrams.isDefinitelyOut(Query) && RegEx->match(Query);
   }
 };
 
@@ -115,6 +196,21 @@ bool SpecialCaseList::parse(const MemoryBuffer *MB, std::string &Error) {
       continue;
     }
 
+    // Globs such as "_ZN4base*" or "*_test.cc" don't need a regex either.
+    StringRef Glob = Regexp;
+    if (Glob.endswith("*") && Regex::isLiteralERE(Glob.drop_back())) {
+      Glob = Glob.drop_back();
+      Entries[Prefix][Category].Prefixes.insert(Glob.begin(), Glob.end());
+      continue;
+    }
+    if (Glob.startswith("*") && Regex::isLiteralERE(Glob.drop_front())) {
+      Glob = Glob.drop_front();
+      Entries[Prefix][Category].Suffixes.insert(
+          std::reverse_iterator<StringRef::iterator>(Glob.end()),
+          std::reverse_iterator<StringRef::iterator>(Glob.begin()));
+      continue;
+    }
+
     // Replace * with .*
     for (size_t pos = 0; (pos = Regexp.find("*", pos)) != std::string::npos;
          pos += strlen(".*")) {
@@ -131,6 +227,7 @@ bool SpecialCaseList::parse(const MemoryBuffer *MB, std::string &Error) {
     }
 
     // Add this regexp into the proper group by its prefix.
+    Entries[Prefix][Category].Trigrams.insert(Regexp);
     if (!Regexps[Prefix][Category].empty())
       Regexps[Prefix][Category] += "|";
     Regexps[Prefix][Category] += "^" + Regexp + "$";
@@ -23,6 +23,7 @@
 
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/Twine.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Format.h"
@@ -40,9 +41,17 @@ namespace llvm { extern raw_ostream *CreateInfoOutputFile(); }
 /// what they did.
 ///
 static cl::opt<bool>
-Enabled(
-    "stats",
-    cl::desc("Enable statistics output from program (available with Asserts)"));
+Stats("stats",
+      cl::desc("Enable statistics output from program (available with Asserts "
+               "or LLVM_FORCE_ENABLE_STATS)"));
+
+static cl::opt<bool>
+StatsAsJSON("stats-json", cl::desc("Display statistics as json data"));
+
+/// Set by EnableStatistics.  Statistics are collected if either this or -stats
+/// is set, and printed from llvm_shutdown if -stats or PrintOnExit is.
+static bool Enabled;
+static bool PrintOnExit;
 
 
 namespace {
@@ -50,13 +59,18 @@ namespace {
 /// on demand (when the first statistic is bumped) and destroyed only when
 /// llvm_shutdown is called.  We print statistics from the destructor.
 class StatisticInfo {
-  std::vector<const Statistic*> Stats;
+  std::vector<Statistic*> Stats;
   friend void llvm::PrintStatistics();
   friend void llvm::PrintStatistics(raw_ostream &OS);
+  friend void llvm::PrintStatisticsJSON(raw_ostream &OS);
+  friend void llvm::ResetStatistics();
+
+  /// Sort the statistics by debug type, then name and description.
+  void sort();
 public:
   ~StatisticInfo();
 
-  void addStatistic(const Statistic *S) {
+  void addStatistic(Statistic *S) {
     Stats.push_back(S);
   }
 };
@@ -71,16 +85,12 @@ void Statistic::RegisterStatistic() {
   // If stats are enabled, inform StatInfo that this statistic should be
   // printed.
   sys::SmartScopedLock<true> Writer(*StatLock);
-  if (!Initialized) {
-    if (Enabled)
+  if (!Initialized.load(std::memory_order_relaxed)) {
+    if (Stats || Enabled)
       StatInfo->addStatistic(this);
 
-    TsanHappensBefore(this);
-    sys::MemoryFence();
     // Remember we have been registered.
-    TsanIgnoreWritesBegin();
-    Initialized = true;
-    TsanIgnoreWritesEnd();
+    Initialized.store(true, std::memory_order_relaxed);
   }
 }
 
@@ -89,35 +99,42 @@ StatisticInfo::~StatisticInfo() {
   llvm::PrintStatistics();
 }
 
-void llvm::EnableStatistics() {
-  Enabled.setValue(true);
+void StatisticInfo::sort() {
+  std::stable_sort(Stats.begin(), Stats.end(),
+                   [](const Statistic *LHS, const Statistic *RHS) {
+    if (int Cmp = std::strcmp(LHS->getDebugType(), RHS->getDebugType()))
+      return Cmp < 0;
+
+    if (int Cmp = std::strcmp(LHS->getName(), RHS->getName()))
+      return Cmp < 0;
+
+    return std::strcmp(LHS->getDesc(), RHS->getDesc()) < 0;
+  });
+}
+
+void llvm::EnableStatistics(bool PrintOnExit) {
+  Enabled = true;
+  ::PrintOnExit = PrintOnExit;
 }
 
 bool llvm::AreStatisticsEnabled() {
-  return Enabled;
+  return Enabled || Stats;
 }
 
 void llvm::PrintStatistics(raw_ostream &OS) {
   StatisticInfo &Stats = *StatInfo;
 
   // Figure out how long the biggest Value and Name fields are.
-  unsigned MaxNameLen = 0, MaxValLen = 0;
+  unsigned MaxDebugTypeLen = 0, MaxValLen = 0;
   for (size_t i = 0, e = Stats.Stats.size(); i != e; ++i) {
     MaxValLen = std::max(MaxValLen,
                          (unsigned)utostr(Stats.Stats[i]->getValue()).size());
-    MaxNameLen = std::max(MaxNameLen,
-                          (unsigned)std::strlen(Stats.Stats[i]->getName()));
+    MaxDebugTypeLen =
+        std::max(MaxDebugTypeLen,
+                 (unsigned)std::strlen(Stats.Stats[i]->getDebugType()));
   }
 
-  // Sort the fields by name.
-  std::stable_sort(Stats.Stats.begin(), Stats.Stats.end(),
-                   [](const Statistic *LHS, const Statistic *RHS) {
-    if (int Cmp = std::strcmp(LHS->getName(), RHS->getName()))
-      return Cmp < 0;
-
-    // Secondary key is the description.
-    return std::strcmp(LHS->getDesc(), RHS->getDesc()) < 0;
-  });
+  Stats.sort();
 
   // Print out the statistics header...
   OS << "===" << std::string(73, '-') << "===\n"
@@ -128,34 +145,85 @@ void llvm::PrintStatistics(raw_ostream &OS) {
   for (size_t i = 0, e = Stats.Stats.size(); i != e; ++i)
     OS << format("%*u %-*s - %s\n",
                  MaxValLen, Stats.Stats[i]->getValue(),
-                 MaxNameLen, Stats.Stats[i]->getName(),
+                 MaxDebugTypeLen, Stats.Stats[i]->getDebugType(),
                  Stats.Stats[i]->getDesc());
 
   OS << '\n';  // Flush the output stream.
   OS.flush();
+}
+
+static void writeJSONString(raw_ostream &OS, StringRef Str) {
+  OS << '"';
+  for (char C : Str) {
+    switch (C) {
+    case '"':  OS << "\\\""; break;
+    case '\\': OS << "\\\\"; break;
+    case '\n': OS << "\\n"; break;
+    case '\t': OS << "\\t"; break;
+    default:
+      if ((unsigned char)C < 0x20)
+        OS << format("\\u%04x", (unsigned)C);
+      else
+        OS << C;
+    }
+  }
+  OS << '"';
+}
+
+void llvm::PrintStatisticsJSON(raw_ostream &OS) {
+  StatisticInfo &Stats = *StatInfo;
+
+  Stats.sort();
 
+  // Print all of the statistics.
+  OS << "{";
+  const char *Delim = "\n";
+  for (const Statistic *Stat : Stats.Stats) {
+    OS << Delim << "  ";
+    writeJSONString(OS, (Twine(Stat->getDebugType()) + "." + Stat->getName())
+                            .str());
+    OS << ": " << Stat->getValue();
+    Delim = ",\n";
+  }
+  OS << (Stats.Stats.empty() ? "}\n" : "\n}\n");
+  OS.flush();
+}
+
+void llvm::ResetStatistics() {
+  sys::SmartScopedLock<true> Writer(*StatLock);
+  StatisticInfo &Stats = *StatInfo;
+  // Have the statistics register again when next bumped, so that only those
+  // the next job touches are reported.
+  for (Statistic *Stat : Stats.Stats) {
+    Stat->Value.store(0, std::memory_order_relaxed);
+    Stat->Initialized.store(false, std::memory_order_relaxed);
+  }
+  Stats.Stats.clear();
 }
 
 void llvm::PrintStatistics() {
-#if !defined(NDEBUG) || defined(LLVM_ENABLE_STATS)
+#if defined(LLVM_ENABLE_STATS)
   StatisticInfo &Stats = *StatInfo;
 
-  // Statistics not enabled?
-  if (Stats.Stats.empty()) return;
+  // Statistics not enabled, or only collected for the client to print?
+  if (Stats.Stats.empty() || (!::Stats && !PrintOnExit)) return;
 
   // Get the stream to write to.
   raw_ostream &OutStream = *CreateInfoOutputFile();
-  PrintStatistics(OutStream);
+  if (StatsAsJSON)
+    PrintStatisticsJSON(OutStream);
+  else
+    PrintStatistics(OutStream);
   delete &OutStream;   // Close the file.
 #else
   // Check if the -stats option is set instead of checking
   // !Stats.Stats.empty().  In release builds, Statistics operators
   // do nothing, so stats are never Registered.
-  if (Enabled) {
+  if (Stats || (Enabled && PrintOnExit)) {
     // Get the stream to write to.
     raw_ostream &OutStream = *CreateInfoOutputFile();
     OutStream << "Statistics are disabled.  "
-            << "Build with asserts or with -DLLVM_ENABLE_STATS\n";
+            << "Build with asserts or with -DLLVM_FORCE_ENABLE_STATS=ON\n";
     OutStream.flush();
     delete &OutStream;   // Close the file.
   }
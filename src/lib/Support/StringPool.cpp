@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/StringPool.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringRef.h"
 
 using namespace llvm;
@@ -19,17 +20,36 @@ using namespace llvm;
 StringPool::StringPool() {}
 
 StringPool::~StringPool() {
-  assert(InternTable.empty() && "PooledStringPtr leaked!");
+  assert(empty() && "PooledStringPtr leaked!");
+}
+
+StringPool::Shard &StringPool::getShard(StringRef Str) {
+  // The tables pick buckets with the low bits of the same hash: use the high
+  // bits here, so that the strings of a shard still spread over its buckets.
+  static_assert(NumShards == 16, "Shards are picked by the top 4 hash bits");
+  return Shards[HashString(Str) >> 28];
 }
 
 PooledStringPtr StringPool::intern(StringRef Key) {
-  table_t::iterator I = InternTable.find(Key);
-  if (I != InternTable.end())
+  Shard &S = getShard(Key);
+  std::lock_guard<std::mutex> Lock(S.Lock);
+
+  table_t::iterator I = S.InternTable.find(Key);
+  if (I != S.InternTable.end())
     return PooledStringPtr(&*I);
-  
-  entry_t *S = entry_t::Create(Key);
-  S->getValue().Pool = this;
-  InternTable.insert(S);
-  
-  return PooledStringPtr(S);
+
+  entry_t *E = entry_t::Create(Key);
+  E->getValue().Owner = &S;
+  S.InternTable.insert(E);
+
+  return PooledStringPtr(E);
+}
+
+bool StringPool::empty() const {
+  for (const Shard &S : Shards) {
+    std::lock_guard<std::mutex> Lock(S.Lock);
+    if (!S.InternTable.empty())
+      return false;
+  }
+  return true;
 }
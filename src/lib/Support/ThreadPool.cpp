@@ -0,0 +1,118 @@
+//==-- llvm/Support/ThreadPool.cpp - A ThreadPool implementation -*- C++ -*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a crude C++11 based thread pool.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Config/llvm-config.h"
+
+using namespace llvm;
+
+ThreadPool::ThreadPool(unsigned ThreadCount)
+    : ActiveTasks(0), EnableFlag(true) {
+#if LLVM_ENABLE_THREADS
+  if (ThreadCount == 0)
+    ThreadCount = std::thread::hardware_concurrency();
+  if (ThreadCount == 0)
+    ThreadCount = 1;
+  // Create ThreadCount threads that will loop forever, wait on QueueCondition
+  // for tasks to be queued or the Pool to be destroyed.
+  Threads.reserve(ThreadCount);
+  for (unsigned ThreadID = 0; ThreadID < ThreadCount; ++ThreadID)
+    Threads.emplace_back([this] { workerLoop(); });
+#else
+  (void)ThreadCount;
+#endif
+}
+
+ThreadPool::~ThreadPool() {
+  wait();
+  {
+    std::unique_lock<std::mutex> LockGuard(QueueLock);
+    EnableFlag = false;
+  }
+  QueueCondition.notify_all();
+  for (auto &Worker : Threads)
+    Worker.join();
+}
+
+void ThreadPool::workerLoop() {
+  std::unique_lock<std::mutex> LockGuard(QueueLock);
+  while (true) {
+    // Wait for tasks to be pushed in the queue, or for the pool to be torn
+    // down.
+    QueueCondition.wait(LockGuard,
+                        [&] { return !EnableFlag || !Tasks.empty(); });
+    // Exit condition.
+    if (!EnableFlag && Tasks.empty())
+      return;
+
+    // Take the task out of the queue and mark it active before releasing the
+    // lock, so that wait() never observes an empty queue and no active task
+    // while this one is still pending.
+    TaskTy Task = std::move(Tasks.front());
+    Tasks.pop_front();
+    ++ActiveTasks;
+    LockGuard.unlock();
+
+    Task();
+
+    LockGuard.lock();
+    --ActiveTasks;
+    // Waiters re-evaluate their condition every time a task completes.
+    CompletionCondition.notify_all();
+  }
+}
+
+void ThreadPool::enqueue(TaskTy Task) {
+#if LLVM_ENABLE_THREADS
+  {
+    std::unique_lock<std::mutex> LockGuard(QueueLock);
+    Tasks.push_back(std::move(Task));
+  }
+  QueueCondition.notify_one();
+  // Threads blocked in waitUntil() may want to run the new task themselves.
+  CompletionCondition.notify_all();
+#else
+  // Without thread support, tasks run synchronously on submission.
+  Task();
+#endif
+}
+
+void ThreadPool::waitUntil(const std::function<bool()> &IsDone) {
+  std::unique_lock<std::mutex> LockGuard(QueueLock);
+  while (!IsDone()) {
+    if (Tasks.empty()) {
+      CompletionCondition.wait(LockGuard);
+      continue;
+    }
+    // Rather than sleeping while the workers drain the queue, help them. This
+    // also guarantees progress when waiting from inside a task.
+    TaskTy Task = std::move(Tasks.front());
+    Tasks.pop_front();
+    ++ActiveTasks;
+    LockGuard.unlock();
+
+    Task();
+
+    LockGuard.lock();
+    --ActiveTasks;
+    CompletionCondition.notify_all();
+  }
+}
+
+void ThreadPool::wait() {
+  waitUntil([&] { return Tasks.empty() && ActiveTasks == 0; });
+}
+
+void TaskGroup::wait() {
+  Pool.waitUntil([&] { return Pending == 0; });
+}
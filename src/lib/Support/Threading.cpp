@@ -40,6 +40,12 @@ static void *ExecuteOnThread_Dispatch(void *Arg) {
   TI->UserFn(TI->UserData);
   return nullptr;
 }
+static void *ExecuteDetachedThread_Dispatch(void *Arg) {
+  ThreadInfo TI = *reinterpret_cast<ThreadInfo*>(Arg);
+  delete reinterpret_cast<ThreadInfo*>(Arg);
+  TI.UserFn(TI.UserData);
+  return nullptr;
+}
 
 void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
                                   unsigned RequestedStackSize) {
@@ -67,6 +73,32 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
  error:
   ::pthread_attr_destroy(&Attr);
 }
+
+bool llvm::llvm_execute_on_detached_thread(void (*Fn)(void*), void *UserData,
+                                           unsigned RequestedStackSize) {
+  // The thread owns its ThreadInfo, as this function returns before the thread
+  // is done with it.
+  ThreadInfo *Info = new ThreadInfo{ Fn, UserData };
+  pthread_attr_t Attr;
+  pthread_t Thread;
+  bool Started = false;
+
+  if (::pthread_attr_init(&Attr) != 0) {
+    delete Info;
+    return false;
+  }
+
+  if (::pthread_attr_setdetachstate(&Attr, PTHREAD_CREATE_DETACHED) == 0 &&
+      (RequestedStackSize == 0 ||
+       ::pthread_attr_setstacksize(&Attr, RequestedStackSize) == 0))
+    Started = ::pthread_create(&Thread, &Attr, ExecuteDetachedThread_Dispatch,
+                               Info) == 0;
+
+  ::pthread_attr_destroy(&Attr);
+  if (!Started)
+    delete Info;
+  return Started;
+}
 #elif LLVM_ENABLE_THREADS!=0 && defined(LLVM_ON_WIN32)
 #include "Windows/WindowsSupport.h"
 #include <process.h>
@@ -101,6 +133,32 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
     ::CloseHandle(hThread);
   }
 }
+
+static unsigned __stdcall DetachedThreadCallback(void *param) {
+  struct ThreadInfo info = *reinterpret_cast<struct ThreadInfo *>(param);
+  delete reinterpret_cast<struct ThreadInfo *>(param);
+  info.func(info.param);
+
+  return 0;
+}
+
+bool llvm::llvm_execute_on_detached_thread(void (*Fn)(void*), void *UserData,
+                                           unsigned RequestedStackSize) {
+  struct ThreadInfo *param = new ThreadInfo{ Fn, UserData };
+
+  HANDLE hThread = (HANDLE)::_beginthreadex(NULL,
+                                            RequestedStackSize,
+                                            DetachedThreadCallback,
+                                            param, 0, NULL);
+  if (!hThread) {
+    delete param;
+    return false;
+  }
+  // Closing the handle doesn't stop the thread, it only lets it go away once
+  // it is done.
+  ::CloseHandle(hThread);
+  return true;
+}
 #else
 // Support for non-Win32, non-pthread implementation.
 void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
@@ -109,4 +167,12 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
   Fn(UserData);
 }
 
+bool llvm::llvm_execute_on_detached_thread(void (*Fn)(void*), void *UserData,
+                                           unsigned RequestedStackSize) {
+  (void) Fn;
+  (void) UserData;
+  (void) RequestedStackSize;
+  return false;
+}
+
 #endif
@@ -0,0 +1,280 @@
+//===-- TimeProfiler.cpp - Hierarchical time trace ------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the time trace recorded by TimeTraceScope, as used by
+// clang's -ftime-trace and the -time-trace-file option of opt and llc.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+typedef std::chrono::steady_clock Clock;
+typedef std::chrono::nanoseconds Duration;
+
+/// The number of scopes a thread keeps for the Chrome trace.  Past this, each
+/// new scope replaces the oldest one, so that a long run can't exhaust memory.
+const size_t MaxEntriesPerThread = 1 << 18;
+
+struct TraceEntry {
+  Clock::time_point Start;
+  Duration Elapsed;
+  /// The time spent in the scopes nested in this one.
+  Duration Nested;
+  /// The length of the folded stack before this scope was entered.
+  size_t StackPathLength;
+  std::string Name;
+  std::string Detail;
+};
+
+/// The scopes recorded by one thread.  Only that thread touches it until the
+/// trace is written.
+struct ThreadTrace {
+  explicit ThreadTrace(unsigned Tid) : Tid(Tid) {}
+
+  unsigned Tid;
+  std::vector<TraceEntry> Stack;
+  std::vector<TraceEntry> Entries;
+  /// Where the next entry goes once Entries is full.
+  size_t NextEntry = 0;
+  /// The names of the scopes on the stack, joined with ';'.
+  std::string StackPath;
+  llvm::StringMap<std::pair<unsigned, Duration>> Totals;
+  llvm::StringMap<Duration> FoldedStacks;
+};
+
+/// The trace this thread's ThreadTrace belongs to, so that a thread starts a
+/// new one when its program records a second trace.
+LLVM_THREAD_LOCAL unsigned CurrentSession = 0;
+LLVM_THREAD_LOCAL ThreadTrace *CurrentThread = nullptr;
+
+unsigned LastSession = 0;
+} // end anonymous namespace
+
+namespace llvm {
+class TimeTraceProfiler {
+public:
+  TimeTraceProfiler(unsigned GranularityUS, StringRef ProcessName)
+      : StartTime(Clock::now()),
+        Granularity(std::chrono::microseconds(GranularityUS)),
+        ProcessName(ProcessName), Session(++LastSession) {}
+
+  void begin(StringRef Name, StringRef Detail) {
+    ThreadTrace &T = getThread();
+    TraceEntry E = {Clock::now(), Duration(), Duration(), T.StackPath.size(),
+                    Name, Detail};
+    if (!T.StackPath.empty())
+      T.StackPath += ';';
+    size_t NameStart = T.StackPath.size();
+    T.StackPath += Name;
+    std::replace(T.StackPath.begin() + NameStart, T.StackPath.end(), ';', ',');
+    T.Stack.push_back(std::move(E));
+  }
+
+  void end() {
+    ThreadTrace &T = getThread();
+    // The scope may have begun before this trace did.
+    if (T.Stack.empty())
+      return;
+    TraceEntry &E = T.Stack.back();
+    E.Elapsed = std::chrono::duration_cast<Duration>(Clock::now() - E.Start);
+
+    // Recursive scopes, such as nested template instantiations, only count
+    // once towards the total of their name.
+    bool Nested = std::any_of(
+        T.Stack.begin(), T.Stack.end() - 1,
+        [&](const TraceEntry &Outer) { return Outer.Name == E.Name; });
+    if (!Nested) {
+      std::pair<unsigned, Duration> &Total = T.Totals[E.Name];
+      ++Total.first;
+      Total.second += E.Elapsed;
+    }
+
+    T.FoldedStacks[T.StackPath] += E.Elapsed - E.Nested;
+    T.StackPath.resize(E.StackPathLength);
+    if (T.Stack.size() > 1)
+      T.Stack[T.Stack.size() - 2].Nested += E.Elapsed;
+
+    if (E.Elapsed >= Granularity) {
+      if (T.Entries.size() < MaxEntriesPerThread) {
+        T.Entries.push_back(std::move(E));
+      } else {
+        T.Entries[T.NextEntry] = std::move(E);
+        T.NextEntry = (T.NextEntry + 1) % MaxEntriesPerThread;
+      }
+    }
+    T.Stack.pop_back();
+  }
+
+  void write(raw_ostream &OS);
+  void writeFolded(raw_ostream &OS);
+
+private:
+  ThreadTrace &getThread() {
+    if (LLVM_LIKELY(CurrentSession == Session))
+      return *CurrentThread;
+
+    sys::ScopedLock Lock(ThreadsLock);
+    Threads.emplace_back(new ThreadTrace(Threads.size()));
+    CurrentThread = Threads.back().get();
+    CurrentSession = Session;
+    return *CurrentThread;
+  }
+
+  sys::Mutex ThreadsLock;
+  std::vector<std::unique_ptr<ThreadTrace>> Threads;
+  Clock::time_point StartTime;
+  Duration Granularity;
+  std::string ProcessName;
+  unsigned Session;
+};
+} // end namespace llvm
+
+TimeTraceProfiler *llvm::TimeTraceProfilerInstance = nullptr;
+
+static void writeJSONString(raw_ostream &OS, StringRef Str) {
+  OS << '"';
+  for (unsigned char C : Str) {
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << format("\\u%04x", C);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+/// Write \p D in microseconds, the unit of Chrome traces.
+static void writeMicroseconds(raw_ostream &OS, Duration D) {
+  uint64_t NS = D.count();
+  OS << NS / 1000 << '.' << format("%03u", unsigned(NS % 1000));
+}
+
+void TimeTraceProfiler::write(raw_ostream &OS) {
+  sys::ScopedLock Lock(ThreadsLock);
+  OS << "{\"traceEvents\":[\n";
+  llvm::StringMap<std::pair<unsigned, Duration>> Totals;
+  for (const auto &T : Threads) {
+    for (const TraceEntry &E : T->Entries) {
+      OS << "{\"pid\":1,\"tid\":" << T->Tid << ",\"ph\":\"X\",\"ts\":";
+      writeMicroseconds(OS, E.Start - StartTime);
+      OS << ",\"dur\":";
+      writeMicroseconds(OS, E.Elapsed);
+      OS << ",\"name\":";
+      writeJSONString(OS, E.Name);
+      OS << ",\"args\":{\"detail\":";
+      writeJSONString(OS, E.Detail);
+      OS << "}},\n";
+    }
+    for (const auto &Total : T->Totals) {
+      std::pair<unsigned, Duration> &Sum = Totals[Total.getKey()];
+      Sum.first += Total.getValue().first;
+      Sum.second += Total.getValue().second;
+    }
+  }
+
+  // Show the totals on their own rows below the threads, the most expensive
+  // first.
+  std::vector<const llvm::StringMapEntry<std::pair<unsigned, Duration>> *>
+      SortedTotals;
+  for (const auto &Total : Totals)
+    SortedTotals.push_back(&Total);
+  std::sort(SortedTotals.begin(), SortedTotals.end(),
+            [](const llvm::StringMapEntry<std::pair<unsigned, Duration>> *A,
+               const llvm::StringMapEntry<std::pair<unsigned, Duration>> *B) {
+    if (A->getValue().second != B->getValue().second)
+      return A->getValue().second > B->getValue().second;
+    return A->getKey() < B->getKey();
+  });
+  unsigned Row = std::max<size_t>(Threads.size(), 1);
+  for (const auto *Total : SortedTotals) {
+    unsigned Count = Total->getValue().first;
+    Duration Elapsed = Total->getValue().second;
+    OS << "{\"pid\":1,\"tid\":" << Row++ << ",\"ph\":\"X\",\"ts\":0,\"dur\":";
+    writeMicroseconds(OS, Elapsed);
+    OS << ",\"name\":";
+    writeJSONString(OS, "Total " + Total->getKey().str());
+    OS << ",\"args\":{\"count\":" << Count << ",\"avg ms\":"
+       << format("%.3f", Elapsed.count() / 1e6 / Count) << "}},\n";
+  }
+
+  OS << "{\"pid\":1,\"tid\":0,\"ph\":\"M\",\"ts\":0,\"name\":\"process_name\","
+        "\"args\":{\"name\":";
+  writeJSONString(OS, ProcessName);
+  OS << "}}\n";
+  OS << "]}\n";
+}
+
+void TimeTraceProfiler::writeFolded(raw_ostream &OS) {
+  sys::ScopedLock Lock(ThreadsLock);
+  llvm::StringMap<Duration> FoldedStacks;
+  for (const auto &T : Threads)
+    for (const auto &Stack : T->FoldedStacks)
+      FoldedStacks[Stack.getKey()] += Stack.getValue();
+
+  std::vector<const llvm::StringMapEntry<Duration> *> Sorted;
+  for (const auto &Stack : FoldedStacks)
+    Sorted.push_back(&Stack);
+  std::sort(Sorted.begin(), Sorted.end(),
+            [](const llvm::StringMapEntry<Duration> *A,
+               const llvm::StringMapEntry<Duration> *B) {
+    return A->getKey() < B->getKey();
+  });
+  for (const auto *Stack : Sorted) {
+    uint64_t US =
+        std::chrono::duration_cast<std::chrono::microseconds>(Stack->getValue())
+            .count();
+    if (US)
+      OS << Stack->getKey() << ' ' << US << '\n';
+  }
+}
+
+void llvm::timeTraceProfilerInitialize(unsigned GranularityUS,
+                                       StringRef ProcessName) {
+  assert(!TimeTraceProfilerInstance && "time trace already recorded");
+  TimeTraceProfilerInstance = new TimeTraceProfiler(GranularityUS, ProcessName);
+}
+
+void llvm::timeTraceProfilerCleanup() {
+  delete TimeTraceProfilerInstance;
+  TimeTraceProfilerInstance = nullptr;
+}
+
+void llvm::timeTraceProfilerWrite(raw_ostream &OS) {
+  assert(TimeTraceProfilerInstance && "no time trace recorded");
+  TimeTraceProfilerInstance->write(OS);
+}
+
+void llvm::timeTraceProfilerWriteFolded(raw_ostream &OS) {
+  assert(TimeTraceProfilerInstance && "no time trace recorded");
+  TimeTraceProfilerInstance->writeFolded(OS);
+}
+
+void llvm::timeTraceProfilerBegin(StringRef Name, StringRef Detail) {
+  if (TimeTraceProfilerInstance)
+    TimeTraceProfilerInstance->begin(Name, Detail);
+}
+
+void llvm::timeTraceProfilerEnd() {
+  if (TimeTraceProfilerInstance)
+    TimeTraceProfilerInstance->end();
+}
@@ -0,0 +1,106 @@
+//===-- TrigramIndex.cpp - a heuristic for SpecialCaseList ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// TrigramIndex implements a heuristic for SpecialCaseList that allows to
+// filter out ~99% incoming queries when all regular expressions in the
+// SpecialCaseList are simple wildcards with '*' and '.'. If rules are more
+// complicated, the check is defeated and it will always pass the queries to a
+// full regex.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/TrigramIndex.h"
+#include "llvm/ADT/SmallSet.h"
+#include <cctype>
+#include <cstring>
+
+using namespace llvm;
+
+static const char RegexAdvancedMetachars[] = "()^$|+?[]{}";
+
+static bool isAdvancedMetachar(unsigned Char) {
+  return Char && strchr(RegexAdvancedMetachars, Char) != nullptr;
+}
+
+void TrigramIndex::insert(StringRef Regex) {
+  if (Defeated)
+    return;
+  SmallSet<unsigned, 16> Seen;
+  unsigned Tri = 0;
+  unsigned Len = 0;
+  bool Escaped = false;
+  bool AfterDot = false;
+  for (unsigned char Char : Regex) {
+    if (!Escaped) {
+      // Regular expressions allow escaping symbols by preceding them with '\'.
+      if (Char == '\\') {
+        Escaped = true;
+        AfterDot = false;
+        continue;
+      }
+      // '*' after anything but '.' repeats a character that may already be
+      // part of a trigram.
+      if (Char == '*' && !AfterDot) {
+        Defeated = true;
+        return;
+      }
+      AfterDot = Char == '.';
+      if (isAdvancedMetachar(Char)) {
+        Defeated = true;
+        return;
+      }
+      // '.' and ".*" match any character, so no trigram crosses them.
+      if (Char == '.' || Char == '*') {
+        Tri = 0;
+        Len = 0;
+        continue;
+      }
+    } else if (isalnum(Char)) {
+      // Back-references and other escapes that aren't a literal character.
+      Defeated = true;
+      return;
+    }
+    Escaped = false;
+    AfterDot = false;
+    Tri = ((Tri << 8) + Char) & 0xFFFFFF;
+    if (++Len < 3 || !Seen.insert(Tri).second)
+      continue;
+    Index[Tri].push_back(Counts.size());
+  }
+  // A rule without trigrams may match any query.
+  if (Seen.empty()) {
+    Defeated = true;
+    return;
+  }
+  Counts.push_back(Seen.size());
+}
+
+bool TrigramIndex::isDefinitelyOut(StringRef Query) const {
+  if (Defeated)
+    return false;
+  std::vector<unsigned> CurCounts(Counts.size());
+  unsigned Tri = 0;
+  for (size_t I = 0; I < Query.size(); ++I) {
+    Tri = ((Tri << 8) + (unsigned char)Query[I]) & 0xFFFFFF;
+    if (I < 2)
+      continue;
+    auto It = Index.find(Tri);
+    if (It == Index.end())
+      continue;
+    // A trigram the query repeats is counted again, which only makes the
+    // check more conservative.
+    for (unsigned Rule : It->second) {
+      // Once a rule has seen as many trigrams as it has, the query may match
+      // it and has to go through the full regex.
+      if (++CurCounts[Rule] >= Counts[Rule])
+        return false;
+    }
+  }
+  return true;
+}
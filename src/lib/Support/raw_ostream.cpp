@@ -105,19 +105,53 @@ void raw_ostream::SetBufferAndMode(char *BufferStart, size_t Size,
   assert(OutBufStart <= OutBufEnd && "Invalid size!");
 }
 
-raw_ostream &raw_ostream::operator<<(unsigned long N) {
-  // Zero is a special case.
-  if (N == 0)
-    return *this << '0';
+// The two digits of each number below 100, so that decimals format two digits
+// per division.
+static const char DecimalDigitPairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536"
+    "37383940414243444546474849505152535455565758596061626364656667686970717273"
+    "7475767778798081828384858687888990919293949596979899";
+
+template <typename UIntT> static char *formatDecimalImpl(UIntT N, char *End) {
+  while (N >= 100) {
+    unsigned Pair = unsigned(N % 100);
+    N /= 100;
+    End -= 2;
+    memcpy(End, &DecimalDigitPairs[2 * Pair], 2);
+  }
+  if (N >= 10) {
+    End -= 2;
+    memcpy(End, &DecimalDigitPairs[2 * N], 2);
+  } else {
+    *--End = char('0' + N);
+  }
+  return End;
+}
+
+/// Format \p N in decimal into the characters that end at \p End, and return
+/// where they start.  There must be room for 20 characters.
+static char *formatDecimal(uint64_t N, char *End) {
+  // Divisions by constants are much cheaper in 32 bits.
+  if (N == static_cast<uint32_t>(N))
+    return formatDecimalImpl(static_cast<uint32_t>(N), End);
+  return formatDecimalImpl(N, End);
+}
+
+/// Format \p N in hexadecimal into the characters that end at \p End, and
+/// return where they start.  There must be room for 16 characters.
+static char *formatHex(uint64_t N, char *End, bool Upper) {
+  const char *Digits = Upper ? "0123456789ABCDEF" : "0123456789abcdef";
+  do {
+    *--End = Digits[N & 15];
+    N >>= 4;
+  } while (N);
+  return End;
+}
 
+raw_ostream &raw_ostream::operator<<(unsigned long N) {
   char NumberBuffer[20];
   char *EndPtr = NumberBuffer+sizeof(NumberBuffer);
-  char *CurPtr = EndPtr;
-
-  while (N) {
-    *--CurPtr = '0' + char(N % 10);
-    N /= 10;
-  }
+  char *CurPtr = formatDecimal(N, EndPtr);
   return write(CurPtr, EndPtr-CurPtr);
 }
 
@@ -132,18 +166,9 @@ raw_ostream &raw_ostream::operator<<(long N) {
 }
 
 raw_ostream &raw_ostream::operator<<(unsigned long long N) {
-  // Output using 32-bit div/mod when possible.
-  if (N == static_cast<unsigned long>(N))
-    return this->operator<<(static_cast<unsigned long>(N));
-
   char NumberBuffer[20];
   char *EndPtr = NumberBuffer+sizeof(NumberBuffer);
-  char *CurPtr = EndPtr;
-
-  while (N) {
-    *--CurPtr = '0' + char(N % 10);
-    N /= 10;
-  }
+  char *CurPtr = formatDecimal(N, EndPtr);
   return write(CurPtr, EndPtr-CurPtr);
 }
 
@@ -158,20 +183,9 @@ raw_ostream &raw_ostream::operator<<(long long N) {
 }
 
 raw_ostream &raw_ostream::write_hex(unsigned long long N) {
-  // Zero is a special case.
-  if (N == 0)
-    return *this << '0';
-
-  char NumberBuffer[20];
+  char NumberBuffer[16];
   char *EndPtr = NumberBuffer+sizeof(NumberBuffer);
-  char *CurPtr = EndPtr;
-
-  while (N) {
-    uintptr_t x = N % 16;
-    *--CurPtr = (x < 10 ? '0' + x : 'a' + x - 10);
-    N /= 16;
-  }
-
+  char *CurPtr = formatHex(N, EndPtr, /*Upper=*/false);
   return write(CurPtr, EndPtr-CurPtr);
 }
 
@@ -324,6 +338,15 @@ raw_ostream &raw_ostream::write(const char *Ptr, size_t Size) {
       return *this;
     }
 
+    // A string at least as large as the buffer goes out with the buffered
+    // data in one call, rather than through the buffer.
+    if (Size >= size_t(OutBufEnd - OutBufStart)) {
+      size_t Length = OutBufCur - OutBufStart;
+      OutBufCur = OutBufStart;
+      writev_impl(OutBufStart, Length, Ptr, Size);
+      return *this;
+    }
+
     // We don't have enough space in the buffer to fit the string in. Insert as
     // much as possible, flush and start over with the remainder.
     copy_to_buffer(Ptr, NumBytes);
@@ -336,6 +359,12 @@ raw_ostream &raw_ostream::write(const char *Ptr, size_t Size) {
   return *this;
 }
 
+void raw_ostream::writev_impl(const char *Ptr1, size_t Size1,
+                              const char *Ptr2, size_t Size2) {
+  write_impl(Ptr1, Size1);
+  write_impl(Ptr2, Size2);
+}
+
 void raw_ostream::copy_to_buffer(const char *Ptr, size_t Size) {
   assert(Size <= size_t(OutBufEnd - OutBufCur) && "Buffer overrun!");
 
@@ -416,32 +445,16 @@ raw_ostream &raw_ostream::operator<<(const FormattedNumber &FN) {
     char NumberBuffer[20] = "0x0000000000000000";
     if (!FN.HexPrefix)
       NumberBuffer[1] = '0';
-    char *EndPtr = NumberBuffer+Width;
-    char *CurPtr = EndPtr;
-    const char A = FN.Upper ? 'A' : 'a';
-    unsigned long long N = FN.HexValue;
-    while (N) {
-      uintptr_t x = N % 16;
-      *--CurPtr = (x < 10 ? '0' + x : A + x - 10);
-      N /= 16;
-    }
+    if (FN.HexValue)
+      formatHex(FN.HexValue, NumberBuffer+Width, FN.Upper);
 
     return write(NumberBuffer, Width);
   } else {
-    // Zero is a special case.
-    if (FN.DecValue == 0) {
-      this->indent(FN.Width-1);
-      return *this << '0';
-    }
-    char NumberBuffer[32];
+    char NumberBuffer[20];
     char *EndPtr = NumberBuffer+sizeof(NumberBuffer);
-    char *CurPtr = EndPtr;
     bool Neg = (FN.DecValue < 0);
     uint64_t N = Neg ? -static_cast<uint64_t>(FN.DecValue) : FN.DecValue;
-    while (N) {
-      *--CurPtr = '0' + char(N % 10);
-      N /= 10;
-    }
+    char *CurPtr = formatDecimal(N, EndPtr);
     int Len = EndPtr - CurPtr;
     int Pad = FN.Width - Len;
     if (Neg) 
@@ -561,6 +574,21 @@ raw_fd_ostream::~raw_fd_ostream() {
 }
 
 
+/// Return whether a write that failed should be retried.
+static bool isRecoverableWriteError() {
+  // Ideally we wouldn't ever see EAGAIN or EWOULDBLOCK here, since
+  // raw_ostream isn't designed to do non-blocking I/O. However, some
+  // programs, such as old versions of bjam, have mistakenly used
+  // O_NONBLOCK. For compatibility, emulate blocking semantics by
+  // spinning until the write succeeds. If you don't want spinning,
+  // don't use O_NONBLOCK file descriptors with raw_ostream.
+  return errno == EINTR || errno == EAGAIN
+#ifdef EWOULDBLOCK
+         || errno == EWOULDBLOCK
+#endif
+      ;
+}
+
 void raw_fd_ostream::write_impl(const char *Ptr, size_t Size) {
   assert(FD >= 0 && "File already closed.");
   pos += Size;
@@ -584,18 +612,7 @@ void raw_fd_ostream::write_impl(const char *Ptr, size_t Size) {
 
     if (ret < 0) {
       // If it's a recoverable error, swallow it and retry the write.
-      //
-      // Ideally we wouldn't ever see EAGAIN or EWOULDBLOCK here, since
-      // raw_ostream isn't designed to do non-blocking I/O. However, some
-      // programs, such as old versions of bjam, have mistakenly used
-      // O_NONBLOCK. For compatibility, emulate blocking semantics by
-      // spinning until the write succeeds. If you don't want spinning,
-      // don't use O_NONBLOCK file descriptors with raw_ostream.
-      if (errno == EINTR || errno == EAGAIN
-#ifdef EWOULDBLOCK
-          || errno == EWOULDBLOCK
-#endif
-          )
+      if (isRecoverableWriteError())
         continue;
 
       // Otherwise it's a non-recoverable error. Note it and quit.
@@ -611,6 +628,38 @@ void raw_fd_ostream::write_impl(const char *Ptr, size_t Size) {
   } while (Size > 0);
 }
 
+void raw_fd_ostream::writev_impl(const char *Ptr1, size_t Size1,
+                                 const char *Ptr2, size_t Size2) {
+#if defined(HAVE_WRITEV)
+  assert(FD >= 0 && "File already closed.");
+  struct iovec IOV[2] = {
+    { const_cast<char *>(Ptr1), Size1 },
+    { const_cast<char *>(Ptr2), Size2 }
+  };
+  ssize_t ret;
+  do
+    ret = ::writev(FD, IOV, 2);
+  while (ret < 0 && isRecoverableWriteError());
+  if (ret < 0) {
+    pos += Size1 + Size2;
+    error_detected();
+    return;
+  }
+  pos += ret;
+
+  // Write what a short write left the slow way.
+  size_t Written = ret;
+  if (Written < Size1) {
+    write_impl(Ptr1 + Written, Size1 - Written);
+    write_impl(Ptr2, Size2);
+  } else if (Written < Size1 + Size2) {
+    write_impl(Ptr2 + (Written - Size1), Size2 - (Written - Size1));
+  }
+#else
+  raw_ostream::writev_impl(Ptr1, Size1, Ptr2, Size2);
+#endif
+}
+
 void raw_fd_ostream::close() {
   assert(ShouldClose);
   ShouldClose = false;
@@ -641,8 +690,10 @@ size_t raw_fd_ostream::preferred_buffer_size() const {
   // the complexity.
   if (S_ISCHR(statbuf.st_mode) && isatty(FD))
     return 0;
-  // Return the preferred block size.
-  return statbuf.st_blksize;
+  // Return the preferred block size, but buffer at least 64KiB: the streams
+  // that write the most, like assembly, bitcode and preprocessed output, then
+  // make far fewer system calls, for little memory.
+  return std::max<size_t>(statbuf.st_blksize, 64 * 1024);
 #else
   return raw_ostream::preferred_buffer_size();
 #endif
@@ -0,0 +1,106 @@
+//===- xxhash.cpp - 64-bit xxHash -----------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the 64-bit variant of xxHash, following the reference
+// implementation at https://github.com/Cyan4973/xxHash, which is
+// Copyright (C) 2012-2016, Yann Collet, and distributed under the BSD
+// 2-Clause License.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/xxhash.h"
+#include "llvm/Support/Endian.h"
+
+using namespace llvm;
+using namespace support;
+
+static const uint64_t Prime64_1 = 11400714785074694791ULL;
+static const uint64_t Prime64_2 = 14029467366897019727ULL;
+static const uint64_t Prime64_3 = 1609587929392839161ULL;
+static const uint64_t Prime64_4 = 9650029242287828579ULL;
+static const uint64_t Prime64_5 = 2870177450012600261ULL;
+
+static uint64_t rotl64(uint64_t X, unsigned R) {
+  return (X << R) | (X >> (64 - R));
+}
+
+static uint64_t read64(const char *P) {
+  return endian::read<uint64_t, little, unaligned>(P);
+}
+
+static uint64_t read32(const char *P) {
+  return endian::read<uint32_t, little, unaligned>(P);
+}
+
+static uint64_t mixLane(uint64_t Acc, uint64_t Input) {
+  Acc += Input * Prime64_2;
+  Acc = rotl64(Acc, 31);
+  return Acc * Prime64_1;
+}
+
+static uint64_t mergeRound(uint64_t Acc, uint64_t Val) {
+  Acc ^= mixLane(0, Val);
+  return Acc * Prime64_1 + Prime64_4;
+}
+
+uint64_t llvm::xxHash64(StringRef Data, uint64_t Seed) {
+  const char *P = Data.data();
+  const char *const End = P + Data.size();
+  uint64_t H64;
+
+  if (Data.size() >= 32) {
+    // Hash 32-byte stripes into four independent lanes, which keeps the
+    // multipliers busy.
+    const char *const Limit = End - 32;
+    uint64_t V1 = Seed + Prime64_1 + Prime64_2;
+    uint64_t V2 = Seed + Prime64_2;
+    uint64_t V3 = Seed;
+    uint64_t V4 = Seed - Prime64_1;
+    do {
+      V1 = mixLane(V1, read64(P));
+      V2 = mixLane(V2, read64(P + 8));
+      V3 = mixLane(V3, read64(P + 16));
+      V4 = mixLane(V4, read64(P + 24));
+      P += 32;
+    } while (P <= Limit);
+
+    H64 = rotl64(V1, 1) + rotl64(V2, 7) + rotl64(V3, 12) + rotl64(V4, 18);
+    H64 = mergeRound(H64, V1);
+    H64 = mergeRound(H64, V2);
+    H64 = mergeRound(H64, V3);
+    H64 = mergeRound(H64, V4);
+  } else {
+    H64 = Seed + Prime64_5;
+  }
+
+  H64 += (uint64_t)Data.size();
+
+  for (; P + 8 <= End; P += 8) {
+    H64 ^= mixLane(0, read64(P));
+    H64 = rotl64(H64, 27) * Prime64_1 + Prime64_4;
+  }
+
+  if (P + 4 <= End) {
+    H64 ^= read32(P) * Prime64_1;
+    H64 = rotl64(H64, 23) * Prime64_2 + Prime64_3;
+    P += 4;
+  }
+
+  for (; P != End; ++P) {
+    H64 ^= (uint8_t)*P * Prime64_5;
+    H64 = rotl64(H64, 11) * Prime64_1;
+  }
+
+  H64 ^= H64 >> 33;
+  H64 *= Prime64_2;
+  H64 ^= H64 >> 29;
+  H64 *= Prime64_3;
+  H64 ^= H64 >> 32;
+  return H64;
+}
@@ -16,6 +16,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "TGParser.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -26,6 +27,11 @@
 #include <algorithm>
 #include <cstdio>
 #include <system_error>
+#include <thread>
+#ifdef LLVM_ON_UNIX
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 using namespace llvm;
 
 namespace {
@@ -45,16 +51,45 @@ namespace {
   cl::list<std::string>
   IncludeDirs("I", cl::desc("Directory of include files"),
               cl::value_desc("directory"), cl::Prefix);
+
+  cl::list<std::string>
+  EmitBackends("emit",
+               cl::desc("Run the backend that an action option selects and "
+                        "write its output to a file, e.g. "
+                        "-emit=gen-instr-info:GenInstrInfo.inc; the records "
+                        "are parsed once for all of them"),
+               cl::value_desc("action:filename"));
+
+  cl::opt<unsigned>
+  EmitJobs("emit-jobs",
+           cl::desc("How many -emit backends to run at once (default: one "
+                    "per hardware thread)"),
+           cl::value_desc("N"), cl::init(0));
+
+  cl::opt<bool>
+  WriteIfChanged("write-if-changed",
+                 cl::desc("Leave the outputs whose contents didn't change "
+                          "untouched, with their time stamps"));
+
+/// A backend to run: the action option that selects it, if it isn't the one
+/// on the command line, and the file its output goes to.
+struct Backend {
+  StringRef Action;
+  StringRef Filename;
+};
 }
 
 /// \brief Create a dependency file for `-d` option.
 ///
 /// This functionality is really only for the benefit of the build system.
 /// It is similar to GCC's `-M*` family of options.
-static int createDependencyFile(const TGParser &Parser, const char *argv0) {
-  if (OutputFilename == "-") {
-    errs() << argv0 << ": the option -d must be used together with -o\n";
-    return 1;
+static int createDependencyFile(const TGParser &Parser, const char *argv0,
+                                ArrayRef<Backend> Backends) {
+  for (const Backend &B : Backends) {
+    if (B.Filename == "-") {
+      errs() << argv0 << ": the option -d must be used together with -o\n";
+      return 1;
+    }
   }
   std::error_code EC;
   tool_output_file DepOut(DependFilename, EC, sys::fs::F_Text);
@@ -63,7 +98,8 @@ static int createDependencyFile(const TGParser &Parser, const char *argv0) {
            << EC.message() << "\n";
     return 1;
   }
-  DepOut.os() << OutputFilename << ":";
+  for (const Backend &B : Backends)
+    DepOut.os() << B.Filename << (&B == &Backends.back() ? ":" : " ");
   for (const auto &Dep : Parser.getDependencies()) {
     DepOut.os() << ' ' << Dep.first;
   }
@@ -72,6 +108,111 @@ static int createDependencyFile(const TGParser &Parser, const char *argv0) {
   return 0;
 }
 
+/// Select the backend that the action option \p Action names, as if it were
+/// on the command line.
+static bool selectBackend(const char *argv0, StringRef Action) {
+  cl::Option *O = cl::getRegisteredOptions().lookup(Action);
+  // The actions are the values of an option without a name.
+  if (!O || O->hasArgStr() ||
+      O->getValueExpectedFlag() != cl::ValueDisallowed) {
+    errs() << argv0 << ": '" << Action << "' doesn't select a backend\n";
+    return true;
+  }
+  // Add the value as part of an occurrence, so that an action option that may
+  // only occur once can select several backends in turn.
+  return O->addOccurrence(O->getPosition(), Action, StringRef(),
+                          /*MultiArg=*/true);
+}
+
+/// Write \p Contents to \p Filename, unless -write-if-changed is given and
+/// the file already holds them.
+static int writeOutput(const char *argv0, StringRef Filename,
+                       StringRef Contents) {
+  if (WriteIfChanged && Filename != "-") {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> Old = MemoryBuffer::getFile(
+        Filename, /*FileSize=*/-1, /*RequiresNullTerminator=*/false);
+    if (Old && (*Old)->getBuffer() == Contents)
+      return 0;
+  }
+
+  std::error_code EC;
+  tool_output_file Out(Filename, EC, sys::fs::F_Text);
+  if (EC) {
+    errs() << argv0 << ": error opening " << Filename << ":"
+           << EC.message() << "\n";
+    return 1;
+  }
+  Out.os() << Contents;
+  Out.keep();
+  return 0;
+}
+
+static int runBackend(const char *argv0, TableGenMainFn *MainFn,
+                      RecordKeeper &Records, const Backend &B) {
+  if (!B.Action.empty() && selectBackend(argv0, B.Action))
+    return 1;
+
+  // The output is only written once the backend succeeded, so that a failed
+  // run leaves no partial file behind.
+  std::string Output;
+  raw_string_ostream OS(Output);
+  if (MainFn(OS, Records))
+    return 1;
+
+  if (ErrorsPrinted > 0) {
+    errs() << argv0 << ": " << ErrorsPrinted << " errors.\n";
+    return 1;
+  }
+
+  return writeOutput(argv0, B.Filename, OS.str());
+}
+
+/// Run the backends, up to \p Jobs at once.
+static int runBackends(const char *argv0, TableGenMainFn *MainFn,
+                       RecordKeeper &Records, ArrayRef<Backend> Backends,
+                       unsigned Jobs) {
+#ifdef LLVM_ON_UNIX
+  // The records and the values they hold are shared and uniqued without
+  // locks, so the backends run in processes of their own, which share the
+  // parsed records until they write to them.
+  if (Jobs > 1 && Backends.size() > 1) {
+    outs().flush();
+    errs().flush();
+    unsigned Running = 0;
+    bool Failed = false;
+    size_t Next = 0;
+    while (Running || (Next != Backends.size() && !Failed)) {
+      if (Running < Jobs && Next != Backends.size() && !Failed) {
+        pid_t Child = fork();
+        if (Child == 0)
+          _exit(runBackend(argv0, MainFn, Records, Backends[Next]));
+        if (Child > 0) {
+          ++Running;
+          ++Next;
+          continue;
+        }
+        // Without a process to spare, wait for one, or run the backend here.
+        if (!Running) {
+          Failed |= runBackend(argv0, MainFn, Records, Backends[Next++]) != 0;
+          continue;
+        }
+      }
+      int Status;
+      if (waitpid(-1, &Status, 0) < 0)
+        return 1;
+      --Running;
+      Failed |= !WIFEXITED(Status) || WEXITSTATUS(Status) != 0;
+    }
+    return Failed;
+  }
+#endif
+
+  for (const Backend &B : Backends)
+    if (int Ret = runBackend(argv0, MainFn, Records, B))
+      return Ret;
+  return 0;
+}
+
 namespace llvm {
 
 int TableGenMain(char *argv0, TableGenMainFn *MainFn) {
@@ -98,29 +239,29 @@ int TableGenMain(char *argv0, TableGenMainFn *MainFn) {
   if (Parser.ParseFile())
     return 1;
 
-  std::error_code EC;
-  tool_output_file Out(OutputFilename, EC, sys::fs::F_Text);
-  if (EC) {
-    errs() << argv0 << ": error opening " << OutputFilename << ":"
-           << EC.message() << "\n";
-    return 1;
+  // Without -emit, run the backend the command line selects into -o.
+  SmallVector<Backend, 16> Backends;
+  for (StringRef Emit : EmitBackends) {
+    std::pair<StringRef, StringRef> ActionAndFile = Emit.split(':');
+    if (ActionAndFile.second.empty()) {
+      errs() << argv0 << ": -emit needs an action and a file: " << Emit
+             << "\n";
+      return 1;
+    }
+    Backends.push_back({ActionAndFile.first, ActionAndFile.second});
   }
+  if (Backends.empty())
+    Backends.push_back({StringRef(), OutputFilename});
+
   if (!DependFilename.empty()) {
-    if (int Ret = createDependencyFile(Parser, argv0))
+    if (int Ret = createDependencyFile(Parser, argv0, Backends))
       return Ret;
   }
 
-  if (MainFn(Out.os(), Records))
-    return 1;
-
-  if (ErrorsPrinted > 0) {
-    errs() << argv0 << ": " << ErrorsPrinted << " errors.\n";
-    return 1;
-  }
-
-  // Declare success.
-  Out.keep();
-  return 0;
+  unsigned Jobs = EmitJobs;
+  if (!Jobs)
+    Jobs = std::max(1u, std::thread::hardware_concurrency());
+  return runBackends(argv0, MainFn, Records, Backends, Jobs);
 }
 
 }
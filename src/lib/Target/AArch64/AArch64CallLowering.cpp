@@ -0,0 +1,97 @@
+//===-- llvm/lib/Target/AArch64/AArch64CallLowering.cpp - Call lowering ---===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements the lowering of LLVM calls to machine code calls for
+/// the global instruction selector.
+///
+//===----------------------------------------------------------------------===//
+
+#include "AArch64CallLowering.h"
+#include "AArch64ISelLowering.h"
+#include "MCTargetDesc/AArch64MCTargetDesc.h"
+#include "llvm/CodeGen/CallingConvLower.h"
+#include "llvm/CodeGen/GlobalISel/MachineIRBuilder.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+
+using namespace llvm;
+
+AArch64CallLowering::AArch64CallLowering(const AArch64TargetLowering &TLI)
+    : CallLowering(&TLI) {}
+
+bool AArch64CallLowering::lowerReturn(MachineIRBuilder &MIRBuilder,
+                                      const Value *Val, unsigned VReg) const {
+  MachineFunction &MF = MIRBuilder.getMF();
+  if (!Val) {
+    MIRBuilder.buildInstr(AArch64::RET_ReallyLR);
+    return true;
+  }
+
+  // Integers and pointers of 32 and 64 bits are returned in W0 and X0.
+  if (!Val->getType()->isIntegerTy() && !Val->getType()->isPointerTy())
+    return false;
+  unsigned ResReg;
+  switch (MF.getRegInfo().getSize(VReg)) {
+  default:
+    return false;
+  case 32:
+    ResReg = AArch64::W0;
+    break;
+  case 64:
+    ResReg = AArch64::X0;
+    break;
+  }
+  MIRBuilder.buildInstr(TargetOpcode::COPY, ResReg, VReg);
+  MachineInstr *Ret = MIRBuilder.buildInstr(AArch64::RET_ReallyLR);
+  MachineInstrBuilder(MF, Ret).addReg(ResReg, RegState::Implicit);
+  return true;
+}
+
+bool AArch64CallLowering::lowerFormalArguments(
+    MachineIRBuilder &MIRBuilder, const Function::ArgumentListType &Args,
+    ArrayRef<unsigned> VRegs) const {
+  MachineFunction &MF = MIRBuilder.getMF();
+  const Function &F = *MF.getFunction();
+  if (F.isVarArg())
+    return false;
+
+  const AArch64TargetLowering &TLI = *getTLI<AArch64TargetLowering>();
+  CCAssignFn *AssignFn =
+      TLI.CCAssignFnForCall(F.getCallingConv(), /*IsVarArg=*/false);
+  SmallVector<CCValAssign, 16> ArgLocs;
+  CCState CCInfo(F.getCallingConv(), F.isVarArg(), MF, ArgLocs,
+                 F.getContext());
+
+  unsigned i = 0;
+  for (const Argument &Arg : Args) {
+    EVT VT = TLI.getValueType(Arg.getType(), /*AllowUnknown=*/true);
+    if (!VT.isSimple() || !VT.isInteger() || VT.isVector())
+      return false;
+    MVT ValVT = VT.getSimpleVT();
+    if (AssignFn(i++, ValVT, ValVT, CCValAssign::Full, ISD::ArgFlagsTy(),
+                 CCInfo))
+      return false;
+  }
+  assert(ArgLocs.size() == VRegs.size() && "Missing argument location");
+
+  MachineRegisterInfo &MRI = MF.getRegInfo();
+  for (unsigned i = 0, e = ArgLocs.size(); i != e; ++i) {
+    const CCValAssign &VA = ArgLocs[i];
+    // Only the arguments passed in a register of their own size are supported
+    // for now.
+    if (!VA.isRegLoc() || VA.getLocInfo() != CCValAssign::Full)
+      return false;
+    unsigned PhysReg = VA.getLocReg();
+    MRI.addLiveIn(PhysReg);
+    MIRBuilder.getMBB().addLiveIn(PhysReg);
+    MIRBuilder.buildInstr(TargetOpcode::COPY, VRegs[i], PhysReg);
+  }
+  return true;
+}
@@ -3434,7 +3434,12 @@ bool AArch64FastISel::fastLowerIntrinsicCall(const IntrinsicInst *II) {
   }
   case Intrinsic::sin:
   case Intrinsic::cos:
-  case Intrinsic::pow: {
+  case Intrinsic::pow:
+  case Intrinsic::exp:
+  case Intrinsic::exp2:
+  case Intrinsic::log:
+  case Intrinsic::log2:
+  case Intrinsic::log10: {
     MVT RetVT;
     if (!isTypeLegal(II->getType(), RetVT))
       return false;
@@ -3442,10 +3447,15 @@ bool AArch64FastISel::fastLowerIntrinsicCall(const IntrinsicInst *II) {
     if (RetVT != MVT::f32 && RetVT != MVT::f64)
       return false;
 
-    static const RTLIB::Libcall LibCallTable[3][2] = {
+    static const RTLIB::Libcall LibCallTable[8][2] = {
       { RTLIB::SIN_F32, RTLIB::SIN_F64 },
       { RTLIB::COS_F32, RTLIB::COS_F64 },
-      { RTLIB::POW_F32, RTLIB::POW_F64 }
+      { RTLIB::POW_F32, RTLIB::POW_F64 },
+      { RTLIB::EXP_F32, RTLIB::EXP_F64 },
+      { RTLIB::EXP2_F32, RTLIB::EXP2_F64 },
+      { RTLIB::LOG_F32, RTLIB::LOG_F64 },
+      { RTLIB::LOG2_F32, RTLIB::LOG2_F64 },
+      { RTLIB::LOG10_F32, RTLIB::LOG10_F64 }
     };
     RTLIB::Libcall LC;
     bool Is64Bit = RetVT == MVT::f64;
@@ -3461,6 +3471,21 @@ bool AArch64FastISel::fastLowerIntrinsicCall(const IntrinsicInst *II) {
     case Intrinsic::pow:
       LC = LibCallTable[2][Is64Bit];
       break;
+    case Intrinsic::exp:
+      LC = LibCallTable[3][Is64Bit];
+      break;
+    case Intrinsic::exp2:
+      LC = LibCallTable[4][Is64Bit];
+      break;
+    case Intrinsic::log:
+      LC = LibCallTable[5][Is64Bit];
+      break;
+    case Intrinsic::log2:
+      LC = LibCallTable[6][Is64Bit];
+      break;
+    case Intrinsic::log10:
+      LC = LibCallTable[7][Is64Bit];
+      break;
     }
 
     ArgListTy Args;
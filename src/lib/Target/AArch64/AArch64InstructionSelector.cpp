@@ -0,0 +1,96 @@
+//===-- AArch64InstructionSelector.cpp - AArch64 instruction selector -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file implements the selection of generic MachineInstrs into AArch64
+/// instructions for the global instruction selector.
+//===----------------------------------------------------------------------===//
+
+#include "AArch64InstructionSelector.h"
+#include "AArch64InstrInfo.h"
+#include "AArch64RegisterInfo.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+
+#define DEBUG_TYPE "aarch64-isel"
+
+using namespace llvm;
+
+AArch64InstructionSelector::AArch64InstructionSelector(
+    const AArch64InstrInfo &TII, const AArch64RegisterInfo &TRI)
+    : TII(TII), TRI(TRI) {}
+
+/// \brief Return the AArch64 opcode for the generic binary operation
+/// \p GenericOpc on registers of \p Is64Bit, or \p GenericOpc if there is none.
+static unsigned selectBinaryOp(unsigned GenericOpc, bool Is64Bit) {
+  switch (GenericOpc) {
+  case TargetOpcode::G_ADD:
+    return Is64Bit ? AArch64::ADDXrr : AArch64::ADDWrr;
+  case TargetOpcode::G_SUB:
+    return Is64Bit ? AArch64::SUBXrr : AArch64::SUBWrr;
+  case TargetOpcode::G_MUL:
+    return Is64Bit ? AArch64::MADDXrrr : AArch64::MADDWrrr;
+  case TargetOpcode::G_AND:
+    return Is64Bit ? AArch64::ANDXrr : AArch64::ANDWrr;
+  case TargetOpcode::G_OR:
+    return Is64Bit ? AArch64::ORRXrr : AArch64::ORRWrr;
+  case TargetOpcode::G_XOR:
+    return Is64Bit ? AArch64::EORXrr : AArch64::EORWrr;
+  default:
+    return GenericOpc;
+  }
+}
+
+bool AArch64InstructionSelector::select(MachineInstr &I) const {
+  MachineFunction &MF = *I.getParent()->getParent();
+  MachineRegisterInfo &MRI = MF.getRegInfo();
+
+  if (I.getOpcode() == TargetOpcode::G_BR) {
+    I.setDesc(TII.get(AArch64::B));
+    return true;
+  }
+
+  // The remaining generic instructions define a register, whose bank says if
+  // they operate on 32 or 64 bits. The values narrower than 32 bits live in
+  // 32-bit registers, as the low bits of the result of these operations do
+  // not depend on the high bits of the operands.
+  unsigned DefReg = I.getOperand(0).getReg();
+  const TargetRegisterClass *RC = MRI.getRegClass(DefReg);
+  if (!RC)
+    return false;
+  bool Is64Bit = RC->getSize() == 8;
+
+  if (I.getOpcode() == TargetOpcode::G_CONSTANT) {
+    MachineOperand &Imm = I.getOperand(1);
+    if (!Is64Bit)
+      Imm.setImm(static_cast<uint32_t>(Imm.getImm()));
+    I.setDesc(TII.get(Is64Bit ? AArch64::MOVi64imm : AArch64::MOVi32imm));
+  } else {
+    unsigned NewOpc = selectBinaryOp(I.getOpcode(), Is64Bit);
+    if (NewOpc == I.getOpcode())
+      return false;
+    bool IsMul = I.getOpcode() == TargetOpcode::G_MUL;
+    I.setDesc(TII.get(NewOpc));
+    // A multiplication is a multiply-add of the zero register.
+    if (IsMul)
+      MachineInstrBuilder(MF, &I).addReg(Is64Bit ? AArch64::XZR : AArch64::WZR);
+  }
+
+  // Constrain the virtual registers to the classes of the selected opcode.
+  for (unsigned OpI = 0, E = I.getNumExplicitOperands(); OpI != E; ++OpI) {
+    MachineOperand &MO = I.getOperand(OpI);
+    if (!MO.isReg() || !TargetRegisterInfo::isVirtualRegister(MO.getReg()))
+      continue;
+    if (const TargetRegisterClass *OpRC =
+            TII.getRegClass(I.getDesc(), OpI, &TRI, MF))
+      if (!MRI.constrainRegClass(MO.getReg(), OpRC))
+        return false;
+  }
+  return true;
+}
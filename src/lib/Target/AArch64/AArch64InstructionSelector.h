@@ -0,0 +1,36 @@
+//===-- AArch64InstructionSelector.h - AArch64 selector ---------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file declares the selection of generic MachineInstrs into AArch64
+/// instructions for the global instruction selector.
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LIB_TARGET_AARCH64_AARCH64INSTRUCTIONSELECTOR_H
+#define LLVM_LIB_TARGET_AARCH64_AARCH64INSTRUCTIONSELECTOR_H
+
+#include "llvm/CodeGen/GlobalISel/InstructionSelector.h"
+
+namespace llvm {
+
+class AArch64InstrInfo;
+class AArch64RegisterInfo;
+
+class AArch64InstructionSelector : public InstructionSelector {
+  const AArch64InstrInfo &TII;
+  const AArch64RegisterInfo &TRI;
+
+public:
+  AArch64InstructionSelector(const AArch64InstrInfo &TII,
+                             const AArch64RegisterInfo &TRI);
+
+  bool select(MachineInstr &I) const override;
+};
+} // End llvm namespace.
+
+#endif
@@ -0,0 +1,28 @@
+//===-- AArch64RegisterBankInfo.cpp - AArch64 register banks --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file implements the register banks of AArch64 for the global
+/// instruction selector.
+//===----------------------------------------------------------------------===//
+
+#include "AArch64RegisterBankInfo.h"
+#include "AArch64RegisterInfo.h"
+#include "MCTargetDesc/AArch64MCTargetDesc.h"
+
+using namespace llvm;
+
+const TargetRegisterClass *
+AArch64RegisterBankInfo::getRegBankClass(unsigned VReg, unsigned Size,
+                                         const MachineRegisterInfo &MRI) const {
+  if (Size <= 32)
+    return &AArch64::GPR32RegClass;
+  if (Size == 64)
+    return &AArch64::GPR64RegClass;
+  return nullptr;
+}
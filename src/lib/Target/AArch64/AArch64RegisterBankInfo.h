@@ -0,0 +1,31 @@
+//===-- AArch64RegisterBankInfo.h - AArch64 register banks ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file declares the register banks of AArch64 for the global
+/// instruction selector.
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LIB_TARGET_AARCH64_AARCH64REGISTERBANKINFO_H
+#define LLVM_LIB_TARGET_AARCH64_AARCH64REGISTERBANKINFO_H
+
+#include "llvm/CodeGen/GlobalISel/RegisterBankInfo.h"
+
+namespace llvm {
+
+/// \brief The generic instructions that AArch64 selects so far all operate
+/// on the general purpose registers.
+class AArch64RegisterBankInfo : public RegisterBankInfo {
+public:
+  const TargetRegisterClass *
+  getRegBankClass(unsigned VReg, unsigned Size,
+                  const MachineRegisterInfo &MRI) const override;
+};
+} // End llvm namespace.
+
+#endif
@@ -14,9 +14,12 @@
 #ifndef LLVM_LIB_TARGET_AARCH64_AARCH64SUBTARGET_H
 #define LLVM_LIB_TARGET_AARCH64_AARCH64SUBTARGET_H
 
+#include "AArch64CallLowering.h"
 #include "AArch64FrameLowering.h"
 #include "AArch64ISelLowering.h"
 #include "AArch64InstrInfo.h"
+#include "AArch64InstructionSelector.h"
+#include "AArch64RegisterBankInfo.h"
 #include "AArch64RegisterInfo.h"
 #include "AArch64SelectionDAGInfo.h"
 #include "llvm/IR/DataLayout.h"
@@ -64,6 +67,10 @@ protected:
   AArch64InstrInfo InstrInfo;
   AArch64SelectionDAGInfo TSInfo;
   AArch64TargetLowering TLInfo;
+  // The hooks of the global instruction selector.
+  AArch64CallLowering CallLoweringInfo;
+  AArch64RegisterBankInfo RegBankInfo;
+  AArch64InstructionSelector InstSelector;
 private:
   /// initializeSubtargetDependencies - Initializes using CPUString and the
   /// passed in feature string so that we can use initializer lists for
@@ -87,6 +94,15 @@ public:
     return &TLInfo;
   }
   const AArch64InstrInfo *getInstrInfo() const override { return &InstrInfo; }
+  const CallLowering *getCallLowering() const override {
+    return &CallLoweringInfo;
+  }
+  const RegisterBankInfo *getRegBankInfo() const override {
+    return &RegBankInfo;
+  }
+  const InstructionSelector *getInstructionSelector() const override {
+    return &InstSelector;
+  }
   const AArch64RegisterInfo *getRegisterInfo() const override {
     return &getInstrInfo()->getRegisterInfo();
   }
@@ -406,6 +406,30 @@ unsigned AArch64TTIImpl::getMemoryOpCost(unsigned Opcode, Type *Src,
   return LT.first;
 }
 
+unsigned AArch64TTIImpl::getInterleavedMemoryOpCost(
+    unsigned Opcode, Type *VecTy, unsigned Factor, ArrayRef<unsigned> Indices,
+    unsigned Alignment, unsigned AddressSpace) {
+  assert(Factor >= 2 && "Invalid interleave factor");
+  assert(isa<VectorType>(VecTy) && "Expect a vector type");
+
+  // A factor 2 group of 64 or 128-bit NEON vectors is split or merged with one
+  // uzp or zip per member.
+  unsigned NumElts = VecTy->getVectorNumElements();
+  if (Factor == 2 && NumElts % Factor == 0) {
+    Type *SubVecTy = VectorType::get(VecTy->getScalarType(), NumElts / Factor);
+    unsigned SubVecSize = SubVecTy->getPrimitiveSizeInBits();
+    if ((SubVecSize == 64 || SubVecSize == 128) && isTypeLegal(SubVecTy)) {
+      unsigned NumShuffles =
+          Opcode == Instruction::Load ? Indices.size() : Factor;
+      return getMemoryOpCost(Opcode, VecTy, Alignment, AddressSpace) +
+             NumShuffles;
+    }
+  }
+
+  return BaseT::getInterleavedMemoryOpCost(Opcode, VecTy, Factor, Indices,
+                                           Alignment, AddressSpace);
+}
+
 unsigned AArch64TTIImpl::getCostOfKeepingLiveOverCall(ArrayRef<Type *> Tys) {
   unsigned Cost = 0;
   for (auto *I : Tys) {
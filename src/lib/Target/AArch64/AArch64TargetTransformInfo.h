@@ -112,6 +112,8 @@ public:
 
   unsigned getMaxInterleaveFactor();
 
+  bool enableInterleavedAccessVectorization() { return true; }
+
   unsigned getCastInstrCost(unsigned Opcode, Type *Dst, Type *Src);
 
   unsigned getVectorInstrCost(unsigned Opcode, Type *Val, unsigned Index);
@@ -130,6 +132,12 @@ public:
   unsigned getMemoryOpCost(unsigned Opcode, Type *Src, unsigned Alignment,
                            unsigned AddressSpace);
 
+  unsigned getInterleavedMemoryOpCost(unsigned Opcode, Type *VecTy,
+                                      unsigned Factor,
+                                      ArrayRef<unsigned> Indices,
+                                      unsigned Alignment,
+                                      unsigned AddressSpace);
+
   unsigned getCostOfKeepingLiveOverCall(ArrayRef<Type *> Tys);
 
   void getUnrollingPreferences(Loop *L, TTI::UnrollingPreferences &UP);
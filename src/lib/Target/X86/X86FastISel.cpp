@@ -2212,13 +2212,16 @@ bool X86FastISel::fastLowerIntrinsicCall(const IntrinsicInst *II) {
     updateValueMap(II, SrcReg);
     return true;
   }
-  case Intrinsic::memcpy: {
-    const MemCpyInst *MCI = cast<MemCpyInst>(II);
+  case Intrinsic::memcpy:
+  case Intrinsic::memmove: {
+    const MemTransferInst *MCI = cast<MemTransferInst>(II);
     // Don't handle volatile or variable length memcpys.
     if (MCI->isVolatile())
       return false;
 
-    if (isa<ConstantInt>(MCI->getLength())) {
+    // Only memcpy is expanded inline; a memmove's operands may overlap.
+    bool IsMemCpy = isa<MemCpyInst>(MCI);
+    if (IsMemCpy && isa<ConstantInt>(MCI->getLength())) {
       // Small memcpy's are common enough that we want to do them
       // without a call if possible.
       uint64_t Len = cast<ConstantInt>(MCI->getLength())->getZExtValue();
@@ -2239,7 +2242,8 @@ bool X86FastISel::fastLowerIntrinsicCall(const IntrinsicInst *II) {
     if (MCI->getSourceAddressSpace() > 255 || MCI->getDestAddressSpace() > 255)
       return false;
 
-    return lowerCallTo(II, "memcpy", II->getNumArgOperands() - 2);
+    return lowerCallTo(II, IsMemCpy ? "memcpy" : "memmove",
+                       II->getNumArgOperands() - 2);
   }
   case Intrinsic::memset: {
     const MemSetInst *MSI = cast<MemSetInst>(II);
@@ -2292,6 +2296,12 @@ bool X86FastISel::fastLowerIntrinsicCall(const IntrinsicInst *II) {
     BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, TII.get(X86::TRAP));
     return true;
   }
+  case Intrinsic::debugtrap: {
+    if (Subtarget->isTargetPS4())
+      return false;
+    BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, TII.get(X86::INT3));
+    return true;
+  }
   case Intrinsic::sqrt: {
     if (!Subtarget->hasSSE1())
       return false;
@@ -2473,6 +2483,67 @@ bool X86FastISel::fastLowerIntrinsicCall(const IntrinsicInst *II) {
     updateValueMap(II, ResultReg, 2);
     return true;
   }
+  case Intrinsic::sin:
+  case Intrinsic::cos:
+  case Intrinsic::pow:
+  case Intrinsic::exp:
+  case Intrinsic::exp2:
+  case Intrinsic::log:
+  case Intrinsic::log2:
+  case Intrinsic::log10: {
+    // Only the x86-64 calling convention passes and returns the floating point
+    // values of the libcalls in SSE registers.
+    if (!Subtarget->is64Bit() || !Subtarget->hasSSE2())
+      return false;
+
+    MVT RetVT;
+    if (!isTypeLegal(II->getType(), RetVT))
+      return false;
+
+    if (RetVT != MVT::f32 && RetVT != MVT::f64)
+      return false;
+
+    static const RTLIB::Libcall LibCallTable[8][2] = {
+      { RTLIB::SIN_F32, RTLIB::SIN_F64 },
+      { RTLIB::COS_F32, RTLIB::COS_F64 },
+      { RTLIB::POW_F32, RTLIB::POW_F64 },
+      { RTLIB::EXP_F32, RTLIB::EXP_F64 },
+      { RTLIB::EXP2_F32, RTLIB::EXP2_F64 },
+      { RTLIB::LOG_F32, RTLIB::LOG_F64 },
+      { RTLIB::LOG2_F32, RTLIB::LOG2_F64 },
+      { RTLIB::LOG10_F32, RTLIB::LOG10_F64 }
+    };
+    unsigned Idx;
+    switch (II->getIntrinsicID()) {
+    default: llvm_unreachable("Unexpected intrinsic.");
+    case Intrinsic::sin:   Idx = 0; break;
+    case Intrinsic::cos:   Idx = 1; break;
+    case Intrinsic::pow:   Idx = 2; break;
+    case Intrinsic::exp:   Idx = 3; break;
+    case Intrinsic::exp2:  Idx = 4; break;
+    case Intrinsic::log:   Idx = 5; break;
+    case Intrinsic::log2:  Idx = 6; break;
+    case Intrinsic::log10: Idx = 7; break;
+    }
+    RTLIB::Libcall LC = LibCallTable[Idx][RetVT == MVT::f64];
+
+    ArgListTy Args;
+    Args.reserve(II->getNumArgOperands());
+    for (auto &Arg : II->arg_operands()) {
+      ArgListEntry Entry;
+      Entry.Val = Arg;
+      Entry.Ty = Arg->getType();
+      Args.push_back(Entry);
+    }
+
+    CallLoweringInfo CLI;
+    CLI.setCallee(TLI.getLibcallCallingConv(LC), II->getType(),
+                  TLI.getLibcallName(LC), std::move(Args));
+    if (!lowerCallTo(CLI))
+      return false;
+    updateValueMap(II, CLI.ResultReg);
+    return true;
+  }
   case Intrinsic::x86_sse_cvttss2si:
   case Intrinsic::x86_sse_cvttss2si64:
   case Intrinsic::x86_sse2_cvttsd2si:
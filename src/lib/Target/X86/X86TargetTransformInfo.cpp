@@ -1110,8 +1110,10 @@ unsigned X86TTIImpl::getIntImmCost(Intrinsic::ID IID, unsigned Idx,
 }
 
 bool X86TTIImpl::isLegalMaskedLoad(Type *DataTy, int Consecutive) {
-  int DataWidth = DataTy->getPrimitiveSizeInBits();
-  
+  // The vectorizer asks about the scalar type, the cost model about the
+  // vector type; the element width decides in both cases.
+  int DataWidth = DataTy->getScalarSizeInBits();
+
   // Todo: AVX512 allows gather/scatter, works with strided and random as well
   if ((DataWidth < 32) || (Consecutive == 0))
     return false;
@@ -0,0 +1,157 @@
+//===- FunctionImport.cpp - Import functions from other modules -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the decision of which functions to import into a
+// module from a function summary index, and the import itself.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/IPO/FunctionImport.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/IR/FunctionInfo.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <algorithm>
+
+using namespace llvm;
+
+ImportListTy llvm::ComputeImportList(const FunctionInfoIndex &Index,
+                                     StringRef ModulePath,
+                                     unsigned InstLimit) {
+  ImportListTy ImportList;
+  int ModuleID = Index.findModule(ModulePath);
+  if (ModuleID < 0)
+    return ImportList;
+
+  auto isDefinedInModule = [&](StringRef Name) {
+    for (const auto &Definition : Index.lookup(Name))
+      if (Definition.first == unsigned(ModuleID))
+        return true;
+    return false;
+  };
+
+  // Start from the callees of the functions the module defines.
+  SmallVector<StringRef, 64> Worklist;
+  for (const auto &Entry : Index)
+    for (const auto &Definition : Entry.getValue())
+      if (Definition.first == unsigned(ModuleID))
+        Worklist.append(Definition.second.Callees.begin(),
+                        Definition.second.Callees.end());
+
+  StringSet<> Visited;
+  while (!Worklist.empty()) {
+    StringRef Name = Worklist.pop_back_val();
+    if (!Visited.insert(Name).second || isDefinedInModule(Name))
+      continue;
+
+    const FunctionInfoIndex::ModuleSummaryTy *Candidate = nullptr;
+    for (const auto &Definition : Index.lookup(Name))
+      if (Definition.second.isImportable() &&
+          Definition.second.InstCount <= InstLimit) {
+        Candidate = &Definition;
+        break;
+      }
+    if (!Candidate)
+      continue;
+
+    ImportList[Index.getModulePath(Candidate->first)].push_back(Name);
+    // The callees of an imported function may be worth importing too, to
+    // allow inlining through it.
+    Worklist.append(Candidate->second.Callees.begin(),
+                    Candidate->second.Callees.end());
+  }
+
+  for (auto &Entry : ImportList)
+    std::sort(Entry.second.begin(), Entry.second.end());
+  return ImportList;
+}
+
+/// Turn \p M, a copy of a source module restricted to the imported
+/// definitions, into a module that can be linked into the destination without
+/// defining anything there.
+static void prepareForImport(Module &M) {
+  M.setModuleInlineAsm("");
+
+  for (auto I = M.begin(), E = M.end(); I != E;) {
+    Function &F = *I++;
+    if (F.isDeclaration()) {
+      if (F.use_empty()) {
+        F.eraseFromParent();
+        continue;
+      }
+      // The prefix and prologue data were copied from the source module.
+      F.setPrefixData(nullptr);
+      F.setPrologueData(nullptr);
+      continue;
+    }
+    F.setLinkage(GlobalValue::AvailableExternallyLinkage);
+    F.setComdat(nullptr);
+  }
+
+  for (auto I = M.global_begin(), E = M.global_end(); I != E;) {
+    GlobalVariable &GV = *I++;
+    if (GV.isDeclaration() && GV.use_empty())
+      GV.eraseFromParent();
+  }
+
+  // Only keep the module flags, which the linker checks for compatibility,
+  // and not the module-level metadata describing the whole source module.
+  for (auto I = M.named_metadata_begin(), E = M.named_metadata_end();
+       I != E;) {
+    NamedMDNode &NMD = *I++;
+    if (NMD.getName() != "llvm.module.flags")
+      NMD.eraseFromParent();
+  }
+}
+
+bool FunctionImporter::importFunctions(Module &DestModule,
+                                       const ImportListTy &ImportList) {
+  for (const auto &Entry : ImportList) {
+    ErrorOr<std::unique_ptr<Module>> SrcOrErr = ModuleLoader(Entry.first);
+    if (!SrcOrErr)
+      return true;
+    Module &SrcModule = **SrcOrErr;
+    assert(&SrcModule.getContext() == &DestModule.getContext() &&
+           "Source module must be loaded in the destination context");
+
+    // Only materialize the bodies that are imported.
+    SmallPtrSet<const GlobalValue *, 16> Imported;
+    for (const std::string &Name : Entry.second) {
+      Function *F = SrcModule.getFunction(Name);
+      if (!F || F->isDeclaration())
+        continue;
+      if (Function *Existing = DestModule.getFunction(Name))
+        if (!Existing->isDeclaration())
+          continue;
+      if (F->materialize())
+        return true;
+      Imported.insert(F);
+    }
+    if (Imported.empty())
+      continue;
+
+    ValueToValueMapTy VMap;
+    std::unique_ptr<Module> Clone(
+        CloneModule(&SrcModule, VMap, [&](const GlobalValue *GV) {
+          return Imported.count(GV) != 0;
+        }));
+    prepareForImport(*Clone);
+
+    bool Failed = DiagnosticHandler
+                      ? Linker::LinkModules(&DestModule, Clone.get(),
+                                            DiagnosticHandler)
+                      : Linker::LinkModules(&DestModule, Clone.get());
+    if (Failed)
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,245 @@
+//===- FunctionOrdering.cpp - Order functions by their profile ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass lays out the functions of a module so that functions which call
+// each other frequently are close to each other, and hot functions are ahead
+// of cold ones. It follows Pettis and Hansen: the call graph edges are
+// weighted with the profile counts of their call sites, and starting from the
+// heaviest edge, the clusters of the caller and the callee are concatenated.
+//
+// The functions are emitted in module order, so moving the hot functions to
+// the front of the module orders their code. Optionally, the hot functions are
+// placed into a dedicated text section, and their symbols are written to an
+// order file for the linker.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/IPO.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Mangler.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ScaledNumber.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+using namespace llvm;
+
+#define DEBUG_TYPE "order-functions"
+
+STATISTIC(NumOrdered, "Number of hot functions ordered");
+
+static cl::opt<std::string>
+HotSection("order-functions-hot-section", cl::Hidden,
+           cl::desc("Place the ordered hot functions into this section"));
+
+static cl::opt<std::string>
+OrderFile("order-functions-file", cl::Hidden,
+          cl::desc("Write the symbols of the ordered hot functions to this "
+                   "linker order file"));
+
+namespace {
+  struct FunctionOrdering : public ModulePass {
+    static char ID; // Pass identification, replacement for typeid
+    FunctionOrdering() : ModulePass(ID) {
+      initializeFunctionOrderingPass(*PassRegistry::getPassRegistry());
+    }
+
+    void getAnalysisUsage(AnalysisUsage &AU) const override {
+      AU.addRequired<BlockFrequencyInfo>();
+    }
+
+    bool runOnModule(Module &M) override;
+
+  private:
+    typedef std::pair<Function *, Function *> CallEdge;
+
+    /// The estimated number of calls of each profiled function.
+    DenseMap<Function *, uint64_t> EntryCounts;
+    /// The estimated number of calls along each call graph edge, in the order
+    /// in which the edges were found.
+    MapVector<CallEdge, uint64_t> EdgeCounts;
+
+    void collectProfile(Function &F);
+    void computeOrder(SmallVectorImpl<Function *> &Order);
+  };
+}
+
+char FunctionOrdering::ID = 0;
+INITIALIZE_PASS_BEGIN(FunctionOrdering, "order-functions",
+                      "Order functions by profile", false, false)
+INITIALIZE_PASS_DEPENDENCY(BlockFrequencyInfo)
+INITIALIZE_PASS_END(FunctionOrdering, "order-functions",
+                    "Order functions by profile", false, false)
+
+ModulePass *llvm::createFunctionOrderingPass() {
+  return new FunctionOrdering();
+}
+
+/// \brief Returns the sum of the profile weights on the terminator of \p BB,
+/// which is the number of times that \p BB ran when the profile was taken.
+static uint64_t getProfileCount(const BasicBlock &BB) {
+  MDNode *MD = BB.getTerminator()->getMetadata(LLVMContext::MD_prof);
+  if (!MD || MD->getNumOperands() < 2)
+    return 0;
+  MDString *Tag = dyn_cast<MDString>(MD->getOperand(0));
+  if (!Tag || Tag->getString() != "branch_weights")
+    return 0;
+  uint64_t Count = 0;
+  for (unsigned i = 1, e = MD->getNumOperands(); i != e; ++i)
+    if (ConstantInt *Weight = mdconst::dyn_extract<ConstantInt>(MD->getOperand(i)))
+      Count += Weight->getZExtValue();
+  return Count;
+}
+
+void FunctionOrdering::collectProfile(Function &F) {
+  // The branch weights of instrumentation and sample profiles are execution
+  // counts. The block with the largest count yields the most precise entry
+  // count after scaling it by the block frequencies.
+  const BasicBlock *Counted = nullptr;
+  uint64_t Count = 0;
+  for (const BasicBlock &BB : F) {
+    uint64_t BBCount = getProfileCount(BB);
+    if (BBCount > Count) {
+      Count = BBCount;
+      Counted = &BB;
+    }
+  }
+  if (!Counted)
+    return;
+
+  typedef ScaledNumber<uint64_t> Scaled64;
+  BlockFrequencyInfo &BFI = getAnalysis<BlockFrequencyInfo>(F);
+  Scaled64 EntryFreq = Scaled64::get(BFI.getEntryFreq());
+  Scaled64 Calls = Scaled64::get(Count) * EntryFreq /
+                   Scaled64::get(BFI.getBlockFreq(Counted).getFrequency());
+  EntryCounts[&F] = Calls.toInt<uint64_t>();
+
+  for (BasicBlock &BB : F) {
+    uint64_t CallsFromBB =
+        (Calls * Scaled64::get(BFI.getBlockFreq(&BB).getFrequency()) /
+         EntryFreq).toInt<uint64_t>();
+    if (!CallsFromBB)
+      continue;
+    for (Instruction &I : BB) {
+      CallSite CS(&I);
+      if (!CS || isa<IntrinsicInst>(I))
+        continue;
+      Function *Callee = CS.getCalledFunction();
+      if (Callee && !Callee->isDeclaration() && Callee != &F)
+        EdgeCounts[std::make_pair(&F, Callee)] += CallsFromBB;
+    }
+  }
+}
+
+void FunctionOrdering::computeOrder(SmallVectorImpl<Function *> &Order) {
+  // Every function with a profile starts out in a cluster of its own.
+  std::vector<std::vector<Function *>> Clusters;
+  std::vector<uint64_t> ClusterCounts;
+  DenseMap<Function *, unsigned> ClusterOf;
+  auto getCluster = [&](Function *F) {
+    auto Inserted = ClusterOf.insert(std::make_pair(F, Clusters.size()));
+    if (Inserted.second) {
+      Clusters.push_back(std::vector<Function *>(1, F));
+      ClusterCounts.push_back(EntryCounts.lookup(F));
+    }
+    return Inserted.first->second;
+  };
+
+  // Visit the edges from the heaviest to the lightest, and append the cluster
+  // of the callee to the cluster of the caller.
+  std::vector<std::pair<CallEdge, uint64_t>> Edges(EdgeCounts.begin(),
+                                                   EdgeCounts.end());
+  std::stable_sort(Edges.begin(), Edges.end(),
+                   [](const std::pair<CallEdge, uint64_t> &A,
+                      const std::pair<CallEdge, uint64_t> &B) {
+    return A.second > B.second;
+  });
+  for (auto &Edge : Edges) {
+    unsigned Caller = getCluster(Edge.first.first);
+    unsigned Callee = getCluster(Edge.first.second);
+    if (Caller == Callee)
+      continue;
+    for (Function *F : Clusters[Callee])
+      ClusterOf[F] = Caller;
+    Clusters[Caller].insert(Clusters[Caller].end(), Clusters[Callee].begin(),
+                            Clusters[Callee].end());
+    Clusters[Callee].clear();
+    ClusterCounts[Caller] += ClusterCounts[Callee];
+  }
+  for (auto &Entry : EntryCounts)
+    getCluster(Entry.first);
+
+  // The hottest clusters come first.
+  std::vector<unsigned> ClusterOrder;
+  for (unsigned i = 0, e = Clusters.size(); i != e; ++i)
+    if (!Clusters[i].empty() && ClusterCounts[i])
+      ClusterOrder.push_back(i);
+  std::stable_sort(ClusterOrder.begin(), ClusterOrder.end(),
+                   [&](unsigned A, unsigned B) {
+    return ClusterCounts[A] > ClusterCounts[B];
+  });
+  for (unsigned i : ClusterOrder)
+    Order.append(Clusters[i].begin(), Clusters[i].end());
+}
+
+bool FunctionOrdering::runOnModule(Module &M) {
+  EntryCounts.clear();
+  EdgeCounts.clear();
+  for (Function &F : M)
+    if (!F.isDeclaration())
+      collectProfile(F);
+
+  SmallVector<Function *, 32> Order;
+  computeOrder(Order);
+  if (Order.empty())
+    return false;
+
+  // Move the ordered functions to the front of the module. The functions
+  // without a profile stay behind them in their original order.
+  Module::FunctionListType &Functions = M.getFunctionList();
+  for (auto I = Order.rbegin(), E = Order.rend(); I != E; ++I)
+    Functions.splice(Functions.begin(), Functions, *I);
+  NumOrdered += Order.size();
+
+  if (!HotSection.empty())
+    for (Function *F : Order)
+      if (!F->hasSection() && !F->hasComdat())
+        F->setSection(HotSection);
+
+  if (!OrderFile.empty()) {
+    std::error_code EC;
+    raw_fd_ostream OS(OrderFile, EC, sys::fs::F_Text);
+    if (EC) {
+      M.getContext().emitError("could not open order file '" + OrderFile +
+                               "': " + EC.message());
+      return true;
+    }
+    Mangler Mang(&M.getDataLayout());
+    for (Function *F : Order) {
+      SmallString<64> Name;
+      Mang.getNameWithPrefix(Name, F, false);
+      OS << Name << '\n';
+    }
+  }
+
+  DEBUG(dbgs() << "FunctionOrdering: ordered " << Order.size()
+               << " hot functions of " << M.getModuleIdentifier() << "\n");
+  return true;
+}
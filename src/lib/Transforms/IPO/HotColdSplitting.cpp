@@ -0,0 +1,247 @@
+//===- HotColdSplitting.cpp - Outline cold regions of functions -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass outlines the cold regions of functions into separate functions, so
+// that the hot code of the functions is laid out densely. A block is cold if it
+// ends in unreachable, calls a cold function, is rarely executed according to
+// the profile of its function, or only leads to cold blocks. Every region is
+// a cold block together with the cold blocks that it dominates, and is
+// extracted with the CodeExtractor.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/IPO.h"
+#include "llvm/ADT/DepthFirstIterator.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/CodeExtractor.h"
+using namespace llvm;
+
+#define DEBUG_TYPE "hotcoldsplit"
+
+STATISTIC(NumColdRegionsOutlined, "Number of cold regions outlined");
+
+static cl::opt<unsigned>
+MinColdRegionSize("hotcoldsplit-min-size", cl::Hidden, cl::init(4),
+                  cl::desc("Minimum number of instructions in a cold region "
+                           "for it to be outlined"));
+
+static cl::opt<unsigned>
+ColdBlockRelFreq("hotcoldsplit-cold-rel-freq", cl::Hidden, cl::init(1),
+                 cl::desc("Maximum block frequency of a cold block, as a "
+                          "percentage of its function's entry frequency"));
+
+namespace {
+  struct HotColdSplitting : public ModulePass {
+    static char ID; // Pass identification, replacement for typeid
+    HotColdSplitting() : ModulePass(ID) {
+      initializeHotColdSplittingPass(*PassRegistry::getPassRegistry());
+    }
+
+    void getAnalysisUsage(AnalysisUsage &AU) const override {
+      AU.addRequired<BlockFrequencyInfo>();
+    }
+
+    bool runOnModule(Module &M) override;
+
+  private:
+    void findColdBlocks(Function &F, SmallPtrSetImpl<BasicBlock *> &Cold);
+    bool outlineColdRegion(Function &F,
+                           const SmallPtrSetImpl<BasicBlock *> &Cold);
+  };
+}
+
+char HotColdSplitting::ID = 0;
+INITIALIZE_PASS_BEGIN(HotColdSplitting, "hotcoldsplit",
+                      "Hot Cold Splitting", false, false)
+INITIALIZE_PASS_DEPENDENCY(BlockFrequencyInfo)
+INITIALIZE_PASS_END(HotColdSplitting, "hotcoldsplit",
+                    "Hot Cold Splitting", false, false)
+
+ModulePass *llvm::createHotColdSplittingPass() {
+  return new HotColdSplitting();
+}
+
+/// \brief Returns true if any branch of \p F carries profile weights.
+static bool hasProfileData(const Function &F) {
+  for (const BasicBlock &BB : F)
+    if (BB.getTerminator()->getMetadata(LLVMContext::MD_prof))
+      return true;
+  return false;
+}
+
+/// \brief Returns true if \p BB is cold regardless of the profile: it cannot
+/// return, or it calls a cold function.
+static bool isStaticallyCold(const BasicBlock &BB) {
+  if (isa<UnreachableInst>(BB.getTerminator()))
+    return true;
+  for (const Instruction &I : BB) {
+    ImmutableCallSite CS(&I);
+    if (CS && !isa<IntrinsicInst>(I) && CS.hasFnAttr(Attribute::Cold))
+      return true;
+  }
+  return false;
+}
+
+/// \brief Returns true if \p BB can be moved into an outlined function. The
+/// outlined function cannot return from or unwind through its caller.
+static bool mayExtractBlock(const BasicBlock &BB) {
+  const TerminatorInst *Term = BB.getTerminator();
+  return !BB.isLandingPad() && !isa<ReturnInst>(Term) &&
+         !isa<ResumeInst>(Term) && !isa<InvokeInst>(Term);
+}
+
+void HotColdSplitting::findColdBlocks(Function &F,
+                                      SmallPtrSetImpl<BasicBlock *> &Cold) {
+  BlockFrequencyInfo *BFI = nullptr;
+  if (hasProfileData(F))
+    BFI = &getAnalysis<BlockFrequencyInfo>(F);
+
+  // Visit the successors of a block before the block, so that a block whose
+  // successors are all cold becomes cold too. Back edges are not followed, so
+  // this stays conservative in loops.
+  BasicBlock *Entry = &F.getEntryBlock();
+  for (po_iterator<BasicBlock *> I = po_begin(Entry), E = po_end(Entry);
+       I != E; ++I) {
+    BasicBlock *BB = *I;
+    if (BB == Entry)
+      continue;
+    bool IsCold = isStaticallyCold(*BB);
+    if (!IsCold && BFI) {
+      uint64_t EntryFreq = BFI->getEntryFreq();
+      IsCold = BFI->getBlockFreq(BB).getFrequency() <
+               EntryFreq / 100 * ColdBlockRelFreq;
+    }
+    if (!IsCold && succ_begin(BB) != succ_end(BB)) {
+      IsCold = true;
+      for (BasicBlock *Succ : successors(BB))
+        if (!Cold.count(Succ)) {
+          IsCold = false;
+          break;
+        }
+    }
+    if (IsCold)
+      Cold.insert(BB);
+  }
+}
+
+bool HotColdSplitting::outlineColdRegion(
+    Function &F, const SmallPtrSetImpl<BasicBlock *> &Cold) {
+  DominatorTree DT;
+  DT.recalculate(F);
+
+  ReversePostOrderTraversal<Function *> RPOT(&F);
+  for (BasicBlock *Header : RPOT) {
+    if (!Cold.count(Header) || !mayExtractBlock(*Header))
+      continue;
+    // Start at the top of a cold region.
+    DomTreeNode *IDom = DT.getNode(Header)->getIDom();
+    if (!IDom || Cold.count(IDom->getBlock()))
+      continue;
+
+    // The region is the cold part of the dominator subtree of the header. A
+    // block with a predecessor outside of the region would be a second entry,
+    // so drop those until only the header is entered from outside.
+    SetVector<BasicBlock *> Region;
+    for (DomTreeNode *N : depth_first(DT.getNode(Header)))
+      if (Cold.count(N->getBlock()) && mayExtractBlock(*N->getBlock()))
+        Region.insert(N->getBlock());
+    bool Pruned;
+    do {
+      Pruned = false;
+      for (unsigned i = 1; i < Region.size(); ++i) {
+        BasicBlock *BB = Region[i];
+        for (BasicBlock *Pred : predecessors(BB))
+          if (!Region.count(Pred)) {
+            Region.remove(BB);
+            Pruned = true;
+            break;
+          }
+        if (Pruned)
+          break;
+      }
+    } while (Pruned);
+
+    unsigned Size = 0;
+    bool HasExit = false;
+    for (BasicBlock *BB : Region) {
+      for (Instruction &I : *BB)
+        if (!isa<DbgInfoIntrinsic>(I))
+          ++Size;
+      for (BasicBlock *Succ : successors(BB))
+        HasExit |= !Region.count(Succ);
+    }
+    if (Size < MinColdRegionSize)
+      continue;
+
+    SmallVector<BasicBlock *, 16> Blocks(Region.begin(), Region.end());
+    CodeExtractor CE(Blocks, &DT);
+    if (!CE.isEligible())
+      continue;
+    Function *Outlined = CE.extractCodeRegion();
+    if (!Outlined)
+      continue;
+
+    DEBUG(dbgs() << "HotColdSplitting: outlined " << Size
+                 << " instructions of " << F.getName() << " into "
+                 << Outlined->getName() << "\n");
+    Outlined->addFnAttr(Attribute::Cold);
+    Outlined->addFnAttr(Attribute::MinSize);
+    Outlined->addFnAttr(Attribute::NoInline);
+    if (!HasExit) {
+      // The region never returns to the function that it was outlined from.
+      CallInst *Call = cast<CallInst>(Outlined->user_back());
+      Outlined->addFnAttr(Attribute::NoReturn);
+      Call->setDoesNotReturn();
+      TerminatorInst *Term = Call->getParent()->getTerminator();
+      new UnreachableInst(F.getContext(), Term);
+      Term->eraseFromParent();
+    }
+    ++NumColdRegionsOutlined;
+    return true;
+  }
+  return false;
+}
+
+bool HotColdSplitting::runOnModule(Module &M) {
+  // The outlined functions are appended to the module; they are cold already
+  // and are not visited again.
+  SmallVector<Function *, 16> Worklist;
+  for (Function &F : M)
+    if (!F.isDeclaration() && !F.hasFnAttribute(Attribute::Cold) &&
+        !F.hasFnAttribute(Attribute::OptimizeNone))
+      Worklist.push_back(&F);
+
+  bool Changed = false;
+  for (Function *F : Worklist) {
+    SmallPtrSet<BasicBlock *, 16> Cold;
+    findColdBlocks(*F, Cold);
+    if (Cold.empty())
+      continue;
+    // The dominator tree is rebuilt after every region, since the extractor
+    // replaces the region with a call block.
+    while (outlineColdRegion(*F, Cold))
+      Changed = true;
+  }
+  return Changed;
+}
@@ -18,6 +18,7 @@
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/AssumptionCache.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
 #include "llvm/Analysis/CallGraph.h"
 #include "llvm/Analysis/InlineCost.h"
 #include "llvm/IR/CallSite.h"
@@ -25,6 +26,7 @@
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
@@ -61,9 +63,87 @@ static cl::opt<int>
 ColdThreshold("inlinecold-threshold", cl::Hidden, cl::init(225),
               cl::desc("Threshold for inlining functions with cold attribute"));
 
+static cl::opt<int>
+HotCallSiteThreshold("inlinehot-callsite-threshold", cl::Hidden,
+                     cl::init(3000),
+                     cl::desc("Threshold for inlining call sites that the "
+                              "profile says are hot"));
+
+static cl::opt<int>
+ColdCallSiteThreshold("inlinecold-callsite-threshold", cl::Hidden,
+                      cl::init(45),
+                      cl::desc("Threshold for inlining call sites that the "
+                               "profile says are cold"));
+
+static cl::opt<unsigned>
+HotCallSiteRelFreq("inline-hot-callsite-rel-freq", cl::Hidden, cl::init(60),
+                   cl::desc("Minimum block frequency of a hot call site, as a "
+                            "multiple of the caller's entry frequency"));
+
+static cl::opt<unsigned>
+ColdCallSiteRelFreq("inline-cold-callsite-rel-freq", cl::Hidden, cl::init(2),
+                    cl::desc("Maximum block frequency of a cold call site, as "
+                             "a percentage of the caller's entry frequency"));
+
 // Threshold to use when optsize is specified (and there is no -inline-limit).
 const int OptSizeThreshold = 75;
 
+namespace {
+/// \brief Sorts the call sites of a function into hot and cold ones by their
+/// block frequency relative to the entry of the function.
+///
+/// The inliner is a call graph SCC pass and cannot require function analyses,
+/// so it runs this pass on its own pass manager.
+struct CallSiteHotness : public FunctionPass {
+  static char ID;
+  SmallPtrSetImpl<const Instruction *> &Hot;
+  SmallPtrSetImpl<const Instruction *> &Cold;
+
+  CallSiteHotness(SmallPtrSetImpl<const Instruction *> &Hot,
+                  SmallPtrSetImpl<const Instruction *> &Cold)
+      : FunctionPass(ID), Hot(Hot), Cold(Cold) {
+    initializeBlockFrequencyInfoPass(*PassRegistry::getPassRegistry());
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<BlockFrequencyInfo>();
+    AU.setPreservesAll();
+  }
+
+  bool runOnFunction(Function &F) override {
+    BlockFrequencyInfo &BFI = getAnalysis<BlockFrequencyInfo>();
+    uint64_t EntryFreq = BFI.getEntryFreq();
+    for (BasicBlock &BB : F) {
+      uint64_t Freq = BFI.getBlockFreq(&BB).getFrequency();
+      bool IsHot = Freq / EntryFreq >= HotCallSiteRelFreq;
+      bool IsCold = Freq < EntryFreq / 100 * ColdCallSiteRelFreq;
+      if (!IsHot && !IsCold)
+        continue;
+      for (Instruction &I : BB) {
+        CallSite CS(&I);
+        if (!CS || isa<IntrinsicInst>(I))
+          continue;
+        if (IsHot)
+          Hot.insert(&I);
+        else
+          Cold.insert(&I);
+      }
+    }
+    return false;
+  }
+};
+}
+
+char CallSiteHotness::ID = 0;
+
+/// \brief Returns true if any branch of \p F carries profile weights.
+static bool hasProfileData(const Function &F) {
+  for (const BasicBlock &BB : F)
+    if (BB.getTerminator()->getMetadata(LLVMContext::MD_prof))
+      return true;
+  return false;
+}
+
 Inliner::Inliner(char &ID) 
   : CallGraphSCCPass(ID), InlineThreshold(InlineLimit), InsertLifetime(true) {}
 
@@ -284,9 +364,31 @@ unsigned Inliner::getInlineThreshold(CallSite CS) const {
       ColdThreshold < thres)
     thres = ColdThreshold;
 
+  // Listen to the profile of the caller. A hot call site raises the threshold
+  // unless the caller is optimized for size, and a cold one lowers it the same
+  // way the cold attribute does.
+  const Instruction *Call = CS.getInstruction();
+  if (HotCallSites.count(Call) && HotCallSiteThreshold > thres && !OptSize &&
+      !Caller->hasFnAttribute(Attribute::MinSize))
+    thres = HotCallSiteThreshold;
+  if ((InlineLimit.getNumOccurrences() == 0 ||
+       ColdCallSiteThreshold.getNumOccurrences() > 0) &&
+      ColdCallSites.count(Call) && ColdCallSiteThreshold < thres)
+    thres = ColdCallSiteThreshold;
+
   return thres;
 }
 
+void Inliner::collectCallSiteHotness(Function &F) {
+  if (!hasProfileData(F))
+    return;
+  legacy::FunctionPassManager FPM(F.getParent());
+  FPM.add(new CallSiteHotness(HotCallSites, ColdCallSites));
+  FPM.doInitialization();
+  FPM.run(F);
+  FPM.doFinalization();
+}
+
 static void emitAnalysis(CallSite CS, const Twine &Msg) {
   Function *Caller = CS.getCaller();
   LLVMContext &Ctx = Caller->getContext();
@@ -449,9 +551,12 @@ bool Inliner::runOnSCC(CallGraphSCC &SCC) {
   // index into the InlineHistory vector.
   SmallVector<std::pair<Function*, int>, 8> InlineHistory;
 
+  HotCallSites.clear();
+  ColdCallSites.clear();
   for (CallGraphSCC::iterator I = SCC.begin(), E = SCC.end(); I != E; ++I) {
     Function *F = (*I)->getFunction();
     if (!F) continue;
+    collectCallSiteHotness(*F);
     
     for (Function::iterator BB = F->begin(), E = F->end(); BB != E; ++BB)
       for (BasicBlock::iterator I = BB->begin(), E = BB->end(); I != E; ++I) {
@@ -512,6 +617,8 @@ bool Inliner::runOnSCC(CallGraphSCC &SCC) {
                      << *CS.getInstruction() << "\n");
         // Update the call graph by deleting the edge from Callee to Caller.
         CG[Caller]->removeCallEdgeFor(CS);
+        HotCallSites.erase(CS.getInstruction());
+        ColdCallSites.erase(CS.getInstruction());
         CS.getInstruction()->eraseFromParent();
         ++NumCallsDeleted;
       } else {
@@ -532,6 +639,7 @@ bool Inliner::runOnSCC(CallGraphSCC &SCC) {
 
         // Get DebugLoc to report. CS will be invalid after Inliner.
         DebugLoc DLoc = CS.getInstruction()->getDebugLoc();
+        Instruction *Call = CS.getInstruction();
 
         // If the policy determines that we should inline this function,
         // try to do so.
@@ -553,6 +661,8 @@ bool Inliner::runOnSCC(CallGraphSCC &SCC) {
           continue;
         }
         ++NumInlined;
+        HotCallSites.erase(Call);
+        ColdCallSites.erase(Call);
 
         // Report the inline decision.
         emitOptimizationRemark(
@@ -32,6 +32,15 @@
 // overridable, we move the functionality into a new internal function and
 // leave two overridable thunks to it.
 //
+// Every function also gets a cheap structural hash of its CFG and opcodes.
+// Functions that compare equal have the same hash, so the hash orders the
+// tree before the comparator does, and functions with a unique hash are never
+// inserted into the tree.
+//
+// Optionally, functions that only differ in some integer constants are merged
+// too: their body is moved into a new internal function that takes the
+// constants as extra parameters, and both functions become thunks to it.
+//
 //===----------------------------------------------------------------------===//
 //
 // Future work:
@@ -84,7 +93,9 @@
 #include "llvm/Transforms/IPO.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/IR/CallSite.h"
@@ -93,6 +104,7 @@
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/InlineAsm.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Operator.h"
@@ -111,6 +123,10 @@ STATISTIC(NumFunctionsMerged, "Number of functions merged");
 STATISTIC(NumThunksWritten, "Number of thunks generated");
 STATISTIC(NumAliasesWritten, "Number of aliases generated");
 STATISTIC(NumDoubleWeak, "Number of new functions created");
+STATISTIC(NumParameterized,
+          "Number of functions merged by parameterizing constants");
+STATISTIC(NumHashFiltered,
+          "Number of functions skipped because of a unique hash");
 
 static cl::opt<unsigned> NumFunctionsForSanityCheck(
     "mergefunc-sanity",
@@ -119,20 +135,58 @@ static cl::opt<unsigned> NumFunctionsForSanityCheck(
              "'0' disables this check. Works only with '-debug' key."),
     cl::init(0), cl::Hidden);
 
+static cl::opt<bool> MergeParameterized(
+    "mergefunc-parameterize",
+    cl::desc("Merge functions that only differ in integer constants by "
+             "passing the constants as parameters"),
+    cl::init(false), cl::Hidden);
+
+static cl::opt<unsigned> MaxMergeParams(
+    "mergefunc-max-params",
+    cl::desc("Maximum number of constant parameters added to merge functions "
+             "with -mergefunc-parameterize"),
+    cl::init(4), cl::Hidden);
+
+static cl::opt<unsigned> MinParameterizedSize(
+    "mergefunc-param-min-size",
+    cl::desc("Minimum number of instructions of a function merged with "
+             "-mergefunc-parameterize"),
+    cl::init(8), cl::Hidden);
+
 namespace {
 
+/// A pair of different integer constants that two functions use in the same
+/// operand of corresponding instructions. The constant of the left function
+/// can be replaced by a parameter to merge the two functions.
+struct ConstantDiff {
+  const Instruction *InstL;
+  unsigned OpNo;
+  ConstantInt *ConstL, *ConstR;
+};
+
 /// FunctionComparator - Compares two functions to determine whether or not
 /// they will generate machine code with the same behaviour. DataLayout is
 /// used if available. The comparator always fails conservatively (erring on the
 /// side of claiming that two functions are different).
 class FunctionComparator {
 public:
-  FunctionComparator(const Function *F1, const Function *F2)
-      : FnL(F1), FnR(F2) {}
+  /// If \p Diffs is non-null, integer constants in operands that could be
+  /// parameterized compare equal, and the pairs of different constants are
+  /// recorded in \p Diffs. That is not a total order, so it must not be used
+  /// to order the FnTree.
+  FunctionComparator(const Function *F1, const Function *F2,
+                     SmallVectorImpl<ConstantDiff> *Diffs = nullptr)
+      : FnL(F1), FnR(F2), Diffs(Diffs) {}
 
   /// Test whether the two functions have equivalent behaviour.
   int compare();
 
+  typedef uint64_t FunctionHash;
+
+  /// Compute a hash of the CFG and the opcodes of \p F. Functions that are
+  /// equal according to compare() have the same hash.
+  static FunctionHash functionHash(const Function &F);
+
 private:
   /// Test whether two basic blocks have equivalent behaviour.
   int compare(const BasicBlock *BBL, const BasicBlock *BBR);
@@ -352,6 +406,10 @@ private:
   // The two functions undergoing comparison.
   const Function *FnL, *FnR;
 
+  /// The constants that differ between FnL and FnR, if they are compared for
+  /// a parameterized merge.
+  SmallVectorImpl<ConstantDiff> *Diffs;
+
   /// Assign serial numbers to values from left function, and values from
   /// right function.
   /// Explanation:
@@ -390,15 +448,18 @@ private:
 
 class FunctionNode {
   mutable AssertingVH<Function> F;
+  FunctionComparator::FunctionHash Hash;
 
 public:
-  FunctionNode(Function *F) : F(F) {}
+  FunctionNode(Function *F)
+      : F(F), Hash(FunctionComparator::functionHash(*F)) {}
   Function *getFunc() const { return F; }
+  FunctionComparator::FunctionHash getHash() const { return Hash; }
 
   /// Replace the reference to the function F by the function G, assuming their
   /// implementations are equal.
   void replaceBy(Function *G) const {
-    assert(!(*this < FunctionNode(G)) && !(FunctionNode(G) < *this) &&
+    assert(FunctionComparator(F, G).compare() == 0 &&
            "The two functions must be equal");
 
     F = G;
@@ -406,11 +467,29 @@ public:
 
   void release() { F = 0; }
   bool operator<(const FunctionNode &RHS) const {
+    // The hashes are much cheaper to compare, and only equal hashes need the
+    // full comparison.
+    if (Hash != RHS.Hash)
+      return Hash < RHS.Hash;
     return (FunctionComparator(F, RHS.getFunc()).compare()) == -1;
   }
 };
 }
 
+/// Returns true if the constant operand \p OpNo of \p I may be replaced by a
+/// value that is only known at run time.
+static bool isParameterizableOperand(const Instruction *I, unsigned OpNo) {
+  if (isa<BinaryOperator>(I) || isa<CmpInst>(I) || isa<SelectInst>(I) ||
+      isa<CastInst>(I) || isa<ReturnInst>(I))
+    return true;
+  if (isa<StoreInst>(I))
+    return OpNo == 0;
+  if (const CallInst *CI = dyn_cast<CallInst>(I))
+    return OpNo < CI->getNumArgOperands() && !CI->isInlineAsm() &&
+           !isa<IntrinsicInst>(CI);
+  return false;
+}
+
 int FunctionComparator::cmpNumbers(uint64_t L, uint64_t R) const {
   if (L < R) return -1;
   if (L > R) return 1;
@@ -897,6 +976,11 @@ int FunctionComparator::cmpGEPs(const GEPOperator *GEPL,
 /// that we will detect mismatches on next use.
 /// See comments in declaration for more details.
 int FunctionComparator::cmpValues(const Value *L, const Value *R) {
+  // A parameterized merge moves the body of FnL into a new function, where a
+  // reference to FnL would lose the constants of FnR.
+  if (Diffs && (L == FnL || R == FnR))
+    return L == FnL ? -1 : 1;
+
   // Catch self-reference case.
   if (L == FnL) {
     if (R == FnR)
@@ -968,6 +1052,13 @@ int FunctionComparator::compare(const BasicBlock *BBL, const BasicBlock *BBR) {
       for (unsigned i = 0, e = InstL->getNumOperands(); i != e; ++i) {
         Value *OpL = InstL->getOperand(i);
         Value *OpR = InstR->getOperand(i);
+        if (Diffs && OpL != OpR && OpL->getType() == OpR->getType() &&
+            isa<ConstantInt>(OpL) && isa<ConstantInt>(OpR) &&
+            isParameterizableOperand(InstL, i)) {
+          Diffs->push_back({InstL, i, cast<ConstantInt>(OpL),
+                            cast<ConstantInt>(OpR)});
+          continue;
+        }
         if (int Res = cmpValues(OpL, OpR))
           return Res;
         if (int Res = cmpNumbers(OpL->getValueID(), OpR->getValueID()))
@@ -993,6 +1084,8 @@ int FunctionComparator::compare() {
 
   sn_mapL.clear();
   sn_mapR.clear();
+  if (Diffs)
+    Diffs->clear();
 
   if (int Res = cmpAttrs(FnL->getAttributes(), FnR->getAttributes()))
     return Res;
@@ -1073,6 +1166,30 @@ int FunctionComparator::compare() {
   return 0;
 }
 
+// Hash the CFG in the same order in which compare() walks it, so that equal
+// functions have equal hashes.
+FunctionComparator::FunctionHash
+FunctionComparator::functionHash(const Function &F) {
+  hash_code Hash = hash_combine(F.isVarArg(), F.arg_size());
+
+  SmallVector<const BasicBlock *, 8> BBs;
+  SmallSet<const BasicBlock *, 16> VisitedBBs;
+  BBs.push_back(&F.getEntryBlock());
+  VisitedBBs.insert(BBs[0]);
+  while (!BBs.empty()) {
+    const BasicBlock *BB = BBs.pop_back_val();
+    // Mark the start of each block, so that the split into blocks is hashed.
+    Hash = hash_combine(Hash, BB->size());
+    for (const Instruction &I : *BB)
+      Hash = hash_combine(Hash, I.getOpcode());
+    const TerminatorInst *Term = BB->getTerminator();
+    for (unsigned i = 0, e = Term->getNumSuccessors(); i != e; ++i)
+      if (VisitedBBs.insert(Term->getSuccessor(i)).second)
+        BBs.push_back(Term->getSuccessor(i));
+  }
+  return Hash;
+}
+
 namespace {
 
 /// MergeFunctions finds functions which will generate identical machine code,
@@ -1135,6 +1252,19 @@ private:
   /// Replace function F with function G in the function tree.
   void replaceFunctionInTree(FnTreeType::iterator &IterToF, Function *G);
 
+  /// Merge the functions of \p Bucket, which have the same hash, that only
+  /// differ in integer constants. Returns true if any function was merged.
+  bool mergeParameterized(ArrayRef<Function *> Bucket);
+
+  /// Move the body of F into a new function that takes the constants listed
+  /// in \p Params as extra parameters, and turn F and the functions \p Gs
+  /// into thunks to it. \p Args holds the constants of F followed by those of
+  /// each function of \p Gs.
+  void writeParameterizedBody(Function *F, ArrayRef<Function *> Gs,
+                              ArrayRef<std::pair<const Instruction *, unsigned>>
+                                  Params,
+                              ArrayRef<SmallVector<Constant *, 4>> Args);
+
   /// The set of all distinct functions. Use the insert() and remove() methods
   /// to modify it.
   FnTreeType FnTree;
@@ -1227,9 +1357,26 @@ bool MergeFunctions::doSanityCheck(std::vector<WeakVH> &Worklist) {
 bool MergeFunctions::runOnModule(Module &M) {
   bool Changed = false;
 
-  for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I) {
-    if (!I->isDeclaration() && !I->hasAvailableExternallyLinkage())
-      Deferred.push_back(WeakVH(I));
+  // Functions can only be equal if their hashes are, so a function with a
+  // unique hash is never considered for merging.
+  std::vector<std::pair<FunctionComparator::FunctionHash, Function *>>
+      HashedFuncs;
+  for (Function &F : M)
+    if (!F.isDeclaration() && !F.hasAvailableExternallyLinkage())
+      HashedFuncs.push_back(
+          std::make_pair(FunctionComparator::functionHash(F), &F));
+  std::stable_sort(
+      HashedFuncs.begin(), HashedFuncs.end(),
+      [](const std::pair<FunctionComparator::FunctionHash, Function *> &A,
+         const std::pair<FunctionComparator::FunctionHash, Function *> &B) {
+        return A.first < B.first;
+      });
+  for (auto I = HashedFuncs.begin(), E = HashedFuncs.end(); I != E; ++I) {
+    if ((I != HashedFuncs.begin() && std::prev(I)->first == I->first) ||
+        (std::next(I) != E && std::next(I)->first == I->first))
+      Deferred.push_back(WeakVH(I->second));
+    else
+      ++NumHashFiltered;
   }
 
   do {
@@ -1269,6 +1416,22 @@ bool MergeFunctions::runOnModule(Module &M) {
     DEBUG(dbgs() << "size of FnTree: " << FnTree.size() << '\n');
   } while (!Deferred.empty());
 
+  if (MergeParameterized) {
+    // The functions left in the tree are all different. Those that only differ
+    // in constants still share a hash.
+    std::vector<Function *> Bucket;
+    FunctionComparator::FunctionHash BucketHash = 0;
+    for (const FunctionNode &Node : FnTree) {
+      if (!Bucket.empty() && Node.getHash() != BucketHash) {
+        Changed |= mergeParameterized(Bucket);
+        Bucket.clear();
+      }
+      BucketHash = Node.getHash();
+      Bucket.push_back(Node.getFunc());
+    }
+    Changed |= mergeParameterized(Bucket);
+  }
+
   FnTree.clear();
 
   return Changed;
@@ -1493,6 +1656,162 @@ bool MergeFunctions::insert(Function *NewFunction) {
   return true;
 }
 
+/// Returns true if \p F may be merged with other functions by parameterizing
+/// its constants.
+static bool mayParameterize(const Function *F) {
+  if (F->mayBeOverridden() || F->isVarArg())
+    return false;
+  unsigned Size = 0;
+  for (const BasicBlock &BB : *F)
+    Size += BB.size();
+  return Size >= MinParameterizedSize;
+}
+
+bool MergeFunctions::mergeParameterized(ArrayRef<Function *> Bucket) {
+  typedef std::pair<const Instruction *, unsigned> ParamPos;
+  bool Changed = false;
+  SmallPtrSet<Function *, 8> Merged;
+  for (unsigned i = 0, e = Bucket.size(); i != e; ++i) {
+    Function *F = Bucket[i];
+    if (Merged.count(F) || !mayParameterize(F))
+      continue;
+
+    // Collect the functions that only differ from F in some constants, as
+    // long as the union of the differing operands stays small.
+    SmallVector<Function *, 4> Gs;
+    SmallVector<SmallVector<ConstantDiff, 4>, 4> GDiffs;
+    SmallVector<ParamPos, 4> Params;
+    for (unsigned j = i + 1; j != e; ++j) {
+      Function *G = Bucket[j];
+      if (Merged.count(G) || !mayParameterize(G))
+        continue;
+      SmallVector<ConstantDiff, 4> Diffs;
+      if (FunctionComparator(F, G, &Diffs).compare() != 0 || Diffs.empty())
+        continue;
+      SmallVector<ParamPos, 4> NewParams(Params.begin(), Params.end());
+      for (const ConstantDiff &D : Diffs) {
+        ParamPos Pos(D.InstL, D.OpNo);
+        if (std::find(NewParams.begin(), NewParams.end(), Pos) ==
+            NewParams.end())
+          NewParams.push_back(Pos);
+      }
+      if (NewParams.size() > MaxMergeParams)
+        continue;
+      Params.swap(NewParams);
+      Gs.push_back(G);
+      GDiffs.push_back(std::move(Diffs));
+    }
+    if (Gs.empty())
+      continue;
+
+    // The constants that F and each function of Gs use for every parameter.
+    // Where a function does not differ from F, it uses the constant of F.
+    SmallVector<SmallVector<Constant *, 4>, 4> Args(Gs.size() + 1);
+    for (const ParamPos &Pos : Params)
+      Args[0].push_back(cast<Constant>(Pos.first->getOperand(Pos.second)));
+    for (unsigned k = 0, ke = Gs.size(); k != ke; ++k) {
+      Args[k + 1] = Args[0];
+      for (const ConstantDiff &D : GDiffs[k]) {
+        auto It = std::find(Params.begin(), Params.end(),
+                            ParamPos(D.InstL, D.OpNo));
+        Args[k + 1][It - Params.begin()] = D.ConstR;
+      }
+    }
+
+    DEBUG(dbgs() << "Parameterizing " << Params.size() << " constants of "
+                 << F->getName() << " to merge " << Gs.size()
+                 << " functions\n");
+    writeParameterizedBody(F, Gs, Params, Args);
+    Merged.insert(F);
+    Merged.insert(Gs.begin(), Gs.end());
+    NumParameterized += Gs.size() + 1;
+    NumFunctionsMerged += Gs.size();
+    Changed = true;
+  }
+  return Changed;
+}
+
+void MergeFunctions::writeParameterizedBody(
+    Function *F, ArrayRef<Function *> Gs,
+    ArrayRef<std::pair<const Instruction *, unsigned>> Params,
+    ArrayRef<SmallVector<Constant *, 4>> Args) {
+  // Constants that every caller passes together share a parameter.
+  SmallVector<Type *, 8> ParamTys(F->getFunctionType()->param_begin(),
+                                  F->getFunctionType()->param_end());
+  SmallVector<unsigned, 4> ParamOf;
+  SmallVector<unsigned, 4> UniqueParams;
+  for (unsigned i = 0, e = Params.size(); i != e; ++i) {
+    unsigned P = 0, PE = UniqueParams.size();
+    for (; P != PE; ++P) {
+      unsigned U = UniqueParams[P];
+      bool Same = true;
+      for (const SmallVector<Constant *, 4> &A : Args)
+        Same &= A[U] == A[i];
+      if (Same)
+        break;
+    }
+    if (P == PE) {
+      UniqueParams.push_back(i);
+      ParamTys.push_back(Args[0][i]->getType());
+    }
+    ParamOf.push_back(P);
+  }
+
+  // Move the body of F into H, and replace the constants by the parameters.
+  FunctionType *HTy = FunctionType::get(F->getReturnType(), ParamTys, false);
+  Function *H = Function::Create(HTy, GlobalValue::InternalLinkage,
+                                 F->getName() + ".param", F->getParent());
+  H->setAttributes(F->getAttributes());
+  H->setCallingConv(F->getCallingConv());
+  H->setAlignment(F->getAlignment());
+  if (F->hasSection())
+    H->setSection(F->getSection());
+  if (F->hasGC())
+    H->setGC(F->getGC());
+  H->setUnnamedAddr(true);
+  H->getBasicBlockList().splice(H->begin(), F->getBasicBlockList());
+  Function::arg_iterator HAI = H->arg_begin();
+  for (Argument &A : F->args()) {
+    A.replaceAllUsesWith(HAI);
+    HAI->takeName(&A);
+    ++HAI;
+  }
+  SmallVector<Value *, 4> NewParams;
+  for (; HAI != H->arg_end(); ++HAI)
+    NewParams.push_back(HAI);
+  for (unsigned i = 0, e = Params.size(); i != e; ++i)
+    const_cast<Instruction *>(Params[i].first)
+        ->setOperand(Params[i].second, NewParams[ParamOf[i]]);
+
+  // Every function passes its own constants to H.
+  auto WriteThunkBody = [&](Function *Thunk, ArrayRef<Constant *> Consts) {
+    BasicBlock *BB = BasicBlock::Create(Thunk->getContext(), "", Thunk);
+    IRBuilder<false> Builder(BB);
+    SmallVector<Value *, 16> CallArgs;
+    unsigned i = 0;
+    for (Argument &A : Thunk->args())
+      CallArgs.push_back(createCast(Builder, &A, HTy->getParamType(i++)));
+    for (unsigned U : UniqueParams)
+      CallArgs.push_back(Consts[U]);
+    CallInst *CI = Builder.CreateCall(H, CallArgs);
+    CI->setTailCall();
+    CI->setCallingConv(H->getCallingConv());
+    if (Thunk->getReturnType()->isVoidTy())
+      Builder.CreateRetVoid();
+    else
+      Builder.CreateRet(createCast(Builder, CI, Thunk->getReturnType()));
+    ++NumThunksWritten;
+  };
+  WriteThunkBody(F, Args[0]);
+  for (unsigned i = 0, e = Gs.size(); i != e; ++i) {
+    Function *G = Gs[i];
+    GlobalValue::LinkageTypes Linkage = G->getLinkage();
+    G->deleteBody();
+    G->setLinkage(Linkage);
+    WriteThunkBody(G, Args[i + 1]);
+  }
+}
+
 // Remove a function from FnTree. If it was already in FnTree, add
 // it to Deferred so that we'll look at it in the next round.
 void MergeFunctions::remove(Function *F) {
@@ -25,6 +25,7 @@
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/Instrumentation.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Vectorize.h"
 
@@ -81,6 +82,18 @@ static cl::opt<bool> EnableLoopDistribute(
     "enable-loop-distribute", cl::init(false), cl::Hidden,
     cl::desc("Enable the new, experimental LoopDistribution Pass"));
 
+static cl::opt<bool> EnableHotColdSplit(
+    "hot-cold-split", cl::init(false), cl::Hidden,
+    cl::desc("Enable the experimental hot/cold splitting pass"));
+
+static cl::opt<bool> DisableICP(
+    "disable-icp", cl::init(false), cl::Hidden,
+    cl::desc("Disable the promotion of profiled indirect calls"));
+
+static cl::opt<bool> EnableFunctionOrdering(
+    "enable-function-ordering", cl::init(false), cl::Hidden,
+    cl::desc("Order functions by their profile at the end of the pipeline"));
+
 PassManagerBuilder::PassManagerBuilder() {
     OptLevel = 2;
     SizeLevel = 0;
@@ -193,6 +206,9 @@ void PassManagerBuilder::populateModulePassManager(PassManagerBase &MPM) {
   if (!DisableUnitAtATime) {
     addExtensionsToPM(EP_ModuleOptimizerEarly, MPM);
 
+    // Promote the hot indirect call targets before the inliner runs.
+    if (!DisableICP)
+      MPM.add(createPGOIndirectCallPromotionPass());
     MPM.add(createIPSCCPPass());              // IP SCCP
     MPM.add(createGlobalOptimizerPass());     // Optimize out global vars
 
@@ -366,6 +382,10 @@ void PassManagerBuilder::populateModulePassManager(PassManagerBase &MPM) {
   // about pointer alignments.
   MPM.add(createAlignmentFromAssumptionsPass());
 
+  // Outline the cold regions once the hot code has been optimized.
+  if (EnableHotColdSplit && OptLevel > 1 && SizeLevel == 0)
+    MPM.add(createHotColdSplittingPass());
+
   if (!DisableUnitAtATime) {
     // FIXME: We shouldn't bother with this anymore.
     MPM.add(createStripDeadPrototypesPass()); // Get rid of dead prototypes
@@ -381,12 +401,17 @@ void PassManagerBuilder::populateModulePassManager(PassManagerBase &MPM) {
   if (MergeFunctions)
     MPM.add(createMergeFunctionsPass());
 
+  if (EnableFunctionOrdering && OptLevel > 1)
+    MPM.add(createFunctionOrderingPass());
+
   addExtensionsToPM(EP_OptimizerLast, MPM);
 }
 
-void PassManagerBuilder::addLTOOptimizationPasses(PassManagerBase &PM) {
-  // Provide AliasAnalysis services for optimizations.
-  addInitialAliasAnalysisPasses(PM);
+void PassManagerBuilder::addLTOIPOPasses(PassManagerBase &PM) {
+  // The linked module holds every virtual table of the program, so the
+  // targets of the virtual calls are known.  Resolve the calls that have only
+  // one target before IPSCCP, so that it can propagate into them.
+  PM.add(createWholeProgramDevirtPass());
 
   // Propagate constants at call sites into the functions they call.  This
   // opens opportunities for globalopt (and inlining) by substituting function
@@ -441,6 +466,9 @@ void PassManagerBuilder::addLTOOptimizationPasses(PassManagerBase &PM) {
 
   // Run a few AA driven optimizations here and now, to cleanup the code.
   PM.add(createFunctionAttrsPass()); // Add nocapture.
+}
+
+void PassManagerBuilder::addLTOFunctionPasses(PassManagerBase &PM) {
   PM.add(createGlobalsModRefPass()); // IP alias analysis.
 
   PM.add(createLICMPass());                 // Hoist loop invariants.
@@ -477,6 +505,14 @@ void PassManagerBuilder::addLTOOptimizationPasses(PassManagerBase &PM) {
 
   // Delete basic blocks, which optimization passes may have killed.
   PM.add(createCFGSimplificationPass());
+}
+
+void PassManagerBuilder::addLTOOptimizationPasses(PassManagerBase &PM) {
+  // Provide AliasAnalysis services for optimizations.
+  addInitialAliasAnalysisPasses(PM);
+
+  addLTOIPOPasses(PM);
+  addLTOFunctionPasses(PM);
 
   // Now that we have optimized the program, discard unreachable functions.
   PM.add(createGlobalDCEPass());
@@ -485,6 +521,11 @@ void PassManagerBuilder::addLTOOptimizationPasses(PassManagerBase &PM) {
   // currently it damages debug info.
   if (MergeFunctions)
     PM.add(createMergeFunctionsPass());
+
+  // With the whole program in one module, the function order is the final
+  // layout of the hot text.
+  if (EnableFunctionOrdering)
+    PM.add(createFunctionOrderingPass());
 }
 
 void PassManagerBuilder::populateLTOPassManager(PassManagerBase &PM) {
@@ -501,6 +542,35 @@ void PassManagerBuilder::populateLTOPassManager(PassManagerBase &PM) {
     PM.add(createVerifierPass());
 }
 
+void PassManagerBuilder::populateLTOIPOPassManager(PassManagerBase &PM) {
+  if (LibraryInfo)
+    PM.add(new TargetLibraryInfoWrapperPass(*LibraryInfo));
+
+  if (VerifyInput)
+    PM.add(createVerifierPass());
+
+  if (OptLevel != 0) {
+    addInitialAliasAnalysisPasses(PM);
+    addLTOIPOPasses(PM);
+  }
+
+  if (VerifyOutput)
+    PM.add(createVerifierPass());
+}
+
+void PassManagerBuilder::populateLTOFunctionPassManager(PassManagerBase &PM) {
+  if (LibraryInfo)
+    PM.add(new TargetLibraryInfoWrapperPass(*LibraryInfo));
+
+  if (OptLevel != 0) {
+    addInitialAliasAnalysisPasses(PM);
+    addLTOFunctionPasses(PM);
+  }
+
+  if (VerifyOutput)
+    PM.add(createVerifierPass());
+}
+
 inline PassManagerBuilder *unwrap(LLVMPassManagerBuilderRef P) {
     return reinterpret_cast<PassManagerBuilder*>(P);
 }
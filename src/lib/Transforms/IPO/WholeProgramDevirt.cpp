@@ -0,0 +1,231 @@
+//===- WholeProgramDevirt.cpp - Whole program virtual call optimization ---===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass devirtualizes virtual calls when the module contains every virtual
+// table of the class hierarchy, as it does under LTO. The front end lists the
+// address points of each virtual table with the classes they are compatible
+// with in the llvm.vtable.types named metadata, and marks each load of a
+// virtual function pointer with the class and slot that it reads through
+// !vtable.slot metadata. The possible targets of a virtual call are the
+// functions in that slot of the compatible virtual tables.
+//
+// If every target is the same function, the loaded pointer is replaced with the
+// function, so that the call becomes direct. If every target only returns the
+// same constant, or returns nothing, the calls are replaced with that value.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/IPO.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+using namespace llvm;
+
+#define DEBUG_TYPE "wholeprogramdevirt"
+
+STATISTIC(NumSingleImpl, "Number of virtual calls with a single target");
+STATISTIC(NumUniformRetVal, "Number of virtual calls folded to a uniform "
+                            "return value");
+
+namespace {
+  struct WholeProgramDevirt : public ModulePass {
+    static char ID; // Pass identification, replacement for typeid
+    WholeProgramDevirt() : ModulePass(ID) {
+      initializeWholeProgramDevirtPass(*PassRegistry::getPassRegistry());
+    }
+
+    bool runOnModule(Module &M) override;
+
+  private:
+    typedef std::pair<GlobalVariable *, uint64_t> AddressPoint;
+    typedef std::pair<Metadata *, uint64_t> VirtualSlot;
+
+    /// The address points of the virtual tables compatible with each type
+    /// identifier.
+    DenseMap<Metadata *, SmallSetVector<AddressPoint, 4>> AddressPoints;
+    /// The loads of virtual function pointers from each slot.
+    MapVector<VirtualSlot, SmallVector<LoadInst *, 4>> SlotLoads;
+
+    bool findTargets(const DataLayout &DL, VirtualSlot Slot,
+                     SmallSetVector<Function *, 4> &Targets);
+    bool foldUniformReturnValue(const SmallSetVector<Function *, 4> &Targets,
+                                ArrayRef<LoadInst *> Loads);
+  };
+}
+
+char WholeProgramDevirt::ID = 0;
+INITIALIZE_PASS(WholeProgramDevirt, "wholeprogramdevirt",
+                "Whole program devirtualization", false, false)
+
+ModulePass *llvm::createWholeProgramDevirtPass() {
+  return new WholeProgramDevirt();
+}
+
+/// \brief Finds the functions that the loads from \p Slot may yield. Returns
+/// false if some virtual table in the slot cannot be read.
+bool WholeProgramDevirt::findTargets(const DataLayout &DL, VirtualSlot Slot,
+                                     SmallSetVector<Function *, 4> &Targets) {
+  auto I = AddressPoints.find(Slot.first);
+  if (I == AddressPoints.end())
+    return false;
+  for (const AddressPoint &AP : I->second) {
+    GlobalVariable *VTable = AP.first;
+    if (!VTable->hasInitializer() || VTable->mayBeOverridden())
+      return false;
+    Constant *Init = VTable->getInitializer();
+    ArrayType *Ty = dyn_cast<ArrayType>(Init->getType());
+    if (!Ty)
+      return false;
+    uint64_t EltSize = DL.getTypeAllocSize(Ty->getElementType());
+    uint64_t Offset = AP.second + Slot.second;
+    if (!EltSize || Offset % EltSize ||
+        Offset / EltSize >= Ty->getNumElements())
+      return false;
+    Constant *Elt = Init->getAggregateElement(Offset / EltSize);
+    Function *Fn = Elt ? dyn_cast<Function>(Elt->stripPointerCasts()) : nullptr;
+    if (!Fn)
+      return false;
+    // No object has the dynamic type of a class with a pure virtual function.
+    if (Fn->getName() == "__cxa_pure_virtual")
+      continue;
+    Targets.insert(Fn);
+  }
+  return !Targets.empty();
+}
+
+/// \brief Returns true if \p Fn does nothing but return, and sets \p RetVal to
+/// the value that it returns, or to null if it returns void.
+static bool isTrivialReturn(const Function &Fn, Constant *&RetVal) {
+  if (Fn.isDeclaration() || Fn.mayBeOverridden())
+    return false;
+  const ReturnInst *Ret =
+      dyn_cast<ReturnInst>(Fn.getEntryBlock().getFirstNonPHIOrDbg());
+  if (!Ret)
+    return false;
+  RetVal = nullptr;
+  if (Value *V = Ret->getReturnValue()) {
+    RetVal = dyn_cast<Constant>(V);
+    return RetVal != nullptr;
+  }
+  return true;
+}
+
+bool WholeProgramDevirt::foldUniformReturnValue(
+    const SmallSetVector<Function *, 4> &Targets, ArrayRef<LoadInst *> Loads) {
+  Constant *RetVal = nullptr;
+  for (Function *Fn : Targets) {
+    Constant *FnRetVal;
+    if (!isTrivialReturn(*Fn, FnRetVal) ||
+        (Fn != Targets[0] && FnRetVal != RetVal))
+      return false;
+    RetVal = FnRetVal;
+  }
+
+  Type *RetTy = RetVal ? RetVal->getType()
+                       : Type::getVoidTy(Targets[0]->getContext());
+  bool Changed = false;
+  for (LoadInst *LI : Loads) {
+    SmallVector<Instruction *, 4> Calls;
+    SmallVector<Value *, 4> Worklist(1, LI);
+    while (!Worklist.empty()) {
+      Value *V = Worklist.pop_back_val();
+      for (Use &U : V->uses()) {
+        if (isa<BitCastInst>(U.getUser())) {
+          Worklist.push_back(U.getUser());
+          continue;
+        }
+        CallSite CS(U.getUser());
+        if (CS && CS.isCallee(&U) && CS.getType() == RetTy)
+          Calls.push_back(CS.getInstruction());
+      }
+    }
+
+    for (Instruction *Call : Calls) {
+      if (RetVal)
+        Call->replaceAllUsesWith(RetVal);
+      if (InvokeInst *II = dyn_cast<InvokeInst>(Call)) {
+        BranchInst::Create(II->getNormalDest(), II);
+        II->getUnwindDest()->removePredecessor(II->getParent());
+      }
+      Call->eraseFromParent();
+      ++NumUniformRetVal;
+      Changed = true;
+    }
+  }
+  return Changed;
+}
+
+bool WholeProgramDevirt::runOnModule(Module &M) {
+  NamedMDNode *VTableTypes = M.getNamedMetadata("llvm.vtable.types");
+  if (!VTableTypes)
+    return false;
+
+  AddressPoints.clear();
+  SlotLoads.clear();
+  for (MDNode *Entry : VTableTypes->operands()) {
+    if (Entry->getNumOperands() != 3)
+      continue;
+    // The operand of a virtual table that was deleted is null.
+    auto *VTable = mdconst::dyn_extract_or_null<GlobalVariable>(
+        Entry->getOperand(1));
+    auto *Offset = mdconst::dyn_extract_or_null<ConstantInt>(
+        Entry->getOperand(2));
+    if (Entry->getOperand(0) && VTable && Offset)
+      AddressPoints[Entry->getOperand(0)].insert(
+          std::make_pair(VTable, Offset->getZExtValue()));
+  }
+
+  unsigned SlotKind = M.getMDKindID("vtable.slot");
+  for (Function &F : M)
+    for (BasicBlock &BB : F)
+      for (Instruction &I : BB) {
+        LoadInst *LI = dyn_cast<LoadInst>(&I);
+        MDNode *MD = LI ? LI->getMetadata(SlotKind) : nullptr;
+        if (!MD || MD->getNumOperands() != 2 || !MD->getOperand(0))
+          continue;
+        if (auto *Offset =
+                mdconst::dyn_extract_or_null<ConstantInt>(MD->getOperand(1)))
+          SlotLoads[VirtualSlot(MD->getOperand(0), Offset->getZExtValue())]
+              .push_back(LI);
+      }
+
+  const DataLayout &DL = M.getDataLayout();
+  bool Changed = false;
+  for (auto &Slot : SlotLoads) {
+    SmallSetVector<Function *, 4> Targets;
+    if (!findTargets(DL, Slot.first, Targets))
+      continue;
+    DEBUG(dbgs() << "WholeProgramDevirt: " << Slot.second.size()
+                 << " loads of slot " << Slot.first.second << " with "
+                 << Targets.size() << " targets\n");
+
+    Changed |= foldUniformReturnValue(Targets, Slot.second);
+    if (Targets.size() != 1)
+      continue;
+    Function *Target = Targets[0];
+    for (LoadInst *LI : Slot.second) {
+      if (!LI->use_empty()) {
+        LI->replaceAllUsesWith(ConstantExpr::getBitCast(Target, LI->getType()));
+        ++NumSingleImpl;
+      }
+      LI->eraseFromParent();
+      Changed = true;
+    }
+  }
+  return Changed;
+}
@@ -136,12 +136,17 @@ private:
 
   bool MadeIRChange;
 
+  /// \brief The number of instructions erased so far, which tells whether
+  /// pointers to instructions taken before a combine are still valid.
+  unsigned NumErased;
+
 public:
   InstCombiner(InstCombineWorklist &Worklist, BuilderTy *Builder,
                bool MinimizeSize, AssumptionCache *AC, TargetLibraryInfo *TLI,
                DominatorTree *DT, const DataLayout &DL, LoopInfo *LI)
       : Worklist(Worklist), Builder(Builder), MinimizeSize(MinimizeSize),
-        AC(AC), TLI(TLI), DT(DT), DL(DL), LI(LI), MadeIRChange(false) {}
+        AC(AC), TLI(TLI), DT(DT), DL(DL), LI(LI), MadeIRChange(false),
+        NumErased(0) {}
 
   /// \brief Run the combiner over the entire worklist until it is empty.
   ///
@@ -391,6 +396,7 @@ public:
     }
     Worklist.Remove(&I);
     I.eraseFromParent();
+    ++NumErased;
     MadeIRChange = true;
     return nullptr; // Don't do anything with FI
   }
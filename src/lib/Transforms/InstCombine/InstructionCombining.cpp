@@ -73,6 +73,19 @@ STATISTIC(NumSunkInst , "Number of instructions sunk");
 STATISTIC(NumExpand,    "Number of expansions");
 STATISTIC(NumFactor   , "Number of factorizations");
 STATISTIC(NumReassoc  , "Number of reassociations");
+STATISTIC(NumWorklistIterations,
+          "Number of instruction combining iterations performed");
+STATISTIC(NumOneIteration, "Number of functions with one iteration");
+STATISTIC(NumTwoIterations, "Number of functions with two iterations");
+STATISTIC(NumThreeIterations, "Number of functions with three iterations");
+STATISTIC(NumFourOrMoreIterations,
+          "Number of functions with four or more iterations");
+
+static cl::opt<unsigned>
+MaxIterations("instcombine-max-iterations",
+              cl::desc("Limit the maximum number of instruction combining "
+                       "iterations over a function"),
+              cl::init(1000));
 
 Value *InstCombiner::EmitGEPOffset(User *GEP) {
   return llvm::EmitGEPOffset(Builder, DL, GEP);
@@ -2683,6 +2696,13 @@ bool InstCombiner::run() {
     DEBUG(raw_string_ostream SS(OrigI); I->print(SS); OrigI = SS.str(););
     DEBUG(dbgs() << "IC: Visiting: " << OrigI << '\n');
 
+    // Remember the operands, which may lose a use if I is changed in place.
+    SmallVector<Instruction *, 4> OrigOperands;
+    for (Use &U : I->operands())
+      if (Instruction *OpI = dyn_cast<Instruction>(U.get()))
+        OrigOperands.push_back(OpI);
+    unsigned NumErasedBefore = NumErased;
+
     if (Instruction *Result = visit(*I)) {
       ++NumCombined;
       // Should we replace the old instruction with a new one?
@@ -2720,6 +2740,14 @@ bool InstCombiner::run() {
                      << "    New = " << *I << '\n');
 #endif
 
+        // The operands that I no longer uses may now be dead or have a
+        // single use.  Revisit them now rather than in another iteration over
+        // the whole function; unless something was erased, they all still
+        // exist.
+        if (NumErased == NumErasedBefore)
+          for (Instruction *OpI : OrigOperands)
+            Worklist.Add(OpI);
+
         // If the instruction was modified, it's possible that it is now dead.
         // if so, remove it.
         if (isInstructionTriviallyDead(I, TLI)) {
@@ -2915,26 +2943,45 @@ combineInstructionsOverFunction(Function &F, InstCombineWorklist &Worklist,
   // by instcombiner.
   bool DbgDeclaresChanged = LowerDbgDeclare(F);
 
-  // Iterate while there is work to do.
-  int Iteration = 0;
+  // Iterate while there is work to do.  The worklist revisits everything a
+  // combine may have enabled, so another iteration rarely finds anything; it
+  // only makes sure nothing was missed.
+  bool MadeIRChange = false;
+  unsigned Iteration = 0;
   for (;;) {
     ++Iteration;
+    ++NumWorklistIterations;
     DEBUG(dbgs() << "\n\nINSTCOMBINE ITERATION #" << Iteration << " on "
                  << F.getName() << "\n");
 
-    bool Changed = false;
+    // The changes made while preparing the worklist, such as deleting
+    // unreachable code and folding constants, are all seen by the combiner
+    // run that follows, so they do not call for another iteration.
     if (prepareICWorklistFromFunction(F, DL, &TLI, Worklist))
-      Changed = true;
+      MadeIRChange = true;
 
     InstCombiner IC(Worklist, &Builder, MinimizeSize, &AC, &TLI, &DT, DL, LI);
-    if (IC.run())
-      Changed = true;
+    if (!IC.run())
+      break;
+    MadeIRChange = true;
 
-    if (!Changed)
+    if (Iteration >= MaxIterations) {
+      DEBUG(dbgs() << "INSTCOMBINE: stopping after " << Iteration
+                   << " iterations on " << F.getName() << "\n");
       break;
+    }
   }
 
-  return DbgDeclaresChanged || Iteration > 1;
+  if (Iteration == 1)
+    ++NumOneIteration;
+  else if (Iteration == 2)
+    ++NumTwoIterations;
+  else if (Iteration == 3)
+    ++NumThreeIterations;
+  else
+    ++NumFourOrMoreIterations;
+
+  return DbgDeclaresChanged || MadeIRChange;
 }
 
 PreservedAnalyses InstCombinePass::run(Function &F,
@@ -2949,10 +2996,12 @@ PreservedAnalyses InstCombinePass::run(Function &F,
     // No changes, all analyses are preserved.
     return PreservedAnalyses::all();
 
-  // Mark all the analyses that instcombine updates as preserved.
-  // FIXME: Need a way to preserve CFG analyses here!
+  // Mark all the analyses that instcombine updates as preserved, and the
+  // analyses that only depend on the CFG, which instcombine doesn't change.
+  // FIXME: Need a way to preserve all the CFG analyses here!
   PreservedAnalyses PA;
   PA.preserve<DominatorTreeAnalysis>();
+  PA.preserve<LoopAnalysis>();
   return PA;
 }
 
@@ -25,6 +25,8 @@
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/CallSite.h"
 #include "llvm/IR/DIBuilder.h"
 #include "llvm/IR/DataLayout.h"
@@ -191,6 +193,12 @@ static cl::opt<bool> ClOptSameTemp("asan-opt-same-temp",
        cl::init(true));
 static cl::opt<bool> ClOptGlobals("asan-opt-globals",
        cl::desc("Don't instrument scalar globals"), cl::Hidden, cl::init(true));
+static cl::opt<bool> ClOptDominating("asan-opt-dominating",
+       cl::desc("Don't instrument accesses covered by a dominating check"),
+       cl::Hidden, cl::init(true));
+static cl::opt<bool> ClOptLoopInvariant("asan-opt-loop-invariant",
+       cl::desc("Check loop invariant addresses once before the loop"),
+       cl::Hidden, cl::init(true));
 
 static cl::opt<bool> ClCheckLifetime("asan-check-lifetime",
        cl::desc("Use llvm.lifetime intrinsics to insert extra checks"),
@@ -221,6 +229,12 @@ STATISTIC(NumOptimizedAccessesToGlobalArray,
           "Number of optimized accesses to global arrays");
 STATISTIC(NumOptimizedAccessesToGlobalVar,
           "Number of optimized accesses to global vars");
+STATISTIC(NumOptimizedAccessesToSameTemp,
+          "Number of optimized accesses to a temp checked in the same block");
+STATISTIC(NumOptimizedDominatedAccesses,
+          "Number of optimized accesses covered by a dominating check");
+STATISTIC(NumHoistedLoopInvariantChecks,
+          "Number of checks hoisted out of loops");
 
 namespace {
 /// Frontend-provided metadata for source location.
@@ -388,6 +402,7 @@ struct AddressSanitizer : public FunctionPass {
   }
   void getAnalysisUsage(AnalysisUsage &AU) const override {
     AU.addRequired<DominatorTreeWrapperPass>();
+    AU.addRequired<LoopInfoWrapperPass>();
   }
   uint64_t getAllocaSizeInBytes(AllocaInst *AI) const {
     Type *Ty = AI->getAllocatedType();
@@ -401,7 +416,8 @@ struct AddressSanitizer : public FunctionPass {
   /// and set IsWrite/Alignment. Otherwise return nullptr.
   Value *isInterestingMemoryAccess(Instruction *I, bool *IsWrite,
                                    unsigned *Alignment);
-  void instrumentMop(Instruction *I, bool UseCalls, const DataLayout &DL);
+  void instrumentMop(Instruction *I, Instruction *InsertBefore, bool UseCalls,
+                     const DataLayout &DL);
   void instrumentPointerComparisonOrSubtraction(Instruction *I);
   void instrumentAddress(Instruction *OrigIns, Instruction *InsertBefore,
                          Value *Addr, uint32_t TypeSize, bool IsWrite,
@@ -424,6 +440,13 @@ struct AddressSanitizer : public FunctionPass {
   void initializeCallbacks(Module &M);
 
   bool LooksLikeCodeInBug11395(Instruction *I);
+  void removeDominatedAccesses(SmallVectorImpl<Instruction *> &ToInstrument,
+                               const SmallPtrSetImpl<BasicBlock *> &CallBlocks,
+                               const DataLayout &DL);
+  Instruction *
+  getCheckInsertPoint(Instruction *I, LoopInfo &LI,
+                      const SmallPtrSetImpl<BasicBlock *> &CallBlocks,
+                      DenseMap<Loop *, bool> &LoopHasCalls);
   bool GlobalIsLinkerInitialized(GlobalVariable *G);
 
   LLVMContext *C;
@@ -708,6 +731,7 @@ INITIALIZE_PASS_BEGIN(AddressSanitizer, "asan",
     "AddressSanitizer: detects use-after-free and out-of-bounds bugs.",
     false, false)
 INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(LoopInfoWrapperPass)
 INITIALIZE_PASS_END(AddressSanitizer, "asan",
     "AddressSanitizer: detects use-after-free and out-of-bounds bugs.",
     false, false)
@@ -898,8 +922,8 @@ AddressSanitizer::instrumentPointerComparisonOrSubtraction(Instruction *I) {
   IRB.CreateCall2(F, Param[0], Param[1]);
 }
 
-void AddressSanitizer::instrumentMop(Instruction *I, bool UseCalls,
-                                     const DataLayout &DL) {
+void AddressSanitizer::instrumentMop(Instruction *I, Instruction *InsertBefore,
+                                     bool UseCalls, const DataLayout &DL) {
   bool IsWrite = false;
   unsigned Alignment = 0;
   Value *Addr = isInterestingMemoryAccess(I, &IsWrite, &Alignment);
@@ -943,12 +967,13 @@ void AddressSanitizer::instrumentMop(Instruction *I, bool UseCalls,
   if ((TypeSize == 8 || TypeSize == 16 || TypeSize == 32 || TypeSize == 64 ||
        TypeSize == 128) &&
       (Alignment >= Granularity || Alignment == 0 || Alignment >= TypeSize / 8))
-    return instrumentAddress(I, I, Addr, TypeSize, IsWrite, nullptr, UseCalls);
+    return instrumentAddress(I, InsertBefore, Addr, TypeSize, IsWrite, nullptr,
+                             UseCalls);
   // Instrument unusual size or unusual alignment.
   // We can not do it with a single check, so we do 1-byte check for the first
   // and the last bytes. We call __asan_report_*_n(addr, real_size) to be able
   // to report the actual access size.
-  IRBuilder<> IRB(I);
+  IRBuilder<> IRB(InsertBefore);
   Value *Size = ConstantInt::get(IntptrTy, TypeSize / 8);
   Value *AddrLong = IRB.CreatePointerCast(Addr, IntptrTy);
   if (UseCalls) {
@@ -957,8 +982,8 @@ void AddressSanitizer::instrumentMop(Instruction *I, bool UseCalls,
     Value *LastByte = IRB.CreateIntToPtr(
         IRB.CreateAdd(AddrLong, ConstantInt::get(IntptrTy, TypeSize / 8 - 1)),
         OrigPtrTy);
-    instrumentAddress(I, I, Addr, 8, IsWrite, Size, false);
-    instrumentAddress(I, I, LastByte, 8, IsWrite, Size, false);
+    instrumentAddress(I, InsertBefore, Addr, 8, IsWrite, Size, false);
+    instrumentAddress(I, InsertBefore, LastByte, 8, IsWrite, Size, false);
   }
 }
 
@@ -1460,6 +1485,160 @@ bool AddressSanitizer::maybeInsertAsanInitAtFunctionEntry(Function &F) {
   return false;
 }
 
+// Calls may free memory or poison it, so a check doesn't hold across them.
+// Debug intrinsics are the exception.
+static bool mayChangeShadow(Instruction *I) {
+  return CallSite(I) && !isa<DbgInfoIntrinsic>(I);
+}
+
+static bool mayChangeShadow(BasicBlock::iterator I, BasicBlock::iterator E) {
+  for (; I != E; ++I)
+    if (mayChangeShadow(I))
+      return true;
+  return false;
+}
+
+// The number of blocks searched for calls between two accesses, above which
+// the accesses are both instrumented.
+static const unsigned kMaxBlocksBetweenAccesses = 32;
+
+/// Returns true if a call may run on a path from From to To, which From
+/// dominates. CallBlocks holds the blocks that may contain calls.
+static bool
+mayChangeShadowBetween(Instruction *From, Instruction *To,
+                       const SmallPtrSetImpl<BasicBlock *> &CallBlocks,
+                       DominatorTree &DT) {
+  BasicBlock *FromBB = From->getParent(), *ToBB = To->getParent();
+  BasicBlock::iterator AfterFrom = From;
+  ++AfterFrom;
+  if (FromBB == ToBB)
+    return mayChangeShadow(AfterFrom, To);
+  if (mayChangeShadow(AfterFrom, FromBB->end()) ||
+      mayChangeShadow(ToBB->begin(), To))
+    return true;
+  // Every path reaching ToBB from the entry goes through FromBB: walk the
+  // blocks backwards from ToBB until FromBB. ToBB is found again if it is in
+  // a cycle that doesn't go through From, and is then searched as a whole.
+  SmallVector<BasicBlock *, 8> Worklist(pred_begin(ToBB), pred_end(ToBB));
+  SmallPtrSet<BasicBlock *, 16> Visited;
+  while (!Worklist.empty()) {
+    BasicBlock *BB = Worklist.pop_back_val();
+    if (BB == FromBB || !DT.isReachableFromEntry(BB) ||
+        !Visited.insert(BB).second)
+      continue;
+    if (CallBlocks.count(BB) || Visited.size() > kMaxBlocksBetweenAccesses)
+      return true;
+    Worklist.append(pred_begin(BB), pred_end(BB));
+  }
+  return false;
+}
+
+/// Removes from ToInstrument the memory accesses whose bytes are all checked
+/// by another access that dominates them, when no call may run in between.
+/// Accesses are compared by their base pointer and constant offset, so that
+/// e.g. the check of an 8 byte load covers the loads of its halves.
+void AddressSanitizer::removeDominatedAccesses(
+    SmallVectorImpl<Instruction *> &ToInstrument,
+    const SmallPtrSetImpl<BasicBlock *> &CallBlocks, const DataLayout &DL) {
+  struct CheckedRange {
+    Instruction *I;
+    int64_t Begin, End;
+  };
+  // Comparing an access with a bounded number of checks of its base keeps
+  // this linear.
+  const unsigned kMaxChecksPerBase = 16;
+
+  // Visit the accesses in dominator tree order, so that the checks that may
+  // cover an access are known when it is reached.
+  DenseMap<BasicBlock *, unsigned> BlockOrder;
+  unsigned NumBlocks = 0;
+  for (auto DTN : depth_first(DT->getRootNode()))
+    BlockOrder[DTN->getBlock()] = NumBlocks++;
+  SmallVector<Instruction *, 16> Sorted(ToInstrument.begin(),
+                                        ToInstrument.end());
+  std::stable_sort(Sorted.begin(), Sorted.end(),
+                   [&](Instruction *A, Instruction *B) {
+    return BlockOrder.lookup(A->getParent()) <
+           BlockOrder.lookup(B->getParent());
+  });
+
+  DenseMap<Value *, SmallVector<CheckedRange, 4>> Checks;
+  SmallPtrSet<Instruction *, 16> Removed;
+  for (Instruction *I : Sorted) {
+    bool IsWrite;
+    unsigned Alignment;
+    Value *Addr = isInterestingMemoryAccess(I, &IsWrite, &Alignment);
+    if (!Addr)
+      continue;  // A mem intrinsic.
+    int64_t Offset = 0;
+    Value *Base = GetPointerBaseWithConstantOffset(Addr, Offset, DL);
+    Type *Ty = cast<PointerType>(Addr->getType())->getElementType();
+    int64_t End = Offset + DL.getTypeStoreSize(Ty);
+    SmallVectorImpl<CheckedRange> &BaseChecks = Checks[Base];
+    bool Covered = false;
+    for (const CheckedRange &Check : BaseChecks) {
+      if (Check.Begin <= Offset && End <= Check.End &&
+          DT->dominates(Check.I, I) &&
+          !mayChangeShadowBetween(Check.I, I, CallBlocks, *DT)) {
+        Covered = true;
+        break;
+      }
+    }
+    if (Covered) {
+      Removed.insert(I);
+      NumOptimizedDominatedAccesses++;
+    } else if (BaseChecks.size() < kMaxChecksPerBase) {
+      BaseChecks.push_back({I, Offset, End});
+    }
+  }
+  if (Removed.empty())
+    return;
+  ToInstrument.erase(std::remove_if(ToInstrument.begin(), ToInstrument.end(),
+                                    [&](Instruction *I) {
+                                      return Removed.count(I);
+                                    }),
+                     ToInstrument.end());
+}
+
+/// Returns the instruction before which the access I is to be checked. That
+/// is the terminator of the preheader of the outermost loop for which the
+/// address of I is invariant, which has no calls, and which can neither loop
+/// nor exit without executing I. Otherwise it is I itself.
+Instruction *AddressSanitizer::getCheckInsertPoint(
+    Instruction *I, LoopInfo &LI,
+    const SmallPtrSetImpl<BasicBlock *> &CallBlocks,
+    DenseMap<Loop *, bool> &LoopHasCalls) {
+  bool IsWrite;
+  unsigned Alignment;
+  Value *Addr = isInterestingMemoryAccess(I, &IsWrite, &Alignment);
+  BasicBlock *BB = I->getParent();
+  Instruction *InsertBefore = I;
+  for (Loop *L = LI.getLoopFor(BB); L; L = L->getParentLoop()) {
+    BasicBlock *Preheader = L->getLoopPreheader();
+    if (!Preheader || !L->isLoopInvariant(Addr))
+      break;
+    auto HasCalls = LoopHasCalls.find(L);
+    if (HasCalls == LoopHasCalls.end()) {
+      bool Calls = std::any_of(L->block_begin(), L->block_end(),
+                               [&](BasicBlock *LoopBB) {
+        return CallBlocks.count(LoopBB) != 0;
+      });
+      HasCalls = LoopHasCalls.insert(std::make_pair(L, Calls)).first;
+    }
+    if (HasCalls->second)
+      break;
+    SmallVector<BasicBlock *, 4> Blocks;
+    L->getLoopLatches(Blocks);
+    L->getExitingBlocks(Blocks);
+    if (std::any_of(Blocks.begin(), Blocks.end(), [&](BasicBlock *Other) {
+          return !DT->dominates(BB, Other);
+        }))
+      break;
+    InsertBefore = Preheader->getTerminator();
+  }
+  return InsertBefore;
+}
+
 bool AddressSanitizer::runOnFunction(Function &F) {
   if (&F == AsanCtorFunction) return false;
   if (F.getLinkage() == GlobalValue::AvailableExternallyLinkage) return false;
@@ -1484,6 +1663,8 @@ bool AddressSanitizer::runOnFunction(Function &F) {
   SmallVector<Instruction*, 8> NoReturnCalls;
   SmallVector<BasicBlock*, 16> AllBlocks;
   SmallVector<Instruction*, 16> PointerComparisonsOrSubtracts;
+  // The blocks which may contain calls, for the optimizations across blocks.
+  SmallPtrSet<BasicBlock*, 16> CallBlocks;
   int NumAllocas = 0;
   bool IsWrite;
   unsigned Alignment;
@@ -1498,8 +1679,10 @@ bool AddressSanitizer::runOnFunction(Function &F) {
       if (Value *Addr =
               isInterestingMemoryAccess(&Inst, &IsWrite, &Alignment)) {
         if (ClOpt && ClOptSameTemp) {
-          if (!TempsToInstrument.insert(Addr).second)
+          if (!TempsToInstrument.insert(Addr).second) {
+            NumOptimizedAccessesToSameTemp++;
             continue;  // We've seen this temp in the current BB.
+          }
         }
       } else if (ClInvalidPointerPairs &&
                  isInterestingPointerComparisonOrSubtraction(&Inst)) {
@@ -1511,6 +1694,8 @@ bool AddressSanitizer::runOnFunction(Function &F) {
         if (isa<AllocaInst>(Inst))
           NumAllocas++;
         CallSite CS(&Inst);
+        if (mayChangeShadow(&Inst))
+          CallBlocks.insert(&BB);
         if (CS) {
           // A call inside BB.
           TempsToInstrument.clear();
@@ -1521,24 +1706,49 @@ bool AddressSanitizer::runOnFunction(Function &F) {
       }
       ToInstrument.push_back(&Inst);
       NumInsnsPerBB++;
-      if (NumInsnsPerBB >= ClMaxInsnsToInstrumentPerBB)
+      if (NumInsnsPerBB >= ClMaxInsnsToInstrumentPerBB) {
+        // The rest of the block isn't scanned for calls.
+        CallBlocks.insert(&BB);
         break;
+      }
     }
   }
 
+  const DataLayout &DL = F.getParent()->getDataLayout();
+  if (ClOpt && ClOptDominating)
+    removeDominatedAccesses(ToInstrument, CallBlocks, DL);
+
   bool UseCalls = false;
   if (ClInstrumentationWithCallsThreshold >= 0 &&
       ToInstrument.size() > (unsigned)ClInstrumentationWithCallsThreshold)
     UseCalls = true;
 
+  // Pick the insertion points before instrumenting, which changes the CFG.
+  LoopInfo &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+  DenseMap<Loop *, bool> LoopHasCalls;
+  DenseMap<Instruction *, Instruction *> InsertPoints;
+  if (ClOpt && ClOptLoopInvariant) {
+    for (auto Inst : ToInstrument) {
+      if (!isInterestingMemoryAccess(Inst, &IsWrite, &Alignment))
+        continue;
+      Instruction *InsertBefore =
+          getCheckInsertPoint(Inst, LI, CallBlocks, LoopHasCalls);
+      if (InsertBefore != Inst) {
+        InsertPoints[Inst] = InsertBefore;
+        NumHoistedLoopInvariantChecks++;
+      }
+    }
+  }
+
   // Instrument.
   int NumInstrumented = 0;
   for (auto Inst : ToInstrument) {
     if (ClDebugMin < 0 || ClDebugMax < 0 ||
         (NumInstrumented >= ClDebugMin && NumInstrumented <= ClDebugMax)) {
-      if (isInterestingMemoryAccess(Inst, &IsWrite, &Alignment))
-        instrumentMop(Inst, UseCalls, F.getParent()->getDataLayout());
-      else
+      if (isInterestingMemoryAccess(Inst, &IsWrite, &Alignment)) {
+        Instruction *InsertBefore = InsertPoints.lookup(Inst);
+        instrumentMop(Inst, InsertBefore ? InsertBefore : Inst, UseCalls, DL);
+      } else
         instrumentMemIntrinsic(cast<MemIntrinsic>(Inst));
     }
     NumInstrumented++;
@@ -15,15 +15,19 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Transforms/Instrumentation.h"
+#include "MaximumSpanningTree.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/UniqueVector.h"
+#include "llvm/Analysis/LoopInfo.h"
 #include "llvm/IR/DebugInfo.h"
 #include "llvm/IR/DebugLoc.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
@@ -49,6 +53,20 @@ DefaultGCOVVersion("default-gcov-version", cl::init("402*"), cl::Hidden,
                    cl::ValueRequired);
 static cl::opt<bool> DefaultExitBlockBeforeBody("gcov-exit-block-before-body",
                                                 cl::init(false), cl::Hidden);
+static cl::opt<bool> SpanningTree(
+    "gcov-spanning-tree", cl::init(true), cl::Hidden,
+    cl::desc("Only give counters to the edges off a spanning tree of the CFG, "
+             "as gcc does, and leave the other counts to gcov"));
+
+// The flags of an edge in a .gcno file.
+enum {
+  // The edge has no counter: gcov works its count out from the others.
+  EdgeOnTree = 1,
+  // The edge leads to the exit block from a block that leaves the function
+  // without returning, such as one ending in unreachable after a call to
+  // exit().
+  EdgeFake = 2
+};
 
 GCOVOptions GCOVOptions::getDefault() {
   GCOVOptions Options;
@@ -103,6 +121,12 @@ namespace {
     // profiling runtime to emit .gcda files when run.
     bool emitProfileArcs();
 
+    // The edges of F that get no counter, as pairs of a block and the number
+    // of a successor, or zero for the edge from a block without successors
+    // to the exit block.
+    typedef DenseSet<std::pair<const BasicBlock *, unsigned>> EdgeSet;
+    const EdgeSet &getSpanningTree(Function &F);
+
     // Get pointers to the functions in the runtime library.
     Constant *getStartFileFunc();
     Constant *getIncrementIndirectCounterFunc();
@@ -121,6 +145,7 @@ namespace {
     // block number.
     GlobalVariable *buildEdgeLookupTable(Function *F,
                                          GlobalVariable *Counter,
+                                         const EdgeSet &Tree,
                                          const UniqueVector<BasicBlock *>&Preds,
                                          const UniqueVector<BasicBlock*>&Succs);
 
@@ -143,6 +168,7 @@ namespace {
     Module *M;
     LLVMContext *Ctx;
     SmallVector<std::unique_ptr<GCOVFunction>, 16> Funcs;
+    DenseMap<Function *, EdgeSet> SpanningTrees;
   };
 }
 
@@ -160,6 +186,12 @@ static StringRef getFunctionName(const DISubprogram *SP) {
   return SP->getName();
 }
 
+// The number of edges gcov sees leaving a block: one per successor, or one to
+// the exit block if the block leaves the function.
+static unsigned getNumEdges(const TerminatorInst *TI) {
+  return std::max(1u, TI->getNumSuccessors());
+}
+
 namespace {
   class GCOVRecord {
    protected:
@@ -254,8 +286,9 @@ namespace {
       return *Lines;
     }
 
-    void addEdge(GCOVBlock &Successor) {
+    void addEdge(GCOVBlock &Successor, uint32_t Flags) {
       OutEdges.push_back(&Successor);
+      OutEdgeFlags.push_back(Flags);
     }
 
     void writeOut() {
@@ -307,6 +340,7 @@ namespace {
     uint32_t Number;
     StringMap<GCOVLines *> LinesByFile;
     SmallVector<GCOVBlock *, 4> OutEdges;
+    SmallVector<uint32_t, 4> OutEdgeFlags;
   };
 
   // A function has a unique identifier, a checksum (we leave as zero) and a
@@ -354,8 +388,12 @@ namespace {
       Function *F = Blocks.begin()->first->getParent();
       for (Function::iterator I = F->begin(), E = F->end(); I != E; ++I) {
         GCOVBlock &Block = getBlock(I);
-        for (int i = 0, e = Block.OutEdges.size(); i != e; ++i)
+        for (int i = 0, e = Block.OutEdges.size(); i != e; ++i) {
           EDOS << Block.OutEdges[i]->Number;
+          // Tell .gcda files for different spanning trees apart.
+          if (Block.OutEdgeFlags[i] & EdgeOnTree)
+            EDOS << 't';
+        }
       }
       return EdgeDestinations;
     }
@@ -405,7 +443,7 @@ namespace {
           DEBUG(dbgs() << Block.Number << " -> " << Block.OutEdges[i]->Number
                        << "\n");
           write(Block.OutEdges[i]->Number);
-          write(0);  // no flags
+          write(Block.OutEdgeFlags[i]);
         }
       }
 
@@ -455,12 +493,75 @@ std::string GCOVProfiler::mangleName(const DICompileUnit *CU,
 bool GCOVProfiler::runOnModule(Module &M) {
   this->M = &M;
   Ctx = &M.getContext();
+  SpanningTrees.clear();
 
   if (Options.EmitNotes) emitProfileNotes();
   if (Options.EmitData) return emitProfileArcs();
   return false;
 }
 
+const GCOVProfiler::EdgeSet &GCOVProfiler::getSpanningTree(Function &F) {
+  auto Inserted = SpanningTrees.insert(std::make_pair(&F, EdgeSet()));
+  EdgeSet &Tree = Inserted.first->second;
+  if (!Inserted.second || !SpanningTree)
+    return Tree;
+
+  // The count of every block but the entry and exit blocks is both the sum of
+  // the counts of the edges into it and the sum of those out of it, so the
+  // counts of the edges on a spanning tree of the CFG follow from those of
+  // the other edges, and only the latter need counters. Without a profile,
+  // guess that an edge runs more often the deeper it is in loops, and put the
+  // edges that run most often on the tree. The edges out of switches and the
+  // like come out ahead, as each of their counters takes a call.
+  DominatorTree DT;
+  DT.recalculate(F);
+  LoopInfo LI;
+  LI.Analyze(DT);
+
+  typedef MaximumSpanningTree<BasicBlock> MST;
+  MST::EdgeWeights Weights;
+  // The exit block has no BasicBlock, so it is null here. The edge from it
+  // back to the entry block, which is not a real edge and can't be counted,
+  // comes first so that it is always on the tree, and so do the edges from
+  // blocks that leave the function without returning, as gcc arranges.
+  const double Uncountable = 1e30;
+  Weights.push_back(
+      std::make_pair(MST::Edge(nullptr, &F.getEntryBlock()), Uncountable));
+  for (BasicBlock &BB : F) {
+    TerminatorInst *TI = BB.getTerminator();
+    unsigned Successors = TI->getNumSuccessors();
+    if (!Successors) {
+      double Weight = isa<ReturnInst>(TI) ? LI.getLoopDepth(&BB) : Uncountable;
+      Weights.push_back(std::make_pair(MST::Edge(&BB, nullptr), Weight));
+      continue;
+    }
+    bool Complex = Successors > 1 && !isa<BranchInst>(TI);
+    for (unsigned i = 0; i != Successors; ++i) {
+      BasicBlock *Succ = TI->getSuccessor(i);
+      double Weight = std::min(LI.getLoopDepth(&BB), LI.getLoopDepth(Succ));
+      if (Complex)
+        Weight += 0.5;
+      Weights.push_back(std::make_pair(MST::Edge(&BB, Succ), Weight));
+    }
+  }
+
+  // The tree names edges by the blocks they join. Of several edges between
+  // the same two blocks, at most one is on the tree; take the first.
+  DenseSet<MST::Edge> TreeEdges;
+  MST MaxTree(Weights);
+  for (const MST::Edge &E : MaxTree)
+    TreeEdges.insert(E);
+  for (BasicBlock &BB : F) {
+    TerminatorInst *TI = BB.getTerminator();
+    for (unsigned i = 0, e = getNumEdges(TI); i != e; ++i) {
+      BasicBlock *Succ = TI->getNumSuccessors() ? TI->getSuccessor(i) : nullptr;
+      if (TreeEdges.erase(MST::Edge(&BB, Succ)))
+        Tree.insert(std::make_pair(&BB, i));
+    }
+  }
+  return Tree;
+}
+
 static bool functionHasLines(Function *F) {
   // Check whether this function actually has any source lines. Not only
   // do these waste space, they also can crash gcov.
@@ -516,16 +617,25 @@ void GCOVProfiler::emitProfileNotes() {
                                                 Options.UseCfgChecksum,
                                                 Options.ExitBlockBeforeBody));
       GCOVFunction &Func = *Funcs.back();
+      const EdgeSet &Tree = getSpanningTree(*F);
 
       for (Function::iterator BB = F->begin(), E = F->end(); BB != E; ++BB) {
         GCOVBlock &Block = Func.getBlock(BB);
         TerminatorInst *TI = BB->getTerminator();
         if (int successors = TI->getNumSuccessors()) {
           for (int i = 0; i != successors; ++i) {
-            Block.addEdge(Func.getBlock(TI->getSuccessor(i)));
+            bool OnTree = Tree.count(std::make_pair(&*BB, i));
+            Block.addEdge(Func.getBlock(TI->getSuccessor(i)),
+                          OnTree ? EdgeOnTree : 0);
           }
-        } else if (isa<ReturnInst>(TI)) {
-          Block.addEdge(Func.getReturnBlock());
+        } else {
+          // Like gcc, give the blocks that leave the function other than by
+          // returning a fake edge to the exit block, so that the counts of
+          // the edges into them can be worked out as well.
+          uint32_t Flags = isa<ReturnInst>(TI) ? 0 : EdgeFake;
+          if (Tree.count(std::make_pair(&*BB, 0u)))
+            Flags |= EdgeOnTree;
+          Block.addEdge(Func.getReturnBlock(), Flags);
         }
 
         uint32_t Line = 0;
@@ -583,13 +693,12 @@ bool GCOVProfiler::emitProfileArcs() {
       if (!F) continue;
       if (!functionHasLines(F)) continue;
       if (!Result) Result = true;
+      const EdgeSet &Tree = getSpanningTree(*F);
       unsigned Edges = 0;
       for (Function::iterator BB = F->begin(), E = F->end(); BB != E; ++BB) {
-        TerminatorInst *TI = BB->getTerminator();
-        if (isa<ReturnInst>(TI))
-          ++Edges;
-        else
-          Edges += TI->getNumSuccessors();
+        for (unsigned i = 0, e = getNumEdges(BB->getTerminator()); i != e; ++i)
+          if (!Tree.count(std::make_pair(&*BB, i)))
+            ++Edges;
       }
 
       ArrayType *CounterTy =
@@ -607,40 +716,63 @@ bool GCOVProfiler::emitProfileArcs() {
       unsigned Edge = 0;
       for (Function::iterator BB = F->begin(), E = F->end(); BB != E; ++BB) {
         TerminatorInst *TI = BB->getTerminator();
-        int Successors = isa<ReturnInst>(TI) ? 1 : TI->getNumSuccessors();
-        if (Successors) {
-          if (Successors == 1) {
-            IRBuilder<> Builder(BB->getFirstInsertionPt());
-            Value *Counter = Builder.CreateConstInBoundsGEP2_64(Counters, 0,
-                                                                Edge);
-            Value *Count = Builder.CreateLoad(Counter);
-            Count = Builder.CreateAdd(Count, Builder.getInt64(1));
-            Builder.CreateStore(Count, Counter);
-          } else if (BranchInst *BI = dyn_cast<BranchInst>(TI)) {
-            IRBuilder<> Builder(BI);
-            Value *Sel = Builder.CreateSelect(BI->getCondition(),
-                                              Builder.getInt64(Edge),
-                                              Builder.getInt64(Edge + 1));
-            SmallVector<Value *, 2> Idx;
-            Idx.push_back(Builder.getInt64(0));
-            Idx.push_back(Sel);
-            Value *Counter = Builder.CreateInBoundsGEP(Counters, Idx);
-            Value *Count = Builder.CreateLoad(Counter);
-            Count = Builder.CreateAdd(Count, Builder.getInt64(1));
-            Builder.CreateStore(Count, Counter);
-          } else {
-            ComplexEdgePreds.insert(BB);
-            for (int i = 0; i != Successors; ++i)
+        unsigned Successors = getNumEdges(TI);
+        unsigned Counted = 0;
+        for (unsigned i = 0; i != Successors; ++i)
+          if (!Tree.count(std::make_pair(&*BB, i)))
+            ++Counted;
+
+        if (Successors > 1 && !isa<BranchInst>(TI)) {
+          // Even a block none of whose edges has a counter records itself as
+          // the predecessor, lest its successors blame another block.
+          ComplexEdgePreds.insert(BB);
+          for (unsigned i = 0; i != Successors; ++i)
+            if (!Tree.count(std::make_pair(&*BB, i)))
               ComplexEdgeSuccs.insert(TI->getSuccessor(i));
-          }
-
-          Edge += Successors;
+        } else if (!Counted) {
+          continue;
+        } else if (Successors == 1) {
+          IRBuilder<> Builder(BB->getFirstInsertionPt());
+          Value *Counter = Builder.CreateConstInBoundsGEP2_64(Counters, 0,
+                                                              Edge);
+          Value *Count = Builder.CreateLoad(Counter);
+          Count = Builder.CreateAdd(Count, Builder.getInt64(1));
+          Builder.CreateStore(Count, Counter);
+        } else if (Counted == 2) {
+          BranchInst *BI = cast<BranchInst>(TI);
+          IRBuilder<> Builder(BI);
+          Value *Sel = Builder.CreateSelect(BI->getCondition(),
+                                            Builder.getInt64(Edge),
+                                            Builder.getInt64(Edge + 1));
+          SmallVector<Value *, 2> Idx;
+          Idx.push_back(Builder.getInt64(0));
+          Idx.push_back(Sel);
+          Value *Counter = Builder.CreateInBoundsGEP(Counters, Idx);
+          Value *Count = Builder.CreateLoad(Counter);
+          Count = Builder.CreateAdd(Count, Builder.getInt64(1));
+          Builder.CreateStore(Count, Counter);
+        } else {
+          // Only one side of the branch has a counter, so add the condition,
+          // or its inverse, to it.
+          BranchInst *BI = cast<BranchInst>(TI);
+          IRBuilder<> Builder(BI);
+          Value *Taken = BI->getCondition();
+          if (Tree.count(std::make_pair(&*BB, 0u)))
+            Taken = Builder.CreateNot(Taken);
+          Value *Counter = Builder.CreateConstInBoundsGEP2_64(Counters, 0,
+                                                              Edge);
+          Value *Count = Builder.CreateLoad(Counter);
+          Count = Builder.CreateAdd(
+              Count, Builder.CreateZExt(Taken, Builder.getInt64Ty()));
+          Builder.CreateStore(Count, Counter);
         }
+
+        Edge += Counted;
       }
 
-      if (!ComplexEdgePreds.empty()) {
+      if (!ComplexEdgeSuccs.empty()) {
         GlobalVariable *EdgeTable =
-          buildEdgeLookupTable(F, Counters,
+          buildEdgeLookupTable(F, Counters, Tree,
                                ComplexEdgePreds, ComplexEdgeSuccs);
         GlobalVariable *EdgeState = getEdgeStateValue();
 
@@ -709,6 +841,7 @@ bool GCOVProfiler::emitProfileArcs() {
 GlobalVariable *GCOVProfiler::buildEdgeLookupTable(
     Function *F,
     GlobalVariable *Counters,
+    const EdgeSet &Tree,
     const UniqueVector<BasicBlock *> &Preds,
     const UniqueVector<BasicBlock *> &Succs) {
   // TODO: support invoke, threads. We rely on the fact that nothing can modify
@@ -725,21 +858,24 @@ GlobalVariable *GCOVProfiler::buildEdgeLookupTable(
   for (size_t i = 0; i != TableSize; ++i)
     EdgeTable[i] = NullValue;
 
+  // The edges on the spanning tree keep a null entry.
   unsigned Edge = 0;
   for (Function::iterator BB = F->begin(), E = F->end(); BB != E; ++BB) {
     TerminatorInst *TI = BB->getTerminator();
-    int Successors = isa<ReturnInst>(TI) ? 1 : TI->getNumSuccessors();
-    if (Successors > 1 && !isa<BranchInst>(TI) && !isa<ReturnInst>(TI)) {
-      for (int i = 0; i != Successors; ++i) {
+    unsigned Successors = getNumEdges(TI);
+    bool Complex = Successors > 1 && !isa<BranchInst>(TI);
+    for (unsigned i = 0; i != Successors; ++i) {
+      if (Tree.count(std::make_pair(&*BB, i)))
+        continue;
+      if (Complex) {
         BasicBlock *Succ = TI->getSuccessor(i);
         IRBuilder<> Builder(Succ);
-        Value *Counter = Builder.CreateConstInBoundsGEP2_64(Counters, 0,
-                                                            Edge + i);
+        Value *Counter = Builder.CreateConstInBoundsGEP2_64(Counters, 0, Edge);
         EdgeTable[((Succs.idFor(Succ)-1) * Preds.size()) +
                   (Preds.idFor(BB)-1)] = cast<Constant>(Counter);
       }
+      ++Edge;
     }
-    Edge += Successors;
   }
 
   GlobalVariable *EdgeTableGV =
@@ -0,0 +1,322 @@
+//===-- IndirectCallPromotion.cpp - Promote indirect calls to direct calls ===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass promotes the hot targets of indirect calls to direct calls, using
+// the value profile that the frontend attached to the calls. A call whose
+// profile is dominated by one target
+//
+//   %r = call i32 %fp(i32 %x)
+//
+// becomes a comparison against that target, a direct call that can be inlined,
+// and the original indirect call as the fallback:
+//
+//   %c = icmp eq i32 (i32)* %fp, @target
+//   br i1 %c, label %if.true.direct_targ, label %if.false.orig_indirect
+//
+// The value profile is an !prof node tagged "VP", followed by the value kind,
+// the total count of the call and pairs of the profile name hash and the count
+// of its hottest targets.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/Instrumentation.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InlineAsm.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/ProfileData/InstrProf.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+using namespace llvm;
+
+#define DEBUG_TYPE "pgo-icall-prom"
+
+STATISTIC(NumPromoted, "Number of indirect call targets promoted");
+STATISTIC(NumPromotedCallSites, "Number of indirect call sites promoted");
+
+static cl::opt<unsigned>
+ICPPercentThreshold("icp-percent-threshold", cl::init(30), cl::Hidden,
+                    cl::desc("Minimum percentage of the remaining calls that "
+                             "must go to a target for it to be promoted"));
+
+static cl::opt<unsigned>
+ICPCountThreshold("icp-count-threshold", cl::init(1000), cl::Hidden,
+                  cl::desc("Minimum number of calls to a target for it to be "
+                           "promoted"));
+
+static cl::opt<unsigned>
+ICPMaxTargets("icp-max-prom", cl::init(2), cl::Hidden,
+              cl::desc("Maximum number of targets promoted at a call site"));
+
+namespace {
+  struct PGOIndirectCallPromotion : public ModulePass {
+    static char ID; // Pass identification, replacement for typeid
+    PGOIndirectCallPromotion() : ModulePass(ID) {
+      initializePGOIndirectCallPromotionPass(*PassRegistry::getPassRegistry());
+    }
+
+    const char *getPassName() const override {
+      return "PGO indirect call promotion";
+    }
+
+    bool runOnModule(Module &M) override;
+
+  private:
+    /// The functions of the module by the hash of their profile name.
+    DenseMap<uint64_t, Function *> FunctionsByHash;
+
+    void buildFunctionMap(Module &M);
+    bool promoteCallSite(Instruction *I);
+  };
+}
+
+char PGOIndirectCallPromotion::ID = 0;
+INITIALIZE_PASS(PGOIndirectCallPromotion, "pgo-icall-prom",
+                "Use PGO instrumentation profile to promote indirect calls to "
+                "direct calls.", false, false)
+
+ModulePass *llvm::createPGOIndirectCallPromotionPass() {
+  return new PGOIndirectCallPromotion();
+}
+
+/// \brief Returns the name under which the frontend profiled \p F. Local
+/// functions are qualified with the name of their file.
+static std::string getPGOFuncName(const Function &F) {
+  StringRef Name = F.getName();
+  if (Name.startswith("\1"))
+    Name = Name.substr(1);
+  if (!F.hasLocalLinkage())
+    return Name;
+  StringRef FileName =
+      sys::path::filename(F.getParent()->getModuleIdentifier());
+  if (FileName.empty())
+    FileName = "<unknown>";
+  return (FileName + ":" + Name).str();
+}
+
+void PGOIndirectCallPromotion::buildFunctionMap(Module &M) {
+  FunctionsByHash.clear();
+  for (Function &F : M)
+    if (!F.isIntrinsic())
+      FunctionsByHash[getInstrProfNameHash(getPGOFuncName(F))] = &F;
+}
+
+/// \brief Reads the value profile of the indirect call \p I into \p Targets,
+/// and returns the total number of calls, or zero if there is none.
+static uint64_t
+getCallTargets(const Instruction *I,
+               SmallVectorImpl<InstrProfValueData> &Targets) {
+  MDNode *MD = I->getMetadata(LLVMContext::MD_prof);
+  if (!MD || MD->getNumOperands() < 3 || MD->getNumOperands() % 2 == 0)
+    return 0;
+  MDString *Tag = dyn_cast<MDString>(MD->getOperand(0));
+  if (!Tag || Tag->getString() != "VP")
+    return 0;
+  ConstantInt *Kind = mdconst::dyn_extract<ConstantInt>(MD->getOperand(1));
+  ConstantInt *Total = mdconst::dyn_extract<ConstantInt>(MD->getOperand(2));
+  if (!Kind || Kind->getZExtValue() != IPVK_IndirectCallTarget || !Total)
+    return 0;
+  for (unsigned i = 3, e = MD->getNumOperands(); i != e; i += 2) {
+    ConstantInt *Value = mdconst::dyn_extract<ConstantInt>(MD->getOperand(i));
+    ConstantInt *Count =
+        mdconst::dyn_extract<ConstantInt>(MD->getOperand(i + 1));
+    if (!Value || !Count)
+      return 0;
+    InstrProfValueData Target = {Value->getZExtValue(), Count->getZExtValue()};
+    Targets.push_back(Target);
+  }
+  return Total->getZExtValue();
+}
+
+/// \brief Attaches the value profile of the targets that are left, or drops
+/// it when none is.
+static void setCallTargets(Instruction *I,
+                           ArrayRef<InstrProfValueData> Targets,
+                           uint64_t Total) {
+  if (Targets.empty()) {
+    I->setMetadata(LLVMContext::MD_prof, nullptr);
+    return;
+  }
+  LLVMContext &Ctx = I->getContext();
+  MDBuilder MDB(Ctx);
+  Type *Int32Ty = Type::getInt32Ty(Ctx);
+  Type *Int64Ty = Type::getInt64Ty(Ctx);
+  SmallVector<Metadata *, 9> Vals;
+  Vals.push_back(MDB.createString("VP"));
+  Vals.push_back(MDB.createConstant(
+      ConstantInt::get(Int32Ty, IPVK_IndirectCallTarget)));
+  Vals.push_back(MDB.createConstant(ConstantInt::get(Int64Ty, Total)));
+  for (const InstrProfValueData &Target : Targets) {
+    Vals.push_back(MDB.createConstant(ConstantInt::get(Int64Ty, Target.Value)));
+    Vals.push_back(MDB.createConstant(ConstantInt::get(Int64Ty, Target.Count)));
+  }
+  I->setMetadata(LLVMContext::MD_prof, MDNode::get(Ctx, Vals));
+}
+
+/// \brief Returns branch weights for \p TrueCount and \p FalseCount, scaled to
+/// 32 bits.
+static MDNode *createBranchWeights(LLVMContext &Ctx, uint64_t TrueCount,
+                                   uint64_t FalseCount) {
+  uint64_t Scale = std::max(TrueCount, FalseCount) / UINT32_MAX + 1;
+  return MDBuilder(Ctx).createBranchWeights(uint32_t(TrueCount / Scale),
+                                            uint32_t(FalseCount / Scale));
+}
+
+/// \brief Guards the indirect call \p I with a check that its callee is
+/// \p Target, and calls \p Target directly when it is. \p I stays the
+/// fallback call for all other targets.
+static void promoteTarget(Instruction *I, Function *Target, uint64_t Count,
+                          uint64_t Remaining) {
+  CallSite CS(I);
+  BasicBlock *BB = I->getParent();
+  LLVMContext &Ctx = I->getContext();
+  IRBuilder<> Builder(I);
+  Value *Callee = CS.getCalledValue();
+  Value *Cond = Builder.CreateICmpEQ(
+      Callee, Builder.CreateBitCast(Target, Callee->getType()));
+  MDNode *Weights = createBranchWeights(Ctx, Count, Remaining - Count);
+
+  Instruction *DirectCall = I->clone();
+  DirectCall->setMetadata(LLVMContext::MD_prof, nullptr);
+  CallSite(DirectCall).setCalledFunction(Target);
+
+  if (isa<CallInst>(I)) {
+    TerminatorInst *ThenTerm, *ElseTerm;
+    SplitBlockAndInsertIfThenElse(Cond, I, &ThenTerm, &ElseTerm, Weights);
+    BasicBlock *Tail = I->getParent();
+    ThenTerm->getParent()->setName("if.true.direct_targ");
+    ElseTerm->getParent()->setName("if.false.orig_indirect");
+    DirectCall->insertBefore(ThenTerm);
+    I->moveBefore(ElseTerm);
+    if (!I->getType()->isVoidTy()) {
+      PHINode *Phi = PHINode::Create(I->getType(), 2, "", &Tail->front());
+      I->replaceAllUsesWith(Phi);
+      Phi->addIncoming(DirectCall, DirectCall->getParent());
+      Phi->addIncoming(I, I->getParent());
+    }
+    return;
+  }
+
+  // An invoke is a terminator, so both invokes get a block of their own, and
+  // their results meet in a block on the way to the normal destination.
+  InvokeInst *Invoke = cast<InvokeInst>(I);
+  BasicBlock *Normal = Invoke->getNormalDest();
+  BasicBlock *Unwind = Invoke->getUnwindDest();
+  Function *F = BB->getParent();
+  BasicBlock *DirectBB =
+      BasicBlock::Create(Ctx, "if.true.direct_targ", F, Normal);
+  BasicBlock *IndirectBB =
+      BasicBlock::Create(Ctx, "if.false.orig_indirect", F, Normal);
+  BasicBlock *MergeBB = BasicBlock::Create(Ctx, "if.end.icp", F, Normal);
+
+  Invoke->removeFromParent();
+  IndirectBB->getInstList().push_back(Invoke);
+  DirectBB->getInstList().push_back(DirectCall);
+  BranchInst::Create(DirectBB, IndirectBB, Cond, BB)
+      ->setMetadata(LLVMContext::MD_prof, Weights);
+  BranchInst::Create(Normal, MergeBB);
+  Invoke->setNormalDest(MergeBB);
+  cast<InvokeInst>(DirectCall)->setNormalDest(MergeBB);
+
+  for (BasicBlock::iterator PI = Normal->begin(); isa<PHINode>(PI); ++PI) {
+    PHINode *Phi = cast<PHINode>(PI);
+    for (unsigned i = 0, e = Phi->getNumIncomingValues(); i != e; ++i)
+      if (Phi->getIncomingBlock(i) == BB)
+        Phi->setIncomingBlock(i, MergeBB);
+  }
+  for (BasicBlock::iterator PI = Unwind->begin(); isa<PHINode>(PI); ++PI) {
+    PHINode *Phi = cast<PHINode>(PI);
+    int Idx = Phi->getBasicBlockIndex(BB);
+    Value *V = Phi->getIncomingValue(Idx);
+    Phi->setIncomingBlock(Idx, IndirectBB);
+    Phi->addIncoming(V, DirectBB);
+  }
+
+  if (!Invoke->getType()->isVoidTy()) {
+    PHINode *Phi = PHINode::Create(Invoke->getType(), 2, "", &MergeBB->front());
+    Invoke->replaceAllUsesWith(Phi);
+    Phi->addIncoming(DirectCall, DirectBB);
+    Phi->addIncoming(Invoke, IndirectBB);
+  }
+}
+
+bool PGOIndirectCallPromotion::promoteCallSite(Instruction *I) {
+  SmallVector<InstrProfValueData, 4> Targets;
+  uint64_t Total = getCallTargets(I, Targets);
+  if (!Total)
+    return false;
+
+  // The targets are sorted by count. Promote them while each one takes a
+  // large enough share of the calls that are left.
+  CallSite CS(I);
+  FunctionType *CalleeTy = cast<FunctionType>(
+      CS.getCalledValue()->getType()->getPointerElementType());
+  uint64_t Remaining = Total;
+  unsigned NumPromotedTargets = 0;
+  while (NumPromotedTargets < Targets.size() &&
+         NumPromotedTargets < ICPMaxTargets) {
+    const InstrProfValueData &Target = Targets[NumPromotedTargets];
+    if (Target.Count < ICPCountThreshold || Target.Count > Remaining ||
+        Target.Count * 100 < Remaining * ICPPercentThreshold)
+      break;
+    Function *F = FunctionsByHash.lookup(Target.Value);
+    // A target from another module of the profile, or one that doesn't match
+    // the call, stops the promotion; the targets after it are colder.
+    if (!F || F->getFunctionType() != CalleeTy)
+      break;
+
+    DEBUG(dbgs() << "ICP: promoting " << F->getName() << " (" << Target.Count
+                 << " of " << Remaining << " calls) in "
+                 << I->getParent()->getParent()->getName() << "\n");
+    promoteTarget(I, F, Target.Count, Remaining);
+    Remaining -= Target.Count;
+    ++NumPromotedTargets;
+    ++NumPromoted;
+  }
+  if (!NumPromotedTargets)
+    return false;
+
+  setCallTargets(I, makeArrayRef(Targets).slice(NumPromotedTargets),
+                 Remaining);
+  ++NumPromotedCallSites;
+  return true;
+}
+
+bool PGOIndirectCallPromotion::runOnModule(Module &M) {
+  // Collect the calls first, since promotion splits their blocks.
+  SmallVector<Instruction *, 16> Calls;
+  for (Function &F : M)
+    for (BasicBlock &BB : F)
+      for (Instruction &I : BB) {
+        CallSite CS(&I);
+        if (CS && !CS.getCalledFunction() &&
+            !isa<InlineAsm>(CS.getCalledValue()) &&
+            I.getMetadata(LLVMContext::MD_prof))
+          Calls.push_back(&I);
+      }
+  if (Calls.empty())
+    return false;
+
+  buildFunctionMap(M);
+  bool Changed = false;
+  for (Instruction *I : Calls)
+    Changed |= promoteCallSite(I);
+  return Changed;
+}
@@ -7,24 +7,39 @@
 //
 //===----------------------------------------------------------------------===//
 //
-// This pass lowers instrprof_increment intrinsics emitted by a frontend for
-// profiling. It also builds the data structures and initialization code needed
-// for updating execution counts and emitting the profile at runtime.
+// This pass lowers instrprof_increment and instrprof_value_profile intrinsics
+// emitted by a frontend for profiling. It also builds the data structures and
+// initialization code needed for updating execution counts and emitting the
+// profile at runtime.
 //
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Transforms/Instrumentation.h"
 
 #include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Transforms/Utils/ModuleUtils.h"
+#include <algorithm>
 
 using namespace llvm;
 
 #define DEBUG_TYPE "instrprof"
 
+// Counting loop iterations in a local instead of the counters avoids a load
+// and a store to shared memory per iteration, which is the main cost of the
+// counters of multi-threaded programs. Counts of loops left by a call that
+// doesn't return, like exit or longjmp, are lost.
+static cl::opt<bool> ClPromoteLoopCounters(
+    "instrprof-promote-loop-counters",
+    cl::desc("Count loop iterations in locals, added to the counters when the "
+             "loop exits"),
+    cl::Hidden, cl::init(false));
+
 namespace {
 
 class InstrProfiling : public ModulePass {
@@ -50,6 +65,9 @@ private:
   InstrProfOptions Options;
   Module *M;
   DenseMap<GlobalVariable *, GlobalVariable *> RegionCounters;
+  /// The profile data variable and the number of value sites of each name.
+  DenseMap<GlobalVariable *, GlobalVariable *> ProfileData;
+  DenseMap<GlobalVariable *, uint32_t> NumValueSites;
   std::vector<Value *> UsedVars;
 
   bool isMachO() const {
@@ -76,9 +94,20 @@ private:
     return isMachO() ? "__DATA,__llvm_covmap" : "__llvm_covmap";
   }
 
+  /// Count the value sites of the name of \p Ind.
+  void computeNumValueSites(InstrProfValueProfileInst *Ind);
+
   /// Replace instrprof_increment with an increment of the appropriate value.
   void lowerIncrement(InstrProfIncrementInst *Inc);
 
+  /// Replace the instrprof_increments in the loops of \p F with increments of
+  /// locals, which are added to the counters on the exits of the loops.
+  bool promoteLoopCounters(Function &F);
+
+  /// Replace instrprof_value_profile with a call to the runtime, which records
+  /// the value in the value sites of the profile data variable.
+  void lowerValueProfileInst(InstrProfValueProfileInst *Ind);
+
   /// Set up the section and uses for coverage data and its references.
   void lowerCoverageData(GlobalVariable *CoverageData);
 
@@ -117,15 +146,35 @@ bool InstrProfiling::runOnModule(Module &M) {
 
   this->M = &M;
   RegionCounters.clear();
+  ProfileData.clear();
+  NumValueSites.clear();
   UsedVars.clear();
 
+  // The value sites are allocated with the profile data variable, so they are
+  // counted before any of the increments creates it.
   for (Function &F : M)
+    for (BasicBlock &BB : F)
+      for (Instruction &I : BB)
+        if (auto *Ind = dyn_cast<InstrProfValueProfileInst>(&I))
+          computeNumValueSites(Ind);
+
+  for (Function &F : M) {
+    if (ClPromoteLoopCounters)
+      MadeChange |= promoteLoopCounters(F);
     for (BasicBlock &BB : F)
       for (auto I = BB.begin(), E = BB.end(); I != E;)
         if (auto *Inc = dyn_cast<InstrProfIncrementInst>(I++)) {
           lowerIncrement(Inc);
           MadeChange = true;
         }
+  }
+  for (Function &F : M)
+    for (BasicBlock &BB : F)
+      for (auto I = BB.begin(), E = BB.end(); I != E;)
+        if (auto *Ind = dyn_cast<InstrProfValueProfileInst>(I++)) {
+          lowerValueProfileInst(Ind);
+          MadeChange = true;
+        }
   if (GlobalVariable *Coverage = M.getNamedGlobal("__llvm_coverage_mapping")) {
     lowerCoverageData(Coverage);
     MadeChange = true;
@@ -140,6 +189,39 @@ bool InstrProfiling::runOnModule(Module &M) {
   return true;
 }
 
+void InstrProfiling::computeNumValueSites(InstrProfValueProfileInst *Ind) {
+  uint32_t &NumSites = NumValueSites[Ind->getName()];
+  NumSites = std::max<uint32_t>(NumSites, Ind->getIndex()->getZExtValue() + 1);
+}
+
+void InstrProfiling::lowerValueProfileInst(InstrProfValueProfileInst *Ind) {
+  // Without counters there is no profile data to attach the values to.
+  GlobalVariable *Data = ProfileData.lookup(Ind->getName());
+  if (!Data) {
+    Ind->eraseFromParent();
+    return;
+  }
+  assert(Ind->getValueKind()->getZExtValue() == 0 &&
+         "only indirect call targets are profiled");
+
+  LLVMContext &Ctx = M->getContext();
+  auto *VoidTy = Type::getVoidTy(Ctx);
+  auto *Int8PtrTy = Type::getInt8PtrTy(Ctx);
+  auto *Int32Ty = Type::getInt32Ty(Ctx);
+  auto *Int64Ty = Type::getInt64Ty(Ctx);
+  Type *ParamTypes[] = {Int64Ty, Int8PtrTy, Int32Ty};
+  Constant *RuntimeF = M->getOrInsertFunction(
+      "__llvm_profile_instrument_target",
+      FunctionType::get(VoidTy, ParamTypes, false));
+
+  IRBuilder<> Builder(Ind->getParent(), *Ind);
+  Value *Args[] = {Ind->getTargetValue(),
+                   Builder.CreateBitCast(Data, Int8PtrTy),
+                   Builder.getInt32(Ind->getIndex()->getZExtValue())};
+  Ind->replaceAllUsesWith(Builder.CreateCall(RuntimeF, Args));
+  Ind->eraseFromParent();
+}
+
 void InstrProfiling::lowerIncrement(InstrProfIncrementInst *Inc) {
   GlobalVariable *Counters = getOrCreateRegionCounters(Inc);
 
@@ -152,6 +234,72 @@ void InstrProfiling::lowerIncrement(InstrProfIncrementInst *Inc) {
   Inc->eraseFromParent();
 }
 
+/// Get the innermost loop containing \p BB whose counts can be kept in locals:
+/// it needs a preheader to clear them, and exit blocks reached only from the
+/// loop to add them to the counters.
+static Loop *getPromotionLoop(const LoopInfo &LI, BasicBlock *BB) {
+  for (Loop *L = LI.getLoopFor(BB); L; L = L->getParentLoop()) {
+    SmallVector<BasicBlock *, 4> ExitBlocks;
+    L->getExitBlocks(ExitBlocks);
+    if (L->getLoopPreheader() && !ExitBlocks.empty() && L->hasDedicatedExits())
+      return L;
+  }
+  return nullptr;
+}
+
+bool InstrProfiling::promoteLoopCounters(Function &F) {
+  SmallVector<InstrProfIncrementInst *, 16> Incs;
+  for (BasicBlock &BB : F)
+    for (Instruction &I : BB)
+      if (auto *Inc = dyn_cast<InstrProfIncrementInst>(&I))
+        Incs.push_back(Inc);
+  if (Incs.empty())
+    return false;
+
+  DominatorTree DT;
+  DT.recalculate(F);
+  LoopInfo LI;
+  LI.Analyze(DT);
+  if (LI.empty())
+    return false;
+
+  bool MadeChange = false;
+  Type *Int64Ty = Type::getInt64Ty(M->getContext());
+  BasicBlock &Entry = F.getEntryBlock();
+  for (InstrProfIncrementInst *Inc : Incs) {
+    Loop *L = getPromotionLoop(LI, Inc->getParent());
+    if (!L)
+      continue;
+
+    GlobalVariable *Counters = getOrCreateRegionCounters(Inc);
+    uint64_t Index = Inc->getIndex()->getZExtValue();
+    IRBuilder<> EntryBuilder(&Entry, Entry.begin());
+    AllocaInst *Local =
+        EntryBuilder.CreateAlloca(Int64Ty, nullptr, "pgocount.promoted");
+
+    IRBuilder<> PreheaderBuilder(L->getLoopPreheader()->getTerminator());
+    PreheaderBuilder.CreateStore(PreheaderBuilder.getInt64(0), Local);
+
+    IRBuilder<> Builder(Inc->getParent(), *Inc);
+    Value *Count = Builder.CreateLoad(Local);
+    Count = Builder.CreateAdd(Count, Builder.getInt64(1));
+    Inc->replaceAllUsesWith(Builder.CreateStore(Count, Local));
+    Inc->eraseFromParent();
+
+    SmallVector<BasicBlock *, 4> ExitBlocks;
+    L->getUniqueExitBlocks(ExitBlocks);
+    for (BasicBlock *Exit : ExitBlocks) {
+      IRBuilder<> ExitBuilder(Exit, Exit->getFirstInsertionPt());
+      Value *Addr = ExitBuilder.CreateConstInBoundsGEP2_64(Counters, 0, Index);
+      Value *Count = ExitBuilder.CreateLoad(Addr, "pgocount");
+      Count = ExitBuilder.CreateAdd(Count, ExitBuilder.CreateLoad(Local));
+      ExitBuilder.CreateStore(Count, Addr);
+    }
+    MadeChange = true;
+  }
+  return MadeChange;
+}
+
 void InstrProfiling::lowerCoverageData(GlobalVariable *CoverageData) {
   CoverageData->setSection(getCoverageSection());
   CoverageData->setAlignment(8);
@@ -220,20 +368,37 @@ InstrProfiling::getOrCreateRegionCounters(InstrProfIncrementInst *Inc) {
   auto *Int8PtrTy = Type::getInt8PtrTy(Ctx);
   auto *Int64PtrTy = Type::getInt64PtrTy(Ctx);
 
-  Type *DataTypes[] = {Int32Ty, Int32Ty, Int64Ty, Int8PtrTy, Int64PtrTy};
+  // The function pointer identifies the function as the target of the
+  // indirect calls recorded by the value sites. Only functions whose address
+  // is taken can be such a target.
+  Function *Fn = Inc->getParent()->getParent();
+  Constant *FunctionAddr = Fn->hasAddressTaken()
+                               ? ConstantExpr::getBitCast(Fn, Int8PtrTy)
+                               : ConstantPointerNull::get(Int8PtrTy);
+
+  // The runtime allocates the value sites on the first value it records, and
+  // stores them in the data variable. All data variables share a section, so
+  // none of them is constant.
+  uint32_t NumSites = NumValueSites.lookup(Name);
+  Type *DataTypes[] = {Int32Ty, Int32Ty, Int64Ty, Int8PtrTy, Int64PtrTy,
+                       Int8PtrTy, Int8PtrTy, Int64Ty};
   auto *DataTy = StructType::get(Ctx, makeArrayRef(DataTypes));
   Constant *DataVals[] = {
       ConstantInt::get(Int32Ty, NameArrayTy->getArrayNumElements()),
       ConstantInt::get(Int32Ty, NumCounters),
       ConstantInt::get(Int64Ty, Inc->getHash()->getZExtValue()),
       ConstantExpr::getBitCast(Name, Int8PtrTy),
-      ConstantExpr::getBitCast(Counters, Int64PtrTy)};
-  auto *Data = new GlobalVariable(*M, DataTy, true, Name->getLinkage(),
+      ConstantExpr::getBitCast(Counters, Int64PtrTy),
+      FunctionAddr,
+      ConstantPointerNull::get(Int8PtrTy),
+      ConstantInt::get(Int64Ty, NumSites)};
+  auto *Data = new GlobalVariable(*M, DataTy, false, Name->getLinkage(),
                                   ConstantStruct::get(DataTy, DataVals),
                                   getVarName(Inc, "data"));
   Data->setVisibility(Name->getVisibility());
   Data->setSection(getDataSection());
   Data->setAlignment(8);
+  ProfileData[Name] = Data;
 
   // Mark the data variable as used so that it isn't stripped out.
   UsedVars.push_back(Data);
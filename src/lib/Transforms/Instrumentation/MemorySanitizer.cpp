@@ -643,8 +643,20 @@ struct MemorySanitizerVisitor : public InstVisitor<MemorySanitizerVisitor> {
     unsigned OriginAlignment = std::max(kMinOriginAlignment, Alignment);
     unsigned StoreSize = DL.getTypeStoreSize(Shadow->getType());
     if (isa<StructType>(Shadow->getType())) {
-      paintOrigin(IRB, updateOrigin(Origin, IRB),
-                  getOriginPtr(Addr, IRB, Alignment), StoreSize,
+      // Like scalars, only paint (and chain) the origin of poisoned structs.
+      Value *Poisoned = collapseAggregateShadow(Shadow, IRB);
+      if (Constant *ConstantPoisoned = dyn_cast<Constant>(Poisoned)) {
+        if (!ConstantPoisoned->isZeroValue())
+          paintOrigin(IRB, updateOrigin(Origin, IRB),
+                      getOriginPtr(Addr, IRB, Alignment), StoreSize,
+                      OriginAlignment);
+        return;
+      }
+      Instruction *CheckTerm = SplitBlockAndInsertIfThen(
+          Poisoned, IRB.GetInsertPoint(), false, MS.OriginStoreWeights);
+      IRBuilder<> IRBNew(CheckTerm);
+      paintOrigin(IRBNew, updateOrigin(Origin, IRBNew),
+                  getOriginPtr(Addr, IRBNew, Alignment), StoreSize,
                   OriginAlignment);
     } else {
       Value *ConvertedShadow = convertToShadowTyNoVec(Shadow, IRB);
@@ -862,6 +874,28 @@ struct MemorySanitizerVisitor : public InstVisitor<MemorySanitizerVisitor> {
     return IRB.CreateBitCast(V, NoVecTy);
   }
 
+  /// \brief Compute an i1 that is true if any bit of a shadow is poisoned.
+  ///
+  /// Struct and array shadows are collapsed element by element.
+  Value *collapseAggregateShadow(Value *Shadow, IRBuilder<> &IRB) {
+    Type *Ty = Shadow->getType();
+    if (!Ty->isAggregateType()) {
+      Value *ConvertedShadow = convertToShadowTyNoVec(Shadow, IRB);
+      return IRB.CreateICmpNE(ConvertedShadow,
+                              getCleanShadow(ConvertedShadow));
+    }
+    unsigned NumElements = isa<StructType>(Ty) ? Ty->getStructNumElements()
+                                               : Ty->getArrayNumElements();
+    Value *Poisoned = nullptr;
+    for (unsigned i = 0; i < NumElements; i++) {
+      Value *ElementPoisoned =
+          collapseAggregateShadow(IRB.CreateExtractValue(Shadow, i), IRB);
+      Poisoned =
+          Poisoned ? IRB.CreateOr(Poisoned, ElementPoisoned) : ElementPoisoned;
+    }
+    return Poisoned ? Poisoned : IRB.getFalse();
+  }
+
   /// \brief Compute the integer shadow offset that corresponds to a given
   /// application address.
   ///
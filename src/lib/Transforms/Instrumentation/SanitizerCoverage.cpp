@@ -28,6 +28,15 @@
 // it only tells if a given function (block) was ever executed. No counters.
 // But for many use cases this is what we need and the added slowdown small.
 //
+// For fuzzers, which need more than that at the lowest cost, there are two
+// more modes:
+// -sanitizer-coverage-8bit-counters also increments an 8-bit counter of the
+// block inline, without atomics or calls. The run-time reports, as a bitset,
+// how many times each block ran since the last query.
+// -sanitizer-coverage-trace-pc-guard replaces the inline guard check with an
+// unconditional call to __sanitizer_cov_trace_pc_guard(&Guard), which
+// fuzzers may define to collect coverage their own way.
+//
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Transforms/Instrumentation.h"
@@ -59,6 +68,9 @@ static const char *const kSanCovWithCheckName = "__sanitizer_cov_with_check";
 static const char *const kSanCovIndirCallName = "__sanitizer_cov_indir_call16";
 static const char *const kSanCovTraceEnter = "__sanitizer_cov_trace_func_enter";
 static const char *const kSanCovTraceBB = "__sanitizer_cov_trace_basic_block";
+static const char *const kSanCovTracePCGuard = "__sanitizer_cov_trace_pc_guard";
+static const char *const kSanCov8bitCountersInitName =
+    "__sanitizer_cov_8bit_counters_init";
 static const char *const kSanCovModuleCtorName = "sancov.module_ctor";
 static const uint64_t    kSanCtorAndDtorPriority = 2;
 
@@ -80,6 +92,18 @@ static cl::opt<bool>
                                    "callbacks at every basic block"),
                           cl::Hidden, cl::init(false));
 
+static cl::opt<bool>
+    ClUse8bitCounters("sanitizer-coverage-8bit-counters",
+                      cl::desc("Increment an 8-bit counter of every "
+                               "instrumented block inline"),
+                      cl::Hidden, cl::init(false));
+
+static cl::opt<bool>
+    ClTracePCGuard("sanitizer-coverage-trace-pc-guard",
+                   cl::desc("Call __sanitizer_cov_trace_pc_guard with the "
+                            "guard of every instrumented block"),
+                   cl::Hidden, cl::init(false));
+
 namespace {
 
 class SanitizerCoverageModule : public ModulePass {
@@ -105,11 +129,15 @@ class SanitizerCoverageModule : public ModulePass {
   Function *SanCovIndirCallFunction;
   Function *SanCovModuleInit;
   Function *SanCovTraceEnter, *SanCovTraceBB;
+  Function *SanCovTracePCGuard;
   InlineAsm *EmptyAsm;
   Type *IntptrTy;
   LLVMContext *C;
 
   GlobalVariable *GuardArray;
+  GlobalVariable *EightBitCounterArray;
+  // Number of guards (and 8-bit counters) handed out so far.
+  unsigned NumGuards;
 
   int CoverageLevel;
 };
@@ -162,21 +190,30 @@ bool SanitizerCoverageModule::runOnModule(Module &M) {
     SanCovTraceBB = checkInterfaceFunction(
         M.getOrInsertFunction(kSanCovTraceBB, VoidTy, Int32PtrTy, nullptr));
   }
+  if (ClTracePCGuard)
+    SanCovTracePCGuard = checkInterfaceFunction(M.getOrInsertFunction(
+        kSanCovTracePCGuard, VoidTy, Int32PtrTy, nullptr));
 
   // At this point we create a dummy array of guards because we don't
   // know how many elements we will need.
   Type *Int32Ty = IRB.getInt32Ty();
+  Type *Int8Ty = IRB.getInt8Ty();
   GuardArray =
       new GlobalVariable(M, Int32Ty, false, GlobalValue::ExternalLinkage,
                          nullptr, "__sancov_gen_cov_tmp");
+  EightBitCounterArray = nullptr;
+  if (ClUse8bitCounters)
+    EightBitCounterArray =
+        new GlobalVariable(M, Int8Ty, false, GlobalValue::ExternalLinkage,
+                           nullptr, "__sancov_gen_cov_counter_tmp");
+  NumGuards = 0;
 
   for (auto &F : M)
     runOnFunction(F);
 
   // Now we know how many elements we need. Create an array of guards
   // with one extra element at the beginning for the size.
-  Type *Int32ArrayNTy =
-      ArrayType::get(Int32Ty, SanCovFunction->getNumUses() + 1);
+  Type *Int32ArrayNTy = ArrayType::get(Int32Ty, NumGuards + 1);
   GlobalVariable *RealGuardArray = new GlobalVariable(
       M, Int32ArrayNTy, false, GlobalValue::PrivateLinkage,
       Constant::getNullValue(Int32ArrayNTy), "__sancov_gen_cov");
@@ -190,7 +227,26 @@ bool SanitizerCoverageModule::runOnModule(Module &M) {
   IRB.SetInsertPoint(CtorFunc->getEntryBlock().getTerminator());
   IRB.CreateCall2(SanCovModuleInit,
                   IRB.CreatePointerCast(RealGuardArray, Int32PtrTy),
-                  ConstantInt::get(IntptrTy, SanCovFunction->getNumUses()));
+                  ConstantInt::get(IntptrTy, NumGuards));
+
+  if (EightBitCounterArray) {
+    // The counters have no size element: counter i belongs to guard i + 1.
+    Type *Int8ArrayNTy = ArrayType::get(Int8Ty, NumGuards);
+    GlobalVariable *RealEightBitCounterArray = new GlobalVariable(
+        M, Int8ArrayNTy, false, GlobalValue::PrivateLinkage,
+        Constant::getNullValue(Int8ArrayNTy), "__sancov_gen_cov_counter");
+    Type *Int8PtrTy = IRB.getInt8PtrTy();
+    EightBitCounterArray->replaceAllUsesWith(
+        IRB.CreatePointerCast(RealEightBitCounterArray, Int8PtrTy));
+    EightBitCounterArray->eraseFromParent();
+
+    Function *SanCov8bitCountersInit = checkInterfaceFunction(
+        M.getOrInsertFunction(kSanCov8bitCountersInitName, VoidTy, Int8PtrTy,
+                              IntptrTy, nullptr));
+    IRB.CreateCall2(SanCov8bitCountersInit,
+                    IRB.CreatePointerCast(RealEightBitCounterArray, Int8PtrTy),
+                    ConstantInt::get(IntptrTy, NumGuards));
+  }
   return true;
 }
 
@@ -278,13 +334,32 @@ void SanitizerCoverageModule::InjectCoverageAtBlock(Function &F, BasicBlock &BB,
                           : IP->getDebugLoc();
   IRBuilder<> IRB(IP);
   IRB.SetCurrentDebugLocation(EntryLoc);
-  SmallVector<Value *, 1> Indices;
-  Value *GuardP = IRB.CreateAdd(
-      IRB.CreatePointerCast(GuardArray, IntptrTy),
-      ConstantInt::get(IntptrTy, (1 + SanCovFunction->getNumUses()) * 4));
+  unsigned GuardIndex = NumGuards++;
+  Value *GuardP =
+      IRB.CreateAdd(IRB.CreatePointerCast(GuardArray, IntptrTy),
+                    ConstantInt::get(IntptrTy, (1 + GuardIndex) * 4));
   Type *Int32PtrTy = PointerType::getUnqual(IRB.getInt32Ty());
   GuardP = IRB.CreateIntToPtr(GuardP, Int32PtrTy);
-  if (UseCalls) {
+
+  if (EightBitCounterArray) {
+    // Plain, non-atomic increment: a lost or wrapped count costs little.
+    Value *CounterP = IRB.CreateIntToPtr(
+        IRB.CreateAdd(IRB.CreatePointerCast(EightBitCounterArray, IntptrTy),
+                      ConstantInt::get(IntptrTy, GuardIndex)),
+        IRB.getInt8PtrTy());
+    LoadInst *LI = IRB.CreateLoad(CounterP);
+    Value *Inc = IRB.CreateAdd(LI, IRB.getInt8(1));
+    StoreInst *SI = IRB.CreateStore(Inc, CounterP);
+    unsigned NoSanitizeKind = F.getParent()->getMDKindID("nosanitize");
+    LI->setMetadata(NoSanitizeKind, MDNode::get(*C, None));
+    SI->setMetadata(NoSanitizeKind, MDNode::get(*C, None));
+  }
+
+  if (ClTracePCGuard) {
+    // The callee checks the guard, if it cares about it.
+    IRB.CreateCall(SanCovTracePCGuard, GuardP);
+    IRB.CreateCall(EmptyAsm);  // Avoids callback merge.
+  } else if (UseCalls) {
     IRB.CreateCall(SanCovWithCheckFunction, GuardP);
   } else {
     LoadInst *Load = IRB.CreateLoad(GuardP);
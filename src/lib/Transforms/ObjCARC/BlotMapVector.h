@@ -99,5 +99,8 @@ public:
     Map.clear();
     Vector.clear();
   }
+
+  /// Return the number of elements that have not been blotted.
+  size_t size() const { return Map.size(); }
 };
 } //
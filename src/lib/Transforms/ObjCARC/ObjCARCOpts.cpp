@@ -39,6 +39,7 @@
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -47,6 +48,11 @@ using namespace llvm::objcarc;
 
 #define DEBUG_TYPE "objc-arc-opts"
 
+static cl::opt<unsigned> MaxPtrStates("arc-opt-max-ptr-states",
+    cl::Hidden,
+    cl::desc("Maximum number of ptr states the optimizer keeps track of"),
+    cl::init(4095));
+
 /// \defgroup ARCUtilities Utility declarations/definitions specific to ARC.
 /// @{
 
@@ -270,7 +276,11 @@ namespace {
       PerPtrTopDown.clear();
     }
 
+    size_t top_down_ptr_list_size() const { return PerPtrTopDown.size(); }
+    size_t bottom_up_ptr_list_size() const { return PerPtrBottomUp.size(); }
+
     void InitFromPred(const BBState &Other);
+    void InitFromPred(BBState &&Other);
     void InitFromSucc(const BBState &Other);
     void MergePred(const BBState &Other);
     void MergeSucc(const BBState &Other);
@@ -314,6 +324,14 @@ void BBState::InitFromPred(const BBState &Other) {
   TopDownPathCount = Other.TopDownPathCount;
 }
 
+/// Take over the state of a predecessor whose only successor is this block:
+/// nothing else reads it.
+void BBState::InitFromPred(BBState &&Other) {
+  PerPtrTopDown = std::move(Other.PerPtrTopDown);
+  Other.PerPtrTopDown.clear();
+  TopDownPathCount = Other.TopDownPathCount;
+}
+
 void BBState::InitFromSucc(const BBState &Other) {
   PerPtrBottomUp = Other.PerPtrBottomUp;
   BottomUpPathCount = Other.BottomUpPathCount;
@@ -426,6 +444,10 @@ namespace {
     /// A flag indicating whether this optimization pass should run.
     bool Run;
 
+    /// A flag set when a block tracks more than MaxPtrStates pointers, which
+    /// stops the pairing of retains and releases in the current function.
+    bool DisableRetainReleasePairing;
+
     /// Flags which determine whether each of the interesting runtine functions
     /// is in fact used in the current function.
     unsigned UsedInThisFunction;
@@ -1164,6 +1186,13 @@ bool ObjCARCOpt::VisitBottomUp(BasicBlock *BB,
     DEBUG(dbgs() << "Visiting " << *Inst << "\n");
 
     NestingDetected |= VisitInstructionBottomUp(Inst, BB, Retains, MyStates);
+
+    // Bail out if the number of pointers being tracked becomes too large so
+    // that this pass can complete in a reasonable amount of time.
+    if (MyStates.bottom_up_ptr_list_size() > MaxPtrStates) {
+      DisableRetainReleasePairing = true;
+      return false;
+    }
   }
 
   // If there's a predecessor with an invoke, visit the invoke as if it were
@@ -1262,7 +1291,10 @@ ObjCARCOpt::VisitTopDown(BasicBlock *BB,
     const BasicBlock *Pred = *PI;
     DenseMap<const BasicBlock *, BBState>::iterator I = BBStates.find(Pred);
     assert(I != BBStates.end());
-    MyStates.InitFromPred(I->second);
+    if (std::next(I->second.succ_begin()) == I->second.succ_end())
+      MyStates.InitFromPred(std::move(I->second));
+    else
+      MyStates.InitFromPred(I->second);
     ++PI;
     for (; PI != PE; ++PI) {
       Pred = *PI;
@@ -1279,6 +1311,13 @@ ObjCARCOpt::VisitTopDown(BasicBlock *BB,
     DEBUG(dbgs() << "Visiting " << *Inst << "\n");
 
     NestingDetected |= VisitInstructionTopDown(Inst, Releases, MyStates);
+
+    // Bail out if the number of pointers being tracked becomes too large so
+    // that this pass can complete in a reasonable amount of time.
+    if (MyStates.top_down_ptr_list_size() > MaxPtrStates) {
+      DisableRetainReleasePairing = true;
+      return false;
+    }
   }
 
   CheckForCFGHazards(BB, BBStates, MyStates);
@@ -1386,15 +1425,21 @@ bool ObjCARCOpt::Visit(Function &F,
   bool BottomUpNestingDetected = false;
   for (SmallVectorImpl<BasicBlock *>::const_reverse_iterator I =
        ReverseCFGPostOrder.rbegin(), E = ReverseCFGPostOrder.rend();
-       I != E; ++I)
+       I != E; ++I) {
     BottomUpNestingDetected |= VisitBottomUp(*I, BBStates, Retains);
+    if (DisableRetainReleasePairing)
+      return false;
+  }
 
   // Use reverse-postorder for top-down.
   bool TopDownNestingDetected = false;
   for (SmallVectorImpl<BasicBlock *>::const_reverse_iterator I =
        PostOrder.rbegin(), E = PostOrder.rend();
-       I != E; ++I)
+       I != E; ++I) {
     TopDownNestingDetected |= VisitTopDown(*I, BBStates, Releases);
+    if (DisableRetainReleasePairing)
+      return false;
+  }
 
   return TopDownNestingDetected && BottomUpNestingDetected;
 }
@@ -1903,6 +1948,11 @@ bool ObjCARCOpt::OptimizeSequences(Function &F) {
   // Analyze the CFG of the function, and all instructions.
   bool NestingDetected = Visit(F, BBStates, Retains, Releases);
 
+  if (DisableRetainReleasePairing) {
+    MultiOwnersSet.clear();
+    return false;
+  }
+
   // Transform.
   bool AnyPairsCompletelyEliminated = PerformCodePlacement(BBStates, Retains,
                                                            Releases,
@@ -2122,6 +2172,7 @@ bool ObjCARCOpt::runOnFunction(Function &F) {
     return false;
 
   Changed = false;
+  DisableRetainReleasePairing = false;
 
   DEBUG(dbgs() << "<<< ObjCARCOpt: Visiting Function: " << F.getName() << " >>>"
         "\n");
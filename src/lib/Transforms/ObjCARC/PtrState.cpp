@@ -214,6 +214,11 @@ bool BottomUpPtrState::HandlePotentialAlterRefCount(Instruction *Inst,
                                                     ARCInstKind Class) {
   Sequence Seq = GetSeq();
 
+  // Only a pointer in use can be affected; don't query the provenance of the
+  // others.
+  if (Seq != S_Use)
+    return false;
+
   // Check for possible releases.
   if (!CanAlterRefCount(Inst, Ptr, PA, Class))
     return false;
@@ -341,6 +346,11 @@ bool TopDownPtrState::HandlePotentialAlterRefCount(Instruction *Inst,
                                                    const Value *Ptr,
                                                    ProvenanceAnalysis &PA,
                                                    ARCInstKind Class) {
+  // A possible release only matters to a retained pointer, or to one whose
+  // reference count is known to be positive.
+  if (Seq != S_Retain && !HasKnownPositiveRefCount())
+    return false;
+
   // Check for possible releases.
   if (!CanAlterRefCount(Inst, Ptr, PA, Class))
     return false;
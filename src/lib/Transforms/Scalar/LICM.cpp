@@ -264,11 +264,14 @@ bool LICM::runOnLoop(Loop *L, LPPassManager &LPM) {
   // Because subloops have already been incorporated into AST, we skip blocks in
   // subloops.
   //
-  for (Loop::block_iterator I = L->block_begin(), E = L->block_end();
-       I != E; ++I) {
-    BasicBlock *BB = *I;
-    if (LI->getLoopFor(BB) == L)        // Ignore blocks in subloops.
-      CurAST->add(*BB);                 // Incorporate the specified basic block
+  {
+    AliasAnalysis::BatchQueryScope Batch(*AA);
+    for (Loop::block_iterator I = L->block_begin(), E = L->block_end();
+         I != E; ++I) {
+      BasicBlock *BB = *I;
+      if (LI->getLoopFor(BB) == L)      // Ignore blocks in subloops.
+        CurAST->add(*BB);               // Incorporate the specified basic block
+    }
   }
 
   HeaderMayThrow = false;
@@ -115,10 +115,13 @@ public:
 private:
   // This transformation requires dominator postdominator info
   void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesCFG();
     AU.addRequired<TargetLibraryInfoWrapperPass>();
     AU.addRequired<MemoryDependenceAnalysis>();
     AU.addRequired<AliasAnalysis>();
     AU.addPreserved<AliasAnalysis>();
+    // removeInstruction keeps the dependence cache up to date for GVN.
+    AU.addPreserved<MemoryDependenceAnalysis>();
   }
 
   // Helper routines
@@ -1505,6 +1505,8 @@ namespace {
   struct SCCP : public FunctionPass {
     void getAnalysisUsage(AnalysisUsage &AU) const override {
       AU.addRequired<TargetLibraryInfoWrapperPass>();
+      // Dead blocks are emptied but kept, so the CFG is left untouched.
+      AU.setPreservesCFG();
     }
     static char ID; // Pass identification, replacement for typeid
     SCCP() : FunctionPass(ID) {
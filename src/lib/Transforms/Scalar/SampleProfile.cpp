@@ -20,6 +20,13 @@
 //      that edge. The weight of a block B is computed as the maximum
 //      number of samples found in B.
 //
+// The profile of a function keeps the samples of the functions that were
+// inlined into it in the profiled binary apart, per call site. Before
+// annotating a function, the call sites that were inlined and hot in the
+// profiled binary are inlined again, so that the samples of the inlined
+// instances can be attributed to the inlined code. The samples of an
+// instruction are looked up along its inline stack.
+//
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Transforms/Scalar.h"
@@ -28,7 +35,6 @@
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Analysis/LoopInfo.h"
-#include "llvm/Analysis/PostDominators.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DebugInfo.h"
 #include "llvm/IR/DiagnosticInfo.h"
@@ -45,6 +51,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 #include <cctype>
 
 using namespace llvm;
@@ -61,6 +68,10 @@ static cl::opt<unsigned> SampleProfileMaxPropagateIterations(
     "sample-profile-max-propagate-iterations", cl::init(100),
     cl::desc("Maximum number of iterations to go through when propagating "
              "sample block/edge weights through the CFG."));
+static cl::opt<unsigned> SampleProfileHotThreshold(
+    "sample-profile-inline-hot-threshold", cl::init(5), cl::value_desc("N"),
+    cl::desc("Inlined functions that account for more than N% of all samples "
+             "collected in the parent function, will be inlined again."));
 
 namespace {
 typedef DenseMap<BasicBlock *, unsigned> BlockWeightMap;
@@ -80,8 +91,8 @@ public:
   static char ID;
 
   SampleProfileLoader(StringRef Name = SampleProfileFile)
-      : FunctionPass(ID), DT(nullptr), PDT(nullptr), LI(nullptr), Ctx(nullptr),
-        Reader(), Samples(nullptr), Filename(Name), ProfileIsValid(false) {
+      : FunctionPass(ID), Ctx(nullptr), Reader(), Samples(nullptr),
+        Filename(Name), ProfileIsValid(false) {
     initializeSampleProfileLoaderPass(*PassRegistry::getPassRegistry());
   }
 
@@ -93,17 +104,14 @@ public:
 
   bool runOnFunction(Function &F) override;
 
-  void getAnalysisUsage(AnalysisUsage &AU) const override {
-    AU.setPreservesCFG();
-    AU.addRequired<LoopInfoWrapperPass>();
-    AU.addRequired<DominatorTreeWrapperPass>();
-    AU.addRequired<PostDominatorTree>();
-  }
-
 protected:
   unsigned getFunctionLoc(Function &F);
   bool emitAnnotations(Function &F);
   unsigned getInstWeight(Instruction &I);
+  const FunctionSamples *findFunctionSamples(const Instruction &I) const;
+  const FunctionSamples *findCalleeFunctionSamples(const CallInst &I) const;
+  bool inlineHotFunctions(Function &F);
+  void computeDominanceAndLoopInfo(Function &F);
   unsigned getBlockWeight(BasicBlock *BB);
   void printEdgeWeight(raw_ostream &OS, Edge E);
   void printBlockWeight(raw_ostream &OS, BasicBlock *BB);
@@ -149,9 +157,12 @@ protected:
   EquivalenceClassMap EquivalenceClass;
 
   /// \brief Dominance, post-dominance and loop information.
-  DominatorTree *DT;
-  PostDominatorTree *PDT;
-  LoopInfo *LI;
+  ///
+  /// These are computed by the pass itself, since inlining the hot call
+  /// sites changes the CFG before the function is annotated.
+  std::unique_ptr<DominatorTree> DT;
+  std::unique_ptr<DominatorTreeBase<BasicBlock>> PDT;
+  std::unique_ptr<LoopInfo> LI;
 
   /// \brief Predecessors for each basic block in the CFG.
   BlockEdgeMap Predecessors;
@@ -165,7 +176,8 @@ protected:
   /// \brief Profile reader object.
   std::unique_ptr<SampleProfileReader> Reader;
 
-  /// \brief Samples collected for the body of this function.
+  /// \brief Samples collected for the body of this function, including the
+  /// samples of the functions inlined into it.
   FunctionSamples *Samples;
 
   /// \brief Name of the profile file to load.
@@ -204,36 +216,170 @@ void SampleProfileLoader::printBlockWeight(raw_ostream &OS, BasicBlock *BB) {
   OS << "weight[" << BB->getName() << "]: " << BlockWeights[BB] << "\n";
 }
 
+/// \brief Compute the line offset of \p DIL relative to the start of the
+/// function whose code it is in, which is the inlined function for inlined
+/// code.
+///
+/// \returns false if \p DIL is before the start of the function.
+static bool getLineOffset(const DILocation *DIL, int &LOffset) {
+  DISubprogram *SP = DIL->getScope()->getSubprogram();
+  if (!SP || DIL->getLine() < SP->getLine())
+    return false;
+  LOffset = DIL->getLine() - SP->getLine();
+  return true;
+}
+
+/// \brief Return the name that the profile uses for \p SP.
+static StringRef getProfileName(const DISubprogram *SP) {
+  StringRef Name = SP->getLinkageName();
+  return Name.empty() ? SP->getName() : Name;
+}
+
 /// \brief Get the weight for an instruction.
 ///
 /// The "weight" of an instruction \p Inst is the number of samples
 /// collected on that instruction at runtime. To retrieve it, we
-/// need to compute the line number of \p Inst relative to the start of its
-/// function. We use HeaderLineno to compute the offset. We then
-/// look up the samples collected for \p Inst using BodySamples.
+/// need to compute the line number of \p Inst relative to the start of the
+/// function that it comes from, and look up the samples collected for
+/// \p Inst in the profile of that function along the inline stack of
+/// \p Inst.
 ///
 /// \param Inst Instruction to query.
 ///
 /// \returns The profiled weight of I.
 unsigned SampleProfileLoader::getInstWeight(Instruction &Inst) {
-  DebugLoc DLoc = Inst.getDebugLoc();
-  if (!DLoc)
+  const DILocation *DIL = Inst.getDebugLoc();
+  if (!DIL)
+    return 0;
+
+  int LOffset;
+  if (!getLineOffset(DIL, LOffset))
     return 0;
 
-  unsigned Lineno = DLoc.getLine();
-  if (Lineno < HeaderLineno)
+  const FunctionSamples *FS = findFunctionSamples(Inst);
+  if (!FS)
     return 0;
 
-  const DILocation *DIL = DLoc;
-  int LOffset = Lineno - HeaderLineno;
+  unsigned Lineno = DIL->getLine();
   unsigned Discriminator = DIL->getDiscriminator();
-  unsigned Weight = Samples->samplesAt(LOffset, Discriminator);
+  unsigned Weight = FS->findSamplesAt(LOffset, Discriminator);
   DEBUG(dbgs() << "    " << Lineno << "." << Discriminator << ":" << Inst
                << " (line offset: " << LOffset << "." << Discriminator
                << " - weight: " << Weight << ")\n");
   return Weight;
 }
 
+/// \brief Get the profile of the inlined instance that \p Inst comes from.
+///
+/// The inline stack of \p Inst is turned into the chain of call sites that
+/// lead to its inlined instance in the profile, starting at the outermost
+/// call site.
+///
+/// \returns the profile of the inlined instance, Samples for code that was
+/// not inlined, or null if the profile has no samples for the instance.
+const FunctionSamples *
+SampleProfileLoader::findFunctionSamples(const Instruction &Inst) const {
+  const DILocation *DIL = Inst.getDebugLoc();
+  if (!DIL)
+    return Samples;
+
+  SmallVector<CallsiteLocation, 8> InlineStack;
+  for (const DILocation *CallDIL = DIL->getInlinedAt(); CallDIL;
+       DIL = CallDIL, CallDIL = CallDIL->getInlinedAt()) {
+    DISubprogram *SP = DIL->getScope()->getSubprogram();
+    int LOffset;
+    if (!SP || !getLineOffset(CallDIL, LOffset))
+      return nullptr;
+    InlineStack.push_back(CallsiteLocation(LOffset, CallDIL->getDiscriminator(),
+                                           getProfileName(SP)));
+  }
+
+  const FunctionSamples *FS = Samples;
+  for (auto I = InlineStack.rbegin(), E = InlineStack.rend(); I != E && FS;
+       ++I)
+    FS = FS->findFunctionSamplesAt(*I);
+  return FS;
+}
+
+/// \brief Get the profile of the function called by \p Inst, when it was
+/// inlined at \p Inst in the profiled binary.
+///
+/// \returns the profile of the inlined instance, or null if the callee was
+/// not inlined at \p Inst.
+const FunctionSamples *
+SampleProfileLoader::findCalleeFunctionSamples(const CallInst &Inst) const {
+  const DILocation *DIL = Inst.getDebugLoc();
+  Function *Callee = Inst.getCalledFunction();
+  int LOffset;
+  if (!DIL || !Callee || !getLineOffset(DIL, LOffset))
+    return nullptr;
+
+  const FunctionSamples *FS = findFunctionSamples(Inst);
+  if (!FS)
+    return nullptr;
+  return FS->findFunctionSamplesAt(
+      CallsiteLocation(LOffset, DIL->getDiscriminator(), Callee->getName()));
+}
+
+/// \brief Inline the call sites that were inlined and hot in the profiled
+/// binary.
+///
+/// A call site is hot if its inlined instance collected at least
+/// -sample-profile-inline-hot-threshold percent of the samples of \p F. The
+/// code inlined at a call site may contain hot call sites of its own, so
+/// this iterates until no hot call site is left.
+///
+/// \param F The function to query.
+///
+/// \returns true if any call site was inlined.
+bool SampleProfileLoader::inlineHotFunctions(Function &F) {
+  bool Changed = false;
+  uint64_t HotSamples =
+      uint64_t(Samples->getTotalSamples()) * SampleProfileHotThreshold / 100;
+  while (true) {
+    SmallVector<CallInst *, 8> HotCalls;
+    for (auto &BB : F)
+      for (auto &I : BB) {
+        CallInst *CI = dyn_cast<CallInst>(&I);
+        if (!CI)
+          continue;
+        Function *Callee = CI->getCalledFunction();
+        if (!Callee || Callee == &F || Callee->isDeclaration() ||
+            Callee->hasFnAttribute(Attribute::NoInline))
+          continue;
+        const FunctionSamples *FS = findCalleeFunctionSamples(*CI);
+        if (FS && FS->getTotalSamples() && FS->getTotalSamples() >= HotSamples)
+          HotCalls.push_back(CI);
+      }
+
+    bool LocalChanged = false;
+    for (CallInst *CI : HotCalls) {
+      DEBUG(dbgs() << "Inlining hot call site to "
+                   << CI->getCalledFunction()->getName() << " in "
+                   << F.getName() << "\n");
+      InlineFunctionInfo IFI;
+      LocalChanged |= InlineFunction(CI, IFI);
+    }
+    if (!LocalChanged)
+      break;
+    Changed = true;
+  }
+  return Changed;
+}
+
+/// \brief Compute the dominance, post-dominance and loop information of
+/// \p F.
+void SampleProfileLoader::computeDominanceAndLoopInfo(Function &F) {
+  DT.reset(new DominatorTree);
+  DT->recalculate(F);
+
+  PDT.reset(new DominatorTreeBase<BasicBlock>(true));
+  PDT->recalculate(F);
+
+  LI.reset(new LoopInfo);
+  LI->Analyze(*DT);
+}
+
 /// \brief Compute the weight of a basic block.
 ///
 /// The weight of basic block \p BB is the maximum weight of all the
@@ -364,7 +510,7 @@ void SampleProfileLoader::findEquivalenceClasses(Function &F) {
     // class by making BB2's equivalence class be BB1.
     DominatedBBs.clear();
     DT->getDescendants(BB1, DominatedBBs);
-    findEquivalencesFor(BB1, DominatedBBs, PDT->DT);
+    findEquivalencesFor(BB1, DominatedBBs, PDT.get());
 
     // Repeat the same logic for all the blocks post-dominated by BB1.
     // We are looking for every basic block BB2 such that:
@@ -376,7 +522,7 @@ void SampleProfileLoader::findEquivalenceClasses(Function &F) {
     // If all those conditions hold, BB2's equivalence class is BB1.
     DominatedBBs.clear();
     PDT->getDescendants(BB1, DominatedBBs);
-    findEquivalencesFor(BB1, DominatedBBs, DT);
+    findEquivalencesFor(BB1, DominatedBBs, DT.get());
 
     DEBUG(printBlockEquivalence(dbgs(), BB1));
   }
@@ -714,11 +860,24 @@ bool SampleProfileLoader::emitAnnotations(Function &F) {
   DEBUG(dbgs() << "Line number for the first instruction in " << F.getName()
                << ": " << HeaderLineno << "\n");
 
+  Changed |= inlineHotFunctions(F);
+
+  // The state of the previous function refers to its blocks, which may have
+  // been freed.
+  BlockWeights.clear();
+  EdgeWeights.clear();
+  VisitedBlocks.clear();
+  VisitedEdges.clear();
+  EquivalenceClass.clear();
+  Predecessors.clear();
+  Successors.clear();
+
   // Compute basic block weights.
   Changed |= computeBlockWeights(F);
 
   if (Changed) {
     // Find equivalence classes.
+    computeDominanceAndLoopInfo(F);
     findEquivalenceClasses(F);
 
     // Propagate weights to all edges.
@@ -731,9 +890,6 @@ bool SampleProfileLoader::emitAnnotations(Function &F) {
 char SampleProfileLoader::ID = 0;
 INITIALIZE_PASS_BEGIN(SampleProfileLoader, "sample-profile",
                       "Sample Profile loader", false, false)
-INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
-INITIALIZE_PASS_DEPENDENCY(PostDominatorTree)
-INITIALIZE_PASS_DEPENDENCY(LoopInfoWrapperPass)
 INITIALIZE_PASS_DEPENDENCY(AddDiscriminators)
 INITIALIZE_PASS_END(SampleProfileLoader, "sample-profile",
                     "Sample Profile loader", false, false)
@@ -746,7 +902,7 @@ bool SampleProfileLoader::doInitialization(Module &M) {
     return false;
   }
   Reader = std::move(ReaderOrErr.get());
-  ProfileIsValid = (Reader->read() == sampleprof_error::success);
+  ProfileIsValid = (Reader->readOnDemand() == sampleprof_error::success);
   return true;
 }
 
@@ -762,9 +918,6 @@ bool SampleProfileLoader::runOnFunction(Function &F) {
   if (!ProfileIsValid)
     return false;
 
-  DT = &getAnalysis<DominatorTreeWrapperPass>().getDomTree();
-  PDT = &getAnalysis<PostDominatorTree>();
-  LI = &getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
   Ctx = &F.getParent()->getContext();
   Samples = Reader->getSamplesFor(F);
   if (!Samples->empty())
@@ -0,0 +1,193 @@
+//===- SplitModule.cpp - Split a module into partitions -------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the function llvm::SplitModule, which splits a module
+// into multiple linkable partitions. It can be used to implement parallel code
+// generation for link-time optimization.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalAlias.h"
+#include "llvm/IR/GlobalObject.h"
+#include "llvm/IR/GlobalValue.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/xxhash.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <vector>
+
+using namespace llvm;
+
+typedef EquivalenceClasses<const GlobalValue *> ClusterMapTy;
+
+/// Whether the name of \p GV is emitted verbatim, without mangling. Such
+/// symbols may rely on assembler-local prefixes and must stay local.
+static bool hasVerbatimName(const GlobalValue *GV) {
+  return GV->getName().startswith("\1");
+}
+
+/// Give \p GV a name that can be referred to from another partition.
+static void externalize(GlobalValue *GV) {
+  // Unnamed entities must be named consistently between partitions. setName
+  // gives a distinct name to each such entity.
+  if (!GV->hasName())
+    GV->setName("__llvmsplit_unnamed");
+  if (GV->hasLocalLinkage() && !hasVerbatimName(GV)) {
+    // The symbol must not clash with the symbols of the objects that the
+    // partitions are eventually linked with.
+    GV->setName(GV->getName() + ".llvm.split");
+    GV->setLinkage(GlobalValue::ExternalLinkage);
+    GV->setVisibility(GlobalValue::HiddenVisibility);
+  }
+}
+
+/// Collect the global values that refer to \p V, looking through constants.
+static void findUsingGlobals(const Value *V,
+                             SmallPtrSetImpl<const GlobalValue *> &Globals,
+                             SmallPtrSetImpl<const User *> &Visited) {
+  for (const User *U : V->users()) {
+    if (const auto *I = dyn_cast<Instruction>(U))
+      Globals.insert(I->getParent()->getParent());
+    else if (const auto *GV = dyn_cast<GlobalValue>(U))
+      Globals.insert(GV);
+    else if (isa<Constant>(U) && Visited.insert(U).second)
+      findUsingGlobals(U, Globals, Visited);
+  }
+}
+
+/// Group the definitions of \p M that must end up in the same partition.
+static void findClusters(const Module &M, ClusterMapTy &Clusters) {
+  DenseMap<const Comdat *, const GlobalValue *> ComdatMembers;
+  auto Insert = [&](const GlobalValue &GV) {
+    if (GV.isDeclaration())
+      return;
+    Clusters.insert(&GV);
+    if (const Comdat *C = GV.getComdat()) {
+      auto Member = ComdatMembers.insert(std::make_pair(C, &GV));
+      if (!Member.second)
+        Clusters.unionSets(Member.first->second, &GV);
+    }
+    if (const auto *GA = dyn_cast<GlobalAlias>(&GV))
+      if (const GlobalObject *Base = GA->getBaseObject())
+        if (!Base->isDeclaration())
+          Clusters.unionSets(Base, GA);
+
+    // A symbol that stays local must be defined alongside all its users.
+    if (GV.hasLocalLinkage() && hasVerbatimName(&GV)) {
+      SmallPtrSet<const GlobalValue *, 8> Users;
+      SmallPtrSet<const User *, 8> Visited;
+      findUsingGlobals(&GV, Users, Visited);
+      for (const GlobalValue *U : Users)
+        if (!U->isDeclaration())
+          Clusters.unionSets(&GV, U);
+    }
+  };
+  for (const Function &F : M)
+    Insert(F);
+  for (const GlobalVariable &GV : M.globals())
+    Insert(GV);
+  for (const GlobalAlias &GA : M.aliases())
+    Insert(GA);
+}
+
+/// Return the partition of the cluster represented by \p Leader.
+static unsigned getPartition(const GlobalValue *Leader, unsigned N) {
+  // Partition by hash. We only need a few bits for evenness as the number of
+  // partitions will generally be in the 1-2 figure range, so a fast
+  // non-cryptographic hash does as well as MD5.
+  return xxHash64(Leader->getName()) % N;
+}
+
+/// Only keep the entries of the used list \p Name that are defined in \p M.
+static void restrictUsedList(Module &M, StringRef Name) {
+  GlobalVariable *Used = M.getGlobalVariable(Name);
+  if (!Used || !Used->hasInitializer())
+    return;
+  auto *Init = dyn_cast<ConstantArray>(Used->getInitializer());
+  if (!Init)
+    return;
+
+  std::vector<Constant *> Kept;
+  for (const Use &Op : Init->operands()) {
+    auto *GV = dyn_cast<GlobalValue>(Op->stripPointerCasts());
+    if (GV && !GV->isDeclaration())
+      Kept.push_back(cast<Constant>(Op.get()));
+  }
+  if (Kept.size() == Init->getNumOperands())
+    return;
+
+  if (!Kept.empty()) {
+    ArrayType *ATy = ArrayType::get(Init->getType()->getElementType(),
+                                    Kept.size());
+    auto *NewUsed = new GlobalVariable(M, ATy, false,
+                                       GlobalValue::AppendingLinkage,
+                                       ConstantArray::get(ATy, Kept), "");
+    NewUsed->setSection(Used->getSection());
+    NewUsed->takeName(Used);
+  }
+  Used->eraseFromParent();
+}
+
+static bool isUsedList(const GlobalValue *GV) {
+  return GV->getName() == "llvm.used" || GV->getName() == "llvm.compiler.used";
+}
+
+void llvm::SplitModule(
+    Module &M, unsigned N,
+    function_ref<void(std::unique_ptr<Module> MPart)> ModuleCallback) {
+  for (Function &F : M)
+    externalize(&F);
+  for (GlobalVariable &GV : M.globals())
+    externalize(&GV);
+  for (GlobalAlias &GA : M.aliases())
+    externalize(&GA);
+
+  ClusterMapTy Clusters;
+  findClusters(M, Clusters);
+
+  DenseMap<const GlobalValue *, unsigned> Partitions;
+  for (auto I = Clusters.begin(), E = Clusters.end(); I != E; ++I)
+    if (I->isLeader())
+      Partitions[I->getData()] = getPartition(I->getData(), N);
+
+  std::vector<std::string> AppendingNames;
+  for (const GlobalVariable &GV : M.globals())
+    if (GV.hasAppendingLinkage() && !isUsedList(&GV))
+      AppendingNames.push_back(GV.getName());
+
+  for (unsigned I = 0; I != N; ++I) {
+    ValueToValueMapTy VMap;
+    std::unique_ptr<Module> MPart(
+        CloneModule(&M, VMap, [&](const GlobalValue *GV) {
+          // The used lists are split below; the other appending globals, such
+          // as the constructor lists, go to the first partition.
+          if (isUsedList(GV))
+            return true;
+          if (GV->hasAppendingLinkage())
+            return I == 0;
+          return Partitions[Clusters.getLeaderValue(GV)] == I;
+        }));
+    if (I != 0) {
+      MPart->setModuleInlineAsm("");
+      for (const std::string &Name : AppendingNames)
+        if (GlobalVariable *GV = MPart->getGlobalVariable(Name))
+          if (GV->isDeclaration() && GV->use_empty())
+            GV->eraseFromParent();
+    }
+    restrictUsedList(*MPart, "llvm.used");
+    restrictUsedList(*MPart, "llvm.compiler.used");
+    ModuleCallback(std::move(MPart));
+  }
+}
@@ -54,6 +54,9 @@ using namespace llvm;
 #define DEBUG_TYPE "SLP"
 
 STATISTIC(NumVectorInstructions, "Number of vector instructions generated");
+STATISTIC(NumTreesBuilt, "Number of trees considered for vectorization");
+STATISTIC(NumTreesVectorized, "Number of trees vectorized");
+STATISTIC(NumHorizontalReductions, "Number of horizontal reductions vectorized");
 
 static cl::opt<int>
     SLPCostThreshold("slp-threshold", cl::init(0), cl::Hidden,
@@ -69,12 +72,24 @@ static cl::opt<bool> ShouldStartVectorizeHorAtStore(
     cl::desc(
         "Attempt to vectorize horizontal reductions feeding into a store"));
 
+static cl::opt<unsigned> RecursionMaxDepth(
+    "slp-recursion-max-depth", cl::init(12), cl::Hidden,
+    cl::desc("Limit the recursion depth when building a vectorizable tree"));
+
+static cl::opt<unsigned> ScheduleRegionSizeBudget(
+    "slp-schedule-budget", cl::init(100000), cl::Hidden,
+    cl::desc("Limit the size of the SLP scheduling region per block, "
+             "including the instructions searched to extend it"));
+
+static cl::opt<bool>
+PrintSLPStats("slp-stats", cl::init(false), cl::Hidden,
+              cl::desc("Print the number of trees built and vectorized in "
+                       "each function"));
+
 namespace {
 
 static const unsigned MinVecRegSize = 128;
 
-static const unsigned RecursionMaxDepth = 12;
-
 // Limit the number of alias checks. The limit is chosen so that
 // it has no negative effect on the llvm benchmarks.
 static const unsigned AliasedCheckLimit = 10;
@@ -345,7 +360,8 @@ public:
   BoUpSLP(Function *Func, ScalarEvolution *Se, TargetTransformInfo *Tti,
           TargetLibraryInfo *TLi, AliasAnalysis *Aa, LoopInfo *Li,
           DominatorTree *Dt, AssumptionCache *AC)
-      : NumLoadsWantToKeepOrder(0), NumLoadsWantToChangeOrder(0), F(Func),
+      : NumLoadsWantToKeepOrder(0), NumLoadsWantToChangeOrder(0),
+        NumBuiltTrees(0), NumVectorizedTrees(0), F(Func),
         SE(Se), TTI(Tti), TLI(TLi), AA(Aa), LI(Li), DT(Dt),
         Builder(Se->getContext()) {
     CodeMetrics::collectEphemeralValues(F, AC, EphValues);
@@ -393,6 +409,12 @@ public:
     return NumLoadsWantToChangeOrder > NumLoadsWantToKeepOrder;
   }
 
+  /// \returns the number of trees built in this function so far.
+  unsigned getNumBuiltTrees() const { return NumBuiltTrees; }
+
+  /// \returns the number of trees vectorized in this function so far.
+  unsigned getNumVectorizedTrees() const { return NumVectorizedTrees; }
+
 private:
   struct TreeEntry;
 
@@ -712,6 +734,7 @@ private:
         : BB(BB), ChunkSize(BB->size()), ChunkPos(ChunkSize),
           ScheduleStart(nullptr), ScheduleEnd(nullptr),
           FirstLoadStoreInRegion(nullptr), LastLoadStoreInRegion(nullptr),
+          ScheduleRegionSize(0),
           // Make sure that the initial SchedulingRegionID is greater than the
           // initial SchedulingRegionID in ScheduleData (which is 0).
           SchedulingRegionID(1) {}
@@ -722,6 +745,7 @@ private:
       ScheduleEnd = nullptr;
       FirstLoadStoreInRegion = nullptr;
       LastLoadStoreInRegion = nullptr;
+      ScheduleRegionSize = 0;
 
       // Make a new scheduling region, i.e. all existing ScheduleData is not
       // in the new region yet.
@@ -799,7 +823,8 @@ private:
     void cancelScheduling(ArrayRef<Value *> VL);
 
     /// Extends the scheduling region so that V is inside the region.
-    void extendSchedulingRegion(Value *V);
+    /// \returns false if the region would exceed the scheduling budget.
+    bool extendSchedulingRegion(Value *V);
 
     /// Initialize the ScheduleData structures for new instructions in the
     /// scheduling region.
@@ -853,6 +878,10 @@ private:
     /// (can be null).
     ScheduleData *LastLoadStoreInRegion;
 
+    /// The number of instructions in the scheduling region, plus the steps
+    /// spent searching for instructions to add to it.
+    unsigned ScheduleRegionSize;
+
     /// The ID of the scheduling region. For a new vectorization iteration this
     /// is incremented which "removes" all ScheduleData from the region.
     int SchedulingRegionID;
@@ -874,6 +903,10 @@ private:
   // Number of load-bundles of size 2, which are consecutive loads if reversed.
   int NumLoadsWantToChangeOrder;
 
+  // Number of trees built and vectorized, for -slp-stats.
+  unsigned NumBuiltTrees;
+  unsigned NumVectorizedTrees;
+
   // Analysis and block reference.
   Function *F;
   ScalarEvolution *SE;
@@ -899,6 +932,8 @@ void BoUpSLP::buildTree(ArrayRef<Value *> Roots,
   UserIgnoreList = UserIgnoreLst;
   if (!getSameType(Roots))
     return;
+  ++NumTreesBuilt;
+  ++NumBuiltTrees;
   buildTree_rec(Roots, 0);
 
   // Collect the values that we need to extract from the tree.
@@ -1072,7 +1107,6 @@ void BoUpSLP::buildTree_rec(ArrayRef<Value *> VL, unsigned Depth) {
 
   if (!BS.tryScheduleBundle(VL, this)) {
     DEBUG(dbgs() << "SLP: We are not able to schedule this bundle!\n");
-    BS.cancelScheduling(VL);
     newTreeEntry(VL, false);
     return;
   }
@@ -2484,6 +2518,8 @@ Value *BoUpSLP::vectorizeTree() {
 
   Builder.SetInsertPoint(F->getEntryBlock().begin());
   vectorizeTree(&VectorizableTree[0]);
+  ++NumTreesVectorized;
+  ++NumVectorizedTrees;
 
   DEBUG(dbgs() << "SLP: Extracting " << ExternalUses.size() << " values .\n");
 
@@ -2676,8 +2712,24 @@ bool BoUpSLP::BlockScheduling::tryScheduleBundle(ArrayRef<Value *> VL,
   ScheduleData *Bundle = nullptr;
   bool ReSchedule = false;
   DEBUG(dbgs() << "SLP:  bundle: " << *VL[0] << "\n");
+
+  // Make sure that the scheduling region contains all instructions of the
+  // bundle before linking them together.
+  for (Value *V : VL) {
+    if (!extendSchedulingRegion(V)) {
+      // Instructions that were already added at the lower end need their
+      // dependencies recalculated before the next bundle is scheduled.
+      if (ScheduleEnd != OldScheduleEnd) {
+        for (auto *I = ScheduleStart; I != ScheduleEnd; I = I->getNextNode())
+          getScheduleData(I)->clearDependencies();
+        resetSchedule();
+        initialFillReadyList(ReadyInsts);
+      }
+      return false;
+    }
+  }
+
   for (Value *V : VL) {
-    extendSchedulingRegion(V);
     ScheduleData *BundleMember = getScheduleData(V);
     assert(BundleMember &&
            "no ScheduleData for bundle member (maybe not in same basic block)");
@@ -2738,7 +2790,11 @@ bool BoUpSLP::BlockScheduling::tryScheduleBundle(ArrayRef<Value *> VL,
       schedule(pickedSD, ReadyInsts);
     }
   }
-  return Bundle->isReady();
+  if (!Bundle->isReady()) {
+    cancelScheduling(VL);
+    return false;
+  }
+  return true;
 }
 
 void BoUpSLP::BlockScheduling::cancelScheduling(ArrayRef<Value *> VL) {
@@ -2767,9 +2823,9 @@ void BoUpSLP::BlockScheduling::cancelScheduling(ArrayRef<Value *> VL) {
   }
 }
 
-void BoUpSLP::BlockScheduling::extendSchedulingRegion(Value *V) {
+bool BoUpSLP::BlockScheduling::extendSchedulingRegion(Value *V) {
   if (getScheduleData(V))
-    return;
+    return true;
   Instruction *I = dyn_cast<Instruction>(V);
   assert(I && "bundle member must be an instruction");
   assert(!isa<PHINode>(I) && "phi nodes don't need to be scheduled");
@@ -2780,7 +2836,7 @@ void BoUpSLP::BlockScheduling::extendSchedulingRegion(Value *V) {
     ScheduleEnd = I->getNextNode();
     assert(ScheduleEnd && "tried to vectorize a TerminatorInst?");
     DEBUG(dbgs() << "SLP:  initialize schedule region to " << *I << "\n");
-    return;
+    return true;
   }
   // Search up and down at the same time, because we don't know if the new
   // instruction is above or below the existing scheduling region.
@@ -2789,12 +2845,16 @@ void BoUpSLP::BlockScheduling::extendSchedulingRegion(Value *V) {
   BasicBlock::iterator DownIter(ScheduleEnd);
   BasicBlock::iterator LowerEnd = BB->end();
   for (;;) {
+    if (++ScheduleRegionSize > ScheduleRegionSizeBudget) {
+      DEBUG(dbgs() << "SLP:  exceeded schedule region size budget\n");
+      return false;
+    }
     if (UpIter != UpperEnd) {
       if (&*UpIter == I) {
         initScheduleData(I, ScheduleStart, nullptr, FirstLoadStoreInRegion);
         ScheduleStart = I;
         DEBUG(dbgs() << "SLP:  extend schedule region start to " << *I << "\n");
-        return;
+        return true;
       }
       UpIter++;
     }
@@ -2805,7 +2865,7 @@ void BoUpSLP::BlockScheduling::extendSchedulingRegion(Value *V) {
         ScheduleEnd = I->getNextNode();
         assert(ScheduleEnd && "tried to vectorize a TerminatorInst?");
         DEBUG(dbgs() << "SLP:  extend schedule region end to " << *I << "\n");
-        return;
+        return true;
       }
       DownIter++;
     }
@@ -2835,6 +2895,7 @@ void BoUpSLP::BlockScheduling::initScheduleData(Instruction *FromI,
     assert(!isInSchedulingRegion(SD) &&
            "new ScheduleData already in scheduling region");
     SD->init(SchedulingRegionID);
+    ++ScheduleRegionSize;
 
     if (I->mayReadOrWriteMemory()) {
       // Update the linked list of memory accessing instructions.
@@ -3119,6 +3180,10 @@ struct SLPVectorizer : public FunctionPass {
       DEBUG(dbgs() << "SLP: vectorized \"" << F.getName() << "\"\n");
       DEBUG(verifyFunction(F));
     }
+    if (PrintSLPStats)
+      errs() << "SLP: " << F.getName() << ": vectorized "
+             << R.getNumVectorizedTrees() << " of " << R.getNumBuiltTrees()
+             << " trees\n";
     return Changed;
   }
 
@@ -3498,8 +3563,9 @@ static Value *createRdxShuffleMask(unsigned VecLen, unsigned NumEltsToRdx,
 
 /// Model horizontal reductions.
 ///
-/// A horizontal reduction is a tree of reduction operations (currently add and
-/// fadd) that has operations that can be put into a vector as its leaf.
+/// A horizontal reduction is a tree of reduction operations (add, mul, and, or,
+/// xor, fadd, fmul, or an integer min/max formed by a select of a compare) that
+/// has operations that can be put into a vector as its leaf.
 /// For example, this tree:
 ///
 /// mul mul mul mul
@@ -3527,11 +3593,14 @@ class HorizontalReduction {
   SmallVector<Value *, 16> ReductionOps;
   SmallVector<Value *, 32> ReducedVals;
 
-  BinaryOperator *ReductionRoot;
+  Instruction *ReductionRoot;
   PHINode *ReductionPHI;
 
-  /// The opcode of the reduction.
+  /// The opcode of the reduction. This is Instruction::Select for min/max
+  /// reductions.
   unsigned ReductionOpcode;
+  /// The normalized compare predicate of a min/max reduction.
+  CmpInst::Predicate MinMaxPredicate;
   /// The opcode of the values we perform a reduction on.
   unsigned ReducedValueOpcode;
   /// The width of one full horizontal reduction operation.
@@ -3543,36 +3612,75 @@ class HorizontalReduction {
 public:
   HorizontalReduction()
     : ReductionRoot(nullptr), ReductionPHI(nullptr), ReductionOpcode(0),
-    ReducedValueOpcode(0), ReduxWidth(0), IsPairwiseReduction(false) {}
+    MinMaxPredicate(CmpInst::BAD_ICMP_PREDICATE), ReducedValueOpcode(0),
+    ReduxWidth(0), IsPairwiseReduction(false) {}
+
+  /// \returns the normalized predicate of an integer min/max operation
+  /// "select (icmp pred a, b), a, b", or BAD_ICMP_PREDICATE if \p V is not
+  /// one.
+  static CmpInst::Predicate getMinMaxPredicate(Value *V) {
+    SelectInst *Sel = dyn_cast<SelectInst>(V);
+    if (!Sel)
+      return CmpInst::BAD_ICMP_PREDICATE;
+    ICmpInst *Cmp = dyn_cast<ICmpInst>(Sel->getCondition());
+    if (!Cmp || !Cmp->hasOneUse())
+      return CmpInst::BAD_ICMP_PREDICATE;
+
+    Value *L = Sel->getTrueValue(), *R = Sel->getFalseValue();
+    CmpInst::Predicate Pred = Cmp->getPredicate();
+    if (Cmp->getOperand(0) == R && Cmp->getOperand(1) == L)
+      Pred = Cmp->getSwappedPredicate();
+    else if (Cmp->getOperand(0) != L || Cmp->getOperand(1) != R)
+      return CmpInst::BAD_ICMP_PREDICATE;
+
+    // "a >= b ? a : b" computes the same value as "a > b ? a : b".
+    switch (Pred) {
+    case CmpInst::ICMP_SGT:
+    case CmpInst::ICMP_SGE:
+      return CmpInst::ICMP_SGT;
+    case CmpInst::ICMP_SLT:
+    case CmpInst::ICMP_SLE:
+      return CmpInst::ICMP_SLT;
+    case CmpInst::ICMP_UGT:
+    case CmpInst::ICMP_UGE:
+      return CmpInst::ICMP_UGT;
+    case CmpInst::ICMP_ULT:
+    case CmpInst::ICMP_ULE:
+      return CmpInst::ICMP_ULT;
+    default:
+      return CmpInst::BAD_ICMP_PREDICATE;
+    }
+  }
 
   /// \brief Try to find a reduction tree.
-  bool matchAssociativeReduction(PHINode *Phi, BinaryOperator *B) {
+  bool matchAssociativeReduction(PHINode *Phi, Instruction *B) {
     assert((!Phi ||
             std::find(Phi->op_begin(), Phi->op_end(), B) != Phi->op_end()) &&
            "Thi phi needs to use the binary operator");
 
+    if (!setReductionKind(B))
+      return false;
+
     // We could have a initial reductions that is not an add.
     //  r *= v1 + v2 + v3 + v4
     // In such a case start looking for a tree rooted in the first '+'.
     if (Phi) {
-      if (B->getOperand(0) == Phi) {
+      if (getRdxOperand(B, 0) == Phi) {
         Phi = nullptr;
-        B = dyn_cast<BinaryOperator>(B->getOperand(1));
-      } else if (B->getOperand(1) == Phi) {
+        B = dyn_cast<Instruction>(getRdxOperand(B, 1));
+      } else if (getRdxOperand(B, 1) == Phi) {
         Phi = nullptr;
-        B = dyn_cast<BinaryOperator>(B->getOperand(0));
+        B = dyn_cast<Instruction>(getRdxOperand(B, 0));
       }
+      if (!Phi && (!B || !setReductionKind(B)))
+        return false;
     }
 
-    if (!B)
-      return false;
-
     Type *Ty = B->getType();
     if (!isValidElementType(Ty))
       return false;
 
     const DataLayout &DL = B->getModule()->getDataLayout();
-    ReductionOpcode = B->getOpcode();
     ReducedValueOpcode = 0;
     ReduxWidth = MinVecRegSize / DL.getTypeSizeInBits(Ty);
     ReductionRoot = B;
@@ -3581,29 +3689,19 @@ public:
     if (ReduxWidth < 4)
       return false;
 
-    // We currently only support adds.
-    if (ReductionOpcode != Instruction::Add &&
-        ReductionOpcode != Instruction::FAdd)
-      return false;
-
     // Post order traverse the reduction tree starting at B. We only handle true
-    // trees containing only binary operators.
-    SmallVector<std::pair<BinaryOperator *, unsigned>, 32> Stack;
+    // trees containing only reduction operations.
+    SmallVector<std::pair<Instruction *, unsigned>, 32> Stack;
     Stack.push_back(std::make_pair(B, 0));
     while (!Stack.empty()) {
-      BinaryOperator *TreeN = Stack.back().first;
+      Instruction *TreeN = Stack.back().first;
       unsigned EdgeToVist = Stack.back().second++;
-      bool IsReducedValue = TreeN->getOpcode() != ReductionOpcode;
+      bool IsReducedValue = !isReductionOp(TreeN);
 
       // Only handle trees in the current basic block.
       if (TreeN->getParent() != B->getParent())
         return false;
 
-      // Each tree node needs to have one user except for the ultimate
-      // reduction.
-      if (!TreeN->hasOneUse() && TreeN != B)
-        return false;
-
       // Postorder vist.
       if (EdgeToVist == 2 || IsReducedValue) {
         if (IsReducedValue) {
@@ -3615,10 +3713,12 @@ public:
             return false;
           ReducedVals.push_back(TreeN);
         } else {
-          // We need to be able to reassociate the adds.
-          if (!TreeN->isAssociative())
+          // We need to be able to reassociate the operations.
+          if (isa<BinaryOperator>(TreeN) && !TreeN->isAssociative())
             return false;
           ReductionOps.push_back(TreeN);
+          if (SelectInst *Sel = dyn_cast<SelectInst>(TreeN))
+            ReductionOps.push_back(Sel->getCondition());
         }
         // Retract.
         Stack.pop_back();
@@ -3626,12 +3726,15 @@ public:
       }
 
       // Visit left or right.
-      Value *NextV = TreeN->getOperand(EdgeToVist);
-      BinaryOperator *Next = dyn_cast<BinaryOperator>(NextV);
-      if (Next)
-        Stack.push_back(std::make_pair(Next, 0));
-      else if (NextV != Phi)
+      Value *NextV = getRdxOperand(TreeN, EdgeToVist);
+      if (NextV == Phi)
+        continue;
+      Instruction *Next = dyn_cast<Instruction>(NextV);
+      // Each tree node except for the ultimate reduction may only be used by
+      // its parent.
+      if (!Next || !hasOnlyRdxUser(Next, TreeN))
         return false;
+      Stack.push_back(std::make_pair(Next, 0));
     }
     return true;
   }
@@ -3672,8 +3775,8 @@ public:
       Value *ReducedSubTree = emitReduction(VectorizedRoot, Builder);
       if (VectorizedTree) {
         Builder.SetCurrentDebugLocation(Loc);
-        VectorizedTree = createBinOp(Builder, ReductionOpcode, VectorizedTree,
-                                     ReducedSubTree, "bin.rdx");
+        VectorizedTree =
+            createRdxOp(Builder, VectorizedTree, ReducedSubTree, "bin.rdx");
       } else
         VectorizedTree = ReducedSubTree;
     }
@@ -3683,35 +3786,109 @@ public:
       for (; i < NumReducedVals; ++i) {
         Builder.SetCurrentDebugLocation(
           cast<Instruction>(ReducedVals[i])->getDebugLoc());
-        VectorizedTree = createBinOp(Builder, ReductionOpcode, VectorizedTree,
-                                     ReducedVals[i]);
+        VectorizedTree = createRdxOp(Builder, VectorizedTree, ReducedVals[i]);
       }
       // Update users.
-      if (ReductionPHI) {
-        assert(ReductionRoot && "Need a reduction operation");
+      if (ReductionPHI && isa<BinaryOperator>(ReductionRoot)) {
         ReductionRoot->setOperand(0, VectorizedTree);
         ReductionRoot->setOperand(1, ReductionPHI);
+      } else if (ReductionPHI) {
+        // The root select and its compare become dead.
+        ReductionRoot->replaceAllUsesWith(
+            createRdxOp(Builder, VectorizedTree, ReductionPHI));
       } else
         ReductionRoot->replaceAllUsesWith(VectorizedTree);
+      ++NumHorizontalReductions;
     }
     return VectorizedTree != nullptr;
   }
 
 private:
 
+  /// \brief Classify \p Root as the root of an arithmetic or a min/max
+  /// reduction. \returns false if it can be neither.
+  bool setReductionKind(Instruction *Root) {
+    MinMaxPredicate = getMinMaxPredicate(Root);
+    if (MinMaxPredicate != CmpInst::BAD_ICMP_PREDICATE) {
+      ReductionOpcode = Instruction::Select;
+      return true;
+    }
+    ReductionOpcode = Root->getOpcode();
+    switch (ReductionOpcode) {
+    case Instruction::Add:
+    case Instruction::Mul:
+    case Instruction::And:
+    case Instruction::Or:
+    case Instruction::Xor:
+    case Instruction::FAdd:
+    case Instruction::FMul:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  /// \returns true if \p I is a reduction operation of this reduction's kind.
+  bool isReductionOp(Instruction *I) const {
+    if (ReductionOpcode == Instruction::Select)
+      return getMinMaxPredicate(I) == MinMaxPredicate;
+    return I->getOpcode() == ReductionOpcode;
+  }
+
+  /// \returns the reduced operand \p Idx of the reduction operation \p I.
+  static Value *getRdxOperand(Instruction *I, unsigned Idx) {
+    if (SelectInst *Sel = dyn_cast<SelectInst>(I))
+      return Sel->getOperand(Idx + 1);
+    return I->getOperand(Idx);
+  }
+
+  /// \returns true if the reduction operation \p Parent is the only user of
+  /// \p I. The compare of a min/max reduction operation uses its operands too.
+  static bool hasOnlyRdxUser(Instruction *I, Instruction *Parent) {
+    SelectInst *Sel = dyn_cast<SelectInst>(Parent);
+    if (!Sel)
+      return I->hasOneUse();
+    if (!I->hasNUses(2))
+      return false;
+    for (User *U : I->users())
+      if (U != Sel && U != Sel->getCondition())
+        return false;
+    return true;
+  }
+
   /// \brief Calcuate the cost of a reduction.
   int getReductionCost(TargetTransformInfo *TTI, Value *FirstReducedVal) {
     Type *ScalarTy = FirstReducedVal->getType();
     Type *VecTy = VectorType::get(ScalarTy, ReduxWidth);
 
-    int PairwiseRdxCost = TTI->getReductionCost(ReductionOpcode, VecTy, true);
-    int SplittingRdxCost = TTI->getReductionCost(ReductionOpcode, VecTy, false);
-
-    IsPairwiseReduction = PairwiseRdxCost < SplittingRdxCost;
-    int VecReduxCost = IsPairwiseReduction ? PairwiseRdxCost : SplittingRdxCost;
-
-    int ScalarReduxCost =
-        ReduxWidth * TTI->getArithmeticInstrCost(ReductionOpcode, VecTy);
+    int VecReduxCost, ScalarReduxCost;
+    if (ReductionOpcode == Instruction::Select) {
+      // There is no target hook for min/max reductions; model it as a
+      // splitting reduction of shuffles, compares and selects.
+      Type *CmpTy = VectorType::get(Type::getInt1Ty(ScalarTy->getContext()),
+                                    ReduxWidth);
+      int MinMaxCost =
+          TTI->getCmpSelInstrCost(Instruction::ICmp, VecTy, CmpTy) +
+          TTI->getCmpSelInstrCost(Instruction::Select, VecTy, CmpTy);
+      IsPairwiseReduction = false;
+      int ShuffleCost = TTI->getShuffleCost(
+          TargetTransformInfo::SK_ExtractSubvector, VecTy, ReduxWidth / 2,
+          VecTy);
+      VecReduxCost =
+          Log2_32(ReduxWidth) * (ShuffleCost + MinMaxCost) +
+          TTI->getVectorInstrCost(Instruction::ExtractElement, VecTy, 0);
+      ScalarReduxCost = ReduxWidth * MinMaxCost;
+    } else {
+      int PairwiseRdxCost =
+          TTI->getReductionCost(ReductionOpcode, VecTy, true);
+      int SplittingRdxCost =
+          TTI->getReductionCost(ReductionOpcode, VecTy, false);
+
+      IsPairwiseReduction = PairwiseRdxCost < SplittingRdxCost;
+      VecReduxCost = IsPairwiseReduction ? PairwiseRdxCost : SplittingRdxCost;
+      ScalarReduxCost =
+          ReduxWidth * TTI->getArithmeticInstrCost(ReductionOpcode, VecTy);
+    }
 
     DEBUG(dbgs() << "SLP: Adding cost " << VecReduxCost - ScalarReduxCost
                  << " for reduction that starts with " << *FirstReducedVal
@@ -3722,11 +3899,15 @@ private:
     return VecReduxCost - ScalarReduxCost;
   }
 
-  static Value *createBinOp(IRBuilder<> &Builder, unsigned Opcode, Value *L,
-                            Value *R, const Twine &Name = "") {
-    if (Opcode == Instruction::FAdd)
-      return Builder.CreateFAdd(L, R, Name);
-    return Builder.CreateBinOp((Instruction::BinaryOps)Opcode, L, R, Name);
+  /// \brief Emit one reduction operation combining \p L and \p R.
+  Value *createRdxOp(IRBuilder<> &Builder, Value *L, Value *R,
+                     const Twine &Name = "") {
+    if (ReductionOpcode == Instruction::Select) {
+      Value *Cmp = Builder.CreateICmp(MinMaxPredicate, L, R, Name + ".cmp");
+      return Builder.CreateSelect(Cmp, L, R, Name);
+    }
+    return Builder.CreateBinOp((Instruction::BinaryOps)ReductionOpcode, L, R,
+                               Name);
   }
 
   /// \brief Emit a horizontal reduction of the vectorized value.
@@ -3748,14 +3929,13 @@ private:
         Value *RightShuf = Builder.CreateShuffleVector(
           TmpVec, UndefValue::get(TmpVec->getType()), (RightMask),
           "rdx.shuf.r");
-        TmpVec = createBinOp(Builder, ReductionOpcode, LeftShuf, RightShuf,
-                             "bin.rdx");
+        TmpVec = createRdxOp(Builder, LeftShuf, RightShuf, "bin.rdx");
       } else {
         Value *UpperHalf =
           createRdxShuffleMask(ReduxWidth, i, false, false, Builder);
         Value *Shuf = Builder.CreateShuffleVector(
           TmpVec, UndefValue::get(TmpVec->getType()), UpperHalf, "rdx.shuf");
-        TmpVec = createBinOp(Builder, ReductionOpcode, TmpVec, Shuf, "bin.rdx");
+        TmpVec = createRdxOp(Builder, TmpVec, Shuf, "bin.rdx");
       }
     }
 
@@ -3764,6 +3944,51 @@ private:
   }
 };
 
+/// \brief Get the value of a reduction PHI \p P that is computed by the
+/// reduction rooted in \p ParentBB. This is the incoming value from
+/// \p ParentBB, or, when the reduction is computed in another block of the
+/// loop, the incoming value from the loop latch.
+static Value *getReductionValue(const DominatorTree *DT, PHINode *P,
+                                BasicBlock *ParentBB, LoopInfo *LI) {
+  // There are situations where the reduction value is not dominated by the
+  // reduction phi. Vectorizing such cases has been reported to cause
+  // miscompiles.
+  Value *Rdx = nullptr;
+
+  // Return the incoming value if it comes from the same BB as the phi node.
+  if (P->getIncomingBlock(0) == ParentBB) {
+    Rdx = P->getIncomingValue(0);
+  } else if (P->getIncomingBlock(1) == ParentBB) {
+    Rdx = P->getIncomingValue(1);
+  }
+
+  Instruction *RdxI = dyn_cast_or_null<Instruction>(Rdx);
+  if (RdxI && DT->dominates(P, RdxI))
+    return Rdx;
+
+  // Otherwise, check whether we have a loop latch to look at.
+  Loop *BBL = LI->getLoopFor(ParentBB);
+  if (!BBL)
+    return nullptr;
+  BasicBlock *BBLatch = BBL->getLoopLatch();
+  if (!BBLatch)
+    return nullptr;
+
+  // There is a loop latch, return the incoming value if it comes from
+  // that. This reduction pattern occassionaly turns up.
+  if (P->getIncomingBlock(0) == BBLatch) {
+    Rdx = P->getIncomingValue(0);
+  } else if (P->getIncomingBlock(1) == BBLatch) {
+    Rdx = P->getIncomingValue(1);
+  }
+
+  RdxI = dyn_cast_or_null<Instruction>(Rdx);
+  if (RdxI && DT->dominates(P, RdxI))
+    return Rdx;
+
+  return nullptr;
+}
+
 /// \brief Recognize construction of vectors like
 ///  %ra = insertelement <4 x float> undef, float %s0, i32 0
 ///  %rb = insertelement <4 x float> %ra, float %s1, i32 1
@@ -3872,19 +4097,14 @@ bool SLPVectorizer::vectorizeChainsInBlock(BasicBlock *BB, BoUpSLP &R) {
       // Check that the PHI is a reduction PHI.
       if (P->getNumIncomingValues() != 2)
         return Changed;
-      Value *Rdx =
-          (P->getIncomingBlock(0) == BB
-               ? (P->getIncomingValue(0))
-               : (P->getIncomingBlock(1) == BB ? P->getIncomingValue(1)
-                                               : nullptr));
-      // Check if this is a Binary Operator.
-      BinaryOperator *BI = dyn_cast_or_null<BinaryOperator>(Rdx);
-      if (!BI)
+      Instruction *Rdx =
+          dyn_cast_or_null<Instruction>(getReductionValue(DT, P, BB, LI));
+      if (!Rdx)
         continue;
 
       // Try to match and vectorize a horizontal reduction.
       HorizontalReduction HorRdx;
-      if (ShouldVectorizeHor && HorRdx.matchAssociativeReduction(P, BI) &&
+      if (ShouldVectorizeHor && HorRdx.matchAssociativeReduction(P, Rdx) &&
           HorRdx.tryToReduce(R, TTI)) {
         Changed = true;
         it = BB->begin();
@@ -3892,7 +4112,12 @@ bool SLPVectorizer::vectorizeChainsInBlock(BasicBlock *BB, BoUpSLP &R) {
         continue;
       }
 
-     Value *Inst = BI->getOperand(0);
+      // Check if this is a Binary Operator.
+      BinaryOperator *BI = dyn_cast<BinaryOperator>(Rdx);
+      if (!BI)
+        continue;
+
+      Value *Inst = BI->getOperand(0);
       if (Inst == P)
         Inst = BI->getOperand(1);
 
@@ -3911,12 +4136,12 @@ bool SLPVectorizer::vectorizeChainsInBlock(BasicBlock *BB, BoUpSLP &R) {
     // Try to vectorize horizontal reductions feeding into a store.
     if (ShouldStartVectorizeHorAtStore)
       if (StoreInst *SI = dyn_cast<StoreInst>(it))
-        if (BinaryOperator *BinOp =
-                dyn_cast<BinaryOperator>(SI->getValueOperand())) {
+        if (Instruction *Rdx =
+                dyn_cast<Instruction>(SI->getValueOperand())) {
           HorizontalReduction HorRdx;
-          if (((HorRdx.matchAssociativeReduction(nullptr, BinOp) &&
+          if (((HorRdx.matchAssociativeReduction(nullptr, Rdx) &&
                 HorRdx.tryToReduce(R, TTI)) ||
-               tryToVectorize(BinOp, R))) {
+               tryToVectorize(dyn_cast<BinaryOperator>(Rdx), R))) {
             Changed = true;
             it = BB->begin();
             e = BB->end();
@@ -39,6 +39,21 @@ extern "C" {
   // Some of the entries in *data will be zero.
   uintptr_t __sanitizer_get_coverage_guards(uintptr_t **data);
 
+  // The number of 8-bit counters, if the code was instrumented with
+  // -sanitizer-coverage-8bit-counters (zero otherwise).
+  uintptr_t __sanitizer_get_number_of_counters();
+  // For every non-zero 8-bit counter, set in the matching byte of bitset,
+  // which has __sanitizer_get_number_of_counters() bytes, the bit telling
+  // how many times the block ran (1, 2, 3, 4-7, 8-15, 16-31, 32-127, 128+),
+  // and clear the counter. Returns the number of bits newly set in bitset.
+  // If bitset is null, only clears the counters.
+  uintptr_t
+  __sanitizer_update_counter_bitset_and_clear_counters(uint8_t *bitset);
+  // Called on every instrumented block with its guard, if the code was
+  // instrumented with -sanitizer-coverage-trace-pc-guard. The default
+  // definition records the coverage of the block, and can be overridden.
+  void __sanitizer_cov_trace_pc_guard(uint32_t *guard);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -27,6 +27,18 @@ u32 GetMallocContextSize() {
   return atomic_load(&malloc_context_size, memory_order_acquire);
 }
 
+u32 GetFreeContextSize() {
+  u32 size = GetMallocContextSize();
+  int rate = flags()->free_context_sample_rate;
+  if (rate <= 1 || size <= 2)
+    return size;
+  AsanThread *t = GetCurrentThread();
+  if (!t || t->takeFreeContextSample((u32)rate))
+    return size;
+  // The two innermost frames are taken without unwinding.
+  return 2;
+}
+
 }  // namespace __asan
 
 // ------------------ Interface -------------- {{{1
@@ -25,6 +25,9 @@ static const u32 kDefaultMallocContextSize = 30;
 
 void SetMallocContextSize(u32 size);
 u32 GetMallocContextSize();
+// Returns the number of frames to record for the current free: the malloc
+// context size, or less for the frees left out by free_context_sample_rate.
+u32 GetFreeContextSize();
 
 // Get the stack trace with the given pc and bp.
 // The pc will be in the position 0 of the resulting stack trace.
@@ -64,16 +67,17 @@ void GetStackTraceWithPcBpAndContext(BufferedStackTrace *stack, uptr max_depth,
 
 #define GET_STACK_TRACE(max_size, fast)                                        \
   BufferedStackTrace stack;                                                    \
-  if (max_size <= 2) {                                                         \
-    stack.size = max_size;                                                     \
-    if (max_size > 0) {                                                        \
+  uptr stack_max_size = (max_size);                                            \
+  if (stack_max_size <= 2) {                                                   \
+    stack.size = stack_max_size;                                               \
+    if (stack_max_size > 0) {                                                  \
       stack.top_frame_bp = GET_CURRENT_FRAME();                                \
       stack.trace_buffer[0] = StackTrace::GetCurrentPc();                      \
-      if (max_size > 1)                                                        \
+      if (stack_max_size > 1)                                                  \
         stack.trace_buffer[1] = GET_CALLER_PC();                               \
     }                                                                          \
   } else {                                                                     \
-    GetStackTraceWithPcBpAndContext(&stack, max_size,                          \
+    GetStackTraceWithPcBpAndContext(&stack, stack_max_size,                    \
                                     StackTrace::GetCurrentPc(),                \
                                     GET_CURRENT_FRAME(), 0, fast);             \
   }
@@ -101,7 +105,8 @@ void GetStackTraceWithPcBpAndContext(BufferedStackTrace *stack, uptr max_depth,
 #define GET_STACK_TRACE_MALLOC                                                 \
   GET_STACK_TRACE(GetMallocContextSize(), common_flags()->fast_unwind_on_malloc)
 
-#define GET_STACK_TRACE_FREE GET_STACK_TRACE_MALLOC
+#define GET_STACK_TRACE_FREE                                                   \
+  GET_STACK_TRACE(GetFreeContextSize(), common_flags()->fast_unwind_on_malloc)
 
 #define PRINT_CURRENT_STACK()   \
   {                             \
@@ -114,6 +114,15 @@ class AsanThread {
   bool isInDeadlySignal() const { return in_deadly_signal_; }
   void setInDeadlySignal(bool b) { in_deadly_signal_ = b; }
 
+  // True once every 'rate' calls: the free that should record its full stack
+  // when free_context_sample_rate is in effect.
+  bool takeFreeContextSample(u32 rate) {
+    if (++frees_since_sample_ < rate)
+      return false;
+    frees_since_sample_ = 0;
+    return true;
+  }
+
   AsanThreadLocalMallocStorage &malloc_storage() { return malloc_storage_; }
   AsanStats &stats() { return stats_; }
 
@@ -140,6 +149,7 @@ class AsanThread {
   AsanStats stats_;
   bool unwinding_;
   bool in_deadly_signal_;
+  u32 frees_since_sample_;
 };
 
 // ScopedUnwinding is a scope for stacktracing member of a context
@@ -115,6 +115,39 @@ u32 ChainedOriginDepotGet(u32 id, u32 *other) {
   return desc.here_id;
 }
 
+struct ChainedOriginCacheEntry {
+  u32 here_id;
+  u32 prev_id;
+  u32 id;
+};
+
+static const uptr kChainedOriginCacheSize = 64;
+
+// Zero-initialized; here_id 0 is never a valid stack id, so neither is a hit.
+static THREADLOCAL ChainedOriginCacheEntry
+    chained_origin_cache[kChainedOriginCacheSize];
+
+static ChainedOriginCacheEntry *ChainedOriginCacheLookup(u32 here_id,
+                                                         u32 prev_id) {
+  ChainedOriginDepotDesc desc = {here_id, prev_id};
+  u32 h = ChainedOriginDepotNode::hash(desc);
+  return &chained_origin_cache[h % kChainedOriginCacheSize];
+}
+
+bool ChainedOriginCacheGet(u32 here_id, u32 prev_id, u32 *id) {
+  ChainedOriginCacheEntry *e = ChainedOriginCacheLookup(here_id, prev_id);
+  if (e->here_id != here_id || e->prev_id != prev_id) return false;
+  *id = e->id;
+  return true;
+}
+
+void ChainedOriginCachePut(u32 here_id, u32 prev_id, u32 id) {
+  ChainedOriginCacheEntry *e = ChainedOriginCacheLookup(here_id, prev_id);
+  e->here_id = here_id;
+  e->prev_id = prev_id;
+  e->id = id;
+}
+
 void ChainedOriginDepotLockAll() {
   chainedOriginDepot.LockAll();
 }
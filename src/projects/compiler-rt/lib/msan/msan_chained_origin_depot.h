@@ -21,6 +21,12 @@ bool ChainedOriginDepotPut(u32 here_id, u32 prev_id, u32 *new_id);
 // Retrieves a stored stack trace by the id.
 u32 ChainedOriginDepotGet(u32 id, u32 *other);
 
+// A small per-thread cache of the origin ids recently made by chaining the
+// event here_id onto prev_id. It lets repeated stores of the same value from
+// the same place skip the depot.
+bool ChainedOriginCacheGet(u32 here_id, u32 prev_id, u32 *id);
+void ChainedOriginCachePut(u32 here_id, u32 prev_id, u32 id);
+
 void ChainedOriginDepotLockAll();
 void ChainedOriginDepotUnlockAll();
 
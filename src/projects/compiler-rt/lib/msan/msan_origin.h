@@ -128,6 +128,10 @@ class Origin {
       if (use_count > flags()->origin_history_per_stack_limit) return prev;
     }
 
+    u32 cached_id;
+    if (ChainedOriginCacheGet(h.id(), prev.raw_id(), &cached_id))
+      return Origin(cached_id);
+
     u32 chained_id;
     bool inserted = ChainedOriginDepotPut(h.id(), prev.raw_id(), &chained_id);
     CHECK((chained_id & kChainedIdMask) == chained_id);
@@ -135,7 +139,13 @@ class Origin {
     if (inserted && flags()->origin_history_per_stack_limit > 0)
       h.inc_use_count_unsafe();
 
-    return Origin((1 << kHeapShift) | (depth << kDepthShift) | chained_id);
+    Origin chained((1 << kHeapShift) | (depth << kDepthShift) | chained_id);
+    ChainedOriginCachePut(h.id(), prev.raw_id(), chained.raw_id());
+    // A value stored again from the same stack keeps its origin instead of
+    // growing the chain (and the depot) with an identical event.
+    if (flags()->dedup_chained_origins)
+      ChainedOriginCachePut(h.id(), chained.raw_id(), chained.raw_id());
+    return chained;
   }
 
   static Origin FromRawId(u32 id) {
@@ -29,6 +29,8 @@
 #include <sys/file.h>
 #ifdef _WIN32
 #include <direct.h>
+#else
+#include <unistd.h>
 #endif
 
 #define I386_FREEBSD (defined(__FreeBSD__) && defined(__i386__))
@@ -72,7 +74,10 @@ static char *filename = NULL;
 static FILE *output_file = NULL;
 
 /*
- * Buffer that we write things into.
+ * Buffer that we write things into. For an existing file, this is the file
+ * mapped into memory, which gets its counters merged in place, until the new
+ * data outgrows it. Otherwise it's on the heap and gets written out in one go
+ * by llvm_gcda_end_file.
  */
 #define WRITE_BUFFER_SIZE (128 * 1024)
 static char *write_buffer = NULL;
@@ -80,6 +85,7 @@ static uint64_t cur_buffer_size = 0;
 static uint64_t cur_pos = 0;
 static uint64_t file_size = 0;
 static int new_file = 0;
+static int buffer_is_mapped = 0;
 static int fd = -1;
 
 /*
@@ -109,12 +115,21 @@ static struct flush_fn_node *flush_fn_head = NULL;
 static struct flush_fn_node *flush_fn_tail = NULL;
 
 static void resize_write_buffer(uint64_t size) {
-  if (!new_file) return;
   size += cur_pos;
   if (size <= cur_buffer_size) return;
   size = (size - 1) / WRITE_BUFFER_SIZE + 1;
   size *= WRITE_BUFFER_SIZE;
-  write_buffer = realloc(write_buffer, size);
+  if (buffer_is_mapped) {
+    /* The file is too small for the new data: move what's left to read of it
+     * to the heap, and rewrite the whole file at the end. */
+    char *new_buffer = malloc(size);
+    memcpy(new_buffer, write_buffer, file_size);
+    (void)munmap(write_buffer, file_size);
+    write_buffer = new_buffer;
+    buffer_is_mapped = 0;
+  } else {
+    write_buffer = realloc(write_buffer, size);
+  }
   cur_buffer_size = size;
 }
 
@@ -146,7 +161,7 @@ static void write_string(const char *s) {
 static uint32_t read_32bit_value() {
   uint32_t val;
 
-  if (new_file)
+  if (new_file || cur_pos + 4 > file_size)
     return (uint32_t)-1;
 
   val = *(uint32_t*)&write_buffer[cur_pos];
@@ -157,7 +172,7 @@ static uint32_t read_32bit_value() {
 static uint64_t read_64bit_value() {
   uint64_t val;
 
-  if (new_file)
+  if (new_file || cur_pos + 8 > file_size)
     return (uint64_t)-1;
 
   val = *(uint64_t*)&write_buffer[cur_pos];
@@ -241,6 +256,8 @@ static int map_file() {
             strerror(errnum));
     return -1;
   }
+  buffer_is_mapped = 1;
+  cur_buffer_size = file_size;
   return 0;
 }
 
@@ -255,8 +272,7 @@ static void unmap_file() {
    * is written and we don't care.
    */
   (void)munmap(write_buffer, file_size);
-  write_buffer = NULL;
-  file_size = 0;
+  buffer_is_mapped = 0;
 }
 
 /*
@@ -306,6 +322,8 @@ void llvm_gcda_start_file(const char *orig_filename, const char version[4],
   write_buffer = NULL;
   cur_buffer_size = 0;
   cur_pos = 0;
+  file_size = 0;
+  buffer_is_mapped = 0;
 
   if (new_file) {
     resize_write_buffer(WRITE_BUFFER_SIZE);
@@ -316,6 +334,7 @@ void llvm_gcda_start_file(const char *orig_filename, const char version[4],
       new_file = 1;
       write_buffer = NULL;
       cur_buffer_size = 0;
+      file_size = 0;
       resize_write_buffer(WRITE_BUFFER_SIZE);
       memset(write_buffer, 0, WRITE_BUFFER_SIZE);
     }
@@ -491,11 +510,15 @@ void llvm_gcda_end_file() {
   if (output_file) {
     write_bytes("\0\0\0\0\0\0\0\0", 8);
 
-    if (new_file) {
+    if (buffer_is_mapped) {
+      unmap_file();
+      /* Drop whatever is left of the old data past the new. */
+      if (cur_pos < file_size)
+        (void)ftruncate(fd, cur_pos);
+    } else {
+      fseek(output_file, 0L, SEEK_SET);
       fwrite(write_buffer, cur_pos, 1, output_file);
       free(write_buffer);
-    } else {
-      unmap_file();
     }
 
     fclose(output_file);
@@ -8,6 +8,7 @@
 \*===----------------------------------------------------------------------===*/
 
 #include "InstrProfiling.h"
+#include "InstrProfilingInternal.h"
 #include <string.h>
 
 __attribute__((visibility("hidden")))
@@ -36,7 +37,7 @@ uint64_t __llvm_profile_get_magic(void) {
 __attribute__((visibility("hidden")))
 uint64_t __llvm_profile_get_version(void) {
   /* This should be bumped any time the output format changes. */
-  return 1;
+  return 2;
 }
 
 __attribute__((visibility("hidden")))
@@ -45,4 +46,6 @@ void __llvm_profile_reset_counters(void) {
   uint64_t *E = __llvm_profile_end_counters();
 
   memset(I, 0, sizeof(uint64_t)*(E - I));
+  __llvm_profile_reset_value_data(__llvm_profile_begin_data(),
+                                  __llvm_profile_end_data());
 }
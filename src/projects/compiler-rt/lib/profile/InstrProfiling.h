@@ -27,7 +27,7 @@ typedef uint32_t uintptr_t;
 
 #endif /* defined(__FreeBSD__) && defined(__i386__) */
 
-#define PROFILE_HEADER_SIZE 7
+#define PROFILE_HEADER_SIZE 8
 
 typedef struct __llvm_profile_data {
   const uint32_t NameSize;
@@ -35,8 +35,21 @@ typedef struct __llvm_profile_data {
   const uint64_t FuncHash;
   const char *const Name;
   uint64_t *const Counters;
+  const void *const FunctionPointer;
+  void *Values;
+  const uint64_t NumValueSites;
 } __llvm_profile_data;
 
+/*!
+ * \brief Record that the indirect call at site \c CounterIndex of \c Data
+ * called \c TargetValue.
+ *
+ * Calls to this are emitted by the -instrprof pass for the
+ * llvm.instrprof_value_profile intrinsic.
+ */
+void __llvm_profile_instrument_target(uint64_t TargetValue, void *Data,
+                                      uint32_t CounterIndex);
+
 /*!
  * \brief Get required size for profile buffer.
  */
@@ -62,10 +75,26 @@ uint64_t *__llvm_profile_end_counters(void);
  *
  * Writes to the file with the last name given to \a __llvm_profile_set_filename(),
  * or if it hasn't been called, the \c LLVM_PROFILE_FILE environment variable,
- * or if that's not set, \c "default.profdata".
+ * or if that's not set, \c "default.profdata".  In continuous mode, this takes
+ * a snapshot with \a __llvm_profile_snapshot_file() instead.
  */
 int __llvm_profile_write_file(void);
 
+/*!
+ * \brief Copy the current counters into the profile file.
+ *
+ * Only works in continuous mode, which the \c LLVM_PROFILE_CONTINUOUS
+ * environment variable turns on: the profile is then written to the file at
+ * startup, and the counters in the file are kept in a shared mapping, so that
+ * a snapshot is just a copy to memory and can be taken often, for instance
+ * from a signal handler.  If \c LLVM_PROFILE_CONTINUOUS is a number of
+ * seconds and the program uses threads, a thread takes a snapshot at that
+ * interval.  Value profile data is only written at startup.
+ *
+ * Returns 0 on success, or -1 if not in continuous mode.
+ */
+int __llvm_profile_snapshot_file(void);
+
 /*!
  * \brief Set the filename for writing instrumentation data.
  *
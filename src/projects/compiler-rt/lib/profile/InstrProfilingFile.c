@@ -8,10 +8,15 @@
 \*===----------------------------------------------------------------------===*/
 
 #include "InstrProfiling.h"
+#include "InstrProfilingInternal.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <pthread.h>
+#include <signal.h>
 #include <string.h>
 #include <sys/errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #define UNCONST(ptr) ((void *)(uintptr_t)(ptr))
 
@@ -33,6 +38,18 @@ static int writeFile(FILE *File) {
   /* Enough zeroes for padding. */
   const char Zeroes[sizeof(uint64_t)] = {0};
 
+  /* Take a snapshot of the value data, whose size is in the header. */
+  const uint64_t ValueDataSize =
+      __llvm_profile_get_value_data_size(DataBegin, DataEnd);
+  uint64_t *ValueData = NULL;
+  if (ValueDataSize) {
+    ValueData = (uint64_t *)malloc(ValueDataSize);
+    if (!ValueData)
+      return -1;
+    __llvm_profile_write_value_data(ValueData, ValueDataSize, DataBegin,
+                                    DataEnd);
+  }
+
   /* Create the header. */
   uint64_t Header[PROFILE_HEADER_SIZE];
   Header[0] = __llvm_profile_get_magic();
@@ -42,18 +59,122 @@ static int writeFile(FILE *File) {
   Header[4] = NamesSize;
   Header[5] = (uintptr_t)CountersBegin;
   Header[6] = (uintptr_t)NamesBegin;
+  Header[7] = ValueDataSize;
 
   /* Write the data. */
 #define CHECK_fwrite(Data, Size, Length, File) \
-  do { if (fwrite(Data, Size, Length, File) != Length) return -1; } while (0)
+  do { if (fwrite(Data, Size, Length, File) != Length) goto fail; } while (0)
   CHECK_fwrite(Header,        sizeof(uint64_t), PROFILE_HEADER_SIZE, File);
   CHECK_fwrite(DataBegin,     sizeof(__llvm_profile_data), DataSize, File);
   CHECK_fwrite(CountersBegin, sizeof(uint64_t), CountersSize, File);
   CHECK_fwrite(NamesBegin,    sizeof(char), NamesSize, File);
   CHECK_fwrite(Zeroes,        sizeof(char), Padding, File);
+  CHECK_fwrite(ValueData,     sizeof(char), ValueDataSize, File);
 #undef CHECK_fwrite
 
+  free(ValueData);
+  return 0;
+
+fail:
+  free(ValueData);
+  return -1;
+}
+
+/* In continuous mode, the counters of the profile that this image wrote to
+ * the file when it started, in a shared mapping of the file.  Copying the
+ * counters there updates the file without any I/O on our side.
+ */
+static uint64_t *volatile ContinuousCounters = NULL;
+static int ContinuousMode = 0;
+static unsigned ContinuousInterval = 0;
+
+static int startContinuousMode(const char *OutputName) {
+  const uint64_t CountersSize = (__llvm_profile_end_counters() -
+                                 __llvm_profile_begin_counters()) *
+                                sizeof(uint64_t);
+  const uint64_t DataSize =
+      __llvm_profile_end_data() - __llvm_profile_begin_data();
+  if (!OutputName || !OutputName[0] || !CountersSize)
+    return -1;
+
+  /* Other images may have written their profiles already; ours starts where
+   * the file ends.  mmap needs the file to be open for reading too.
+   */
+  FILE *File = fopen(OutputName, "a+");
+  if (!File)
+    return -1;
+  long Offset;
+  if (fseek(File, 0, SEEK_END) || (Offset = ftell(File)) < 0) {
+    fclose(File);
+    return -1;
+  }
+  if (writeFile(File) || fflush(File))
+    goto fail;
+
+  const uint64_t CountersOffset = Offset +
+                                  PROFILE_HEADER_SIZE * sizeof(uint64_t) +
+                                  DataSize * sizeof(__llvm_profile_data);
+  const uint64_t MapOffset = CountersOffset & ~((uint64_t)getpagesize() - 1);
+  char *Map = (char *)mmap(NULL, CountersOffset - MapOffset + CountersSize,
+                           PROT_READ | PROT_WRITE, MAP_SHARED, fileno(File),
+                           MapOffset);
+  if (Map == MAP_FAILED)
+    goto fail;
+  fclose(File);
+
+  /* A mapping of a file we no longer write to is left alone: another thread
+   * may still be copying counters into it.
+   */
+  ContinuousCounters = (uint64_t *)(Map + (CountersOffset - MapOffset));
   return 0;
+
+fail:
+  /* Drop what we wrote, so that the profile isn't written twice at exit. */
+  (void)ftruncate(fileno(File), Offset);
+  fclose(File);
+  return -1;
+}
+
+/* Only programs using threads get a thread taking snapshots. */
+#pragma weak pthread_create
+#pragma weak pthread_detach
+#pragma weak pthread_sigmask
+
+static void *snapshotPeriodically(void *Arg) {
+  for (;;) {
+    sleep(ContinuousInterval);
+    __llvm_profile_snapshot_file();
+  }
+  return NULL;
+}
+
+static void startSnapshotThread(void) {
+  if (!ContinuousInterval || !pthread_create || !pthread_sigmask)
+    return;
+
+  /* Leave the signals of the program to its own threads. */
+  sigset_t Blocked, Saved;
+  sigfillset(&Blocked);
+  pthread_sigmask(SIG_SETMASK, &Blocked, &Saved);
+  pthread_t Thread;
+  if (!pthread_create(&Thread, NULL, snapshotPeriodically, NULL))
+    pthread_detach(Thread);
+  pthread_sigmask(SIG_SETMASK, &Saved, NULL);
+}
+
+static void reportContinuousModeFailure(const char *OutputName) {
+  if (getenv("LLVM_PROFILE_VERBOSE_ERRORS"))
+    fprintf(stderr, "LLVM Profile: Failed to map file \"%s\": %s\n",
+            OutputName, strerror(errno));
+}
+
+static void setContinuousModeFromEnvironment(void) {
+  const char *Interval = getenv("LLVM_PROFILE_CONTINUOUS");
+  if (!Interval || !Interval[0])
+    return;
+
+  ContinuousMode = 1;
+  ContinuousInterval = (unsigned)atoi(Interval);
 }
 
 static int writeFileWithName(const char *OutputName) {
@@ -98,7 +219,6 @@ static void truncateCurrentFile(void) {
 
 static void setDefaultFilename(void) { setFilename("default.profraw", 0); }
 
-int getpid(void);
 static int setFilenameFromEnvironment(void) {
   const char *Filename = getenv("LLVM_PROFILE_FILE");
   if (!Filename || !Filename[0])
@@ -161,16 +281,49 @@ void __llvm_profile_initialize_file(void) {
   /* Detect the filename and truncate. */
   setFilenameAutomatically();
   truncateCurrentFile();
+
+  setContinuousModeFromEnvironment();
+  if (!ContinuousMode)
+    return;
+  if (startContinuousMode(__llvm_profile_CurrentFilename)) {
+    reportContinuousModeFailure(__llvm_profile_CurrentFilename);
+    return;
+  }
+  startSnapshotThread();
 }
 
 __attribute__((visibility("hidden")))
 void __llvm_profile_set_filename(const char *Filename) {
   setFilename(Filename, 0);
   truncateCurrentFile();
+
+  /* Move the snapshots to the new file, or write it at exit if we can't. */
+  if (ContinuousMode && startContinuousMode(Filename)) {
+    ContinuousCounters = NULL;
+    if (Filename)
+      reportContinuousModeFailure(Filename);
+  }
+}
+
+__attribute__((visibility("hidden")))
+int __llvm_profile_snapshot_file(void) {
+  uint64_t *Counters = ContinuousCounters;
+  if (!Counters)
+    return -1;
+
+  const uint64_t *CountersBegin = __llvm_profile_begin_counters();
+  const uint64_t *CountersEnd = __llvm_profile_end_counters();
+  memcpy(Counters, CountersBegin,
+         (CountersEnd - CountersBegin) * sizeof(uint64_t));
+  return 0;
 }
 
 __attribute__((visibility("hidden")))
 int __llvm_profile_write_file(void) {
+  /* In continuous mode the profile is already in the file. */
+  if (ContinuousCounters)
+    return __llvm_profile_snapshot_file();
+
   /* Check the filename. */
   if (!__llvm_profile_CurrentFilename)
     return -1;
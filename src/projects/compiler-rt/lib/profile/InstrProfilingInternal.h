@@ -37,4 +37,28 @@ int __llvm_profile_write_buffer_internal(
     const __llvm_profile_data *DataEnd, const uint64_t *CountersBegin,
     const uint64_t *CountersEnd, const char *NamesBegin, const char *NamesEnd);
 
+/*!
+ * \brief Get the size in bytes of the value profile data of the functions in
+ * [\c DataBegin, \c DataEnd).
+ */
+uint64_t
+__llvm_profile_get_value_data_size(const __llvm_profile_data *DataBegin,
+                                   const __llvm_profile_data *DataEnd);
+
+/*!
+ * \brief Write the value profile data of the functions in [\c DataBegin,
+ * \c DataEnd) to \c Buffer, which holds \c Size bytes, as returned by
+ * \a __llvm_profile_get_value_data_size().
+ *
+ * Values recorded after the size was taken are left out, so that the data
+ * stays well-formed while other threads keep running.
+ */
+void __llvm_profile_write_value_data(uint64_t *Buffer, uint64_t Size,
+                                     const __llvm_profile_data *DataBegin,
+                                     const __llvm_profile_data *DataEnd);
+
+/*! \brief Reset the counts of all values recorded so far. */
+void __llvm_profile_reset_value_data(const __llvm_profile_data *DataBegin,
+                                     const __llvm_profile_data *DataEnd);
+
 #endif
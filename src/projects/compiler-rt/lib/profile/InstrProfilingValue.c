@@ -0,0 +1,147 @@
+/*===- InstrProfilingValue.c - Support library for value profiling --------===*\
+|*
+|*                     The LLVM Compiler Infrastructure
+|*
+|* This file is distributed under the University of Illinois Open Source
+|* License. See LICENSE.TXT for details.
+|*
+\*===----------------------------------------------------------------------===*/
+
+#include "InstrProfiling.h"
+#include "InstrProfilingInternal.h"
+#include <stdlib.h>
+
+/* The number of distinct targets recorded per value site. The targets after
+ * them are rare enough that promotion wouldn't pay off, and dropping them keeps
+ * the per-call cost bounded.
+ */
+#define MAX_VALUES_PER_SITE 16
+
+/* Each value site is a singly linked list of the targets seen there, in the
+ * order in which they were first seen. Nodes are only ever appended, with a
+ * compare and swap, so readers can walk the lists without a lock.
+ */
+typedef struct ValueProfNode {
+  uint64_t Value;
+  uint64_t Count;
+  struct ValueProfNode *Next;
+} ValueProfNode;
+
+static ValueProfNode **getValueSites(__llvm_profile_data *Data) {
+  ValueProfNode **Sites = (ValueProfNode **)Data->Values;
+  if (Sites)
+    return Sites;
+
+  Sites =
+      (ValueProfNode **)calloc(Data->NumValueSites, sizeof(ValueProfNode *));
+  if (!Sites)
+    return NULL;
+  if (!__sync_bool_compare_and_swap(&Data->Values, NULL, Sites)) {
+    /* Another thread got there first. */
+    free(Sites);
+    Sites = (ValueProfNode **)Data->Values;
+  }
+  return Sites;
+}
+
+__attribute__((visibility("hidden")))
+void __llvm_profile_instrument_target(uint64_t TargetValue, void *Data_,
+                                      uint32_t CounterIndex) {
+  __llvm_profile_data *Data = (__llvm_profile_data *)Data_;
+  ValueProfNode **Sites, **Tail, *Node, *New;
+  unsigned NumValues = 0;
+  if (CounterIndex >= Data->NumValueSites)
+    return;
+  Sites = getValueSites(Data);
+  if (!Sites)
+    return;
+
+  /* Like the counters, the counts are updated without synchronization. */
+  Tail = &Sites[CounterIndex];
+  for (Node = *Tail; Node; Node = *Tail) {
+    if (Node->Value == TargetValue) {
+      ++Node->Count;
+      return;
+    }
+    Tail = &Node->Next;
+    ++NumValues;
+  }
+  if (NumValues >= MAX_VALUES_PER_SITE)
+    return;
+
+  New = (ValueProfNode *)calloc(1, sizeof(ValueProfNode));
+  if (!New)
+    return;
+  New->Value = TargetValue;
+  New->Count = 1;
+  /* A racing thread appended a node of its own; this call is dropped. */
+  if (!__sync_bool_compare_and_swap(Tail, NULL, New))
+    free(New);
+}
+
+__attribute__((visibility("hidden")))
+uint64_t
+__llvm_profile_get_value_data_size(const __llvm_profile_data *DataBegin,
+                                   const __llvm_profile_data *DataEnd) {
+  const __llvm_profile_data *I;
+  uint64_t Size = 0;
+  for (I = DataBegin; I != DataEnd; ++I) {
+    ValueProfNode **Sites = (ValueProfNode **)I->Values;
+    uint64_t S;
+    /* The number of values at each site, and the pairs of target and count. */
+    Size += I->NumValueSites;
+    if (!Sites)
+      continue;
+    for (S = 0; S < I->NumValueSites; ++S) {
+      const ValueProfNode *Node;
+      for (Node = Sites[S]; Node; Node = Node->Next)
+        Size += 2;
+    }
+  }
+  return Size * sizeof(uint64_t);
+}
+
+__attribute__((visibility("hidden")))
+void __llvm_profile_write_value_data(uint64_t *Buffer, uint64_t Size,
+                                     const __llvm_profile_data *DataBegin,
+                                     const __llvm_profile_data *DataEnd) {
+  const __llvm_profile_data *I;
+  uint64_t NumSites = 0, Budget;
+  for (I = DataBegin; I != DataEnd; ++I)
+    NumSites += I->NumValueSites;
+  /* The number of pairs that fit next to the number of values of each site. */
+  Budget = (Size / sizeof(uint64_t) - NumSites) / 2;
+
+  for (I = DataBegin; I != DataEnd; ++I) {
+    ValueProfNode **Sites = (ValueProfNode **)I->Values;
+    uint64_t S;
+    for (S = 0; S < I->NumValueSites; ++S) {
+      uint64_t *NumValues = Buffer++;
+      const ValueProfNode *Node;
+      *NumValues = 0;
+      for (Node = Sites ? Sites[S] : NULL; Node && Budget;
+           Node = Node->Next, --Budget) {
+        *Buffer++ = Node->Value;
+        *Buffer++ = Node->Count;
+        ++*NumValues;
+      }
+    }
+  }
+}
+
+__attribute__((visibility("hidden")))
+void __llvm_profile_reset_value_data(const __llvm_profile_data *DataBegin,
+                                     const __llvm_profile_data *DataEnd) {
+  const __llvm_profile_data *I;
+  for (I = DataBegin; I != DataEnd; ++I) {
+    ValueProfNode **Sites = (ValueProfNode **)I->Values;
+    uint64_t S;
+    if (!Sites)
+      continue;
+    for (S = 0; S < I->NumValueSites; ++S) {
+      ValueProfNode *Node;
+      for (Node = Sites[S]; Node; Node = Node->Next)
+        Node->Count = 0;
+    }
+  }
+}
@@ -19,6 +19,12 @@
 // to consecutive negative numbers (-1, -2, -3, ...).
 // It's fine to call __sanitizer_cov more than once for a given block.
 //
+// With -sanitizer-coverage-8bit-counters the compiler also increments an
+// 8-bit counter of each block inline, and registers the counters of the
+// module with __sanitizer_cov_8bit_counters_init. With
+// -sanitizer-coverage-trace-pc-guard it calls __sanitizer_cov_trace_pc_guard
+// on every block instead of checking the guard.
+//
 // Run-time:
 //  - __sanitizer_cov(): record that we've executed the PC (GET_CALLER_PC).
 //    and atomically set Guard to -Guard.
@@ -85,6 +91,10 @@ class CoverageData {
   void InitializeGuards(s32 *guards, uptr n);
   void ReinitializeGuards();
 
+  void Initialize8bitCounters(u8 *counters, uptr n);
+  uptr GetNumberOf8bitCounters();
+  uptr Update8bitCounterBitsetAndClearCounters(u8 *bitset);
+
   uptr *data();
   uptr size();
 
@@ -110,6 +120,15 @@ class CoverageData {
   // Vector of coverage guard arrays, protected by mu.
   InternalMmapVectorNoCtor<s32*> guard_array_vec;
 
+  // Vector of the 8-bit counter arrays of the modules and their total size,
+  // protected by mu.
+  struct CounterArray {
+    u8 *counters;
+    uptr n;
+  };
+  InternalMmapVectorNoCtor<CounterArray> counter_array_vec;
+  uptr num_8bit_counters;
+
   // Caller-Callee (cc) array, size and current index.
   static const uptr kCcArrayMaxSize = FIRST_32_SECOND_64(1 << 18, 1 << 24);
   uptr **cc_array;
@@ -296,6 +315,69 @@ void CoverageData::InitializeGuards(s32 *guards, uptr n) {
   guard_array_vec.push_back(guards);
 }
 
+void CoverageData::Initialize8bitCounters(u8 *counters, uptr n) {
+  SpinMutexLock l(&mu);
+  CounterArray array = {counters, n};
+  counter_array_vec.push_back(array);
+  num_8bit_counters += n;
+}
+
+uptr CoverageData::GetNumberOf8bitCounters() {
+  SpinMutexLock l(&mu);
+  return num_8bit_counters;
+}
+
+// Maps a counter value to one of 8 bits, so that the bitset tells apart a
+// block that ran 1, 2, 3, 4-7, 8-15, 16-31, 32-127 or 128+ times.
+static u8 CounterToBit(u8 counter) {
+  if (counter >= 128) return 128;
+  if (counter >= 32) return 64;
+  if (counter >= 16) return 32;
+  if (counter >= 8) return 16;
+  if (counter >= 4) return 8;
+  if (counter >= 3) return 4;
+  if (counter >= 2) return 2;
+  return 1;
+}
+
+// Ors the bit of every non-zero counter into the matching byte of bitset,
+// which has GetNumberOf8bitCounters() bytes, and clears the counters.
+// Returns the number of bits that were newly set. With a null bitset, only
+// clears the counters.
+uptr CoverageData::Update8bitCounterBitsetAndClearCounters(u8 *bitset) {
+  SpinMutexLock l(&mu);
+  uptr num_new_bits = 0;
+  uptr bitset_idx = 0;
+  for (uptr i = 0; i < counter_array_vec.size(); i++) {
+    u8 *counters = counter_array_vec[i].counters;
+    uptr n = counter_array_vec[i].n;
+    if (!bitset) {
+      internal_memset(counters, 0, n);
+      continue;
+    }
+    for (uptr j = 0; j < n; j++, bitset_idx++) {
+      // Most counters stay zero: skip them a word at a time.
+      if ((reinterpret_cast<uptr>(&counters[j]) % sizeof(uptr)) == 0) {
+        while (j + sizeof(uptr) <= n &&
+               *reinterpret_cast<uptr *>(&counters[j]) == 0) {
+          j += sizeof(uptr);
+          bitset_idx += sizeof(uptr);
+        }
+        if (j == n) break;
+      }
+      u8 counter = counters[j];
+      if (!counter) continue;
+      counters[j] = 0;
+      u8 bit = CounterToBit(counter);
+      if (!(bitset[bitset_idx] & bit)) {
+        bitset[bitset_idx] |= bit;
+        num_new_bits++;
+      }
+    }
+  }
+  return num_new_bits;
+}
+
 // If guard is negative, atomically set it to -guard and store the PC in
 // pc_array.
 void CoverageData::Add(uptr pc, u32 *guard) {
@@ -664,6 +746,12 @@ SANITIZER_INTERFACE_ATTRIBUTE void __sanitizer_cov_with_check(u32 *guard) {
   if (__sanitizer::atomic_load(atomic_guard, memory_order_relaxed))
     __sanitizer_cov(guard);
 }
+// Fuzzers may override this to get a call on every instrumented block.
+SANITIZER_INTERFACE_ATTRIBUTE SANITIZER_WEAK_ATTRIBUTE void
+__sanitizer_cov_trace_pc_guard(u32 *guard) {
+  coverage_data.Add(StackTrace::GetPreviousInstructionPc(GET_CALLER_PC()),
+                    guard);
+}
 SANITIZER_INTERFACE_ATTRIBUTE void
 __sanitizer_cov_indir_call16(uptr callee, uptr callee_cache16[]) {
   coverage_data.IndirCall(StackTrace::GetPreviousInstructionPc(GET_CALLER_PC()),
@@ -686,6 +774,10 @@ SANITIZER_INTERFACE_ATTRIBUTE void __sanitizer_cov_module_init(s32 *guards,
   }
   coverage_data.Extend(npcs);
 }
+SANITIZER_INTERFACE_ATTRIBUTE void
+__sanitizer_cov_8bit_counters_init(u8 *counters, uptr n) {
+  coverage_data.Initialize8bitCounters(counters, n);
+}
 SANITIZER_INTERFACE_ATTRIBUTE
 sptr __sanitizer_maybe_open_cov_file(const char *name) {
   return MaybeOpenCovFile(name);
@@ -715,4 +807,12 @@ uptr __sanitizer_get_coverage_guards(uptr **data) {
   *data = coverage_data.data();
   return coverage_data.size();
 }
+SANITIZER_INTERFACE_ATTRIBUTE
+uptr __sanitizer_get_number_of_counters() {
+  return coverage_data.GetNumberOf8bitCounters();
+}
+SANITIZER_INTERFACE_ATTRIBUTE
+uptr __sanitizer_update_counter_bitset_and_clear_counters(u8 *bitset) {
+  return coverage_data.Update8bitCounterBitsetAndClearCounters(bitset);
+}
 }  // extern "C"
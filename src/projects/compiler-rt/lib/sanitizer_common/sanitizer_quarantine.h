@@ -9,8 +9,9 @@
 //
 // Memory quarantine for AddressSanitizer and potentially other tools.
 // Quarantine caches some specified amount of memory in per-thread caches,
-// then evicts to global FIFO queue. When the queue reaches specified threshold,
-// oldest memory is recycled.
+// then hands it off to a global lock-free stack. When the quarantine reaches
+// specified threshold, the stack is moved to a FIFO queue and the oldest
+// memory is recycled.
 //
 //===----------------------------------------------------------------------===//
 
@@ -18,6 +19,7 @@
 #define SANITIZER_QUARANTINE_H
 
 #include "sanitizer_internal_defs.h"
+#include "sanitizer_common.h"
 #include "sanitizer_mutex.h"
 #include "sanitizer_list.h"
 
@@ -44,8 +46,7 @@ class Quarantine {
  public:
   typedef QuarantineCache<Callback> Cache;
 
-  explicit Quarantine(LinkerInitialized)
-      : cache_(LINKER_INITIALIZED) {
+  explicit Quarantine(LinkerInitialized) {
   }
 
   void Init(uptr size, uptr cache_size) {
@@ -63,13 +64,43 @@ class Quarantine {
       Drain(c, cb);
   }
 
+  // Hands the batches of c off to the global queue without taking a lock,
+  // then recycles the oldest memory if the quarantine grew too large.
   void NOINLINE Drain(Cache *c, Callback cb) {
-    {
-      SpinMutexLock l(&cache_mutex_);
-      cache_.Transfer(c);
+    uptr size = c->Size();
+    QuarantineBatch *last;
+    if (QuarantineBatch *first = c->ExtractBatches(&last)) {
+      // Account for the batches first, so that the recycler never sees them
+      // before their size.
+      atomic_fetch_add(&size_, size, memory_order_relaxed);
+      uptr head = atomic_load(&handoff_, memory_order_relaxed);
+      for (;;) {
+        last->next = (QuarantineBatch *)head;
+        if (atomic_compare_exchange_weak(&handoff_, &head, (uptr)first,
+                                         memory_order_release))
+          break;
+        atomic_fetch_add(&handoff_retries_, 1, memory_order_relaxed);
+      }
+      atomic_fetch_add(&handoffs_, 1, memory_order_relaxed);
+    }
+    if (atomic_load(&size_, memory_order_relaxed) > GetSize()) {
+      if (recycle_mutex_.TryLock())
+        Recycle(cb);
+      else
+        atomic_fetch_add(&busy_recycles_, 1, memory_order_relaxed);
     }
-    if (cache_.Size() > GetSize() && recycle_mutex_.TryLock())
-      Recycle(cb);
+  }
+
+  void PrintStats() const {
+    Printf("Quarantine limits: global: %zdMb; thread local: %zdKb\n",
+           GetSize() >> 20, max_cache_size_ >> 10);
+    Printf("Quarantine: %zdM held; %zd handoffs (%zd retried); "
+           "%zd recycles (%zd skipped while busy)\n",
+           atomic_load(&size_, memory_order_relaxed) >> 20,
+           atomic_load(&handoffs_, memory_order_relaxed),
+           atomic_load(&handoff_retries_, memory_order_relaxed),
+           atomic_load(&recycles_, memory_order_relaxed),
+           atomic_load(&busy_recycles_, memory_order_relaxed));
   }
 
  private:
@@ -79,22 +110,51 @@ class Quarantine {
   atomic_uintptr_t min_size_;
   uptr max_cache_size_;
   char pad1_[kCacheLineSize];
-  SpinMutex cache_mutex_;
-  SpinMutex recycle_mutex_;
-  Cache cache_;
+  // Stack of the batches handed off by the threads, newest first.
+  atomic_uintptr_t handoff_;
+  // Size of the batches in handoff_ and queue_.
+  atomic_uintptr_t size_;
   char pad2_[kCacheLineSize];
+  SpinMutex recycle_mutex_;
+  // Batches waiting to be recycled, oldest first; guarded by recycle_mutex_.
+  IntrusiveList<QuarantineBatch> queue_;
+  char pad3_[kCacheLineSize];
+  // Statistics.
+  atomic_uintptr_t handoffs_;
+  atomic_uintptr_t handoff_retries_;
+  atomic_uintptr_t recycles_;
+  atomic_uintptr_t busy_recycles_;
+  char pad4_[kCacheLineSize];
 
   void NOINLINE Recycle(Callback cb) {
+    // Take the whole handoff stack; pushing only ever replaces its head, so
+    // this can't suffer from ABA.
+    uptr head = atomic_load(&handoff_, memory_order_acquire);
+    while (head && !atomic_compare_exchange_weak(&handoff_, &head, 0,
+                                                 memory_order_acquire)) {
+    }
+    // Reversing it queues the batches in the order they were freed, up to
+    // the order within a single handoff.
+    IntrusiveList<QuarantineBatch> handed_off;
+    handed_off.clear();
+    for (QuarantineBatch *b = (QuarantineBatch *)head; b;) {
+      QuarantineBatch *next = b->next;
+      handed_off.push_front(b);
+      b = next;
+    }
+    queue_.append_back(&handed_off);
+
     Cache tmp;
     uptr min_size = atomic_load(&min_size_, memory_order_acquire);
-    {
-      SpinMutexLock l(&cache_mutex_);
-      while (cache_.Size() > min_size) {
-        QuarantineBatch *b = cache_.DequeueBatch();
-        tmp.EnqueueBatch(b);
-      }
+    while (atomic_load(&size_, memory_order_relaxed) > min_size &&
+           !queue_.empty()) {
+      QuarantineBatch *b = queue_.front();
+      queue_.pop_front();
+      atomic_fetch_sub(&size_, b->size, memory_order_relaxed);
+      tmp.EnqueueBatch(b);
     }
     recycle_mutex_.Unlock();
+    atomic_fetch_add(&recycles_, 1, memory_order_relaxed);
     DoRecycle(&tmp, cb);
   }
 
@@ -140,10 +200,14 @@ class QuarantineCache {
     SizeAdd(size);
   }
 
-  void Transfer(QuarantineCache *c) {
-    list_.append_back(&c->list_);
-    SizeAdd(c->Size());
-    atomic_store(&c->size_, 0, memory_order_relaxed);
+  // Removes all the batches, still linked through their next field, and
+  // returns the first one. The last one is stored in *last.
+  QuarantineBatch *ExtractBatches(QuarantineBatch **last) {
+    QuarantineBatch *first = list_.front();
+    *last = list_.back();
+    list_.clear();
+    atomic_store(&size_, 0, memory_order_relaxed);
+    return first;
   }
 
   void EnqueueBatch(QuarantineBatch *b) {
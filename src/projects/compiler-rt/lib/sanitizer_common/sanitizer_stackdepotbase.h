@@ -36,7 +36,7 @@ class StackDepotBase {
   void UnlockAll();
 
  private:
-  static Node *find(Node *s, args_type args, u32 hash);
+  static Node *find(Node *s, Node *end, args_type args, u32 hash);
   static Node *lock(atomic_uintptr_t *p);
   static void unlock(atomic_uintptr_t *p, Node *s);
 
@@ -58,10 +58,11 @@ class StackDepotBase {
 
 template <class Node, int kReservedBits, int kTabSizeLog>
 Node *StackDepotBase<Node, kReservedBits, kTabSizeLog>::find(Node *s,
+                                                             Node *end,
                                                              args_type args,
                                                              u32 hash) {
-  // Searches linked list s for the stack, returns its id.
-  for (; s; s = s->link) {
+  // Searches linked list s up to (not including) end for the stack.
+  for (; s != end; s = s->link) {
     if (s->eq(hash, args)) {
       return s;
     }
@@ -103,33 +104,48 @@ StackDepotBase<Node, kReservedBits, kTabSizeLog>::Put(args_type args,
   uptr v = atomic_load(p, memory_order_consume);
   Node *s = (Node *)(v & ~1);
   // First, try to find the existing stack.
-  Node *node = find(s, args, h);
+  Node *node = find(s, 0, args, h);
   if (node) return node->get_handle();
-  // If failed, lock, retry and insert new.
-  Node *s2 = lock(p);
-  if (s2 != s) {
-    node = find(s2, args, h);
-    if (node) {
-      unlock(p, s2);
-      return node->get_handle();
-    }
-  }
+  // If failed, build a new node and publish it with a CAS on the list head.
+  // Nodes are never removed, so a failed CAS means that other stacks were
+  // pushed in front of s: only those need to be searched before retrying.
   uptr part = (h % kTabSize) / kPartSize;
   u32 id = atomic_fetch_add(&seq[part], 1, memory_order_relaxed) + 1;
-  stats.n_uniq_ids++;
   CHECK_LT(id, kMaxId);
   id |= part << kPartShift;
   CHECK_NE(id, 0);
   CHECK_EQ(id & (((u32)-1) >> kReservedBits), id);
   uptr memsz = Node::storage_size(args);
-  s = (Node *)PersistentAlloc(memsz);
+  node = (Node *)PersistentAlloc(memsz);
   stats.allocated += memsz;
-  s->id = id;
-  s->store(args, h);
-  s->link = s2;
-  unlock(p, s);
+  node->id = id;
+  node->store(args, h);
+  for (int i = 0;; i++) {
+    uptr cmp = atomic_load(p, memory_order_consume);
+    // The lsb is set by LockAll, which must keep the table unchanged.
+    if (cmp & 1) {
+      if (i < 10)
+        proc_yield(10);
+      else
+        internal_sched_yield();
+      continue;
+    }
+    Node *head = (Node *)cmp;
+    if (head != s) {
+      // Another thread may have inserted the same stack meanwhile. The node
+      // built here is then lost, which only happens on a race.
+      Node *found = find(head, s, args, h);
+      if (found) return found->get_handle();
+      s = head;
+    }
+    node->link = s;
+    if (atomic_compare_exchange_weak(p, &cmp, (uptr)node,
+                                     memory_order_release))
+      break;
+  }
+  stats.n_uniq_ids++;
   if (inserted) *inserted = true;
-  return s->get_handle();
+  return node->get_handle();
 }
 
 template <class Node, int kReservedBits, int kTabSizeLog>
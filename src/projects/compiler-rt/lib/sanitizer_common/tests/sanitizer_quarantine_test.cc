@@ -0,0 +1,75 @@
+//===-- sanitizer_quarantine_test.cc --------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file is a part of ThreadSanitizer/AddressSanitizer runtime.
+//
+//===----------------------------------------------------------------------===//
+#include "sanitizer_common/sanitizer_atomic.h"
+#include "sanitizer_common/sanitizer_quarantine.h"
+
+#include "sanitizer_pthread_wrappers.h"
+
+#include "gtest/gtest.h"
+
+#include <stdlib.h>
+
+namespace __sanitizer {
+
+static const int kThreads = 8;
+static const int kNodesPerThread = 20000;
+static const uptr kNodeSize = 1000;
+
+struct Node {
+  atomic_uint8_t recycled;
+};
+
+static Node nodes[kThreads][kNodesPerThread];
+static atomic_uintptr_t recycled_count;
+
+struct TestCallback {
+  void Recycle(Node *n) {
+    // Every node must be recycled at most once.
+    CHECK_EQ(atomic_exchange(&n->recycled, 1, memory_order_relaxed), 0);
+    atomic_fetch_add(&recycled_count, 1, memory_order_relaxed);
+  }
+  void *Allocate(uptr size) { return malloc(size); }
+  void Deallocate(void *p) { free(p); }
+};
+
+typedef Quarantine<TestCallback, Node> TestQuarantine;
+static TestQuarantine quarantine(LINKER_INITIALIZED);
+
+static void *PutThread(void *arg) {
+  Node *thread_nodes = (Node *)arg;
+  TestQuarantine::Cache cache;
+  for (int i = 0; i < kNodesPerThread; i++)
+    quarantine.Put(&cache, TestCallback(), &thread_nodes[i], kNodeSize);
+  quarantine.Drain(&cache, TestCallback());
+  return 0;
+}
+
+TEST(SanitizerCommon, QuarantineThreads) {
+  const uptr kMaxSize = 1 << 20;
+  quarantine.Init(kMaxSize, 1 << 16);
+  pthread_t threads[kThreads];
+  for (int i = 0; i < kThreads; i++)
+    PTHREAD_CREATE(&threads[i], 0, PutThread, nodes[i]);
+  for (int i = 0; i < kThreads; i++)
+    PTHREAD_JOIN(threads[i], 0);
+
+  // Everything beyond the quarantine size, give or take a thread cache per
+  // thread, must have been recycled.
+  uptr total = kThreads * kNodesPerThread;
+  uptr recycled = atomic_load(&recycled_count, memory_order_relaxed);
+  EXPECT_LE(recycled, total);
+  EXPECT_GE(recycled * kNodeSize + kMaxSize + kThreads * (1 << 16),
+            total * kNodeSize);
+}
+
+}  // namespace __sanitizer
@@ -13,6 +13,9 @@
 #include "sanitizer_common/sanitizer_stackdepot.h"
 #include "sanitizer_common/sanitizer_internal_defs.h"
 #include "sanitizer_common/sanitizer_libc.h"
+
+#include "sanitizer_pthread_wrappers.h"
+
 #include "gtest/gtest.h"
 
 namespace __sanitizer {
@@ -90,4 +93,40 @@ TEST(SanitizerCommon, StackDepotReverseMap) {
   }
 }
 
+static const int kPutThreads = 8;
+static const int kPutStacks = 5000;
+
+static void *PutThread(void *arg) {
+  u32 *ids = (u32 *)arg;
+  // Each thread goes through the same stacks, starting at a different one,
+  // so that the insertions of a stack race with each other.
+  uptr first = (uptr)ids[0];
+  for (uptr n = 0; n < kPutStacks; n++) {
+    uptr i = (first + n) % kPutStacks;
+    uptr array[] = {0x1000, 0x2000 + i, 0x3000 + i * 7, i};
+    ids[i] = StackDepotPut(StackTrace(array, ARRAY_SIZE(array)));
+  }
+  return 0;
+}
+
+TEST(SanitizerCommon, StackDepotConcurrentPut) {
+  static u32 ids[kPutThreads][kPutStacks];
+  pthread_t threads[kPutThreads];
+  for (int t = 0; t < kPutThreads; t++) {
+    ids[t][0] = t * kPutStacks / kPutThreads;
+    PTHREAD_CREATE(&threads[t], 0, PutThread, ids[t]);
+  }
+  for (int t = 0; t < kPutThreads; t++)
+    PTHREAD_JOIN(threads[t], 0);
+
+  for (uptr i = 0; i < kPutStacks; i++) {
+    for (int t = 1; t < kPutThreads; t++)
+      EXPECT_EQ(ids[0][i], ids[t][i]);
+    StackTrace stack = StackDepotGet(ids[0][i]);
+    ASSERT_EQ(4U, stack.size);
+    EXPECT_EQ(0x2000 + i, stack.trace[1]);
+    EXPECT_EQ(i, stack.trace[3]);
+  }
+}
+
 }  // namespace __sanitizer
@@ -56,6 +56,13 @@
 // read-only phase, these reads will be O(1); if it later switches to read/write
 // phase, the implementation will correctly handle that by switching to O(N).
 //
+// Release and release-store are also proportional to the number of blocks of
+// the thread clock that acquired something since the sync clock got the time
+// of the thread. The sync clock already holds everything the thread knew at
+// that time, so the other blocks can't be ahead of it. For a mutex passed
+// around a pool of threads, each unlock then only merges the few blocks that
+// the lock changed, instead of the clocks of all the threads.
+//
 // Thread-safety note: all const operations on SyncClock's are conducted under
 // a shared lock; all non-const operations on SyncClock's are conducted under
 // an exclusive lock; ThreadClock's are private to respective threads and so
@@ -67,6 +74,8 @@
 // tid_ - index of the thread associated with he clock ("current thread").
 // last_acquire_ - current thread time when it acquired something from
 //   other threads.
+// block_acquire_ - the same, for each block of ClockBlock::kClockCount
+//   elements of clk_.
 //
 // Description of SyncClock state:
 // clk_ - variable size vector clock, low kClkBits hold timestamp,
@@ -100,6 +109,7 @@ ThreadClock::ThreadClock(unsigned tid, unsigned reused)
   nclk_ = tid_ + 1;
   last_acquire_ = 0;
   internal_memset(clk_, 0, sizeof(clk_));
+  internal_memset(block_acquire_, 0, sizeof(block_acquire_));
   clk_[tid_].reused = reused_;
 }
 
@@ -127,6 +137,9 @@ void ThreadClock::acquire(ClockCache *c, const SyncClock *src) {
           u64 epoch = src->elem(tid).epoch;
           if (clk_[tid].epoch < epoch) {
             clk_[tid].epoch = epoch;
+            block_acquire_[tid / ClockBlock::kClockCount] = clk_[tid_].epoch;
+            if (nclk_ <= tid)
+              nclk_ = tid + 1;
             acquired = true;
           }
         }
@@ -142,10 +155,20 @@ void ThreadClock::acquire(ClockCache *c, const SyncClock *src) {
   // O(N) acquire.
   CPP_STAT_INC(StatClockAcquireFull);
   nclk_ = max(nclk_, nclk);
-  for (uptr i = 0; i < nclk; i++) {
-    u64 epoch = src->elem(i).epoch;
-    if (clk_[i].epoch < epoch) {
-      clk_[i].epoch = epoch;
+  for (uptr b = 0; b * ClockBlock::kClockCount < nclk; b++) {
+    const ClockElem *ce = src->block(b);
+    const uptr begin = b * ClockBlock::kClockCount;
+    const uptr end = min(nclk, begin + ClockBlock::kClockCount);
+    bool acquired_block = false;
+    for (uptr i = begin; i < end; i++) {
+      u64 epoch = ce[i - begin].epoch;
+      if (clk_[i].epoch < epoch) {
+        clk_[i].epoch = epoch;
+        acquired_block = true;
+      }
+    }
+    if (acquired_block) {
+      block_acquire_[b] = clk_[tid_].epoch;
       acquired = true;
     }
   }
@@ -187,6 +210,29 @@ void ThreadClock::release(ClockCache *c, SyncClock *dst) const {
     return;
   }
 
+  // If some blocks of clk_ didn't acquire anything since the last release on
+  // dst, merge only the other ones.
+  if (HasUnchangedBlocks(dst)) {
+    CPP_STAT_INC(StatClockReleasePartial);
+    bool acquired = IsAlreadyAcquired(dst);
+    if (!UpdateChangedBlocks(dst)) {
+      // Too many elements changed to record them in dirty_tids_: reset all
+      // 'acquired' flags, O(N).
+      CPP_STAT_INC(StatClockReleaseSlow);
+      dst->ResetAcquired();
+      if (acquired)
+        dst->elem(tid_).reused = reused_;
+    }
+    // If dst was the result of a release-store by this thread, it now is the
+    // result of one at the current time.
+    if (dst->release_store_tid_ != tid_ ||
+        dst->release_store_reused_ != reused_) {
+      dst->release_store_tid_ = kInvalidTid;
+      dst->release_store_reused_ = 0;
+    }
+    return;
+  }
+
   // O(N) release.
   CPP_STAT_INC(StatClockReleaseFull);
   // First, remember whether we've acquired dst.
@@ -224,11 +270,21 @@ void ThreadClock::ReleaseStore(ClockCache *c, SyncClock *dst) const {
     dst->Resize(c, nclk_);
 
   if (dst->release_store_tid_ == tid_ &&
-      dst->release_store_reused_ == reused_ &&
-      dst->elem(tid_).epoch > last_acquire_) {
-    CPP_STAT_INC(StatClockStoreFast);
-    UpdateCurrentThread(dst);
-    return;
+      dst->release_store_reused_ == reused_) {
+    if (dst->elem(tid_).epoch > last_acquire_) {
+      CPP_STAT_INC(StatClockStoreFast);
+      UpdateCurrentThread(dst);
+      return;
+    }
+    // dst is clk_ as of the last release-store: only the blocks that acquired
+    // something since then differ.
+    if (HasUnchangedBlocks(dst)) {
+      CPP_STAT_INC(StatClockStorePartial);
+      if (!UpdateChangedBlocks(dst))
+        dst->ResetAcquired();
+      dst->elem(tid_).reused = reused_;
+      return;
+    }
   }
 
   // O(N) release-store.
@@ -279,10 +335,48 @@ void ThreadClock::UpdateCurrentThread(SyncClock *dst) const {
   }
   // Reset all 'acquired' flags, O(N).
   CPP_STAT_INC(StatClockReleaseSlow);
-  for (uptr i = 0; i < dst->size_; i++)
-    dst->elem(i).reused = 0;
-  for (unsigned i = 0; i < kDirtyTids; i++)
-    dst->dirty_tids_[i] = kInvalidTid;
+  dst->ResetAcquired();
+}
+
+// Checks whether some blocks of clk_ didn't acquire anything since dst got
+// the current thread time. dst holds all that the thread knew at that time:
+// these blocks can't be ahead of it.
+bool ThreadClock::HasUnchangedBlocks(const SyncClock *dst) const {
+  const u64 since = dst->elem(tid_).epoch;
+  for (uptr b = 0; b * ClockBlock::kClockCount < nclk_; b++) {
+    if (block_acquire_[b] < since)
+      return true;
+  }
+  return false;
+}
+
+// Raises the elements of dst->clk_ to those of clk_ in the blocks that
+// acquired something since dst got the current thread time, and in the
+// element of the current thread. Records the elements that changed in
+// dst->dirty_tids_ and returns true, or returns false if they don't fit.
+bool ThreadClock::UpdateChangedBlocks(SyncClock *dst) const {
+  const u64 since = dst->elem(tid_).epoch;
+  bool dirty_fits = true;
+  for (uptr b = 0; b * ClockBlock::kClockCount < nclk_; b++) {
+    if (block_acquire_[b] < since)
+      continue;
+    CPP_STAT_INC(StatClockReleaseBlock);
+    ClockElem *ce = dst->block(b);
+    const uptr begin = b * ClockBlock::kClockCount;
+    const uptr end = min(nclk_, begin + ClockBlock::kClockCount);
+    for (uptr i = begin; i < end; i++) {
+      if (ce[i - begin].epoch < clk_[i].epoch) {
+        ce[i - begin].epoch = clk_[i].epoch;
+        dirty_fits = dirty_fits && dst->AddDirty(i);
+      }
+    }
+  }
+  ClockElem &ce = dst->elem(tid_);
+  if (ce.epoch < clk_[tid_].epoch) {
+    ce.epoch = clk_[tid_].epoch;
+    dirty_fits = dirty_fits && dst->AddDirty(tid_);
+  }
+  return dirty_fits;
 }
 
 // Checks whether the current threads has already acquired src.
@@ -355,6 +449,7 @@ void ThreadClock::set(unsigned tid, u64 v) {
   if (nclk_ <= tid)
     nclk_ = tid + 1;
   last_acquire_ = clk_[tid_].epoch;
+  block_acquire_[tid / ClockBlock::kClockCount] = last_acquire_;
 }
 
 void ThreadClock::DebugDump(int(*printf)(const char *s, ...)) {
@@ -415,6 +510,42 @@ ClockElem &SyncClock::elem(unsigned tid) const {
   return cb->clock[tid % ClockBlock::kClockCount];
 }
 
+// Returns the elements of the block of ClockBlock::kClockCount elements with
+// index idx.
+ClockElem *SyncClock::block(uptr idx) const {
+  DCHECK_LT(idx * ClockBlock::kClockCount, size_);
+  if (size_ <= ClockBlock::kClockCount)
+    return tab_->clock;
+  return ctx->clock_alloc.Map(tab_->table[idx])->clock;
+}
+
+// Records that other threads need to acquire the element of tid regardless
+// of their 'acquired' flag. Returns false if there's no room for it.
+bool SyncClock::AddDirty(unsigned tid) {
+  for (unsigned i = 0; i < kDirtyTids; i++) {
+    if (dirty_tids_[i] == tid)
+      return true;
+    if (dirty_tids_[i] == kInvalidTid) {
+      dirty_tids_[i] = tid;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Clears the 'acquired' flags of all the threads, and the dirty tids.
+void SyncClock::ResetAcquired() {
+  for (uptr b = 0; b * ClockBlock::kClockCount < size_; b++) {
+    ClockElem *ce = block(b);
+    const uptr n = min(size_ - b * ClockBlock::kClockCount,
+                       ClockBlock::kClockCount);
+    for (uptr i = 0; i < n; i++)
+      ce[i].reused = 0;
+  }
+  for (unsigned i = 0; i < kDirtyTids; i++)
+    dirty_tids_[i] = kInvalidTid;
+}
+
 void SyncClock::DebugDump(int(*printf)(const char *s, ...)) {
   printf("clock=[");
   for (uptr i = 0; i < size_; i++)
@@ -75,6 +75,9 @@ class SyncClock {
   u32 size_;
 
   ClockElem &elem(unsigned tid) const;
+  ClockElem *block(uptr idx) const;
+  bool AddDirty(unsigned tid);
+  void ResetAcquired();
 };
 
 // The clock that lives in threads.
@@ -114,14 +117,20 @@ struct ThreadClock {
 
  private:
   static const uptr kDirtyTids = SyncClock::kDirtyTids;
+  static const uptr kBlocks = kMaxTidInClock / ClockBlock::kClockCount;
   const unsigned tid_;
   const unsigned reused_;
   u64 last_acquire_;
   uptr nclk_;
   ClockElem clk_[kMaxTidInClock];
+  // Current thread time when it acquired something into each block of
+  // ClockBlock::kClockCount elements of clk_.
+  u64 block_acquire_[kBlocks];
 
   bool IsAlreadyAcquired(const SyncClock *src) const;
   void UpdateCurrentThread(SyncClock *dst) const;
+  bool HasUnchangedBlocks(const SyncClock *dst) const;
+  bool UpdateChangedBlocks(SyncClock *dst) const;
 };
 
 }  // namespace __tsan
@@ -88,11 +88,14 @@ void StatOutput(u64 *stat) {
   name[StatClockReleaseFast2]            = "  fast2                           ";
   name[StatClockReleaseSlow]             = "  dirty overflow (slow)           ";
   name[StatClockReleaseFull]             = "  full (slow)                     ";
+  name[StatClockReleasePartial]          = "  changed blocks                  ";
+  name[StatClockReleaseBlock]            = "  merged blocks                   ";
   name[StatClockReleaseAcquired]         = "  was acquired                    ";
   name[StatClockReleaseClearTail]        = "  clear tail                      ";
   name[StatClockStore]                   = "Clock release store               ";
   name[StatClockStoreResize]             = "  resize                          ";
   name[StatClockStoreFast]               = "  fast                            ";
+  name[StatClockStorePartial]            = "  changed blocks                  ";
   name[StatClockStoreFull]               = "  slow                            ";
   name[StatClockStoreTail]               = "  clear tail                      ";
   name[StatClockAcquireRelease]          = "Clock acquire-release             ";
@@ -85,12 +85,15 @@ enum StatType {
   StatClockReleaseFast2,
   StatClockReleaseSlow,
   StatClockReleaseFull,
+  StatClockReleasePartial,
+  StatClockReleaseBlock,
   StatClockReleaseAcquired,
   StatClockReleaseClearTail,
   // Clocks - release store.
   StatClockStore,
   StatClockStoreResize,
   StatClockStoreFast,
+  StatClockStorePartial,
   StatClockStoreFull,
   StatClockStoreTail,
   // Clocks - acquire-release.
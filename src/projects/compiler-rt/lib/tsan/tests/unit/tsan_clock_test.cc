@@ -213,11 +213,15 @@ TEST(Clock, Growth) {
 
 const uptr kThreads = 4;
 const uptr kClocks = 4;
+// Thread tids are spaced by up to kMaxTidStride, so that they fall in
+// different clock blocks.
+const uptr kMaxTidStride = 100;
+const uptr kModelSize = kThreads * kMaxTidStride;
 
 // SimpleSyncClock and SimpleThreadClock implement the same thing as
 // SyncClock and ThreadClock, but in a very simple way.
 struct SimpleSyncClock {
-  u64 clock[kThreads];
+  u64 clock[kModelSize];
   uptr size;
 
   SimpleSyncClock() {
@@ -226,7 +230,7 @@ struct SimpleSyncClock {
 
   void Reset() {
     size = 0;
-    for (uptr i = 0; i < kThreads; i++)
+    for (uptr i = 0; i < kModelSize; i++)
       clock[i] = 0;
   }
 
@@ -246,14 +250,14 @@ struct SimpleSyncClock {
 };
 
 struct SimpleThreadClock {
-  u64 clock[kThreads];
+  u64 clock[kModelSize];
   uptr size;
   unsigned tid;
 
   explicit SimpleThreadClock(unsigned tid) {
     this->tid = tid;
     size = tid + 1;
-    for (uptr i = 0; i < kThreads; i++)
+    for (uptr i = 0; i < kModelSize; i++)
       clock[i] = 0;
   }
 
@@ -264,14 +268,14 @@ struct SimpleThreadClock {
   void acquire(const SimpleSyncClock *src) {
     if (size < src->size)
       size = src->size;
-    for (uptr i = 0; i < kThreads; i++)
+    for (uptr i = 0; i < kModelSize; i++)
       clock[i] = max(clock[i], src->clock[i]);
   }
 
   void release(SimpleSyncClock *dst) const {
     if (dst->size < size)
       dst->size = size;
-    for (uptr i = 0; i < kThreads; i++)
+    for (uptr i = 0; i < kModelSize; i++)
       dst->clock[i] = max(dst->clock[i], clock[i]);
   }
 
@@ -283,7 +287,7 @@ struct SimpleThreadClock {
   void ReleaseStore(SimpleSyncClock *dst) const {
     if (dst->size < size)
       dst->size = size;
-    for (uptr i = 0; i < kThreads; i++)
+    for (uptr i = 0; i < kModelSize; i++)
       dst->clock[i] = clock[i];
   }
 
@@ -302,15 +306,15 @@ struct SimpleThreadClock {
   }
 };
 
-static bool ClockFuzzer(bool printing) {
+static bool ClockFuzzer(bool printing, unsigned stride) {
   // Create kThreads thread clocks.
   SimpleThreadClock *thr0[kThreads];
   ThreadClock *thr1[kThreads];
   unsigned reused[kThreads];
   for (unsigned i = 0; i < kThreads; i++) {
     reused[i] = 0;
-    thr0[i] = new SimpleThreadClock(i);
-    thr1[i] = new ThreadClock(i, reused[i]);
+    thr0[i] = new SimpleThreadClock(i * stride);
+    thr1[i] = new ThreadClock(i * stride, reused[i]);
   }
 
   // Create kClocks sync clocks.
@@ -363,13 +367,13 @@ static bool ClockFuzzer(bool printing) {
     case 5:
       if (printing)
         printf("reset thr%d\n", tid);
-      u64 epoch = thr0[tid]->clock[tid] + 1;
+      u64 epoch = thr0[tid]->clock[tid * stride] + 1;
       reused[tid]++;
       delete thr0[tid];
-      thr0[tid] = new SimpleThreadClock(tid);
-      thr0[tid]->clock[tid] = epoch;
+      thr0[tid] = new SimpleThreadClock(tid * stride);
+      thr0[tid]->clock[tid * stride] = epoch;
       delete thr1[tid];
-      thr1[tid] = new ThreadClock(tid, reused[tid]);
+      thr1[tid] = new ThreadClock(tid * stride, reused[tid]);
       thr1[tid]->set(epoch);
       break;
     }
@@ -415,18 +419,60 @@ static bool ClockFuzzer(bool printing) {
   return true;
 }
 
-TEST(Clock, Fuzzer) {
+static void RunClockFuzzer(unsigned stride) {
   timespec ts;
   clock_gettime(CLOCK_MONOTONIC, &ts);
   int seed = ts.tv_sec + ts.tv_nsec;
   printf("seed=%d\n", seed);
   srand(seed);
-  if (!ClockFuzzer(false)) {
+  if (!ClockFuzzer(false, stride)) {
     // Redo the test with the same seed, but logging operations.
     srand(seed);
-    ClockFuzzer(true);
+    ClockFuzzer(true, stride);
     ASSERT_TRUE(false);
   }
 }
 
+TEST(Clock, Fuzzer) {
+  RunClockFuzzer(1);
+}
+
+TEST(Clock, FuzzerBlocks) {
+  RunClockFuzzer(kMaxTidStride);
+}
+
+// A mutex locked and unlocked in turn by each thread of a pool, whose threads
+// also acquire from the work items they process.
+static void BenchThreadPool(unsigned nthreads) {
+  ThreadClock **threads = new ThreadClock*[nthreads];
+  SyncClock *items = new SyncClock[nthreads];
+  for (unsigned i = 0; i < nthreads; i++)
+    threads[i] = new ThreadClock(i);
+  SyncClock queue;
+  for (int iter = 0; iter < 100000; iter++) {
+    unsigned tid = rand() % nthreads;
+    threads[tid]->tick();
+    threads[tid]->acquire(&cache, &queue);
+    threads[tid]->release(&cache, &items[rand() % nthreads]);
+    threads[tid]->release(&cache, &queue);
+    threads[tid]->tick();
+    threads[tid]->acquire(&cache, &items[rand() % nthreads]);
+  }
+  queue.Reset(&cache);
+  for (unsigned i = 0; i < nthreads; i++) {
+    items[i].Reset(&cache);
+    delete threads[i];
+  }
+  delete[] items;
+  delete[] threads;
+}
+
+TEST(DISABLED_BENCH, ClockThreadPool16) {
+  BenchThreadPool(16);
+}
+
+TEST(DISABLED_BENCH, ClockThreadPool512) {
+  BenchThreadPool(512);
+}
+
 }  // namespace __tsan
@@ -0,0 +1,143 @@
+//===------------------------- atomic.cpp ---------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "__config"
+#ifndef _LIBCPP_HAS_NO_THREADS
+
+#include "atomic"
+#include "climits"
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+// The ulock calls are what the Darwin pthread library itself sleeps on.
+extern "C" int __ulock_wait(uint32_t __operation, void* __addr,
+                            uint64_t __value, uint32_t __timeout);
+extern "C" int __ulock_wake(uint32_t __operation, void* __addr,
+                            uint64_t __wake_value);
+#define _LIBCPP_UL_COMPARE_AND_WAIT 1
+#define _LIBCPP_ULF_WAKE_ALL 0x00000100
+#else
+#include "mutex"
+#include "condition_variable"
+#endif
+
+_LIBCPP_BEGIN_NAMESPACE_STD
+
+namespace
+{
+
+// A contention state: a version that each notify bumps and that the waiters
+// sleep on, and the count of the waiters, so that notifies don't call in the
+// kernel when nobody waits.  Each state sits in its own cache line, so that
+// objects in different states don't contend on the table itself.
+struct _ALIGNAS(64) __contention_state
+{
+    atomic<__libcpp_contention_t> __version_;
+    atomic<__libcpp_contention_t> __waiters_;
+#if !defined(__linux__) && !defined(__APPLE__)
+    mutex __mut_;
+    condition_variable __cv_;
+#endif
+};
+
+const size_t __contention_state_count = 256;
+
+__contention_state __contention_table[__contention_state_count];
+
+__contention_state&
+__state_for(const volatile void* __location)
+{
+    // Objects are at least 4-aligned but for the smallest ones, so the low
+    // bits tell little apart.
+    uintptr_t __p = reinterpret_cast<uintptr_t>(__location);
+    return __contention_table[(__p >> 2) % __contention_state_count];
+}
+
+void
+__platform_wait(__contention_state& __s, __libcpp_contention_t __old)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, &__s.__version_, FUTEX_WAIT_PRIVATE, __old, 0, 0, 0);
+#elif defined(__APPLE__)
+    __ulock_wait(_LIBCPP_UL_COMPARE_AND_WAIT, &__s.__version_,
+                 static_cast<uint32_t>(__old), 0);
+#else
+    unique_lock<mutex> __lk(__s.__mut_);
+    if (__s.__version_.load(memory_order_relaxed) == __old)
+        __s.__cv_.wait(__lk);
+#endif
+}
+
+// Wakes all the waiters of the state: waking one could wake a waiter of
+// another object, which would just go back to sleep, and the notify would be
+// lost.
+void
+__platform_wake_all(__contention_state& __s)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, &__s.__version_, FUTEX_WAKE_PRIVATE, INT_MAX, 0, 0, 0);
+#elif defined(__APPLE__)
+    __ulock_wake(_LIBCPP_UL_COMPARE_AND_WAIT | _LIBCPP_ULF_WAKE_ALL,
+                 &__s.__version_, 0);
+#else
+    // Taking the lock orders the wake after any waiter between its check of
+    // the version and its sleep.
+    __s.__mut_.lock();
+    __s.__mut_.unlock();
+    __s.__cv_.notify_all();
+#endif
+}
+
+void
+__notify(const volatile void* __location)
+{
+    __contention_state& __s = __state_for(__location);
+    // Both are sequentially consistent: a waiter that the load of the count
+    // misses registered after the bump, and sees it before it sleeps.
+    __s.__version_.fetch_add(1, memory_order_seq_cst);
+    if (__s.__waiters_.load(memory_order_seq_cst) != 0)
+        __platform_wake_all(__s);
+}
+
+}  // namespace
+
+__libcpp_contention_t
+__libcpp_atomic_monitor(const volatile void* __location) _NOEXCEPT
+{
+    return __state_for(__location).__version_.load(memory_order_seq_cst);
+}
+
+void
+__libcpp_atomic_wait(const volatile void* __location,
+                     __libcpp_contention_t __old) _NOEXCEPT
+{
+    __contention_state& __s = __state_for(__location);
+    __s.__waiters_.fetch_add(1, memory_order_seq_cst);
+    __platform_wait(__s, __old);
+    __s.__waiters_.fetch_sub(1, memory_order_release);
+}
+
+void
+__libcpp_atomic_notify_one(const volatile void* __location) _NOEXCEPT
+{
+    __notify(__location);
+}
+
+void
+__libcpp_atomic_notify_all(const volatile void* __location) _NOEXCEPT
+{
+    __notify(__location);
+}
+
+_LIBCPP_END_NAMESPACE_STD
+
+#endif  // !_LIBCPP_HAS_NO_THREADS
@@ -0,0 +1,328 @@
+//===------------------------- charconv.cpp -------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#define _LIBCPP_BUILDING_CHARCONV
+#include "experimental/charconv"
+#include "cerrno"
+#include "cmath"
+#include "cstdlib"
+#include "cstring"
+#include "locale"
+#include "string"
+
+_LIBCPP_BEGIN_NAMESPACE_EXPERIMENTAL
+
+namespace
+{
+
+template <class _Tp>
+int
+__print_c(char* __buf, size_t __n, const char* __fmt, int __prec, _Tp __v)
+{
+#ifdef _LIBCPP_LOCALE__L_EXTENSIONS
+    return snprintf_l(__buf, __n, _LIBCPP_GET_C_LOCALE, __fmt, __prec, __v);
+#else
+    return __snprintf_l(__buf, __n, __cloc(), __fmt, __prec, __v);
+#endif
+}
+
+// Writes __v with __digits significant digits in the format of %e, and
+// returns what it reads back as.
+inline float
+__print_e(char* __buf, size_t __n, int __digits, float __v)
+{
+    __print_c(__buf, __n, "%.*e", __digits - 1, static_cast<double>(__v));
+    return strtof_l(__buf, 0, _LIBCPP_GET_C_LOCALE);
+}
+
+inline double
+__print_e(char* __buf, size_t __n, int __digits, double __v)
+{
+    __print_c(__buf, __n, "%.*e", __digits - 1, __v);
+    return strtod_l(__buf, 0, _LIBCPP_GET_C_LOCALE);
+}
+
+inline long double
+__print_e(char* __buf, size_t __n, int __digits, long double __v)
+{
+    __print_c(__buf, __n, "%.*Le", __digits - 1, __v);
+    return strtold_l(__buf, 0, _LIBCPP_GET_C_LOCALE);
+}
+
+inline float
+__parse(const char* __s, char** __e, float*)
+{
+    return strtof_l(__s, __e, _LIBCPP_GET_C_LOCALE);
+}
+
+inline double
+__parse(const char* __s, char** __e, double*)
+{
+    return strtod_l(__s, __e, _LIBCPP_GET_C_LOCALE);
+}
+
+inline long double
+__parse(const char* __s, char** __e, long double*)
+{
+    return strtold_l(__s, __e, _LIBCPP_GET_C_LOCALE);
+}
+
+to_chars_result
+__copy_chars(char* __first, char* __last, const char* __s, size_t __n)
+{
+    if (static_cast<size_t>(__last - __first) < __n)
+    {
+        to_chars_result __r = {__last, errc::value_too_large};
+        return __r;
+    }
+    memcpy(__first, __s, __n);
+    to_chars_result __r = {__first + __n, errc()};
+    return __r;
+}
+
+template <class _Tp>
+to_chars_result
+__to_chars_float(char* __first, char* __last, _Tp __value)
+{
+    bool __neg = signbit(__value);
+    if (isnan(__value))
+        return __neg ? __copy_chars(__first, __last, "-nan", 4)
+                     : __copy_chars(__first, __last, "nan", 3);
+    if (isinf(__value))
+        return __neg ? __copy_chars(__first, __last, "-inf", 4)
+                     : __copy_chars(__first, __last, "inf", 3);
+    if (__value == 0)
+        return __neg ? __copy_chars(__first, __last, "-0", 2)
+                     : __copy_chars(__first, __last, "0", 1);
+    // Search the fewest significant digits reading back as __value: as they
+    // are rounded, more digits don't read back further from it.
+    char __buf[64];
+    int __lo = 1;
+    int __hi = numeric_limits<_Tp>::max_digits10;
+    while (__lo < __hi)
+    {
+        int __mid = (__lo + __hi) / 2;
+        if (__print_e(__buf, sizeof(__buf), __mid, __value) == __value)
+            __hi = __mid;
+        else
+            __lo = __mid + 1;
+    }
+    __print_e(__buf, sizeof(__buf), __hi, __value);
+    // __buf is [-]d[.ddd]e(+|-)dd[d...]
+    char __digits[64];
+    int __nd = 0;
+    const char* __p = __buf + __neg;
+    for (; *__p != 'e'; ++__p)
+        if (*__p != '.')
+            __digits[__nd++] = *__p;
+    while (__nd > 1 && __digits[__nd - 1] == '0')
+        --__nd;
+    int __exp = atoi(__p + 1);
+    int __exp_digits = 2;
+    for (int __e = __exp < 0 ? -__exp : __exp; __e >= 100; __e /= 10)
+        ++__exp_digits;
+    int __sci_len = __nd + (__nd > 1) + 2 + __exp_digits;
+    int __fixed_len;
+    if (__exp < 0)
+        __fixed_len = 2 + (-__exp - 1) + __nd;
+    else if (__exp + 1 >= __nd)
+        __fixed_len = __exp + 1;
+    else
+        __fixed_len = __nd + 1;
+    bool __fixed = __fixed_len <= __sci_len;
+    ptrdiff_t __len = __neg + (__fixed ? __fixed_len : __sci_len);
+    if (__last - __first < __len)
+    {
+        to_chars_result __r = {__last, errc::value_too_large};
+        return __r;
+    }
+    char* __o = __first;
+    if (__neg)
+        *__o++ = '-';
+    if (!__fixed)
+    {
+        *__o++ = __digits[0];
+        if (__nd > 1)
+        {
+            *__o++ = '.';
+            memcpy(__o, __digits + 1, __nd - 1);
+            __o += __nd - 1;
+        }
+        *__o++ = 'e';
+        *__o++ = __exp < 0 ? '-' : '+';
+        __o += __exp_digits;
+        _VSTD::__write_decimal(__o, static_cast<unsigned>(__exp < 0 ? -__exp : __exp));
+        if (__exp_digits == 2 && (__exp < 0 ? -__exp : __exp) < 10)
+            __o[-2] = '0';
+    }
+    else if (__exp < 0)
+    {
+        *__o++ = '0';
+        *__o++ = '.';
+        memset(__o, '0', -__exp - 1);
+        __o += -__exp - 1;
+        memcpy(__o, __digits, __nd);
+        __o += __nd;
+    }
+    else if (__exp + 1 >= __nd)
+    {
+        memcpy(__o, __digits, __nd);
+        __o += __nd;
+        memset(__o, '0', __exp + 1 - __nd);
+        __o += __exp + 1 - __nd;
+    }
+    else
+    {
+        memcpy(__o, __digits, __exp + 1);
+        __o += __exp + 1;
+        *__o++ = '.';
+        memcpy(__o, __digits + __exp + 1, __nd - (__exp + 1));
+        __o += __nd - (__exp + 1);
+    }
+    to_chars_result __r = {__o, errc()};
+    return __r;
+}
+
+inline bool
+__is_digit(char __c)
+{
+    return __c >= '0' && __c <= '9';
+}
+
+// Whether [__p, __last) starts with __s, in any case.
+bool
+__starts_with(const char* __p, const char* __last, const char* __s)
+{
+    for (; *__s; ++__s, ++__p)
+        if (__p == __last || (*__p | 0x20) != *__s)
+            return false;
+    return true;
+}
+
+template <class _Tp>
+from_chars_result
+__from_chars_float(const char* __first, const char* __last, _Tp& __value)
+{
+    // Find the end of the number, so that strtod doesn't take what isn't
+    // allowed here, such as spaces or hexadecimal.
+    const char* __p = __first;
+    if (__p != __last && *__p == '-')
+        ++__p;
+    if (__starts_with(__p, __last, "inf"))
+    {
+        __p += 3;
+        if (__starts_with(__p, __last, "inity"))
+            __p += 5;
+    }
+    else if (__starts_with(__p, __last, "nan"))
+    {
+        __p += 3;
+        if (__p != __last && *__p == '(')
+        {
+            const char* __q = __p + 1;
+            while (__q != __last && (__is_digit(*__q) ||
+                                     ((*__q | 0x20) >= 'a' && (*__q | 0x20) <= 'z') ||
+                                     *__q == '_'))
+                ++__q;
+            if (__q != __last && *__q == ')')
+                __p = __q + 1;
+        }
+    }
+    else
+    {
+        const char* __int = __p;
+        while (__p != __last && __is_digit(*__p))
+            ++__p;
+        bool __has_digits = __p != __int;
+        if (__p != __last && *__p == '.')
+        {
+            const char* __frac = ++__p;
+            while (__p != __last && __is_digit(*__p))
+                ++__p;
+            __has_digits |= __p != __frac;
+        }
+        if (!__has_digits)
+        {
+            from_chars_result __r = {__first, errc::invalid_argument};
+            return __r;
+        }
+        if (__p != __last && (*__p | 0x20) == 'e')
+        {
+            const char* __q = __p + 1;
+            if (__q != __last && (*__q == '+' || *__q == '-'))
+                ++__q;
+            if (__q != __last && __is_digit(*__q))
+            {
+                while (__q != __last && __is_digit(*__q))
+                    ++__q;
+                __p = __q;
+            }
+        }
+    }
+    if (__p == __first || (__p == __first + 1 && *__first == '-'))
+    {
+        from_chars_result __r = {__first, errc::invalid_argument};
+        return __r;
+    }
+    string __s(__first, __p);
+    typename remove_reference<decltype(errno)>::type __save_errno = errno;
+    errno = 0;
+    _Tp __v = __parse(__s.c_str(), 0, static_cast<_Tp*>(0));
+    // Subnormal numbers set ERANGE too, though they fit.
+    bool __range = errno == ERANGE && (isinf(__v) || __v == 0);
+    errno = __save_errno;
+    if (__range)
+    {
+        from_chars_result __r = {__p, errc::result_out_of_range};
+        return __r;
+    }
+    __value = __v;
+    from_chars_result __r = {__p, errc()};
+    return __r;
+}
+
+}  // namespace
+
+to_chars_result
+to_chars(char* __first, char* __last, float __value)
+{
+    return __to_chars_float(__first, __last, __value);
+}
+
+to_chars_result
+to_chars(char* __first, char* __last, double __value)
+{
+    return __to_chars_float(__first, __last, __value);
+}
+
+to_chars_result
+to_chars(char* __first, char* __last, long double __value)
+{
+    return __to_chars_float(__first, __last, __value);
+}
+
+from_chars_result
+from_chars(const char* __first, const char* __last, float& __value)
+{
+    return __from_chars_float(__first, __last, __value);
+}
+
+from_chars_result
+from_chars(const char* __first, const char* __last, double& __value)
+{
+    return __from_chars_float(__first, __last, __value);
+}
+
+from_chars_result
+from_chars(const char* __first, const char* __last, long double& __value)
+{
+    return __from_chars_float(__first, __last, __value);
+}
+
+_LIBCPP_END_NAMESPACE_EXPERIMENTAL
@@ -0,0 +1,216 @@
+//===--------------------- execution_policy.cpp ---------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "__config"
+#ifndef _LIBCPP_HAS_NO_THREADS
+
+#define _LIBCPP_BUILDING_EXECUTION_POLICY
+#include "experimental/execution_policy"
+#include "atomic"
+#include "condition_variable"
+#include "deque"
+#include "exception"
+#include "functional"
+#include "memory"
+#include "mutex"
+#include "thread"
+#include "vector"
+
+_LIBCPP_BEGIN_NAMESPACE_PARALLEL
+
+namespace
+{
+
+struct __task
+{
+    void (*__f_)(void*, size_t, size_t);
+    void* __ctx_;
+    size_t __begin_;
+    size_t __end_;
+    atomic<size_t>* __pending_;
+};
+
+// A pool of threads, each with a queue of tasks.  A thread runs the newest
+// task of its own queue, or steals the oldest task of another queue when its
+// own is empty.  The threads waiting for their tasks run tasks too, so that
+// the algorithms may nest.
+class __work_stealing_pool
+{
+    struct __queue
+    {
+        mutex __mut_;
+        deque<__task> __tasks_;
+    };
+
+    unsigned __nthreads_;
+    unique_ptr<__queue[]> __queues_;
+    vector<thread::id> __ids_;
+    atomic<size_t> __queued_;
+    mutex __sleep_mut_;
+    condition_variable __wake_;
+
+public:
+    explicit __work_stealing_pool(unsigned __nthreads);
+
+    void __run(size_t __n, void (*__f)(void*, size_t, size_t), void* __ctx);
+
+private:
+    unsigned __home_queue() const;
+    bool __try_run(unsigned __home);
+    void __work(unsigned __i);
+};
+
+__work_stealing_pool::__work_stealing_pool(unsigned __nthreads)
+    : __nthreads_(__nthreads),
+      __queues_(new __queue[__nthreads]),
+      __queued_(0)
+{
+    // The threads are detached: the pool is never destroyed, so that the
+    // algorithms may still run while the program exits.
+    for (unsigned __i = 0; __i < __nthreads_; ++__i)
+    {
+        thread __t(&__work_stealing_pool::__work, this, __i);
+        __ids_.push_back(__t.get_id());
+        __t.detach();
+    }
+}
+
+unsigned
+__work_stealing_pool::__home_queue() const
+{
+    thread::id __id = this_thread::get_id();
+    for (unsigned __i = 0; __i < __nthreads_; ++__i)
+        if (__ids_[__i] == __id)
+            return __i;
+    return hash<thread::id>()(__id) % __nthreads_;
+}
+
+bool
+__work_stealing_pool::__try_run(unsigned __home)
+{
+    __task __t;
+    bool __found = false;
+    for (unsigned __i = 0; __i < __nthreads_ && !__found; ++__i)
+    {
+        __queue& __q = __queues_[(__home + __i) % __nthreads_];
+        lock_guard<mutex> __lk(__q.__mut_);
+        if (__q.__tasks_.empty())
+            continue;
+        if (__i == 0)
+        {
+            __t = __q.__tasks_.back();
+            __q.__tasks_.pop_back();
+        }
+        else
+        {
+            __t = __q.__tasks_.front();
+            __q.__tasks_.pop_front();
+        }
+        __found = true;
+    }
+    if (!__found)
+        return false;
+    __queued_.fetch_sub(1, memory_order_relaxed);
+#ifndef _LIBCPP_NO_EXCEPTIONS
+    try
+    {
+#endif  // _LIBCPP_NO_EXCEPTIONS
+        __t.__f_(__t.__ctx_, __t.__begin_, __t.__end_);
+#ifndef _LIBCPP_NO_EXCEPTIONS
+    }
+    catch (...)
+    {
+        terminate();
+    }
+#endif  // _LIBCPP_NO_EXCEPTIONS
+    __t.__pending_->fetch_sub(1, memory_order_release);
+    return true;
+}
+
+void
+__work_stealing_pool::__work(unsigned __i)
+{
+    while (true)
+    {
+        if (__try_run(__i))
+            continue;
+        unique_lock<mutex> __lk(__sleep_mut_);
+        while (__queued_.load(memory_order_relaxed) == 0)
+            __wake_.wait(__lk);
+    }
+}
+
+void
+__work_stealing_pool::__run(size_t __n, void (*__f)(void*, size_t, size_t),
+                            void* __ctx)
+{
+    // A few tasks per thread balance the load without making each task too
+    // small to amortize its scheduling.
+    size_t __ntasks = _VSTD::min<size_t>(__n, 8 * (__nthreads_ + 1));
+    unsigned __home = __home_queue();
+    atomic<size_t> __pending(__ntasks);
+    for (size_t __i = 0; __i < __ntasks; ++__i)
+    {
+        __task __t = {__f, __ctx, __parallel_chunk_begin(__n, __ntasks, __i),
+                      __parallel_chunk_begin(__n, __ntasks, __i + 1),
+                      &__pending};
+        __queue& __q = __queues_[(__home + __i) % __nthreads_];
+        lock_guard<mutex> __lk(__q.__mut_);
+        __q.__tasks_.push_back(__t);
+    }
+    {
+        lock_guard<mutex> __lk(__sleep_mut_);
+        __queued_.fetch_add(__ntasks, memory_order_relaxed);
+    }
+    __wake_.notify_all();
+    while (__pending.load(memory_order_acquire) != 0)
+        if (!__try_run(__home))
+            this_thread::yield();
+}
+
+unsigned
+__pool_threads()
+{
+    // The calling thread runs tasks too.
+    static unsigned __n = thread::hardware_concurrency();
+    return __n > 1 ? __n - 1 : 0;
+}
+
+__work_stealing_pool&
+__pool()
+{
+    static __work_stealing_pool* __p =
+        new __work_stealing_pool(__pool_threads());
+    return *__p;
+}
+
+}  // namespace
+
+void
+__parallel_for(size_t __n, void (*__f)(void*, size_t, size_t), void* __ctx)
+{
+    if (__n == 0)
+        return;
+    if (__n == 1 || __pool_threads() == 0)
+    {
+        __f(__ctx, 0, __n);
+        return;
+    }
+    __pool().__run(__n, __f, __ctx);
+}
+
+unsigned
+__parallel_concurrency() _NOEXCEPT
+{
+    return __pool_threads() + 1;
+}
+
+_LIBCPP_END_NAMESPACE_PARALLEL
+
+#endif  // !_LIBCPP_HAS_NO_THREADS
@@ -4435,6 +4435,47 @@ __num_put_base::__identify_padding(char* __nb, char* __ne,
     return __nb;
 }
 
+char*
+__num_put_base::__put_int(char* __nb, unsigned long long __v, bool __neg,
+                          bool __signd, ios_base::fmtflags __flags)
+{
+    // As snprintf_l does, '+' only goes before signed decimal numbers, and
+    // the 0 or 0x of showbase before nonzero ones.
+    bool __showbase = (__flags & ios_base::showbase) && __v != 0;
+    char* __ne;
+    switch (__flags & ios_base::basefield)
+    {
+    case ios_base::oct:
+        if (__showbase)
+            *__nb++ = '0';
+        __ne = __nb + __integral_width(__v, 8);
+        __write_integral(__ne, __v, 8, __digit_chars<>::__lower);
+        break;
+    case ios_base::hex:
+        {
+        bool __upper = (__flags & ios_base::uppercase) != 0;
+        if (__showbase)
+        {
+            *__nb++ = '0';
+            *__nb++ = __upper ? 'X' : 'x';
+        }
+        __ne = __nb + __integral_width(__v, 16);
+        __write_integral(__ne, __v, 16, __upper ? __digit_chars<>::__upper
+                                                : __digit_chars<>::__lower);
+        }
+        break;
+    default:
+        if (__neg)
+            *__nb++ = '-';
+        else if (__signd && (__flags & ios_base::showpos))
+            *__nb++ = '+';
+        __ne = __nb + __decimal_width(__v);
+        __write_decimal(__ne, __v);
+        break;
+    }
+    return __ne;
+}
+
 // time_get
 
 static
@@ -9,6 +9,7 @@
 
 #define _LIBCPP_BUILDING_MEMORY
 #include "memory"
+#include "cstdint"
 #ifndef _LIBCPP_HAS_NO_THREADS
 #include "mutex"
 #include "thread"
@@ -19,18 +20,22 @@ _LIBCPP_BEGIN_NAMESPACE_STD
 namespace
 {
 
+// Taking a reference needs no ordering, as the one it is taken from keeps the
+// object alive.  Dropping one has to make the writes through it visible to the
+// thread destroying the object.
+
 template <class T>
 inline T
 increment(T& t) _NOEXCEPT
 {
-    return __sync_add_and_fetch(&t, 1);
+    return __atomic_add_fetch(&t, 1, __ATOMIC_RELAXED);
 }
 
 template <class T>
 inline T
 decrement(T& t) _NOEXCEPT
 {
-    return __sync_add_and_fetch(&t, -1);
+    return __atomic_add_fetch(&t, -1, __ATOMIC_ACQ_REL);
 }
 
 }  // namespace
@@ -92,21 +97,26 @@ __shared_weak_count::__release_shared() _NOEXCEPT
 void
 __shared_weak_count::__release_weak() _NOEXCEPT
 {
-    if (decrement(__shared_weak_owners_) == -1)
+    // Without weak_ptrs the last shared owner holds the only weak reference,
+    // and as nobody can take another one then, it can skip the locked
+    // decrement, which would take the cache line shared with the object of
+    // make_shared away from its other readers.
+    if (__atomic_load_n(&__shared_weak_owners_, __ATOMIC_ACQUIRE) == 0 ||
+        decrement(__shared_weak_owners_) == -1)
         __on_zero_shared_weak();
 }
 
 __shared_weak_count*
 __shared_weak_count::lock() _NOEXCEPT
 {
-    long object_owners = __shared_owners_;
+    long object_owners = __atomic_load_n(&__shared_owners_, __ATOMIC_RELAXED);
     while (object_owners != -1)
     {
-        if (__sync_bool_compare_and_swap(&__shared_owners_,
-                                         object_owners,
-                                         object_owners+1))
+        // A failed exchange reloads object_owners.
+        if (__atomic_compare_exchange_n(&__shared_owners_, &object_owners,
+                                        object_owners+1, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
             return this;
-        object_owners = __shared_owners_;
     }
     return 0;
 }
@@ -174,6 +184,36 @@ __get_sp_mut(const void* p)
     return muts[hash<const void*>()(p) & (__sp_mut_count-1)];
 }
 
+__shared_weak_count*
+__sp_lock(__shared_weak_count** cntrl) _NOEXCEPT
+{
+    uintptr_t* word = reinterpret_cast<uintptr_t*>(cntrl);
+    uintptr_t v = __atomic_load_n(word, __ATOMIC_RELAXED);
+    unsigned count = 0;
+    while (true)
+    {
+        if ((v & 1) == 0)
+        {
+            if (__atomic_compare_exchange_n(word, &v, v | 1, true,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+                return reinterpret_cast<__shared_weak_count*>(v);
+            continue;
+        }
+        // The lock is held only for a few instructions, but its holder may
+        // have been preempted.
+        if (++count > 16)
+            this_thread::yield();
+        v = __atomic_load_n(word, __ATOMIC_RELAXED);
+    }
+}
+
+void
+__sp_unlock(__shared_weak_count** cntrl, __shared_weak_count* c) _NOEXCEPT
+{
+    __atomic_store_n(reinterpret_cast<uintptr_t*>(cntrl),
+                     reinterpret_cast<uintptr_t>(c), __ATOMIC_RELEASE);
+}
+
 #endif // __has_feature(cxx_atomic) && !_LIBCPP_HAS_NO_THREADS
 
 void
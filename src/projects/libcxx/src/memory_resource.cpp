@@ -0,0 +1,458 @@
+//===------------------------ memory_resource.cpp -------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is dual licensed under the MIT and the University of Illinois Open
+// Source Licenses. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#define _LIBCPP_BUILDING_MEMORY_RESOURCE
+#include "experimental/memory_resource"
+#include "cstdint"
+
+_LIBCPP_BEGIN_NAMESPACE_LFTS_PMR
+
+namespace
+{
+
+// The pools are for blocks of __min_block << i bytes.
+const size_t __min_block = 8;
+const size_t __default_largest_block = 4096;
+const size_t __max_largest_block = size_t(1) << 20;
+const size_t __default_max_blocks = size_t(1) << 12;
+const size_t __max_max_blocks = size_t(1) << 20;
+const size_t __first_chunk_bytes = 1024;
+const size_t __first_chunk_blocks = 4;
+
+inline size_t
+__round_up(size_t __n, size_t __align)
+{
+    return (__n + __align - 1) & ~(__align - 1);
+}
+
+// Bumps __cur past __bytes aligned to __align, unless that goes past __end.
+inline void*
+__bump(char*& __cur, char* __end, size_t __bytes, size_t __align)
+{
+    if (__cur == 0)
+        return 0;
+    uintptr_t __c = reinterpret_cast<uintptr_t>(__cur);
+    uintptr_t __e = reinterpret_cast<uintptr_t>(__end);
+    uintptr_t __p = (__c + __align - 1) & ~static_cast<uintptr_t>(__align - 1);
+    if (__p < __c || __p > __e || __bytes > __e - __p)
+        return 0;
+    __cur = reinterpret_cast<char*>(__p + __bytes);
+    return reinterpret_cast<void*>(__p);
+}
+
+class __new_delete_memory_resource_imp
+    : public memory_resource
+{
+protected:
+    // Over-aligned blocks keep what operator new returned right before them.
+    virtual void* do_allocate(size_t __bytes, size_t __align)
+    {
+        if (__align <= __max_align)
+            return ::operator new(__bytes);
+        if (__bytes > numeric_limits<size_t>::max() - __align - sizeof(void*))
+            __throw_bad_alloc();
+        char* __raw = static_cast<char*>(::operator new(__bytes + __align +
+                                                        sizeof(void*)));
+        void** __p = reinterpret_cast<void**>(
+            __round_up(reinterpret_cast<uintptr_t>(__raw) + sizeof(void*),
+                       __align));
+        __p[-1] = __raw;
+        return __p;
+    }
+
+    virtual void do_deallocate(void* __p, size_t, size_t __align)
+    {
+        if (__align <= __max_align)
+            ::operator delete(__p);
+        else
+            ::operator delete(static_cast<void**>(__p)[-1]);
+    }
+
+    virtual bool do_is_equal(const memory_resource& __other) const _NOEXCEPT
+        {return this == &__other;}
+};
+
+class __null_memory_resource_imp
+    : public memory_resource
+{
+protected:
+    virtual void* do_allocate(size_t, size_t)
+    {
+        __throw_bad_alloc();
+        return 0;
+    }
+
+    virtual void do_deallocate(void*, size_t, size_t) {}
+
+    virtual bool do_is_equal(const memory_resource& __other) const _NOEXCEPT
+        {return this == &__other;}
+};
+
+// Null stands for new_delete_resource(), so that it needs no initialization.
+memory_resource* __default_resource = 0;
+
+}  // namespace
+
+// memory_resource
+
+memory_resource::~memory_resource()
+{
+}
+
+memory_resource*
+new_delete_resource() _NOEXCEPT
+{
+    static __new_delete_memory_resource_imp __r;
+    return &__r;
+}
+
+memory_resource*
+null_memory_resource() _NOEXCEPT
+{
+    static __null_memory_resource_imp __r;
+    return &__r;
+}
+
+memory_resource*
+get_default_resource() _NOEXCEPT
+{
+#ifndef _LIBCPP_HAS_NO_THREADS
+    memory_resource* __r = __atomic_load_n(&__default_resource, __ATOMIC_ACQUIRE);
+#else
+    memory_resource* __r = __default_resource;
+#endif
+    return __r ? __r : new_delete_resource();
+}
+
+memory_resource*
+set_default_resource(memory_resource* __r) _NOEXCEPT
+{
+    if (__r == 0)
+        __r = new_delete_resource();
+#ifndef _LIBCPP_HAS_NO_THREADS
+    memory_resource* __old = __atomic_exchange_n(&__default_resource, __r,
+                                                 __ATOMIC_ACQ_REL);
+#else
+    memory_resource* __old = __default_resource;
+    __default_resource = __r;
+#endif
+    return __old ? __old : new_delete_resource();
+}
+
+// unsynchronized_pool_resource
+
+// Pool chunks and large blocks end with a __chunk, so that the blocks before
+// it keep the alignment upstream gave them.  Only the large blocks use
+// __prev_, to be unlinked when deallocated.
+struct unsynchronized_pool_resource::__chunk
+{
+    __chunk* __next_;
+    __chunk* __prev_;
+    void* __start_;
+    size_t __size_;
+    size_t __align_;
+};
+
+struct unsynchronized_pool_resource::__pool
+{
+    // The blocks given back, each holding a pointer to the next one.
+    void* __free_;
+    // The blocks of the newest chunk never handed out.
+    char* __cur_;
+    char* __end_;
+    __chunk* __chunks_;
+    size_t __next_blocks_;
+};
+
+unsynchronized_pool_resource::unsynchronized_pool_resource(
+        const pool_options& __opts, memory_resource* __upstream)
+    : __upstream_(__upstream), __num_pools_(1), __pools_(0), __large_(0)
+{
+    size_t __largest = __opts.largest_required_pool_block;
+    if (__largest == 0)
+        __largest = __default_largest_block;
+    else if (__largest > __max_largest_block)
+        __largest = __max_largest_block;
+    size_t __block = __min_block;
+    for (; __block < __largest; __block <<= 1)
+        ++__num_pools_;
+    __opts_.largest_required_pool_block = __block;
+    size_t __max_blocks = __opts.max_blocks_per_chunk;
+    if (__max_blocks == 0)
+        __max_blocks = __default_max_blocks;
+    else if (__max_blocks > __max_max_blocks)
+        __max_blocks = __max_max_blocks;
+    __opts_.max_blocks_per_chunk = __max_blocks;
+}
+
+unsynchronized_pool_resource::~unsynchronized_pool_resource()
+{
+    release();
+}
+
+void
+unsynchronized_pool_resource::release()
+{
+    if (__pools_)
+    {
+        for (int __i = 0; __i < __num_pools_; ++__i)
+        {
+            for (__chunk* __c = __pools_[__i].__chunks_; __c != 0;)
+            {
+                __chunk* __next = __c->__next_;
+                __upstream_->deallocate(__c->__start_, __c->__size_, __c->__align_);
+                __c = __next;
+            }
+        }
+        __upstream_->deallocate(__pools_, __num_pools_ * sizeof(__pool),
+                                alignment_of<__pool>::value);
+        __pools_ = 0;
+    }
+    while (__large_ != 0)
+    {
+        __chunk* __next = __large_->__next_;
+        __upstream_->deallocate(__large_->__start_, __large_->__size_,
+                                __large_->__align_);
+        __large_ = __next;
+    }
+}
+
+// The pool of the smallest blocks holding __bytes aligned to __align, or
+// __num_pools_ if none does.
+int
+unsynchronized_pool_resource::__pool_index(size_t __bytes, size_t __align) const
+{
+    if (__align > __max_align || __bytes > __opts_.largest_required_pool_block)
+        return __num_pools_;
+    size_t __n = __bytes > __align ? __bytes : __align;
+    int __i = 0;
+    for (size_t __block = __min_block; __block < __n; __block <<= 1)
+        ++__i;
+    return __i;
+}
+
+void*
+unsynchronized_pool_resource::do_allocate(size_t __bytes, size_t __align)
+{
+    int __i = __pool_index(__bytes, __align);
+    if (__i == __num_pools_)
+        return __allocate_large(__bytes, __align);
+    if (__pools_ != 0)
+    {
+        __pool& __p = __pools_[__i];
+        if (__p.__free_ != 0)
+        {
+            void* __r = __p.__free_;
+            __p.__free_ = *static_cast<void**>(__r);
+            return __r;
+        }
+        if (__p.__cur_ != __p.__end_)
+        {
+            void* __r = __p.__cur_;
+            __p.__cur_ += __min_block << __i;
+            return __r;
+        }
+    }
+    return __allocate_from_new_chunk(__i);
+}
+
+void*
+unsynchronized_pool_resource::__allocate_from_new_chunk(int __i)
+{
+    if (__pools_ == 0)
+    {
+        __pools_ = static_cast<__pool*>(__upstream_->allocate(
+            __num_pools_ * sizeof(__pool), alignment_of<__pool>::value));
+        for (int __j = 0; __j < __num_pools_; ++__j)
+        {
+            __pool& __p = __pools_[__j];
+            __p.__free_ = 0;
+            __p.__cur_ = 0;
+            __p.__end_ = 0;
+            __p.__chunks_ = 0;
+            __p.__next_blocks_ = 0;
+        }
+    }
+    __pool& __p = __pools_[__i];
+    size_t __block = __min_block << __i;
+    size_t __max_blocks = __opts_.max_blocks_per_chunk;
+    size_t __blocks = __p.__next_blocks_;
+    if (__blocks == 0)
+    {
+        __blocks = __first_chunk_bytes / __block;
+        if (__blocks < __first_chunk_blocks)
+            __blocks = __first_chunk_blocks;
+    }
+    if (__blocks > __max_blocks)
+        __blocks = __max_blocks;
+    size_t __align = __block < __max_align ? __block : __max_align;
+    size_t __size = __blocks * __block + sizeof(__chunk);
+    char* __start = static_cast<char*>(__upstream_->allocate(__size, __align));
+    __chunk* __c = reinterpret_cast<__chunk*>(__start + __blocks * __block);
+    __c->__next_ = __p.__chunks_;
+    __c->__prev_ = 0;
+    __c->__start_ = __start;
+    __c->__size_ = __size;
+    __c->__align_ = __align;
+    __p.__chunks_ = __c;
+    __p.__cur_ = __start + __block;
+    __p.__end_ = __start + __blocks * __block;
+    __p.__next_blocks_ = __blocks < __max_blocks / 2 ? 2 * __blocks : __max_blocks;
+    return __start;
+}
+
+void*
+unsynchronized_pool_resource::__allocate_large(size_t __bytes, size_t __align)
+{
+    const size_t __chunk_align = alignment_of<__chunk>::value;
+    if (__bytes > numeric_limits<size_t>::max() - __chunk_align - sizeof(__chunk))
+        __throw_bad_alloc();
+    size_t __off = __round_up(__bytes, __chunk_align);
+    size_t __size = __off + sizeof(__chunk);
+    if (__align < __chunk_align)
+        __align = __chunk_align;
+    char* __start = static_cast<char*>(__upstream_->allocate(__size, __align));
+    __chunk* __c = reinterpret_cast<__chunk*>(__start + __off);
+    __c->__next_ = __large_;
+    __c->__prev_ = 0;
+    __c->__start_ = __start;
+    __c->__size_ = __size;
+    __c->__align_ = __align;
+    if (__large_ != 0)
+        __large_->__prev_ = __c;
+    __large_ = __c;
+    return __start;
+}
+
+void
+unsynchronized_pool_resource::do_deallocate(void* __p, size_t __bytes,
+                                            size_t __align)
+{
+    int __i = __pool_index(__bytes, __align);
+    if (__i == __num_pools_)
+    {
+        __deallocate_large(__p, __bytes);
+        return;
+    }
+    __pool& __pl = __pools_[__i];
+    *static_cast<void**>(__p) = __pl.__free_;
+    __pl.__free_ = __p;
+}
+
+void
+unsynchronized_pool_resource::__deallocate_large(void* __p, size_t __bytes)
+{
+    __chunk* __c = reinterpret_cast<__chunk*>(static_cast<char*>(__p) +
+        __round_up(__bytes, alignment_of<__chunk>::value));
+    if (__c->__prev_ != 0)
+        __c->__prev_->__next_ = __c->__next_;
+    else
+        __large_ = __c->__next_;
+    if (__c->__next_ != 0)
+        __c->__next_->__prev_ = __c->__prev_;
+    __upstream_->deallocate(__c->__start_, __c->__size_, __c->__align_);
+}
+
+bool
+unsynchronized_pool_resource::do_is_equal(const memory_resource& __other) const _NOEXCEPT
+{
+    return this == &__other;
+}
+
+// synchronized_pool_resource
+
+synchronized_pool_resource::~synchronized_pool_resource()
+{
+}
+
+void
+synchronized_pool_resource::release()
+{
+#ifndef _LIBCPP_HAS_NO_THREADS
+    lock_guard<mutex> __lk(__mut_);
+#endif
+    __unsync_.release();
+}
+
+void*
+synchronized_pool_resource::do_allocate(size_t __bytes, size_t __align)
+{
+#ifndef _LIBCPP_HAS_NO_THREADS
+    lock_guard<mutex> __lk(__mut_);
+#endif
+    return __unsync_.allocate(__bytes, __align);
+}
+
+void
+synchronized_pool_resource::do_deallocate(void* __p, size_t __bytes,
+                                          size_t __align)
+{
+#ifndef _LIBCPP_HAS_NO_THREADS
+    lock_guard<mutex> __lk(__mut_);
+#endif
+    __unsync_.deallocate(__p, __bytes, __align);
+}
+
+bool
+synchronized_pool_resource::do_is_equal(const memory_resource& __other) const _NOEXCEPT
+{
+    return this == &__other;
+}
+
+// monotonic_buffer_resource
+
+struct monotonic_buffer_resource::__chunk
+{
+    __chunk* __next_;
+    size_t __size_;
+};
+
+monotonic_buffer_resource::~monotonic_buffer_resource()
+{
+    release();
+}
+
+void
+monotonic_buffer_resource::release()
+{
+    while (__chunks_ != 0)
+    {
+        __chunk* __next = __chunks_->__next_;
+        __upstream_->deallocate(__chunks_, __chunks_->__size_, __max_align);
+        __chunks_ = __next;
+    }
+    __cur_ = __buffer_;
+    __end_ = __buffer_ + __buffer_size_;
+    __next_size_ = __initial_size_;
+}
+
+void*
+monotonic_buffer_resource::do_allocate(size_t __bytes, size_t __align)
+{
+    if (void* __r = __bump(__cur_, __end_, __bytes, __align))
+        return __r;
+    const size_t __header = __round_up(sizeof(__chunk), __max_align);
+    size_t __slack = __align > __max_align ? __align : 0;
+    if (__bytes > numeric_limits<size_t>::max() - __header - __slack)
+        __throw_bad_alloc();
+    size_t __size = __header + __bytes + __slack;
+    if (__size < __next_size_)
+        __size = __next_size_;
+    char* __start = static_cast<char*>(__upstream_->allocate(__size, __max_align));
+    __chunk* __c = reinterpret_cast<__chunk*>(__start);
+    __c->__next_ = __chunks_;
+    __c->__size_ = __size;
+    __chunks_ = __c;
+    __cur_ = __start + __header;
+    __end_ = __start + __size;
+    __next_size_ = __size <= numeric_limits<size_t>::max() / 2 ? 2 * __size : __size;
+    return __bump(__cur_, __end_, __bytes, __align);
+}
+
+_LIBCPP_END_NAMESPACE_LFTS_PMR
@@ -9,8 +9,10 @@
 
 #define _LIBCPP_BUILDING_MUTEX
 #include "mutex"
+#include "atomic"
 #include "limits"
 #include "system_error"
+#include "thread"
 #include "cassert"
 
 _LIBCPP_BEGIN_NAMESPACE_STD
@@ -25,9 +27,39 @@ mutex::~mutex()
     pthread_mutex_destroy(&__m_);
 }
 
+// Whether a thread that finds a mutex locked should spin a while before it
+// sleeps: only when the owner can be running on another processor meanwhile.
+static bool
+__spin_on_contention()
+{
+    // 0 until computed, then 1 for no and 2 for yes.
+    static atomic<int> __spin(0);
+    int __s = __spin.load(memory_order_relaxed);
+    if (__s == 0)
+    {
+        __s = thread::hardware_concurrency() > 1 ? 2 : 1;
+        __spin.store(__s, memory_order_relaxed);
+    }
+    return __s == 2;
+}
+
 void
 mutex::lock()
 {
+    // Critical sections are mostly shorter than a trip to sleep in the kernel
+    // and back, so retry with a growing back off first.
+    if (pthread_mutex_trylock(&__m_) == 0)
+        return;
+    if (__spin_on_contention())
+    {
+        for (unsigned __backoff = 1; __backoff <= 128; __backoff <<= 1)
+        {
+            for (unsigned __i = 0; __i < __backoff; ++__i)
+                __libcpp_cpu_relax();
+            if (pthread_mutex_trylock(&__m_) == 0)
+                return;
+        }
+    }
     int ec = pthread_mutex_lock(&__m_);
     if (ec)
         __throw_system_error(ec, "mutex lock failed");
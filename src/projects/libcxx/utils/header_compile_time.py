@@ -0,0 +1,78 @@
+#!/usr/bin/env python
+"""header_compile_time.py measures what including each libc++ header costs.
+
+For each header it reports the lines a translation unit including only that
+header preprocesses to, and the best time of a few runs of the compiler
+checking its syntax.  Run it on two trees to compare headers' costs.
+ex: python utils/header_compile_time.py --cxx clang++ --std c++11 \
+        --include include vector string algorithm
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+
+def public_headers(include_dir):
+    headers = []
+    for name in sorted(os.listdir(include_dir)):
+        path = os.path.join(include_dir, name)
+        if (name.startswith('_') or name.endswith('.h') or '.' in name or
+                name == 'CMakeLists.txt' or not os.path.isfile(path)):
+            continue
+        headers.append(name)
+    return headers
+
+
+def compile_header(args, header, action):
+    cmd = [args.cxx, '-std=' + args.std, '-nostdinc++',
+           '-I' + args.include] + args.flags + action + ['-x', 'c++', '-']
+    proc = subprocess.Popen(cmd, stdin=subprocess.PIPE,
+                            stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    out, err = proc.communicate(('#include <%s>\n' % header).encode())
+    if proc.returncode != 0:
+        sys.stderr.write('%s failed:\n%s' % (header, err.decode()))
+        return None
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--cxx', default='c++')
+    parser.add_argument('--std', default='c++11')
+    parser.add_argument('--include', required=True,
+                        help='the libc++ include directory')
+    parser.add_argument('--runs', type=int, default=5)
+    parser.add_argument('--flag', dest='flags', action='append', default=[],
+                        help='an extra compiler flag, may be repeated')
+    parser.add_argument('headers', nargs='*',
+                        help='the headers to measure, all public ones if none')
+    args = parser.parse_args()
+
+    headers = args.headers or public_headers(args.include)
+    total = 0.0
+    print('%-24s %10s %10s' % ('header', 'lines', 'ms'))
+    for header in headers:
+        out = compile_header(args, header, ['-E', '-P'])
+        if out is None:
+            continue
+        lines = out.count(b'\n')
+        best = None
+        for _ in range(args.runs):
+            start = time.time()
+            if compile_header(args, header, ['-fsyntax-only']) is None:
+                break
+            elapsed = time.time() - start
+            best = elapsed if best is None else min(best, elapsed)
+        if best is None:
+            continue
+        total += best
+        print('%-24s %10d %10.1f' % (header, lines, best * 1000))
+    print('%-24s %10s %10.1f' % ('total', '', total * 1000))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
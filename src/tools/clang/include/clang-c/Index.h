@@ -32,7 +32,7 @@
  * compatible, thus CINDEX_VERSION_MAJOR is expected to remain stable.
  */
 #define CINDEX_VERSION_MAJOR 0
-#define CINDEX_VERSION_MINOR 29
+#define CINDEX_VERSION_MINOR 32
 
 #define CINDEX_VERSION_ENCODE(major, minor) ( \
       ((major) * 10000)                       \
@@ -1391,7 +1391,20 @@ enum CXReparse_Flags {
   /**
    * \brief Used to indicate that no special reparsing options are needed.
    */
-  CXReparse_None = 0x0
+  CXReparse_None = 0x0,
+
+  /**
+   * \brief Used to indicate that the bodies of functions in the main file
+   * that were not touched by the edits since the last parse should not be
+   * parsed again.
+   *
+   * Only the definitions overlapping the edited region of the main file are
+   * re-parsed; the diagnostics previously reported within the skipped bodies
+   * are carried over. The skipped bodies are not available to cursor
+   * traversal, and changes elsewhere that affect their meaning are not
+   * diagnosed until the next full reparse.
+   */
+  CXReparse_SkipUnchangedFunctionBodies = 0x01
 };
  
 /**
@@ -4823,6 +4836,39 @@ CXCodeCompleteResults *clang_codeCompleteAt(CXTranslationUnit TU,
                                             unsigned num_unsaved_files,
                                             unsigned options);
 
+/**
+ * \brief Perform code completion at a given location in a translation unit,
+ * keeping only the results that match the text typed so far.
+ *
+ * This behaves like \c clang_codeCompleteAt(), except that the filtering
+ * that clients would otherwise perform on every result is done inside Clang,
+ * before the completion strings are built. Results that do not match are
+ * never materialized, which matters when completing in contexts with many
+ * thousands of candidates.
+ *
+ * \param prefix If non-NULL and non-empty, only results whose typed text
+ * starts with \p prefix (compared case-insensitively) are returned.
+ *
+ * \param max_results If non-zero, at most this many results are returned.
+ * When more results match, the ones with the best (lowest) priority are
+ * kept, ties being broken alphabetically. The returned results are not
+ * otherwise sorted.
+ *
+ * The remaining parameters and the return value are as for
+ * \c clang_codeCompleteAt().
+ */
+CINDEX_LINKAGE
+CXCodeCompleteResults *
+clang_codeCompleteAtWithPrefix(CXTranslationUnit TU,
+                               const char *complete_filename,
+                               unsigned complete_line,
+                               unsigned complete_column,
+                               struct CXUnsavedFile *unsaved_files,
+                               unsigned num_unsaved_files,
+                               unsigned options,
+                               const char *prefix,
+                               unsigned max_results);
+
 /**
  * \brief Sort the code-completion results in case-insensitive alphabetical 
  * order.
@@ -5582,7 +5628,17 @@ typedef enum {
    * indexing session associated with a \c CXIndexAction object.
    * Bodies in system headers are always skipped.
    */
-  CXIndexOpt_SkipParsedBodiesInSession = 0x10
+  CXIndexOpt_SkipParsedBodiesInSession = 0x10,
+
+  /**
+   * \brief Do not report declarations and references in a header that was
+   * already indexed during an indexing session associated with a
+   * \c CXIndexAction object, by a translation unit with the same command line
+   * configuration. Only headers with a multiple-include guard are skipped.
+   * The inclusion of such a header is still reported through
+   * IndexerCallbacks#ppIncludedFile.
+   */
+  CXIndexOpt_SkipIndexedHeadersInSession = 0x20
 
 } CXIndexOptFlags;
 
@@ -5624,6 +5680,64 @@ CINDEX_LINKAGE int clang_indexSourceFile(CXIndexAction,
                                          CXTranslationUnit *out_TU,
                                          unsigned TU_options);
 
+/**
+ * \brief A source file to index with #clang_indexSourceFiles.
+ */
+typedef struct {
+  /**
+   * \brief Data supplied by the client, passed to the callbacks invoked for
+   * this source file.
+   */
+  CXClientData client_data;
+  /**
+   * \brief The same as the corresponding parameters of
+   * #clang_indexSourceFile.
+   */
+  const char *source_filename;
+  const char * const *command_line_args;
+  int num_command_line_args;
+  struct CXUnsavedFile *unsaved_files;
+  unsigned num_unsaved_files;
+  /**
+   * \brief On return, the value #clang_indexSourceFile returned for this
+   * source file.
+   */
+  int result;
+} CXIndexSourceFileJob;
+
+/**
+ * \brief Index the given source files concurrently on a pool of worker
+ * threads, via callbacks implemented through #IndexerCallbacks.
+ *
+ * Each source file is indexed as by #clang_indexSourceFile, with the
+ * \c client_data of its job. Callbacks are invoked from worker threads, but
+ * never concurrently with each other, so the client needs no locking of its
+ * own. The callbacks of different source files may interleave.
+ *
+ * Passing \c CXIndexOpt_SkipIndexedHeadersInSession avoids reporting the
+ * same headers for every source file.
+ *
+ * \param jobs The source files to index.
+ *
+ * \param num_jobs The number of entries in \p jobs.
+ *
+ * \param num_threads The maximum number of source files to index at the
+ * same time, or 0 to use the number of hardware threads.
+ *
+ * \returns 0 if every source file was indexed successfully, otherwise a
+ * non-zero \c CXErrorCode; the result of each source file is stored in its
+ * job.
+ *
+ * The rest of the parameters are the same as #clang_indexSourceFile.
+ */
+CINDEX_LINKAGE int clang_indexSourceFiles(CXIndexAction,
+                                          IndexerCallbacks *index_callbacks,
+                                          unsigned index_callbacks_size,
+                                          unsigned index_options,
+                                          CXIndexSourceFileJob *jobs,
+                                          unsigned num_jobs,
+                                          unsigned num_threads);
+
 /**
  * \brief Index the given translation unit via callbacks implemented through
  * #IndexerCallbacks.
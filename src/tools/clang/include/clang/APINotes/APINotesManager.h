@@ -56,6 +56,11 @@ class APINotesManager {
   /// reader for this directory.
   llvm::DenseMap<const DirectoryEntry *, ReaderEntry> Readers;
 
+  /// The file of the last location API notes were looked up for, and the
+  /// API notes reader found for it.
+  FileID LastFile;
+  APINotesReader *LastReader;
+
   /// Load the given API notes file for the given header directory.
   ///
   /// \param HeaderDir The directory at which we
@@ -77,6 +82,9 @@ class APINotesManager {
                                               llvm::StringRef FrameworkName,
                                               bool Public);
 
+  /// Find the API notes reader for the declarations in the given file.
+  APINotesReader *findAPINotes(const FileEntry *File);
+
 public:
   APINotesManager(SourceManager &SourceMgr);
   ~APINotesManager();
@@ -66,6 +66,22 @@ public:
   Optional<std::pair<ContextID, ObjCContextInfo>>
   lookupObjCProtocol(StringRef name);
 
+  /// Look for the context ID of the given Objective-C class, remembering
+  /// the answer for the next lookup.
+  ///
+  /// \param name The name of the class we're looking for.
+  ///
+  /// \returns The ID of the class, if known.
+  Optional<ContextID> lookupObjCClassID(StringRef name);
+
+  /// Look for the context ID of the given Objective-C protocol, remembering
+  /// the answer for the next lookup.
+  ///
+  /// \param name The name of the protocol we're looking for.
+  ///
+  /// \returns The ID of the protocol, if known.
+  Optional<ContextID> lookupObjCProtocolID(StringRef name);
+
   /// Look for information regarding the given Objective-C property in
   /// the given context.
   ///
@@ -36,6 +36,7 @@
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/Support/Allocator.h"
 #include <memory>
@@ -84,51 +85,65 @@ namespace clang {
         : Width(Width), Align(Align), AlignIsRequired(AlignIsRequired) {}
   };
 
+  /// \brief The value of a call to a constexpr function that only depends on
+  /// its arguments, with what it took to evaluate it.
+  struct ConstexprCallResult {
+    APValue Value;
+    /// \brief The number of evaluation steps the call took.
+    unsigned Steps;
+    /// \brief The depth of the deepest call in the evaluation, relative to
+    /// the depth of the caller.
+    unsigned Depth;
+  };
+
 /// \brief Holds long-lived AST nodes (such as types and decls) that can be
 /// referred to throughout the semantic analysis of a file.
 class ASTContext : public RefCountedBase<ASTContext> {
   ASTContext &this_() { return *this; }
 
   mutable SmallVector<Type *, 0> Types;
-  mutable llvm::FoldingSet<ExtQuals> ExtQualNodes;
-  mutable llvm::FoldingSet<ComplexType> ComplexTypes;
-  mutable llvm::FoldingSet<PointerType> PointerTypes;
-  mutable llvm::FoldingSet<AdjustedType> AdjustedTypes;
-  mutable llvm::FoldingSet<BlockPointerType> BlockPointerTypes;
-  mutable llvm::FoldingSet<LValueReferenceType> LValueReferenceTypes;
-  mutable llvm::FoldingSet<RValueReferenceType> RValueReferenceTypes;
-  mutable llvm::FoldingSet<MemberPointerType> MemberPointerTypes;
-  mutable llvm::FoldingSet<ConstantArrayType> ConstantArrayTypes;
-  mutable llvm::FoldingSet<IncompleteArrayType> IncompleteArrayTypes;
+  mutable llvm::HashedFoldingSet<ExtQuals> ExtQualNodes;
+  mutable llvm::HashedFoldingSet<ComplexType> ComplexTypes;
+  mutable llvm::HashedFoldingSet<PointerType> PointerTypes;
+  mutable llvm::HashedFoldingSet<AdjustedType> AdjustedTypes;
+  mutable llvm::HashedFoldingSet<BlockPointerType> BlockPointerTypes;
+  mutable llvm::HashedFoldingSet<LValueReferenceType> LValueReferenceTypes;
+  mutable llvm::HashedFoldingSet<RValueReferenceType> RValueReferenceTypes;
+  mutable llvm::HashedFoldingSet<MemberPointerType> MemberPointerTypes;
+  mutable llvm::HashedFoldingSet<ConstantArrayType> ConstantArrayTypes;
+  mutable llvm::HashedFoldingSet<IncompleteArrayType> IncompleteArrayTypes;
   mutable std::vector<VariableArrayType*> VariableArrayTypes;
-  mutable llvm::FoldingSet<DependentSizedArrayType> DependentSizedArrayTypes;
-  mutable llvm::FoldingSet<DependentSizedExtVectorType>
+  mutable llvm::HashedFoldingSet<DependentSizedArrayType>
+    DependentSizedArrayTypes;
+  mutable llvm::HashedFoldingSet<DependentSizedExtVectorType>
     DependentSizedExtVectorTypes;
-  mutable llvm::FoldingSet<VectorType> VectorTypes;
-  mutable llvm::FoldingSet<FunctionNoProtoType> FunctionNoProtoTypes;
-  mutable llvm::ContextualFoldingSet<FunctionProtoType, ASTContext&>
+  mutable llvm::HashedFoldingSet<VectorType> VectorTypes;
+  mutable llvm::HashedFoldingSet<FunctionNoProtoType> FunctionNoProtoTypes;
+  mutable llvm::HashedContextualFoldingSet<FunctionProtoType, ASTContext&>
     FunctionProtoTypes;
-  mutable llvm::FoldingSet<DependentTypeOfExprType> DependentTypeOfExprTypes;
-  mutable llvm::FoldingSet<DependentDecltypeType> DependentDecltypeTypes;
-  mutable llvm::FoldingSet<TemplateTypeParmType> TemplateTypeParmTypes;
-  mutable llvm::FoldingSet<SubstTemplateTypeParmType>
+  mutable llvm::HashedFoldingSet<DependentTypeOfExprType>
+    DependentTypeOfExprTypes;
+  mutable llvm::HashedFoldingSet<DependentDecltypeType> DependentDecltypeTypes;
+  mutable llvm::HashedFoldingSet<TemplateTypeParmType> TemplateTypeParmTypes;
+  mutable llvm::HashedFoldingSet<SubstTemplateTypeParmType>
     SubstTemplateTypeParmTypes;
-  mutable llvm::FoldingSet<SubstTemplateTypeParmPackType>
+  mutable llvm::HashedFoldingSet<SubstTemplateTypeParmPackType>
     SubstTemplateTypeParmPackTypes;
-  mutable llvm::ContextualFoldingSet<TemplateSpecializationType, ASTContext&>
+  mutable llvm::HashedContextualFoldingSet<TemplateSpecializationType,
+                                           ASTContext&>
     TemplateSpecializationTypes;
-  mutable llvm::FoldingSet<ParenType> ParenTypes;
-  mutable llvm::FoldingSet<ElaboratedType> ElaboratedTypes;
-  mutable llvm::FoldingSet<DependentNameType> DependentNameTypes;
-  mutable llvm::ContextualFoldingSet<DependentTemplateSpecializationType,
-                                     ASTContext&>
+  mutable llvm::HashedFoldingSet<ParenType> ParenTypes;
+  mutable llvm::HashedFoldingSet<ElaboratedType> ElaboratedTypes;
+  mutable llvm::HashedFoldingSet<DependentNameType> DependentNameTypes;
+  mutable llvm::HashedContextualFoldingSet<DependentTemplateSpecializationType,
+                                           ASTContext&>
     DependentTemplateSpecializationTypes;
-  llvm::FoldingSet<PackExpansionType> PackExpansionTypes;
-  mutable llvm::FoldingSet<ObjCObjectTypeImpl> ObjCObjectTypes;
-  mutable llvm::FoldingSet<ObjCObjectPointerType> ObjCObjectPointerTypes;
-  mutable llvm::FoldingSet<AutoType> AutoTypes;
-  mutable llvm::FoldingSet<AtomicType> AtomicTypes;
-  llvm::FoldingSet<AttributedType> AttributedTypes;
+  llvm::HashedFoldingSet<PackExpansionType> PackExpansionTypes;
+  mutable llvm::HashedFoldingSet<ObjCObjectTypeImpl> ObjCObjectTypes;
+  mutable llvm::HashedFoldingSet<ObjCObjectPointerType> ObjCObjectPointerTypes;
+  mutable llvm::HashedFoldingSet<AutoType> AutoTypes;
+  mutable llvm::HashedFoldingSet<AtomicType> AtomicTypes;
+  llvm::HashedFoldingSet<AttributedType> AttributedTypes;
 
   mutable llvm::FoldingSet<QualifiedTemplateName> QualifiedTemplateNames;
   mutable llvm::FoldingSet<DependentTemplateName> DependentTemplateNames;
@@ -180,6 +195,10 @@ class ASTContext : public RefCountedBase<ASTContext> {
   llvm::DenseMap<const MaterializeTemporaryExpr*, APValue>
     MaterializedTemporaryValues;
 
+  /// \brief Mapping from constexpr function calls, identified by the function
+  /// and the values of their arguments, to their evaluated values.
+  llvm::StringMap<ConstexprCallResult> ConstexprCallResults;
+
   /// \brief Representation of a "canonical" template template parameter that
   /// is used in canonical template names.
   class CanonicalTemplateTemplateParm : public llvm::FoldingSetNode {
@@ -496,6 +515,30 @@ public:
     return BumpAlloc.Allocate(Size, Align);
   }
   void Deallocate(void *Ptr) const { }
+
+  /// \brief The kinds of AST nodes whose memory is accounted for separately
+  /// by PrintAllocationStats().
+  ///
+  /// Types are not listed: their memory is derived from the list of types.
+  enum ASTAllocationKind {
+    AAK_Decl,
+    AAK_Stmt,
+    AAK_TypeLoc,
+    AAK_Attr,
+    NumASTAllocationKinds
+  };
+
+  /// \brief Note that \p Size bytes were allocated for AST nodes of the given
+  /// kind.
+  void noteAllocation(ASTAllocationKind Kind, size_t Size) const {
+    AllocatedBytes[Kind] += Size;
+  }
+
+private:
+  /// \brief The number of bytes allocated for each kind of AST node.
+  mutable uint64_t AllocatedBytes[NumASTAllocationKinds];
+
+public:
   
   /// Return the total amount of physical memory allocated for representing
   /// AST nodes and type information.
@@ -855,6 +898,10 @@ public:
   ASTMutationListener *getASTMutationListener() const { return Listener; }
 
   void PrintStats() const;
+
+  /// \brief Print how the memory allocated for the AST is split between the
+  /// kinds of AST nodes.
+  void PrintAllocationStats(raw_ostream &OS) const;
   const SmallVectorImpl<Type *>& getTypes() const { return Types; }
 
   /// \brief Create a new implicit TU-level CXXRecordDecl or RecordDecl
@@ -2276,6 +2323,10 @@ public:
   APValue *getMaterializedTemporaryValue(const MaterializeTemporaryExpr *E,
                                          bool MayCreate);
 
+  /// \brief Get the evaluated value of the constexpr function call identified
+  /// by \p Key, or the storage for it if \p MayCreate is true.
+  ConstexprCallResult *getConstexprCallResult(StringRef Key, bool MayCreate);
+
   //===--------------------------------------------------------------------===//
   //                    Statistics
   //===--------------------------------------------------------------------===//
@@ -2321,6 +2372,16 @@ public:
   /// \brief The number of implicitly-declared destructors for which 
   /// declarations were built.
   static unsigned NumImplicitDestructorsDeclared;
+
+  /// \brief The number of calls to constexpr functions evaluated.
+  static unsigned NumConstexprCalls;
+
+  /// \brief The number of calls to constexpr functions whose value was
+  /// found in the cache of evaluated calls.
+  static unsigned NumConstexprCallsCached;
+
+  /// \brief The number of steps taken by the constant evaluator.
+  static uint64_t NumConstexprSteps;
   
 private:
   ASTContext(const ASTContext &) LLVM_DELETED_FUNCTION;
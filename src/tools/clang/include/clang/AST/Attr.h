@@ -65,9 +65,7 @@ protected:
 public:
   // Forward so that the regular new and delete do not hide global ones.
   void* operator new(size_t Bytes, ASTContext &C,
-                     size_t Alignment = 16) throw() {
-    return ::operator new(Bytes, C, Alignment);
-  }
+                     size_t Alignment = 16) throw();
   void operator delete(void *Ptr, ASTContext &C,
                        size_t Alignment) throw() {
     return ::operator delete(Ptr, C, Alignment);
@@ -131,6 +131,10 @@ protected:
   };
   enum { NumStmtBits = 8 };
 
+  // The bitfields below that end in a SourceLocation keep its raw encoding in
+  // the second word of the union, which is padding on 64-bit hosts anyway.
+  // This keeps the most common nodes a pointer smaller.
+
   class CompoundStmtBitfields {
     friend class CompoundStmt;
     unsigned : NumStmtBits;
@@ -138,6 +142,14 @@ protected:
     unsigned NumStmts : 32 - NumStmtBits;
   };
 
+  class ReturnStmtBitfields {
+    friend class ReturnStmt;
+    unsigned : NumStmtBits;
+
+    /// \brief The location of the 'return' keyword.
+    unsigned RetLoc;
+  };
+
   class ExprBitfields {
     friend class Expr;
     friend class DeclRefExpr; // computeDependence
@@ -213,6 +225,35 @@ protected:
     unsigned HasFoundDecl : 1;
     unsigned HadMultipleCandidates : 1;
     unsigned RefersToEnclosingVariableOrCapture : 1;
+
+    /// \brief The location of the declaration name itself.
+    unsigned Loc;
+  };
+
+  class UnaryOperatorBitfields {
+    friend class UnaryOperator;
+    unsigned : NumExprBits;
+
+    unsigned Opc : 5;
+
+    /// \brief The location of the operator.
+    unsigned Loc;
+  };
+
+  class BinaryOperatorBitfields {
+    friend class BinaryOperator;
+    unsigned : NumExprBits;
+
+    unsigned Opc : 6;
+
+    // Records the FP_CONTRACT pragma status at the point that this binary
+    // operator was parsed. This bit is only meaningful for operations on
+    // floating point types. For all other types it should default to
+    // false.
+    unsigned FPContractable : 1;
+
+    /// \brief The location of the operator.
+    unsigned OpLoc;
   };
 
   class CastExprBitfields {
@@ -287,16 +328,18 @@ protected:
   };
 
   union {
-    // FIXME: this is wasteful on 64-bit platforms.
     void *Aligner;
 
     StmtBitfields StmtBits;
     CompoundStmtBitfields CompoundStmtBits;
+    ReturnStmtBitfields ReturnStmtBits;
     ExprBitfields ExprBits;
     CharacterLiteralBitfields CharacterLiteralBits;
     FloatingLiteralBitfields FloatingLiteralBits;
     UnaryExprOrTypeTraitExprBitfields UnaryExprOrTypeTraitExprBits;
     DeclRefExprBitfields DeclRefExprBits;
+    UnaryOperatorBitfields UnaryOperatorBits;
+    BinaryOperatorBitfields BinaryOperatorBits;
     CastExprBitfields CastExprBits;
     CallExprBitfields CallExprBits;
     ExprWithCleanupsBitfields ExprWithCleanupsBits;
@@ -1346,17 +1389,19 @@ public:
 ///
 class ReturnStmt : public Stmt {
   Stmt *RetExpr;
-  SourceLocation RetLoc;
   const VarDecl *NRVOCandidate;
 
 public:
   ReturnStmt(SourceLocation RL)
-    : Stmt(ReturnStmtClass), RetExpr(nullptr), RetLoc(RL),
-      NRVOCandidate(nullptr) {}
+    : Stmt(ReturnStmtClass), RetExpr(nullptr), NRVOCandidate(nullptr) {
+    setReturnLoc(RL);
+  }
 
   ReturnStmt(SourceLocation RL, Expr *E, const VarDecl *NRVOCandidate)
-    : Stmt(ReturnStmtClass), RetExpr((Stmt*) E), RetLoc(RL),
-      NRVOCandidate(NRVOCandidate) {}
+    : Stmt(ReturnStmtClass), RetExpr((Stmt*) E),
+      NRVOCandidate(NRVOCandidate) {
+    setReturnLoc(RL);
+  }
 
   /// \brief Build an empty return expression.
   explicit ReturnStmt(EmptyShell Empty) : Stmt(ReturnStmtClass, Empty) { }
@@ -1365,8 +1410,12 @@ public:
   Expr *getRetValue();
   void setRetValue(Expr *E) { RetExpr = reinterpret_cast<Stmt*>(E); }
 
-  SourceLocation getReturnLoc() const { return RetLoc; }
-  void setReturnLoc(SourceLocation L) { RetLoc = L; }
+  SourceLocation getReturnLoc() const {
+    return SourceLocation::getFromRawEncoding(ReturnStmtBits.RetLoc);
+  }
+  void setReturnLoc(SourceLocation L) {
+    ReturnStmtBits.RetLoc = L.getRawEncoding();
+  }
 
   /// \brief Retrieve the variable that might be used for the named return
   /// value optimization.
@@ -1376,9 +1425,9 @@ public:
   const VarDecl *getNRVOCandidate() const { return NRVOCandidate; }
   void setNRVOCandidate(const VarDecl *Var) { NRVOCandidate = Var; }
 
-  SourceLocation getLocStart() const LLVM_READONLY { return RetLoc; }
+  SourceLocation getLocStart() const LLVM_READONLY { return getReturnLoc(); }
   SourceLocation getLocEnd() const LLVM_READONLY {
-    return RetExpr ? RetExpr->getLocEnd() : RetLoc;
+    return RetExpr ? RetExpr->getLocEnd() : getReturnLoc();
   }
 
   static bool classof(const Stmt *T) {
@@ -232,6 +232,10 @@ public:
     return FS;
   }
 
+  /// \brief Whether files which don't exist on the file system were added
+  /// with getVirtualFile().
+  bool hasVirtualFiles() const { return !VirtualFileEntries.empty(); }
+
   /// \brief Retrieve a file entry for a "virtual" file that acts as
   /// if there were a file with the given name on disk.
   ///
@@ -241,9 +245,14 @@ public:
 
   /// \brief Open the specified file as a MemoryBuffer, returning a new
   /// MemoryBuffer if successful, otherwise returning null.
+  ///
+  /// Clients that never read past the end of the buffer, such as AST file
+  /// readers, can pass \p RequiresNullTerminator = false so that the file is
+  /// always eligible to be memory mapped rather than copied into the heap.
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
   getBufferForFile(const FileEntry *Entry, bool isVolatile = false,
-                   bool ShouldCloseOpenFile = true);
+                   bool ShouldCloseOpenFile = true,
+                   bool RequiresNullTerminator = true);
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
   getBufferForFile(StringRef Filename);
 
@@ -28,6 +28,10 @@ public:
 
   /// The path to the API notes cache.
   std::string APINotesCachePath;
+
+  /// The file caching the directory listings used to answer the lookups of
+  /// missing files, shared between compiles.
+  std::string DirectoryCacheFile;
 };
 
 } // end namespace clang
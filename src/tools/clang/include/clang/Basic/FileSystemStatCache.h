@@ -19,6 +19,12 @@
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/FileSystem.h"
 #include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+class MemoryBuffer;
+}
 
 namespace clang {
 
@@ -126,6 +132,52 @@ public:
                        vfs::FileSystem &FS) override;
 };
 
+/// \brief A stat cache that answers the lookups of missing files from the
+/// listings of their directories, which it shares with other processes
+/// through a cache file.
+///
+/// A listing stays valid as long as the identity and the modification time
+/// of its directory do not change, so each directory costs one stat per
+/// process instead of one failed stat per file header search tries in it.
+/// The cache file is mapped read-only, and \a save() replaces it atomically.
+///
+/// Names are compared ignoring ASCII case, so that lookups which could
+/// succeed on a case-insensitive file system go to the file system, as do
+/// the names with other characters than ASCII ones.
+class DirectoryListingStatCache : public FileSystemStatCache {
+  struct Listing;
+  class OnDiskTable;
+
+  std::string CacheFile;
+  std::string WorkingDir;
+  std::vector<std::string> VolatileDirs;
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  std::unique_ptr<OnDiskTable> Table;
+  llvm::StringMap<Listing> Listings;
+  bool Modified;
+
+  Listing *getListing(StringRef Dir, vfs::FileSystem &FS);
+
+public:
+  /// \brief Use the listings of \p CacheFile, if it exists.
+  explicit DirectoryListingStatCache(StringRef CacheFile);
+  ~DirectoryListingStatCache() override;
+
+  /// \brief Never use listings for the directories under \p Dir, which the
+  /// client writes to while using the cache.
+  void addVolatileDirectory(StringRef Dir);
+
+  /// \brief Write the listings computed by this process, and the ones of the
+  /// cache file it did not replace, to the cache file.
+  ///
+  /// \returns true on error.
+  bool save();
+
+  LookupResult getStat(const char *Path, FileData &Data, bool isFile,
+                       std::unique_ptr<vfs::File> *F,
+                       vfs::FileSystem &FS) override;
+};
+
 } // end namespace clang
 
 #endif
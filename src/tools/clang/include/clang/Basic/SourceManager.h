@@ -438,6 +438,16 @@ namespace SrcMgr {
     }
   };
 }  // end SrcMgr namespace.
+}  // end namespace clang
+
+namespace llvm {
+  template <>
+  struct isPodLike<clang::SrcMgr::SLocEntry> {
+    static const bool value = true;
+  };
+}  // end namespace llvm
+
+namespace clang {
 
 /// \brief External source of source location entries.
 class ExternalSLocEntrySource {
@@ -16,10 +16,12 @@
 #include "clang/Basic/LLVM.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/raw_ostream.h"
+#include <vector>
 
 namespace llvm {
 class MemoryBuffer;
@@ -241,6 +243,70 @@ public:
   iterator overlays_end() { return FSList.rend(); }
 };
 
+class CachedFile;
+
+/// \brief A file system that remembers the status and the contents of the
+/// files of another file system, for clients that outlive many similar uses
+/// of it, such as a compile server.
+///
+/// Within a generation, started by \a revalidate(), every path is looked up
+/// in the underlying file system at most once. A later generation checks
+/// existing entries again with a single status, and reads the contents again
+/// only when the size, modification time or identity of the file changed. A
+/// missing entry stays missing as long as its parent directory has not been
+/// modified, so that the failed lookups of header search only cost the
+/// status of their directories.
+///
+/// Files under the volatile directories, which the client writes while using
+/// the cache, are looked up every time. This is not thread-safe, and the
+/// buffers returned refer to the cache until the next \a revalidate().
+class CachingFileSystem : public FileSystem {
+  struct StatusEntry;
+  struct ParentStamp;
+  struct ContentsEntry;
+  friend class CachedFile;
+
+public:
+  /// \brief Cache \p Base, keeping the contents the last generations used up
+  /// to \p MaxContentsSize bytes, or all of them if 0.
+  explicit CachingFileSystem(IntrusiveRefCntPtr<FileSystem> Base,
+                             uint64_t MaxContentsSize = 0);
+  ~CachingFileSystem();
+
+  /// \brief Start a new generation: check the entries against the underlying
+  /// file system again the next time they are used, and take the current
+  /// working directory into account for relative paths.
+  void revalidate();
+
+  /// \brief Never cache the status of the entries under \p Dir.
+  void addVolatileDirectory(StringRef Dir);
+
+  llvm::ErrorOr<Status> status(const Twine &Path) override;
+  llvm::ErrorOr<std::unique_ptr<File>>
+  openFileForRead(const Twine &Path) override;
+  directory_iterator dir_begin(const Twine &Dir, std::error_code &EC) override;
+
+private:
+  std::string makeAbsolute(const Twine &Path) const;
+  bool isVolatile(StringRef AbsPath) const;
+  StatusEntry *lookupEntry(StringRef AbsPath);
+  llvm::ErrorOr<Status> lookup(StringRef AbsPath);
+  ParentStamp getParentStamp(StringRef AbsPath);
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+  getBuffer(StringRef AbsPath, const Status &S, const Twine &Name,
+            bool RequiresNullTerminator, bool IsVolatile);
+  void pruneContents();
+
+  IntrusiveRefCntPtr<FileSystem> Base;
+  std::string WorkingDir;
+  std::vector<std::string> VolatileDirs;
+  unsigned Generation;
+  llvm::StringMap<StatusEntry> Statuses;
+  llvm::StringMap<ContentsEntry> Contents;
+  uint64_t ContentsSize;
+  uint64_t MaxContentsSize;
+};
+
 /// \brief Get a globally unique ID for a virtual file or directory.
 llvm::sys::fs::UniqueID getNextVirtualUniqueID();
 
@@ -172,13 +172,21 @@ public:
   void ExecuteJob(const Job &J,
      SmallVectorImpl< std::pair<int, const Command *> > &FailingCommands) const;
 
+  /// ExecuteJobsInParallel - Execute \p Commands, running up to
+  /// Driver::getParallelJobs() of them at the same time.
+  ///
+  /// \param FailingCommands - For non-zero results, this will be a vector of
+  /// failing commands and their associated result code.
+  void ExecuteJobsInParallel(ArrayRef<const Command *> Commands,
+     SmallVectorImpl< std::pair<int, const Command *> > &FailingCommands) const;
+
   /// initCompilationForDiagnostics - Remove stale state and suppress output
   /// so compilation can be reexecuted to generate additional diagnostic
   /// information (e.g., preprocessed source(s)).
   void initCompilationForDiagnostics();
 
   /// Return true if we're compiling for diagnostics.
-  bool isForDiagnostics() { return ForDiagnostics; }
+  bool isForDiagnostics() const { return ForDiagnostics; }
 };
 
 } // end namespace driver
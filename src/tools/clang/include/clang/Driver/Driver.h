@@ -73,6 +73,9 @@ class Driver {
     EmbedBitcode
   } BitcodeEmbed;
 
+  /// The number of independent commands to run at the same time.
+  unsigned ParallelJobs;
+
 public:
   // Diag - Forwarding function for diagnostics.
   DiagnosticBuilder Diag(unsigned DiagID) const {
@@ -163,6 +166,12 @@ public:
   /// Whether the driver is generating diagnostics for debugging purposes.
   unsigned CCGenDiagnostics : 1;
 
+  /// The entry point of clang -cc1 in the driver executable, given the
+  /// arguments of the command including the executable. When set, cc1 runs
+  /// within the driver process when that is safe.
+  typedef int (*CC1ToolFunc)(ArrayRef<const char *> Argv);
+  CC1ToolFunc CC1Main;
+
 private:
   /// Name to use when invoking gcc/g++.
   std::string CCCGenericGCCName;
@@ -252,6 +261,8 @@ public:
   bool embedBitcodeEnabled() const { return BitcodeEmbed == EmbedBitcode; }
   bool embedBitcodeMarkerOnly() const { return BitcodeEmbed == EmbedMarker; }
 
+  unsigned getParallelJobs() const { return ParallelJobs; }
+
   /// @}
   /// @name Primary Functionality
   /// @{
@@ -42,6 +42,7 @@ class Job {
 public:
   enum JobClass {
     CommandClass,
+    CC1CommandClass,
     FallbackCommandClass,
     JobListClass
   };
@@ -85,6 +86,9 @@ class Command : public Job {
   /// The list of program arguments which are inputs.
   llvm::opt::ArgStringList InputFilenames;
 
+  /// The file the action of this job produces, or nullptr if unknown.
+  const char *OutputFilename;
+
   /// Response file name, if this command is set to use one, or nullptr
   /// otherwise
   const char *ResponseFile;
@@ -109,6 +113,11 @@ class Command : public Job {
   /// The results are the contents of a response file, written into a raw_ostream.
   void writeResponseFile(raw_ostream &OS) const;
 
+protected:
+  Command(JobClass Kind, const Action &Source, const Tool &Creator,
+          const char *Executable, const llvm::opt::ArgStringList &Arguments,
+          ArrayRef<InputInfo> Inputs);
+
 public:
   Command(const Action &Source, const Tool &Creator, const char *Executable,
           const llvm::opt::ArgStringList &Arguments,
@@ -140,15 +149,48 @@ public:
 
   const llvm::opt::ArgStringList &getArguments() const { return Arguments; }
 
+  const llvm::opt::ArgStringList &getInputFilenames() const {
+    return InputFilenames;
+  }
+
+  /// Set the file the action of this job produces, so that the jobs reading
+  /// it can be ordered after this one when jobs run in parallel.
+  void setOutputFilename(const char *FileName) { OutputFilename = FileName; }
+
+  const char *getOutputFilename() const { return OutputFilename; }
+
   /// Print a command argument, and optionally quote it.
   static void printArg(llvm::raw_ostream &OS, const char *Arg, bool Quote);
 
   static bool classof(const Job *J) {
     return J->getKind() == CommandClass ||
+           J->getKind() == CC1CommandClass ||
            J->getKind() == FallbackCommandClass;
   }
 };
 
+/// Like Command, but for clang -cc1, which can run within the driver process
+/// instead of spawning a new one.
+class CC1Command : public Command {
+public:
+  CC1Command(const Action &Source_, const Tool &Creator_,
+             const char *Executable_, const ArgStringList &Arguments_,
+             ArrayRef<InputInfo> Inputs, bool InProcess);
+
+  /// Whether the command runs within the driver process.
+  bool isInProcess() const { return InProcess; }
+
+  int Execute(const StringRef **Redirects, std::string *ErrMsg,
+              bool *ExecutionFailed) const override;
+
+  static bool classof(const Job *J) {
+    return J->getKind() == CC1CommandClass;
+  }
+
+private:
+  bool InProcess;
+};
+
 /// Like Command, but with a fallback which is executed in case
 /// the primary command crashes.
 class FallbackCommand : public Command {
@@ -70,6 +70,14 @@ struct FormatStyle {
   /// \brief The maximum number of consecutive empty lines to keep.
   unsigned MaxEmptyLinesToKeep;
 
+  /// \brief The number of formatting states explored when searching for the
+  /// best line breaks of a line, after which each remaining token is placed
+  /// where it costs least at that point.
+  ///
+  /// A limit of \c 0 means the search is unbounded. Long initializer lists
+  /// and deeply nested calls can take seconds to format without a limit.
+  unsigned MaxLineFormattingStates;
+
   /// \brief If true, empty lines at the start of blocks are kept.
   bool KeepEmptyLinesAtTheStartOfBlocks;
 
@@ -447,6 +455,7 @@ struct FormatStyle {
            IndentWrappedFunctionNames == R.IndentWrappedFunctionNames &&
            IndentWidth == R.IndentWidth && Language == R.Language &&
            MaxEmptyLinesToKeep == R.MaxEmptyLinesToKeep &&
+           MaxLineFormattingStates == R.MaxLineFormattingStates &&
            KeepEmptyLinesAtTheStartOfBlocks ==
                R.KeepEmptyLinesAtTheStartOfBlocks &&
            NamespaceIndentation == R.NamespaceIndentation &&
@@ -554,6 +563,47 @@ tooling::Replacements reformat(const FormatStyle &Style, StringRef Code,
                                ArrayRef<tooling::Range> Ranges,
                                StringRef FileName = "<stdin>");
 
+/// \brief Reformats ranges of a buffer that is edited between calls, such as
+/// an editor buffer, by only formatting the top-level declarations around
+/// the ranges.
+///
+/// The buffer is split at blank lines between top-level declarations. The
+/// split points of the previous buffer are kept across calls, and only those
+/// in the edited part of the buffer are recomputed.
+class IncrementalFormatter {
+public:
+  explicit IncrementalFormatter(const FormatStyle &Style,
+                                StringRef FileName = "<stdin>");
+
+  /// \brief Reformats the given \p Ranges in \p Code.
+  ///
+  /// The result is the one of \c reformat() for the same \p Code.
+  tooling::Replacements reformat(StringRef Code,
+                                 ArrayRef<tooling::Range> Ranges);
+
+private:
+  /// \brief A point the buffer can be split at.
+  struct SplitPoint {
+    unsigned Offset;
+    /// \brief The number of enclosing blocks that do not add a level of
+    /// indentation, such as namespaces.
+    unsigned Depth;
+    /// \brief Whether the region up to the next split point closes a bracket
+    /// or preprocessor conditional it does not open, or the buffer ends with
+    /// one left open.
+    bool Unbalanced;
+  };
+
+  void updateSplitPoints(StringRef NewCode);
+  void scan(SplitPoint Start, unsigned StopAfter, ArrayRef<SplitPoint> Old,
+            int Delta);
+
+  FormatStyle Style;
+  std::string FileName;
+  std::string Code;
+  std::vector<SplitPoint> SplitPoints;
+};
+
 /// \brief Returns the \c LangOpts that the formatter expects you to set.
 ///
 /// \param Style determines specific settings for lexing mode.
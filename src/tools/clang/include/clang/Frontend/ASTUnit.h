@@ -26,14 +26,16 @@
 #include "clang/Lex/PreprocessingRecord.h"
 #include "clang/Sema/CodeCompleteConsumer.h"
 #include "clang/Serialization/ASTBitCodes.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
-#include "llvm/Support/MD5.h"
 #include "llvm/Support/Path.h"
 #include <cassert>
+#include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <sys/types.h>
 #include <utility>
@@ -57,10 +59,12 @@ class FileEntry;
 class FileManager;
 class HeaderSearch;
 class ModuleProvider;
+class PrecompiledPreambleCache;
 class Preprocessor;
 class Sema;
 class SourceManager;
 class TargetInfo;
+struct SharedPreamble;
 
 /// \brief Utility class for loading a ASTContext from an AST file.
 ///
@@ -234,10 +238,11 @@ public:
     /// buffers it is zero.
     time_t ModTime;
 
-    /// Memory buffers have MD5 instead of modification time.  We don't
-    /// compute MD5 for on-disk files because we hope that modification time is
-    /// enough to tell if the file was changed.
-    llvm::MD5::MD5Result MD5;
+    /// Memory buffers have a hash of their contents instead of modification
+    /// time.  We don't hash on-disk files because we hope that modification
+    /// time is enough to tell if the file was changed.  The hash is only
+    /// compared within one process, so it doesn't need to be MD5.
+    uint64_t ContentHash;
 
     static PreambleFileHash createForFile(off_t Size, time_t ModTime);
     static PreambleFileHash
@@ -306,6 +311,18 @@ private:
   /// \brief The language options used when we load an AST file.
   LangOptions ASTFileLangOpts;
 
+  /// \brief While reparsing with \c SkipUnchangedFunctionBodies, the offsets
+  /// within the main file of the names of functions whose definitions lie
+  /// entirely outside the edited region, whose bodies we skip.
+  llvm::DenseSet<unsigned> UnchangedFunctionBodies;
+
+  /// \brief Record the functions of the current AST whose definitions the
+  /// edit from \p OldText to \p NewText leaves untouched, and save the
+  /// diagnostics within their bodies into \p CarriedDiags.
+  void collectUnchangedFunctionBodies(
+      StringRef OldText, StringRef NewText,
+      SmallVectorImpl<StandaloneDiagnostic> &CarriedDiags);
+
   static void ConfigureDiags(IntrusiveRefCntPtr<DiagnosticsEngine> Diags,
                              ASTUnit &AST, bool CaptureDiagnostics);
 
@@ -406,6 +423,14 @@ private:
   /// definition names
   unsigned CurrentTopLevelHashValue;
   
+  /// \brief The cache consulted before building a precompiled preamble, and
+  /// into which newly built preambles are published, if any.
+  PrecompiledPreambleCache *PreambleCache;
+
+  /// \brief The precompiled preamble this unit is using when it came from (or
+  /// was published to) \c PreambleCache. Keeps the preamble file alive.
+  std::shared_ptr<SharedPreamble> CachedPreamble;
+
   /// \brief Bit used by CIndex to mark when a translation unit may be in an
   /// inconsistent state, and is not safe to free.
   unsigned UnsafeToFree : 1;
@@ -829,14 +854,27 @@ public:
       bool IncludeBriefCommentsInCodeCompletion = false,
       bool AllowPCHWithCompilerErrors = false, bool SkipFunctionBodies = false,
       bool UserFilesAreVolatile = false, bool ForSerialization = false,
-      std::unique_ptr<ASTUnit> *ErrAST = nullptr);
+      std::unique_ptr<ASTUnit> *ErrAST = nullptr,
+      PrecompiledPreambleCache *PreambleCache = nullptr);
 
   /// \brief Reparse the source files using the same command-line options that
   /// were originally used to produce this translation unit.
   ///
+  /// \param SkipUnchangedFunctionBodies If true, the bodies of functions in
+  /// the main file that lie entirely outside the region edited since the last
+  /// parse are skipped rather than parsed again, and the diagnostics that were
+  /// produced within them are carried over.
+  ///
   /// \returns True if a failure occurred that causes the ASTUnit not to
   /// contain any translation-unit information, false otherwise.  
-  bool Reparse(ArrayRef<RemappedFile> RemappedFiles = None);
+  bool Reparse(ArrayRef<RemappedFile> RemappedFiles = None,
+               bool SkipUnchangedFunctionBodies = false);
+
+  /// \brief Whether the parser may skip the body of the function \p D.
+  ///
+  /// Only consulted when function bodies are being skipped; in an incremental
+  /// reparse, this limits skipping to the bodies that are unchanged.
+  bool shouldSkipFunctionBody(const Decl *D) const;
 
   /// \brief Perform code completion at the given file, line, and
   /// column within this translation unit.
@@ -895,6 +933,75 @@ public:
     { return 0; };
 };
 
+/// \brief A precompiled preamble that can be used by several ASTUnits parsing
+/// the same main file with the same options.
+///
+/// The preamble file is removed once the last reference goes away.
+struct SharedPreamble {
+  SharedPreamble() : PreambleEndsAtStartOfLine(false), NumWarnings(0),
+                     TopLevelHashValue(0), FileSize(0) {}
+  ~SharedPreamble();
+
+  /// \brief The precompiled preamble file.
+  std::string File;
+
+  /// \brief The source text the preamble was built from.
+  std::string Text;
+  bool PreambleEndsAtStartOfLine;
+
+  /// \brief The files the preamble depends on, at the time it was built.
+  llvm::StringMap<ASTUnit::PreambleFileHash> FilesInPreamble;
+
+  /// \brief Diagnostics produced while building the preamble.
+  SmallVector<ASTUnit::StandaloneDiagnostic, 4> Diagnostics;
+
+  /// \brief The top-level declarations in the preamble.
+  std::vector<serialization::DeclID> TopLevelDecls;
+
+  unsigned NumWarnings;
+  unsigned TopLevelHashValue;
+
+  /// \brief The size of \c File, counted against the cache's size limit.
+  uint64_t FileSize;
+};
+
+/// \brief A content-addressed cache of precompiled preambles shared by the
+/// ASTUnits of one libclang index.
+///
+/// Preambles are keyed by a hash of the main file name, the preamble text and
+/// the options that affect how it is compiled, so units that would build an
+/// identical preamble reuse the one already on disk instead. Preamble files
+/// are kept in the temporary directory; once their total size exceeds the
+/// limit, the least recently used ones are dropped from the cache (units
+/// still using them keep them alive).
+class PrecompiledPreambleCache {
+  typedef std::pair<std::string, std::shared_ptr<SharedPreamble> > CacheEntry;
+
+  std::mutex Lock;
+  uint64_t SizeLimit;
+  uint64_t Size;
+
+  /// \brief Cached preambles, most recently used first.
+  std::list<CacheEntry> Entries;
+  llvm::StringMap<std::list<CacheEntry>::iterator> EntriesByKey;
+
+  void evict();
+
+public:
+  explicit PrecompiledPreambleCache(uint64_t SizeLimit)
+    : SizeLimit(SizeLimit), Size(0) {}
+
+  /// \brief Find the preamble stored under \p Key, if any.
+  std::shared_ptr<SharedPreamble> lookup(StringRef Key);
+
+  /// \brief Publish a newly built preamble under \p Key.
+  void insert(StringRef Key, std::shared_ptr<SharedPreamble> Preamble);
+
+  /// \brief Drop the preamble stored under \p Key, e.g., because the files
+  /// it depends on have changed.
+  void remove(StringRef Key);
+};
+
 } // namespace clang
 
 #endif
@@ -36,13 +36,16 @@ class ASTContext;
 class ASTConsumer;
 class ASTReader;
 class CodeCompleteConsumer;
+class ConditionalSkipCache;
 class DiagnosticsEngine;
 class DiagnosticConsumer;
+class DirectoryListingStatCache;
 class ExternalASTSource;
 class FileEntry;
 class FileManager;
 class FrontendAction;
 class Module;
+class ModulePrebuilder;
 class ModuleProvider;
 class Preprocessor;
 class Sema;
@@ -83,12 +86,19 @@ class CompilerInstance : public ModuleLoader {
   /// The file manager.
   IntrusiveRefCntPtr<FileManager> FileMgr;
 
+  /// The directory listing cache of the file manager, if it has one.
+  DirectoryListingStatCache *DirectoryCache;
+
   /// The source manager.
   IntrusiveRefCntPtr<SourceManager> SourceMgr;
 
   /// The preprocessor.
   IntrusiveRefCntPtr<Preprocessor> PP;
 
+  /// The extents of the excluded conditional blocks the preprocessor shares
+  /// with other compiles, if any.
+  IntrusiveRefCntPtr<ConditionalSkipCache> SkipCache;
+
   /// The AST context.
   IntrusiveRefCntPtr<ASTContext> Context;
 
@@ -140,6 +150,11 @@ class CompilerInstance : public ModuleLoader {
   /// \brief One or more modules failed to build.
   bool ModuleBuildFailed;
 
+  /// \brief The modules this instance is going to import that are being built
+  /// on worker threads, see -fmodules-build-threads. Created when the first
+  /// module needs to be built.
+  std::unique_ptr<ModulePrebuilder> Prebuilder;
+
   /// \brief Holds information about the output file.
   ///
   /// If TempFilename is not empty we must rename it to Filename at the end.
@@ -160,6 +175,10 @@ class CompilerInstance : public ModuleLoader {
 
   CompilerInstance(const CompilerInstance &) LLVM_DELETED_FUNCTION;
   void operator=(const CompilerInstance &) LLVM_DELETED_FUNCTION;
+
+  /// \brief Start building the missing modules this instance is going to
+  /// import, other than \p Building, in the background.
+  void startModulePrebuilds(Module *Building);
 public:
   explicit CompilerInstance(SharedModuleProvider MP,
                             bool BuildingModule = false);
@@ -371,6 +390,7 @@ public:
   void resetAndLeakFileManager() {
     BuryPointer(FileMgr.get());
     FileMgr.resetWithoutRelease();
+    DirectoryCache = nullptr;
   }
 
   /// \brief Replace the current file manager and virtual file system.
@@ -416,6 +436,10 @@ public:
   /// Replace the current preprocessor.
   void setPreprocessor(Preprocessor *Value);
 
+  /// \brief Share the extents of the excluded conditional blocks of the
+  /// preprocessors created from now on through \p Cache.
+  void setConditionalSkipCache(ConditionalSkipCache *Cache);
+
   /// }
   /// @name ASTContext
   /// {
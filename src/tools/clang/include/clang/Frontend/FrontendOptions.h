@@ -124,8 +124,15 @@ public:
   unsigned ShowHelp : 1;                   ///< Show the -help text.
   unsigned ShowStats : 1;                  ///< Show frontend performance
                                            /// metrics and statistics.
+  unsigned ShowASTMemory : 1;              ///< Show the memory used by each
+                                           /// kind of AST node.
+  unsigned ASTHugePages : 1;               ///< Back the AST with huge pages.
   unsigned ShowTimers : 1;                 ///< Show timers for individual
                                            /// actions.
+  unsigned TimeTrace : 1;                  ///< Write a trace of the time
+                                           /// spent in each scope.
+  unsigned TimeTraceFolded : 1;            ///< Write the trace as folded
+                                           /// stacks.
   unsigned ShowVersion : 1;                ///< Show the -version text.
   unsigned FixWhatYouCan : 1;              ///< Apply fixes even if there are
                                            /// unfixable errors.
@@ -251,10 +258,25 @@ public:
   /// \brief The list of AST files to merge.
   std::vector<std::string> ASTMergeFiles;
 
+  /// \brief The directory of the index store that symbol occurrences are
+  /// recorded into, if not empty.
+  std::string IndexStorePath;
+
   /// \brief A list of arguments to forward to LLVM's option processing; this
   /// should only be used for debugging and experimental features.
   std::vector<std::string> LLVMArgs;
 
+  /// \brief The minimum duration in microseconds of the scopes written to
+  /// the -ftime-trace output.
+  unsigned TimeTraceGranularity;
+
+  /// \brief The file to write the LLVM statistics to as JSON, if not empty.
+  std::string StatsFile;
+
+  /// \brief The minimum size of the slabs the AST is allocated in, or 0 for
+  /// the default.
+  unsigned ASTSlabSize;
+
   /// \brief File name of the file that will provide record layouts
   /// (in the format produced by -fdump-record-layouts).
   std::string OverrideRecordLayoutsFile;
@@ -262,13 +284,16 @@ public:
 public:
   FrontendOptions() :
     DisableFree(false), RelocatablePCH(false), ShowHelp(false),
-    ShowStats(false), ShowTimers(false), ShowVersion(false),
+    ShowStats(false), ShowASTMemory(false), ASTHugePages(false),
+    ShowTimers(false), TimeTrace(false), TimeTraceFolded(false),
+    ShowVersion(false),
     FixWhatYouCan(false), FixOnlyWarnings(false), FixAndRecompile(false),
     FixToTemporaries(false), ARCMTMigrateEmitARCErrors(false),
     SkipFunctionBodies(false), UseGlobalModuleIndex(true),
     GenerateGlobalModuleIndex(true), ASTDumpDecls(false), ASTDumpLookups(false),
     ARCMTAction(ARCMT_None), ObjCMTAction(ObjCMT_None), XCTMigrate(false),
-    ProgramAction(frontend::ParseSyntaxOnly)
+    ProgramAction(frontend::ParseSyntaxOnly), TimeTraceGranularity(500),
+    ASTSlabSize(0)
   {}
 
   /// getInputKindForExtension - Return the appropriate input kind for a file
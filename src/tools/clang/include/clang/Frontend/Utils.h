@@ -49,6 +49,7 @@ class LangOptions;
 class Preprocessor;
 class PreprocessorOptions;
 class PreprocessorOutputOptions;
+class PTHCache;
 class SourceManager;
 class Stmt;
 class TargetInfo;
@@ -165,6 +166,11 @@ void AttachHeaderIncludeGen(Preprocessor &PP, bool ShowAllHeaders = false,
 /// a seekable stream.
 void CacheTokens(Preprocessor &PP, llvm::raw_fd_ostream* OS);
 
+/// createPTHCache - Create a PTHCache providing the tokens of the system
+/// headers \p PP enters from the directory \p Path, and caching there the
+/// tokens of the headers it doesn't have yet.
+std::unique_ptr<PTHCache> createPTHCache(Preprocessor &PP, StringRef Path);
+
 /// The ChainedIncludesSource class converts headers to chained PCHs in
 /// memory, mainly for testing.
 IntrusiveRefCntPtr<ExternalSemaSource>
@@ -0,0 +1,106 @@
+//===--- IndexStore.h - Persistent USR-based symbol index -------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// An index store is a directory holding the symbol occurrences recorded while
+// compiling, so that tools can find cross-references without parsing:
+//
+//   records/  One file per source file and compiler configuration, named
+//             after a hash of both, mapping each USR to its occurrences in
+//             that file through an on-disk hash table. A record is only
+//             written the first time its source file is seen, so unchanged
+//             headers cost nothing to subsequent compilations.
+//   units/    One file per translation unit, listing the records it covers.
+//             It is rewritten on every compilation of the translation unit.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_INDEX_INDEXSTORE_H
+#define LLVM_CLANG_INDEX_INDEXSTORE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include <memory>
+#include <string>
+
+namespace llvm {
+class MemoryBuffer;
+}
+
+namespace clang {
+class ASTConsumer;
+
+namespace index {
+
+/// \brief The roles of a symbol occurrence, bitwise-OR'd together.
+enum SymbolRole : unsigned {
+  SymbolRole_Declaration = 1 << 0,
+  SymbolRole_Definition = 1 << 1,
+  SymbolRole_Reference = 1 << 2
+};
+
+/// \brief An occurrence of a symbol found in an index store.
+struct SymbolOccurrence {
+  StringRef FilePath;
+  unsigned Roles;
+  unsigned Line;
+  unsigned Column;
+};
+
+/// \brief Create a consumer that records the symbol occurrences of the
+/// translation unit into the index store at \p StorePath.
+///
+/// \param MainFile The main source file of the translation unit.
+///
+/// \param OutputFile The output file of the compilation, which together with
+/// \p MainFile identifies the unit.
+///
+/// \param ContextHash A hash of the compiler configuration. Records of the
+/// same file written under different configurations are kept apart.
+std::unique_ptr<ASTConsumer>
+createIndexStoreConsumer(StringRef StorePath, StringRef MainFile,
+                         StringRef OutputFile, StringRef ContextHash);
+
+/// \brief Reads the symbol occurrences of an index store.
+///
+/// Record files are memory mapped lazily, the first time a lookup needs them.
+class IndexStoreReader {
+  std::string StorePath;
+
+  /// \brief The source file path of each record referenced by a unit.
+  llvm::StringMap<std::string> RecordFiles;
+
+  /// \brief The record files opened so far.
+  llvm::StringMap<std::unique_ptr<llvm::MemoryBuffer>> RecordBuffers;
+
+  explicit IndexStoreReader(StringRef StorePath) : StorePath(StorePath) {}
+
+  const llvm::MemoryBuffer *getRecordBuffer(StringRef RecordName);
+
+public:
+  ~IndexStoreReader();
+
+  /// \brief Open the index store at \p StorePath.
+  ///
+  /// \returns The reader, or null with \p Error set if the store could not
+  /// be read.
+  static std::unique_ptr<IndexStoreReader> open(StringRef StorePath,
+                                                std::string &Error);
+
+  /// \brief Call \p Receiver for each occurrence of the symbol with the
+  /// given USR.
+  void findOccurrences(StringRef USR,
+               llvm::function_ref<void(const SymbolOccurrence &)> Receiver);
+};
+
+} // namespace index
+} // namespace clang
+
+#endif
@@ -0,0 +1,67 @@
+//===--- ConditionalSkipCache.h - Extents of excluded blocks ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the ConditionalSkipCache class, which remembers where the
+//  excluded conditional blocks of the files end.
+//
+//===----------------------------------------------------------------------===//
+#ifndef LLVM_CLANG_LEX_CONDITIONALSKIPCACHE_H
+#define LLVM_CLANG_LEX_CONDITIONALSKIPCACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/Support/FileSystem.h"
+#include <ctime>
+#include <map>
+
+namespace clang {
+
+class FileEntry;
+class LangOptions;
+
+/// \brief Remembers, for each offset of a file the preprocessor started
+/// skipping an excluded conditional block from, the offset of the '#' of the
+/// \#elif, \#else or \#endif closing the block.
+///
+/// The blocks only depend on the text of the file and on how it is lexed, so
+/// the cache can be shared by the preprocessors of several translation units.
+/// The entries are kept per file and set of language options, and dropped when
+/// the size or modification time of the file changes.
+class ConditionalSkipCache : public RefCountedBase<ConditionalSkipCache> {
+  struct FileBlocks {
+    FileBlocks() : ModTime(0), Size(0) {}
+    time_t ModTime;
+    uint64_t Size;
+    llvm::DenseMap<unsigned, unsigned> Ends;
+  };
+
+  std::map<std::pair<llvm::sys::fs::UniqueID, size_t>, FileBlocks> Files;
+
+  FileBlocks &getFileBlocks(const FileEntry *File, size_t LangKey,
+                            uint64_t Size);
+
+public:
+  /// \brief Compute the key of the entries lexed with \p LangOpts.
+  static size_t getLangOptionsKey(const LangOptions &LangOpts);
+
+  /// \brief Return the offset of the directive closing the block skipped from
+  /// \p Offset in \p File, whose buffer is \p Size bytes, or 0 if unknown.
+  unsigned getBlockEnd(const FileEntry *File, size_t LangKey, uint64_t Size,
+                       unsigned Offset);
+
+  /// \brief Record that the block skipped from \p Offset in \p File is closed
+  /// by the directive at \p End.
+  void addBlock(const FileEntry *File, size_t LangKey, uint64_t Size,
+                unsigned Offset, unsigned End);
+};
+
+} // end namespace clang
+
+#endif
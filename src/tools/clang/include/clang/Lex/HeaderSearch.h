@@ -232,6 +232,22 @@ class HeaderSearch {
   /// \brief Describes whether a given directory has a module map in it.
   llvm::DenseMap<const DirectoryEntry *, bool> DirectoryHasModuleMap;
 
+  /// \brief The ASCII lowercase names of the entries of a search directory.
+  struct DirectoryEntryNames {
+    /// Whether the directory was listed.
+    bool Listed;
+    /// Whether the listing succeeded, and the names can be relied on.
+    bool Complete;
+    llvm::StringSet<> Names;
+
+    DirectoryEntryNames() : Listed(false), Complete(false) {}
+  };
+
+  /// \brief The entries of the search directories, listed the first time a
+  /// file is looked up in them, used to answer the lookups of missing files
+  /// without going to the file system.
+  llvm::DenseMap<const DirectoryEntry *, DirectoryEntryNames> SearchDirEntries;
+
   /// \brief Set of module map files we've already loaded, and a flag indicating
   /// whether they were valid or not.
   llvm::DenseMap<const FileEntry *, bool> LoadedModuleMaps;
@@ -251,6 +267,7 @@ class HeaderSearch {
   unsigned NumIncluded;
   unsigned NumMultiIncludeFileOptzn;
   unsigned NumFrameworkLookups, NumSubFrameworkLookups;
+  unsigned NumListedMisses;
 
   const LangOptions &LangOpts;
 
@@ -520,6 +537,14 @@ public:
   
   void IncrementFrameworkLookupCount() { ++NumFrameworkLookups; }
 
+  /// \brief Determine whether the search directory \p Dir may contain an
+  /// entry named \p Name.
+  ///
+  /// Returns false only if the listing of \p Dir has no entry whose name is
+  /// equal to \p Name, ignoring case, in which case no file needs to be
+  /// looked up under \p Dir/\p Name.
+  bool mayContainEntry(const DirectoryEntry *Dir, StringRef Name);
+
   /// \brief Determine whether there is a module map that may map the header
   /// with the given file name to a (sub)module.
   /// Always returns false if modules are disabled.
@@ -128,6 +128,13 @@ public:
   /// regenerated often.
   unsigned ModuleCachePruneAfter;
 
+  /// \brief The maximum number of modules to build at the same time.
+  ///
+  /// When a module needs to be built and this is more than one, the other
+  /// missing modules that the compile is going to import are built on worker
+  /// threads in the meantime.
+  unsigned ModulesBuildThreads;
+
   /// \brief The time in seconds when the build session started.
   ///
   /// This time is used by other optimizations in header search and module
@@ -169,7 +176,7 @@ public:
     : Sysroot(_Sysroot), DisableModuleHash(0), ModuleMaps(0),
       ModuleMapFileHomeIsCwd(0),
       ModuleCachePruneInterval(7*24*60*60),
-      ModuleCachePruneAfter(31*24*60*60),
+      ModuleCachePruneAfter(31*24*60*60), ModulesBuildThreads(1),
       BuildSessionTimestamp(0),
       UseBuiltinIncludes(true),
       UseStandardSystemIncludes(true), UseStandardCXXIncludes(true),
@@ -224,7 +224,19 @@ public:
 
   /// \brief Return the current location in the buffer.
   const char *getBufferLocation() const { return BufferPtr; }
-  
+
+  /// \brief Return the offset of the current location in the buffer.
+  unsigned getCurrentBufferOffset() const { return BufferPtr - BufferStart; }
+
+  /// \brief Continue lexing at \p Offset in the buffer, which starts a token
+  /// at the start of a line.
+  void seekToStartOfLine(unsigned Offset) {
+    assert(Offset <= unsigned(BufferEnd - BufferStart) && "Invalid offset");
+    BufferPtr = BufferStart + Offset;
+    IsAtStartOfLine = true;
+    IsAtPhysicalStartOfLine = false;
+  }
+
   /// Stringify - Convert the specified string into a C string by escaping '\'
   /// and " characters.  This does not add surrounding ""'s to the string.
   /// If Charify is true, this escapes the ' character instead of ".
@@ -82,6 +82,11 @@ class PTHManager : public IdentifierInfoLookup {
   ///  if the file (if any) that was to used to generate the PTH cache.
   const char* OriginalSourceFile;
 
+  /// UsePreprocessorIdentifiers - Whether identifiers are looked up in the
+  ///  identifier table of the preprocessor rather than created by this
+  ///  PTHManager, see setUsePreprocessorIdentifiers().
+  bool UsePreprocessorIdentifiers;
+
   /// This constructor is intended to only be called by the static 'Create'
   /// method.
   PTHManager(std::unique_ptr<const llvm::MemoryBuffer> buf,
@@ -132,6 +137,12 @@ public:
 
   void setPreprocessor(Preprocessor *pp) { PP = pp; }
 
+  /// setUsePreprocessorIdentifiers - Look up the identifiers of the cached
+  ///  tokens in the identifier table of the preprocessor.  This allows using
+  ///  PTHManagers which aren't the external identifier lookup of the
+  ///  preprocessor, along with the lexers of other files.
+  void setUsePreprocessorIdentifiers() { UsePreprocessorIdentifiers = true; }
+
   /// CreateLexer - Return a PTHLexer that "lexes" the cached tokens for the
   ///  specified file.  This method returns NULL if no cached tokens exist.
   ///  It is the responsibility of the caller to 'delete' the returned object.
@@ -144,6 +155,20 @@ public:
   std::unique_ptr<FileSystemStatCache> createStatCache();
 };
 
+/// \brief A cache of the tokens of the headers a Preprocessor enters.
+///
+/// Unlike a PTHManager, which provides the tokens of the files of a PTH file,
+/// a PTHCache decides which files are cached and how, and is used along with
+/// the lexers of the files which aren't.
+class PTHCache {
+public:
+  virtual ~PTHCache();
+
+  /// \brief Return a PTHLexer for the cached tokens of the file \p FID, or
+  /// null if it should be lexed from its source.
+  virtual PTHLexer *CreateLexer(FileID FID) = 0;
+};
+
 }  // end namespace clang
 
 #endif
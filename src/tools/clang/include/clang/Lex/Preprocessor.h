@@ -19,6 +19,7 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/IdentifierTable.h"
 #include "clang/Basic/SourceLocation.h"
+#include "clang/Lex/ConditionalSkipCache.h"
 #include "clang/Lex/Lexer.h"
 #include "clang/Lex/MacroInfo.h"
 #include "clang/Lex/ModuleMap.h"
@@ -111,6 +112,15 @@ class Preprocessor : public RefCountedBase<Preprocessor> {
   /// a token cache rather than lexing the original source file.
   std::unique_ptr<PTHManager> PTH;
 
+  /// An optional cache of the tokens of the headers, used for the files PTH
+  /// doesn't provide the tokens of.
+  std::unique_ptr<PTHCache> HeaderPTHCache;
+
+  /// The extents of the excluded conditional blocks skipped so far, used to
+  /// jump over them when they are skipped again.
+  IntrusiveRefCntPtr<ConditionalSkipCache> SkipCache;
+  size_t SkipCacheLangKey;
+
   /// A BumpPtrAllocator object used to quickly allocate and release
   /// objects internal to the Preprocessor.
   llvm::BumpPtrAllocator BP;
@@ -400,7 +410,7 @@ class Preprocessor : public RefCountedBase<Preprocessor> {
   unsigned NumEnteredSourceFiles, MaxIncludeStackDepth;
   unsigned NumMacroExpanded, NumFnMacroExpanded, NumBuiltinMacroExpanded;
   unsigned NumFastMacroExpanded, NumTokenPaste, NumFastTokenPaste;
-  unsigned NumSkipped;
+  unsigned NumSkipped, NumSkippedFromCache;
 
   /// \brief The predefined macros that preprocessor should use from the
   /// command line etc.
@@ -519,6 +529,17 @@ public:
 
   PTHManager *getPTHManager() { return PTH.get(); }
 
+  void setPTHCache(std::unique_ptr<PTHCache> Cache) {
+    HeaderPTHCache = std::move(Cache);
+  }
+
+  /// \brief Share the extents of the excluded conditional blocks with other
+  /// preprocessors using \p Cache.
+  void
+  setConditionalSkipCache(IntrusiveRefCntPtr<ConditionalSkipCache> Cache) {
+    SkipCache = std::move(Cache);
+  }
+
   void setExternalSource(ExternalPreprocessorSource *Source) {
     ExternalSource = Source;
   }
@@ -603,6 +624,11 @@ public:
                                                 std::move(Callbacks));
     Callbacks = std::move(C);
   }
+  /// \brief Removes the callbacks from the preprocessor, returning them to
+  /// the caller.
+  std::unique_ptr<PPCallbacks> takePPCallbacks() {
+    return std::move(Callbacks);
+  }
   /// \}
 
   /// \brief Given an identifier, return its latest MacroDirective if it is
@@ -89,6 +89,10 @@ public:
   /// If given, a PTH cache file to use for speeding up header parsing.
   std::string TokenCache;
 
+  /// If given, the directory caching the tokens of the system headers, keyed
+  /// on their name and contents.
+  std::string PTHCachePath;
+
   /// \brief True if the SourceManager should report the original file name for
   /// contents of files that were remapped to other files. Defaults to true.
   bool RemappedFilesKeepOriginalName;
@@ -769,6 +769,13 @@ public:
     return Keyword;
   }
 
+  /// \brief Retrieve the name under which this result is sorted and
+  /// filtered, without building its code-completion string.
+  ///
+  /// \param Saved Storage for the name when it is not a simple identifier;
+  /// the returned reference may point into it.
+  StringRef getOrderedName(std::string &Saved) const;
+
   /// \brief Create a new code-completion string that describes how to insert
   /// this result into a program.
   ///
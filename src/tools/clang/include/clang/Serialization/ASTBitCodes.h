@@ -35,7 +35,7 @@ namespace clang {
     /// Version 4 of AST files also requires that the version control branch and
     /// revision match exactly, since there is no backward compatibility of
     /// AST files at this time.
-    const unsigned VERSION_MAJOR = 6;
+    const unsigned VERSION_MAJOR = 7;
 
     /// \brief AST file minor version number supported by this version of
     /// Clang.
@@ -571,10 +571,49 @@ namespace clang {
       /// overridden buffer.
       SM_SLOC_BUFFER_BLOB = 3,
       /// \brief Describes a source location entry (SLocEntry) for a
-      /// macro expansion.
+      /// macro expansion. Its locations are stored compactly, see
+      /// encodeSLocExpansionLoc() and encodeSLocExpansionEnd().
       SM_SLOC_EXPANSION_ENTRY = 4
     };
 
+    /// \brief Encode a source location of a macro expansion entry so that it
+    /// serializes to few VBR chunks.
+    ///
+    /// Macro locations have the top bit of their raw encoding set, which
+    /// would make every one of them take five VBR8 chunks; rotating that bit
+    /// down to the bottom keeps small offsets small for both kinds.
+    inline uint32_t encodeSLocExpansionLoc(uint32_t Raw) {
+      return (Raw << 1) | (Raw >> 31);
+    }
+
+    /// \brief Decode a location written by encodeSLocExpansionLoc().
+    inline uint32_t decodeSLocExpansionLoc(uint32_t Encoded) {
+      return (Encoded >> 1) | (Encoded << 31);
+    }
+
+    /// \brief Encode the end location of a macro expansion entry relative to
+    /// its start location.
+    ///
+    /// The end of an expansion range is almost always a few characters past
+    /// its start, so store the zig-zag encoded difference, offset by one so
+    /// that 0 still denotes the missing end of a macro argument expansion.
+    inline uint32_t encodeSLocExpansionEnd(uint32_t StartRaw, uint32_t EndRaw) {
+      if (EndRaw == 0)
+        return 0;
+      int32_t Delta = static_cast<int32_t>(EndRaw - StartRaw);
+      return ((static_cast<uint32_t>(Delta) << 1) ^
+              static_cast<uint32_t>(Delta >> 31)) + 1;
+    }
+
+    /// \brief Decode an end location written by encodeSLocExpansionEnd().
+    inline uint32_t decodeSLocExpansionEnd(uint32_t StartRaw,
+                                           uint32_t Encoded) {
+      if (Encoded == 0)
+        return 0;
+      uint32_t ZigZag = Encoded - 1;
+      return StartRaw + ((ZigZag >> 1) ^ (0u - (ZigZag & 1)));
+    }
+
     /// \brief Record types used within a preprocessor block.
     enum PreprocessorRecordTypes {
       // The macros in the PP section are a PP_MACRO_* instance followed by a
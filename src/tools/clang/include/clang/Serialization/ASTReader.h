@@ -930,6 +930,10 @@ private:
   /// Number of visible decl contexts read/total.
   unsigned NumVisibleDeclContextsRead, TotalVisibleDeclContexts;
 
+  /// Number of declarations produced by name lookups into visible decl
+  /// contexts.
+  unsigned NumVisibleDeclsFound;
+
   /// Total size of modules, in bits, currently loaded
   uint64_t TotalModulesSizeInBits;
 
@@ -8,9 +8,9 @@
 //===----------------------------------------------------------------------===//
 //
 // This file defines the GlobalModuleIndex class, which manages a global index
-// containing all of the identifiers known to the various modules within a given
-// subdirectory of the module cache. It is used to improve the performance of
-// queries such as "do any modules know about this identifier?"
+// containing all of the identifiers and selectors known to the various modules
+// within a given subdirectory of the module cache. It is used to improve the
+// performance of queries such as "do any modules know about this identifier?"
 //
 //===----------------------------------------------------------------------===//
 #ifndef LLVM_CLANG_SERIALIZATION_GLOBALMODULEINDEX_H
@@ -35,6 +35,7 @@ class DirectoryEntry;
 class FileEntry;
 class FileManager;
 class IdentifierIterator;
+class Selector;
 
 namespace serialization {
   class ModuleFile;
@@ -68,6 +69,12 @@ class GlobalModuleIndex {
   /// GlobalModuleIndex.
   void *IdentifierIndex;
 
+  /// \brief The selector hash table.
+  ///
+  /// This pointer actually points to a SelectorIndexTable object, keyed by
+  /// the hash of each selector found in a module file's method pool.
+  void *SelectorIndex;
+
   /// \brief Information about a given module file.
   struct ModuleInfo {
     ModuleInfo() : File(), Size(), ModTime() { }
@@ -113,6 +120,13 @@ class GlobalModuleIndex {
   /// \brief The number of identifier lookup hits, where we recognize the
   /// identifier.
   unsigned NumIdentifierLookupHits;
+
+  /// \brief The number of selector lookups we performed.
+  unsigned NumSelectorLookups;
+
+  /// \brief The number of selector lookup hits, where at least one module
+  /// file may have methods for the selector.
+  unsigned NumSelectorLookupHits;
   
   /// \brief Internal constructor. Use \c readIndex() to read an index.
   explicit GlobalModuleIndex(std::unique_ptr<llvm::MemoryBuffer> Buffer,
@@ -177,6 +191,20 @@ public:
   /// \returns true if the identifier is known to the index, false otherwise.
   bool lookupIdentifier(StringRef Name, HitSet &Hits);
 
+  /// \brief Look for all of the module files whose method pool may contain
+  /// methods for the given selector.
+  ///
+  /// Selectors are indexed by hash, so \p Hits may contain module files that
+  /// only have an entry for a different selector with the same hash.
+  ///
+  /// \param Sel The selector to look for.
+  ///
+  /// \param Hits Will be populated with the set of module files that may have
+  /// information about this selector.
+  ///
+  /// \returns true if the index has selector information, false otherwise.
+  bool lookupSelector(Selector Sel, HitSet &Hits);
+
   /// \brief Note that the given module file has been loaded.
   ///
   /// \returns false if the global module index has information about this
@@ -176,6 +176,15 @@ public:
   /// \brief The mode of function selection used during inlining.
   AnalysisInliningMode InliningMode;
 
+  /// \brief The number of processes the analysis of the translation unit is
+  /// split between, each with its own exploded graphs.
+  unsigned ShardCount;
+
+  /// \brief Which of the \c ShardCount processes this one is. Each function
+  /// is analyzed path-sensitively by one of them only, and the syntax-based
+  /// checks run in the first one.
+  unsigned ShardIndex;
+
 private:
   /// \brief Describes the kinds for high-level analyzer mode.
   enum UserModeKind {
@@ -246,6 +255,9 @@ private:
   /// \sa getGraphTrimInterval
   Optional<unsigned> GraphTrimInterval;
 
+  /// \sa shouldTrimGraphAggressively
+  Optional<bool> TrimGraphAggressively;
+
   /// \sa getMaxTimesInlineLarge
   Optional<unsigned> MaxTimesInlineLarge;
 
@@ -409,6 +421,14 @@ public:
   /// node reclamation, set the option to "0".
   unsigned getGraphTrimInterval();
 
+  /// Returns true if node recycling should also reclaim nodes that are not
+  /// needed to reconstruct bug paths, trading the precision of path
+  /// diagnostics for memory.
+  ///
+  /// This is controlled by the 'graph-trim-aggressive' config option, which
+  /// accepts the values "true" and "false".
+  bool shouldTrimGraphAggressively();
+
   /// Returns the maximum times a large function could be inlined.
   ///
   /// This is controlled by the 'max-times-inline-large' config option.
@@ -442,6 +462,8 @@ public:
     // Cap the stack depth at 4 calls (5 stack frames, base + 4 calls).
     InlineMaxStackDepth(5),
     InliningMode(NoRedundancy),
+    ShardCount(1),
+    ShardIndex(0),
     UserMode(UMK_NotSet),
     IPAMode(IPAK_NotSet),
     CXXMemberInliningMode() {}
@@ -272,6 +272,9 @@ protected:
 
   /// NumNodes - The number of nodes in the graph.
   unsigned NumNodes;
+
+  /// The largest number of nodes the graph held at any one time.
+  unsigned PeakNumNodes;
   
   /// A list of recently allocated nodes that can potentially be recycled.
   NodeVector ChangedNodes;
@@ -287,6 +290,10 @@ protected:
   /// Counter to determine when to reclaim nodes.
   unsigned ReclaimCounter;
 
+  /// Whether nodes that only matter for the precision of path diagnostics
+  /// are reclaimed as well.
+  bool AggressiveReclamation;
+
 public:
 
   /// \brief Retrieve the node associated with a (Location,State) pair,
@@ -323,6 +330,13 @@ public:
   bool empty() const { return NumNodes == 0; }
   unsigned size() const { return NumNodes; }
 
+  /// \brief Returns the largest number of nodes the graph held at once.
+  unsigned getPeakSize() const { return PeakNumNodes; }
+
+  /// \brief Returns the number of bytes allocated for the nodes and their
+  /// predecessor and successor groups.
+  size_t getAllocatedBytes() { return getAllocator().getTotalMemory(); }
+
   // Iterators.
   typedef ExplodedNode                        NodeTy;
   typedef llvm::FoldingSet<ExplodedNode>      AllNodesTy;
@@ -379,8 +393,12 @@ public:
 
   /// Enable tracking of recently allocated nodes for potential reclamation
   /// when calling reclaimRecentlyAllocatedNodes().
-  void enableNodeReclamation(unsigned Interval) {
+  ///
+  /// \param Aggressive Also reclaim nodes that are not needed to reconstruct
+  /// bug paths, at the cost of less precise locations in path diagnostics.
+  void enableNodeReclamation(unsigned Interval, bool Aggressive = false) {
     ReclaimCounter = ReclaimNodeInterval = Interval;
+    AggressiveReclamation = Aggressive;
   }
 
   /// Reclaim "uninteresting" nodes created since the last time this method
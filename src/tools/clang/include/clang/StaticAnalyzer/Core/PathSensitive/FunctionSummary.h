@@ -28,6 +28,21 @@ namespace ento {
 typedef std::deque<Decl*> SetOfDecls;
 typedef llvm::DenseSet<const Decl*> SetOfConstDecls;
 
+/// \brief Persists what the analysis learned about functions beyond the
+/// translation unit, so that other translation units and later runs do not
+/// have to explore them again to find out.
+class FunctionSummaryStore {
+public:
+  virtual ~FunctionSummaryStore();
+
+  /// \brief Returns true if the exploration of \p D hit the block visit
+  /// limit when it was inlined by an earlier analysis.
+  virtual bool reachedMaxBlockCount(const Decl *D) = 0;
+
+  /// \brief Records that the exploration of \p D hit the block visit limit.
+  virtual void recordReachedMaxBlockCount(const Decl *D) = 0;
+};
+
 class FunctionSummariesTy {
   class FunctionSummary {
   public:
@@ -56,7 +71,14 @@ class FunctionSummariesTy {
   typedef llvm::DenseMap<const Decl *, FunctionSummary> MapTy;
   MapTy Map;
 
+  /// The summaries persisted across translation units, if any.
+  FunctionSummaryStore *Store;
+
 public:
+  FunctionSummariesTy() : Store(nullptr) {}
+
+  void setStore(FunctionSummaryStore *S) { Store = S; }
+
   MapTy::iterator findOrInsertSummary(const Decl *D) {
     MapTy::iterator I = Map.find(D);
     if (I != Map.end())
@@ -82,12 +104,18 @@ public:
 
   void markReachedMaxBlockCount(const Decl *D) {
     markShouldNotInline(D);
+    if (Store)
+      Store->recordReachedMaxBlockCount(D);
   }
 
   Optional<bool> mayInline(const Decl *D) {
     MapTy::const_iterator I = Map.find(D);
     if (I != Map.end() && I->second.InlineChecked)
       return I->second.MayInline;
+    if (Store && Store->reachedMaxBlockCount(D)) {
+      markShouldNotInline(D);
+      return false;
+    }
     return None;
   }
 
@@ -21,6 +21,7 @@
 
 #include "clang/Basic/SourceLocation.h"
 #include "llvm/ADT/StringRef.h"
+#include <mutex>
 #include <set>
 #include <string>
 #include <vector>
@@ -179,6 +180,26 @@ unsigned shiftedCodePosition(const std::vector<Replacement> &Replaces,
 void deduplicate(std::vector<Replacement> &Replaces,
                  std::vector<Range> &Conflicts);
 
+/// \brief Collects the Replacements of tool invocations that run
+/// concurrently.
+///
+/// All member functions may be called from several threads at once.
+class ReplacementCollector {
+public:
+  /// \brief Add a single replacement.
+  void add(const Replacement &Replace);
+
+  /// \brief Add all replacements in \p Replaces.
+  void add(const Replacements &Replaces);
+
+  /// \brief Returns the replacements added so far and forgets about them.
+  Replacements take();
+
+private:
+  std::mutex Mutex;
+  Replacements Collected;
+};
+
 /// \brief Collection of Replacements generated from a single translation unit.
 struct TranslationUnitReplacements {
   /// Name of the main source for the translation unit.
@@ -20,16 +20,20 @@
 #include "clang/Tooling/FileMatchTrie.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/YAMLParser.h"
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 namespace clang {
 namespace tooling {
 
+class CompileCommandCache;
+
 /// \brief A JSON based compilation database.
 ///
 /// JSON compilation database files must contain a list of JSON objects which
@@ -47,9 +51,18 @@ namespace tooling {
 ///
 /// JSON compilation databases can for example be generated in CMake projects
 /// by setting the flag -DCMAKE_EXPORT_COMPILE_COMMANDS.
+///
+/// Databases loaded from a file are cached in binary form next to it, in a
+/// file with the suffix '.cache'. As long as the size and modification time
+/// of the JSON file match those recorded in the cache, the cache is memory
+/// mapped instead of parsing the JSON, and commands are looked up in its
+/// on-disk hash table.
 class JSONCompilationDatabase : public CompilationDatabase {
 public:
-  /// \brief Loads a JSON compilation database from the specified file.
+  ~JSONCompilationDatabase() override;
+
+  /// \brief Loads a JSON compilation database from the specified file, or
+  /// from its cache if that is up to date.
   ///
   /// Returns NULL and sets ErrorMessage if the database could not be
   /// loaded from the given file.
@@ -81,9 +94,7 @@ public:
 
 private:
   /// \brief Constructs a JSON compilation database on a memory buffer.
-  JSONCompilationDatabase(std::unique_ptr<llvm::MemoryBuffer> Database)
-      : Database(std::move(Database)),
-        YAMLStream(this->Database->getBuffer(), SM) {}
+  JSONCompilationDatabase(std::unique_ptr<llvm::MemoryBuffer> Database);
 
   /// \brief Parses the database file and creates the index.
   ///
@@ -91,23 +102,55 @@ private:
   /// failed.
   bool parse(std::string &ErrorMessage);
 
-  // Tuple (directory, commandline) where 'commandline' pointing to the
-  // corresponding nodes in the YAML stream.
-  typedef std::pair<llvm::yaml::ScalarNode*,
-                    llvm::yaml::ScalarNode*> CompileCommandRef;
+  /// \brief Returns the value of \p Node, copied into Strings if it had to
+  /// be unescaped.
+  StringRef getUnescapedValue(llvm::yaml::ScalarNode *Node);
+
+  /// \brief Uses the binary cache in \p Buffer instead of a parsed database.
+  ///
+  /// Returns false if the cache is invalid or was not written for a JSON file
+  /// of the given size and modification time.
+  bool loadCache(std::unique_ptr<llvm::MemoryBuffer> Buffer, uint64_t Size,
+                 uint64_t ModificationTime);
+
+  /// \brief Writes the parsed database in binary form to \p CachePath,
+  /// ignoring any errors.
+  void writeCache(StringRef CachePath, uint64_t Size,
+                  uint64_t ModificationTime) const;
+
+  // Tuple (directory, commandline) of unescaped values, pointing into the
+  // database, the cache or Strings.
+  typedef std::pair<StringRef, StringRef> CompileCommandRef;
 
   /// \brief Converts the given array of CompileCommandRefs to CompileCommands.
   void getCommands(ArrayRef<CompileCommandRef> CommandsRef,
                    std::vector<CompileCommand> &Commands) const;
 
-  // Maps file paths to the compile command lines for that file.
+  /// \brief Appends the commands for exactly the file \p NativeFilePath to
+  /// \p Commands.
+  void lookupCommands(StringRef NativeFilePath,
+                      std::vector<CompileCommand> &Commands) const;
+
+  /// \brief Returns the trie of all files, building it the first time.
+  ///
+  /// Only lookups of paths not found verbatim need it.
+  const FileMatchTrie &getMatchTrie() const;
+
+  // Maps file paths to the compile command lines for that file, unless the
+  // database was loaded from its cache.
   llvm::StringMap< std::vector<CompileCommandRef> > IndexByFile;
 
-  FileMatchTrie MatchTrie;
+  mutable FileMatchTrie MatchTrie;
+  mutable std::once_flag MatchTrieBuilt;
 
   std::unique_ptr<llvm::MemoryBuffer> Database;
   llvm::SourceMgr SM;
-  llvm::yaml::Stream YAMLStream;
+  std::unique_ptr<llvm::yaml::Stream> YAMLStream;
+
+  /// \brief Storage for values that needed unescaping.
+  llvm::BumpPtrAllocator Strings;
+
+  std::unique_ptr<CompileCommandCache> Cache;
 };
 
 } // end namespace tooling
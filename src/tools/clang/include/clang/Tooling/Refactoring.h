@@ -33,7 +33,8 @@ namespace tooling {
 ///
 /// This is a refactoring specific version of \see ClangTool. FrontendActions
 /// passed to run() and runAndSave() should add replacements to
-/// getReplacements().
+/// getReplacements(), or to getReplacementCollector() when the tool runs on
+/// several threads.
 class RefactoringTool : public ClangTool {
 public:
   /// \see ClangTool::ClangTool.
@@ -45,6 +46,12 @@ public:
   /// be added during the run of the tool.
   Replacements &getReplacements();
 
+  /// \brief Returns the thread-safe collector to which replacements should be
+  /// added when the tool runs concurrently, see \c ClangTool::setNumThreads.
+  ///
+  /// Its replacements are moved to getReplacements() when they are applied.
+  ReplacementCollector &getReplacementCollector() { return Collector; }
+
   /// \brief Call run(), apply all generated replacements, and immediately save
   /// the results to disk.
   ///
@@ -65,6 +72,7 @@ private:
 
 private:
   Replacements Replace;
+  ReplacementCollector Collector;
 };
 
 } // end namespace tooling
@@ -300,6 +300,32 @@ class ClangTool {
   /// \brief Clear the command line arguments adjuster chain.
   void clearArgumentsAdjusters();
 
+  /// \brief Set the number of compile commands that run() processes at the
+  /// same time, or 0 for one per hardware thread. The default is 1.
+  ///
+  /// With more than one thread, the compile commands of all source files are
+  /// retrieved before any of them runs, and each one runs with a file manager
+  /// of its own instead of changing the current directory. The file managers
+  /// share the results of their stat calls on absolute paths. The tool action
+  /// is called from several threads at once and must be thread-safe; the
+  /// diagnostic consumer is not, as it receives one diagnostic at a time.
+  void setNumThreads(unsigned NumThreads) { this->NumThreads = NumThreads; }
+
+  /// \brief Precompile the \#include directives that several source files
+  /// start with into PCH files in \p Directory, so that the headers they
+  /// include are parsed once rather than once per source file. An empty
+  /// directory, the default, turns this off.
+  ///
+  /// Source files share a PCH when they are compiled with the same arguments
+  /// from the same directory and their leading includes agree; each uses the
+  /// longest such prefix it has in common with another source file. A PCH is
+  /// only used when every header in it has an include guard, because the
+  /// source file still includes them itself. Like with several threads, the
+  /// compile commands are all retrieved up front.
+  void setSharedPCHDirectory(StringRef Directory) {
+    SharedPCHDirectory = Directory;
+  }
+
   /// Runs an action over all files specified in the command line.
   ///
   /// \param Action Tool action.
@@ -311,10 +337,14 @@ class ClangTool {
 
   /// \brief Returns the file manager used in the tool.
   ///
-  /// The file manager is shared between all translation units.
+  /// The file manager is shared between all translation units, unless they
+  /// run concurrently.
   FileManager &getFiles() { return *Files; }
 
  private:
+  int runCollectedCommands(ToolAction *Action,
+                           const std::string &MainExecutable);
+
   const CompilationDatabase &Compilations;
   std::vector<std::string> SourcePaths;
   SharedModuleProvider MP;
@@ -326,6 +356,10 @@ class ClangTool {
   ArgumentsAdjuster ArgsAdjuster;
 
   DiagnosticConsumer *DiagConsumer;
+
+  unsigned NumThreads;
+
+  std::string SharedPCHDirectory;
 };
 
 template <typename T>
@@ -50,7 +50,7 @@ STATISTIC(NumBinaryCacheRebuilds,
           "binary form cache rebuilds");
 
 APINotesManager::APINotesManager(SourceManager &SourceMgr)
-  : SourceMgr(SourceMgr), PrunedCache(false) { }
+  : SourceMgr(SourceMgr), PrunedCache(false), LastReader(nullptr) { }
 
 
 APINotesManager::~APINotesManager() {
@@ -142,8 +142,11 @@ bool APINotesManager::loadAPINotes(const DirectoryEntry *HeaderDir,
   StringRef APINotesFileExt = llvm::sys::path::extension(APINotesFileName);
   if (!APINotesFileExt.empty() &&
       APINotesFileExt.substr(1) == BINARY_APINOTES_EXTENSION) {
-    // Load the file.
-    auto Buffer = FileMgr.getBufferForFile(APINotesFile);
+    // Load the file. The binary form needs no null terminator, which lets it
+    // be mapped.
+    auto Buffer = FileMgr.getBufferForFile(APINotesFile, /*isVolatile=*/false,
+                                           /*ShouldCloseOpenFile=*/true,
+                                           /*RequiresNullTerminator=*/false);
     if (!Buffer) {
       Readers[HeaderDir] = nullptr;
       return true;
@@ -168,9 +171,18 @@ bool APINotesManager::loadAPINotes(const DirectoryEntry *HeaderDir,
     PrunedCache = true;
   }
 
-  // Compute a hash of the API notes file's directory and the Clang version,
-  // to be used as part of the filename for the cached binary copy.
-  auto code = llvm::hash_value(StringRef(APINotesFile->getDir()->getName()));
+  // Open the source file.
+  auto Buffer = FileMgr.getBufferForFile(APINotesFile);
+  if (!Buffer) {
+    Readers[HeaderDir] = nullptr;
+    return true;
+  }
+
+  // Compute a hash of the API notes file's contents and the Clang version,
+  // to be used as part of the filename for the cached binary copy. A cached
+  // copy thus never goes stale, and all the copies of the same API notes
+  // (e.g., in several SDKs) share one.
+  auto code = llvm::hash_value(Buffer.get()->getBuffer());
   code = hash_combine(code, getClangFullRepositoryVersion());
 
   // Determine the file name for the cached binary form.
@@ -186,18 +198,16 @@ bool APINotesManager::loadAPINotes(const DirectoryEntry *HeaderDir,
   if (const FileEntry *CompiledFile = FileMgr.getFile(CompiledFileName,
                                                       /*openFile=*/true,
                                                       /*cacheFailure=*/false)) {
-    // Load the file contents.
-    if (auto Buffer = FileMgr.getBufferForFile(CompiledFile)) {
-      // Make sure the file is up-to-date.
-      if (CompiledFile->getModificationTime()
-            >= APINotesFile->getModificationTime()) {
-        // Load the file.
-        if (auto Reader = APINotesReader::get(std::move(Buffer.get()))) {
-          // Success.
-          ++NumBinaryCacheHits;
-          Readers[HeaderDir] = Reader.release();
-          return false;
-        }
+    // Load the file contents, mapped if they are large enough.
+    if (auto CompiledBuffer =
+            FileMgr.getBufferForFile(CompiledFile, /*isVolatile=*/false,
+                                     /*ShouldCloseOpenFile=*/true,
+                                     /*RequiresNullTerminator=*/false)) {
+      if (auto Reader = APINotesReader::get(std::move(CompiledBuffer.get()))) {
+        // Success.
+        ++NumBinaryCacheHits;
+        Readers[HeaderDir] = Reader.release();
+        return false;
       }
     }
 
@@ -209,13 +219,6 @@ bool APINotesManager::loadAPINotes(const DirectoryEntry *HeaderDir,
     ++NumBinaryCacheMisses;
   }
 
-  // Open the source file.
-  auto Buffer = FileMgr.getBufferForFile(APINotesFile);
-  if (!Buffer) {
-    Readers[HeaderDir] = nullptr;
-    return true;
-  }
-
   // Compile the API notes source into a buffer.
   // FIXME: Either propagate OSType through or, better yet, improve the binary
   // APINotes format to maintain complete availability information.
@@ -340,10 +343,21 @@ APINotesReader *APINotesManager::findAPINotes(SourceLocation Loc) {
   FileID ID = SourceMgr.getFileID(ExpansionLoc);
   if (ID.isInvalid())
     return nullptr;
+
+  // Consecutive declarations tend to come from the same file.
+  if (ID == LastFile)
+    return LastReader;
+
   const FileEntry *File = SourceMgr.getFileEntryForID(ID);
   if (!File)
     return nullptr;
 
+  LastFile = ID;
+  LastReader = findAPINotes(File);
+  return LastReader;
+}
+
+APINotesReader *APINotesManager::findAPINotes(const FileEntry *File) {
   // Look for API notes in the directory corresponding to this file, or one of
   // its its parent directories.
   const DirectoryEntry *Dir = File->getDir();
@@ -21,6 +21,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
 
 using namespace clang;
 using namespace api_notes;
@@ -448,6 +449,11 @@ public:
   /// The global function table.
   std::unique_ptr<SerializedGlobalFunctionTable> GlobalFunctionTable;
 
+  /// The context IDs of the Objective-C classes and protocols looked up so
+  /// far, by name, so that the members of a context find it quickly.
+  llvm::StringMap<Optional<ContextID>> ObjCClassIDs;
+  llvm::StringMap<Optional<ContextID>> ObjCProtocolIDs;
+
   /// Retrieve the identifier ID for the given string, or an empty
   /// optional if the string is unknown.
   Optional<IdentifierID> getIdentifier(StringRef str);
@@ -456,6 +462,10 @@ public:
   /// optional if the string is unknown.
   Optional<SelectorID> getSelector(ObjCSelectorRef selector);
 
+  /// Retrieve the context ID for the given Objective-C class or protocol,
+  /// or an empty optional if it is unknown.
+  Optional<ContextID> getObjCContextID(StringRef name, bool isProtocol);
+
   bool readControlBlock(llvm::BitstreamCursor &cursor, 
                         SmallVectorImpl<uint64_t> &scratch);
   bool readIdentifierBlock(llvm::BitstreamCursor &cursor,
@@ -513,6 +523,26 @@ Optional<SelectorID> APINotesReader::Implementation::getSelector(
 
 }
 
+Optional<ContextID> APINotesReader::Implementation::getObjCContextID(
+                      StringRef name, bool isProtocol) {
+  auto &cache = isProtocol ? ObjCProtocolIDs : ObjCClassIDs;
+  auto cached = cache.find(name);
+  if (cached != cache.end())
+    return cached->second;
+
+  Optional<ContextID> result;
+  if (ObjCContextTable) {
+    if (Optional<IdentifierID> nameID = getIdentifier(name)) {
+      auto known = ObjCContextTable->find({*nameID, isProtocol ? '\1' : '\0'});
+      if (known != ObjCContextTable->end())
+        result = ContextID((*known).first);
+    }
+  }
+
+  cache.insert(std::make_pair(name, result));
+  return result;
+}
+
 bool APINotesReader::Implementation::readControlBlock(
        llvm::BitstreamCursor &cursor,
        SmallVectorImpl<uint64_t> &scratch) {
@@ -1060,6 +1090,7 @@ APINotesReader::APINotesReader(std::unique_ptr<llvm::MemoryBuffer> inputBuffer,
 }
 
 APINotesReader::~APINotesReader() {
+  delete &Impl;
 }
 
 std::unique_ptr<APINotesReader> 
@@ -1111,6 +1142,14 @@ auto APINotesReader::lookupObjCProtocol(StringRef name)
   return std::make_pair(ContextID(result.first), result.second);
 }
 
+Optional<ContextID> APINotesReader::lookupObjCClassID(StringRef name) {
+  return Impl.getObjCContextID(name, /*isProtocol=*/false);
+}
+
+Optional<ContextID> APINotesReader::lookupObjCProtocolID(StringRef name) {
+  return Impl.getObjCContextID(name, /*isProtocol=*/true);
+}
+
 Optional<ObjCPropertyInfo> APINotesReader::lookupObjCProperty(
                              ContextID contextID,
                              StringRef name) {
@@ -55,6 +55,9 @@ unsigned ASTContext::NumImplicitMoveAssignmentOperators;
 unsigned ASTContext::NumImplicitMoveAssignmentOperatorsDeclared;
 unsigned ASTContext::NumImplicitDestructors;
 unsigned ASTContext::NumImplicitDestructorsDeclared;
+unsigned ASTContext::NumConstexprCalls;
+unsigned ASTContext::NumConstexprCallsCached;
+uint64_t ASTContext::NumConstexprSteps;
 
 enum FloatingRank {
   HalfRank, FloatRank, DoubleRank, LongDoubleRank
@@ -743,7 +746,7 @@ ASTContext::ASTContext(LangOptions &LOpts, SourceManager &SM,
       AddrSpaceMap(nullptr), Target(nullptr), PrintingPolicy(LOpts),
       Idents(idents), Selectors(sels), BuiltinInfo(builtins),
       DeclarationNames(*this), ExternalSource(nullptr), Listener(nullptr),
-      Comments(SM), CommentsLoaded(false),
+      AllocatedBytes(), Comments(SM), CommentsLoaded(false),
       CommentCommandTraits(BumpAlloc, LOpts.CommentOpts), LastSDM(nullptr, 0) {
   TUDecl = TranslationUnitDecl::Create(*this);
 }
@@ -863,6 +866,42 @@ void ASTContext::PrintStats() const {
   }
 
   BumpAlloc.PrintStats();
+  PrintAllocationStats(llvm::errs());
+}
+
+void ASTContext::PrintAllocationStats(raw_ostream &OS) const {
+  // Types are allocated in many different ways, so measure the memory used
+  // by their classes instead. The trailing data of some types, such as the
+  // parameter types of FunctionProtoType, is counted as other memory.
+  uint64_t TypeBytes = 0;
+  for (const Type *T : Types) {
+    switch (T->getTypeClass()) {
+#define TYPE(Name, Parent)                                                     \
+    case Type::Name:                                                           \
+      TypeBytes += sizeof(Name##Type);                                         \
+      break;
+#define ABSTRACT_TYPE(Name, Parent)
+#include "clang/AST/TypeNodes.def"
+    }
+  }
+
+  static const char *const KindNames[NumASTAllocationKinds] = {
+    "Decl", "Stmt", "TypeLoc", "Attr"
+  };
+  uint64_t Total = BumpAlloc.getBytesAllocated();
+  uint64_t Accounted = TypeBytes;
+  OS << "\n*** AST Memory:\n";
+  for (unsigned I = 0; I != NumASTAllocationKinds; ++I) {
+    OS << "  " << AllocatedBytes[I] << " bytes in " << KindNames[I]
+       << " nodes\n";
+    Accounted += AllocatedBytes[I];
+  }
+  OS << "  " << TypeBytes << " bytes in Type nodes\n";
+  OS << "  " << (Total > Accounted ? Total - Accounted : 0)
+     << " bytes in other allocations\n";
+  OS << "  " << Total << " bytes allocated in " << BumpAlloc.GetNumSlabs()
+     << " slabs of " << BumpAlloc.getTotalMemory() << " bytes\n";
+  OS << "  " << getSideTableAllocatedMemory() << " bytes in side tables\n";
 }
 
 RecordDecl *ASTContext::buildImplicitRecord(StringRef Name,
@@ -1982,6 +2021,7 @@ TypeSourceInfo *ASTContext::CreateTypeSourceInfo(QualType T,
     assert(DataSize == TypeLoc::getFullDataSizeForType(T) &&
            "incorrect data size provided to CreateTypeSourceInfo!");
 
+  noteAllocation(AAK_TypeLoc, sizeof(TypeSourceInfo) + DataSize);
   TypeSourceInfo *TInfo =
     (TypeSourceInfo*)BumpAlloc.Allocate(sizeof(TypeSourceInfo) + DataSize, 8);
   new (TInfo) TypeSourceInfo(T);
@@ -8459,6 +8499,16 @@ ASTContext::getMaterializedTemporaryValue(const MaterializeTemporaryExpr *E,
   return I == MaterializedTemporaryValues.end() ? nullptr : &I->second;
 }
 
+ConstexprCallResult *ASTContext::getConstexprCallResult(StringRef Key,
+                                                        bool MayCreate) {
+  if (MayCreate)
+    return &ConstexprCallResults[Key];
+
+  llvm::StringMap<ConstexprCallResult>::iterator I =
+      ConstexprCallResults.find(Key);
+  return I == ConstexprCallResults.end() ? nullptr : &I->second;
+}
+
 bool ASTContext::AtomicUsesUnsupportedLibcall(const AtomicExpr *E) const {
   const llvm::Triple &T = getTargetInfo().getTriple();
   if (!T.isOSDarwin())
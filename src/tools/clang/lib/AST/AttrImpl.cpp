@@ -20,6 +20,12 @@ using namespace clang;
 
 Attr::~Attr() { }
 
+void *Attr::operator new(size_t Bytes, ASTContext &C,
+                         size_t Alignment) throw() {
+  C.noteAllocation(ASTContext::AAK_Attr, Bytes);
+  return ::operator new(Bytes, C, Alignment);
+}
+
 void InheritableAttr::anchor() { }
 
 void InheritableParamAttr::anchor() { }
@@ -49,6 +49,7 @@ void *Decl::operator new(std::size_t Size, const ASTContext &Context,
                          unsigned ID, std::size_t Extra) {
   // Allocate an extra 8 bytes worth of storage, which ensures that the
   // resulting pointer will still be 8-byte aligned. 
+  Context.noteAllocation(ASTContext::AAK_Decl, Size + Extra + 8);
   void *Start = Context.Allocate(Size + Extra + 8);
   void *Result = (char*)Start + 8;
 
@@ -66,6 +67,7 @@ void *Decl::operator new(std::size_t Size, const ASTContext &Context,
 void *Decl::operator new(std::size_t Size, const ASTContext &Ctx,
                          DeclContext *Parent, std::size_t Extra) {
   assert(!Parent || &Parent->getParentASTContext() == &Ctx);
+  Ctx.noteAllocation(ASTContext::AAK_Decl, Size + Extra);
   return ::operator new(Size + Extra, Ctx);
 }
 
@@ -1332,8 +1334,22 @@ DeclContext::lookup(DeclarationName Name) {
 
     StoredDeclsMap *Map = LookupPtr.getPointer();
 
-    if (LookupPtr.getInt())
-      Map = buildLookup();
+    if (LookupPtr.getInt()) {
+      // Declarations from the external source are found by name through its
+      // visible lookup table, and buildLookupImpl skips them anyway, so only
+      // walk the declarations we already have rather than deserializing the
+      // whole lexical contents of this context. Each local name consults the
+      // external source as it is added, so no entry is left incomplete.
+      SmallVector<DeclContext *, 2> Contexts;
+      collectAllContexts(Contexts);
+      for (unsigned I = 0, N = Contexts.size(); I != N; ++I)
+        buildLookupImpl<&DeclContext::noload_decls_begin,
+                        &DeclContext::noload_decls_end>(Contexts[I]);
+
+      // We no longer have any lazy decls.
+      LookupPtr.setInt(false);
+      Map = LookupPtr.getPointer();
+    }
 
     if (!Map)
       Map = CreateStoredDeclsMap(getParentASTContext());
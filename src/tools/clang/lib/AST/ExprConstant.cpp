@@ -426,6 +426,10 @@ namespace {
     /// CallStackDepth - The number of calls in the call stack right now.
     unsigned CallStackDepth;
 
+    /// MaxCallStackDepth - The deepest the call stack has been since it was
+    /// last reset.
+    unsigned MaxCallStackDepth;
+
     /// NextCallIndex - The next call index to assign.
     unsigned NextCallIndex;
 
@@ -454,6 +458,11 @@ namespace {
     /// notes attached to it will also be stored, otherwise they will not be.
     bool HasActiveDiagnostic;
 
+    /// NumUncacheableEvents - The number of diagnostics, stored or not, and of
+    /// accesses to the object under construction so far. A constexpr call
+    /// whose evaluation adds to these is not cached.
+    unsigned NumUncacheableEvents;
+
     enum EvaluationMode {
       /// Evaluate as a constant expression. Stop if we find that the expression
       /// is not a constant expression.
@@ -509,12 +518,17 @@ namespace {
 
     EvalInfo(const ASTContext &C, Expr::EvalStatus &S, EvaluationMode Mode)
       : Ctx(const_cast<ASTContext &>(C)), EvalStatus(S), CurrentCall(nullptr),
-        CallStackDepth(0), NextCallIndex(1),
+        CallStackDepth(0), MaxCallStackDepth(0), NextCallIndex(1),
         StepsLeft(getLangOpts().ConstexprStepLimit),
         BottomFrame(*this, SourceLocation(), nullptr, nullptr, nullptr),
         EvaluatingDecl((const ValueDecl *)nullptr),
         EvaluatingDeclValue(nullptr), HasActiveDiagnostic(false),
-        EvalMode(Mode) {}
+        NumUncacheableEvents(0), EvalMode(Mode) {}
+
+    ~EvalInfo() {
+      ASTContext::NumConstexprSteps +=
+          getLangOpts().ConstexprStepLimit - StepsLeft;
+    }
 
     void setEvaluatingDecl(APValue::LValueBase Base, APValue &Value) {
       EvaluatingDecl = Base;
@@ -575,6 +589,7 @@ namespace {
     OptionalDiagnostic Diag(SourceLocation Loc, diag::kind DiagId
                               = diag::note_invalid_subexpr_in_const_expr,
                             unsigned ExtraNotes = 0) {
+      ++NumUncacheableEvents;
       if (EvalStatus.Diag) {
         // If we have a prior diagnostic, it will be noting that the expression
         // isn't a constant expression. This diagnostic is more important,
@@ -624,6 +639,7 @@ namespace {
                             unsigned ExtraNotes = 0) {
       if (EvalStatus.Diag)
         return Diag(E->getExprLoc(), DiagId, ExtraNotes);
+      ++NumUncacheableEvents;
       HasActiveDiagnostic = false;
       return OptionalDiagnostic();
     }
@@ -640,6 +656,7 @@ namespace {
       // Don't override a previous diagnostic. Don't bother collecting
       // diagnostics if we're evaluating for overflow.
       if (!EvalStatus.Diag || !EvalStatus.Diag->empty()) {
+        ++NumUncacheableEvents;
         HasActiveDiagnostic = false;
         return OptionalDiagnostic();
       }
@@ -825,6 +842,8 @@ CallStackFrame::CallStackFrame(EvalInfo &Info, SourceLocation CallLoc,
       Index(Info.NextCallIndex++), This(This), Arguments(Arguments) {
   Info.CurrentCall = this;
   ++Info.CallStackDepth;
+  Info.MaxCallStackDepth = std::max(Info.MaxCallStackDepth,
+                                    Info.CallStackDepth);
 }
 
 CallStackFrame::~CallStackFrame() {
@@ -2640,6 +2659,8 @@ CompleteObject findCompleteObject(EvalInfo &Info, const Expr *E, AccessKinds AK,
         // Therefore we use the C++1y rules in C++11 too.
         const ValueDecl *VD = Info.EvaluatingDecl.dyn_cast<const ValueDecl*>();
         const ValueDecl *ED = MTE->getExtendingDecl();
+        if (VD && VD->getCanonicalDecl() == ED->getCanonicalDecl())
+          ++Info.NumUncacheableEvents;
         if (!(BaseType.isConstQualified() &&
               BaseType->isIntegralOrEnumerationType()) &&
             !(VD && VD->getCanonicalDecl() == ED->getCanonicalDecl())) {
@@ -2677,6 +2698,7 @@ CompleteObject findCompleteObject(EvalInfo &Info, const Expr *E, AccessKinds AK,
   // and this doesn't do quite the right thing for const subobjects of the
   // object under construction.
   if (LVal.getLValueBase() == Info.EvaluatingDecl) {
+    ++Info.NumUncacheableEvents;
     BaseType = Info.Ctx.getCanonicalType(BaseType);
     BaseType.removeLocalConst();
   }
@@ -3705,18 +3727,91 @@ static bool EvaluateArgs(ArrayRef<const Expr*> Args, ArgVector &ArgValues,
   return Success;
 }
 
-/// Evaluate a function call.
-static bool HandleFunctionCall(SourceLocation CallLoc,
-                               const FunctionDecl *Callee, const LValue *This,
-                               ArrayRef<const Expr*> Args, const Stmt *Body,
-                               EvalInfo &Info, APValue &Result) {
-  ArgVector ArgValues(Args.size());
-  if (!EvaluateArgs(Args, ArgValues, Info))
-    return false;
+static void appendCallCacheKey(SmallVectorImpl<char> &Key, const void *Data,
+                               size_t Size) {
+  const char *Bytes = static_cast<const char *>(Data);
+  Key.append(Bytes, Bytes + Size);
+}
 
-  if (!Info.CheckCallLimit(CallLoc))
+static void appendCallCacheKey(SmallVectorImpl<char> &Key,
+                               const llvm::APInt &I) {
+  unsigned BitWidth = I.getBitWidth();
+  appendCallCacheKey(Key, &BitWidth, sizeof(BitWidth));
+  appendCallCacheKey(Key, I.getRawData(), I.getNumWords() * sizeof(uint64_t));
+}
+
+/// Check whether a value is made of numbers only, as opposed to referring to
+/// objects, and if so append an encoding of it to \p Key, if given. Equal
+/// values of the same type have equal encodings.
+static bool appendCallCacheKey(SmallVectorImpl<char> *Key, const APValue &V) {
+  if (Key)
+    Key->push_back(char(V.getKind()));
+  switch (V.getKind()) {
+  case APValue::Uninitialized:
+  case APValue::LValue:
+  case APValue::MemberPointer:
+  case APValue::AddrLabelDiff:
     return false;
+  case APValue::Int:
+    if (Key) {
+      appendCallCacheKey(*Key, V.getInt());
+      Key->push_back(V.getInt().isUnsigned());
+    }
+    return true;
+  case APValue::Float:
+    if (Key)
+      appendCallCacheKey(*Key, V.getFloat().bitcastToAPInt());
+    return true;
+  case APValue::ComplexInt:
+    if (Key) {
+      appendCallCacheKey(*Key, V.getComplexIntReal());
+      appendCallCacheKey(*Key, V.getComplexIntImag());
+    }
+    return true;
+  case APValue::ComplexFloat:
+    if (Key) {
+      appendCallCacheKey(*Key, V.getComplexFloatReal().bitcastToAPInt());
+      appendCallCacheKey(*Key, V.getComplexFloatImag().bitcastToAPInt());
+    }
+    return true;
+  case APValue::Vector:
+    for (unsigned I = 0, N = V.getVectorLength(); I != N; ++I)
+      if (!appendCallCacheKey(Key, V.getVectorElt(I)))
+        return false;
+    return true;
+  case APValue::Array: {
+    unsigned Init = V.getArrayInitializedElts();
+    if (Key)
+      appendCallCacheKey(*Key, &Init, sizeof(Init));
+    for (unsigned I = 0; I != Init; ++I)
+      if (!appendCallCacheKey(Key, V.getArrayInitializedElt(I)))
+        return false;
+    return !V.hasArrayFiller() || appendCallCacheKey(Key, V.getArrayFiller());
+  }
+  case APValue::Struct:
+    for (unsigned I = 0, N = V.getStructNumBases(); I != N; ++I)
+      if (!appendCallCacheKey(Key, V.getStructBase(I)))
+        return false;
+    for (unsigned I = 0, N = V.getStructNumFields(); I != N; ++I)
+      if (!appendCallCacheKey(Key, V.getStructField(I)))
+        return false;
+    return true;
+  case APValue::Union: {
+    const FieldDecl *Field = V.getUnionField();
+    if (Key)
+      appendCallCacheKey(*Key, &Field, sizeof(Field));
+    return !Field || appendCallCacheKey(Key, V.getUnionValue());
+  }
+  }
+  llvm_unreachable("unknown APValue kind");
+}
 
+/// Evaluate the body of a function call, once its arguments are evaluated.
+static bool HandleFunctionBody(SourceLocation CallLoc,
+                               const FunctionDecl *Callee, const LValue *This,
+                               ArrayRef<const Expr*> Args,
+                               ArgVector &ArgValues, const Stmt *Body,
+                               EvalInfo &Info, APValue &Result) {
   CallStackFrame Frame(Info, CallLoc, Callee, This, ArgValues.data());
 
   // For a trivial copy or move assignment, perform an APValue copy. This is
@@ -3753,6 +3848,76 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
   return ESR == ESR_Returned;
 }
 
+/// Evaluate a function call.
+static bool HandleFunctionCall(SourceLocation CallLoc,
+                               const FunctionDecl *Callee, const LValue *This,
+                               ArrayRef<const Expr*> Args, const Stmt *Body,
+                               EvalInfo &Info, APValue &Result) {
+  ArgVector ArgValues(Args.size());
+  if (!EvaluateArgs(Args, ArgValues, Info))
+    return false;
+
+  if (!Info.CheckCallLimit(CallLoc))
+    return false;
+  ++ASTContext::NumConstexprCalls;
+
+  // The value of a call to a function that is not a member function and is
+  // only passed numbers only depends on them, unless its evaluation has been
+  // diagnosed or has read the object under construction. Such calls are
+  // cached, along with the steps and call depth they took, so that hitting
+  // the cache respects the limits the same way evaluating the call would.
+  SmallString<64> CacheKey;
+  bool Cacheable = !This && Info.getLangOpts().CPlusPlus11 &&
+                   !Info.checkingPotentialConstantExpression() &&
+                   !Info.checkingForOverflow();
+  if (Cacheable) {
+    appendCallCacheKey(CacheKey, &Callee, sizeof(Callee));
+    for (const APValue &Arg : ArgValues)
+      if (!appendCallCacheKey(&CacheKey, Arg))
+        Cacheable = false;
+  }
+  if (Cacheable) {
+    if (const ConstexprCallResult *Cached =
+            Info.Ctx.getConstexprCallResult(CacheKey, /*MayCreate=*/false)) {
+      if (Cached->Steps <= Info.StepsLeft &&
+          Info.CallStackDepth + Cached->Depth <=
+              Info.getLangOpts().ConstexprCallDepth + 1) {
+        Info.StepsLeft -= Cached->Steps;
+        Info.MaxCallStackDepth = std::max(Info.MaxCallStackDepth,
+                                          Info.CallStackDepth + Cached->Depth);
+        Result = Cached->Value;
+        ++ASTContext::NumConstexprCallsCached;
+        return true;
+      }
+    }
+  }
+
+  unsigned OldMaxCallStackDepth = Info.MaxCallStackDepth;
+  unsigned OldStepsLeft = Info.StepsLeft;
+  unsigned OldUncacheableEvents = Info.NumUncacheableEvents;
+  bool HadSideEffects = Info.EvalStatus.HasSideEffects;
+  Info.MaxCallStackDepth = Info.CallStackDepth;
+  bool Success = HandleFunctionBody(CallLoc, Callee, This, Args, ArgValues,
+                                    Body, Info, Result);
+  unsigned Depth = Info.MaxCallStackDepth - Info.CallStackDepth;
+  Info.MaxCallStackDepth = std::max(OldMaxCallStackDepth,
+                                    Info.MaxCallStackDepth);
+
+  if (Cacheable && Success &&
+      (Info.EvalMode == EvalInfo::EM_ConstantExpression ||
+       Info.EvalMode == EvalInfo::EM_ConstantExpressionUnevaluated ||
+       Info.EvalMode == EvalInfo::EM_ConstantFold) &&
+      Info.NumUncacheableEvents == OldUncacheableEvents && !HadSideEffects &&
+      !Info.EvalStatus.HasSideEffects && appendCallCacheKey(nullptr, Result)) {
+    ConstexprCallResult *Cached =
+        Info.Ctx.getConstexprCallResult(CacheKey, /*MayCreate=*/true);
+    Cached->Value = Result;
+    Cached->Steps = OldStepsLeft - Info.StepsLeft;
+    Cached->Depth = Depth;
+  }
+  return Success;
+}
+
 /// Evaluate a constructor call.
 static bool HandleConstructorCall(SourceLocation CallLoc, const LValue &This,
                                   ArrayRef<const Expr*> Args,
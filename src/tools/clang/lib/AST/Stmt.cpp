@@ -51,6 +51,7 @@ static StmtClassNameTable &getStmtInfoTableEntry(Stmt::StmtClass E) {
 
 void *Stmt::operator new(size_t bytes, const ASTContext& C,
                          unsigned alignment) {
+  C.noteAllocation(ASTContext::AAK_Stmt, bytes);
   return ::operator new(bytes, C, alignment);
 }
 
@@ -34,7 +34,8 @@ namespace {
 
 typedef MatchFinder::MatchCallback MatchCallback;
 
-// The maximum number of memoization entries to store.
+// The maximum number of memoization entries to store in each of the two
+// generations of the cache.
 // 10k has been experimentally found to give a good trade-off
 // of performance vs. memory consumption by running matcher
 // that match on every statement over a very large codebase.
@@ -391,10 +392,9 @@ public:
     // Note that we key on the bindings *before* the match.
     Key.BoundNodes = *Builder;
 
-    MemoizationMap::iterator I = ResultCache.find(Key);
-    if (I != ResultCache.end()) {
-      *Builder = I->second.Nodes;
-      return I->second.ResultOfMatch;
+    if (const MemoizedMatchResult *Cached = findMemoizedResult(Key)) {
+      *Builder = Cached->Nodes;
+      return Cached->ResultOfMatch;
     }
 
     MemoizedMatchResult Result;
@@ -409,6 +409,35 @@ public:
     return CachedResult.ResultOfMatch;
   }
 
+  // Returns the memoized result for \p Key, if any.
+  //
+  // Results found in the previous generation move to the current one, so
+  // that the results still in use survive the next eviction.
+  const MemoizedMatchResult *findMemoizedResult(const MatchKey &Key) {
+    MemoizationMap::iterator I = ResultCache.find(Key);
+    if (I != ResultCache.end())
+      return &I->second;
+    I = PreviousResultCache.find(Key);
+    if (I == PreviousResultCache.end())
+      return nullptr;
+    MemoizedMatchResult &Result = ResultCache[Key];
+    Result = std::move(I->second);
+    PreviousResultCache.erase(I);
+    return &Result;
+  }
+
+  // Drops the results that were not used since the last eviction, once the
+  // current generation is full.
+  //
+  // Must be called outside of the recursive matching calls, so that no
+  // iterators into the cache are invalidated.
+  void evictMemoizedResults() {
+    if (ResultCache.size() <= MaxMemoizationEntries)
+      return;
+    PreviousResultCache.swap(ResultCache);
+    ResultCache.clear();
+  }
+
   // Matches children or descendants of 'Node' with 'BaseMatcher'.
   bool matchesRecursively(const ast_type_traits::DynTypedNode &Node,
                           const DynTypedMatcher &Matcher,
@@ -429,8 +458,7 @@ public:
                       BoundNodesTreeBuilder *Builder,
                       TraversalKind Traversal,
                       BindKind Bind) override {
-    if (ResultCache.size() > MaxMemoizationEntries)
-      ResultCache.clear();
+    evictMemoizedResults();
     return memoizedMatchesRecursively(Node, Matcher, Builder, 1, Traversal,
                                       Bind);
   }
@@ -439,8 +467,7 @@ public:
                            const DynTypedMatcher &Matcher,
                            BoundNodesTreeBuilder *Builder,
                            BindKind Bind) override {
-    if (ResultCache.size() > MaxMemoizationEntries)
-      ResultCache.clear();
+    evictMemoizedResults();
     return memoizedMatchesRecursively(Node, Matcher, Builder, INT_MAX,
                                       TK_AsIs, Bind);
   }
@@ -451,8 +478,7 @@ public:
                          AncestorMatchMode MatchMode) override {
     // Reset the cache outside of the recursive call to make sure we
     // don't invalidate any iterators.
-    if (ResultCache.size() > MaxMemoizationEntries)
-      ResultCache.clear();
+    evictMemoizedResults();
     return memoizedMatchesAncestorOfRecursively(Node, Matcher, Builder,
                                                 MatchMode);
   }
@@ -632,10 +658,9 @@ private:
 
     // Note that we cannot use insert and reuse the iterator, as recursive
     // calls to match might invalidate the result cache iterators.
-    MemoizationMap::iterator I = ResultCache.find(Key);
-    if (I != ResultCache.end()) {
-      *Builder = I->second.Nodes;
-      return I->second.ResultOfMatch;
+    if (const MemoizedMatchResult *Cached = findMemoizedResult(Key)) {
+      *Builder = Cached->Nodes;
+      return Cached->ResultOfMatch;
     }
 
     MemoizedMatchResult Result;
@@ -749,8 +774,15 @@ private:
   llvm::DenseMap<const Type*, std::set<const TypedefNameDecl*> > TypeAliases;
 
   // Maps (matcher, node) -> the match result for memoization.
+  //
+  // Instead of dropping all results when the cache is full, the cache keeps
+  // two generations: the results memoized or used since the last eviction,
+  // and those from before it, which are dropped at the next eviction unless
+  // they are used again. This approximates LRU eviction without having to
+  // track the use of every entry.
   typedef std::map<MatchKey, MemoizedMatchResult> MemoizationMap;
   MemoizationMap ResultCache;
+  MemoizationMap PreviousResultCache;
 };
 
 static CXXRecordDecl *getAsCXXRecordDecl(const Type *TypeNode) {
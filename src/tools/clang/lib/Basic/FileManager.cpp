@@ -414,7 +414,8 @@ bool FileManager::makeAbsolutePath(SmallVectorImpl<char> &Path) const {
 
 llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
 FileManager::getBufferForFile(const FileEntry *Entry, bool isVolatile,
-                              bool ShouldCloseOpenFile) {
+                              bool ShouldCloseOpenFile,
+                              bool RequiresNullTerminator) {
   uint64_t FileSize = Entry->getSize();
   // If there's a high enough chance that the file have changed since we
   // got its size, force a stat before opening it.
@@ -425,8 +426,8 @@ FileManager::getBufferForFile(const FileEntry *Entry, bool isVolatile,
   // If the file is already open, use the open file descriptor.
   if (Entry->File) {
     auto Result =
-        Entry->File->getBuffer(Filename, FileSize,
-                               /*RequiresNullTerminator=*/true, isVolatile);
+        Entry->File->getBuffer(Filename, FileSize, RequiresNullTerminator,
+                               isVolatile);
     // FIXME: we need a set of APIs that can make guarantees about whether a
     // FileEntry is open or not.
     if (ShouldCloseOpenFile)
@@ -437,13 +438,13 @@ FileManager::getBufferForFile(const FileEntry *Entry, bool isVolatile,
   // Otherwise, open the file.
 
   if (FileSystemOpts.WorkingDir.empty())
-    return FS->getBufferForFile(Filename, FileSize,
-                                /*RequiresNullTerminator=*/true, isVolatile);
+    return FS->getBufferForFile(Filename, FileSize, RequiresNullTerminator,
+                                isVolatile);
 
   SmallString<128> FilePath(Entry->getName());
   FixupRelativePath(FilePath);
-  return FS->getBufferForFile(FilePath.str(), FileSize,
-                              /*RequiresNullTerminator=*/true, isVolatile);
+  return FS->getBufferForFile(FilePath.str(), FileSize, RequiresNullTerminator,
+                              isVolatile);
 }
 
 llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
@@ -12,7 +12,14 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Basic/FileSystemStatCache.h"
+#include "clang/Basic/CharInfo.h"
 #include "clang/Basic/VirtualFileSystem.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/Errc.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/OnDiskHashTable.h"
 #include "llvm/Support/Path.h"
 
 // FIXME: This is terrible, we need this for ::close.
@@ -135,3 +142,334 @@ MemorizeStatCalls::getStat(const char *Path, FileData &Data, bool isFile,
 
   return Result;
 }
+
+//===----------------------------------------------------------------------===//
+// DirectoryListingStatCache
+//===----------------------------------------------------------------------===//
+
+/// The cache file starts with a magic number and a version, followed by the
+/// offset of the buckets of its hash table. The table maps the absolute path
+/// of each directory to its identity, its modification time and the (ASCII
+/// lowercase) names of its entries, each preceded by its 16-bit length.
+static const uint32_t DirectoryCacheMagic = 0x4c44434c; // 'LCDL'
+static const uint32_t DirectoryCacheVersion = 1;
+static const unsigned DirectoryCacheHeaderSize = 16;
+
+namespace {
+struct OnDiskListing {
+  llvm::sys::fs::UniqueID UID;
+  uint64_t MTime;
+  std::string Names;
+};
+
+class DirectoryListingTrait {
+public:
+  typedef StringRef key_type;
+  typedef StringRef key_type_ref;
+  typedef StringRef internal_key_type;
+  typedef StringRef external_key_type;
+  typedef OnDiskListing data_type;
+  typedef const OnDiskListing &data_type_ref;
+  typedef uint32_t hash_value_type;
+  typedef uint32_t offset_type;
+
+  static hash_value_type ComputeHash(StringRef Key) {
+    return llvm::HashString(Key);
+  }
+  static bool EqualKey(StringRef LHS, StringRef RHS) { return LHS == RHS; }
+  static StringRef GetInternalKey(StringRef Key) { return Key; }
+  static StringRef GetExternalKey(StringRef Key) { return Key; }
+
+  static std::pair<offset_type, offset_type>
+  EmitKeyDataLength(raw_ostream &Out, StringRef Key,
+                    const OnDiskListing &Data) {
+    using namespace llvm::support;
+    offset_type KeyLen = Key.size();
+    offset_type DataLen = 3 * sizeof(uint64_t) + Data.Names.size();
+    endian::Writer<little> Writer(Out);
+    Writer.write<uint16_t>(KeyLen);
+    Writer.write<uint32_t>(DataLen);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static void EmitKey(raw_ostream &Out, StringRef Key, offset_type) {
+    Out << Key;
+  }
+
+  static void EmitData(raw_ostream &Out, StringRef, const OnDiskListing &Data,
+                       offset_type) {
+    using namespace llvm::support;
+    endian::Writer<little> Writer(Out);
+    Writer.write<uint64_t>(Data.UID.getDevice());
+    Writer.write<uint64_t>(Data.UID.getFile());
+    Writer.write<uint64_t>(Data.MTime);
+    Out << Data.Names;
+  }
+
+  static std::pair<offset_type, offset_type>
+  ReadKeyDataLength(const unsigned char *&D) {
+    using namespace llvm::support;
+    offset_type KeyLen = endian::readNext<uint16_t, little, unaligned>(D);
+    offset_type DataLen = endian::readNext<uint32_t, little, unaligned>(D);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static StringRef ReadKey(const unsigned char *D, offset_type KeyLen) {
+    return StringRef(reinterpret_cast<const char *>(D), KeyLen);
+  }
+
+  static OnDiskListing ReadData(StringRef, const unsigned char *D,
+                                offset_type DataLen) {
+    using namespace llvm::support;
+    OnDiskListing Data;
+    uint64_t Device = endian::readNext<uint64_t, little, unaligned>(D);
+    uint64_t File = endian::readNext<uint64_t, little, unaligned>(D);
+    Data.UID = llvm::sys::fs::UniqueID(Device, File);
+    Data.MTime = endian::readNext<uint64_t, little, unaligned>(D);
+    Data.Names.assign(reinterpret_cast<const char *>(D),
+                      DataLen - 3 * sizeof(uint64_t));
+    return Data;
+  }
+};
+} // end anonymous namespace
+
+class DirectoryListingStatCache::OnDiskTable
+    : public llvm::OnDiskIterableChainedHashTable<DirectoryListingTrait> {
+public:
+  using OnDiskIterableChainedHashTable::OnDiskIterableChainedHashTable;
+};
+
+struct DirectoryListingStatCache::Listing {
+  enum ListingKind { Unknown, Unusable, Missing, Listed };
+  ListingKind Kind = Unknown;
+  /// Whether the listing was computed here and can be shared.
+  bool Shareable = false;
+  llvm::sys::fs::UniqueID UID;
+  uint64_t MTime = 0;
+  llvm::StringSet<> Names;
+
+  bool contains(StringRef LowerName) const {
+    return Kind == Listed && Names.count(LowerName);
+  }
+};
+
+/// Whether the lookups of \p Name can be answered from a listing, and if so
+/// its ASCII lowercase spelling in \p LowerName.
+static bool getListingName(StringRef Name, SmallVectorImpl<char> &LowerName) {
+  if (Name.empty() || Name == "." || Name == ".." || Name.size() > 0xffff)
+    return false;
+  LowerName.clear();
+  for (char C : Name) {
+    if (static_cast<unsigned char>(C) >= 0x80)
+      return false;
+    LowerName.push_back(toLowercase(C));
+  }
+  return true;
+}
+
+DirectoryListingStatCache::DirectoryListingStatCache(StringRef CacheFile)
+    : CacheFile(CacheFile), Modified(false) {
+  SmallString<256> CWD;
+  if (!llvm::sys::fs::current_path(CWD))
+    WorkingDir = CWD.str();
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> File =
+      llvm::MemoryBuffer::getFile(CacheFile, -1,
+                                  /*RequiresNullTerminator=*/false);
+  if (!File)
+    return;
+
+  using namespace llvm::support;
+  const unsigned char *Base =
+      reinterpret_cast<const unsigned char *>((*File)->getBufferStart());
+  size_t Size = (*File)->getBufferSize();
+  if (Size < DirectoryCacheHeaderSize)
+    return;
+  const unsigned char *Header = Base;
+  uint32_t Magic = endian::readNext<uint32_t, little, unaligned>(Header);
+  uint32_t Version = endian::readNext<uint32_t, little, unaligned>(Header);
+  uint32_t BucketsOffset = endian::readNext<uint32_t, little, unaligned>(Header);
+  if (Magic != DirectoryCacheMagic || Version != DirectoryCacheVersion ||
+      BucketsOffset < DirectoryCacheHeaderSize || BucketsOffset % 4 ||
+      BucketsOffset + 2 * sizeof(uint32_t) > Size)
+    return;
+
+  const unsigned char *Buckets = Base + BucketsOffset;
+  uint32_t NumBuckets = endian::readNext<uint32_t, little, aligned>(Buckets);
+  uint32_t NumEntries = endian::readNext<uint32_t, little, aligned>(Buckets);
+  if (Buckets + NumBuckets * sizeof(uint32_t) > Base + Size)
+    return;
+  Table.reset(new OnDiskTable(NumBuckets, NumEntries, Buckets,
+                              Base + DirectoryCacheHeaderSize, Base));
+  Buffer = std::move(*File);
+}
+
+DirectoryListingStatCache::~DirectoryListingStatCache() {}
+
+void DirectoryListingStatCache::addVolatileDirectory(StringRef Dir) {
+  SmallString<256> AbsDir(Dir);
+  llvm::sys::fs::make_absolute(AbsDir);
+  VolatileDirs.push_back(AbsDir.str());
+}
+
+DirectoryListingStatCache::Listing *
+DirectoryListingStatCache::getListing(StringRef Dir, vfs::FileSystem &FS) {
+  for (const std::string &VolatileDir : VolatileDirs)
+    if (Dir.startswith(VolatileDir) &&
+        (Dir.size() == VolatileDir.size() ||
+         llvm::sys::path::is_separator(Dir[VolatileDir.size()])))
+      return nullptr;
+
+  Listing &L = Listings[Dir];
+  if (L.Kind != Listing::Unknown)
+    return L.Kind == Listing::Unusable ? nullptr : &L;
+  L.Kind = Listing::Unusable;
+
+  llvm::sys::TimeValue Now = llvm::sys::TimeValue::now();
+  llvm::ErrorOr<vfs::Status> Status = FS.status(Dir);
+  if (!Status) {
+    // A missing directory has no entries.
+    if (Status.getError() != llvm::errc::no_such_file_or_directory)
+      return nullptr;
+    L.Kind = Listing::Missing;
+    return &L;
+  }
+  if (!Status->isDirectory())
+    return nullptr;
+  L.UID = Status->getUniqueID();
+  L.MTime = Status->getLastModificationTime().toEpochTime();
+
+  if (Table) {
+    OnDiskTable::iterator I = Table->find(Dir);
+    if (I != Table->end()) {
+      OnDiskListing Data = *I;
+      if (Data.UID == L.UID && Data.MTime == L.MTime) {
+        using namespace llvm::support;
+        const unsigned char *Ptr =
+            reinterpret_cast<const unsigned char *>(Data.Names.data());
+        const unsigned char *End = Ptr + Data.Names.size();
+        while (Ptr + sizeof(uint16_t) <= End) {
+          unsigned Len = endian::readNext<uint16_t, little, unaligned>(Ptr);
+          if (Ptr + Len > End)
+            break;
+          L.Names.insert(StringRef(reinterpret_cast<const char *>(Ptr), Len));
+          Ptr += Len;
+        }
+        L.Kind = Listing::Listed;
+        return &L;
+      }
+    }
+  }
+
+  std::error_code EC;
+  SmallString<64> LowerName;
+  for (vfs::directory_iterator I = FS.dir_begin(Dir, EC), E; I != E && !EC;
+       I.increment(EC))
+    if (getListingName(llvm::sys::path::filename(I->getName()), LowerName))
+      L.Names.insert(LowerName);
+  if (EC) {
+    L.Names.clear();
+    return nullptr;
+  }
+  L.Kind = Listing::Listed;
+
+  // Modification times have a granularity of a second: a directory modified
+  // in the second it was listed may be modified again without its time
+  // changing, so only share the listings of the older ones.
+  if (L.MTime + 1 < Now.toEpochTime()) {
+    L.Shareable = true;
+    Modified = true;
+  }
+  return &L;
+}
+
+DirectoryListingStatCache::LookupResult
+DirectoryListingStatCache::getStat(const char *Path, FileData &Data,
+                                   bool isFile, std::unique_ptr<vfs::File> *F,
+                                   vfs::FileSystem &FS) {
+  SmallString<256> AbsPath(Path);
+  if (!llvm::sys::path::is_absolute(AbsPath.str()) && !WorkingDir.empty()) {
+    SmallString<256> Relative(AbsPath);
+    AbsPath = WorkingDir;
+    llvm::sys::path::append(AbsPath, Relative.str());
+  }
+
+  SmallString<64> LowerName;
+  StringRef Dir = llvm::sys::path::parent_path(AbsPath.str());
+  if (!Dir.empty() &&
+      getListingName(llvm::sys::path::filename(AbsPath.str()), LowerName))
+    if (Listing *L = getListing(Dir, FS))
+      if (!L->contains(LowerName))
+        return CacheMissing;
+
+  return statChained(Path, Data, isFile, F, FS);
+}
+
+bool DirectoryListingStatCache::save() {
+  if (!Modified)
+    return false;
+
+  llvm::OnDiskChainedHashTableGenerator<DirectoryListingTrait> Generator;
+  for (const auto &Entry : Listings) {
+    const Listing &L = Entry.getValue();
+    if (!L.Shareable || Entry.getKey().size() > 0xffff)
+      continue;
+    OnDiskListing Data;
+    Data.UID = L.UID;
+    Data.MTime = L.MTime;
+    llvm::raw_string_ostream Names(Data.Names);
+    for (const auto &Name : L.Names) {
+      llvm::support::endian::Writer<llvm::support::little>(Names)
+          .write<uint16_t>(Name.getKey().size());
+      Names << Name.getKey();
+    }
+    Names.flush();
+    Generator.insert(Entry.getKey(), Data);
+  }
+
+  // Keep the listings of the other processes. The stale ones are harmless,
+  // they are checked before being used.
+  if (Table)
+    for (StringRef Dir : Table->keys()) {
+      auto I = Listings.find(Dir);
+      if (I == Listings.end() || !I->getValue().Shareable)
+        Generator.insert(Dir, *Table->find(Dir));
+    }
+
+  std::string Contents;
+  {
+    using namespace llvm::support;
+    llvm::raw_string_ostream Out(Contents);
+    endian::Writer<little> Writer(Out);
+    Writer.write<uint32_t>(DirectoryCacheMagic);
+    Writer.write<uint32_t>(DirectoryCacheVersion);
+    Writer.write<uint32_t>(0); // Buckets offset, filled in below.
+    Writer.write<uint32_t>(0);
+    uint32_t BucketsOffset = Generator.Emit(Out);
+    Out.flush();
+    for (unsigned I = 0; I != 4; ++I)
+      Contents[8 + I] = static_cast<char>(BucketsOffset >> (8 * I));
+  }
+
+  // Write a new file and rename it over the old one, so that the processes
+  // using the old one keep a consistent view of it.
+  SmallString<128> TempPath;
+  int FD;
+  if (llvm::sys::fs::createUniqueFile(Twine(CacheFile) + "-%%%%%%%%", FD,
+                                      TempPath))
+    return true;
+  bool WriteFailed;
+  {
+    llvm::raw_fd_ostream Out(FD, /*shouldClose=*/true);
+    Out << Contents;
+    Out.close();
+    WriteFailed = Out.has_error();
+    Out.clear_error();
+  }
+  if (WriteFailed || llvm::sys::fs::rename(TempPath.str(), CacheFile)) {
+    llvm::sys::fs::remove(TempPath.str());
+    return true;
+  }
+  Modified = false;
+  return false;
+}
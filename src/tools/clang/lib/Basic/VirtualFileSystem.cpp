@@ -19,6 +19,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/YAMLParser.h"
+#include <algorithm>
 #include <atomic>
 #include <memory>
 
@@ -320,6 +321,281 @@ directory_iterator OverlayFileSystem::dir_begin(const Twine &Dir,
       std::make_shared<OverlayFSDirIterImpl>(Dir, *this, EC));
 }
 
+//===-----------------------------------------------------------------------===/
+// CachingFileSystem implementation
+//===-----------------------------------------------------------------------===/
+
+/// The state of the parent directory of a path, which a missing entry stays
+/// missing with.
+struct CachingFileSystem::ParentStamp {
+  bool Valid = false;
+  bool Exists = false;
+  UniqueID UID;
+  sys::TimeValue MTime;
+
+  bool operator==(const ParentStamp &RHS) const {
+    return Valid && RHS.Valid && Exists == RHS.Exists &&
+           (!Exists || (UID == RHS.UID && MTime == RHS.MTime));
+  }
+};
+
+struct CachingFileSystem::StatusEntry {
+  Status S;
+  std::error_code EC;
+  /// The generation the entry was last checked in, 0 if never.
+  unsigned Generation = 0;
+  /// When the entry was last looked up.
+  sys::TimeValue LookupTime;
+  /// The parent directory of a missing entry.
+  ParentStamp Parent;
+};
+
+struct CachingFileSystem::ContentsEntry {
+  Status S;
+  std::unique_ptr<MemoryBuffer> Buffer;
+  unsigned LastUsed = 0;
+};
+
+namespace clang {
+namespace vfs {
+/// \brief A file of a CachingFileSystem, which is only opened in the
+/// underlying file system when its contents are not cached.
+class CachedFile : public File {
+  CachingFileSystem &FS;
+  std::string AbsPath;
+  Status S;
+
+public:
+  CachedFile(CachingFileSystem &FS, StringRef AbsPath, Status S)
+      : FS(FS), AbsPath(AbsPath), S(std::move(S)) {}
+
+  ErrorOr<Status> status() override { return S; }
+  ErrorOr<std::unique_ptr<MemoryBuffer>>
+  getBuffer(const Twine &Name, int64_t FileSize, bool RequiresNullTerminator,
+            bool IsVolatile) override {
+    return FS.getBuffer(AbsPath, S, Name, RequiresNullTerminator, IsVolatile);
+  }
+  std::error_code close() override { return std::error_code(); }
+  void setName(StringRef Name) override { S.setName(Name); }
+};
+} // end namespace vfs
+} // end namespace clang
+
+CachingFileSystem::CachingFileSystem(IntrusiveRefCntPtr<FileSystem> Base,
+                                     uint64_t MaxContentsSize)
+    : Base(std::move(Base)), Generation(1), ContentsSize(0),
+      MaxContentsSize(MaxContentsSize) {
+  SmallString<256> CWD;
+  if (!sys::fs::current_path(CWD))
+    WorkingDir = CWD.str();
+}
+
+CachingFileSystem::~CachingFileSystem() {}
+
+void CachingFileSystem::revalidate() {
+  ++Generation;
+  SmallString<256> CWD;
+  if (!sys::fs::current_path(CWD))
+    WorkingDir = CWD.str();
+  pruneContents();
+}
+
+void CachingFileSystem::addVolatileDirectory(StringRef Dir) {
+  std::string AbsDir = makeAbsolute(Dir);
+  if (std::find(VolatileDirs.begin(), VolatileDirs.end(), AbsDir) ==
+      VolatileDirs.end())
+    VolatileDirs.push_back(std::move(AbsDir));
+}
+
+std::string CachingFileSystem::makeAbsolute(const Twine &Path) const {
+  SmallString<256> AbsPath;
+  Path.toVector(AbsPath);
+  if (!WorkingDir.empty() && !sys::path::is_absolute(AbsPath.str())) {
+    std::string Relative = AbsPath.str();
+    AbsPath = WorkingDir;
+    sys::path::append(AbsPath, Relative);
+  }
+  return AbsPath.str();
+}
+
+bool CachingFileSystem::isVolatile(StringRef AbsPath) const {
+  for (const std::string &Dir : VolatileDirs)
+    if (AbsPath.startswith(Dir) &&
+        (AbsPath.size() == Dir.size() ||
+         sys::path::is_separator(AbsPath[Dir.size()])))
+      return true;
+  return false;
+}
+
+CachingFileSystem::ParentStamp
+CachingFileSystem::getParentStamp(StringRef AbsPath) {
+  ParentStamp Stamp;
+  StringRef ParentPath = sys::path::parent_path(AbsPath);
+  if (ParentPath.empty() || ParentPath == AbsPath)
+    return Stamp;
+  StatusEntry *Parent = lookupEntry(ParentPath);
+  if (!Parent)
+    return Stamp;
+
+  if (Parent->EC) {
+    // A missing directory has no entries.
+    Stamp.Valid = Parent->EC == llvm::errc::no_such_file_or_directory;
+    return Stamp;
+  }
+  if (!Parent->S.isDirectory())
+    return Stamp;
+
+  // Modification times have a granularity of a second: a directory modified
+  // in the second it was looked up may be modified again without its time
+  // changing, so only trust the older ones.
+  sys::TimeValue MTime = Parent->S.getLastModificationTime();
+  if (MTime.seconds() + 1 >= Parent->LookupTime.seconds())
+    return Stamp;
+  Stamp.Valid = true;
+  Stamp.Exists = true;
+  Stamp.UID = Parent->S.getUniqueID();
+  Stamp.MTime = MTime;
+  return Stamp;
+}
+
+CachingFileSystem::StatusEntry *
+CachingFileSystem::lookupEntry(StringRef AbsPath) {
+  if (isVolatile(AbsPath))
+    return nullptr;
+
+  // The entries of a StringMap are allocated separately, so references to
+  // them stay valid while the lookups of the parents add entries.
+  StatusEntry &Entry = Statuses[AbsPath];
+  if (Entry.Generation == Generation)
+    return &Entry;
+
+  // The parent is looked up before the entry itself, so that an entry created
+  // after the lookup always changes the parent from the recorded one.
+  bool WasMissing = Entry.Generation &&
+                    Entry.EC == llvm::errc::no_such_file_or_directory;
+  ParentStamp Parent = getParentStamp(AbsPath);
+  if (WasMissing && Parent == Entry.Parent) {
+    Entry.Generation = Generation;
+    return &Entry;
+  }
+
+  Entry.LookupTime = sys::TimeValue::now();
+  ErrorOr<Status> S = Base->status(AbsPath);
+  Entry.Generation = Generation;
+  if (S) {
+    Entry.S = std::move(*S);
+    Entry.EC = std::error_code();
+  } else {
+    Entry.EC = S.getError();
+    Entry.Parent = Parent;
+  }
+  return &Entry;
+}
+
+ErrorOr<Status> CachingFileSystem::lookup(StringRef AbsPath) {
+  StatusEntry *Entry = lookupEntry(AbsPath);
+  if (!Entry)
+    return Base->status(AbsPath);
+  if (Entry->EC)
+    return Entry->EC;
+  return Entry->S;
+}
+
+ErrorOr<Status> CachingFileSystem::status(const Twine &Path) {
+  ErrorOr<Status> S = lookup(makeAbsolute(Path));
+  if (S)
+    S->setName(Path.str());
+  return S;
+}
+
+ErrorOr<std::unique_ptr<File>>
+CachingFileSystem::openFileForRead(const Twine &Path) {
+  std::string AbsPath = makeAbsolute(Path);
+  ErrorOr<Status> S = lookup(AbsPath);
+  if (!S)
+    return S.getError();
+  S->setName(Path.str());
+  return std::unique_ptr<File>(new CachedFile(*this, AbsPath, std::move(*S)));
+}
+
+directory_iterator CachingFileSystem::dir_begin(const Twine &Dir,
+                                                std::error_code &EC) {
+  return Base->dir_begin(makeAbsolute(Dir), EC);
+}
+
+static bool isSameFile(const Status &LHS, const Status &RHS) {
+  return LHS.getUniqueID() == RHS.getUniqueID() &&
+         LHS.getLastModificationTime() == RHS.getLastModificationTime() &&
+         LHS.getSize() == RHS.getSize();
+}
+
+ErrorOr<std::unique_ptr<MemoryBuffer>>
+CachingFileSystem::getBuffer(StringRef AbsPath, const Status &S,
+                             const Twine &Name, bool RequiresNullTerminator,
+                             bool IsVolatile) {
+  bool Cacheable = !IsVolatile && S.isRegularFile();
+  ContentsEntry *Entry = nullptr;
+  if (Cacheable) {
+    Entry = &Contents[AbsPath];
+    if (Entry->Buffer && isSameFile(Entry->S, S)) {
+      Entry->LastUsed = Generation;
+      return MemoryBuffer::getMemBuffer(Entry->Buffer->getBuffer(), Name.str(),
+                                        RequiresNullTerminator);
+    }
+  }
+
+  ErrorOr<std::unique_ptr<File>> F = Base->openFileForRead(AbsPath);
+  if (!F)
+    return F.getError();
+  if (!Cacheable)
+    return (*F)->getBuffer(Name, -1, RequiresNullTerminator, IsVolatile);
+
+  // Read the contents rather than mapping them, so that the cached copy does
+  // not change with the file.
+  ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer =
+      (*F)->getBuffer(AbsPath, -1, /*RequiresNullTerminator=*/true,
+                      /*IsVolatile=*/true);
+  if (!Buffer)
+    return Buffer.getError();
+
+  // Do not cache the contents of a file that changed since its lookup.
+  ErrorOr<Status> Current = (*F)->status();
+  if (!Current || !isSameFile(*Current, S) ||
+      (*Buffer)->getBufferSize() != S.getSize())
+    return MemoryBuffer::getMemBufferCopy((*Buffer)->getBuffer(), Name.str());
+
+  if (Entry->Buffer)
+    ContentsSize -= Entry->Buffer->getBufferSize();
+  Entry->S = S;
+  Entry->Buffer = std::move(*Buffer);
+  Entry->LastUsed = Generation;
+  ContentsSize += Entry->Buffer->getBufferSize();
+  return MemoryBuffer::getMemBuffer(Entry->Buffer->getBuffer(), Name.str(),
+                                    RequiresNullTerminator);
+}
+
+void CachingFileSystem::pruneContents() {
+  if (!MaxContentsSize || ContentsSize <= MaxContentsSize)
+    return;
+
+  // Drop the contents the most ancient generations used first.
+  std::vector<StringMapEntry<ContentsEntry> *> Entries;
+  for (StringMapEntry<ContentsEntry> &Entry : Contents)
+    Entries.push_back(&Entry);
+  std::sort(Entries.begin(), Entries.end(),
+            [](const StringMapEntry<ContentsEntry> *LHS,
+               const StringMapEntry<ContentsEntry> *RHS) {
+              return LHS->getValue().LastUsed < RHS->getValue().LastUsed;
+            });
+  for (StringMapEntry<ContentsEntry> *Entry : Entries) {
+    if (ContentsSize <= MaxContentsSize)
+      break;
+    if (Entry->getValue().Buffer)
+      ContentsSize -= Entry->getValue().Buffer->getBufferSize();
+    Contents.erase(Entry->getKey());
+  }
+}
+
 //===-----------------------------------------------------------------------===/
 // VFSFromYAML implementation
 //===-----------------------------------------------------------------------===/
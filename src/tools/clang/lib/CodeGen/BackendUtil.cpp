@@ -33,6 +33,7 @@
 #include "llvm/Support/FormattedStream.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
@@ -625,8 +626,13 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action, raw_ostream *OS) {
   // Before executing passes, print the final values of the LLVM options.
   cl::PrintOptionValues();
 
-  // Run passes. For now we do all passes at once, but eventually we
-  // would like to have the option of streaming code generation.
+  // Run passes. All passes run at once, after the whole module has been
+  // generated. The per-function passes cannot be streamed as functions are
+  // generated: some of them depend on module state that CodeGenModule only
+  // sets up in Release (e.g. AddDiscriminators checks the Dwarf Version
+  // module flag), the verifier rejects the debug info forward declarations
+  // that are still temporary until the debug info is finalized, and the
+  // LLVMContext cannot be shared with a backend thread.
 
   if (PerFunctionPasses) {
     PrettyStackTraceString CrashInfo("Per-function optimization");
@@ -656,6 +662,7 @@ void clang::EmitBackendOutput(DiagnosticsEngine &Diags,
                               const LangOptions &LOpts, StringRef TDesc,
                               Module *M, BackendAction Action,
                               raw_ostream *OS) {
+  llvm::TimeTraceScope TimeScope("Backend");
   EmitAssemblyHelper AsmHelper(Diags, CGOpts, TOpts, LOpts, M);
 
   AsmHelper.EmitAssembly(Action, OS);
@@ -3325,6 +3325,12 @@ RValue CodeGenFunction::EmitCall(const CGFunctionInfo &CallInfo,
   if (callOrInvoke)
     *callOrInvoke = CS.getInstruction();
 
+  // Profile the targets of indirect calls, so that the hot ones can be
+  // promoted to direct calls.
+  if (!isa<llvm::Function>(Callee->stripPointerCasts()) &&
+      !isa<llvm::InlineAsm>(Callee))
+    PGO.profileIndirectCall(CS.getInstruction(), Callee);
+
   if (CurCodeDecl && CurCodeDecl->hasAttr<FlattenAttr>() &&
       !CS.hasFnAttr(llvm::Attribute::NoInline))
     Attrs =
@@ -1470,13 +1470,36 @@ void CGDebugInfo::completeType(const RecordDecl *RD) {
     completeRequiredType(RD);
 }
 
+/// \brief Whether objects of \p RD can only be created by calling one of its
+/// constructors, so that the translation units that emit a constructor are
+/// the ones that need its definition.
+static bool isHomedInConstructors(const CXXRecordDecl *RD) {
+  if (!RD->hasDefinition() || RD->isLambda() || RD->isAggregate() ||
+      RD->hasTrivialDefaultConstructor() ||
+      RD->hasConstexprNonCopyMoveConstructor())
+    return false;
+
+  // The constructors of a dllimport class are emitted by another module.
+  if (RD->hasAttr<DLLImportAttr>())
+    return false;
+  for (const CXXConstructorDecl *Ctor : RD->ctors())
+    if (Ctor->hasAttr<DLLImportAttr>())
+      return false;
+  return true;
+}
+
 void CGDebugInfo::completeRequiredType(const RecordDecl *RD) {
   if (DebugKind <= CodeGenOptions::DebugLineTablesOnly)
     return;
 
-  if (const CXXRecordDecl *CXXDecl = dyn_cast<CXXRecordDecl>(RD))
+  if (const CXXRecordDecl *CXXDecl = dyn_cast<CXXRecordDecl>(RD)) {
     if (CXXDecl->isDynamicClass())
       return;
+    if (DebugKind == CodeGenOptions::LimitedDebugInfo &&
+        CGM.getCodeGenOpts().DebugCtorHoming &&
+        isHomedInConstructors(CXXDecl))
+      return;
+  }
 
   QualType Ty = CGM.getContext().getRecordType(RD);
   llvm::DIType *T = getTypeOrNull(Ty);
@@ -1497,6 +1520,13 @@ void CGDebugInfo::completeClassData(const RecordDecl *RD) {
   TypeCache[TyPtr].reset(Res);
 }
 
+void CGDebugInfo::completeConstructedClass(const CXXRecordDecl *RD) {
+  if (DebugKind == CodeGenOptions::LimitedDebugInfo &&
+      CGM.getCodeGenOpts().DebugCtorHoming && !RD->isDynamicClass() &&
+      isHomedInConstructors(RD))
+    completeClassData(RD);
+}
+
 static bool hasExplicitMemberDefinition(CXXRecordDecl::method_iterator I,
                                         CXXRecordDecl::method_iterator End) {
   for (; I != End; ++I)
@@ -1508,7 +1538,7 @@ static bool hasExplicitMemberDefinition(CXXRecordDecl::method_iterator I,
 }
 
 static bool shouldOmitDefinition(CodeGenOptions::DebugInfoKind DebugKind,
-                                 const RecordDecl *RD,
+                                 bool CtorHoming, const RecordDecl *RD,
                                  const LangOptions &LangOpts) {
   if (DebugKind > CodeGenOptions::LimitedDebugInfo)
     return false;
@@ -1527,6 +1557,11 @@ static bool shouldOmitDefinition(CodeGenOptions::DebugInfoKind DebugKind,
   if (CXXDecl->hasDefinition() && CXXDecl->isDynamicClass())
     return true;
 
+  // With constructor homing, the definition is emitted along with the
+  // constructors, like that of a dynamic class is emitted with its vtable.
+  if (CtorHoming && isHomedInConstructors(CXXDecl))
+    return true;
+
   TemplateSpecializationKind Spec = TSK_Undeclared;
   if (const ClassTemplateSpecializationDecl *SD =
           dyn_cast<ClassTemplateSpecializationDecl>(RD))
@@ -1544,7 +1579,8 @@ static bool shouldOmitDefinition(CodeGenOptions::DebugInfoKind DebugKind,
 llvm::DIType *CGDebugInfo::CreateType(const RecordType *Ty) {
   RecordDecl *RD = Ty->getDecl();
   llvm::DIType *T = cast_or_null<llvm::DIType>(getTypeOrNull(QualType(Ty, 0)));
-  if (T || shouldOmitDefinition(DebugKind, RD, CGM.getLangOpts())) {
+  if (T || shouldOmitDefinition(DebugKind, CGM.getCodeGenOpts().DebugCtorHoming,
+                                RD, CGM.getLangOpts())) {
     if (!T)
       T = getOrCreateRecordFwdDecl(
           Ty, getContextDescriptor(cast<Decl>(RD->getDeclContext())));
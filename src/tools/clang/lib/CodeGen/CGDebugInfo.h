@@ -318,6 +318,10 @@ public:
   void completeRequiredType(const RecordDecl *RD);
   void completeClassData(const RecordDecl *RD);
 
+  /// \brief Emit the definition of \p RD if it was left out until one of its
+  /// constructors is emitted (-fuse-ctor-homing).
+  void completeConstructedClass(const CXXRecordDecl *RD);
+
   void completeTemplateDefinition(const ClassTemplateSpecializationDecl &SD);
 
 private:
@@ -668,6 +668,7 @@ CodeGenVTables::GenerateConstructionVTable(const CXXRecordDecl *RD,
       VTLayout->getNumVTableComponents(), VTLayout->vtable_thunk_begin(),
       VTLayout->getNumVTableThunks(), RTTI);
   VTable->setInitializer(Init);
+  EmitVTableTypeMetadata(VTable, *VTLayout);
   
   return VTable;
 }
@@ -758,6 +759,19 @@ CodeGenModule::getVTableLinkage(const CXXRecordDecl *RD) {
 /// emits them as-needed.
 void CodeGenModule::EmitVTable(CXXRecordDecl *theClass) {
   VTables.GenerateClassData(theClass);
+
+  // With -fhome-inline-methods, the translation unit that defines the key
+  // function emits the inline member functions for all the others, whether
+  // it uses them or not.
+  if (!CodeGenOpts.HomeInlineMethods)
+    return;
+  for (const CXXMethodDecl *MD : theClass->methods()) {
+    const CXXMethodDecl *KeyFunction = getInlineMethodKeyFunction(MD);
+    if (!KeyFunction || !KeyFunction->hasBody())
+      continue;
+    GlobalDecl GD(MD);
+    addDeferredDeclToEmit(GetGlobalValue(getMangledName(GD)), GD);
+  }
 }
 
 void 
@@ -837,3 +851,60 @@ void CodeGenModule::EmitDeferredVTables() {
          "deferred extra v-tables during v-table emission?");
   DeferredVTables.clear();
 }
+
+/// Return the mangled name of the type info name of the given class, which
+/// names the class in every translation unit.
+static SmallString<256> getTypeInfoName(CodeGenModule &CGM,
+                                        const CXXRecordDecl *RD) {
+  SmallString<256> Name;
+  llvm::raw_svector_ostream Out(Name);
+  CGM.getCXXABI().getMangleContext().mangleCXXRTTIName(
+      CGM.getContext().getRecordType(RD), Out);
+  Out.flush();
+  return Name;
+}
+
+llvm::Metadata *CodeGenVTables::getVTableTypeId(const CXXRecordDecl *RD) {
+  llvm::Metadata *&Id = VTableTypeIds[RD];
+  if (Id)
+    return Id;
+
+  // A class that is not externally visible may share its name with a class
+  // of another translation unit, so it gets a distinct node, which the IR
+  // linker never merges with the nodes of other modules.
+  if (RD->isExternallyVisible())
+    Id = llvm::MDString::get(CGM.getLLVMContext(), getTypeInfoName(CGM, RD));
+  else
+    Id = llvm::MDNode::getDistinct(CGM.getLLVMContext(), None);
+  return Id;
+}
+
+void CodeGenVTables::EmitVTableTypeMetadata(llvm::GlobalVariable *VTable,
+                                            const VTableLayout &VTLayout) {
+  if (!CGM.getCodeGenOpts().WholeProgramVTables)
+    return;
+
+  // Every base subobject that has an address point in the vtable is
+  // compatible with it, including the primary bases that share an address
+  // point with their derived class. Emit them in a deterministic order.
+  typedef std::pair<uint64_t, const CXXRecordDecl *> AddressPointTy;
+  SmallVector<AddressPointTy, 8> AddressPoints;
+  for (const auto &AP : VTLayout.getAddressPoints())
+    AddressPoints.push_back(std::make_pair(AP.second, AP.first.getBase()));
+  std::sort(AddressPoints.begin(), AddressPoints.end(),
+            [this](const AddressPointTy &A, const AddressPointTy &B) {
+    if (A.first != B.first)
+      return A.first < B.first;
+    return getTypeInfoName(CGM, A.second) < getTypeInfoName(CGM, B.second);
+  });
+
+  llvm::NamedMDNode *VTableTypes =
+      CGM.getModule().getOrInsertNamedMetadata("llvm.vtable.types");
+  for (const AddressPointTy &AP : AddressPoints) {
+    llvm::Metadata *Ops[] = {
+        getVTableTypeId(AP.second), llvm::ConstantAsMetadata::get(VTable),
+        llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(
+            CGM.Int64Ty, AP.first * CGM.PointerSizeInBytes))};
+    VTableTypes->addOperand(llvm::MDNode::get(CGM.getLLVMContext(), Ops));
+  }
+}
@@ -49,6 +49,10 @@ class CodeGenVTables {
   /// indices.
   SecondaryVirtualPointerIndicesMapTy SecondaryVirtualPointerIndices;
 
+  /// VTableTypeIds - The identifiers of the classes in the vtable type
+  /// metadata.
+  llvm::DenseMap<const CXXRecordDecl *, llvm::Metadata *> VTableTypeIds;
+
   /// emitThunk - Emit a single thunk.
   void emitThunk(GlobalDecl GD, const ThunkInfo &Thunk, bool ForVTable);
 
@@ -116,6 +120,16 @@ public:
   void GenerateClassData(const CXXRecordDecl *RD);
 
   bool isVTableExternal(const CXXRecordDecl *RD);
+
+  /// getVTableTypeId - Return the identifier of the given class in the vtable
+  /// type metadata.
+  llvm::Metadata *getVTableTypeId(const CXXRecordDecl *RD);
+
+  /// EmitVTableTypeMetadata - Record the classes that the address points of
+  /// the given vtable are compatible with in the llvm.vtable.types metadata,
+  /// if whole program devirtualization is enabled.
+  void EmitVTableTypeMetadata(llvm::GlobalVariable *VTable,
+                              const VTableLayout &VTLayout);
 };
 
 } // end namespace CodeGen
@@ -30,6 +30,7 @@
 #include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Operator.h"
+#include "llvm/Support/TimeProfiler.h"
 using namespace clang;
 using namespace CodeGen;
 
@@ -816,6 +817,8 @@ static void EmitSizedDeallocationFunction(CodeGenFunction &CGF,
 void CodeGenFunction::GenerateCode(GlobalDecl GD, llvm::Function *Fn,
                                    const CGFunctionInfo &FnInfo) {
   const FunctionDecl *FD = cast<FunctionDecl>(GD.getDecl());
+  llvm::TimeTraceScope TimeScope(
+      "CodeGenFunction", [&]() { return FD->getQualifiedNameAsString(); });
 
   // Check if we should generate debug info for this function.
   if (FD->hasAttr<NoDebugAttr>())
@@ -660,6 +660,11 @@ CodeGenModule::getFunctionLinkage(GlobalDecl GD) {
 
   GVALinkage Linkage = getContext().GetGVALinkageForFunction(D);
 
+  if (Linkage == GVA_DiscardableODR)
+    if (const CXXMethodDecl *KeyFunction = getInlineMethodKeyFunction(D))
+      Linkage =
+          KeyFunction->hasBody() ? GVA_StrongODR : GVA_AvailableExternally;
+
   if (isa<CXXDestructorDecl>(D) &&
       getCXXABI().useThunkForDtorVariant(cast<CXXDestructorDecl>(D),
                                          GD.getDtorType())) {
@@ -672,6 +677,30 @@ CodeGenModule::getFunctionLinkage(GlobalDecl GD) {
   return getLLVMLinkageForDeclarator(D, Linkage, /*isConstantVariable=*/false);
 }
 
+const CXXMethodDecl *
+CodeGenModule::getInlineMethodKeyFunction(const FunctionDecl *FD) {
+  if (!CodeGenOpts.HomeInlineMethods || LangOpts.InlineVisibilityHidden)
+    return nullptr;
+
+  // Only the member functions defined in the class body are sure to be seen
+  // by the translation unit that defines the key function. Constructors and
+  // destructors are left alone, since their variants are emitted by the ABI.
+  const auto *MD = dyn_cast<CXXMethodDecl>(FD);
+  if (!MD || isa<CXXConstructorDecl>(MD) || isa<CXXDestructorDecl>(MD) ||
+      MD->isImplicit() || MD->isDefaulted() || MD->isDeleted() ||
+      MD->getTemplatedKind() != FunctionDecl::TK_NonTemplate ||
+      !MD->hasInlineBody() || MD->hasAttr<GNUInlineAttr>())
+    return nullptr;
+
+  const CXXRecordDecl *RD = MD->getParent();
+  if (!RD->isDynamicClass() || RD->isLocalClass() ||
+      RD->getTemplateSpecializationKind() != TSK_Undeclared ||
+      RD->hasAttr<DLLImportAttr>() || RD->hasAttr<DLLExportAttr>())
+    return nullptr;
+
+  return getContext().getCurrentKeyFunction(RD);
+}
+
 void CodeGenModule::setFunctionDefinitionAttributes(const FunctionDecl *D,
                                                     llvm::Function *F) {
   setNonAliasAttributes(D, F);
@@ -1091,26 +1120,46 @@ void CodeGenModule::EmitDeferred() {
   // Emit code for any potentially referenced deferred decls.  Since a
   // previously unused static decl may become used during the generation of code
   // for a static function, iterate until no changes are made.
+  //
+  // The decls that become deferred while emitting one are emitted before the
+  // rest of its batch. This has the advantage that the decls are emitted in a
+  // DFS and related ones are close together, which is convenient for testing.
+  // The batches are kept on an explicit stack rather than by recursing, since
+  // the chains of functions using each other in large generated translation
+  // units can be deep enough to overflow the stack.
+  struct DeferredBatch {
+    std::vector<DeferredGlobal> Decls;
+    size_t Next;
+  };
+  std::vector<DeferredBatch> Batches;
 
-  if (!DeferredVTables.empty()) {
-    EmitDeferredVTables();
+  while (true) {
+    if (!DeferredVTables.empty()) {
+      EmitDeferredVTables();
 
-    // Emitting a v-table doesn't directly cause more v-tables to
-    // become deferred, although it can cause functions to be
-    // emitted that then need those v-tables.
-    assert(DeferredVTables.empty());
-  }
+      // Emitting a v-table doesn't directly cause more v-tables to
+      // become deferred, although it can cause functions to be
+      // emitted that then need those v-tables.
+      assert(DeferredVTables.empty());
+    }
 
-  // Stop if we're out of both deferred v-tables and deferred declarations.
-  if (DeferredDeclsToEmit.empty())
-    return;
+    // Grab the list of decls to emit. If EmitGlobalDefinition schedules more
+    // work, it will not interfere with this.
+    if (!DeferredDeclsToEmit.empty()) {
+      Batches.emplace_back();
+      Batches.back().Decls.swap(DeferredDeclsToEmit);
+      Batches.back().Next = 0;
+    }
+
+    while (!Batches.empty() &&
+           Batches.back().Next == Batches.back().Decls.size())
+      Batches.pop_back();
 
-  // Grab the list of decls to emit. If EmitGlobalDefinition schedules more
-  // work, it will not interfere with this.
-  std::vector<DeferredGlobal> CurDeclsToEmit;
-  CurDeclsToEmit.swap(DeferredDeclsToEmit);
+    // Stop if we're out of both deferred v-tables and deferred declarations.
+    if (Batches.empty())
+      return;
 
-  for (DeferredGlobal &G : CurDeclsToEmit) {
+    DeferredGlobal &G = Batches.back().Decls[Batches.back().Next++];
     GlobalDecl D = G.GD;
     llvm::GlobalValue *GV = G.GV;
     G.GV = nullptr;
@@ -1130,14 +1179,6 @@ void CodeGenModule::EmitDeferred() {
 
     // Otherwise, emit the definition and move on to the next one.
     EmitGlobalDefinition(D, GV);
-
-    // If we found out that we need to emit more decls, do that recursively.
-    // This has the advantage that the decls are emitted in a DFS and related
-    // ones are close together, which is convenient for testing.
-    if (!DeferredVTables.empty() || !DeferredDeclsToEmit.empty()) {
-      EmitDeferred();
-      assert(DeferredVTables.empty() && DeferredDeclsToEmit.empty());
-    }
   }
 }
 
@@ -1989,7 +2030,7 @@ static bool shouldBeInCOMDAT(CodeGenModule &CGM, const Decl &D) {
 
 void CodeGenModule::maybeSetTrivialComdat(const Decl &D,
                                           llvm::GlobalObject &GO) {
-  if (!shouldBeInCOMDAT(*this, D))
+  if (!shouldBeInCOMDAT(*this, D) || GO.hasAvailableExternallyLinkage())
     return;
   GO.setComdat(TheModule.getOrInsertComdat(GO.getName()));
 }
@@ -1021,6 +1021,12 @@ public:
 
   llvm::GlobalVariable::LinkageTypes getFunctionLinkage(GlobalDecl GD);
 
+  /// \brief With -fhome-inline-methods, return the key function of the class
+  /// of the inline member function \p FD, if \p FD is only emitted in the
+  /// translation unit that defines the key function. The other translation
+  /// units treat \p FD as available_externally.
+  const CXXMethodDecl *getInlineMethodKeyFunction(const FunctionDecl *FD);
+
   void setFunctionLinkage(GlobalDecl GD, llvm::Function *F) {
     F->setLinkage(getFunctionLinkage(GD));
   }
@@ -684,6 +684,7 @@ void CodeGenPGO::assignRegionCounters(const Decl *D, llvm::Function *Fn) {
     return;
   CGM.ClearUnusedCoverageMapping(D);
   setFuncName(Fn);
+  NumIndirectCallSites = 0;
 
   mapRegionCounters(D);
   if (CGM.getCodeGenOpts().CoverageMapping)
@@ -809,8 +810,9 @@ void CodeGenPGO::loadRegionCounts(llvm::IndexedInstrProfReader *PGOReader,
                                   bool IsInMainFile) {
   CGM.getPGOStats().addVisited(IsInMainFile);
   RegionCounts.clear();
-  if (std::error_code EC =
-          PGOReader->getFunctionCounts(FuncName, FunctionHash, RegionCounts)) {
+  IndirectCallSites.clear();
+  if (std::error_code EC = PGOReader->getFunctionCounts(
+          FuncName, FunctionHash, RegionCounts, &IndirectCallSites)) {
     if (EC == llvm::instrprof_error::unknown_function)
       CGM.getPGOStats().addMissing(IsInMainFile);
     else if (EC == llvm::instrprof_error::hash_mismatch)
@@ -819,9 +821,67 @@ void CodeGenPGO::loadRegionCounts(llvm::IndexedInstrProfReader *PGOReader,
       // TODO: Consider a more specific warning for this case.
       CGM.getPGOStats().addMismatched(IsInMainFile);
     RegionCounts.clear();
+    IndirectCallSites.clear();
   }
 }
 
+/// The number of targets of an indirect call that are passed on to the
+/// optimizer. Promotion rarely pays off for more of them.
+static const unsigned MaxIndirectCallTargets = 3;
+
+void CodeGenPGO::profileIndirectCall(llvm::Instruction *Call,
+                                     llvm::Value *Callee) {
+  if (!RegionCounterMap || !Call)
+    return;
+  unsigned Index = NumIndirectCallSites++;
+
+  if (CGM.getCodeGenOpts().ProfileInstrGenerate) {
+    // Record the target right before the call.
+    llvm::LLVMContext &Ctx = CGM.getLLVMContext();
+    llvm::IRBuilder<> IRB(Call);
+    llvm::Value *Args[] = {
+        llvm::ConstantExpr::getBitCast(FuncNameVar,
+                                       llvm::Type::getInt8PtrTy(Ctx)),
+        IRB.getInt64(FunctionHash),
+        IRB.CreatePtrToInt(Callee, IRB.getInt64Ty()),
+        IRB.getInt32(llvm::IPVK_IndirectCallTarget), IRB.getInt32(Index)};
+    IRB.CreateCall(
+        CGM.getIntrinsic(llvm::Intrinsic::instrprof_value_profile), Args);
+    return;
+  }
+
+  if (!haveRegionCounts() || Index >= IndirectCallSites.size())
+    return;
+  const llvm::InstrProfValueSiteRecord &Site = IndirectCallSites[Index];
+  if (Site.empty())
+    return;
+
+  // The targets are identified by the hash of their profile name, which the
+  // optimizer matches against the functions that it sees.
+  uint64_t Total = 0;
+  for (const llvm::InstrProfValueData &V : Site)
+    Total += V.Count;
+  llvm::MDBuilder MDHelper(CGM.getLLVMContext());
+  llvm::Type *Int32Ty = llvm::Type::getInt32Ty(CGM.getLLVMContext());
+  llvm::Type *Int64Ty = llvm::Type::getInt64Ty(CGM.getLLVMContext());
+  SmallVector<llvm::Metadata *, 9> Vals;
+  Vals.push_back(MDHelper.createString("VP"));
+  Vals.push_back(MDHelper.createConstant(
+      llvm::ConstantInt::get(Int32Ty, llvm::IPVK_IndirectCallTarget)));
+  Vals.push_back(
+      MDHelper.createConstant(llvm::ConstantInt::get(Int64Ty, Total)));
+  for (unsigned I = 0, E = std::min<unsigned>(Site.size(),
+                                               MaxIndirectCallTargets);
+       I != E; ++I) {
+    Vals.push_back(MDHelper.createConstant(
+        llvm::ConstantInt::get(Int64Ty, Site[I].Value)));
+    Vals.push_back(MDHelper.createConstant(
+        llvm::ConstantInt::get(Int64Ty, Site[I].Count)));
+  }
+  Call->setMetadata(llvm::LLVMContext::MD_prof,
+                    llvm::MDNode::get(CGM.getLLVMContext(), Vals));
+}
+
 /// \brief Calculate what to divide by to scale weights.
 ///
 /// Given the maximum weight, calculate a divisor that will scale all the
@@ -19,6 +19,7 @@
 #include "CodeGenTypes.h"
 #include "clang/Frontend/CodeGenOptions.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/ProfileData/InstrProf.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include <memory>
 
@@ -39,6 +40,11 @@ private:
   std::unique_ptr<llvm::DenseMap<const Stmt *, unsigned>> RegionCounterMap;
   std::unique_ptr<llvm::DenseMap<const Stmt *, uint64_t>> StmtCountMap;
   std::vector<uint64_t> RegionCounts;
+  /// The number of indirect calls emitted so far, which is the index of the
+  /// value site of the next one.
+  unsigned NumIndirectCallSites;
+  /// The targets seen at each indirect call when the profile was taken.
+  std::vector<llvm::InstrProfValueSiteRecord> IndirectCallSites;
   uint64_t CurrentRegionCount;
   /// \brief A flag that is set to true when this function doesn't need
   /// to have coverage mapping data.
@@ -46,7 +52,8 @@ private:
 
 public:
   CodeGenPGO(CodeGenModule &CGM)
-      : CGM(CGM), NumRegionCounters(0), FunctionHash(0), CurrentRegionCount(0),
+      : CGM(CGM), NumRegionCounters(0), FunctionHash(0),
+        NumIndirectCallSites(0), CurrentRegionCount(0),
         SkipCoverageMapping(false) {}
 
   /// Whether or not we have PGO region data for the current function. This is
@@ -93,6 +100,11 @@ public:
   llvm::MDNode *createBranchWeights(ArrayRef<uint64_t> Weights);
   llvm::MDNode *createLoopWeights(const Stmt *Cond, RegionCounter &Cnt);
 
+  /// Profile the targets of the indirect call \p Call through \p Callee.
+  /// When generating instrumentation, this records the target at runtime.
+  /// When using a profile, this annotates \p Call with its hottest targets.
+  void profileIndirectCall(llvm::Instruction *Call, llvm::Value *Callee);
+
   /// Check if we need to emit coverage mapping for a given declaration
   void checkGlobalDecl(GlobalDecl GD);
   /// Assign counters to regions and configure them for PGO of a given
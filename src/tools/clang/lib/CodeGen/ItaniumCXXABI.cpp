@@ -1253,6 +1253,7 @@ void ItaniumCXXABI::emitVTableDefinitions(CodeGenVTables &CGVT,
       RD, VTLayout.vtable_component_begin(), VTLayout.getNumVTableComponents(),
       VTLayout.vtable_thunk_begin(), VTLayout.getNumVTableThunks(), RTTI);
   VTable->setInitializer(Init);
+  CGVT.EmitVTableTypeMetadata(VTable, VTLayout);
 
   // Set the correct linkage.
   VTable->setLinkage(Linkage);
@@ -1373,7 +1374,19 @@ llvm::Value *ItaniumCXXABI::getVirtualFunctionPointer(CodeGenFunction &CGF,
   uint64_t VTableIndex = CGM.getItaniumVTableContext().getMethodVTableIndex(GD);
   llvm::Value *VFuncPtr =
       CGF.Builder.CreateConstInBoundsGEP1_64(VTable, VTableIndex, "vfn");
-  return CGF.Builder.CreateLoad(VFuncPtr);
+  llvm::LoadInst *VFunc = CGF.Builder.CreateLoad(VFuncPtr);
+
+  // Tell whole program devirtualization which slot of which class this is.
+  if (CGM.getCodeGenOpts().WholeProgramVTables) {
+    const CXXRecordDecl *RD = cast<CXXMethodDecl>(GD.getDecl())->getParent();
+    llvm::Metadata *Ops[] = {
+        CGM.getVTables().getVTableTypeId(RD),
+        llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(
+            CGM.Int64Ty, VTableIndex * CGM.PointerSizeInBytes))};
+    VFunc->setMetadata("vtable.slot",
+                       llvm::MDNode::get(CGM.getLLVMContext(), Ops));
+  }
+  return VFunc;
 }
 
 llvm::Value *ItaniumCXXABI::EmitVirtualDestructorCall(
@@ -14,9 +14,17 @@
 #include "clang/Driver/Options.h"
 #include "clang/Driver/ToolChain.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Option/ArgList.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
 
 using namespace clang::driver;
 using namespace clang;
@@ -122,10 +130,15 @@ bool Compilation::CleanupFileMap(const ArgStringMap &Files,
   return Success;
 }
 
+/// Serializes the output and the diagnostics of the commands that run in
+/// parallel.
+static llvm::ManagedStatic<llvm::sys::Mutex> CommandOutputLock;
+
 int Compilation::ExecuteCommand(const Command &C,
                                 const Command *&FailingCommand) const {
   if ((getDriver().CCPrintOptions ||
        getArgs().hasArg(options::OPT_v)) && !getDriver().CCGenDiagnostics) {
+    llvm::sys::ScopedLock Lock(*CommandOutputLock);
     raw_ostream *OS = &llvm::errs();
 
     // Follow gcc implementation of CC_PRINT_OPTIONS; we could also cache the
@@ -158,6 +171,7 @@ int Compilation::ExecuteCommand(const Command &C,
   int Res = C.Execute(Redirects, &Error, &ExecutionFailed);
   if (!Error.empty()) {
     assert(Res && "Error string set with 0 result code!");
+    llvm::sys::ScopedLock Lock(*CommandOutputLock);
     getDriver().Diag(clang::diag::err_drv_command_failure) << Error;
   }
 
@@ -192,6 +206,122 @@ static bool InputsOk(const Command &C,
   return !ActionFailed(&C.getSource(), FailingCommands);
 }
 
+/// Collect the commands of \p J, in order.
+static void collectCommands(const Job &J,
+                            SmallVectorImpl<const Command *> &Commands) {
+  if (const Command *C = dyn_cast<Command>(&J)) {
+    Commands.push_back(C);
+    return;
+  }
+  for (const auto &Job : *cast<JobList>(&J))
+    collectCommands(Job, Commands);
+}
+
+/// Collect \p A and the actions it depends on.
+static void collectActions(const Action *A,
+                           llvm::SmallPtrSetImpl<const Action *> &Actions) {
+  if (!Actions.insert(A).second)
+    return;
+  for (const Action *Input : *A)
+    collectActions(Input, Actions);
+}
+
+void Compilation::ExecuteJobsInParallel(
+    ArrayRef<const Command *> Commands,
+    FailingCommandList &FailingCommands) const {
+  // A command waits for the earlier commands whose action it depends on, like
+  // lipo waits for the slice of each architecture. The slices share their
+  // actions, so when both commands are known to involve files, the command
+  // only waits for the ones producing one of its inputs. When a command fails,
+  // the commands depending on it are skipped, as they would be when running in
+  // order.
+  unsigned NumCommands = Commands.size();
+  std::vector<SmallVector<unsigned, 4>> Dependents(NumCommands);
+  std::vector<unsigned> NumPendingInputs(NumCommands);
+  for (unsigned I = 0; I != NumCommands; ++I) {
+    llvm::SmallPtrSet<const Action *, 16> Actions;
+    collectActions(&Commands[I]->getSource(), Actions);
+    const ArgStringList &Inputs = Commands[I]->getInputFilenames();
+    for (unsigned J = 0; J != I; ++J) {
+      if (!Actions.count(&Commands[J]->getSource()))
+        continue;
+      const char *Output = Commands[J]->getOutputFilename();
+      if (Output && !Inputs.empty() &&
+          std::none_of(Inputs.begin(), Inputs.end(), [&](const char *Input) {
+            return StringRef(Input) == Output;
+          }))
+        continue;
+      Dependents[J].push_back(I);
+      ++NumPendingInputs[I];
+    }
+  }
+
+  // The ready commands are started in order, as far as the inputs allow.
+  std::priority_queue<unsigned, std::vector<unsigned>, std::greater<unsigned>>
+      Ready;
+  for (unsigned I = 0; I != NumCommands; ++I)
+    if (!NumPendingInputs[I])
+      Ready.push(I);
+
+  std::vector<int> Results(NumCommands);
+  std::vector<const Command *> FailingCommandOf(NumCommands);
+  std::vector<bool> Skipped(NumCommands);
+  std::vector<unsigned> Finished;
+  std::mutex FinishedMutex;
+  std::condition_variable FinishedCond;
+
+  unsigned MaxRunning = getDriver().getParallelJobs();
+  unsigned NumRunning = 0, NumRemaining = NumCommands;
+  llvm::ThreadPool Pool(MaxRunning);
+  while (NumRemaining) {
+    for (; NumRunning < MaxRunning && !Ready.empty(); ++NumRunning) {
+      unsigned I = Ready.top();
+      Ready.pop();
+      Pool.async([&, I] {
+        Results[I] = ExecuteCommand(*Commands[I], FailingCommandOf[I]);
+        std::lock_guard<std::mutex> Lock(FinishedMutex);
+        Finished.push_back(I);
+        FinishedCond.notify_one();
+      });
+    }
+
+    std::vector<unsigned> JustFinished;
+    {
+      std::unique_lock<std::mutex> Lock(FinishedMutex);
+      FinishedCond.wait(Lock, [&] { return !Finished.empty(); });
+      JustFinished.swap(Finished);
+    }
+
+    for (unsigned I : JustFinished) {
+      --NumRunning;
+      --NumRemaining;
+      if (!Results[I]) {
+        for (unsigned D : Dependents[I])
+          if (!--NumPendingInputs[D] && !Skipped[D])
+            Ready.push(D);
+        continue;
+      }
+      SmallVector<unsigned, 8> Worklist(Dependents[I].begin(),
+                                        Dependents[I].end());
+      while (!Worklist.empty()) {
+        unsigned D = Worklist.pop_back_val();
+        if (Skipped[D])
+          continue;
+        Skipped[D] = true;
+        --NumRemaining;
+        Worklist.append(Dependents[D].begin(), Dependents[D].end());
+      }
+    }
+  }
+
+  // Report the failures in the order of the commands, as when running them
+  // one at a time.
+  for (unsigned I = 0; I != NumCommands; ++I)
+    if (!Skipped[I] && Results[I])
+      FailingCommands.push_back(std::make_pair(Results[I],
+                                               FailingCommandOf[I]));
+}
+
 void Compilation::ExecuteJob(const Job &J,
                              FailingCommandList &FailingCommands) const {
   if (const Command *C = dyn_cast<Command>(&J)) {
@@ -202,6 +332,23 @@ void Compilation::ExecuteJob(const Job &J,
       FailingCommands.push_back(std::make_pair(Res, FailingCommand));
   } else {
     const JobList *Jobs = cast<JobList>(&J);
+
+    // Run the commands in parallel when asked to, unless their output is
+    // redirected for crash diagnostics. Fallback commands diagnose the
+    // fallback themselves, so they keep running one at a time.
+    if (getDriver().getParallelJobs() > 1 && !Redirects) {
+      SmallVector<const Command *, 16> Commands;
+      collectCommands(*Jobs, Commands);
+      if (Commands.size() > 1 &&
+          std::none_of(Commands.begin(), Commands.end(),
+                       [](const Command *C) {
+                         return isa<FallbackCommand>(C);
+                       })) {
+        ExecuteJobsInParallel(Commands, FailingCommands);
+        return;
+      }
+    }
+
     for (const auto &Job : *Jobs)
       ExecuteJob(Job, FailingCommands);
   }
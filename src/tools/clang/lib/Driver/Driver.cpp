@@ -47,14 +47,15 @@ using namespace llvm::opt;
 Driver::Driver(StringRef ClangExecutable, StringRef DefaultTargetTriple,
                DiagnosticsEngine &Diags)
     : Opts(createDriverOptTable()), Diags(Diags), Mode(GCCMode),
-      SaveTemps(SaveTempsNone), BitcodeEmbed(EmbedNone),
+      SaveTemps(SaveTempsNone), BitcodeEmbed(EmbedNone), ParallelJobs(1),
       ClangExecutable(ClangExecutable),
       SysRoot(DEFAULT_SYSROOT), UseStdLib(true),
       DefaultTargetTriple(DefaultTargetTriple),
       DriverTitle("clang LLVM compiler"), CCPrintOptionsFilename(nullptr),
       CCPrintHeadersFilename(nullptr), CCLogDiagnosticsFilename(nullptr),
       CCCPrintBindings(false), CCPrintHeaders(false), CCLogDiagnostics(false),
-      CCGenDiagnostics(false), CCCGenericGCCName(""), CheckInputsExist(true),
+      CCGenDiagnostics(false), CC1Main(nullptr), CCCGenericGCCName(""),
+      CheckInputsExist(true),
       CCCUsePCH(true), SuppressMissingInputWarning(false) {
 
   Name = llvm::sys::path::stem(ClangExecutable);
@@ -374,6 +375,15 @@ Compilation *Driver::BuildCompilation(ArrayRef<const char *> ArgList) {
                     .Default(SaveTempsCwd);
   }
 
+  if (const Arg *A = Args->getLastArg(options::OPT_parallel_jobs_EQ)) {
+    StringRef Value = A->getValue();
+    if (Value.getAsInteger(10, ParallelJobs) || ParallelJobs == 0) {
+      Diag(clang::diag::err_drv_invalid_int_value)
+          << A->getAsString(*Args) << Value;
+      ParallelJobs = 1;
+    }
+  }
+
   // Ignore -fembed-bitcode options with LTO
   // since the output will be bitcode anyway.
   if (!Args->hasFlag(options::OPT_flto, options::OPT_fno_lto, false)) {
@@ -1674,8 +1684,17 @@ void Driver::BuildJobsForAction(Compilation &C,
     }
     llvm::errs() << "], output: " << Result.getAsString() << "\n";
   } else {
+    size_t NumJobs = C.getJobs().size();
     T->ConstructJob(C, *JA, Result, InputInfos,
                     C.getArgsForToolChain(TC, BoundArch), LinkingOutput);
+
+    // Record what the new commands produce, for the parallel execution.
+    if (Result.isFilename())
+      for (const auto &J : llvm::make_range(
+               C.getJobs().getJobs().begin() + NumJobs,
+               C.getJobs().getJobs().end()))
+        if (Command *Cmd = dyn_cast<Command>(J.get()))
+          Cmd->setOutputFilename(Result.getFilename());
   }
 }
 
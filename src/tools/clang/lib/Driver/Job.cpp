@@ -18,6 +18,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cassert>
@@ -31,8 +32,14 @@ Job::~Job() {}
 Command::Command(const Action &Source, const Tool &Creator,
                  const char *Executable, const ArgStringList &Arguments,
                  ArrayRef<InputInfo> Inputs)
-    : Job(CommandClass), Source(Source), Creator(Creator),
-      Executable(Executable), Arguments(Arguments), ResponseFile(nullptr) {
+    : Command(CommandClass, Source, Creator, Executable, Arguments, Inputs) {}
+
+Command::Command(JobClass Kind, const Action &Source, const Tool &Creator,
+                 const char *Executable, const ArgStringList &Arguments,
+                 ArrayRef<InputInfo> Inputs)
+    : Job(Kind), Source(Source), Creator(Creator),
+      Executable(Executable), Arguments(Arguments), OutputFilename(nullptr),
+      ResponseFile(nullptr) {
   for (const auto &II : Inputs)
     if (II.isFilename())
       InputFilenames.push_back(II.getFilename());
@@ -257,12 +264,45 @@ int Command::Execute(const StringRef **Redirects, std::string *ErrMsg,
                                    /*memoryLimit*/ 0, ErrMsg, ExecutionFailed);
 }
 
+CC1Command::CC1Command(const Action &Source_, const Tool &Creator_,
+                       const char *Executable_,
+                       const ArgStringList &Arguments_,
+                       ArrayRef<InputInfo> Inputs, bool InProcess)
+    : Command(CC1CommandClass, Source_, Creator_, Executable_, Arguments_,
+              Inputs),
+      InProcess(InProcess) {}
+
+int CC1Command::Execute(const StringRef **Redirects, std::string *ErrMsg,
+                        bool *ExecutionFailed) const {
+  // Redirected output needs a process of its own.
+  const Driver &D = getCreator().getToolChain().getDriver();
+  if (!InProcess || Redirects || !D.CC1Main)
+    return Command::Execute(Redirects, ErrMsg, ExecutionFailed);
+
+  SmallVector<const char *, 128> Argv;
+  Argv.push_back(getExecutable());
+  Argv.append(getArguments().begin(), getArguments().end());
+
+  if (ExecutionFailed)
+    *ExecutionFailed = false;
+
+  // Report a crash of cc1 like the crash of a separate process, so that the
+  // driver generates the crash diagnostics, in a new process.
+  llvm::CrashRecoveryContext::Enable();
+  llvm::CrashRecoveryContext CRC;
+  int Res = 1;
+  if (!CRC.RunSafely([&]() { Res = D.CC1Main(Argv); }))
+    return CRC.getRetCode() ? CRC.getRetCode() : -1;
+  return Res;
+}
+
 FallbackCommand::FallbackCommand(const Action &Source_, const Tool &Creator_,
                                  const char *Executable_,
                                  const ArgStringList &Arguments_,
                                  ArrayRef<InputInfo> Inputs,
                                  std::unique_ptr<Command> Fallback_)
-    : Command(Source_, Creator_, Executable_, Arguments_, Inputs),
+    : Command(FallbackCommandClass, Source_, Creator_, Executable_, Arguments_,
+              Inputs),
       Fallback(std::move(Fallback_)) {}
 
 void FallbackCommand::Print(raw_ostream &OS, const char *Terminator,
@@ -16,6 +16,7 @@
 #include "clang/Driver/DriverDiagnostic.h"
 #include "clang/Driver/Options.h"
 #include "clang/Driver/SanitizerArgs.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
@@ -29,6 +30,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
+#include "llvm/Support/TimeValue.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cstdlib> // ::getenv
 #include <system_error>
@@ -1330,14 +1332,43 @@ Generic_GCC::GCCInstallationDetector::init(
       Prefixes.push_back("/usr");
   }
 
+  // If CLANG_TOOLCHAIN_CACHE_PATH names a directory, the results of the
+  // search are cached there across invocations, keyed on everything the
+  // search depends on but the filesystem.
+  SmallString<128> CacheFile;
+  const char *CachePath = ::getenv("CLANG_TOOLCHAIN_CACHE_PATH");
+  if (CachePath && *CachePath) {
+    llvm::hash_code Key = llvm::hash_combine(getClangFullVersion(),
+                                             D.ClangExecutable,
+                                             TargetTriple.str());
+    llvm::sys::fs::file_status Status;
+    if (!llvm::sys::fs::status(D.ClangExecutable, Status))
+      Key = llvm::hash_combine(
+          Key, Status.getLastModificationTime().toEpochTime());
+    for (const std::string &Prefix : Prefixes)
+      Key = llvm::hash_combine(Key, Prefix);
+    // The multilib selection depends on the -m options.
+    for (const Arg *A : Args.filtered(options::OPT_m_Group))
+      Key = llvm::hash_combine(Key, A->getAsString(Args));
+
+    CacheFile = CachePath;
+    llvm::sys::path::append(CacheFile, "gcc-installation-" +
+                                           llvm::utohexstr(Key) + ".txt");
+    if (loadCachedSearch(CacheFile, TargetTriple, Args))
+      return;
+    RecordProbes = true;
+  }
+
   // Loop over the various components which exist and select the best GCC
   // installation available. GCC installs are ranked by version number.
   Version = GCCVersion::Parse("0.0.0");
   for (unsigned i = 0, ie = Prefixes.size(); i < ie; ++i) {
+    recordProbe(Prefixes[i]);
     if (!llvm::sys::fs::exists(Prefixes[i]))
       continue;
     for (unsigned j = 0, je = CandidateLibDirs.size(); j < je; ++j) {
       const std::string LibDir = Prefixes[i] + CandidateLibDirs[j].str();
+      recordProbe(LibDir);
       if (!llvm::sys::fs::exists(LibDir))
         continue;
       for (unsigned k = 0, ke = CandidateTripleAliases.size(); k < ke; ++k)
@@ -1346,6 +1377,7 @@ Generic_GCC::GCCInstallationDetector::init(
     }
     for (unsigned j = 0, je = CandidateBiarchLibDirs.size(); j < je; ++j) {
       const std::string LibDir = Prefixes[i] + CandidateBiarchLibDirs[j].str();
+      recordProbe(LibDir);
       if (!llvm::sys::fs::exists(LibDir))
         continue;
       for (unsigned k = 0, ke = CandidateBiarchTripleAliases.size(); k < ke;
@@ -1355,6 +1387,9 @@ Generic_GCC::GCCInstallationDetector::init(
                                /*NeedsBiarchSuffix=*/ true);
     }
   }
+
+  if (!CacheFile.empty())
+    saveCachedSearch(CacheFile);
 }
 
 void Generic_GCC::GCCInstallationDetector::print(raw_ostream &OS) const {
@@ -1601,14 +1636,44 @@ bool Generic_GCC::GCCInstallationDetector::getBiarchSibling(Multilib &M) const {
     BiarchTripleAliases.push_back(BiarchTriple.str());
 }
 
+/// The directories a search depended on, with their modification times.
+typedef std::map<std::string, uint64_t> ProbedDirMap;
+
+/// Record in \p Probed the nearest existing directory at or above \p Path:
+/// whether \p Path exists can't change without that directory's modification
+/// time changing.
+static void recordProbe(ProbedDirMap *Probed, StringRef Path) {
+  if (!Probed)
+    return;
+  for (StringRef Dir = Path; !Dir.empty();
+       Dir = llvm::sys::path::parent_path(Dir)) {
+    if (Probed->count(Dir))
+      return;
+    llvm::sys::fs::file_status Status;
+    if (!llvm::sys::fs::status(Dir, Status) &&
+        llvm::sys::fs::is_directory(Status)) {
+      (*Probed)[Dir] = Status.getLastModificationTime().toEpochTime();
+      return;
+    }
+  }
+}
+
+void Generic_GCC::GCCInstallationDetector::recordProbe(StringRef Path) {
+  ::recordProbe(RecordProbes ? &ProbedDirs : nullptr, Path);
+}
+
 namespace {
 // Filter to remove Multilibs that don't exist as a suffix to Path
 class FilterNonExistent : public MultilibSet::FilterCallback {
   std::string Base;
+  ProbedDirMap *Probed;
 public:
-  FilterNonExistent(std::string Base) : Base(Base) {}
+  FilterNonExistent(std::string Base, ProbedDirMap *Probed)
+      : Base(Base), Probed(Probed) {}
   bool operator()(const Multilib &M) const override {
-    return !llvm::sys::fs::exists(Base + M.gccSuffix() + "/crtbegin.o");
+    std::string Path = Base + M.gccSuffix() + "/crtbegin.o";
+    recordProbe(Probed, Path);
+    return !llvm::sys::fs::exists(Path);
   }
 };
 } // end anonymous namespace
@@ -1668,7 +1733,8 @@ static Multilib makeMultilib(StringRef commonSuffix) {
 
 static bool findMIPSMultilibs(const llvm::Triple &TargetTriple, StringRef Path,
                               const llvm::opt::ArgList &Args,
-                              DetectedMultilibs &Result) {
+                              DetectedMultilibs &Result,
+                              ProbedDirMap *Probed = nullptr) {
   // Some MIPS toolchains put libraries and object files compiled
   // using different options in to the sub-directoris which names
   // reflects the flags used for compilation. For example sysroot
@@ -1694,7 +1760,7 @@ static bool findMIPSMultilibs(const llvm::Triple &TargetTriple, StringRef Path,
   //     /usr
   //       /lib  <= crt*.o files compiled with '-mips32'
 
-  FilterNonExistent NonExistent(Path);
+  FilterNonExistent NonExistent(Path, Probed);
 
   // Check for FSF toolchain multilibs
   MultilibSet FSFMipsMultilibs;
@@ -1956,7 +2022,8 @@ static bool findMIPSMultilibs(const llvm::Triple &TargetTriple, StringRef Path,
 static bool findBiarchMultilibs(const llvm::Triple &TargetTriple,
                                 StringRef Path, const ArgList &Args,
                                 bool NeedsBiarchSuffix,
-                                DetectedMultilibs &Result) {
+                                DetectedMultilibs &Result,
+                                ProbedDirMap *Probed = nullptr) {
 
   // Some versions of SUSE and Fedora on ppc64 put 32-bit libs
   // in what would normally be GCCInstallPath and put the 64-bit
@@ -1979,7 +2046,7 @@ static bool findBiarchMultilibs(const llvm::Triple &TargetTriple,
     .includeSuffix("/x32")
     .flag("-m32").flag("-m64").flag("+mx32");
 
-  FilterNonExistent NonExistent(Path);
+  FilterNonExistent NonExistent(Path, Probed);
 
   // Determine default multilib from: 32, 64, x32
   // Also handle cases such as 64 on 32, 32 on 64, etc.
@@ -2066,8 +2133,10 @@ void Generic_GCC::GCCInstallationDetector::ScanLibDirForGCCTriple(
   // Only look at the final, weird Ubuntu suffix for i386-linux-gnu.
   const unsigned NumLibSuffixes =
       (llvm::array_lengthof(LibSuffixes) - (TargetArch != llvm::Triple::x86));
+  ProbedDirMap *Probed = RecordProbes ? &ProbedDirs : nullptr;
   for (unsigned i = 0; i < NumLibSuffixes; ++i) {
     StringRef LibSuffix = LibSuffixes[i];
+    recordProbe(LibDir + LibSuffix.str());
     std::error_code EC;
     for (llvm::sys::fs::directory_iterator LI(LibDir + LibSuffix, EC), LE;
          !EC && LI != LE; LI = LI.increment(EC)) {
@@ -2086,10 +2155,11 @@ void Generic_GCC::GCCInstallationDetector::ScanLibDirForGCCTriple(
       // Debian mips multilibs behave more like the rest of the biarch ones,
       // so handle them there
       if (isMipsArch(TargetArch)) {
-        if (!findMIPSMultilibs(TargetTriple, LI->path(), Args, Detected))
+        if (!findMIPSMultilibs(TargetTriple, LI->path(), Args, Detected,
+                               Probed))
           continue;
       } else if (!findBiarchMultilibs(TargetTriple, LI->path(), Args,
-                                      NeedsBiarchSuffix, Detected)) {
+                                      NeedsBiarchSuffix, Detected, Probed)) {
         continue;
       }
 
@@ -2103,11 +2173,138 @@ void Generic_GCC::GCCInstallationDetector::ScanLibDirForGCCTriple(
       // Linux.
       GCCInstallPath = LibDir + LibSuffixes[i] + "/" + VersionText.str();
       GCCParentLibPath = GCCInstallPath + InstallSuffixes[i];
+      InstallNeedsBiarchSuffix = NeedsBiarchSuffix;
       IsValid = true;
     }
   }
 }
 
+/// The first line of a cached GCC installation search; bump it when the
+/// format of the cache, or what the search does, changes.
+static const char GCCInstallationCacheMagic[] = "clang-gcc-installation 1";
+
+bool Generic_GCC::GCCInstallationDetector::loadCachedSearch(
+    StringRef CacheFile, const llvm::Triple &TargetTriple,
+    const ArgList &Args) {
+  auto Buffer = llvm::MemoryBuffer::getFile(CacheFile);
+  if (!Buffer)
+    return false;
+
+  SmallVector<StringRef, 16> Lines;
+  Buffer.get()->getBuffer().split(Lines, "\n", -1, /*KeepEmpty=*/false);
+  if (Lines.empty() || Lines[0] != GCCInstallationCacheMagic)
+    return false;
+
+  std::string InstallPath, ParentLibPath, Triple, VersionText;
+  bool NeedsBiarchSuffix = false;
+  std::set<std::string> Candidates;
+  for (StringRef Line : llvm::makeArrayRef(Lines).slice(1)) {
+    std::pair<StringRef, StringRef> Field = Line.split(' ');
+    if (Field.first == "probe") {
+      // The search is stale if any directory it depended on changed.
+      std::pair<StringRef, StringRef> Dir = Field.second.split(' ');
+      uint64_t ModTime;
+      llvm::sys::fs::file_status Status;
+      if (Dir.first.getAsInteger(10, ModTime) ||
+          llvm::sys::fs::status(Dir.second, Status) ||
+          !llvm::sys::fs::is_directory(Status) ||
+          Status.getLastModificationTime().toEpochTime() != ModTime)
+        return false;
+    } else if (Field.first == "candidate") {
+      Candidates.insert(Field.second.str());
+    } else if (Field.first == "install") {
+      InstallPath = Field.second;
+    } else if (Field.first == "parent") {
+      ParentLibPath = Field.second;
+    } else if (Field.first == "triple") {
+      Triple = Field.second;
+    } else if (Field.first == "version") {
+      VersionText = Field.second;
+    } else if (Field.first == "biarch") {
+      NeedsBiarchSuffix = Field.second == "1";
+    } else {
+      return false;
+    }
+  }
+
+  if (InstallPath.empty()) {
+    // The search found no installation.
+    Version = GCCVersion::Parse("0.0.0");
+    CandidateGCCInstallPaths = std::move(Candidates);
+    return true;
+  }
+
+  // The multilibs carry callbacks, so recompute them for the installation
+  // found, which only looks at that installation.
+  DetectedMultilibs Detected;
+  if (isMipsArch(TargetTriple.getArch())) {
+    if (!findMIPSMultilibs(TargetTriple, InstallPath, Args, Detected))
+      return false;
+  } else if (!findBiarchMultilibs(TargetTriple, InstallPath, Args,
+                                  NeedsBiarchSuffix, Detected)) {
+    return false;
+  }
+
+  Multilibs = Detected.Multilibs;
+  SelectedMultilib = Detected.SelectedMultilib;
+  BiarchSibling = Detected.BiarchSibling;
+  Version = GCCVersion::Parse(VersionText);
+  GCCTriple.setTriple(Triple);
+  GCCInstallPath = InstallPath;
+  GCCParentLibPath = ParentLibPath;
+  InstallNeedsBiarchSuffix = NeedsBiarchSuffix;
+  CandidateGCCInstallPaths = std::move(Candidates);
+  IsValid = true;
+  return true;
+}
+
+void Generic_GCC::GCCInstallationDetector::saveCachedSearch(
+    StringRef CacheFile) const {
+  // A directory modified within the last second could be modified again
+  // without its modification time changing: don't cache a search that
+  // depended on one.
+  uint64_t Now = llvm::sys::TimeValue::now().toEpochTime();
+  for (const auto &Dir : ProbedDirs)
+    if (Dir.second + 1 >= Now)
+      return;
+
+  std::string Contents;
+  llvm::raw_string_ostream OS(Contents);
+  OS << GCCInstallationCacheMagic << "\n";
+  if (IsValid) {
+    OS << "install " << GCCInstallPath << "\n"
+       << "parent " << GCCParentLibPath << "\n"
+       << "triple " << GCCTriple.str() << "\n"
+       << "version " << Version.Text << "\n"
+       << "biarch " << (InstallNeedsBiarchSuffix ? "1" : "0") << "\n";
+  }
+  for (const auto &InstallPath : CandidateGCCInstallPaths)
+    OS << "candidate " << InstallPath << "\n";
+  for (const auto &Dir : ProbedDirs)
+    OS << "probe " << Dir.second << " " << Dir.first << "\n";
+  OS.flush();
+
+  // Write the cache file atomically, so that concurrent invocations see
+  // either all of it or none of it.
+  SmallString<128> TemporaryFile = CacheFile;
+  TemporaryFile += "-%%%%%%";
+  int FD;
+  llvm::sys::fs::create_directories(llvm::sys::path::parent_path(CacheFile));
+  if (llvm::sys::fs::createUniqueFile(TemporaryFile.str(), FD, TemporaryFile))
+    return;
+
+  bool HadError;
+  {
+    llvm::raw_fd_ostream Out(FD, /*shouldClose=*/true);
+    Out << Contents;
+    Out.close();
+    HadError = Out.has_error();
+    Out.clear_error();
+  }
+  if (HadError || llvm::sys::fs::rename(TemporaryFile.str(), CacheFile))
+    llvm::sys::fs::remove(TemporaryFile.str());
+}
+
 Generic_GCC::Generic_GCC(const Driver &D, const llvm::Triple& Triple,
                          const ArgList &Args)
   : ToolChain(D, Triple, Args), GCCInstallation() {
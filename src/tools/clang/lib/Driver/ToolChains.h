@@ -18,6 +18,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/Support/Compiler.h"
+#include <map>
 #include <set>
 #include <vector>
 
@@ -98,8 +99,19 @@ protected:
     /// The set of multilibs that the detected installation supports.
     MultilibSet Multilibs;
 
+    /// Whether the detected installation was found through a biarch triple
+    /// alias.
+    bool InstallNeedsBiarchSuffix;
+
+    /// The directories the search for an installation depended on, with
+    /// their modification times, when the search is to be cached.
+    std::map<std::string, uint64_t> ProbedDirs;
+    bool RecordProbes;
+
   public:
-    GCCInstallationDetector() : IsValid(false) {}
+    GCCInstallationDetector()
+        : IsValid(false), InstallNeedsBiarchSuffix(false),
+          RecordProbes(false) {}
     void init(const Driver &D, const llvm::Triple &TargetTriple,
                             const llvm::opt::ArgList &Args);
 
@@ -145,6 +157,18 @@ protected:
                                 const std::string &LibDir,
                                 StringRef CandidateTriple,
                                 bool NeedsBiarchSuffix = false);
+
+    /// Record that the search depended on whether \p Path exists.
+    void recordProbe(StringRef Path);
+
+    /// Restore the results of a search from \p CacheFile, if it holds
+    /// them and none of the directories the search depended on changed.
+    bool loadCachedSearch(StringRef CacheFile,
+                          const llvm::Triple &TargetTriple,
+                          const llvm::opt::ArgList &Args);
+
+    /// Save the results of the search to \p CacheFile.
+    void saveCachedSearch(StringRef CacheFile) const;
   };
 
   GCCInstallationDetector GCCInstallation;
@@ -2452,6 +2452,25 @@ static void SplitDebugInfo(const ToolChain &TC, Compilation &C,
   C.addCommand(llvm::make_unique<Command>(JA, T, Exec, StripArgs, II));
 }
 
+/// \brief Whether the cc1 command can run within the driver process. cc1
+/// mutates global state: commands may not run concurrently, and the LLVM
+/// options set by -mllvm can only be parsed once per process. A crash is
+/// reproduced in a separate process.
+static bool canRunCC1InProcess(const Compilation &C, const ArgList &Args) {
+  const Driver &D = C.getDriver();
+  if (!D.CC1Main || C.isForDiagnostics() || D.getParallelJobs() > 1)
+    return false;
+  if (!Args.hasFlag(options::OPT_fintegrated_cc1,
+                    options::OPT_fno_integrated_cc1, true))
+    return false;
+  if (Args.hasArg(options::OPT_mllvm))
+    return false;
+  for (StringRef Value : Args.getAllArgValues(options::OPT_Xclang))
+    if (Value == "-mllvm" || Value == "-load")
+      return false;
+  return true;
+}
+
 /// \brief Vectorize at all optimization levels greater than 1 except for -Oz.
 /// For -Oz the loop vectorizer is disable, while the slp vectorizer is enabled.
 static bool shouldEnableVectorizerAtOLevel(const ArgList &Args, bool isSlpVec) {
@@ -3658,6 +3677,15 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   if (Args.hasArg(options::OPT_fcoverage_mapping))
     CmdArgs.push_back("-fcoverage-mapping");
 
+  // The vtables are only all in one module when linking with LTO.
+  if (Args.hasFlag(options::OPT_fwhole_program_vtables,
+                   options::OPT_fno_whole_program_vtables, false)) {
+    if (!D.IsUsingLTO(Args))
+      D.Diag(diag::err_drv_argument_only_allowed_with)
+        << "-fwhole-program-vtables" << "-flto";
+    CmdArgs.push_back("-fwhole-program-vtables");
+  }
+
   if (C.getArgs().hasArg(options::OPT_c) ||
       C.getArgs().hasArg(options::OPT_S)) {
     if (Output.isFilename()) {
@@ -3695,6 +3723,8 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   CmdArgs.push_back(D.ResourceDir.c_str());
 
   Args.AddLastArg(CmdArgs, options::OPT_working_directory);
+  Args.AddLastArg(CmdArgs, options::OPT_fdirectory_cache_EQ);
+  Args.AddLastArg(CmdArgs, options::OPT_fpth_cache_path);
 
   bool ARCMTEnabled = false;
   if (!Args.hasArg(options::OPT_fno_objc_arc, options::OPT_fobjc_arc)) {
@@ -4012,6 +4042,10 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   Args.AddLastArg(CmdArgs, options::OPT_fheinous_gnu_extensions);
   Args.AddLastArg(CmdArgs, options::OPT_fstandalone_debug);
   Args.AddLastArg(CmdArgs, options::OPT_fno_standalone_debug);
+  Args.AddLastArg(CmdArgs, options::OPT_fuse_ctor_homing,
+                  options::OPT_fno_use_ctor_homing);
+  Args.AddLastArg(CmdArgs, options::OPT_fhome_inline_methods,
+                  options::OPT_fno_home_inline_methods);
   Args.AddLastArg(CmdArgs, options::OPT_fno_operator_names);
   // AltiVec language extensions aren't relevant for assembling.
   if (!isa<PreprocessJobAction>(JA) || 
@@ -4046,6 +4080,10 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   Args.AddLastArg(CmdArgs, options::OPT_fdiagnostics_print_source_range_info);
   Args.AddLastArg(CmdArgs, options::OPT_fdiagnostics_parseable_fixits);
   Args.AddLastArg(CmdArgs, options::OPT_ftime_report);
+  Args.AddLastArg(CmdArgs, options::OPT_ftime_trace);
+  Args.AddLastArg(CmdArgs, options::OPT_ftime_trace_granularity_EQ);
+  Args.AddLastArg(CmdArgs, options::OPT_ftime_trace_format_EQ);
+  Args.AddLastArg(CmdArgs, options::OPT_stats_file);
   Args.AddLastArg(CmdArgs, options::OPT_ftrapv);
 
   if (Arg *A = Args.getLastArg(options::OPT_ftrapv_handler_EQ)) {
@@ -4284,12 +4322,19 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   // -fmodule-file can be used to specify files containing precompiled modules.
   Args.AddAllArgs(CmdArgs, options::OPT_fmodule_file);
 
+  // -fno-implicit-modules restricts the compile to the module files given
+  // with -fmodule-file; there is no module cache then.
+  bool ImplicitModules = Args.hasFlag(options::OPT_fimplicit_modules,
+                                      options::OPT_fno_implicit_modules, true);
+  if (HaveModules && !ImplicitModules)
+    CmdArgs.push_back("-fno-implicit-modules");
+
   // -fmodule-cache-path specifies where our implicitly-built module files
   // should be written.
   SmallString<128> ModuleCachePath;
   if (Arg *A = Args.getLastArg(options::OPT_fmodules_cache_path))
     ModuleCachePath = A->getValue();
-  if (HaveModules) {
+  if (HaveModules && ImplicitModules) {
     if (C.isForDiagnostics()) {
       // When generating crash reports, we want to emit the modules along with
       // the reproduction sources, so we ignore any provided module path.
@@ -4329,6 +4374,7 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   Args.AddAllArgs(CmdArgs, options::OPT_fmodules_ignore_macro);
   Args.AddLastArg(CmdArgs, options::OPT_fmodules_prune_interval);
   Args.AddLastArg(CmdArgs, options::OPT_fmodules_prune_after);
+  Args.AddLastArg(CmdArgs, options::OPT_fmodules_build_threads);
 
   Args.AddLastArg(CmdArgs, options::OPT_fbuild_session_timestamp);
 
@@ -4926,6 +4972,7 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   Args.AddAllArgs(CmdArgs, options::OPT_fcomment_block_commands);
   // Forward -fparse-all-comments to -cc1.
   Args.AddAllArgs(CmdArgs, options::OPT_fparse_all_comments);
+  Args.AddLastArg(CmdArgs, options::OPT_index_store_path);
 
   // Forward -Xclang arguments to -cc1, and -mllvm arguments to the LLVM option
   // parser.
@@ -5014,7 +5061,8 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
     C.addCommand(llvm::make_unique<FallbackCommand>(
         JA, *this, Exec, CmdArgs, Inputs, std::move(CLCommand)));
   } else {
-    C.addCommand(llvm::make_unique<Command>(JA, *this, Exec, CmdArgs, Inputs));
+    C.addCommand(llvm::make_unique<CC1Command>(
+        JA, *this, Exec, CmdArgs, Inputs, canRunCC1InProcess(C, Args)));
   }
 
 
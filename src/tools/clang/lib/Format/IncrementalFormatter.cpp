@@ -0,0 +1,277 @@
+//===--- IncrementalFormatter.cpp - Format edited buffers -----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief This file implements \c IncrementalFormatter, which formats the
+/// ranges of an edited buffer by only formatting the top-level declarations
+/// around them.
+///
+/// The formatter annotates the tokens of the lines it formats in place, so
+/// the lines themselves cannot be kept across calls. Instead, the buffer is
+/// split into regions that format independently of each other, and only the
+/// regions around the requested ranges are lexed, parsed and formatted.
+///
+//===----------------------------------------------------------------------===//
+
+#include "clang/Format/Format.h"
+#include "clang/Lex/Lexer.h"
+#include <algorithm>
+
+namespace clang {
+namespace format {
+
+IncrementalFormatter::IncrementalFormatter(const FormatStyle &Style,
+                                           StringRef FileName)
+    : Style(Style), FileName(FileName) {}
+
+// Whether a region can be formatted without looking at the rest of the file.
+// Some options derive the style from the whole file.
+static bool canFormatRegions(const FormatStyle &Style) {
+  return Style.Language == FormatStyle::LK_Cpp && !Style.DisableFormat &&
+         !Style.DerivePointerAlignment &&
+         !Style.ExperimentalAutoDetectBinPacking &&
+         Style.Standard != FormatStyle::LS_Auto;
+}
+
+void IncrementalFormatter::updateSplitPoints(StringRef NewCode) {
+  if (!SplitPoints.empty() && NewCode == Code)
+    return;
+
+  StringRef OldCode = Code;
+  unsigned Prefix = 0;
+  unsigned Common = std::min(OldCode.size(), NewCode.size());
+  while (Prefix < Common && OldCode[Prefix] == NewCode[Prefix])
+    ++Prefix;
+  unsigned Suffix = 0;
+  while (Suffix < Common - Prefix &&
+         OldCode[OldCode.size() - Suffix - 1] ==
+             NewCode[NewCode.size() - Suffix - 1])
+    ++Suffix;
+  int Delta = int(NewCode.size()) - int(OldCode.size());
+
+  // A split point stays valid as long as the text before it and its first
+  // character are unchanged. The first split point is the start of the
+  // buffer and always valid.
+  std::vector<SplitPoint> Old;
+  Old.swap(SplitPoints);
+  auto Kept = std::lower_bound(
+      Old.begin(), Old.end(), Prefix,
+      [](const SplitPoint &P, unsigned Offset) { return P.Offset < Offset; });
+  if (Kept == Old.begin())
+    Kept = Old.empty() ? Old.end() : Old.begin() + 1;
+  SplitPoints.assign(Old.begin(), Kept);
+  if (SplitPoints.empty())
+    SplitPoints.push_back({0, 0, false});
+
+  Code = NewCode;
+  scan(SplitPoints.back(), NewCode.size() - Suffix,
+       llvm::makeArrayRef(Old).slice(Kept - Old.begin()), Delta);
+}
+
+// Lexes the buffer from \p Start and appends the split points found. Once a
+// split point in the unchanged suffix starting at \p StopAfter matches one of
+// the previous split points \p Old, the rest of the buffer lexes as before and
+// the remaining previous split points are reused, shifted by \p Delta.
+//
+// A split point is the first token of a line that follows a blank line and
+// ends a top-level declaration or preprocessor directive, outside of
+// preprocessor conditionals and clang-format off regions. Blocks that do not
+// add a level of indentation, such as namespaces, count as top-level.
+void IncrementalFormatter::scan(SplitPoint Start, unsigned StopAfter,
+                                ArrayRef<SplitPoint> Old, int Delta) {
+  LangOptions LangOpts = getFormattingLangOpts(Style);
+  const char *Begin = Code.data();
+  Lexer Lex(SourceLocation(), LangOpts, Begin, Begin + Start.Offset,
+            Begin + Code.size());
+  Lex.SetCommentRetentionState(true);
+
+  // Whether each enclosing brace adds a level of indentation.
+  SmallVector<bool, 8> Indenting(Start.Depth, false);
+  unsigned IndentingBraces = 0;
+  unsigned Parens = 0;
+  unsigned PPConditionals = 0;
+  bool FormattingOff = false;
+  bool Unbalanced = false;
+  bool AtDeclarationEnd = true;
+  bool InPPDirective = false;
+  bool AfterHash = false;
+  unsigned PreviousEnd = Start.Offset;
+  Token Previous[2];
+  Previous[0].startToken();
+  Previous[1].startToken();
+
+  Token Tok;
+  while (!Lex.LexFromRawLexer(Tok) || Tok.isNot(tok::eof)) {
+    unsigned End = Lex.getBufferLocation() - Begin;
+    unsigned Offset = End - Tok.getLength();
+    StringRef Text(Begin + Offset, Tok.getLength());
+
+    if (InPPDirective && !Tok.isAtStartOfLine()) {
+      if (AfterHash && Tok.is(tok::raw_identifier)) {
+        StringRef Directive = Tok.getRawIdentifier();
+        if (Directive == "if" || Directive == "ifdef" || Directive == "ifndef")
+          ++PPConditionals;
+        else if (Directive == "endif" && PPConditionals == 0)
+          Unbalanced = true;
+        else if (Directive == "endif")
+          --PPConditionals;
+      }
+      AfterHash = false;
+      PreviousEnd = End;
+      continue;
+    }
+    InPPDirective = false;
+
+    if (Offset > Start.Offset && Tok.isAtStartOfLine() && AtDeclarationEnd &&
+        IndentingBraces == 0 && Parens == 0 && PPConditionals == 0 &&
+        !FormattingOff &&
+        StringRef(Begin + PreviousEnd, Offset - PreviousEnd).count('\n') >= 2) {
+      SplitPoints.back().Unbalanced = Unbalanced;
+      Unbalanced = false;
+      SplitPoint Point = {Offset, unsigned(Indenting.size()), false};
+      SplitPoints.push_back(Point);
+      if (Offset >= StopAfter) {
+        auto I = std::lower_bound(Old.begin(), Old.end(), Offset - Delta,
+                                  [](const SplitPoint &P, unsigned Offset) {
+                                    return P.Offset < Offset;
+                                  });
+        if (I != Old.end() && I->Offset == Offset - Delta &&
+            I->Depth == Point.Depth) {
+          SplitPoints.back().Unbalanced = I->Unbalanced;
+          for (++I; I != Old.end(); ++I)
+            SplitPoints.push_back({I->Offset + Delta, I->Depth, I->Unbalanced});
+          return;
+        }
+      }
+    }
+    PreviousEnd = End;
+
+    if (Tok.is(tok::comment)) {
+      if (Text == "// clang-format off" || Text == "/* clang-format off */")
+        FormattingOff = true;
+      else if (Text == "// clang-format on" || Text == "/* clang-format on */")
+        FormattingOff = false;
+      continue;
+    }
+    if (Tok.is(tok::hash) && Tok.isAtStartOfLine()) {
+      InPPDirective = true;
+      AfterHash = true;
+      continue;
+    }
+
+    if (Tok.is(tok::l_brace)) {
+      bool IsNamespace = (Previous[0].is(tok::raw_identifier) &&
+                          Previous[0].getRawIdentifier() == "namespace") ||
+                         (Previous[1].is(tok::raw_identifier) &&
+                          Previous[1].getRawIdentifier() == "namespace" &&
+                          Previous[0].is(tok::raw_identifier));
+      bool IsExternC = Previous[0].is(tok::string_literal) &&
+                       Previous[1].is(tok::raw_identifier) &&
+                       Previous[1].getRawIdentifier() == "extern";
+      bool Indents =
+          !IsExternC &&
+          (!IsNamespace || Style.NamespaceIndentation != FormatStyle::NI_None);
+      Indenting.push_back(Indents);
+      if (Indents)
+        ++IndentingBraces;
+      AtDeclarationEnd = !Indents && IndentingBraces == 0;
+    } else if (Tok.is(tok::r_brace)) {
+      if (Indenting.empty()) {
+        Unbalanced = true;
+      } else {
+        if (Indenting.back())
+          --IndentingBraces;
+        Indenting.pop_back();
+      }
+      AtDeclarationEnd = IndentingBraces == 0;
+    } else {
+      if (Tok.is(tok::l_paren))
+        ++Parens;
+      else if (Tok.is(tok::r_paren) && Parens == 0)
+        Unbalanced = true;
+      else if (Tok.is(tok::r_paren))
+        --Parens;
+      AtDeclarationEnd = Tok.is(tok::semi) && IndentingBraces == 0;
+    }
+    Previous[1] = Previous[0];
+    Previous[0] = Tok;
+  }
+  SplitPoints.back().Unbalanced =
+      Unbalanced || !Indenting.empty() || Parens != 0 || PPConditionals != 0;
+}
+
+tooling::Replacements
+IncrementalFormatter::reformat(StringRef NewCode,
+                               ArrayRef<tooling::Range> Ranges) {
+  if (!canFormatRegions(Style) || Ranges.empty()) {
+    Code.clear();
+    SplitPoints.clear();
+    return format::reformat(Style, NewCode, Ranges, FileName);
+  }
+  updateSplitPoints(NewCode);
+
+  // The formatter recovers from unbalanced brackets in ways that depend on
+  // the whole file.
+  bool Balanced =
+      std::none_of(SplitPoints.begin(), SplitPoints.end(),
+                   [](const SplitPoint &P) { return P.Unbalanced; });
+  if (!Balanced)
+    return format::reformat(Style, Code, Ranges, FileName);
+
+  // Format from the start of the region before the first range to the end of
+  // the region after the last one, so that the lines next to the ranges are
+  // seen as they would be when formatting the whole file.
+  unsigned RangesBegin = Code.size(), RangesEnd = 0;
+  for (const tooling::Range &R : Ranges) {
+    RangesBegin = std::min(RangesBegin, R.getOffset());
+    RangesEnd = std::max(RangesEnd, R.getOffset() + R.getLength());
+  }
+  auto First = std::upper_bound(
+      SplitPoints.begin(), SplitPoints.end(), RangesBegin,
+      [](unsigned Offset, const SplitPoint &P) { return Offset < P.Offset; });
+  --First;
+  if (First != SplitPoints.begin())
+    --First;
+  auto Last = std::upper_bound(
+      SplitPoints.begin(), SplitPoints.end(), RangesEnd,
+      [](unsigned Offset, const SplitPoint &P) { return Offset < P.Offset; });
+  if (Last != SplitPoints.end())
+    ++Last;
+
+  unsigned SliceBegin = First->Offset;
+  unsigned SliceEnd = Code.size();
+  if (Last != SplitPoints.end()) {
+    // The blank lines before a split point belong to its region.
+    SliceEnd = Last->Offset;
+    StringRef Whitespace = " \t\n\v\f\r";
+    while (SliceEnd > SliceBegin &&
+           Whitespace.find(Code[SliceEnd - 1]) != StringRef::npos)
+      --SliceEnd;
+  }
+  if (SliceBegin == 0 && SliceEnd == Code.size())
+    return format::reformat(Style, Code, Ranges, FileName);
+
+  std::vector<tooling::Range> SliceRanges;
+  for (const tooling::Range &R : Ranges) {
+    unsigned Begin = std::max(R.getOffset(), SliceBegin);
+    unsigned End = std::min(R.getOffset() + R.getLength(), SliceEnd);
+    if (Begin <= End)
+      SliceRanges.push_back(tooling::Range(Begin - SliceBegin, End - Begin));
+  }
+  std::string Slice = Code.substr(SliceBegin, SliceEnd - SliceBegin);
+  tooling::Replacements Result;
+  for (const tooling::Replacement &R :
+       format::reformat(Style, Slice, SliceRanges, FileName))
+    Result.insert(tooling::Replacement(FileName, R.getOffset() + SliceBegin,
+                                       R.getLength(), R.getReplacementText()));
+  return Result;
+}
+
+} // end namespace format
+} // end namespace clang
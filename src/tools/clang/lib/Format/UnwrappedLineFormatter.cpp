@@ -564,6 +564,10 @@ unsigned UnwrappedLineFormatter::analyzeSolutionSpace(LineState &InitialState,
 
   unsigned Penalty = 0;
 
+  // Whether the search budget is exhausted. From then on, only the cheapest
+  // successor of each state is followed.
+  bool Greedy = false;
+
   // While not empty, take first element and follow edges.
   while (!Queue.empty()) {
     Penalty = Queue.top().first.first;
@@ -579,9 +583,20 @@ unsigned UnwrappedLineFormatter::analyzeSolutionSpace(LineState &InitialState,
     if (Count > 10000)
       Node->State.IgnoreStackForComparison = true;
 
-    if (!Seen.insert(&Node->State).second)
+    if (!Greedy && Style.MaxLineFormattingStates != 0 &&
+        Count > Style.MaxLineFormattingStates) {
+      DEBUG(llvm::dbgs() << "Search budget exhausted, placing the remaining "
+                            "tokens greedily.\n");
+      Greedy = true;
+    }
+    if (Greedy) {
+      // Drop the other candidates, so that the next state taken from the queue
+      // is the cheapest successor of this one.
+      Queue = QueueType();
+    } else if (!Seen.insert(&Node->State).second) {
       // State already examined with lower penalty.
       continue;
+    }
 
     FormatDecision LastFormat = Node->State.NextToken->Decision;
     if (LastFormat == FD_Unformatted || LastFormat == FD_Continue)
@@ -38,12 +38,14 @@
 #include "llvm/ADT/StringSet.h"
 #include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/MutexGuard.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
 #include <atomic>
 #include <cstdio>
 #include <cstdlib>
@@ -80,9 +82,15 @@ namespace {
   };
   
   struct OnDiskData {
+    OnDiskData() : PreambleFileIsShared(false) {}
+
     /// \brief The file in which the precompiled preamble is stored.
     std::string PreambleFile;
 
+    /// \brief Whether \c PreambleFile is owned by a \c SharedPreamble rather
+    /// than by this unit, in which case it is not ours to erase.
+    bool PreambleFileIsShared;
+
     /// \brief Temporary files that should be removed when the ASTUnit is
     /// destroyed.
     SmallVector<std::string, 4> TemporaryFiles;
@@ -154,8 +162,11 @@ static void removeOnDiskEntry(const ASTUnit *AU) {
   }
 }
 
-static void setPreambleFile(const ASTUnit *AU, StringRef preambleFile) {
-  getOnDiskData(AU).PreambleFile = preambleFile;
+static void setPreambleFile(const ASTUnit *AU, StringRef preambleFile,
+                            bool isShared = false) {
+  OnDiskData &D = getOnDiskData(AU);
+  D.PreambleFile = preambleFile;
+  D.PreambleFileIsShared = isShared;
 }
 
 static const std::string &getPreambleFile(const ASTUnit *AU) {
@@ -170,8 +181,10 @@ void OnDiskData::CleanTemporaryFiles() {
 
 void OnDiskData::CleanPreambleFile() {
   if (!PreambleFile.empty()) {
-    llvm::sys::fs::remove(PreambleFile);
+    if (!PreambleFileIsShared)
+      llvm::sys::fs::remove(PreambleFile);
     PreambleFile.clear();
+    PreambleFileIsShared = false;
   }
 }
 
@@ -225,7 +238,7 @@ ASTUnit::ASTUnit(SharedModuleProvider MP, bool _MainFileIsAST)
     IncludeBriefCommentsInCodeCompletion(false), UserFilesAreVolatile(false),
     CompletionCacheTopLevelHashValue(0),
     PreambleTopLevelHashValue(0),
-    CurrentTopLevelHashValue(0),
+    CurrentTopLevelHashValue(0), PreambleCache(nullptr),
     UnsafeToFree(false) { 
   if (getenv("LIBCLANG_OBJTRACKING"))
     fprintf(stderr, "+++ %u translation units\n", ++ActiveASTUnitObjects);
@@ -860,6 +873,10 @@ public:
   // We're not interested in "interesting" decls.
   void HandleInterestingDecl(DeclGroupRef) override {}
 
+  bool shouldSkipFunctionBody(Decl *D) override {
+    return Unit.shouldSkipFunctionBody(D);
+  }
+
   void HandleTopLevelDeclInObjCContainer(DeclGroupRef D) override {
     for (Decl *TopLevelDecl : D)
       handleTopLevelDecl(TopLevelDecl);
@@ -1247,7 +1264,7 @@ ASTUnit::PreambleFileHash::createForFile(off_t Size, time_t ModTime) {
   PreambleFileHash Result;
   Result.Size = Size;
   Result.ModTime = ModTime;
-  memset(Result.MD5, 0, sizeof(Result.MD5));
+  Result.ContentHash = 0;
   return Result;
 }
 
@@ -1257,9 +1274,7 @@ ASTUnit::PreambleFileHash ASTUnit::PreambleFileHash::createForMemoryBuffer(
   Result.Size = Buffer->getBufferSize();
   Result.ModTime = 0;
 
-  llvm::MD5 MD5Ctx;
-  MD5Ctx.update(Buffer->getBuffer().data());
-  MD5Ctx.final(Result.MD5);
+  Result.ContentHash = llvm::xxHash64(Buffer->getBuffer());
 
   return Result;
 }
@@ -1268,7 +1283,7 @@ namespace clang {
 bool operator==(const ASTUnit::PreambleFileHash &LHS,
                 const ASTUnit::PreambleFileHash &RHS) {
   return LHS.Size == RHS.Size && LHS.ModTime == RHS.ModTime &&
-         memcmp(LHS.MD5, RHS.MD5, sizeof(LHS.MD5)) == 0;
+         LHS.ContentHash == RHS.ContentHash;
 }
 } // namespace clang
 
@@ -1317,6 +1332,118 @@ makeStandaloneDiagnostic(const LangOptions &LangOpts,
   return OutDiag;
 }
 
+/// \brief Determine whether any of the files a precompiled preamble was built
+/// from have changed, taking files remapped by \p PreprocessorOpts into
+/// account.
+static bool preambleFilesChanged(
+    FileManager &FileMgr, const PreprocessorOptions &PreprocessorOpts,
+    const llvm::StringMap<ASTUnit::PreambleFileHash> &FilesInPreamble) {
+  bool AnyFileChanged = false;
+
+  // First, make a record of those files that have been overridden via
+  // remapping or unsaved_files.
+  llvm::StringMap<ASTUnit::PreambleFileHash> OverriddenFiles;
+  for (const auto &R : PreprocessorOpts.RemappedFiles) {
+    if (AnyFileChanged)
+      break;
+
+    vfs::Status Status;
+    if (FileMgr.getNoncachedStatValue(R.second, Status)) {
+      // If we can't stat the file we're remapping to, assume that something
+      // horrible happened.
+      AnyFileChanged = true;
+      break;
+    }
+
+    OverriddenFiles[R.first] = ASTUnit::PreambleFileHash::createForFile(
+        Status.getSize(), Status.getLastModificationTime().toEpochTime());
+  }
+
+  for (const auto &RB : PreprocessorOpts.RemappedFileBuffers) {
+    if (AnyFileChanged)
+      break;
+    OverriddenFiles[RB.first] =
+        ASTUnit::PreambleFileHash::createForMemoryBuffer(RB.second);
+  }
+   
+  // Check whether anything has changed.
+  for (llvm::StringMap<ASTUnit::PreambleFileHash>::const_iterator
+         F = FilesInPreamble.begin(), FEnd = FilesInPreamble.end();
+       !AnyFileChanged && F != FEnd; 
+       ++F) {
+    llvm::StringMap<ASTUnit::PreambleFileHash>::iterator Overridden
+      = OverriddenFiles.find(F->first());
+    if (Overridden != OverriddenFiles.end()) {
+      // This file was remapped; check whether the newly-mapped file 
+      // matches up with the previous mapping.
+      if (Overridden->second != F->second)
+        AnyFileChanged = true;
+      continue;
+    }
+    
+    // The file was not remapped; check whether it has changed on disk.
+    vfs::Status Status;
+    if (FileMgr.getNoncachedStatValue(F->first(), Status)) {
+      // If we can't stat the file, assume that something horrible happened.
+      AnyFileChanged = true;
+    } else if (Status.getSize() != uint64_t(F->second.Size) ||
+               Status.getLastModificationTime().toEpochTime() !=
+                   uint64_t(F->second.ModTime))
+      AnyFileChanged = true;
+  }
+
+  return AnyFileChanged;
+}
+
+/// \brief Compute the key under which a preamble built from \p Invocation is
+/// stored in a \c PrecompiledPreambleCache.
+static std::string getPreambleCacheKey(const CompilerInvocation &Invocation,
+                                       StringRef MainFilename,
+                                       StringRef PreambleText,
+                                       bool PreambleEndsAtStartOfLine) {
+  llvm::MD5 Hash;
+  auto AddString = [&Hash](StringRef Str) {
+    Hash.update(Str);
+    Hash.update(StringRef("\0", 1));
+  };
+
+  // The module hash covers the language, target and predefined macros.
+  AddString(Invocation.getModuleHash());
+
+  const HeaderSearchOptions &HSOpts = Invocation.getHeaderSearchOpts();
+  for (const auto &Entry : HSOpts.UserEntries) {
+    AddString(Entry.Path);
+    AddString(llvm::utostr(Entry.Group));
+    AddString(Entry.IsFramework ? "F" : "");
+  }
+
+  const PreprocessorOptions &PPOpts = Invocation.getPreprocessorOpts();
+  for (const auto &Include : PPOpts.Includes)
+    AddString(Include);
+  for (const auto &Include : PPOpts.MacroIncludes)
+    AddString(Include);
+  AddString(PPOpts.ImplicitPCHInclude);
+  AddString(PPOpts.ImplicitPTHInclude);
+
+  // Warning flags affect the diagnostics we replay from the preamble.
+  const DiagnosticOptions &DiagOpts = Invocation.getDiagnosticOpts();
+  for (const auto &Warning : DiagOpts.Warnings)
+    AddString(Warning);
+  for (const auto &Remark : DiagOpts.Remarks)
+    AddString(Remark);
+
+  AddString(Invocation.getFrontendOpts().SkipFunctionBodies ? "S" : "");
+  AddString(MainFilename);
+  AddString(PreambleEndsAtStartOfLine ? "L" : "");
+  Hash.update(PreambleText);
+
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Key;
+  llvm::MD5::stringifyResult(Result, Key);
+  return Key.str();
+}
+
 /// \brief Attempt to build or re-use a precompiled preamble when (re-)parsing
 /// the source file.
 ///
@@ -1355,6 +1482,7 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
     // preamble, if we have one. It's obviously no good any more.
     Preamble.clear();
     erasePreambleFile(this);
+    CachedPreamble.reset();
 
     // The next time we actually see a preamble, precompile it.
     PreambleRebuildCounter = 1;
@@ -1374,60 +1502,9 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
       // preamble.
 
       // Check that none of the files used by the preamble have changed.
-      bool AnyFileChanged = false;
-          
-      // First, make a record of those files that have been overridden via
-      // remapping or unsaved_files.
-      llvm::StringMap<PreambleFileHash> OverriddenFiles;
-      for (const auto &R : PreprocessorOpts.RemappedFiles) {
-        if (AnyFileChanged)
-          break;
-
-        vfs::Status Status;
-        if (FileMgr->getNoncachedStatValue(R.second, Status)) {
-          // If we can't stat the file we're remapping to, assume that something
-          // horrible happened.
-          AnyFileChanged = true;
-          break;
-        }
-
-        OverriddenFiles[R.first] = PreambleFileHash::createForFile(
-            Status.getSize(), Status.getLastModificationTime().toEpochTime());
-      }
+      bool AnyFileChanged =
+          preambleFilesChanged(*FileMgr, PreprocessorOpts, FilesInPreamble);
 
-      for (const auto &RB : PreprocessorOpts.RemappedFileBuffers) {
-        if (AnyFileChanged)
-          break;
-        OverriddenFiles[RB.first] =
-            PreambleFileHash::createForMemoryBuffer(RB.second);
-      }
-       
-      // Check whether anything has changed.
-      for (llvm::StringMap<PreambleFileHash>::iterator 
-             F = FilesInPreamble.begin(), FEnd = FilesInPreamble.end();
-           !AnyFileChanged && F != FEnd; 
-           ++F) {
-        llvm::StringMap<PreambleFileHash>::iterator Overridden
-          = OverriddenFiles.find(F->first());
-        if (Overridden != OverriddenFiles.end()) {
-          // This file was remapped; check whether the newly-mapped file 
-          // matches up with the previous mapping.
-          if (Overridden->second != F->second)
-            AnyFileChanged = true;
-          continue;
-        }
-        
-        // The file was not remapped; check whether it has changed on disk.
-        vfs::Status Status;
-        if (FileMgr->getNoncachedStatValue(F->first(), Status)) {
-          // If we can't stat the file, assume that something horrible happened.
-          AnyFileChanged = true;
-        } else if (Status.getSize() != uint64_t(F->second.Size) ||
-                   Status.getLastModificationTime().toEpochTime() !=
-                       uint64_t(F->second.ModTime))
-          AnyFileChanged = true;
-      }
-          
       if (!AnyFileChanged) {
         // Okay! We can re-use the precompiled preamble.
 
@@ -1452,6 +1529,7 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
     Preamble.clear();
     PreambleDiagnostics.clear();
     erasePreambleFile(this);
+    CachedPreamble.reset();
     PreambleRebuildCounter = 1;
   } else if (!AllowRebuild) {
     // We aren't allowed to rebuild the precompiled preamble; just
@@ -1459,6 +1537,59 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
     return nullptr;
   }
 
+  // Another unit of this index may already have precompiled the very same
+  // preamble; if so, and none of its files changed since, use that one.
+  StringRef PreambleText =
+      NewPreamble.Buffer->getBuffer().slice(0, NewPreamble.Size);
+  std::string PreambleCacheKey;
+  if (PreambleCache) {
+    StringRef MainFilename = FrontendOpts.Inputs[0].getFile();
+    PreambleCacheKey = getPreambleCacheKey(
+        *PreambleInvocation, MainFilename, PreambleText,
+        NewPreamble.PreambleEndsAtStartOfLine);
+    if (std::shared_ptr<SharedPreamble> Shared =
+            PreambleCache->lookup(PreambleCacheKey)) {
+      if (Shared->Text == PreambleText &&
+          Shared->PreambleEndsAtStartOfLine ==
+              NewPreamble.PreambleEndsAtStartOfLine &&
+          !preambleFilesChanged(*FileMgr, PreprocessorOpts,
+                                Shared->FilesInPreamble)) {
+        Preamble.assign(FileMgr->getFile(MainFilename), PreambleText.begin(),
+                        PreambleText.end());
+        PreambleEndsAtStartOfLine = Shared->PreambleEndsAtStartOfLine;
+        FilesInPreamble.clear();
+        for (const auto &F : Shared->FilesInPreamble)
+          FilesInPreamble[F.getKey()] = F.getValue();
+        PreambleDiagnostics = Shared->Diagnostics;
+        TopLevelDecls.clear();
+        TopLevelDeclsInPreamble = Shared->TopLevelDecls;
+        NumWarningsInPreamble = Shared->NumWarnings;
+        OriginalSourceFile = MainFilename;
+        setPreambleFile(this, Shared->File, /*isShared=*/true);
+        PreambleRebuildCounter = 1;
+        if (Shared->TopLevelHashValue != PreambleTopLevelHashValue) {
+          CompletionCacheTopLevelHashValue = 0;
+          PreambleTopLevelHashValue = Shared->TopLevelHashValue;
+        }
+        CachedPreamble = std::move(Shared);
+
+        // Set the state of the diagnostic object to mimic its state
+        // after parsing the preamble.
+        getDiagnostics().Reset();
+        ProcessWarningOptions(getDiagnostics(),
+                              PreambleInvocation->getDiagnosticOpts());
+        getDiagnostics().setNumWarnings(NumWarningsInPreamble);
+        checkAndRemoveNonDriverDiags(StoredDiagnostics);
+
+        return llvm::MemoryBuffer::getMemBufferCopy(
+            NewPreamble.Buffer->getBuffer(), MainFilename);
+      }
+
+      // The cached preamble is stale; build a fresh one in its place.
+      PreambleCache->remove(PreambleCacheKey);
+    }
+  }
+
   // If the preamble rebuild counter > 1, it's because we previously
   // failed to build a preamble and we're not yet ready to try
   // again. Decrement the counter and return a failure.
@@ -1488,8 +1619,8 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
                   NewPreamble.Buffer->getBufferStart() + NewPreamble.Size);
   PreambleEndsAtStartOfLine = NewPreamble.PreambleEndsAtStartOfLine;
 
-  PreambleBuffer = llvm::MemoryBuffer::getMemBufferCopy(
-      NewPreamble.Buffer->getBuffer().slice(0, Preamble.size()), MainFilename);
+  PreambleBuffer =
+      llvm::MemoryBuffer::getMemBufferCopy(PreambleText, MainFilename);
 
   // Remap the main source file to the preamble buffer.
   StringRef MainFilePath = FrontendOpts.Inputs[0].getFile();
@@ -1632,6 +1763,27 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
     PreambleTopLevelHashValue = CurrentTopLevelHashValue;
   }
 
+  // Publish the preamble so that other units of this index with the same
+  // preamble can reuse it. From now on the cache entry owns the file.
+  if (PreambleCache) {
+    auto Shared = std::make_shared<SharedPreamble>();
+    Shared->File = FrontendOpts.OutputFile;
+    Shared->Text = PreambleText;
+    Shared->PreambleEndsAtStartOfLine = PreambleEndsAtStartOfLine;
+    for (const auto &F : FilesInPreamble)
+      Shared->FilesInPreamble[F.getKey()] = F.getValue();
+    Shared->Diagnostics = PreambleDiagnostics;
+    Shared->TopLevelDecls = TopLevelDeclsInPreamble;
+    Shared->NumWarnings = NumWarningsInPreamble;
+    Shared->TopLevelHashValue = PreambleTopLevelHashValue;
+    uint64_t FileSize;
+    if (!llvm::sys::fs::file_size(Shared->File, FileSize))
+      Shared->FileSize = FileSize;
+    setPreambleFile(this, Shared->File, /*isShared=*/true);
+    CachedPreamble = Shared;
+    PreambleCache->insert(PreambleCacheKey, std::move(Shared));
+  }
+
   return llvm::MemoryBuffer::getMemBufferCopy(NewPreamble.Buffer->getBuffer(),
                                               MainFilename);
 }
@@ -1933,7 +2085,7 @@ ASTUnit *ASTUnit::LoadFromCommandLine(
     bool CacheCodeCompletionResults, bool IncludeBriefCommentsInCodeCompletion,
     bool AllowPCHWithCompilerErrors, bool SkipFunctionBodies,
     bool UserFilesAreVolatile, bool ForSerialization,
-    std::unique_ptr<ASTUnit> *ErrAST) {
+    std::unique_ptr<ASTUnit> *ErrAST, PrecompiledPreambleCache *PreambleCache) {
   assert(Diags.get() && "no DiagnosticsEngine was provided");
 
   SmallVector<StoredDiagnostic, 4> StoredDiagnostics;
@@ -1984,6 +2136,7 @@ ASTUnit *ASTUnit::LoadFromCommandLine(
   AST->IncludeBriefCommentsInCodeCompletion
     = IncludeBriefCommentsInCodeCompletion;
   AST->UserFilesAreVolatile = UserFilesAreVolatile;
+  AST->PreambleCache = PreambleCache;
   AST->NumStoredDiagnosticsFromDriver = StoredDiagnostics.size();
   AST->StoredDiagnostics.swap(StoredDiagnostics);
   AST->Invocation = CI;
@@ -2010,7 +2163,145 @@ ASTUnit *ASTUnit::LoadFromCommandLine(
   return AST.release();
 }
 
-bool ASTUnit::Reparse(ArrayRef<RemappedFile> RemappedFiles) {
+/// \brief Shift the main-file offsets in \p SD that follow an edit of the main
+/// file ending at \p OldEnd by \p Delta.
+static void shiftStandaloneDiagnostic(ASTUnit::StandaloneDiagnostic &SD,
+                                      unsigned OldEnd, int Delta) {
+  auto Shift = [OldEnd, Delta](unsigned &Offset) {
+    if (Offset >= OldEnd)
+      Offset += Delta;
+  };
+  Shift(SD.LocOffset);
+  for (auto &Range : SD.Ranges) {
+    Shift(Range.first);
+    Shift(Range.second);
+  }
+  for (auto &FixIt : SD.FixIts) {
+    Shift(FixIt.RemoveRange.first);
+    Shift(FixIt.RemoveRange.second);
+    Shift(FixIt.InsertFromRange.first);
+    Shift(FixIt.InsertFromRange.second);
+  }
+}
+
+void ASTUnit::collectUnchangedFunctionBodies(
+    StringRef OldText, StringRef NewText,
+    SmallVectorImpl<StandaloneDiagnostic> &CarriedDiags) {
+  // Find the edited region: everything but the common prefix and suffix.
+  unsigned Max = std::min(OldText.size(), NewText.size());
+  unsigned EditBegin = 0;
+  while (EditBegin != Max && OldText[EditBegin] == NewText[EditBegin])
+    ++EditBegin;
+  unsigned Suffix = 0;
+  while (Suffix != Max - EditBegin &&
+         OldText[OldText.size() - Suffix - 1] ==
+             NewText[NewText.size() - Suffix - 1])
+    ++Suffix;
+  unsigned EditOldEnd = OldText.size() - Suffix;
+  int Delta = int(NewText.size()) - int(OldText.size());
+
+  const SourceManager &SM = getSourceManager();
+  FileID MainFID = SM.getMainFileID();
+  auto GetMainFileOffset = [&](SourceLocation Loc, unsigned &Offset) {
+    if (Loc.isInvalid() || !Loc.isFileID())
+      return false;
+    std::pair<FileID, unsigned> Decomposed = SM.getDecomposedLoc(Loc);
+    if (Decomposed.first != MainFID)
+      return false;
+    Offset = Decomposed.second;
+    return true;
+  };
+
+  // The old ranges of the definitions we'll skip, for carrying over their
+  // diagnostics.
+  SmallVector<std::pair<unsigned, unsigned>, 16> SkippedRanges;
+  std::function<void(Decl *)> Visit = [&](Decl *D) {
+    if (auto *Template = dyn_cast<TemplateDecl>(D)) {
+      if (Decl *Templated = Template->getTemplatedDecl())
+        Visit(Templated);
+      return;
+    }
+
+    bool HasBody = false;
+    if (auto *FD = dyn_cast<FunctionDecl>(D))
+      HasBody = FD->doesThisDeclarationHaveABody() && !FD->hasSkippedBody();
+    else if (auto *MD = dyn_cast<ObjCMethodDecl>(D))
+      HasBody = MD->hasBody() && !MD->hasSkippedBody();
+    if (HasBody) {
+      unsigned Begin, End, NameOffset;
+      SourceRange Range = D->getSourceRange();
+      if (!GetMainFileOffset(Range.getBegin(), Begin) ||
+          !GetMainFileOffset(Range.getEnd(), End) ||
+          !GetMainFileOffset(D->getLocation(), NameOffset))
+        return;
+
+      // The range ends at the closing brace. Leave a character of slack on
+      // either side so that an edit adjacent to the definition, which may
+      // have glued tokens onto it, still causes it to be re-parsed.
+      if (End + 1 < EditBegin)
+        UnchangedFunctionBodies.insert(NameOffset);
+      else if (Begin > EditOldEnd)
+        UnchangedFunctionBodies.insert(NameOffset + Delta);
+      else
+        return;
+      SkippedRanges.push_back(std::make_pair(Begin, End + 1));
+      return;
+    }
+
+    if (isa<NamespaceDecl>(D) || isa<LinkageSpecDecl>(D) ||
+        isa<RecordDecl>(D) || isa<ObjCContainerDecl>(D))
+      for (Decl *Member : cast<DeclContext>(D)->decls())
+        Visit(Member);
+  };
+  for (Decl *D : TopLevelDecls)
+    Visit(D);
+  if (UnchangedFunctionBodies.empty())
+    return;
+
+  // Save the diagnostics emitted within the bodies we're about to skip, along
+  // with their notes, since we won't see them again.
+  bool InSkippedBody = false;
+  for (unsigned I = NumStoredDiagnosticsFromDriver,
+                N = StoredDiagnostics.size(); I != N; ++I) {
+    const StoredDiagnostic &SD = StoredDiagnostics[I];
+    unsigned Offset = 0;
+    bool InMainFile = GetMainFileOffset(SM.getFileLoc(SD.getLocation()),
+                                        Offset);
+    if (SD.getLevel() != DiagnosticsEngine::Note) {
+      InSkippedBody = false;
+      if (InMainFile)
+        for (const auto &Range : SkippedRanges)
+          if (Offset >= Range.first && Offset < Range.second)
+            InSkippedBody = true;
+    }
+    if (!InSkippedBody)
+      continue;
+
+    // Drop notes that point into the edited region; it no longer exists.
+    if (InMainFile && Offset >= EditBegin && Offset < EditOldEnd)
+      continue;
+
+    CarriedDiags.push_back(makeStandaloneDiagnostic(getLangOpts(), SD));
+    if (InMainFile)
+      shiftStandaloneDiagnostic(CarriedDiags.back(), EditOldEnd, Delta);
+  }
+}
+
+bool ASTUnit::shouldSkipFunctionBody(const Decl *D) const {
+  if (UnchangedFunctionBodies.empty())
+    return true;
+
+  const SourceManager &SM = getSourceManager();
+  SourceLocation Loc = D->getLocation();
+  if (Loc.isInvalid() || !Loc.isFileID())
+    return false;
+  std::pair<FileID, unsigned> Decomposed = SM.getDecomposedLoc(Loc);
+  return Decomposed.first == SM.getMainFileID() &&
+         UnchangedFunctionBodies.count(Decomposed.second);
+}
+
+bool ASTUnit::Reparse(ArrayRef<RemappedFile> RemappedFiles,
+                      bool SkipUnchangedFunctionBodies) {
   if (!Invocation)
     return true;
 
@@ -2030,6 +2321,22 @@ bool ASTUnit::Reparse(ArrayRef<RemappedFile> RemappedFiles) {
                                                       RemappedFile.second);
   }
 
+  // Work out which function bodies the edits since the last parse left alone,
+  // while we still have that parse around.
+  SmallVector<StandaloneDiagnostic, 4> CarriedDiags;
+  FrontendOptions &FrontendOpts = Invocation->getFrontendOpts();
+  if (SkipUnchangedFunctionBodies && !FrontendOpts.SkipFunctionBodies &&
+      Ctx && SourceMgr) {
+    bool Invalid = false;
+    StringRef OldText =
+        SourceMgr->getBufferData(SourceMgr->getMainFileID(), &Invalid);
+    ComputedPreamble NewMainFile = ComputePreamble(*Invocation, 0);
+    if (!Invalid && NewMainFile.Buffer)
+      collectUnchangedFunctionBodies(OldText,
+                                     NewMainFile.Buffer->getBuffer(),
+                                     CarriedDiags);
+  }
+
   // If we have a preamble file lying around, or if we might try to
   // build a precompiled preamble, do so now.
   std::unique_ptr<llvm::MemoryBuffer> OverrideMainBuffer;
@@ -2042,8 +2349,22 @@ bool ASTUnit::Reparse(ArrayRef<RemappedFile> RemappedFiles) {
   if (OverrideMainBuffer)
     getDiagnostics().setNumWarnings(NumWarningsInPreamble);
 
-  // Parse the sources
+  // Parse the sources, skipping only the unchanged function bodies.
+  bool SkippingUnchanged = !UnchangedFunctionBodies.empty();
+  if (SkippingUnchanged)
+    FrontendOpts.SkipFunctionBodies = true;
   bool Result = Parse(getSharedModuleProvider(), std::move(OverrideMainBuffer));
+  if (SkippingUnchanged) {
+    FrontendOpts.SkipFunctionBodies = false;
+    UnchangedFunctionBodies.clear();
+
+    if (!Result && !CarriedDiags.empty()) {
+      SmallVector<StoredDiagnostic, 4> Carried;
+      TranslateStoredDiagnostics(getFileManager(), getSourceManager(),
+                                 CarriedDiags, Carried);
+      StoredDiagnostics.append(Carried.begin(), Carried.end());
+    }
+  }
 
   // If we're caching global code-completion results, and the top-level 
   // declarations have changed, clear out the code-completion cache.
@@ -2857,3 +3178,58 @@ void ASTUnit::ConcurrencyState::start() {}
 void ASTUnit::ConcurrencyState::finish() {}
 
 #endif
+
+SharedPreamble::~SharedPreamble() {
+  if (!File.empty())
+    llvm::sys::fs::remove(File);
+}
+
+std::shared_ptr<SharedPreamble>
+PrecompiledPreambleCache::lookup(StringRef Key) {
+  std::lock_guard<std::mutex> Guard(Lock);
+  auto Known = EntriesByKey.find(Key);
+  if (Known == EntriesByKey.end())
+    return nullptr;
+
+  // This is now the most recently used preamble.
+  Entries.splice(Entries.begin(), Entries, Known->second);
+  return Known->second->second;
+}
+
+void PrecompiledPreambleCache::insert(StringRef Key,
+                                      std::shared_ptr<SharedPreamble> Preamble) {
+  std::lock_guard<std::mutex> Guard(Lock);
+  auto Known = EntriesByKey.find(Key);
+  if (Known != EntriesByKey.end()) {
+    Size -= Known->second->second->FileSize;
+    Entries.erase(Known->second);
+    EntriesByKey.erase(Known);
+  }
+
+  Size += Preamble->FileSize;
+  Entries.push_front(CacheEntry(Key, std::move(Preamble)));
+  EntriesByKey[Key] = Entries.begin();
+  evict();
+}
+
+void PrecompiledPreambleCache::remove(StringRef Key) {
+  std::lock_guard<std::mutex> Guard(Lock);
+  auto Known = EntriesByKey.find(Key);
+  if (Known == EntriesByKey.end())
+    return;
+
+  Size -= Known->second->second->FileSize;
+  Entries.erase(Known->second);
+  EntriesByKey.erase(Known);
+}
+
+void PrecompiledPreambleCache::evict() {
+  // Drop the least recently used preambles until we fit. Units that are
+  // still using one of them keep its file alive until they let go of it.
+  while (Size > SizeLimit && !Entries.empty()) {
+    CacheEntry &Oldest = Entries.back();
+    Size -= Oldest.second->FileSize;
+    EntriesByKey.erase(Oldest.first);
+    Entries.pop_back();
+  }
+}
@@ -19,11 +19,13 @@
 #include "clang/Basic/IdentifierTable.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Lex/Lexer.h"
+#include "clang/Lex/PTHManager.h"
 #include "clang/Lex/Preprocessor.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/EndianStream.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/OnDiskHashTable.h"
 #include "llvm/Support/Path.h"
@@ -191,6 +193,9 @@ class PTHWriter {
   Offset CurStrOffset;
   std::vector<llvm::StringMapEntry<OffsetOpt>*> StrEntries;
 
+  /// Whether a token couldn't be represented in the PTH file.
+  bool HasInvalidToken;
+
   //// Get the persistent id for the given IdentifierInfo*.
   uint32_t ResolveID(const IdentifierInfo* II);
 
@@ -232,15 +237,26 @@ class PTHWriter {
   /// token data.
   Offset EmitFileTable() { return PM.Emit(Out); }
 
-  PTHEntry LexTokens(Lexer& L);
+  /// LexTokens - Emit the tokens of the file \p L lexes, and return whether
+  ///  they could be.
+  bool LexTokens(Lexer& L, PTHEntry &Entry);
   Offset EmitCachedSpellings();
 
+  /// EmitPrologue - Emit the start of the PTH file, and return the offset of
+  ///  the table offsets, which EmitTables() fills in.
+  Offset EmitPrologue(StringRef MainFile);
+  void EmitTables(Offset PrologueOffset);
+
 public:
   PTHWriter(llvm::raw_fd_ostream& out, Preprocessor& pp)
-    : Out(out), PP(pp), idcount(0), CurStrOffset(0) {}
+    : Out(out), PP(pp), idcount(0), CurStrOffset(0), HasInvalidToken(false) {}
 
   PTHMap &getPM() { return PM; }
   void GeneratePTH(const std::string &MainFile);
+
+  /// GenerateHeaderPTH - Generate a PTH file containing the tokens of the
+  ///  file \p FID only, and return whether it could be.
+  bool GenerateHeaderPTH(FileID FID);
 };
 } // end anonymous namespace
 
@@ -258,6 +274,10 @@ uint32_t PTHWriter::ResolveID(const IdentifierInfo* II) {
 }
 
 void PTHWriter::EmitToken(const Token& T) {
+  // The length and the flags of the tokens are stored in 16 and 8 bits.
+  if (T.getLength() > 0xFFFF || T.getFlags() > 0xFF)
+    HasInvalidToken = true;
+
   // Emit the token kind, flags, and length.
   Emit32(((uint32_t) T.getKind()) | ((((uint32_t) T.getFlags())) << 8)|
          (((uint32_t) T.getLength()) << 16));
@@ -288,7 +308,7 @@ void PTHWriter::EmitToken(const Token& T) {
   Emit32(PP.getSourceManager().getFileOffset(T.getLocation()));
 }
 
-PTHEntry PTHWriter::LexTokens(Lexer& L) {
+bool PTHWriter::LexTokens(Lexer& L, PTHEntry &Entry) {
   // Pad 0's so that we emit tokens to a 4-byte alignment.
   // This speed up reading them back in.
   using namespace llvm::support;
@@ -395,7 +415,8 @@ PTHEntry PTHWriter::LexTokens(Lexer& L) {
         // use 0 for uninitialized indices because that is easier to debug.
         unsigned index = PPCond.size();
         // Backpatch the opening '#if' entry.
-        assert(!PPStartCond.empty());
+        if (PPStartCond.empty())
+          return false;
         assert(PPCond.size() > PPStartCond.back());
         assert(PPCond[PPStartCond.back()].second == 0);
         PPCond[PPStartCond.back()].second = index;
@@ -420,7 +441,8 @@ PTHEntry PTHWriter::LexTokens(Lexer& L) {
         // This means that its entry will get backpatched later.
         unsigned index = PPCond.size();
         // Backpatch the previous '#if' entry.
-        assert(!PPStartCond.empty());
+        if (PPStartCond.empty())
+          return false;
         assert(PPCond.size() > PPStartCond.back());
         assert(PPCond[PPStartCond.back()].second == 0);
         PPCond[PPStartCond.back()].second = index;
@@ -437,7 +459,9 @@ PTHEntry PTHWriter::LexTokens(Lexer& L) {
   }
   while (Tok.isNot(tok::eof));
 
-  assert(PPStartCond.empty() && "Error: imblanced preprocessor conditionals.");
+  // The conditionals of the file are not balanced.
+  if (!PPStartCond.empty() || HasInvalidToken)
+    return false;
 
   // Next write out PPCond.
   Offset PPCondOff = (Offset) Out.tell();
@@ -454,7 +478,8 @@ PTHEntry PTHWriter::LexTokens(Lexer& L) {
     Emit32(x == i ? 0 : x);
   }
 
-  return PTHEntry(TokenOff, PPCondOff);
+  Entry = PTHEntry(TokenOff, PPCondOff);
+  return true;
 }
 
 Offset PTHWriter::EmitCachedSpellings() {
@@ -468,7 +493,7 @@ Offset PTHWriter::EmitCachedSpellings() {
   return SpellingsOff;
 }
 
-void PTHWriter::GeneratePTH(const std::string &MainFile) {
+Offset PTHWriter::EmitPrologue(StringRef MainFile) {
   // Generate the prologue.
   Out << "cfe-pth" << '\0';
   Emit32(PTHManager::Version);
@@ -486,6 +511,29 @@ void PTHWriter::GeneratePTH(const std::string &MainFile) {
     Emit16(0);
   }
   Emit8(0);
+  return PrologueOffset;
+}
+
+void PTHWriter::EmitTables(Offset PrologueOffset) {
+  // Write out the identifier table.
+  const std::pair<Offset,Offset> &IdTableOff = EmitIdentifierTable();
+
+  // Write out the cached strings table.
+  Offset SpellingOff = EmitCachedSpellings();
+
+  // Write out the file table.
+  Offset FileTableOff = EmitFileTable();
+
+  // Finally, write the prologue.
+  Out.seek(PrologueOffset);
+  Emit32(IdTableOff.first);
+  Emit32(IdTableOff.second);
+  Emit32(FileTableOff);
+  Emit32(SpellingOff);
+}
+
+void PTHWriter::GeneratePTH(const std::string &MainFile) {
+  Offset PrologueOffset = EmitPrologue(MainFile);
 
   // Iterate over all the files in SourceManager.  Create a lexer
   // for each file and cache the tokens.
@@ -507,24 +555,33 @@ void PTHWriter::GeneratePTH(const std::string &MainFile) {
     FileID FID = SM.createFileID(FE, SourceLocation(), SrcMgr::C_User);
     const llvm::MemoryBuffer *FromFile = SM.getBuffer(FID);
     Lexer L(FID, FromFile, SM, LOpts);
-    PM.insert(FE, LexTokens(L));
+    PTHEntry Entry;
+    if (LexTokens(L, Entry))
+      PM.insert(FE, Entry);
+    HasInvalidToken = false;
   }
 
-  // Write out the identifier table.
-  const std::pair<Offset,Offset> &IdTableOff = EmitIdentifierTable();
-
-  // Write out the cached strings table.
-  Offset SpellingOff = EmitCachedSpellings();
-
-  // Write out the file table.
-  Offset FileTableOff = EmitFileTable();
+  EmitTables(PrologueOffset);
+}
 
-  // Finally, write the prologue.
-  Out.seek(PrologueOffset);
-  Emit32(IdTableOff.first);
-  Emit32(IdTableOff.second);
-  Emit32(FileTableOff);
-  Emit32(SpellingOff);
+bool PTHWriter::GenerateHeaderPTH(FileID FID) {
+  SourceManager &SM = PP.getSourceManager();
+  const FileEntry *FE = SM.getFileEntryForID(FID);
+  bool Invalid = false;
+  const llvm::MemoryBuffer *FromFile = SM.getBuffer(FID, &Invalid);
+  if (!FE || Invalid)
+    return false;
+
+  Offset PrologueOffset = EmitPrologue(StringRef());
+
+  Lexer L(FID, FromFile, SM, PP.getLangOpts());
+  PTHEntry Entry;
+  if (!LexTokens(L, Entry))
+    return false;
+  PM.insert(FE, Entry);
+
+  EmitTables(PrologueOffset);
+  return true;
 }
 
 namespace {
@@ -682,3 +739,144 @@ std::pair<Offset,Offset> PTHWriter::EmitIdentifierTable() {
 
   return std::make_pair(IDOff, StringTableOffset);
 }
+
+//===----------------------------------------------------------------------===//
+// Caching of the tokens of the headers.
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// DirectoryPTHCache - A PTHCache storing the tokens of each system header in
+///  its own PTH file of a cache directory, named after the hash of the name
+///  and the contents of the header and of the options the tokens depend on.
+///  Headers whose tokens aren't cached yet are lexed from their source, and
+///  their tokens are cached for the next compiles.
+class DirectoryPTHCache : public PTHCache {
+  Preprocessor &PP;
+  std::string Path;
+
+  /// The hash of the language options and of the PTH version.
+  llvm::MD5::MD5Result OptionsHash;
+
+  /// The PTHManagers of the headers entered so far, null for the ones which
+  ///  are lexed from their source.
+  llvm::DenseMap<const FileEntry *, std::unique_ptr<PTHManager>> Managers;
+
+  /// Diagnostics ignoring the errors of the PTH files, which are rewritten.
+  DiagnosticsEngine IgnoringDiags;
+
+  bool writeHeaderPTH(FileID FID, StringRef HeaderPTHPath);
+
+public:
+  DirectoryPTHCache(Preprocessor &PP, StringRef Path);
+
+  PTHLexer *CreateLexer(FileID FID) override;
+};
+} // end anonymous namespace
+
+DirectoryPTHCache::DirectoryPTHCache(Preprocessor &PP, StringRef Path)
+    : PP(PP), Path(Path),
+      IgnoringDiags(PP.getDiagnostics().getDiagnosticIDs(),
+                    &PP.getDiagnostics().getDiagnosticOptions(),
+                    new IgnoringDiagConsumer()) {
+  // The tokens depend on every language option the lexer looks at; rather
+  // than tracking them, hash all of them.
+  const LangOptions &LangOpts = PP.getLangOpts();
+  llvm::MD5 Hash;
+  uint32_t Version = PTHManager::Version;
+  Hash.update(llvm::makeArrayRef(reinterpret_cast<const uint8_t *>(&Version),
+                                 sizeof(Version)));
+  auto HashValue = [&](uint64_t Value) {
+    Hash.update(llvm::makeArrayRef(reinterpret_cast<const uint8_t *>(&Value),
+                                   sizeof(Value)));
+  };
+#define LANGOPT(Name, Bits, Default, Description) \
+  HashValue(LangOpts.Name);
+#define ENUM_LANGOPT(Name, Type, Bits, Default, Description) \
+  HashValue(static_cast<uint64_t>(LangOpts.get##Name()));
+#include "clang/Basic/LangOptions.def"
+  Hash.final(OptionsHash);
+}
+
+PTHLexer *DirectoryPTHCache::CreateLexer(FileID FID) {
+  SourceManager &SM = PP.getSourceManager();
+  const FileEntry *FE = SM.getFileEntryForID(FID);
+  if (!FE)
+    return nullptr;
+
+  // The lexer would report diagnostics the cached tokens don't, only cache
+  // the headers where they are suppressed.
+  if (!SM.isInSystemHeader(SM.getLocForStartOfFile(FID)) ||
+      !PP.getDiagnostics().getSuppressSystemWarnings())
+    return nullptr;
+
+  auto Known = Managers.find(FE);
+  if (Known != Managers.end())
+    return Known->second ? Known->second->CreateLexer(FID) : nullptr;
+  std::unique_ptr<PTHManager> &Manager = Managers[FE];
+
+  bool Invalid = false;
+  StringRef Contents = SM.getBufferData(FID, &Invalid);
+  if (Invalid)
+    return nullptr;
+
+  llvm::MD5 Hash;
+  Hash.update(llvm::makeArrayRef(OptionsHash, sizeof(OptionsHash)));
+  Hash.update(FE->getName());
+  Hash.update(StringRef("", 1));
+  Hash.update(Contents);
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Digest;
+  llvm::MD5::stringifyResult(Result, Digest);
+
+  SmallString<256> HeaderPTHPath(Path);
+  llvm::sys::path::append(HeaderPTHPath, Digest.str() + ".pth");
+  if (llvm::sys::fs::exists(HeaderPTHPath.str())) {
+    Manager.reset(PTHManager::Create(HeaderPTHPath.str(), IgnoringDiags));
+    if (Manager) {
+      Manager->setPreprocessor(&PP);
+      Manager->setUsePreprocessorIdentifiers();
+      if (PTHLexer *PL = Manager->CreateLexer(FID))
+        return PL;
+      Manager.reset();
+    }
+  }
+
+  // Lex the header from its source this time.
+  writeHeaderPTH(FID, HeaderPTHPath);
+  return nullptr;
+}
+
+bool DirectoryPTHCache::writeHeaderPTH(FileID FID, StringRef HeaderPTHPath) {
+  if (llvm::sys::fs::create_directories(Path))
+    return false;
+
+  // Write to a temporary file renamed to the PTH file once complete, so that
+  // concurrent compiles only see complete PTH files.
+  SmallString<256> TempPath;
+  int FD;
+  if (llvm::sys::fs::createUniqueFile(HeaderPTHPath + "-%%%%%%%%", FD,
+                                      TempPath))
+    return false;
+
+  bool Written;
+  {
+    llvm::raw_fd_ostream Out(FD, /*shouldClose=*/true);
+    PTHWriter PW(Out, PP);
+    Written = PW.GenerateHeaderPTH(FID);
+    Out.close();
+    Written &= !Out.has_error();
+    Out.clear_error();
+  }
+
+  if (!Written || llvm::sys::fs::rename(TempPath.str(), HeaderPTHPath)) {
+    llvm::sys::fs::remove(TempPath.str());
+    return false;
+  }
+  return true;
+}
+
+std::unique_ptr<PTHCache> clang::createPTHCache(Preprocessor &PP,
+                                                StringRef Path) {
+  return llvm::make_unique<DirectoryPTHCache>(PP, Path);
+}
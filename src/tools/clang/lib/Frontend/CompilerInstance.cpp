@@ -13,6 +13,7 @@
 #include "clang/AST/Decl.h"
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/FileManager.h"
+#include "clang/Basic/FileSystemStatCache.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/TargetInfo.h"
 #include "clang/Basic/Version.h"
@@ -27,13 +28,17 @@
 #include "clang/Frontend/Utils.h"
 #include "clang/Frontend/VerifyDiagnosticConsumer.h"
 #include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/Lexer.h"
 #include "clang/Lex/PTHManager.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Sema/CodeCompleteConsumer.h"
 #include "clang/Sema/Sema.h"
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/GlobalModuleIndex.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/FileSystem.h"
@@ -43,17 +48,183 @@
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <sys/stat.h>
 #include <system_error>
+#include <thread>
 #include <time.h>
 
 using namespace clang;
 
+namespace clang {
+/// \brief Builds the modules that a compiler instance is expected to import on
+/// worker threads, before the imports that need them are reached.
+///
+/// The workers take the usual lock on the module file, so a module is never
+/// built twice at the same time, by this process or by any other. Their
+/// diagnostics are discarded: a module that fails to build leaves no module
+/// file behind, and the import that needs it builds it again the usual way,
+/// reporting the errors.
+class ModulePrebuilder {
+public:
+  /// \brief Everything needed to build a module independently of the
+  /// importing compiler instance.
+  struct Request {
+    Request(SharedModuleProvider MP) : MP(std::move(MP)) {}
+
+    SharedModuleProvider MP;
+    IntrusiveRefCntPtr<CompilerInvocation> Invocation;
+    IntrusiveRefCntPtr<vfs::FileSystem> VFS;
+    std::vector<std::string> BuildStack;
+    std::string ModuleName;
+    std::string ModuleFileName;
+    std::string ModuleMapFileName;
+    std::string InferredModuleMap;
+    std::string ModuleMapFileForUniquing;
+    bool IsSystem;
+  };
+
+  explicit ModulePrebuilder(unsigned MaxThreads) : MaxThreads(MaxThreads) {}
+  ~ModulePrebuilder();
+
+  /// \brief Queue the given module build and start a worker for it if the
+  /// limit on concurrent module builds allows it.
+  void add(std::unique_ptr<Request> R);
+
+  /// \brief Wait until the given module is not being built by a worker.
+  ///
+  /// A module whose build has not started yet is removed from the queue, it
+  /// is cheaper for the caller to build it right away.
+  void wait(StringRef ModuleName);
+
+private:
+  void run();
+  static void build(Request &R);
+
+  /// \brief The number of module builds allowed in flight, including the one
+  /// on the thread that imports them.
+  unsigned MaxThreads;
+
+  /// \brief The number of worker threads of all prebuilders in this process.
+  static std::atomic<unsigned> NumWorkers;
+
+  std::mutex Mutex;
+  std::condition_variable BuildDone;
+  std::deque<std::unique_ptr<Request>> Pending;
+  llvm::StringSet<> Building;
+  std::vector<std::thread> Workers;
+};
+}
+
+std::atomic<unsigned> ModulePrebuilder::NumWorkers(0);
+
+ModulePrebuilder::~ModulePrebuilder() {
+  {
+    std::lock_guard<std::mutex> Guard(Mutex);
+    Pending.clear();
+  }
+  for (std::thread &Worker : Workers)
+    Worker.join();
+}
+
+void ModulePrebuilder::add(std::unique_ptr<Request> R) {
+  {
+    std::lock_guard<std::mutex> Guard(Mutex);
+    Pending.push_back(std::move(R));
+  }
+
+  if (++NumWorkers >= MaxThreads) {
+    --NumWorkers;
+    return;
+  }
+  Workers.push_back(std::thread([this] { run(); }));
+}
+
+void ModulePrebuilder::wait(StringRef ModuleName) {
+  std::unique_lock<std::mutex> Guard(Mutex);
+  for (auto I = Pending.begin(), E = Pending.end(); I != E; ++I)
+    if ((*I)->ModuleName == ModuleName) {
+      Pending.erase(I);
+      return;
+    }
+  while (Building.count(ModuleName))
+    BuildDone.wait(Guard);
+}
+
+void ModulePrebuilder::run() {
+  std::unique_lock<std::mutex> Guard(Mutex);
+  while (!Pending.empty()) {
+    std::unique_ptr<Request> R = std::move(Pending.front());
+    Pending.pop_front();
+    Building.insert(R->ModuleName);
+    Guard.unlock();
+
+    build(*R);
+
+    Guard.lock();
+    Building.erase(R->ModuleName);
+    BuildDone.notify_all();
+  }
+  --NumWorkers;
+}
+
+void ModulePrebuilder::build(Request &R) {
+  llvm::sys::fs::create_directories(
+      llvm::sys::path::parent_path(R.ModuleFileName));
+
+  // Leave modules that somebody else is building to them, and don't redo one
+  // that was finished while we were waiting for our turn.
+  llvm::LockFileManager Locked(R.ModuleFileName);
+  if (Locked != llvm::LockFileManager::LFS_Owned ||
+      llvm::sys::fs::exists(R.ModuleFileName))
+    return;
+
+  // Unlike compileModuleImpl, the instance gets a file manager of its own,
+  // since the one of the importing instance is not thread-safe.
+  CompilerInstance Instance(R.MP, /*BuildingModule=*/true);
+  Instance.setInvocation(&*R.Invocation);
+  Instance.createDiagnostics(new IgnoringDiagConsumer, /*ShouldOwnClient=*/true);
+  Instance.setVirtualFileSystem(R.VFS);
+  Instance.createFileManager();
+  Instance.createSourceManager(Instance.getFileManager());
+
+  // The import locations live in the source manager of the importing
+  // instance, so only keep the names for detecting cycles.
+  SourceManager &SourceMgr = Instance.getSourceManager();
+  for (const std::string &Name : R.BuildStack)
+    SourceMgr.pushModuleBuildStack(Name, FullSourceLoc());
+  SourceMgr.pushModuleBuildStack(R.ModuleName, FullSourceLoc());
+
+  if (!R.InferredModuleMap.empty()) {
+    const FileEntry *ModuleMapFile = Instance.getFileManager().getVirtualFile(
+        R.ModuleMapFileName, R.InferredModuleMap.size(), 0);
+    SourceMgr.overrideFileContents(
+        ModuleMapFile, llvm::MemoryBuffer::getMemBuffer(R.InferredModuleMap));
+  }
+
+  const FileEntry *ModuleMapForUniquing = nullptr;
+  if (!R.ModuleMapFileForUniquing.empty())
+    ModuleMapForUniquing =
+        Instance.getFileManager().getFile(R.ModuleMapFileForUniquing);
+  GenerateModuleAction CreateModuleAction(ModuleMapForUniquing, R.IsSystem);
+
+  const unsigned ThreadStackSize = 8 << 20;
+  llvm::CrashRecoveryContext CRC;
+  CRC.RunSafelyOnThread([&]() { Instance.ExecuteAction(CreateModuleAction); },
+                        ThreadStackSize);
+  Instance.clearOutputFiles(/*EraseFiles=*/true);
+}
+
 CompilerInstance::CompilerInstance(SharedModuleProvider MP, bool BuildingModule)
   : ModuleLoader(MP, BuildingModule),
-    Invocation(new CompilerInvocation()), ModuleManager(nullptr),
+    Invocation(new CompilerInvocation()), DirectoryCache(nullptr),
+    ModuleManager(nullptr),
     BuildGlobalModuleIndex(false), HaveFullGlobalModuleIndex(false),
     ModuleBuildFailed(false) {
 }
@@ -67,10 +238,11 @@ void CompilerInstance::setInvocation(CompilerInvocation *Value) {
 }
 
 bool CompilerInstance::shouldBuildGlobalModuleIndex() const {
+  // The global module index lives in the module cache.
   return (BuildGlobalModuleIndex ||
           (ModuleManager && ModuleManager->isGlobalIndexUnavailable() &&
            getFrontendOpts().GenerateGlobalModuleIndex)) &&
-         !ModuleBuildFailed;
+         !ModuleBuildFailed && getLangOpts().ImplicitModules;
 }
 
 void CompilerInstance::setDiagnostics(DiagnosticsEngine *Value) {
@@ -83,6 +255,7 @@ void CompilerInstance::setTarget(TargetInfo *Value) {
 
 void CompilerInstance::setFileManager(FileManager *Value) {
   FileMgr = Value;
+  DirectoryCache = nullptr;
   if (Value)
     VirtualFileSystem = Value->getVirtualFileSystem();
   else
@@ -95,6 +268,10 @@ void CompilerInstance::setSourceManager(SourceManager *Value) {
 
 void CompilerInstance::setPreprocessor(Preprocessor *Value) { PP = Value; }
 
+void CompilerInstance::setConditionalSkipCache(ConditionalSkipCache *Cache) {
+  SkipCache = Cache;
+}
+
 void CompilerInstance::setASTContext(ASTContext *Value) { Context = Value; }
 
 void CompilerInstance::setSema(Sema *S) {
@@ -226,6 +403,21 @@ void CompilerInstance::createFileManager() {
     setVirtualFileSystem(vfs::getRealFileSystem());
   }
   FileMgr = new FileManager(getFileSystemOpts(), VirtualFileSystem);
+  DirectoryCache = nullptr;
+
+  // The unique IDs of the files of a virtual file system overlay are not
+  // stable across processes, so it can't share the listings.
+  const FileSystemOptions &FSOpts = getFileSystemOpts();
+  if (!FSOpts.DirectoryCacheFile.empty() &&
+      getHeaderSearchOpts().VFSOverlayFiles.empty()) {
+    std::unique_ptr<DirectoryListingStatCache> Cache(
+        new DirectoryListingStatCache(FSOpts.DirectoryCacheFile));
+    // Modules are built into the module cache during the compile.
+    if (!getHeaderSearchOpts().ModuleCachePath.empty())
+      Cache->addVolatileDirectory(getHeaderSearchOpts().ModuleCachePath);
+    DirectoryCache = Cache.get();
+    FileMgr->addStatCache(std::move(Cache));
+  }
 }
 
 // Source Manager
@@ -313,6 +505,14 @@ void CompilerInstance::createPreprocessor(TranslationUnitKind TUKind) {
     PP->setPTHManager(PTHMgr);
   }
 
+  // The cached headers report no diagnostics from their lexing, which would
+  // break the checking of the expected ones.
+  if (!PPOpts.PTHCachePath.empty() && !getDiagnosticOpts().VerifyDiagnostics)
+    PP->setPTHCache(createPTHCache(*PP, PPOpts.PTHCachePath));
+
+  if (SkipCache)
+    PP->setConditionalSkipCache(SkipCache);
+
   if (PPOpts.DetailedRecord)
     PP->createPreprocessingRecord();
 
@@ -384,6 +584,9 @@ void CompilerInstance::createASTContext() {
   Context = new ASTContext(getLangOpts(), PP.getSourceManager(),
                            PP.getIdentifierTable(), PP.getSelectorTable(),
                            PP.getBuiltinInfo());
+  if (unsigned SlabSize = getFrontendOpts().ASTSlabSize)
+    Context->getAllocator().setMinSlabSize(SlabSize);
+  Context->getAllocator().setUseHugePages(getFrontendOpts().ASTHugePages);
   Context->InitBuiltinTypes(getTarget());
 }
 
@@ -793,8 +996,10 @@ bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
   if (getFrontendOpts().ShowTimers)
     createFrontendTimer();
 
-  if (getFrontendOpts().ShowStats)
-    llvm::EnableStatistics();
+  // -print-stats prints LLVM's statistics at exit too, -stats-file only wants
+  // them collected.
+  if (getFrontendOpts().ShowStats || !getFrontendOpts().StatsFile.empty())
+    llvm::EnableStatistics(getFrontendOpts().ShowStats);
 
   for (unsigned i = 0, e = getFrontendOpts().Inputs.size(); i != e; ++i) {
     // Reset the ID tables if we are reusing the SourceManager and parsing
@@ -808,6 +1013,9 @@ bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
     }
   }
 
+  // Finish the module builds that are still running in the background.
+  Prebuilder.reset();
+
   // Notify the diagnostic client that all files were processed.
   getDiagnostics().getClient()->finish();
 
@@ -827,11 +1035,26 @@ bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
       OS << " generated.\n";
   }
 
+  // Share the directory listings with the next compiles.
+  if (DirectoryCache)
+    DirectoryCache->save();
+
   if (getFrontendOpts().ShowStats && hasFileManager()) {
     getFileManager().PrintStats();
     OS << "\n";
   }
 
+  StringRef StatsFile = getFrontendOpts().StatsFile;
+  if (!StatsFile.empty()) {
+    std::error_code EC;
+    llvm::raw_fd_ostream StatS(StatsFile, EC, llvm::sys::fs::F_Text);
+    if (EC)
+      getDiagnostics().Report(diag::err_fe_unable_to_open_output)
+          << StatsFile << EC.message();
+    else
+      llvm::PrintStatisticsJSON(StatS);
+  }
+
   return !getDiagnostics().getClient()->getNumErrors();
 }
 
@@ -847,16 +1070,11 @@ static InputKind getSourceInputKindFromOptions(const LangOptions &LangOpts) {
   return LangOpts.CPlusPlus? IK_CXX : IK_C;
 }
 
-/// \brief Compile a module file for the given module, using the options 
-/// provided by the importing compiler instance. Returns true if the module
-/// was built without errors.
-static bool compileModuleImpl(CompilerInstance &ImportingInstance,
-                              SourceLocation ImportLoc,
-                              Module *Module,
-                              StringRef ModuleFileName) {
-  ModuleMap &ModMap 
-    = ImportingInstance.getPreprocessor().getHeaderSearchInfo().getModuleMap();
-    
+/// \brief Create the invocation that builds the given module, based on the
+/// options of the importing compiler instance. The caller provides the input.
+static IntrusiveRefCntPtr<CompilerInvocation>
+createModuleInvocation(CompilerInstance &ImportingInstance, Module *Module,
+                       StringRef ModuleFileName) {
   // Construct a compiler invocation for creating this module.
   IntrusiveRefCntPtr<CompilerInvocation> Invocation
     (new CompilerInvocation(ImportingInstance.getInvocation()));
@@ -882,6 +1100,37 @@ static bool compileModuleImpl(CompilerInstance &ImportingInstance,
   // Note the name of the module we're building.
   Invocation->getLangOpts()->CurrentModule = Module->getTopLevelModuleName();
 
+  // Set up the outputs; the inputs are the module map of the module, which
+  // the caller adds.
+  FrontendOptions &FrontendOpts = Invocation->getFrontendOpts();
+  FrontendOpts.OutputFile = ModuleFileName.str();
+  FrontendOpts.DisableFree = false;
+  FrontendOpts.GenerateGlobalModuleIndex = false;
+  FrontendOpts.Inputs.clear();
+
+  // Don't free the remapped file buffers; they are owned by our caller.
+  PPOpts.RetainRemappedFileBuffers = true;
+    
+  Invocation->getDiagnosticOpts().VerifyDiagnostics = 0;
+  assert(ImportingInstance.getInvocation().getModuleHash() ==
+         Invocation->getModuleHash() && "Module hash mismatch!");
+  return Invocation;
+}
+
+/// \brief Compile a module file for the given module, using the options 
+/// provided by the importing compiler instance. Returns true if the module
+/// was built without errors.
+static bool compileModuleImpl(CompilerInstance &ImportingInstance,
+                              SourceLocation ImportLoc,
+                              Module *Module,
+                              StringRef ModuleFileName) {
+  ModuleMap &ModMap 
+    = ImportingInstance.getPreprocessor().getHeaderSearchInfo().getModuleMap();
+    
+  IntrusiveRefCntPtr<CompilerInvocation> Invocation =
+      createModuleInvocation(ImportingInstance, Module, ModuleFileName);
+  PreprocessorOptions &PPOpts = Invocation->getPreprocessorOpts();
+
   // Make sure that the failed-module structure has been allocated in
   // the importing instance, and propagate the pointer to the newly-created
   // instance.
@@ -892,22 +1141,10 @@ static bool compileModuleImpl(CompilerInstance &ImportingInstance,
   PPOpts.FailedModules = ImportingPPOpts.FailedModules;
 
   // If there is a module map file, build the module using the module map.
-  // Set up the inputs/outputs so that we build the module from its umbrella
-  // header.
+  // Set up the inputs so that we build the module from its umbrella header.
   FrontendOptions &FrontendOpts = Invocation->getFrontendOpts();
-  FrontendOpts.OutputFile = ModuleFileName.str();
-  FrontendOpts.DisableFree = false;
-  FrontendOpts.GenerateGlobalModuleIndex = false;
-  FrontendOpts.Inputs.clear();
   InputKind IK = getSourceInputKindFromOptions(*Invocation->getLangOpts());
 
-  // Don't free the remapped file buffers; they are owned by our caller.
-  PPOpts.RetainRemappedFileBuffers = true;
-    
-  Invocation->getDiagnosticOpts().VerifyDiagnostics = 0;
-  assert(ImportingInstance.getInvocation().getModuleHash() ==
-         Invocation->getModuleHash() && "Module hash mismatch!");
-  
   // Construct a compiler instance that will be used to actually create the
   // module.
   CompilerInstance Instance(ImportingInstance.getSharedModuleProvider(),
@@ -1066,6 +1303,198 @@ static bool compileAndLoadModule(CompilerInstance &ImportingInstance,
   }
 }
 
+/// \brief Scan the given files for the modules they import, following the
+/// headers that are not part of another module.
+///
+/// This is a quick approximation of what the preprocessor will import: it
+/// only looks at the spelling of the inclusion and import directives, so it
+/// also reports the imports of conditional blocks that are skipped.
+static void collectImportedModules(CompilerInstance &CI,
+                                   SmallVectorImpl<const FileEntry *> &Files,
+                                   const Module *Current,
+                                   llvm::SetVector<Module *> &Imports) {
+  HeaderSearch &HS = CI.getPreprocessor().getHeaderSearchInfo();
+  SourceManager &SourceMgr = CI.getSourceManager();
+  llvm::SmallPtrSet<const FileEntry *, 32> Visited(Files.begin(), Files.end());
+
+  auto addImport = [&](Module *M) {
+    M = M->getTopLevelModule();
+    if (M != Current)
+      Imports.insert(M);
+  };
+
+  while (!Files.empty()) {
+    const FileEntry *File = Files.pop_back_val();
+    bool Invalid = false;
+    llvm::MemoryBuffer *Buffer =
+        SourceMgr.getMemoryBufferForFile(File, &Invalid);
+    if (Invalid)
+      continue;
+
+    Lexer RawLex(SourceLocation(), CI.getLangOpts(), Buffer->getBufferStart(),
+                 Buffer->getBufferStart(), Buffer->getBufferEnd());
+    Token Tok;
+    do {
+      RawLex.LexFromRawLexer(Tok);
+
+      // '@import' names the module directly.
+      if (Tok.is(tok::at)) {
+        RawLex.LexFromRawLexer(Tok);
+        if (Tok.is(tok::raw_identifier) && Tok.getRawIdentifier() == "import") {
+          RawLex.LexFromRawLexer(Tok);
+          if (Tok.is(tok::raw_identifier))
+            if (Module *M = HS.lookupModule(Tok.getRawIdentifier(),
+                                            /*AllowSearch=*/false))
+              addImport(M);
+        }
+        continue;
+      }
+
+      if (Tok.isNot(tok::hash) || !Tok.isAtStartOfLine())
+        continue;
+      RawLex.LexFromRawLexer(Tok);
+      if (Tok.isNot(tok::raw_identifier))
+        continue;
+      StringRef Directive = Tok.getRawIdentifier();
+      if (Directive != "include" && Directive != "import" &&
+          Directive != "include_next")
+        continue;
+
+      // Find the header name on the rest of the line; the raw lexer does not
+      // know about <header-name> tokens.
+      const char *Ptr = Directive.end(), *End = Buffer->getBufferEnd();
+      while (Ptr != End && (*Ptr == ' ' || *Ptr == '\t'))
+        ++Ptr;
+      if (Ptr == End || (*Ptr != '<' && *Ptr != '"'))
+        continue;
+      bool IsAngled = *Ptr == '<';
+      const char *NameEnd = Ptr + 1;
+      while (NameEnd != End && *NameEnd != (IsAngled ? '>' : '"') &&
+             *NameEnd != '\n')
+        ++NameEnd;
+      if (NameEnd == End || *NameEnd == '\n')
+        continue;
+      StringRef Name(Ptr + 1, NameEnd - Ptr - 1);
+
+      const DirectoryLookup *CurDir;
+      ModuleMap::KnownHeader Suggested;
+      std::pair<const FileEntry *, const DirectoryEntry *> Includer(
+          File, File->getDir());
+      const FileEntry *Header =
+          HS.LookupFile(Name, SourceLocation(), IsAngled, /*FromDir=*/nullptr,
+                        CurDir, Includer, /*SearchPath=*/nullptr,
+                        /*RelativePath=*/nullptr, &Suggested);
+      if (!Header)
+        continue;
+      if (!Suggested)
+        Suggested = HS.findModuleForHeader(Header);
+      if (Suggested && !(Suggested.getRole() & ModuleMap::TextualHeader) &&
+          Suggested.getModule()->getTopLevelModule() != Current) {
+        addImport(Suggested.getModule());
+        continue;
+      }
+      if (Visited.insert(Header).second)
+        Files.push_back(Header);
+    } while (Tok.isNot(tok::eof));
+  }
+}
+
+/// \brief Start building, on worker threads, the modules that the given
+/// instance is about to import and that are missing from the module cache.
+static void prebuildImportedModules(CompilerInstance &CI,
+                                    ModulePrebuilder &Prebuilder,
+                                    Module *Building) {
+  HeaderSearch &HS = CI.getPreprocessor().getHeaderSearchInfo();
+  ModuleMap &ModMap = HS.getModuleMap();
+  SourceManager &SourceMgr = CI.getSourceManager();
+
+  // Scan what this instance compiles: the headers of the module it builds,
+  // or the main source file.
+  SmallVector<const FileEntry *, 16> Files;
+  Module *Current = nullptr;
+  if (!CI.getLangOpts().CurrentModule.empty())
+    Current = HS.lookupModule(CI.getLangOpts().CurrentModule,
+                              /*AllowSearch=*/false);
+  if (Current) {
+    SmallVector<Module *, 16> Stack(1, Current);
+    while (!Stack.empty()) {
+      Module *M = Stack.pop_back_val();
+      if (const FileEntry *Umbrella = M->getUmbrellaHeader())
+        Files.push_back(Umbrella);
+      for (unsigned Kind = 0; Kind != Module::HK_Excluded; ++Kind)
+        for (const Module::Header &H : M->Headers[Kind])
+          Files.push_back(H.Entry);
+      Stack.append(M->submodule_begin(), M->submodule_end());
+    }
+  } else if (const FileEntry *MainFile =
+                 SourceMgr.getFileEntryForID(SourceMgr.getMainFileID())) {
+    Files.push_back(MainFile);
+  }
+
+  llvm::SetVector<Module *> Imports;
+  collectImportedModules(CI, Files, Current, Imports);
+
+  ModuleBuildStack BuildStack = SourceMgr.getModuleBuildStack();
+  for (Module *M : Imports) {
+    if (M == Building || !M->isAvailable() || M->getASTFile())
+      continue;
+    if (std::any_of(BuildStack.begin(), BuildStack.end(),
+                    [&](const std::pair<std::string, FullSourceLoc> &Entry) {
+          return Entry.first == M->Name;
+        }))
+      continue;
+
+    // Modules that are present but out of date are rebuilt by the import.
+    std::string ModuleFileName = HS.getModuleFileName(M);
+    if (llvm::sys::fs::exists(ModuleFileName))
+      continue;
+
+    std::unique_ptr<ModulePrebuilder::Request> R(
+        new ModulePrebuilder::Request(CI.getSharedModuleProvider()));
+    R->Invocation = createModuleInvocation(CI, M, ModuleFileName);
+    R->Invocation->getPreprocessorOpts().FailedModules =
+        new PreprocessorOptions::FailedModulesSet;
+    R->VFS = &CI.getVirtualFileSystem();
+    for (const auto &Entry : BuildStack)
+      R->BuildStack.push_back(Entry.first);
+    if (!CI.getLangOpts().CurrentModule.empty())
+      R->BuildStack.push_back(CI.getLangOpts().CurrentModule);
+    R->ModuleName = M->Name;
+    R->ModuleFileName = ModuleFileName;
+    if (const FileEntry *ModuleMapFile = ModMap.getContainingModuleMapFile(M)) {
+      R->ModuleMapFileName = ModuleMapFile->getName();
+    } else {
+      llvm::raw_string_ostream OS(R->InferredModuleMap);
+      M->print(OS);
+      OS.flush();
+      R->ModuleMapFileName = "__inferred_module.map";
+    }
+    if (const FileEntry *ModuleMapFile = ModMap.getModuleMapFileForUniquing(M))
+      R->ModuleMapFileForUniquing = ModuleMapFile->getName();
+    R->IsSystem = M->IsSystem;
+    R->Invocation->getFrontendOpts().Inputs.push_back(FrontendInputFile(
+        R->ModuleMapFileName,
+        getSourceInputKindFromOptions(*R->Invocation->getLangOpts())));
+
+    CI.getDiagnostics().Report(diag::remark_module_prebuild)
+        << M->Name << ModuleFileName;
+    Prebuilder.add(std::move(R));
+
+    if (CI.getFrontendOpts().GenerateGlobalModuleIndex)
+      CI.setBuildGlobalModuleIndex(true);
+  }
+}
+
+void CompilerInstance::startModulePrebuilds(Module *Building) {
+  // Collecting the module dependencies for a crash reproducer relies on all
+  // the module builds sharing the collector, so don't build any in the
+  // background then.
+  unsigned MaxThreads = getHeaderSearchOpts().ModulesBuildThreads;
+  Prebuilder.reset(new ModulePrebuilder(MaxThreads));
+  if (MaxThreads > 1 && llvm::llvm_is_multithreaded() && !ModuleDepCollector)
+    prebuildImportedModules(*this, *Prebuilder, Building);
+}
+
 /// \brief Diagnose differences between the current definition of the given
 /// configuration macro and the definition provided on the command line.
 static void checkConfigMacro(Preprocessor &PP, StringRef ConfigMacro,
@@ -1244,6 +1673,7 @@ void CompilerInstance::createModuleManager() {
     // If we're not recursively building a module, check whether we
     // need to prune the module cache.
     if (getSourceManager().getModuleBuildStack().empty() &&
+        getLangOpts().ImplicitModules &&
         getHeaderSearchOpts().ModuleCachePruneInterval > 0 &&
         getHeaderSearchOpts().ModuleCachePruneAfter > 0) {
       pruneModuleCache(getHeaderSearchOpts());
@@ -1259,7 +1689,8 @@ void CompilerInstance::createModuleManager() {
                                   /*AllowASTWithCompilerErrors=*/false,
                                   /*AllowConfigurationMismatch=*/false,
                                   HSOpts.ModulesValidateSystemHeaders,
-                                  getFrontendOpts().UseGlobalModuleIndex);
+                                  getFrontendOpts().UseGlobalModuleIndex &&
+                                      getLangOpts().ImplicitModules);
     if (hasASTConsumer()) {
       ModuleManager->setDeserializationListener(
         getASTConsumer().GetASTDeserializationListener());
@@ -1381,6 +1812,15 @@ CompilerInstance::loadModule(SourceLocation ImportLoc,
     auto Override = ModuleFileOverrides.find(ModuleName);
     bool Explicit = Override != ModuleFileOverrides.end();
 
+    // Without implicit modules, only the module files we were given are used;
+    // the module cache is neither read nor written.
+    if (!Explicit && !getLangOpts().ImplicitModules) {
+      getDiagnostics().Report(ModuleNameLoc, diag::err_module_build_disabled)
+          << ModuleName;
+      ModuleBuildFailed = true;
+      return ModuleLoadResult();
+    }
+
     std::string ModuleFileName =
         Explicit ? Override->second
                  : PP->getHeaderSearchInfo().getModuleFileName(Module);
@@ -1398,6 +1838,10 @@ CompilerInstance::loadModule(SourceLocation ImportLoc,
     for (auto &Listener : DependencyCollectors)
       Listener->attachToASTReader(*ModuleManager);
 
+    // If the module is being built in the background, wait for it.
+    if (Prebuilder && !Explicit)
+      Prebuilder->wait(ModuleName);
+
     // Try to load the module file.
     unsigned ARRFlags =
         Explicit ? 0 : ASTReader::ARR_OutOfDate | ASTReader::ARR_Missing;
@@ -1451,6 +1895,11 @@ CompilerInstance::loadModule(SourceLocation ImportLoc,
         return ModuleLoadResult();
       }
 
+      // Before building this module, start building the other modules we're
+      // going to import in the background.
+      if (!Prebuilder)
+        startModulePrebuilds(Module);
+
       // Try to compile and then load the module.
       if (!compileAndLoadModule(*this, ImportLoc, ModuleNameLoc, Module,
                                 ModuleFileName)) {
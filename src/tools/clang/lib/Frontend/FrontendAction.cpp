@@ -464,6 +464,9 @@ void FrontendAction::EndSourceFile() {
   // Finalize the action.
   EndSourceFileAction();
 
+  if (CI.getFrontendOpts().ShowASTMemory && CI.hasASTContext())
+    CI.getASTContext().PrintAllocationStats(llvm::errs());
+
   // Sema references the ast consumer, so reset sema first.
   //
   // FIXME: There is more per-file stuff we could just drop here?
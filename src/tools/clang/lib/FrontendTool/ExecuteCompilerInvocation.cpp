@@ -21,7 +21,9 @@
 #include "clang/Frontend/FrontendActions.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/FrontendPluginRegistry.h"
+#include "clang/Frontend/MultiplexConsumer.h"
 #include "clang/Frontend/Utils.h"
+#include "clang/Index/IndexStore.h"
 #include "clang/Rewrite/Frontend/FrontendActions.h"
 #include "clang/StaticAnalyzer/Frontend/FrontendActions.h"
 #include "llvm/Option/OptTable.h"
@@ -113,6 +115,32 @@ static FrontendAction *CreateFrontendBaseAction(CompilerInstance &CI) {
 #endif
 }
 
+namespace {
+/// \brief Records the symbol occurrences of the wrapped action's input into
+/// the index store given by -index-store-path.
+class IndexStoreAction : public WrapperFrontendAction {
+protected:
+  std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &CI,
+                                                 StringRef InFile) override {
+    std::unique_ptr<ASTConsumer> Consumer =
+        WrapperFrontendAction::CreateASTConsumer(CI, InFile);
+    if (!Consumer)
+      return nullptr;
+
+    std::vector<std::unique_ptr<ASTConsumer>> Consumers;
+    Consumers.push_back(std::move(Consumer));
+    Consumers.push_back(index::createIndexStoreConsumer(
+        CI.getFrontendOpts().IndexStorePath, InFile,
+        CI.getFrontendOpts().OutputFile, CI.getInvocation().getModuleHash()));
+    return llvm::make_unique<MultiplexConsumer>(std::move(Consumers));
+  }
+
+public:
+  explicit IndexStoreAction(FrontendAction *WrappedAction)
+    : WrapperFrontendAction(WrappedAction) {}
+};
+}
+
 static FrontendAction *CreateFrontendAction(CompilerInstance &CI) {
   // Create the underlying action.
   FrontendAction *Act = CreateFrontendBaseAction(CI);
@@ -158,6 +186,9 @@ static FrontendAction *CreateFrontendAction(CompilerInstance &CI) {
   if (!FEOpts.ASTMergeFiles.empty())
     Act = new ASTMergeAction(Act, FEOpts.ASTMergeFiles);
 
+  if (!FEOpts.IndexStorePath.empty())
+    Act = new IndexStoreAction(Act);
+
   return Act;
 }
 
@@ -0,0 +1,578 @@
+//===--- IndexStore.cpp - Persistent USR-based symbol index ---------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Index/IndexStore.h"
+#include "clang/AST/ASTConsumer.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclObjC.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Frontend/FrontendDiagnostic.h"
+#include "clang/Index/USRGeneration.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/OnDiskHashTable.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+using namespace clang::index;
+
+/// \brief The signature at the start of every record file.
+static const char RecordMagic[4] = { 'I', 'D', 'X', 'R' };
+
+/// \brief The version of the record and unit file formats.
+static const unsigned IndexStoreVersion = 1;
+
+namespace {
+
+/// \brief A symbol occurrence as stored in a record, whose file is implied.
+struct StoredOccurrence {
+  unsigned Roles;
+  unsigned Line;
+  unsigned Column;
+};
+
+/// \brief Trait used to write the USR table of a record file.
+class RecordWriterTrait {
+public:
+  typedef StringRef key_type;
+  typedef StringRef key_type_ref;
+  typedef ArrayRef<StoredOccurrence> data_type;
+  typedef ArrayRef<StoredOccurrence> data_type_ref;
+  typedef unsigned hash_value_type;
+  typedef unsigned offset_type;
+
+  static hash_value_type ComputeHash(key_type_ref Key) {
+    return llvm::HashString(Key);
+  }
+
+  std::pair<unsigned,unsigned>
+  EmitKeyDataLength(raw_ostream& Out, key_type_ref Key, data_type_ref Data) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    unsigned KeyLen = Key.size();
+    unsigned DataLen = Data.size() * 12;
+    LE.write<uint16_t>(KeyLen);
+    LE.write<uint32_t>(DataLen);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  void EmitKey(raw_ostream& Out, key_type_ref Key, unsigned KeyLen) {
+    Out.write(Key.data(), KeyLen);
+  }
+
+  void EmitData(raw_ostream& Out, key_type_ref Key, data_type_ref Data,
+                unsigned DataLen) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    for (const StoredOccurrence &Occ : Data) {
+      LE.write<uint32_t>(Occ.Roles);
+      LE.write<uint32_t>(Occ.Line);
+      LE.write<uint32_t>(Occ.Column);
+    }
+  }
+};
+
+/// \brief Trait used to read the USR table of a record file.
+class RecordReaderTrait {
+public:
+  typedef StringRef external_key_type;
+  typedef StringRef internal_key_type;
+  typedef SmallVector<StoredOccurrence, 4> data_type;
+  typedef unsigned hash_value_type;
+  typedef unsigned offset_type;
+
+  static bool EqualKey(const internal_key_type& a, const internal_key_type& b) {
+    return a == b;
+  }
+
+  static hash_value_type ComputeHash(const internal_key_type& a) {
+    return llvm::HashString(a);
+  }
+
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char*& d) {
+    using namespace llvm::support;
+    unsigned KeyLen = endian::readNext<uint16_t, little, unaligned>(d);
+    unsigned DataLen = endian::readNext<uint32_t, little, unaligned>(d);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static const internal_key_type&
+  GetInternalKey(const external_key_type& x) { return x; }
+
+  static const external_key_type&
+  GetExternalKey(const internal_key_type& x) { return x; }
+
+  static internal_key_type ReadKey(const unsigned char* d, unsigned n) {
+    return StringRef((const char *)d, n);
+  }
+
+  static data_type ReadData(const internal_key_type& k,
+                            const unsigned char* d,
+                            unsigned DataLen) {
+    using namespace llvm::support;
+
+    data_type Result;
+    while (DataLen >= 12) {
+      StoredOccurrence Occ;
+      Occ.Roles = endian::readNext<uint32_t, little, unaligned>(d);
+      Occ.Line = endian::readNext<uint32_t, little, unaligned>(d);
+      Occ.Column = endian::readNext<uint32_t, little, unaligned>(d);
+      Result.push_back(Occ);
+      DataLen -= 12;
+    }
+
+    return Result;
+  }
+};
+
+typedef llvm::OnDiskChainedHashTable<RecordReaderTrait> RecordTable;
+
+/// \brief The occurrences of one source file, to be written as its record.
+struct FileRecord {
+  std::string Name;
+  std::string FilePath;
+
+  /// \brief Whether the record is already in the store, in which case the
+  /// occurrences of the file are not collected again.
+  bool Exists;
+
+  llvm::StringMap<SmallVector<StoredOccurrence, 4>> Occurrences;
+};
+
+/// \brief Collects the symbol occurrences of a translation unit and writes
+/// them to an index store when the translation unit is complete.
+class IndexStoreConsumer : public ASTConsumer,
+                           public RecursiveASTVisitor<IndexStoreConsumer> {
+  std::string StorePath;
+  std::string MainFile;
+  std::string OutputFile;
+  std::string ContextHash;
+
+  ASTContext *Ctx;
+  std::vector<Decl *> TopLevelDecls;
+
+  std::vector<std::unique_ptr<FileRecord>> Records;
+  llvm::DenseMap<const FileEntry *, FileRecord *> RecordsByFile;
+  llvm::DenseMap<const Decl *, std::string> USRs;
+
+public:
+  IndexStoreConsumer(StringRef StorePath, StringRef MainFile,
+                     StringRef OutputFile, StringRef ContextHash)
+    : StorePath(StorePath), MainFile(MainFile), OutputFile(OutputFile),
+      ContextHash(ContextHash), Ctx(nullptr) { }
+
+  // ASTConsumer implementation.
+
+  void Initialize(ASTContext &Context) override { Ctx = &Context; }
+
+  bool HandleTopLevelDecl(DeclGroupRef DG) override {
+    TopLevelDecls.insert(TopLevelDecls.end(), DG.begin(), DG.end());
+    return true;
+  }
+
+  void HandleTopLevelDeclInObjCContainer(DeclGroupRef DG) override {
+    TopLevelDecls.insert(TopLevelDecls.end(), DG.begin(), DG.end());
+  }
+
+  /// \brief Declarations loaded from AST files were indexed when those
+  /// files were built.
+  void HandleInterestingDecl(DeclGroupRef DG) override {}
+
+  void HandleTranslationUnit(ASTContext &Context) override;
+
+  // RecursiveASTVisitor implementation.
+
+  bool VisitNamedDecl(NamedDecl *D) {
+    if (D->isImplicit())
+      return true;
+    unsigned Roles = SymbolRole_Declaration;
+    if (isDefinition(D))
+      Roles |= SymbolRole_Definition;
+    addOccurrence(D, D->getLocation(), Roles);
+    return true;
+  }
+
+  bool VisitDeclRefExpr(DeclRefExpr *E) {
+    addOccurrence(E->getDecl(), E->getLocation(), SymbolRole_Reference);
+    return true;
+  }
+
+  bool VisitMemberExpr(MemberExpr *E) {
+    addOccurrence(E->getMemberDecl(), E->getMemberLoc(), SymbolRole_Reference);
+    return true;
+  }
+
+  bool VisitObjCMessageExpr(ObjCMessageExpr *E) {
+    addOccurrence(E->getMethodDecl(), E->getSelectorStartLoc(),
+                  SymbolRole_Reference);
+    return true;
+  }
+
+  bool VisitObjCIvarRefExpr(ObjCIvarRefExpr *E) {
+    addOccurrence(E->getDecl(), E->getLocation(), SymbolRole_Reference);
+    return true;
+  }
+
+  bool VisitObjCPropertyRefExpr(ObjCPropertyRefExpr *E) {
+    if (E->isExplicitProperty())
+      addOccurrence(E->getExplicitProperty(), E->getLocation(),
+                    SymbolRole_Reference);
+    return true;
+  }
+
+  bool VisitTagTypeLoc(TagTypeLoc TL) {
+    addOccurrence(TL.getDecl(), TL.getNameLoc(), SymbolRole_Reference);
+    return true;
+  }
+
+  bool VisitTypedefTypeLoc(TypedefTypeLoc TL) {
+    addOccurrence(TL.getTypedefNameDecl(), TL.getNameLoc(),
+                  SymbolRole_Reference);
+    return true;
+  }
+
+  bool VisitObjCInterfaceTypeLoc(ObjCInterfaceTypeLoc TL) {
+    addOccurrence(TL.getIFaceDecl(), TL.getNameLoc(), SymbolRole_Reference);
+    return true;
+  }
+
+  bool VisitTemplateSpecializationTypeLoc(TemplateSpecializationTypeLoc TL) {
+    TemplateName Name = TL.getTypePtr()->getTemplateName();
+    addOccurrence(Name.getAsTemplateDecl(), TL.getTemplateNameLoc(),
+                  SymbolRole_Reference);
+    return true;
+  }
+
+private:
+  static bool isDefinition(const NamedDecl *D);
+
+  void addOccurrence(const NamedDecl *D, SourceLocation Loc, unsigned Roles);
+  FileRecord *getRecord(FileID FID);
+  StringRef getUSR(const NamedDecl *D);
+
+  bool writeRecord(const FileRecord &Record, StringRef Path,
+                   std::string &Error);
+  bool writeUnit(StringRef Path, std::string &Error);
+};
+
+} // end anonymous namespace
+
+/// \brief Write \p Contents to \p Path through a temporary file, so that
+/// readers never see a partially written file.
+static bool writeFileAtomically(StringRef Path, StringRef Contents,
+                                std::string &Error) {
+  SmallString<128> TmpPath;
+  int TmpFD;
+  if (std::error_code EC =
+          llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%", TmpFD, TmpPath)) {
+    Error = EC.message();
+    return true;
+  }
+
+  {
+    llvm::raw_fd_ostream Out(TmpFD, /*shouldClose=*/true);
+    Out << Contents;
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      llvm::sys::fs::remove(TmpPath.str());
+      Error = "error writing file";
+      return true;
+    }
+  }
+
+  if (std::error_code EC = llvm::sys::fs::rename(TmpPath.str(), Path)) {
+    llvm::sys::fs::remove(TmpPath.str());
+    Error = EC.message();
+    return true;
+  }
+  return false;
+}
+
+bool IndexStoreConsumer::isDefinition(const NamedDecl *D) {
+  if (const FunctionDecl *FD = dyn_cast<FunctionDecl>(D))
+    return FD->isThisDeclarationADefinition();
+  if (const VarDecl *VD = dyn_cast<VarDecl>(D))
+    return VD->isThisDeclarationADefinition() == VarDecl::Definition;
+  if (const TagDecl *TD = dyn_cast<TagDecl>(D))
+    return TD->isThisDeclarationADefinition();
+  if (const ObjCMethodDecl *MD = dyn_cast<ObjCMethodDecl>(D))
+    return MD->isThisDeclarationADefinition();
+  if (const ObjCInterfaceDecl *ID = dyn_cast<ObjCInterfaceDecl>(D))
+    return ID->isThisDeclarationADefinition();
+  if (const ObjCProtocolDecl *PD = dyn_cast<ObjCProtocolDecl>(D))
+    return PD->isThisDeclarationADefinition();
+  return isa<ObjCImplDecl>(D);
+}
+
+void IndexStoreConsumer::addOccurrence(const NamedDecl *D, SourceLocation Loc,
+                                       unsigned Roles) {
+  if (!D || Loc.isInvalid())
+    return;
+  // Function-local symbols are of no interest outside of their function.
+  if (isa<ParmVarDecl>(D) || D->getParentFunctionOrMethod())
+    return;
+
+  SourceManager &SM = Ctx->getSourceManager();
+  FileID FID;
+  unsigned Offset;
+  std::tie(FID, Offset) = SM.getDecomposedLoc(SM.getFileLoc(Loc));
+  FileRecord *Record = getRecord(FID);
+  if (!Record || Record->Exists)
+    return;
+
+  StringRef USR = getUSR(D);
+  if (USR.empty())
+    return;
+
+  StoredOccurrence Occ = { Roles, SM.getLineNumber(FID, Offset),
+                           SM.getColumnNumber(FID, Offset) };
+  Record->Occurrences[USR].push_back(Occ);
+}
+
+FileRecord *IndexStoreConsumer::getRecord(FileID FID) {
+  SourceManager &SM = Ctx->getSourceManager();
+  const FileEntry *FE = SM.getFileEntryForID(FID);
+  if (!FE)
+    return nullptr;
+
+  FileRecord *&Record = RecordsByFile[FE];
+  if (Record)
+    return Record;
+
+  // Name the record after the file contents and the compiler configuration,
+  // so that an unchanged file compiled the same way maps to the same record.
+  bool Invalid = false;
+  StringRef Contents = SM.getBufferData(FID, &Invalid);
+  if (Invalid)
+    return nullptr;
+
+  llvm::MD5 Hash;
+  Hash.update(Contents);
+  Hash.update(ContextHash);
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> HashStr;
+  llvm::MD5::stringifyResult(Result, HashStr);
+
+  Records.push_back(llvm::make_unique<FileRecord>());
+  Record = Records.back().get();
+  Record->Name = (llvm::sys::path::filename(FE->getName()) + "-" +
+                  HashStr.str()).str();
+  Record->FilePath = FE->getName();
+
+  SmallString<128> Path(StorePath);
+  llvm::sys::path::append(Path, "records", Record->Name);
+  Record->Exists = llvm::sys::fs::exists(Path.str());
+  return Record;
+}
+
+StringRef IndexStoreConsumer::getUSR(const NamedDecl *D) {
+  auto Known = USRs.find(D);
+  if (Known != USRs.end())
+    return Known->second;
+
+  SmallString<128> Buf;
+  std::string &USR = USRs[D];
+  if (!generateUSRForDecl(D, Buf))
+    USR = Buf.str();
+  return USR;
+}
+
+bool IndexStoreConsumer::writeRecord(const FileRecord &Record, StringRef Path,
+                                     std::string &Error) {
+  llvm::OnDiskChainedHashTableGenerator<RecordWriterTrait> Generator;
+  for (auto &Entry : Record.Occurrences)
+    Generator.insert(Entry.getKey(), Entry.getValue());
+
+  SmallString<4096> Buffer;
+  uint32_t BucketOffset;
+  {
+    using namespace llvm::support;
+    llvm::raw_svector_ostream Out(Buffer);
+    Out.write(RecordMagic, sizeof(RecordMagic));
+    endian::Writer<little>(Out).write<uint32_t>(IndexStoreVersion);
+    // Leave room for the offset of the bucket table.
+    endian::Writer<little>(Out).write<uint32_t>(0);
+    BucketOffset = Generator.Emit(Out);
+  }
+  llvm::support::endian::write<uint32_t, llvm::support::little,
+                               llvm::support::unaligned>(Buffer.data() + 8,
+                                                         BucketOffset);
+
+  return writeFileAtomically(Path, Buffer.str(), Error);
+}
+
+bool IndexStoreConsumer::writeUnit(StringRef Path, std::string &Error) {
+  std::string Contents;
+  llvm::raw_string_ostream Out(Contents);
+  Out << "index-unit " << IndexStoreVersion << '\n';
+  Out << "main " << MainFile << '\n';
+  for (const auto &Record : Records)
+    Out << "record " << Record->Name << ' ' << Record->FilePath << '\n';
+  return writeFileAtomically(Path, Out.str(), Error);
+}
+
+void IndexStoreConsumer::HandleTranslationUnit(ASTContext &Context) {
+  for (Decl *D : TopLevelDecls)
+    TraverseDecl(D);
+
+  DiagnosticsEngine &Diags = Context.getDiagnostics();
+  SmallString<128> RecordsDir(StorePath), UnitsDir(StorePath);
+  llvm::sys::path::append(RecordsDir, "records");
+  llvm::sys::path::append(UnitsDir, "units");
+  for (StringRef Dir : { RecordsDir.str(), UnitsDir.str() }) {
+    if (std::error_code EC = llvm::sys::fs::create_directories(Dir)) {
+      Diags.Report(diag::err_fe_index_store_write) << Dir << EC.message();
+      return;
+    }
+  }
+
+  std::string Error;
+  for (const auto &Record : Records) {
+    if (Record->Exists)
+      continue;
+    SmallString<128> Path(RecordsDir);
+    llvm::sys::path::append(Path, Record->Name);
+    if (writeRecord(*Record, Path, Error)) {
+      Diags.Report(diag::err_fe_index_store_write) << Path << Error;
+      return;
+    }
+  }
+
+  // The unit is identified by its main and output files; compiling it again
+  // replaces the previous unit.
+  llvm::MD5 Hash;
+  Hash.update(MainFile);
+  Hash.update(OutputFile);
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> UnitName;
+  llvm::MD5::stringifyResult(Result, UnitName);
+
+  SmallString<128> Path(UnitsDir);
+  llvm::sys::path::append(Path, (llvm::sys::path::filename(MainFile) + "-" +
+                                 UnitName.str()).str());
+  if (writeUnit(Path, Error))
+    Diags.Report(diag::err_fe_index_store_write) << Path << Error;
+}
+
+std::unique_ptr<ASTConsumer>
+index::createIndexStoreConsumer(StringRef StorePath, StringRef MainFile,
+                                StringRef OutputFile, StringRef ContextHash) {
+  return llvm::make_unique<IndexStoreConsumer>(StorePath, MainFile, OutputFile,
+                                               ContextHash);
+}
+
+//===----------------------------------------------------------------------===//
+// IndexStoreReader
+//===----------------------------------------------------------------------===//
+
+IndexStoreReader::~IndexStoreReader() { }
+
+std::unique_ptr<IndexStoreReader>
+IndexStoreReader::open(StringRef StorePath, std::string &Error) {
+  std::unique_ptr<IndexStoreReader> Reader(new IndexStoreReader(StorePath));
+
+  SmallString<128> UnitsDir(StorePath);
+  llvm::sys::path::append(UnitsDir, "units");
+  std::error_code EC;
+  for (llvm::sys::fs::directory_iterator Unit(UnitsDir.str(), EC), End;
+       Unit != End && !EC; Unit.increment(EC)) {
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+        llvm::MemoryBuffer::getFile(Unit->path());
+    if (!Buffer)
+      continue;
+
+    // Units of another version of the format are ignored, along with the
+    // records they reference.
+    SmallVector<StringRef, 32> Lines;
+    (*Buffer)->getBuffer().split(Lines, "\n", -1, /*KeepEmpty=*/false);
+    if (Lines.empty() ||
+        Lines[0] != ("index-unit " + Twine(IndexStoreVersion)).str())
+      continue;
+
+    for (StringRef Line : Lines) {
+      if (!Line.startswith("record "))
+        continue;
+      std::pair<StringRef, StringRef> NameAndPath =
+          Line.substr(strlen("record ")).split(' ');
+      Reader->RecordFiles[NameAndPath.first] = NameAndPath.second;
+    }
+  }
+
+  if (EC) {
+    Error = EC.message();
+    return nullptr;
+  }
+  return Reader;
+}
+
+const llvm::MemoryBuffer *
+IndexStoreReader::getRecordBuffer(StringRef RecordName) {
+  std::unique_ptr<llvm::MemoryBuffer> &Buffer = RecordBuffers[RecordName];
+  if (Buffer)
+    return Buffer.get();
+
+  SmallString<128> Path(StorePath);
+  llvm::sys::path::append(Path, "records", RecordName);
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> File =
+      llvm::MemoryBuffer::getFile(Path.str(), /*FileSize=*/-1,
+                                  /*RequiresNullTerminator=*/false);
+  if (!File || (*File)->getBufferSize() < 12 ||
+      memcmp((*File)->getBufferStart(), RecordMagic, sizeof(RecordMagic)))
+    return nullptr;
+
+  using namespace llvm::support;
+  const unsigned char *Start =
+      reinterpret_cast<const unsigned char *>((*File)->getBufferStart());
+  if (endian::read<uint32_t, little, unaligned>(Start + 4) !=
+          IndexStoreVersion ||
+      endian::read<uint32_t, little, unaligned>(Start + 8) >=
+          (*File)->getBufferSize())
+    return nullptr;
+
+  Buffer = std::move(*File);
+  return Buffer.get();
+}
+
+void IndexStoreReader::findOccurrences(StringRef USR,
+                 llvm::function_ref<void(const SymbolOccurrence &)> Receiver) {
+  for (auto &Entry : RecordFiles) {
+    const llvm::MemoryBuffer *Buffer = getRecordBuffer(Entry.getKey());
+    if (!Buffer)
+      continue;
+
+    const unsigned char *Base =
+        reinterpret_cast<const unsigned char *>(Buffer->getBufferStart());
+    using namespace llvm::support;
+    uint32_t BucketOffset = endian::read<uint32_t, little, unaligned>(Base + 8);
+    std::unique_ptr<RecordTable> Table(
+        RecordTable::Create(Base + BucketOffset, Base));
+
+    RecordTable::iterator Known = Table->find(USR);
+    if (Known == Table->end())
+      continue;
+
+    for (const StoredOccurrence &Occ : *Known) {
+      SymbolOccurrence Result = { Entry.getValue(), Occ.Roles, Occ.Line,
+                                  Occ.Column };
+      Receiver(Result);
+    }
+  }
+}
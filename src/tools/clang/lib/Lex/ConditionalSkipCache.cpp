@@ -0,0 +1,59 @@
+//===--- ConditionalSkipCache.cpp - Extents of excluded blocks ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the ConditionalSkipCache class, which remembers where
+//  the excluded conditional blocks of the files end.
+//
+//===----------------------------------------------------------------------===//
+#include "clang/Lex/ConditionalSkipCache.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/LangOptions.h"
+#include "llvm/ADT/Hashing.h"
+
+using namespace clang;
+
+size_t ConditionalSkipCache::getLangOptionsKey(const LangOptions &LangOpts) {
+  // Many options affect how the text is split into tokens (digraphs, raw
+  // string literals, digit separators...); rather than tracking them, hash all
+  // of them.
+  using llvm::hash_combine;
+  llvm::hash_code code = 0;
+#define LANGOPT(Name, Bits, Default, Description) \
+  code = hash_combine(code, LangOpts.Name);
+#define ENUM_LANGOPT(Name, Type, Bits, Default, Description) \
+  code = hash_combine(code, static_cast<unsigned>(LangOpts.get##Name()));
+#include "clang/Basic/LangOptions.def"
+  return code;
+}
+
+ConditionalSkipCache::FileBlocks &
+ConditionalSkipCache::getFileBlocks(const FileEntry *File, size_t LangKey,
+                                    uint64_t Size) {
+  FileBlocks &Blocks = Files[std::make_pair(File->getUniqueID(), LangKey)];
+  if (Blocks.ModTime != File->getModificationTime() || Blocks.Size != Size) {
+    Blocks.ModTime = File->getModificationTime();
+    Blocks.Size = Size;
+    Blocks.Ends.clear();
+  }
+  return Blocks;
+}
+
+unsigned ConditionalSkipCache::getBlockEnd(const FileEntry *File,
+                                           size_t LangKey, uint64_t Size,
+                                           unsigned Offset) {
+  FileBlocks &Blocks = getFileBlocks(File, LangKey, Size);
+  auto Known = Blocks.Ends.find(Offset);
+  return Known == Blocks.Ends.end() ? 0 : Known->second;
+}
+
+void ConditionalSkipCache::addBlock(const FileEntry *File, size_t LangKey,
+                                    uint64_t Size, unsigned Offset,
+                                    unsigned End) {
+  getFileBlocks(File, LangKey, Size).Ends[Offset] = End;
+}
@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Lex/HeaderSearch.h"
+#include "clang/Basic/CharInfo.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/IdentifierTable.h"
 #include "clang/Lex/HeaderMap.h"
@@ -61,6 +62,7 @@ HeaderSearch::HeaderSearch(IntrusiveRefCntPtr<HeaderSearchOptions> HSOpts,
   NumIncluded = 0;
   NumMultiIncludeFileOptzn = 0;
   NumFrameworkLookups = NumSubFrameworkLookups = 0;
+  NumListedMisses = 0;
 }
 
 HeaderSearch::~HeaderSearch() {
@@ -89,6 +91,8 @@ void HeaderSearch::PrintStats() {
 
   fprintf(stderr, "%d framework lookups.\n", NumFrameworkLookups);
   fprintf(stderr, "%d subframework lookups.\n", NumSubFrameworkLookups);
+  fprintf(stderr, "%d lookups answered by directory listings.\n",
+          NumListedMisses);
 }
 
 /// CreateHeaderMap - This method returns a HeaderMap for the specified
@@ -268,6 +272,22 @@ getFileAndSuggestModule(HeaderSearch &HS, StringRef FileName,
   return HS.getFileMgr().getFile(FileName, /*openFile=*/true);
 }
 
+/// \brief Compute the name \p Name is listed under by
+/// HeaderSearch::mayContainEntry(), or return false if lookups of \p Name
+/// can't be answered from the listings.
+static bool getListedName(StringRef Name, SmallVectorImpl<char> &LowerName) {
+  if (Name.empty() || Name == "." || Name == "..")
+    return false;
+  LowerName.clear();
+  for (char C : Name) {
+    // Non-ASCII names may be normalized differently by the file system.
+    if (!isASCII(C))
+      return false;
+    LowerName.push_back(toLowercase(C));
+  }
+  return true;
+}
+
 /// LookupFile - Lookup the specified file in this search path, returning it
 /// if it exists or returning null if not.
 const FileEntry *DirectoryLookup::LookupFile(
@@ -297,6 +317,13 @@ const FileEntry *DirectoryLookup::LookupFile(
       RelativePath->append(Filename.begin(), Filename.end());
     }
 
+    // Don't look up the files this directory can't contain, but still load
+    // the module maps such a lookup would.
+    if (!HS.mayContainEntry(getDir(), *llvm::sys::path::begin(Filename))) {
+      HS.hasModuleMap(TmpDir.str(), getDir(), isSystemHeaderDirectory());
+      return nullptr;
+    }
+
     return getFileAndSuggestModule(HS, TmpDir.str(), getDir(),
                                    isSystemHeaderDirectory(),
                                    SuggestedModule);
@@ -343,6 +370,41 @@ const FileEntry *DirectoryLookup::LookupFile(
   return Result;
 }
 
+bool HeaderSearch::mayContainEntry(const DirectoryEntry *Dir, StringRef Name) {
+  // The virtual files aren't listed by the file system.
+  if (FileMgr.hasVirtualFiles())
+    return true;
+
+  SmallString<64> LowerName;
+  if (!getListedName(Name, LowerName))
+    return true;
+
+  DirectoryEntryNames &Entries = SearchDirEntries[Dir];
+  if (!Entries.Listed) {
+    SmallString<256> DirPath(Dir->getName());
+    FileMgr.FixupRelativePath(DirPath);
+
+    std::error_code EC;
+    SmallString<64> EntryName;
+    vfs::FileSystem &FS = *FileMgr.getVirtualFileSystem();
+    for (vfs::directory_iterator I = FS.dir_begin(DirPath.str(), EC), E;
+         I != E && !EC; I.increment(EC))
+      if (getListedName(llvm::sys::path::filename(I->getName()), EntryName))
+        Entries.Names.insert(EntryName);
+
+    // If the directory can't be listed, look up every file.
+    Entries.Listed = true;
+    Entries.Complete = !EC;
+    if (EC)
+      Entries.Names.clear();
+  }
+
+  if (!Entries.Complete || Entries.Names.count(LowerName))
+    return true;
+  ++NumListedMisses;
+  return false;
+}
+
 /// \brief Given a framework directory, find the top-most framework directory.
 ///
 /// \param FileMgr The file manager to use for directory lookups.
@@ -438,6 +500,9 @@ const FileEntry *DirectoryLookup::DoFrameworkLookup(
     HS.IncrementFrameworkLookupCount();
 
     // If the framework dir doesn't exist, we fail.
+    if (!HS.mayContainEntry(getFrameworkDir(),
+                            (ModuleName + ".framework").str()))
+      return nullptr;
     const DirectoryEntry *Dir = FileMgr.getDirectory(FrameworkName.str());
     if (!Dir) return nullptr;
 
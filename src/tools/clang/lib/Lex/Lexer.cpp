@@ -26,6 +26,12 @@
 #include "llvm/Support/ConvertUTF.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif __ALTIVEC__
+#include <altivec.h>
+#undef bool
+#endif
 using namespace clang;
 
 //===----------------------------------------------------------------------===//
@@ -1474,9 +1480,112 @@ bool Lexer::tryConsumeIdentifierUTF8Char(const char *&CurPtr) {
   return true;
 }
 
+//===----------------------------------------------------------------------===//
+// Vectorized scanning of runs of simple characters.
+//===----------------------------------------------------------------------===//
+//
+// These skip over the simple characters the lexer loops below would
+// otherwise consume one by one, sixteen at a time, and leave the end of the
+// run and the rest of the buffer to the loops. They never read past
+// BufferEnd, so don't rely on the nul terminator of the buffer. Without
+// SSE2, they don't skip anything.
+
+#ifdef __SSE2__
+/// Return the mask of the bytes of \p Chars which are equal to \p C.
+static inline unsigned getCharMask(__m128i Chars, char C) {
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(Chars, _mm_set1_epi8(C)));
+}
+
+/// Return the mask of the bytes of \p Chars which are in [\p Lo, \p Hi].
+/// Non-ASCII bytes are negative, and never in the range.
+static inline __m128i getRangeMask(__m128i Chars, char Lo, char Hi) {
+  return _mm_and_si128(_mm_cmpgt_epi8(Chars, _mm_set1_epi8(Lo - 1)),
+                       _mm_cmplt_epi8(Chars, _mm_set1_epi8(Hi + 1)));
+}
+
+/// Skip the sixteen byte blocks of \p CurPtr where \p GetStopMask finds no
+/// character to stop at, and return the first character to stop at.
+template <typename StopMaskFn>
+static inline const char *skipSimpleChars(const char *CurPtr,
+                                          const char *BufferEnd,
+                                          StopMaskFn GetStopMask) {
+  while (CurPtr + 16 <= BufferEnd) {
+    __m128i Chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(CurPtr));
+    if (unsigned Mask = GetStopMask(Chars))
+      return CurPtr + llvm::countTrailingZeros(Mask);
+    CurPtr += 16;
+  }
+  return CurPtr;
+}
+#endif
+
+/// Skip over the [_A-Za-z0-9] characters starting at \p CurPtr.
+static inline const char *skipIdentifierBody(const char *CurPtr,
+                                             const char *BufferEnd) {
+#ifdef __SSE2__
+  return skipSimpleChars(CurPtr, BufferEnd, [](__m128i Chars) -> unsigned {
+    // Setting the 0x20 bit maps the uppercase letters to the lowercase ones,
+    // and nothing else to a letter.
+    __m128i Letters =
+        getRangeMask(_mm_or_si128(Chars, _mm_set1_epi8(0x20)), 'a', 'z');
+    __m128i Digits = getRangeMask(Chars, '0', '9');
+    __m128i Underscores = _mm_cmpeq_epi8(Chars, _mm_set1_epi8('_'));
+    return ~_mm_movemask_epi8(
+               _mm_or_si128(Letters, _mm_or_si128(Digits, Underscores))) &
+           0xFFFF;
+  });
+#else
+  return CurPtr;
+#endif
+}
+
+/// Skip over the horizontal whitespace starting at \p CurPtr.
+static inline const char *skipHorizontalWhitespace(const char *CurPtr,
+                                                   const char *BufferEnd) {
+#ifdef __SSE2__
+  return skipSimpleChars(CurPtr, BufferEnd, [](__m128i Chars) -> unsigned {
+    return ~(getCharMask(Chars, ' ') | getCharMask(Chars, '\t') |
+             getCharMask(Chars, '\f') | getCharMask(Chars, '\v')) &
+           0xFFFF;
+  });
+#else
+  return CurPtr;
+#endif
+}
+
+/// Skip over the characters of a line comment starting at \p CurPtr, up to
+/// its first newline or nul character.
+static inline const char *skipLineCommentChars(const char *CurPtr,
+                                               const char *BufferEnd) {
+#ifdef __SSE2__
+  return skipSimpleChars(CurPtr, BufferEnd, [](__m128i Chars) -> unsigned {
+    return getCharMask(Chars, '\n') | getCharMask(Chars, '\r') |
+           getCharMask(Chars, '\0');
+  });
+#else
+  return CurPtr;
+#endif
+}
+
+/// Skip over the characters of a string literal starting at \p CurPtr which
+/// are the same in translation phases 1 and 3 and don't end the literal.
+static inline const char *skipStringLiteralChars(const char *CurPtr,
+                                                 const char *BufferEnd) {
+#ifdef __SSE2__
+  return skipSimpleChars(CurPtr, BufferEnd, [](__m128i Chars) -> unsigned {
+    return getCharMask(Chars, '"') | getCharMask(Chars, '\\') |
+           getCharMask(Chars, '?') | getCharMask(Chars, '\n') |
+           getCharMask(Chars, '\r') | getCharMask(Chars, '\0');
+  });
+#else
+  return CurPtr;
+#endif
+}
+
 bool Lexer::LexIdentifier(Token &Result, const char *CurPtr) {
   // Match [_A-Za-z0-9]*, we have already matched [_A-Za-z$]
   unsigned Size;
+  CurPtr = skipIdentifierBody(CurPtr, BufferEnd);
   unsigned char C = *CurPtr++;
   while (isIdentifierBody(C))
     C = *CurPtr++;
@@ -1753,6 +1862,7 @@ bool Lexer::LexStringLiteral(Token &Result, const char *CurPtr,
 
       NulCharacter = CurPtr-1;
     }
+    CurPtr = skipStringLiteralChars(CurPtr, BufferEnd);
     C = getAndAdvanceChar(CurPtr, Result);
   }
 
@@ -1968,6 +2078,10 @@ bool Lexer::SkipWhitespace(Token &Result, const char *CurPtr,
   // Skip consecutive spaces efficiently.
   while (1) {
     // Skip horizontal whitespace very aggressively.
+    if (isHorizontalWhitespace(Char)) {
+      CurPtr = skipHorizontalWhitespace(CurPtr, BufferEnd);
+      Char = *CurPtr;
+    }
     while (isHorizontalWhitespace(Char))
       Char = *++CurPtr;
 
@@ -2034,6 +2148,7 @@ bool Lexer::SkipLineComment(Token &Result, const char *CurPtr,
   // them.  As such, optimize for this case with the inner loop.
   char C;
   do {
+    CurPtr = skipLineCommentChars(CurPtr, BufferEnd);
     C = *CurPtr;
     // Skip over characters in the fast loop.
     while (C != 0 &&                // Potentially EOF.
@@ -2239,13 +2354,6 @@ static bool isEndOfBlockCommentWithEscapedNewLine(const char *CurPtr,
   return true;
 }
 
-#ifdef __SSE2__
-#include <emmintrin.h>
-#elif __ALTIVEC__
-#include <altivec.h>
-#undef bool
-#endif
-
 /// We have just read from input the / and * characters that started a comment.
 /// Read until we find the * and / characters that terminate the comment.
 /// Note that we don't bother decoding trigraphs or escaped newlines in block
@@ -27,6 +27,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/SaveAndRestore.h"
+#include "llvm/Support/TimeProfiler.h"
 using namespace clang;
 
 //===----------------------------------------------------------------------===//
@@ -307,11 +308,37 @@ void Preprocessor::SkipExcludedConditionalBlock(SourceLocation IfTokenLoc,
     return;
   }
 
+  // The blocks closed by the next \#elif, \#else or \#endif at this level only
+  // depend on the text of the file, jump over the ones skipped before. Code
+  // completion needs their tokens.
+  const FileEntry *SkipFile = nullptr;
+  uint64_t SkipFileSize = CurLexer->getBuffer().size();
+  if (SkipCache && !isCodeCompletionEnabled()) {
+    SkipFile = CurLexer->getFileEntry();
+    if (SkipFile && SourceMgr.isFileOverridden(SkipFile))
+      SkipFile = nullptr;
+  }
+  unsigned SkipDepth = CurPPLexer->getConditionalStackDepth();
+  bool AtBlockStart = true, RecordBlock = false;
+  unsigned BlockStart = 0;
+
   // Enter raw mode to disable identifier lookup (and thus macro expansion),
   // disabling warnings, etc.
   CurPPLexer->LexingRawMode = true;
   Token Tok;
   while (1) {
+    if (AtBlockStart && SkipFile) {
+      BlockStart = CurLexer->getCurrentBufferOffset();
+      RecordBlock = true;
+      if (unsigned BlockEnd = SkipCache->getBlockEnd(
+              SkipFile, SkipCacheLangKey, SkipFileSize, BlockStart)) {
+        CurLexer->seekToStartOfLine(BlockEnd);
+        RecordBlock = false;
+        ++NumSkippedFromCache;
+      }
+    }
+    AtBlockStart = false;
+
     CurLexer->Lex(Tok);
 
     if (Tok.is(tok::code_completion)) {
@@ -339,6 +366,7 @@ void Preprocessor::SkipExcludedConditionalBlock(SourceLocation IfTokenLoc,
     // If this token is not a preprocessor directive, just skip it.
     if (Tok.isNot(tok::hash) || !Tok.isAtStartOfLine())
       continue;
+    unsigned HashOffset = CurLexer->getCurrentBufferOffset() - Tok.getLength();
 
     // We just parsed a # character at the start of a line, so we're in
     // directive mode.  Tell the lexer this so any newlines we see will be
@@ -395,6 +423,15 @@ void Preprocessor::SkipExcludedConditionalBlock(SourceLocation IfTokenLoc,
       Directive = StringRef(DirectiveBuf, IdLen);
     }
 
+    // A directive of this level closes the block skipped so far; record where,
+    // unless the block issued diagnostics.
+    bool ClosesBlock = CurPPLexer->getConditionalStackDepth() == SkipDepth &&
+                       (Directive == "endif" || Directive == "else" ||
+                        Directive == "elif");
+    if (ClosesBlock && RecordBlock)
+      SkipCache->addBlock(SkipFile, SkipCacheLangKey, SkipFileSize,
+                          BlockStart, HashOffset);
+
     if (Directive.startswith("if")) {
       StringRef Sub = Directive.substr(2);
       if (Sub.empty() ||   // "if"
@@ -436,7 +473,10 @@ void Preprocessor::SkipExcludedConditionalBlock(SourceLocation IfTokenLoc,
         PPConditionalInfo &CondInfo = CurPPLexer->peekConditionalLevel();
 
         // If this is a #else with a #else before it, report the error.
-        if (CondInfo.FoundElse) Diag(Tok, diag::pp_err_else_after_else);
+        if (CondInfo.FoundElse) {
+          Diag(Tok, diag::pp_err_else_after_else);
+          RecordBlock = false;
+        }
 
         // Note that we've seen a #else in this conditional.
         CondInfo.FoundElse = true;
@@ -460,7 +500,10 @@ void Preprocessor::SkipExcludedConditionalBlock(SourceLocation IfTokenLoc,
         PPConditionalInfo &CondInfo = CurPPLexer->peekConditionalLevel();
 
         // If this is a #elif with a #else before it, report the error.
-        if (CondInfo.FoundElse) Diag(Tok, diag::pp_err_elif_after_else);
+        if (CondInfo.FoundElse) {
+          Diag(Tok, diag::pp_err_elif_after_else);
+          RecordBlock = false;
+        }
 
         // If this is in a skipping block or if we're already handled this #if
         // block, don't bother parsing the condition.
@@ -490,6 +533,10 @@ void Preprocessor::SkipExcludedConditionalBlock(SourceLocation IfTokenLoc,
       }
     }
 
+    // Skipping goes on after a directive of this level, with a new block.
+    if (ClosesBlock)
+      AtBlockStart = true;
+
     CurPPLexer->ParsingPreprocessorDirective = false;
     // Restore comment saving mode.
     if (CurLexer) CurLexer->resetExtendedTokenMode();
@@ -616,6 +663,8 @@ const FileEntry *Preprocessor::LookupFile(
     SmallVectorImpl<char> *RelativePath,
     ModuleMap::KnownHeader *SuggestedModule,
     bool SkipCache) {
+  llvm::TimeTraceScope TimeScope("LookupFile", [&]() { return Filename; });
+
   // If the header lookup mechanism may be relative to the current inclusion
   // stack, record the parent #includes.
   SmallVector<std::pair<const FileEntry *, const DirectoryEntry *>, 16>
@@ -1219,17 +1268,31 @@ void Preprocessor::HandleDigitDirective(Token &DigitTok) {
 ///
 void Preprocessor::HandleUserDiagnosticDirective(Token &Tok,
                                                  bool isWarning) {
-  // PTH doesn't emit #warning or #error directives.
-  if (CurPTHLexer)
-    return CurPTHLexer->DiscardToEndOfLine();
-
   // Read the rest of the line raw.  We do this because we don't want macros
   // to be expanded and we don't require that the tokens be valid preprocessing
   // tokens.  For example, this is allowed: "#warning `   'foo".  GCC does
   // collapse multiple consequtive white space between tokens, but this isn't
   // specified by the standard.
   SmallString<128> Message;
-  CurLexer->ReadToEndOfLine(&Message);
+  if (CurLexer) {
+    CurLexer->ReadToEndOfLine(&Message);
+  } else {
+    // PTH doesn't store the message, read it from the source of the
+    // directive.
+    std::pair<FileID, unsigned> LocInfo =
+        SourceMgr.getDecomposedLoc(Tok.getLocation());
+    bool Invalid = false;
+    StringRef Buffer = SourceMgr.getBufferData(LocInfo.first, &Invalid);
+    CurPTHLexer->DiscardToEndOfLine();
+    if (Invalid)
+      return;
+    Lexer RawLex(SourceMgr.getLocForStartOfFile(LocInfo.first), LangOpts,
+                 Buffer.begin(),
+                 Buffer.begin() + LocInfo.second + Tok.getLength(),
+                 Buffer.end());
+    RawLex.setParsingPreprocessorDirective(true);
+    RawLex.ReadToEndOfLine(&Message);
+  }
 
   // Find the first non-whitespace character, so that we can make the
   // diagnostic more succinct.
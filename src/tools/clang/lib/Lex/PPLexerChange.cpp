@@ -94,6 +94,15 @@ bool Preprocessor::EnterSourceFile(FileID FID, const DirectoryLookup *CurDir,
     return true;
   }
 
+  // The cached tokens have no comments, and no code completion point.
+  if (HeaderPTHCache && FID != SourceMgr.getMainFileID() &&
+      !isCodeCompletionEnabled() && !getCommentRetentionState()) {
+    if (PTHLexer *PL = HeaderPTHCache->CreateLexer(FID)) {
+      EnterSourceFileWithPTH(PL, CurDir);
+      return false;
+    }
+  }
+
   if (isCodeCompletionEnabled() &&
       SourceMgr.getFileEntryForID(FID) == CodeCompletionFile) {
     CodeCompletionFileLoc = SourceMgr.getLocForStartOfFile(FID);
@@ -525,14 +534,13 @@ bool Preprocessor::HandleEndOfTokenLexer(Token &Result) {
       MacroExpandingLexersStack.back().first == CurTokenLexer.get())
     removeCachedMacroExpandedTokensOfLastLexer();
 
-  // Delete or cache the now-dead macro expander.
-  if (NumCachedTokenLexers == TokenLexerCacheSize)
-    CurTokenLexer.reset();
-  else
-    TokenLexerCache[NumCachedTokenLexers++] = std::move(CurTokenLexer);
+  // Pop the now-dead macro expander off the stack, like HandleEndOfFile does
+  // with a #include'd file; none of its other work applies to macros.
+  RemoveTopOfLexerStack();
 
-  // Handle this like a #include file being popped off the stack.
-  return HandleEndOfFile(Result, true);
+  // Propagate info about start-of-line/leading white-space/etc.
+  PropagateLineStartLeadingSpaceInfo(Result);
+  return false;
 }
 
 /// RemoveTopOfLexerStack - Pop the current lexer/macro exp off the top of the
@@ -422,7 +422,8 @@ PTHManager::PTHManager(
     : Buf(std::move(buf)), PerIDCache(std::move(perIDCache)),
       FileLookup(std::move(fileLookup)), IdDataTable(idDataTable),
       StringIdLookup(std::move(stringIdLookup)), NumIds(numIds), PP(nullptr),
-      SpellingBase(spellingBase), OriginalSourceFile(originalSourceFile) {}
+      SpellingBase(spellingBase), OriginalSourceFile(originalSourceFile),
+      UsePreprocessorIdentifiers(false) {}
 
 PTHManager::~PTHManager() {
 }
@@ -566,6 +567,13 @@ IdentifierInfo* PTHManager::LazilyCreateIdentifierInfo(unsigned PersistentID) {
       endian::readNext<uint32_t, little, aligned>(TableEntry);
   assert(IDData < (const unsigned char*)Buf->getBufferEnd());
 
+  if (UsePreprocessorIdentifiers) {
+    assert(PP && "No preprocessor set yet!");
+    IdentifierInfo *II = PP->getIdentifierInfo((const char *)IDData);
+    PerIDCache[PersistentID] = II;
+    return II;
+  }
+
   // Allocate the object.
   std::pair<IdentifierInfo,const unsigned char*> *Mem =
     Alloc.Allocate<std::pair<IdentifierInfo,const unsigned char*> >();
@@ -623,6 +631,8 @@ PTHLexer *PTHManager::CreateLexer(FileID FID) {
   return new PTHLexer(*PP, FID, data, ppcond, *this);
 }
 
+PTHCache::~PTHCache() {}
+
 //===----------------------------------------------------------------------===//
 // 'stat' caching.
 //===----------------------------------------------------------------------===//
@@ -65,7 +65,7 @@ Preprocessor::Preprocessor(IntrusiveRefCntPtr<PreprocessorOptions> PPOpts,
       FileMgr(Headers.getFileMgr()), SourceMgr(SM),
       ScratchBuf(new ScratchBuffer(SourceMgr)),HeaderInfo(Headers),
       TheModuleLoader(TheModuleLoader), ExternalSource(nullptr),
-      Identifiers(opts, IILookup),
+      SkipCache(new ConditionalSkipCache()), Identifiers(opts, IILookup),
       PragmaHandlers(new PragmaNamespace(StringRef())),
       IncrementalProcessing(false), TUKind(TUKind),
       CodeComplete(nullptr), CodeCompletionFile(nullptr),
@@ -76,6 +76,7 @@ Preprocessor::Preprocessor(IntrusiveRefCntPtr<PreprocessorOptions> PPOpts,
       Callbacks(nullptr), MacroArgCache(nullptr), Record(nullptr),
       MIChainHead(nullptr), DeserialMIChainHead(nullptr) {
   OwnsHeaderSearch = OwnsHeaders;
+  SkipCacheLangKey = ConditionalSkipCache::getLangOptionsKey(LangOpts);
   
   CounterValue = 0; // __COUNTER__ starts at 0.
   
@@ -86,7 +87,7 @@ Preprocessor::Preprocessor(IntrusiveRefCntPtr<PreprocessorOptions> PPOpts,
   NumMacroExpanded = NumFnMacroExpanded = NumBuiltinMacroExpanded = 0;
   NumFastMacroExpanded = NumTokenPaste = NumFastTokenPaste = 0;
   MaxIncludeStackDepth = 0;
-  NumSkipped = 0;
+  NumSkipped = NumSkippedFromCache = 0;
   
   // Default to discarding comments.
   KeepComments = false;
@@ -251,7 +252,8 @@ void Preprocessor::PrintStats() {
   llvm::errs() << "  " << NumElse << " #else/#elif.\n";
   llvm::errs() << "  " << NumEndif << " #endif.\n";
   llvm::errs() << "  " << NumPragma << " #pragma.\n";
-  llvm::errs() << NumSkipped << " #if/#ifndef#ifdef regions skipped\n";
+  llvm::errs() << NumSkipped << " #if/#ifndef#ifdef regions skipped, "
+               << NumSkippedFromCache << " blocks jumped over.\n";
 
   llvm::errs() << NumMacroExpanded << "/" << NumFnMacroExpanded << "/"
              << NumBuiltinMacroExpanded << " obj/fn/builtin macros expanded, "
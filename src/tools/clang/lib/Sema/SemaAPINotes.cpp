@@ -273,12 +273,8 @@ void Sema::ProcessAPINotes(Decl *D) {
     // Location function that looks up an Objective-C context.
     auto GetContext = [&](api_notes::APINotesReader *Reader)
                         -> Optional<api_notes::ContextID> {
-      if (auto Protocol = dyn_cast<ObjCProtocolDecl>(ObjCContainer)) {
-        if (auto Found = Reader->lookupObjCProtocol(Protocol->getName()))
-          return Found->first;
-
-        return None;
-      }
+      if (auto Protocol = dyn_cast<ObjCProtocolDecl>(ObjCContainer))
+        return Reader->lookupObjCProtocolID(Protocol->getName());
 
       if (auto Impl = dyn_cast<ObjCCategoryImplDecl>(ObjCContainer)) {
         if (auto Cat = Impl->getCategoryDecl())
@@ -301,13 +297,8 @@ void Sema::ProcessAPINotes(Decl *D) {
           return None;
       }
 
-      if (auto Class = dyn_cast<ObjCInterfaceDecl>(ObjCContainer)) {
-        if (auto Found = Reader->lookupObjCClass(Class->getName()))
-          return Found->first;
-
-        return None;
-
-      }
+      if (auto Class = dyn_cast<ObjCInterfaceDecl>(ObjCContainer))
+        return Reader->lookupObjCClassID(Class->getName());
 
       return None;
     };
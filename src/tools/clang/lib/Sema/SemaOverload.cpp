@@ -32,6 +32,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/TimeProfiler.h"
 #include <algorithm>
 #include <cstdlib>
 
@@ -5549,6 +5550,40 @@ static bool IsAcceptableNonMemberOperatorCandidate(ASTContext &Context,
   return false;
 }
 
+/// \brief Determine whether no specialization of the function template
+/// \p FunctionTemplate can be an acceptable non-member overloaded operator
+/// for a call with the arguments \p Args, so that template argument
+/// deduction can be skipped.
+///
+/// This is the check performed by IsAcceptableNonMemberOperatorCandidate,
+/// restricted to what is known before deduction: a parameter whose type is
+/// not dependent has the same type in every specialization.
+static bool IsUnacceptableNonMemberOperatorTemplate(
+    ASTContext &Context, FunctionTemplateDecl *FunctionTemplate,
+    ArrayRef<Expr *> Args) {
+  FunctionDecl *Fn = FunctionTemplate->getTemplatedDecl();
+  if (isa<CXXMethodDecl>(Fn))
+    return false;
+
+  // A function parameter pack can expand to any number of parameters.
+  for (const ParmVarDecl *Param : Fn->params())
+    if (Param->isParameterPack())
+      return false;
+
+  for (unsigned I = 0, N = std::min<size_t>(Args.size(), 2); I != N; ++I) {
+    QualType T = Args[I]->getType();
+    if (T->isDependentType() || T->isRecordType())
+      return false;
+    if (!T->isEnumeralType() || I >= Fn->getNumParams())
+      continue;
+    QualType ParamType = Fn->getParamDecl(I)->getType().getNonReferenceType();
+    if (ParamType->isDependentType() ||
+        Context.hasSameUnqualifiedType(T, ParamType))
+      return false;
+  }
+  return true;
+}
+
 /// AddOverloadCandidate - Adds the given function to the set of
 /// candidate functions, using the given function call arguments.  If
 /// @p SuppressUserConversions, then don't allow user-defined
@@ -6142,6 +6177,18 @@ Sema::AddTemplateOverloadCandidate(FunctionTemplateDecl *FunctionTemplate,
   if (!CandidateSet.isNewCandidate(FunctionTemplate))
     return;
 
+  // C++ [over.match.oper]p3:
+  //   if no operand has a class type, only those non-member functions in the
+  //   lookup set that have a first parameter of type T1 or "reference to
+  //   (possibly cv-qualified) T1", when T1 is an enumeration type, [...] are
+  //   candidate functions.
+  // AddOverloadCandidate drops the specialization in this case; avoid
+  // deducing it in the first place when the parameter types already rule it
+  // out.
+  if (CandidateSet.getKind() == OverloadCandidateSet::CSK_Operator &&
+      IsUnacceptableNonMemberOperatorTemplate(Context, FunctionTemplate, Args))
+    return;
+
   // C++ [over.match.funcs]p7:
   //   In each case where a candidate is a function template, candidate
   //   function template specializations are generated using template argument
@@ -10835,6 +10882,8 @@ ExprResult Sema::BuildOverloadedCallExpr(Scope *S, Expr *Fn,
                                          SourceLocation RParenLoc,
                                          Expr *ExecConfig,
                                          bool AllowTypoCorrection) {
+  llvm::TimeTraceScope TimeScope(
+      "OverloadResolution", [&]() { return ULE->getName().getAsString(); });
   OverloadCandidateSet CandidateSet(Fn->getExprLoc(),
                                     OverloadCandidateSet::CSK_Normal);
   ExprResult result;
@@ -11073,6 +11122,8 @@ Sema::CreateOverloadedBinOp(SourceLocation OpLoc,
   BinaryOperator::Opcode Opc = static_cast<BinaryOperator::Opcode>(OpcIn);
   OverloadedOperatorKind Op = BinaryOperator::getOverloadedOperator(Opc);
   DeclarationName OpName = Context.DeclarationNames.getCXXOperatorName(Op);
+  llvm::TimeTraceScope TimeScope("OverloadResolution",
+                                 [&]() { return OpName.getAsString(); });
 
   // If either side is type-dependent, create an appropriate dependent
   // expression.
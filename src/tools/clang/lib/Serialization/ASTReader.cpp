@@ -45,6 +45,7 @@
 #include "clang/Serialization/ModuleManager.h"
 #include "clang/Serialization/SerializationDiagnostic.h"
 #include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Bitcode/BitstreamReader.h"
 #include "llvm/Support/ErrorHandling.h"
@@ -52,6 +53,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/SaveAndRestore.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstdio>
@@ -63,6 +65,13 @@ using namespace clang::serialization;
 using namespace clang::serialization::reader;
 using llvm::BitstreamCursor;
 
+#define DEBUG_TYPE "ast-reader"
+
+STATISTIC(NumSLocEntriesDeserialized,
+          "Number of source location entries deserialized");
+STATISTIC(NumMacrosDeserialized, "Number of macros deserialized");
+STATISTIC(NumTypesDeserialized, "Number of types deserialized");
+
 
 //===----------------------------------------------------------------------===//
 // ChainedASTReaderListener implementation
@@ -1208,6 +1217,7 @@ bool ASTReader::ReadSLocEntry(int ID) {
   unsigned BaseOffset = F->SLocEntryBaseOffset;
 
   ++NumSLocEntriesRead;
+  ++NumSLocEntriesDeserialized;
   llvm::BitstreamEntry Entry = SLocEntryCursor.advance();
   if (Entry.Kind != llvm::BitstreamEntry::Record) {
     Error("incorrectly-formatted source location entry in AST file");
@@ -1308,10 +1318,13 @@ bool ASTReader::ReadSLocEntry(int ID) {
   }
 
   case SM_SLOC_EXPANSION_ENTRY: {
-    SourceLocation SpellingLoc = ReadSourceLocation(*F, Record[1]);
+    uint32_t StartRaw = decodeSLocExpansionLoc(Record[2]);
+    uint32_t EndRaw = decodeSLocExpansionEnd(StartRaw, Record[3]);
+    SourceLocation SpellingLoc =
+        ReadSourceLocation(*F, decodeSLocExpansionLoc(Record[1]));
     SourceMgr.createExpansionLoc(SpellingLoc,
-                                     ReadSourceLocation(*F, Record[2]),
-                                     ReadSourceLocation(*F, Record[3]),
+                                     ReadSourceLocation(*F, StartRaw),
+                                     ReadSourceLocation(*F, EndRaw),
                                      Record[4],
                                      ID,
                                      BaseOffset + Record[0]);
@@ -1484,6 +1497,7 @@ MacroInfo *ASTReader::ReadMacroRecord(ModuleFile &F, uint64_t Offset) {
       }
 
       ++NumMacrosRead;
+      ++NumMacrosDeserialized;
       break;
     }
 
@@ -2327,7 +2341,11 @@ ASTReader::ReadControlBlock(ModuleFile &F,
 
       // All user input files reside at the index range [0, NumUserInputs), and
       // system input files reside at [NumUserInputs, NumInputs).
-      if (!DisableValidation) {
+      //
+      // Without implicit modules, keeping the module files it passes us up to
+      // date is the business of the build system, so don't stat their inputs.
+      if (!DisableValidation &&
+          (F.Kind != MK_ExplicitModule || PP.getLangOpts().ImplicitModules)) {
         bool Complain = (ClientLoadCapabilities & ARR_OutOfDate) == 0;
 
         // If we are reading a module, we will create a verification timestamp,
@@ -3637,6 +3655,7 @@ ASTReader::ASTReadResult ASTReader::ReadAST(const std::string &FileName,
                                             ModuleKind Type,
                                             SourceLocation ImportLoc,
                                             unsigned ClientLoadCapabilities) {
+  llvm::TimeTraceScope TimeScope("ReadAST", [&]() { return FileName; });
   llvm::SaveAndRestore<SourceLocation>
     SetCurImportLocRAII(CurrentImportLoc, ImportLoc);
 
@@ -5222,6 +5241,7 @@ ASTReader::RecordLocation ASTReader::TypeCursorForIndex(unsigned Index) {
 /// location. It is a helper routine for GetType, which deals with reading type
 /// IDs.
 QualType ASTReader::readTypeRecord(unsigned Index) {
+  ++NumTypesDeserialized;
   RecordLocation Loc = TypeCursorForIndex(Index);
   BitstreamCursor &DeclsCursor = Loc.F->DeclsCursor;
 
@@ -6690,6 +6710,7 @@ ASTReader::FindExternalVisibleDeclsByName(const DeclContext *DC,
   }
 
   ++NumVisibleDeclContextsRead;
+  NumVisibleDeclsFound += Decls.size();
   SetExternalVisibleDeclsForName(DC, Name, Decls);
   return !Decls.empty();
 }
@@ -6851,6 +6872,9 @@ void ASTReader::PrintStats() {
   unsigned NumDeclsLoaded
     = DeclsLoaded.size() - std::count(DeclsLoaded.begin(), DeclsLoaded.end(),
                                       (Decl *)nullptr);
+  unsigned NumDeclsReferenced
+    = std::count_if(DeclsLoaded.begin(), DeclsLoaded.end(),
+                    [](Decl *D) { return D && D->isReferenced(); });
   unsigned NumIdentifiersLoaded
     = IdentifiersLoaded.size() - std::count(IdentifiersLoaded.begin(),
                                             IdentifiersLoaded.end(),
@@ -6876,6 +6900,10 @@ void ASTReader::PrintStats() {
     std::fprintf(stderr, "  %u/%u declarations read (%f%%)\n",
                  NumDeclsLoaded, (unsigned)DeclsLoaded.size(),
                  ((float)NumDeclsLoaded/DeclsLoaded.size() * 100));
+  if (NumDeclsLoaded)
+    std::fprintf(stderr, "  %u/%u declarations read were referenced (%f%%)\n",
+                 NumDeclsReferenced, NumDeclsLoaded,
+                 ((float)NumDeclsReferenced/NumDeclsLoaded * 100));
   if (!IdentifiersLoaded.empty())
     std::fprintf(stderr, "  %u/%u identifiers read (%f%%)\n",
                  NumIdentifiersLoaded, (unsigned)IdentifiersLoaded.size(),
@@ -6906,6 +6934,9 @@ void ASTReader::PrintStats() {
                  NumVisibleDeclContextsRead, TotalVisibleDeclContexts,
                  ((float)NumVisibleDeclContextsRead/TotalVisibleDeclContexts
                   * 100));
+  if (NumVisibleDeclContextsRead)
+    std::fprintf(stderr, "  %u declarations found by visible name lookup\n",
+                 NumVisibleDeclsFound);
   if (TotalNumMethodPoolEntries) {
     std::fprintf(stderr, "  %u/%u method pool entries read (%f%%)\n",
                  NumMethodPoolEntriesRead, TotalNumMethodPoolEntries,
@@ -7224,10 +7255,19 @@ void ASTReader::ReadMethodPool(Selector Sel) {
   unsigned PriorGeneration = Generation;
   Generation = getGeneration();
   
+  // If there is a global index, look there first to determine which modules
+  // provably do not have any methods for this selector.
+  GlobalModuleIndex::HitSet Hits;
+  GlobalModuleIndex::HitSet *HitsPtr = nullptr;
+  if (!loadGlobalIndex()) {
+    if (GlobalIndex->lookupSelector(Sel, Hits))
+      HitsPtr = &Hits;
+  }
+
   // Search for methods defined with this selector.
   ++NumMethodPoolLookups;
   ReadMethodPoolVisitor Visitor(*this, Sel, PriorGeneration);
-  ModuleMgr.visit(&ReadMethodPoolVisitor::visit, &Visitor);
+  ModuleMgr.visit(&ReadMethodPoolVisitor::visit, &Visitor, HitsPtr);
   
   if (Visitor.getInstanceMethods().empty() &&
       Visitor.getFactoryMethods().empty())
@@ -8679,6 +8719,7 @@ ASTReader::ASTReader(Preprocessor &PP, ASTContext &Context,
       NumMethodPoolTableHits(0), TotalNumMethodPoolEntries(0),
       NumLexicalDeclContextsRead(0), TotalLexicalDeclContexts(0),
       NumVisibleDeclContextsRead(0), TotalVisibleDeclContexts(0),
+      NumVisibleDeclsFound(0),
       TotalModulesSizeInBits(0), NumCurrentElementsDeserializing(0),
       PassingDeclsToConsumer(false), NumCXXBaseSpecifiersLoaded(0),
       ReadingKind(Read_None) {
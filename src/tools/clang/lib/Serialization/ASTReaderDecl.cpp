@@ -25,10 +25,16 @@
 #include "clang/Sema/IdentifierResolver.h"
 #include "clang/Sema/Sema.h"
 #include "clang/Sema/SemaDiagnostic.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Support/SaveAndRestore.h"
+#include "llvm/Support/TimeProfiler.h"
 using namespace clang;
 using namespace clang::serialization;
 
+#define DEBUG_TYPE "ast-reader"
+
+STATISTIC(NumDeclsDeserialized, "Number of declarations deserialized");
+
 //===----------------------------------------------------------------------===//
 // Declaration deserialization
 //===----------------------------------------------------------------------===//
@@ -2993,6 +2999,8 @@ ASTReader::combineStoredMergedDecls(Decl *Canon, GlobalDeclID CanonID) {
 
 /// \brief Read the declaration at the given offset from the AST file.
 Decl *ASTReader::ReadDeclRecord(DeclID ID) {
+  llvm::TimeTraceScope TimeScope("DeserializeDecl");
+  ++NumDeclsDeserialized;
   unsigned Index = ID - NUM_PREDEF_DECL_IDS;
   unsigned RawLocation = 0;
   RecordLocation Loc = DeclCursorForID(ID, RawLocation);
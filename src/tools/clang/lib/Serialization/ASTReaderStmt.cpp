@@ -19,9 +19,14 @@
 #include "clang/AST/StmtVisitor.h"
 #include "clang/Lex/Token.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Statistic.h"
 using namespace clang;
 using namespace clang::serialization;
 
+#define DEBUG_TYPE "ast-reader"
+
+STATISTIC(NumStmtsDeserialized, "Number of statements deserialized");
+
 namespace clang {
 
   class ASTStmtReader : public StmtVisitor<ASTStmtReader> {
@@ -2971,6 +2976,7 @@ Stmt *ASTReader::ReadStmtFromStream(ModuleFile &F) {
       break;
 
     ++NumStatementsRead;
+    ++NumStmtsDeserialized;
 
     if (S && !IsStmtReference) {
       Reader.Visit(S);
@@ -11,6 +11,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "ASTCommon.h"
 #include "ASTReaderInternals.h"
 #include "clang/AST/ModuleProvider.h"
 #include "clang/Basic/FileManager.h"
@@ -51,7 +52,9 @@ namespace {
     /// \brief Describes a module, including its file name and dependencies.
     MODULE,
     /// \brief The index for identifiers.
-    IDENTIFIER_INDEX
+    IDENTIFIER_INDEX,
+    /// \brief The index for selector hashes.
+    SELECTOR_INDEX
   };
 }
 
@@ -59,7 +62,7 @@ namespace {
 static const char * const IndexFileName = "modules.idx";
 
 /// \brief The global index file version.
-static const unsigned CurrentVersion = 1;
+static const unsigned CurrentVersion = 2;
 
 //----------------------------------------------------------------------------//
 // Global module index reader.
@@ -122,12 +125,63 @@ public:
 typedef llvm::OnDiskIterableChainedHashTable<IdentifierIndexReaderTrait>
     IdentifierIndexTable;
 
+/// \brief Trait used to read the selector index from the on-disk hash table.
+///
+/// The key is the selector hash computed by \c serialization::ComputeHash,
+/// which depends only on the spelling of the selector.
+class SelectorIndexReaderTrait {
+public:
+  typedef unsigned external_key_type;
+  typedef unsigned internal_key_type;
+  typedef SmallVector<unsigned, 2> data_type;
+  typedef unsigned hash_value_type;
+  typedef unsigned offset_type;
+
+  static bool EqualKey(internal_key_type a, internal_key_type b) {
+    return a == b;
+  }
+
+  static hash_value_type ComputeHash(internal_key_type a) { return a; }
+
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char*& d) {
+    using namespace llvm::support;
+    unsigned DataLen = endian::readNext<uint16_t, little, unaligned>(d);
+    return std::make_pair(4u, DataLen);
+  }
+
+  static internal_key_type GetInternalKey(external_key_type x) { return x; }
+
+  static internal_key_type ReadKey(const unsigned char* d, unsigned) {
+    using namespace llvm::support;
+    return endian::readNext<uint32_t, little, unaligned>(d);
+  }
+
+  static data_type ReadData(internal_key_type k, const unsigned char* d,
+                            unsigned DataLen) {
+    using namespace llvm::support;
+
+    data_type Result;
+    while (DataLen > 0) {
+      unsigned ID = endian::readNext<uint32_t, little, unaligned>(d);
+      Result.push_back(ID);
+      DataLen -= 4;
+    }
+
+    return Result;
+  }
+};
+
+typedef llvm::OnDiskChainedHashTable<SelectorIndexReaderTrait>
+    SelectorIndexTable;
+
 }
 
 GlobalModuleIndex::GlobalModuleIndex(std::unique_ptr<llvm::MemoryBuffer> Buffer,
                                      llvm::BitstreamCursor Cursor)
-    : Buffer(std::move(Buffer)), IdentifierIndex(), NumIdentifierLookups(),
-      NumIdentifierLookupHits() {
+    : Buffer(std::move(Buffer)), IdentifierIndex(), SelectorIndex(),
+      NumIdentifierLookups(), NumIdentifierLookupHits(), NumSelectorLookups(),
+      NumSelectorLookupHits() {
   // Read the global index.
   bool InGlobalIndexBlock = false;
   bool Done = false;
@@ -225,12 +279,22 @@ GlobalModuleIndex::GlobalModuleIndex(std::unique_ptr<llvm::MemoryBuffer> Buffer,
             (const unsigned char *)Blob.data(), IdentifierIndexReaderTrait());
       }
       break;
+
+    case SELECTOR_INDEX:
+      // Wire up the selector index.
+      if (Record[0]) {
+        SelectorIndex = SelectorIndexTable::Create(
+            (const unsigned char *)Blob.data() + Record[0],
+            (const unsigned char *)Blob.data());
+      }
+      break;
     }
   }
 }
 
 GlobalModuleIndex::~GlobalModuleIndex() {
   delete static_cast<IdentifierIndexTable *>(IdentifierIndex);
+  delete static_cast<SelectorIndexTable *>(SelectorIndex);
 }
 
 std::pair<GlobalModuleIndex *, GlobalModuleIndex::ErrorCode>
@@ -318,6 +382,30 @@ bool GlobalModuleIndex::lookupIdentifier(StringRef Name, HitSet &Hits) {
   return true;
 }
 
+bool GlobalModuleIndex::lookupSelector(Selector Sel, HitSet &Hits) {
+  Hits.clear();
+
+  // If there's no selector index, there is nothing we can do.
+  if (!SelectorIndex)
+    return false;
+
+  // Look into the selector index.
+  ++NumSelectorLookups;
+  SelectorIndexTable &Table = *static_cast<SelectorIndexTable *>(SelectorIndex);
+  SelectorIndexTable::iterator Known = Table.find(ComputeHash(Sel));
+  if (Known == Table.end())
+    return true;
+
+  SmallVector<unsigned, 2> ModuleIDs = *Known;
+  for (unsigned I = 0, N = ModuleIDs.size(); I != N; ++I) {
+    if (ModuleFile *MF = Modules[ModuleIDs[I]].File)
+      Hits.insert(MF);
+  }
+
+  ++NumSelectorLookupHits;
+  return true;
+}
+
 bool GlobalModuleIndex::loadedModuleFile(ModuleFile *File) {
   // Look for the module in the global module index based on the module name.
   StringRef Name = File->ModuleName;
@@ -352,6 +440,11 @@ void GlobalModuleIndex::printStats() {
             NumIdentifierLookupHits, NumIdentifierLookups,
             (double)NumIdentifierLookupHits*100.0/NumIdentifierLookups);
   }
+  if (NumSelectorLookups) {
+    fprintf(stderr, "  %u / %u selector lookups succeeded (%f%%)\n",
+            NumSelectorLookupHits, NumSelectorLookups,
+            (double)NumSelectorLookupHits*100.0/NumSelectorLookups);
+  }
   std::fprintf(stderr, "\n");
 }
 
@@ -401,6 +494,14 @@ namespace {
     /// \brief A mapping from all interesting identifiers to the set of module
     /// files in which those identifiers are considered interesting.
     InterestingIdentifierMap InterestingIdentifiers;
+
+    /// \brief Mapping from selector hashes to the list of module file IDs
+    /// whose method pool has an entry with that hash.
+    typedef llvm::MapVector<unsigned, SmallVector<unsigned, 2> >
+      SelectorHashMap;
+
+    /// \brief The selector hashes of all known method pool entries.
+    SelectorHashMap SelectorHashes;
     
     /// \brief Write the block-info block for the global module index file.
     void emitBlockInfoBlock(llvm::BitstreamWriter &Stream);
@@ -469,6 +570,7 @@ GlobalModuleIndexBuilder::emitBlockInfoBlock(llvm::BitstreamWriter &Stream) {
   RECORD(INDEX_METADATA);
   RECORD(MODULE);
   RECORD(IDENTIFIER_INDEX);
+  RECORD(SELECTOR_INDEX);
 #undef RECORD
 #undef BLOCK
 
@@ -639,6 +741,40 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
       }
     }
 
+    // Handle the method pool. We only need the hash of each selector, which
+    // the on-disk hash table stores alongside every entry, so walk the
+    // buckets directly rather than resolving the selector's identifiers.
+    if (State == ASTBlock && Code == METHOD_POOL && Record[0] > 0) {
+      using namespace llvm::support;
+      const unsigned char *Base = (const unsigned char *)Blob.data();
+      const unsigned char *Buckets = Base + Record[0];
+      unsigned NumBuckets = endian::readNext<uint32_t, little, unaligned>(
+          Buckets);
+      endian::readNext<uint32_t, little, unaligned>(Buckets); // NumEntries
+      for (unsigned B = 0; B != NumBuckets; ++B) {
+        uint32_t Offset = endian::readNext<uint32_t, little, unaligned>(
+            Buckets);
+        if (!Offset)
+          continue;
+
+        const unsigned char *Items = Base + Offset;
+        unsigned NumItems = endian::readNext<uint16_t, little, unaligned>(
+            Items);
+        for (; NumItems; --NumItems) {
+          unsigned Hash = endian::readNext<uint32_t, little, unaligned>(Items);
+          unsigned KeyLen = endian::readNext<uint16_t, little, unaligned>(
+              Items);
+          unsigned DataLen = endian::readNext<uint16_t, little, unaligned>(
+              Items);
+          Items += KeyLen + DataLen;
+
+          SmallVectorImpl<unsigned> &IDs = SelectorHashes[Hash];
+          if (IDs.empty() || IDs.back() != ID)
+            IDs.push_back(ID);
+        }
+      }
+    }
+
     // We don't care about this record.
   }
 
@@ -647,6 +783,39 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
 
 namespace {
 
+/// \brief Trait used to generate the selector index as an on-disk hash table.
+class SelectorIndexWriterTrait {
+public:
+  typedef unsigned key_type;
+  typedef unsigned key_type_ref;
+  typedef SmallVector<unsigned, 2> data_type;
+  typedef const SmallVector<unsigned, 2> &data_type_ref;
+  typedef unsigned hash_value_type;
+  typedef unsigned offset_type;
+
+  static hash_value_type ComputeHash(key_type_ref Key) { return Key; }
+
+  std::pair<unsigned,unsigned>
+  EmitKeyDataLength(raw_ostream& Out, key_type_ref Key, data_type_ref Data) {
+    using namespace llvm::support;
+    unsigned DataLen = Data.size() * 4;
+    endian::Writer<little>(Out).write<uint16_t>(DataLen);
+    return std::make_pair(4u, DataLen);
+  }
+
+  void EmitKey(raw_ostream& Out, key_type_ref Key, unsigned KeyLen) {
+    using namespace llvm::support;
+    endian::Writer<little>(Out).write<uint32_t>(Key);
+  }
+
+  void EmitData(raw_ostream& Out, key_type_ref Key, data_type_ref Data,
+                unsigned DataLen) {
+    using namespace llvm::support;
+    for (unsigned I = 0, N = Data.size(); I != N; ++I)
+      endian::Writer<little>(Out).write<uint32_t>(Data[I]);
+  }
+};
+
 /// \brief Trait used to generate the identifier index as an on-disk hash
 /// table.
 class IdentifierIndexWriterTrait {
@@ -764,6 +933,43 @@ void GlobalModuleIndexBuilder::writeIndex(llvm::BitstreamWriter &Stream) {
     Stream.EmitRecordWithBlob(IDTableAbbrev, Record, IdentifierTable.str());
   }
 
+  // Write the selector hash -> module file mapping.
+  {
+    llvm::OnDiskChainedHashTableGenerator<SelectorIndexWriterTrait> Generator;
+    SelectorIndexWriterTrait Trait;
+
+    // Populate the hash table.
+    for (SelectorHashMap::iterator I = SelectorHashes.begin(),
+                                   IEnd = SelectorHashes.end();
+         I != IEnd; ++I) {
+      Generator.insert(I->first, I->second, Trait);
+    }
+
+    // Create the on-disk hash table in a buffer.
+    SmallString<4096> SelectorTable;
+    uint32_t BucketOffset;
+    {
+      using namespace llvm::support;
+      llvm::raw_svector_ostream Out(SelectorTable);
+      // Make sure that no bucket is at offset 0
+      endian::Writer<little>(Out).write<uint32_t>(0);
+      BucketOffset = Generator.Emit(Out, Trait);
+    }
+
+    // Create a blob abbreviation
+    BitCodeAbbrev *Abbrev = new BitCodeAbbrev();
+    Abbrev->Add(BitCodeAbbrevOp(SELECTOR_INDEX));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
+    unsigned SelTableAbbrev = Stream.EmitAbbrev(Abbrev);
+
+    // Write the selector table
+    Record.clear();
+    Record.push_back(SELECTOR_INDEX);
+    Record.push_back(BucketOffset);
+    Stream.EmitRecordWithBlob(SelTableAbbrev, Record, SelectorTable.str());
+  }
+
   Stream.ExitBlock();
 }
 
@@ -125,9 +125,16 @@ ModuleManager::addModule(StringRef FileName, ModuleKind Type,
         // ModuleManager it must be the same underlying file.
         // FIXME: Because FileManager::getFile() doesn't guarantee that it will
         // give us an open file, this may not be 100% reliable.
+        //
+        // The bitstream reader never looks past the end of the file, so don't
+        // ask for a null terminator: that lets every AST file be mapped
+        // read-only, with its blobs served straight out of the (shared) page
+        // cache, instead of files whose size is a multiple of the page size
+        // being copied into private memory.
         Buf = FileMgr.getBufferForFile(New->File,
                                        /*IsVolatile=*/false,
-                                       /*ShouldClose=*/false);
+                                       /*ShouldClose=*/false,
+                                       /*RequiresNullTerminator=*/false);
       }
 
       if (!Buf) {
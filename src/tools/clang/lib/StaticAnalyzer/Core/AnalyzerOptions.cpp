@@ -245,6 +245,11 @@ unsigned AnalyzerOptions::getGraphTrimInterval() {
   return GraphTrimInterval.getValue();
 }
 
+bool AnalyzerOptions::shouldTrimGraphAggressively() {
+  return getBooleanOption(TrimGraphAggressively, "graph-trim-aggressive",
+                          /* Default = */ false);
+}
+
 unsigned AnalyzerOptions::getMaxTimesInlineLarge() {
   if (!MaxTimesInlineLarge.hasValue())
     MaxTimesInlineLarge = getOptionAsInteger("max-times-inline-large", 32);
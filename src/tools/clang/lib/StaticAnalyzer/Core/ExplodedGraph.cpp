@@ -48,7 +48,8 @@ void ExplodedNode::SetAuditor(ExplodedNode::Auditor* A) {
 //===----------------------------------------------------------------------===//
 
 ExplodedGraph::ExplodedGraph()
-  : NumNodes(0), ReclaimNodeInterval(0) {}
+  : NumNodes(0), PeakNumNodes(0), ReclaimNodeInterval(0),
+    AggressiveReclamation(false) {}
 
 ExplodedGraph::~ExplodedGraph() {}
 
@@ -94,6 +95,11 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
   //      PreImplicitCall (so that we would be able to find it when retrying a 
   //      call with no inlining).
   // FIXME: It may be safe to reclaim PreCall and PostCall nodes as well.
+  //
+  // With aggressive reclamation, condition 9 is dropped, and PreStmt nodes
+  // that satisfy conditions 4 to 7 and are not for a call are collected too.
+  // Bug paths still go through the same statements, but arrows in path
+  // diagnostics may be anchored less precisely.
 
   // Conditions 1 and 2.
   if (node->pred_size() != 1 || node->succ_size() != 1)
@@ -114,7 +120,9 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
     return !progPoint.getTag();
 
   // Condition 3.
-  if (!progPoint.getAs<PostStmt>() || progPoint.getAs<PostStore>())
+  bool IsPreStmt = AggressiveReclamation && progPoint.getAs<PreStmt>();
+  if (!IsPreStmt &&
+      (!progPoint.getAs<PostStmt>() || progPoint.getAs<PostStore>()))
     return false;
 
   // Condition 4.
@@ -129,11 +137,14 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
     return false;
 
   // All further checks require expressions. As per #3, we know that we have
-  // a PostStmt.
-  const Expr *Ex = dyn_cast<Expr>(progPoint.castAs<PostStmt>().getStmt());
+  // a PostStmt, or a PreStmt when reclaiming aggressively.
+  const Expr *Ex = dyn_cast<Expr>(progPoint.castAs<StmtPoint>().getStmt());
   if (!Ex)
     return false;
 
+  if (IsPreStmt && CallEvent::isCallStmt(Ex))
+    return false;
+
   // Condition 8.
   // Do not collect nodes for "interesting" lvalue expressions since they are
   // used extensively for generating path diagnostics.
@@ -145,7 +156,7 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
   // diagnostic generation; specifically, so that we could anchor arrows
   // pointing to the beginning of statements (as written in code).
   ParentMap &PM = progPoint.getLocationContext()->getParentMap();
-  if (!PM.isConsumedExpr(Ex))
+  if (!AggressiveReclamation && !PM.isConsumedExpr(Ex))
     return false;
 
   // Condition 10.
@@ -327,6 +338,8 @@ ExplodedNode *ExplodedGraph::getNode(const ProgramPoint &L,
     // Insert the node into the node set and return it.
     Nodes.InsertNode(V, InsertPos);
     ++NumNodes;
+    if (NumNodes > PeakNumNodes)
+      PeakNumNodes = NumNodes;
 
     if (IsNew) *IsNew = true;
   }
@@ -88,7 +88,8 @@ ExprEngine::ExprEngine(AnalysisManager &mgr, bool gcEnabled,
   unsigned TrimInterval = mgr.options.getGraphTrimInterval();
   if (TrimInterval != 0) {
     // Enable eager node reclaimation when constructing the ExplodedGraph.
-    G.enableNodeReclamation(TrimInterval);
+    G.enableNodeReclamation(TrimInterval,
+                            mgr.options.shouldTrimGraphAggressively());
   }
 }
 
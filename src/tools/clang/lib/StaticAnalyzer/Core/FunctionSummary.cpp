@@ -15,6 +15,8 @@
 using namespace clang;
 using namespace ento;
 
+FunctionSummaryStore::~FunctionSummaryStore() {}
+
 unsigned FunctionSummariesTy::getTotalNumBasicBlocks() {
   unsigned Total = 0;
   for (MapTy::iterator I = Map.begin(), E = Map.end(); I != E; ++I) {
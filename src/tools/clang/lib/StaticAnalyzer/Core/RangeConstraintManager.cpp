@@ -17,7 +17,8 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramState.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramStateTrait.h"
 #include "llvm/ADT/FoldingSet.h"
-#include "llvm/ADT/ImmutableSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -55,59 +56,101 @@ public:
 };
 
 
-class RangeTrait : public llvm::ImutContainerInfo<Range> {
-public:
-  // When comparing if one Range is less than another, we should compare
-  // the actual APSInt values instead of their pointers.  This keeps the order
-  // consistent (instead of comparing by pointer values) and can potentially
-  // be used to speed up some of the operations in RangeSet.
-  static inline bool isLess(key_type_ref lhs, key_type_ref rhs) {
-    return *lhs.first < *rhs.first || (!(*rhs.first < *lhs.first) &&
-                                       *lhs.second < *rhs.second);
-  }
-};
-
 /// RangeSet contains a set of ranges. If the set is empty, then
 ///  there the value of a symbol is overly constrained and there are no
 ///  possible values for that symbol.
+///
+/// The ranges are kept sorted and disjoint in a single array. Sets are
+/// uniqued by their Factory, so that each distinct set is stored once and
+/// comparing two sets is a pointer comparison.
 class RangeSet {
-  typedef llvm::ImmutableSet<Range, RangeTrait> PrimRangeSet;
-  PrimRangeSet ranges; // no need to make const, since it is an
-                       // ImmutableSet - this allows default operator=
-                       // to work.
+  /// The array of ranges, allocated together with its header.
+  class Storage : public llvm::FoldingSetNode {
+    unsigned NumRanges;
+
+  public:
+    explicit Storage(unsigned NumRanges) : NumRanges(NumRanges) {}
+
+    const Range *begin() const {
+      return reinterpret_cast<const Range *>(this + 1);
+    }
+    const Range *end() const { return begin() + NumRanges; }
+    unsigned size() const { return NumRanges; }
+
+    static void Profile(llvm::FoldingSetNodeID &ID, ArrayRef<Range> Ranges) {
+      for (ArrayRef<Range>::iterator I = Ranges.begin(), E = Ranges.end();
+           I != E; ++I)
+        I->Profile(ID);
+    }
+    void Profile(llvm::FoldingSetNodeID &ID) const {
+      Profile(ID, llvm::makeArrayRef(begin(), end()));
+    }
+  };
+
+  /// The ranges of the set, or null if the set is empty.
+  const Storage *Ranges;
+
+  explicit RangeSet(const Storage *Ranges) : Ranges(Ranges) {}
+
 public:
-  typedef PrimRangeSet::Factory Factory;
-  typedef PrimRangeSet::iterator iterator;
+  class Factory {
+    llvm::BumpPtrAllocator Allocator;
+    llvm::FoldingSet<Storage> Sets;
+
+  public:
+    RangeSet getEmptySet() { return RangeSet(nullptr); }
+
+    /// Returns the set of the given sorted and disjoint ranges.
+    RangeSet getSet(ArrayRef<Range> NewRanges) {
+      if (NewRanges.empty())
+        return getEmptySet();
+
+      llvm::FoldingSetNodeID ID;
+      Storage::Profile(ID, NewRanges);
+      void *InsertPos;
+      if (Storage *S = Sets.FindNodeOrInsertPos(ID, InsertPos))
+        return RangeSet(S);
+
+      void *Mem = Allocator.Allocate(
+          sizeof(Storage) + NewRanges.size() * sizeof(Range),
+          llvm::alignOf<Storage>());
+      Storage *S = new (Mem) Storage(NewRanges.size());
+      std::uninitialized_copy(NewRanges.begin(), NewRanges.end(),
+                              const_cast<Range *>(S->begin()));
+      Sets.InsertNode(S, InsertPos);
+      return RangeSet(S);
+    }
+  };
 
-  RangeSet(PrimRangeSet RS) : ranges(RS) {}
+  typedef const Range *iterator;
 
-  iterator begin() const { return ranges.begin(); }
-  iterator end() const { return ranges.end(); }
+  iterator begin() const { return Ranges ? Ranges->begin() : nullptr; }
+  iterator end() const { return Ranges ? Ranges->end() : nullptr; }
 
-  bool isEmpty() const { return ranges.isEmpty(); }
+  bool isEmpty() const { return !Ranges; }
 
   /// Construct a new RangeSet representing '{ [from, to] }'.
   RangeSet(Factory &F, const llvm::APSInt &from, const llvm::APSInt &to)
-    : ranges(F.add(F.getEmptySet(), Range(from, to))) {}
+    : Ranges(F.getSet(Range(from, to)).Ranges) {}
 
   /// Profile - Generates a hash profile of this RangeSet for use
   ///  by FoldingSet.
-  void Profile(llvm::FoldingSetNodeID &ID) const { ranges.Profile(ID); }
+  void Profile(llvm::FoldingSetNodeID &ID) const { ID.AddPointer(Ranges); }
 
   /// getConcreteValue - If a symbol is contrained to equal a specific integer
   ///  constant then this method returns that value.  Otherwise, it returns
   ///  NULL.
   const llvm::APSInt* getConcreteValue() const {
-    return ranges.isSingleton() ? ranges.begin()->getConcreteValue() : nullptr;
+    return Ranges && Ranges->size() == 1 ? begin()->getConcreteValue()
+                                         : nullptr;
   }
 
 private:
-  void IntersectInRange(BasicValueFactory &BV, Factory &F,
+  void IntersectInRange(BasicValueFactory &BV,
                         const llvm::APSInt &Lower,
                         const llvm::APSInt &Upper,
-                        PrimRangeSet &newRanges,
-                        PrimRangeSet::iterator &i,
-                        PrimRangeSet::iterator &e) const {
+                        SmallVectorImpl<Range> &newRanges,
+                        iterator &i, iterator e) const {
     // There are six cases for each range R in the set:
     //   1. R is entirely before the intersection range.
     //   2. R is entirely after the intersection range.
@@ -126,24 +169,23 @@ private:
 
       if (i->Includes(Lower)) {
         if (i->Includes(Upper)) {
-          newRanges = F.add(newRanges, Range(BV.getValue(Lower),
-                                             BV.getValue(Upper)));
+          newRanges.push_back(Range(BV.getValue(Lower), BV.getValue(Upper)));
           break;
         } else
-          newRanges = F.add(newRanges, Range(BV.getValue(Lower), i->To()));
+          newRanges.push_back(Range(BV.getValue(Lower), i->To()));
       } else {
         if (i->Includes(Upper)) {
-          newRanges = F.add(newRanges, Range(i->From(), BV.getValue(Upper)));
+          newRanges.push_back(Range(i->From(), BV.getValue(Upper)));
           break;
         } else
-          newRanges = F.add(newRanges, *i);
+          newRanges.push_back(*i);
       }
     }
   }
 
   const llvm::APSInt &getMinValue() const {
     assert(!isEmpty());
-    return ranges.begin()->From();
+    return begin()->From();
   }
 
   bool pin(llvm::APSInt &Lower, llvm::APSInt &Upper) const {
@@ -240,20 +282,20 @@ public:
     if (!pin(Lower, Upper))
       return F.getEmptySet();
 
-    PrimRangeSet newRanges = F.getEmptySet();
+    SmallVector<Range, 4> newRanges;
 
-    PrimRangeSet::iterator i = begin(), e = end();
+    iterator i = begin(), e = end();
     if (Lower <= Upper)
-      IntersectInRange(BV, F, Lower, Upper, newRanges, i, e);
+      IntersectInRange(BV, Lower, Upper, newRanges, i, e);
     else {
       // The order of the next two statements is important!
-      // IntersectInRange() does not reset the iteration state for i and e.
+      // IntersectInRange() does not reset the iteration state for i.
       // Therefore, the lower range most be handled first.
-      IntersectInRange(BV, F, BV.getMinValue(Upper), Upper, newRanges, i, e);
-      IntersectInRange(BV, F, Lower, BV.getMaxValue(Lower), newRanges, i, e);
+      IntersectInRange(BV, BV.getMinValue(Upper), Upper, newRanges, i, e);
+      IntersectInRange(BV, Lower, BV.getMaxValue(Lower), newRanges, i, e);
     }
 
-    return newRanges;
+    return F.getSet(newRanges);
   }
 
   void print(raw_ostream &os) const {
@@ -272,7 +314,7 @@ public:
   }
 
   bool operator==(const RangeSet &other) const {
-    return ranges == other.ranges;
+    return Ranges == other.Ranges;
   }
 };
 } // end anonymous namespace
@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/StaticAnalyzer/Frontend/AnalysisConsumer.h"
+#include "FunctionSummaryCache.h"
 #include "ModelInjector.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/DataRecursiveASTVisitor.h"
@@ -37,6 +38,7 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
 #include "clang/StaticAnalyzer/Frontend/CheckerRegistration.h"
 #include "llvm/ADT/DepthFirstIterator.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
@@ -64,6 +66,12 @@ STATISTIC(NumBlocksInAnalyzedFunctions,
                       "The # of basic blocks in the analyzed functions.");
 STATISTIC(PercentReachableBlocks, "The % of reachable basic blocks.");
 STATISTIC(MaxCFGSize, "The maximum number of basic blocks in a function.");
+STATISTIC(MaxExplodedGraphSize,
+                      "The maximum number of nodes in the exploded graph of a "
+                      "function at any one time.");
+STATISTIC(MaxExplodedGraphBytes,
+                      "The maximum number of bytes allocated for the exploded "
+                      "graph of a function.");
 
 //===----------------------------------------------------------------------===//
 // Special PathDiagnosticConsumers.
@@ -185,6 +193,10 @@ public:
   /// translation unit.
   FunctionSummariesTy FunctionSummaries;
 
+  /// The function summaries shared with other translation units, when the
+  /// summary-cache-path option is set.
+  std::unique_ptr<FunctionSummaryCache> SummaryCache;
+
   AnalysisConsumer(const Preprocessor& pp,
                    const std::string& outdir,
                    AnalyzerOptionsRef opts,
@@ -295,6 +307,14 @@ public:
     Mgr = llvm::make_unique<AnalysisManager>(
         *Ctx, PP.getDiagnostics(), PP.getLangOpts(), PathConsumers,
         CreateStoreMgr, CreateConstraintMgr, checkerMgr.get(), *Opts, Injector);
+
+    AnalyzerOptions::ConfigTable::const_iterator CachePath =
+        Opts->Config.find("summary-cache-path");
+    if (CachePath != Opts->Config.end() && !CachePath->second.empty()) {
+      SummaryCache = llvm::make_unique<FunctionSummaryCache>(
+          CachePath->second, *Ctx, Opts->maxBlockVisitOnPath);
+      FunctionSummaries.setStore(SummaryCache.get());
+    }
   }
 
   /// \brief Store the top level decls in the set to be processed later on.
@@ -518,7 +538,11 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
     // Introduce a scope to destroy BR before Mgr.
     BugReporter BR(*Mgr);
     TranslationUnitDecl *TU = C.getTranslationUnitDecl();
-    checkerMgr->runCheckersOnASTDecl(TU, *Mgr, BR);
+    // The translation unit checks only run in the first part of a split
+    // analysis, so that their reports aren't duplicated.
+    bool IsFirstShard = Opts->ShardIndex == 0;
+    if (IsFirstShard)
+      checkerMgr->runCheckersOnASTDecl(TU, *Mgr, BR);
 
     // Run the AST-only checks using the order in which functions are defined.
     // If inlining is not turned on, use the simplest function order for path
@@ -543,7 +567,8 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
       HandleDeclsCallGraph(LocalTUDeclsSize);
 
     // After all decls handled, run checkers on the entire TranslationUnit.
-    checkerMgr->runCheckersOnEndOfTranslationUnit(TU, *Mgr, BR);
+    if (IsFirstShard)
+      checkerMgr->runCheckersOnEndOfTranslationUnit(TU, *Mgr, BR);
 
     RecVisitorBR = nullptr;
   }
@@ -596,7 +621,19 @@ AnalysisConsumer::getModeForDecl(Decl *D, AnalysisMode Mode) {
   if (!Opts->AnalyzeAll && !SM.isWrittenInMainFile(SL)) {
     if (SL.isInvalid() || SM.isInSystemHeader(SL))
       return AM_None;
-    return Mode & ~AM_Path;
+    Mode &= ~AM_Path;
+  }
+
+  // When the analysis is split between several processes, the first one runs
+  // the syntax-based checks and the path-sensitive analysis of each function
+  // goes to the process its location hashes to. Every process parses the same
+  // translation unit, so they all agree on the raw source locations.
+  if (Opts->ShardCount > 1) {
+    if (Opts->ShardIndex != 0)
+      Mode &= ~AM_Syntax;
+    if (llvm::hash_value(D->getLocation().getRawEncoding()) %
+            Opts->ShardCount != Opts->ShardIndex)
+      Mode &= ~AM_Path;
   }
 
   return Mode;
@@ -664,6 +701,18 @@ void AnalysisConsumer::ActionExprEngine(Decl *D, bool ObjCGCEnabled,
   // created BugReporter.
   ExplodedNode::SetAuditor(nullptr);
 
+  if (Opts->PrintStats) {
+    ExplodedGraph &G = Eng.getGraph();
+    unsigned PeakNodes = G.getPeakSize();
+    size_t Bytes = G.getAllocatedBytes();
+    if (PeakNodes > MaxExplodedGraphSize)
+      MaxExplodedGraphSize = PeakNodes;
+    if (Bytes > MaxExplodedGraphBytes)
+      MaxExplodedGraphBytes = Bytes;
+    llvm::errs() << "STATS: " << getFunctionName(D) << ": " << PeakNodes
+                 << " peak exploded nodes, " << Bytes << " bytes\n";
+  }
+
   // Visualize the exploded graph.
   if (Mgr->options.visualizeExplodedGraphWithGraphViz)
     Eng.ViewGraph(Mgr->options.TrimGraph);
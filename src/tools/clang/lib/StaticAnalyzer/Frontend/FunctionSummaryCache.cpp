@@ -0,0 +1,87 @@
+//===-- FunctionSummaryCache.cpp --------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Every entry is an empty file whose name is the hash of its key; its presence
+// is the recorded fact. Concurrent analyses may create the same entry, which
+// is harmless.
+//
+//===----------------------------------------------------------------------===//
+
+#include "FunctionSummaryCache.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/Stmt.h"
+#include "clang/Index/USRGeneration.h"
+#include "clang/Lex/Lexer.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+using namespace ento;
+
+FunctionSummaryCache::FunctionSummaryCache(StringRef Dir, ASTContext &Ctx,
+                                           unsigned MaxBlockVisit)
+    : Dir(Dir), Ctx(Ctx), MaxBlockVisit(MaxBlockVisit) {}
+
+bool FunctionSummaryCache::getEntryPath(const Decl *D, StringRef Fact,
+                                        SmallString<128> &Path) {
+  const Stmt *Body = D->getBody();
+  if (!Body)
+    return false;
+
+  SmallString<128> USR;
+  if (index::generateUSRForDecl(D, USR))
+    return false;
+
+  SourceManager &SM = Ctx.getSourceManager();
+  bool Invalid = false;
+  StringRef Text = Lexer::getSourceText(
+      CharSourceRange::getTokenRange(Body->getSourceRange()), SM,
+      Ctx.getLangOpts(), &Invalid);
+  if (Invalid || Text.empty())
+    return false;
+
+  llvm::MD5 Hash;
+  Hash.update(Fact);
+  Hash.update(StringRef("", 1));
+  Hash.update(USR);
+  Hash.update(StringRef("", 1));
+  Hash.update(Text);
+  Hash.update(StringRef("", 1));
+  Hash.update(llvm::utostr(MaxBlockVisit));
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Name;
+  llvm::MD5::stringifyResult(Result, Name);
+
+  Path = Dir;
+  llvm::sys::path::append(Path, Name.str());
+  return true;
+}
+
+bool FunctionSummaryCache::reachedMaxBlockCount(const Decl *D) {
+  SmallString<128> Path;
+  return getEntryPath(D, "max-block-count", Path) &&
+         llvm::sys::fs::exists(Path.str());
+}
+
+void FunctionSummaryCache::recordReachedMaxBlockCount(const Decl *D) {
+  SmallString<128> Path;
+  if (!getEntryPath(D, "max-block-count", Path) ||
+      llvm::sys::fs::exists(Path.str()))
+    return;
+
+  if (llvm::sys::fs::create_directories(Dir))
+    return;
+  std::error_code EC;
+  llvm::raw_fd_ostream Entry(Path.str(), EC, llvm::sys::fs::F_None);
+}
@@ -0,0 +1,60 @@
+//===-- FunctionSummaryCache.h ----------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief This file defines the clang::ento::FunctionSummaryCache class, which
+/// keeps the function summaries of the analyzer in a directory shared between
+/// translation units and analysis runs.
+///
+/// An entry is keyed by the USR of the function, the text of its body and the
+/// analyzer settings the summary depends on, so editing a function or changing
+/// the settings discards what was learned about it.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SA_FRONTEND_FUNCTIONSUMMARYCACHE_H
+#define LLVM_CLANG_SA_FRONTEND_FUNCTIONSUMMARYCACHE_H
+
+#include "clang/StaticAnalyzer/Core/PathSensitive/FunctionSummary.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+
+namespace clang {
+
+class ASTContext;
+
+namespace ento {
+class FunctionSummaryCache : public FunctionSummaryStore {
+public:
+  /// \param Dir The directory holding the cache. It is created on the first
+  /// write.
+  ///
+  /// \param MaxBlockVisit The block visit limit of the analysis, which is
+  /// part of every key.
+  FunctionSummaryCache(StringRef Dir, ASTContext &Ctx, unsigned MaxBlockVisit);
+
+  bool reachedMaxBlockCount(const Decl *D) override;
+  void recordReachedMaxBlockCount(const Decl *D) override;
+
+private:
+  /// \brief Compute the path of the entry recording \p Fact about \p D.
+  ///
+  /// \returns false if \p D cannot be identified across translation units,
+  /// for instance because it has no USR or its body comes from a macro.
+  bool getEntryPath(const Decl *D, StringRef Fact, SmallString<128> &Path);
+
+  std::string Dir;
+  ASTContext &Ctx;
+  unsigned MaxBlockVisit;
+};
+}
+}
+
+#endif
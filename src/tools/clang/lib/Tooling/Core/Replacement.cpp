@@ -225,6 +225,23 @@ void deduplicate(std::vector<Replacement> &Replaces,
     Conflicts.push_back(Range(ConflictStart, ConflictLength));
 }
 
+void ReplacementCollector::add(const Replacement &Replace) {
+  std::lock_guard<std::mutex> Guard(Mutex);
+  Collected.insert(Replace);
+}
+
+void ReplacementCollector::add(const Replacements &Replaces) {
+  std::lock_guard<std::mutex> Guard(Mutex);
+  Collected.insert(Replaces.begin(), Replaces.end());
+}
+
+Replacements ReplacementCollector::take() {
+  std::lock_guard<std::mutex> Guard(Mutex);
+  Replacements Result;
+  Result.swap(Collected);
+  return Result;
+}
+
 bool applyAllReplacements(const Replacements &Replaces, Rewriter &Rewrite) {
   bool Result = true;
   for (Replacements::const_iterator I = Replaces.begin(),
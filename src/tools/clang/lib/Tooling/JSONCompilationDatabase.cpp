@@ -16,7 +16,12 @@
 #include "clang/Tooling/CompilationDatabasePluginRegistry.h"
 #include "clang/Tooling/Tooling.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/OnDiskHashTable.h"
 #include "llvm/Support/Path.h"
+#include <cstring>
 #include <system_error>
 
 namespace clang {
@@ -117,6 +122,124 @@ std::vector<std::string> unescapeCommandLine(
   return parser.parse();
 }
 
+const char CacheMagic[] = { 'C', 'D', 'B', 'C' };
+const uint32_t CacheVersion = 1;
+// Magic, version, JSON size and modification time, bucket and payload offsets.
+const size_t CacheHeaderSize = 32;
+
+/// \brief Trait used to write the table of a compilation database cache,
+/// which maps each file to its (directory, command line) pairs.
+class CacheWriterTrait {
+public:
+  typedef StringRef key_type;
+  typedef StringRef key_type_ref;
+  typedef const std::vector<std::pair<StringRef, StringRef>> *data_type;
+  typedef data_type data_type_ref;
+  typedef unsigned hash_value_type;
+  typedef unsigned offset_type;
+
+  static hash_value_type ComputeHash(key_type_ref Key) {
+    return llvm::HashString(Key);
+  }
+
+  std::pair<unsigned,unsigned>
+  EmitKeyDataLength(raw_ostream& Out, key_type_ref Key, data_type_ref Data) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    unsigned KeyLen = Key.size();
+    unsigned DataLen = 0;
+    for (const auto &Command : *Data)
+      DataLen += 8 + Command.first.size() + Command.second.size();
+    LE.write<uint16_t>(KeyLen);
+    LE.write<uint32_t>(DataLen);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  void EmitKey(raw_ostream& Out, key_type_ref Key, unsigned KeyLen) {
+    Out.write(Key.data(), KeyLen);
+  }
+
+  void EmitData(raw_ostream& Out, key_type_ref Key, data_type_ref Data,
+                unsigned DataLen) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    for (const auto &Command : *Data) {
+      LE.write<uint32_t>(Command.first.size());
+      Out << Command.first;
+      LE.write<uint32_t>(Command.second.size());
+      Out << Command.second;
+    }
+  }
+};
+
+/// \brief Trait used to read the table of a compilation database cache. The
+/// data is left encoded, see \c decodeCommands.
+class CacheReaderTrait {
+public:
+  typedef StringRef external_key_type;
+  typedef StringRef internal_key_type;
+  typedef StringRef data_type;
+  typedef unsigned hash_value_type;
+  typedef unsigned offset_type;
+
+  static bool EqualKey(const internal_key_type& a, const internal_key_type& b) {
+    return a == b;
+  }
+
+  static hash_value_type ComputeHash(const internal_key_type& a) {
+    return llvm::HashString(a);
+  }
+
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char*& d) {
+    using namespace llvm::support;
+    unsigned KeyLen = endian::readNext<uint16_t, little, unaligned>(d);
+    unsigned DataLen = endian::readNext<uint32_t, little, unaligned>(d);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static const internal_key_type&
+  GetInternalKey(const external_key_type& x) { return x; }
+
+  static const external_key_type&
+  GetExternalKey(const internal_key_type& x) { return x; }
+
+  static internal_key_type ReadKey(const unsigned char* d, unsigned n) {
+    return StringRef((const char *)d, n);
+  }
+
+  static data_type ReadData(const internal_key_type& k,
+                            const unsigned char* d,
+                            unsigned DataLen) {
+    return StringRef((const char *)d, DataLen);
+  }
+};
+
+/// \brief Decodes the (directory, command line) pairs of a cache entry.
+///
+/// Returns false if the entry is malformed.
+bool decodeCommands(StringRef Data,
+                    std::vector<std::pair<StringRef, StringRef>> &Commands) {
+  using namespace llvm::support;
+  auto ReadString = [&](StringRef &String) {
+    if (Data.size() < 4)
+      return false;
+    uint32_t Length = endian::read<uint32_t, little, unaligned>(Data.data());
+    if (Data.size() - 4 < Length)
+      return false;
+    String = Data.substr(4, Length);
+    Data = Data.drop_front(4 + Length);
+    return true;
+  };
+  while (!Data.empty()) {
+    StringRef Directory, CommandLine;
+    if (!ReadString(Directory) || !ReadString(CommandLine))
+      return false;
+    Commands.push_back(std::make_pair(Directory, CommandLine));
+  }
+  return true;
+}
+
 class JSONCompilationDatabasePlugin : public CompilationDatabasePlugin {
   std::unique_ptr<CompilationDatabase>
   loadFromDirectory(StringRef Directory, std::string &ErrorMessage) override {
@@ -141,9 +264,44 @@ X("json-compilation-database", "Reads JSON formatted compilation databases");
 // and thus register the JSONCompilationDatabasePlugin.
 volatile int JSONAnchorSource = 0;
 
+/// \brief A memory mapped binary cache of a JSON compilation database.
+class CompileCommandCache {
+public:
+  typedef llvm::OnDiskIterableChainedHashTable<CacheReaderTrait> TableType;
+
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  std::unique_ptr<TableType> Table;
+};
+
+JSONCompilationDatabase::JSONCompilationDatabase(
+    std::unique_ptr<llvm::MemoryBuffer> Database)
+    : Database(std::move(Database)) {}
+
+JSONCompilationDatabase::~JSONCompilationDatabase() {}
+
 std::unique_ptr<JSONCompilationDatabase>
 JSONCompilationDatabase::loadFromFile(StringRef FilePath,
                                       std::string &ErrorMessage) {
+  // The cache is only trusted while the JSON file keeps the size and the
+  // modification time it had when the cache was written.
+  std::string CachePath = (FilePath + ".cache").str();
+  llvm::sys::fs::file_status Status;
+  bool HasStatus = !llvm::sys::fs::status(FilePath, Status);
+  uint64_t Size = HasStatus ? Status.getSize() : 0;
+  uint64_t ModificationTime =
+      HasStatus ? Status.getLastModificationTime().toEpochTime() : 0;
+  if (HasStatus) {
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> CacheBuffer =
+        llvm::MemoryBuffer::getFile(CachePath, /*FileSize=*/-1,
+                                    /*RequiresNullTerminator=*/false);
+    if (CacheBuffer) {
+      std::unique_ptr<JSONCompilationDatabase> Database(
+          new JSONCompilationDatabase(nullptr));
+      if (Database->loadCache(std::move(*CacheBuffer), Size, ModificationTime))
+        return Database;
+    }
+  }
+
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> DatabaseBuffer =
       llvm::MemoryBuffer::getFile(FilePath);
   if (std::error_code Result = DatabaseBuffer.getError()) {
@@ -154,6 +312,8 @@ JSONCompilationDatabase::loadFromFile(StringRef FilePath,
       new JSONCompilationDatabase(std::move(*DatabaseBuffer)));
   if (!Database->parse(ErrorMessage))
     return nullptr;
+  if (HasStatus)
+    Database->writeCache(CachePath, Size, ModificationTime);
   return Database;
 }
 
@@ -174,17 +334,17 @@ JSONCompilationDatabase::getCompileCommands(StringRef FilePath) const {
   SmallString<128> NativeFilePath;
   llvm::sys::path::native(FilePath, NativeFilePath);
 
+  std::vector<CompileCommand> Commands;
+  lookupCommands(NativeFilePath, Commands);
+  if (!Commands.empty())
+    return Commands;
+
   std::string Error;
   llvm::raw_string_ostream ES(Error);
-  StringRef Match = MatchTrie.findEquivalent(NativeFilePath.str(), ES);
-  if (Match.empty())
-    return std::vector<CompileCommand>();
-  llvm::StringMap< std::vector<CompileCommandRef> >::const_iterator
-    CommandsRefI = IndexByFile.find(Match);
-  if (CommandsRefI == IndexByFile.end())
-    return std::vector<CompileCommand>();
-  std::vector<CompileCommand> Commands;
-  getCommands(CommandsRefI->getValue(), Commands);
+  StringRef Match = getMatchTrie().findEquivalent(NativeFilePath.str(), ES);
+  if (Match.empty() || Match == NativeFilePath.str())
+    return Commands;
+  lookupCommands(Match, Commands);
   return Commands;
 }
 
@@ -192,6 +352,12 @@ std::vector<std::string>
 JSONCompilationDatabase::getAllFiles() const {
   std::vector<std::string> Result;
 
+  if (Cache) {
+    for (StringRef File : Cache->Table->keys())
+      Result.push_back(File.str());
+    return Result;
+  }
+
   llvm::StringMap< std::vector<CompileCommandRef> >::const_iterator
     CommandsRefI = IndexByFile.begin();
   const llvm::StringMap< std::vector<CompileCommandRef> >::const_iterator
@@ -206,6 +372,12 @@ JSONCompilationDatabase::getAllFiles() const {
 std::vector<CompileCommand>
 JSONCompilationDatabase::getAllCompileCommands() const {
   std::vector<CompileCommand> Commands;
+  if (Cache) {
+    for (StringRef File : Cache->Table->keys())
+      lookupCommands(File, Commands);
+    return Commands;
+  }
+
   for (llvm::StringMap< std::vector<CompileCommandRef> >::const_iterator
         CommandsRefI = IndexByFile.begin(), CommandsRefEnd = IndexByFile.end();
       CommandsRefI != CommandsRefEnd; ++CommandsRefI) {
@@ -218,18 +390,119 @@ void JSONCompilationDatabase::getCommands(
                                   ArrayRef<CompileCommandRef> CommandsRef,
                                   std::vector<CompileCommand> &Commands) const {
   for (int I = 0, E = CommandsRef.size(); I != E; ++I) {
-    SmallString<8> DirectoryStorage;
-    SmallString<1024> CommandStorage;
     Commands.push_back(CompileCommand(
       // FIXME: Escape correctly:
-      CommandsRef[I].first->getValue(DirectoryStorage),
-      unescapeCommandLine(CommandsRef[I].second->getValue(CommandStorage))));
+      CommandsRef[I].first,
+      unescapeCommandLine(CommandsRef[I].second)));
+  }
+}
+
+void JSONCompilationDatabase::lookupCommands(
+    StringRef NativeFilePath, std::vector<CompileCommand> &Commands) const {
+  if (!Cache) {
+    auto CommandsRefI = IndexByFile.find(NativeFilePath);
+    if (CommandsRefI != IndexByFile.end())
+      getCommands(CommandsRefI->getValue(), Commands);
+    return;
+  }
+
+  auto Entry = Cache->Table->find(NativeFilePath);
+  if (Entry == Cache->Table->end())
+    return;
+  std::vector<CompileCommandRef> CommandsRef;
+  if (decodeCommands(*Entry, CommandsRef))
+    getCommands(CommandsRef, Commands);
+}
+
+const FileMatchTrie &JSONCompilationDatabase::getMatchTrie() const {
+  std::call_once(MatchTrieBuilt, [this] {
+    for (const std::string &File : getAllFiles())
+      MatchTrie.insert(File);
+  });
+  return MatchTrie;
+}
+
+bool JSONCompilationDatabase::loadCache(
+    std::unique_ptr<llvm::MemoryBuffer> Buffer, uint64_t Size,
+    uint64_t ModificationTime) {
+  using namespace llvm::support;
+  StringRef Data = Buffer->getBuffer();
+  if (Data.size() < CacheHeaderSize ||
+      memcmp(Data.data(), CacheMagic, sizeof(CacheMagic)) != 0)
+    return false;
+  const char *Header = Data.data() + sizeof(CacheMagic);
+  if (endian::read<uint32_t, little, unaligned>(Header) != CacheVersion ||
+      endian::read<uint64_t, little, unaligned>(Header + 4) != Size ||
+      endian::read<uint64_t, little, unaligned>(Header + 12) !=
+          ModificationTime)
+    return false;
+  uint32_t BucketOffset = endian::read<uint32_t, little, unaligned>(Header + 20);
+  uint32_t PayloadOffset =
+      endian::read<uint32_t, little, unaligned>(Header + 24);
+  if (BucketOffset < CacheHeaderSize || BucketOffset % 4 != 0 ||
+      BucketOffset + 8 > Data.size() || PayloadOffset < CacheHeaderSize ||
+      PayloadOffset > BucketOffset)
+    return false;
+
+  const unsigned char *Base = (const unsigned char *)Data.data();
+  Cache.reset(new CompileCommandCache());
+  Cache->Table.reset(CompileCommandCache::TableType::Create(
+      Base + BucketOffset, Base + PayloadOffset, Base));
+  Cache->Buffer = std::move(Buffer);
+  return true;
+}
+
+void JSONCompilationDatabase::writeCache(StringRef CachePath, uint64_t Size,
+                                         uint64_t ModificationTime) const {
+  llvm::OnDiskChainedHashTableGenerator<CacheWriterTrait> Generator;
+  for (const auto &Entry : IndexByFile)
+    Generator.insert(Entry.getKey(), &Entry.getValue());
+
+  SmallString<4096> Buffer;
+  uint32_t BucketOffset, PayloadOffset;
+  {
+    using namespace llvm::support;
+    llvm::raw_svector_ostream Out(Buffer);
+    endian::Writer<little> LE(Out);
+    Out.write(CacheMagic, sizeof(CacheMagic));
+    LE.write<uint32_t>(CacheVersion);
+    LE.write<uint64_t>(Size);
+    LE.write<uint64_t>(ModificationTime);
+    // Leave room for the offsets of the buckets and the payload.
+    LE.write<uint32_t>(0);
+    LE.write<uint32_t>(0);
+    PayloadOffset = Out.tell();
+    BucketOffset = Generator.Emit(Out);
   }
+  using namespace llvm::support;
+  endian::write<uint32_t, little, unaligned>(Buffer.data() + 24, BucketOffset);
+  endian::write<uint32_t, little, unaligned>(Buffer.data() + 28,
+                                             PayloadOffset);
+
+  // Write to a temporary file first, so that concurrent loads never see a
+  // partially written cache. Failing to write the cache is not an error.
+  int FD;
+  SmallString<128> TempPath;
+  if (llvm::sys::fs::createUniqueFile(CachePath + "-%%%%%%%%", FD, TempPath))
+    return;
+  {
+    llvm::raw_fd_ostream Out(FD, /*shouldClose=*/true);
+    Out << Buffer.str();
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      llvm::sys::fs::remove(TempPath.str());
+      return;
+    }
+  }
+  if (llvm::sys::fs::rename(TempPath.str(), CachePath))
+    llvm::sys::fs::remove(TempPath.str());
 }
 
 bool JSONCompilationDatabase::parse(std::string &ErrorMessage) {
-  llvm::yaml::document_iterator I = YAMLStream.begin();
-  if (I == YAMLStream.end()) {
+  YAMLStream.reset(new llvm::yaml::Stream(Database->getBuffer(), SM));
+  llvm::yaml::document_iterator I = YAMLStream->begin();
+  if (I == YAMLStream->end()) {
     ErrorMessage = "Error while parsing YAML.";
     return false;
   }
@@ -301,22 +574,32 @@ bool JSONCompilationDatabase::parse(std::string &ErrorMessage) {
     }
     SmallString<8> FileStorage;
     StringRef FileName = File->getValue(FileStorage);
+    StringRef DirectoryValue = getUnescapedValue(Directory);
     SmallString<128> NativeFilePath;
     if (llvm::sys::path::is_relative(FileName)) {
-      SmallString<8> DirectoryStorage;
-      SmallString<128> AbsolutePath(
-          Directory->getValue(DirectoryStorage));
+      SmallString<128> AbsolutePath(DirectoryValue);
       llvm::sys::path::append(AbsolutePath, FileName);
       llvm::sys::path::native(AbsolutePath.str(), NativeFilePath);
     } else {
       llvm::sys::path::native(FileName, NativeFilePath);
     }
     IndexByFile[NativeFilePath].push_back(
-        CompileCommandRef(Directory, Command));
-    MatchTrie.insert(NativeFilePath.str());
+        CompileCommandRef(DirectoryValue, getUnescapedValue(Command)));
   }
   return true;
 }
 
+StringRef
+JSONCompilationDatabase::getUnescapedValue(llvm::yaml::ScalarNode *Node) {
+  SmallString<128> Storage;
+  StringRef Value = Node->getValue(Storage);
+  // Values without escapes point into the database itself.
+  if (Value.data() != Storage.data())
+    return Value;
+  char *Copy = Strings.Allocate<char>(Value.size());
+  std::copy(Value.begin(), Value.end(), Copy);
+  return StringRef(Copy, Value.size());
+}
+
 } // end namespace tooling
 } // end namespace clang
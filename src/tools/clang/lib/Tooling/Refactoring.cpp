@@ -54,6 +54,8 @@ int RefactoringTool::runAndSave(FrontendActionFactory *ActionFactory) {
 }
 
 bool RefactoringTool::applyAllReplacements(Rewriter &Rewrite) {
+  Replacements Collected = Collector.take();
+  Replace.insert(Collected.begin(), Collected.end());
   return tooling::applyAllReplacements(Replace, Rewrite);
 }
 
@@ -14,22 +14,36 @@
 
 #include "clang/Tooling/Tooling.h"
 #include "clang/AST/ASTConsumer.h"
+#include "clang/Basic/FileSystemStatCache.h"
 #include "clang/Driver/Compilation.h"
 #include "clang/Driver/Driver.h"
 #include "clang/Driver/Tool.h"
+#include "clang/Driver/Types.h"
 #include "clang/Frontend/ASTUnit.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/FrontendActions.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/TextDiagnosticPrinter.h"
+#include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/PPCallbacks.h"
+#include "clang/Lex/Preprocessor.h"
 #include "clang/Tooling/ArgumentsAdjusters.h"
 #include "clang/Tooling/CompilationDatabase.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Config/llvm-config.h"
 #include "llvm/Option/Option.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
 
 // For chdir, see the comment in ClangTool::run for more information.
 #ifdef LLVM_ON_WIN32
@@ -286,7 +300,8 @@ ClangTool::ClangTool(const CompilationDatabase &Compilations,
                      ArrayRef<std::string> SourcePaths,
                      SharedModuleProvider MP)
   : Compilations(Compilations), SourcePaths(SourcePaths), MP(MP),
-      Files(new FileManager(FileSystemOptions())), DiagConsumer(nullptr) {
+      Files(new FileManager(FileSystemOptions())), DiagConsumer(nullptr),
+      NumThreads(1) {
   appendArgumentsAdjuster(getClangStripOutputAdjuster());
   appendArgumentsAdjuster(getClangSyntaxOnlyAdjuster());
 }
@@ -320,6 +335,9 @@ int ClangTool::run(ToolAction *Action) {
   std::string MainExecutable =
       llvm::sys::fs::getMainExecutable("clang_tool", &StaticSymbol);
 
+  if (NumThreads != 1 || !SharedPCHDirectory.empty())
+    return runCollectedCommands(Action, MainExecutable);
+
   llvm::SmallString<128> InitialDirectory;
   if (std::error_code EC = llvm::sys::fs::current_path(InitialDirectory))
     llvm::report_fatal_error("Cannot detect current path: " +
@@ -386,8 +404,549 @@ int ClangTool::run(ToolAction *Action) {
 
 namespace {
 
+/// \brief The results of the stat calls of concurrently running tool
+/// invocations, which are missing files when there is no data.
+struct SharedStatCalls {
+  std::mutex Mutex;
+  llvm::StringMap<llvm::Optional<FileData>> StatCalls;
+};
+
+/// \brief A stat cache that shares the results for absolute paths with the
+/// file managers of the other tool invocations.
+///
+/// Missing files are remembered too: every compilation database has prepared
+/// the file system before the invocations start running.
+class SharedStatCache : public FileSystemStatCache {
+  SharedStatCalls &Shared;
+
+public:
+  explicit SharedStatCache(SharedStatCalls &Shared) : Shared(Shared) {}
+
+  LookupResult getStat(const char *Path, FileData &Data, bool isFile,
+                       std::unique_ptr<vfs::File> *F,
+                       vfs::FileSystem &FS) override {
+    // Relative paths depend on the working directory of the invocation.
+    if (!llvm::sys::path::is_absolute(Path))
+      return statChained(Path, Data, isFile, F, FS);
+
+    {
+      std::lock_guard<std::mutex> Guard(Shared.Mutex);
+      auto Known = Shared.StatCalls.find(Path);
+      if (Known != Shared.StatCalls.end()) {
+        if (!Known->second)
+          return CacheMissing;
+        Data = *Known->second;
+        return CacheExists;
+      }
+    }
+
+    LookupResult Result = statChained(Path, Data, isFile, F, FS);
+    // Files mapped by an overlay are not seen by all invocations.
+    if (Result == CacheExists && Data.IsVFSMapped)
+      return Result;
+
+    std::lock_guard<std::mutex> Guard(Shared.Mutex);
+    if (Result == CacheExists)
+      Shared.StatCalls[Path] = Data;
+    else
+      Shared.StatCalls[Path] = llvm::None;
+    return Result;
+  }
+};
+
+/// \brief The state of a diagnostic consumer shared by concurrently running
+/// tool invocations.
+struct SharedDiagnostics {
+  std::mutex Mutex;
+  DiagnosticConsumer *Target;
+  /// \brief The invocation whose source file the consumer is in, if any.
+  const void *CurrentOwner;
+  SharedDiagnostics(DiagnosticConsumer *Target)
+    : Target(Target), CurrentOwner(nullptr) {}
+};
+
+/// \brief Forwards the diagnostics of one tool invocation to the consumer of
+/// the tool, one diagnostic at a time.
+///
+/// Before forwarding, the consumer is moved into the source file of the
+/// invocation, since it may have been given another one in the meantime.
+class SerializingDiagnosticConsumer : public DiagnosticConsumer {
+  SharedDiagnostics &Shared;
+  const LangOptions *LangOpts;
+  const Preprocessor *PP;
+
+public:
+  explicit SerializingDiagnosticConsumer(SharedDiagnostics &Shared)
+    : Shared(Shared), LangOpts(nullptr), PP(nullptr) {}
+
+  void BeginSourceFile(const LangOptions &LO,
+                       const Preprocessor *PP) override {
+    LangOpts = &LO;
+    this->PP = PP;
+  }
+
+  void EndSourceFile() override {
+    std::lock_guard<std::mutex> Guard(Shared.Mutex);
+    if (Shared.CurrentOwner == this) {
+      Shared.Target->EndSourceFile();
+      Shared.CurrentOwner = nullptr;
+    }
+    LangOpts = nullptr;
+    PP = nullptr;
+  }
+
+  void HandleDiagnostic(DiagnosticsEngine::Level DiagLevel,
+                        const Diagnostic &Info) override {
+    DiagnosticConsumer::HandleDiagnostic(DiagLevel, Info);
+
+    std::lock_guard<std::mutex> Guard(Shared.Mutex);
+    if (Shared.CurrentOwner != this) {
+      if (Shared.CurrentOwner)
+        Shared.Target->EndSourceFile();
+      Shared.CurrentOwner = nullptr;
+      if (LangOpts) {
+        Shared.Target->BeginSourceFile(*LangOpts, PP);
+        Shared.CurrentOwner = this;
+      }
+    }
+    Shared.Target->HandleDiagnostic(DiagLevel, Info);
+  }
+};
+
+/// \brief A compile command to run, with its arguments already adjusted.
+struct ToolJob {
+  std::string File;
+  std::string Directory;
+  std::vector<std::string> CommandLine;
+};
+
+/// \brief Call \p Run for 0 to \p Count - 1 on \p Threads threads, one of
+/// which is the calling thread.
+void runOnThreads(unsigned Threads, size_t Count,
+                  const std::function<void(size_t)> &Run) {
+  std::atomic<size_t> Next(0);
+  auto Work = [&] {
+    for (size_t I = Next++; I < Count; I = Next++)
+      Run(I);
+  };
+
+  if (Threads > Count)
+    Threads = Count;
+  std::vector<std::thread> Workers;
+  for (unsigned I = 1; I < Threads; ++I)
+    Workers.push_back(std::thread(Work));
+  Work();
+  for (std::thread &Worker : Workers)
+    Worker.join();
+}
+
+/// \brief The #include and #import directives a source file starts with,
+/// and the arguments it compiles them with.
+struct IncludePrefix {
+  /// \brief Identifies the arguments, the directory of the command and the
+  /// directory of the source file; only prefixes with the same configuration
+  /// can share a PCH.
+  std::string Configuration;
+  std::vector<std::string> Arguments;
+  std::vector<std::string> Includes;
+  const char *HeaderLanguage;
+  IncludePrefix() : HeaderLanguage(nullptr) {}
+};
+
+/// \brief Returns the -x language for headers of the language of \p File,
+/// or null if it has none.
+const char *getHeaderLanguage(StringRef File) {
+  StringRef Extension = llvm::sys::path::extension(File);
+  if (Extension.empty())
+    return nullptr;
+  switch (driver::types::lookupTypeForExtension(
+              Extension.drop_front().str().c_str())) {
+  case driver::types::TY_C:
+    return "c-header";
+  case driver::types::TY_CXX:
+    return "c++-header";
+  case driver::types::TY_ObjC:
+    return "objective-c-header";
+  case driver::types::TY_ObjCXX:
+    return "objective-c++-header";
+  default:
+    return nullptr;
+  }
+}
+
+/// \brief Returns the #include and #import lines that \p Code starts with,
+/// skipping blank lines and comments.
+std::vector<std::string> getLeadingIncludes(StringRef Code) {
+  std::vector<std::string> Includes;
+  bool InBlockComment = false;
+  while (!Code.empty()) {
+    StringRef Line;
+    std::tie(Line, Code) = Code.split('\n');
+    Line = Line.trim();
+    if (InBlockComment || Line.startswith("/*")) {
+      size_t End = Line.find("*/", InBlockComment ? 0 : 2);
+      InBlockComment = End == StringRef::npos;
+      if (InBlockComment)
+        continue;
+      Line = Line.substr(End + 2).ltrim();
+    }
+    if (Line.empty() || Line.startswith("//"))
+      continue;
+    if (!Line.startswith("#"))
+      break;
+    StringRef Directive = Line.drop_front().ltrim();
+    if ((!Directive.startswith("include") && !Directive.startswith("import")) ||
+        Directive.startswith("include_next"))
+      break;
+    // A comment may start after the directive and span the following lines.
+    size_t CommentStart = Line.rfind("/*");
+    if (CommentStart != StringRef::npos &&
+        Line.find("*/", CommentStart) == StringRef::npos)
+      InBlockComment = true;
+    Includes.push_back(Line);
+  }
+  return Includes;
+}
+
+/// \brief Compute the include prefix of \p Job; it is left without includes
+/// if the job cannot use a shared PCH.
+void computeIncludePrefix(
+    const ToolJob &Job,
+    ArrayRef<std::pair<StringRef, StringRef>> MappedFileContents,
+    IncludePrefix &Prefix) {
+  Prefix.HeaderLanguage = getHeaderLanguage(Job.File);
+  if (!Prefix.HeaderLanguage)
+    return;
+
+  StringRef FileName = llvm::sys::path::filename(Job.File);
+  for (size_t I = 1, E = Job.CommandLine.size(); I != E; ++I) {
+    StringRef Arg = Job.CommandLine[I];
+    // Explicit languages and other PCHs cannot be combined with the prefix.
+    if (Arg.startswith("-x") || Arg == "-include-pch" || Arg == "-E")
+      return;
+    // The PCH is built under its own name, and without dependency files.
+    if (Arg == "-fsyntax-only")
+      continue;
+    if (Arg == "-MF" || Arg == "-MT" || Arg == "-MQ") {
+      ++I;
+      continue;
+    }
+    if (Arg.startswith("-M"))
+      continue;
+    if (!Arg.startswith("-") && llvm::sys::path::filename(Arg) == FileName)
+      continue;
+    Prefix.Arguments.push_back(Arg);
+  }
+
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  StringRef Code;
+  for (const auto &MappedFile : MappedFileContents) {
+    if (getAbsolutePath(MappedFile.first) == Job.File) {
+      Code = MappedFile.second;
+      break;
+    }
+  }
+  if (Code.empty()) {
+    auto BufferOrError = llvm::MemoryBuffer::getFile(Job.File);
+    if (!BufferOrError)
+      return;
+    Buffer = std::move(*BufferOrError);
+    Code = Buffer->getBuffer();
+  }
+
+  Prefix.Configuration = Job.Directory;
+  Prefix.Configuration += '\0';
+  Prefix.Configuration += llvm::sys::path::parent_path(Job.File);
+  for (const std::string &Arg : Prefix.Arguments) {
+    Prefix.Configuration += '\0';
+    Prefix.Configuration += Arg;
+  }
+  Prefix.Includes = getLeadingIncludes(Code);
+}
+
+/// \brief Records the files entered while preprocessing, apart from the main
+/// file.
+class EnteredFilesCallbacks : public PPCallbacks {
+  SourceManager &SM;
+  std::vector<const FileEntry *> &Entered;
+
+public:
+  EnteredFilesCallbacks(SourceManager &SM,
+                        std::vector<const FileEntry *> &Entered)
+    : SM(SM), Entered(Entered) {}
+
+  void FileChanged(SourceLocation Loc, FileChangeReason Reason,
+                   SrcMgr::CharacteristicKind FileType,
+                   FileID PrevFID) override {
+    if (Reason != EnterFile)
+      return;
+    FileID FID = SM.getFileID(SM.getExpansionLoc(Loc));
+    if (FID == SM.getMainFileID())
+      return;
+    if (const FileEntry *File = SM.getFileEntryForID(FID))
+      Entered.push_back(File);
+  }
+};
+
+/// \brief Generates the PCH of an include prefix, noting whether all headers
+/// in it have include guards.
+class IncludePrefixPCHAction : public GeneratePCHAction {
+  bool &AllGuarded;
+  std::vector<const FileEntry *> Entered;
+
+public:
+  explicit IncludePrefixPCHAction(bool &AllGuarded) : AllGuarded(AllGuarded) {}
+
+  bool BeginSourceFileAction(CompilerInstance &CI,
+                             StringRef Filename) override {
+    CI.getPreprocessor().addPPCallbacks(
+        llvm::make_unique<EnteredFilesCallbacks>(CI.getSourceManager(),
+                                                 Entered));
+    return true;
+  }
+
+  void EndSourceFileAction() override {
+    HeaderSearch &HS =
+        getCompilerInstance().getPreprocessor().getHeaderSearchInfo();
+    for (const FileEntry *File : Entered)
+      if (!HS.isFileMultipleIncludeGuarded(File))
+        AllGuarded = false;
+  }
+};
+
+class IncludePrefixPCHActionFactory : public FrontendActionFactory {
+public:
+  bool AllGuarded;
+  IncludePrefixPCHActionFactory() : AllGuarded(true) {}
+  clang::FrontendAction *create() override {
+    return new IncludePrefixPCHAction(AllGuarded);
+  }
+};
+
+/// \brief Precompile the first \p NumIncludes includes of \p Prefix, which
+/// \p Job starts with, into a PCH in \p Directory named after \p Key.
+///
+/// \returns The PCH file, or an empty string if it could not be built or may
+/// not be used.
+std::string buildIncludePrefixPCH(
+    const ToolJob &Job, const IncludePrefix &Prefix, unsigned NumIncludes,
+    StringRef Key, StringRef Directory,
+    ArrayRef<std::pair<StringRef, StringRef>> MappedFileContents,
+    SharedModuleProvider MP, SharedStatCalls &Stats) {
+  llvm::MD5 Hash;
+  Hash.update(Key);
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Digest;
+  llvm::MD5::stringifyResult(Result, Digest);
+
+  SmallString<128> HeaderFile(Directory);
+  llvm::sys::path::append(HeaderFile, "prefix-" + Digest.str() + ".h");
+  SmallString<128> PCHFile(HeaderFile);
+  llvm::sys::path::replace_extension(PCHFile, "pch");
+  {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(HeaderFile, EC, llvm::sys::fs::F_Text);
+    if (EC)
+      return std::string();
+    for (unsigned I = 0; I != NumIncludes; ++I)
+      OS << Prefix.Includes[I] << '\n';
+  }
+
+  std::vector<std::string> CommandLine;
+  CommandLine.push_back(Job.CommandLine[0]);
+  // Quoted includes are looked up next to the source file first.
+  CommandLine.push_back("-iquote");
+  CommandLine.push_back(llvm::sys::path::parent_path(Job.File));
+  CommandLine.insert(CommandLine.end(), Prefix.Arguments.begin(),
+                     Prefix.Arguments.end());
+  CommandLine.push_back("-x");
+  CommandLine.push_back(Prefix.HeaderLanguage);
+  CommandLine.push_back(HeaderFile.str());
+  CommandLine.push_back("-o");
+  CommandLine.push_back(PCHFile.str());
+
+  FileSystemOptions FileSystemOpts;
+  FileSystemOpts.WorkingDir = Job.Directory;
+  IntrusiveRefCntPtr<FileManager> Files(new FileManager(FileSystemOpts));
+  Files->addStatCache(llvm::make_unique<SharedStatCache>(Stats));
+
+  // The source files report any errors in the headers themselves.
+  IgnoringDiagConsumer IgnoreDiagnostics;
+  IncludePrefixPCHActionFactory Factory;
+  ToolInvocation Invocation(std::move(CommandLine), &Factory, Files.get(), MP);
+  Invocation.setDiagnosticConsumer(&IgnoreDiagnostics);
+  for (const auto &MappedFile : MappedFileContents)
+    Invocation.mapVirtualFile(MappedFile.first, MappedFile.second);
+  if (!Invocation.run() || !Factory.AllGuarded) {
+    llvm::sys::fs::remove(PCHFile.str());
+    return std::string();
+  }
+  return PCHFile.str();
+}
+
+/// \brief Build the PCHs of the include prefixes that several jobs share, on
+/// \p Threads threads, and make the jobs include them.
+void addSharedPCHs(std::vector<ToolJob> &Jobs, unsigned Threads,
+                   StringRef Directory,
+                   ArrayRef<std::pair<StringRef, StringRef>> MappedFileContents,
+                   SharedModuleProvider MP, SharedStatCalls &Stats) {
+  if (std::error_code EC = llvm::sys::fs::create_directories(Directory)) {
+    llvm::errs() << "Cannot create directory " << Directory << ": "
+                 << EC.message() << ". Not sharing PCHs.\n";
+    return;
+  }
+
+  // Count how many jobs start with each prefix of their includes.
+  std::vector<IncludePrefix> Prefixes(Jobs.size());
+  llvm::StringMap<unsigned> NumJobs;
+  for (size_t I = 0, E = Jobs.size(); I != E; ++I) {
+    computeIncludePrefix(Jobs[I], MappedFileContents, Prefixes[I]);
+    std::string Key = Prefixes[I].Configuration;
+    for (const std::string &Include : Prefixes[I].Includes) {
+      Key += '\n';
+      Key += Include;
+      ++NumJobs[Key];
+    }
+  }
+
+  // Each job uses the longest prefix it shares with another job.
+  struct SharedPCH {
+    size_t Job;
+    unsigned NumIncludes;
+    std::string Key;
+    std::string File;
+  };
+  std::vector<SharedPCH> PCHs;
+  llvm::StringMap<size_t> PCHsByKey;
+  std::vector<size_t> PCHOfJob(Jobs.size(), ~size_t(0));
+  for (size_t I = 0, E = Jobs.size(); I != E; ++I) {
+    std::string Key = Prefixes[I].Configuration;
+    std::string SharedKey;
+    unsigned NumIncludes = 0;
+    for (unsigned N = 0, NE = Prefixes[I].Includes.size(); N != NE; ++N) {
+      Key += '\n';
+      Key += Prefixes[I].Includes[N];
+      if (NumJobs[Key] > 1) {
+        SharedKey = Key;
+        NumIncludes = N + 1;
+      }
+    }
+    if (!NumIncludes)
+      continue;
+    auto Known = PCHsByKey.insert(std::make_pair(SharedKey, PCHs.size()));
+    if (Known.second)
+      PCHs.push_back({I, NumIncludes, SharedKey, std::string()});
+    PCHOfJob[I] = Known.first->second;
+  }
+
+  runOnThreads(Threads, PCHs.size(), [&](size_t I) {
+    SharedPCH &PCH = PCHs[I];
+    PCH.File = buildIncludePrefixPCH(Jobs[PCH.Job], Prefixes[PCH.Job],
+                                     PCH.NumIncludes, PCH.Key, Directory,
+                                     MappedFileContents, MP, Stats);
+  });
+
+  for (size_t I = 0, E = Jobs.size(); I != E; ++I) {
+    if (PCHOfJob[I] == ~size_t(0) || PCHs[PCHOfJob[I]].File.empty())
+      continue;
+    std::vector<std::string> &CommandLine = Jobs[I].CommandLine;
+    CommandLine.insert(CommandLine.begin() + 1, "-include-pch");
+    CommandLine.insert(CommandLine.begin() + 2, PCHs[PCHOfJob[I]].File);
+  }
+}
+
+}
+
+int ClangTool::runCollectedCommands(ToolAction *Action,
+                                    const std::string &MainExecutable) {
+  // Retrieve all compile commands up front, since compilation databases may
+  // change the state of the file system as they do so.
+  std::vector<ToolJob> Jobs;
+  for (const auto &SourcePath : SourcePaths) {
+    std::string File(getAbsolutePath(SourcePath));
+    std::vector<CompileCommand> CompileCommandsForFile =
+        Compilations.getCompileCommands(File);
+    if (CompileCommandsForFile.empty()) {
+      llvm::errs() << "Skipping " << File << ". Compile command not found.\n";
+      continue;
+    }
+    for (CompileCommand &CompileCommand : CompileCommandsForFile) {
+      ToolJob Job;
+      Job.File = File;
+      Job.Directory = CompileCommand.Directory;
+      Job.CommandLine = CompileCommand.CommandLine;
+      if (ArgsAdjuster)
+        Job.CommandLine = ArgsAdjuster(Job.CommandLine);
+      assert(!Job.CommandLine.empty());
+      Job.CommandLine[0] = MainExecutable;
+      Jobs.push_back(std::move(Job));
+    }
+  }
+
+  unsigned Threads = NumThreads;
+  if (!Threads)
+    Threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+  SharedStatCalls Stats;
+  if (!SharedPCHDirectory.empty())
+    addSharedPCHs(Jobs, Threads, SharedPCHDirectory, MappedFileContents, MP,
+                  Stats);
+
+  SharedDiagnostics Diags(DiagConsumer);
+  // Guards the output of the invocations to llvm::errs().
+  std::mutex OutputMutex;
+  std::atomic<bool> ProcessingFailed(false);
+
+  runOnThreads(Threads, Jobs.size(), [&](size_t I) {
+    ToolJob &Job = Jobs[I];
+    DEBUG({
+      std::lock_guard<std::mutex> Guard(OutputMutex);
+      llvm::dbgs() << "Processing: " << Job.File << ".\n";
+    });
+
+    // Resolve relative paths against the directory of the command through
+    // the file manager, rather than with chdir.
+    FileSystemOptions FileSystemOpts;
+    FileSystemOpts.WorkingDir = Job.Directory;
+    IntrusiveRefCntPtr<FileManager> JobFiles(new FileManager(FileSystemOpts));
+    JobFiles->addStatCache(llvm::make_unique<SharedStatCache>(Stats));
+
+    // Without a consumer of the tool, print the diagnostics of each
+    // invocation in one piece once it is done.
+    std::string Output;
+    llvm::raw_string_ostream OS(Output);
+    IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts = new DiagnosticOptions();
+    TextDiagnosticPrinter DiagnosticPrinter(OS, &*DiagOpts);
+    SerializingDiagnosticConsumer Serializer(Diags);
+
+    ToolInvocation Invocation(std::move(Job.CommandLine), Action,
+                              JobFiles.get(), MP);
+    if (DiagConsumer)
+      Invocation.setDiagnosticConsumer(&Serializer);
+    else
+      Invocation.setDiagnosticConsumer(&DiagnosticPrinter);
+    for (const auto &MappedFile : MappedFileContents)
+      Invocation.mapVirtualFile(MappedFile.first, MappedFile.second);
+    bool Success = Invocation.run();
+
+    std::lock_guard<std::mutex> Guard(OutputMutex);
+    llvm::errs() << OS.str();
+    if (!Success) {
+      llvm::errs() << "Error while processing " << Job.File << ".\n";
+      ProcessingFailed = true;
+    }
+  });
+
+  return ProcessingFailed ? 1 : 0;
+}
+
+namespace {
+
 class ASTBuilderAction : public ToolAction {
   std::vector<std::unique_ptr<ASTUnit>> &ASTs;
+  /// \brief Guards ASTs, for tools that run concurrently.
+  std::mutex Mutex;
 
 public:
   ASTBuilderAction(std::vector<std::unique_ptr<ASTUnit>> &ASTs) : ASTs(ASTs) {}
@@ -403,6 +962,7 @@ public:
     if (!AST)
       return false;
 
+    std::lock_guard<std::mutex> Guard(Mutex);
     ASTs.push_back(std::move(AST));
     return true;
   }
@@ -24,7 +24,12 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/Signals.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 using namespace llvm;
 
@@ -97,6 +102,19 @@ static cl::opt<unsigned>
                     "clang-format from an editor integration"),
            cl::init(0), cl::cat(ClangFormatCategory));
 
+static cl::opt<unsigned>
+    NumThreads("j",
+               cl::desc("The number of files to format concurrently when\n"
+                        "several <file>s are given (0 to use all the\n"
+                        "available hardware threads)."),
+               cl::init(1), cl::cat(ClangFormatCategory));
+static cl::opt<std::string>
+    CacheDir("cache",
+             cl::desc("A directory remembering which file contents are\n"
+                      "already formatted with which style, so that\n"
+                      "formatting them again is skipped."),
+             cl::cat(ClangFormatCategory));
+
 static cl::list<std::string> FileNames(cl::Positional, cl::desc("[<file> ...]"),
                                        cl::cat(ClangFormatCategory));
 
@@ -149,6 +167,14 @@ static bool fillRanges(SourceManager &Sources, FileID ID,
     return false;
   }
 
+  // Format the whole file. This is the only case when several files are
+  // formatted, possibly concurrently, so it must leave Offsets alone.
+  if (Offsets.empty() && Lengths.empty()) {
+    Ranges.push_back(CharSourceRange::getCharRange(
+        Sources.getLocForStartOfFile(ID), Sources.getLocForEndOfFile(ID)));
+    return false;
+  }
+
   if (Offsets.empty())
     Offsets.push_back(0);
   if (Offsets.size() != Lengths.size() &&
@@ -182,28 +208,79 @@ static bool fillRanges(SourceManager &Sources, FileID ID,
   return false;
 }
 
-static void outputReplacementXML(StringRef Text) {
+static void outputReplacementXML(raw_ostream &OS, StringRef Text) {
   size_t From = 0;
   size_t Index;
   while ((Index = Text.find_first_of("\n\r", From)) != StringRef::npos) {
-    llvm::outs() << Text.substr(From, Index - From);
+    OS << Text.substr(From, Index - From);
     switch (Text[Index]) {
     case '\n':
-      llvm::outs() << "&#10;";
+      OS << "&#10;";
       break;
     case '\r':
-      llvm::outs() << "&#13;";
+      OS << "&#13;";
       break;
     default:
       llvm_unreachable("Unexpected character encountered!");
     }
     From = Index + 1;
   }
-  llvm::outs() << Text.substr(From);
+  OS << Text.substr(From);
+}
+
+/// \brief The styles found so far, keyed by the directory the configuration
+/// was searched from and the extension of the file, which determine the style
+/// getStyle() returns.
+static StringMap<FormatStyle> StyleCache;
+static std::mutex StyleCacheMutex;
+
+static FormatStyle getCachedStyle(StringRef FileName) {
+  SmallString<128> Key;
+  if (StringRef(Style).equals_lower("file")) {
+    SmallString<128> Path(FileName);
+    llvm::sys::fs::make_absolute(Path);
+    Key = llvm::sys::path::parent_path(Path);
+  }
+  Key.push_back('\0');
+  Key += llvm::sys::path::extension(FileName);
+
+  std::lock_guard<std::mutex> Lock(StyleCacheMutex);
+  StringMap<FormatStyle>::iterator I = StyleCache.find(Key);
+  if (I == StyleCache.end())
+    I = StyleCache.insert(std::make_pair(
+        Key, getStyle(Style, FileName, FallbackStyle))).first;
+  return I->second;
+}
+
+/// \brief Returns the path of the -cache entry recording that \p Code is
+/// formatted according to \p FormatStyle.
+static std::string getCacheEntry(StringRef Code,
+                                 const FormatStyle &FormatStyle) {
+  llvm::MD5 Hash;
+  Hash.update(clang::getClangToolFullVersion("clang-format"));
+  Hash.update(StringRef("", 1));
+  Hash.update(configurationAsText(FormatStyle));
+  Hash.update(StringRef("", 1));
+  Hash.update(Code);
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Name;
+  llvm::MD5::stringifyResult(Result, Name);
+
+  SmallString<128> Path(CacheDir);
+  llvm::sys::path::append(Path, Name.str());
+  return Path.str();
+}
+
+static void addCacheEntry(StringRef Entry) {
+  if (llvm::sys::fs::create_directories(CacheDir))
+    return;
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(Entry, EC, llvm::sys::fs::F_None);
 }
 
 // Returns true on error.
-static bool format(StringRef FileName) {
+static bool format(StringRef FileName, raw_ostream &OS) {
   FileManager Files((FileSystemOptions()));
   DiagnosticsEngine Diagnostics(
       IntrusiveRefCntPtr<DiagnosticIDs>(new DiagnosticIDs),
@@ -223,26 +300,35 @@ static bool format(StringRef FileName) {
   if (fillRanges(Sources, ID, Code.get(), Ranges))
     return true;
 
-  FormatStyle FormatStyle = getStyle(
-      Style, (FileName == "-") ? AssumeFilename : FileName, FallbackStyle);
-  tooling::Replacements Replaces = reformat(FormatStyle, Sources, ID, Ranges);
+  FormatStyle FormatStyle =
+      getCachedStyle((FileName == "-") ? AssumeFilename : FileName);
+
+  // The cache only knows about whole files that end up unchanged.
+  std::string CacheEntry;
+  if (!CacheDir.empty() && LineRanges.empty() && Offsets.empty() &&
+      Lengths.empty()) {
+    CacheEntry = getCacheEntry(Code->getBuffer(), FormatStyle);
+  }
+
+  tooling::Replacements Replaces;
+  bool Cached = !CacheEntry.empty() && llvm::sys::fs::exists(CacheEntry);
+  if (!Cached)
+    Replaces = reformat(FormatStyle, Sources, ID, Ranges);
   if (OutputXML) {
-    llvm::outs()
-        << "<?xml version='1.0'?>\n<replacements xml:space='preserve'>\n";
+    OS << "<?xml version='1.0'?>\n<replacements xml:space='preserve'>\n";
     if (Cursor.getNumOccurrences() != 0)
-      llvm::outs() << "<cursor>"
-                   << tooling::shiftedCodePosition(Replaces, Cursor)
-                   << "</cursor>\n";
+      OS << "<cursor>" << tooling::shiftedCodePosition(Replaces, Cursor)
+         << "</cursor>\n";
     for (tooling::Replacements::const_iterator I = Replaces.begin(),
                                                E = Replaces.end();
          I != E; ++I) {
-      llvm::outs() << "<replacement "
-                   << "offset='" << I->getOffset() << "' "
-                   << "length='" << I->getLength() << "'>";
-      outputReplacementXML(I->getReplacementText());
-      llvm::outs() << "</replacement>\n";
+      OS << "<replacement "
+         << "offset='" << I->getOffset() << "' "
+         << "length='" << I->getLength() << "'>";
+      outputReplacementXML(OS, I->getReplacementText());
+      OS << "</replacement>\n";
     }
-    llvm::outs() << "</replacements>\n";
+    OS << "</replacements>\n";
   } else {
     Rewriter Rewrite(Sources, LangOptions());
     tooling::applyAllReplacements(Replaces, Rewrite);
@@ -251,14 +337,51 @@ static bool format(StringRef FileName) {
         return true;
     } else {
       if (Cursor.getNumOccurrences() != 0)
-        outs() << "{ \"Cursor\": "
-               << tooling::shiftedCodePosition(Replaces, Cursor) << " }\n";
-      Rewrite.getEditBuffer(ID).write(outs());
+        OS << "{ \"Cursor\": "
+           << tooling::shiftedCodePosition(Replaces, Cursor) << " }\n";
+      Rewrite.getEditBuffer(ID).write(OS);
     }
   }
+
+  if (!CacheEntry.empty() && !Cached) {
+    // Remember the formatted code, which is what the next run will see if the
+    // file was edited in place or the output is written back.
+    if (!Replaces.empty())
+      CacheEntry = getCacheEntry(
+          tooling::applyAllReplacements(Code->getBuffer(), Replaces),
+          FormatStyle);
+    addCacheEntry(CacheEntry);
+  }
   return false;
 }
 
+/// \brief Format all of \p Files on \p Threads threads. The output of each
+/// file is buffered, and written in order once all of them are formatted.
+static bool formatConcurrently(ArrayRef<std::string> Files,
+                               unsigned Threads) {
+  std::vector<std::string> Outputs(Files.size());
+  std::atomic<size_t> Next(0);
+  std::atomic<bool> Error(false);
+  auto Worker = [&]() {
+    for (size_t I = Next++; I < Files.size(); I = Next++) {
+      llvm::raw_string_ostream OS(Outputs[I]);
+      if (format(Files[I], OS))
+        Error = true;
+    }
+  };
+
+  std::vector<std::thread> Pool;
+  for (unsigned I = 1; I < Threads; ++I)
+    Pool.emplace_back(Worker);
+  Worker();
+  for (std::thread &T : Pool)
+    T.join();
+
+  for (const std::string &Output : Outputs)
+    llvm::outs() << Output;
+  return Error;
+}
+
 }  // namespace format
 }  // namespace clang
 
@@ -297,10 +420,10 @@ int main(int argc, const char **argv) {
   bool Error = false;
   switch (FileNames.size()) {
   case 0:
-    Error = clang::format::format("-");
+    Error = clang::format::format("-", llvm::outs());
     break;
   case 1:
-    Error = clang::format::format(FileNames[0]);
+    Error = clang::format::format(FileNames[0], llvm::outs());
     break;
   default:
     if (!Offsets.empty() || !Lengths.empty() || !LineRanges.empty()) {
@@ -308,8 +431,15 @@ int main(int argc, const char **argv) {
                       "single file.\n";
       return 1;
     }
+    unsigned Threads = NumThreads;
+    if (Threads == 0)
+      Threads = std::max(std::thread::hardware_concurrency(), 1u);
+    if (Threads > 1) {
+      Error = clang::format::formatConcurrently(FileNames, Threads);
+      break;
+    }
     for (unsigned i = 0; i < FileNames.size(); ++i)
-      Error |= clang::format::format(FileNames[i]);
+      Error |= clang::format::format(FileNames[i], llvm::outs());
     break;
   }
   return Error ? 1 : 0;
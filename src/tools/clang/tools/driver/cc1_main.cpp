@@ -14,6 +14,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Option/Arg.h"
+#include "clang/Basic/VirtualFileSystem.h"
 #include "clang/CodeGen/LLVMModuleProvider.h"
 #include "clang/Driver/DriverDiagnostic.h"
 #include "clang/Driver/Options.h"
@@ -24,14 +25,19 @@
 #include "clang/Frontend/TextDiagnosticPrinter.h"
 #include "clang/Frontend/Utils.h"
 #include "clang/FrontendTool/Utils.h"
+#include "clang/Lex/ConditionalSkipCache.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/LinkAllPasses.h"
 #include "llvm/Option/ArgList.h"
 #include "llvm/Option/OptTable.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cstdio>
@@ -55,7 +61,12 @@ static void LLVMErrorHandler(void *UserData, const std::string &Message,
   // We cannot recover from llvm errors.  When reporting a fatal error, exit
   // with status 70 to generate crash diagnostics.  For BSD systems this is
   // defined as an internal software error.  Otherwise, exit with status 1.
-  exit(GenCrashDiag ? 70 : 1);
+  // When running within the driver, return to it instead of exiting.
+  int RetCode = GenCrashDiag ? 70 : 1;
+  if (llvm::CrashRecoveryContext *CRC =
+          llvm::CrashRecoveryContext::GetCurrent())
+    CRC->HandleExit(RetCode);
+  exit(RetCode);
 }
 
 #ifdef LINK_POLLY_INTO_TOOLS
@@ -64,7 +75,8 @@ void initializePollyPasses(llvm::PassRegistry &Registry);
 }
 #endif
 
-int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
+int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr,
+             vfs::CachingFileSystem *ServerCache) {
   std::unique_ptr<CompilerInstance> Clang(new CompilerInstance(
       SharedModuleProvider::Create<LLVMModuleProvider>()));
   IntrusiveRefCntPtr<DiagnosticIDs> DiagID(new DiagnosticIDs());
@@ -99,21 +111,77 @@ int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
   if (!Clang->hasDiagnostics())
     return 1;
 
+  DiagsBuffer->FlushDiagnostics(Clang->getDiagnostics());
+  if (!Success)
+    return 1;
+
+  // A compile server outlives the compile: free everything, and read the
+  // files through its cache. The compile writes the module cache, so that
+  // has to be looked up every time.
+  if (ServerCache) {
+    Clang->getFrontendOpts().DisableFree = false;
+    Clang->getCodeGenOpts().DisableFree = false;
+    if (!Clang->getHeaderSearchOpts().ModuleCachePath.empty())
+      ServerCache->addVolatileDirectory(
+          Clang->getHeaderSearchOpts().ModuleCachePath);
+    IntrusiveRefCntPtr<vfs::FileSystem> VFS = createVFSFromCompilerInvocation(
+        Clang->getInvocation(), Clang->getDiagnostics(), ServerCache);
+    if (!VFS)
+      return 1;
+    Clang->setVirtualFileSystem(VFS);
+
+    // The excluded blocks of the unchanged headers stay the same too.
+    static IntrusiveRefCntPtr<ConditionalSkipCache> SkipCache(
+        new ConditionalSkipCache());
+    Clang->setConditionalSkipCache(SkipCache.get());
+
+    // Report the statistics of this compile, not of the server's lifetime.
+    llvm::ResetStatistics();
+  }
+
   // Set an error handler, so that any LLVM backend diagnostics go through our
   // error handler.
   llvm::install_fatal_error_handler(LLVMErrorHandler,
                                   static_cast<void*>(&Clang->getDiagnostics()));
 
-  DiagsBuffer->FlushDiagnostics(Clang->getDiagnostics());
-  if (!Success)
-    return 1;
+  const FrontendOptions &FrontendOpts = Clang->getFrontendOpts();
+  if (FrontendOpts.TimeTrace)
+    llvm::timeTraceProfilerInitialize(FrontendOpts.TimeTraceGranularity,
+                                      "clang");
 
   // Execute the frontend actions.
-  Success = ExecuteCompilerInvocation(Clang.get());
+  {
+    llvm::TimeTraceScope TimeScope("ExecuteCompiler");
+    Success = ExecuteCompilerInvocation(Clang.get());
+  }
+
+  // Write the time trace next to the output file, or to the current
+  // directory when writing to stdout.
+  if (FrontendOpts.TimeTrace) {
+    SmallString<128> Path(FrontendOpts.OutputFile);
+    if ((Path.empty() || Path == "-") && !FrontendOpts.Inputs.empty() &&
+        FrontendOpts.Inputs[0].isFile())
+      Path = llvm::sys::path::filename(FrontendOpts.Inputs[0].getFile());
+    if (!Path.empty() && Path != "-") {
+      llvm::sys::path::replace_extension(
+          Path, FrontendOpts.TimeTraceFolded ? "folded" : "json");
+      std::error_code EC;
+      llvm::raw_fd_ostream OS(Path, EC, llvm::sys::fs::F_Text);
+      if (EC)
+        Clang->getDiagnostics().Report(diag::err_fe_unable_to_open_output)
+            << Path << EC.message();
+      else if (FrontendOpts.TimeTraceFolded)
+        llvm::timeTraceProfilerWriteFolded(OS);
+      else
+        llvm::timeTraceProfilerWrite(OS);
+    }
+    llvm::timeTraceProfilerCleanup();
+  }
 
   // If any timers were active but haven't been destroyed yet, print their
   // results now.  This happens in -disable-free mode.
   llvm::TimerGroup::printAll(llvm::errs());
+  llvm::writePassTimingsJSON();
 
   // Our error handler depends on the Diagnostics object, which we're
   // potentially about to delete. Uninstall the handler now so that any
@@ -129,8 +197,10 @@ int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
   }
 
   // Managed static deconstruction. Useful for making things like
-  // -time-passes usable.
-  llvm::llvm_shutdown();
+  // -time-passes usable. The driver does it when running cc1 within its
+  // process.
+  if (!llvm::CrashRecoveryContext::GetCurrent())
+    llvm::llvm_shutdown();
 
   return !Success;
 }
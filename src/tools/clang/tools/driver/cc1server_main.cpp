@@ -0,0 +1,419 @@
+//===-- cc1server_main.cpp - Clang CC1 Compile Server ---------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This is the entry point to the clang -cc1server functionality, a persistent
+// process that runs the -cc1 invocations drivers send it over a local socket.
+// The targets are initialized once, and the status and the contents of the
+// files the compiles read are kept from one compile to the next, revalidated
+// against the file system before each one. It also implements the client side
+// the driver uses when CLANG_COMPILE_SERVER names the socket of a server.
+//
+// The server forks a number of workers, that accept connections on the same
+// socket and run one compile at a time, in the working directory and with the
+// standard streams of the client. A worker whose compile crashed is replaced
+// by a fresh one. The environment of the compiles is the one of the server.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/VirtualFileSystem.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/CrashRecoveryContext.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef LLVM_ON_UNIX
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace clang;
+
+extern int cc1_main(ArrayRef<const char *> Argv, const char *Argv0,
+                    void *MainAddr, vfs::CachingFileSystem *ServerCache);
+
+#ifdef LLVM_ON_UNIX
+
+namespace {
+/// The start of a request, which the client sends along with its standard
+/// input, output and error. The payload that follows is the working directory
+/// and the arguments of the invocation, each terminated by a null character.
+struct RequestHeader {
+  uint32_t Version;
+  uint32_t PayloadSize;
+};
+
+/// The answer to a request: whether the server ran the invocation, and if so
+/// what it returned.
+struct Reply {
+  uint32_t Accepted;
+  int32_t Result;
+};
+} // end anonymous namespace
+
+static const uint32_t ProtocolVersion = 1;
+static const uint32_t MaxPayloadSize = 64 << 20;
+
+static bool writeAll(int FD, const void *Data, size_t Size) {
+  const char *Ptr = static_cast<const char *>(Data);
+  while (Size) {
+    ssize_t Written = ::write(FD, Ptr, Size);
+    if (Written < 0 && errno == EINTR)
+      continue;
+    if (Written <= 0)
+      return false;
+    Ptr += Written;
+    Size -= Written;
+  }
+  return true;
+}
+
+static bool readAll(int FD, void *Data, size_t Size) {
+  char *Ptr = static_cast<char *>(Data);
+  while (Size) {
+    ssize_t Read = ::read(FD, Ptr, Size);
+    if (Read < 0 && errno == EINTR)
+      continue;
+    if (Read <= 0)
+      return false;
+    Ptr += Read;
+    Size -= Read;
+  }
+  return true;
+}
+
+/// Send the \p Size bytes of \p Data along with the descriptors \p FDs.
+static bool sendWithDescriptors(int Socket, const void *Data, size_t Size,
+                                ArrayRef<int> FDs) {
+  SmallVector<char, 64> Control(CMSG_SPACE(sizeof(int) * FDs.size()));
+  struct iovec IOV;
+  IOV.iov_base = const_cast<void *>(Data);
+  IOV.iov_len = Size;
+  struct msghdr Msg;
+  memset(&Msg, 0, sizeof(Msg));
+  Msg.msg_iov = &IOV;
+  Msg.msg_iovlen = 1;
+  Msg.msg_control = Control.data();
+  Msg.msg_controllen = Control.size();
+  struct cmsghdr *CMsg = CMSG_FIRSTHDR(&Msg);
+  CMsg->cmsg_level = SOL_SOCKET;
+  CMsg->cmsg_type = SCM_RIGHTS;
+  CMsg->cmsg_len = CMSG_LEN(sizeof(int) * FDs.size());
+  memcpy(CMSG_DATA(CMsg), FDs.data(), sizeof(int) * FDs.size());
+
+  ssize_t Sent;
+  do
+    Sent = ::sendmsg(Socket, &Msg, 0);
+  while (Sent < 0 && errno == EINTR);
+  if (Sent <= 0)
+    return false;
+  return writeAll(Socket, static_cast<const char *>(Data) + Sent, Size - Sent);
+}
+
+/// Receive the \p Size bytes of \p Data, and the descriptors sent with them
+/// into \p FDs.
+static bool receiveWithDescriptors(int Socket, void *Data, size_t Size,
+                                   SmallVectorImpl<int> &FDs) {
+  char Control[CMSG_SPACE(sizeof(int) * 4)];
+  struct iovec IOV;
+  IOV.iov_base = Data;
+  IOV.iov_len = Size;
+  struct msghdr Msg;
+  memset(&Msg, 0, sizeof(Msg));
+  Msg.msg_iov = &IOV;
+  Msg.msg_iovlen = 1;
+  Msg.msg_control = Control;
+  Msg.msg_controllen = sizeof(Control);
+
+  ssize_t Received;
+  do
+    Received = ::recvmsg(Socket, &Msg, 0);
+  while (Received < 0 && errno == EINTR);
+  if (Received <= 0)
+    return false;
+
+  for (struct cmsghdr *CMsg = CMSG_FIRSTHDR(&Msg); CMsg;
+       CMsg = CMSG_NXTHDR(&Msg, CMsg)) {
+    if (CMsg->cmsg_level != SOL_SOCKET || CMsg->cmsg_type != SCM_RIGHTS)
+      continue;
+    size_t NumFDs = (CMsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    const int *Begin = reinterpret_cast<const int *>(CMSG_DATA(CMsg));
+    FDs.append(Begin, Begin + NumFDs);
+  }
+  return readAll(Socket, static_cast<char *>(Data) + Received,
+                 Size - Received);
+}
+
+/// Fill \p Addr with the address of the socket \p Path.
+static bool getSocketAddress(StringRef Path, struct sockaddr_un &Addr) {
+  memset(&Addr, 0, sizeof(Addr));
+  Addr.sun_family = AF_UNIX;
+  if (Path.empty() || Path.size() >= sizeof(Addr.sun_path))
+    return false;
+  memcpy(Addr.sun_path, Path.data(), Path.size());
+  return true;
+}
+
+bool cc1server_execute(StringRef SocketPath, ArrayRef<const char *> Argv,
+                       int &Res) {
+  if (Argv.size() < 2 || StringRef(Argv[1]) != "-cc1")
+    return false;
+
+  SmallString<256> CWD;
+  if (llvm::sys::fs::current_path(CWD))
+    return false;
+  std::string Payload = CWD.str();
+  Payload += '\0';
+  for (const char *Arg : Argv) {
+    Payload += Arg;
+    Payload += '\0';
+  }
+  if (Payload.size() > MaxPayloadSize)
+    return false;
+
+  struct sockaddr_un Addr;
+  if (!getSocketAddress(SocketPath, Addr))
+    return false;
+  int Socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (Socket < 0)
+    return false;
+  if (::connect(Socket, reinterpret_cast<struct sockaddr *>(&Addr),
+                sizeof(Addr)) < 0) {
+    ::close(Socket);
+    return false;
+  }
+
+  // The server uses our standard input, output and error directly.
+  llvm::outs().flush();
+  llvm::errs().flush();
+
+  // If the server goes away before replying, the invocation is run here.
+  RequestHeader Header = {ProtocolVersion, uint32_t(Payload.size())};
+  int StdFDs[] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+  Reply R;
+  bool Replied =
+      sendWithDescriptors(Socket, &Header, sizeof(Header), StdFDs) &&
+      writeAll(Socket, Payload.data(), Payload.size()) &&
+      readAll(Socket, &R, sizeof(R));
+  ::close(Socket);
+  if (!Replied || !R.Accepted)
+    return false;
+  Res = R.Result;
+  return true;
+}
+
+/// Whether the worker can run \p Args. Plugins and -mllvm options would
+/// outlive the compile, and another clang would not produce the same output.
+static bool canServe(ArrayRef<const char *> Args, StringRef ServerPath) {
+  if (Args.size() < 2 || StringRef(Args[1]) != "-cc1")
+    return false;
+  for (const char *Arg : Args.slice(2)) {
+    StringRef A(Arg);
+    if (A == "-mllvm" || A == "-load" || A == "-plugin" ||
+        A.startswith("-plugin-arg-") || A == "-add-plugin")
+      return false;
+  }
+  bool Same = false;
+  return !llvm::sys::fs::equivalent(Args[0], ServerPath, Same) && Same;
+}
+
+/// Run the request on \p Conn. Returns false if the worker is not in a state
+/// to serve more requests.
+static bool serveRequest(int Conn, vfs::CachingFileSystem &Cache,
+                         StringRef ServerPath, void *MainAddr) {
+  RequestHeader Header;
+  SmallVector<int, 3> FDs;
+  bool Received = receiveWithDescriptors(Conn, &Header, sizeof(Header), FDs);
+  std::string Payload;
+  if (Received && FDs.size() == 3 && Header.Version == ProtocolVersion &&
+      Header.PayloadSize <= MaxPayloadSize) {
+    Payload.resize(Header.PayloadSize);
+    Received = readAll(Conn, &Payload[0], Payload.size());
+  } else {
+    Received = false;
+  }
+
+  std::vector<const char *> Args;
+  for (size_t Pos = 0, End; Received && Pos < Payload.size(); Pos = End + 1) {
+    End = Payload.find('\0', Pos);
+    if (End == std::string::npos)
+      break;
+    Args.push_back(Payload.c_str() + Pos);
+  }
+
+  // The first string is the working directory of the client.
+  Reply R = {0, 0};
+  bool Completed = true;
+  if (!Args.empty() && ::chdir(Args[0]) == 0 &&
+      canServe(llvm::makeArrayRef(Args).slice(1), ServerPath)) {
+    Cache.revalidate();
+
+    llvm::outs().flush();
+    int SavedFDs[3];
+    for (int FD = 0; FD != 3; ++FD) {
+      SavedFDs[FD] = ::dup(FD);
+      ::dup2(FDs[FD], FD);
+    }
+
+    ArrayRef<const char *> Argv = llvm::makeArrayRef(Args).slice(1);
+    int Res = 1;
+    llvm::CrashRecoveryContext CRC;
+    Completed = CRC.RunSafely([&] {
+      Res = cc1_main(Argv.slice(2), Argv[0], MainAddr, &Cache);
+    });
+    if (!Completed)
+      Res = CRC.getRetCode() ? CRC.getRetCode() : -1;
+
+    llvm::outs().flush();
+    for (int FD = 0; FD != 3; ++FD) {
+      ::dup2(SavedFDs[FD], FD);
+      ::close(SavedFDs[FD]);
+    }
+    R.Accepted = 1;
+    R.Result = Res;
+  }
+  for (int FD : FDs)
+    ::close(FD);
+  writeAll(Conn, &R, sizeof(R));
+  return Completed;
+}
+
+/// Serve the connections of \p Listener until a compile fails to complete,
+/// and the worker has to be replaced. Returns 1 on errors.
+static int runWorker(int Listener, uint64_t CacheSize, const char *Argv0,
+                     void *MainAddr) {
+  std::string ServerPath = llvm::sys::fs::getMainExecutable(Argv0, MainAddr);
+  IntrusiveRefCntPtr<vfs::CachingFileSystem> Cache(
+      new vfs::CachingFileSystem(vfs::getRealFileSystem(), CacheSize));
+  llvm::CrashRecoveryContext::Enable();
+
+  while (true) {
+    int Conn = ::accept(Listener, nullptr, nullptr);
+    if (Conn < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      llvm::errs() << "error: cannot accept connections: "
+                   << strerror(errno) << '\n';
+      return 1;
+    }
+    bool Completed = serveRequest(Conn, *Cache, ServerPath, MainAddr);
+    ::close(Conn);
+    if (!Completed)
+      return 0;
+  }
+}
+
+int cc1server_main(ArrayRef<const char *> Argv, const char *Argv0,
+                   void *MainAddr) {
+  unsigned Jobs = 1;
+  uint64_t CacheSizeMB = 1024;
+  StringRef SocketPath;
+  for (StringRef Arg : Argv) {
+    if (Arg.startswith("-jobs=")) {
+      if (Arg.substr(6).getAsInteger(10, Jobs) || !Jobs) {
+        llvm::errs() << "error: invalid number of jobs in '" << Arg << "'\n";
+        return 1;
+      }
+    } else if (Arg.startswith("-cache-size=")) {
+      if (Arg.substr(12).getAsInteger(10, CacheSizeMB)) {
+        llvm::errs() << "error: invalid cache size in '" << Arg << "'\n";
+        return 1;
+      }
+    } else if (SocketPath.empty() && !Arg.startswith("-")) {
+      SocketPath = Arg;
+    } else {
+      llvm::errs() << "error: unknown argument '" << Arg << "'\n";
+      return 1;
+    }
+  }
+
+  struct sockaddr_un Addr;
+  if (!getSocketAddress(SocketPath, Addr)) {
+    llvm::errs() << "usage: clang -cc1server [-jobs=<n>] "
+                    "[-cache-size=<megabytes>] <socket>\n";
+    return 1;
+  }
+
+  // Initialize the targets once for all the compiles of the workers.
+  llvm::InitializeAllTargets();
+  llvm::InitializeAllTargetMCs();
+  llvm::InitializeAllAsmPrinters();
+  llvm::InitializeAllAsmParsers();
+
+  ::unlink(SocketPath.str().c_str());
+  int Listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (Listener < 0 ||
+      ::bind(Listener, reinterpret_cast<struct sockaddr *>(&Addr),
+             sizeof(Addr)) < 0 ||
+      ::listen(Listener, SOMAXCONN) < 0) {
+    llvm::errs() << "error: cannot listen on '" << SocketPath
+                 << "': " << strerror(errno) << '\n';
+    return 1;
+  }
+  llvm::sys::RemoveFileOnSignal(SocketPath);
+
+  // Clients that go away must not kill the workers writing to them.
+  ::signal(SIGPIPE, SIG_IGN);
+
+  // Keep Jobs workers running, replacing the ones that exit.
+  unsigned Running = 0;
+  while (true) {
+    for (; Running < Jobs; ++Running) {
+      pid_t Pid = ::fork();
+      if (Pid == 0) {
+        llvm::sys::DontRemoveFileOnSignal(SocketPath);
+        ::_exit(runWorker(Listener, CacheSizeMB << 20, Argv0, MainAddr));
+      }
+      if (Pid < 0) {
+        llvm::errs() << "error: cannot start a worker: " << strerror(errno)
+                     << '\n';
+        return 1;
+      }
+    }
+    int Status;
+    if (::wait(&Status) < 0) {
+      if (errno == EINTR)
+        continue;
+      return 1;
+    }
+    --Running;
+    if (WIFEXITED(Status) && WEXITSTATUS(Status) != 0)
+      return 1;
+  }
+}
+
+#else
+
+bool cc1server_execute(StringRef SocketPath, ArrayRef<const char *> Argv,
+                       int &Res) {
+  return false;
+}
+
+int cc1server_main(ArrayRef<const char *> Argv, const char *Argv0,
+                   void *MainAddr) {
+  llvm::errs() << "error: the compile server is not supported on this "
+                  "platform\n";
+  return 1;
+}
+
+#endif
@@ -195,12 +195,23 @@ static void ApplyQAOverride(SmallVectorImpl<const char*> &Args,
   }
 }
 
+namespace clang {
+namespace vfs {
+class CachingFileSystem;
+}
+}
+
 extern int cc1_main(ArrayRef<const char *> Argv, const char *Argv0,
-                    void *MainAddr);
+                    void *MainAddr,
+                    vfs::CachingFileSystem *ServerCache = nullptr);
 extern int cc1as_main(ArrayRef<const char *> Argv, const char *Argv0,
                       void *MainAddr);
 extern int cc1apinotes_main(ArrayRef<const char *> Argv, const char *Argv0,
                             void *MainAddr);
+extern int cc1server_main(ArrayRef<const char *> Argv, const char *Argv0,
+                          void *MainAddr);
+extern bool cc1server_execute(StringRef SocketPath,
+                              ArrayRef<const char *> Argv, int &Res);
 
 struct DriverSuffix {
   const char *Suffix;
@@ -373,6 +384,8 @@ static int ExecuteCC1Tool(ArrayRef<const char *> argv, StringRef Tool) {
     return cc1as_main(argv.slice(2), argv[0], GetExecutablePathVP);
   if (Tool == "apinotes")
     return cc1apinotes_main(argv.slice(2), argv[0], GetExecutablePathVP);
+  if (Tool == "server")
+    return cc1server_main(argv.slice(2), argv[0], GetExecutablePathVP);
 
   // Reject unknown tools.
   llvm::errs() << "error: unknown integrated tool '" << Tool << "'\n";
@@ -474,6 +487,16 @@ int main(int argc_, const char **argv_) {
 
   SetBackdoorDriverOutputsFromEnvVars(TheDriver);
 
+  // Let the driver run cc1 without spawning a process for it, on the compile
+  // server named by CLANG_COMPILE_SERVER if it accepts the invocation.
+  TheDriver.CC1Main = [](ArrayRef<const char *> Argv) {
+    int Res;
+    if (const char *Server = ::getenv("CLANG_COMPILE_SERVER"))
+      if (cc1server_execute(Server, Argv, Res))
+        return Res;
+    return ExecuteCC1Tool(Argv, Argv[1] + 4);
+  };
+
   std::unique_ptr<Compilation> C(TheDriver.BuildCompilation(argv));
   int Res = 0;
   SmallVector<std::pair<int, const Command *>, 4> FailingCommands;
@@ -178,6 +178,198 @@ private:
   unsigned AppliedFixes;
 };
 
+/// \brief Adds the time from its construction to its destruction to a record.
+class ScopedTimeRecord {
+public:
+  explicit ScopedTimeRecord(llvm::TimeRecord &Record) : Record(Record) {
+    Record -= llvm::TimeRecord::getCurrentTime(/*Start=*/true);
+  }
+  ~ScopedTimeRecord() {
+    Record += llvm::TimeRecord::getCurrentTime(/*Start=*/false);
+  }
+
+private:
+  llvm::TimeRecord &Record;
+};
+
+/// \brief Forwards to the preprocessor callbacks of a check, timing them.
+class TimedPPCallbacks : public PPCallbacks {
+  std::unique_ptr<PPCallbacks> Callbacks;
+  llvm::TimeRecord &Record;
+
+public:
+  TimedPPCallbacks(std::unique_ptr<PPCallbacks> Callbacks,
+                   llvm::TimeRecord &Record)
+      : Callbacks(std::move(Callbacks)), Record(Record) {}
+
+
+  void FileChanged(SourceLocation Loc, FileChangeReason Reason,
+                   SrcMgr::CharacteristicKind FileType,
+                   FileID PrevFID) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->FileChanged(Loc, Reason, FileType, PrevFID);
+  }
+
+  void FileSkipped(const FileEntry &ParentFile,
+                   const Token &FilenameTok,
+                   SrcMgr::CharacteristicKind FileType) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->FileSkipped(ParentFile, FilenameTok, FileType);
+  }
+
+  bool FileNotFound(StringRef FileName,
+                    SmallVectorImpl<char> &RecoveryPath) override {
+    ScopedTimeRecord Timer(Record);
+    return Callbacks->FileNotFound(FileName, RecoveryPath);
+  }
+
+  void InclusionDirective(SourceLocation HashLoc, const Token &IncludeTok,
+                          StringRef FileName, bool IsAngled,
+                          CharSourceRange FilenameRange, const FileEntry *File,
+                          StringRef SearchPath, StringRef RelativePath,
+                          const Module *Imported) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->InclusionDirective(HashLoc, IncludeTok, FileName, IsAngled,
+                                  FilenameRange, File, SearchPath, RelativePath,
+                                  Imported);
+  }
+
+  void moduleImport(SourceLocation ImportLoc, ModuleIdPath Path,
+                    const Module *Imported) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->moduleImport(ImportLoc, Path, Imported);
+  }
+
+  void EndOfMainFile() override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->EndOfMainFile();
+  }
+
+  void Ident(SourceLocation Loc, const std::string &str) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->Ident(Loc, str);
+  }
+
+  void PragmaComment(SourceLocation Loc, const IdentifierInfo *Kind,
+                     const std::string &Str) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->PragmaComment(Loc, Kind, Str);
+  }
+
+  void PragmaDetectMismatch(SourceLocation Loc, const std::string &Name,
+                            const std::string &Value) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->PragmaDetectMismatch(Loc, Name, Value);
+  }
+
+  void PragmaMessage(SourceLocation Loc, StringRef Namespace,
+                     PragmaMessageKind Kind, StringRef Str) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->PragmaMessage(Loc, Namespace, Kind, Str);
+  }
+
+  void PragmaDiagnosticPush(SourceLocation Loc, StringRef Namespace) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->PragmaDiagnosticPush(Loc, Namespace);
+  }
+
+  void PragmaDiagnosticPop(SourceLocation Loc, StringRef Namespace) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->PragmaDiagnosticPop(Loc, Namespace);
+  }
+
+  void PragmaDiagnostic(SourceLocation Loc, StringRef Namespace,
+                        diag::Severity mapping, StringRef Str) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->PragmaDiagnostic(Loc, Namespace, mapping, Str);
+  }
+
+  void PragmaOpenCLExtension(SourceLocation NameLoc, const IdentifierInfo *Name,
+                             SourceLocation StateLoc, unsigned State) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->PragmaOpenCLExtension(NameLoc, Name, StateLoc, State);
+  }
+
+  void PragmaWarning(SourceLocation Loc, StringRef WarningSpec,
+                     ArrayRef<int> Ids) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->PragmaWarning(Loc, WarningSpec, Ids);
+  }
+
+  void PragmaWarningPush(SourceLocation Loc, int Level) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->PragmaWarningPush(Loc, Level);
+  }
+
+  void PragmaWarningPop(SourceLocation Loc) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->PragmaWarningPop(Loc);
+  }
+
+  void MacroExpands(const Token &MacroNameTok, const MacroDirective *MD,
+                    SourceRange Range, const MacroArgs *Args) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->MacroExpands(MacroNameTok, MD, Range, Args);
+  }
+
+  void MacroDefined(const Token &MacroNameTok,
+                    const MacroDirective *MD) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->MacroDefined(MacroNameTok, MD);
+  }
+
+  void MacroUndefined(const Token &MacroNameTok,
+                      const MacroDirective *MD) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->MacroUndefined(MacroNameTok, MD);
+  }
+
+  void Defined(const Token &MacroNameTok, const MacroDirective *MD,
+               SourceRange Range) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->Defined(MacroNameTok, MD, Range);
+  }
+
+  void SourceRangeSkipped(SourceRange Range) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->SourceRangeSkipped(Range);
+  }
+
+  void If(SourceLocation Loc, SourceRange ConditionRange,
+          ConditionValueKind ConditionValue) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->If(Loc, ConditionRange, ConditionValue);
+  }
+
+  void Elif(SourceLocation Loc, SourceRange ConditionRange,
+            ConditionValueKind ConditionValue, SourceLocation IfLoc) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->Elif(Loc, ConditionRange, ConditionValue, IfLoc);
+  }
+
+  void Ifdef(SourceLocation Loc, const Token &MacroNameTok,
+             const MacroDirective *MD) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->Ifdef(Loc, MacroNameTok, MD);
+  }
+
+  void Ifndef(SourceLocation Loc, const Token &MacroNameTok,
+              const MacroDirective *MD) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->Ifndef(Loc, MacroNameTok, MD);
+  }
+
+  void Else(SourceLocation Loc, SourceLocation IfLoc) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->Else(Loc, IfLoc);
+  }
+
+  void Endif(SourceLocation Loc, SourceLocation IfLoc) override {
+    ScopedTimeRecord Timer(Record);
+    Callbacks->Endif(Loc, IfLoc);
+  }
+};
+
 class ClangTidyASTConsumer : public MultiplexConsumer {
 public:
   ClangTidyASTConsumer(std::vector<std::unique_ptr<ASTConsumer>> Consumers,
@@ -225,7 +417,7 @@ ClangTidyASTConsumerFactory::CreateASTConsumer(
 
   for (auto &Check : Checks) {
     Check->registerMatchers(&*Finder);
-    Check->registerPPCallbacks(Compiler);
+    registerPPCallbacks(*Check, Compiler);
   }
 
   std::vector<std::unique_ptr<ASTConsumer>> Consumers;
@@ -255,6 +447,30 @@ ClangTidyASTConsumerFactory::CreateASTConsumer(
       std::move(Consumers), std::move(Finder), std::move(Checks));
 }
 
+void ClangTidyASTConsumerFactory::registerPPCallbacks(
+    ClangTidyCheck &Check, CompilerInstance &Compiler) {
+  ProfileData *Profile = Context.getCheckProfileData();
+  if (!Profile) {
+    Check.registerPPCallbacks(Compiler);
+    return;
+  }
+
+  // Let the check register its callbacks on their own, so that they can be
+  // wrapped in a timer, then put everything back in the original order.
+  Preprocessor &PP = Compiler.getPreprocessor();
+  std::unique_ptr<PPCallbacks> Previous = PP.takePPCallbacks();
+  Check.registerPPCallbacks(Compiler);
+  std::unique_ptr<PPCallbacks> Added = PP.takePPCallbacks();
+  if (Previous)
+    PP.addPPCallbacks(std::move(Previous));
+  // The check's name is the ID of its match callback, which is the bucket of
+  // its matcher timings as well.
+  const ast_matchers::MatchFinder::MatchCallback &Callback = Check;
+  if (Added)
+    PP.addPPCallbacks(llvm::make_unique<TimedPPCallbacks>(
+        std::move(Added), Profile->PPCallbackRecords[Callback.getID()]));
+}
+
 std::vector<std::string> ClangTidyASTConsumerFactory::getCheckNames() {
   std::vector<std::string> CheckNames;
   GlobList &Filter = Context.getChecksFilter();
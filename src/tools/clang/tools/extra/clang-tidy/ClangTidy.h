@@ -180,6 +180,10 @@ private:
   typedef std::vector<std::pair<std::string, bool>> CheckersList;
   CheckersList getCheckersControlList(GlobList &Filter);
 
+  /// \brief Lets \p Check register its preprocessor callbacks, timing them
+  /// if profiling is enabled.
+  void registerPPCallbacks(ClangTidyCheck &Check, CompilerInstance &Compiler);
+
   ClangTidyContext &Context;
   std::unique_ptr<ClangTidyCheckFactories> CheckFactories;
 };
@@ -107,9 +107,14 @@ struct ClangTidyStats {
   }
 };
 
-/// \brief Container for clang-tidy profiling data.
+/// \brief Container for clang-tidy profiling data, aggregated over all
+/// translation units.
 struct ProfileData {
+  /// \brief Time spent in the matchers and match callbacks of each check.
   llvm::StringMap<llvm::TimeRecord> Records;
+
+  /// \brief Time spent in the preprocessor callbacks of each check.
+  llvm::StringMap<llvm::TimeRecord> PPCallbackRecords;
 };
 
 /// \brief Every \c ClangTidyCheck reports errors through a \c DiagnosticsEngine
@@ -18,7 +18,10 @@
 #include "../ClangTidy.h"
 #include "clang/CodeGen/LLVMModuleProvider.h"
 #include "clang/Tooling/CommonOptionsParser.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/Process.h"
+#include "llvm/Support/YAMLParser.h"
+#include <set>
 
 using namespace clang::ast_matchers;
 using namespace clang::driver;
@@ -132,6 +135,13 @@ static cl::opt<bool> EnableCheckProfile(
     cl::desc("Enable per-check timing profiles, and print a report to stderr."),
     cl::init(false), cl::cat(ClangTidyCategory));
 
+static cl::opt<std::string> ExportCheckProfile(
+    "export-check-profile",
+    cl::desc("JSON file to store per-check timing profiles in, aggregated\n"
+             "over all input files. This collects the profiles without\n"
+             "printing them, unless -enable-check-profile is given too."),
+    cl::value_desc("filename"), cl::cat(ClangTidyCategory));
+
 static cl::opt<bool> AnalyzeTemporaryDtors(
     "analyze-temporary-dtors",
     cl::desc("Enable temporary destructor-aware analysis in\n"
@@ -180,13 +190,17 @@ static void printStats(const ClangTidyStats &Stats) {
 static void printProfileData(const ProfileData &Profile,
                              llvm::raw_ostream &OS) {
   // Time is first to allow for sorting by it.
-  std::vector<std::pair<llvm::TimeRecord, StringRef>> Timers;
+  std::vector<std::pair<llvm::TimeRecord, std::string>> Timers;
   TimeRecord Total;
 
   for (const auto& P : Profile.Records) {
     Timers.emplace_back(P.getValue(), P.getKey());
     Total += P.getValue();
   }
+  for (const auto& P : Profile.PPCallbackRecords) {
+    Timers.emplace_back(P.getValue(), (P.getKey() + " (preprocessor)").str());
+    Total += P.getValue();
+  }
 
   std::sort(Timers.begin(), Timers.end());
 
@@ -216,6 +230,39 @@ static void printProfileData(const ProfileData &Profile,
   OS.flush();
 }
 
+static void printTimeRecord(StringRef Name, const TimeRecord &Record,
+                            llvm::raw_ostream &OS) {
+  OS << "\"" << Name << "\": { \"wall\": "
+     << llvm::format("%.6f", Record.getWallTime()) << ", \"user\": "
+     << llvm::format("%.6f", Record.getUserTime()) << ", \"system\": "
+     << llvm::format("%.6f", Record.getSystemTime()) << " }";
+}
+
+static void exportProfileData(const ProfileData &Profile,
+                              llvm::raw_ostream &OS) {
+  // Sort the checks by name, so that reports of different runs can be
+  // compared.
+  std::set<std::string> Checks;
+  for (const auto& P : Profile.Records)
+    Checks.insert(P.getKey());
+  for (const auto& P : Profile.PPCallbackRecords)
+    Checks.insert(P.getKey());
+
+  OS << "{\n  \"checks\": [";
+  StringRef Separator = "";
+  for (const std::string &Check : Checks) {
+    OS << Separator << "\n    { \"name\": \"" << llvm::yaml::escape(Check)
+       << "\",\n      ";
+    printTimeRecord("matchers", Profile.Records.lookup(Check), OS);
+    OS << ",\n      ";
+    printTimeRecord("preprocessor", Profile.PPCallbackRecords.lookup(Check),
+                    OS);
+    OS << " }";
+    Separator = ",";
+  }
+  OS << "\n  ]\n}\n";
+}
+
 std::unique_ptr<ClangTidyOptionsProvider> createOptionsProvider() {
   ClangTidyGlobalOptions GlobalOptions;
   if (std::error_code Err = parseLineFilter(LineFilter, GlobalOptions)) {
@@ -297,6 +344,7 @@ int clangTidyMain(int argc, const char **argv) {
   }
 
   ProfileData Profile;
+  bool CollectProfile = EnableCheckProfile || !ExportCheckProfile.empty();
 
   std::vector<ClangTidyError> Errors;
   ClangTidyStats Stats =
@@ -304,7 +352,7 @@ int clangTidyMain(int argc, const char **argv) {
                    SharedModuleProvider::Create<LLVMModuleProvider>(),
                    OptionsParser.getCompilations(),
                    OptionsParser.getSourcePathList(), &Errors,
-                   EnableCheckProfile ? &Profile : nullptr);
+                   CollectProfile ? &Profile : nullptr);
   bool FoundErrors =
       std::find_if(Errors.begin(), Errors.end(), [](const ClangTidyError &E) {
         return E.DiagLevel == ClangTidyError::Error;
@@ -334,6 +382,16 @@ int clangTidyMain(int argc, const char **argv) {
   if (EnableCheckProfile)
     printProfileData(Profile, llvm::errs());
 
+  if (!ExportCheckProfile.empty()) {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(ExportCheckProfile, EC, llvm::sys::fs::F_Text);
+    if (EC) {
+      llvm::errs() << "Error opening output file: " << EC.message() << '\n';
+      return 1;
+    }
+    exportProfileData(Profile, OS);
+  }
+
   return 0;
 }
 
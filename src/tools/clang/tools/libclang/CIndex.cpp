@@ -2822,6 +2822,16 @@ CXIndex clang_createIndex(int excludeDeclarationsFromPCH,
     CIdxr->setCXGlobalOptFlags(CIdxr->getCXGlobalOptFlags() |
                                CXGlobalOpt_ThreadBackgroundPriorityForEditing);
 
+  // Let translation units of this index share identical precompiled
+  // preambles. LIBCLANG_PREAMBLE_CACHE_SIZE is the size limit in megabytes of
+  // the preamble files kept for reuse; zero disables sharing.
+  unsigned PreambleCacheSize = 256;
+  if (const char *Size = getenv("LIBCLANG_PREAMBLE_CACHE_SIZE"))
+    PreambleCacheSize = strtoul(Size, nullptr, 10);
+  if (PreambleCacheSize)
+    CIdxr->setPreambleCache(llvm::make_unique<PrecompiledPreambleCache>(
+        uint64_t(PreambleCacheSize) << 20));
+
   return CIdxr;
 }
 
@@ -3025,7 +3035,8 @@ static void clang_parseTranslationUnit_Impl(void *UserData) {
       /*RemappedFilesKeepOriginalName=*/true, PrecompilePreamble, TUKind,
       CacheCodeCompletionResults, IncludeBriefCommentsInCodeCompletion,
       /*AllowPCHWithCompilerErrors=*/true, SkipFunctionBodies,
-      /*UserFilesAreVolatile=*/true, ForSerialization, &ErrUnit));
+      /*UserFilesAreVolatile=*/true, ForSerialization, &ErrUnit,
+      CXXIdx->getPreambleCache()));
 
   if (NumErrors != Diags->getClient()->getNumErrors()) {
     // Make sure to check that 'Unit' is non-NULL.
@@ -3227,7 +3238,6 @@ static void clang_reparseTranslationUnit_Impl(void *UserData) {
       static_cast<ReparseTranslationUnitInfo *>(UserData);
   CXTranslationUnit TU = RTUI->TU;
   unsigned options = RTUI->options;
-  (void) options;
 
   // Check arguments.
   if (isNotUsableTU(TU)) {
@@ -3260,7 +3270,8 @@ static void clang_reparseTranslationUnit_Impl(void *UserData) {
     RemappedFiles->push_back(std::make_pair(UF.Filename, MB.release()));
   }
 
-  if (!CXXUnit->Reparse(*RemappedFiles.get()))
+  if (!CXXUnit->Reparse(*RemappedFiles.get(),
+                        options & CXReparse_SkipUnchangedFunctionBodies))
     RTUI->result = CXError_Success;
   else if (isASTReadError(CXXUnit))
     RTUI->result = CXError_ASTReadError;
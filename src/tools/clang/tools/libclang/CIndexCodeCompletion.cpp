@@ -36,6 +36,7 @@
 #include "llvm/Support/Program.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <atomic>
 #include <cstdio>
 #include <cstdlib>
@@ -526,21 +527,65 @@ namespace {
     CodeCompletionTUInfo CCTUInfo;
     SmallVector<CXCompletionResult, 16> StoredResults;
     CXTranslationUnit *TU;
+    /// \brief Only results whose typed text starts with this prefix (ignoring
+    /// case) are kept.
+    std::string FilterPrefix;
+    /// \brief The maximum number of results to keep, or 0 for no limit.
+    unsigned MaxResults;
   public:
     CaptureCompletionResults(const CodeCompleteOptions &Opts,
                              AllocatedCXCodeCompleteResults &Results,
-                             CXTranslationUnit *TranslationUnit)
+                             CXTranslationUnit *TranslationUnit,
+                             StringRef FilterPrefix = StringRef(),
+                             unsigned MaxResults = 0)
       : CodeCompleteConsumer(Opts, false), 
         AllocatedResults(Results), CCTUInfo(Results.CodeCompletionAllocator),
-        TU(TranslationUnit) { }
+        TU(TranslationUnit), FilterPrefix(FilterPrefix),
+        MaxResults(MaxResults) { }
     ~CaptureCompletionResults() { Finish(); }
 
+    /// \brief Select the results that pass the prefix filter and, if there
+    /// are more than the remaining result limit, keep the best-ranked ones.
+    ///
+    /// This is done before any code-completion string is built, so that
+    /// discarded results cost no more than a look at their names.
+    void selectResults(CodeCompletionResult *Results, unsigned NumResults,
+                       SmallVectorImpl<unsigned> &Selected) {
+      for (unsigned I = 0; I != NumResults; ++I) {
+        if (!FilterPrefix.empty()) {
+          std::string Saved;
+          if (!Results[I].getOrderedName(Saved).startswith_lower(FilterPrefix))
+            continue;
+        }
+        Selected.push_back(I);
+      }
+
+      if (!MaxResults)
+        return;
+      unsigned Remaining = MaxResults > StoredResults.size()
+                             ? MaxResults - StoredResults.size() : 0;
+      if (Selected.size() <= Remaining)
+        return;
+
+      // Rank by priority, breaking ties alphabetically, and keep the best.
+      std::partial_sort(Selected.begin(), Selected.begin() + Remaining,
+                        Selected.end(), [&](unsigned X, unsigned Y) {
+        if (Results[X].Priority != Results[Y].Priority)
+          return Results[X].Priority < Results[Y].Priority;
+        return Results[X] < Results[Y];
+      });
+      Selected.resize(Remaining);
+    }
+
     void ProcessCodeCompleteResults(Sema &S, 
                                     CodeCompletionContext Context,
                                     CodeCompletionResult *Results,
                                     unsigned NumResults) override {
-      StoredResults.reserve(StoredResults.size() + NumResults);
-      for (unsigned I = 0; I != NumResults; ++I) {
+      SmallVector<unsigned, 64> Selected;
+      selectResults(Results, NumResults, Selected);
+
+      StoredResults.reserve(StoredResults.size() + Selected.size());
+      for (unsigned I : Selected) {
         CodeCompletionString *StoredCompletion        
           = Results[I].CreateCodeCompletionString(S, Context, getAllocator(),
                                                   getCodeCompletionTUInfo(),
@@ -654,6 +699,8 @@ struct CodeCompleteAtInfo {
   unsigned complete_column;
   ArrayRef<CXUnsavedFile> unsaved_files;
   unsigned options;
+  const char *filter_prefix;
+  unsigned max_results;
   CXCodeCompleteResults *result;
 };
 void clang_codeCompleteAt_Impl(void *UserData) {
@@ -711,7 +758,10 @@ void clang_codeCompleteAt_Impl(void *UserData) {
   // Create a code-completion consumer to capture the results.
   CodeCompleteOptions Opts;
   Opts.IncludeBriefComments = IncludeBriefComments;
-  CaptureCompletionResults Capture(Opts, *Results, &TU);
+  CaptureCompletionResults Capture(Opts, *Results, &TU,
+                                   CCAI->filter_prefix ? CCAI->filter_prefix
+                                                       : "",
+                                   CCAI->max_results);
 
   // Perform completion.
   AST->CodeComplete(complete_filename, complete_line, complete_column,
@@ -815,9 +865,28 @@ CXCodeCompleteResults *clang_codeCompleteAt(CXTranslationUnit TU,
                                             struct CXUnsavedFile *unsaved_files,
                                             unsigned num_unsaved_files,
                                             unsigned options) {
+  return clang_codeCompleteAtWithPrefix(TU, complete_filename, complete_line,
+                                        complete_column, unsaved_files,
+                                        num_unsaved_files, options, nullptr, 0);
+}
+
+CXCodeCompleteResults *
+clang_codeCompleteAtWithPrefix(CXTranslationUnit TU,
+                               const char *complete_filename,
+                               unsigned complete_line,
+                               unsigned complete_column,
+                               struct CXUnsavedFile *unsaved_files,
+                               unsigned num_unsaved_files,
+                               unsigned options,
+                               const char *prefix,
+                               unsigned max_results) {
   LOG_FUNC_SECTION {
     *Log << TU << ' '
          << complete_filename << ':' << complete_line << ':' << complete_column;
+    if (prefix && *prefix)
+      *Log << " prefix:" << prefix;
+    if (max_results)
+      *Log << " max:" << max_results;
   }
 
   if (num_unsaved_files && !unsaved_files)
@@ -825,7 +894,7 @@ CXCodeCompleteResults *clang_codeCompleteAt(CXTranslationUnit TU,
 
   CodeCompleteAtInfo CCAI = {TU, complete_filename, complete_line,
     complete_column, llvm::makeArrayRef(unsaved_files, num_unsaved_files),
-    options, nullptr};
+    options, prefix, max_results, nullptr};
 
   if (getenv("LIBCLANG_NOTHREADS")) {
     clang_codeCompleteAt_Impl(&CCAI);
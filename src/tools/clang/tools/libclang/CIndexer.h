@@ -16,6 +16,7 @@
 #define LLVM_CLANG_TOOLS_LIBCLANG_CINDEXER_H
 
 #include "clang-c/Index.h"
+#include "clang/Frontend/ASTUnit.h"
 #include "clang/Lex/ModuleLoader.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Path.h"
@@ -41,6 +42,10 @@ class CIndexer {
   std::string ResourcesPath;
   SharedModuleProvider MP;
 
+  /// \brief Precompiled preambles shared by the translation units of this
+  /// index, if enabled.
+  std::unique_ptr<PrecompiledPreambleCache> PreambleCache;
+
 public:
   CIndexer(SharedModuleProvider MP)
    : OnlyLocalDecls(false), DisplayDiagnostics(false),
@@ -59,6 +64,13 @@ public:
 
   SharedModuleProvider getModuleProvider() const { return MP; }
 
+  PrecompiledPreambleCache *getPreambleCache() const {
+    return PreambleCache.get();
+  }
+  void setPreambleCache(std::unique_ptr<PrecompiledPreambleCache> Cache) {
+    PreambleCache = std::move(Cache);
+  }
+
   unsigned getCXGlobalOptFlags() const { return Options; }
   void setCXGlobalOptFlags(unsigned options) { Options = options; }
 
@@ -27,11 +27,17 @@
 #include "clang/Lex/PPConditionalDirectiveRecord.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Sema/SemaConsumer.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/MutexGuard.h"
+#include <atomic>
 #include <cstdio>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <tuple>
 
 using namespace clang;
 using namespace cxtu;
@@ -240,6 +246,76 @@ private:
 
 #endif
 
+//===----------------------------------------------------------------------===//
+// Skip Indexed Headers
+//===----------------------------------------------------------------------===//
+
+/// \brief A header indexed during a session, along with a hash of the
+/// configuration of the translation unit that it was indexed in.
+typedef std::tuple<llvm::sys::fs::UniqueID, time_t, size_t> IndexedHeader;
+
+class SessionIndexedHeaders {
+  llvm::sys::Mutex Mux;
+  std::set<IndexedHeader> Headers;
+
+public:
+  SessionIndexedHeaders() : Mux(/*recursive=*/false) {}
+
+  bool contains(const IndexedHeader &Header) {
+    llvm::MutexGuard MG(Mux);
+    return Headers.count(Header);
+  }
+
+  void update(ArrayRef<IndexedHeader> NewHeaders) {
+    llvm::MutexGuard MG(Mux);
+    Headers.insert(NewHeaders.begin(), NewHeaders.end());
+  }
+};
+
+/// \brief Suppresses the indexing of headers that another translation unit of
+/// the session already indexed in the same context, and publishes the headers
+/// indexed by this translation unit once it is done.
+///
+/// Only headers with a multiple-include guard are published, since their
+/// contents do not depend on where they are included from, as long as the
+/// command line configuration is the same.
+class TUIndexedHeadersControl {
+  SessionIndexedHeaders &SessionData;
+  Preprocessor &PP;
+  IndexingContext &IndexCtx;
+  size_t ContextHash;
+  SmallVector<const FileEntry *, 32> IndexedFiles;
+
+public:
+  TUIndexedHeadersControl(SessionIndexedHeaders &sessionData,
+                          Preprocessor &pp, IndexingContext &indexCtx,
+                          size_t contextHash)
+    : SessionData(sessionData), PP(pp), IndexCtx(indexCtx),
+      ContextHash(contextHash) { }
+
+  void enteredHeader(const FileEntry *FE) {
+    if (SessionData.contains(getHeader(FE)))
+      IndexCtx.skipIndexingFile(FE);
+    else
+      IndexedFiles.push_back(FE);
+  }
+
+  void finished() {
+    HeaderSearch &HS = PP.getHeaderSearchInfo();
+    SmallVector<IndexedHeader, 32> NewHeaders;
+    for (const FileEntry *FE : IndexedFiles)
+      if (HS.isFileMultipleIncludeGuarded(FE))
+        NewHeaders.push_back(getHeader(FE));
+    SessionData.update(NewHeaders);
+  }
+
+private:
+  IndexedHeader getHeader(const FileEntry *FE) const {
+    return IndexedHeader(FE->getUniqueID(), FE->getModificationTime(),
+                         ContextHash);
+  }
+};
+
 //===----------------------------------------------------------------------===//
 // IndexPPCallbacks
 //===----------------------------------------------------------------------===//
@@ -247,16 +323,24 @@ private:
 class IndexPPCallbacks : public PPCallbacks {
   Preprocessor &PP;
   IndexingContext &IndexCtx;
+  TUIndexedHeadersControl *IHCtrl;
   bool IsMainFileEntered;
 
 public:
-  IndexPPCallbacks(Preprocessor &PP, IndexingContext &indexCtx)
-    : PP(PP), IndexCtx(indexCtx), IsMainFileEntered(false) { }
+  IndexPPCallbacks(Preprocessor &PP, IndexingContext &indexCtx,
+                   TUIndexedHeadersControl *ihCtrl)
+    : PP(PP), IndexCtx(indexCtx), IHCtrl(ihCtrl), IsMainFileEntered(false) { }
 
   void FileChanged(SourceLocation Loc, FileChangeReason Reason,
                  SrcMgr::CharacteristicKind FileType, FileID PrevFID) override {
-    if (IsMainFileEntered)
+    if (IsMainFileEntered) {
+      if (IHCtrl && Reason == PPCallbacks::EnterFile) {
+        SourceManager &SM = PP.getSourceManager();
+        if (const FileEntry *FE = SM.getFileEntryForID(SM.getFileID(Loc)))
+          IHCtrl->enteredHeader(FE);
+      }
       return;
+    }
 
     SourceManager &SM = PP.getSourceManager();
     SourceLocation MainFileLoc = SM.getLocForStartOfFile(SM.getMainFileID());
@@ -303,10 +387,12 @@ public:
 class IndexingConsumer : public ASTConsumer {
   IndexingContext &IndexCtx;
   TUSkipBodyControl *SKCtrl;
+  TUIndexedHeadersControl *IHCtrl;
 
 public:
-  IndexingConsumer(IndexingContext &indexCtx, TUSkipBodyControl *skCtrl)
-    : IndexCtx(indexCtx), SKCtrl(skCtrl) { }
+  IndexingConsumer(IndexingContext &indexCtx, TUSkipBodyControl *skCtrl,
+                   TUIndexedHeadersControl *ihCtrl)
+    : IndexCtx(indexCtx), SKCtrl(skCtrl), IHCtrl(ihCtrl) { }
 
   // ASTConsumer Implementation
 
@@ -318,6 +404,9 @@ public:
   void HandleTranslationUnit(ASTContext &Ctx) override {
     if (SKCtrl)
       SKCtrl->finished();
+    // Headers of an aborted translation unit may be only partially indexed.
+    if (IHCtrl && !IndexCtx.shouldAbort())
+      IHCtrl->finished();
   }
 
   bool HandleTopLevelDecl(DeclGroupRef DG) override {
@@ -405,14 +494,18 @@ class IndexingFrontendAction : public ASTFrontendAction {
   SessionSkipBodyData *SKData;
   std::unique_ptr<TUSkipBodyControl> SKCtrl;
 
+  SessionIndexedHeaders *IHData;
+  std::unique_ptr<TUIndexedHeadersControl> IHCtrl;
+
 public:
   IndexingFrontendAction(CXClientData clientData,
                          IndexerCallbacks &indexCallbacks,
                          unsigned indexOptions,
                          CXTranslationUnit cxTU,
-                         SessionSkipBodyData *skData)
+                         SessionSkipBodyData *skData,
+                         SessionIndexedHeaders *ihData)
     : IndexCtx(clientData, indexCallbacks, indexOptions, cxTU),
-      CXTU(cxTU), SKData(skData) { }
+      CXTU(cxTU), SKData(skData), IHData(ihData) { }
 
   std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &CI,
                                                  StringRef InFile) override {
@@ -425,7 +518,20 @@ public:
 
     IndexCtx.setASTContext(CI.getASTContext());
     Preprocessor &PP = CI.getPreprocessor();
-    PP.addPPCallbacks(llvm::make_unique<IndexPPCallbacks>(PP, IndexCtx));
+    if (IHData) {
+      // Headers are only shared between translation units whose command
+      // line configuration, including implicitly included files, is the same.
+      size_t ContextHash = llvm::hash_combine(
+          CI.getInvocation().getModuleHash(),
+          llvm::hash_combine_range(PPOpts.Includes.begin(),
+                                   PPOpts.Includes.end()),
+          PPOpts.ImplicitPCHInclude);
+      IHCtrl = llvm::make_unique<TUIndexedHeadersControl>(*IHData, PP,
+                                                          IndexCtx,
+                                                          ContextHash);
+    }
+    PP.addPPCallbacks(llvm::make_unique<IndexPPCallbacks>(PP, IndexCtx,
+                                                          IHCtrl.get()));
     IndexCtx.setPreprocessor(PP);
 
     if (SKData) {
@@ -434,7 +540,8 @@ public:
       SKCtrl = llvm::make_unique<TUSkipBodyControl>(*SKData, *PPRec, PP);
     }
 
-    return llvm::make_unique<IndexingConsumer>(IndexCtx, SKCtrl.get());
+    return llvm::make_unique<IndexingConsumer>(IndexCtx, SKCtrl.get(),
+                                               IHCtrl.get());
   }
 
   void EndSourceFileAction() override {
@@ -457,9 +564,11 @@ public:
 struct IndexSessionData {
   CXIndex CIdx;
   std::unique_ptr<SessionSkipBodyData> SkipBodyData;
+  std::unique_ptr<SessionIndexedHeaders> IndexedHeaders;
 
   explicit IndexSessionData(CXIndex cIdx)
-    : CIdx(cIdx), SkipBodyData(new SessionSkipBodyData) {}
+    : CIdx(cIdx), SkipBodyData(new SessionSkipBodyData),
+      IndexedHeaders(new SessionIndexedHeaders) {}
 };
 
 struct IndexSourceFileInfo {
@@ -614,10 +723,15 @@ static void clang_indexSourceFile_Impl(void *UserData) {
   if (SkipBodies)
     CInvok->getFrontendOpts().SkipFunctionBodies = true;
 
+  SessionIndexedHeaders *IndexedHeaders = nullptr;
+  if (index_options & CXIndexOpt_SkipIndexedHeadersInSession)
+    IndexedHeaders = IdxSession->IndexedHeaders.get();
+
   std::unique_ptr<IndexingFrontendAction> IndexAction;
   IndexAction.reset(new IndexingFrontendAction(client_data, CB,
                                                index_options, CXTU->getTU(),
-                        SkipBodies ? IdxSession->SkipBodyData.get() : nullptr));
+                        SkipBodies ? IdxSession->SkipBodyData.get() : nullptr,
+                                               IndexedHeaders));
 
   // Recover resources if we crash before exiting this method.
   llvm::CrashRecoveryContextCleanupRegistrar<IndexingFrontendAction>
@@ -676,6 +790,112 @@ static void clang_indexSourceFile_Impl(void *UserData) {
   ITUI->result = CXError_Success;
 }
 
+//===----------------------------------------------------------------------===//
+// clang_indexSourceFiles Implementation
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+/// \brief The client data given to the callbacks of one source file indexed
+/// by clang_indexSourceFiles.
+///
+/// The callbacks forward to those of the client while holding the lock of
+/// the call, so that the client never receives two callbacks at once.
+struct SerializedCallbackData {
+  IndexerCallbacks *CB;
+  CXClientData ClientData;
+  std::mutex *Mutex;
+};
+
+} // anonymous namespace
+
+static SerializedCallbackData &getSerializedData(CXClientData client_data) {
+  return *static_cast<SerializedCallbackData *>(client_data);
+}
+
+static int serializedAbortQuery(CXClientData client_data, void *reserved) {
+  SerializedCallbackData &Data = getSerializedData(client_data);
+  std::lock_guard<std::mutex> Guard(*Data.Mutex);
+  return Data.CB->abortQuery(Data.ClientData, reserved);
+}
+
+static void serializedDiagnostic(CXClientData client_data,
+                                 CXDiagnosticSet diags, void *reserved) {
+  SerializedCallbackData &Data = getSerializedData(client_data);
+  std::lock_guard<std::mutex> Guard(*Data.Mutex);
+  Data.CB->diagnostic(Data.ClientData, diags, reserved);
+}
+
+static CXIdxClientFile serializedEnteredMainFile(CXClientData client_data,
+                                                 CXFile mainFile,
+                                                 void *reserved) {
+  SerializedCallbackData &Data = getSerializedData(client_data);
+  std::lock_guard<std::mutex> Guard(*Data.Mutex);
+  return Data.CB->enteredMainFile(Data.ClientData, mainFile, reserved);
+}
+
+static CXIdxClientFile
+serializedPPIncludedFile(CXClientData client_data,
+                         const CXIdxIncludedFileInfo *info) {
+  SerializedCallbackData &Data = getSerializedData(client_data);
+  std::lock_guard<std::mutex> Guard(*Data.Mutex);
+  return Data.CB->ppIncludedFile(Data.ClientData, info);
+}
+
+static CXIdxClientASTFile
+serializedImportedASTFile(CXClientData client_data,
+                          const CXIdxImportedASTFileInfo *info) {
+  SerializedCallbackData &Data = getSerializedData(client_data);
+  std::lock_guard<std::mutex> Guard(*Data.Mutex);
+  return Data.CB->importedASTFile(Data.ClientData, info);
+}
+
+static CXIdxClientContainer
+serializedStartedTranslationUnit(CXClientData client_data, void *reserved) {
+  SerializedCallbackData &Data = getSerializedData(client_data);
+  std::lock_guard<std::mutex> Guard(*Data.Mutex);
+  return Data.CB->startedTranslationUnit(Data.ClientData, reserved);
+}
+
+static void serializedIndexDeclaration(CXClientData client_data,
+                                       const CXIdxDeclInfo *info) {
+  SerializedCallbackData &Data = getSerializedData(client_data);
+  std::lock_guard<std::mutex> Guard(*Data.Mutex);
+  Data.CB->indexDeclaration(Data.ClientData, info);
+}
+
+static void serializedIndexEntityReference(CXClientData client_data,
+                                           const CXIdxEntityRefInfo *info) {
+  SerializedCallbackData &Data = getSerializedData(client_data);
+  std::lock_guard<std::mutex> Guard(*Data.Mutex);
+  Data.CB->indexEntityReference(Data.ClientData, info);
+}
+
+/// \brief Build the callbacks that serialize the calls to \p CB; callbacks
+/// that the client did not provide stay null, so that the indexer does not
+/// do the work of preparing their arguments.
+static IndexerCallbacks getSerializedCallbacks(const IndexerCallbacks &CB) {
+  IndexerCallbacks Serialized;
+  memset(&Serialized, 0, sizeof(Serialized));
+  if (CB.abortQuery)
+    Serialized.abortQuery = serializedAbortQuery;
+  if (CB.diagnostic)
+    Serialized.diagnostic = serializedDiagnostic;
+  if (CB.enteredMainFile)
+    Serialized.enteredMainFile = serializedEnteredMainFile;
+  if (CB.ppIncludedFile)
+    Serialized.ppIncludedFile = serializedPPIncludedFile;
+  if (CB.importedASTFile)
+    Serialized.importedASTFile = serializedImportedASTFile;
+  if (CB.startedTranslationUnit)
+    Serialized.startedTranslationUnit = serializedStartedTranslationUnit;
+  if (CB.indexDeclaration)
+    Serialized.indexDeclaration = serializedIndexDeclaration;
+  if (CB.indexEntityReference)
+    Serialized.indexEntityReference = serializedIndexEntityReference;
+  return Serialized;
+}
+
 //===----------------------------------------------------------------------===//
 // clang_indexTranslationUnit Implementation
 //===----------------------------------------------------------------------===//
@@ -778,7 +998,7 @@ static void clang_indexTranslationUnit_Impl(void *UserData) {
     IndexCtxCleanup(IndexCtx.get());
 
   std::unique_ptr<IndexingConsumer> IndexConsumer;
-  IndexConsumer.reset(new IndexingConsumer(*IndexCtx, nullptr));
+  IndexConsumer.reset(new IndexingConsumer(*IndexCtx, nullptr, nullptr));
 
   // Recover resources if we crash before exiting this method.
   llvm::CrashRecoveryContextCleanupRegistrar<IndexingConsumer>
@@ -1029,6 +1249,70 @@ int clang_indexSourceFile(CXIndexAction idxAction,
   return result;
 }
 
+int clang_indexSourceFiles(CXIndexAction idxAction,
+                           IndexerCallbacks *index_callbacks,
+                           unsigned index_callbacks_size,
+                           unsigned index_options,
+                           CXIndexSourceFileJob *jobs,
+                           unsigned num_jobs,
+                           unsigned num_threads) {
+  LOG_FUNC_SECTION {
+    *Log << num_jobs << " files, " << num_threads << " threads";
+  }
+
+  if (!idxAction || !index_callbacks || index_callbacks_size == 0)
+    return CXError_InvalidArguments;
+  if (num_jobs && !jobs)
+    return CXError_InvalidArguments;
+
+  IndexerCallbacks CB;
+  memset(&CB, 0, sizeof(CB));
+  unsigned ClientCBSize = index_callbacks_size < sizeof(CB)
+                                  ? index_callbacks_size : sizeof(CB);
+  memcpy(&CB, index_callbacks, ClientCBSize);
+  IndexerCallbacks SerializedCB = getSerializedCallbacks(CB);
+  std::mutex CallbackMutex;
+
+  // The resources path is computed lazily; do it before there are workers
+  // that could race on it.
+  IndexSessionData *IdxSession = static_cast<IndexSessionData *>(idxAction);
+  static_cast<CIndexer *>(IdxSession->CIdx)->getClangResourcesPath();
+
+  std::atomic<unsigned> NextJob(0);
+  std::atomic<bool> Failed(false);
+  auto IndexJobs = [&] {
+    for (unsigned I = NextJob++; I < num_jobs; I = NextJob++) {
+      CXIndexSourceFileJob &Job = jobs[I];
+      SerializedCallbackData Data = { &CB, Job.client_data, &CallbackMutex };
+      Job.result = clang_indexSourceFile(idxAction, &Data, &SerializedCB,
+                                         sizeof(SerializedCB), index_options,
+                                         Job.source_filename,
+                                         Job.command_line_args,
+                                         Job.num_command_line_args,
+                                         Job.unsaved_files,
+                                         Job.num_unsaved_files,
+                                         /*out_TU=*/nullptr,
+                                         /*TU_options=*/0);
+      if (Job.result)
+        Failed = true;
+    }
+  };
+
+  if (!num_threads)
+    num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  num_threads = std::min(num_threads, num_jobs);
+
+  // The calling thread is one of the workers.
+  std::vector<std::thread> Workers;
+  for (unsigned I = 1; I < num_threads; ++I)
+    Workers.push_back(std::thread(IndexJobs));
+  IndexJobs();
+  for (std::thread &Worker : Workers)
+    Worker.join();
+
+  return Failed ? CXError_Failure : CXError_Success;
+}
+
 int clang_indexTranslationUnit(CXIndexAction idxAction,
                                CXClientData client_data,
                                IndexerCallbacks *index_callbacks,
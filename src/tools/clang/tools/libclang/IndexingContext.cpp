@@ -314,6 +314,8 @@ bool IndexingContext::handleDecl(const NamedDecl *D,
     return false;
   if (D->isImplicit() && shouldIgnoreIfImplicit(D))
     return false;
+  if (isInSkippedFile(Loc))
+    return false;
 
   ScratchAlloc SA(*this);
   getEntityInfo(D, DInfo.EntInfo, SA);
@@ -676,6 +678,8 @@ bool IndexingContext::handleReference(const NamedDecl *D, SourceLocation Loc,
     return false;
   if (Loc.isInvalid())
     return false;
+  if (isInSkippedFile(Loc))
+    return false;
   if (!shouldIndexFunctionLocalSymbols() && isFunctionLocalDecl(D))
     return false;
   if (isNotFromSourceFile(D->getLocation()))
@@ -718,6 +722,14 @@ bool IndexingContext::isNotFromSourceFile(SourceLocation Loc) const {
   return SM.getFileEntryForID(FID) == nullptr;
 }
 
+bool IndexingContext::isInSkippedFile(SourceLocation Loc) const {
+  if (SkippedFiles.empty() || Loc.isInvalid())
+    return false;
+  SourceManager &SM = Ctx->getSourceManager();
+  FileID FID = SM.getFileID(SM.getFileLoc(Loc));
+  return SkippedFiles.count(SM.getFileEntryForID(FID));
+}
+
 void IndexingContext::addContainerInMap(const DeclContext *DC,
                                         CXIdxClientContainer container) {
   if (!DC)
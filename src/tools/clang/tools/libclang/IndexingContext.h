@@ -292,6 +292,10 @@ class IndexingContext {
   typedef std::pair<const FileEntry *, const Decl *> RefFileOccurrence;
   llvm::DenseSet<RefFileOccurrence> RefFileOccurrences;
 
+  /// \brief Files whose declarations and references are not reported,
+  /// because they were already indexed in the same context.
+  llvm::DenseSet<const FileEntry *> SkippedFiles;
+
   std::deque<DeclGroupRef> TUDeclsInObjCContainer;
   
   llvm::BumpPtrAllocator StrScratch;
@@ -445,6 +449,11 @@ public:
 
   bool isNotFromSourceFile(SourceLocation Loc) const;
 
+  /// \brief Do not report declarations or references located in \p File.
+  void skipIndexingFile(const FileEntry *File) { SkippedFiles.insert(File); }
+
+  bool isInSkippedFile(SourceLocation Loc) const;
+
   void indexTopLevelDecl(const Decl *D);
   void indexTUDeclsInObjCContainer();
   void indexDeclGroupRef(DeclGroupRef DG);
@@ -8,10 +8,12 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Basic/VirtualFileSystem.h"
+#include "clang/Basic/FileSystemStatCache.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 #include <map>
 using namespace clang;
@@ -515,6 +517,164 @@ TEST(VirtualFileSystemTest, HiddenInIteration) {
   }
 }
 
+namespace {
+class CountingFileSystem : public DummyFileSystem {
+public:
+  unsigned NumStatus = 0;
+
+  ErrorOr<vfs::Status> status(const Twine &Path) override {
+    ++NumStatus;
+    return DummyFileSystem::status(Path);
+  }
+
+  void addOldDirectory(StringRef Path, unsigned MTime) {
+    addEntry(Path, vfs::Status(Path, Path, UniqueID(0, MTime),
+                               sys::TimeValue(MTime, 0), 0, 0, 0,
+                               sys::fs::file_type::directory_file,
+                               sys::fs::all_all));
+  }
+};
+} // end anonymous namespace
+
+TEST(CachingFileSystemTest, MissingFiles) {
+  IntrusiveRefCntPtr<CountingFileSystem> D(new CountingFileSystem());
+  D->addOldDirectory("//root", 1000);
+  D->addOldDirectory("//root/dir", 1000);
+  IntrusiveRefCntPtr<vfs::CachingFileSystem> Cache(
+      new vfs::CachingFileSystem(D));
+
+  EXPECT_EQ(llvm::errc::no_such_file_or_directory,
+            Cache->status("//root/dir/missing").getError());
+  unsigned NumStatus = D->NumStatus;
+  EXPECT_EQ(llvm::errc::no_such_file_or_directory,
+            Cache->status("//root/dir/missing").getError());
+  EXPECT_EQ(NumStatus, D->NumStatus);
+
+  // The directories are checked again, but not the missing file.
+  Cache->revalidate();
+  EXPECT_EQ(llvm::errc::no_such_file_or_directory,
+            Cache->status("//root/dir/missing").getError());
+  EXPECT_EQ(NumStatus + 2, D->NumStatus);
+
+  // Creating the file modifies its directory.
+  D->addRegularFile("//root/dir/missing");
+  D->addOldDirectory("//root/dir", 2000);
+  EXPECT_EQ(llvm::errc::no_such_file_or_directory,
+            Cache->status("//root/dir/missing").getError());
+  Cache->revalidate();
+  ErrorOr<vfs::Status> Status = Cache->status("//root/dir/missing");
+  ASSERT_FALSE(Status.getError());
+  EXPECT_TRUE(Status->isRegularFile());
+  EXPECT_EQ("//root/dir/missing", Status->getName());
+}
+
+TEST(CachingFileSystemTest, RecentlyModifiedDirectory) {
+  IntrusiveRefCntPtr<CountingFileSystem> D(new CountingFileSystem());
+  D->addOldDirectory("//root", 1000);
+  D->addDirectory("//root/dir");
+  IntrusiveRefCntPtr<vfs::CachingFileSystem> Cache(
+      new vfs::CachingFileSystem(D));
+
+  // The directory may change again within its modification time, so its
+  // missing files are checked in every generation.
+  EXPECT_EQ(llvm::errc::no_such_file_or_directory,
+            Cache->status("//root/dir/missing").getError());
+  unsigned NumStatus = D->NumStatus;
+  Cache->revalidate();
+  EXPECT_EQ(llvm::errc::no_such_file_or_directory,
+            Cache->status("//root/dir/missing").getError());
+  EXPECT_EQ(NumStatus + 3, D->NumStatus);
+}
+
+TEST(CachingFileSystemTest, VolatileDirectory) {
+  IntrusiveRefCntPtr<CountingFileSystem> D(new CountingFileSystem());
+  D->addOldDirectory("//root", 1000);
+  D->addOldDirectory("//root/cache", 1000);
+  IntrusiveRefCntPtr<vfs::CachingFileSystem> Cache(
+      new vfs::CachingFileSystem(D));
+  Cache->addVolatileDirectory("//root/cache");
+
+  EXPECT_EQ(llvm::errc::no_such_file_or_directory,
+            Cache->status("//root/cache/module.pcm").getError());
+  D->addRegularFile("//root/cache/module.pcm");
+  EXPECT_FALSE(Cache->status("//root/cache/module.pcm").getError());
+}
+
+static void writeFile(StringRef Path, StringRef Contents) {
+  std::error_code EC;
+  raw_fd_ostream OS(Path, EC, sys::fs::F_None);
+  ASSERT_FALSE(EC);
+  OS << Contents;
+}
+
+TEST(CachingFileSystemTest, FileContents) {
+  ScopedDir TestDirectory("caching-file-system-test", /*Unique*/true);
+  SmallString<128> Path(TestDirectory.Path);
+  sys::path::append(Path, "a.h");
+  writeFile(Path.str(), "abc");
+  IntrusiveRefCntPtr<vfs::CachingFileSystem> Cache(
+      new vfs::CachingFileSystem(vfs::getRealFileSystem()));
+
+  auto Buffer = Cache->getBufferForFile(Path.str());
+  ASSERT_FALSE(Buffer.getError());
+  EXPECT_EQ("abc", (*Buffer)->getBuffer());
+
+  // The file is only checked again in the next generation.
+  writeFile(Path.str(), "abcd");
+  Buffer = Cache->getBufferForFile(Path.str());
+  ASSERT_FALSE(Buffer.getError());
+  EXPECT_EQ("abc", (*Buffer)->getBuffer());
+
+  Cache->revalidate();
+  Buffer = Cache->getBufferForFile(Path.str());
+  ASSERT_FALSE(Buffer.getError());
+  EXPECT_EQ("abcd", (*Buffer)->getBuffer());
+
+  EXPECT_FALSE(sys::fs::remove(Path.str()));
+}
+
+TEST(DirectoryListingStatCacheTest, MissingFiles) {
+  IntrusiveRefCntPtr<CountingFileSystem> D(new CountingFileSystem());
+  D->addOldDirectory("//root", 1000);
+  D->addOldDirectory("//root/dir", 1000);
+  D->addRegularFile("//root/dir/Found.h");
+
+  SmallString<128> CacheFile;
+  ASSERT_FALSE(sys::fs::createTemporaryFile("listings", "cache", CacheFile));
+
+  FileData Data;
+  {
+    DirectoryListingStatCache Cache(CacheFile);
+    EXPECT_EQ(FileSystemStatCache::CacheMissing,
+              Cache.getStat("//root/dir/missing.h", Data, true, nullptr, *D));
+    EXPECT_EQ(FileSystemStatCache::CacheExists,
+              Cache.getStat("//root/dir/Found.h", Data, true, nullptr, *D));
+    // The directory is only checked once.
+    unsigned NumStatus = D->NumStatus;
+    EXPECT_EQ(FileSystemStatCache::CacheMissing,
+              Cache.getStat("//root/dir/other.h", Data, true, nullptr, *D));
+    EXPECT_EQ(NumStatus, D->NumStatus);
+    EXPECT_FALSE(Cache.save());
+  }
+
+  // The next compiles don't list the directory again until it changes.
+  D->addRegularFile("//root/dir/new.h");
+  {
+    DirectoryListingStatCache Cache(CacheFile);
+    EXPECT_EQ(FileSystemStatCache::CacheMissing,
+              Cache.getStat("//root/dir/new.h", Data, true, nullptr, *D));
+  }
+  D->addOldDirectory("//root/dir", 2000);
+  {
+    DirectoryListingStatCache Cache(CacheFile);
+    EXPECT_EQ(FileSystemStatCache::CacheExists,
+              Cache.getStat("//root/dir/new.h", Data, true, nullptr, *D));
+    EXPECT_FALSE(Cache.save());
+  }
+
+  sys::fs::remove(CacheFile.str());
+}
+
 // NOTE: in the tests below, we use '//root/' as our root directory, since it is
 // a legal *absolute* path on Windows as well as *nix.
 class VFSFromYAMLTest : public ::testing::Test {
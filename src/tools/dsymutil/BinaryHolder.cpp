@@ -33,10 +33,88 @@ getMachOFatMemoryBuffers(StringRef Filename, MemoryBuffer &Mem,
   return std::move(Buffers);
 }
 
+ErrorOr<std::unique_ptr<MappedArchive>>
+MappedArchive::create(StringRef Filename, bool Verbose) {
+  // Archives do not need to be null terminated. Not requiring it lets
+  // the buffer be a plain mapping of the file, whatever its size.
+  auto ErrOrBuff =
+      Filename == "-" ? MemoryBuffer::getSTDIN()
+                      : MemoryBuffer::getFile(Filename, -1,
+                                              /*RequiresNullTerminator=*/false);
+  if (auto Err = ErrOrBuff.getError())
+    return Err;
+
+  if (Verbose)
+    outs() << "\topened new archive '" << Filename << "'\n";
+
+  std::unique_ptr<MappedArchive> Result(new MappedArchive);
+  Result->Filename = Filename;
+  Result->MemBuffer = std::move(*ErrOrBuff);
+
+  std::vector<MemoryBufferRef> ArchiveBuffers;
+  auto ErrOrFat = object::MachOUniversalBinary::create(
+      Result->MemBuffer->getMemBufferRef());
+  if (ErrOrFat.getError()) {
+    // Not a fat binary must be a standard one.
+    ArchiveBuffers.push_back(Result->MemBuffer->getMemBufferRef());
+  } else {
+    Result->FatBinary = std::move(*ErrOrFat);
+    ArchiveBuffers = getMachOFatMemoryBuffers(Filename, *Result->MemBuffer,
+                                              *Result->FatBinary);
+  }
+
+  for (auto MemRef : ArchiveBuffers) {
+    auto ErrOrArchive = object::Archive::create(MemRef);
+    if (auto Err = ErrOrArchive.getError())
+      return Err;
+    Result->Archives.push_back(std::move(*ErrOrArchive));
+  }
+
+  // Index the members. Only the member headers are read here, the
+  // member contents are left untouched until somebody parses them.
+  for (const auto &Archive : Result->Archives) {
+    for (const auto &Child : Archive->children()) {
+      auto NameOrErr = Child.getName();
+      if (NameOrErr.getError())
+        continue;
+      auto ErrOrMem = Child.getMemoryBufferRef();
+      if (ErrOrMem.getError())
+        continue;
+      Result->Members[*NameOrErr].push_back(
+          {*ErrOrMem, Child.getLastModified()});
+    }
+  }
+
+  return std::move(Result);
+}
+
+ErrorOr<std::shared_ptr<const MappedArchive>>
+ArchiveCache::get(StringRef Filename, bool Verbose) {
+  std::lock_guard<std::mutex> Guard(Lock);
+  for (auto It = Entries.begin(), End = Entries.end(); It != End; ++It) {
+    if ((*It)->getFileName() != Filename)
+      continue;
+    // Move the entry to the front of the list.
+    Entries.splice(Entries.begin(), Entries, It);
+    return Entries.front();
+  }
+
+  auto ErrOrArchive = MappedArchive::create(Filename, Verbose);
+  if (auto Err = ErrOrArchive.getError())
+    return Err;
+
+  Entries.emplace_front(std::move(*ErrOrArchive));
+  if (Entries.size() > MaxSize)
+    Entries.pop_back();
+  return Entries.front();
+}
+
 void
 BinaryHolder::changeBackingMemoryBuffer(std::unique_ptr<MemoryBuffer> &&Buf) {
-  CurrentArchives.clear();
+  // The object files might point into the current archive, release
+  // them first.
   CurrentObjectFiles.clear();
+  CurrentArchive.reset();
   CurrentFatBinary.reset();
 
   CurrentMemoryBuffer = std::move(Buf);
@@ -88,39 +166,32 @@ BinaryHolder::GetMemoryBuffersForFile(StringRef Filename,
 ErrorOr<std::vector<MemoryBufferRef>>
 BinaryHolder::GetArchiveMemberBuffers(StringRef Filename,
                                       sys::TimeValue Timestamp) {
-  if (CurrentArchives.empty())
+  if (!CurrentArchive)
     return make_error_code(errc::no_such_file_or_directory);
 
-  StringRef CurArchiveName = CurrentArchives.front()->getFileName();
+  StringRef CurArchiveName = CurrentArchive->getFileName();
   if (!Filename.startswith(Twine(CurArchiveName, "(").str()))
     return make_error_code(errc::no_such_file_or_directory);
 
   // Remove the archive name and the parens around the archive member name.
   Filename = Filename.substr(CurArchiveName.size() + 1).drop_back();
 
-  std::vector<MemoryBufferRef> Buffers;
-  Buffers.reserve(CurrentArchives.size());
+  const auto *Members = CurrentArchive->getMembers(Filename);
+  if (!Members)
+    return make_error_code(errc::no_such_file_or_directory);
 
-  for (const auto &Archive : CurrentArchives) {
-    for (const auto &Child : Archive->children()) {
-      if (auto NameOrErr = Child.getName()) {
-        if (auto Err = NameOrErr.getError())
-          return Err;
-        if (*NameOrErr == Filename) {
-          if (Timestamp != sys::TimeValue::MinTime() &&
-              Timestamp != Child.getLastModified()) {
-            if (Verbose)
-              outs() << "\ttimestamp mismatch.\n";
-          } else {
-            if (Verbose)
-              outs() << "\tfound member in current archive.\n";
-            auto ErrOrMem = Child.getMemoryBufferRef();
-            if (auto Err = ErrOrMem.getError())
-              return Err;
-            Buffers.push_back(*ErrOrMem);
-          }
-        }
-      }
+  std::vector<MemoryBufferRef> Buffers;
+  Buffers.reserve(Members->size());
+
+  for (const auto &Member : *Members) {
+    if (Timestamp != sys::TimeValue::MinTime() &&
+        Timestamp != Member.LastModified) {
+      if (Verbose)
+        outs() << "\ttimestamp mismatch.\n";
+    } else {
+      if (Verbose)
+        outs() << "\tfound member in current archive.\n";
+      Buffers.push_back(Member.Buffer);
     }
   }
 
@@ -135,32 +206,21 @@ BinaryHolder::MapArchiveAndGetMemberBuffers(StringRef Filename,
                                             sys::TimeValue Timestamp) {
   StringRef ArchiveFilename = Filename.substr(0, Filename.find('('));
 
-  auto ErrOrBuff = MemoryBuffer::getFileOrSTDIN(ArchiveFilename);
-  if (auto Err = ErrOrBuff.getError())
-    return Err;
-
-  if (Verbose)
-    outs() << "\topened new archive '" << ArchiveFilename << "'\n";
-
-  changeBackingMemoryBuffer(std::move(*ErrOrBuff));
-  std::vector<MemoryBufferRef> ArchiveBuffers;
-  auto ErrOrFat = object::MachOUniversalBinary::create(
-      CurrentMemoryBuffer->getMemBufferRef());
-  if (ErrOrFat.getError()) {
-    // Not a fat binary must be a standard one.
-    ArchiveBuffers.push_back(CurrentMemoryBuffer->getMemBufferRef());
+  std::shared_ptr<const MappedArchive> Archive;
+  if (Archives) {
+    auto ErrOrArchive = Archives->get(ArchiveFilename, Verbose);
+    if (auto Err = ErrOrArchive.getError())
+      return Err;
+    Archive = std::move(*ErrOrArchive);
   } else {
-    CurrentFatBinary = std::move(*ErrOrFat);
-    ArchiveBuffers = getMachOFatMemoryBuffers(
-        ArchiveFilename, *CurrentMemoryBuffer, *CurrentFatBinary);
-  }
-
-  for (auto MemRef : ArchiveBuffers) {
-    auto ErrOrArchive = object::Archive::create(MemRef);
+    auto ErrOrArchive = MappedArchive::create(ArchiveFilename, Verbose);
     if (auto Err = ErrOrArchive.getError())
       return Err;
-    CurrentArchives.push_back(std::move(*ErrOrArchive));
+    Archive = std::move(*ErrOrArchive);
   }
+
+  changeBackingMemoryBuffer(nullptr);
+  CurrentArchive = std::move(Archive);
   return GetArchiveMemberBuffers(Filename, Timestamp);
 }
 
@@ -14,6 +14,7 @@
 #ifndef LLVM_TOOLS_DSYMUTIL_BINARYHOLDER_H
 #define LLVM_TOOLS_DSYMUTIL_BINARYHOLDER_H
 
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Object/Archive.h"
 #include "llvm/Object/Error.h"
 #include "llvm/Object/MachOUniversal.h"
@@ -21,27 +22,91 @@
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/TimeValue.h"
+#include <list>
+#include <memory>
+#include <mutex>
 
 namespace llvm {
 namespace dsymutil {
 
+/// \brief An archive (or a fat file of archives) mapped to memory,
+/// along with an index of its members.
+///
+/// The archive is mapped without copying it, so the pages of a member
+/// are only read from disk when the member is actually parsed. The
+/// member index is built once when the archive is mapped, instead of
+/// walking the archive for each lookup. A MappedArchive is immutable
+/// once created, which allows sharing it between threads.
+class MappedArchive {
+public:
+  struct Member {
+    MemoryBufferRef Buffer;
+    sys::TimeValue LastModified;
+  };
+
+  /// \brief Map the archive named \p Filename and index its members.
+  static ErrorOr<std::unique_ptr<MappedArchive>> create(StringRef Filename,
+                                                        bool Verbose);
+
+  StringRef getFileName() const { return Filename; }
+
+  /// \brief Return all the members called \p Name (one per
+  /// architecture slice for fat archives), or null if there is none.
+  const std::vector<Member> *getMembers(StringRef Name) const {
+    auto It = Members.find(Name);
+    return It == Members.end() ? nullptr : &It->getValue();
+  }
+
+private:
+  std::string Filename;
+  std::unique_ptr<MemoryBuffer> MemBuffer;
+  std::unique_ptr<object::MachOUniversalBinary> FatBinary;
+  std::vector<std::unique_ptr<object::Archive>> Archives;
+  StringMap<std::vector<Member>> Members;
+};
+
+/// \brief A thread-safe, bounded, most recently used cache of
+/// MappedArchive objects.
+///
+/// Debug maps reference the members of a given archive in sequence,
+/// but several archives can be interleaved, and with -num-threads
+/// multiple BinaryHolders look into the same archives concurrently.
+/// Sharing the mappings avoids remapping and reindexing the archives.
+/// Evicted archives stay alive as long as a BinaryHolder uses them.
+class ArchiveCache {
+  std::mutex Lock;
+  /// \brief The cached archives, most recently used first.
+  std::list<std::shared_ptr<const MappedArchive>> Entries;
+  unsigned MaxSize;
+
+public:
+  explicit ArchiveCache(unsigned MaxSize = 8) : MaxSize(MaxSize) {}
+
+  /// \brief Return the mapping of \p Filename, creating it if needed.
+  ErrorOr<std::shared_ptr<const MappedArchive>> get(StringRef Filename,
+                                                    bool Verbose);
+};
+
 /// \brief The BinaryHolder class is responsible for creating and
 /// owning ObjectFile objects and their underlying MemoryBuffer. This
 /// is different from a simple OwningBinary in that it handles
 /// accessing to archive members.
 ///
 /// As an optimization, this class will reuse an already mapped and
-/// parsed Archive object if 2 successive requests target the same
-/// archive file (Which is always the case in debug maps).
-/// Currently it only owns one memory buffer at any given time,
-/// meaning that a mapping request will invalidate the previous memory
+/// indexed archive if 2 successive requests target the same archive
+/// file (Which is always the case in debug maps). When given an
+/// ArchiveCache, the archive mappings are also shared with the other
+/// holders using that cache.
+/// Currently it only owns one set of object files at any given time,
+/// meaning that a mapping request will invalidate the previous
 /// mapping.
 class BinaryHolder {
-  std::vector<std::unique_ptr<object::Archive>> CurrentArchives;
+  std::shared_ptr<const MappedArchive> CurrentArchive;
   std::unique_ptr<MemoryBuffer> CurrentMemoryBuffer;
   std::vector<std::unique_ptr<object::ObjectFile>> CurrentObjectFiles;
   std::unique_ptr<object::MachOUniversalBinary> CurrentFatBinary;
   Triple CurrentArch;
+  ArchiveCache *Archives;
   bool Verbose;
 
   /// \brief Get the MemoryBufferRef for the file specification in \p
@@ -78,7 +143,8 @@ class BinaryHolder {
   ErrorOr<const object::ObjectFile &> getObjfileForArch(const Triple &T);
 
 public:
-  BinaryHolder(bool Verbose) : Verbose(Verbose) {}
+  BinaryHolder(bool Verbose, ArchiveCache *Archives = nullptr)
+      : Archives(Archives), Verbose(Verbose) {}
 
   /// \brief Get the ObjectFile designated by the \p Filename. This
   /// might be an archive member specification of the form
@@ -54,6 +54,7 @@
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
 #include <cstdlib>
@@ -1995,7 +1996,7 @@ class DwarfLinker {
 public:
   DwarfLinker(StringRef OutputFilename, const LinkOptions &Options)
       : OutputFilename(OutputFilename), Options(Options),
-        BinHolder(Options.Verbose), CurrentDebugObject(nullptr),
+        CurrentDebugObject(nullptr),
         StringPool(Options.Translator),
         AppleNames(DwarfAccelTable::Atom(dwarf::DW_ATOM_die_offset,
                                          dwarf::DW_FORM_data4),
@@ -2063,11 +2064,26 @@ private:
     /// root DIE selection and during DIE cloning.
     unsigned NextValidReloc;
 
+    /// \brief If non-null, warnings are queued here instead of being
+    /// reported right away. See LinkContext.
+    std::vector<std::string> *DeferredWarnings;
+
+    void reportWarning(const Twine &Warning) {
+      if (DeferredWarnings)
+        DeferredWarnings->push_back(Warning.str());
+      else
+        Linker.reportWarning(Warning);
+    }
+
   public:
-    RelocationManager(DwarfLinker &Linker)
-        : Linker(Linker), NextValidReloc(0) {}
+    RelocationManager(DwarfLinker &Linker,
+                      std::vector<std::string> *DeferredWarnings = nullptr)
+        : Linker(Linker), NextValidReloc(0),
+          DeferredWarnings(DeferredWarnings) {}
 
     bool hasValidRelocs() const { return !ValidRelocs.empty(); }
+    /// \brief Stop queuing warnings and report them directly.
+    void stopDeferringWarnings() { DeferredWarnings = nullptr; }
     /// \brief Reset the NextValidReloc counter.
     void resetValidRelocs() { NextValidReloc = 0; }
 
@@ -2116,10 +2132,48 @@ private:
   void loadClangModule(StringRef Filename, StringRef ModulePath,
                        DebugMap &ModuleMap, unsigned Indent = 0);
 
-  /// \brief Attempt to load a debug object from disk.
-  ErrorOr<const object::ObjectFile &> loadObject(BinaryHolder &BinaryHolder,
-                                                 DebugMapObject &Obj,
-                                                 const DebugMap &Map);
+  /// \brief Attempt to load a debug object from disk. If \p
+  /// DeferredWarnings is non-null, warnings are queued there instead
+  /// of being reported.
+  ErrorOr<const object::ObjectFile &>
+  loadObject(BinaryHolder &BinaryHolder, DebugMapObject &Obj,
+             const DebugMap &Map,
+             std::vector<std::string> *DeferredWarnings = nullptr);
+
+  /// \brief A debug map object prepared for linking.
+  ///
+  /// Mapping the object file, looking up its valid relocations and
+  /// extracting its DIEs doesn't touch any state shared with the rest
+  /// of the link. This is what gets done ahead of time on worker
+  /// threads when linking with -num-threads. Everything else (DIE
+  /// selection, cloning and emission) happens in debug map order on
+  /// the main thread, which keeps the output identical to a
+  /// sequential link.
+  struct LinkContext {
+    DebugMapObject &DMO;
+    /// \brief Holder owning the object. The object (and its memory
+    /// mapping when it's not an archive member) is released with the
+    /// LinkContext, once the DebugMapObject has been linked.
+    BinaryHolder BinHolder;
+    /// \brief The loaded object, or null if it couldn't be loaded.
+    const object::ObjectFile *Obj;
+    RelocationManager RelocMgr;
+    /// \brief The debug info of the object, or null if there is
+    /// nothing to link in it.
+    std::unique_ptr<DWARFContextInMemory> DwarfContext;
+    /// \brief Warnings generated while preparing the object. They are
+    /// reported when the object is linked, so that the diagnostics
+    /// don't depend on the thread scheduling.
+    std::vector<std::string> Warnings;
+
+    LinkContext(DwarfLinker &Linker, DebugMapObject &DMO)
+        : DMO(DMO), BinHolder(Linker.Options.Verbose, &Linker.Archives),
+          Obj(nullptr), RelocMgr(Linker, &Warnings) {}
+  };
+
+  /// \brief Load the object described by \p Ctx, find its valid
+  /// relocations and extract its DIEs.
+  void prepareLinkContext(LinkContext &Ctx, const DebugMap &Map);
 
   /// \brief Flags passed to DwarfLinker::lookForDIEsToKeep
   enum TravesalFlags {
@@ -2341,9 +2395,24 @@ protected:
 private:
   std::string OutputFilename;
   LinkOptions Options;
-  BinaryHolder BinHolder;
+  /// \brief The archives mapped by the BinaryHolders of the link.
+  ArchiveCache Archives;
   std::unique_ptr<DwarfStreamer> Streamer;
   uint64_t OutputDebugInfoSize = 0;
+
+  /// \brief Counters describing the effect of ODR type uniquing,
+  /// reported at the end of verbose links.
+  struct {
+    /// Type DIEs that became the canonical definition of their
+    /// declaration context.
+    unsigned CanonicalDIEs = 0;
+    /// Type references redirected to a canonical definition living in
+    /// another compile unit (emitted as DW_FORM_ref_addr).
+    unsigned UniquedReferences = 0;
+    /// Referenced type DIEs that weren't kept because a canonical
+    /// definition had already been emitted.
+    unsigned SkippedDependencies = 0;
+  } ODRStats;
   unsigned UnitID; ///< A unique ID that identifies each compile unit.
 
   DenseMap<DIE *, DeclContext *> DIEToDeclContext;
@@ -2800,7 +2869,7 @@ bool DwarfLinker::RelocationManager::findValidRelocsMachO(
     unsigned RelocSize = 1 << Obj.getAnyRelocationLength(MachOReloc);
     uint64_t Offset64;
     if ((RelocSize != 4 && RelocSize != 8) || Reloc.getOffset(Offset64)) {
-      Linker.reportWarning(" unsupported relocation in debug_info section.");
+      reportWarning(" unsupported relocation in debug_info section.");
       continue;
     }
     uint32_t Offset = Offset64;
@@ -2816,7 +2885,7 @@ bool DwarfLinker::RelocationManager::findValidRelocsMachO(
     if (Sym != Obj.symbol_end()) {
       StringRef SymbolName;
       if (Sym->getName(SymbolName)) {
-        Linker.reportWarning("error getting relocation symbol name.");
+        reportWarning("error getting relocation symbol name.");
         continue;
       }
       if (const auto *Mapping = DMO.lookupSymbol(SymbolName)) {
@@ -2861,7 +2930,7 @@ bool DwarfLinker::RelocationManager::findValidRelocs(
   if (auto *MachOObj = dyn_cast<object::MachOObjectFile>(&Obj))
     FoundInterestingReloc = findValidRelocsMachO(Section, *MachOObj, DMO);
   else
-    Linker.reportWarning(Twine("unsupported object file type: ") +
+    reportWarning(Twine("unsupported object file type: ") +
                          Obj.getFileName());
 
   if (!FoundInterestingReloc)
@@ -3157,8 +3226,10 @@ void DwarfLinker::keepDIEAndDependencies(RelocationManager &RelocMgr,
       if (AttrSpec.Form != dwarf::DW_FORM_ref_addr && UseODR && Info.Ctxt &&
           Info.Ctxt != ReferencedCU->getInfo(Info.ParentIdx).Ctxt &&
           Info.Ctxt->getCanonicalDIEOffset() && Info.Ctxt->isValid() &&
-          isODRAttribute(AttrSpec.Attr))
+          isODRAttribute(AttrSpec.Attr)) {
+        ++ODRStats.SkippedDependencies;
         continue;
+      }
 
       unsigned ODRFlag = UseODR ? TF_ODR : 0;
       lookForDIEsToKeep(RelocMgr, *RefDIE, DMO, *ReferencedCU,
@@ -3441,6 +3512,7 @@ unsigned DwarfLinker::DIECloner::cloneDieReferenceAttribute(
         DIEInteger *Attr = new (DIEAlloc) DIEInteger(TypeOffset);
         Die.addValue((dwarf::Attribute)AttrSpec.Attr, dwarf::DW_FORM_ref_addr,
                      Attr, &Linker.DIEsToDelete);
+        ++Linker.ODRStats.UniquedReferences;
         return getRefAddrSize(*Linker.Streamer, U);
       }
       Ctxt = TypeInfo.Ctxt;
@@ -3876,6 +3948,7 @@ DIE *DwarfLinker::DIECloner::cloneDIE(
       Info.Ctxt != Unit.getInfo(Info.ParentIdx).Ctxt &&
       !Info.Ctxt->getCanonicalDIEOffset()) {
     Info.Ctxt->setCanonicalDIEOffset(OutOffset + Unit.getStartOffset());
+    ++Linker.ODRStats.CanonicalDIEs;
   }
 
   // Extract and clone every attribute.
@@ -4528,17 +4601,45 @@ bool DwarfLinker::registerModuleReference(
 
 ErrorOr<const object::ObjectFile &>
 DwarfLinker::loadObject(BinaryHolder &BinaryHolder, DebugMapObject &Obj,
-                        const DebugMap &Map) {
+                        const DebugMap &Map,
+                        std::vector<std::string> *DeferredWarnings) {
+  auto warnAbout = [&](std::error_code EC) {
+    std::string Warning =
+        (Twine(Obj.getObjectFilename()) + ": " + EC.message()).str();
+    if (DeferredWarnings)
+      DeferredWarnings->push_back(Warning);
+    else
+      reportWarning(Warning);
+  };
+
   auto ErrOrObjs =
       BinaryHolder.GetObjectFiles(Obj.getObjectFilename(), Obj.getTimestamp());
   if (std::error_code EC = ErrOrObjs.getError())
-    reportWarning(Twine(Obj.getObjectFilename()) + ": " + EC.message());
+    warnAbout(EC);
   auto ErrOrObj = BinaryHolder.Get(Map.getTriple());
   if (std::error_code EC = ErrOrObj.getError())
-    reportWarning(Twine(Obj.getObjectFilename()) + ": " + EC.message());
+    warnAbout(EC);
   return ErrOrObj;
 }
 
+void DwarfLinker::prepareLinkContext(LinkContext &Ctx, const DebugMap &Map) {
+  auto ErrOrObj = loadObject(Ctx.BinHolder, Ctx.DMO, Map, &Ctx.Warnings);
+  if (!ErrOrObj)
+    return;
+  Ctx.Obj = &*ErrOrObj;
+
+  // Look for relocations that correspond to debug map entries.
+  if (!Options.Update &&
+      !Ctx.RelocMgr.findValidRelocsInDebugInfo(*Ctx.Obj, Ctx.DMO))
+    return;
+
+  // Setup access to the debug info and extract all the DIEs now, this
+  // is the expensive part of reading the input.
+  Ctx.DwarfContext.reset(new DWARFContextInMemory(*Ctx.Obj));
+  for (const auto &CU : Ctx.DwarfContext->compile_units())
+    CU->getCompileUnitDIE(false);
+}
+
 void DwarfLinker::loadClangModule(StringRef Filename, StringRef ModulePath,
                                   DebugMap &ModuleMap,
                                   unsigned Indent) {
@@ -4676,8 +4777,39 @@ bool DwarfLinker::link(const DebugMap &Map) {
 
   DebugMap ModuleMap(Map.getTriple(), Map.getBinaryPath());
 
-  for (const auto &Obj : Map.objects()) {
-    CurrentDebugObject = Obj.get();
+  // When linking with multiple threads, the objects are prepared
+  // (loaded, scanned for relocations and parsed) ahead of time by a
+  // pool of workers, at most NumThreads objects in advance of the one
+  // currently being linked to bound the memory usage.
+  std::vector<DebugMapObject *> Objects;
+  for (const auto &Obj : Map.objects())
+    Objects.push_back(Obj.get());
+  std::vector<std::unique_ptr<LinkContext>> Contexts(Objects.size());
+  std::vector<std::future<void>> PreparedContexts(Objects.size());
+  unsigned NextObjectToLoad = 0;
+  std::unique_ptr<ThreadPool> Pool;
+  if (Options.NumThreads > 1)
+    Pool = llvm::make_unique<ThreadPool>(Options.NumThreads);
+
+  auto scheduleLoads = [&](unsigned Limit) {
+    Limit = std::min<unsigned>(Limit, Objects.size());
+    for (; NextObjectToLoad < Limit; ++NextObjectToLoad) {
+      DebugMapObject &DMO = *Objects[NextObjectToLoad];
+      // Swift modules and warning placeholders are handled inline.
+      if (DMO.isSwiftModule() || (DMO.getWarnings().size() && DMO.empty()))
+        continue;
+      auto &Ctx = Contexts[NextObjectToLoad];
+      Ctx.reset(new LinkContext(*this, DMO));
+      LinkContext *CtxPtr = Ctx.get();
+      PreparedContexts[NextObjectToLoad] = Pool->async(
+          [this, CtxPtr, &Map] { prepareLinkContext(*CtxPtr, Map); });
+    }
+  };
+
+  for (unsigned ObjectIdx = 0, E = Objects.size(); ObjectIdx != E;
+       ++ObjectIdx) {
+    DebugMapObject *Obj = Objects[ObjectIdx];
+    CurrentDebugObject = Obj;
 
     if (Options.Verbose)
       outs() << "DEBUG MAP OBJECT: " << Obj->getObjectFilename()
@@ -4766,21 +4898,31 @@ bool DwarfLinker::link(const DebugMap &Map) {
       continue;
     }
 
-    auto ErrOrObj = loadObject(BinHolder, *Obj, Map);
-    if (!ErrOrObj)
+    std::unique_ptr<LinkContext> Ctx;
+    if (Pool) {
+      scheduleLoads(ObjectIdx + Options.NumThreads);
+      PreparedContexts[ObjectIdx].wait();
+      Ctx = std::move(Contexts[ObjectIdx]);
+    } else {
+      Ctx.reset(new LinkContext(*this, *Obj));
+      prepareLinkContext(*Ctx, Map);
+    }
+    for (const auto &Warning : Ctx->Warnings)
+      reportWarning(Warning);
+    Ctx->Warnings.clear();
+    Ctx->RelocMgr.stopDeferringWarnings();
+
+    if (!Ctx->Obj)
       continue;
 
-    // Look for relocations that correspond to debug map entries.
-    RelocationManager RelocMgr(*this);
-    if (!Options.Update &&
-        !RelocMgr.findValidRelocsInDebugInfo(*ErrOrObj, *Obj)) {
+    if (!Ctx->DwarfContext) {
       if (Options.Verbose)
         outs() << "No valid relocations found. Skipping.\n";
       continue;
     }
 
-    // Setup access to the debug info.
-    DWARFContextInMemory DwarfContext(*ErrOrObj);
+    RelocationManager &RelocMgr = Ctx->RelocMgr;
+    DWARFContextInMemory &DwarfContext = *Ctx->DwarfContext;
     startDebugObject(DwarfContext, *Obj);
 
     // In a first phase, just read in the debug info and store the DIE
@@ -4807,7 +4949,7 @@ bool DwarfLinker::link(const DebugMap &Map) {
     if (Options.Update) {
       for (auto &Unit : Units)
         Unit.markEverythingAsKept();
-      Streamer->copyInvariantDebugSection(*ErrOrObj, Options);
+      Streamer->copyInvariantDebugSection(*Ctx->Obj, Options);
     } else {
       for (auto &CurrentUnit : Units)
         lookForDIEsToKeep(RelocMgr,
@@ -4874,6 +5016,12 @@ bool DwarfLinker::link(const DebugMap &Map) {
       Streamer->emitDebugInlined(Inlined);
   }
 
+  if (Options.Verbose && !Options.NoODR)
+    outs() << "ODR uniquing: " << ODRStats.CanonicalDIEs
+           << " canonical type DIEs, " << ODRStats.UniquedReferences
+           << " references to canonical types, "
+           << ODRStats.SkippedDependencies << " duplicate types skipped.\n";
+
   return Options.NoOutput ? true : Streamer->finish(Map, Options.Translator);
 }
 
@@ -28,6 +28,7 @@
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
 #include <list>
 #include <string>
 // FIXME: Remove this and thread permissions through llvm's API.
@@ -98,10 +99,17 @@ static opt<std::string> SymbolMap("symbol-map",
     desc("Updates the existing dsyms inplace using symbol map specified."),
     value_desc("bcsymbolmap"), cat(DsymCategory));
 
-static opt<unsigned> Threads("threads",
+static opt<unsigned> NumThreads("num-threads",
     desc("Specifies the maximum number (n) of simultaneous threads to use\n"
-         "when linking multiple architectures."), init(0), cat(DsymCategory));
-static alias ThreadsA("t", desc("Alias for --threads"), aliasopt(Threads));
+         "when linking. Object files are loaded and parsed concurrently,\n"
+         "the output is identical to a single threaded link. Verbose\n"
+         "links always use a single thread."), init(1), cat(DsymCategory));
+static alias NumThreadsA("j", desc("Alias for --num-threads"),
+                         aliasopt(NumThreads));
+static alias ThreadsA("threads", desc("Alias for --num-threads"),
+                      aliasopt(NumThreads));
+static alias ThreadsB("t", desc("Alias for --num-threads"),
+                      aliasopt(NumThreads));
 
 static opt<bool> Verbose("verbose",
     desc("Display verbose information when linking."), init(false),
@@ -567,6 +575,8 @@ int main(int argc, char **argv) {
   Options.Minimize = Minimize;
   Options.Update = Update;
   Options.PrependPath = OsoPrependPath;
+  // The verbose output is interleaved with the link, keep it readable.
+  Options.NumThreads = Verbose ? 1 : std::max(1U, unsigned(NumThreads));
 
   if (!SymbolMap.empty())
     Options.Update = true;
@@ -679,24 +689,55 @@ int main(int argc, char **argv) {
     // Link each separated architecture into a separated thin file.
     typedef llvm::dsymutil::MachOUtils::ArchAndFilename ArchAndFilename;
     llvm::SmallVector<ArchAndFilename, 4> ThinDwarfList;
-    for (auto &Map : *ErrOrDebugMaps) {
-      if (Verbose)
-        Map->print(llvm::outs());
+    auto &Maps = *ErrOrDebugMaps;
+    // The slices of a fat binary are linked concurrently, sharing the
+    // threads between them. The symbol map is process-wide state, so links
+    // that unobfuscate it are done one slice at a time.
+    if (Options.NumThreads > 1 && Maps.size() > 1 && !ParseOnly &&
+        SymbolMap.empty()) {
+      std::vector<std::string> ThinMachODwarfs(Maps.size());
+      for (unsigned I = 0, E = Maps.size(); I != E; ++I)
+        if (!getOutputDwarfPath(InputFile, ThinMachODwarfs[I], true))
+          exitDsymutil(1);
 
-      if (ParseOnly)
-        continue;
+      LinkOptions SliceOptions = Options;
+      SliceOptions.NumThreads = std::max<unsigned>(
+          1, Options.NumThreads / Maps.size());
+      std::unique_ptr<bool[]> Linked(new bool[Maps.size()]);
+      llvm::ThreadPool Pool(std::min<unsigned>(Options.NumThreads,
+                                               Maps.size()));
+      for (unsigned I = 0, E = Maps.size(); I != E; ++I)
+        Pool.async([&, I] {
+          Linked[I] = linkDwarf(ThinMachODwarfs[I], *Maps[I], SliceOptions);
+        });
+      Pool.wait();
+
+      for (unsigned I = 0, E = Maps.size(); I != E; ++I) {
+        if (!Linked[I])
+          exitDsymutil(1);
+        ThinDwarfList.push_back({ getArchName(Maps[I]->getTriple()),
+                                     ThinMachODwarfs[I] });
+      }
+    } else {
+      for (auto &Map : Maps) {
+        if (Verbose)
+          Map->print(llvm::outs());
 
-      if (!SymbolMap.empty())
-        loadSymbolMap(SymbolMap, Options, InputFile, *Map);
+        if (ParseOnly)
+          continue;
 
-      std::string ThinMachO, ThinMachODwarf;
+        if (!SymbolMap.empty())
+          loadSymbolMap(SymbolMap, Options, InputFile, *Map);
 
-      if (!getOutputDwarfPath(InputFile, ThinMachODwarf, true) ||
-          !linkDwarf(ThinMachODwarf, *Map, Options))
-        exitDsymutil(1);
+        std::string ThinMachO, ThinMachODwarf;
+
+        if (!getOutputDwarfPath(InputFile, ThinMachODwarf, true) ||
+            !linkDwarf(ThinMachODwarf, *Map, Options))
+          exitDsymutil(1);
 
-      ThinDwarfList.push_back({ getArchName(Map->getTriple()),
-                                   ThinMachODwarf });
+        ThinDwarfList.push_back({ getArchName(Map->getTriple()),
+                                     ThinMachODwarf });
+      }
     }
 
     if (NoOutput || ParseOnly || DumpStab)
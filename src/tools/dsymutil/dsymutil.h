@@ -34,7 +34,8 @@ struct LinkOptions {
   bool Update;   ///< Do not link, just recompute accelerator tables
   std::function<StringRef (StringRef)> Translator;
   std::string PrependPath; //< -oso-prepend-path
-  LinkOptions() : Verbose(false), NoOutput(false) {}
+  unsigned NumThreads;     ///< Number of threads used to prepare the objects
+  LinkOptions() : Verbose(false), NoOutput(false), NumThreads(1) {}
 };
 
 /// \brief Extract the DebugMap from the given file.
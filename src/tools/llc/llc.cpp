@@ -15,10 +15,12 @@
 
 
 #include "llvm/ADT/Triple.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/CodeGen/LinkAllAsmWriterComponents.h"
 #include "llvm/CodeGen/LinkAllCodegenComponents.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/IRPrintingPasses.h"
 #include "llvm/IR/LLVMContext.h"
@@ -40,6 +42,7 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetSubtargetInfo.h"
@@ -61,6 +64,32 @@ TimeCompilations("time-compilations", cl::Hidden, cl::init(1u),
                  cl::value_desc("N"),
                  cl::desc("Repeat compilation N times for timing"));
 
+static cl::opt<unsigned>
+Parallelism("j", cl::init(1), cl::value_desc("N"),
+            cl::desc("Split the module into N partitions, and generate code "
+                     "for them on as many threads into <output>.<index>"));
+
+static cl::opt<std::string>
+TimeTraceFile("time-trace-file", cl::value_desc("filename"),
+              cl::desc("Record where the time goes and write it to "
+                       "<filename>"));
+
+static cl::opt<unsigned>
+TimeTraceGranularity("time-trace-granularity", cl::init(500),
+                     cl::value_desc("us"),
+                     cl::desc("Leave the scopes shorter than this many "
+                              "microseconds out of the time trace"));
+
+enum TimeTraceFormatKind { ChromeTrace, FoldedStacks };
+static cl::opt<TimeTraceFormatKind>
+TimeTraceFormat("time-trace-format", cl::init(ChromeTrace),
+                cl::desc("The format of the time trace"),
+                cl::values(clEnumValN(ChromeTrace, "chrome",
+                                      "A Chrome trace (the default)"),
+                           clEnumValN(FoldedStacks, "folded",
+                                      "Folded stacks for flame graphs"),
+                           clEnumValEnd));
+
 static cl::opt<bool>
 NoIntegratedAssembler("no-integrated-as", cl::Hidden,
                       cl::desc("Disable integrated assembler"));
@@ -96,9 +125,25 @@ static cl::opt<bool> AsmVerbose("asm-verbose",
 
 static int compileModule(char **, LLVMContext &);
 
+/// Write the time trace recorded for -time-trace-file and stop recording it.
+static void writeTimeTrace(const char *ProgName) {
+  std::error_code EC;
+  raw_fd_ostream OS(TimeTraceFile, EC, sys::fs::F_Text);
+  if (EC)
+    errs() << ProgName << ": " << TimeTraceFile << ": " << EC.message() << '\n';
+  else if (TimeTraceFormat == FoldedStacks)
+    timeTraceProfilerWriteFolded(OS);
+  else
+    timeTraceProfilerWrite(OS);
+  timeTraceProfilerCleanup();
+}
+static bool compilePartition(Module &M, TargetMachine &Target, raw_ostream &OS,
+                             AnalysisID StartAfterID, AnalysisID StopAfterID,
+                             std::string &ErrMsg);
+
 static std::unique_ptr<tool_output_file>
 GetOutputStream(const char *TargetName, Triple::OSType OS,
-                const char *ProgName) {
+                const char *ProgName, StringRef Suffix = "") {
   // If we don't yet have an output filename, make one.
   if (OutputFilename.empty()) {
     if (InputFilename == "-")
@@ -152,8 +197,8 @@ GetOutputStream(const char *TargetName, Triple::OSType OS,
   sys::fs::OpenFlags OpenFlags = sys::fs::F_None;
   if (!Binary)
     OpenFlags |= sys::fs::F_Text;
-  auto FDOut = llvm::make_unique<tool_output_file>(OutputFilename, EC,
-                                                   OpenFlags);
+  auto FDOut = llvm::make_unique<tool_output_file>(
+      (OutputFilename + Suffix).str(), EC, OpenFlags);
   if (EC) {
     errs() << EC.message() << '\n';
     return nullptr;
@@ -185,6 +230,7 @@ int main(int argc, char **argv) {
   PassRegistry *Registry = PassRegistry::getPassRegistry();
   initializeCore(*Registry);
   initializeCodeGen(*Registry);
+  initializeGlobalISel(*Registry);
   initializeLoopStrengthReducePass(*Registry);
   initializeLowerIntrinsicsPass(*Registry);
   initializeUnreachableBlockElimPass(*Registry);
@@ -194,11 +240,17 @@ int main(int argc, char **argv) {
 
   cl::ParseCommandLineOptions(argc, argv, "llvm system compiler\n");
 
+  if (!TimeTraceFile.empty())
+    timeTraceProfilerInitialize(TimeTraceGranularity, "llc");
+
   // Compile the module TimeCompilations times to give better compile time
   // metrics.
   for (unsigned I = TimeCompilations; I; --I)
     if (int RetVal = compileModule(argv, Context))
       return RetVal;
+
+  if (!TimeTraceFile.empty())
+    writeTimeTrace(argv[0]);
   return 0;
 }
 
@@ -284,21 +336,23 @@ static int compileModule(char **argv, LLVMContext &Context) {
   if (GenerateSoftFloatCalls)
     FloatABIForCalls = FloatABI::Soft;
 
-  // Figure out where we are going to send the output.
-  std::unique_ptr<tool_output_file> Out =
-      GetOutputStream(TheTarget->getName(), TheTriple.getOS(), argv[0]);
-  if (!Out) return 1;
-
-  // Build up all of the passes that we want to do to the module.
-  PassManager PM;
-
-  // Add an appropriate TargetLibraryInfo pass for the module's triple.
-  TargetLibraryInfoImpl TLII(Triple(M->getTargetTriple()));
+  if (Parallelism > 1 && (OutputFilename == "-" ||
+                          (OutputFilename.empty() && InputFilename == "-"))) {
+    errs() << argv[0] << ": -j requires an output file name\n";
+    return 1;
+  }
 
-  // The -disable-simplify-libcalls flag actually disables all builtin optzns.
-  if (DisableSimplifyLibCalls)
-    TLII.disableAllFunctions();
-  PM.add(new TargetLibraryInfoWrapperPass(TLII));
+  // Figure out where we are going to send the output. With -j, each
+  // partition goes to <output>.<index>.
+  std::vector<std::unique_ptr<tool_output_file>> Outs;
+  std::vector<raw_ostream *> OSs;
+  for (unsigned I = 0; I != Parallelism; ++I) {
+    Outs.push_back(GetOutputStream(TheTarget->getName(), TheTriple.getOS(),
+                                   argv[0],
+                                   Parallelism > 1 ? "." + utostr(I) : ""));
+    if (!Outs.back()) return 1;
+    OSs.push_back(&Outs.back()->os());
+  }
 
   // Add the target data from the target machine, if it exists, or the module.
   if (const DataLayout *DL = Target->getDataLayout())
@@ -312,45 +366,80 @@ static int compileModule(char **argv, LLVMContext &Context) {
     errs() << argv[0]
              << ": warning: ignoring -mc-relax-all because filetype != obj";
 
-  {
-    formatted_raw_ostream FOS(Out->os());
-
-    AnalysisID StartAfterID = nullptr;
-    AnalysisID StopAfterID = nullptr;
-    const PassRegistry *PR = PassRegistry::getPassRegistry();
-    if (!StartAfter.empty()) {
-      const PassInfo *PI = PR->getPassInfo(StartAfter);
-      if (!PI) {
-        errs() << argv[0] << ": start-after pass is not registered.\n";
-        return 1;
-      }
-      StartAfterID = PI->getTypeInfo();
-    }
-    if (!StopAfter.empty()) {
-      const PassInfo *PI = PR->getPassInfo(StopAfter);
-      if (!PI) {
-        errs() << argv[0] << ": stop-after pass is not registered.\n";
-        return 1;
-      }
-      StopAfterID = PI->getTypeInfo();
+  AnalysisID StartAfterID = nullptr;
+  AnalysisID StopAfterID = nullptr;
+  const PassRegistry *PR = PassRegistry::getPassRegistry();
+  if (!StartAfter.empty()) {
+    const PassInfo *PI = PR->getPassInfo(StartAfter);
+    if (!PI) {
+      errs() << argv[0] << ": start-after pass is not registered.\n";
+      return 1;
     }
-
-    // Ask the target to add backend passes as necessary.
-    if (Target->addPassesToEmitFile(PM, FOS, FileType, NoVerify,
-                                    StartAfterID, StopAfterID)) {
-      errs() << argv[0] << ": target does not support generation of this"
-             << " file type!\n";
+    StartAfterID = PI->getTypeInfo();
+  }
+  if (!StopAfter.empty()) {
+    const PassInfo *PI = PR->getPassInfo(StopAfter);
+    if (!PI) {
+      errs() << argv[0] << ": stop-after pass is not registered.\n";
       return 1;
     }
+    StopAfterID = PI->getTypeInfo();
+  }
 
-    // Before executing passes, print the final values of the LLVM options.
-    cl::PrintOptionValues();
-
-    PM.run(*M);
+  // Before executing passes, print the final values of the LLVM options.
+  cl::PrintOptionValues();
+
+  // Every partition is compiled with a TargetMachine of its own, since the
+  // threads cannot share one.
+  auto CodeGen = [&](Module &MPart, raw_ostream &OS, std::string &ErrMsg) {
+    std::unique_ptr<TargetMachine> PartTarget;
+    TargetMachine *TM = Target.get();
+    if (&MPart != M.get()) {
+      PartTarget.reset(TheTarget->createTargetMachine(
+          TheTriple.getTriple(), CPUStr, FeaturesStr, Options, RelocModel,
+          CMModel, OLvl));
+      TM = PartTarget.get();
+    }
+    return compilePartition(MPart, *TM, OS, StartAfterID, StopAfterID,
+                            ErrMsg);
+  };
+  std::string ErrMsg;
+  if (!splitCodeGen(*M, OSs, CodeGen, ErrMsg)) {
+    errs() << argv[0] << ": " << ErrMsg << "\n";
+    return 1;
   }
 
   // Declare success.
-  Out->keep();
+  for (auto &Out : Outs)
+    Out->keep();
 
   return 0;
 }
+
+/// Build up the passes that generate code for \p M with \p Target, and run
+/// them.
+static bool compilePartition(Module &M, TargetMachine &Target, raw_ostream &OS,
+                             AnalysisID StartAfterID, AnalysisID StopAfterID,
+                             std::string &ErrMsg) {
+  PassManager PM;
+
+  // Add an appropriate TargetLibraryInfo pass for the module's triple.
+  TargetLibraryInfoImpl TLII(Triple(M.getTargetTriple()));
+
+  // The -disable-simplify-libcalls flag actually disables all builtin optzns.
+  if (DisableSimplifyLibCalls)
+    TLII.disableAllFunctions();
+  PM.add(new TargetLibraryInfoWrapperPass(TLII));
+
+  formatted_raw_ostream FOS(OS);
+
+  // Ask the target to add backend passes as necessary.
+  if (Target.addPassesToEmitFile(PM, FOS, FileType, NoVerify, StartAfterID,
+                                 StopAfterID)) {
+    ErrMsg = "target does not support generation of this file type!";
+    return false;
+  }
+
+  PM.run(M);
+  return true;
+}
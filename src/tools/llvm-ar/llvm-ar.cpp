@@ -12,10 +12,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Object/Archive.h"
+#include "llvm/Object/IRObjectFile.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Errc.h"
@@ -27,11 +29,13 @@
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstdlib>
 #include <memory>
+#include <thread>
 
 #if !defined(_MSC_VER) && !defined(__MINGW32__)
 #include <unistd.h>
@@ -684,27 +688,118 @@ static void writeStringTable(raw_fd_ostream &Out,
   Out.seek(Pos);
 }
 
+namespace {
+// The global symbols defined by an archive member, in symbol table order.
+struct MemberSymbols {
+  bool IsSymbolic = false;
+  std::vector<std::string> Names;
+};
+}
+
+static void computeMemberSymbols(MemoryBufferRef MemberBuffer,
+                                 LLVMContext &Context, MemberSymbols &Syms) {
+  // Bitcode members with a symbol table are listed without parsing them.
+  ErrorOr<std::unique_ptr<object::SymbolicFile>> ObjOrErr =
+      object::IRObjectFile::createFromSymbolTable(MemberBuffer);
+  if (!ObjOrErr)
+    ObjOrErr = object::SymbolicFile::createSymbolicFile(
+        MemberBuffer, sys::fs::file_magic::unknown, &Context);
+  if (!ObjOrErr)
+    return; // FIXME: check only for "not an object file" errors.
+  object::SymbolicFile &Obj = *ObjOrErr.get();
+  Syms.IsSymbolic = true;
+
+  for (const object::BasicSymbolRef &S : Obj.symbols()) {
+    uint32_t Symflags = S.getFlags();
+    if (Symflags & object::SymbolRef::SF_FormatSpecific)
+      continue;
+    if (!(Symflags & object::SymbolRef::SF_Global))
+      continue;
+    if (Symflags & object::SymbolRef::SF_Undefined)
+      continue;
+    std::string Name;
+    raw_string_ostream NameOS(Name);
+    failIfError(S.printName(NameOS));
+    Syms.Names.push_back(NameOS.str());
+  }
+}
+
+// Gathers the symbols of every member. The members copied from OldArchive
+// take their names from its symbol table, so that only the members that are
+// new, or that have no entry in that table, need to be parsed. Those are
+// parsed concurrently when there are enough of them, each task with its own
+// LLVMContext since a context must not be shared across threads.
+static void computeSymbols(object::Archive *OldArchive,
+                           ArrayRef<MemoryBufferRef> Buffers,
+                           std::vector<MemberSymbols> &Symbols) {
+  Symbols.resize(Buffers.size());
+
+  DenseMap<const char *, unsigned> OldMemberNum;
+  if (OldArchive && OldArchive->hasSymbolTable())
+    for (unsigned I = 0, N = Buffers.size(); I != N; ++I)
+      OldMemberNum[Buffers[I].getBufferStart()] = I;
+  if (!OldMemberNum.empty()) {
+    for (object::Archive::symbol_iterator S = OldArchive->symbol_begin(),
+                                          E = OldArchive->symbol_end();
+         S != E; ++S) {
+      ErrorOr<object::Archive::child_iterator> MemberOrErr = S->getMember();
+      if (!MemberOrErr)
+        continue;
+      ErrorOr<MemoryBufferRef> BufferOrErr =
+          MemberOrErr.get()->getMemoryBufferRef();
+      if (!BufferOrErr)
+        continue;
+      auto It = OldMemberNum.find(BufferOrErr->getBufferStart());
+      if (It == OldMemberNum.end())
+        continue;
+      MemberSymbols &Syms = Symbols[It->second];
+      Syms.IsSymbolic = true;
+      Syms.Names.push_back(S->getName());
+    }
+  }
+
+  std::vector<unsigned> ToParse;
+  for (unsigned I = 0, N = Buffers.size(); I != N; ++I)
+    if (!Symbols[I].IsSymbolic)
+      ToParse.push_back(I);
+
+  unsigned Threads = std::thread::hardware_concurrency();
+  if (Threads <= 1 || ToParse.size() < 8) {
+    LLVMContext &Context = getGlobalContext();
+    for (unsigned I : ToParse)
+      computeMemberSymbols(Buffers[I], Context, Symbols[I]);
+    return;
+  }
+
+  unsigned NumTasks = std::min<size_t>(Threads, ToParse.size());
+  ThreadPool Pool(NumTasks);
+  for (unsigned Task = 0; Task != NumTasks; ++Task)
+    Pool.async([&, Task] {
+      LLVMContext Context;
+      for (unsigned J = Task, E = ToParse.size(); J < E; J += NumTasks)
+        computeMemberSymbols(Buffers[ToParse[J]], Context,
+                             Symbols[ToParse[J]]);
+    });
+  Pool.wait();
+}
+
 // Returns the offset of the first reference to a member offset.
 static unsigned writeSymbolTable(raw_fd_ostream &Out,
-                                 ArrayRef<NewArchiveIterator> Members,
+                                 object::Archive *OldArchive,
                                  ArrayRef<MemoryBufferRef> Buffers,
                                  std::vector<unsigned> &MemberOffsetRefs) {
+  std::vector<MemberSymbols> Symbols;
+  computeSymbols(OldArchive, Buffers, Symbols);
+
   unsigned StartOffset = 0;
-  unsigned MemberNum = 0;
   std::string NameBuf;
   raw_string_ostream NameOS(NameBuf);
   unsigned NumSyms = 0;
-  LLVMContext &Context = getGlobalContext();
-  for (ArrayRef<NewArchiveIterator>::iterator I = Members.begin(),
-                                              E = Members.end();
-       I != E; ++I, ++MemberNum) {
-    MemoryBufferRef MemberBuffer = Buffers[MemberNum];
-    ErrorOr<std::unique_ptr<object::SymbolicFile>> ObjOrErr =
-        object::SymbolicFile::createSymbolicFile(
-            MemberBuffer, sys::fs::file_magic::unknown, &Context);
-    if (!ObjOrErr)
-      continue;  // FIXME: check only for "not an object file" errors.
-    object::SymbolicFile &Obj = *ObjOrErr.get();
+  for (unsigned MemberNum = 0, N = Buffers.size(); MemberNum != N;
+       ++MemberNum) {
+    const MemberSymbols &Syms = Symbols[MemberNum];
+    if (!Syms.IsSymbolic)
+      continue;
 
     if (!StartOffset) {
       printMemberHeader(Out, "", sys::TimeValue::now(), 0, 0, 0, 0);
@@ -712,16 +807,8 @@ static unsigned writeSymbolTable(raw_fd_ostream &Out,
       print32BE(Out, 0);
     }
 
-    for (const object::BasicSymbolRef &S : Obj.symbols()) {
-      uint32_t Symflags = S.getFlags();
-      if (Symflags & object::SymbolRef::SF_FormatSpecific)
-        continue;
-      if (!(Symflags & object::SymbolRef::SF_Global))
-        continue;
-      if (Symflags & object::SymbolRef::SF_Undefined)
-        continue;
-      failIfError(S.printName(NameOS));
-      NameOS << '\0';
+    for (const std::string &Name : Syms.Names) {
+      NameOS << Name << '\0';
       ++NumSyms;
       MemberOffsetRefs.push_back(MemberNum);
       print32BE(Out, 0);
@@ -791,7 +878,7 @@ performWriteOperation(ArchiveOperation Operation, object::Archive *OldArchive,
   unsigned MemberReferenceOffset = 0;
   if (Symtab) {
     MemberReferenceOffset =
-        writeSymbolTable(Out, NewMembers, Members, MemberOffsetRefs);
+        writeSymbolTable(Out, OldArchive, Members, MemberOffsetRefs);
   }
 
   std::vector<unsigned> StringMapIndexes;
@@ -110,6 +110,7 @@ static const char *GetBlockName(unsigned BlockID,
   case bitc::METADATA_BLOCK_ID:        return "METADATA_BLOCK";
   case bitc::METADATA_ATTACHMENT_ID:   return "METADATA_ATTACHMENT_BLOCK";
   case bitc::USELIST_BLOCK_ID:         return "USELIST_BLOCK_ID";
+  case bitc::SYMTAB_BLOCK_ID:          return "SYMTAB_BLOCK";
   }
 }
 
@@ -161,6 +162,8 @@ static const char *GetCodeName(unsigned CodeID, unsigned BlockID,
       STRINGIFY_CODE(MODULE_CODE, ALIAS)
       STRINGIFY_CODE(MODULE_CODE, PURGEVALS)
       STRINGIFY_CODE(MODULE_CODE, GCNAME)
+      STRINGIFY_CODE(MODULE_CODE, FUNCTION_INDEX)
+      STRINGIFY_CODE(MODULE_CODE, STRTAB)
     }
   case bitc::PARAMATTR_BLOCK_ID:
     switch (CodeID) {
@@ -255,6 +258,8 @@ static const char *GetCodeName(unsigned CodeID, unsigned BlockID,
     default: return nullptr;
     STRINGIFY_CODE(VST_CODE, ENTRY)
     STRINGIFY_CODE(VST_CODE, BBENTRY)
+    STRINGIFY_CODE(VST_CODE, STRTAB_ENTRY)
+    STRINGIFY_CODE(VST_CODE, STRTAB_BBENTRY)
     }
   case bitc::METADATA_ATTACHMENT_ID:
     switch(CodeID) {
@@ -295,6 +300,7 @@ static const char *GetCodeName(unsigned CodeID, unsigned BlockID,
       STRINGIFY_CODE(METADATA, OBJC_PROPERTY)
       STRINGIFY_CODE(METADATA, IMPORTED_ENTITY)
       STRINGIFY_CODE(METADATA, MODULE)
+      STRINGIFY_CODE(METADATA, STRINGS)
     }
   case bitc::USELIST_BLOCK_ID:
     switch(CodeID) {
@@ -302,6 +308,11 @@ static const char *GetCodeName(unsigned CodeID, unsigned BlockID,
     case bitc::USELIST_CODE_DEFAULT: return "USELIST_CODE_DEFAULT";
     case bitc::USELIST_CODE_BB:      return "USELIST_CODE_BB";
     }
+  case bitc::SYMTAB_BLOCK_ID:
+    switch(CodeID) {
+    default:return nullptr;
+    case bitc::SYMTAB_CODE_SYMBOL: return "SYMBOL";
+    }
   }
 #undef STRINGIFY_CODE
 }
@@ -31,7 +31,10 @@
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
+#include <deque>
 #include <functional>
+#include <mutex>
 #include <system_error>
 
 using namespace llvm;
@@ -51,9 +54,16 @@ public:
   /// \brief Print the error message to the error output stream.
   void error(const Twine &Message, StringRef Whence = "");
 
-  /// \brief Return a memory buffer for the given source file.
+  /// \brief Return a memory buffer for the given source file. This can be
+  /// called concurrently from the rendering threads.
   ErrorOr<const MemoryBuffer &> getSourceFile(StringRef SourceFile);
 
+  /// \brief Call \p Render on the indices of \p NumItems items, on up to
+  /// ViewOpts.NumThreads threads, and print the outputs to \p OS in the order
+  /// of the indices.
+  void renderInOrder(raw_ostream &OS, size_t NumItems,
+                     std::function<void(size_t, raw_ostream &)> Render);
+
   /// \brief Create source views for the expansions of the view.
   void attachExpansionSubViews(SourceCoverageView &View,
                                ArrayRef<ExpansionRecord> Expansions,
@@ -87,6 +97,7 @@ public:
   std::vector<std::string> SourceFiles;
   std::vector<std::pair<std::string, std::unique_ptr<MemoryBuffer>>>
       LoadedSourceFiles;
+  std::mutex LoadedSourceFilesLock;
   bool CompareFilenamesOnly;
   StringMap<std::string> RemappedFilenames;
   std::string CoverageArch;
@@ -108,6 +119,7 @@ CodeCoverageTool::getSourceFile(StringRef SourceFile) {
     if (Loc != RemappedFilenames.end())
       SourceFile = Loc->second;
   }
+  std::lock_guard<std::mutex> Guard(LoadedSourceFilesLock);
   for (const auto &Files : LoadedSourceFiles)
     if (sys::fs::equivalent(SourceFile, Files.first))
       return *Files.second;
@@ -121,6 +133,43 @@ CodeCoverageTool::getSourceFile(StringRef SourceFile) {
   return *LoadedSourceFiles.back().second;
 }
 
+void CodeCoverageTool::renderInOrder(
+    raw_ostream &OS, size_t NumItems,
+    std::function<void(size_t, raw_ostream &)> Render) {
+  unsigned NumThreads = std::min<size_t>(ViewOpts.NumThreads, NumItems);
+  if (NumThreads <= 1) {
+    for (size_t I = 0; I < NumItems; ++I)
+      Render(I, OS);
+    return;
+  }
+
+  // Render into buffers on the pool, and print the buffers as they come in
+  // order. Limit how far ahead the rendering goes to bound the memory used by
+  // the buffers waiting to be printed.
+  ThreadPool Pool(NumThreads);
+  std::deque<std::future<std::string>> Pending;
+  size_t Next = 0;
+  auto ScheduleRenders = [&] {
+    while (Next < NumItems && Pending.size() < 2 * NumThreads) {
+      size_t I = Next++;
+      Pending.push_back(Pool.async([I, &Render] {
+        std::string Buffer;
+        ColoredStringOstream BufferOS(Buffer);
+        Render(I, BufferOS);
+        BufferOS.flush();
+        return Buffer;
+      }));
+    }
+  };
+
+  ScheduleRenders();
+  while (!Pending.empty()) {
+    OS << Pending.front().get();
+    Pending.pop_front();
+    ScheduleRenders();
+  }
+}
+
 void
 CodeCoverageTool::attachExpansionSubViews(SourceCoverageView &View,
                                           ArrayRef<ExpansionRecord> Expansions,
@@ -209,8 +258,22 @@ static bool modifiedTimeGT(StringRef LHS, StringRef RHS) {
 std::unique_ptr<CoverageMapping> CodeCoverageTool::load() {
   if (modifiedTimeGT(ObjectFilename, PGOFilename))
     errs() << "warning: profile data may be out of date - object is newer\n";
+  // When only some source files were requested, avoid decoding the mapping
+  // regions of the functions that can't contribute to them. Function filters
+  // select functions regardless of the requested files, so keep everything
+  // in that case.
+  std::function<bool(StringRef)> IsFileWanted;
+  if (!SourceFiles.empty() && Filters.empty())
+    IsFileWanted = [this](StringRef Filename) {
+      for (const auto &SF : SourceFiles)
+        if (CompareFilenamesOnly
+                ? sys::path::filename(SF) == sys::path::filename(Filename)
+                : SF == Filename)
+          return true;
+      return false;
+    };
   auto CoverageOrErr = CoverageMapping::load(ObjectFilename, PGOFilename,
-                                             CoverageArch);
+                                             CoverageArch, IsFileWanted);
   if (std::error_code EC = CoverageOrErr.getError()) {
     colored_ostream(errs(), raw_ostream::RED)
         << "error: Failed to load coverage: " << EC.message();
@@ -311,6 +374,13 @@ int CodeCoverageTool::run(Command Cmd, int argc, const char **argv) {
       "use-color", cl::desc("Emit colored output (default=autodetect)"),
       cl::init(cl::BOU_UNSET));
 
+  cl::opt<unsigned> NumThreads(
+      "num-threads", cl::init(0),
+      cl::desc("Number of threads to use to build the coverage views and "
+               "summaries (default: autodetect)"));
+  cl::alias NumThreadsA("j", cl::desc("Alias for --num-threads"),
+                        cl::aliasopt(NumThreads));
+
   auto commandLineParser = [&, this](int argc, const char **argv) -> int {
     cl::ParseCommandLineOptions(argc, argv, "LLVM code coverage tool\n");
     ViewOpts.Debug = DebugDump;
@@ -320,6 +390,14 @@ int CodeCoverageTool::run(Command Cmd, int argc, const char **argv) {
                           ? sys::Process::StandardOutHasColors()
                           : UseColor == cl::BOU_TRUE;
 
+    ViewOpts.NumThreads = NumThreads;
+    if (!ViewOpts.NumThreads)
+      ViewOpts.NumThreads = std::max(1U, std::thread::hardware_concurrency());
+    // The debug dump goes straight to errs(), and colors that can't be
+    // buffered need the output to be written by a single thread.
+    if (ViewOpts.Debug || (ViewOpts.Colors && sys::Process::ColorNeedsFlush()))
+      ViewOpts.NumThreads = 1;
+
     // Create the function filters
     if (!NameFilters.empty() || !NameRegexFilters.empty()) {
       auto NameFilterer = new CoverageFilters;
@@ -425,23 +503,25 @@ int CodeCoverageTool::show(int argc, const char **argv,
 
   if (!Filters.empty()) {
     // Show functions
-    for (const auto &Function : Coverage->getCoveredFunctions()) {
-      if (!Filters.matches(Function))
-        continue;
+    std::vector<const FunctionRecord *> Functions;
+    for (const auto &Function : Coverage->getCoveredFunctions())
+      if (Filters.matches(Function))
+        Functions.push_back(&Function);
 
+    renderInOrder(outs(), Functions.size(), [&](size_t I, raw_ostream &OS) {
+      const FunctionRecord &Function = *Functions[I];
       auto mainView = createFunctionView(Function, *Coverage);
       if (!mainView) {
-        ViewOpts.colored_ostream(outs(), raw_ostream::RED)
+        ViewOpts.colored_ostream(OS, raw_ostream::RED)
             << "warning: Could not read coverage for '" << Function.Name;
-        outs() << "\n";
-        continue;
+        OS << "\n";
+        return;
       }
-      ViewOpts.colored_ostream(outs(), raw_ostream::CYAN) << Function.Name
-                                                          << ":";
-      outs() << "\n";
-      mainView->render(outs(), /*WholeFile=*/false);
-      outs() << "\n";
-    }
+      ViewOpts.colored_ostream(OS, raw_ostream::CYAN) << Function.Name << ":";
+      OS << "\n";
+      mainView->render(OS, /*WholeFile=*/false);
+      OS << "\n";
+    });
     return 0;
   }
 
@@ -453,23 +533,24 @@ int CodeCoverageTool::show(int argc, const char **argv,
     for (StringRef Filename : Coverage->getUniqueSourceFiles())
       SourceFiles.push_back(Filename);
 
-  for (const auto &SourceFile : SourceFiles) {
+  renderInOrder(outs(), SourceFiles.size(), [&](size_t I, raw_ostream &OS) {
+    const auto &SourceFile = SourceFiles[I];
     auto mainView = createSourceFileView(SourceFile, *Coverage);
     if (!mainView) {
-      ViewOpts.colored_ostream(outs(), raw_ostream::RED)
+      ViewOpts.colored_ostream(OS, raw_ostream::RED)
           << "warning: The file '" << SourceFile << "' isn't covered.";
-      outs() << "\n";
-      continue;
+      OS << "\n";
+      return;
     }
 
     if (ShowFilenames) {
-      ViewOpts.colored_ostream(outs(), raw_ostream::CYAN) << SourceFile << ":";
-      outs() << "\n";
+      ViewOpts.colored_ostream(OS, raw_ostream::CYAN) << SourceFile << ":";
+      OS << "\n";
     }
-    mainView->render(outs(), /*Wholefile=*/true);
+    mainView->render(OS, /*Wholefile=*/true);
     if (SourceFiles.size() > 1)
-      outs() << "\n";
-  }
+      OS << "\n";
+  });
 
   return 0;
 }
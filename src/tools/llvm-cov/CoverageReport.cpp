@@ -15,6 +15,7 @@
 #include "RenderingSupport.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/ThreadPool.h"
 
 using namespace llvm;
 namespace {
@@ -155,6 +156,33 @@ void CoverageReport::render(const FunctionCoverageSummary &Function,
   OS << "\n";
 }
 
+std::vector<FunctionCoverageSummary>
+CoverageReport::getFunctionSummaries(StringRef Filename) {
+  std::vector<const coverage::FunctionRecord *> Functions;
+  for (const auto &F : Coverage->getCoveredFunctions(Filename))
+    Functions.push_back(&F);
+
+  std::vector<FunctionCoverageSummary> Summaries(Functions.size(),
+                                                 FunctionCoverageSummary(""));
+  // Each thread summarizes a contiguous range of the functions.
+  unsigned NumThreads = std::min<size_t>(Options.NumThreads, Functions.size());
+  if (NumThreads <= 1) {
+    for (size_t I = 0, E = Functions.size(); I != E; ++I)
+      Summaries[I] = FunctionCoverageSummary::get(*Functions[I]);
+    return Summaries;
+  }
+  ThreadPool Pool(NumThreads);
+  for (unsigned T = 0; T < NumThreads; ++T)
+    Pool.async([&, T] {
+      for (size_t I = Functions.size() * T / NumThreads,
+                  E = Functions.size() * (T + 1) / NumThreads;
+           I != E; ++I)
+        Summaries[I] = FunctionCoverageSummary::get(*Functions[I]);
+    });
+  Pool.wait();
+  return Summaries;
+}
+
 void CoverageReport::renderFunctionReports(ArrayRef<std::string> Files,
                                            raw_ostream &OS) {
   bool isFirst = true;
@@ -175,8 +203,7 @@ void CoverageReport::renderFunctionReports(ArrayRef<std::string> Files,
     renderDivider(FunctionReportColumns, OS);
     OS << "\n";
     FunctionCoverageSummary Totals("TOTAL");
-    for (const auto &F : Coverage->getCoveredFunctions(Filename)) {
-      FunctionCoverageSummary Function = FunctionCoverageSummary::get(F);
+    for (const auto &Function : getFunctionSummaries(Filename)) {
       ++Totals.ExecutionCount;
       Totals.RegionCoverage += Function.RegionCoverage;
       Totals.LineCoverage += Function.LineCoverage;
@@ -200,14 +227,28 @@ void CoverageReport::renderFileReports(raw_ostream &OS) {
      << "\n";
   renderDivider(FileReportColumns, OS);
   OS << "\n";
+  std::vector<StringRef> Filenames = Coverage->getUniqueSourceFiles();
+  std::vector<FileCoverageSummary> Summaries(Filenames.begin(),
+                                             Filenames.end());
+  auto Summarize = [this](FileCoverageSummary &Summary) {
+    for (const auto &F : Coverage->getCoveredFunctions(Summary.Name))
+      Summary.addFunction(FunctionCoverageSummary::get(F));
+  };
+  // The files are independent from each other, summarize them in parallel.
+  unsigned NumThreads = std::min<size_t>(Options.NumThreads, Summaries.size());
+  if (NumThreads <= 1) {
+    for (auto &Summary : Summaries)
+      Summarize(Summary);
+  } else {
+    ThreadPool Pool(NumThreads);
+    for (auto &Summary : Summaries)
+      Pool.async([&Summarize, &Summary] { Summarize(Summary); });
+    Pool.wait();
+  }
+
   FileCoverageSummary Totals("TOTAL");
-  for (StringRef Filename : Coverage->getUniqueSourceFiles()) {
-    FileCoverageSummary Summary(Filename);
-    for (const auto &F : Coverage->getCoveredFunctions(Filename)) {
-      FunctionCoverageSummary Function = FunctionCoverageSummary::get(F);
-      Summary.addFunction(Function);
-      Totals.addFunction(Function);
-    }
+  for (const auto &Summary : Summaries) {
+    Totals.addFile(Summary);
     render(Summary, OS);
   }
   renderDivider(FileReportColumns, OS);
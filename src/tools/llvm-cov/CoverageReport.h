@@ -27,6 +27,9 @@ class CoverageReport {
   void render(const FileCoverageSummary &File, raw_ostream &OS);
   void render(const FunctionCoverageSummary &Function, raw_ostream &OS);
 
+  /// \brief Summarize the functions of the given file, in order.
+  std::vector<FunctionCoverageSummary> getFunctionSummaries(StringRef Filename);
+
 public:
   CoverageReport(const CoverageViewOptions &Options,
                  std::unique_ptr<coverage::CoverageMapping> Coverage)
@@ -100,6 +100,12 @@ struct FunctionCoverageInfo {
   FunctionCoverageInfo(size_t Executed, size_t NumFunctions)
       : Executed(Executed), NumFunctions(NumFunctions) {}
 
+  FunctionCoverageInfo &operator+=(const FunctionCoverageInfo &RHS) {
+    Executed += RHS.Executed;
+    NumFunctions += RHS.NumFunctions;
+    return *this;
+  }
+
   void addFunction(bool Covered) {
     if (Covered)
       ++Executed;
@@ -149,6 +155,12 @@ struct FileCoverageSummary {
     LineCoverage += Function.LineCoverage;
     FunctionCoverage.addFunction(/*Covered=*/Function.ExecutionCount > 0);
   }
+
+  void addFile(const FileCoverageSummary &File) {
+    RegionCoverage += File.RegionCoverage;
+    LineCoverage += File.LineCoverage;
+    FunctionCoverage += File.FunctionCoverage;
+  }
 };
 
 } // namespace llvm
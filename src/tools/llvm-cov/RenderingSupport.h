@@ -10,7 +10,9 @@
 #ifndef LLVM_COV_RENDERINGSUPPORT_H
 #define LLVM_COV_RENDERINGSUPPORT_H
 
+#include "llvm/Support/Process.h"
 #include "llvm/Support/raw_ostream.h"
+#include <string>
 #include <utility>
 
 namespace llvm {
@@ -45,6 +47,39 @@ inline raw_ostream &operator<<(const ColoredRawOstream &OS, T &&Value) {
   return OS.OS << std::forward<T>(Value);
 }
 
+/// \brief A string stream that records the color changes as the terminal's
+/// escape sequences, so that a view rendered into a buffer keeps its colors
+/// when the buffer is printed. This only works when the terminal takes the
+/// colors in band, see sys::Process::ColorNeedsFlush().
+class ColoredStringOstream : public raw_string_ostream {
+  void writeCode(const char *Code) {
+    if (Code)
+      *this << Code;
+  }
+
+public:
+  explicit ColoredStringOstream(std::string &Str) : raw_string_ostream(Str) {}
+
+  raw_ostream &changeColor(enum Colors Color, bool Bold = false,
+                           bool BG = false) override {
+    writeCode(Color == SAVEDCOLOR ? sys::Process::OutputBold(BG)
+                                  : sys::Process::OutputColor(Color, Bold, BG));
+    return *this;
+  }
+
+  raw_ostream &resetColor() override {
+    writeCode(sys::Process::ResetColor());
+    return *this;
+  }
+
+  raw_ostream &reverseColor() override {
+    writeCode(sys::Process::OutputReverse());
+    return *this;
+  }
+
+  bool has_colors() const override { return true; }
+};
+
 /// \brief Change the color of the output stream if the `IsColorUsed` flag
 /// is true. Returns an object that resets the color when destroyed.
 inline ColoredRawOstream colored_ostream(raw_ostream &OS,
@@ -2,6 +2,8 @@
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/Options.h"
+#include "llvm/Support/ThreadPool.h"
+#include <thread>
 
 
 using namespace llvm;
@@ -12,6 +14,9 @@ using namespace llvm::cl;
 
 static opt<std::string> File1(Positional, desc("<bin1>"));
 static opt<std::string> File2(Positional, desc("<bin2>"));
+static opt<unsigned> NumThreads("j", desc("Number of threads comparing "
+                                          "units, 0 for one per core"),
+                                init(1));
 
 }
 
@@ -47,17 +52,19 @@ bool compareAbbrevDeclarations(const DWARFAbbreviationDeclaration *A1,
   return Identical;
 }
 
-static void dumpDIEAndParents(const DWARFDebugInfoEntryMinimal *DIE,
+static void dumpDIEAndParents(raw_ostream &OS,
+                              const DWARFDebugInfoEntryMinimal *DIE,
                               DWARFUnit *Unit,
                               std::vector<const DWARFDebugInfoEntryMinimal *>& Parents) {
   unsigned incr = 0;
   for (const auto *Parent : Parents)
-    Parent->dump(errs(), Unit, 0, incr++ * 4);
-  errs() << " \\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/";
-  DIE->dump(errs(), Unit, 0, incr * 4);
+    Parent->dump(OS, Unit, 0, incr++ * 4);
+  OS << " \\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/";
+  DIE->dump(OS, Unit, 0, incr * 4);
 }
 
-bool compareDIEs(const DWARFDebugInfoEntryMinimal *DIE1,
+bool compareDIEs(raw_ostream &OS,
+                 const DWARFDebugInfoEntryMinimal *DIE1,
                  const DWARFDebugInfoEntryMinimal *DIE2,
                  const std::vector<bool>& AbbrevsIdentical,
                  DWARFUnit *Unit1,
@@ -72,14 +79,14 @@ bool compareDIEs(const DWARFDebugInfoEntryMinimal *DIE1,
     return true;
 
   if (IsDIE1Null || IsDIE2Null) {
-    errs() << "DIE STRUCTURE MISMATCH\n========================================\n";
-    errs() << "Not same number of children\n";
+    OS << "DIE STRUCTURE MISMATCH\n========================================\n";
+    OS << "Not same number of children\n";
     if (IsDIE2Null) {
-      errs() << "Not in " << File2 << "\n";
-      dumpDIEAndParents(DIE1, Unit1, Parents1);
+      OS << "Not in " << File2 << "\n";
+      dumpDIEAndParents(OS, DIE1, Unit1, Parents1);
     } else {
-      errs() << "Not in " << File1 << "\n";
-      dumpDIEAndParents(DIE2, Unit2, Parents2);
+      OS << "Not in " << File1 << "\n";
+      dumpDIEAndParents(OS, DIE2, Unit2, Parents2);
     }
     return false;
   }
@@ -92,12 +99,12 @@ bool compareDIEs(const DWARFDebugInfoEntryMinimal *DIE1,
 
   if (NeedsAttrCompare)
     if (!compareAbbrevDeclarations(Attr1, Attr2)) {
-      errs() << "DIE STRUCTURE MISMATCH\n========================================\n";
-      errs() << "In " << File1 << '\n';
-      dumpDIEAndParents(DIE1, Unit1, Parents1);
-      errs() << "========================================\nIn " << File2 << '\n';
-      dumpDIEAndParents(DIE2, Unit2, Parents2);
-      errs() << "========================================\n";
+      OS << "DIE STRUCTURE MISMATCH\n========================================\n";
+      OS << "In " << File1 << '\n';
+      dumpDIEAndParents(OS, DIE1, Unit1, Parents1);
+      OS << "========================================\nIn " << File2 << '\n';
+      dumpDIEAndParents(OS, DIE2, Unit2, Parents2);
+      OS << "========================================\n";
       return false;
     }
 
@@ -107,21 +114,21 @@ bool compareDIEs(const DWARFDebugInfoEntryMinimal *DIE1,
     *Child2 = DIE2->getFirstChild();
   for (;Child1 && Child2;
        Child1 = Child1->getSibling(), Child2 = Child2->getSibling()) {
-    if (!compareDIEs(Child1, Child2, AbbrevsIdentical, Unit1, Unit2, Parents1, Parents2))
+    if (!compareDIEs(OS, Child1, Child2, AbbrevsIdentical, Unit1, Unit2, Parents1, Parents2))
       return false;
   }
   Parents1.pop_back();
   Parents2.pop_back();
   
   if (Child1 != Child2) {
-    errs() << "DIE STRUCTURE MISMATCH\n========================================\n";
-    errs() << "Not same number of children\n";
+    OS << "DIE STRUCTURE MISMATCH\n========================================\n";
+    OS << "Not same number of children\n";
     if (Child1) {
-      errs() << "Not in " << File2 << "\n";
-      dumpDIEAndParents(DIE1, Unit1, Parents1);
+      OS << "Not in " << File2 << "\n";
+      dumpDIEAndParents(OS, DIE1, Unit1, Parents1);
     } else {
-      errs() << "Not in " << File1 << "\n";
-      dumpDIEAndParents(DIE2, Unit2, Parents2);
+      OS << "Not in " << File1 << "\n";
+      dumpDIEAndParents(OS, DIE2, Unit2, Parents2);
     }
     return false;
   }
@@ -129,6 +136,39 @@ bool compareDIEs(const DWARFDebugInfoEntryMinimal *DIE1,
   return true;
 }
 
+// Compare the DIE trees of a pair of units, printing the first difference to
+// OS. This only touches the two units, so pairs are compared concurrently.
+// The DIEs are dropped once compared to bound the memory used.
+static bool compareUnits(raw_ostream &OS, DWARFCompileUnit &CU1,
+                         DWARFCompileUnit &CU2, StringRef Info1,
+                         StringRef Info2,
+                         const std::vector<bool> &AbbrevsIdentical,
+                         bool AllAbbrevsIdentical) {
+  // Identical bytes using identical abbreviations describe identical DIEs, so
+  // unchanged units are matched without parsing them.
+  if (AllAbbrevsIdentical &&
+      Info1.slice(CU1.getOffset(), CU1.getNextUnitOffset()) ==
+          Info2.slice(CU2.getOffset(), CU2.getNextUnitOffset()))
+    return true;
+
+  std::vector<const DWARFDebugInfoEntryMinimal *> Parents1, Parents2;
+  const auto *DIE1 = CU1.getCompileUnitDIE(false);
+  const auto *DIE2 = CU2.getCompileUnitDIE(false);
+  if (!compareDIEs(OS, DIE1, DIE2, AbbrevsIdentical, &CU1, &CU2, Parents1, Parents2)){
+    OS << "=============================================================\n";
+    OS << "In " << File1 << " in CU:\n";
+    DIE1->dump(OS, &CU1, -1U, 0);
+    OS << "=============================================================\n";
+    OS << "In " << File2 << " in CU:\n";
+    DIE2->dump(OS, &CU2, -1U, 0);
+    return false;
+  }
+
+  CU1.clearDIEs(true);
+  CU2.clearDIEs(true);
+  return true;
+}
+
 static StringRef getSectionData(StringRef SecName, const object::ObjectFile &Obj) {
   for (const auto &Section : Obj.sections()) {
     StringRef name;
@@ -247,31 +287,64 @@ int main(int argc, char *argv[]) {
       errs() << "Abbrev " << idx << " differs\n";
   }
 
+  bool AllAbbrevsIdentical =
+      std::find(AbbrevsIdentical.begin() + 1, AbbrevsIdentical.end(), false) ==
+          AbbrevsIdentical.end() &&
+      !AbbrevSet2->getAbbreviationDeclaration(AbbrevsIdentical.size());
+  StringRef Info1 = Dwarf1.getInfoSection().Data;
+  StringRef Info2 = Dwarf2.getInfoSection().Data;
+
+  std::vector<std::pair<DWARFCompileUnit *, DWARFCompileUnit *>> Units;
   auto CU2It = Dwarf2.compile_units().begin();
   const auto CU2End = Dwarf2.compile_units().end();
-
-  std::vector<const DWARFDebugInfoEntryMinimal *> Parents1, Parents2;
-  for (const auto &CU1 : Dwarf1.compile_units()) {
-    const auto *DIE1 = CU1->getCompileUnitDIE(false);
-    if (CU2It == CU2End) {
-      errs() << "Not the same number of units! Not in " << File2 << '\n';
-      DIE1->dump(errs(), CU1.get(), 0, 0);
-      return 1;
+  auto CU1It = Dwarf1.compile_units().begin();
+  const auto CU1End = Dwarf1.compile_units().end();
+  for (; CU1It != CU1End && CU2It != CU2End; ++CU1It, ++CU2It)
+    Units.push_back(std::make_pair(CU1It->get(), CU2It->get()));
+
+  unsigned Threads = NumThreads ? NumThreads.getValue()
+                                : std::thread::hardware_concurrency();
+  if (Threads <= 1) {
+    for (const auto &Pair : Units)
+      if (!compareUnits(errs(), *Pair.first, *Pair.second, Info1, Info2,
+                        AbbrevsIdentical, AllAbbrevsIdentical))
+        return 1;
+  } else {
+    // Dumping a DIE may read the line table of its unit, which is cached in
+    // the context, so parse them all before starting the threads.
+    for (const auto &Pair : Units) {
+      Dwarf1.getLineTableForUnit(Pair.first);
+      Dwarf2.getLineTableForUnit(Pair.second);
     }
-    const auto *DIE2 = (*CU2It)->getCompileUnitDIE(false);
-    
-    if (!compareDIEs(DIE1, DIE2, AbbrevsIdentical, CU1.get(), (*CU2It).get(), Parents1, Parents2)){
-      errs() << "=============================================================\n";
-      errs() << "In " << File1 << " in CU:\n";
-      DIE1->dump(errs(), CU1.get(), -1U, 0);
-      errs() << "=============================================================\n";
-      errs() << "In " << File2 << " in CU:\n";
-      DIE2->dump(errs(), (*CU2It).get(), -1U, 0);
-      return 1;
+
+    // Compare a few pairs per thread at a time, keeping the output of each
+    // pair, and print the first difference in unit order.
+    ThreadPool Pool(Threads);
+    const size_t BatchSize = Threads * 4;
+    std::vector<std::string> Output(BatchSize);
+    std::unique_ptr<bool[]> Identical(new bool[BatchSize]);
+    for (size_t Begin = 0; Begin < Units.size(); Begin += BatchSize) {
+      size_t N = std::min(BatchSize, Units.size() - Begin);
+      for (size_t I = 0; I != N; ++I)
+        Pool.async([&, I] {
+          raw_string_ostream OS(Output[I]);
+          Identical[I] = compareUnits(OS, *Units[Begin + I].first,
+                                      *Units[Begin + I].second, Info1, Info2,
+                                      AbbrevsIdentical, AllAbbrevsIdentical);
+        });
+      Pool.wait();
+      for (size_t I = 0; I != N; ++I)
+        if (!Identical[I]) {
+          errs() << Output[I];
+          return 1;
+        }
     }
+  }
 
-    // assert(Parents1.empty() && Parents2.empty());
-    CU2It++;
+  if (CU1It != CU1End) {
+      errs() << "Not the same number of units! Not in " << File2 << '\n';
+      (*CU1It)->getCompileUnitDIE()->dump(errs(), CU1It->get(), 0, 0);
+      return 1;
   }
 
   if (CU2It != CU2End) {
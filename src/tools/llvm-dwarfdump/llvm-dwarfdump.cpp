@@ -14,6 +14,8 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/DebugInfo/DWARF/DIContext.h"
+#include "llvm/DebugInfo/DWARF/DWARFAcceleratorTable.h"
+#include "llvm/DebugInfo/DWARF/DWARFContext.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Object/RelocVisitor.h"
 #include "llvm/Support/CommandLine.h"
@@ -69,6 +71,59 @@ DumpType("debug-dump", cl::init(DIDT_All),
         clEnumValN(DIDT_StrOffsetsDwo, "str_offsets.dwo", ".debug_str_offsets.dwo"),
         clEnumValEnd));
 
+static cl::opt<std::string>
+LookupAddress("lookup", cl::value_desc("address"),
+              cl::desc("Print the source location of an address, including "
+                       "inlined frames, instead of dumping the sections"));
+
+static cl::list<std::string>
+LookupNames("name", cl::value_desc("name"), cl::ZeroOrMore,
+            cl::desc("Print the DIEs found for a name in the accelerator "
+                     "tables instead of dumping the sections"));
+
+static void lookupAddress(DIContext &DICtx, uint64_t Address) {
+  DILineInfoSpecifier Spec(
+      DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath,
+      DILineInfoSpecifier::FunctionNameKind::LinkageName);
+  DIInliningInfo Info = DICtx.getInliningInfoForAddress(Address, Spec);
+  outs() << format("0x%08" PRIx64, Address) << ":\n";
+  if (!Info.getNumberOfFrames())
+    outs() << "  no debug info\n";
+  for (uint32_t I = 0, E = Info.getNumberOfFrames(); I != E; ++I) {
+    DILineInfo Frame = Info.getFrame(I);
+    outs() << "  " << Frame.FunctionName << " at " << Frame.FileName << ':'
+           << Frame.Line << ':' << Frame.Column << '\n';
+  }
+}
+
+// Print the DIEs that the accelerator table in Section lists for Name. The
+// first atom of the Apple tables is the offset of the DIE.
+static void lookupName(DWARFContext &DICtx, StringRef TableName,
+                       const DWARFSection &Section, StringRef Name) {
+  DataExtractor AccelSection(Section.Data, DICtx.isLittleEndian(), 0);
+  DataExtractor StrData(DICtx.getStringSection(), DICtx.isLittleEndian(), 0);
+  DWARFAcceleratorTable Accel(AccelSection, StrData, Section.Relocs);
+  if (Section.Data.empty() || !Accel.extract())
+    return;
+
+  for (auto I = Accel.find(Name), E = Accel.end(); I != E; ++I) {
+    Optional<uint64_t> Offset = (*I)[0].getAsUnsignedConstant();
+    if (!Offset)
+      continue;
+    outs() << Name << " in ." << TableName << ":\n";
+    for (const auto &CU : DICtx.compile_units()) {
+      if (*Offset < CU->getOffset() || *Offset >= CU->getNextUnitOffset())
+        continue;
+      const DWARFDebugInfoEntryMinimal *Die =
+          CU->getCompileUnitDIE(false) ? CU->getDIEForOffset(*Offset)
+                                       : nullptr;
+      if (Die && Die->getOffset() == *Offset)
+        Die->dump(outs(), CU.get(), 0);
+      break;
+    }
+  }
+}
+
 static void DumpInput(StringRef Filename) {
   ErrorOr<std::unique_ptr<MemoryBuffer>> BuffOrErr =
       MemoryBuffer::getFileOrSTDIN(Filename);
@@ -91,6 +146,27 @@ static void DumpInput(StringRef Filename) {
 
   outs() << Filename
          << ":\tfile format " << Obj.getFileFormatName() << "\n\n";
+
+  // Answer the queries from the aranges, line tables and accelerator tables
+  // without dumping everything.
+  if (!LookupAddress.empty() || !LookupNames.empty()) {
+    uint64_t Address;
+    if (!LookupAddress.empty()) {
+      if (StringRef(LookupAddress).getAsInteger(0, Address))
+        errs() << "invalid address: " << LookupAddress << '\n';
+      else
+        lookupAddress(*DICtx, Address);
+    }
+    auto &DwarfCtx = cast<DWARFContext>(*DICtx);
+    for (const auto &Name : LookupNames) {
+      lookupName(DwarfCtx, "apple_names", DwarfCtx.getAppleNamesSection(),
+                 Name);
+      lookupName(DwarfCtx, "apple_types", DwarfCtx.getAppleTypesSection(),
+                 Name);
+    }
+    return;
+  }
+
   // Dump the complete DWARF structure.
   DICtx->dump(outs(), DumpType);
 }
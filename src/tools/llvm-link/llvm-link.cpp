@@ -24,13 +24,17 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/SystemUtils.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/ToolOutputFile.h"
+#include <deque>
 #include <memory>
+#include <mutex>
 using namespace llvm;
 
 static cl::list<std::string>
@@ -73,16 +77,53 @@ static cl::opt<bool> PreserveAssemblyUseListOrder(
     cl::desc("Preserve use-list order when writing LLVM assembly."),
     cl::init(false), cl::Hidden);
 
-// Read the specified bitcode file in and return it. This routine searches the
-// link path for the specified file to try to find it...
-//
+static cl::opt<unsigned>
+Threads("j", cl::desc("Number of threads reading and linking the input "
+                      "files, 0 for one per hardware thread"),
+        cl::init(1), cl::value_desc("N"));
+
+static cl::opt<unsigned>
+MergeTree("merge-tree",
+          cl::desc("Link the input files in groups of <N>, in parallel and "
+                   "each group in its own context, then link the results of "
+                   "the groups the same way until at most <N> are left"),
+          cl::init(0), cl::value_desc("N"));
+
+// Serializes the messages of the threads linking groups of files.
+static std::mutex OutputLock;
+
+// An input of a link: a file to read, or the bitcode of the files from
+// FirstFile to LastFile, linked already.
+struct LinkInput {
+  std::string Name;
+  StringRef FirstFile, LastFile;
+  std::unique_ptr<MemoryBuffer> Buffer;
+};
+
+static ErrorOr<std::unique_ptr<MemoryBuffer>> readFile(std::string FN) {
+  return MemoryBuffer::getFileOrSTDIN(FN);
+}
+
+// Load the specified bitcode file, whose contents were read into Buffer.
 static std::unique_ptr<Module>
-loadFile(const char *argv0, const std::string &FN, LLVMContext &Context) {
+loadFile(const char *argv0, StringRef FN,
+         ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer, LLVMContext &Context) {
   SMDiagnostic Err;
-  if (Verbose) errs() << "Loading '" << FN << "'\n";
-  std::unique_ptr<Module> Result = getLazyIRFileModule(FN, Err, Context);
-  if (!Result)
+  if (Verbose) {
+    std::lock_guard<std::mutex> Lock(OutputLock);
+    errs() << "Loading '" << FN << "'\n";
+  }
+  std::unique_ptr<Module> Result;
+  if (std::error_code EC = Buffer.getError())
+    Err = SMDiagnostic(FN, SourceMgr::DK_Error,
+                       "Could not open input file: " + EC.message());
+  else
+    Result = getLazyIRModule(std::move(Buffer.get()), Err, Context);
+  if (!Result) {
+    std::lock_guard<std::mutex> Lock(OutputLock);
     Err.print(argv0, errs());
+    return nullptr;
+  }
 
   Result->materializeMetadata();
   UpgradeDebugInfo(*Result);
@@ -91,6 +132,7 @@ loadFile(const char *argv0, const std::string &FN, LLVMContext &Context) {
 }
 
 static void diagnosticHandler(const DiagnosticInfo &DI) {
+  std::lock_guard<std::mutex> Lock(OutputLock);
   unsigned Severity = DI.getSeverity();
   switch (Severity) {
   case DS_Error:
@@ -111,31 +153,135 @@ static void diagnosticHandler(const DiagnosticInfo &DI) {
   errs() << '\n';
 }
 
+static bool linkFile(const char *argv0, LLVMContext &Context, Linker &L,
+                     StringRef File,
+                     ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer,
+                     bool OverrideDuplicateSymbols) {
+  std::unique_ptr<Module> M = loadFile(argv0, File, std::move(Buffer), Context);
+  if (!M.get()) {
+    std::lock_guard<std::mutex> Lock(OutputLock);
+    errs() << argv0 << ": error loading file '" << File << "'\n";
+    return false;
+  }
+
+  std::string Errors;
+  raw_string_ostream ErrorsOS(Errors);
+  if (verifyModule(*M, &ErrorsOS)) {
+    std::lock_guard<std::mutex> Lock(OutputLock);
+    errs() << ErrorsOS.str();
+    errs() << argv0 << ": " << File << ": error: input module is broken!\n";
+    return false;
+  }
+
+  if (Verbose) {
+    std::lock_guard<std::mutex> Lock(OutputLock);
+    errs() << "Linking in '" << File << "'\n";
+  }
+
+  return !L.linkInModule(M.get(), OverrideDuplicateSymbols);
+}
+
 static bool linkFiles(const char *argv0, LLVMContext &Context, Linker &L,
-                      const cl::list<std::string> &Files,
-                      bool OverrideDuplicateSymbols) {
-  for (const auto &File : Files) {
-    std::unique_ptr<Module> M = loadFile(argv0, File, Context);
-    if (!M.get()) {
-      errs() << argv0 << ": error loading file '" << File << "'\n";
-      return false;
+                      MutableArrayRef<LinkInput> Inputs,
+                      bool OverrideDuplicateSymbols, ThreadPool &Pool) {
+  // Read the files on the pool's threads ahead of linking them. Don't read
+  // too far ahead, as each file is kept in memory until it is linked.
+  const size_t ReadAhead = 4 * std::max(1u, Pool.getThreadCount());
+  std::deque<std::future<ErrorOr<std::unique_ptr<MemoryBuffer>>>> Reads;
+  size_t NextRead = 0;
+  for (auto &Input : Inputs) {
+    for (; NextRead != Inputs.size() && Reads.size() < ReadAhead; ++NextRead)
+      if (!Inputs[NextRead].Buffer)
+        Reads.push_back(Pool.async(readFile, Inputs[NextRead].Name));
+
+    ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer = std::move(Input.Buffer);
+    if (!Buffer.get()) {
+      Buffer = Reads.front().get();
+      Reads.pop_front();
     }
 
-    if (verifyModule(*M, &errs())) {
-      errs() << argv0 << ": " << File << ": error: input module is broken!\n";
+    if (!linkFile(argv0, Context, L, Input.Name, std::move(Buffer),
+                  OverrideDuplicateSymbols))
       return false;
-    }
+  }
 
-    if (Verbose)
-      errs() << "Linking in '" << File << "'\n";
+  return true;
+}
+
+// Link Inputs into a module of its own context, and return its bitcode, or
+// null if a file couldn't be linked.
+static std::unique_ptr<MemoryBuffer> linkGroup(const char *argv0,
+                                               MutableArrayRef<LinkInput> Inputs,
+                                               const std::string &Name) {
+  LLVMContext Context;
+  auto Composite = make_unique<Module>("llvm-link", Context);
+  Linker L(Composite.get(), diagnosticHandler);
+  for (auto &Input : Inputs) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer = std::move(Input.Buffer);
+    if (!Buffer.get())
+      Buffer = readFile(Input.Name);
+    if (!linkFile(argv0, Context, L, Input.Name, std::move(Buffer), false))
+      return nullptr;
+  }
+
+  std::string Bitcode;
+  raw_string_ostream OS(Bitcode);
+  WriteBitcodeToFile(Composite.get(), OS, PreserveBitcodeUseListOrder);
+  return MemoryBuffer::getMemBufferCopy(OS.str(), Name);
+}
 
-    if (L.linkInModule(M.get(), OverrideDuplicateSymbols))
+// Link groups of MergeTree consecutive inputs on the pool's threads, and
+// replace each group by the result of its link, until at most MergeTree
+// inputs are left. The groups don't depend on the number of threads, so the
+// result is the same for any number of them.
+static bool mergeTree(const char *argv0, std::vector<LinkInput> &Inputs,
+                      ThreadPool &Pool) {
+  while (Inputs.size() > MergeTree) {
+    std::vector<LinkInput> Groups;
+    std::vector<std::pair<size_t, std::future<std::unique_ptr<MemoryBuffer>>>>
+        Links;
+    for (size_t I = 0, E = Inputs.size(); I < E; I += MergeTree) {
+      auto Group = MutableArrayRef<LinkInput>(Inputs).slice(
+          I, std::min<size_t>(MergeTree, E - I));
+      if (Group.size() == 1) {
+        // The last input is left over: it goes on to the next level as is.
+        Groups.push_back(std::move(Group.front()));
+        continue;
+      }
+
+      LinkInput Linked;
+      Linked.FirstFile = Group.front().FirstFile;
+      Linked.LastFile = Group.back().LastFile;
+      Linked.Name = (Linked.FirstFile + " to " + Linked.LastFile).str();
+      std::string Name = Linked.Name;
+      Links.push_back(std::make_pair(Groups.size(), Pool.async([=] {
+        return linkGroup(argv0, Group, Name);
+      })));
+      Groups.push_back(std::move(Linked));
+    }
+
+    bool Failed = false;
+    for (auto &Link : Links) {
+      Groups[Link.first].Buffer = Link.second.get();
+      Failed |= !Groups[Link.first].Buffer;
+    }
+    if (Failed)
       return false;
+    Inputs = std::move(Groups);
   }
 
   return true;
 }
 
+static std::vector<LinkInput> getInputs(const cl::list<std::string> &Files) {
+  std::vector<LinkInput> Inputs(Files.size());
+  for (size_t I = 0, E = Files.size(); I != E; ++I) {
+    Inputs[I].Name = Files[I];
+    Inputs[I].FirstFile = Inputs[I].LastFile = Files[I];
+  }
+  return Inputs;
+}
+
 int main(int argc, char **argv) {
   // Print a stack trace if we signal out.
   sys::PrintStackTraceOnErrorSignal();
@@ -147,13 +293,19 @@ int main(int argc, char **argv) {
 
   auto Composite = make_unique<Module>("llvm-link", Context);
   Linker L(Composite.get(), diagnosticHandler);
+  ThreadPool Pool(Threads);
 
-  // First add all the regular input files
-  if (!linkFiles(argv[0], Context, L, InputFilenames, false))
+  // First add all the regular input files, linking groups of them apart
+  // first if asked to.
+  std::vector<LinkInput> Inputs = getInputs(InputFilenames);
+  if (MergeTree > 1 && !mergeTree(argv[0], Inputs, Pool))
+    return 1;
+  if (!linkFiles(argv[0], Context, L, Inputs, false, Pool))
     return 1;
 
   // Next the -override ones.
-  if (!linkFiles(argv[0], Context, L, OverridingInputs, true))
+  std::vector<LinkInput> Overrides = getInputs(OverridingInputs);
+  if (!linkFiles(argv[0], Context, L, Overrides, true, Pool))
     return 1;
 
   if (DumpAsm) errs() << "Here's the assembly:\n" << *Composite;
@@ -12,16 +12,20 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
+#include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/LTO/LTOCodeGenerator.h"
 #include "llvm/LTO/LTOModule.h"
+#include "llvm/LTO/ThinLTOCodeGenerator.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
@@ -42,6 +46,17 @@ static cl::opt<bool>
 DisableLTOVectorization("disable-lto-vectorization", cl::init(false),
   cl::desc("Do not run loop or slp vectorization during LTO"));
 
+static cl::opt<unsigned>
+Parallelism("j", cl::init(1),
+  cl::desc("Split the output into this many object files, generated on as "
+           "many threads; with -thinlto, the number of backends to run at "
+           "once"));
+
+static cl::opt<bool>
+OptimizePartitions("optimize-partitions", cl::init(false),
+  cl::desc("With -j, run the function passes on each partition, on the "
+           "thread that generates code for it"));
+
 static cl::opt<bool>
 UseDiagnosticHandler("use-diagnostic-handler", cl::init(false),
   cl::desc("Use a diagnostic handler to test the handler interface"));
@@ -73,6 +88,36 @@ static cl::opt<bool> SetMergedModule(
     "set-merged-module", cl::init(false),
     cl::desc("Use the first input module as the merged module"));
 
+static cl::opt<bool> LazyLink(
+    "lazy-link", cl::init(false),
+    cl::desc("Only link and materialize the definitions reachable from the "
+             "preserved symbols"));
+
+static cl::opt<std::string> CacheDir(
+    "cache-dir", cl::init(""),
+    cl::desc("Cache the generated object files in this directory"),
+    cl::value_desc("directory"));
+
+static cl::opt<bool> ThinLTO(
+    "thinlto", cl::init(false),
+    cl::desc("Run thin LTO: optimize and compile each input to "
+             "<input>.thinlto.o, importing from the other inputs"));
+
+static cl::opt<bool> ThinLTOIndexOnly(
+    "thinlto-index-only", cl::init(false),
+    cl::desc("Only write the combined function summary index of the inputs "
+             "to the output file"));
+
+static cl::opt<std::string> ThinLTOIndex(
+    "thinlto-index", cl::init(""),
+    cl::desc("Run the thin LTO backends with this combined index, importing "
+             "from the modules it lists"),
+    cl::value_desc("filename"));
+
+static cl::opt<unsigned> ThinLTOImportLimit(
+    "thinlto-import-instr-limit", cl::init(100), cl::Hidden,
+    cl::desc("Only import functions with at most this many instructions"));
+
 namespace {
 struct ModuleInfo {
   std::vector<bool> CanBeHidden;
@@ -138,6 +183,90 @@ int listSymbols(StringRef Command, const TargetOptions &Options) {
   return 0;
 }
 
+/// \brief Run thin LTO on the inputs, or only write their combined index.
+int thinLTO(StringRef Command, const TargetOptions &Options) {
+  std::vector<std::unique_ptr<MemoryBuffer>> Buffers;
+  ThinLTOCodeGenerator CodeGen;
+  for (auto &Filename : InputFilenames) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
+        MemoryBuffer::getFile(Filename);
+    if (std::error_code EC = BufferOrErr.getError()) {
+      errs() << Command << ": error loading file '" << Filename
+             << "': " << EC.message() << "\n";
+      return 1;
+    }
+    Buffers.push_back(std::move(BufferOrErr.get()));
+    CodeGen.addModule(Filename, Buffers.back()->getBuffer());
+  }
+
+  std::string ErrorInfo;
+  if (ThinLTOIndexOnly) {
+    if (OutputFilename.empty()) {
+      errs() << Command << ": -thinlto-index-only requires -o\n";
+      return 1;
+    }
+    std::unique_ptr<FunctionInfoIndex> Index =
+        CodeGen.linkCombinedIndex(ErrorInfo);
+    if (!Index) {
+      errs() << Command << ": error linking the index: " << ErrorInfo << "\n";
+      return 1;
+    }
+    std::error_code EC;
+    raw_fd_ostream OS(OutputFilename, EC, sys::fs::F_None);
+    if (EC) {
+      errs() << Command << ": error opening the file '" << OutputFilename
+             << "': " << EC.message() << "\n";
+      return 1;
+    }
+    WriteFunctionSummaryToFile(*Index, OS);
+    return 0;
+  }
+
+  if (!ThinLTOIndex.empty()) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
+        MemoryBuffer::getFile(ThinLTOIndex);
+    if (std::error_code EC = BufferOrErr.getError()) {
+      errs() << Command << ": error loading file '" << ThinLTOIndex
+             << "': " << EC.message() << "\n";
+      return 1;
+    }
+    ErrorOr<std::unique_ptr<FunctionInfoIndex>> IndexOrErr =
+        getFunctionInfoIndex((*BufferOrErr)->getMemBufferRef());
+    if (std::error_code EC = IndexOrErr.getError()) {
+      errs() << Command << ": error reading the index '" << ThinLTOIndex
+             << "': " << EC.message() << "\n";
+      return 1;
+    }
+    CodeGen.setCombinedIndex(std::move(IndexOrErr.get()));
+  }
+
+  CodeGen.setCpu(MCPU);
+  CodeGen.setAttr(getFeaturesStr());
+  CodeGen.setTargetOptions(Options);
+  CodeGen.setCodePICModel(RelocModel);
+  CodeGen.setParallelism(Parallelism);
+  CodeGen.setImportInstrLimit(ThinLTOImportLimit);
+  if (!CodeGen.run(ErrorInfo)) {
+    errs() << Command << ": error compiling the code: " << ErrorInfo << "\n";
+    return 1;
+  }
+
+  ArrayRef<std::unique_ptr<MemoryBuffer>> Binaries =
+      CodeGen.getProducedBinaries();
+  for (unsigned I = 0, E = Binaries.size(); I != E; ++I) {
+    std::string ObjFilename = InputFilenames[I] + ".thinlto.o";
+    std::error_code EC;
+    raw_fd_ostream OS(ObjFilename, EC, sys::fs::F_None);
+    if (EC) {
+      errs() << Command << ": error opening the file '" << ObjFilename
+             << "': " << EC.message() << "\n";
+      return 1;
+    }
+    OS << Binaries[I]->getBuffer();
+  }
+  return 0;
+}
+
 int main(int argc, char **argv) {
   // Print a stack trace if we signal out.
   sys::PrintStackTraceOnErrorSignal();
@@ -158,6 +287,9 @@ int main(int argc, char **argv) {
   if (ListSymbolsOnly)
     return listSymbols(argv[0], Options);
 
+  if (ThinLTO || ThinLTOIndexOnly || !ThinLTOIndex.empty())
+    return thinLTO(argv[0], Options);
+
   unsigned BaseArg = 0;
 
   LTOCodeGenerator CodeGen;
@@ -188,10 +320,14 @@ int main(int argc, char **argv) {
 
   std::vector<std::string> KeptDSOSyms;
 
+  // Lazily linked modules are only linked at code generation time.
+  CodeGen.setShouldLinkLazily(LazyLink);
+  std::vector<std::unique_ptr<LTOModule>> LazyModules;
+
   for (unsigned i = BaseArg; i < InputFilenames.size(); ++i) {
     std::string error;
-    std::unique_ptr<LTOModule> Module(
-        LTOModule::createFromFile(InputFilenames[i].c_str(), Options, error));
+    std::unique_ptr<LTOModule> Module(LTOModule::createFromFile(
+        InputFilenames[i].c_str(), Options, error, LazyLink));
     if (!error.empty()) {
       errs() << argv[0] << ": error loading file '" << InputFilenames[i]
              << "': " << error << "\n";
@@ -218,6 +354,9 @@ int main(int argc, char **argv) {
       if (Scope != LTO_SYMBOL_SCOPE_DEFAULT_CAN_BE_HIDDEN)
         KeptDSOSyms.push_back(Name);
     }
+
+    if (LazyLink)
+      LazyModules.push_back(std::move(Module));
   }
 
   // Add all the exported symbols to the table of symbols to preserve.
@@ -241,7 +380,44 @@ int main(int argc, char **argv) {
   if (!attrs.empty())
     CodeGen.setAttr(attrs.c_str());
 
-  if (!OutputFilename.empty()) {
+  CodeGen.setParallelism(Parallelism);
+  CodeGen.setShouldOptimizePartitions(OptimizePartitions);
+  if (!CacheDir.empty())
+    CodeGen.setCacheDir(CacheDir.c_str());
+
+  if (!OutputFilename.empty() && Parallelism > 1) {
+    std::string ErrorInfo;
+    if (!CodeGen.optimize(DisableOpt, DisableInline, DisableGVNLoadPRE,
+                          DisableLTOVectorization, ErrorInfo)) {
+      errs() << argv[0] << ": error optimizing the code: " << ErrorInfo
+             << "\n";
+      return 1;
+    }
+
+    // Each partition goes to <output>.<index>.
+    std::vector<std::unique_ptr<tool_output_file>> Files;
+    std::vector<raw_ostream *> Streams;
+    for (unsigned I = 0; I != Parallelism; ++I) {
+      std::string PartFilename = OutputFilename + "." + utostr(I);
+      std::error_code EC;
+      Files.push_back(
+          make_unique<tool_output_file>(PartFilename, EC, sys::fs::F_None));
+      if (EC) {
+        errs() << argv[0] << ": error opening the file '" << PartFilename
+               << "': " << EC.message() << "\n";
+        return 1;
+      }
+      Streams.push_back(&Files.back()->os());
+    }
+
+    if (!CodeGen.compileOptimized(Streams, ErrorInfo)) {
+      errs() << argv[0] << ": error compiling the code: " << ErrorInfo
+             << "\n";
+      return 1;
+    }
+    for (auto &File : Files)
+      File->keep();
+  } else if (!OutputFilename.empty()) {
     size_t len = 0;
     std::string ErrorInfo;
     const void *Code =
@@ -262,6 +438,20 @@ int main(int argc, char **argv) {
     }
 
     FileStream.write(reinterpret_cast<const char *>(Code), len);
+  } else if (Parallelism > 1) {
+    std::string ErrorInfo;
+    ArrayRef<const char *> OutputNames;
+    if (!CodeGen.compile_to_files(OutputNames, DisableOpt, DisableInline,
+                                  DisableGVNLoadPRE, DisableLTOVectorization,
+                                  ErrorInfo)) {
+      errs() << argv[0]
+             << ": error compiling the code: " << ErrorInfo
+             << "\n";
+      return 1;
+    }
+
+    for (const char *OutputName : OutputNames)
+      outs() << "Wrote native object file '" << OutputName << "'\n";
   } else {
     std::string ErrorInfo;
     const char *OutputName = nullptr;
@@ -37,12 +37,16 @@
 #include "llvm/Support/Program.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <cerrno>
 #include <cstring>
+#include <functional>
 #include <system_error>
+#include <thread>
 #include <vector>
 using namespace llvm;
 using namespace object;
@@ -152,18 +156,33 @@ cl::opt<bool> FormatMachOasHex("x", cl::desc("Print symbol entry in hex, "
 cl::opt<bool> NoLLVMBitcode("no-llvm-bc",
                             cl::desc("Disable LLVM bitcode reader"));
 
+cl::opt<unsigned> NumThreads("j", cl::desc("Number of input files, or members "
+                                           "or slices of a single input, to "
+                                           "dump concurrently, 0 for one per "
+                                           "core"),
+                             cl::init(1));
+
 bool PrintAddress = true;
 
 bool MultipleFiles = false;
 
-bool HadError = false;
+std::atomic<bool> HadError(false);
 
 std::string ToolName;
 }
 
+// The streams of the file or archive member being dumped by this thread. With
+// -j, each one is dumped into buffers of its own, which are printed in input
+// order once the dumps before it have been printed.
+static LLVM_THREAD_LOCAL raw_ostream *OutputStream = nullptr;
+static LLVM_THREAD_LOCAL raw_ostream *ErrorStream = nullptr;
+
+static raw_ostream &out() { return OutputStream ? *OutputStream : outs(); }
+
 static void error(Twine Message, Twine Path = Twine()) {
   HadError = true;
-  errs() << ToolName << ": " << Path << ": " << Message << ".\n";
+  raw_ostream &OS = ErrorStream ? *ErrorStream : errs();
+  OS << ToolName << ": " << Path << ": " << Message << ".\n";
 }
 
 static bool error(std::error_code EC, Twine Path = Twine()) {
@@ -269,9 +288,7 @@ static char isSymbolList64Bit(SymbolicFile &Obj) {
     return false;
 }
 
-static StringRef CurrentFilename;
 typedef std::vector<NMSymbol> SymbolListT;
-static SymbolListT SymbolList;
 
 // darwinPrintSymbol() is used to print a symbol from a Mach-O file when the
 // the OutputFormat is darwin or we are printing Mach-O symbols in hex.  For
@@ -321,54 +338,54 @@ static void darwinPrintSymbol(MachOObjectFile *MachO, SymbolListT::iterator I,
     else
       printFormat = "%08" PRIx64;
     format(printFormat, NValue).print(Str, sizeof(Str));
-    outs() << Str << ' ';
+    out() << Str << ' ';
     format("%02x", NType).print(Str, sizeof(Str));
-    outs() << Str << ' ';
+    out() << Str << ' ';
     format("%02x", NSect).print(Str, sizeof(Str));
-    outs() << Str << ' ';
+    out() << Str << ' ';
     format("%04x", NDesc).print(Str, sizeof(Str));
-    outs() << Str << ' ';
+    out() << Str << ' ';
     format("%08x", NStrx).print(Str, sizeof(Str));
-    outs() << Str << ' ';
-    outs() << I->Name << "\n";
+    out() << Str << ' ';
+    out() << I->Name << "\n";
     return;
   }
 
   if (PrintAddress) {
     if ((NType & MachO::N_TYPE) == MachO::N_INDR)
       strcpy(SymbolAddrStr, printBlanks);
-    outs() << SymbolAddrStr << ' ';
+    out() << SymbolAddrStr << ' ';
   }
 
   switch (NType & MachO::N_TYPE) {
   case MachO::N_UNDF:
     if (NValue != 0) {
-      outs() << "(common) ";
+      out() << "(common) ";
       if (MachO::GET_COMM_ALIGN(NDesc) != 0)
-        outs() << "(alignment 2^" << (int)MachO::GET_COMM_ALIGN(NDesc) << ") ";
+        out() << "(alignment 2^" << (int)MachO::GET_COMM_ALIGN(NDesc) << ") ";
     } else {
       if ((NType & MachO::N_TYPE) == MachO::N_PBUD)
-        outs() << "(prebound ";
+        out() << "(prebound ";
       else
-        outs() << "(";
+        out() << "(";
       if ((NDesc & MachO::REFERENCE_TYPE) ==
           MachO::REFERENCE_FLAG_UNDEFINED_LAZY)
-        outs() << "undefined [lazy bound]) ";
+        out() << "undefined [lazy bound]) ";
       else if ((NDesc & MachO::REFERENCE_TYPE) ==
                MachO::REFERENCE_FLAG_UNDEFINED_LAZY)
-        outs() << "undefined [private lazy bound]) ";
+        out() << "undefined [private lazy bound]) ";
       else if ((NDesc & MachO::REFERENCE_TYPE) ==
                MachO::REFERENCE_FLAG_PRIVATE_UNDEFINED_NON_LAZY)
-        outs() << "undefined [private]) ";
+        out() << "undefined [private]) ";
       else
-        outs() << "undefined) ";
+        out() << "undefined) ";
     }
     break;
   case MachO::N_ABS:
-    outs() << "(absolute) ";
+    out() << "(absolute) ";
     break;
   case MachO::N_INDR:
-    outs() << "(indirect) ";
+    out() << "(indirect) ";
     break;
   case MachO::N_SECT: {
     section_iterator Sec = MachO->section_end();
@@ -377,66 +394,66 @@ static void darwinPrintSymbol(MachOObjectFile *MachO, SymbolListT::iterator I,
     StringRef SectionName;
     MachO->getSectionName(Ref, SectionName);
     StringRef SegmentName = MachO->getSectionFinalSegmentName(Ref);
-    outs() << "(" << SegmentName << "," << SectionName << ") ";
+    out() << "(" << SegmentName << "," << SectionName << ") ";
     break;
   }
   default:
-    outs() << "(?) ";
+    out() << "(?) ";
     break;
   }
 
   if (NType & MachO::N_EXT) {
     if (NDesc & MachO::REFERENCED_DYNAMICALLY)
-      outs() << "[referenced dynamically] ";
+      out() << "[referenced dynamically] ";
     if (NType & MachO::N_PEXT) {
       if ((NDesc & MachO::N_WEAK_DEF) == MachO::N_WEAK_DEF)
-        outs() << "weak private external ";
+        out() << "weak private external ";
       else
-        outs() << "private external ";
+        out() << "private external ";
     } else {
       if ((NDesc & MachO::N_WEAK_REF) == MachO::N_WEAK_REF ||
           (NDesc & MachO::N_WEAK_DEF) == MachO::N_WEAK_DEF) {
         if ((NDesc & (MachO::N_WEAK_REF | MachO::N_WEAK_DEF)) ==
             (MachO::N_WEAK_REF | MachO::N_WEAK_DEF))
-          outs() << "weak external automatically hidden ";
+          out() << "weak external automatically hidden ";
         else
-          outs() << "weak external ";
+          out() << "weak external ";
       } else
-        outs() << "external ";
+        out() << "external ";
     }
   } else {
     if (NType & MachO::N_PEXT)
-      outs() << "non-external (was a private external) ";
+      out() << "non-external (was a private external) ";
     else
-      outs() << "non-external ";
+      out() << "non-external ";
   }
 
   if (Filetype == MachO::MH_OBJECT &&
       (NDesc & MachO::N_NO_DEAD_STRIP) == MachO::N_NO_DEAD_STRIP)
-    outs() << "[no dead strip] ";
+    out() << "[no dead strip] ";
 
   if (Filetype == MachO::MH_OBJECT &&
       ((NType & MachO::N_TYPE) != MachO::N_UNDF) &&
       (NDesc & MachO::N_SYMBOL_RESOLVER) == MachO::N_SYMBOL_RESOLVER)
-    outs() << "[symbol resolver] ";
+    out() << "[symbol resolver] ";
 
   if (Filetype == MachO::MH_OBJECT &&
       ((NType & MachO::N_TYPE) != MachO::N_UNDF) &&
       (NDesc & MachO::N_ALT_ENTRY) == MachO::N_ALT_ENTRY)
-    outs() << "[alt entry] ";
+    out() << "[alt entry] ";
 
   if ((NDesc & MachO::N_ARM_THUMB_DEF) == MachO::N_ARM_THUMB_DEF)
-    outs() << "[Thumb] ";
+    out() << "[Thumb] ";
 
   if ((NType & MachO::N_TYPE) == MachO::N_INDR) {
-    outs() << I->Name << " (for ";
+    out() << I->Name << " (for ";
     StringRef IndirectName;
     if (MachO->getIndirectName(I->Symb, IndirectName))
-      outs() << "?)";
+      out() << "?)";
     else
-      outs() << IndirectName << ")";
+      out() << IndirectName << ")";
   } else
-    outs() << I->Name;
+    out() << I->Name;
 
   if ((Flags & MachO::MH_TWOLEVEL) == MachO::MH_TWOLEVEL &&
       (((NType & MachO::N_TYPE) == MachO::N_UNDF && NValue == 0) ||
@@ -444,20 +461,20 @@ static void darwinPrintSymbol(MachOObjectFile *MachO, SymbolListT::iterator I,
     uint32_t LibraryOrdinal = MachO::GET_LIBRARY_ORDINAL(NDesc);
     if (LibraryOrdinal != 0) {
       if (LibraryOrdinal == MachO::EXECUTABLE_ORDINAL)
-        outs() << " (from executable)";
+        out() << " (from executable)";
       else if (LibraryOrdinal == MachO::DYNAMIC_LOOKUP_ORDINAL)
-        outs() << " (dynamically looked up)";
+        out() << " (dynamically looked up)";
       else {
         StringRef LibraryName;
         if (MachO->getLibraryShortNameByIndex(LibraryOrdinal - 1, LibraryName))
-          outs() << " (from bad library ordinal " << LibraryOrdinal << ")";
+          out() << " (from bad library ordinal " << LibraryOrdinal << ")";
         else
-          outs() << " (from " << LibraryName << ")";
+          out() << " (from " << LibraryName << ")";
       }
     }
   }
 
-  outs() << "\n";
+  out() << "\n";
 }
 
 // Table that maps Darwin's Mach-O stab constants to strings to allow printing.
@@ -528,19 +545,20 @@ static void darwinPrintStab(MachOObjectFile *MachO, SymbolListT::iterator I) {
 
   char Str[18] = "";
   format("%02x", NSect).print(Str, sizeof(Str));
-  outs() << ' ' << Str << ' ';
+  out() << ' ' << Str << ' ';
   format("%04x", NDesc).print(Str, sizeof(Str));
-  outs() << Str << ' ';
+  out() << Str << ' ';
   if (const char *stabString = getDarwinStabString(NType))
     format("%5.5s", stabString).print(Str, sizeof(Str));
   else
     format("   %02x", NType).print(Str, sizeof(Str));
-  outs() << Str;
+  out() << Str;
 }
 
-static void sortAndPrintSymbolList(SymbolicFile &Obj, bool printName,
-                                   std::string ArchiveName,
+static void sortAndPrintSymbolList(SymbolicFile &Obj, SymbolListT &SymbolList,
+                                   bool printName, std::string ArchiveName,
                                    std::string ArchitectureName) {
+  StringRef CurrentFilename = Obj.getFileName();
   if (!NoSort) {
     if (NumericSort)
       std::sort(SymbolList.begin(), SymbolList.end(), compareSymbolAddress);
@@ -552,11 +570,11 @@ static void sortAndPrintSymbolList(SymbolicFile &Obj, bool printName,
 
   if (!PrintFileName) {
     if (OutputFormat == posix && MultipleFiles && printName) {
-      outs() << '\n' << CurrentFilename << ":\n";
+      out() << '\n' << CurrentFilename << ":\n";
     } else if (OutputFormat == bsd && MultipleFiles && printName) {
-      outs() << "\n" << CurrentFilename << ":\n";
+      out() << "\n" << CurrentFilename << ":\n";
     } else if (OutputFormat == sysv) {
-      outs() << "\n\nSymbols from " << CurrentFilename << ":\n\n"
+      out() << "\n\nSymbols from " << CurrentFilename << ":\n\n"
              << "Name                  Value   Class        Type"
              << "         Size   Line  Section\n";
     }
@@ -581,13 +599,13 @@ static void sortAndPrintSymbolList(SymbolicFile &Obj, bool printName,
       continue;
     if (PrintFileName) {
       if (!ArchitectureName.empty())
-        outs() << "(for architecture " << ArchitectureName << "):";
+        out() << "(for architecture " << ArchitectureName << "):";
       if (!ArchiveName.empty())
-        outs() << ArchiveName << ":";
-      outs() << CurrentFilename << ": ";
+        out() << ArchiveName << ":";
+      out() << CurrentFilename << ": ";
     }
     if (JustSymbolName || (UndefinedOnly && isa<MachOObjectFile>(Obj))) {
-      outs() << I->Name << "\n";
+      out() << I->Name << "\n";
       continue;
     }
 
@@ -614,30 +632,28 @@ static void sortAndPrintSymbolList(SymbolicFile &Obj, bool printName,
     if ((OutputFormat == darwin || FormatMachOasHex) && MachO) {
       darwinPrintSymbol(MachO, I, SymbolAddrStr, printBlanks);
     } else if (OutputFormat == posix) {
-      outs() << I->Name << " " << I->TypeChar << " " << SymbolAddrStr
+      out() << I->Name << " " << I->TypeChar << " " << SymbolAddrStr
              << SymbolSizeStr << "\n";
     } else if (OutputFormat == bsd || (OutputFormat == darwin && !MachO)) {
       if (PrintAddress)
-        outs() << SymbolAddrStr << ' ';
+        out() << SymbolAddrStr << ' ';
       if (PrintSize) {
-        outs() << SymbolSizeStr;
+        out() << SymbolSizeStr;
         if (I->Size != UnknownAddressOrSize)
-          outs() << ' ';
+          out() << ' ';
       }
-      outs() << I->TypeChar;
+      out() << I->TypeChar;
       if (I->TypeChar == '-' && MachO)
         darwinPrintStab(MachO, I);
-      outs() << " " << I->Name << "\n";
+      out() << " " << I->Name << "\n";
     } else if (OutputFormat == sysv) {
       std::string PaddedName(I->Name);
       while (PaddedName.length() < 20)
         PaddedName += " ";
-      outs() << PaddedName << "|" << SymbolAddrStr << "|   " << I->TypeChar
+      out() << PaddedName << "|" << SymbolAddrStr << "|   " << I->TypeChar
              << "  |                  |" << SymbolSizeStr << "|     |\n";
     }
   }
-
-  SymbolList.clear();
 }
 
 template <class ELFT>
@@ -909,6 +925,7 @@ static void dumpSymbolNamesFromObject(SymbolicFile &Obj, bool printName,
     IBegin = IDyn.first;
     IEnd = IDyn.second;
   }
+  SymbolListT SymbolList;
   std::string NameBuffer;
   raw_string_ostream OS(NameBuffer);
   // If a "-s segname sectname" option was specified and this is a Mach-O
@@ -963,8 +980,8 @@ static void dumpSymbolNamesFromObject(SymbolicFile &Obj, bool printName,
     P += strlen(P) + 1;
   }
 
-  CurrentFilename = Obj.getFileName();
-  sortAndPrintSymbolList(Obj, printName, ArchiveName, ArchitectureName);
+  sortAndPrintSymbolList(Obj, SymbolList, printName, ArchiveName,
+                         ArchitectureName);
 }
 
 // checkMachOAndArchFlags() checks to see if the SymbolicFile is a Mach-O file
@@ -1001,13 +1018,77 @@ static bool checkMachOAndArchFlags(SymbolicFile *O, std::string &Filename) {
   return true;
 }
 
+static unsigned getNumThreads() {
+  return NumThreads ? NumThreads.getValue()
+                    : std::thread::hardware_concurrency();
+}
+
+// Calls Dump(I) for each I in [0, N) on a thread pool and prints what each
+// call printed in order of I. As in a serial loop, nothing is printed after
+// the first call that returns false. The calls are made in batches, so that
+// only a few dumps are buffered at a time.
+static void dumpInParallel(unsigned N, std::function<bool(unsigned)> Dump) {
+  unsigned Threads = getNumThreads();
+  ThreadPool Pool(Threads);
+  unsigned BatchSize = Threads * 4;
+  for (unsigned Begin = 0; Begin < N; Begin += BatchSize) {
+    unsigned End = std::min(N, Begin + BatchSize);
+    std::vector<std::string> Outputs(End - Begin), Errors(End - Begin);
+    std::unique_ptr<bool[]> Continue(new bool[End - Begin]);
+    for (unsigned I = Begin; I != End; ++I)
+      Pool.async([&, I] {
+        raw_string_ostream OS(Outputs[I - Begin]), ErrOS(Errors[I - Begin]);
+        OutputStream = &OS;
+        ErrorStream = &ErrOS;
+        Continue[I - Begin] = Dump(I);
+        OutputStream = ErrorStream = nullptr;
+      });
+    Pool.wait();
+
+    for (unsigned I = 0; I != End - Begin; ++I) {
+      outs() << Outputs[I];
+      if (!Errors[I].empty()) {
+        outs().flush();
+        errs() << Errors[I];
+      }
+      if (!Continue[I])
+        return;
+    }
+  }
+}
+
+// Dumps the symbols of an archive member, returning false if the rest of the
+// archive should be skipped.
+static bool dumpSymbolNamesFromArchiveMember(const Archive::Child &C,
+                                             LLVMContext &Context,
+                                             std::string &Filename) {
+  ErrorOr<std::unique_ptr<Binary>> ChildOrErr = C.getAsBinary(&Context);
+  if (ChildOrErr.getError())
+    return true;
+  if (SymbolicFile *O = dyn_cast<SymbolicFile>(&*ChildOrErr.get())) {
+    if (!checkMachOAndArchFlags(O, Filename))
+      return false;
+    if (!PrintFileName) {
+      out() << "\n";
+      if (isa<MachOObjectFile>(O)) {
+        out() << Filename << "(" << O->getFileName() << ")";
+      } else
+        out() << O->getFileName();
+      out() << ":\n";
+    }
+    dumpSymbolNamesFromObject(*O, false, Filename);
+  }
+  return true;
+}
+
 static void dumpSymbolNamesFromFile(std::string &Filename) {
   ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
       MemoryBuffer::getFileOrSTDIN(Filename);
   if (error(BufferOrErr.getError(), Filename))
     return;
 
-  LLVMContext &Context = getGlobalContext();
+  // Each file gets a context of its own, as files may be dumped concurrently.
+  LLVMContext Context;
   ErrorOr<std::unique_ptr<Binary>> BinaryOrErr = createBinary(
       BufferOrErr.get()->getMemBufferRef(), NoLLVMBitcode ? nullptr : &Context);
   if (error(BinaryOrErr.getError(), Filename))
@@ -1019,7 +1100,7 @@ static void dumpSymbolNamesFromFile(std::string &Filename) {
       Archive::symbol_iterator I = A->symbol_begin();
       Archive::symbol_iterator E = A->symbol_end();
       if (I != E) {
-        outs() << "Archive map\n";
+        out() << "Archive map\n";
         for (; I != E; ++I) {
           ErrorOr<Archive::child_iterator> C = I->getMember();
           if (error(C.getError()))
@@ -1028,31 +1109,26 @@ static void dumpSymbolNamesFromFile(std::string &Filename) {
           if (error(FileNameOrErr.getError()))
             return;
           StringRef SymName = I->getName();
-          outs() << SymName << " in " << FileNameOrErr.get() << "\n";
+          out() << SymName << " in " << FileNameOrErr.get() << "\n";
         }
-        outs() << "\n";
+        out() << "\n";
       }
     }
 
-    for (Archive::child_iterator I = A->child_begin(), E = A->child_end();
-         I != E; ++I) {
-      ErrorOr<std::unique_ptr<Binary>> ChildOrErr = I->getAsBinary(&Context);
-      if (ChildOrErr.getError())
-        continue;
-      if (SymbolicFile *O = dyn_cast<SymbolicFile>(&*ChildOrErr.get())) {
-        if (!checkMachOAndArchFlags(O, Filename))
-          return;
-        if (!PrintFileName) {
-          outs() << "\n";
-          if (isa<MachOObjectFile>(O)) {
-            outs() << Filename << "(" << O->getFileName() << ")";
-          } else
-            outs() << O->getFileName();
-          outs() << ":\n";
-        }
-        dumpSymbolNamesFromObject(*O, false, Filename);
-      }
+    // The members of a lone input archive are dumped concurrently, each with
+    // a context of its own; with several inputs the files already are.
+    if (getNumThreads() > 1 && !MultipleFiles) {
+      dumpInParallel(A->getNumChildren(), [&](unsigned I) {
+        LLVMContext MemberContext;
+        return dumpSymbolNamesFromArchiveMember(*A->getChild(I), MemberContext,
+                                                Filename);
+      });
+      return;
     }
+    for (Archive::child_iterator I = A->child_begin(), E = A->child_end();
+         I != E; ++I)
+      if (!dumpSymbolNamesFromArchiveMember(*I, Context, Filename))
+        return;
     return;
   }
   if (MachOUniversalBinary *UB = dyn_cast<MachOUniversalBinary>(&Bin)) {
@@ -1079,7 +1155,7 @@ static void dumpSymbolNamesFromFile(std::string &Filename) {
                 if (PrintFileName)
                   ArchitectureName = I->getArchTypeName();
                 else
-                  outs() << "\n" << Obj.getFileName() << " (for architecture "
+                  out() << "\n" << Obj.getFileName() << " (for architecture "
                          << I->getArchTypeName() << ")"
                          << ":\n";
               }
@@ -1102,13 +1178,13 @@ static void dumpSymbolNamesFromFile(std::string &Filename) {
                     if (ArchFlags.size() > 1)
                       ArchitectureName = I->getArchTypeName();
                   } else {
-                    outs() << "\n" << A->getFileName();
-                    outs() << "(" << O->getFileName() << ")";
+                    out() << "\n" << A->getFileName();
+                    out() << "(" << O->getFileName() << ")";
                     if (ArchFlags.size() > 1) {
-                      outs() << " (for architecture " << I->getArchTypeName()
+                      out() << " (for architecture " << I->getArchTypeName()
                              << ")";
                     }
-                    outs() << ":\n";
+                    out() << ":\n";
                   }
                   dumpSymbolNamesFromObject(*O, false, ArchiveName,
                                             ArchitectureName);
@@ -1154,7 +1230,7 @@ static void dumpSymbolNamesFromFile(std::string &Filename) {
                 if (PrintFileName)
                   ArchiveName = A->getFileName();
                 else
-                  outs() << "\n" << A->getFileName() << "(" << O->getFileName()
+                  out() << "\n" << A->getFileName() << "(" << O->getFileName()
                          << ")"
                          << ":\n";
                 dumpSymbolNamesFromObject(*O, false, ArchiveName);
@@ -1168,10 +1244,9 @@ static void dumpSymbolNamesFromFile(std::string &Filename) {
     // Either all architectures have been specified or none have been specified
     // and this does not contain the host architecture so dump all the slices.
     bool moreThanOneArch = UB->getNumberOfObjects() > 1;
-    for (MachOUniversalBinary::object_iterator I = UB->begin_objects(),
-                                               E = UB->end_objects();
-         I != E; ++I) {
-      ErrorOr<std::unique_ptr<ObjectFile>> ObjOrErr = I->getAsObjectFile();
+    auto DumpSlice = [&](unsigned Index, LLVMContext &SliceContext) {
+      MachOUniversalBinary::ObjectForArch Slice(UB, Index);
+      ErrorOr<std::unique_ptr<ObjectFile>> ObjOrErr = Slice.getAsObjectFile();
       std::string ArchiveName;
       std::string ArchitectureName;
       ArchiveName.clear();
@@ -1180,45 +1255,58 @@ static void dumpSymbolNamesFromFile(std::string &Filename) {
         ObjectFile &Obj = *ObjOrErr.get();
         if (PrintFileName) {
           if (isa<MachOObjectFile>(Obj) && moreThanOneArch)
-            ArchitectureName = I->getArchTypeName();
+            ArchitectureName = Slice.getArchTypeName();
         } else {
           if (moreThanOneArch)
-            outs() << "\n";
-          outs() << Obj.getFileName();
+            out() << "\n";
+          out() << Obj.getFileName();
           if (isa<MachOObjectFile>(Obj) && moreThanOneArch)
-            outs() << " (for architecture " << I->getArchTypeName() << ")";
-          outs() << ":\n";
+            out() << " (for architecture " << Slice.getArchTypeName() << ")";
+          out() << ":\n";
         }
         dumpSymbolNamesFromObject(Obj, false, ArchiveName, ArchitectureName);
-      } else if (ErrorOr<std::unique_ptr<Archive>> AOrErr = I->getAsArchive()) {
+      } else if (ErrorOr<std::unique_ptr<Archive>> AOrErr =
+                     Slice.getAsArchive()) {
         std::unique_ptr<Archive> &A = *AOrErr;
         for (Archive::child_iterator AI = A->child_begin(), AE = A->child_end();
              AI != AE; ++AI) {
           ErrorOr<std::unique_ptr<Binary>> ChildOrErr =
-              AI->getAsBinary(&Context);
+              AI->getAsBinary(&SliceContext);
           if (ChildOrErr.getError())
             continue;
           if (SymbolicFile *O = dyn_cast<SymbolicFile>(&*ChildOrErr.get())) {
             if (PrintFileName) {
               ArchiveName = A->getFileName();
               if (isa<MachOObjectFile>(O) && moreThanOneArch)
-                ArchitectureName = I->getArchTypeName();
+                ArchitectureName = Slice.getArchTypeName();
             } else {
-              outs() << "\n" << A->getFileName();
+              out() << "\n" << A->getFileName();
               if (isa<MachOObjectFile>(O)) {
-                outs() << "(" << O->getFileName() << ")";
+                out() << "(" << O->getFileName() << ")";
                 if (moreThanOneArch)
-                  outs() << " (for architecture " << I->getArchTypeName()
+                  out() << " (for architecture " << Slice.getArchTypeName()
                          << ")";
               } else
-                outs() << ":" << O->getFileName();
-              outs() << ":\n";
+                out() << ":" << O->getFileName();
+              out() << ":\n";
             }
             dumpSymbolNamesFromObject(*O, false, ArchiveName, ArchitectureName);
           }
         }
       }
+    };
+    // The slices are dumped concurrently, each with a context of its own,
+    // unless several input files already are.
+    if (getNumThreads() > 1 && !MultipleFiles && moreThanOneArch) {
+      dumpInParallel(UB->getNumberOfObjects(), [&](unsigned Index) {
+        LLVMContext SliceContext;
+        DumpSlice(Index, SliceContext);
+        return true;
+      });
+      return;
     }
+    for (unsigned Index = 0, E = UB->getNumberOfObjects(); Index != E; ++Index)
+      DumpSlice(Index, Context);
     return;
   }
   if (SymbolicFile *O = dyn_cast<SymbolicFile>(&Bin)) {
@@ -1286,8 +1374,14 @@ int main(int argc, char **argv) {
     error("bad number of arguments (must be two arguments)",
           "for the -s option");
 
-  std::for_each(InputFilenames.begin(), InputFilenames.end(),
-                dumpSymbolNamesFromFile);
+  if (getNumThreads() > 1 && MultipleFiles)
+    dumpInParallel(InputFilenames.size(), [](unsigned I) {
+      dumpSymbolNamesFromFile(InputFilenames[I]);
+      return true;
+    });
+  else
+    std::for_each(InputFilenames.begin(), InputFilenames.end(),
+                  dumpSymbolNamesFromFile);
 
   if (HadError)
     return 1;
@@ -24,7 +24,9 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 
 using namespace llvm;
 
@@ -38,8 +40,58 @@ static void exitWithError(const Twine &Message, StringRef Whence = "") {
 
 enum ProfileKinds { instr, sample };
 
+namespace {
+/// The state of one of the (possibly concurrent) merges of a subset of the
+/// inputs.
+struct WriterContext {
+  InstrProfWriter Writer;
+  /// Per function warnings, buffered so that they are reported in the input
+  /// order whatever the thread scheduling.
+  std::string Warnings;
+  /// The input that couldn't be read, if any, and what went wrong with it.
+  std::string ErrorWhence;
+  std::error_code Error;
+};
+}
+
+/// Merge the inputs \p Inputs into \p WC, stopping at the first input that
+/// can't be read.
+static void loadInputs(ArrayRef<std::string> Inputs, WriterContext &WC) {
+  raw_string_ostream WarningsOS(WC.Warnings);
+  for (const auto &Filename : Inputs) {
+    auto ReaderOrErr = InstrProfReader::create(Filename);
+    if (std::error_code EC = ReaderOrErr.getError()) {
+      WC.Error = EC;
+      WC.ErrorWhence = Filename;
+      return;
+    }
+
+    auto Reader = std::move(ReaderOrErr.get());
+    for (const auto &I : *Reader)
+      if (std::error_code EC =
+              WC.Writer.addFunctionCounts(I.Name, I.Hash, I.Counts,
+                                          I.IndirectCallSites))
+        WarningsOS << Filename << ": " << I.Name << ": " << EC.message()
+                   << "\n";
+    if (Reader->hasError()) {
+      WC.Error = Reader->getError();
+      WC.ErrorWhence = Filename;
+      return;
+    }
+  }
+}
+
+/// Report the warnings and the error, if any, accumulated in \p WC.
+static void reportContextDiagnostics(WriterContext &WC) {
+  errs() << WC.Warnings;
+  WC.Warnings.clear();
+  if (WC.Error)
+    exitWithError(WC.Error.message(), WC.ErrorWhence);
+}
+
 void mergeInstrProfile(const cl::list<std::string> &Inputs,
-                       StringRef OutputFilename) {
+                       StringRef OutputFilename, unsigned NumThreads,
+                       size_t MemoryLimit) {
   if (OutputFilename.compare("-") == 0)
     exitWithError("Cannot write indexed profdata format to stdout.");
 
@@ -48,21 +100,58 @@ void mergeInstrProfile(const cl::list<std::string> &Inputs,
   if (EC)
     exitWithError(EC.message(), OutputFilename);
 
-  InstrProfWriter Writer;
-  for (const auto &Filename : Inputs) {
-    auto ReaderOrErr = InstrProfReader::create(Filename);
-    if (std::error_code ec = ReaderOrErr.getError())
-      exitWithError(ec.message(), Filename);
+  std::vector<std::string> Filenames(Inputs.begin(), Inputs.end());
+
+  // Each thread needs at least a couple of inputs to be worth its writer.
+  if (NumThreads == 0)
+    NumThreads = std::max(1U, std::min(std::thread::hardware_concurrency(),
+                                       unsigned(Filenames.size() + 1) / 2));
+  NumThreads = std::max(1U, std::min(NumThreads, unsigned(Filenames.size())));
+
+  std::vector<std::unique_ptr<WriterContext>> Contexts;
+  for (unsigned I = 0; I < NumThreads; ++I) {
+    Contexts.emplace_back(new WriterContext);
+    // The counts that were spilled can only be checked against each other
+    // when writing the output.
+    if (MemoryLimit)
+      Contexts.back()->Writer.setMemoryLimit(
+          MemoryLimit / NumThreads, [](StringRef Name, std::error_code EC) {
+            errs() << Name << ": " << EC.message() << "\n";
+          });
+  }
 
-    auto Reader = std::move(ReaderOrErr.get());
-    for (const auto &I : *Reader)
-      if (std::error_code EC =
-              Writer.addFunctionCounts(I.Name, I.Hash, I.Counts))
-        errs() << Filename << ": " << I.Name << ": " << EC.message() << "\n";
-    if (Reader->hasError())
-      exitWithError(Reader->getError().message(), Filename);
+  if (NumThreads == 1) {
+    for (const auto &Filename : Filenames) {
+      loadInputs(Filename, *Contexts[0]);
+      reportContextDiagnostics(*Contexts[0]);
+    }
+  } else {
+    // Give each context a contiguous range of the inputs, and reduce the
+    // contexts in order. This way the counts of a function are merged in the
+    // same order as in a sequential merge, and so are the diagnostics.
+    ThreadPool Pool(NumThreads);
+    size_t Begin = 0;
+    for (unsigned I = 0; I < NumThreads; ++I) {
+      size_t End = Filenames.size() * (I + 1) / NumThreads;
+      ArrayRef<std::string> Chunk =
+          makeArrayRef(Filenames).slice(Begin, End - Begin);
+      WriterContext *WC = Contexts[I].get();
+      Pool.async([Chunk, WC] { loadInputs(Chunk, *WC); });
+      Begin = End;
+    }
+    Pool.wait();
+
+    for (auto &WC : Contexts)
+      reportContextDiagnostics(*WC);
+    for (unsigned I = 1; I < NumThreads; ++I)
+      Contexts[0]->Writer.mergeRecordsFromWriter(
+          std::move(Contexts[I]->Writer),
+          [](StringRef Name, std::error_code EC) {
+            errs() << Name << ": " << EC.message() << "\n";
+          });
   }
-  Writer.write(Output);
+  if (std::error_code EC = Contexts[0]->Writer.write(Output))
+    exitWithError(EC.message(), OutputFilename);
 }
 
 void mergeSampleProfile(const cl::list<std::string> &Inputs,
@@ -75,6 +164,9 @@ void mergeSampleProfile(const cl::list<std::string> &Inputs,
 
   auto Writer = std::move(WriterOrErr.get());
   StringMap<FunctionSamples> ProfileMap;
+  // The names of inlined functions refer to the buffers of the readers, so
+  // the readers are kept until the merged profile is written.
+  SmallVector<std::unique_ptr<SampleProfileReader>, 4> Readers;
   for (const auto &Filename : Inputs) {
     auto ReaderOrErr =
         SampleProfileReader::create(Filename, getGlobalContext());
@@ -93,6 +185,7 @@ void mergeSampleProfile(const cl::list<std::string> &Inputs,
       FunctionSamples &Samples = I->second;
       ProfileMap[FName].merge(Samples);
     }
+    Readers.push_back(std::move(Reader));
   }
   Writer->write(ProfileMap);
 }
@@ -116,14 +209,29 @@ int merge_main(int argc, const char *argv[]) {
       cl::init(sampleprof::SPF_Binary),
       cl::values(clEnumValN(sampleprof::SPF_Binary, "binary",
                             "Binary encoding (default)"),
+                 clEnumValN(sampleprof::SPF_Compact, "compact",
+                            "Compact binary encoding with a function index"),
                  clEnumValN(sampleprof::SPF_Text, "text", "Text encoding"),
                  clEnumValN(sampleprof::SPF_GCC, "gcc", "GCC encoding"),
                  clEnumValEnd));
 
+  cl::opt<unsigned> NumThreads(
+      "num-threads", cl::init(0),
+      cl::desc("Number of merge threads to use (default: autodetect, only "
+               "meaningful for instrumentation profiles)"));
+  cl::alias NumThreadsA("j", cl::desc("Alias for --num-threads"),
+                        cl::aliasopt(NumThreads));
+  cl::opt<unsigned> MemoryLimit(
+      "memory-limit", cl::init(0),
+      cl::desc("Approximate amount of memory, in megabytes, to use for the "
+               "merged instrumentation counts before spilling them to "
+               "temporary files (default: no limit)"));
+
   cl::ParseCommandLineOptions(argc, argv, "LLVM profile data merger\n");
 
   if (ProfileKind == instr)
-    mergeInstrProfile(Inputs, OutputFilename);
+    mergeInstrProfile(Inputs, OutputFilename, NumThreads,
+                      size_t(MemoryLimit) << 20);
   else
     mergeSampleProfile(Inputs, OutputFilename, OutputFormat);
 
@@ -171,6 +279,21 @@ int showInstrProfile(std::string Filename, bool ShowCounts,
     }
     if (Show && ShowCounts)
       OS << "]\n";
+
+    if (Show && !Func.IndirectCallSites.empty()) {
+      OS << "    Indirect call sites: " << Func.IndirectCallSites.size()
+         << "\n";
+      if (ShowCounts)
+        for (size_t I = 0, E = Func.IndirectCallSites.size(); I < E; ++I) {
+          OS << "    Site " << I << " targets: [";
+          const InstrProfValueSiteRecord &Site = Func.IndirectCallSites[I];
+          for (size_t V = 0, VE = Site.size(); V < VE; ++V)
+            OS << (V == 0 ? "" : ", ")
+               << format("0x%016" PRIx64, Site[V].Value) << ": "
+               << Site[V].Count;
+          OS << "]\n";
+        }
+    }
   }
   if (Reader->hasError())
     exitWithError(Reader->getError().message(), Filename);
@@ -201,9 +201,19 @@ const char LLVMSymbolizer::kBadString[] = "??";
 
 std::string LLVMSymbolizer::symbolizeCode(const std::string &ModuleName,
                                           uint64_t ModuleOffset) {
-  ModuleInfo *Info = getOrCreateModuleInfo(ModuleName);
-  if (!Info)
+  CachedModule &Module = getOrCreateModule(ModuleName);
+  if (!Module.Info)
     return printDILineInfo(DILineInfo());
+  auto I = Module.CodeResults.find(ModuleOffset);
+  if (I != Module.CodeResults.end())
+    return I->second;
+  std::string Result = symbolizeCode(Module.Info, ModuleOffset);
+  Module.CodeResults.insert(std::make_pair(ModuleOffset, Result));
+  return Result;
+}
+
+std::string LLVMSymbolizer::symbolizeCode(ModuleInfo *Info,
+                                          uint64_t ModuleOffset) {
   if (Opts.PrintInlining) {
     DIInliningInfo InlinedContext =
         Info->symbolizeInlinedCode(ModuleOffset, Opts);
@@ -237,7 +247,10 @@ std::string LLVMSymbolizer::symbolizeData(const std::string &ModuleName,
 }
 
 void LLVMSymbolizer::flush() {
-  DeleteContainerSeconds(Modules);
+  for (auto &I : Modules)
+    delete I.second.Info;
+  Modules.clear();
+  NumParsedModules = 0;
   ObjectPairForPathArch.clear();
   ObjectFileForArch.clear();
 }
@@ -437,11 +450,29 @@ LLVMSymbolizer::getObjectFileFromBinary(Binary *Bin,
   return Res;
 }
 
-ModuleInfo *
-LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
+void LLVMSymbolizer::evictLeastRecentlyUsedModule() {
+  auto LRU = Modules.end();
+  for (auto I = Modules.begin(), E = Modules.end(); I != E; ++I)
+    if (I->second.Info &&
+        (LRU == Modules.end() || I->second.LastUse < LRU->second.LastUse))
+      LRU = I;
+  if (LRU == Modules.end())
+    return;
+  // The object files stay open, so looking the module up again only parses
+  // its symbol table and debug info again.
+  delete LRU->second.Info;
+  Modules.erase(LRU);
+  --NumParsedModules;
+}
+
+LLVMSymbolizer::CachedModule &
+LLVMSymbolizer::getOrCreateModule(const std::string &ModuleName) {
+  ++UseCount;
   const auto &I = Modules.find(ModuleName);
-  if (I != Modules.end())
+  if (I != Modules.end()) {
+    I->second.LastUse = UseCount;
     return I->second;
+  }
   std::string BinaryName = ModuleName;
   std::string ArchName = Opts.DefaultArch;
   size_t ColonPos = ModuleName.find_last_of(':');
@@ -455,16 +486,20 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
   }
   ObjectPair Objects = getOrCreateObjects(BinaryName, ArchName);
 
+  CachedModule &Module = Modules[ModuleName];
+  Module.Info = nullptr;
+  Module.LastUse = UseCount;
   if (!Objects.first) {
     // Failed to find valid object file.
-    Modules.insert(make_pair(ModuleName, (ModuleInfo *)nullptr));
-    return nullptr;
+    return Module;
   }
+  if (Opts.MaxCachedModules && NumParsedModules >= Opts.MaxCachedModules)
+    evictLeastRecentlyUsedModule();
   DIContext *Context = DIContext::getDWARFContext(*Objects.second);
   assert(Context);
-  ModuleInfo *Info = new ModuleInfo(Objects.first, Context);
-  Modules.insert(make_pair(ModuleName, Info));
-  return Info;
+  Module.Info = new ModuleInfo(Objects.first, Context);
+  ++NumParsedModules;
+  return Module;
 }
 
 std::string LLVMSymbolizer::printDILineInfo(DILineInfo LineInfo) const {
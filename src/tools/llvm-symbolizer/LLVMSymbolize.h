@@ -41,16 +41,20 @@ public:
     bool Demangle : 1;
     std::string DefaultArch;
     std::vector<std::string> DsymHints;
+    /// Maximum number of modules whose debug info is kept parsed, or 0 for
+    /// no limit. The least recently used module is dropped first.
+    unsigned MaxCachedModules;
     Options(bool UseSymbolTable = true,
             FunctionNameKind PrintFunctions = FunctionNameKind::LinkageName,
             bool PrintInlining = true, bool Demangle = true,
             std::string DefaultArch = "")
         : UseSymbolTable(UseSymbolTable),
           PrintFunctions(PrintFunctions), PrintInlining(PrintInlining),
-          Demangle(Demangle), DefaultArch(DefaultArch) {}
+          Demangle(Demangle), DefaultArch(DefaultArch), MaxCachedModules(0) {}
   };
 
-  LLVMSymbolizer(const Options &Opts = Options()) : Opts(Opts) {}
+  LLVMSymbolizer(const Options &Opts = Options())
+      : NumParsedModules(0), UseCount(0), Opts(Opts) {}
   ~LLVMSymbolizer() {
     flush();
   }
@@ -66,7 +70,26 @@ public:
 private:
   typedef std::pair<ObjectFile*, ObjectFile*> ObjectPair;
 
-  ModuleInfo *getOrCreateModuleInfo(const std::string &ModuleName);
+  /// \brief A module looked up by name. Info is null if no valid object file
+  /// was found for it.
+  struct CachedModule {
+    ModuleInfo *Info;
+    /// Value of UseCount when the module was last looked up.
+    uint64_t LastUse;
+    /// Results of symbolizeCode for the module, keyed by module offset, as
+    /// crash reports tend to symbolize the same frames over and over.
+    std::map<uint64_t, std::string> CodeResults;
+  };
+
+  /// \brief Returns the cache entry for a module, parsing the module if it is
+  /// not cached yet.
+  CachedModule &getOrCreateModule(const std::string &ModuleName);
+  /// \brief Drops the parsed debug info of the least recently used module.
+  void evictLeastRecentlyUsedModule();
+  ModuleInfo *getOrCreateModuleInfo(const std::string &ModuleName) {
+    return getOrCreateModule(ModuleName).Info;
+  }
+  std::string symbolizeCode(ModuleInfo *Info, uint64_t ModuleOffset);
   ObjectFile *lookUpDsymFile(const std::string &Path, const MachOObjectFile *ExeObj,
                              const std::string &ArchName);
 
@@ -91,7 +114,11 @@ private:
   }
 
   // Owns module info objects.
-  std::map<std::string, ModuleInfo *> Modules;
+  std::map<std::string, CachedModule> Modules;
+  // Number of Modules with a non-null Info.
+  unsigned NumParsedModules;
+  // Number of module lookups so far.
+  uint64_t UseCount;
   std::map<std::pair<MachOUniversalBinary *, std::string>, ObjectFile *>
       ObjectFileForArch;
   std::map<std::pair<std::string, std::string>, ObjectPair>
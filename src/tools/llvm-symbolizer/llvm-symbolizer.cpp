@@ -67,6 +67,11 @@ ClDsymHint("dsym-hint", cl::ZeroOrMore,
            cl::desc("Path to .dSYM bundles to search for debug info for the "
                     "object files"));
 
+static cl::opt<unsigned> ClMaxCachedModules(
+    "max-cached-modules", cl::init(0),
+    cl::desc("Maximum number of modules to keep parsed debug info for "
+             "(0 = no limit)"));
+
 static bool parseCommand(bool &IsData, std::string &ModuleName,
                          uint64_t &ModuleOffset) {
   const char *kDataCmd = "DATA ";
@@ -133,6 +138,7 @@ int main(int argc, char **argv) {
                 "\" (must have the '.dSYM' extension).\n";
     }
   }
+  Opts.MaxCachedModules = ClMaxCachedModules;
   LLVMSymbolizer Symbolizer(Opts);
 
   bool IsData = false;
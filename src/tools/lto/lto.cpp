@@ -335,6 +335,61 @@ bool lto_codegen_compile_to_file(lto_code_gen_t cg, const char **name) {
       DisableLTOVectorization, sLastErrorString);
 }
 
+void lto_codegen_set_parallelism(lto_code_gen_t cg, unsigned int parallelism) {
+  unwrap(cg)->setParallelism(parallelism);
+}
+
+bool lto_codegen_compile_to_files(lto_code_gen_t cg, const char ***names,
+                                  unsigned int *count) {
+  if (!parsedOptions) {
+    unwrap(cg)->parseCodeGenDebugOptions();
+    lto_add_attrs(cg);
+    parsedOptions = true;
+  }
+  ArrayRef<const char *> Names;
+  if (!unwrap(cg)->compile_to_files(Names, DisableOpt, DisableInline,
+                                    DisableGVNLoadPRE, DisableLTOVectorization,
+                                    sLastErrorString))
+    return true;
+  *names = const_cast<const char **>(Names.data());
+  *count = Names.size();
+  return false;
+}
+
+bool lto_codegen_compile_optimized_to_files(lto_code_gen_t cg,
+                                            const char ***names,
+                                            unsigned int *count) {
+  if (!parsedOptions) {
+    unwrap(cg)->parseCodeGenDebugOptions();
+    lto_add_attrs(cg);
+    parsedOptions = true;
+  }
+  ArrayRef<const char *> Names;
+  if (!unwrap(cg)->compileOptimizedToFiles(Names, sLastErrorString))
+    return true;
+  *names = const_cast<const char **>(Names.data());
+  *count = Names.size();
+  return false;
+}
+
+void lto_codegen_set_cache_dir(lto_code_gen_t cg, const char *cache_dir) {
+  unwrap(cg)->setCacheDir(cache_dir);
+}
+
+void lto_codegen_set_cache_pruning_interval(lto_code_gen_t cg, int interval) {
+  unwrap(cg)->setCachePruningInterval(interval);
+}
+
+void lto_codegen_set_cache_entry_expiration(lto_code_gen_t cg,
+                                            unsigned int expiration) {
+  unwrap(cg)->setCacheEntryExpiration(expiration);
+}
+
+void lto_codegen_set_max_cache_size(lto_code_gen_t cg,
+                                    unsigned long long size) {
+  unwrap(cg)->setMaxCacheSize(size);
+}
+
 bool lto_codegen_hide_symbols(lto_code_gen_t cg) {
   return unwrap(cg)->hideSymbols();
 }
@@ -48,6 +48,7 @@
 #include "llvm/Support/SystemUtils.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
@@ -185,11 +186,49 @@ static cl::opt<bool> PreserveBitcodeUseListOrder(
     cl::desc("Preserve use-list order when writing LLVM bitcode."),
     cl::init(true), cl::Hidden);
 
+static cl::opt<bool> EmitFunctionSummary(
+    "function-summary",
+    cl::desc("Emit function summaries for thin LTO in the output bitcode."));
+
 static cl::opt<bool> PreserveAssemblyUseListOrder(
     "preserve-ll-uselistorder",
     cl::desc("Preserve use-list order when writing LLVM assembly."),
     cl::init(false), cl::Hidden);
 
+static cl::opt<std::string>
+TimeTraceFile("time-trace-file", cl::value_desc("filename"),
+              cl::desc("Record where the time goes and write it to "
+                       "<filename>"));
+
+static cl::opt<unsigned>
+TimeTraceGranularity("time-trace-granularity", cl::init(500),
+                     cl::value_desc("us"),
+                     cl::desc("Leave the scopes shorter than this many "
+                              "microseconds out of the time trace"));
+
+enum TimeTraceFormatKind { ChromeTrace, FoldedStacks };
+static cl::opt<TimeTraceFormatKind>
+TimeTraceFormat("time-trace-format", cl::init(ChromeTrace),
+                cl::desc("The format of the time trace"),
+                cl::values(clEnumValN(ChromeTrace, "chrome",
+                                      "A Chrome trace (the default)"),
+                           clEnumValN(FoldedStacks, "folded",
+                                      "Folded stacks for flame graphs"),
+                           clEnumValEnd));
+
+/// Write the time trace recorded for -time-trace-file and stop recording it.
+static void writeTimeTrace(const char *ProgName) {
+  std::error_code EC;
+  raw_fd_ostream OS(TimeTraceFile, EC, sys::fs::F_Text);
+  if (EC)
+    errs() << ProgName << ": " << TimeTraceFile << ": " << EC.message() << '\n';
+  else if (TimeTraceFormat == FoldedStacks)
+    timeTraceProfilerWriteFolded(OS);
+  else
+    timeTraceProfilerWrite(OS);
+  timeTraceProfilerCleanup();
+}
+
 static inline void addPass(PassManagerBase &PM, Pass *P) {
   // Add the pass to the pass manager...
   PM.add(P);
@@ -330,6 +369,9 @@ int main(int argc, char **argv) {
   cl::ParseCommandLineOptions(argc, argv,
     "llvm .bc -> .bc modular optimizer and analysis printer\n");
 
+  if (!TimeTraceFile.empty())
+    timeTraceProfilerInitialize(TimeTraceGranularity, "opt");
+
   if (AnalyzeOnly && NoOutput) {
     errs() << argv[0] << ": analyze mode conflicts with no-output mode.\n";
     return 1;
@@ -584,7 +626,8 @@ int main(int argc, char **argv) {
           createPrintModulePass(Out->os(), "", PreserveAssemblyUseListOrder));
     else
       Passes.add(
-          createBitcodeWriterPass(Out->os(), PreserveBitcodeUseListOrder));
+          createBitcodeWriterPass(Out->os(), PreserveBitcodeUseListOrder,
+                                  EmitFunctionSummary));
   }
 
   // Before executing passes, print the final values of the LLVM options.
@@ -593,6 +636,9 @@ int main(int argc, char **argv) {
   // Now that we have all of the passes ready, run them.
   Passes.run(*M);
 
+  if (!TimeTraceFile.empty())
+    writeTimeTrace(argv[0]);
+
   // Declare success.
   if (!NoOutput || PrintBreakpoints)
     Out->keep();
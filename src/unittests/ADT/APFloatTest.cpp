@@ -2876,4 +2876,75 @@ TEST(APFloatTest, scalbn) {
   EXPECT_TRUE(PZero.bitwiseIsEqual(
       scalbn(APFloat(APFloat::IEEEsingle, "0x1p-126"), -1)));
 }
+
+TEST(APFloatTest, exactness) {
+  const APFloat::roundingMode rdmd = APFloat::rmNearestTiesToEven;
+  APFloat::opStatus Status;
+
+  // Single and double values of moderate magnitude, exact or not.
+  APFloat D(0.1);
+  Status = D.add(APFloat(0.2), rdmd);
+  EXPECT_EQ(APFloat::opInexact, Status);
+  EXPECT_EQ(0.30000000000000004, D.convertToDouble());
+
+  D = APFloat(1.5);
+  Status = D.multiply(APFloat(-2.0), rdmd);
+  EXPECT_EQ(APFloat::opOK, Status);
+  EXPECT_EQ(-3.0, D.convertToDouble());
+
+  D = APFloat(APFloat::IEEEdouble, "0x1.0000000000001p+52");
+  Status = D.multiply(D, rdmd);
+  EXPECT_EQ(APFloat::opInexact, Status);
+  EXPECT_TRUE(D.bitwiseIsEqual(
+      APFloat(APFloat::IEEEdouble, "0x1.0000000000002p+104")));
+
+  D = APFloat(1.0);
+  Status = D.divide(APFloat(3.0), rdmd);
+  EXPECT_EQ(APFloat::opInexact, Status);
+  EXPECT_EQ(1.0 / 3.0, D.convertToDouble());
+
+  D = APFloat(APFloat::IEEEdouble, "0x1.8p-200");
+  Status = D.divide(APFloat(APFloat::IEEEdouble, "0x1p+100"), rdmd);
+  EXPECT_EQ(APFloat::opOK, Status);
+  EXPECT_TRUE(D.bitwiseIsEqual(APFloat(APFloat::IEEEdouble, "0x1.8p-300")));
+
+  APFloat F(16777216.0f);
+  Status = F.add(APFloat(1.0f), rdmd);
+  EXPECT_EQ(APFloat::opInexact, Status);
+  EXPECT_EQ(16777216.0f, F.convertToFloat());
+
+  F = APFloat(4097.0f);
+  Status = F.multiply(APFloat(4097.0f), rdmd);
+  EXPECT_EQ(APFloat::opInexact, Status);
+  EXPECT_EQ(16785408.0f, F.convertToFloat());
+
+  F = APFloat(7.5f);
+  Status = F.divide(APFloat(2.5f), rdmd);
+  EXPECT_EQ(APFloat::opOK, Status);
+  EXPECT_EQ(3.0f, F.convertToFloat());
+
+  // Exact cancellation gives a positive zero.
+  F = APFloat(2.5f);
+  Status = F.subtract(APFloat(2.5f), rdmd);
+  EXPECT_EQ(APFloat::opOK, Status);
+  EXPECT_TRUE(F.isPosZero());
+
+  // Results that overflow or are denormal.
+  D = APFloat(APFloat::IEEEdouble, "0x1p+600");
+  Status = D.multiply(D, rdmd);
+  EXPECT_EQ(APFloat::opOverflow | APFloat::opInexact, Status);
+  EXPECT_TRUE(D.isInfinity());
+
+  F = APFloat(APFloat::IEEEsingle, "0x1.000002p-70");
+  Status = F.multiply(F, rdmd);
+  EXPECT_EQ(APFloat::opUnderflow | APFloat::opInexact, Status);
+  EXPECT_TRUE(F.isDenormal());
+
+  // Other rounding modes.
+  D = APFloat(1.0);
+  Status = D.divide(APFloat(3.0), APFloat::rmTowardPositive);
+  EXPECT_EQ(APFloat::opInexact, Status);
+  EXPECT_TRUE(D.bitwiseIsEqual(
+      APFloat(APFloat::IEEEdouble, "0x1.5555555555556p-2")));
+}
 }
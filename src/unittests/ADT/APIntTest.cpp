@@ -803,4 +803,52 @@ TEST(APIntTest, SelfMoveAssignment) {
 #pragma clang diagnostic pop
 #pragma clang diagnostic pop
 #endif
+
+TEST(APIntTest, InlineStorage) {
+  // Values of up to two words live in the object, wider ones are allocated.
+  APInt Small(64, 7);
+  APInt Inline(128, 7);
+  APInt Wide(192, 7);
+  EXPECT_FALSE(Small.needsCleanup());
+  EXPECT_FALSE(Inline.needsCleanup());
+  EXPECT_TRUE(Wide.needsCleanup());
+
+  // Moves and copies between the three kinds keep the value.
+  uint64_t Bits[] = {0x0123456789abcdefULL, 0xfedcba9876543210ULL};
+  APInt X(128, Bits);
+  APInt Y = X;
+  EXPECT_EQ(X, Y);
+  APInt Z = std::move(Y);
+  EXPECT_EQ(X, Z);
+  Z = Wide;
+  EXPECT_EQ(192u, Z.getBitWidth());
+  EXPECT_EQ(7u, Z.getZExtValue());
+  Z = X;
+  EXPECT_EQ(X, Z);
+  Z = Small;
+  EXPECT_EQ(Small, Z);
+  Z = X;
+  EXPECT_EQ(Bits[1], Z.getRawData()[1]);
+  Z = std::move(Wide);
+  EXPECT_EQ(192u, Z.getBitWidth());
+  Z = std::move(X);
+  EXPECT_EQ(Bits[0], Z.getRawData()[0]);
+  EXPECT_EQ(Bits[1], Z.getRawData()[1]);
+
+  // Extensions and truncations cross between them.
+  APInt I96 = Z.trunc(96);
+  EXPECT_EQ(Bits[1] & 0xffffffffULL, I96.getRawData()[1]);
+  APInt I256 = I96.sext(256);
+  EXPECT_EQ(I96.sext(128).zext(256), I256);
+  EXPECT_EQ(I96, I256.trunc(96));
+  EXPECT_EQ(APInt(128, -1ULL, true), APInt(256, -1ULL, true).trunc(128));
+
+  // Division results change width between them.
+  APInt Q(64, 0), R(256, 0);
+  APInt::udivrem(APInt(128, Bits), APInt(128, 0x10000), Q, R);
+  EXPECT_EQ(128u, Q.getBitWidth());
+  EXPECT_EQ(128u, R.getBitWidth());
+  EXPECT_EQ(0xcdefu, R.getZExtValue());
+  EXPECT_EQ(APInt(128, Bits), Q * APInt(128, 0x10000) + R);
+}
 }
@@ -36,6 +36,21 @@ public:
   unsigned getNumTests() const { return NumTests; }
 };
 
+class ParallelDAGDeltaAlgorithm : public DAGDeltaAlgorithm {
+  changeset_ty FailingSet;
+
+protected:
+  bool ExecuteOneTest(const changeset_ty &Changes) override {
+    return std::includes(Changes.begin(), Changes.end(),
+                         FailingSet.begin(), FailingSet.end());
+  }
+
+public:
+  ParallelDAGDeltaAlgorithm(const changeset_ty &FailingSet,
+                            unsigned NumThreads)
+    : DAGDeltaAlgorithm(NumThreads), FailingSet(FailingSet) {}
+};
+
 std::set<unsigned> fixed_set(unsigned N, ...) {
   std::set<unsigned> S;
   va_list ap;
@@ -101,5 +116,21 @@ TEST(DAGDeltaAlgorithmTest, Basic) {
   EXPECT_GE(6U, FDA3.getNumTests());
 }
 
+TEST(DAGDeltaAlgorithmTest, Parallel) {
+  std::vector<edge_ty> Deps;
+  Deps.push_back(std::make_pair(1, 0));
+  Deps.push_back(std::make_pair(2, 0));
+  Deps.push_back(std::make_pair(4, 0));
+  Deps.push_back(std::make_pair(3, 2));
+
+  ParallelDAGDeltaAlgorithm PDA(fixed_set(2, 1, 3), 4);
+  EXPECT_EQ(fixed_set(4, 0, 1, 2, 3), PDA.Run(range(5), Deps));
+
+  Deps.clear();
+  Deps.push_back(std::make_pair(3, 1));
+  ParallelDAGDeltaAlgorithm PDA2(fixed_set(3, 3, 5, 7), 4);
+  EXPECT_EQ(fixed_set(4, 1, 3, 5, 7), PDA2.Run(range(20), Deps));
+}
+
 }
 
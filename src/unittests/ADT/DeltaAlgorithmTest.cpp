@@ -10,6 +10,7 @@
 #include "gtest/gtest.h"
 #include "llvm/ADT/DeltaAlgorithm.h"
 #include <algorithm>
+#include <atomic>
 #include <cstdarg>
 using namespace llvm;
 
@@ -51,6 +52,24 @@ public:
   unsigned getNumTests() const { return NumTests; }
 };
 
+class ParallelDeltaAlgorithm : public DeltaAlgorithm {
+  changeset_ty FailingSet;
+  std::atomic<unsigned> NumTests;
+
+protected:
+  bool ExecuteOneTest(const changeset_ty &Changes) override {
+    ++NumTests;
+    return std::includes(Changes.begin(), Changes.end(),
+                         FailingSet.begin(), FailingSet.end());
+  }
+
+public:
+  ParallelDeltaAlgorithm(const changeset_ty &FailingSet, unsigned NumThreads)
+    : DeltaAlgorithm(NumThreads), FailingSet(FailingSet), NumTests(0) {}
+
+  unsigned getNumTests() const { return NumTests; }
+};
+
 std::set<unsigned> fixed_set(unsigned N, ...) {
   std::set<unsigned> S;
   va_list ap;
@@ -96,5 +115,21 @@ TEST(DeltaAlgorithmTest, Basic) {
   EXPECT_EQ(11U, FDA.getNumTests());  
 }
 
+TEST(DeltaAlgorithmTest, Parallel) {
+  // Tests running concurrently find the same minimal sets, running some
+  // tests speculatively.
+  std::set<unsigned> Fails = fixed_set(3, 3, 5, 7);
+  FixedDeltaAlgorithm FDA(Fails);
+  ParallelDeltaAlgorithm PDA(Fails, 4);
+  EXPECT_EQ(FDA.Run(range(20)), PDA.Run(range(20)));
+  EXPECT_LE(FDA.getNumTests(), PDA.getNumTests());
+
+  ParallelDeltaAlgorithm PDA2(fixed_set(2, 0, 63), 3);
+  EXPECT_EQ(fixed_set(2, 0, 63), PDA2.Run(range(64)));
+
+  ParallelDeltaAlgorithm PDA3(range(10), 4);
+  EXPECT_EQ(range(4), PDA3.Run(range(4)));
+}
+
 }
 
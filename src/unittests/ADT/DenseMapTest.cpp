@@ -9,6 +9,7 @@
 
 #include "gtest/gtest.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/GroupedDenseMap.h"
 #include <map>
 #include <set>
 
@@ -103,7 +104,11 @@ typedef ::testing::Types<DenseMap<uint32_t, uint32_t>,
                          SmallDenseMap<uint32_t, uint32_t>,
                          SmallDenseMap<uint32_t *, uint32_t *>,
                          SmallDenseMap<CtorTester, CtorTester, 4,
-                                       CtorTesterMapInfo>
+                                       CtorTesterMapInfo>,
+                         GroupedDenseMap<uint32_t, uint32_t>,
+                         GroupedDenseMap<uint32_t *, uint32_t *>,
+                         GroupedDenseMap<CtorTester, CtorTester,
+                                         CtorTesterMapInfo>
                          > DenseMapTestTypes;
 TYPED_TEST_CASE(DenseMapTest, DenseMapTestTypes);
 
@@ -396,4 +401,88 @@ TEST(DenseMapCustomTest, SmallDenseMapGrowTest) {
   EXPECT_TRUE(map.find(32) == map.end());
 }
 
+TEST(GroupedDenseMapTest, FindAsTest) {
+  GroupedDenseMap<unsigned, unsigned, TestDenseMapInfo> map;
+  map[0] = 1;
+  map[1] = 2;
+  map[2] = 3;
+
+  EXPECT_EQ(3u, map.size());
+  EXPECT_EQ(1u, map.find_as("a")->second);
+  EXPECT_EQ(2u, map.find_as("b")->second);
+  EXPECT_EQ(3u, map.find_as("c")->second);
+  EXPECT_TRUE(map.find_as("d") == map.end());
+}
+
+// GroupedDenseMap doesn't reserve the empty and tombstone keys.
+TEST(GroupedDenseMapTest, SentinelKeysTest) {
+  GroupedDenseMap<unsigned, unsigned> map;
+  unsigned EmptyKey = DenseMapInfo<unsigned>::getEmptyKey();
+  unsigned TombstoneKey = DenseMapInfo<unsigned>::getTombstoneKey();
+  map[EmptyKey] = 1;
+  map[TombstoneKey] = 2;
+
+  EXPECT_EQ(2u, map.size());
+  EXPECT_EQ(1u, map.lookup(EmptyKey));
+  EXPECT_EQ(2u, map.lookup(TombstoneKey));
+  EXPECT_TRUE(map.erase(EmptyKey));
+  EXPECT_EQ(0u, map.count(EmptyKey));
+  EXPECT_EQ(1u, map.count(TombstoneKey));
+}
+
+struct CollidingDenseMapInfo {
+  static inline unsigned getEmptyKey() { return ~0; }
+  static inline unsigned getTombstoneKey() { return ~0U - 1; }
+  static unsigned getHashValue(const unsigned& Val) { return Val % 3; }
+  static bool isEqual(const unsigned& LHS, const unsigned& RHS) {
+    return LHS == RHS;
+  }
+};
+
+// Keys sharing hashes fill whole groups, which lookups must probe past, and
+// erasing from full groups must keep the other keys reachable.
+TEST(GroupedDenseMapTest, CollisionTest) {
+  GroupedDenseMap<unsigned, unsigned, CollidingDenseMapInfo> map;
+  for (unsigned i = 0; i < 300; ++i)
+    map[i] = i + 1;
+  for (unsigned i = 0; i < 300; i += 2)
+    EXPECT_TRUE(map.erase(i));
+  EXPECT_EQ(150u, map.size());
+  for (unsigned i = 0; i < 300; ++i)
+    EXPECT_EQ(i % 2 ? i + 1 : 0u, map.lookup(i)) << "key " << i;
+  for (unsigned i = 300; i < 400; ++i)
+    map[i] = i + 1;
+  EXPECT_EQ(250u, map.size());
+  for (unsigned i = 0; i < 400; ++i)
+    EXPECT_EQ(i % 2 || i >= 300 ? i + 1 : 0u, map.lookup(i)) << "key " << i;
+}
+
+// Random insertions and erasures, checked against std::map.
+TEST(GroupedDenseMapTest, RandomOperationsTest) {
+  GroupedDenseMap<unsigned, unsigned> map;
+  std::map<unsigned, unsigned> reference;
+  unsigned Seed = 1;
+  for (unsigned i = 0; i < 20000; ++i) {
+    Seed = Seed * 1103515245 + 12345;
+    unsigned Key = (Seed >> 8) % 1000;
+    if ((Seed >> 4) % 3 == 0) {
+      EXPECT_EQ(reference.erase(Key), map.erase(Key) ? 1u : 0u);
+    } else {
+      map[Key] = i;
+      reference[Key] = i;
+    }
+    ASSERT_EQ(reference.size(), map.size());
+  }
+  unsigned Visited = 0;
+  for (const auto &KV : map) {
+    EXPECT_EQ(reference[KV.first], KV.second);
+    ++Visited;
+  }
+  EXPECT_EQ(reference.size(), Visited);
+
+  GroupedDenseMap<unsigned, unsigned> copy(map);
+  for (const auto &KV : reference)
+    EXPECT_EQ(KV.second, copy.lookup(KV.first));
+}
+
 }
@@ -0,0 +1,68 @@
+//===- llvm/unittest/ADT/StatisticTest.cpp - Statistic unit tests ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+using namespace llvm;
+
+#define DEBUG_TYPE "unittest"
+STATISTIC(Counter, "Counts things");
+STATISTIC(Counter2, "Counts other \"things\"");
+
+namespace {
+
+std::string printJSON() {
+  std::string Str;
+  raw_string_ostream OS(Str);
+  PrintStatisticsJSON(OS);
+  return OS.str();
+}
+
+TEST(StatisticTest, Count) {
+  EnableStatistics(/*PrintOnExit=*/false);
+
+  Counter = 0;
+  EXPECT_EQ(Counter, 0u);
+  Counter++;
+  Counter++;
+#if defined(LLVM_ENABLE_STATS)
+  EXPECT_EQ(Counter, 2u);
+#else
+  EXPECT_EQ(Counter, 0u);
+#endif
+
+  Counter2 += 5;
+  Counter2 *= 3;
+  --Counter2;
+#if defined(LLVM_ENABLE_STATS)
+  EXPECT_EQ(Counter2, 14u);
+  EXPECT_EQ("{\n"
+            "  \"unittest.Counter\": 2,\n"
+            "  \"unittest.Counter2\": 14\n"
+            "}\n",
+            printJSON());
+#endif
+
+  ResetStatistics();
+  EXPECT_EQ(Counter, 0u);
+  EXPECT_EQ(Counter2, 0u);
+  EXPECT_EQ("{}\n", printJSON());
+
+  // Statistics bumped after a reset are reported again.
+  ++Counter;
+#if defined(LLVM_ENABLE_STATS)
+  EXPECT_EQ("{\n"
+            "  \"unittest.Counter\": 1\n"
+            "}\n",
+            printJSON());
+#endif
+}
+
+} // end anonymous namespace
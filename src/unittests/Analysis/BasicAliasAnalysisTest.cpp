@@ -0,0 +1,135 @@
+//===- BasicAliasAnalysisTest.cpp - BasicAliasAnalysis unit tests ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/Passes.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/PassManager.h"
+#include "gtest/gtest.h"
+
+namespace llvm {
+namespace {
+
+// Hands the alias analysis of each function to a callback.
+struct AATestPass : public FunctionPass {
+  static char ID;
+  std::function<void(Function &, AliasAnalysis &)> Test;
+
+  explicit AATestPass(std::function<void(Function &, AliasAnalysis &)> Test)
+      : FunctionPass(ID), Test(Test) {}
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<AliasAnalysis>();
+    AU.setPreservesAll();
+  }
+
+  bool runOnFunction(Function &F) override {
+    Test(F, getAnalysis<AliasAnalysis>());
+    return false;
+  }
+};
+
+char AATestPass::ID = 0;
+
+class BasicAliasAnalysisTest : public testing::Test {
+protected:
+  BasicAliasAnalysisTest() : M("BasicAliasAnalysisTest", C) {}
+
+  // Builds a function with chains of geps into one array, with constant and
+  // variable indices, and returns the pointers.
+  Function *buildGEPs(SmallVectorImpl<Value *> &Pointers) {
+    Type *I32 = Type::getInt32Ty(C);
+    Type *ArrayTy = ArrayType::get(I32, 64);
+    Type *Params[] = {I32, I32};
+    FunctionType *FTy = FunctionType::get(Type::getVoidTy(C), Params, false);
+    Function *F = Function::Create(FTy, Function::ExternalLinkage, "f", &M);
+    BasicBlock *BB = BasicBlock::Create(C, "entry", F);
+    IRBuilder<> B(BB);
+    Value *Array = B.CreateAlloca(ArrayTy);
+    Value *Zero = B.getInt32(0);
+    auto AI = F->arg_begin();
+    Value *N = AI++;
+    Value *Other = B.CreateAlloca(I32);
+    Pointers.push_back(Other);
+    for (unsigned I = 0; I != 16; ++I) {
+      Value *Index = I % 2 ? B.CreateAdd(N, B.getInt32(I)) : B.getInt32(I);
+      Value *Indices[] = {Zero, Index};
+      Value *Elt = B.CreateInBoundsGEP(Array, Indices);
+      Pointers.push_back(Elt);
+      Pointers.push_back(B.CreateInBoundsGEP(Elt, B.getInt32(1)));
+    }
+    B.CreateRetVoid();
+    return F;
+  }
+
+  void run(std::function<void(Function &, AliasAnalysis &)> Test) {
+    PM.add(createBasicAliasAnalysisPass());
+    PM.add(new AATestPass(Test));
+    PM.run(M);
+  }
+
+  LLVMContext C;
+  Module M;
+  PassManager PM;
+};
+
+TEST_F(BasicAliasAnalysisTest, BatchQueriesMatch) {
+  SmallVector<Value *, 64> Pointers;
+  buildGEPs(Pointers);
+  run([&](Function &, AliasAnalysis &AA) {
+    std::vector<AliasAnalysis::AliasResult> Single;
+    for (Value *P1 : Pointers)
+      for (Value *P2 : Pointers)
+        Single.push_back(AA.alias(P1, 4, P2, 4));
+
+    std::vector<AliasAnalysis::AliasResult> Batched;
+    {
+      AliasAnalysis::BatchQueryScope Batch(AA);
+      for (Value *P1 : Pointers)
+        for (Value *P2 : Pointers)
+          Batched.push_back(AA.alias(P1, 4, P2, 4));
+    }
+    EXPECT_EQ(Single, Batched);
+    EXPECT_EQ(AliasAnalysis::NoAlias,
+              AA.alias(Pointers[0], 4, Pointers[1], 4));
+    EXPECT_EQ(AliasAnalysis::MustAlias,
+              AA.alias(Pointers[1], 4, Pointers[1], 4));
+  });
+}
+
+TEST_F(BasicAliasAnalysisTest, DeleteValueInBatch) {
+  SmallVector<Value *, 64> Pointers;
+  Function *F = buildGEPs(Pointers);
+  run([&](Function &, AliasAnalysis &AA) {
+    AliasAnalysis::BatchQueryScope Batch(AA);
+    auto *GEP = cast<GetElementPtrInst>(Pointers[1]);
+    Value *Zero = GEP->getOperand(1);
+    Value *Array = GEP->getPointerOperand();
+    Instruction *InsertPt = F->getEntryBlock().getTerminator();
+    Value *OldIndices[] = {Zero, ConstantInt::get(Zero->getType(), 5)};
+    auto *Old =
+        GetElementPtrInst::CreateInBounds(Array, OldIndices, "", InsertPt);
+    EXPECT_EQ(AliasAnalysis::NoAlias, AA.alias(Old, 4, GEP, 4));
+
+    // The new gep may reuse the memory of the old one.
+    AA.deleteValue(Old);
+    Old->eraseFromParent();
+    Value *NewIndices[] = {Zero, Zero};
+    auto *New =
+        GetElementPtrInst::CreateInBounds(Array, NewIndices, "", InsertPt);
+    EXPECT_EQ(AliasAnalysis::MustAlias, AA.alias(New, 4, GEP, 4));
+  });
+}
+
+} // end anonymous namespace
+} // end llvm namespace
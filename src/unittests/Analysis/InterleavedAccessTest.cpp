@@ -0,0 +1,183 @@
+//===- InterleavedAccessTest.cpp - Interleaved access group unit tests ----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/LoopAccessAnalysis.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/PassManager.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/SourceMgr.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+std::unique_ptr<Module> parseAssembly(LLVMContext &C, const char *Assembly) {
+  SMDiagnostic Error;
+  std::unique_ptr<Module> M = parseAssemblyString(Assembly, Error, C);
+
+  std::string ErrMsg;
+  raw_string_ostream OS(ErrMsg);
+  Error.print("", OS);
+
+  // A failure here means that the test itself is buggy.
+  if (!M)
+    report_fatal_error(OS.str().c_str());
+
+  return M;
+}
+
+// Analyzes the interleaved accesses of the outermost loop of each function
+// and hands the result to a callback.
+struct InterleaveTestPass : public FunctionPass {
+  static char ID;
+  std::function<void(Function &, InterleavedAccessInfo &)> Test;
+
+  explicit InterleaveTestPass(
+      std::function<void(Function &, InterleavedAccessInfo &)> Test)
+      : FunctionPass(ID), Test(Test) {}
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<DominatorTreeWrapperPass>();
+    AU.addRequired<LoopInfoWrapperPass>();
+    AU.addRequired<ScalarEvolution>();
+    AU.setPreservesAll();
+  }
+
+  bool runOnFunction(Function &F) override {
+    LoopInfo &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+    InterleavedAccessInfo IAI(
+        &getAnalysis<ScalarEvolution>(), *LI.begin(),
+        &getAnalysis<DominatorTreeWrapperPass>().getDomTree());
+    IAI.analyzeInterleaving(ValueToValueMap());
+    Test(F, IAI);
+    return false;
+  }
+};
+
+char InterleaveTestPass::ID = 0;
+
+void runInterleaveTest(
+    const char *Assembly,
+    std::function<void(Function &, InterleavedAccessInfo &)> Test) {
+  initializeAnalysis(*PassRegistry::getPassRegistry());
+  LLVMContext C;
+  std::unique_ptr<Module> M = parseAssembly(C, Assembly);
+  PassManager PM;
+  PM.add(new InterleaveTestPass(Test));
+  PM.run(*M);
+}
+
+Instruction *getInstruction(Function &F, StringRef Name) {
+  for (BasicBlock &BB : F)
+    for (Instruction &I : BB)
+      if (I.getName() == Name)
+        return &I;
+  return nullptr;
+}
+
+Instruction *getStoreTo(Function &F, StringRef Name) {
+  Instruction *Ptr = getInstruction(F, Name);
+  for (User *U : Ptr->users())
+    if (isa<StoreInst>(U))
+      return cast<Instruction>(U);
+  return nullptr;
+}
+
+TEST(InterleavedAccessTest, LoadGroup) {
+  const char *IR =
+      "define void @f(i32* noalias %a, i32* noalias %b) {\n"
+      "entry:\n"
+      "  br label %loop\n"
+      "loop:\n"
+      "  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]\n"
+      "  %i2 = phi i64 [ 0, %entry ], [ %i2.next, %loop ]\n"
+      "  %i2.1 = add nsw i64 %i2, 1\n"
+      "  %p1 = getelementptr inbounds i32* %a, i64 %i2.1\n"
+      "  %v1 = load i32* %p1\n"
+      "  %p0 = getelementptr inbounds i32* %a, i64 %i2\n"
+      "  %v0 = load i32* %p0\n"
+      "  %sum = add i32 %v0, %v1\n"
+      "  %q = getelementptr inbounds i32* %b, i64 %i\n"
+      "  store i32 %sum, i32* %q\n"
+      "  %i.next = add nuw nsw i64 %i, 1\n"
+      "  %i2.next = add nuw nsw i64 %i2, 2\n"
+      "  %done = icmp eq i64 %i.next, 1024\n"
+      "  br i1 %done, label %exit, label %loop\n"
+      "exit:\n"
+      "  ret void\n"
+      "}\n";
+  bool Ran = false;
+  runInterleaveTest(IR, [&](Function &F, InterleavedAccessInfo &IAI) {
+    Ran = true;
+    Instruction *V0 = getInstruction(F, "v0");
+    Instruction *V1 = getInstruction(F, "v1");
+    InterleaveGroup *Group = IAI.getInterleaveGroup(V0);
+    ASSERT_TRUE(Group != nullptr);
+    EXPECT_EQ(Group, IAI.getInterleaveGroup(V1));
+    EXPECT_EQ(2u, Group->getFactor());
+    EXPECT_FALSE(Group->isReverse());
+    EXPECT_EQ(V0, Group->getMember(0));
+    EXPECT_EQ(V1, Group->getMember(1));
+    EXPECT_EQ(0u, Group->getIndex(V0));
+    EXPECT_EQ(1u, Group->getIndex(V1));
+
+    // The group is loaded at the first load in program order.
+    EXPECT_EQ(V1, Group->getInsertPos());
+    EXPECT_FALSE(IAI.isInterleaved(getStoreTo(F, "q")));
+  });
+  EXPECT_TRUE(Ran);
+}
+
+TEST(InterleavedAccessTest, ReleasedGroups) {
+  // The store group has a load in between its members, and the load of a[3*i]
+  // would need a wide load past the last element read.
+  const char *IR =
+      "define void @f(i32* noalias %a, i32* noalias %b, i32* noalias %c) {\n"
+      "entry:\n"
+      "  br label %loop\n"
+      "loop:\n"
+      "  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]\n"
+      "  %i2 = phi i64 [ 0, %entry ], [ %i2.next, %loop ]\n"
+      "  %i3 = phi i64 [ 0, %entry ], [ %i3.next, %loop ]\n"
+      "  %i2.1 = add nsw i64 %i2, 1\n"
+      "  %p0 = getelementptr inbounds i32* %a, i64 %i2\n"
+      "  store i32 0, i32* %p0\n"
+      "  %q = getelementptr inbounds i32* %b, i64 %i\n"
+      "  %v = load i32* %q\n"
+      "  %p1 = getelementptr inbounds i32* %a, i64 %i2.1\n"
+      "  store i32 %v, i32* %p1\n"
+      "  %r = getelementptr inbounds i32* %c, i64 %i3\n"
+      "  %w = load i32* %r\n"
+      "  %i.next = add nuw nsw i64 %i, 1\n"
+      "  %i2.next = add nuw nsw i64 %i2, 2\n"
+      "  %i3.next = add nuw nsw i64 %i3, 3\n"
+      "  %done = icmp eq i64 %i.next, 1024\n"
+      "  br i1 %done, label %exit, label %loop\n"
+      "exit:\n"
+      "  ret void\n"
+      "}\n";
+  bool Ran = false;
+  runInterleaveTest(IR, [&](Function &F, InterleavedAccessInfo &IAI) {
+    Ran = true;
+    EXPECT_FALSE(IAI.isInterleaved(getStoreTo(F, "p0")));
+    EXPECT_FALSE(IAI.isInterleaved(getStoreTo(F, "p1")));
+    EXPECT_FALSE(IAI.isInterleaved(getInstruction(F, "w")));
+  });
+  EXPECT_TRUE(Ran);
+}
+
+} // end anonymous namespace
@@ -0,0 +1,157 @@
+//===- MemorySSA.cpp - Unit tests for MemorySSA ---------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/MemorySSA.h"
+#include "llvm/Analysis/Passes.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/PassManager.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/SourceMgr.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+std::unique_ptr<Module> parseAssembly(LLVMContext &C, const char *Assembly) {
+  SMDiagnostic Error;
+  std::unique_ptr<Module> M = parseAssemblyString(Assembly, Error, C);
+
+  std::string ErrMsg;
+  raw_string_ostream OS(ErrMsg);
+  Error.print("", OS);
+
+  // A failure here means that the test itself is buggy.
+  if (!M)
+    report_fatal_error(OS.str().c_str());
+
+  return M;
+}
+
+// Runs a callback on each function with the Memory SSA built for it.
+struct MemorySSATestPass : public FunctionPass {
+  static char ID;
+  std::function<void(Function &, MemorySSA &)> Test;
+
+  explicit MemorySSATestPass(std::function<void(Function &, MemorySSA &)> Test)
+      : FunctionPass(ID), Test(Test) {}
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<MemorySSAWrapperPass>();
+    AU.setPreservesAll();
+  }
+
+  bool runOnFunction(Function &F) override {
+    Test(F, getAnalysis<MemorySSAWrapperPass>().getMSSA());
+    return false;
+  }
+};
+
+char MemorySSATestPass::ID = 0;
+
+void runWithMemorySSA(Module &M,
+                      std::function<void(Function &, MemorySSA &)> Test) {
+  initializeMemorySSAWrapperPassPass(*PassRegistry::getPassRegistry());
+  PassManager PM;
+  PM.add(createBasicAliasAnalysisPass());
+  PM.add(new MemorySSATestPass(Test));
+  PM.run(M);
+}
+
+BasicBlock *getBlock(Function &F, StringRef Name) {
+  for (BasicBlock &BB : F)
+    if (BB.getName() == Name)
+      return &BB;
+  return nullptr;
+}
+
+const char *DiamondIR =
+    "define i32 @f(i1 %c, i32* noalias %a, i32* noalias %b) {\n"
+    "entry:\n"
+    "  store i32 1, i32* %a\n"
+    "  br i1 %c, label %left, label %right\n"
+    "left:\n"
+    "  store i32 2, i32* %b\n"
+    "  br label %merge\n"
+    "right:\n"
+    "  br label %merge\n"
+    "merge:\n"
+    "  %v = load i32* %a\n"
+    "  ret i32 %v\n"
+    "}\n";
+
+TEST(MemorySSATest, PhiAtMerge) {
+  LLVMContext C;
+  std::unique_ptr<Module> M = parseAssembly(C, DiamondIR);
+  bool Ran = false;
+  runWithMemorySSA(*M, [&](Function &F, MemorySSA &MSSA) {
+    Ran = true;
+    Instruction *StoreA = &getBlock(F, "entry")->front();
+    Instruction *StoreB = &getBlock(F, "left")->front();
+    Instruction *Load = &getBlock(F, "merge")->front();
+
+    MemoryUseOrDef *DefA = MSSA.getMemoryAccess(StoreA);
+    MemoryUseOrDef *DefB = MSSA.getMemoryAccess(StoreB);
+    MemoryUseOrDef *Use = MSSA.getMemoryAccess(Load);
+    ASSERT_TRUE(DefA && isa<MemoryDef>(DefA));
+    ASSERT_TRUE(DefB && isa<MemoryDef>(DefB));
+    ASSERT_TRUE(Use && isa<MemoryUse>(Use));
+    EXPECT_TRUE(MSSA.isLiveOnEntryDef(DefA->getDefiningAccess()));
+    EXPECT_EQ(DefA, DefB->getDefiningAccess());
+
+    // The load is reached by both versions of memory, but only the store to
+    // %a clobbers it.
+    MemoryPhi *Phi = MSSA.getMemoryAccess(getBlock(F, "merge"));
+    ASSERT_TRUE(Phi != nullptr);
+    EXPECT_EQ(Phi, Use->getDefiningAccess());
+    EXPECT_EQ(DefB, Phi->getIncomingValueForBlock(getBlock(F, "left")));
+    EXPECT_EQ(DefA, Phi->getIncomingValueForBlock(getBlock(F, "right")));
+    EXPECT_EQ(DefA, MSSA.getWalker()->getClobberingMemoryAccess(Load));
+    EXPECT_FALSE(MSSA.getMemoryAccess(getBlock(F, "left")));
+    MSSA.verifyMemorySSA();
+  });
+  EXPECT_TRUE(Ran);
+}
+
+TEST(MemorySSATest, RemoveAccess) {
+  LLVMContext C;
+  std::unique_ptr<Module> M = parseAssembly(C, DiamondIR);
+  runWithMemorySSA(*M, [&](Function &F, MemorySSA &MSSA) {
+    Instruction *StoreA = &getBlock(F, "entry")->front();
+    Instruction *StoreB = &getBlock(F, "left")->front();
+    Instruction *Load = &getBlock(F, "merge")->front();
+
+    // Removing the store to %b makes the phi merge the same version twice.
+    MSSA.removeMemoryAccess(MSSA.getMemoryAccess(StoreB));
+    StoreB->eraseFromParent();
+    MemoryPhi *Phi = MSSA.getMemoryAccess(getBlock(F, "merge"));
+    ASSERT_TRUE(Phi != nullptr);
+    MemoryUseOrDef *DefA = MSSA.getMemoryAccess(StoreA);
+    EXPECT_EQ(DefA, Phi->getIncomingValueForBlock(getBlock(F, "left")));
+    EXPECT_EQ(DefA, MSSA.getWalker()->getClobberingMemoryAccess(Load));
+    MSSA.verifyMemorySSA();
+
+    // A new store before the load becomes its defining access.
+    Instruction *NewStore =
+        new StoreInst(ConstantInt::get(Type::getInt32Ty(F.getContext()), 3),
+                      StoreA->getOperand(1), Load);
+    MemoryUseOrDef *Use = MSSA.getMemoryAccess(Load);
+    MemoryUseOrDef *NewDef = MSSA.createMemoryAccessBefore(NewStore, Phi, Use);
+    Use->setDefiningAccess(NewDef);
+    MSSA.getWalker()->invalidateInfo(Use);
+    EXPECT_EQ(NewDef, MSSA.getWalker()->getClobberingMemoryAccess(Load));
+    MSSA.verifyMemorySSA();
+  });
+}
+
+} // end anonymous namespace
@@ -230,5 +230,36 @@ TEST_F(ScalarEvolutionsTest, SCEVMultiplyAddRecs) {
   EXPECT_EQ(Product->getOperand(8), SE.getAddExpr(Sum));
 }
 
+TEST_F(ScalarEvolutionsTest, SCEVWideAddBudget) {
+  Type *Ty = Type::getInt32Ty(Context);
+  SmallVector<Type *, 300> Types;
+  Types.append(300, Ty);
+  FunctionType *FTy = FunctionType::get(Type::getVoidTy(Context), Types, false);
+  Function *F = cast<Function>(M.getOrInsertFunction("f", FTy));
+  BasicBlock *BB = BasicBlock::Create(Context, "entry", F);
+  ReturnInst::Create(Context, nullptr, BB);
+
+  // Create a ScalarEvolution and "run" it so that it gets initialized.
+  PM.add(&SE);
+  PM.run(M);
+
+  SmallVector<const SCEV *, 301> Args;
+  for (Argument &A : F->args())
+    Args.push_back(SE.getSCEV(&A));
+
+  // Within the budget, a repeated operand is folded into a multiply.
+  SmallVector<const SCEV *, 11> Narrow(Args.begin(), Args.begin() + 10);
+  Narrow.push_back(Args[0]);
+  const SCEVAddExpr *NarrowSum = cast<SCEVAddExpr>(SE.getAddExpr(Narrow));
+  EXPECT_EQ(10u, NarrowSum->getNumOperands());
+
+  // Past it, the operands are only sorted.
+  SmallVector<const SCEV *, 301> Wide(Args.begin(), Args.end());
+  Wide.push_back(Args[0]);
+  const SCEVAddExpr *WideSum = cast<SCEVAddExpr>(SE.getAddExpr(Wide));
+  EXPECT_EQ(301u, WideSum->getNumOperands());
+  EXPECT_EQ(WideSum, SE.getAddExpr(Wide));
+}
+
 }  // end anonymous namespace
 }  // end namespace llvm
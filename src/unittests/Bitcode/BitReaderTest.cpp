@@ -10,9 +10,12 @@
 #include "llvm/ADT/SmallString.h"
 #include "llvm/AsmParser/Parser.h"
 #include "llvm/Bitcode/BitstreamWriter.h"
+#include "llvm/Bitcode/LLVMBitCodes.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/FunctionInfo.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/Metadata.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Verifier.h"
@@ -164,4 +167,236 @@ TEST(BitReaderTest, MaterializeFunctionsForBlockAddrInFunctionAfter) {
   EXPECT_FALSE(verifyModule(*M, &dbgs()));
 }
 
+TEST(BitReaderTest, MaterializeFunctionsFromIndex) {
+  SmallString<1024> Mem;
+
+  LLVMContext Context;
+  std::unique_ptr<Module> M = getLazyModuleFromAssembly(
+      Context, Mem, "define i32 @f() {\n"
+                    "  ret i32 1\n"
+                    "}\n"
+                    "declare i32 @g()\n"
+                    "define i32 @h() {\n"
+                    "  %x = call i32 @f()\n"
+                    "  ret i32 %x\n"
+                    "}\n"
+                    "define i32 @i() {\n"
+                    "  ret i32 3\n"
+                    "}\n");
+  EXPECT_FALSE(verifyModule(*M, &dbgs()));
+  for (const Function &F : *M)
+    EXPECT_TRUE(F.empty());
+
+  // Any function can be materialized first, in any order.
+  EXPECT_FALSE(M->getFunction("i")->materialize());
+  EXPECT_FALSE(M->getFunction("h")->materialize());
+  EXPECT_TRUE(M->getFunction("f")->empty());
+  EXPECT_FALSE(M->getFunction("f")->materialize());
+  EXPECT_TRUE(M->getFunction("g")->isDeclaration());
+
+  ReturnInst *Ret =
+      cast<ReturnInst>(M->getFunction("i")->getEntryBlock().getTerminator());
+  EXPECT_EQ(3u, cast<ConstantInt>(Ret->getReturnValue())->getZExtValue());
+  CallInst *Call = cast<CallInst>(&M->getFunction("h")->getEntryBlock().front());
+  EXPECT_EQ(M->getFunction("f"), Call->getCalledFunction());
+  EXPECT_FALSE(verifyModule(*M, &dbgs()));
+}
+
+TEST(BitReaderTest, StringTable) {
+  SmallString<1024> Mem;
+  writeModuleToBuffer(parseAssembly("@\"shared name\" = global i32 0\n"
+                                    "define i32 @f(i32 %\"shared name\") {\n"
+                                    "entry:\n"
+                                    "  %x = add i32 %\"shared name\", 1\n"
+                                    "  br label %exit\n"
+                                    "exit:\n"
+                                    "  ret i32 %x\n"
+                                    "}\n"
+                                    "define i32 @g(i32 %x) {\n"
+                                    "entry:\n"
+                                    "  ret i32 %x\n"
+                                    "}\n"
+                                    "!named = !{!0}\n"
+                                    "!0 = !{!\"shared name\", !\"entry\"}\n"),
+                      Mem);
+
+  // The string is stored once, although the metadata and two symbol tables
+  // refer to it.
+  StringRef Bitcode = Mem.str();
+  EXPECT_NE(StringRef::npos, Bitcode.find("shared name"));
+  EXPECT_EQ(Bitcode.find("shared name"), Bitcode.rfind("shared name"));
+
+  LLVMContext Context;
+  ErrorOr<Module *> ModuleOrErr =
+      parseBitcodeFile(MemoryBufferRef(Bitcode, "test"), Context);
+  ASSERT_TRUE(bool(ModuleOrErr));
+  std::unique_ptr<Module> M(ModuleOrErr.get());
+  EXPECT_FALSE(verifyModule(*M, &dbgs()));
+
+  EXPECT_TRUE(M->getGlobalVariable("shared name"));
+  Function *F = M->getFunction("f");
+  EXPECT_EQ("shared name", F->arg_begin()->getName());
+  EXPECT_EQ("entry", F->getEntryBlock().getName());
+  EXPECT_EQ("x", F->getEntryBlock().front().getName());
+  EXPECT_EQ("exit", F->back().getName());
+  Function *G = M->getFunction("g");
+  EXPECT_EQ("x", G->arg_begin()->getName());
+  EXPECT_EQ("entry", G->getEntryBlock().getName());
+
+  MDNode *N = M->getNamedMetadata("named")->getOperand(0);
+  ASSERT_EQ(2u, N->getNumOperands());
+  EXPECT_EQ("shared name", cast<MDString>(N->getOperand(0))->getString());
+  EXPECT_EQ("entry", cast<MDString>(N->getOperand(1))->getString());
+}
+
+TEST(BitReaderTest, ReadFunctionSummary) {
+  SmallString<1024> Mem;
+  {
+    raw_svector_ostream OS(Mem);
+    std::unique_ptr<Module> M =
+        parseAssembly("define i32 @callee() {\n"
+                      "  ret i32 0\n"
+                      "}\n"
+                      "define internal void @local() {\n"
+                      "  ret void\n"
+                      "}\n"
+                      "define void @caller() {\n"
+                      "  call i32 @callee()\n"
+                      "  call void @local()\n"
+                      "  call void @external()\n"
+                      "  ret void\n"
+                      "}\n"
+                      "declare void @external()\n");
+    WriteBitcodeToFile(M.get(), OS, /*ShouldPreserveUseListOrder=*/false,
+                       /*EmitFunctionSummary=*/true);
+  }
+  MemoryBufferRef Buffer(Mem.str(), "test.bc");
+  EXPECT_TRUE(hasFunctionSummary(Buffer));
+
+  ErrorOr<std::unique_ptr<FunctionInfoIndex>> IndexOrErr =
+      getFunctionInfoIndex(Buffer);
+  ASSERT_TRUE(bool(IndexOrErr));
+  FunctionInfoIndex &Index = **IndexOrErr;
+  ASSERT_EQ(1U, Index.getModulePaths().size());
+  EXPECT_EQ("test.bc", Index.getModulePath(0));
+
+  ArrayRef<FunctionInfoIndex::ModuleSummaryTy> Caller = Index.lookup("caller");
+  ASSERT_EQ(1U, Caller.size());
+  EXPECT_EQ(0U, Caller[0].first);
+  EXPECT_EQ(4U, Caller[0].second.InstCount);
+  EXPECT_TRUE(Caller[0].second.RefersToLocal);
+  EXPECT_EQ((std::vector<std::string>{"callee", "external", "local"}),
+            Caller[0].second.Callees);
+
+  ASSERT_EQ(1U, Index.lookup("callee").size());
+  EXPECT_TRUE(Index.lookup("callee")[0].second.isImportable());
+  ASSERT_EQ(1U, Index.lookup("local").size());
+  EXPECT_FALSE(Index.lookup("local")[0].second.isImportable());
+  EXPECT_TRUE(Index.lookup("external").empty());
+
+  // The module itself is unaffected by the summaries.
+  LLVMContext Context;
+  ErrorOr<Module *> ModuleOrErr = parseBitcodeFile(Buffer, Context);
+  ASSERT_TRUE(bool(ModuleOrErr));
+  std::unique_ptr<Module> M(ModuleOrErr.get());
+  EXPECT_FALSE(M->getFunction("caller")->isDeclaration());
+}
+
+TEST(BitReaderTest, ReadCombinedFunctionSummaryIndex) {
+  FunctionInfoIndex Index;
+  Index.addModule("a.bc");
+  Index.addModule("b.bc");
+  FunctionSummary Summary;
+  Summary.Linkage = GlobalValue::WeakODRLinkage;
+  Summary.InstCount = 3;
+  Summary.Callees.push_back("g");
+  Index.addFunction("f", 1, Summary);
+  Index.addFunction("f", 0, Summary);
+
+  SmallString<256> Mem;
+  {
+    raw_svector_ostream OS(Mem);
+    WriteFunctionSummaryToFile(Index, OS);
+  }
+  ErrorOr<std::unique_ptr<FunctionInfoIndex>> IndexOrErr =
+      getFunctionInfoIndex(MemoryBufferRef(Mem.str(), "index.bc"));
+  ASSERT_TRUE(bool(IndexOrErr));
+  FunctionInfoIndex &Read = **IndexOrErr;
+  EXPECT_EQ(Index.getModulePaths(), Read.getModulePaths());
+
+  ArrayRef<FunctionInfoIndex::ModuleSummaryTy> F = Read.lookup("f");
+  ASSERT_EQ(2U, F.size());
+  EXPECT_EQ(1U, F[0].first);
+  EXPECT_EQ(0U, F[1].first);
+  EXPECT_EQ(GlobalValue::WeakODRLinkage, F[0].second.Linkage);
+  EXPECT_EQ(3U, F[0].second.InstCount);
+  EXPECT_EQ(Summary.Callees, F[0].second.Callees);
+  EXPECT_TRUE(Read.lookup("g").empty());
+}
+
+TEST(BitReaderTest, NoFunctionSummary) {
+  SmallString<1024> Mem;
+  writeModuleToBuffer(parseAssembly("define void @f() {\n"
+                                    "  ret void\n"
+                                    "}\n"),
+                      Mem);
+  MemoryBufferRef Buffer(Mem.str(), "test.bc");
+  EXPECT_FALSE(hasFunctionSummary(Buffer));
+  ErrorOr<std::unique_ptr<FunctionInfoIndex>> IndexOrErr =
+      getFunctionInfoIndex(Buffer);
+  EXPECT_EQ(BitcodeError::NoFunctionSummary, IndexOrErr.getError());
+}
+
+TEST(BitReaderTest, ReadSymbolTable) {
+  SmallString<1024> Mem;
+  writeModuleToBuffer(
+      parseAssembly("target datalayout = \"m:o\"\n"
+                    "@v = common global i32 0\n"
+                    "@p = private global i32 0\n"
+                    "@llvm.used = appending global [1 x i8*] "
+                    "[i8* bitcast (void ()* @f to i8*)], "
+                    "section \"llvm.metadata\"\n"
+                    "@a = weak alias void ()* @f\n"
+                    "define internal void @f() {\n"
+                    "  ret void\n"
+                    "}\n"
+                    "declare void @g()\n"),
+      Mem);
+  ErrorOr<std::vector<BitcodeSymbol>> SymbolsOrErr =
+      getBitcodeSymbolTable(MemoryBufferRef(Mem.str(), "test.bc"));
+  ASSERT_TRUE(bool(SymbolsOrErr));
+  std::vector<BitcodeSymbol> &Symbols = *SymbolsOrErr;
+
+  // Functions come first, then global variables, then aliases.
+  ASSERT_EQ(6U, Symbols.size());
+  EXPECT_EQ("_f", Symbols[0].Name);
+  EXPECT_EQ(0U, Symbols[0].Flags);
+  EXPECT_EQ("_g", Symbols[1].Name);
+  EXPECT_EQ(unsigned(bitc::SYMTAB_UNDEFINED | bitc::SYMTAB_GLOBAL),
+            Symbols[1].Flags);
+  EXPECT_EQ("_v", Symbols[2].Name);
+  EXPECT_EQ(unsigned(bitc::SYMTAB_GLOBAL | bitc::SYMTAB_COMMON),
+            Symbols[2].Flags);
+  EXPECT_EQ("L_p", Symbols[3].Name);
+  EXPECT_EQ(unsigned(bitc::SYMTAB_FORMAT_SPECIFIC), Symbols[3].Flags);
+  EXPECT_EQ("_llvm.used", Symbols[4].Name);
+  EXPECT_EQ(unsigned(bitc::SYMTAB_GLOBAL | bitc::SYMTAB_FORMAT_SPECIFIC),
+            Symbols[4].Flags);
+  EXPECT_EQ("_a", Symbols[5].Name);
+  EXPECT_EQ(unsigned(bitc::SYMTAB_GLOBAL | bitc::SYMTAB_WEAK),
+            Symbols[5].Flags);
+}
+
+TEST(BitReaderTest, NoSymbolTableWithInlineAsm) {
+  SmallString<1024> Mem;
+  writeModuleToBuffer(parseAssembly("module asm \"foo:\"\n"
+                                    "define void @f() {\n"
+                                    "  ret void\n"
+                                    "}\n"),
+                      Mem);
+  ErrorOr<std::vector<BitcodeSymbol>> SymbolsOrErr =
+      getBitcodeSymbolTable(MemoryBufferRef(Mem.str(), "test.bc"));
+  EXPECT_EQ(BitcodeError::NoSymbolTable, SymbolsOrErr.getError());
+}
+
 } // end namespace
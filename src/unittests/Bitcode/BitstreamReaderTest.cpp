@@ -7,7 +7,13 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Bitcode/BitstreamReader.h"
+#include "llvm/Bitcode/BitstreamWriter.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/TimeValue.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -53,4 +59,142 @@ TEST(BitstreamReaderTest, AtEndOfStreamEmpty) {
   EXPECT_TRUE(Cursor.AtEndOfStream());
 }
 
+/// The abbreviated records of writeRecords(), by abbreviation.
+enum { ArrayRecord = 1, FieldsRecord, BlobRecord };
+
+/// Write a block of \p NumRecords records, using every kind of abbreviation
+/// operand, to \p Buffer.
+static void writeRecords(SmallVectorImpl<char> &Buffer, unsigned NumRecords) {
+  BitstreamWriter Stream(Buffer);
+  Stream.EnterSubblock(bitc::FIRST_APPLICATION_BLOCKID, 3);
+
+  BitCodeAbbrev *ArrayAbbrev = new BitCodeAbbrev();
+  ArrayAbbrev->Add(BitCodeAbbrevOp(ArrayRecord));
+  ArrayAbbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+  ArrayAbbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
+  unsigned ArrayAbbrevID = Stream.EmitAbbrev(ArrayAbbrev);
+
+  BitCodeAbbrev *FieldsAbbrev = new BitCodeAbbrev();
+  FieldsAbbrev->Add(BitCodeAbbrevOp(FieldsRecord));
+  FieldsAbbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 13));
+  FieldsAbbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8));
+  FieldsAbbrev->Add(BitCodeAbbrevOp(7));
+  FieldsAbbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+  FieldsAbbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Char6));
+  unsigned FieldsAbbrevID = Stream.EmitAbbrev(FieldsAbbrev);
+
+  BitCodeAbbrev *BlobAbbrev = new BitCodeAbbrev();
+  BlobAbbrev->Add(BitCodeAbbrevOp(BlobRecord));
+  BlobAbbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
+  unsigned BlobAbbrevID = Stream.EmitAbbrev(BlobAbbrev);
+
+  SmallVector<uint64_t, 16> Vals;
+  for (unsigned I = 0; I != NumRecords; ++I) {
+    Vals.clear();
+    switch (I % 4) {
+    case 0:
+      // Values of every VBR length, up to 64 bits.
+      for (unsigned J = 0; J != 12; ++J)
+        Vals.push_back((uint64_t(I) * 0x9E3779B97F4A7C15ULL) >> (J * 5));
+      Stream.EmitRecord(ArrayRecord, Vals, ArrayAbbrevID);
+      break;
+    case 1:
+      Vals.push_back(I & 0x1fff);
+      Vals.push_back(I);
+      Vals.push_back(7);
+      for (char C : StringRef("abc_XYZ.09"))
+        Vals.push_back(C);
+      Stream.EmitRecord(FieldsRecord, Vals, FieldsAbbrevID);
+      break;
+    case 2:
+      Vals.push_back(BlobRecord);
+      Stream.EmitRecordWithBlob(BlobAbbrevID, Vals, StringRef("blob", I % 5));
+      break;
+    case 3:
+      Vals.push_back(I);
+      Vals.push_back(uint64_t(I) << 40);
+      Stream.EmitRecord(I % 100, Vals);
+      break;
+    }
+  }
+  Stream.ExitBlock();
+}
+
+/// Read the records of writeRecords(), checking them if \p Check. Return the
+/// number of records read.
+static unsigned readRecords(ArrayRef<char> Buffer, bool Check) {
+  BitstreamReader Reader((const unsigned char *)Buffer.begin(),
+                         (const unsigned char *)Buffer.end());
+  BitstreamCursor Cursor(Reader);
+  EXPECT_EQ(unsigned(bitc::ENTER_SUBBLOCK), Cursor.ReadCode());
+  EXPECT_EQ(unsigned(bitc::FIRST_APPLICATION_BLOCKID),
+            Cursor.ReadSubBlockID());
+  EXPECT_FALSE(Cursor.EnterSubBlock(bitc::FIRST_APPLICATION_BLOCKID));
+
+  SmallVector<uint64_t, 16> Vals;
+  for (unsigned I = 0;; ++I) {
+    BitstreamEntry Entry = Cursor.advance();
+    if (Entry.Kind != BitstreamEntry::Record) {
+      EXPECT_EQ(BitstreamEntry::EndBlock, Entry.Kind);
+      return I;
+    }
+    Vals.clear();
+    StringRef Blob;
+    unsigned Code = Cursor.readRecord(Entry.ID, Vals, &Blob);
+    if (!Check)
+      continue;
+
+    std::vector<uint64_t> Record(Vals.begin(), Vals.end());
+    switch (I % 4) {
+    case 0: {
+      EXPECT_EQ(unsigned(ArrayRecord), Code);
+      std::vector<uint64_t> Expected;
+      for (unsigned J = 0; J != 12; ++J)
+        Expected.push_back((uint64_t(I) * 0x9E3779B97F4A7C15ULL) >> (J * 5));
+      EXPECT_EQ(Expected, Record);
+      break;
+    }
+    case 1:
+      EXPECT_EQ(unsigned(FieldsRecord), Code);
+      EXPECT_EQ(13u, Record.size());
+      EXPECT_EQ(std::vector<uint64_t>({I & 0x1fff, I, 7}),
+                std::vector<uint64_t>(Record.begin(), Record.begin() + 3));
+      EXPECT_EQ("abc_XYZ.09", std::string(Record.begin() + 3, Record.end()));
+      break;
+    case 2:
+      EXPECT_EQ(unsigned(BlobRecord), Code);
+      EXPECT_TRUE(Record.empty());
+      EXPECT_EQ(StringRef("blob", I % 5), Blob);
+      break;
+    case 3:
+      EXPECT_EQ(I % 100, Code);
+      EXPECT_EQ(std::vector<uint64_t>({I, uint64_t(I) << 40}), Record);
+      break;
+    }
+  }
+}
+
+TEST(BitstreamReaderTest, ReadRecords) {
+  SmallVector<char, 0> Buffer;
+  writeRecords(Buffer, 1000);
+  EXPECT_EQ(1000u, readRecords(Buffer, true));
+}
+
+// Measures the throughput of readRecord(). Run it with
+// --gtest_also_run_disabled_tests.
+TEST(BitstreamReaderTest, DISABLED_ReadRecordsBenchmark) {
+  const unsigned NumRecords = 1000000, NumRuns = 10;
+  SmallVector<char, 0> Buffer;
+  writeRecords(Buffer, NumRecords);
+
+  sys::TimeValue Start = sys::TimeValue::now();
+  for (unsigned Run = 0; Run != NumRuns; ++Run)
+    EXPECT_EQ(NumRecords, readRecords(Buffer, false));
+  sys::TimeValue Elapsed = sys::TimeValue::now();
+  Elapsed -= Start;
+
+  double Seconds = Elapsed.seconds() + Elapsed.nanoseconds() / 1e9;
+  outs() << format("%.0f records/s\n", NumRecords * NumRuns / Seconds);
+}
+
 } // end anonymous namespace
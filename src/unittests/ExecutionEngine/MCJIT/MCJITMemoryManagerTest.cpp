@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/Support/Process.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -80,6 +81,45 @@ TEST(MCJITMemoryManagerTest, LargeAllocations) {
   EXPECT_FALSE(MemMgr->finalizeMemory(&Error));
 }
 
+TEST(MCJITMemoryManagerTest, AllocationsAfterFinalize) {
+  std::unique_ptr<SectionMemoryManager> MemMgr(new SectionMemoryManager());
+  uintptr_t PageSize = sys::Process::getPageSize();
+
+  // Small sections are packed into the same slab.
+  uint8_t *code1 = MemMgr->allocateCodeSection(256, 0, 1, "");
+  uint8_t *code2 = MemMgr->allocateCodeSection(256, 0, 2, "");
+  EXPECT_NE((uint8_t*)nullptr, code1);
+  EXPECT_NE((uint8_t*)nullptr, code2);
+  EXPECT_EQ((uintptr_t)code1 / PageSize, (uintptr_t)code2 / PageSize);
+  for (unsigned i = 0; i < 256; ++i) {
+    code1[i] = 1;
+    code2[i] = 2;
+  }
+
+  std::string Error;
+  EXPECT_FALSE(MemMgr->finalizeMemory(&Error));
+
+  // The sections allocated next must not share a page with the finalized ones,
+  // which are no longer writable.
+  uint8_t *code3 = MemMgr->allocateCodeSection(256, 0, 3, "");
+  uint8_t *data1 = MemMgr->allocateDataSection(256, 0, 4, "", true);
+  EXPECT_NE((uint8_t*)nullptr, code3);
+  EXPECT_NE((uint8_t*)nullptr, data1);
+  EXPECT_NE((uintptr_t)code1 / PageSize, (uintptr_t)code3 / PageSize);
+  for (unsigned i = 0; i < 256; ++i) {
+    code3[i] = 3;
+    data1[i] = 4;
+  }
+  for (unsigned i = 0; i < 256; ++i) {
+    EXPECT_EQ(1, code1[i]);
+    EXPECT_EQ(2, code2[i]);
+    EXPECT_EQ(3, code3[i]);
+    EXPECT_EQ(4, data1[i]);
+  }
+
+  EXPECT_FALSE(MemMgr->finalizeMemory(&Error));
+}
+
 TEST(MCJITMemoryManagerTest, ManyAllocations) {
   std::unique_ptr<SectionMemoryManager> MemMgr(new SectionMemoryManager());
 
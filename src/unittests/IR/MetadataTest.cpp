@@ -1238,6 +1238,38 @@ TEST_F(DICompositeTypeTest, replaceOperands) {
   EXPECT_EQ(nullptr, N->getTemplateParams().get());
 }
 
+TEST_F(DICompositeTypeTest, getODRType) {
+  unsigned Tag = dwarf::DW_TAG_structure_type;
+  MDString *Name = MDString::get(Context, "some name");
+  DIFile *File = getFile();
+  MDString *Identifier = MDString::get(Context, "some id");
+
+  auto getODRType = [&](unsigned Line, unsigned Flags) {
+    return DICompositeType::getODRType(
+        Context, /*IsDistinct=*/false, Tag, Name, File, Line, nullptr, nullptr,
+        2, 3, 4, Flags, nullptr, 6, nullptr, nullptr, Identifier);
+  };
+
+  // Without ODR uniquing, definitions differing in any operand are different.
+  EXPECT_FALSE(Context.isODRUniquingDebugTypes());
+  auto *N = getODRType(1, 0);
+  EXPECT_NE(N, getODRType(2, 0));
+
+  // With it, the first definition is returned for a given identifier.
+  Context.enableDebugTypeODRUniquing();
+  EXPECT_TRUE(Context.isODRUniquingDebugTypes());
+  auto *Decl = getODRType(3, DINode::FlagFwdDecl);
+  EXPECT_EQ(3u, Decl->getLine());
+  auto *Def = getODRType(4, 0);
+  EXPECT_EQ(4u, Def->getLine());
+  EXPECT_EQ(Def, getODRType(5, 0));
+  EXPECT_NE(Def, getODRType(6, DINode::FlagFwdDecl));
+
+  Context.disableDebugTypeODRUniquing();
+  EXPECT_FALSE(Context.isODRUniquingDebugTypes());
+  EXPECT_NE(Def, getODRType(5, 0));
+}
+
 typedef MetadataTest DISubroutineTypeTest;
 
 TEST_F(DISubroutineTypeTest, get) {
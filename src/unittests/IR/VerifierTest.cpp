@@ -60,5 +60,30 @@ TEST(VerifierTest, InvalidRetAttribute) {
       "Attribute 'uwtable' only applies to functions!"));
 }
 
+TEST(VerifierTest, ParallelFunctions) {
+  LLVMContext C;
+  Module M("M", C);
+  FunctionType *FTy = FunctionType::get(Type::getInt32Ty(C), /*isVarArg=*/false);
+  Constant *Zero32 = ConstantInt::get(Type::getInt32Ty(C), 0);
+  for (unsigned I = 0; I != 64; ++I) {
+    Function *F = cast<Function>(
+        M.getOrInsertFunction(("f" + Twine(I)).str(), FTy));
+    ReturnInst::Create(C, Zero32, BasicBlock::Create(C, "entry", F));
+  }
+  EXPECT_FALSE(verifyModule(M, nullptr, 4));
+
+  // Break a few functions, which must be reported in module order.
+  for (unsigned I : {50, 3, 17}) {
+    Function *F = M.getFunction(("f" + Twine(I)).str());
+    F->front().getTerminator()->setOperand(0, ConstantInt::getFalse(C));
+  }
+  std::string Sequential, Parallel;
+  raw_string_ostream SequentialOS(Sequential), ParallelOS(Parallel);
+  EXPECT_TRUE(verifyModule(M, &SequentialOS));
+  EXPECT_TRUE(verifyModule(M, &ParallelOS, 4));
+  EXPECT_FALSE(SequentialOS.str().empty());
+  EXPECT_EQ(SequentialOS.str(), ParallelOS.str());
+}
+
 }
 }
@@ -177,4 +177,35 @@ TEST_F(LinkModuleTest, TypeMerge) {
             M1->getNamedGlobal("t2")->getType());
 }
 
+TEST_F(LinkModuleTest, LinkOnlyNeeded) {
+  LLVMContext C;
+  SMDiagnostic Err;
+
+  const char *SrcStr = "define void @needed() {\n"
+                       "  call void @callee()\n"
+                       "  ret void\n"
+                       "}\n"
+                       "define void @callee() {\n"
+                       "  ret void\n"
+                       "}\n"
+                       "define void @unused() {\n"
+                       "  call void @callee()\n"
+                       "  ret void\n"
+                       "}\n";
+  std::unique_ptr<Module> Src = parseAssemblyString(SrcStr, Err, C);
+  std::unique_ptr<Module> Dst(new Module("Linked", C));
+
+  Linker L(Dst.get(), [](const llvm::DiagnosticInfo &) {});
+  EXPECT_FALSE(L.linkInModule(Src.get(), false, [](const GlobalValue &GV) {
+    return GV.getName() == "needed";
+  }));
+
+  // What the needed definitions refer to is linked too.
+  ASSERT_NE(nullptr, Dst->getFunction("needed"));
+  EXPECT_FALSE(Dst->getFunction("needed")->isDeclaration());
+  ASSERT_NE(nullptr, Dst->getFunction("callee"));
+  EXPECT_FALSE(Dst->getFunction("callee")->isDeclaration());
+  EXPECT_EQ(nullptr, Dst->getFunction("unused"));
+}
+
 } // end anonymous namespace
@@ -209,3 +209,21 @@ TEST(Option, Slurp) {
   EXPECT_EQ(AL->getAllArgValues(OPT_Slurp)[1], "--");
   EXPECT_EQ(AL->getAllArgValues(OPT_Slurp)[2], "foo");
 }
+
+TEST(Option, LongestPrefixFirst) {
+  TestOptTable T;
+  unsigned MAI, MAC;
+
+  const char *MyArgs[] = { "-Joo", "-Joox", "-C=bye", "--C=desu", "-Cx",
+                           "/C", "hi", "-" };
+  std::unique_ptr<InputArgList> AL(
+      T.ParseArgs(std::begin(MyArgs), std::end(MyArgs), MAI, MAC));
+  EXPECT_EQ(AL->size(), 7U);
+  EXPECT_EQ(AL->getAllArgValues(OPT_B)[0], "bar");
+  EXPECT_EQ(AL->getAllArgValues(OPT_UNKNOWN)[0], "-Joox");
+  EXPECT_EQ(AL->getAllArgValues(OPT_C)[0], "bye");
+  EXPECT_EQ(AL->getAllArgValues(OPT_C)[1], "desu");
+  EXPECT_EQ(AL->getAllArgValues(OPT_UNKNOWN)[1], "-Cx");
+  EXPECT_EQ(AL->getAllArgValues(OPT_SLASH_C)[0], "hi");
+  EXPECT_EQ(AL->getAllArgValues(OPT_INPUT)[0], "-");
+}
@@ -174,6 +174,21 @@ TEST_F(CoverageMappingTest, basic_write_read) {
   }
 }
 
+TEST_F(CoverageMappingTest, read_filenames_only) {
+  addCMR(Counter::getCounter(0), "foo", 1, 1, 1, 1);
+  addCMR(Counter::getCounter(1), "bar", 2, 1, 2, 2);
+  std::string Coverage = writeCoverageRegions();
+
+  SmallVector<StringRef, 8> Filenames;
+  for (const auto &E : Files)
+    Filenames.push_back(E.getKey());
+  RawCoverageMappingReader Reader(Coverage, Filenames, OutputFiles,
+                                  OutputExpressions, OutputCMRs);
+  ASSERT_TRUE(NoError(Reader.readFilenames()));
+  ASSERT_EQ(2U, OutputFiles.size());
+  ASSERT_TRUE(OutputCMRs.empty());
+}
+
 TEST_F(CoverageMappingTest, expansion_gets_first_counter) {
   addCMR(Counter::getCounter(1), "foo", 10, 1, 10, 2);
   // This starts earlier in "foo", so the expansion should get its counter.
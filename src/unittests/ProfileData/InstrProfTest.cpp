@@ -7,8 +7,10 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ProfileData/InstrProfReader.h"
 #include "llvm/ProfileData/InstrProfWriter.h"
+#include "llvm/Support/FileSystem.h"
 #include "gtest/gtest.h"
 
 #include <cstdarg>
@@ -95,4 +97,156 @@ TEST_F(InstrProfTest, get_max_function_count) {
   ASSERT_EQ(1ULL << 63, Reader->getMaximumFunctionCount());
 }
 
+TEST_F(InstrProfTest, merge_records_from_writer) {
+  Writer.addFunctionCounts("foo", 0x1234, {1, 2});
+  InstrProfWriter Writer2;
+  Writer2.addFunctionCounts("foo", 0x1234, {3, 4});
+  Writer2.addFunctionCounts("foo", 0x5678, {5});
+  Writer2.addFunctionCounts("bar", 0x1234, {6, 7, 8});
+  Writer2.addFunctionCounts("baz", 0, {1ULL << 63});
+
+  unsigned Warnings = 0;
+  Writer.addFunctionCounts("bar", 0x1234, {1});
+  Writer.mergeRecordsFromWriter(std::move(Writer2),
+                                [&](StringRef Name, std::error_code EC) {
+    ASSERT_EQ(StringRef("bar"), Name);
+    ASSERT_TRUE(ErrorEquals(instrprof_error::count_mismatch, EC));
+    ++Warnings;
+  });
+  ASSERT_EQ(1U, Warnings);
+
+  auto Profile = Writer.writeBuffer();
+  readProfile(std::move(Profile));
+
+  std::vector<uint64_t> Counts;
+  ASSERT_TRUE(NoError(Reader->getFunctionCounts("foo", 0x1234, Counts)));
+  ASSERT_EQ(2U, Counts.size());
+  ASSERT_EQ(4U, Counts[0]);
+  ASSERT_EQ(6U, Counts[1]);
+  ASSERT_TRUE(NoError(Reader->getFunctionCounts("foo", 0x5678, Counts)));
+  ASSERT_EQ(1U, Counts.size());
+  ASSERT_EQ(5U, Counts[0]);
+  ASSERT_TRUE(NoError(Reader->getFunctionCounts("bar", 0x1234, Counts)));
+  ASSERT_EQ(1U, Counts.size());
+  ASSERT_EQ(1U, Counts[0]);
+  ASSERT_EQ(1ULL << 63, Reader->getMaximumFunctionCount());
+}
+
+TEST_F(InstrProfTest, write_and_read_spilled_profile) {
+  unsigned Warnings = 0;
+  // Spill after every new function.
+  Writer.setMemoryLimit(1, [&](StringRef Name, std::error_code EC) {
+    ASSERT_EQ(StringRef("bar"), Name);
+    ASSERT_TRUE(ErrorEquals(instrprof_error::count_mismatch, EC));
+    ++Warnings;
+  });
+  Writer.addFunctionCounts("foo", 0x1234, {1, 2});
+  Writer.addFunctionCounts("bar", 0x1234, {1});
+  Writer.addFunctionCounts("foo", 0x1234, {3, 4});
+  Writer.addFunctionCounts("foo", 0x5678, {5});
+  Writer.addFunctionCounts("bar", 0x1234, {6, 7, 8});
+  Writer.addFunctionCounts("baz", 0, {1ULL << 63});
+  for (unsigned I = 0; I < 100; ++I)
+    Writer.addFunctionCounts("f" + utostr(I), I, {I});
+  auto Profile = Writer.writeBuffer();
+  ASSERT_TRUE(Profile != nullptr);
+  ASSERT_EQ(1U, Warnings);
+  readProfile(std::move(Profile));
+
+  std::vector<uint64_t> Counts;
+  ASSERT_TRUE(NoError(Reader->getFunctionCounts("foo", 0x1234, Counts)));
+  ASSERT_EQ(2U, Counts.size());
+  ASSERT_EQ(4U, Counts[0]);
+  ASSERT_EQ(6U, Counts[1]);
+  ASSERT_TRUE(NoError(Reader->getFunctionCounts("foo", 0x5678, Counts)));
+  ASSERT_EQ(1U, Counts.size());
+  ASSERT_EQ(5U, Counts[0]);
+  ASSERT_TRUE(NoError(Reader->getFunctionCounts("bar", 0x1234, Counts)));
+  ASSERT_EQ(1U, Counts.size());
+  ASSERT_EQ(1U, Counts[0]);
+  for (unsigned I = 0; I < 100; ++I) {
+    ASSERT_TRUE(NoError(Reader->getFunctionCounts("f" + utostr(I), I, Counts)));
+    ASSERT_EQ(1U, Counts.size());
+    ASSERT_EQ(I, Counts[0]);
+  }
+  ASSERT_EQ(1ULL << 63, Reader->getMaximumFunctionCount());
+}
+
+TEST_F(InstrProfTest, write_and_read_value_sites) {
+  std::vector<InstrProfValueSiteRecord> Sites(3);
+  Sites[0] = {{0x10, 1}, {0x20, 5}};
+  Sites[2] = {{0x30, 2}};
+  Writer.addFunctionCounts("foo", 0x1234, {1, 2}, Sites);
+  std::vector<InstrProfValueSiteRecord> MoreSites(3);
+  MoreSites[0] = {{0x10, 7}};
+  MoreSites[1] = {{0x40, 3}};
+  Writer.addFunctionCounts("foo", 0x1234, {3, 4}, MoreSites);
+  Writer.addFunctionCounts("bar", 0x5678, {1});
+  auto Profile = Writer.writeBuffer();
+  readProfile(std::move(Profile));
+
+  // The counts of each target are merged, and the hottest target comes first.
+  std::vector<uint64_t> Counts;
+  std::vector<InstrProfValueSiteRecord> Found;
+  ASSERT_TRUE(
+      NoError(Reader->getFunctionCounts("foo", 0x1234, Counts, &Found)));
+  ASSERT_EQ(2U, Counts.size());
+  ASSERT_EQ(6U, Counts[1]);
+  ASSERT_EQ(3U, Found.size());
+  ASSERT_EQ(2U, Found[0].size());
+  ASSERT_EQ(0x10U, Found[0][0].Value);
+  ASSERT_EQ(8U, Found[0][0].Count);
+  ASSERT_EQ(0x20U, Found[0][1].Value);
+  ASSERT_EQ(5U, Found[0][1].Count);
+  ASSERT_EQ(1U, Found[1].size());
+  ASSERT_EQ(0x40U, Found[1][0].Value);
+  ASSERT_EQ(1U, Found[2].size());
+  ASSERT_EQ(2U, Found[2][0].Count);
+  ASSERT_TRUE(
+      NoError(Reader->getFunctionCounts("bar", 0x5678, Counts, &Found)));
+  ASSERT_TRUE(Found.empty());
+
+  // A different number of sites for the same function is a mismatch.
+  InstrProfWriter Writer2;
+  Writer2.addFunctionCounts("foo", 0x1234, {1, 2}, Sites);
+  ASSERT_TRUE(ErrorEquals(
+      instrprof_error::value_site_count_mismatch,
+      Writer2.addFunctionCounts("foo", 0x1234, {1, 2},
+                                std::vector<InstrProfValueSiteRecord>(1))));
+}
+
+TEST_F(InstrProfTest, read_profile_file_twice) {
+  int FD;
+  SmallString<128> Path;
+  ASSERT_TRUE(NoError(
+      sys::fs::createTemporaryFile("instrprof-test", "profdata", FD, Path)));
+  Writer.addFunctionCounts("foo", 0x1234, {1, 2});
+  {
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    ASSERT_TRUE(NoError(Writer.write(OS)));
+  }
+
+  // Both readers share the mapping of the file, each has its own state.
+  auto Reader1OrErr = IndexedInstrProfReader::create(Path.str());
+  ASSERT_TRUE(NoError(Reader1OrErr.getError()));
+  auto Reader2OrErr = IndexedInstrProfReader::create(Path.str());
+  ASSERT_TRUE(NoError(Reader2OrErr.getError()));
+  std::unique_ptr<IndexedInstrProfReader> Reader1 =
+      std::move(Reader1OrErr.get());
+  std::unique_ptr<IndexedInstrProfReader> Reader2 =
+      std::move(Reader2OrErr.get());
+
+  auto I = Reader1->begin();
+  ASSERT_TRUE(I != Reader1->end());
+  ASSERT_EQ(StringRef("foo"), I->Name);
+  std::vector<uint64_t> Counts;
+  ASSERT_TRUE(NoError(Reader2->getFunctionCounts("foo", 0x1234, Counts)));
+  ASSERT_EQ(2U, Counts.size());
+  ASSERT_EQ(2U, Counts[1]);
+  ASSERT_EQ(2U, I->Counts[1]);
+  ASSERT_TRUE(++I == Reader1->end());
+
+  sys::fs::remove(Path.str());
+}
+
 } // end anonymous namespace
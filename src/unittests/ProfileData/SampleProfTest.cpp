@@ -0,0 +1,120 @@
+//===- unittest/ProfileData/SampleProfTest.cpp ------------------------------=//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/ProfileData/SampleProfReader.h"
+#include "llvm/ProfileData/SampleProfWriter.h"
+#include "llvm/Support/FileSystem.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+using namespace sampleprof;
+
+static ::testing::AssertionResult NoError(std::error_code EC) {
+  if (!EC)
+    return ::testing::AssertionSuccess();
+  return ::testing::AssertionFailure() << "error " << EC.value()
+                                       << ": " << EC.message();
+}
+
+namespace {
+
+struct SampleProfTest : ::testing::Test {
+  LLVMContext Context;
+  std::unique_ptr<SampleProfileReader> Reader;
+
+  void writeAndRead(SampleProfileFormat Format,
+                    StringMap<FunctionSamples> &Profiles, bool OnDemand) {
+    SmallString<128> ProfilePath;
+    ASSERT_TRUE(NoError(
+        sys::fs::createTemporaryFile("profile", "sample", ProfilePath)));
+    {
+      auto WriterOrErr = SampleProfileWriter::create(ProfilePath, Format);
+      ASSERT_TRUE(NoError(WriterOrErr.getError()));
+      ASSERT_TRUE(WriterOrErr.get()->write(Profiles));
+    }
+
+    auto ReaderOrErr = SampleProfileReader::create(ProfilePath, Context);
+    ASSERT_TRUE(NoError(ReaderOrErr.getError()));
+    Reader = std::move(ReaderOrErr.get());
+    if (OnDemand)
+      ASSERT_TRUE(NoError(Reader->readOnDemand()));
+    else
+      ASSERT_TRUE(NoError(Reader->read()));
+    sys::fs::remove(ProfilePath.str());
+  }
+
+  void testRoundTrip(SampleProfileFormat Format, bool OnDemand) {
+    StringMap<FunctionSamples> Profiles;
+    FunctionSamples &Foo = Profiles["_Z3foov"];
+    Foo.addTotalSamples(100);
+    Foo.addHeadSamples(10);
+    Foo.addBodySamples(1, 0, 10);
+    Foo.addBodySamples(2, 3, 20);
+    Foo.addCalledTargetSamples(2, 3, "_Z3bazv", 15);
+
+    FunctionSamples &Bar =
+        Foo.functionSamplesAt(CallsiteLocation(4, 0, "_Z3barv"));
+    Bar.addTotalSamples(60);
+    Bar.addBodySamples(1, 0, 30);
+    FunctionSamples &Baz =
+        Bar.functionSamplesAt(CallsiteLocation(2, 1, "_Z3bazv"));
+    Baz.addTotalSamples(30);
+    Baz.addBodySamples(0, 0, 30);
+
+    FunctionSamples &Qux = Profiles["_Z3quxv"];
+    Qux.addTotalSamples(5);
+    Qux.addBodySamples(1, 0, 5);
+
+    writeAndRead(Format, Profiles, OnDemand);
+
+    FunctionSamples *ReadFoo = Reader->getSamplesFor("_Z3foov");
+    ASSERT_EQ(100U, ReadFoo->getTotalSamples());
+    ASSERT_EQ(10U, ReadFoo->getHeadSamples());
+    ASSERT_EQ(10U, ReadFoo->findSamplesAt(1, 0));
+    ASSERT_EQ(20U, ReadFoo->findSamplesAt(2, 3));
+    ASSERT_EQ(0U, ReadFoo->findSamplesAt(3, 0));
+
+    const FunctionSamples *ReadBar =
+        ReadFoo->findFunctionSamplesAt(CallsiteLocation(4, 0, "_Z3barv"));
+    ASSERT_TRUE(ReadBar != nullptr);
+    ASSERT_EQ(60U, ReadBar->getTotalSamples());
+    ASSERT_EQ(30U, ReadBar->findSamplesAt(1, 0));
+    ASSERT_TRUE(ReadFoo->findFunctionSamplesAt(
+                    CallsiteLocation(4, 0, "_Z3bazv")) == nullptr);
+
+    const FunctionSamples *ReadBaz =
+        ReadBar->findFunctionSamplesAt(CallsiteLocation(2, 1, "_Z3bazv"));
+    ASSERT_TRUE(ReadBaz != nullptr);
+    ASSERT_EQ(30U, ReadBaz->getTotalSamples());
+    ASSERT_EQ(30U, ReadBaz->findSamplesAt(0, 0));
+
+    ASSERT_EQ(5U, Reader->getSamplesFor("_Z3quxv")->getTotalSamples());
+    ASSERT_TRUE(Reader->getSamplesFor("_Z4nonev")->empty());
+  }
+};
+
+TEST_F(SampleProfTest, roundtrip_text_profile) {
+  testRoundTrip(SPF_Text, false);
+}
+
+TEST_F(SampleProfTest, roundtrip_binary_profile) {
+  testRoundTrip(SPF_Binary, false);
+}
+
+TEST_F(SampleProfTest, roundtrip_compact_profile) {
+  testRoundTrip(SPF_Compact, false);
+}
+
+TEST_F(SampleProfTest, read_compact_profile_on_demand) {
+  testRoundTrip(SPF_Compact, true);
+}
+
+} // end anonymous namespace
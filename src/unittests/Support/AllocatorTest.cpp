@@ -178,4 +178,24 @@ TEST(AllocatorTest, TestBigAlignment) {
   EXPECT_GT(MockSlabAllocator::GetLastSlabSize(), 4096u);
 }
 
+// Raise the slab size of an allocator that already has a slab; the existing
+// slab keeps its size and the new ones use the new size.
+TEST(AllocatorTest, TestMinSlabSize) {
+  BumpPtrAllocatorImpl<MockSlabAllocator> Alloc;
+  Alloc.Allocate(3000, 1);
+  EXPECT_EQ(4096u, MockSlabAllocator::GetLastSlabSize());
+  EXPECT_EQ(4096u, Alloc.getTotalMemory());
+
+  Alloc.setMinSlabSize(10000);
+  Alloc.setUseHugePages(true);
+  EXPECT_EQ(1U, Alloc.GetNumSlabs());
+  Alloc.Allocate(3000, 1);
+  EXPECT_EQ(2U, Alloc.GetNumSlabs());
+  EXPECT_EQ(16384u, MockSlabAllocator::GetLastSlabSize());
+  Alloc.Allocate(10000, 1);
+  EXPECT_EQ(2U, Alloc.GetNumSlabs());
+  EXPECT_EQ(4096u + 16384u, Alloc.getTotalMemory());
+  EXPECT_EQ(16000u, Alloc.getBytesAllocated());
+}
+
 }  // anonymous namespace
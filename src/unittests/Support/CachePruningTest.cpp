@@ -0,0 +1,102 @@
+//===- unittests/CachePruningTest.cpp - CachePruning tests ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/TimeValue.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+/// Create the file \p Name of \p Size bytes in \p Dir, last used \p Age
+/// seconds ago.
+static void createEntry(StringRef Dir, StringRef Name, unsigned Size,
+                        unsigned Age) {
+  SmallString<64> Path(Dir);
+  sys::path::append(Path, Name);
+  int FD;
+  ASSERT_FALSE(sys::fs::openFileForWrite(Path.str(), FD, sys::fs::F_None));
+  raw_fd_ostream OS(FD, /*shouldClose=*/true);
+  OS << std::string(Size, 'x');
+  OS.flush();
+  sys::TimeValue Time = sys::TimeValue::now();
+  Time -= sys::TimeValue(Age, 0);
+  ASSERT_FALSE(sys::fs::setLastModificationAndAccessTime(FD, Time));
+}
+
+static bool entryExists(StringRef Dir, StringRef Name) {
+  SmallString<64> Path(Dir);
+  sys::path::append(Path, Name);
+  return sys::fs::exists(Path.str());
+}
+
+static void removeDir(StringRef Dir) {
+  std::error_code EC;
+  for (sys::fs::directory_iterator File(Dir, EC), FileEnd;
+       File != FileEnd && !EC; File.increment(EC))
+    sys::fs::remove(File->path());
+  sys::fs::remove(Dir);
+}
+
+TEST(CachePruningTest, Expiration) {
+  SmallString<64> TmpDir;
+  ASSERT_FALSE(sys::fs::createUniqueDirectory("CachePruningTestDir", TmpDir));
+  createEntry(TmpDir, "old", 1, 1000);
+  createEntry(TmpDir, "new", 1, 0);
+
+  EXPECT_TRUE(CachePruning(TmpDir).setPruningInterval(0)
+                  .setEntryExpiration(100).prune());
+  EXPECT_FALSE(entryExists(TmpDir, "old"));
+  EXPECT_TRUE(entryExists(TmpDir, "new"));
+  EXPECT_TRUE(entryExists(TmpDir, CachePruning::getTimestampFileName()));
+
+  removeDir(TmpDir);
+}
+
+TEST(CachePruningTest, MaxSize) {
+  SmallString<64> TmpDir;
+  ASSERT_FALSE(sys::fs::createUniqueDirectory("CachePruningTestDir", TmpDir));
+  createEntry(TmpDir, "a", 100, 30);
+  createEntry(TmpDir, "b", 100, 20);
+  createEntry(TmpDir, "c", 100, 10);
+
+  // The least recently used entries go first.
+  EXPECT_TRUE(CachePruning(TmpDir).setPruningInterval(0)
+                  .setMaxSize(250).prune());
+  EXPECT_FALSE(entryExists(TmpDir, "a"));
+  EXPECT_TRUE(entryExists(TmpDir, "b"));
+  EXPECT_TRUE(entryExists(TmpDir, "c"));
+
+  removeDir(TmpDir);
+}
+
+TEST(CachePruningTest, Interval) {
+  SmallString<64> TmpDir;
+  ASSERT_FALSE(sys::fs::createUniqueDirectory("CachePruningTestDir", TmpDir));
+  createEntry(TmpDir, "old", 1, 1000);
+
+  // Pruning is disabled by default.
+  EXPECT_FALSE(CachePruning(TmpDir).setEntryExpiration(100).prune());
+  EXPECT_TRUE(entryExists(TmpDir, "old"));
+
+  // The first pruning writes the timestamp that delays the next one.
+  EXPECT_TRUE(CachePruning(TmpDir).setPruningInterval(3600).prune());
+  createEntry(TmpDir, "old", 1, 1000);
+  EXPECT_FALSE(CachePruning(TmpDir).setPruningInterval(3600)
+                   .setEntryExpiration(100).prune());
+  EXPECT_TRUE(entryExists(TmpDir, "old"));
+
+  removeDir(TmpDir);
+}
+
+} // end anonymous namespace
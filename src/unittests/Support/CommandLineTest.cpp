@@ -212,6 +212,30 @@ TEST(CommandLineTest, AliasesWithArguments) {
   }
 }
 
+enum TestLevel { LevelOne, LevelTwo };
+
+TEST(CommandLineTest, PendingOptions) {
+  // Both options are only registered when the parser is first used: the
+  // values one by its values, the other by its changed argument string.
+  StackOption<TestLevel> Level(
+      cl::values(clEnumValN(LevelOne, "level-one", "First level"),
+                 clEnumValN(LevelTwo, "level-two", "Second level"),
+                 clEnumValEnd));
+  StackOption<int> Renamed("pending-option");
+  Renamed.setArgStr("renamed-pending-option");
+
+  const char *Args[] = { "-tool", "-level-two", "-renamed-pending-option=3" };
+  cl::ParseCommandLineOptions(array_lengthof(Args), Args);
+  EXPECT_EQ(LevelTwo, Level);
+  EXPECT_EQ(3, Renamed);
+
+  StringMap<cl::Option *> &Map = cl::getRegisteredOptions();
+  EXPECT_EQ(&Level, Map.lookup("level-one"));
+  EXPECT_EQ(&Level, Map.lookup("level-two"));
+  EXPECT_EQ(&Renamed, Map.lookup("renamed-pending-option"));
+  EXPECT_EQ(0u, Map.count("pending-option"));
+}
+
 void testAliasRequired(int argc, const char *const *argv) {
   StackOption<std::string> Option("option", cl::Required);
   cl::alias Alias("o", llvm::cl::aliasopt(Option));
@@ -0,0 +1,71 @@
+//===- llvm/unittest/Support/CrashRecoveryTest.cpp ------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Config/config.h"
+#include "llvm/Support/CrashRecoveryContext.h"
+#include "gtest/gtest.h"
+#include <thread>
+
+using namespace llvm;
+
+namespace {
+
+class CrashRecoveryTest : public ::testing::Test {
+protected:
+  void SetUp() override { CrashRecoveryContext::Enable(); }
+  void TearDown() override { CrashRecoveryContext::Disable(); }
+};
+
+TEST_F(CrashRecoveryTest, RunSafelyOnThread) {
+  for (unsigned i = 0; i != 3; ++i) {
+    CrashRecoveryContext CRC;
+    CrashRecoveryContext *Current = nullptr;
+    EXPECT_TRUE(CRC.RunSafelyOnThread(
+        [&] { Current = CrashRecoveryContext::GetCurrent(); }));
+    EXPECT_EQ(&CRC, Current);
+  }
+  EXPECT_EQ(nullptr, CrashRecoveryContext::GetCurrent());
+}
+
+#if LLVM_ENABLE_THREADS
+TEST_F(CrashRecoveryTest, ReusesThreads) {
+  std::thread::id First, Second;
+  {
+    CrashRecoveryContext CRC;
+    EXPECT_TRUE(
+        CRC.RunSafelyOnThread([&] { First = std::this_thread::get_id(); }));
+  }
+  {
+    CrashRecoveryContext CRC;
+    EXPECT_TRUE(
+        CRC.RunSafelyOnThread([&] { Second = std::this_thread::get_id(); }));
+  }
+  EXPECT_EQ(First, Second);
+  EXPECT_NE(std::this_thread::get_id(), First);
+}
+#endif
+
+TEST_F(CrashRecoveryTest, RunSafelyOnThreadAfterCrash) {
+  {
+    CrashRecoveryContext CRC;
+    EXPECT_FALSE(CRC.RunSafelyOnThread([&] { CRC.HandleCrash(); }));
+  }
+  {
+    CrashRecoveryContext CRC;
+    EXPECT_FALSE(CRC.RunSafelyOnThread([&] { CRC.HandleExit(3); }));
+    EXPECT_EQ(3, CRC.getRetCode());
+  }
+
+  CrashRecoveryContext CRC;
+  bool Ran = false;
+  EXPECT_TRUE(CRC.RunSafelyOnThread([&] { Ran = true; }));
+  EXPECT_TRUE(Ran);
+}
+
+}
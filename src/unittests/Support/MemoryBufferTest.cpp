@@ -86,6 +86,32 @@ TEST_F(MemoryBufferTest, NullTerminator4K) {
   EXPECT_EQ('\0', BufData[4096]);
 }
 
+TEST_F(MemoryBufferTest, NoNullTerminatorPageMultiple) {
+  // A file whose size is a multiple of the page size is only mapped when the
+  // client doesn't need a null terminator.
+  int TestFD;
+  SmallString<64> TestPath;
+  sys::fs::createTemporaryFile("MemoryBufferTest_NoNullTerminator", "temp",
+                               TestFD, TestPath);
+  raw_fd_ostream OF(TestFD, true, /*unbuffered=*/true);
+  for (unsigned i = 0; i < 0x4000 / 16; ++i) {
+    OF << "0123456789abcdef";
+  }
+  OF.close();
+
+  ErrorOr<OwningBuffer> MB = MemoryBuffer::getFileOrSTDIN(
+      TestPath.c_str(), /*FileSize=*/-1, /*RequiresNullTerminator=*/false);
+  std::error_code EC = MB.getError();
+  ASSERT_FALSE(EC);
+
+  EXPECT_EQ(MemoryBuffer::MemoryBuffer_MMap, MB.get()->getBufferKind());
+  ASSERT_EQ(0x4000u, MB.get()->getBufferSize());
+  const char *BufData = MB.get()->getBufferStart();
+  EXPECT_EQ('0', BufData[0]);
+  EXPECT_EQ('f', BufData[0x3fff]);
+  sys::fs::remove(TestPath.str());
+}
+
 TEST_F(MemoryBufferTest, copy) {
   // copy with no name
   OwningBuffer MBC1(MemoryBuffer::getMemBufferCopy(data));
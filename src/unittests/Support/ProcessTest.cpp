@@ -9,6 +9,7 @@
 
 #include "llvm/Support/Process.h"
 #include "gtest/gtest.h"
+#include <vector>
 
 #ifdef LLVM_ON_WIN32
 #include <windows.h>
@@ -26,6 +27,16 @@ TEST(ProcessTest, GetRandomNumberTest) {
   EXPECT_NE((r1 | r2), 0u);
 }
 
+#if defined(LLVM_ON_WIN32) || defined(__linux__) || defined(__APPLE__)
+TEST(ProcessTest, GetPeakMemoryUsage) {
+  // The test itself is resident, and the peak resident set size only grows.
+  size_t Before = Process::GetPeakMemoryUsage();
+  EXPECT_NE(Before, 0u);
+  std::vector<char> Buffer(16 << 20, 1);
+  EXPECT_GE(Process::GetPeakMemoryUsage(), Before);
+}
+#endif
+
 #ifdef _MSC_VER
 #define setenv(name, var, ignore) _putenv_s(name, var)
 #endif
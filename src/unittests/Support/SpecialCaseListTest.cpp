@@ -94,6 +94,38 @@ TEST_F(SpecialCaseListTest, Substring) {
   EXPECT_TRUE(SCL->inSection("fun", "foobar"));
 }
 
+TEST_F(SpecialCaseListTest, Globs) {
+  std::unique_ptr<SpecialCaseList> SCL = makeSpecialCaseList("fun:_ZN4base*\n"
+                                                             "fun:_ZN4b*\n"
+                                                             "src:*_test.cc\n"
+                                                             "src:*.h\n");
+  EXPECT_TRUE(SCL->inSection("fun", "_ZN4base6subtle"));
+  EXPECT_TRUE(SCL->inSection("fun", "_ZN4b"));
+  EXPECT_TRUE(SCL->inSection("fun", "_ZN4bar"));
+  EXPECT_FALSE(SCL->inSection("fun", "_ZN4"));
+  EXPECT_FALSE(SCL->inSection("fun", "_ZN3base"));
+  EXPECT_TRUE(SCL->inSection("src", "foo_test.cc"));
+  EXPECT_TRUE(SCL->inSection("src", "_test.cc"));
+  EXPECT_TRUE(SCL->inSection("src", "a/b.h"));
+  EXPECT_FALSE(SCL->inSection("src", "foo_test.cpp"));
+  EXPECT_FALSE(SCL->inSection("src", "_ZN4base"));
+
+  SCL = makeSpecialCaseList("fun:*\n");
+  EXPECT_TRUE(SCL->inSection("fun", ""));
+  EXPECT_TRUE(SCL->inSection("fun", "anything"));
+  EXPECT_FALSE(SCL->inSection("src", "anything"));
+
+  SCL = makeSpecialCaseList("fun:*foo*bar*\n"
+                            "fun:a.c*\n"
+                            "fun:*baz\n");
+  EXPECT_TRUE(SCL->inSection("fun", "xfooybarz"));
+  EXPECT_TRUE(SCL->inSection("fun", "foobar"));
+  EXPECT_FALSE(SCL->inSection("fun", "barfoo"));
+  EXPECT_TRUE(SCL->inSection("fun", "abcd"));
+  EXPECT_TRUE(SCL->inSection("fun", "mybaz"));
+  EXPECT_FALSE(SCL->inSection("fun", "bazz"));
+}
+
 TEST_F(SpecialCaseListTest, InvalidSpecialCaseList) {
   std::string Error;
   EXPECT_EQ(nullptr, makeSpecialCaseList("badline", Error));
@@ -8,7 +8,10 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/StringPool.h"
+#include "llvm/Support/ThreadPool.h"
 #include "gtest/gtest.h"
+#include <string>
+#include <vector>
 
 using namespace llvm;
 
@@ -28,4 +31,43 @@ TEST(PooledStringPtrTest, OperatorNotEquals) {
   EXPECT_TRUE(a != b);
 }
 
+TEST(PooledStringPtrTest, InternIdentical) {
+  StringPool pool;
+  PooledStringPtr a = pool.intern("wakka");
+  PooledStringPtr b = pool.intern(StringRef("wakka wakka", 5));
+  EXPECT_TRUE(a == b);
+  EXPECT_EQ(5u, b.size());
+  a.clear();
+  EXPECT_FALSE(pool.empty());
+  b.clear();
+  EXPECT_TRUE(pool.empty());
+}
+
+TEST(PooledStringPtrTest, ConcurrentIntern) {
+  StringPool pool;
+  std::vector<PooledStringPtr> Expected;
+  for (unsigned i = 0; i < 64; ++i)
+    Expected.push_back(pool.intern("str" + std::to_string(i)));
+
+  // Threads intern, copy and release the same strings: they must all get the
+  // entries interned above, and release every temporary one.
+  {
+    ThreadPool Pool(4);
+    for (unsigned t = 0; t < 8; ++t)
+      Pool.async([&] {
+        for (unsigned n = 0; n < 100; ++n)
+          for (unsigned i = 0; i < 64; ++i) {
+            PooledStringPtr P = pool.intern("str" + std::to_string(i));
+            PooledStringPtr Q = pool.intern("tmp" + std::to_string(i));
+            PooledStringPtr R = Q;
+            EXPECT_TRUE(P == Expected[i]);
+          }
+      });
+    Pool.wait();
+  }
+
+  Expected.clear();
+  EXPECT_TRUE(pool.empty());
+}
+
 }
@@ -0,0 +1,97 @@
+//========- unittests/Support/ThreadPool.cpp - ThreadPool.h tests ----========//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/ThreadPool.h"
+#include "gtest/gtest.h"
+#include <atomic>
+
+using namespace llvm;
+
+namespace {
+
+TEST(ThreadPoolTest, AsyncBarrier) {
+  std::atomic_int checked_in{0};
+
+  ThreadPool Pool;
+  for (size_t i = 0; i < 5; ++i)
+    Pool.async([&checked_in] { ++checked_in; });
+  Pool.wait();
+  ASSERT_EQ(5, checked_in);
+
+  // The pool can be reused after a wait().
+  for (size_t i = 0; i < 5; ++i)
+    Pool.async([&checked_in] { ++checked_in; });
+  Pool.wait();
+  ASSERT_EQ(10, checked_in);
+}
+
+static void TestFunc(std::atomic_int &checked_in, int i) { checked_in += i; }
+
+TEST(ThreadPoolTest, AsyncBarrierArgs) {
+  std::atomic_int checked_in{0};
+
+  ThreadPool Pool;
+  for (size_t i = 0; i < 5; ++i)
+    Pool.async(TestFunc, std::ref(checked_in), i);
+  Pool.wait();
+  ASSERT_EQ(10, checked_in);
+}
+
+TEST(ThreadPoolTest, GetFuture) {
+  ThreadPool Pool(2);
+  std::future<int> Future = Pool.async([] { return 42; });
+  ASSERT_EQ(42, Future.get());
+
+  std::atomic_int i{0};
+  std::future<void> Done = Pool.async([&i] { ++i; });
+  Done.wait();
+  ASSERT_EQ(1, i);
+}
+
+TEST(ThreadPoolTest, PoolDestruction) {
+  // Test that we are waiting on destruction.
+  std::atomic_int checked_in{0};
+  {
+    ThreadPool Pool;
+    for (size_t i = 0; i < 5; ++i)
+      Pool.async([&checked_in] { ++checked_in; });
+  }
+  ASSERT_EQ(5, checked_in);
+}
+
+TEST(ThreadPoolTest, TaskGroupWait) {
+  std::atomic_int checked_in{0};
+
+  ThreadPool Pool(2);
+  TaskGroup Group(Pool);
+  for (size_t i = 0; i < 10; ++i)
+    Group.spawn([&checked_in] { ++checked_in; });
+  Group.wait();
+  ASSERT_EQ(10, checked_in);
+}
+
+TEST(ThreadPoolTest, NestedTaskGroup) {
+  // Waiting on a group from inside a task of the same pool must not
+  // deadlock, even with a single worker thread.
+  std::atomic_int checked_in{0};
+
+  ThreadPool Pool(1);
+  std::future<void> Outer = Pool.async([&] {
+    TaskGroup Group(Pool);
+    for (size_t i = 0; i < 4; ++i)
+      Group.spawn([&checked_in] { ++checked_in; });
+    Group.wait();
+    ASSERT_EQ(4, checked_in);
+  });
+  Outer.wait();
+  Pool.wait();
+  ASSERT_EQ(4, checked_in);
+}
+
+} // end anonymous namespace
@@ -0,0 +1,100 @@
+//===- llvm/unittest/Support/TimeProfilerTest.cpp - Time trace tests ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <thread>
+
+using namespace llvm;
+
+namespace {
+
+void spin() {
+  // Take long enough to show up in the folded stacks, which count whole
+  // microseconds.
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+}
+
+std::string writeTrace(bool Folded) {
+  std::string Str;
+  raw_string_ostream OS(Str);
+  if (Folded)
+    timeTraceProfilerWriteFolded(OS);
+  else
+    timeTraceProfilerWrite(OS);
+  return OS.str();
+}
+
+TEST(TimeProfiler, Disabled) {
+  EXPECT_FALSE(isTimeTraceProfilerEnabled());
+  bool Computed = false;
+  TimeTraceScope Scope("Unused", [&]() {
+    Computed = true;
+    return std::string();
+  });
+  EXPECT_FALSE(Computed);
+}
+
+TEST(TimeProfiler, Scopes) {
+  timeTraceProfilerInitialize(0, "unittest");
+  ASSERT_TRUE(isTimeTraceProfilerEnabled());
+  {
+    TimeTraceScope Outer("Outer");
+    spin();
+    {
+      TimeTraceScope Inner("Inner", []() { return std::string("detail"); });
+      spin();
+    }
+    NamedRegionTimer T("Region", /*Enabled=*/false);
+    spin();
+  }
+
+  std::string Trace = writeTrace(false);
+  EXPECT_NE(std::string::npos, Trace.find("\"name\":\"Outer\""));
+  EXPECT_NE(std::string::npos,
+            Trace.find("\"name\":\"Inner\",\"args\":{\"detail\":\"detail\"}"));
+  EXPECT_NE(std::string::npos, Trace.find("\"name\":\"Region\""));
+  EXPECT_NE(std::string::npos, Trace.find("\"name\":\"Total Outer\""));
+  EXPECT_NE(std::string::npos, Trace.find("{\"name\":\"unittest\"}"));
+
+  // Each stack gets only the time spent in its innermost scope itself.
+  std::string Folded = writeTrace(true);
+  EXPECT_EQ(0u, Folded.find("Outer "));
+  EXPECT_NE(std::string::npos, Folded.find("\nOuter;Inner "));
+  EXPECT_NE(std::string::npos, Folded.find("\nOuter;Region "));
+  timeTraceProfilerCleanup();
+  EXPECT_FALSE(isTimeTraceProfilerEnabled());
+}
+
+TEST(TimeProfiler, Threads) {
+  timeTraceProfilerInitialize(0, "unittest");
+  {
+    TimeTraceScope Scope("Main");
+    std::thread Worker([] {
+      TimeTraceScope Scope("Worker");
+      spin();
+    });
+    Worker.join();
+  }
+
+  // The worker's scopes get their own row, and don't nest in the main
+  // thread's.
+  std::string Trace = writeTrace(false);
+  EXPECT_NE(std::string::npos,
+            Trace.find("\"tid\":1,\"ph\":\"X\",\"ts\":"));
+  std::string Folded = writeTrace(true);
+  EXPECT_NE(std::string::npos, Folded.find("\nWorker "));
+  EXPECT_EQ(std::string::npos, Folded.find("Main;Worker"));
+  timeTraceProfilerCleanup();
+}
+
+} // end anonymous namespace
@@ -0,0 +1,77 @@
+//===- TrigramIndexTest.cpp - Unit tests for TrigramIndex -----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/TrigramIndex.h"
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+
+class TrigramIndexTest : public ::testing::Test {
+protected:
+  std::unique_ptr<TrigramIndex>
+  makeTrigramIndex(const std::vector<std::string> &Rules) {
+    std::unique_ptr<TrigramIndex> TI(new TrigramIndex);
+    for (const std::string &Rule : Rules)
+      TI->insert(Rule);
+    return TI;
+  }
+};
+
+TEST_F(TrigramIndexTest, Empty) {
+  std::unique_ptr<TrigramIndex> TI = makeTrigramIndex({});
+  EXPECT_FALSE(TI->isDefeated());
+  EXPECT_TRUE(TI->isDefinitelyOut("foo"));
+}
+
+TEST_F(TrigramIndexTest, Basic) {
+  std::unique_ptr<TrigramIndex> TI = makeTrigramIndex({"hello", "world"});
+  EXPECT_FALSE(TI->isDefeated());
+  EXPECT_FALSE(TI->isDefinitelyOut("hello"));
+  EXPECT_FALSE(TI->isDefinitelyOut("world"));
+  EXPECT_TRUE(TI->isDefinitelyOut("hell"));
+  EXPECT_TRUE(TI->isDefinitelyOut("word"));
+}
+
+TEST_F(TrigramIndexTest, Wildcards) {
+  std::unique_ptr<TrigramIndex> TI =
+      makeTrigramIndex({".*foo.*bar.*", "a.cde"});
+  EXPECT_FALSE(TI->isDefeated());
+  EXPECT_FALSE(TI->isDefinitelyOut("xfooybar"));
+  EXPECT_FALSE(TI->isDefinitelyOut("barfoo"));
+  EXPECT_TRUE(TI->isDefinitelyOut("foo"));
+  EXPECT_FALSE(TI->isDefinitelyOut("abcde"));
+  EXPECT_TRUE(TI->isDefinitelyOut("abcd"));
+}
+
+TEST_F(TrigramIndexTest, Escaped) {
+  std::unique_ptr<TrigramIndex> TI = makeTrigramIndex({"a\\.b\\.c"});
+  EXPECT_FALSE(TI->isDefeated());
+  EXPECT_FALSE(TI->isDefinitelyOut("a.b.c"));
+  EXPECT_TRUE(TI->isDefinitelyOut("abc"));
+}
+
+TEST_F(TrigramIndexTest, Defeated) {
+  EXPECT_TRUE(makeTrigramIndex({"foo", "ab"})->isDefeated());
+  EXPECT_TRUE(makeTrigramIndex({"foo", ".*"})->isDefeated());
+  EXPECT_TRUE(makeTrigramIndex({"fo+"})->isDefeated());
+  EXPECT_TRUE(makeTrigramIndex({"fooo*"})->isDefeated());
+  EXPECT_TRUE(makeTrigramIndex({"f[oa]o"})->isDefeated());
+  EXPECT_TRUE(makeTrigramIndex({"foo|bar"})->isDefeated());
+  EXPECT_TRUE(makeTrigramIndex({"(foo)\\1"})->isDefeated());
+
+  std::unique_ptr<TrigramIndex> TI = makeTrigramIndex({"foo", "ba?r"});
+  EXPECT_FALSE(TI->isDefinitelyOut("anything"));
+}
+
+}
@@ -30,4 +30,36 @@ TEST(formatted_raw_ostreamTest, Test_Tell) {
   }
 }
 
+TEST(formatted_raw_ostreamTest, Test_Position) {
+  SmallString<128> A;
+  raw_svector_ostream B(A);
+  formatted_raw_ostream C(B);
+
+  C << "abc";
+  C.flush();
+  EXPECT_EQ(3U, C.getColumn());
+  EXPECT_EQ(0U, C.getLine());
+
+  // Tabs advance to the next multiple of 8.
+  C << "\tx";
+  C.flush();
+  EXPECT_EQ(9U, C.getColumn());
+
+  // Only the characters after the last line break count for the column.
+  C << "\n\tfoo\n\nab\tc";
+  C.flush();
+  EXPECT_EQ(9U, C.getColumn());
+  EXPECT_EQ(3U, C.getLine());
+
+  // A carriage return resets the column without starting a new line.
+  C << "xyz\rq";
+  C.flush();
+  EXPECT_EQ(1U, C.getColumn());
+  EXPECT_EQ(3U, C.getLine());
+
+  C.PadToColumn(20);
+  C.flush();
+  EXPECT_EQ(20U, C.getColumn());
+}
+
 }
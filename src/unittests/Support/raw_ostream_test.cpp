@@ -9,7 +9,9 @@
 
 #include "gtest/gtest.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
@@ -109,6 +111,30 @@ TEST(raw_ostreamTest, Types_Unbuffered) {
   EXPECT_EQ("-9223372036854775808", printToStringUnbuffered(INT64_MIN));
 }
 
+TEST(raw_ostreamTest, Digits) {
+  // Every number of digits, around where the digits go in pairs and where
+  // the formatting switches to 64 bits.
+  uint64_t Power = 1;
+  for (unsigned Digits = 1; Digits != 20; ++Digits, Power *= 10) {
+    EXPECT_EQ("1" + std::string(Digits - 1, '0'), printToString(Power));
+    EXPECT_EQ(std::string(Digits, '9'), printToString(Power * 10 - 1));
+  }
+  EXPECT_EQ("4294967295", printToString(UINT64_C(4294967295)));
+  EXPECT_EQ("4294967296", printToString(UINT64_C(4294967296)));
+  EXPECT_EQ("-4294967296", printToString(INT64_C(-4294967296)));
+
+  std::string Hex;
+  raw_string_ostream OS(Hex);
+  OS.write_hex(0);
+  OS << ' ';
+  OS.write_hex(0xf);
+  OS << ' ';
+  OS.write_hex(0x1234abcd);
+  OS << ' ';
+  OS.write_hex(UINT64_MAX);
+  EXPECT_EQ("0 f 1234abcd ffffffffffffffff", OS.str());
+}
+
 TEST(raw_ostreamTest, BufferEdge) {  
   EXPECT_EQ("1.20", printToString(format("%.2f", 1.2), 1));
   EXPECT_EQ("1.20", printToString(format("%.2f", 1.2), 2));
@@ -127,6 +153,36 @@ TEST(raw_ostreamTest, TinyBuffer) {
   EXPECT_EQ("hello1world", OS.str());
 }
 
+TEST(raw_ostreamTest, LargeWrites) {
+  // Writes at least as large as the buffer go out with the buffered data.
+  std::string Large(100, 'x');
+  std::string Str;
+  raw_string_ostream OS(Str);
+  OS.SetBufferSize(16);
+  OS << "ab" << Large << 'c' << StringRef(Large.data(), 15) << "de";
+  EXPECT_EQ("ab" + Large + 'c' + Large.substr(0, 15) + "de", OS.str());
+
+  SmallString<64> Path;
+  int FD;
+  ASSERT_FALSE(sys::fs::createTemporaryFile("raw_ostream", "txt", FD, Path));
+  std::string Expected;
+  {
+    raw_fd_ostream FOS(FD, /*shouldClose=*/true);
+    std::string Chunk(200000, 'y');
+    for (unsigned i = 0; i != 8; ++i) {
+      FOS << i;
+      FOS.write(Chunk.data(), Chunk.size() >> i);
+      Expected += char('0' + i);
+      Expected.append(Chunk.size() >> i, 'y');
+    }
+    EXPECT_EQ(Expected.size(), FOS.tell());
+  }
+  ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer = MemoryBuffer::getFile(Path.str());
+  ASSERT_TRUE(bool(Buffer));
+  EXPECT_EQ(Expected, (*Buffer)->getBuffer());
+  sys::fs::remove(Path.str());
+}
+
 TEST(raw_ostreamTest, WriteEscaped) {
   std::string Str;
 
@@ -0,0 +1,47 @@
+//===- llvm/unittest/Support/xxhashTest.cpp - xxHash tests ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/xxhash.h"
+#include "gtest/gtest.h"
+#include <string>
+
+using namespace llvm;
+
+namespace {
+
+TEST(xxhashTest, Basic) {
+  EXPECT_EQ(0xef46db3751d8e999ULL, xxHash64(""));
+  EXPECT_EQ(0x33bf00a859c4ba3fULL, xxHash64("foo"));
+  EXPECT_EQ(0x48a37c90ad27a659ULL, xxHash64("bar"));
+  EXPECT_EQ(0x69196c1b3af0bff9ULL,
+            xxHash64("0123456789abcdefghijklmnopqrstuvwxyz"));
+}
+
+TEST(xxhashTest, Lengths) {
+  // Every length up to a few stripes goes through a different mix of the
+  // 32-, 8-, 4- and 1-byte steps; they must all depend on every byte.
+  std::string Data(100, 'x');
+  for (size_t Len = 1; Len <= Data.size(); ++Len) {
+    StringRef Prefix(Data.data(), Len);
+    uint64_t H = xxHash64(Prefix);
+    EXPECT_NE(xxHash64(StringRef(Data.data(), Len - 1)), H);
+    for (size_t I = 0; I != Len; ++I) {
+      std::string Changed = Prefix;
+      Changed[I] = '\xff';
+      EXPECT_NE(xxHash64(Changed), H) << "length " << Len << ", byte " << I;
+    }
+  }
+}
+
+TEST(xxhashTest, Seed) {
+  EXPECT_NE(xxHash64("foo", 0), xxHash64("foo", 1));
+  EXPECT_EQ(xxHash64("foo", 42), xxHash64("foo", 42));
+}
+
+}
@@ -0,0 +1,150 @@
+//===- SplitModuleTest.cpp - Unit tests for SplitModule -------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+
+class SplitModuleTest : public ::testing::Test {
+protected:
+  SplitModuleTest() : M(new Module("split", C)) {}
+
+  Function *addFunction(StringRef Name, GlobalValue::LinkageTypes Linkage,
+                        ArrayRef<Function *> Callees,
+                        ArrayRef<GlobalVariable *> Loads) {
+    FunctionType *FTy = FunctionType::get(Type::getVoidTy(C), false);
+    Function *F = Function::Create(FTy, Linkage, Name, M.get());
+    IRBuilder<> Builder(BasicBlock::Create(C, "entry", F));
+    for (Function *Callee : Callees)
+      Builder.CreateCall(Callee);
+    for (GlobalVariable *GV : Loads)
+      Builder.CreateLoad(GV);
+    Builder.CreateRetVoid();
+    return F;
+  }
+
+  GlobalVariable *addGlobal(StringRef Name,
+                            GlobalValue::LinkageTypes Linkage) {
+    Type *Int32 = Type::getInt32Ty(C);
+    return new GlobalVariable(*M, Int32, false, Linkage,
+                              ConstantInt::get(Int32, 0), Name);
+  }
+
+  void split(unsigned N) {
+    SplitModule(*M, N, [&](std::unique_ptr<Module> MPart) {
+      EXPECT_FALSE(verifyModule(*MPart, &errs()));
+      Parts.push_back(std::move(MPart));
+    });
+    ASSERT_EQ(N, Parts.size());
+  }
+
+  /// Return the partitions where \p Name is defined.
+  std::vector<unsigned> getDefiningParts(StringRef Name) {
+    std::vector<unsigned> Defining;
+    for (unsigned I = 0, E = Parts.size(); I != E; ++I) {
+      GlobalValue *GV = Parts[I]->getNamedValue(Name);
+      if (GV && !GV->isDeclaration())
+        Defining.push_back(I);
+    }
+    return Defining;
+  }
+
+  LLVMContext C;
+  std::unique_ptr<Module> M;
+  std::vector<std::unique_ptr<Module>> Parts;
+};
+
+TEST_F(SplitModuleTest, DefinitionsInOnePartition) {
+  GlobalVariable *Counter = addGlobal("counter", GlobalValue::InternalLinkage);
+  Function *Helper =
+      addFunction("helper", GlobalValue::InternalLinkage, None, Counter);
+  std::vector<Function *> Callers;
+  for (unsigned I = 0; I != 16; ++I)
+    Callers.push_back(addFunction("caller" + utostr(I),
+                                  GlobalValue::ExternalLinkage, Helper, None));
+  split(4);
+
+  // Local definitions are renamed and become hidden externals.
+  EXPECT_EQ(nullptr, M->getNamedValue("helper"));
+  ASSERT_EQ(1U, getDefiningParts("helper.llvm.split").size());
+  ASSERT_EQ(1U, getDefiningParts("counter.llvm.split").size());
+  GlobalValue *NewHelper = Parts[getDefiningParts("helper.llvm.split")[0]]
+                               ->getNamedValue("helper.llvm.split");
+  EXPECT_TRUE(NewHelper->hasExternalLinkage());
+  EXPECT_TRUE(NewHelper->hasHiddenVisibility());
+
+  std::vector<unsigned> UsedParts(Parts.size());
+  for (Function *Caller : Callers) {
+    std::vector<unsigned> Defining = getDefiningParts(Caller->getName());
+    ASSERT_EQ(1U, Defining.size());
+    ++UsedParts[Defining[0]];
+  }
+  // Sixteen functions should be spread over more than one partition.
+  EXPECT_GT(16U, *std::max_element(UsedParts.begin(), UsedParts.end()));
+}
+
+TEST_F(SplitModuleTest, VerbatimLocalsStayWithUsers) {
+  GlobalVariable *Label = addGlobal("\1L_label", GlobalValue::PrivateLinkage);
+  std::vector<Function *> Users;
+  for (unsigned I = 0; I != 8; ++I)
+    Users.push_back(addFunction("user" + utostr(I),
+                                GlobalValue::ExternalLinkage, None, Label));
+  split(4);
+
+  std::vector<unsigned> Defining = getDefiningParts("\1L_label");
+  ASSERT_EQ(1U, Defining.size());
+  EXPECT_TRUE(Parts[Defining[0]]->getNamedValue("\1L_label")
+                  ->hasPrivateLinkage());
+  for (Function *User : Users)
+    EXPECT_EQ(Defining, getDefiningParts(User->getName()));
+}
+
+TEST_F(SplitModuleTest, UsedListIsSplit) {
+  std::vector<Constant *> UsedEntries;
+  Type *Int8Ptr = Type::getInt8PtrTy(C);
+  for (unsigned I = 0; I != 8; ++I) {
+    Function *F = addFunction("used" + utostr(I), GlobalValue::ExternalLinkage,
+                              None, None);
+    UsedEntries.push_back(ConstantExpr::getBitCast(F, Int8Ptr));
+  }
+  ArrayType *ATy = ArrayType::get(Int8Ptr, UsedEntries.size());
+  auto *Used = new GlobalVariable(*M, ATy, false,
+                                  GlobalValue::AppendingLinkage,
+                                  ConstantArray::get(ATy, UsedEntries),
+                                  "llvm.used");
+  Used->setSection("llvm.metadata");
+  split(2);
+
+  unsigned NumEntries = 0;
+  for (const auto &Part : Parts) {
+    GlobalVariable *PartUsed = Part->getGlobalVariable("llvm.used");
+    if (!PartUsed)
+      continue;
+    auto *Init = cast<ConstantArray>(PartUsed->getInitializer());
+    for (const Use &Op : Init->operands())
+      EXPECT_FALSE(cast<GlobalValue>(Op->stripPointerCasts())->isDeclaration());
+    NumEntries += Init->getNumOperands();
+  }
+  EXPECT_EQ(8U, NumEntries);
+}
+
+} // end anonymous namespace
@@ -47,6 +47,10 @@ class MatcherTableEmitter {
   DenseMap<Record*, unsigned> NodeXFormMap;
   std::vector<Record*> NodeXForms;
 
+  /// SwitchTableMap - The number of the interpreter's dispatch cache of each
+  /// switch emitted as OPC_SwitchOpcodeTable or OPC_SwitchTypeTable.
+  DenseMap<const Matcher*, unsigned> SwitchTableMap;
+
 public:
   MatcherTableEmitter(const CodeGenDAGPatterns &cgp)
     : CGP(cgp) {}
@@ -69,6 +73,15 @@ private:
     }
     return Entry-1;
   }
+
+  // The children of a switch are emitted more than once while their size is
+  // worked out, so a switch keeps the number it got the first time.
+  unsigned getSwitchTable(const Matcher *N) {
+    unsigned &Entry = SwitchTableMap[N];
+    if (Entry == 0)
+      Entry = SwitchTableMap.size();
+    return Entry-1;
+  }
   
   unsigned getPatternPredicate(StringRef PredName) {
     unsigned &Entry = PatternPredicateMap[PredName];
@@ -132,6 +145,26 @@ static uint64_t EmitVBRValue(uint64_t Val, raw_ostream &OS) {
   return NumBytes+1;
 }
 
+/// UseSwitchTable - Return true if the switch at CurrentIdx has enough cases
+/// for the interpreter to dispatch through a table rather than scan them.  The
+/// switch that starts the table is always indexed by the interpreter's
+/// OpcodeOffset table, and iPTR cases would only be known at run time.
+static bool UseSwitchTable(const Matcher *N, unsigned CurrentIdx) {
+  if (CurrentIdx == 0)
+    return false;
+
+  if (const SwitchOpcodeMatcher *SOM = dyn_cast<SwitchOpcodeMatcher>(N))
+    return SOM->getNumCases() >= 8;
+
+  const SwitchTypeMatcher *STM = cast<SwitchTypeMatcher>(N);
+  if (STM->getNumCases() < 6)
+    return false;
+  for (unsigned i = 0, e = STM->getNumCases(); i != e; ++i)
+    if (STM->getCaseType(i) == MVT::iPTR)
+      return false;
+  return true;
+}
+
 /// EmitMatcher - Emit bytes for the specified matcher and return
 /// the number of bytes emitted.
 unsigned MatcherTableEmitter::
@@ -274,12 +307,13 @@ EmitMatcher(const Matcher *N, unsigned Indent, unsigned CurrentIdx,
   case Matcher::SwitchType: {
     unsigned StartIdx = CurrentIdx;
 
+    bool UseTable = UseSwitchTable(N, CurrentIdx);
     unsigned NumCases;
     if (const SwitchOpcodeMatcher *SOM = dyn_cast<SwitchOpcodeMatcher>(N)) {
-      OS << "OPC_SwitchOpcode ";
+      OS << (UseTable ? "OPC_SwitchOpcodeTable " : "OPC_SwitchOpcode ");
       NumCases = SOM->getNumCases();
     } else {
-      OS << "OPC_SwitchType ";
+      OS << (UseTable ? "OPC_SwitchTypeTable " : "OPC_SwitchType ");
       NumCases = cast<SwitchTypeMatcher>(N)->getNumCases();
     }
 
@@ -288,6 +322,11 @@ EmitMatcher(const Matcher *N, unsigned Indent, unsigned CurrentIdx,
     OS << ", ";
     ++CurrentIdx;
 
+    // A table switch names the interpreter's cache for it, then has the same
+    // cases as a plain one.
+    if (UseTable)
+      CurrentIdx += EmitVBRValue(getSwitchTable(N), OS);
+
     // For each case we emit the size, then the opcode, then the matcher.
     for (unsigned i = 0, e = NumCases; i != e; ++i) {
       const Matcher *Child;
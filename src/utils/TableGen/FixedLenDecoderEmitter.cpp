@@ -99,6 +99,9 @@ public:
   void emitTable(formatted_raw_ostream &o, DecoderTable &Table,
                  unsigned Indentation, unsigned BitWidth,
                  StringRef Namespace) const;
+  bool emitDispatchTable(formatted_raw_ostream &OS, const DecoderTable &Table,
+                         unsigned BitWidth, StringRef Namespace,
+                         std::string &Dispatch) const;
   void emitPredicateFunction(formatted_raw_ostream &OS,
                              PredicateSet &Predicates,
                              unsigned Indentation) const;
@@ -842,6 +845,81 @@ void FixedLenDecoderEmitter::emitTable(formatted_raw_ostream &OS,
   OS.indent(Indentation) << "};\n\n";
 }
 
+// Maximum width of the leading field of a decode table for which a dispatch
+// table is emitted, so that dispatch tables take at most 1 KiB each.
+static const unsigned MaxDispatchBits = 8;
+
+// Emit a dispatch table for a decode table starting with an
+// OPC_ExtractField and a chain of OPC_FilterValue entries, which holds for
+// each value of the extracted field the position the state machine gets to
+// after that chain. The interpreter can then jump there directly instead of
+// testing the values one after the other, which most instructions go through.
+// Returns false, emitting nothing, for the tables without such a chain. On
+// success, Dispatch is set to the code of decodeInstruction's dispatch for
+// this table.
+bool FixedLenDecoderEmitter::emitDispatchTable(formatted_raw_ostream &OS,
+                                               const DecoderTable &Table,
+                                               unsigned BitWidth,
+                                               StringRef Namespace,
+                                               std::string &Dispatch) const {
+  if (Table.size() < 4 || Table[0] != MCD::OPC_ExtractField)
+    return false;
+  unsigned Start = Table[1];
+  unsigned Len = Table[2];
+  if (Len > MaxDispatchBits || Table[3] != MCD::OPC_FilterValue)
+    return false;
+
+  // Follow the chain as the state machine does for values no filter accepts,
+  // giving each value the position after the first filter that accepts it.
+  std::vector<uint32_t> Targets(1u << Len, ~0u);
+  size_t Pos = 3;
+  while (Table[Pos] == MCD::OPC_FilterValue) {
+    unsigned ValLen;
+    uint64_t Val = decodeULEB128(&Table[Pos + 1], &ValLen);
+    size_t Body = Pos + 1 + ValLen + 2;
+    unsigned NumToSkip = Table[Body - 2] | (Table[Body - 1] << 8);
+    if (Val < Targets.size() && Targets[Val] == ~0u)
+      Targets[Val] = Body;
+    Pos = Body + NumToSkip;
+  }
+  for (uint32_t &Target : Targets)
+    if (Target == ~0u)
+      Target = Pos;
+
+  std::string TableName = "DecoderTable" + Namespace.str() + utostr(BitWidth);
+  OS << "static const uint" << (Table.size() <= 65536 ? 16 : 32)
+     << "_t " << TableName << "Dispatch[] = {";
+  for (unsigned I = 0, E = Targets.size(); I != E; ++I)
+    OS << (I % 8 ? " " : "\n  ") << Targets[I] << ",";
+  OS << "\n};\n\n";
+
+  raw_string_ostream DS(Dispatch);
+  DS << "  if (DecodeTable == " << TableName << ") {\n"
+     << "    CurFieldValue = fieldFromInstruction(insn, " << Start << ", "
+     << Len << ");\n"
+     << "    return DecodeTable + " << TableName
+     << "Dispatch[CurFieldValue];\n"
+     << "  }\n";
+  DS.flush();
+  return true;
+}
+
+// emitDispatchFunction - Emit the templated helper function
+// dispatchFirstLevel(), which applies the dispatch tables.
+static void emitDispatchFunction(formatted_raw_ostream &OS,
+                                 ArrayRef<std::string> Dispatches) {
+  OS << "// Returns where the state machine of DecodeTable gets to after its\n"
+     << "// leading field test, setting CurFieldValue as that test does.\n"
+     << "template<typename InsnType>\n"
+     << "static const uint8_t *dispatchFirstLevel(const uint8_t DecodeTable[],\n"
+     << "                                         InsnType insn,\n"
+     << "                                         uint32_t &CurFieldValue) {\n";
+  for (const std::string &Dispatch : Dispatches)
+    OS << Dispatch;
+  OS << "  return DecodeTable;\n"
+     << "}\n\n";
+}
+
 void FixedLenDecoderEmitter::
 emitPredicateFunction(formatted_raw_ostream &OS, PredicateSet &Predicates,
                       unsigned Indentation) const {
@@ -2012,8 +2090,9 @@ static void emitDecodeInstruction(formatted_raw_ostream &OS) {
      << "                                      const MCSubtargetInfo &STI) {\n"
      << "  uint64_t Bits = STI.getFeatureBits();\n"
      << "\n"
-     << "  const uint8_t *Ptr = DecodeTable;\n"
      << "  uint32_t CurFieldValue = 0;\n"
+     << "  const uint8_t *Ptr = dispatchFirstLevel(DecodeTable, insn,\n"
+     << "                                          CurFieldValue);\n"
      << "  DecodeStatus S = MCDisassembler::Success;\n"
      << "  for (;;) {\n"
      << "    ptrdiff_t Loc = Ptr - DecodeTable;\n"
@@ -2166,6 +2245,7 @@ void FixedLenDecoderEmitter::run(raw_ostream &o) {
   }
 
   DecoderTableInfo TableInfo;
+  std::vector<std::string> Dispatches;
   for (const auto &Opc : OpcMap) {
     // Emit the decoder for this namespace+width combination.
     FilterChooser FC(*NumberedInstructions, Opc.second, Operands,
@@ -2191,6 +2271,10 @@ void FixedLenDecoderEmitter::run(raw_ostream &o) {
 
     // Print the table to the output stream.
     emitTable(OS, TableInfo.Table, 0, FC.getBitWidth(), Opc.first.first);
+    std::string Dispatch;
+    if (emitDispatchTable(OS, TableInfo.Table, FC.getBitWidth(),
+                          Opc.first.first, Dispatch))
+      Dispatches.push_back(Dispatch);
     OS.flush();
   }
 
@@ -2200,6 +2284,9 @@ void FixedLenDecoderEmitter::run(raw_ostream &o) {
   // Emit the decoder function.
   emitDecoderFunction(OS, TableInfo.Decoders, 0);
 
+  // Emit the first-level dispatch used by decodeInstruction().
+  emitDispatchFunction(OS, Dispatches);
+
   // Emit the main entry point for the decoder, decodeInstruction().
   emitDecodeInstruction(OS);
 
@@ -0,0 +1,467 @@
+#!/usr/bin/env python
+
+"""A compile-time benchmark for the optimizer and the code generator.
+
+This script runs opt at every optimization level and llc at -O0 and -O2 on a
+set of bitcode or IR inputs, under -time-passes, and records the CPU time of
+every run and of the slowest passes. llc writes both an object file and
+textual assembly, so that the two emission paths can be compared. Assembly inputs are assembled into object
+files by llvm-mc, to measure the throughput of the integrated assembler. The
+results are written as JSON and can be compared against the results of an
+earlier run, in which case the script fails if any measurement became slower
+than the allowed threshold.
+
+The inputs are either the given .bc, .ll and .s files (and the files found in
+the given directories), or a default set of synthetic modules written by
+--generate. Each synthetic module stresses one part of the pipeline: the
+inliner, the loop passes, CFG simplification, expression rewriting, memory
+dependence analysis, or branch relaxation in the assembler.
+
+Typical use, from the build directory:
+
+  compile_time.py --bindir bin --output new.json --baseline old.json inputs/
+"""
+
+import argparse
+import json
+import os
+import random
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+try:
+  import resource
+except ImportError:
+  resource = None
+
+OPT_LEVELS = ['-O0', '-O1', '-O2', '-O3', '-Os', '-Oz']
+LLC_LEVELS = ['-O0', '-O2']
+
+
+# Synthetic inputs. The IR is generated from a fixed seed so that every run
+# measures the same modules.
+
+def gen_calls(rng, size):
+  """A call graph of small functions, for the inliner and IPO passes."""
+  out = []
+  for i in range(size * 8):
+    linkage = 'internal ' if i % 4 else ''
+    out.append('define %si32 @callee_%d(i32 %%x) {' % (linkage, i))
+    out.append('entry:')
+    if i < 2:
+      out.append('  %%a = add i32 %%x, %d' % (i + 1))
+      out.append('  %b = mul i32 %a, %x')
+      out.append('  ret i32 %b')
+      out.append('}')
+      continue
+    out.append('  %%c = icmp slt i32 %%x, %d' % rng.randint(0, 100))
+    out.append('  br i1 %c, label %then, label %else')
+    out.append('then:')
+    out.append('  %%r1 = call i32 @callee_%d(i32 %%x)' % (i - 1))
+    out.append('  br label %join')
+    out.append('else:')
+    out.append('  %%y = mul i32 %%x, %d' % rng.randint(2, 9))
+    out.append('  %%r2 = call i32 @callee_%d(i32 %%y)' % rng.randint(0, i - 1))
+    out.append('  br label %join')
+    out.append('join:')
+    out.append('  %r = phi i32 [ %r1, %then ], [ %r2, %else ]')
+    out.append('  %%s = add i32 %%r, %d' % i)
+    out.append('  ret i32 %s')
+    out.append('}')
+  return out
+
+
+def gen_loops(rng, size):
+  """Loop nests over arrays, for the loop passes and the vectorizers."""
+  out = []
+  for f in range(size):
+    out.append('define void @loops_%d(i32* noalias %%a, i32* noalias %%b, '
+               'i32* noalias %%c, i64 %%n) {' % f)
+    out.append('entry:')
+    out.append('  %cmp = icmp sgt i64 %n, 0')
+    out.append('  br i1 %cmp, label %i.body, label %exit')
+    out.append('i.body:')
+    out.append('  %i = phi i64 [ 0, %entry ], [ %i.next, %i.latch ]')
+    out.append('  br label %j.body')
+    out.append('j.body:')
+    out.append('  %j = phi i64 [ 0, %i.body ], [ %j.next, %j.latch ]')
+    out.append('  br label %k.body')
+    out.append('k.body:')
+    out.append('  %k = phi i64 [ 0, %j.body ], [ %k.next, %k.body ]')
+    out.append('  %sum = phi i32 [ 0, %j.body ], [ %sum.next, %k.body ]')
+    out.append('  %ik = mul i64 %i, %n')
+    out.append('  %ik.idx = add i64 %ik, %k')
+    out.append('  %pa = getelementptr inbounds i32* %a, i64 %ik.idx')
+    out.append('  %va = load i32* %pa')
+    out.append('  %kj = mul i64 %k, %n')
+    out.append('  %kj.idx = add i64 %kj, %j')
+    out.append('  %pb = getelementptr inbounds i32* %b, i64 %kj.idx')
+    out.append('  %vb = load i32* %pb')
+    out.append('  %t0 = mul i32 %va, %vb')
+    ops = ['add', 'xor', 'mul', 'sub']
+    for t in range(1, 2 + f % 6):
+      out.append('  %%t%d = %s i32 %%t%d, %d' %
+                 (t, rng.choice(ops), t - 1, rng.randint(1, 31)))
+    out.append('  %%sum.next = add i32 %%sum, %%t%d' % (1 + f % 6))
+    out.append('  %k.next = add i64 %k, 1')
+    out.append('  %k.done = icmp eq i64 %k.next, %n')
+    out.append('  br i1 %k.done, label %j.latch, label %k.body')
+    out.append('j.latch:')
+    out.append('  %ij = mul i64 %i, %n')
+    out.append('  %ij.idx = add i64 %ij, %j')
+    out.append('  %pc = getelementptr inbounds i32* %c, i64 %ij.idx')
+    out.append('  store i32 %sum.next, i32* %pc')
+    out.append('  %j.next = add i64 %j, 1')
+    out.append('  %j.done = icmp eq i64 %j.next, %n')
+    out.append('  br i1 %j.done, label %i.latch, label %j.body')
+    out.append('i.latch:')
+    out.append('  %i.next = add i64 %i, 1')
+    out.append('  %i.done = icmp eq i64 %i.next, %n')
+    out.append('  br i1 %i.done, label %exit, label %i.body')
+    out.append('exit:')
+    out.append('  ret void')
+    out.append('}')
+  return out
+
+
+def gen_cfg(rng, size):
+  """Wide switches and diamonds, for CFG simplification and jump threading."""
+  out = []
+  for f in range(size):
+    cases = 16 + 4 * (f % 8)
+    out.append('define i32 @cfg_%d(i32 %%x, i32 %%y) {' % f)
+    out.append('entry:')
+    out.append('  switch i32 %x, label %default [')
+    for c in range(cases):
+      out.append('    i32 %d, label %%case%d' % (c, c))
+    out.append('  ]')
+    incoming = ['[ 0, %default ]']
+    for c in range(cases):
+      out.append('case%d:' % c)
+      out.append('  %%c%d.a = add i32 %%y, %d' % (c, rng.randint(0, 64)))
+      out.append('  %%c%d.cmp = icmp sgt i32 %%x, %d' % (c, rng.randint(0, 64)))
+      out.append('  br i1 %%c%d.cmp, label %%case%d.t, label %%join' % (c, c))
+      out.append('case%d.t:' % c)
+      out.append('  %%c%d.b = mul i32 %%c%d.a, %%x' % (c, c))
+      out.append('  br label %join')
+      incoming.append('[ %%c%d.a, %%case%d ]' % (c, c))
+      incoming.append('[ %%c%d.b, %%case%d.t ]' % (c, c))
+    out.append('default:')
+    out.append('  br label %join')
+    out.append('join:')
+    out.append('  %%r = phi i32 %s' % ', '.join(incoming))
+    out.append('  ret i32 %r')
+    out.append('}')
+  return out
+
+
+def gen_expr(rng, size):
+  """Long expression DAGs with redundancy, for InstCombine, GVN and
+  reassociation."""
+  out = []
+  ops = ['add', 'sub', 'mul', 'xor', 'and', 'or']
+  for f in range(size):
+    out.append('define i64 @expr_%d(i64 %%a, i64 %%b, i64 %%c, i64 %%d) {' % f)
+    out.append('entry:')
+    values = ['%a', '%b', '%c', '%d']
+    insts = []
+    for v in range(200):
+      if insts and rng.random() < 0.2:
+        # Recompute an earlier expression, which CSE should remove.
+        op, lhs, rhs = rng.choice(insts)
+      elif rng.random() < 0.2:
+        op, lhs, rhs = 'shl', rng.choice(values), str(rng.randint(1, 7))
+      else:
+        op, lhs, rhs = rng.choice(ops), rng.choice(values), rng.choice(values)
+      insts.append((op, lhs, rhs))
+      out.append('  %%v%d = %s i64 %s, %s' % (v, op, lhs, rhs))
+      values.append('%%v%d' % v)
+    out.append('  %%r0 = add i64 %s, %s' % (values[-1], values[-2]))
+    out.append('  %%r1 = xor i64 %%r0, %s' % values[-3])
+    out.append('  ret i64 %r1')
+    out.append('}')
+  return out
+
+
+def gen_memory(rng, size):
+  """Redundant and dead memory accesses through struct GEPs, for alias
+  analysis, GVN and DSE."""
+  out = ['%struct.S = type { i32, i32, [8 x i32] }']
+  for f in range(size):
+    out.append('define void @memory_%d(%%struct.S* noalias %%p, '
+               '%%struct.S* %%q, i64 %%n) {' % f)
+    out.append('entry:')
+    out.append('  %cmp = icmp sgt i64 %n, 0')
+    out.append('  br i1 %cmp, label %body, label %exit')
+    out.append('body:')
+    out.append('  %i = phi i64 [ 0, %entry ], [ %i.next, %body ]')
+    out.append('  %acc = phi i32 [ 0, %entry ], [ %acc.next, %body ]')
+    acc = '%acc'
+    for e in range(8):
+      fld = rng.randint(0, 7)
+      out.append('  %%p%d = getelementptr inbounds %%struct.S* %%p, i64 %%i, '
+                 'i32 2, i64 %d' % (e, fld))
+      out.append('  %%l%d = load i32* %%p%d' % (e, e))
+      out.append('  %%q%d = getelementptr inbounds %%struct.S* %%q, i64 %%i, '
+                 'i32 %d' % (e, e % 2))
+      # The first store is dead, and the second load is redundant.
+      out.append('  store i32 0, i32* %%q%d' % e)
+      out.append('  store i32 %%l%d, i32* %%q%d' % (e, e))
+      out.append('  %%r%d = load i32* %%p%d' % (e, e))
+      out.append('  %%a%d = add i32 %s, %%r%d' % (e, acc, e))
+      acc = '%%a%d' % e
+    out.append('  %%acc.next = add i32 %s, 1' % acc)
+    out.append('  %i.next = add i64 %i, 1')
+    out.append('  %done = icmp eq i64 %i.next, %n')
+    out.append('  br i1 %done, label %exit, label %body')
+    out.append('exit:')
+    out.append('  ret void')
+    out.append('}')
+  return out
+
+
+def gen_branches(rng, size):
+  """x86-64 functions with many short and long conditional branches, for
+  fragment relaxation in the assembler. Whether a branch needs its long form
+  depends on the size of the branches it jumps over."""
+  insts = ['addl $%d, %%eax', 'imull $%d, %%ecx, %%edx',
+           'movq %d(%%rsp), %%rax', 'xorl $%d, %%edi',
+           'leaq %d(%%rdi,%%rsi,4), %%r8']
+  out = ['  .text']
+  blocks = 400
+  for f in range(size):
+    out.append('  .globl branches_%d' % f)
+    out.append('  .p2align 4')
+    out.append('branches_%d:' % f)
+    for b in range(blocks):
+      out.append('.L%d_%d:' % (f, b))
+      for i in range(rng.randint(2, 6)):
+        out.append('  ' + rng.choice(insts) % (rng.randint(0, 255) * 8))
+      target = rng.randint(max(0, b - 40), min(blocks - 1, b + 40))
+      out.append('  %s .L%d_%d' % (rng.choice(['jne', 'jl', 'jmp']), f,
+                                   target))
+    out.append('  retq')
+  return out
+
+
+GENERATORS = [('calls', gen_calls), ('loops', gen_loops), ('cfg', gen_cfg),
+              ('expr', gen_expr), ('memory', gen_memory)]
+ASM_GENERATORS = [('branches', gen_branches)]
+
+
+def generate_inputs(directory, size, asm):
+  if not os.path.isdir(directory):
+    os.makedirs(directory)
+  paths = []
+  generators = [(name, gen, '.ll', ';') for name, gen in GENERATORS]
+  if asm:
+    generators += [(name, gen, '.s', '#') for name, gen in ASM_GENERATORS]
+  for name, gen, ext, comment in generators:
+    rng = random.Random(name)
+    path = os.path.join(directory, name + ext)
+    with open(path, 'w') as f:
+      f.write('%s Generated by compile_time.py --generate --size %d\n' %
+              (comment, size))
+      f.write('\n'.join(gen(rng, size)) + '\n')
+    paths.append(path)
+  return paths
+
+
+def collect_inputs(paths):
+  inputs = []
+  for path in paths:
+    if os.path.isdir(path):
+      for name in sorted(os.listdir(path)):
+        if os.path.splitext(name)[1] in ('.bc', '.ll', '.s'):
+          inputs.append(os.path.join(path, name))
+    else:
+      inputs.append(path)
+  return inputs
+
+
+# Measurement.
+
+def read_pass_times(path):
+  """Sum the wall time of every pass in a -time-passes-json report."""
+  times = {}
+  if not os.path.exists(path):
+    return times
+  with open(path) as f:
+    text = f.read()
+  decoder = json.JSONDecoder()
+  pos = 0
+  while True:
+    while pos < len(text) and text[pos].isspace():
+      pos += 1
+    if pos >= len(text):
+      break
+    report, pos = decoder.raw_decode(text, pos)
+    for p in report.get('passes', []):
+      times[p['name']] = times.get(p['name'], 0.0) + p['wall']
+  return times
+
+
+def run_once(cmd, json_path):
+  """Run cmd and return its CPU time, or its wall time where the CPU time
+  of child processes is not available."""
+  if json_path and os.path.exists(json_path):
+    os.remove(json_path)
+  with open(os.devnull, 'w') as devnull:
+    if resource:
+      before = resource.getrusage(resource.RUSAGE_CHILDREN)
+    start = time.time()
+    status = subprocess.call(cmd, stdout=devnull, stderr=devnull)
+    elapsed = time.time() - start
+    if resource:
+      after = resource.getrusage(resource.RUSAGE_CHILDREN)
+      elapsed = (after.ru_utime - before.ru_utime +
+                 after.ru_stime - before.ru_stime)
+  if status != 0:
+    raise RuntimeError('command failed: ' + ' '.join(cmd))
+  return elapsed
+
+
+def measure(args, inputs):
+  results = {}
+  scratch = tempfile.mkdtemp(prefix='compile-time-')
+  try:
+    json_path = os.path.join(scratch, 'passes.json')
+    opt = os.path.join(args.bindir, 'opt')
+    llc = os.path.join(args.bindir, 'llc')
+    mc = os.path.join(args.bindir, 'llvm-mc')
+    runs = []
+    for path in inputs:
+      name = os.path.basename(path)
+      if path.endswith('.s'):
+        # llvm-mc has no pass timers; only its total time is recorded.
+        if args.mc_triple:
+          runs.append(('%s:llvm-mc' % name,
+                       [mc, '-triple', args.mc_triple, '-filetype=obj', path,
+                        '-o', os.devnull], None))
+        continue
+      for level in OPT_LEVELS:
+        runs.append(('%s:opt%s' % (name, level),
+                     [opt, level, path, '-o', os.devnull], json_path))
+      for level in LLC_LEVELS:
+        runs.append(('%s:llc%s' % (name, level),
+                     [llc, level, '-filetype=obj', path, '-o', os.devnull],
+                     json_path))
+        runs.append(('%s:llc%s:asm' % (name, level),
+                     [llc, level, '-filetype=asm', path, '-o', os.devnull],
+                     json_path))
+
+    for key, cmd, timers in runs:
+      if timers:
+        cmd = cmd + ['-time-passes', '-time-passes-json=' + timers]
+      # The fastest of the repetitions is the least disturbed by the rest of
+      # the system.
+      best, best_passes = None, {}
+      for i in range(args.repeat):
+        elapsed = run_once(cmd, timers)
+        if best is None or elapsed < best:
+          best = elapsed
+          best_passes = read_pass_times(timers) if timers else {}
+      slowest = sorted(best_passes.items(), key=lambda p: -p[1])
+      results[key] = {'total': best,
+                      'passes': dict(slowest[:args.passes])}
+      if args.verbose:
+        print('%-40s %8.3fs' % (key, best))
+  finally:
+    shutil.rmtree(scratch)
+  return results
+
+
+def compare(args, results, baseline):
+  """Print the measurements that changed, and return the number of
+  regressions."""
+  regressions = 0
+
+  def check(key, new, old):
+    delta = new - old
+    if abs(delta) < args.min_delta or old <= 0:
+      return 0
+    change = 100.0 * delta / old
+    if change > args.threshold:
+      print('REGRESSION %-50s %8.3fs -> %8.3fs (%+.1f%%)' %
+            (key, old, new, change))
+      return 1
+    if change < -args.threshold:
+      print('improved   %-50s %8.3fs -> %8.3fs (%+.1f%%)' %
+            (key, old, new, change))
+    return 0
+
+  for key in sorted(results):
+    if key not in baseline:
+      continue
+    new, old = results[key], baseline[key]
+    regressions += check(key, new['total'], old['total'])
+    for p in sorted(new['passes']):
+      if p in old['passes']:
+        regressions += check('%s:%s' % (key, p), new['passes'][p],
+                             old['passes'][p])
+  return regressions
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('inputs', nargs='*',
+                      help='Bitcode, IR or assembly files, or directories of them')
+  parser.add_argument('--bindir', required=True,
+                      help='Directory containing opt, llc and llvm-mc')
+  parser.add_argument('--mc-triple', default='x86_64-unknown-linux-gnu',
+                      help='Target triple of the assembly inputs; assembly '
+                      'inputs are skipped if empty')
+  parser.add_argument('--output', help='Write the results to this JSON file')
+  parser.add_argument('--baseline',
+                      help='Compare against the results in this JSON file')
+  parser.add_argument('--generate', metavar='DIR',
+                      help='Write the synthetic inputs to DIR and measure '
+                           'them when no inputs are given')
+  parser.add_argument('--size', type=int, default=50,
+                      help='Number of functions of each synthetic input')
+  parser.add_argument('--repeat', type=int, default=3,
+                      help='Number of runs of each measurement')
+  parser.add_argument('--passes', type=int, default=10,
+                      help='Number of the slowest passes recorded per run')
+  parser.add_argument('--threshold', type=float, default=5.0,
+                      help='Slowdown in percent reported as a regression')
+  parser.add_argument('--min-delta', type=float, default=0.02,
+                      help='Ignore changes of fewer seconds than this')
+  parser.add_argument('-v', '--verbose', action='store_true',
+                      help='Print every measurement')
+  args = parser.parse_args()
+
+  inputs = collect_inputs(args.inputs)
+  if args.generate:
+    generated = generate_inputs(args.generate, args.size, args.mc_triple)
+    if not args.inputs:
+      inputs = generated
+  if not inputs:
+    parser.error('no inputs; give bitcode files or use --generate')
+
+  results = measure(args, inputs)
+  if args.output:
+    with open(args.output, 'w') as f:
+      json.dump(results, f, indent=1, sort_keys=True)
+
+  if args.baseline:
+    if not os.path.exists(args.baseline):
+      print('No baseline at %s; nothing to compare against.' % args.baseline)
+      return 0
+    with open(args.baseline) as f:
+      baseline = json.load(f)
+    regressions = compare(args, results, baseline)
+    if regressions:
+      print('%d compile-time regressions over %.1f%%.' %
+            (regressions, args.threshold))
+      return 1
+    print('No compile-time regressions.')
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -0,0 +1,80 @@
+#!/usr/bin/env python
+
+"""Merge the statistics written by -stats-json or clang's -stats-file.
+
+Each input is a JSON object mapping "<debug type>.<name>" to the value of an
+LLVM statistic, as written for one translation unit. This script sums every
+statistic over all the inputs and writes the totals in the same format, so
+that the result can be merged again or compared between builds. With --table
+it prints a table of the totals instead, with the largest value seen in any
+one input and the number of inputs that reported the statistic.
+
+Directories are searched recursively for files ending in --suffix. Typical use,
+after compiling each foo.c with -stats-file=foo.stats:
+
+  merge-stats.py --table build/ | head -40
+"""
+
+import argparse
+import json
+import os
+import sys
+
+
+def find_inputs(paths, suffix):
+  for path in paths:
+    if not os.path.isdir(path):
+      yield path
+      continue
+    for root, dirs, files in os.walk(path):
+      dirs.sort()
+      for name in sorted(files):
+        if name.endswith(suffix):
+          yield os.path.join(root, name)
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+  parser.add_argument('inputs', nargs='+',
+                      help='statistics files, or directories to search')
+  parser.add_argument('--suffix', default='.stats',
+                      help='the suffix of the files to read from directories')
+  parser.add_argument('--output', help='write the totals here, not stdout')
+  parser.add_argument('--table', action='store_true',
+                      help='print a table sorted by total instead of JSON')
+  args = parser.parse_args()
+
+  totals = {}
+  maxima = {}
+  counts = {}
+  num_inputs = 0
+  for path in find_inputs(args.inputs, args.suffix):
+    try:
+      with open(path) as f:
+        stats = json.load(f)
+    except (IOError, ValueError) as e:
+      sys.stderr.write('%s: skipped: %s\n' % (path, e))
+      continue
+    num_inputs += 1
+    for key, value in stats.items():
+      totals[key] = totals.get(key, 0) + value
+      maxima[key] = max(maxima.get(key, 0), value)
+      counts[key] = counts.get(key, 0) + 1
+
+  out = open(args.output, 'w') if args.output else sys.stdout
+  if args.table:
+    out.write('%d inputs\n' % num_inputs)
+    out.write('%14s %12s %8s  %s\n' % ('total', 'max', 'inputs', 'statistic'))
+    for key in sorted(totals, key=lambda k: (-totals[k], k)):
+      out.write('%14d %12d %8d  %s\n' %
+                (totals[key], maxima[key], counts[key], key))
+  else:
+    json.dump(totals, out, indent=2, sort_keys=True, separators=(',', ': '))
+    out.write('\n')
+  if out is not sys.stdout:
+    out.close()
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
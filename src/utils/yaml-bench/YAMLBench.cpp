@@ -7,8 +7,8 @@
 //
 //===----------------------------------------------------------------------===//
 //
-// This program executes the YAMLParser on differently sized YAML texts and
-// outputs the run time.
+// This program executes the YAMLParser and YAMLTraits on differently sized
+// YAML texts and outputs the run time.
 //
 //===----------------------------------------------------------------------===//
 
@@ -20,6 +20,7 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/YAMLParser.h"
+#include "llvm/Support/YAMLTraits.h"
 #include "llvm/Support/raw_ostream.h"
 #include <system_error>
 
@@ -136,6 +137,29 @@ static void dumpStream(yaml::Stream &stream) {
   }
 }
 
+namespace {
+/// \brief One of the objects createJSONText writes, read through YAMLTraits.
+struct Record {
+  StringRef Key1;
+  StringRef Key2;
+  StringRef Key3;
+};
+} // end anonymous namespace
+
+LLVM_YAML_IS_SEQUENCE_VECTOR(Record)
+
+namespace llvm {
+namespace yaml {
+template <> struct MappingTraits<Record> {
+  static void mapping(IO &IO, Record &R) {
+    IO.mapRequired("key1", R.Key1);
+    IO.mapRequired("key2", R.Key2);
+    IO.mapRequired("key3", R.Key3);
+  }
+};
+} // end namespace yaml
+} // end namespace llvm
+
 static void benchmark( llvm::TimerGroup &Group
                      , llvm::StringRef Name
                      , llvm::StringRef JSONText) {
@@ -163,6 +187,15 @@ static void benchmark( llvm::TimerGroup &Group
     stream.skip();
   }
   Parsing.stopTimer();
+
+  llvm::Timer Reading((Name + ": Reading").str(), Group);
+  Reading.startTimer();
+  {
+    std::vector<Record> Records;
+    yaml::Input In(JSONText);
+    In >> Records;
+  }
+  Reading.stopTimer();
 }
 
 static std::string createJSONText(size_t MemoryMB, unsigned ValueSize) {